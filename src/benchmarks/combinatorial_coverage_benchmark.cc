@@ -0,0 +1,44 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "src/internal/combinatorial_coverage.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::moriarty_internal::RandomEngine;
+
+// Arguments are {number of dimensions, size of each dimension, strength}.
+void BM_GenerateCoveringArray(benchmark::State& state) {
+  std::vector<int> dimension_sizes(state.range(0), state.range(1));
+  int strength = state.range(2);
+  RandomEngine rng({1, 2, 3}, "");
+  for (auto _ : state) {
+    std::vector<CoveringArrayTestCase> cases =
+        GenerateCoveringArray(dimension_sizes, strength, rng);
+    benchmark::DoNotOptimize(cases);
+  }
+}
+BENCHMARK(BM_GenerateCoveringArray)
+    ->Args({5, 3, 2})
+    ->Args({10, 4, 2})
+    ->Args({20, 5, 2})
+    ->Args({10, 3, 3});
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,304 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// End-to-end benchmarks: realistic problems at their maximum constraints, run
+// through each stage of a Moriarty program (generate, export, import and
+// validate). Each stage is its own benchmark, so a regression in any of them
+// is visible on its own.
+//
+// `peak_rss_mb` is the peak memory of the whole process so far. To compare it
+// across commits, run one benchmark per process with `--benchmark_filter`.
+
+#include <sys/resource.h>
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "benchmark/benchmark.h"
+#include "docs/examples/example_graph.h"
+#include "docs/examples/mexample_graph.h"
+#include "src/exporter.h"
+#include "src/generator.h"
+#include "src/importer.h"
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+#include "src/variables/mtuple.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty_examples::ExampleGraph;
+using ::moriarty_examples::MExampleGraph;
+
+constexpr int kNumTestCases = 5;
+
+// Generates a single test case where every variable is random.
+class PurelyRandom : public Generator {
+ public:
+  void GenerateTestCases() override { AddTestCase(); }
+};
+
+Moriarty CreateMoriarty() {
+  return Moriarty()
+      .SetName("End-to-end benchmark")
+      .SetSeed("end-to-end-benchmark-seed")
+      .AddGenerator("Random", PurelyRandom(), kNumTestCases);
+}
+
+// Reports the peak memory of the process (in MB) to `state`.
+void ReportPeakRss(benchmark::State& state) {
+  rusage usage;
+  ABSL_CHECK_EQ(getrusage(RUSAGE_SELF, &usage), 0);
+  state.counters["peak_rss_mb"] = usage.ru_maxrss / 1024.0;  // KB on Linux.
+}
+
+// -----------------------------------------------------------------------------
+//  Problems
+//
+// Each problem has:
+//  * `Create()`: a Moriarty with its variables and a generator.
+//  * `Export()`: writes the test cases of `moriarty` to `os`.
+//  * `Import()`: reads test cases written by `Export()` into `moriarty`.
+
+// The graph from the codelab (docs/examples/example_graph_main.cc).
+struct GraphProblem {
+  static Moriarty Create() {
+    return CreateMoriarty()
+        .AddVariable("N", MInteger().Is(100'000))
+        .AddVariable("G", MExampleGraph()
+                              .WithNumNodes(MInteger().Is("N"))
+                              .WithNumEdges(MInteger().Between("N", "2 * N"))
+                              .IsConnected());
+  }
+
+  class GraphExporter : public Exporter {
+   public:
+    explicit GraphExporter(std::ostream& os) : os_(os) {}
+
+    void ExportTestCase() override {
+      const ExampleGraph& G = GetValueRef<MExampleGraph>("G");
+      os_ << G.num_nodes << " " << G.edges.size() << '\n';
+      for (const auto& [u, v] : G.edges) os_ << u << " " << v << '\n';
+    }
+
+   private:
+    std::ostream& os_;
+  };
+
+  class GraphImporter : public Importer {
+   public:
+    explicit GraphImporter(std::istream& is) : is_(is) {}
+
+    absl::Status ImportTestCase() override {
+      ExampleGraph G;
+      int num_edges;
+      if (!(is_ >> G.num_nodes >> num_edges)) {
+        Done();
+        return absl::OkStatus();
+      }
+      G.edges.resize(num_edges);
+      for (auto& [u, v] : G.edges) {
+        if (!(is_ >> u >> v)) return absl::InvalidArgumentError("bad edge");
+      }
+      SetValue<MInteger>("N", G.num_nodes);
+      SetValue<MExampleGraph>("G", std::move(G));
+      return absl::OkStatus();
+    }
+
+   private:
+    std::istream& is_;
+  };
+
+  static void Export(Moriarty& moriarty, std::ostream& os) {
+    moriarty.ExportTestCases(GraphExporter(os));
+  }
+
+  static absl::Status Import(Moriarty& moriarty, std::istream& is) {
+    return moriarty.ImportTestCases(GraphImporter(is));
+  }
+};
+
+// The problems below are read and written with `SimpleIO`.
+template <typename Problem>
+struct SimpleIOProblem {
+  static void Export(Moriarty& moriarty, std::ostream& os) {
+    moriarty.ExportTestCases(Problem::Format().Exporter(os));
+  }
+
+  static absl::Status Import(Moriarty& moriarty, std::istream& is) {
+    return moriarty.ImportTestCases(Problem::Format().Importer(is));
+  }
+};
+
+// A large array of large integers.
+struct ArrayProblem : SimpleIOProblem<ArrayProblem> {
+  static Moriarty Create() {
+    return CreateMoriarty()
+        .AddVariable("N", MInteger().Is(200'000))
+        .AddVariable(
+            "A", MArray(MInteger().Between(-1'000'000'000, 1'000'000'000))
+                     .OfLength("N"));
+  }
+
+  static SimpleIO Format() { return SimpleIO().AddLine("N").AddLine("A"); }
+};
+
+// A long string and a few shorter, distinct words.
+struct StringProblem : SimpleIOProblem<StringProblem> {
+  static Moriarty Create() {
+    return CreateMoriarty()
+        .AddVariable("N", MInteger().Is(1'000'000))
+        .AddVariable("S",
+                     MString().OfLength("N").WithAlphabet(MString::kLowerCase))
+        .AddVariable("Q", MInteger().Is(10'000))
+        .AddVariable("W",
+                     MArray(MString().OfLength(1, 20).WithAlphabet("abc"))
+                         .OfLength("Q")
+                         .WithDistinctElements()
+                         .WithSeparator(Whitespace::kNewline));
+  }
+
+  static SimpleIO Format() {
+    return SimpleIO().AddLine("N").AddLine("S").AddLine("Q").AddLine("W");
+  }
+};
+
+// Queries, one per line, each a tuple of integers and a short string.
+struct TupleProblem : SimpleIOProblem<TupleProblem> {
+  static Moriarty Create() {
+    return CreateMoriarty()
+        .AddVariable("N", MInteger().Is(100'000))
+        .AddVariable(
+            "Q", MArray(MTuple(MInteger().Between(1, "N"),
+                               MInteger().Between(1, "N"),
+                               MString().OfLength(1, 10).WithAlphabet("xyz")))
+                     .OfLength("N")
+                     .WithSeparator(Whitespace::kNewline));
+  }
+
+  static SimpleIO Format() { return SimpleIO().AddLine("N").AddLine("Q"); }
+};
+
+// -----------------------------------------------------------------------------
+//  Stages
+
+// Returns a Moriarty with the test cases of `Problem` already generated.
+template <typename Problem>
+Moriarty Generated() {
+  Moriarty moriarty = Problem::Create();
+  ABSL_CHECK_OK(moriarty.TryGenerateTestCases());
+  return moriarty;
+}
+
+template <typename Problem>
+std::string Exported() {
+  Moriarty moriarty = Generated<Problem>();
+  std::stringstream ss;
+  Problem::Export(moriarty, ss);
+  return ss.str();
+}
+
+template <typename Problem>
+void BM_Generate(benchmark::State& state) {
+  for (auto _ : state) {
+    Moriarty moriarty = Problem::Create();
+    absl::Status status = moriarty.TryGenerateTestCases();
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+    benchmark::DoNotOptimize(moriarty);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTestCases);
+  ReportPeakRss(state);
+}
+
+template <typename Problem>
+void BM_Export(benchmark::State& state) {
+  Moriarty moriarty = Generated<Problem>();
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    std::stringstream ss;
+    Problem::Export(moriarty, ss);
+    bytes += ss.tellp();
+  }
+  state.SetBytesProcessed(bytes);
+  ReportPeakRss(state);
+}
+
+template <typename Problem>
+void BM_Import(benchmark::State& state) {
+  std::string input = Exported<Problem>();
+  for (auto _ : state) {
+    Moriarty moriarty = Problem::Create();
+    std::stringstream ss(input);
+    absl::Status status = Problem::Import(moriarty, ss);
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+    benchmark::DoNotOptimize(moriarty);
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+  ReportPeakRss(state);
+}
+
+template <typename Problem>
+void BM_Validate(benchmark::State& state) {
+  Moriarty moriarty = Problem::Create();
+  std::stringstream ss(Exported<Problem>());
+  ABSL_CHECK_OK(Problem::Import(moriarty, ss));
+  for (auto _ : state) {
+    absl::Status status = moriarty.TryValidateTestCases();
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTestCases);
+  ReportPeakRss(state);
+}
+
+BENCHMARK_TEMPLATE(BM_Generate, GraphProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Export, GraphProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Import, GraphProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Validate, GraphProblem)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_Generate, ArrayProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Export, ArrayProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Import, ArrayProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Validate, ArrayProblem)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_Generate, StringProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Export, StringProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Import, StringProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Validate, StringProblem)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_Generate, TupleProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Export, TupleProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Import, TupleProblem)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Validate, TupleProblem)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,69 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "benchmark/benchmark.h"
+#include "src/internal/expressions.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+constexpr char kExpression[] = "3 * N * (N - 1) / 2 + max(M, 10^5) % 7";
+
+void BM_ParseExpression(benchmark::State& state) {
+  for (auto _ : state) {
+    absl::StatusOr<Expression> expression = ParseExpression(kExpression);
+    benchmark::DoNotOptimize(expression);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseExpression);
+
+void BM_EvaluateIntegerExpression(benchmark::State& state) {
+  absl::StatusOr<Expression> expression = ParseExpression(kExpression);
+  ABSL_CHECK_OK(expression);
+  absl::flat_hash_map<std::string, int64_t> variables = {{"N", 1000},
+                                                         {"M", 123456}};
+  for (auto _ : state) {
+    absl::StatusOr<int64_t> value =
+        EvaluateIntegerExpression(*expression, variables);
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EvaluateIntegerExpression);
+
+void BM_ParseAndEvaluateIntegerExpression(benchmark::State& state) {
+  absl::flat_hash_map<std::string, int64_t> variables = {{"N", 1000},
+                                                         {"M", 123456}};
+  for (auto _ : state) {
+    absl::StatusOr<Expression> expression = ParseExpression(kExpression);
+    ABSL_CHECK_OK(expression);
+    absl::StatusOr<int64_t> value =
+        EvaluateIntegerExpression(*expression, variables);
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseAndEvaluateIntegerExpression);
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
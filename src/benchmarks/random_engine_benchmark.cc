@@ -0,0 +1,51 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+void BM_RandInt(benchmark::State& state) {
+  RandomEngine rng({1, 2, 3}, "");
+  for (auto _ : state) {
+    absl::StatusOr<int64_t> value = rng.RandInt(1, state.range(0));
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandInt)->Arg(10)->Arg(1'000'000'000)->Arg(INT64_MAX);
+
+void BM_RandInts(benchmark::State& state) {
+  RandomEngine rng({1, 2, 3}, "");
+  std::vector<int64_t> values(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        rng.RandInts(1, 1'000'000'000, absl::MakeSpan(values)));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RandInts)->Range(1 << 4, 1 << 20);
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,129 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "benchmark/benchmark.h"
+#include "src/exporter.h"
+#include "src/importer.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/simple_io.h"
+#include "src/test_case.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::moriarty_internal::ValueSet;
+using ::moriarty::moriarty_internal::VariableSet;
+
+constexpr int kNumTestCases = 10;
+
+// Each test case is an integer `N` followed by an array of `N` integers.
+SimpleIO TestCaseFormat() {
+  return SimpleIO().WithNumberOfTestCasesInHeader().AddLine("N").AddLine("A");
+}
+
+VariableSet TestCaseVariables() {
+  VariableSet variables;
+  ABSL_CHECK_OK(variables.AddVariable("N", MInteger()));
+  ABSL_CHECK_OK(variables.AddVariable(
+      "A", MArray(MInteger().Between(-1'000'000'000, 1'000'000'000))
+               .OfLength("N")));
+  return variables;
+}
+
+std::vector<ValueSet> TestCaseValues(int64_t n) {
+  std::vector<int64_t> array(n);
+  for (int64_t i = 0; i < n; i++) array[i] = (i * 1'234'567) % 2'000'000'001;
+
+  std::vector<ValueSet> values(kNumTestCases);
+  for (ValueSet& value_set : values) {
+    value_set.Set<MInteger>("N", n);
+    value_set.Set<MArray<MInteger>>("A", array);
+  }
+  return values;
+}
+
+std::string Export(const VariableSet& variables,
+                   const std::vector<ValueSet>& values) {
+  std::stringstream ss;
+  SimpleIOExporter exporter = TestCaseFormat().Exporter(ss);
+  moriarty_internal::ExporterManager(&exporter).SetGeneralConstraints(
+      variables);
+  moriarty_internal::ExporterManager(&exporter).SetAllValues(values);
+  moriarty_internal::ExporterManager(&exporter).SetTestCaseMetadata(
+      std::vector<TestCaseMetadata>(values.size()));
+  exporter.ExportTestCases();
+  return ss.str();
+}
+
+absl::Status Import(const VariableSet& variables, const std::string& input) {
+  std::stringstream ss(input);
+  SimpleIOImporter importer = TestCaseFormat().Importer(ss);
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variables);
+  return importer.ImportTestCases();
+}
+
+void BM_SimpleIOExport(benchmark::State& state) {
+  VariableSet variables = TestCaseVariables();
+  std::vector<ValueSet> values = TestCaseValues(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Export(variables, values));
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTestCases * state.range(0));
+}
+BENCHMARK(BM_SimpleIOExport)->Range(1 << 4, 1 << 16);
+
+void BM_SimpleIOImport(benchmark::State& state) {
+  VariableSet variables = TestCaseVariables();
+  std::string input = Export(variables, TestCaseValues(state.range(0)));
+
+  for (auto _ : state) {
+    absl::Status status = Import(variables, input);
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_SimpleIOImport)->Range(1 << 4, 1 << 16);
+
+void BM_SimpleIORoundTrip(benchmark::State& state) {
+  VariableSet variables = TestCaseVariables();
+  std::vector<ValueSet> values = TestCaseValues(state.range(0));
+
+  for (auto _ : state) {
+    absl::Status status = Import(variables, Export(variables, values));
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTestCases * state.range(0));
+}
+BENCHMARK(BM_SimpleIORoundTrip)->Range(1 << 4, 1 << 16);
+
+}  // namespace
+}  // namespace moriarty
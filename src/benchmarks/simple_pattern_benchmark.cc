@@ -0,0 +1,54 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "benchmark/benchmark.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/simple_pattern.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+constexpr char kPattern[] = "[a-z]{1,20}(@|_)[a-zA-Z0-9_]{0,40}";
+
+void BM_SimplePatternMatches(benchmark::State& state) {
+  absl::StatusOr<SimplePattern> pattern = SimplePattern::Create(kPattern);
+  ABSL_CHECK_OK(pattern);
+  std::string str = "moriarty@" + std::string(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pattern->Matches(str));
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+}
+BENCHMARK(BM_SimplePatternMatches)->Arg(1)->Arg(10)->Arg(40);
+
+void BM_SimplePatternGenerate(benchmark::State& state) {
+  absl::StatusOr<SimplePattern> pattern = SimplePattern::Create(kPattern);
+  ABSL_CHECK_OK(pattern);
+  RandomEngine rng({1, 2, 3}, "");
+  for (auto _ : state) {
+    absl::StatusOr<std::string> str = pattern->Generate(rng);
+    benchmark::DoNotOptimize(str);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SimplePatternGenerate);
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
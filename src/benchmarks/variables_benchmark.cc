@@ -0,0 +1,129 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "benchmark/benchmark.h"
+#include "src/internal/analysis_bootstrap.h"
+#include "src/internal/generation_bootstrap.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/librarian/mvariable.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+#include "src/variables/mtuple.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::moriarty_internal::GenerateAllValues;
+using ::moriarty::moriarty_internal::RandomEngine;
+using ::moriarty::moriarty_internal::SatisfiesConstraints;
+using ::moriarty::moriarty_internal::ValueSet;
+using ::moriarty::moriarty_internal::VariableSet;
+
+// Generates `variable` once per iteration. The random engine is shared between
+// iterations, so each iteration generates a different value.
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+void BenchmarkGeneration(benchmark::State& state, T variable) {
+  VariableSet variables;
+  ABSL_CHECK_OK(variables.AddVariable("X", variable));
+  RandomEngine rng({1, 2, 3}, "");
+
+  for (auto _ : state) {
+    absl::StatusOr<ValueSet> values =
+        GenerateAllValues(variables, ValueSet(),
+                          {rng, /* soft_generation_limit = */ std::nullopt});
+    if (!values.ok()) {
+      state.SkipWithError(std::string(values.status().message()).c_str());
+      return;
+    }
+    benchmark::DoNotOptimize(values);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_GenerateMArrayOfMInteger(benchmark::State& state) {
+  BenchmarkGeneration(state, MArray(MInteger().Between(1, 1'000'000'000))
+                                 .OfLength(state.range(0)));
+}
+BENCHMARK(BM_GenerateMArrayOfMInteger)->Range(1 << 4, 1 << 20);
+
+void BM_GenerateDistinctMArrayOfMInteger(benchmark::State& state) {
+  BenchmarkGeneration(state, MArray(MInteger().Between(1, state.range(0)))
+                                 .OfLength(state.range(0))
+                                 .WithDistinctElements());
+}
+BENCHMARK(BM_GenerateDistinctMArrayOfMInteger)->Range(1 << 4, 1 << 20);
+
+void BM_GenerateMString(benchmark::State& state) {
+  BenchmarkGeneration(
+      state, MString().OfLength(state.range(0)).WithAlphabet("abcdefghij"));
+}
+BENCHMARK(BM_GenerateMString)->Range(1 << 4, 1 << 20);
+
+void BM_GenerateMArrayOfMTuple(benchmark::State& state) {
+  BenchmarkGeneration(
+      state,
+      MArray(MTuple(MInteger().Between(1, 1'000'000), MInteger().Between(1, 10),
+                    MString().OfLength(5).WithAlphabet("xyz")))
+          .OfLength(state.range(0)));
+}
+BENCHMARK(BM_GenerateMArrayOfMTuple)->Range(1 << 4, 1 << 12);
+
+void BM_ValidateMArrayOfMInteger(benchmark::State& state) {
+  std::vector<int64_t> values(state.range(0));
+  for (int64_t i = 0; i < values.size(); i++) values[i] = i + 1;
+  MArray<MInteger> array = MArray(MInteger().Between(1, state.range(0)))
+                               .OfLength(state.range(0))
+                               .WithDistinctElements();
+
+  for (auto _ : state) {
+    absl::Status status = SatisfiesConstraints(array, values);
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ValidateMArrayOfMInteger)->Range(1 << 4, 1 << 20);
+
+void BM_ValidateMString(benchmark::State& state) {
+  std::string value(state.range(0), 'a');
+  MString string = MString().OfLength(state.range(0)).WithAlphabet("abc");
+
+  for (auto _ : state) {
+    absl::Status status = SatisfiesConstraints(string, value);
+    if (!status.ok()) {
+      state.SkipWithError(std::string(status.message()).c_str());
+      return;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ValidateMString)->Range(1 << 4, 1 << 20);
+
+}  // namespace
+}  // namespace moriarty
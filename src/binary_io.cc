@@ -0,0 +1,207 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/binary_io.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "src/exporter.h"
+#include "src/importer.h"
+#include "src/internal/binary_format.h"
+#include "src/internal/value_set.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+// -----------------------------------------------------------------------------
+//  BinaryExporter
+
+BinaryExporter::BinaryExporter(std::ostream& os) : os_(os) {}
+
+void BinaryExporter::StartExport() {
+  variables_ = moriarty_internal::GetVariablesByName(
+      moriarty_internal::ExporterManager(this).GetGeneralConstraints());
+
+  std::string header;
+  moriarty_internal::AppendBinaryFormatHeader(header);
+  os_ << header;
+}
+
+void BinaryExporter::ExportTestCase() {
+  std::string encoded;
+  ABSL_CHECK_OK(moriarty_internal::AppendEncodedTestCase(
+      moriarty_internal::ExporterManager(this).GetCurrentValues(), variables_,
+      encoded));
+  os_ << encoded;
+}
+
+// -----------------------------------------------------------------------------
+//  BinaryFileExporter
+
+BinaryFileExporter::BinaryFileExporter(absl::string_view path)
+    : path_(path),
+      // Random, so exporters (in any process) publishing to the same path do
+      // not write to the same temporary file.
+      temporary_path_(
+          absl::StrCat(path, ".tmp.", absl::Hex(std::random_device()()))) {}
+
+void BinaryFileExporter::StartExport() {
+  variables_ = moriarty_internal::GetVariablesByName(
+      moriarty_internal::ExporterManager(this).GetGeneralConstraints());
+
+  os_ = std::make_shared<std::ofstream>(
+      temporary_path_,
+      std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  ABSL_CHECK(os_->is_open()) << "Unable to open file '" << temporary_path_
+                             << "'";
+  std::string header;
+  moriarty_internal::AppendBinaryFormatHeader(header);
+  *os_ << header;
+}
+
+void BinaryFileExporter::ExportTestCase() {
+  std::string encoded;
+  ABSL_CHECK_OK(moriarty_internal::AppendEncodedTestCase(
+      moriarty_internal::ExporterManager(this).GetCurrentValues(), variables_,
+      encoded));
+  *os_ << encoded;
+}
+
+void BinaryFileExporter::EndExport() {
+  os_->close();
+  ABSL_CHECK(!os_->fail()) << "Unable to write file '" << temporary_path_
+                           << "'";
+  os_.reset();
+  // Renaming within a file system replaces `path_` atomically.
+  ABSL_CHECK_EQ(std::rename(temporary_path_.c_str(), path_.c_str()), 0)
+      << "Unable to rename '" << temporary_path_ << "' to '" << path_
+      << "': " << std::strerror(errno);
+}
+
+// -----------------------------------------------------------------------------
+//  BinaryImporter
+
+BinaryImporter::BinaryImporter(absl::string_view data) : data_(data) {}
+
+absl::StatusOr<BinaryImporter> BinaryImporter::FromFile(
+    absl::string_view path) {
+  if (auto map_file = moriarty_internal::GetBinaryIOFileSupport().map_file;
+      map_file != nullptr) {
+    absl::StatusOr<std::shared_ptr<const absl::string_view>> mapped =
+        map_file(path);
+    if (mapped.ok()) {
+      BinaryImporter importer(**mapped);
+      importer.file_ = *std::move(mapped);
+      return importer;
+    }
+    // E.g., a pipe is read into memory below instead.
+    if (!absl::IsFailedPrecondition(mapped.status())) return mapped.status();
+  }
+
+  std::ifstream file{std::string(path), std::ios_base::binary};
+  if (!file.is_open()) {
+    return absl::NotFoundError(absl::Substitute("unable to open $0", path));
+  }
+  auto contents = std::make_shared<const std::string>(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (file.bad()) {
+    return absl::UnavailableError(absl::Substitute("unable to read $0", path));
+  }
+  BinaryImporter importer(*contents);
+  importer.file_ = std::move(contents);
+  return importer;
+}
+
+void BinaryImporter::SelectTestCases(std::vector<int64_t> test_case_numbers) {
+  ABSL_CHECK(absl::c_is_sorted(test_case_numbers) &&
+             absl::c_adjacent_find(test_case_numbers) ==
+                 test_case_numbers.end())
+      << "SelectTestCases() requires strictly increasing test case numbers";
+  selected_test_cases_ = std::move(test_case_numbers);
+}
+
+absl::Status BinaryImporter::StartImport() {
+  variables_ = moriarty_internal::GetVariablesByName(
+      moriarty_internal::ImporterManager(this).GetGeneralConstraints());
+  remaining_ = data_;
+  num_read_test_cases_ = 0;
+  num_imported_selected_test_cases_ = 0;
+  return moriarty_internal::ReadBinaryFormatHeader(remaining_);
+}
+
+absl::Status BinaryImporter::ImportTestCase() {
+  if (selected_test_cases_.has_value()) {
+    if (num_imported_selected_test_cases_ == selected_test_cases_->size()) {
+      Done();
+      return absl::OkStatus();
+    }
+    int64_t next = (*selected_test_cases_)[num_imported_selected_test_cases_];
+    while (num_read_test_cases_ + 1 < next && !remaining_.empty()) {
+      MORIARTY_RETURN_IF_ERROR(
+          moriarty_internal::SkipEncodedTestCase(remaining_))
+          << "test case " << num_read_test_cases_ + 1;
+      num_read_test_cases_++;
+    }
+    if (remaining_.empty()) {
+      return absl::OutOfRangeError(absl::Substitute(
+          "cannot import test case $0; there are only $1 test cases", next,
+          num_read_test_cases_));
+    }
+    num_imported_selected_test_cases_++;
+  }
+  if (remaining_.empty()) {
+    Done();
+    return absl::OkStatus();
+  }
+  num_read_test_cases_++;
+
+  moriarty_internal::ValueSet values;
+  MORIARTY_RETURN_IF_ERROR(moriarty_internal::ReadEncodedTestCase(
+      remaining_, variables_, values))
+      << "test case " << num_read_test_cases_;
+  moriarty_internal::ImporterManager(this).SetCurrentTestCase(
+      std::move(values));
+  return absl::OkStatus();
+}
+
+namespace moriarty_internal {
+
+BinaryIOFileSupport& GetBinaryIOFileSupport() {
+  static BinaryIOFileSupport* support = new BinaryIOFileSupport();
+  return *support;
+}
+
+}  // namespace moriarty_internal
+
+}  // namespace moriarty
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_BINARY_IO_H_
+#define MORIARTY_SRC_BINARY_IO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/exporter.h"
+#include "src/importer.h"
+#include "src/internal/binary_format.h"
+
+namespace moriarty {
+
+// BinaryExporter
+//
+// Exports test cases in Moriarty's compact binary format (see
+// `src/internal/binary_format.h`). All values must be of built-in types (or
+// nested arrays and tuples of them). Read them back with `BinaryImporter`.
+//
+// Example usage:
+//
+//   std::ofstream file("tests.bin", std::ios::binary);
+//   M.ExportTestCases(BinaryExporter(file));
+class BinaryExporter : public Exporter {
+ public:
+  explicit BinaryExporter(std::ostream& os);
+
+  // StartExport()
+  //
+  // Writes the header of the binary format.
+  void StartExport() override;
+
+  // ExportTestCase()
+  //
+  // Writes the values of all variables in the test case.
+  void ExportTestCase() override;
+
+ private:
+  std::ostream& os_;
+  moriarty_internal::VariablesByName variables_;
+};
+
+// BinaryFileExporter
+//
+// Exports test cases like `BinaryExporter`, to the file at `path`. The test
+// cases are written to a temporary file next to it, which is renamed to `path`
+// once all of them are written. So processes reading `path` (e.g., with
+// `BinaryImporter::FromFile()`) see either the previous file or the complete
+// new one, never a partially written one.
+//
+// Crashes if the file cannot be written.
+//
+// Example usage:
+//
+//   M.ExportTestCases(BinaryFileExporter("/shared/suite.bin"));
+class BinaryFileExporter : public Exporter {
+ public:
+  explicit BinaryFileExporter(absl::string_view path);
+
+  // StartExport()
+  //
+  // Creates the temporary file and writes the header of the binary format.
+  void StartExport() override;
+
+  // ExportTestCase()
+  //
+  // Writes the values of all variables in the test case.
+  void ExportTestCase() override;
+
+  // EndExport()
+  //
+  // Closes the temporary file and renames it to `path`.
+  void EndExport() override;
+
+ private:
+  std::string path_;
+  std::string temporary_path_;
+  std::shared_ptr<std::ofstream> os_;
+  moriarty_internal::VariablesByName variables_;
+};
+
+// BinaryImporter
+//
+// Imports test cases written by `BinaryExporter`. Values are decoded directly
+// from the input without copying it.
+class BinaryImporter : public Importer {
+ public:
+  // `data` must outlive this importer.
+  explicit BinaryImporter(absl::string_view data);
+
+  // FromFile()
+  //
+  // Returns an importer that reads the file at `path`. By default, the whole
+  // file is read into memory, which works on any platform. Depending on
+  // `//src:binary_io_mmap` as well (which needs POSIX `mmap()`) memory-maps
+  // regular files instead, so only the pages that are decoded are read. The
+  // contents are kept alive as long as the importer (or any copy of it) is.
+  static absl::StatusOr<BinaryImporter> FromFile(absl::string_view path);
+
+  // SelectTestCases()
+  //
+  // Only imports the test cases with the given (1-based) numbers, which must
+  // be strictly increasing. The other test cases are skipped without decoding
+  // them, so a process can import a few test cases of a large file quickly.
+  // By default, all test cases are imported.
+  void SelectTestCases(std::vector<int64_t> test_case_numbers);
+
+  // StartImport()
+  //
+  // Reads the header of the binary format.
+  absl::Status StartImport() override;
+
+  // ImportTestCase()
+  //
+  // Reads the values of all variables in a test case.
+  absl::Status ImportTestCase() override;
+
+ private:
+  absl::string_view data_;
+  absl::string_view remaining_;
+  std::optional<std::vector<int64_t>> selected_test_cases_;
+  // The number of test cases read or skipped so far, and the number of
+  // selected test cases imported so far.
+  int64_t num_read_test_cases_ = 0;
+  size_t num_imported_selected_test_cases_ = 0;
+  // Owns `data_` if it was read by `FromFile()`.
+  std::shared_ptr<const void> file_;
+  moriarty_internal::VariablesByName variables_;
+};
+
+namespace moriarty_internal {
+
+// BinaryIOFileSupport
+//
+// Optional ways for `BinaryImporter` to read files, provided by other targets
+// so that `:binary_io` only needs the C++ standard library (see
+// `src/binary_io_mmap.h`). Each is `nullptr` until its target registers it,
+// which happens during static initialization.
+struct BinaryIOFileSupport {
+  // Returns the contents of the file at `path`, read in place. The returned
+  // pointer keeps them alive. Returns kFailedPrecondition if the file cannot be
+  // read in place (e.g., it is not a regular file).
+  absl::StatusOr<std::shared_ptr<const absl::string_view>> (*map_file)(
+      absl::string_view path) = nullptr;
+};
+
+// GetBinaryIOFileSupport()
+//
+// Returns the file support registered so far.
+BinaryIOFileSupport& GetBinaryIOFileSupport();
+
+}  // namespace moriarty_internal
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_BINARY_IO_H_
@@ -0,0 +1,55 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/binary_io_mmap.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/binary_io.h"
+#include "src/memory_mapped_file.h"
+
+namespace moriarty {
+
+namespace {
+
+struct MappedContents {
+  MemoryMappedFile file;
+  absl::string_view contents;
+};
+
+absl::StatusOr<std::shared_ptr<const absl::string_view>> MapFile(
+    absl::string_view path) {
+  absl::StatusOr<MemoryMappedFile> file = MemoryMappedFile::Open(path);
+  if (!file.ok()) return file.status();
+  // Moving the file keeps the same mapping.
+  absl::string_view contents = file->Contents();
+  auto mapped = std::make_shared<const MappedContents>(
+      MappedContents{.file = *std::move(file), .contents = contents});
+  // Shares ownership of the whole mapping.
+  return std::shared_ptr<const absl::string_view>(mapped, &mapped->contents);
+}
+
+[[maybe_unused]] const bool kRegistered = RegisterBinaryIOMmap();
+
+}  // namespace
+
+bool RegisterBinaryIOMmap() {
+  moriarty_internal::GetBinaryIOFileSupport().map_file = &MapFile;
+  return true;
+}
+
+}  // namespace moriarty
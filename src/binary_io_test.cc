@@ -0,0 +1,216 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/binary_io.h"
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/generator.h"
+#include "src/internal/binary_format.h"
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Lt;
+using ::testing::Not;
+using ::testing::StartsWith;
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+
+class FiveCasesGenerator : public Generator {
+ public:
+  void GenerateTestCases() override {
+    for (int i = 0; i < 5; i++) AddTestCase();
+  }
+};
+
+Moriarty MoriartyWithSeveralTypes() {
+  Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("N", MInteger().Between(1, 100));
+  M.AddVariable("S", MString().OfLength(1, 10).WithAlphabet("abc"));
+  M.AddVariable("A", MArray(MInteger().Between(-1000000, 1000000))
+                         .OfLength("N"));
+  return M;
+}
+
+std::string GenerateBinary() {
+  Moriarty M = MoriartyWithSeveralTypes();
+  M.AddGenerator("Five", FiveCasesGenerator());
+  M.GenerateTestCases();
+  std::stringstream ss;
+  M.ExportTestCases(BinaryExporter(ss));
+  return ss.str();
+}
+
+std::string ReExport(Moriarty& M) {
+  std::stringstream ss;
+  M.ExportTestCases(BinaryExporter(ss));
+  return ss.str();
+}
+
+TEST(BinaryIOTest, ExportedTestCasesCanBeImported) {
+  std::string binary = GenerateBinary();
+
+  Moriarty M = MoriartyWithSeveralTypes();
+  MORIARTY_ASSERT_OK(M.ImportTestCases(BinaryImporter(binary)));
+  MORIARTY_EXPECT_OK(M.TryValidateTestCases());
+  EXPECT_EQ(ReExport(M), binary);
+}
+
+TEST(BinaryIOTest, BinaryIsSmallerThanText) {
+  Moriarty M = MoriartyWithSeveralTypes();
+  M.AddGenerator("Five", FiveCasesGenerator());
+  M.GenerateTestCases();
+  std::stringstream text;
+  M.ExportTestCases(SimpleIO().AddLine("N", "S").AddLine("A").Exporter(text));
+
+  EXPECT_THAT(GenerateBinary().size(), Lt(text.str().size()));
+}
+
+TEST(BinaryIOTest, FromFileReadsAMemoryMappedFile) {
+  std::string binary = GenerateBinary();
+  std::string path =
+      (std::filesystem::path(::testing::TempDir()) / "binary_io_test.bin")
+          .string();
+  std::ofstream(path, std::ios::binary) << binary;
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(BinaryImporter importer,
+                                BinaryImporter::FromFile(path));
+  Moriarty M = MoriartyWithSeveralTypes();
+  MORIARTY_ASSERT_OK(M.ImportTestCases(importer));
+  EXPECT_EQ(ReExport(M), binary);
+}
+
+TEST(BinaryIOTest, FromFileWorksWithoutMemoryMapping) {
+  std::string binary = GenerateBinary();
+  std::string path =
+      (std::filesystem::path(::testing::TempDir()) / "binary_io_read_test.bin")
+          .string();
+  std::ofstream(path, std::ios::binary) << binary;
+
+  // Only this test acts as if `//src:binary_io_mmap` was not linked in.
+  moriarty_internal::BinaryIOFileSupport& support =
+      moriarty_internal::GetBinaryIOFileSupport();
+  moriarty_internal::BinaryIOFileSupport registered = support;
+  support.map_file = nullptr;
+  absl::StatusOr<BinaryImporter> importer = BinaryImporter::FromFile(path);
+  support = registered;
+  MORIARTY_ASSERT_OK(importer);
+
+  Moriarty M = MoriartyWithSeveralTypes();
+  MORIARTY_ASSERT_OK(M.ImportTestCases(*importer));
+  EXPECT_EQ(ReExport(M), binary);
+}
+
+TEST(BinaryIOTest, FromFileMissingFileFails) {
+  EXPECT_THAT(BinaryImporter::FromFile("/this/file/does/not/exist"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(BinaryIOTest, BinaryFileExporterPublishesTheWholeFile) {
+  std::string binary = GenerateBinary();
+  std::filesystem::path dir = ::testing::TempDir();
+  std::string path = (dir / "binary_file_exporter_test.bin").string();
+  std::ofstream(path, std::ios::binary) << "previous contents";
+
+  Moriarty M = MoriartyWithSeveralTypes();
+  M.AddGenerator("Five", FiveCasesGenerator());
+  M.GenerateTestCases();
+  M.ExportTestCases(BinaryFileExporter(path));
+
+  std::ifstream file(path, std::ios::binary);
+  EXPECT_EQ(std::string(std::istreambuf_iterator<char>(file), {}), binary);
+  // Only the published file is left in the directory.
+  for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+    EXPECT_THAT(entry.path().filename().string(),
+                Not(StartsWith("binary_file_exporter_test.bin.tmp")));
+  }
+}
+
+TEST(BinaryIOTest, SelectTestCasesImportsOnlyThoseTestCases) {
+  std::string binary = GenerateBinary();
+
+  // The expected output is the header followed by test cases 2 and 5.
+  absl::string_view in = binary;
+  MORIARTY_ASSERT_OK(moriarty_internal::ReadBinaryFormatHeader(in));
+  std::string expected(binary.substr(0, binary.size() - in.size()));
+  for (int test_case = 1; test_case <= 5; test_case++) {
+    absl::string_view before = in;
+    MORIARTY_ASSERT_OK(moriarty_internal::SkipEncodedTestCase(in));
+    if (test_case == 2 || test_case == 5)
+      expected += before.substr(0, before.size() - in.size());
+  }
+
+  BinaryImporter importer(binary);
+  importer.SelectTestCases({2, 5});
+  Moriarty M = MoriartyWithSeveralTypes();
+  MORIARTY_ASSERT_OK(M.ImportTestCases(importer));
+  MORIARTY_EXPECT_OK(M.TryValidateTestCases());
+  EXPECT_EQ(ReExport(M), expected);
+}
+
+TEST(BinaryIOTest, SelectingATestCaseAfterTheLastOneFails) {
+  std::string binary = GenerateBinary();
+  BinaryImporter importer(binary);
+  importer.SelectTestCases({1, 6});
+  Moriarty M = MoriartyWithSeveralTypes();
+  EXPECT_THAT(M.ImportTestCases(importer),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("only 5 test cases")));
+}
+
+TEST(BinaryIOTest, ImportingTextFails) {
+  Moriarty M = MoriartyWithSeveralTypes();
+  EXPECT_THAT(M.ImportTestCases(BinaryImporter("3 abc\n1 2 3\n")),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("binary format")));
+}
+
+TEST(BinaryIOTest, ImportingTruncatedDataFails) {
+  std::string binary = GenerateBinary();
+  Moriarty M = MoriartyWithSeveralTypes();
+  EXPECT_THAT(M.ImportTestCases(
+                  BinaryImporter(binary.substr(0, binary.size() - 1))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(BinaryIOTest, ImportingUnknownVariablesFails) {
+  std::string binary = GenerateBinary();
+  Moriarty M;
+  M.AddVariable("N", MInteger());
+  EXPECT_THAT(M.ImportTestCases(BinaryImporter(binary)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unknown variable")));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -55,6 +55,16 @@ class ConstraintValues {
   template <typename MType>
   typename MType::value_type GetValue(std::string_view variable_name) const;
 
+  // GetValueRef<>()
+  //
+  // Same as `GetValue<>()`, but returns a reference to the value instead of a
+  // copy, so a constraint can look at a large value (e.g., an array) without
+  // copying it on every check. Subvalues (e.g., "A.length") cannot be
+  // referenced; use `GetValue<>()` for those.
+  template <typename MType>
+  const typename MType::value_type& GetValueRef(
+      std::string_view variable_name) const;
+
  private:
   moriarty_internal::Universe& universe_;
 };
@@ -74,6 +84,15 @@ typename MType::value_type ConstraintValues::GetValue(
   return *var;
 }
 
+template <typename MType>
+const typename MType::value_type& ConstraintValues::GetValueRef(
+    std::string_view variable_name) const {
+  absl::StatusOr<const typename MType::value_type*> var =
+      universe_.GetValueRef<MType>(variable_name);
+  ABSL_CHECK_OK(var);
+  return **var;
+}
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_CONSTRAINT_VALUES_H_
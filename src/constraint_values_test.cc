@@ -47,6 +47,18 @@ TEST(ConstraintValuesTest, GetValueObtainsVariableValue) {
   EXPECT_EQ(cv.GetValue<MInteger>(var_name), value);
 }
 
+TEST(ConstraintValuesTest, GetValueRefReferencesTheStoredValue) {
+  Universe u;
+  ValueSet values;
+
+  values.Set<MString>("S", "hello");
+  u.SetConstValueSet(&values);
+
+  ConstraintValues cv(&u);
+  EXPECT_EQ(cv.GetValueRef<MString>("S"), "hello");
+  EXPECT_EQ(&cv.GetValueRef<MString>("S"), *values.GetRef<MString>("S"));
+}
+
 TEST(ConstraintValuesDeathTest, GetValueCrashesOnNotGeneratedValue) {
   Universe u;
   VariableSet variables;
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/digest_exporter.h"
+
+#include <ostream>
+#include <utility>
+
+#include "src/exporter.h"
+#include "src/internal/binary_format.h"
+#include "src/internal/digest.h"
+#include "src/simple_io.h"
+#include "src/test_case.h"
+
+namespace moriarty {
+
+DigestExporter::DigestExporter(SimpleIO simple_io, std::ostream& manifest)
+    : SimpleIOExporter(std::move(simple_io), *digest_stream_),
+      manifest_(&manifest) {}
+
+void DigestExporter::StartExport() {
+  variables_ = moriarty_internal::GetVariablesByName(
+      moriarty_internal::ExporterManager(this).GetGeneralConstraints());
+
+  SimpleIOExporter::StartExport();
+  *manifest_ << "header "
+             << moriarty_internal::DigestToHex(digest_stream_->TakeDigest())
+             << '\n';
+}
+
+void DigestExporter::ExportTestCase() {
+  SimpleIOExporter::ExportTestCase();
+  TestCaseMetadata metadata = GetTestCaseMetadata();
+  *manifest_ << "case " << metadata.GetTestCaseNumber() << " output "
+             << moriarty_internal::DigestToHex(digest_stream_->TakeDigest());
+
+  encoded_values_.clear();
+  *manifest_ << " values ";
+  if (moriarty_internal::AppendEncodedTestCase(
+          moriarty_internal::ExporterManager(this).GetCurrentValues(),
+          variables_, encoded_values_)
+          .ok()) {
+    moriarty_internal::Digest128 digest;
+    digest.Update(encoded_values_);
+    *manifest_ << moriarty_internal::DigestToHex(digest.Finish());
+  } else {
+    *manifest_ << "-";
+  }
+
+  if (metadata.GetGeneratorMetadata().has_value()) {
+    *manifest_ << " generator "
+               << metadata.GetGeneratorMetadata()->generator_name;
+  }
+  *manifest_ << '\n';
+}
+
+void DigestExporter::EndExport() {
+  SimpleIOExporter::EndExport();
+  *manifest_ << "footer "
+             << moriarty_internal::DigestToHex(digest_stream_->TakeDigest())
+             << '\n'
+             << "total "
+             << moriarty_internal::DigestToHex(digest_stream_->TotalDigest())
+             << '\n';
+}
+
+}  // namespace moriarty
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MORIARTY_SRC_DIGEST_EXPORTER_H_
+#define MORIARTY_SRC_DIGEST_EXPORTER_H_
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "src/internal/binary_format.h"
+#include "src/internal/digest.h"
+#include "src/simple_io.h"
+
+namespace moriarty {
+
+namespace moriarty_internal {
+
+// Owns the stream that `DigestExporter` prints to. It is a base class of
+// `DigestExporter` (listed before `SimpleIOExporter`), so the stream exists
+// before `SimpleIOExporter` is constructed with it.
+class DigestStreamOwner {
+ protected:
+  std::unique_ptr<DigestStream> digest_stream_ =
+      std::make_unique<DigestStream>();
+};
+
+}  // namespace moriarty_internal
+
+// DigestExporter
+//
+// Instead of writing the test cases, writes a small manifest with a 128-bit
+// digest of each of them (see `moriarty_internal::Digest128`). Two runs (e.g.,
+// on different platforms) produced the same test cases if and only if (barring
+// hash collisions) their manifests are identical, so checking determinism does
+// not require writing and comparing all of the test cases.
+//
+// Each test case has two digests:
+//  * output: the bytes `SimpleIOExporter` would print for the test case.
+//  * values: the values of all variables, in the format of `BinaryExporter`.
+//    "-" if some value is not of a built-in type.
+//
+// The manifest has one line per test case, between lines for the header and
+// footer lines of `simple_io`. The last line is the digest of everything
+// `SimpleIOExporter` would print:
+//
+//   header <digest>
+//   case 1 output <digest> values <digest> generator <generator name>
+//   case 2 output <digest> values <digest> generator <generator name>
+//   footer <digest>
+//   total <digest>
+//
+// where each `<digest>` is 32 hexadecimal digits. " generator ..." is omitted
+// for test cases that were not generated.
+//
+// Example usage:
+//
+//   M.GenerateTestCases();
+//   M.ExportTestCases(DigestExporter(SimpleIO().AddLine("N"), std::cout));
+class DigestExporter : private moriarty_internal::DigestStreamOwner,
+                       public SimpleIOExporter {
+ public:
+  explicit DigestExporter(SimpleIO simple_io, std::ostream& manifest);
+
+  // StartExport()
+  //
+  // Writes the digest of the header lines.
+  void StartExport() override;
+
+  // ExportTestCase()
+  //
+  // Writes the digests of the current test case.
+  void ExportTestCase() override;
+
+  // EndExport()
+  //
+  // Writes the digest of the footer lines and the total digest.
+  void EndExport() override;
+
+ private:
+  std::ostream* manifest_;
+  moriarty_internal::VariablesByName variables_;
+  std::string encoded_values_;  // Reused between test cases.
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_DIGEST_EXPORTER_H_
@@ -0,0 +1,126 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/digest_exporter.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "src/generator.h"
+#include "src/internal/digest.h"
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::moriarty_internal::Digest128;
+using ::moriarty::moriarty_internal::DigestToHex;
+using ::testing::MatchesRegex;
+using ::testing::SizeIs;
+using ::testing::StartsWith;
+
+class FiveCasesGenerator : public Generator {
+ public:
+  void GenerateTestCases() override {
+    for (int i = 0; i < 5; i++) AddTestCase();
+  }
+};
+
+Moriarty GeneratedMoriarty(absl::string_view seed) {
+  Moriarty M;
+  M.SetSeed(seed);
+  M.AddVariable("N", MInteger().Between(1, 100));
+  M.AddVariable("S", MString().OfLength(1, 10).WithAlphabet("abc"));
+  M.AddVariable("A", MArray(MInteger().Between(-1000000, 1000000))
+                         .OfLength("N"));
+  M.AddGenerator("Five", FiveCasesGenerator());
+  M.GenerateTestCases();
+  return M;
+}
+
+SimpleIO TestSimpleIO() {
+  return SimpleIO()
+      .AddHeaderLine(StringLiteral("begin"))
+      .AddLine("N", "S")
+      .AddLine("A")
+      .AddFooterLine(StringLiteral("end"));
+}
+
+std::string Manifest(Moriarty& M) {
+  std::stringstream manifest;
+  M.ExportTestCases(DigestExporter(TestSimpleIO(), manifest));
+  return manifest.str();
+}
+
+std::string DigestOf(absl::string_view bytes) {
+  Digest128 digest;
+  digest.Update(bytes);
+  return DigestToHex(digest.Finish());
+}
+
+TEST(DigestExporterTest, ManifestShouldHaveOneLinePerTestCase) {
+  Moriarty M = GeneratedMoriarty("abcde0123456789");
+  std::vector<std::string> lines =
+      absl::StrSplit(Manifest(M), '\n', absl::SkipEmpty());
+
+  ASSERT_THAT(lines, SizeIs(8));
+  EXPECT_EQ(lines[0], "header " + DigestOf("begin\n"));
+  for (int i = 1; i <= 5; i++) {
+    EXPECT_THAT(lines[i], MatchesRegex(absl::StrCat(
+                              "case ", i, " output [0-9a-f]{32} values "
+                              "[0-9a-f]{32} generator Five")));
+  }
+  EXPECT_EQ(lines[6], "footer " + DigestOf("end\n"));
+  EXPECT_THAT(lines[7], StartsWith("total "));
+}
+
+TEST(DigestExporterTest, DigestsShouldMatchTheSimpleIOOutput) {
+  Moriarty M = GeneratedMoriarty("abcde0123456789");
+  std::stringstream text;
+  M.ExportTestCases(TestSimpleIO().Exporter(text));
+
+  std::vector<std::string> lines =
+      absl::StrSplit(Manifest(M), '\n', absl::SkipEmpty());
+  EXPECT_EQ(lines.back(), "total " + DigestOf(text.str()));
+
+  // The first test case is the second and third lines of the text.
+  std::vector<absl::string_view> text_lines =
+      absl::StrSplit(text.str(), '\n');
+  std::string first_case =
+      absl::StrCat(text_lines[1], "\n", text_lines[2], "\n");
+  EXPECT_THAT(lines[1],
+              StartsWith(absl::StrCat("case 1 output ", DigestOf(first_case))));
+}
+
+TEST(DigestExporterTest, SameSeedShouldGiveTheSameManifest) {
+  Moriarty M1 = GeneratedMoriarty("abcde0123456789");
+  Moriarty M2 = GeneratedMoriarty("abcde0123456789");
+  Moriarty M3 = GeneratedMoriarty("zyxwv0123456789");
+  EXPECT_EQ(Manifest(M1), Manifest(M2));
+  EXPECT_NE(Manifest(M1), Manifest(M3));
+}
+
+}  // namespace
+}  // namespace moriarty
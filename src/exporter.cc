@@ -14,6 +14,7 @@
 
 #include "src/exporter.h"
 
+#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -21,9 +22,12 @@
 #include "absl/log/absl_check.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "src/errors.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
+#include "src/internal/tracing.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
@@ -33,25 +37,49 @@
 namespace moriarty {
 
 void Exporter::ExportTestCases() {
-  StartExport();
+  CallWithSharedValues(&Exporter::StartExport);
+
+  if (!ExportTestCasesConcurrently()) {
+    absl::Span<const moriarty_internal::ValueSet> values = GetAllValues();
+    for (int index = 0; index < values.size(); index++) {
+      ExportSingleTestCase(values[index], all_metadata_[index]);
+      if (index + 1 != values.size()) TestCaseDivider();
+    }
+  }
+
+  CallWithSharedValues(&Exporter::EndExport);
+}
+
+void Exporter::ExportSingleTestCase(const moriarty_internal::ValueSet& values,
+                                    TestCaseMetadata metadata) {
+  current_values_ = &values;
+  current_metadata_ = std::move(metadata);
 
   auto universe = moriarty_internal::Universe()
                       .SetConstVariableSet(&general_constraints_)
-                      .SetIOConfig(io_config_);
+                      .SetIOConfig(io_config_)
+                      .SetConstValueSet(current_values_);
   general_constraints_.SetUniverse(&universe);
 
-  for (int index = 0; index < all_values_.size(); index++) {
-    current_values_ = all_values_[index];
-    current_metadata_ = all_metadata_[index];
-    universe.SetConstValueSet(&(*current_values_));
-
+  {
+    MORIARTY_TRACE_SPAN("Exporter::ExportTestCase");
     ExportTestCase();
-    current_values_ = std::nullopt;  // Unset it so they do not access it later.
+  }
+  current_values_ = nullptr;  // Unset it so they do not access it later.
+}
 
-    if (index + 1 != all_values_.size()) TestCaseDivider();
+void Exporter::CallWithSharedValues(void (Exporter::*export_fn)()) {
+  if (shared_values_ == nullptr) {
+    (this->*export_fn)();
+    return;
   }
 
-  EndExport();
+  auto universe = moriarty_internal::Universe()
+                      .SetConstVariableSet(&general_constraints_)
+                      .SetIOConfig(io_config_)
+                      .SetConstValueSet(shared_values_.get());
+  general_constraints_.SetUniverse(&universe);
+  (this->*export_fn)();
 }
 
 TestCaseMetadata Exporter::GetTestCaseMetadata() const {
@@ -68,7 +96,17 @@ absl::StatusOr<TestCaseMetadata> Exporter::TryGetTestCaseMetadata() const {
   return *current_metadata_;
 }
 
-int Exporter::NumTestCases() const { return all_values_.size(); }
+int Exporter::NumTestCases() const {
+  if (streaming_) {
+    ABSL_CHECK(all_test_cases_streamed_)
+        << "NumTestCases() cannot be used while test cases are being "
+           "streamed. It can only be used in EndExport().";
+    return num_streamed_test_cases_;
+  }
+  return GetAllValues().size();
+}
+
+bool Exporter::IsStreaming() const { return streaming_; }
 
 void Exporter::SetIOConfig(librarian::IOConfig* io_config) {
   io_config_ = io_config;
@@ -76,15 +114,48 @@ void Exporter::SetIOConfig(librarian::IOConfig* io_config) {
 
 librarian::IOConfig* Exporter::GetIOConfig() { return io_config_; }
 
+const moriarty_internal::VariableSet& Exporter::GetGeneralConstraints() const {
+  return general_constraints_;
+}
+
+const moriarty_internal::ValueSet& Exporter::GetCurrentValues() const {
+  ABSL_CHECK(current_values_ != nullptr)
+      << "GetCurrentValues() called outside of ExportTestCase()";
+  return *current_values_;
+}
+
 void Exporter::SetAllValues(std::vector<moriarty_internal::ValueSet> values) {
   all_values_ = std::move(values);
+  borrowed_values_ = std::nullopt;
+}
+
+void Exporter::BorrowAllValues(
+    absl::Span<const moriarty_internal::ValueSet> values) {
+  all_values_.clear();
+  borrowed_values_ = values;
 }
 
 void Exporter::SetTestCaseMetadata(std::vector<TestCaseMetadata> metadata) {
-  ABSL_CHECK_EQ(metadata.size(), all_values_.size());
+  ABSL_CHECK_EQ(metadata.size(), GetAllValues().size());
   all_metadata_ = std::move(metadata);
 }
 
+absl::Span<const moriarty_internal::ValueSet> Exporter::GetAllValues() const {
+  return borrowed_values_.value_or(all_values_);
+}
+
+const std::vector<TestCaseMetadata>& Exporter::GetAllTestCaseMetadata() const {
+  return all_metadata_;
+}
+
+void Exporter::SetScheduler(moriarty_internal::Scheduler* scheduler) {
+  scheduler_ = scheduler;
+}
+
+moriarty_internal::Scheduler* Exporter::GetScheduler() const {
+  return scheduler_;
+}
+
 absl::StatusOr<moriarty_internal::AbstractVariable*>
 Exporter::GetAbstractVariable(absl::string_view variable_name) {
   return general_constraints_.GetAbstractVariable(variable_name);
@@ -95,6 +166,36 @@ void Exporter::SetGeneralConstraints(
   general_constraints_ = std::move(general_constraints);
 }
 
+void Exporter::SetSharedValues(
+    std::shared_ptr<const moriarty_internal::ValueSet> shared_values) {
+  shared_values_ = std::move(shared_values);
+}
+
+void Exporter::StartStreamingExport() {
+  ABSL_CHECK(!streaming_) << "StartStreamingExport() called twice.";
+  streaming_ = true;
+  all_test_cases_streamed_ = false;
+  num_streamed_test_cases_ = 0;
+  CallWithSharedValues(&Exporter::StartExport);
+}
+
+void Exporter::StreamTestCase(moriarty_internal::ValueSet values,
+                              TestCaseMetadata metadata) {
+  ABSL_CHECK(streaming_)
+      << "StreamTestCase() called without StartStreamingExport().";
+  if (num_streamed_test_cases_ > 0) TestCaseDivider();
+  num_streamed_test_cases_++;
+  ExportSingleTestCase(values, std::move(metadata));
+}
+
+void Exporter::EndStreamingExport() {
+  ABSL_CHECK(streaming_)
+      << "EndStreamingExport() called without StartStreamingExport().";
+  all_test_cases_streamed_ = true;
+  CallWithSharedValues(&Exporter::EndExport);
+  streaming_ = false;
+}
+
 // -----------------------------------------------------------------------------
 //   Internal Extended API
 
@@ -107,11 +208,28 @@ void ExporterManager::SetAllValues(std::vector<ValueSet> values) {
   managed_exporter_.SetAllValues(std::move(values));
 }
 
+void ExporterManager::BorrowAllValues(absl::Span<const ValueSet> values) {
+  managed_exporter_.BorrowAllValues(values);
+}
+
 void ExporterManager::SetTestCaseMetadata(
     std::vector<TestCaseMetadata> metadata) {
   return managed_exporter_.SetTestCaseMetadata(std::move(metadata));
 }
 
+void ExporterManager::StartStreamingExport() {
+  managed_exporter_.StartStreamingExport();
+}
+
+void ExporterManager::StreamTestCase(ValueSet values,
+                                     TestCaseMetadata metadata) {
+  managed_exporter_.StreamTestCase(std::move(values), std::move(metadata));
+}
+
+void ExporterManager::EndStreamingExport() {
+  managed_exporter_.EndStreamingExport();
+}
+
 absl::StatusOr<AbstractVariable*> ExporterManager::GetAbstractVariable(
     absl::string_view variable_name) {
   return managed_exporter_.GetAbstractVariable(variable_name);
@@ -121,10 +239,40 @@ void ExporterManager::SetGeneralConstraints(VariableSet general_constraints) {
   managed_exporter_.SetGeneralConstraints(std::move(general_constraints));
 }
 
+void ExporterManager::SetSharedValues(
+    std::shared_ptr<const ValueSet> shared_values) {
+  managed_exporter_.SetSharedValues(std::move(shared_values));
+}
+
 librarian::IOConfig* ExporterManager::GetIOConfig() {
   return managed_exporter_.GetIOConfig();
 }
 
+const VariableSet& ExporterManager::GetGeneralConstraints() const {
+  return managed_exporter_.GetGeneralConstraints();
+}
+
+const ValueSet& ExporterManager::GetCurrentValues() const {
+  return managed_exporter_.GetCurrentValues();
+}
+
+absl::Span<const ValueSet> ExporterManager::GetAllValues() const {
+  return managed_exporter_.GetAllValues();
+}
+
+const std::vector<TestCaseMetadata>& ExporterManager::GetAllTestCaseMetadata()
+    const {
+  return managed_exporter_.GetAllTestCaseMetadata();
+}
+
+void ExporterManager::SetScheduler(Scheduler* scheduler) {
+  managed_exporter_.SetScheduler(scheduler);
+}
+
+Scheduler* ExporterManager::GetScheduler() const {
+  return managed_exporter_.GetScheduler();
+}
+
 }  // namespace moriarty_internal
 
 }  // namespace moriarty
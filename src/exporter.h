@@ -18,13 +18,17 @@
 #define MORIARTY_SRC_EXPORTER_H_
 
 #include <concepts>
+#include <memory>
 #include <optional>
 #include <vector>
 
+#include "absl/base/nullability.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "src/errors.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
@@ -57,13 +61,16 @@ class Exporter {
   //    respectively. Once for each test case and once between each pair of test
   //    cases, respectively.
   // 3. `EndExport()` is called exactly once.
+  //
+  // If `ExportTestCasesConcurrently()` returns true, it replaces step 2.
   void ExportTestCases();
 
  protected:
   // StartExport() [virtual/optional]
   //
   // User-written code to export information prior to the first test case.
-  // Any call to `GetValue` will crash.
+  // Only suite-level variables (see `Moriarty::AddSharedVariable()`) may be
+  // read with `GetValue`. Any other call to `GetValue` will crash.
   //
   // By default, this does nothing.
   virtual void StartExport() {}
@@ -85,12 +92,26 @@ class Exporter {
 
   // EndExport() [virtual/optional]
   //
-  // User-written code to import information after the final test case. Any call
-  // to `GetValue` will crash.
+  // User-written code to import information after the final test case. Only
+  // suite-level variables (see `Moriarty::AddSharedVariable()`) may be read
+  // with `GetValue`. Any other call to `GetValue` will crash.
   //
   // By default, this does nothing.
   virtual void EndExport() {}
 
+  // ExportTestCasesConcurrently() [virtual/optional]
+  //
+  // Exporters whose test cases are independent of each other (for example,
+  // each one is written to its own file) may override this to export all test
+  // cases at once, possibly in parallel on `ExporterManager::GetScheduler()`.
+  // Called between `StartExport()` and `EndExport()`, instead of
+  // `ExportTestCase()` and `TestCaseDivider()`. Return false to have the test
+  // cases exported one at a time instead.
+  //
+  // This is not used when test cases are streamed. By default, this returns
+  // false.
+  virtual bool ExportTestCasesConcurrently() { return false; }
+
   // GetValue<>()
   //
   // Grabs the variable with the specified name. The argument is the type it is
@@ -118,6 +139,32 @@ class Exporter {
   absl::StatusOr<typename T::value_type> TryGetValue(
       absl::string_view variable_name) const;
 
+  // GetValueRef<>()
+  //
+  // Same as `GetValue<>()`, but returns a reference to the value instead of a
+  // copy, so large values (e.g., arrays) can be exported without copying them.
+  // The reference is valid until this test case has been exported.
+  //
+  //   const std::vector<int64_t>& A = GetValueRef<MArray<MInteger>>("A");
+  //
+  // Crashes on failure. See `TryGetValueRef()` for non-crashing version.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  const T::value_type& GetValueRef(absl::string_view variable_name) const;
+
+  // TryGetValueRef<>()
+  //
+  // Same as `TryGetValue<>()`, but returns a pointer to the value instead of a
+  // copy. The pointer is valid until this test case has been exported.
+  //
+  // Returns status on failure. See `GetValueRef()` for simpler API version.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<absl::Nonnull<const typename T::value_type*>> TryGetValueRef(
+      absl::string_view variable_name) const;
+
   // GetTestCaseMetadata()
   //
   // Retrieves the metadata for this test case.
@@ -137,8 +184,20 @@ class Exporter {
   // NumTestCases()
   //
   // Returns the number of test cases to be exported.
+  //
+  // Crashes if the test cases are being streamed (see
+  // `Moriarty::GenerateAndExportTestCases()`) and generation is not complete
+  // yet, since the number of test cases is not known until then. While
+  // streaming, this may only be used from `EndExport()`.
   [[nodiscard]] int NumTestCases() const;
 
+  // IsStreaming()
+  //
+  // Returns true if the test cases are being streamed (see
+  // `Moriarty::GenerateAndExportTestCases()`), in which case `NumTestCases()`
+  // is only known in `EndExport()`.
+  [[nodiscard]] bool IsStreaming() const;
+
   // SetIOConfig()
   //
   // Sets the internal IOConfig to be passed to all variables.
@@ -148,13 +207,33 @@ class Exporter {
 
  private:
   std::vector<moriarty_internal::ValueSet> all_values_;
+  // If set, these are exported instead of `all_values_`. Not owned.
+  std::optional<absl::Span<const moriarty_internal::ValueSet>> borrowed_values_;
   std::vector<TestCaseMetadata> all_metadata_;
 
-  std::optional<moriarty_internal::ValueSet> current_values_;
+  // The values of the test case being exported. Not owned.
+  const moriarty_internal::ValueSet* current_values_ = nullptr;
   std::optional<TestCaseMetadata> current_metadata_;
 
   moriarty_internal::VariableSet general_constraints_;
+  // The values of the suite-level variables, known outside of test cases.
+  std::shared_ptr<const moriarty_internal::ValueSet> shared_values_;
   librarian::IOConfig* io_config_ = nullptr;
+  moriarty_internal::Scheduler* scheduler_ = nullptr;
+
+  // Streaming export information. See `StartStreamingExport()`.
+  bool streaming_ = false;
+  bool all_test_cases_streamed_ = false;
+  int num_streamed_test_cases_ = 0;
+
+  // Exports a single test case with the given values and metadata.
+  void ExportSingleTestCase(const moriarty_internal::ValueSet& values,
+                            TestCaseMetadata metadata);
+
+  // Calls `export_fn` (e.g., `StartExport()`) with only the shared values
+  // known to the general constraints, so they can be printed outside of a
+  // test case.
+  void CallWithSharedValues(void (Exporter::*export_fn)());
 
   // ---------------------------------------------------------------------------
   //    Start of Internal Extended API
@@ -171,6 +250,13 @@ class Exporter {
   // match the order in `SetTestCaseMetadata`.
   void SetAllValues(std::vector<moriarty_internal::ValueSet> values);
 
+  // BorrowAllValues() [Internal Extended API]
+  //
+  // Same as `SetAllValues()`, but `values` is not copied. `values` must not be
+  // changed or destroyed until the export is finished. Several exporters may
+  // borrow (and export) the same values at the same time.
+  void BorrowAllValues(absl::Span<const moriarty_internal::ValueSet> values);
+
   // SetTestCaseMetadata() [Internal Extended API]
   //
   // Sets the metadata for the `TestCase`s that will be exported. The order of
@@ -185,17 +271,83 @@ class Exporter {
   absl::StatusOr<moriarty_internal::AbstractVariable*> GetAbstractVariable(
       absl::string_view variable_name);
 
+  // StartStreamingExport() [Internal Extended API]
+  //
+  // An alternative to `SetAllValues()` + `ExportTestCases()` that exports test
+  // cases one at a time as they become available, without holding all of them
+  // in memory. Calls `StartExport()`. Each test case is then passed to
+  // `StreamTestCase()` and `EndStreamingExport()` must be called once all test
+  // cases have been streamed.
+  void StartStreamingExport();
+
+  // StreamTestCase() [Internal Extended API]
+  //
+  // Exports a single test case immediately, calling `TestCaseDivider()` before
+  // it if it is not the first test case. The values are not kept afterwards.
+  // Must be called between `StartStreamingExport()` and
+  // `EndStreamingExport()`.
+  void StreamTestCase(moriarty_internal::ValueSet values,
+                      TestCaseMetadata metadata);
+
+  // EndStreamingExport() [Internal Extended API]
+  //
+  // Calls `EndExport()`. Must be called after `StartStreamingExport()`.
+  void EndStreamingExport();
+
   // SetGeneralConstraints() [Internal Extended API]
   //
   // Sets the general constraints.
   void SetGeneralConstraints(
       moriarty_internal::VariableSet general_constraints);
 
+  // SetSharedValues() [Internal Extended API]
+  //
+  // Sets the values of the suite-level variables. These are known in every
+  // function, not only in `ExportTestCase()`.
+  void SetSharedValues(
+      std::shared_ptr<const moriarty_internal::ValueSet> shared_values);
+
   // GetIOConfig() [Internal Extended API]
   //
   // Returns the IOConfig if it has been set. `nullptr` otherwise.
   [[nodiscard]] librarian::IOConfig* GetIOConfig();
 
+  // GetGeneralConstraints() [Internal Extended API]
+  //
+  // Returns the general constraints.
+  [[nodiscard]] const moriarty_internal::VariableSet& GetGeneralConstraints()
+      const;
+
+  // GetCurrentValues() [Internal Extended API]
+  //
+  // Returns the values of the test case being exported. Crashes if called
+  // outside of `ExportTestCase()`.
+  [[nodiscard]] const moriarty_internal::ValueSet& GetCurrentValues() const;
+
+  // GetAllValues() [Internal Extended API]
+  //
+  // Returns the values of all test cases set by `SetAllValues()` or
+  // `BorrowAllValues()`.
+  [[nodiscard]] absl::Span<const moriarty_internal::ValueSet> GetAllValues()
+      const;
+
+  // GetAllTestCaseMetadata() [Internal Extended API]
+  //
+  // Returns the metadata of all test cases set by `SetTestCaseMetadata()`.
+  [[nodiscard]] const std::vector<TestCaseMetadata>& GetAllTestCaseMetadata()
+      const;
+
+  // SetScheduler() [Internal Extended API]
+  //
+  // Sets the scheduler that `ExportTestCasesConcurrently()` may use.
+  // `scheduler` must outlive the export. `nullptr` means a single thread.
+  void SetScheduler(moriarty_internal::Scheduler* scheduler);
+
+  // GetScheduler() [Internal Extended API]
+  //
+  // Returns the scheduler set by `SetScheduler()`, or `nullptr`.
+  [[nodiscard]] moriarty_internal::Scheduler* GetScheduler() const;
+
   //    End of Internal Extended API
   // ---------------------------------------------------------------------------
 };
@@ -228,11 +380,22 @@ class ExporterManager {
   explicit ExporterManager(moriarty::Exporter* exporter_to_manage);
 
   void SetAllValues(std::vector<ValueSet> values);
+  void BorrowAllValues(absl::Span<const ValueSet> values);
   void SetTestCaseMetadata(std::vector<TestCaseMetadata> metadata);
   absl::StatusOr<AbstractVariable*> GetAbstractVariable(
       absl::string_view variable_name);
+  void StartStreamingExport();
+  void StreamTestCase(ValueSet values, TestCaseMetadata metadata);
+  void EndStreamingExport();
   void SetGeneralConstraints(VariableSet general_constraints);
+  void SetSharedValues(std::shared_ptr<const ValueSet> shared_values);
   librarian::IOConfig* GetIOConfig();
+  const VariableSet& GetGeneralConstraints() const;
+  const ValueSet& GetCurrentValues() const;
+  absl::Span<const ValueSet> GetAllValues() const;
+  const std::vector<TestCaseMetadata>& GetAllTestCaseMetadata() const;
+  void SetScheduler(Scheduler* scheduler);
+  Scheduler* GetScheduler() const;
 
  private:
   moriarty::Exporter& managed_exporter_;
@@ -254,14 +417,40 @@ template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 absl::StatusOr<typename T::value_type> Exporter::TryGetValue(
     absl::string_view variable_name) const {
-  if (!current_values_) {
+  // Outside of `ExportTestCase()`, only the shared values are known.
+  const moriarty_internal::ValueSet* values =
+      current_values_ ? current_values_ : shared_values_.get();
+  if (!values) {
     // You can also get this error if you are calling `TryGetValue()` from
     // `StartExport`, `TestCaseDivider`, `EndExport`.
     return MisconfiguredError("Exporter", "TryGetValue",
                               InternalConfigurationType::kValueSet);
   }
 
-  return current_values_->Get<T>(variable_name);
+  return values->Get<T>(variable_name);
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+const T::value_type& Exporter::GetValueRef(
+    absl::string_view variable_name) const {
+  return moriarty_internal::TryFunctionOrCrash<const typename T::value_type>(
+      [&, this]() { return this->TryGetValueRef<T>(variable_name); },
+      "GetValueRef");
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<absl::Nonnull<const typename T::value_type*>>
+Exporter::TryGetValueRef(absl::string_view variable_name) const {
+  const moriarty_internal::ValueSet* values =
+      current_values_ ? current_values_ : shared_values_.get();
+  if (!values) {
+    return MisconfiguredError("Exporter", "TryGetValueRef",
+                              InternalConfigurationType::kValueSet);
+  }
+
+  return values->GetRef<T>(variable_name);
 }
 
 }  // namespace moriarty
@@ -56,6 +56,7 @@ class ProtectedExporter : public Exporter {
   void ExportTestCase() override {}  // Do nothing.
 
   using Exporter::GetValue;
+  using Exporter::IsStreaming;
   using Exporter::NumTestCases;
   using Exporter::SetIOConfig;
   using Exporter::TryGetTestCaseMetadata;
@@ -105,6 +106,19 @@ class ExporterMetadata : public Exporter {
   std::vector<ExporterFn> fn_calls_;
 };
 
+// SingleValueExporter
+//
+// Records the value of "A" (an MInteger) in each test case.
+class SingleValueExporter : public Exporter {
+ public:
+  void ExportTestCase() override { values_.push_back(GetValue<MInteger>("A")); }
+
+  std::vector<int64_t> Values() const { return values_; }
+
+ private:
+  std::vector<int64_t> values_;
+};
+
 struct ListOfValueSetAndMetadata {
   std::vector<moriarty_internal::ValueSet> values;
   std::vector<TestCaseMetadata> metadata;
@@ -196,6 +210,96 @@ TEST(ExporterTest, ExportTestCasesPassesCorrectMetadataToEachExportTestCase) {
                           Property(&TestCaseMetadata::GetTestCaseNumber, 789)));
 }
 
+TEST(ExporterTest, StreamingExportCallsFunctionsInAppropriateOrder) {
+  ExporterMetadata exporter;
+  moriarty_internal::ExporterManager manager(&exporter);
+
+  manager.StartStreamingExport();
+  for (int i = 1; i <= 3; i++) {
+    manager.StreamTestCase(moriarty_internal::ValueSet(),
+                           TestCaseMetadata().SetTestCaseNumber(i * 10));
+  }
+  manager.EndStreamingExport();
+
+  EXPECT_THAT(
+      exporter.FunctionCallOrder(),
+      ElementsAre(ExporterFn::kStartExport, ExporterFn::kExportTestCase,
+                  ExporterFn::kTestCaseDivider, ExporterFn::kExportTestCase,
+                  ExporterFn::kTestCaseDivider, ExporterFn::kExportTestCase,
+                  ExporterFn::kEndExport));
+  EXPECT_THAT(exporter.GetTestCaseMetadataInExportTestCase(),
+              ElementsAre(Property(&TestCaseMetadata::GetTestCaseNumber, 10),
+                          Property(&TestCaseMetadata::GetTestCaseNumber, 20),
+                          Property(&TestCaseMetadata::GetTestCaseNumber, 30)));
+}
+
+TEST(ExporterTest, StreamingExportWithNoTestCasesSucceeds) {
+  ExporterMetadata exporter;
+  moriarty_internal::ExporterManager(&exporter).StartStreamingExport();
+  moriarty_internal::ExporterManager(&exporter).EndStreamingExport();
+
+  EXPECT_THAT(exporter.FunctionCallOrder(),
+              ElementsAre(ExporterFn::kStartExport, ExporterFn::kEndExport));
+}
+
+TEST(ExporterTest, StreamedTestCaseValuesAreAvailableInExportTestCase) {
+  SingleValueExporter exporter;
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger()));
+  moriarty_internal::ExporterManager manager(&exporter);
+  manager.SetGeneralConstraints(variables);
+
+  manager.StartStreamingExport();
+  for (int64_t a : {5, 7}) {
+    moriarty_internal::ValueSet values;
+    values.Set<MInteger>("A", a);
+    manager.StreamTestCase(values, TestCaseMetadata());
+  }
+  manager.EndStreamingExport();
+
+  EXPECT_THAT(exporter.Values(), ElementsAre(5, 7));
+}
+
+// Records `NumTestCases()` in `EndExport()`.
+class NumTestCasesInEndExportExporter : public Exporter {
+ public:
+  void ExportTestCase() override {}
+  void EndExport() override { num_test_cases_ = NumTestCases(); }
+
+  int NumTestCasesInEndExport() const { return num_test_cases_; }
+
+ private:
+  int num_test_cases_ = -1;
+};
+
+TEST(ExporterTest, NumTestCasesShouldBeKnownInEndExportWhileStreaming) {
+  NumTestCasesInEndExportExporter exporter;
+  moriarty_internal::ExporterManager manager(&exporter);
+
+  manager.StartStreamingExport();
+  for (int i = 0; i < 4; i++) {
+    manager.StreamTestCase(moriarty_internal::ValueSet(), TestCaseMetadata());
+  }
+  manager.EndStreamingExport();
+
+  EXPECT_EQ(exporter.NumTestCasesInEndExport(), 4);
+}
+
+TEST(ExporterTest, IsStreamingShouldOnlyBeTrueDuringStreamingExport) {
+  ProtectedExporter exporter;
+  EXPECT_FALSE(exporter.IsStreaming());
+  moriarty_internal::ExporterManager(&exporter).StartStreamingExport();
+  EXPECT_TRUE(exporter.IsStreaming());
+  moriarty_internal::ExporterManager(&exporter).EndStreamingExport();
+  EXPECT_FALSE(exporter.IsStreaming());
+}
+
+TEST(ExporterDeathTest, NumTestCasesWhileStreamingShouldCrash) {
+  ProtectedExporter exporter;
+  moriarty_internal::ExporterManager(&exporter).StartStreamingExport();
+  EXPECT_DEATH({ (void)exporter.NumTestCases(); }, "streamed");
+}
+
 TEST(ExporterDeathTest, TestCaseMetadatasSizeMustBeTheSameAsSetAllValues) {
   {
     ProtectedExporter exporter;
@@ -237,6 +341,29 @@ TEST(ExporterTest, NumTestCasesReturnsNumberOfValuesSet) {
   EXPECT_EQ(exporter.NumTestCases(), 5);
 }
 
+// Records the address of the values of each exported test case.
+class AddressRecordingExporter : public Exporter {
+ public:
+  void ExportTestCase() override {
+    addresses.push_back(
+        &moriarty_internal::ExporterManager(this).GetCurrentValues());
+  }
+
+  std::vector<const moriarty_internal::ValueSet*> addresses;
+};
+
+TEST(ExporterTest, BorrowAllValuesExportsTheValuesWithoutCopying) {
+  std::vector<moriarty_internal::ValueSet> values(3);
+  AddressRecordingExporter exporter;
+  moriarty_internal::ExporterManager(&exporter).BorrowAllValues(values);
+  moriarty_internal::ExporterManager(&exporter).SetTestCaseMetadata(
+      std::vector<TestCaseMetadata>(3));
+
+  exporter.ExportTestCases();
+  EXPECT_THAT(exporter.addresses,
+              ElementsAre(&values[0], &values[1], &values[2]));
+}
+
 TEST(ExporterTest, GetAbstractVariableExtractsVariablesCorrectly) {
   ProtectedExporter exporter;
   moriarty_internal::VariableSet variables;
@@ -310,6 +437,10 @@ class GetValuesExporter : public Exporter {
     results_a_.push_back(TryGetValue<moriarty::MInteger>("A"));
     if (results_a_.back().ok()) {
       ABSL_CHECK_EQ(*results_a_.back(), GetValue<moriarty::MInteger>("A"));
+      ABSL_CHECK_EQ(*results_a_.back(),
+                    GetValueRef<moriarty::MInteger>("A"));
+      ABSL_CHECK_EQ(&GetValueRef<moriarty::MInteger>("A"),
+                    *TryGetValueRef<moriarty::MInteger>("A"));
     }
 
     // Does not exist.
@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/generation_server.h"
+
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "src/moriarty.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+GenerationServer::GenerationServer(Moriarty prepared)
+    : prepared_(std::move(prepared)) {}
+
+absl::StatusOr<Moriarty> GenerationServer::GenerateRequest(
+    absl::string_view seed, absl::string_view generator_name, int call) {
+  // Copying keeps the variables as they were prepared (constraints already
+  // parsed) and shares the generators and threads with `prepared_`.
+  Moriarty M = prepared_;
+  MORIARTY_RETURN_IF_ERROR(M.TrySetSeed(seed));
+
+  absl::MutexLock lock(&generate_mutex_);
+  MORIARTY_RETURN_IF_ERROR(
+      M.TryGenerateTestCasesFromCall(generator_name, call));
+  return M;
+}
+
+}  // namespace moriarty
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MORIARTY_SRC_GENERATION_SERVER_H_
+#define MORIARTY_SRC_GENERATION_SERVER_H_
+
+#include <concepts>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "src/exporter.h"
+#include "src/moriarty.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+// GenerationServer
+//
+// Regenerates single generator calls on request from a prepared `Moriarty`
+// that stays in memory, for processes that serve many requests (e.g., a UI
+// that regenerates test cases on demand). The work of preparing the
+// `Moriarty` (parsing the constraints of its variables, starting its threads,
+// etc.) is only done once, and so are process-wide caches such as covering
+// arrays.
+//
+// Example usage:
+//
+//   Moriarty M;
+//   M.AddVariable("N", MInteger().Between(1, "10^5"))
+//    .AddGenerator("Random", RandomGenerator(), 100)
+//    .SetNumThreads(4);
+//   GenerationServer server(std::move(M));
+//
+//   // For each request:
+//   absl::Status status = server.TryGenerate(seed, "Random", 17,
+//                                            SimpleIO().AddLine("N")
+//                                                .Exporter(response));
+class GenerationServer {
+ public:
+  // `prepared` must have its variables and generators added, and no stored
+  // test cases. Its seed (if any) is replaced by the seed of each request.
+  explicit GenerationServer(Moriarty prepared);
+
+  // TryGenerate()
+  //
+  // Generates the test cases of call number `call` of the generator named
+  // `generator_name` using `seed`, and exports them with `exporter`. The test
+  // cases are identical to `GenerateTestCasesFromCall()` on the prepared
+  // `Moriarty` with `SetSeed(seed)`. Requests do not affect each other.
+  //
+  // The generators are shared by all requests, so concurrent requests are
+  // generated one at a time. Their exports may overlap.
+  //
+  // Returns status on failure (e.g., an invalid seed or an unknown
+  // generator).
+  template <typename T>
+    requires std::derived_from<T, Exporter>
+  absl::Status TryGenerate(absl::string_view seed,
+                           absl::string_view generator_name, int call,
+                           T exporter);
+
+ private:
+  // Only read after construction, so it may be copied without the lock.
+  const Moriarty prepared_;
+  // Held while a request runs a generator.
+  absl::Mutex generate_mutex_;
+
+  // Returns a copy of `prepared_` holding the test cases of the request.
+  absl::StatusOr<Moriarty> GenerateRequest(absl::string_view seed,
+                                           absl::string_view generator_name,
+                                           int call)
+      ABSL_LOCKS_EXCLUDED(generate_mutex_);
+};
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename T>
+  requires std::derived_from<T, Exporter>
+absl::Status GenerationServer::TryGenerate(absl::string_view seed,
+                                           absl::string_view generator_name,
+                                           int call, T exporter) {
+  MORIARTY_ASSIGN_OR_RETURN(Moriarty M,
+                            GenerateRequest(seed, generator_name, call));
+  M.ExportTestCases(std::move(exporter));
+  return absl::OkStatus();
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_GENERATION_SERVER_H_
@@ -0,0 +1,131 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/generation_server.h"
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "src/moriarty.h"
+#include "src/testing/exporter_test_util.h"
+#include "src/testing/generator_test_util.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty_testing::ExampleTestCase;
+using ::moriarty_testing::TwoIntegerExporter;
+using ::moriarty_testing::TwoIntegerGeneratorWithRandomness;
+using ::testing::Ne;
+using ::testing::SizeIs;
+using ::moriarty::StatusIs;
+
+Moriarty PreparedMoriarty() {
+  Moriarty M;
+  M.AddVariable("R", MInteger().Between(3, 50));
+  M.AddGenerator("Gen 1", TwoIntegerGeneratorWithRandomness(), 7);
+  M.AddGenerator("Gen 2", TwoIntegerGeneratorWithRandomness(), 3);
+  return M;
+}
+
+std::vector<std::pair<int, int>> GetRAndS(
+    const std::vector<ExampleTestCase>& test_cases) {
+  std::vector<std::pair<int, int>> result;
+  for (const ExampleTestCase& c : test_cases) result.push_back({c.r, c.s});
+  return result;
+}
+
+std::vector<std::pair<int, int>> Serve(GenerationServer& server,
+                                       absl::string_view seed,
+                                       absl::string_view generator_name,
+                                       int call) {
+  std::vector<ExampleTestCase> test_cases;
+  MORIARTY_EXPECT_OK(server.TryGenerate(seed, generator_name, call,
+                                        TwoIntegerExporter(&test_cases)));
+  return GetRAndS(test_cases);
+}
+
+std::vector<std::pair<int, int>> GenerateFromCall(
+    absl::string_view seed, absl::string_view generator_name, int call) {
+  Moriarty M = PreparedMoriarty();
+  M.SetSeed(seed);
+  M.GenerateTestCasesFromCall(generator_name, call);
+  std::vector<ExampleTestCase> test_cases;
+  M.ExportTestCases(TwoIntegerExporter(&test_cases));
+  return GetRAndS(test_cases);
+}
+
+TEST(GenerationServerTest, ShouldMatchGenerateTestCasesFromCall) {
+  GenerationServer server(PreparedMoriarty());
+  for (const char* seed : {"abcde0123456789", "another seed 42"}) {
+    EXPECT_EQ(Serve(server, seed, "Gen 1", 5),
+              GenerateFromCall(seed, "Gen 1", 5));
+    EXPECT_EQ(Serve(server, seed, "Gen 2", 1),
+              GenerateFromCall(seed, "Gen 2", 1));
+  }
+  EXPECT_THAT(Serve(server, "abcde0123456789", "Gen 1", 5),
+              Ne(Serve(server, "another seed 42", "Gen 1", 5)));
+}
+
+TEST(GenerationServerTest, RequestsShouldNotAffectEachOther) {
+  GenerationServer server(PreparedMoriarty());
+  std::vector<std::pair<int, int>> first =
+      Serve(server, "abcde0123456789", "Gen 1", 2);
+  EXPECT_THAT(first, SizeIs(4));
+  Serve(server, "another seed 42", "Gen 2", 3);
+  EXPECT_EQ(Serve(server, "abcde0123456789", "Gen 1", 2), first);
+}
+
+TEST(GenerationServerTest, ConcurrentRequestsShouldMatchSequentialOnes) {
+  GenerationServer server(PreparedMoriarty());
+  constexpr int kNumCalls = 7;
+  std::vector<std::vector<std::pair<int, int>>> expected(kNumCalls);
+  for (int call = 1; call <= kNumCalls; call++)
+    expected[call - 1] = Serve(server, "abcde0123456789", "Gen 1", call);
+
+  std::vector<std::vector<std::pair<int, int>>> actual(kNumCalls);
+  std::vector<std::thread> threads;
+  for (int call = 1; call <= kNumCalls; call++) {
+    threads.emplace_back([&, call] {
+      actual[call - 1] = Serve(server, "abcde0123456789", "Gen 1", call);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(actual, expected);
+}
+
+TEST(GenerationServerTest, InvalidRequestsShouldFail) {
+  GenerationServer server(PreparedMoriarty());
+  std::vector<ExampleTestCase> test_cases;
+  EXPECT_THAT(server.TryGenerate("short", "Gen 1", 1,
+                                 TwoIntegerExporter(&test_cases)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(server.TryGenerate("abcde0123456789", "Gen 3", 1,
+                                 TwoIntegerExporter(&test_cases)),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(server.TryGenerate("abcde0123456789", "Gen 2", 4,
+                                 TwoIntegerExporter(&test_cases)),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -14,6 +14,7 @@
 
 #include "src/generator.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -24,19 +25,79 @@
 #include "absl/base/nullability.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "src/errors.h"
+#include "src/internal/generation_profile.h"
 #include "src/internal/random_config.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
+#include "src/lazy_permutation.h"
 #include "src/scenario.h"
 #include "src/test_case.h"
+#include "src/test_case_mutation.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 
+namespace {
+
+// Appended to the seed of a test case's RandomEngine, so that test cases and
+// optional test cases with the same index use different streams.
+constexpr int64_t kTestCaseStream = 0;
+constexpr int64_t kOptionalTestCaseStream = 1;
+
+// Returns the RandomEngine for the `index`-th test case in `stream`. It only
+// depends on `seed`, `stream` and `index`. Each test case's engine is split
+// from its own position in the stream's engine, which is O(1).
+//
+// Only used with the counter-based engine. With "v0.1", all test cases share
+// the generator's engine so that old seeds still give the same test cases.
+moriarty_internal::RandomEngine TestCaseRandomEngine(
+    absl::Span<const int64_t> seed, int64_t stream, int64_t index) {
+  std::vector<int64_t> test_case_seed(seed.begin(), seed.end());
+  test_case_seed.push_back(stream);
+  moriarty_internal::RandomEngine stream_rng(
+      test_case_seed, moriarty_internal::kCounterBasedVersion);
+  stream_rng.Jump(index);
+  return stream_rng.Split();
+}
+
+std::vector<std::unique_ptr<TestCase>> CopyTestCases(
+    const std::vector<std::unique_ptr<TestCase>>& test_cases) {
+  std::vector<std::unique_ptr<TestCase>> copy;
+  copy.reserve(test_cases.size());
+  for (const std::unique_ptr<TestCase>& test_case : test_cases)
+    copy.push_back(std::make_unique<TestCase>(*test_case));
+  return copy;
+}
+
+}  // namespace
+
+Generator::Generator(const Generator& other) { *this = other; }
+
+Generator& Generator::operator=(const Generator& other) {
+  if (this == &other) return *this;
+  test_cases_ = CopyTestCases(other.test_cases_);
+  optional_test_cases_ = CopyTestCases(other.optional_test_cases_);
+  rng_.reset();  // RandomEngine can be copied, but not assigned.
+  if (other.rng_) rng_.emplace(*other.rng_);
+  seed_ = other.seed_;
+  general_constraints_ = other.general_constraints_;
+  shared_values_ = other.shared_values_;
+  scenarios_ = other.scenarios_;
+  approximate_generation_limit_ = other.approximate_generation_limit_;
+  scheduler_ = other.scheduler_;
+  profile_ = other.profile_;
+  budget_ = other.budget_;
+  num_released_test_cases_ = other.num_released_test_cases_;
+  num_released_optional_test_cases_ = other.num_released_optional_test_cases_;
+  return *this;
+}
+
 TestCase& Generator::AddTestCase() {
   return moriarty_internal::TryFunctionOrCrash<TestCase>(
       [this]() { return this->TryAddTestCase(); }, "AddTestCase");
@@ -49,35 +110,57 @@ TestCase& Generator::AddOptionalTestCase() {
 }
 
 absl::StatusOr<absl::Nonnull<TestCase*>> Generator::TryAddTestCase() {
+  return TryAddTestCaseTo(test_cases_, "TryAddTestCase");
+}
+
+absl::StatusOr<absl::Nonnull<TestCase*>> Generator::TryAddOptionalTestCase() {
+  return TryAddTestCaseTo(optional_test_cases_, "TryAddOptionalTestCase");
+}
+
+absl::StatusOr<absl::Nonnull<TestCase*>> Generator::TryAddTestCaseTo(
+    std::vector<std::unique_ptr<TestCase>>& test_cases,
+    absl::string_view function_name) {
   if (!general_constraints_) {
-    return MisconfiguredError("Generator", "TryAddTestCase",
+    return MisconfiguredError("Generator", function_name,
                               InternalConfigurationType::kVariableSet);
   }
 
-  test_cases_.push_back(std::make_shared<TestCase>());
+  test_cases.push_back(std::make_unique<TestCase>());
 
-  TestCase& result = *test_cases_.back();
+  TestCase& result = *test_cases.back();
   for (const Scenario& scenario : scenarios_) result.WithScenario(scenario);
-  moriarty_internal::TestCaseManager(&result).SetVariables(
-      *general_constraints_);
+  moriarty_internal::TestCaseManager(&result).SetGeneralVariables(
+      general_constraints_);
+  moriarty_internal::TestCaseManager(&result).SetSharedValues(shared_values_);
   return &result;
 }
 
-// TODO(darcybest): merge these two together since they're just updating
-// different vectors.
-absl::StatusOr<absl::Nonnull<TestCase*>> Generator::TryAddOptionalTestCase() {
-  if (!general_constraints_) {
-    return MisconfiguredError("Generator", "TryAddTestCase",
-                              InternalConfigurationType::kVariableSet);
-  }
+void Generator::AddDerivedTestCase(const TestCase& base,
+                                   TestCaseMutation mutation) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&]() { return this->TryAddDerivedTestCase(base, std::move(mutation)); },
+      "AddDerivedTestCase");
+}
 
-  optional_test_cases_.push_back(std::make_shared<TestCase>());
+absl::Status Generator::TryAddDerivedTestCase(const TestCase& base,
+                                              TestCaseMutation mutation) {
+  auto it = std::find_if(test_cases_.begin(), test_cases_.end(),
+                         [&](const std::unique_ptr<TestCase>& test_case) {
+                           return test_case.get() == &base;
+                         });
+  if (it == test_cases_.end()) {
+    return absl::InvalidArgumentError(
+        "AddDerivedTestCase() requires a test case added by AddTestCase() or "
+        "AddDerivedTestCase() of the same Generator.");
+  }
+  int base_index = it - test_cases_.begin();
 
-  TestCase& result = *optional_test_cases_.back();
-  for (const Scenario& scenario : scenarios_) result.WithScenario(scenario);
-  moriarty_internal::TestCaseManager(&result).SetVariables(
-      *general_constraints_);
-  return &result;
+  MORIARTY_ASSIGN_OR_RETURN(
+      TestCase * test_case,
+      TryAddTestCaseTo(test_cases_, "TryAddDerivedTestCase"));
+  moriarty_internal::TestCaseManager(test_case).SetDerivation(
+      {.base_index = base_index, .mutation = std::move(mutation)});
+  return absl::OkStatus();
 }
 
 void Generator::WithScenario(Scenario scenario) {
@@ -93,16 +176,17 @@ absl::Status Generator::TryWithScenario(Scenario scenario) {
   return absl::OkStatus();
 }
 
-const std::vector<std::shared_ptr<TestCase>>& Generator::GetTestCases() {
+const std::vector<std::unique_ptr<TestCase>>& Generator::GetTestCases() {
   return test_cases_;
 }
 
 std::optional<const moriarty_internal::VariableSet>
 Generator::GetGeneralConstraints() {
-  return general_constraints_;
+  if (!general_constraints_) return std::nullopt;
+  return *general_constraints_;
 }
 
-const std::vector<std::shared_ptr<TestCase>>&
+const std::vector<std::unique_ptr<TestCase>>&
 Generator::GetOptionalTestCases() {
   return optional_test_cases_;
 }
@@ -118,42 +202,154 @@ Generator::AssignValuesInAllTestCases() {
                               InternalConfigurationType::kVariableSet);
   }
 
-  std::vector<moriarty_internal::ValueSet> assigned_test_cases;
-  assigned_test_cases.reserve(test_cases_.size());
-  for (auto& case_ptr : test_cases_) {
-    MORIARTY_ASSIGN_OR_RETURN(
-        moriarty_internal::ValueSet values,
-        moriarty_internal::TestCaseManager(case_ptr.get())
-            .AssignAllValues(*rng_, approximate_generation_limit_));
-    assigned_test_cases.push_back(values);
+  // With the counter-based engine, each test case has its own RandomEngine, so
+  // the values do not depend on which thread assigns which test case. With
+  // "v0.1", the test cases share `rng_` and are assigned in order.
+  const bool per_case_engines = rng_->IsCounterBased();
+  const int num_test_cases = test_cases_.size();
+  const int num_cases = num_test_cases + optional_test_cases_.size();
+  std::vector<absl::StatusOr<moriarty_internal::ValueSet>> values(num_cases);
+  std::vector<moriarty_internal::GenerationProfile> profiles(
+      profile_ ? num_cases : 0);
+  auto is_derived = [&](int i) {
+    return i < num_test_cases &&
+           moriarty_internal::TestCaseManager(test_cases_[i].get())
+                   .GetDerivation() != nullptr;
+  };
+  auto assign_case = [&](int i) {
+    // Derived test cases are filled in below, once their base is assigned.
+    if (is_derived(i)) return;
+    bool optional = i >= num_test_cases;
+    int index = optional ? i - num_test_cases : i;
+    TestCase& test_case =
+        optional ? *optional_test_cases_[index] : *test_cases_[index];
+    std::optional<moriarty_internal::RandomEngine> rng;
+    if (per_case_engines) {
+      rng.emplace(TestCaseRandomEngine(
+          seed_, optional ? kOptionalTestCaseStream : kTestCaseStream,
+          index + (optional ? num_released_optional_test_cases_
+                            : num_released_test_cases_)));
+    }
+    values[i] = moriarty_internal::TestCaseManager(&test_case)
+                    .AssignAllValues(rng ? *rng : *rng_,
+                                     approximate_generation_limit_,
+                                     scheduler_,
+                                     profiles.empty() ? nullptr : &profiles[i],
+                                     budget_);
+  };
+  // Optional test cases may fail, but running out of budget is fatal.
+  auto is_fatal = [&](int i) {
+    if (values[i].ok()) return false;
+    return i < num_test_cases || absl::IsResourceExhausted(values[i].status());
+  };
+
+  if (!per_case_engines || scheduler_ == nullptr ||
+      scheduler_->NumThreads() == 1) {
+    for (int i = 0; i < num_cases; i++) {
+      assign_case(i);
+      if (is_fatal(i)) break;
+    }
+  } else {
+    scheduler_->ParallelFor(num_cases, assign_case);
   }
 
-  for (auto& case_ptr : optional_test_cases_) {
-    absl::StatusOr<moriarty_internal::ValueSet> values =
-        moriarty_internal::TestCaseManager(case_ptr.get())
-            .AssignAllValues(*rng_, approximate_generation_limit_);
-    if (values.ok()) assigned_test_cases.push_back(*values);
+  // A derived test case copies the values of an earlier test case (its base
+  // has a smaller index), then applies its (usually small) mutation.
+  for (int i = 0; i < num_test_cases; i++) {
+    if (!is_derived(i)) continue;
+    const moriarty_internal::TestCaseDerivation& derivation =
+        *moriarty_internal::TestCaseManager(test_cases_[i].get())
+             .GetDerivation();
+    const absl::StatusOr<moriarty_internal::ValueSet>& base =
+        values[derivation.base_index];
+    if (!base.ok()) {
+      values[i] = base.status();
+      continue;
+    }
+    moriarty_internal::ValueSet derived = *base;
+    std::optional<moriarty_internal::RandomEngine> rng;
+    if (per_case_engines) {
+      rng.emplace(TestCaseRandomEngine(seed_, kTestCaseStream,
+                                       num_released_test_cases_ + i));
+    }
+    absl::Status status =
+        moriarty_internal::TestCaseMutationManager(&derivation.mutation)
+            .Apply(derived, rng ? *rng : *rng_);
+    if (status.ok()) {
+      values[i] = std::move(derived);
+    } else {
+      values[i] = std::move(status);
+    }
   }
 
+  // Collect the test cases in the order they were added, and report the
+  // error from the earliest one, as the serial version would.
+  std::vector<moriarty_internal::ValueSet> assigned_test_cases;
+  assigned_test_cases.reserve(num_cases);
+  int64_t allocated_bytes = 0;
+  for (int i = 0; i < num_cases; i++) {
+    if (!profiles.empty()) profile_->MergeFrom(profiles[i]);
+    if (is_fatal(i)) return values[i].status();
+    if (!values[i].ok()) continue;
+    if (profile_) {
+      profile_->RecordTestCase(values[i]->GetAllocatedBytes(),
+                               values[i]->GetPeakAllocatedBytes());
+      allocated_bytes += values[i]->GetAllocatedBytes();
+    }
+    assigned_test_cases.push_back(*std::move(values[i]));
+  }
+  if (profile_) profile_->RecordGeneratorCall(allocated_bytes);
+
   return assigned_test_cases;
 }
 
-void Generator::SetSeed(absl::Span<const int64_t> seed) {
-  rng_.emplace(seed, "v0.1");
+void Generator::SetSeed(absl::Span<const int64_t> seed,
+                        absl::string_view random_engine_version) {
+  rng_.emplace(seed, random_engine_version);
+  seed_.assign(seed.begin(), seed.end());
 }
 
 void Generator::SetGeneralConstraints(
     moriarty_internal::VariableSet general_constraints) {
-  general_constraints_.emplace(std::move(general_constraints));
+  general_constraints_ = std::make_shared<const moriarty_internal::VariableSet>(
+      std::move(general_constraints));
+}
+
+void Generator::SetSharedValues(
+    std::shared_ptr<const moriarty_internal::ValueSet> shared_values) {
+  shared_values_ = std::move(shared_values);
 }
 
 void Generator::SetApproximateGenerationLimit(int64_t limit) {
   approximate_generation_limit_ = limit;
 }
 
+void Generator::SetScheduler(moriarty_internal::Scheduler* scheduler) {
+  scheduler_ = scheduler;
+}
+
+void Generator::SetGenerationProfile(
+    moriarty_internal::GenerationProfile* profile) {
+  profile_ = profile;
+}
+
+void Generator::SetGenerationBudget(
+    moriarty_internal::GenerationBudget* budget) {
+  budget_ = budget;
+}
+
 void Generator::ClearCases() {
   test_cases_.clear();
   optional_test_cases_.clear();
+  num_released_test_cases_ = 0;
+  num_released_optional_test_cases_ = 0;
+}
+
+void Generator::ReleaseTestCases() {
+  num_released_test_cases_ += test_cases_.size();
+  num_released_optional_test_cases_ += optional_test_cases_.size();
+  test_cases_.clear();
+  optional_test_cases_.clear();
 }
 
 absl::Nullable<moriarty_internal::RandomEngine*> Generator::GetRandomEngine() {
@@ -161,6 +357,24 @@ absl::Nullable<moriarty_internal::RandomEngine*> Generator::GetRandomEngine() {
   return &(*rng_);
 }
 
+absl::Nullable<moriarty_internal::Scheduler*> Generator::GetScheduler() {
+  return scheduler_;
+}
+
+std::optional<int64_t> Generator::GetApproximateGenerationLimit() const {
+  return approximate_generation_limit_;
+}
+
+absl::Nullable<moriarty_internal::GenerationProfile*>
+Generator::GetGenerationProfile() {
+  return profile_;
+}
+
+absl::Nullable<moriarty_internal::GenerationBudget*>
+Generator::GetGenerationBudget() {
+  return budget_;
+}
+
 absl::StatusOr<std::vector<int>> Generator::TryRandomPermutation(int n) {
   if (!rng_) {
     return MisconfiguredError("Generator", "RandomPermutation",
@@ -170,6 +384,16 @@ absl::StatusOr<std::vector<int>> Generator::TryRandomPermutation(int n) {
   return moriarty_internal::RandomPermutation(*rng_, n);
 }
 
+absl::StatusOr<LazyPermutation> Generator::TryRandomLazyPermutation(
+    int64_t n) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomLazyPermutation",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomLazyPermutation(*rng_, n);
+}
+
 absl::StatusOr<int64_t> Generator::TryRandomInteger(int64_t min, int64_t max) {
   if (!rng_) {
     return MisconfiguredError("Generator", "RandomInteger",
@@ -194,6 +418,12 @@ std::vector<int> Generator::RandomPermutation(int n) {
       "RandomPermutation");
 }
 
+LazyPermutation Generator::RandomLazyPermutation(int64_t n) {
+  return moriarty_internal::TryFunctionOrCrash<LazyPermutation>(
+      [&, this]() { return this->TryRandomLazyPermutation(n); },
+      "RandomLazyPermutation");
+}
+
 int64_t Generator::RandomInteger(int64_t min, int64_t max) {
   return moriarty_internal::TryFunctionOrCrash<int64_t>(
       [&, this]() { return this->TryRandomInteger(min, max); },
@@ -205,12 +435,21 @@ int64_t Generator::RandomInteger(int64_t n) {
       [&, this]() { return this->TryRandomInteger(n); }, "RandomInteger");
 }
 
+void StreamingGenerator::GenerateTestCases() {
+  while (GenerateNextTestCase()) {
+  }
+}
+
+int StreamingGenerator::NumTestCasesAdded() const {
+  return num_released_test_cases_ + test_cases_.size();
+}
+
 namespace moriarty_internal {
 
 GeneratorManager::GeneratorManager(Generator* generator_to_manage)
     : managed_generator_(*generator_to_manage) {}
 
-const std::vector<std::shared_ptr<TestCase>>& GeneratorManager::GetTestCases() {
+const std::vector<std::unique_ptr<TestCase>>& GeneratorManager::GetTestCases() {
   return managed_generator_.GetTestCases();
 }
 
@@ -219,7 +458,7 @@ GeneratorManager::GetGeneralConstraints() {
   return managed_generator_.GetGeneralConstraints();
 }
 
-const std::vector<std::shared_ptr<TestCase>>&
+const std::vector<std::unique_ptr<TestCase>>&
 GeneratorManager::GetOptionalTestCases() {
   return managed_generator_.GetOptionalTestCases();
 }
@@ -229,25 +468,72 @@ GeneratorManager::AssignValuesInAllTestCases() {
   return managed_generator_.AssignValuesInAllTestCases();
 }
 
-void GeneratorManager::SetSeed(absl::Span<const int64_t> seed) {
-  managed_generator_.SetSeed(seed);
+void GeneratorManager::SetSeed(absl::Span<const int64_t> seed,
+                               absl::string_view random_engine_version) {
+  managed_generator_.SetSeed(seed, random_engine_version);
 }
 
 void GeneratorManager::SetGeneralConstraints(VariableSet general_constraints) {
   managed_generator_.SetGeneralConstraints(std::move(general_constraints));
 }
 
+void GeneratorManager::SetSharedValues(
+    std::shared_ptr<const ValueSet> shared_values) {
+  managed_generator_.SetSharedValues(std::move(shared_values));
+}
+
 void GeneratorManager::SetApproximateGenerationLimit(int64_t limit) {
   managed_generator_.SetApproximateGenerationLimit(limit);
 }
 
+void GeneratorManager::SetScheduler(Scheduler* scheduler) {
+  managed_generator_.SetScheduler(scheduler);
+}
+
+void GeneratorManager::SetGenerationProfile(GenerationProfile* profile) {
+  managed_generator_.SetGenerationProfile(profile);
+}
+
+void GeneratorManager::SetGenerationBudget(GenerationBudget* budget) {
+  managed_generator_.SetGenerationBudget(budget);
+}
+
 void GeneratorManager::ClearCases() { managed_generator_.ClearCases(); }
 
+void GeneratorManager::ReleaseTestCases() {
+  managed_generator_.ReleaseTestCases();
+}
+
+bool GeneratorManager::IsStreaming() {
+  return dynamic_cast<StreamingGenerator*>(&managed_generator_) != nullptr;
+}
+
+bool GeneratorManager::GenerateNextTestCase() {
+  auto* generator = dynamic_cast<StreamingGenerator*>(&managed_generator_);
+  return generator != nullptr && generator->GenerateNextTestCase();
+}
+
 absl::Nullable<moriarty_internal::RandomEngine*>
 GeneratorManager::GetRandomEngine() {
   return managed_generator_.GetRandomEngine();
 }
 
+absl::Nullable<Scheduler*> GeneratorManager::GetScheduler() {
+  return managed_generator_.GetScheduler();
+}
+
+std::optional<int64_t> GeneratorManager::GetApproximateGenerationLimit() {
+  return managed_generator_.GetApproximateGenerationLimit();
+}
+
+absl::Nullable<GenerationProfile*> GeneratorManager::GetGenerationProfile() {
+  return managed_generator_.GetGenerationProfile();
+}
+
+absl::Nullable<GenerationBudget*> GeneratorManager::GetGenerationBudget() {
+  return managed_generator_.GetGenerationBudget();
+}
+
 }  // namespace moriarty_internal
 
 }  // namespace moriarty
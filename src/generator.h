@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <concepts>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
@@ -36,16 +37,21 @@
 #include "src/errors.h"
 #include "src/internal/analysis_bootstrap.h"
 #include "src/internal/generation_config.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
 #include "src/internal/random_config.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
+#include "src/lazy_permutation.h"
 #include "src/librarian/mvariable.h"
 #include "src/property.h"
 #include "src/scenario.h"
 #include "src/test_case.h"
+#include "src/test_case_mutation.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
@@ -61,8 +67,14 @@ class GeneratorManager;  // Forward declaring the internal API
 // or several times. Then add the Generator to Moriarty via `AddGenerator()`.
 class Generator {
  public:
+  Generator() = default;
   virtual ~Generator() = default;
 
+  // A copy has its own copy of each test case added so far.
+  Generator(const Generator& other);
+  Generator& operator=(const Generator& other);
+  Generator(Generator&& other) = default;
+
   // AddTestCase()
   //
   // Creates an empty case (no variables set) and returns a reference to that
@@ -99,6 +111,35 @@ class Generator {
   // version.
   absl::StatusOr<absl::Nonnull<TestCase*>> TryAddOptionalTestCase();
 
+  // AddDerivedTestCase()
+  //
+  // Adds a test case whose values are a copy of the values of `base` (a test
+  // case previously returned by `AddTestCase()` or `AddDerivedTestCase()`),
+  // changed by `mutation`. Use this to build many similar large test cases
+  // from one generated test case instead of generating each of them from
+  // scratch. The changed values are not checked against the constraints.
+  //
+  // Example:
+  //   TestCase& base = AddTestCase().ConstrainVariable("A", ...);
+  //   for (int k : {1, 10, 100}) {
+  //     AddDerivedTestCase(base, TestCaseMutation().ChangeElements<
+  //                                  MArray<MInteger>>("A", k, MInteger()));
+  //   }
+  //
+  // Crashes on failure. See `TryAddDerivedTestCase()` for a non-crashing
+  // version.
+  void AddDerivedTestCase(const TestCase& base, TestCaseMutation mutation);
+
+  // TryAddDerivedTestCase()
+  //
+  // Adds a test case whose values are a copy of the values of `base`, changed
+  // by `mutation`. See `AddDerivedTestCase()`.
+  //
+  // Returns status on failure. See `AddDerivedTestCase()` for simpler API
+  // version.
+  absl::Status TryAddDerivedTestCase(const TestCase& base,
+                                     TestCaseMutation mutation);
+
   // WithScenario()
   //
   // All future calls to `AddTestCase()` will have this scenario added into it.
@@ -233,6 +274,56 @@ class Generator {
   absl::StatusOr<std::vector<T>> TryRandomElementsWithReplacement(
       const std::vector<T>& container, int k);
 
+  // RandomWeightedElement()
+  //
+  // Returns a random element of `container`, where `container[i]` is picked
+  // with probability weights[i] / (sum of weights). E.g.,
+  // RandomWeightedElement({"rock", "paper"}, {3, 1}) returns "rock" 75% of the
+  // time.
+  //
+  // Crashes on failure. See `TryRandomWeightedElement()` for a non-crashing
+  // version.
+  template <typename T>
+  [[nodiscard]] T RandomWeightedElement(const std::vector<T>& container,
+                                        absl::Span<const int64_t> weights);
+
+  // TryRandomWeightedElement()
+  //
+  // Returns a random element of `container`, where `container[i]` is picked
+  // with probability weights[i] / (sum of weights).
+  //
+  // Returns status on failure. See `RandomWeightedElement()` for simpler API
+  // version.
+  template <typename T>
+  absl::StatusOr<T> TryRandomWeightedElement(
+      const std::vector<T>& container, absl::Span<const int64_t> weights);
+
+  // RandomWeightedElements()
+  //
+  // Returns k (randomly ordered) elements of `container`, possibly with
+  // duplicates, each picked as in `RandomWeightedElement()`. Prefer this over
+  // calling `RandomWeightedElement()` k times: the weights are only processed
+  // once.
+  //
+  // Crashes on failure. See `TryRandomWeightedElements()` for a non-crashing
+  // version.
+  template <typename T>
+  [[nodiscard]] std::vector<T> RandomWeightedElements(
+      const std::vector<T>& container, absl::Span<const int64_t> weights,
+      int k);
+
+  // TryRandomWeightedElements()
+  //
+  // Returns k (randomly ordered) elements of `container`, possibly with
+  // duplicates, each picked as in `RandomWeightedElement()`.
+  //
+  // Returns status on failure. See `RandomWeightedElements()` for simpler API
+  // version.
+  template <typename T>
+  absl::StatusOr<std::vector<T>> TryRandomWeightedElements(
+      const std::vector<T>& container, absl::Span<const int64_t> weights,
+      int k);
+
   // RandomElementsWithoutReplacement()
   //
   // Returns k (randomly ordered) elements of `container`, without duplicates.
@@ -264,6 +355,30 @@ class Generator {
   absl::StatusOr<std::vector<T>> TryRandomElementsWithoutReplacement(
       const std::vector<T>& container, int k);
 
+  // ReservoirSample()
+  //
+  // Returns k (randomly ordered) elements of the range [first, last), without
+  // duplicates. The range is only read once and at most k elements are held
+  // in memory, so this works on ranges too large to store, e.g.,
+  // `std::istream_iterator`s over a huge file.
+  //
+  // Crashes on failure. See `TryReservoirSample()` for a non-crashing version.
+  template <typename InputIt>
+  [[nodiscard]] std::vector<std::iter_value_t<InputIt>> ReservoirSample(
+      InputIt first, InputIt last, int k);
+
+  // TryReservoirSample()
+  //
+  // Returns k (randomly ordered) elements of the range [first, last), without
+  // duplicates. The range is only read once and at most k elements are held
+  // in memory.
+  //
+  // Returns status on failure. See `ReservoirSample()` for simpler API
+  // version.
+  template <typename InputIt>
+  absl::StatusOr<std::vector<std::iter_value_t<InputIt>>> TryReservoirSample(
+      InputIt first, InputIt last, int k);
+
   // RandomPermutation()
   //
   // Returns a random permutation of {0, 1, ... , n-1}.
@@ -304,6 +419,137 @@ class Generator {
     requires std::integral<T>
   absl::StatusOr<std::vector<T>> TryRandomPermutation(int n, T min);
 
+  // RandomLazyPermutation()
+  //
+  // Returns a random permutation of {0, 1, ... , n-1} whose values are
+  // computed when they are asked for, in O(1) memory (e.g., to relabel 10^9
+  // vertices). See `LazyPermutation` for details.
+  //
+  // Crashes on failure. See `TryRandomLazyPermutation()` for a non-crashing
+  // version.
+  [[nodiscard]] LazyPermutation RandomLazyPermutation(int64_t n);
+
+  // TryRandomLazyPermutation()
+  //
+  // Returns a random permutation of {0, 1, ... , n-1} whose values are
+  // computed when they are asked for, in O(1) memory (e.g., to relabel 10^9
+  // vertices). See `LazyPermutation` for details.
+  //
+  // Returns status on failure. See `RandomLazyPermutation()` for simpler API
+  // version.
+  absl::StatusOr<LazyPermutation> TryRandomLazyPermutation(int64_t n);
+
+  // RandomCyclicPermutation()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} that is
+  // a single cycle (following x -> p[x - min] visits every value). Each such
+  // permutation is equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Crashes on failure. See `TryRandomCyclicPermutation()` for a non-crashing
+  // version.
+  template <typename T = int>
+    requires std::integral<T>
+  [[nodiscard]] std::vector<T> RandomCyclicPermutation(int n, T min = 0);
+
+  // TryRandomCyclicPermutation()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} that is
+  // a single cycle (following x -> p[x - min] visits every value). Each such
+  // permutation is equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Returns status on failure. See `RandomCyclicPermutation()` for simpler API
+  // version.
+  template <typename T = int>
+    requires std::integral<T>
+  absl::StatusOr<std::vector<T>> TryRandomCyclicPermutation(int n, T min = 0);
+
+  // RandomDerangement()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} with no
+  // fixed points (p[i] != min + i). Each such permutation is equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Crashes on failure. See `TryRandomDerangement()` for a non-crashing
+  // version.
+  template <typename T = int>
+    requires std::integral<T>
+  [[nodiscard]] std::vector<T> RandomDerangement(int n, T min = 0);
+
+  // TryRandomDerangement()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} with no
+  // fixed points (p[i] != min + i). Each such permutation is equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Returns status on failure. See `RandomDerangement()` for simpler API
+  // version.
+  template <typename T = int>
+    requires std::integral<T>
+  absl::StatusOr<std::vector<T>> TryRandomDerangement(int n, T min = 0);
+
+  // RandomPermutationWithCycles()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} with
+  // exactly k cycles (following x -> p[x - min]). Every such permutation is
+  // possible, but they are not all equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Crashes on failure. See `TryRandomPermutationWithCycles()` for a
+  // non-crashing version.
+  template <typename T = int>
+    requires std::integral<T>
+  [[nodiscard]] std::vector<T> RandomPermutationWithCycles(int n, int k,
+                                                           T min = 0);
+
+  // TryRandomPermutationWithCycles()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} with
+  // exactly k cycles (following x -> p[x - min]). Every such permutation is
+  // possible, but they are not all equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Returns status on failure. See `RandomPermutationWithCycles()` for
+  // simpler API version.
+  template <typename T = int>
+    requires std::integral<T>
+  absl::StatusOr<std::vector<T>> TryRandomPermutationWithCycles(int n, int k,
+                                                                T min = 0);
+
+  // RandomInvolution()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} that is
+  // its own inverse (p[p[i] - min] == min + i). Each such permutation is
+  // equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Crashes on failure. See `TryRandomInvolution()` for a non-crashing version.
+  template <typename T = int>
+    requires std::integral<T>
+  [[nodiscard]] std::vector<T> RandomInvolution(int n, T min = 0);
+
+  // TryRandomInvolution()
+  //
+  // Returns a random permutation p of {min, min + 1, ... , min + (n-1)} that is
+  // its own inverse (p[p[i] - min] == min + i). Each such permutation is
+  // equally likely.
+  //
+  // Requires min + (n-1) to not overflow T.
+  //
+  // Returns status on failure. See `RandomInvolution()` for simpler API
+  // version.
+  template <typename T = int>
+    requires std::integral<T>
+  absl::StatusOr<std::vector<T>> TryRandomInvolution(int n, T min = 0);
+
   // DistinctIntegers()
   //
   // Returns k (randomly ordered) distinct integers from
@@ -388,6 +634,35 @@ class Generator {
                                librarian::MVariable<T, typename T::value_type>>
   absl::StatusOr<T> TryGetVariable(absl::string_view variable_name) const;
 
+  // GetVariableView()
+  //
+  // Returns a reference to the variable `variable_name` from global context.
+  // Unlike `GetVariable()`, the variable is not copied, so this is cheap to
+  // call repeatedly (e.g., in a loop). The global context does not change
+  // while generating, so the reference stays valid until
+  // `GenerateTestCases()` returns.
+  //
+  // Crashes on failure. See `TryGetVariableView()` for a non-crashing version.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  [[nodiscard]] const T& GetVariableView(absl::string_view variable_name) const;
+
+  // TryGetVariableView()
+  //
+  // Returns a pointer to the variable `variable_name` from global context.
+  // Unlike `TryGetVariable()`, the variable is not copied, so this is cheap to
+  // call repeatedly (e.g., in a loop). The global context does not change
+  // while generating, so the pointer stays valid until `GenerateTestCases()`
+  // returns.
+  //
+  // Returns status on failure. See `GetVariableView()` for simpler API version.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<absl::Nonnull<const T*>> TryGetVariableView(
+      absl::string_view variable_name) const;
+
   // SizedValue()
   //
   // Returns a value generated by `variable_name` of size `size`.
@@ -399,6 +674,17 @@ class Generator {
   absl::StatusOr<typename T::value_type> SizedValue(
       absl::string_view variable_name, absl::string_view size);
 
+  // SizedValues()
+  //
+  // Returns `count` values generated by `variable_name` of size `size`. This is
+  // faster than calling `SizedValue()` `count` times. All `count` values share
+  // the same values for any variables that `variable_name` depends on.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<std::vector<typename T::value_type>> SizedValues(
+      absl::string_view variable_name, absl::string_view size, int count);
+
   // MinValue()
   // TinyValue()
   // SmallValue()
@@ -506,21 +792,43 @@ class Generator {
   absl::Status SatisfiesConstraints(T constraints,
                                     const T::value_type& value) const;
 
+  // AllSatisfyConstraints()
+  //
+  // Checks if every value in `values` satisfies the constraints in
+  // `constraints`. Returns a non-ok status with the reason (and the index of
+  // the value) for the first one that does not. This is faster than calling
+  // `SatisfiesConstraints()` once per value. Example:
+  //
+  //   absl::Status s = AllSatisfyConstraints(MInteger().Between(1, "N"), A);
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::Status AllSatisfyConstraints(
+      T constraints, absl::Span<const typename T::value_type> values) const;
+
  private:
   // Pointers are to maintain reference-stability with AddCase()
-  // TODO(darcybest): This should be unique_ptr, but having it as shared_ptr so
-  // we can copy freely for now.
-  std::vector<std::shared_ptr<TestCase>> test_cases_;
+  std::vector<std::unique_ptr<TestCase>> test_cases_;
 
   // List of optional test cases.
-  std::vector<std::shared_ptr<TestCase>> optional_test_cases_;
+  std::vector<std::unique_ptr<TestCase>> optional_test_cases_;
 
   // `rng_` is not initialized until InternalSetSeed is called.
   std::optional<moriarty_internal::RandomEngine> rng_;
 
+  // The seed passed to `SetSeed()`. With the counter-based engine, each test
+  // case is assigned with its own RandomEngine derived from this seed and the
+  // test case's index (see `AssignValuesInAllTestCases()`).
+  std::vector<int64_t> seed_;
+
   // `general_constraints_` are the constraints of all variables declared in the
-  // Moriarty class.
-  std::optional<const moriarty_internal::VariableSet> general_constraints_;
+  // Moriarty class. They are shared by all test cases, which only store the
+  // variables they change.
+  std::shared_ptr<const moriarty_internal::VariableSet> general_constraints_;
+
+  // The values of the suite-level variables declared in the Moriarty class.
+  // They are generated once and shared (not copied) by all test cases.
+  std::shared_ptr<const moriarty_internal::ValueSet> shared_values_;
 
   // `scenarios_` are passed to all future calls to `AddTestCase()`.
   std::vector<Scenario> scenarios_;
@@ -529,6 +837,26 @@ class Generator {
   // Approximately how many tokens to generate.
   std::optional<int64_t> approximate_generation_limit_;
 
+  // Runs the parallel work of a single variable's generation. Not owned.
+  moriarty_internal::Scheduler* scheduler_ = nullptr;
+
+  // Where to record how long each variable took to generate. Not owned.
+  moriarty_internal::GenerationProfile* profile_ = nullptr;
+
+  // Limits on the work done while assigning values. Not owned.
+  moriarty_internal::GenerationBudget* budget_ = nullptr;
+
+  // The number of test cases and optional test cases removed by
+  // `ReleaseTestCases()` since the last `ClearCases()`.
+  int num_released_test_cases_ = 0;
+  int num_released_optional_test_cases_ = 0;
+
+  // Adds an empty test case (with the general constraints and scenarios) to
+  // `test_cases` and returns a pointer to it.
+  absl::StatusOr<absl::Nonnull<TestCase*>> TryAddTestCaseTo(
+      std::vector<std::unique_ptr<TestCase>>& test_cases,
+      absl::string_view function_name);
+
   // ---------------------------------------------------------------------------
   //    Start of Internal Extended API
   //
@@ -536,11 +864,17 @@ class Generator {
   // Users and Librarians should not need to access these functions. See
   // `ImporterManager` for more details.
   friend class moriarty_internal::GeneratorManager;
+  friend class StreamingGenerator;
 
   // SetSeed()
   //
   // Sets the seed for the random engine used inside the generator.
-  void SetSeed(absl::Span<const int64_t> seed);
+  // `random_engine_version` selects the engine (see `RandomEngine`). With
+  // "v0.1", the test cases share this engine, so a seed gives the same test
+  // cases as before per-test-case engines were added.
+  void SetSeed(absl::Span<const int64_t> seed,
+               absl::string_view random_engine_version =
+                   moriarty_internal::kMersenneTwisterVersion);
 
   // SetGeneralConstraints()
   //
@@ -550,6 +884,13 @@ class Generator {
   void SetGeneralConstraints(
       moriarty_internal::VariableSet general_constraints);
 
+  // SetSharedValues()
+  //
+  // Sets the values of the suite-level variables. Every TestCase added by the
+  // generator (and every value from `Random()`) may depend on them.
+  void SetSharedValues(
+      std::shared_ptr<const moriarty_internal::ValueSet> shared_values);
+
   // SetApproximateGenerationLimit()
   //
   // Sets a threshold for approximately how much data to generate. If set,
@@ -563,10 +904,32 @@ class Generator {
   // stop generation at any point.
   void SetApproximateGenerationLimit(int64_t limit);
 
+  // SetScheduler()
+  //
+  // Sets the scheduler that a single variable may use to generate its value
+  // on several threads (e.g., the elements of a large array). The generated
+  // values do not depend on the scheduler. `scheduler` must outlive this
+  // generator (or the next call to `SetScheduler()`).
+  void SetScheduler(moriarty_internal::Scheduler* scheduler);
+
+  // SetGenerationProfile()
+  //
+  // Records how long each variable takes to generate in `profile` (if not
+  // `nullptr`) when assigning values. `profile` must outlive this generator
+  // (or the next call to `SetGenerationProfile()`).
+  void SetGenerationProfile(moriarty_internal::GenerationProfile* profile);
+
+  // SetGenerationBudget()
+  //
+  // Stops assigning values once `budget` (if not `nullptr`) is exceeded.
+  // `budget` must outlive this generator (or the next call to
+  // `SetGenerationBudget()`).
+  void SetGenerationBudget(moriarty_internal::GenerationBudget* budget);
+
   // GetTestCases()
   //
   // Returns the internal list of test cases.
-  const std::vector<std::shared_ptr<TestCase>>& GetTestCases();
+  const std::vector<std::unique_ptr<TestCase>>& GetTestCases();
 
   // GetGeneralConstraints()
   //
@@ -576,11 +939,19 @@ class Generator {
   // GetOptionalTestCases()
   //
   // Returns the internal list of test cases.
-  const std::vector<std::shared_ptr<TestCase>>& GetOptionalTestCases();
+  const std::vector<std::unique_ptr<TestCase>>& GetOptionalTestCases();
 
   // AssignValuesInAllTestCases()
   //
-  // Assigns all of the variables in all of the test cases.
+  // Assigns all of the variables in all of the test cases. With the
+  // counter-based engine, each test case uses its own RandomEngine, which only
+  // depends on the seed and the index of the test case (among the test cases
+  // or among the optional test cases). So the values of one test case do not
+  // depend on the other test cases, and they may be assigned in parallel.
+  //
+  // With "v0.1", the test cases share the generator's engine and are assigned
+  // in order (all test cases, then all optional test cases), ignoring the
+  // scheduler.
   absl::StatusOr<std::vector<moriarty_internal::ValueSet>>
   AssignValuesInAllTestCases();
 
@@ -595,10 +966,91 @@ class Generator {
   // unavailable.
   absl::Nullable<moriarty_internal::RandomEngine*> GetRandomEngine();
 
+  // GetScheduler()
+  //
+  // Returns the scheduler set by `SetScheduler()`, or nullptr if there is
+  // none.
+  absl::Nullable<moriarty_internal::Scheduler*> GetScheduler();
+
+  // GetApproximateGenerationLimit()
+  //
+  // Returns the limit set by `SetApproximateGenerationLimit()`, if any.
+  std::optional<int64_t> GetApproximateGenerationLimit() const;
+
+  // GetGenerationProfile()
+  //
+  // Returns the profile set by `SetGenerationProfile()`, or nullptr if there is
+  // none.
+  absl::Nullable<moriarty_internal::GenerationProfile*> GetGenerationProfile();
+
+  // GetGenerationBudget()
+  //
+  // Returns the budget set by `SetGenerationBudget()`, or nullptr if there is
+  // none.
+  absl::Nullable<moriarty_internal::GenerationBudget*> GetGenerationBudget();
+
+  // ReleaseTestCases()
+  //
+  // Removes all cases that have been generated, but keeps counting from them:
+  // test cases added afterwards get the indices (and, with the counter-based
+  // engine, the values) they would have had if nothing was removed.
+  void ReleaseTestCases();
+
   //    End of Internal Extended API
   // ---------------------------------------------------------------------------
 };
 
+// StreamingGenerator
+//
+// A Generator that adds its test cases one at a time. You must override
+// `GenerateNextTestCase()` instead of `GenerateTestCases()`. When test cases
+// are generated serially, each test case is assigned (and, with
+// `Moriarty::GenerateAndExportTestCases()`, exported) before the next one is
+// added, so only a few `TestCase`s are held in memory at once.
+//
+// With the counter-based engine, the values are the same as if all of the test
+// cases were added at once (with "v0.1", the test cases share one engine, so
+// they depend on when the optional test cases are assigned). However, since
+// the number of test cases is not known in advance, a planned generation limit
+// (see `Moriarty::EnableGenerationLimitPlanning()`) is not split between them,
+// and the generation limits stop generation after the test case that reaches
+// them instead of after the whole call.
+//
+// Example:
+//   class ManySmallCases : public StreamingGenerator {
+//    public:
+//     bool GenerateNextTestCase() override {
+//       if (NumTestCasesAdded() == 100'000) return false;
+//       AddTestCase().ConstrainVariable("N", MInteger().Between(1, 10));
+//       return true;
+//     }
+//   };
+class StreamingGenerator : public Generator {
+ public:
+  // GenerateNextTestCase() [virtual]
+  //
+  // You must override this function in your derived StreamingGenerator. It
+  // should add the next test case (via `AddTestCase()`) and return true, or
+  // return false once there are no test cases left. It may also add optional
+  // test cases, or several test cases at once. A test case passed to
+  // `AddDerivedTestCase()` must have been added by the same call.
+  virtual bool GenerateNextTestCase() = 0;
+
+  // GenerateTestCases()
+  //
+  // Adds all of the test cases, by calling `GenerateNextTestCase()` until it
+  // returns false.
+  void GenerateTestCases() final;
+
+ protected:
+  // NumTestCasesAdded()
+  //
+  // Returns the number of test cases (not including optional test cases)
+  // added so far in this call of the generator, including the ones that were
+  // already assigned and released.
+  int NumTestCasesAdded() const;
+};
+
 namespace moriarty_internal {
 
 // GeneratorManager [Internal Extended API]
@@ -626,15 +1078,37 @@ class GeneratorManager {
   // This class does not take ownership of `generator_to_manage`
   explicit GeneratorManager(moriarty::Generator* generator_to_manage);
 
-  void SetSeed(absl::Span<const int64_t> seed);
+  void SetSeed(
+      absl::Span<const int64_t> seed,
+      absl::string_view random_engine_version = kMersenneTwisterVersion);
   void SetGeneralConstraints(VariableSet general_constraints);
+  void SetSharedValues(std::shared_ptr<const ValueSet> shared_values);
   void SetApproximateGenerationLimit(int64_t limit);
-  const std::vector<std::shared_ptr<TestCase>>& GetTestCases();
+  void SetScheduler(Scheduler* scheduler);
+  void SetGenerationProfile(GenerationProfile* profile);
+  void SetGenerationBudget(GenerationBudget* budget);
+  const std::vector<std::unique_ptr<TestCase>>& GetTestCases();
   std::optional<const moriarty_internal::VariableSet> GetGeneralConstraints();
-  const std::vector<std::shared_ptr<TestCase>>& GetOptionalTestCases();
+  const std::vector<std::unique_ptr<TestCase>>& GetOptionalTestCases();
   absl::StatusOr<std::vector<ValueSet>> AssignValuesInAllTestCases();
   void ClearCases();
+  void ReleaseTestCases();
+
+  // IsStreaming()
+  //
+  // Returns true if the managed generator is a `StreamingGenerator`.
+  bool IsStreaming();
+
+  // GenerateNextTestCase()
+  //
+  // Calls `GenerateNextTestCase()` of the managed `StreamingGenerator`.
+  // Returns false if it is not a `StreamingGenerator`.
+  bool GenerateNextTestCase();
   absl::Nullable<moriarty_internal::RandomEngine*> GetRandomEngine();
+  absl::Nullable<Scheduler*> GetScheduler();
+  std::optional<int64_t> GetApproximateGenerationLimit();
+  absl::Nullable<GenerationProfile*> GetGenerationProfile();
+  absl::Nullable<GenerationBudget*> GetGenerationBudget();
 
  private:
   Generator& managed_generator_;  // Not owned by this class
@@ -663,8 +1137,10 @@ absl::StatusOr<typename T::value_type> Generator::TryRandom(T m) {
   // We make a copy of the variables so that they may be generated if needed by
   // the user without affecting the global scope.
   moriarty_internal::VariableSet variables =
-      general_constraints_.value_or(moriarty_internal::VariableSet());
+      general_constraints_ ? *general_constraints_
+                           : moriarty_internal::VariableSet();
   moriarty_internal::ValueSet values;
+  values.SetSharedValues(shared_values_);
   moriarty_internal::GenerationConfig generation_config;
 
   moriarty_internal::Universe universe =
@@ -713,6 +1189,30 @@ absl::StatusOr<std::vector<T>> Generator::TryRandomElementsWithReplacement(
   return moriarty_internal::RandomElementsWithReplacement(*rng_, container, k);
 }
 
+template <typename T>
+absl::StatusOr<T> Generator::TryRandomWeightedElement(
+    const std::vector<T>& container, absl::Span<const int64_t> weights) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomWeightedElement",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomWeightedElement(*rng_, container, weights);
+}
+
+template <typename T>
+absl::StatusOr<std::vector<T>> Generator::TryRandomWeightedElements(
+    const std::vector<T>& container, absl::Span<const int64_t> weights,
+    int k) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomWeightedElements",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomWeightedElements(*rng_, container, weights,
+                                                   k);
+}
+
 template <typename T>
 absl::StatusOr<std::vector<T>> Generator::TryRandomElementsWithoutReplacement(
     const std::vector<T>& container, int k) {
@@ -725,6 +1225,17 @@ absl::StatusOr<std::vector<T>> Generator::TryRandomElementsWithoutReplacement(
                                                              k);
 }
 
+template <typename InputIt>
+absl::StatusOr<std::vector<std::iter_value_t<InputIt>>>
+Generator::TryReservoirSample(InputIt first, InputIt last, int k) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "ReservoirSample",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::ReservoirSample(*rng_, first, last, k);
+}
+
 template <typename T>
   requires std::integral<T>
 absl::StatusOr<std::vector<T>> Generator::TryRandomPermutation(int n, T min) {
@@ -736,6 +1247,52 @@ absl::StatusOr<std::vector<T>> Generator::TryRandomPermutation(int n, T min) {
   return moriarty_internal::RandomPermutation(*rng_, n, min);
 }
 
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> Generator::TryRandomCyclicPermutation(int n,
+                                                                     T min) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomCyclicPermutation",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomCyclicPermutation(*rng_, n, min);
+}
+
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> Generator::TryRandomDerangement(int n, T min) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomDerangement",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomDerangement(*rng_, n, min);
+}
+
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> Generator::TryRandomPermutationWithCycles(
+    int n, int k, T min) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomPermutationWithCycles",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomPermutationWithCycles(*rng_, n, k, min);
+}
+
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> Generator::TryRandomInvolution(int n, T min) {
+  if (!rng_) {
+    return MisconfiguredError("Generator", "RandomInvolution",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  return moriarty_internal::RandomInvolution(*rng_, n, min);
+}
+
 template <typename T>
   requires std::integral<T>
 absl::StatusOr<std::vector<T>> Generator::TryDistinctIntegers(T n, int k,
@@ -780,6 +1337,23 @@ std::vector<T> Generator::RandomElementsWithReplacement(
       "RandomElementWithReplacement");
 }
 
+template <typename T>
+T Generator::RandomWeightedElement(const std::vector<T>& container,
+                                   absl::Span<const int64_t> weights) {
+  return moriarty_internal::TryFunctionOrCrash<T>(
+      [&]() { return this->TryRandomWeightedElement(container, weights); },
+      "RandomWeightedElement");
+}
+
+template <typename T>
+std::vector<T> Generator::RandomWeightedElements(
+    const std::vector<T>& container, absl::Span<const int64_t> weights,
+    int k) {
+  return moriarty_internal::TryFunctionOrCrash<std::vector<T>>(
+      [&]() { return this->TryRandomWeightedElements(container, weights, k); },
+      "RandomWeightedElements");
+}
+
 template <typename T>
 std::vector<T> Generator::RandomElementsWithoutReplacement(
     const std::vector<T>& container, int k) {
@@ -788,6 +1362,15 @@ std::vector<T> Generator::RandomElementsWithoutReplacement(
       "RandomElementWithoutReplacement");
 }
 
+template <typename InputIt>
+std::vector<std::iter_value_t<InputIt>> Generator::ReservoirSample(
+    InputIt first, InputIt last, int k) {
+  return moriarty_internal::TryFunctionOrCrash<
+      std::vector<std::iter_value_t<InputIt>>>(
+      [&]() { return this->TryReservoirSample(first, last, k); },
+      "ReservoirSample");
+}
+
 template <typename T>
   requires std::integral<T>
 std::vector<T> Generator::RandomPermutation(int n, T min) {
@@ -796,6 +1379,38 @@ std::vector<T> Generator::RandomPermutation(int n, T min) {
       "RandomPermutation");
 }
 
+template <typename T>
+  requires std::integral<T>
+std::vector<T> Generator::RandomCyclicPermutation(int n, T min) {
+  return moriarty_internal::TryFunctionOrCrash<std::vector<T>>(
+      [&]() { return this->TryRandomCyclicPermutation(n, min); },
+      "RandomCyclicPermutation");
+}
+
+template <typename T>
+  requires std::integral<T>
+std::vector<T> Generator::RandomDerangement(int n, T min) {
+  return moriarty_internal::TryFunctionOrCrash<std::vector<T>>(
+      [&]() { return this->TryRandomDerangement(n, min); },
+      "RandomDerangement");
+}
+
+template <typename T>
+  requires std::integral<T>
+std::vector<T> Generator::RandomPermutationWithCycles(int n, int k, T min) {
+  return moriarty_internal::TryFunctionOrCrash<std::vector<T>>(
+      [&]() { return this->TryRandomPermutationWithCycles(n, k, min); },
+      "RandomPermutationWithCycles");
+}
+
+template <typename T>
+  requires std::integral<T>
+std::vector<T> Generator::RandomInvolution(int n, T min) {
+  return moriarty_internal::TryFunctionOrCrash<std::vector<T>>(
+      [&]() { return this->TryRandomInvolution(n, min); },
+      "RandomInvolution");
+}
+
 template <typename T>
   requires std::integral<T>
 std::vector<T> Generator::DistinctIntegers(T n, int k, T min) {
@@ -829,19 +1444,93 @@ absl::StatusOr<T> Generator::TryGetVariable(
                               InternalConfigurationType::kVariableSet);
   }
 
-  return general_constraints_->GetVariable<T>(variable_name);
+  MORIARTY_ASSIGN_OR_RETURN(const T* variable,
+                            TryGetVariableView<T>(variable_name));
+  return *variable;
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+const T& Generator::GetVariableView(absl::string_view variable_name) const {
+  return moriarty_internal::TryFunctionOrCrash<const T>(
+      [&, this]() { return this->TryGetVariableView<T>(variable_name); },
+      "GetVariableView");
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<absl::Nonnull<const T*>> Generator::TryGetVariableView(
+    absl::string_view variable_name) const {
+  if (!general_constraints_) {
+    return MisconfiguredError("Generator", "TryGetVariableView",
+                              InternalConfigurationType::kVariableSet);
+  }
+
+  return general_constraints_->GetVariableView<T>(variable_name);
 }
 
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 absl::StatusOr<typename T::value_type> Generator::SizedValue(
     absl::string_view variable_name, absl::string_view size) {
-  MORIARTY_ASSIGN_OR_RETURN(auto variable, TryGetVariable<T>(variable_name));
+  // Copy the variable once, since the size is added to it.
+  MORIARTY_ASSIGN_OR_RETURN(const T* view, TryGetVariableView<T>(variable_name));
+  T variable = *view;
   MORIARTY_RETURN_IF_ERROR(variable.TryWithKnownProperty(
       Property({.category = "size", .descriptor = std::string(size)})));
   return TryRandom(variable);
 }
 
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::vector<typename T::value_type>> Generator::SizedValues(
+    absl::string_view variable_name, absl::string_view size, int count) {
+  if (rng_ == std::nullopt) {
+    return MisconfiguredError("Generator", "SizedValues",
+                              InternalConfigurationType::kRandomEngine);
+  }
+  if (count < 0) {
+    return absl::InvalidArgumentError("SizedValues() count must be >= 0");
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(T variable, TryGetVariable<T>(variable_name));
+  MORIARTY_RETURN_IF_ERROR(variable.TryWithKnownProperty(
+      Property({.category = "size", .descriptor = std::string(size)})));
+
+  // As in `TryRandom()`, copy the variables so that they may be generated
+  // without affecting the global scope.
+  moriarty_internal::VariableSet variables = *general_constraints_;
+  moriarty_internal::ValueSet values;
+  values.SetSharedValues(shared_values_);
+  moriarty_internal::GenerationConfig generation_config;
+
+  moriarty_internal::Universe universe =
+      moriarty_internal::Universe()
+          .SetRandomEngine(&(*rng_))
+          .SetMutableVariableSet(&variables)
+          .SetMutableValueSet(&values)
+          .SetGenerationConfig(&generation_config);
+
+  moriarty_internal::MVariableManager manager(&variable);
+  manager.SetUniverse(
+      &universe,
+      /* my_name_in_universe = */ absl::Substitute("SizedValues($0)",
+                                                   variable_name));
+
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::optional<std::vector<typename T::value_type>> bulk,
+      manager.GenerateInBulk(count));
+  if (bulk) return *std::move(bulk);
+
+  std::vector<typename T::value_type> result;
+  result.reserve(count);
+  for (int i = 0; i < count; i++) {
+    MORIARTY_ASSIGN_OR_RETURN(typename T::value_type value, manager.Generate());
+    result.push_back(std::move(value));
+  }
+  return result;
+}
+
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 typename T::value_type Generator::MinValue(absl::string_view variable_name) {
@@ -960,6 +1649,22 @@ absl::Status Generator::SatisfiesConstraints(T constraints,
       "Generator::SatisfiesConstraints");
 }
 
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::Status Generator::AllSatisfyConstraints(
+    T constraints, absl::Span<const typename T::value_type> values) const {
+  if (!general_constraints_) {
+    return MisconfiguredError("Generator", "AllSatisfyConstraints",
+                              InternalConfigurationType::kVariableSet);
+  }
+
+  moriarty_internal::ValueSet known_values;
+  return moriarty_internal::ConstraintChecker<T>(
+             std::move(constraints), known_values, *general_constraints_,
+             "Generator::AllSatisfyConstraints")
+      .CheckAll(values);
+}
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_GENERATOR_H_
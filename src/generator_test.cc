@@ -16,6 +16,8 @@
 
 #include <concepts>
 #include <cstdint>
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -24,19 +26,26 @@
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "src/errors.h"
+#include "src/internal/permutations.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
+#include "src/lazy_permutation.h"
 #include "src/librarian/size_property.h"
 #include "src/librarian/test_utils.h"
 #include "src/scenario.h"
 #include "src/test_case.h"
+#include "src/test_case_mutation.h"
 #include "src/testing/generator_test_util.h"
 #include "src/testing/mtest_type.h"
 #include "src/testing/random_test_util.h"
 #include "src/testing/status_test_util.h"
 #include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
 #include "src/variables/minteger.h"
 
 namespace moriarty {
@@ -54,6 +63,7 @@ using ::moriarty_testing::SingleIntegerGenerator;
 using ::moriarty_testing::TwoIntegerGeneratorWithRandomness;
 using ::moriarty_testing::TwoTestTypeGenerator;
 using ::testing::AllOf;
+using ::testing::Each;
 using ::testing::Ge;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
@@ -118,6 +128,27 @@ TEST(GeneratorManagerTest, ClearCasesDeletesAllTestCases) {
   EXPECT_THAT(generator_manager.GetTestCases(), IsEmpty());
 }
 
+TEST(GeneratorManagerTest, TestCasesShareTheGeneralConstraints) {
+  EmptyGenerator gen;
+  moriarty_internal::GeneratorManager generator_manager(&gen);
+  gen.AddTestCase().ConstrainVariable("R", MInteger().Between(1, 5));
+  gen.AddTestCase();
+  gen.AddOptionalTestCase();
+
+  const moriarty_internal::VariableSet* general =
+      &moriarty_internal::TestCaseManager(
+           generator_manager.GetTestCases()[0].get())
+           .GetGeneralVariables();
+  EXPECT_EQ(&moriarty_internal::TestCaseManager(
+                 generator_manager.GetTestCases()[1].get())
+                 .GetGeneralVariables(),
+            general);
+  EXPECT_EQ(&moriarty_internal::TestCaseManager(
+                 generator_manager.GetOptionalTestCases()[0].get())
+                 .GetGeneralVariables(),
+            general);
+}
+
 TEST(GeneratorManagerTest, ClearCasesDeletesAllOptionalTestCases) {
   EmptyGenerator gen;
   moriarty_internal::GeneratorManager generator_manager(&gen);
@@ -195,6 +226,261 @@ TEST(GeneratorManagerTest, AssignValuesInAllTestCasesAllowsRandomness) {
               IsOkAndHolds(AllOf(Ge(50), Le(100))));
 }
 
+TEST(GeneratorManagerTest,
+     AssignValuesInAllTestCasesShouldNotDependOnOtherTestCases) {
+  EmptyGenerator gen1;
+  GeneratorManager(&gen1).SetSeed({1, 2, 3},
+                                  moriarty_internal::kCounterBasedVersion);
+  gen1.AddTestCase().ConstrainVariable("X", MInteger().Between(1, 1000000000));
+  gen1.AddTestCase().ConstrainVariable("Y", MInteger().Between(1, 1000000000));
+
+  // The first test case uses a different amount of randomness.
+  EmptyGenerator gen2;
+  GeneratorManager(&gen2).SetSeed({1, 2, 3},
+                                  moriarty_internal::kCounterBasedVersion);
+  gen2.AddTestCase()
+      .ConstrainVariable("A", MInteger().Between(1, 1000000000))
+      .ConstrainVariable("B", MInteger().Between(1, 1000000000));
+  gen2.AddTestCase().ConstrainVariable("Y", MInteger().Between(1, 1000000000));
+  gen2.AddOptionalTestCase().ConstrainVariable("Z", MInteger().Is(5));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> values1,
+      GeneratorManager(&gen1).AssignValuesInAllTestCases());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> values2,
+      GeneratorManager(&gen2).AssignValuesInAllTestCases());
+
+  ASSERT_THAT(values1, SizeIs(2));
+  ASSERT_THAT(values2, SizeIs(3));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t y, values1[1].Get<MInteger>("Y"));
+  EXPECT_THAT(values2[1].Get<MInteger>("Y"), IsOkAndHolds(y));
+}
+
+TEST(GeneratorManagerTest,
+     AssignValuesInAllTestCasesWithTheMersenneTwisterShouldShareTheEngine) {
+  EmptyGenerator gen;
+  gen.AddTestCase().ConstrainVariable("X", MInteger().Between(1, 1000000000));
+  gen.AddTestCase().ConstrainVariable("X", MInteger().Between(1, 1000000000));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> values,
+      GeneratorManager(&gen).AssignValuesInAllTestCases());
+  ASSERT_THAT(values, SizeIs(2));
+
+  // Old seeds give the same values as when every test case used one engine.
+  moriarty_internal::RandomEngine rng(
+      {1, 2, 3}, moriarty_internal::kMersenneTwisterVersion);
+  for (int i = 0; i < 2; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        moriarty_internal::ValueSet expected,
+        moriarty_internal::TestCaseManager(
+            GeneratorManager(&gen).GetTestCases()[i].get())
+            .AssignAllValues(rng, std::nullopt));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t x, expected.Get<MInteger>("X"));
+    EXPECT_THAT(values[i].Get<MInteger>("X"), IsOkAndHolds(x));
+  }
+}
+
+TEST(GeneratorManagerTest,
+     AssignValuesInAllTestCasesWithSchedulerShouldMatchSerialOrder) {
+  auto add_cases = [](EmptyGenerator& gen) {
+    GeneratorManager(&gen).SetSeed({1, 2, 3},
+                                   moriarty_internal::kCounterBasedVersion);
+    for (int i = 0; i < 50; i++) {
+      gen.AddTestCase().ConstrainVariable("X", MInteger().Between(1, i + 1));
+      gen.AddOptionalTestCase().ConstrainVariable(
+          "Y", MInteger().Between(1, 1000000000));
+    }
+  };
+  EmptyGenerator serial;
+  add_cases(serial);
+  EmptyGenerator parallel;
+  add_cases(parallel);
+  moriarty_internal::WorkStealingScheduler scheduler(4);
+  GeneratorManager(&parallel).SetScheduler(&scheduler);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> serial_values,
+      GeneratorManager(&serial).AssignValuesInAllTestCases());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> parallel_values,
+      GeneratorManager(&parallel).AssignValuesInAllTestCases());
+
+  ASSERT_THAT(parallel_values, SizeIs(100));
+  for (int i = 0; i < 50; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t x,
+                                  serial_values[i].Get<MInteger>("X"));
+    EXPECT_THAT(parallel_values[i].Get<MInteger>("X"), IsOkAndHolds(x));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t y,
+                                  serial_values[50 + i].Get<MInteger>("Y"));
+    EXPECT_THAT(parallel_values[50 + i].Get<MInteger>("Y"), IsOkAndHolds(y));
+  }
+}
+
+TEST(GeneratorManagerTest,
+     AssignValuesInAllTestCasesWithSchedulerFailsIfATestCaseFails) {
+  EmptyGenerator gen;
+  moriarty_internal::WorkStealingScheduler scheduler(4);
+  GeneratorManager(&gen).SetScheduler(&scheduler);
+  for (int i = 0; i < 20; i++)
+    gen.AddTestCase().ConstrainVariable("X", MInteger().Between(1, 10));
+  gen.AddTestCase().ConstrainVariable("Y", MInteger().Between(10, 5));
+
+  EXPECT_FALSE(GeneratorManager(&gen).AssignValuesInAllTestCases().ok());
+}
+
+TEST(GeneratorManagerTest,
+     DerivedTestCaseShouldCopyItsBaseAndApplyTheMutation) {
+  EmptyGenerator gen;
+  TestCase& base =
+      gen.AddTestCase()
+          .ConstrainVariable("N", MInteger().Between(1, 1000000000))
+          .ConstrainVariable(
+              "A", MArray<MInteger>(MInteger().Between(1, 5)).OfLength(100));
+  gen.AddDerivedTestCase(base,
+                         TestCaseMutation().ChangeElements<MArray<MInteger>>(
+                             "A", 3, MInteger().Between(100, 200)));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> values,
+      GeneratorManager(&gen).AssignValuesInAllTestCases());
+
+  ASSERT_THAT(values, SizeIs(2));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t n, values[0].Get<MInteger>("N"));
+  EXPECT_THAT(values[1].Get<MInteger>("N"), IsOkAndHolds(n));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> a,
+                                values[0].Get<MArray<MInteger>>("A"));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> derived_a,
+                                values[1].Get<MArray<MInteger>>("A"));
+  ASSERT_THAT(derived_a, SizeIs(100));
+  int num_changed = 0;
+  for (int i = 0; i < 100; i++) {
+    if (a[i] == derived_a[i]) continue;
+    num_changed++;
+    EXPECT_THAT(derived_a[i], AllOf(Ge(100), Le(200)));
+  }
+  EXPECT_EQ(num_changed, 3);
+}
+
+TEST(GeneratorManagerTest, DerivedTestCasesCanBeDerivedFromEachOther) {
+  EmptyGenerator gen;
+  TestCase& base =
+      gen.AddTestCase().ConstrainVariable("X", MInteger().Between(1, 10));
+  gen.AddDerivedTestCase(
+      base, TestCaseMutation().SetValue<MInteger>("X", 100).SetValue<MInteger>(
+                "Y", 5));
+  gen.AddDerivedTestCase(*GeneratorManager(&gen).GetTestCases()[1],
+                         TestCaseMutation().SetValue<MInteger>("X", 200));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> values,
+      GeneratorManager(&gen).AssignValuesInAllTestCases());
+
+  ASSERT_THAT(values, SizeIs(3));
+  EXPECT_THAT(values[1].Get<MInteger>("X"), IsOkAndHolds(100));
+  EXPECT_THAT(values[2].Get<MInteger>("X"), IsOkAndHolds(200));
+  EXPECT_THAT(values[2].Get<MInteger>("Y"), IsOkAndHolds(5));
+}
+
+TEST(GeneratorManagerTest, DerivedTestCaseWithAFailingMutationShouldFail) {
+  EmptyGenerator gen;
+  TestCase& base = gen.AddTestCase().ConstrainVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 5)).OfLength(10));
+  gen.AddDerivedTestCase(base,
+                         TestCaseMutation().ChangeElements<MArray<MInteger>>(
+                             "A", 11, MInteger().Between(1, 5)));
+
+  EXPECT_THAT(GeneratorManager(&gen).AssignValuesInAllTestCases(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(GeneratorTest, AddDerivedTestCaseRequiresATestCaseOfTheSameGenerator) {
+  EmptyGenerator gen1;
+  EmptyGenerator gen2;
+  TestCase& base = gen1.AddTestCase();
+
+  EXPECT_THAT(gen2.TryAddDerivedTestCase(base, TestCaseMutation()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(gen1.TryAddDerivedTestCase(gen1.AddOptionalTestCase(),
+                                         TestCaseMutation()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Adds `num_test_cases` test cases, one at a time, each with an optional test
+// case.
+class CountingStreamingGenerator : public moriarty::StreamingGenerator {
+ public:
+  explicit CountingStreamingGenerator(int num_test_cases)
+      : num_test_cases_(num_test_cases) {}
+
+  bool GenerateNextTestCase() override {
+    if (NumTestCasesAdded() == num_test_cases_) return false;
+    AddTestCase().ConstrainVariable("X", MInteger().Between(1, 1000000000));
+    AddOptionalTestCase().ConstrainVariable("Y", MInteger().Between(1, 10));
+    return true;
+  }
+
+ private:
+  int num_test_cases_;
+};
+
+TEST(StreamingGeneratorTest, GenerateTestCasesAddsAllTestCases) {
+  EXPECT_THAT(RunGenerateForTest(CountingStreamingGenerator(5)),
+              IsOkAndHolds(SizeIs(10)));
+  EXPECT_THAT(RunGenerateForTest(CountingStreamingGenerator(0)),
+              IsOkAndHolds(IsEmpty()));
+}
+
+// Checks that assigning the test cases of a `CountingStreamingGenerator` one
+// at a time gives the same values as assigning them all at once.
+void ExpectReleasedTestCasesDoNotChangeLaterValues(absl::string_view version) {
+  CountingStreamingGenerator all_at_once(3);
+  GeneratorManager(&all_at_once).SetSeed({1, 2, 3}, version);
+  GeneratorManager(&all_at_once).SetGeneralConstraints({});
+  all_at_once.GenerateTestCases();
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> expected,
+      GeneratorManager(&all_at_once).AssignValuesInAllTestCases());
+  ASSERT_THAT(expected, SizeIs(6));
+
+  CountingStreamingGenerator one_at_a_time(3);
+  GeneratorManager manager(&one_at_a_time);
+  manager.SetSeed({1, 2, 3}, version);
+  manager.SetGeneralConstraints({});
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(manager.GenerateNextTestCase());
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<moriarty_internal::ValueSet> values,
+        manager.AssignValuesInAllTestCases());
+    manager.ReleaseTestCases();
+    ASSERT_THAT(values, SizeIs(2));
+    ASSERT_THAT(manager.GetTestCases(), IsEmpty());
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t x, expected[i].Get<MInteger>("X"));
+    EXPECT_THAT(values[0].Get<MInteger>("X"), IsOkAndHolds(x));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t y,
+                                  expected[3 + i].Get<MInteger>("Y"));
+    EXPECT_THAT(values[1].Get<MInteger>("Y"), IsOkAndHolds(y));
+  }
+  EXPECT_FALSE(manager.GenerateNextTestCase());
+}
+
+TEST(StreamingGeneratorTest, ReleasedTestCasesShouldNotChangeLaterValues) {
+  // With "v0.1", the test cases share one engine, so the values depend on the
+  // order they are assigned in.
+  ExpectReleasedTestCasesDoNotChangeLaterValues(
+      moriarty_internal::kCounterBasedVersion);
+}
+
+TEST(GeneratorManagerTest, GenerateNextTestCaseIsOnlyForStreamingGenerators) {
+  EmptyGenerator gen;
+  EXPECT_FALSE(GeneratorManager(&gen).IsStreaming());
+  EXPECT_FALSE(GeneratorManager(&gen).GenerateNextTestCase());
+
+  CountingStreamingGenerator streaming(1);
+  EXPECT_TRUE(GeneratorManager(&streaming).IsStreaming());
+}
+
 TEST(GeneratorTest, ScenarioShouldApplyToAllFutureAddTestCaseCalls) {
   SimpleTestTypeGenerator generator;
   MORIARTY_ASSERT_OK(generator.TryWithScenario(Scenario().WithGeneralProperty(
@@ -266,7 +552,9 @@ class ProtectedGenerator : public moriarty::Generator {
   void GenerateTestCases() override {}  // Do nothing.
 
   // Promote protected functions in `Generator` to public for testing purposes.
+  using Generator::AllSatisfyConstraints;
   using Generator::GetVariable;
+  using Generator::GetVariableView;
   using Generator::HugeValue;
   using Generator::LargeValue;
   using Generator::MaxValue;
@@ -276,9 +564,11 @@ class ProtectedGenerator : public moriarty::Generator {
   using Generator::RandomInteger;
   using Generator::SatisfiesConstraints;
   using Generator::SizedValue;
+  using Generator::SizedValues;
   using Generator::SmallValue;
   using Generator::TinyValue;
   using Generator::TryGetVariable;
+  using Generator::TryGetVariableView;
   using Generator::TryHugeValue;
   using Generator::TryLargeValue;
   using Generator::TryMaxValue;
@@ -316,6 +606,25 @@ TEST(GeneratorTest, UnseededSatisfiesConstraintsShouldFail) {
               IsMisconfigured(InternalConfigurationType::kVariableSet));
 }
 
+TEST(GeneratorTest, AllSatisfyConstraintsChecksEveryValue) {
+  ProtectedGenerator G(/* should_seed = */ false);
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Is(10)));
+  moriarty_internal::GeneratorManager(&G).SetGeneralConstraints(variables);
+  MORIARTY_EXPECT_OK(G.AllSatisfyConstraints(MInteger().Between(1, "N"),
+                                             std::vector<int64_t>{1, 5, 10}));
+  EXPECT_THAT(G.AllSatisfyConstraints(MInteger().Between(1, "N"),
+                                      std::vector<int64_t>{1, 11, 5}),
+              IsUnsatisfiedConstraint("range"));
+}
+
+TEST(GeneratorTest, UnseededAllSatisfyConstraintsShouldFail) {
+  ProtectedGenerator G(/* should_seed = */ false);
+  EXPECT_THAT(G.AllSatisfyConstraints(MInteger().Between(1, 10),
+                                      std::vector<int64_t>{5}),
+              IsMisconfigured(InternalConfigurationType::kVariableSet));
+}
+
 TEST(GeneratorDeathTest, RandomIntegerShouldCrashIfNoRngSet) {
   // (void) to ignore the [[nodiscard]] error.
   EXPECT_DEATH(
@@ -407,6 +716,33 @@ TEST(GeneratorTest, GetVariableFailsForWrongVariableType) {
                        HasSubstr("Unable to convert")));
 }
 
+TEST(GeneratorTest, GetVariableViewReturnsTheSameVariableEachTime) {
+  ProtectedGenerator G(/* should_seed = */ false);
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("x", MInteger().Between(111, 122)));
+  moriarty_internal::GeneratorManager(&G).SetGeneralConstraints(variables);
+
+  const MInteger& x = G.GetVariableView<MInteger>("x");
+  EXPECT_TRUE(GenerateSameValues(x, MInteger().Between(111, 122)));
+  EXPECT_EQ(&x, &G.GetVariableView<MInteger>("x"));
+}
+
+TEST(GeneratorTest, TryGetVariableViewFailsLikeTryGetVariable) {
+  ProtectedGenerator G(/* should_seed = */ false);
+  EXPECT_THAT(G.TryGetVariableView<MInteger>("x"),
+              IsMisconfigured(InternalConfigurationType::kVariableSet));
+
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("x", MInteger()));
+  moriarty_internal::GeneratorManager(&G).SetGeneralConstraints(variables);
+
+  EXPECT_THAT(G.TryGetVariableView<MInteger>("u"),
+              moriarty_testing::IsVariableNotFound("u"));
+  EXPECT_THAT(G.TryGetVariableView<MTestType>("x"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unable to convert")));
+}
+
 TEST(GeneratorTest, SizedValuesReturnsAppropriatelySizedValues) {
   // G1 and G2 share the same seed, so should generate the same sequence of
   // values. Only G1 is seeded with the variable.
@@ -483,6 +819,38 @@ TEST(GeneratorTest, SizedValuesReturnsAppropriatelySizedValues) {
       G2.Random(MInteger().Between(123, 234).WithSize(CommonSize::kMax)));
 }
 
+TEST(GeneratorTest, SizedValuesInBulkShouldAllHaveTheRequestedSize) {
+  ProtectedGenerator G;
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("x", MInteger().Between(123, 234)));
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable("y", MInteger().Between(1, "N")));
+  moriarty_internal::GeneratorManager(&G).SetGeneralConstraints(variables);
+
+  // Small values in [1, 112] are in [1, 30], so these are in [123, 152].
+  EXPECT_THAT(G.SizedValues<MInteger>("x", "small", 1000),
+              IsOkAndHolds(AllOf(SizeIs(1000), Each(AllOf(Ge(123), Le(152))))));
+  EXPECT_THAT(G.SizedValues<MInteger>("x", "max", 10),
+              IsOkAndHolds(AllOf(SizeIs(10), Each(234))));
+  EXPECT_THAT(G.SizedValues<MInteger>("y", "min", 10),
+              IsOkAndHolds(AllOf(SizeIs(10), Each(1))));
+  EXPECT_THAT(G.SizedValues<MInteger>("x", "small", 0),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(GeneratorTest, SizedValuesWithBadArgumentsShouldFail) {
+  ProtectedGenerator G;
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("x", MInteger().Between(1, 10)));
+  moriarty_internal::GeneratorManager(&G).SetGeneralConstraints(variables);
+
+  EXPECT_THAT(G.SizedValues<MInteger>("x", "small", -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_FALSE(G.SizedValues<MInteger>("x", "gigantic", 5).ok());
+  EXPECT_THAT(G.SizedValues<MInteger>("z", "small", 5),
+              IsVariableNotFound("z"));
+}
+
 TEST(GeneratorTest, SizedValuesFailsForUnknownSizes) {
   ProtectedGenerator G;
   moriarty_internal::VariableSet variables;
@@ -555,6 +923,16 @@ TEST(GeneratorTest, GetGeneralConstraintsWithSetVarsHasValue) {
 namespace moriarty_testing {
 namespace {
 
+using ::moriarty::StatusIs;
+using ::moriarty::moriarty_internal::CountPermutationCycles;
+using ::moriarty::moriarty_internal::IsDerangement;
+using ::moriarty::moriarty_internal::IsInvolution;
+using ::moriarty::moriarty_internal::IsPermutation;
+using ::testing::AnyOf;
+using ::testing::Each;
+using ::testing::Optional;
+using ::testing::UnorderedElementsAre;
+
 class ProtectedNonStatusRandomFunctions : public moriarty::Generator {
  public:
   ProtectedNonStatusRandomFunctions() {
@@ -565,11 +943,19 @@ class ProtectedNonStatusRandomFunctions : public moriarty::Generator {
 
   using Generator::DistinctIntegers;
   using Generator::RandomComposition;
+  using Generator::RandomCyclicPermutation;
+  using Generator::RandomDerangement;
   using Generator::RandomElement;
   using Generator::RandomElementsWithoutReplacement;
   using Generator::RandomElementsWithReplacement;
   using Generator::RandomInteger;
+  using Generator::RandomInvolution;
+  using Generator::RandomLazyPermutation;
   using Generator::RandomPermutation;
+  using Generator::RandomPermutationWithCycles;
+  using Generator::RandomWeightedElement;
+  using Generator::RandomWeightedElements;
+  using Generator::ReservoirSample;
   using Generator::Shuffle;
 };
 
@@ -611,6 +997,25 @@ class ProtectedStatusRandomFunctions : public moriarty::Generator {
     return TryRandomElementsWithoutReplacement(container, k);
   }
 
+  template <typename T>
+  absl::StatusOr<T> RandomWeightedElement(const std::vector<T>& container,
+                                          absl::Span<const int64_t> weights) {
+    return TryRandomWeightedElement(container, weights);
+  }
+
+  template <typename T>
+  absl::StatusOr<std::vector<T>> RandomWeightedElements(
+      const std::vector<T>& container, absl::Span<const int64_t> weights,
+      int k) {
+    return TryRandomWeightedElements(container, weights, k);
+  }
+
+  template <typename InputIt>
+  absl::StatusOr<std::vector<std::iter_value_t<InputIt>>> ReservoirSample(
+      InputIt first, InputIt last, int k) {
+    return TryReservoirSample(first, last, k);
+  }
+
   absl::StatusOr<std::vector<int>> RandomPermutation(int n) {
     return TryRandomPermutation(n);
   }
@@ -633,6 +1038,26 @@ class ProtectedStatusRandomFunctions : public moriarty::Generator {
                                                    T min_bucket_size = 1) {
     return TryRandomComposition(n, k, min_bucket_size);
   }
+
+  absl::StatusOr<std::vector<int>> RandomCyclicPermutation(int n) {
+    return TryRandomCyclicPermutation(n);
+  }
+
+  absl::StatusOr<std::vector<int>> RandomDerangement(int n) {
+    return TryRandomDerangement(n);
+  }
+
+  absl::StatusOr<std::vector<int>> RandomPermutationWithCycles(int n, int k) {
+    return TryRandomPermutationWithCycles(n, k);
+  }
+
+  absl::StatusOr<std::vector<int>> RandomInvolution(int n) {
+    return TryRandomInvolution(n);
+  }
+
+  absl::StatusOr<moriarty::LazyPermutation> RandomLazyPermutation(int64_t n) {
+    return TryRandomLazyPermutation(n);
+  }
 };
 
 INSTANTIATE_TYPED_TEST_SUITE_P(ProtectedStatusRandomFunctions,
@@ -670,6 +1095,15 @@ TEST(GeneratorTest, RandomFunctionsWithoutRandomSeedShouldFail) {
   EXPECT_THAT(
       unseeded.RandomElementsWithReplacement(helper, 2),
       IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomWeightedElement(helper, {1, 1, 1}),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomWeightedElements(helper, {1, 1, 1}, 2),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.ReservoirSample(helper.begin(), helper.end(), 2),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
   EXPECT_THAT(
       unseeded.RandomPermutation(2),
       IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
@@ -679,6 +1113,71 @@ TEST(GeneratorTest, RandomFunctionsWithoutRandomSeedShouldFail) {
   EXPECT_THAT(
       unseeded.Shuffle(helper),
       IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomCyclicPermutation(2),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomDerangement(2),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomPermutationWithCycles(2, 1),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomInvolution(2),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+  EXPECT_THAT(
+      unseeded.RandomLazyPermutation(2),
+      IsMisconfigured(moriarty::InternalConfigurationType::kRandomEngine));
+}
+
+TEST(GeneratorTest, RandomWeightedElementsShouldSkipZeroWeights) {
+  ProtectedNonStatusRandomFunctions generator;
+  std::vector<int> values = {1, 2, 3};
+  EXPECT_EQ(generator.RandomWeightedElement(values, {0, 4, 0}), 2);
+  EXPECT_THAT(generator.RandomWeightedElements(values, {1, 0, 1}, 50),
+              Each(AnyOf(1, 3)));
+}
+
+TEST(GeneratorTest, ReservoirSampleShouldReturnDistinctElements) {
+  ProtectedNonStatusRandomFunctions generator;
+  std::vector<int> values = {1, 2, 3, 4, 5};
+  std::vector<int> sample =
+      generator.ReservoirSample(values.begin(), values.end(), 5);
+  EXPECT_THAT(sample, UnorderedElementsAre(1, 2, 3, 4, 5));
+}
+
+TEST(GeneratorTest, StructuredPermutationsShouldHaveTheirStructure) {
+  ProtectedNonStatusRandomFunctions generator;
+  std::vector<int64_t> cycle = generator.RandomCyclicPermutation<int64_t>(50);
+  EXPECT_THAT(CountPermutationCycles(cycle), Optional(1));
+
+  std::vector<int64_t> derangement =
+      generator.RandomDerangement<int64_t>(50, 1);
+  EXPECT_TRUE(IsDerangement(derangement, 1));
+
+  std::vector<int64_t> cycles =
+      generator.RandomPermutationWithCycles<int64_t>(50, 7);
+  EXPECT_THAT(CountPermutationCycles(cycles), Optional(7));
+
+  std::vector<int64_t> involution = generator.RandomInvolution<int64_t>(50);
+  EXPECT_TRUE(IsInvolution(involution));
+}
+
+TEST(GeneratorTest, RandomLazyPermutationShouldBeAPermutation) {
+  ProtectedNonStatusRandomFunctions generator;
+  moriarty::LazyPermutation permutation =
+      generator.RandomLazyPermutation(1000);
+  std::vector<int64_t> values;
+  for (int64_t i = 0; i < 1000; i++) values.push_back(permutation(i));
+  EXPECT_TRUE(IsPermutation(values));
+}
+
+TEST(GeneratorTest, StructuredPermutationsWithInvalidInputShouldFail) {
+  ProtectedStatusRandomFunctions generator;
+  EXPECT_THAT(generator.RandomDerangement(1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(generator.RandomPermutationWithCycles(3, 4),
+              StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
 }  // namespace
@@ -14,7 +14,10 @@
 
 #include "src/generators/combinatorial_generator.h"
 
-#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -22,19 +25,63 @@
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/statusor.h"
-#include "absl/types/span.h"
+#include "absl/synchronization/mutex.h"
 #include "src/generator.h"
 #include "src/internal/abstract_variable.h"
 #include "src/internal/combinatorial_coverage.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/test_case.h"
 
 namespace moriarty {
 
+namespace {
+
+// The rows of a covering array that have been built, but not yet turned into
+// test cases. Rows are taken out in the order they were added.
+class PendingRows {
+ public:
+  void Add(const CoveringArrayTestCase& row) {
+    absl::MutexLock lock(&mutex_);
+    rows_.push_back(row);
+  }
+
+  // No more rows will be added.
+  void Close() {
+    absl::MutexLock lock(&mutex_);
+    closed_ = true;
+  }
+
+  // Waits for the next row. Returns std::nullopt once every row has been
+  // taken and no more will be added.
+  std::optional<CoveringArrayTestCase> Take() {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(this, &PendingRows::HasRowsOrIsClosed));
+    if (rows_.empty()) return std::nullopt;
+    CoveringArrayTestCase row = std::move(rows_.front());
+    rows_.pop_front();
+    return row;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::deque<CoveringArrayTestCase> rows_ ABSL_GUARDED_BY(mutex_);
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+
+  bool HasRowsOrIsClosed() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !rows_.empty() || closed_;
+  }
+};
+
+}  // namespace
+
 void CombinatorialCoverage::GenerateTestCases() {
   moriarty_internal::GeneratorManager generator_manager(this);
   // TODO(hivini): Handle the (two) crashes better to inform the user about the
@@ -48,30 +95,102 @@ void CombinatorialCoverage::GenerateTestCases() {
 
   InitializeCasesInfo cases_info = InitializeCases(var_set.GetAllVariables());
 
-  std::function<int(int)> rand_f = [random_engine](int n) -> int {
-    int result = random_engine->RandInt(n).value() % n;
-    return result;
+  int num_dimensions = cases_info.dimension_sizes.size();
+  if (num_dimensions == 0) return;
+  int strength = std::min(strength_.value_or(num_dimensions), num_dimensions);
+
+  // The covering array only depends on this seed (and the dimensions), so it
+  // is reused if the same array was already built in this process.
+  int64_t seed =
+      random_engine->RandInt(std::numeric_limits<int64_t>::max()).value();
+  auto for_each_row = [&](CoveringArrayRowCallback on_row) {
+    ForEachCoveringArrayRowFromSeed(cases_info.dimension_sizes, strength, seed,
+                                    CoveringArrayAlgorithm::kIpog,
+                                    /*scheduler=*/nullptr, on_row);
   };
 
-  std::vector<CoveringArrayTestCase> covering_array = GenerateCoveringArray(
-      cases_info.dimension_sizes, cases_info.dimension_sizes.size(), rand_f);
-  CreateTestCases(covering_array, cases_info.cases, cases_info.variable_names);
+  absl::Nullable<moriarty_internal::Scheduler*> scheduler =
+      generator_manager.GetScheduler();
+  if (scheduler == nullptr || scheduler->NumThreads() == 1) {
+    for_each_row([&](const CoveringArrayTestCase& row) {
+      CreateTestCase(row, cases_info);
+    });
+    return;
+  }
+
+  // Task 0 builds the covering array while task 1 creates the test cases for
+  // the rows that are already final, in order. Task 0 never waits for task 1,
+  // so this cannot deadlock even if both run on the same thread.
+  PendingRows pending_rows;
+  scheduler->ParallelFor(2, [&](int task) {
+    if (task == 0) {
+      for_each_row(
+          [&](const CoveringArrayTestCase& row) { pending_rows.Add(row); });
+      pending_rows.Close();
+      return;
+    }
+    while (std::optional<CoveringArrayTestCase> row = pending_rows.Take())
+      CreateTestCase(*row, cases_info);
+  });
+}
+
+CombinatorialCoverage& CombinatorialCoverage::WithStrength(int strength) {
+  ABSL_CHECK_GT(strength, 0) << "Strength must be > 0";
+  strength_ = strength;
+  return *this;
+}
+
+void CombinatorialCoverage::CreateTestCase(
+    const CoveringArrayTestCase& row, const InitializeCasesInfo& cases_info) {
+  moriarty_internal::VariableSet variables;
+  for (int i = 0; i < cases_info.variable_names.size(); i++) {
+    ABSL_CHECK_OK(variables.AddVariable(
+        cases_info.variable_names[i],
+        *cases_info.difficult_instances[i][row.test_case[i]]));
+  }
+  if (IsKnownUnsatisfiable(variables)) return;
+
+  moriarty_internal::TestCaseManager manager(&AddTestCase());
+  for (int i = 0; i < cases_info.variable_names.size(); i++) {
+    const std::string& name = cases_info.variable_names[i];
+    const auto& merged = cases_info.merged_instances[i][row.test_case[i]];
+    if (merged != nullptr) {
+      manager.SetOverriddenVariable(name, *merged);
+    } else {
+      manager.ConstrainVariable(
+          name, *cases_info.difficult_instances[i][row.test_case[i]]);
+    }
+  }
 }
 
-void CombinatorialCoverage::CreateTestCases(
-    absl::Span<const CoveringArrayTestCase> covering_array,
-    absl::Span<
-        const std::vector<std::unique_ptr<moriarty_internal::AbstractVariable>>>
-        cases,
-    absl::Span<const std::string> variable_names) {
-  for (const CoveringArrayTestCase& x : covering_array) {
-    TestCase& test_case = AddTestCase();
-    for (int i = 0; i < x.test_case.size(); i++) {
-      moriarty_internal::TestCaseManager manager(&test_case);
-      manager.ConstrainVariable(variable_names[i],
-                                *(cases[i][x.test_case[i]].get()));
+bool CombinatorialCoverage::IsKnownUnsatisfiable(
+    const moriarty_internal::VariableSet& row) {
+  moriarty_internal::VariableSet variables = row;
+  moriarty_internal::ValueSet values;
+  moriarty_internal::Universe universe = moriarty_internal::Universe()
+                                             .SetMutableValueSet(&values)
+                                             .SetMutableVariableSet(&variables);
+  variables.SetUniverse(&universe);
+
+  // Uniquely determined values (e.g., N = 1) may determine others, so repeat
+  // until nothing new is known. Nothing is generated along the way.
+  int num_variables = variables.GetAllVariables().size();
+  for (int pass = 0; pass < num_variables; pass++) {
+    bool assigned_new_value = false;
+    for (const auto& [name, var_ptr] : variables.GetAllVariables()) {
+      if (values.Contains(name)) continue;
+      if (!var_ptr->AssignUniqueValue().ok()) return true;
+      if (values.Contains(name)) assigned_new_value = true;
     }
+    if (!assigned_new_value) break;
   }
+
+  for (const auto& [name, var_ptr] : variables.GetAllVariables()) {
+    if (var_ptr->IsKnownUnsatisfiable()) return true;
+    if (values.Contains(name) && !var_ptr->ValueSatisfiesConstraints().ok())
+      return true;
+  }
+  return false;
 }
 
 InitializeCasesInfo CombinatorialCoverage::InitializeCases(
@@ -80,11 +199,21 @@ InitializeCasesInfo CombinatorialCoverage::InitializeCases(
         vars) {
   InitializeCasesInfo info;
   for (const auto& [name, var_ptr] : vars) {
-    std::vector<std::unique_ptr<moriarty_internal::AbstractVariable>>
-        difficult_vars = var_ptr->GetDifficultAbstractVariables().value();
-    info.dimension_sizes.push_back(difficult_vars.size());
-    info.cases.push_back(std::move(difficult_vars));
+    info.difficult_instances.push_back(
+        var_ptr->GetDifficultAbstractVariables().value());
+    info.dimension_sizes.push_back(info.difficult_instances.back().size());
     info.variable_names.push_back(name);
+
+    // The same merge as `TestCase::ConstrainVariable()`. If it fails, the test
+    // case merges again and reports the failure.
+    std::vector<std::unique_ptr<moriarty_internal::AbstractVariable>>& merged =
+        info.merged_instances.emplace_back();
+    for (const auto& instance : info.difficult_instances.back()) {
+      std::unique_ptr<moriarty_internal::AbstractVariable> var =
+          var_ptr->Clone();
+      if (!var->MergeFrom(*instance).ok()) var = nullptr;
+      merged.push_back(std::move(var));
+    }
   }
   return info;
 }
@@ -26,24 +26,38 @@
 //    .AddVariable("N", MInteger().Between(1, 10))
 //    .AddVariable("A", MArray<MInteger>().OfLength("N"))
 //    .AddGenerator(CombinatorialCoverage());  // Will generate tricky cases.
+//
+// By default, every combination of difficult cases is generated. Use
+// `WithStrength(t)` to only require that every combination of difficult cases
+// of any t variables appears in some test case, which needs far fewer cases.
+// Combinations that are known to be impossible (e.g., N = 1 with an array of
+// length 2^31, when the length is at most N) are not generated.
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/types/span.h"
 #include "src/generator.h"
 #include "src/internal/abstract_variable.h"
 #include "src/internal/combinatorial_coverage.h"
+#include "src/internal/variable_set.h"
 
 namespace moriarty {
 
 struct InitializeCasesInfo {
-  std::vector<std::vector<std::unique_ptr<moriarty_internal::AbstractVariable>>>
-      cases;
   std::vector<std::string> variable_names;
   std::vector<int> dimension_sizes;
+  // The difficult instances of each variable, in the same order.
+  std::vector<std::vector<std::unique_ptr<moriarty_internal::AbstractVariable>>>
+      difficult_instances;
+  // Each difficult instance merged into the general constraints of its
+  // variable (`nullptr` if the merge fails). Many rows of the covering array
+  // use the same instance, so their test cases share these instead of each
+  // merging the instance again.
+  std::vector<std::vector<std::unique_ptr<moriarty_internal::AbstractVariable>>>
+      merged_instances;
 };
 
 // Generates test cases using covering arrays based on the difficult instances
@@ -52,26 +66,41 @@ class CombinatorialCoverage : public moriarty::Generator {
  public:
   void GenerateTestCases() override;
 
+  // WithStrength()
+  //
+  // Every combination of difficult cases of any `strength` variables appears
+  // in some test case (unless it is known to be impossible). `strength` must
+  // be positive. If it is at least the number of variables, all combinations
+  // are generated (the default).
+  CombinatorialCoverage& WithStrength(int strength);
+
  private:
+  std::optional<int> strength_;
+
   // InitializeCases()
   //
-  // Uses the map of variables to extract the difficult instances from the
-  // abstract variables, the name of the variable and define the dimensions
-  // array for the generation of the covering array.
+  // Uses the map of variables to get the difficult instances of the abstract
+  // variables, which define the dimensions array for the generation of the
+  // covering array.
   InitializeCasesInfo InitializeCases(
       const absl::flat_hash_map<
           std::string, std::unique_ptr<moriarty_internal::AbstractVariable>>&
           vars);
 
-  // CreateTestCases()
+  // CreateTestCase()
+  //
+  // Creates the test case for one row of the covering array, unless it is
+  // known to be unsatisfiable.
+  void CreateTestCase(const CoveringArrayTestCase& row,
+                      const InitializeCasesInfo& cases_info);
+
+  // IsKnownUnsatisfiable()
   //
-  // Creates all the test cases defined in the covering array.
-  void CreateTestCases(
-      absl::Span<const CoveringArrayTestCase> covering_array,
-      absl::Span<const std::vector<
-          std::unique_ptr<moriarty_internal::AbstractVariable>>>
-          cases,
-      absl::Span<const std::string> variable_names);
+  // Cheaply determines that the constraints in `row` cannot all be satisfied.
+  // Values that are uniquely determined are propagated, then each variable
+  // checks its constraints against them (e.g., an empty range via
+  // `Range::Extremes()`). Nothing is generated.
+  static bool IsKnownUnsatisfiable(const moriarty_internal::VariableSet& row);
 };
 
 }  // namespace moriarty
@@ -14,6 +14,9 @@
 
 #include "src/generators/combinatorial_generator.h"
 
+#include <cstdint>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -23,14 +26,25 @@
 #include "src/generator.h"
 #include "src/internal/combinatorial_coverage.h"
 #include "src/internal/combinatorial_coverage_test_util.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
+#include "src/test_case.h"
 #include "src/testing/mtest_type.h"
 #include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
 
 namespace moriarty {
 
 using ::moriarty::CombinatorialCoverage;
+using ::testing::AllOf;
+using ::testing::Contains;
+using ::testing::Ge;
+using ::testing::IsEmpty;
+using ::testing::Le;
+using ::testing::Not;
+using ::testing::SizeIs;
 
 namespace {
 
@@ -82,5 +96,126 @@ TEST(CombinatorialCoverage, GenerateShouldCreateCasesFromCoveringArray) {
   EXPECT_THAT(catc, IsStrength2CoveringArray(std::vector<int>({2, 2})));
 }
 
+TEST(CombinatorialCoverage, WithStrengthShouldOnlyCoverThatManyVariables) {
+  CombinatorialCoverage generator;
+  generator.WithStrength(2);
+  moriarty_internal::GeneratorManager generator_manager(&generator);
+  generator_manager.SetSeed({1, 2, 3, 4});
+  moriarty_internal::VariableSet varset;
+  for (const char* name : {"X", "Y", "Z"})
+    MORIARTY_ASSERT_OK(varset.AddVariable(name, moriarty_testing::MTestType()));
+
+  generator_manager.SetGeneralConstraints(varset);
+  generator.GenerateTestCases();
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> cases,
+      generator_manager.AssignValuesInAllTestCases());
+  // Covering all pairs of 3 variables with 2 difficult cases each needs 4 of
+  // the 8 combinations.
+  EXPECT_THAT(cases, SizeIs(4));
+}
+
+TEST(CombinatorialCoverage, ImpossibleCombinationsShouldNotBecomeTestCases) {
+  CombinatorialCoverage generator;
+  moriarty_internal::GeneratorManager generator_manager(&generator);
+  generator_manager.SetSeed({1, 2, 3, 4});
+  moriarty_internal::VariableSet varset;
+  MORIARTY_ASSERT_OK(varset.AddVariable("N", MInteger().Between(1, 3)));
+  MORIARTY_ASSERT_OK(varset.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 5)).OfLength(1, "N")));
+
+  generator_manager.SetGeneralConstraints(varset);
+  generator.GenerateTestCases();
+
+  // Most difficult lengths of `A` do not fit in [1, N], but every remaining
+  // test case can be generated.
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> cases,
+      generator_manager.AssignValuesInAllTestCases());
+  EXPECT_THAT(cases, Not(IsEmpty()));
+  for (const moriarty_internal::ValueSet& values : cases) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t n, values.Get<MInteger>("N"));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> a,
+                                  values.Get<MArray<MInteger>>("A"));
+    EXPECT_THAT(a, SizeIs(AllOf(Ge(1), Le(n))));
+  }
+}
+
+TEST(CombinatorialCoverage, SharedMergesShouldMatchMergingInEachTestCase) {
+  moriarty_internal::VariableSet varset;
+  MORIARTY_ASSERT_OK(varset.AddVariable("N", MInteger().Between(1, 30)));
+  MORIARTY_ASSERT_OK(varset.AddVariable("M", MInteger().Between(5, "N")));
+
+  // The constraints of N in a test case that merges each difficult instance
+  // of N itself.
+  std::vector<std::string> expected;
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      const moriarty_internal::AbstractVariable* general_n,
+      std::as_const(varset).GetAbstractVariable("N"));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(auto instances,
+                                general_n->GetDifficultAbstractVariables());
+  for (const auto& instance : instances) {
+    TestCase test_case;
+    moriarty_internal::TestCaseManager manager(&test_case);
+    manager.SetVariables(varset);
+    manager.ConstrainVariable("N", *instance);
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        const moriarty_internal::AbstractVariable* n,
+        manager.GetOverriddenVariables().GetAbstractVariable("N"));
+    expected.push_back(n->ToString());
+  }
+
+  CombinatorialCoverage generator;
+  moriarty_internal::GeneratorManager generator_manager(&generator);
+  generator_manager.SetSeed({1, 2, 3, 4});
+  generator_manager.SetGeneralConstraints(varset);
+  generator.GenerateTestCases();
+
+  ASSERT_THAT(generator_manager.GetTestCases(), Not(IsEmpty()));
+  for (const auto& test_case : generator_manager.GetTestCases()) {
+    moriarty_internal::TestCaseManager manager(test_case.get());
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        const moriarty_internal::AbstractVariable* n,
+        manager.GetOverriddenVariables().GetAbstractVariable("N"));
+    EXPECT_THAT(expected, Contains(n->ToString()));
+  }
+}
+
+TEST(CombinatorialCoverage, SchedulerShouldNotChangeTheTestCases) {
+  moriarty_internal::VariableSet varset;
+  MORIARTY_ASSERT_OK(varset.AddVariable("N", MInteger().Between(1, 30)));
+  MORIARTY_ASSERT_OK(varset.AddVariable("M", MInteger().Between(1, 30)));
+  MORIARTY_ASSERT_OK(varset.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 5)).OfLength(1, "N")));
+
+  auto generate = [&](moriarty_internal::Scheduler* scheduler) {
+    CombinatorialCoverage generator;
+    generator.WithStrength(2);
+    moriarty_internal::GeneratorManager generator_manager(&generator);
+    generator_manager.SetSeed({1, 2, 3, 4});
+    generator_manager.SetGeneralConstraints(varset);
+    generator_manager.SetScheduler(scheduler);
+    generator.GenerateTestCases();
+    return generator_manager.AssignValuesInAllTestCases();
+  };
+
+  moriarty_internal::WorkStealingScheduler scheduler(4);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<moriarty_internal::ValueSet> serial,
+                                generate(nullptr));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> parallel, generate(&scheduler));
+
+  ASSERT_THAT(parallel, SizeIs(serial.size()));
+  for (int i = 0; i < serial.size(); i++) {
+    EXPECT_EQ(parallel[i].Get<MInteger>("N").value(),
+              serial[i].Get<MInteger>("N").value());
+    EXPECT_EQ(parallel[i].Get<MInteger>("M").value(),
+              serial[i].Get<MInteger>("M").value());
+    EXPECT_EQ(parallel[i].Get<MArray<MInteger>>("A").value(),
+              serial[i].Get<MArray<MInteger>>("A").value());
+  }
+}
+
 }  // namespace
 }  // namespace moriarty
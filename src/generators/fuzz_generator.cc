@@ -0,0 +1,204 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/generators/fuzz_generator.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/constraint_values.h"
+#include "src/errors.h"
+#include "src/generator.h"
+#include "src/internal/generation_bootstrap.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/test_case.h"
+#include "src/test_case_mutation.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+void FuzzGenerator::GenerateTestCases() { ABSL_CHECK_OK(Fuzz()); }
+
+FuzzGenerator& FuzzGenerator::WithGeneratedSeeds(int num_seeds) {
+  ABSL_CHECK_GE(num_seeds, 0) << "The number of seeds must be >= 0";
+  num_generated_seeds_ = num_seeds;
+  return *this;
+}
+
+FuzzGenerator& FuzzGenerator::AddMutation(TestCaseMutation mutation) {
+  mutations_.push_back(std::move(mutation));
+  return *this;
+}
+
+FuzzGenerator& FuzzGenerator::WithNumMutants(int64_t num_mutants) {
+  ABSL_CHECK_GE(num_mutants, 0) << "The number of mutants must be >= 0";
+  num_mutants_ = num_mutants;
+  return *this;
+}
+
+FuzzGenerator& FuzzGenerator::WithCoverageFeedback(CoverageFeedback feedback) {
+  coverage_feedback_ = std::move(feedback);
+  return *this;
+}
+
+absl::Status FuzzGenerator::Fuzz() {
+  moriarty_internal::GeneratorManager generator_manager(this);
+  std::optional<const moriarty_internal::VariableSet> general_constraints =
+      generator_manager.GetGeneralConstraints();
+  if (!general_constraints) {
+    return MisconfiguredError("FuzzGenerator", "GenerateTestCases",
+                              InternalConfigurationType::kVariableSet);
+  }
+  moriarty_internal::RandomEngine* engine =
+      generator_manager.GetRandomEngine();
+  if (engine == nullptr) {
+    return MisconfiguredError("FuzzGenerator", "GenerateTestCases",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  // Seeds and mutants are generated like regular test cases.
+  const moriarty_internal::GenerationOptions options = {
+      .random_engine = *engine,
+      .soft_generation_limit =
+          generator_manager.GetApproximateGenerationLimit(),
+      .scheduler = generator_manager.GetScheduler(),
+      .profile = generator_manager.GetGenerationProfile(),
+      .budget = generator_manager.GetGenerationBudget()};
+
+  moriarty_internal::VariableSet variables = *general_constraints;
+  MORIARTY_ASSIGN_OR_RETURN(std::vector<moriarty_internal::ValueSet> corpus,
+                            GetSeeds(variables, options));
+  if (corpus.empty()) return absl::OkStatus();
+
+  // All checks and feedback look at `candidate`, which holds each seed and
+  // mutant in turn.
+  moriarty_internal::ValueSet candidate;
+  moriarty_internal::Universe universe =
+      moriarty_internal::Universe()
+          .SetConstValueSet(&candidate)
+          .SetConstVariableSet(&variables);
+  variables.SetUniverse(&universe);
+
+  absl::flat_hash_set<int64_t> covered;
+  auto reaches_new_coverage = [&]() -> absl::StatusOr<bool> {
+    if (!coverage_feedback_) return true;
+    MORIARTY_ASSIGN_OR_RETURN(std::vector<int64_t> coverage,
+                              coverage_feedback_(ConstraintValues(&universe)));
+    bool new_coverage = false;
+    for (int64_t id : coverage) {
+      if (covered.insert(id).second) new_coverage = true;
+    }
+    return new_coverage;
+  };
+
+  // Seeds are checked in full once. Afterwards, only changes are checked.
+  for (moriarty_internal::ValueSet& seed : corpus) {
+    candidate = std::move(seed);
+    MORIARTY_RETURN_IF_ERROR(variables.AllVariablesSatisfyConstraints())
+        << "FuzzGenerator seed does not satisfy constraints";
+    MORIARTY_RETURN_IF_ERROR(reaches_new_coverage().status());
+    seed = std::move(candidate);
+  }
+
+  for (int64_t mutant = 0; mutant < num_mutants_; mutant++) {
+    MORIARTY_ASSIGN_OR_RETURN(int64_t parent, engine->RandInt(corpus.size()));
+    candidate = corpus[parent];
+
+    // A mutation that cannot be applied (e.g., changing more elements than
+    // the array has) is just a mutant that is not kept.
+    absl::StatusOr<std::vector<std::string>> changed =
+        Mutate(variables, candidate, options);
+    if (!changed.ok()) continue;
+    bool valid = true;
+    for (const std::string& name : *changed) {
+      if (!variables.ValidateAfterChange(name).ok()) {
+        valid = false;
+        break;
+      }
+    }
+    if (!valid) continue;
+
+    MORIARTY_ASSIGN_OR_RETURN(bool keep, reaches_new_coverage());
+    if (!keep) continue;
+
+    corpus.push_back(candidate);
+    MORIARTY_ASSIGN_OR_RETURN(TestCase * test_case, TryAddTestCase());
+    moriarty_internal::TestCaseManager(test_case).SetValues(
+        std::move(candidate));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<moriarty_internal::ValueSet>>
+FuzzGenerator::GetSeeds(const moriarty_internal::VariableSet& variables,
+                        const moriarty_internal::GenerationOptions& options) {
+  if (!imported_seeds_) {
+    std::vector<moriarty_internal::ValueSet> imported;
+    for (SeedImporter& importer : importers_) {
+      MORIARTY_ASSIGN_OR_RETURN(std::vector<moriarty_internal::ValueSet> seeds,
+                                importer(variables));
+      for (moriarty_internal::ValueSet& seed : seeds)
+        imported.push_back(std::move(seed));
+    }
+    imported_seeds_ = std::move(imported);
+  }
+
+  std::vector<moriarty_internal::ValueSet> seeds = *imported_seeds_;
+  int num_generated = num_generated_seeds_.value_or(importers_.empty() ? 1 : 0);
+  for (int i = 0; i < num_generated; i++) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        moriarty_internal::ValueSet seed,
+        moriarty_internal::GenerateAllValues(variables, /*known_values = */ {},
+                                             options));
+    seeds.push_back(std::move(seed));
+  }
+  return seeds;
+}
+
+absl::StatusOr<std::vector<std::string>> FuzzGenerator::Mutate(
+    const moriarty_internal::VariableSet& variables,
+    moriarty_internal::ValueSet& values,
+    const moriarty_internal::GenerationOptions& options) const {
+  moriarty_internal::RandomEngine& engine = options.random_engine;
+  if (!mutations_.empty()) {
+    MORIARTY_ASSIGN_OR_RETURN(int64_t index, engine.RandInt(mutations_.size()));
+    moriarty_internal::TestCaseMutationManager mutation(&mutations_[index]);
+    MORIARTY_RETURN_IF_ERROR(mutation.Apply(values, engine));
+    return mutation.GetChangedVariables();
+  }
+
+  // Without mutations, one variable gets a new value given all the others.
+  if (variables.NumVariables() == 0) return std::vector<std::string>();
+  MORIARTY_ASSIGN_OR_RETURN(int64_t handle,
+                            engine.RandInt(variables.NumVariables()));
+  std::string name = variables.GetName(handle);
+  values.Erase(name);
+  MORIARTY_ASSIGN_OR_RETURN(
+      values, moriarty_internal::GenerateAllValues(variables, std::move(values),
+                                                   options));
+  return std::vector<std::string>({name});
+}
+
+}  // namespace moriarty
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MORIARTY_SRC_GENERATORS_FUZZ_GENERATOR_H_
+#define MORIARTY_SRC_GENERATORS_FUZZ_GENERATOR_H_
+
+// FuzzGenerator is a generator that creates test cases by mutating the values
+// of existing test cases (seeds), instead of generating each of them from
+// scratch.
+//
+// Example Usage:
+//
+// Moriarty()
+//    .AddVariable("N", MInteger().Between(1, 100000))
+//    .AddVariable("A", MArray<MInteger>(MInteger().Between(1, 9))
+//                          .OfLength("N"))
+//    .AddGenerator("Fuzz",
+//                  FuzzGenerator()
+//                      .AddSeedsFrom(ExampleImporter())
+//                      .AddMutation(TestCaseMutation()
+//                                       .ChangeElements<MArray<MInteger>>(
+//                                           "A", 3, MInteger().Between(1, 9)))
+//                      .WithNumMutants(50));
+//
+// Each mutant is a copy of a seed (or of an earlier kept mutant) with one
+// mutation applied. A mutant is only kept if its values still satisfy all
+// constraints. Since the seed was valid, only the changed variables and the
+// variables that depend on them are checked again. With
+// `WithCoverageFeedback()`, a mutant is also only kept if it reaches coverage
+// that no earlier test case reached.
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/constraint_values.h"
+#include "src/generator.h"
+#include "src/importer.h"
+#include "src/internal/generation_bootstrap.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/test_case_mutation.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+// Generates test cases by mutating the values of seed test cases.
+class FuzzGenerator : public moriarty::Generator {
+ public:
+  void GenerateTestCases() override;
+
+  // AddSeedsFrom()
+  //
+  // The test cases imported by `importer` are used as seeds. They must
+  // satisfy all constraints. `importer` is run the first time this generator
+  // generates test cases, and its test cases are reused afterwards.
+  template <typename T>
+    requires std::derived_from<T, Importer>
+  FuzzGenerator& AddSeedsFrom(T importer);
+
+  // WithGeneratedSeeds()
+  //
+  // Each time this generator generates test cases, `num_seeds` seeds are
+  // generated from the constraints of the variables. `num_seeds` must be
+  // non-negative. By default, one seed is generated if no importer was added
+  // via `AddSeedsFrom()`, and none otherwise.
+  FuzzGenerator& WithGeneratedSeeds(int num_seeds);
+
+  // AddMutation()
+  //
+  // Each mutant applies one of the mutations added here, chosen uniformly at
+  // random. If no mutation is added, each mutant instead generates a new value
+  // for one random variable (and keeps the values of all others).
+  FuzzGenerator& AddMutation(TestCaseMutation mutation);
+
+  // WithNumMutants()
+  //
+  // The number of mutants to try (100 by default). Mutants that are not kept
+  // count towards this number, so at most `num_mutants` test cases are
+  // created. `num_mutants` must be non-negative.
+  FuzzGenerator& WithNumMutants(int64_t num_mutants);
+
+  // CoverageFeedback
+  //
+  // Given the values of a test case, returns the coverage it reaches. For
+  // example, runs a solution on the test case and returns the ids of the
+  // branches it took.
+  using CoverageFeedback = std::function<absl::StatusOr<std::vector<int64_t>>(
+      const ConstraintValues& values)>;
+
+  // WithCoverageFeedback()
+  //
+  // `feedback` is called on every seed and on every valid mutant. A mutant is
+  // only kept if `feedback` returns an id that it did not return for any seed
+  // or earlier kept mutant. If `feedback` fails, generation fails.
+  FuzzGenerator& WithCoverageFeedback(CoverageFeedback feedback);
+
+ private:
+  using SeedImporter =
+      std::function<absl::StatusOr<std::vector<moriarty_internal::ValueSet>>(
+          const moriarty_internal::VariableSet& general_constraints)>;
+  std::vector<SeedImporter> importers_;
+  std::optional<std::vector<moriarty_internal::ValueSet>> imported_seeds_;
+
+  std::optional<int> num_generated_seeds_;
+  std::vector<TestCaseMutation> mutations_;
+  int64_t num_mutants_ = 100;
+  CoverageFeedback coverage_feedback_;
+
+  // Fuzz()
+  //
+  // Adds a test case for each kept mutant.
+  absl::Status Fuzz();
+
+  // GetSeeds()
+  //
+  // Returns the imported seeds (importing them if needed) followed by the
+  // generated ones.
+  absl::StatusOr<std::vector<moriarty_internal::ValueSet>> GetSeeds(
+      const moriarty_internal::VariableSet& variables,
+      const moriarty_internal::GenerationOptions& options);
+
+  // Mutate()
+  //
+  // Applies a random mutation to `values` and returns the names of the
+  // variables it may have changed.
+  absl::StatusOr<std::vector<std::string>> Mutate(
+      const moriarty_internal::VariableSet& variables,
+      moriarty_internal::ValueSet& values,
+      const moriarty_internal::GenerationOptions& options) const;
+};
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename T>
+  requires std::derived_from<T, Importer>
+FuzzGenerator& FuzzGenerator::AddSeedsFrom(T importer) {
+  importers_.push_back(
+      [importer = std::move(importer)](
+          const moriarty_internal::VariableSet& general_constraints) mutable
+      -> absl::StatusOr<std::vector<moriarty_internal::ValueSet>> {
+        moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+            general_constraints);
+        MORIARTY_RETURN_IF_ERROR(importer.ImportTestCases())
+            << "Importer failed.";
+        return moriarty_internal::ImporterManager(&importer).TakeTestCases();
+      });
+  imported_seeds_.reset();
+  return *this;
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_GENERATORS_FUZZ_GENERATOR_H_
@@ -0,0 +1,207 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/generators/fuzz_generator.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/constraint_values.h"
+#include "src/generator.h"
+#include "src/importer.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/test_case_mutation.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::Ge;
+using ::testing::IsEmpty;
+using ::testing::Le;
+using ::testing::Not;
+using ::testing::SizeIs;
+
+// Imports a single test case with the given values of X and A.
+class SeedImporter : public Importer {
+ public:
+  SeedImporter(int64_t x, std::vector<int64_t> a) : x_(x), a_(std::move(a)) {}
+
+  absl::Status StartImport() override {
+    SetNumTestCases(1);
+    return absl::OkStatus();
+  }
+
+  absl::Status ImportTestCase() override {
+    SetValue<MInteger>("X", x_);
+    SetValue<MArray<MInteger>>("A", a_);
+    return absl::OkStatus();
+  }
+
+ private:
+  int64_t x_;
+  std::vector<int64_t> a_;
+};
+
+// Runs `generator` once with `variables` as its general constraints and
+// returns the values of the test cases it created.
+absl::StatusOr<std::vector<moriarty_internal::ValueSet>> Fuzz(
+    FuzzGenerator generator, const moriarty_internal::VariableSet& variables) {
+  moriarty_internal::GeneratorManager generator_manager(&generator);
+  generator_manager.SetSeed({1, 2, 3, 4});
+  generator_manager.SetGeneralConstraints(variables);
+  generator.GenerateTestCases();
+  return generator_manager.AssignValuesInAllTestCases();
+}
+
+TEST(FuzzGeneratorTest, DefaultMutationsOnlyKeepValidTestCases) {
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 5)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 5)).OfLength("N")));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> cases,
+      Fuzz(FuzzGenerator().WithNumMutants(50), variables));
+  EXPECT_THAT(cases, AllOf(Not(IsEmpty()), SizeIs(Le(50))));
+  for (const moriarty_internal::ValueSet& values : cases) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t n, values.Get<MInteger>("N"));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> a,
+                                  values.Get<MArray<MInteger>>("A"));
+    EXPECT_THAT(a, AllOf(SizeIs(n), Each(AllOf(Ge(1), Le(5)))));
+  }
+}
+
+TEST(FuzzGeneratorTest, InvalidMutantsAreNotKept) {
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("X", MInteger().Between(1, 10)));
+
+  EXPECT_THAT(Fuzz(FuzzGenerator().AddMutation(
+                       TestCaseMutation().SetValue<MInteger>("X", 11)),
+                   variables),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(FuzzGeneratorTest, MutantsAreBasedOnImportedSeeds) {
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("X", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 100)).OfLength(10)));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> cases,
+      Fuzz(FuzzGenerator()
+               .AddSeedsFrom(SeedImporter(5, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}))
+               .AddMutation(TestCaseMutation().ChangeElements<MArray<MInteger>>(
+                   "A", 1, MInteger().Between(100, 100)))
+               .WithNumMutants(20),
+           variables));
+  EXPECT_THAT(cases, SizeIs(20));
+  for (const moriarty_internal::ValueSet& values : cases) {
+    EXPECT_THAT(values.Get<MInteger>("X"), IsOkAndHolds(5));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> a,
+                                  values.Get<MArray<MInteger>>("A"));
+    ASSERT_THAT(a, SizeIs(10));
+    for (int i = 0; i < 10; i++) EXPECT_TRUE(a[i] == i + 1 || a[i] == 100);
+  }
+}
+
+TEST(FuzzGeneratorTest, MutantsOnlyRecheckTheChangedVariables) {
+  auto num_checks = std::make_shared<int>(0);
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("X", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "A", MArray<MInteger>().AddCustomConstraint(
+               "counted", [num_checks](const std::vector<int64_t>&) {
+                 (*num_checks)++;
+                 return true;
+               })));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> cases,
+      Fuzz(FuzzGenerator()
+               .AddSeedsFrom(SeedImporter(5, {1, 2, 3}))
+               .AddMutation(TestCaseMutation().SetValue<MInteger>("X", 7))
+               .WithNumMutants(10),
+           variables));
+  EXPECT_THAT(cases, SizeIs(10));
+  // Only the seed's value of A is checked.
+  EXPECT_EQ(*num_checks, 1);
+}
+
+TEST(FuzzGeneratorTest, CoverageFeedbackOnlyKeepsMutantsWithNewCoverage) {
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("X", MInteger().Between(1, 5)));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<moriarty_internal::ValueSet> cases,
+      Fuzz(FuzzGenerator().WithNumMutants(100).WithCoverageFeedback(
+               [](const ConstraintValues& values)
+                   -> absl::StatusOr<std::vector<int64_t>> {
+                 return std::vector<int64_t>{values.GetValue<MInteger>("X")};
+               }),
+           variables));
+  // The seed covers one value of X, and each kept mutant covers a new one.
+  EXPECT_THAT(cases, AllOf(Not(IsEmpty()), SizeIs(Le(4))));
+  std::vector<int64_t> xs;
+  for (const moriarty_internal::ValueSet& values : cases) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t x, values.Get<MInteger>("X"));
+    EXPECT_THAT(xs, Each(Not(x)));
+    xs.push_back(x);
+  }
+}
+
+TEST(FuzzGeneratorTest, GeneratedSeedsUseTheGenerationBudget) {
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(5, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 5)).OfLength("N")));
+
+  FuzzGenerator generator;
+  moriarty_internal::GenerationBudget budget({.max_generate_calls = 1});
+  moriarty_internal::GeneratorManager generator_manager(&generator);
+  generator_manager.SetSeed({1, 2, 3, 4});
+  generator_manager.SetGeneralConstraints(variables);
+  generator_manager.SetGenerationBudget(&budget);
+  EXPECT_DEATH(generator.GenerateTestCases(), "generation budget exceeded");
+}
+
+TEST(FuzzGeneratorTest, FailingCoverageFeedbackFails) {
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("X", MInteger().Between(1, 5)));
+
+  FuzzGenerator generator = FuzzGenerator().WithCoverageFeedback(
+      [](const ConstraintValues&) -> absl::StatusOr<std::vector<int64_t>> {
+        return absl::InternalError("solution crashed");
+      });
+  moriarty_internal::GeneratorManager(&generator).SetSeed({1, 2, 3, 4});
+  moriarty_internal::GeneratorManager(&generator)
+      .SetGeneralConstraints(variables);
+  EXPECT_DEATH(generator.GenerateTestCases(), "solution crashed");
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,174 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/gzip_stream.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include "zlib.h"
+
+namespace moriarty {
+
+namespace {
+
+// Size of the buffers on either side of zlib.
+constexpr int kBufferSize = 1 << 16;
+
+// gzip encoding with the largest window (see `deflateInit2()`).
+constexpr int kGzipWindowBits = 15 + 16;
+// Accept both gzip and zlib headers (see `inflateInit2()`).
+constexpr int kAutoDetectWindowBits = 15 + 32;
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+//  GzipOutputStream
+
+class GzipOutputStream::Buffer : public std::streambuf {
+ public:
+  explicit Buffer(std::ostream& os)
+      : os_(os), in_(kBufferSize), out_(kBufferSize) {
+    ok_ = deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                       kGzipWindowBits, /* memLevel = */ 8,
+                       Z_DEFAULT_STRATEGY) == Z_OK;
+    setp(in_.data(), in_.data() + in_.size());
+  }
+
+  ~Buffer() override { deflateEnd(&stream_); }
+
+  bool Finish() {
+    if (finished_) return ok_;
+    finished_ = true;
+    ok_ = Deflate(Z_FINISH) && os_.flush().good();
+    return ok_;
+  }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (finished_ || !Deflate(Z_NO_FLUSH)) return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  // Flushing the compressor would make the output worse, so this only hands
+  // the buffered data to zlib. Everything is written by `Finish()`.
+  int sync() override { return !finished_ && Deflate(Z_NO_FLUSH) ? 0 : -1; }
+
+ private:
+  std::ostream& os_;
+  z_stream stream_ = {};
+  std::vector<char> in_;
+  std::vector<char> out_;
+  bool ok_ = false;
+  bool finished_ = false;
+
+  // Compresses everything in the put area and writes whatever zlib produces.
+  bool Deflate(int flush) {
+    if (!ok_) return false;
+    stream_.next_in = reinterpret_cast<Bytef*>(pbase());
+    stream_.avail_in = pptr() - pbase();
+    do {
+      stream_.next_out = reinterpret_cast<Bytef*>(out_.data());
+      stream_.avail_out = out_.size();
+      if (deflate(&stream_, flush) == Z_STREAM_ERROR) return ok_ = false;
+      os_.write(out_.data(), out_.size() - stream_.avail_out);
+      if (!os_) return ok_ = false;
+    } while (stream_.avail_out == 0);
+    setp(in_.data(), in_.data() + in_.size());
+    return true;
+  }
+};
+
+GzipOutputStream::GzipOutputStream(std::ostream& os)
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>(os)) {
+  rdbuf(buffer_.get());
+}
+
+GzipOutputStream::~GzipOutputStream() { Finish(); }
+
+void GzipOutputStream::Finish() {
+  if (!buffer_->Finish()) setstate(std::ios_base::badbit);
+}
+
+// -----------------------------------------------------------------------------
+//  GzipInputStream
+
+class GzipInputStream::Buffer : public std::streambuf {
+ public:
+  explicit Buffer(std::istream& is)
+      : is_(is), in_(kBufferSize), out_(kBufferSize) {
+    ok_ = inflateInit2(&stream_, kAutoDetectWindowBits) == Z_OK;
+  }
+
+  ~Buffer() override { inflateEnd(&stream_); }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    while (ok_) {
+      if (stream_.avail_in == 0) {
+        is_.read(in_.data(), in_.size());
+        if (is_.gcount() == 0) break;  // End of the compressed data.
+        stream_.next_in = reinterpret_cast<Bytef*>(in_.data());
+        stream_.avail_in = is_.gcount();
+      }
+
+      stream_.next_out = reinterpret_cast<Bytef*>(out_.data());
+      stream_.avail_out = out_.size();
+      int result = inflate(&stream_, Z_NO_FLUSH);
+      if (result == Z_STREAM_END) {
+        // Another gzip stream may follow this one.
+        ok_ = inflateReset(&stream_) == Z_OK;
+      } else if (result != Z_OK && result != Z_BUF_ERROR) {
+        ok_ = false;  // Corrupt data. Treat it as the end of the input.
+      }
+
+      int produced = out_.size() - stream_.avail_out;
+      if (produced > 0) {
+        setg(out_.data(), out_.data(), out_.data() + produced);
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+    return traits_type::eof();
+  }
+
+ private:
+  std::istream& is_;
+  z_stream stream_ = {};
+  std::vector<char> in_;
+  std::vector<char> out_;
+  bool ok_ = false;
+};
+
+GzipInputStream::GzipInputStream(std::istream& is)
+    : std::istream(nullptr), buffer_(std::make_unique<Buffer>(is)) {
+  rdbuf(buffer_.get());
+}
+
+GzipInputStream::~GzipInputStream() = default;
+
+bool IsGzipData(const char* data, int size) {
+  return size >= 2 && static_cast<unsigned char>(data[0]) == 0x1f &&
+         static_cast<unsigned char>(data[1]) == 0x8b;
+}
+
+}  // namespace moriarty
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_GZIP_STREAM_H_
+#define MORIARTY_SRC_GZIP_STREAM_H_
+
+#include <istream>
+#include <memory>
+#include <ostream>
+
+namespace moriarty {
+
+// GzipOutputStream
+//
+// An output stream that gzip-compresses everything written to it into `os`.
+// Use it anywhere an `std::ostream` is accepted (e.g., `SimpleIO::Exporter()`)
+// to write compressed output without a second pass over the data.
+//
+// The compressed data is only complete once `Finish()` has been called (the
+// destructor calls it if needed). `os` must outlive this stream.
+//
+// Example usage:
+//
+//   std::ofstream file("tests.txt.gz", std::ios::binary);
+//   GzipOutputStream gz(file);
+//   M.ExportTestCases(SimpleIO().AddLine("N").Exporter(gz));
+//   gz.Finish();
+class GzipOutputStream : public std::ostream {
+ public:
+  explicit GzipOutputStream(std::ostream& os);
+  ~GzipOutputStream() override;
+
+  GzipOutputStream(const GzipOutputStream&) = delete;
+  GzipOutputStream& operator=(const GzipOutputStream&) = delete;
+
+  // Finish()
+  //
+  // Compresses any buffered data and writes the end of the gzip stream to
+  // `os`. Nothing may be written afterwards. Sets `badbit` on failure. Calling
+  // this more than once has no effect.
+  void Finish();
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+// GzipInputStream
+//
+// An input stream that decompresses the gzip data read from `is`. Several
+// gzip streams one after another (as produced by `cat a.gz b.gz`) are read as
+// one. `is` must outlive this stream.
+class GzipInputStream : public std::istream {
+ public:
+  explicit GzipInputStream(std::istream& is);
+  ~GzipInputStream() override;
+
+  GzipInputStream(const GzipInputStream&) = delete;
+  GzipInputStream& operator=(const GzipInputStream&) = delete;
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+// IsGzipData()
+//
+// Returns true if `data` starts with the gzip magic bytes.
+[[nodiscard]] bool IsGzipData(const char* data, int size);
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_GZIP_STREAM_H_
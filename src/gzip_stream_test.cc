@@ -0,0 +1,95 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/gzip_stream.h"
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+
+namespace moriarty {
+namespace {
+
+std::string Compress(const std::string& data) {
+  std::stringstream compressed;
+  GzipOutputStream gzip(compressed);
+  gzip << data;
+  gzip.Finish();
+  EXPECT_TRUE(gzip.good());
+  return compressed.str();
+}
+
+std::string Decompress(const std::string& data) {
+  std::stringstream compressed(data);
+  GzipInputStream gzip(compressed);
+  std::stringstream decompressed;
+  decompressed << gzip.rdbuf();
+  return decompressed.str();
+}
+
+TEST(GzipStreamTest, RoundTripShouldGiveTheOriginalData) {
+  std::string data;
+  for (int i = 0; i < 100000; i++) absl::StrAppend(&data, i, " ");
+
+  std::string compressed = Compress(data);
+  EXPECT_TRUE(IsGzipData(compressed.data(), compressed.size()));
+  EXPECT_LT(compressed.size(), data.size());
+  EXPECT_EQ(Decompress(compressed), data);
+}
+
+TEST(GzipStreamTest, RoundTripOfEmptyDataShouldBeEmpty) {
+  EXPECT_EQ(Decompress(Compress("")), "");
+}
+
+TEST(GzipStreamTest, DestructorShouldFinishTheStream) {
+  std::stringstream compressed;
+  { GzipOutputStream(compressed) << "hello world\n"; }
+  EXPECT_EQ(Decompress(compressed.str()), "hello world\n");
+}
+
+TEST(GzipStreamTest, ConcatenatedStreamsShouldBeReadAsOne) {
+  EXPECT_EQ(Decompress(Compress("hello ") + Compress("world")), "hello world");
+}
+
+TEST(GzipStreamTest, ReadingTokensShouldWork) {
+  std::stringstream compressed(Compress("12 abc\nx"));
+  GzipInputStream gzip(compressed);
+  int n;
+  std::string s;
+  char c;
+  gzip >> n >> s >> c;
+  EXPECT_EQ(n, 12);
+  EXPECT_EQ(s, "abc");
+  EXPECT_EQ(c, 'x');
+  EXPECT_FALSE(gzip >> c);
+}
+
+TEST(GzipStreamTest, CorruptDataShouldEndTheInput) {
+  std::string compressed = Compress("hello world");
+  EXPECT_TRUE(absl::StartsWith(
+      "hello world", Decompress(compressed.substr(0, compressed.size() / 2))));
+  EXPECT_EQ(Decompress("not gzip data"), "");
+}
+
+TEST(GzipStreamTest, IsGzipDataShouldCheckTheMagicBytes) {
+  EXPECT_TRUE(IsGzipData("\x1f\x8b", 2));
+  EXPECT_FALSE(IsGzipData("\x1f", 1));
+  EXPECT_FALSE(IsGzipData("ab", 2));
+}
+
+}  // namespace
+}  // namespace moriarty
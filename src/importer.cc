@@ -22,6 +22,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/tracing.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
@@ -52,11 +53,14 @@ absl::Status Importer::ImportTestCasesWithKnownNumberOfCases() {
 
   metadata_.num_test_cases = *num_test_cases_;
   for (int tc = 1; tc <= *num_test_cases_; tc++) {
-    metadata_.test_case_number = tc;
+    metadata_.test_case_number = first_test_case_number_ + tc - 1;
     current_test_case_ = {};
     universe.SetMutableValueSet(&current_test_case_);
 
-    MORIARTY_RETURN_IF_ERROR(ImportTestCase());
+    {
+      MORIARTY_TRACE_SPAN("Importer::ImportTestCase");
+      MORIARTY_RETURN_IF_ERROR(ImportTestCase());
+    }
     test_cases_.push_back(std::move(current_test_case_));
 
     if (tc != num_test_cases_) {
@@ -80,11 +84,14 @@ absl::Status Importer::ImportTestCasesWithUnknownNumberOfCases() {
 
   metadata_.num_test_cases = 0;
   while (!IsDone()) {
-    metadata_.test_case_number = test_cases_.size() + 1;
+    metadata_.test_case_number = first_test_case_number_ + test_cases_.size();
     current_test_case_ = {};
     universe.SetMutableValueSet(&current_test_case_);
 
-    MORIARTY_RETURN_IF_ERROR(ImportTestCase());
+    {
+      MORIARTY_TRACE_SPAN("Importer::ImportTestCase");
+      MORIARTY_RETURN_IF_ERROR(ImportTestCase());
+    }
     if (IsDone()) break;
     test_cases_.push_back(std::move(current_test_case_));
 
@@ -102,6 +109,10 @@ void Importer::SetNumTestCases(int num_test_cases) {
   num_test_cases_ = num_test_cases;
 }
 
+void Importer::SetFirstTestCaseNumber(int first_test_case_number) {
+  first_test_case_number_ = first_test_case_number;
+}
+
 Importer::TestCaseMetadata Importer::GetTestCaseMetadata() const {
   return metadata_;
 }
@@ -119,6 +130,10 @@ std::vector<moriarty_internal::ValueSet> Importer::GetTestCases() const {
   return test_cases_;
 }
 
+std::vector<moriarty_internal::ValueSet> Importer::TakeTestCases() {
+  return std::exchange(test_cases_, {});
+}
+
 absl::StatusOr<moriarty_internal::AbstractVariable*>
 Importer::GetAbstractVariable(absl::string_view variable_name) {
   return general_constraints_.GetAbstractVariable(variable_name);
@@ -128,6 +143,14 @@ const moriarty_internal::ValueSet& Importer::GetCurrentTestCase() const {
   return current_test_case_;
 }
 
+void Importer::SetCurrentTestCase(moriarty_internal::ValueSet values) {
+  current_test_case_ = std::move(values);
+}
+
+const moriarty_internal::VariableSet& Importer::GetGeneralConstraints() const {
+  return general_constraints_;
+}
+
 librarian::IOConfig* Importer::GetIOConfig() { return io_config_; }
 
 namespace moriarty_internal {
@@ -143,6 +166,10 @@ std::vector<moriarty_internal::ValueSet> ImporterManager::GetTestCases() const {
   return managed_importer_.GetTestCases();
 }
 
+std::vector<moriarty_internal::ValueSet> ImporterManager::TakeTestCases() {
+  return managed_importer_.TakeTestCases();
+}
+
 absl::StatusOr<AbstractVariable*> ImporterManager::GetAbstractVariable(
     absl::string_view variable_name) {
   return managed_importer_.GetAbstractVariable(variable_name);
@@ -152,6 +179,14 @@ const ValueSet& ImporterManager::GetCurrentTestCase() const {
   return managed_importer_.GetCurrentTestCase();
 }
 
+void ImporterManager::SetCurrentTestCase(ValueSet values) {
+  managed_importer_.SetCurrentTestCase(std::move(values));
+}
+
+const VariableSet& ImporterManager::GetGeneralConstraints() const {
+  return managed_importer_.GetGeneralConstraints();
+}
+
 librarian::IOConfig* ImporterManager::GetIOConfig() {
   return managed_importer_.GetIOConfig();
 }
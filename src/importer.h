@@ -25,6 +25,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "src/internal/abstract_variable.h"
 #include "src/internal/analysis_bootstrap.h"
 #include "src/internal/value_set.h"
@@ -134,6 +135,15 @@ class Importer {
   // call this, you may not use `Done()`.
   void SetNumTestCases(int num_test_cases);
 
+  // SetFirstTestCaseNumber()
+  //
+  // Sets the `test_case_number` (see `GetTestCaseMetadata()`) of the first
+  // test case read, e.g., when reading only some of the test cases of a file,
+  // so they keep the numbers they have in that file. Default = 1. Should only
+  // be called from within `StartImport()`. `num_test_cases` is still the
+  // number of test cases read.
+  void SetFirstTestCaseNumber(int first_test_case_number);
+
   // SetValue()
   //
   // Sets the variable `variable_name` to a specific `value`. The MVariable of
@@ -180,6 +190,22 @@ class Importer {
   absl::Status SatisfiesConstraints(T constraints,
                                     const T::value_type& value) const;
 
+  // AllSatisfyConstraints()
+  //
+  // Checks if every value in `values` satisfies the constraints in
+  // `constraints`. Returns a non-ok status with the reason (and the index of
+  // the value) for the first one that does not. This is faster than calling
+  // `SatisfiesConstraints()` once per value. Example:
+  //
+  //   absl::Status s = AllSatisfyConstraints(MInteger().Between(1, "N"), A);
+  //
+  // This should only be called from within `ImportTestCase()`.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::Status AllSatisfyConstraints(
+      T constraints, absl::Span<const typename T::value_type> values) const;
+
   // SetIOConfig()
   //
   // Sets the internal IOConfig to be passed to all variables.
@@ -195,6 +221,7 @@ class Importer {
   moriarty_internal::VariableSet general_constraints_;
   TestCaseMetadata metadata_;
   std::optional<int> num_test_cases_;
+  int first_test_case_number_ = 1;
   bool done_ = false;
 
   librarian::IOConfig* io_config_ = nullptr;
@@ -218,11 +245,28 @@ class Importer {
   // Returns the list of test cases which have been set.
   std::vector<moriarty_internal::ValueSet> GetTestCases() const;
 
+  // TakeTestCases() [Internal Extended API]
+  //
+  // Same as `GetTestCases()`, but moves the test cases out of this importer
+  // instead of copying them. Afterwards, this importer has no test cases.
+  std::vector<moriarty_internal::ValueSet> TakeTestCases();
+
   // GetCurrentTestCase() [Internal Extended API]
   //
   // Returns the current test case.
   const moriarty_internal::ValueSet& GetCurrentTestCase() const;
 
+  // SetCurrentTestCase() [Internal Extended API]
+  //
+  // Replaces all values in the current test case with `values`. Should only be
+  // called from within `ImportTestCase()`.
+  void SetCurrentTestCase(moriarty_internal::ValueSet values);
+
+  // GetGeneralConstraints() [Internal Extended API]
+  //
+  // Returns the general constraints.
+  const moriarty_internal::VariableSet& GetGeneralConstraints() const;
+
   // GetIOConfig() [Internal Extended API]
   //
   // Returns the IOConfig if it has been set. `nullptr` otherwise.
@@ -272,9 +316,12 @@ class ImporterManager {
 
   void SetGeneralConstraints(VariableSet general_constraints);
   std::vector<moriarty_internal::ValueSet> GetTestCases() const;
+  std::vector<moriarty_internal::ValueSet> TakeTestCases();
   absl::StatusOr<AbstractVariable*> GetAbstractVariable(
       absl::string_view variable_name);
   const moriarty_internal::ValueSet& GetCurrentTestCase() const;
+  void SetCurrentTestCase(ValueSet values);
+  const VariableSet& GetGeneralConstraints() const;
   librarian::IOConfig* GetIOConfig();
 
  private:
@@ -289,7 +336,7 @@ class ImporterManager {
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 void Importer::SetValue(absl::string_view variable_name, T::value_type value) {
-  current_test_case_.Set<T>(variable_name, value);
+  current_test_case_.Set<T>(variable_name, std::move(value));
 }
 
 template <typename T>
@@ -303,6 +350,17 @@ absl::Status Importer::SatisfiesConstraints(T constraints,
       "Generator::SatisfiesConstraints");
 }
 
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::Status Importer::AllSatisfyConstraints(
+    T constraints, absl::Span<const typename T::value_type> values) const {
+  return moriarty_internal::ConstraintChecker<T>(
+             std::move(constraints), /* known_values = */ current_test_case_,
+             /* variables = */ general_constraints_,
+             "Importer::AllSatisfyConstraints")
+      .CheckAll(values);
+}
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_IMPORTER_H_
@@ -14,6 +14,7 @@
 
 #include "src/importer.h"
 
+#include <cstdint>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -50,6 +51,7 @@ class ProtectedImporter : public Importer {
         "Don't use ProtectedImporter for importing");
   }
 
+  using Importer::AllSatisfyConstraints;
   using Importer::Done;
   using Importer::GetTestCaseMetadata;
   using Importer::IsDone;
@@ -71,12 +73,16 @@ class ImporterMetadata : public Importer {
     kCallDoneInTestCaseDivider
   };
 
-  ImporterMetadata(ImportStyle import_style, int num_test_cases)
-      : import_style_(import_style), num_test_cases_(num_test_cases) {}
+  ImporterMetadata(ImportStyle import_style, int num_test_cases,
+                   int first_test_case_number = 1)
+      : import_style_(import_style),
+        num_test_cases_(num_test_cases),
+        first_test_case_number_(first_test_case_number) {}
 
   absl::Status StartImport() override {
     fn_calls_.push_back(Function::kStartImport);
 
+    SetFirstTestCaseNumber(first_test_case_number_);
     if (import_style_ == ImportStyle::kCallSetNumTestCases)
       SetNumTestCases(num_test_cases_);
     return absl::OkStatus();
@@ -145,6 +151,7 @@ class ImporterMetadata : public Importer {
  private:
   ImportStyle import_style_;
   int num_test_cases_;
+  int first_test_case_number_;
   int current_test_case_ = 1;
 
   std::vector<int> test_case_numbers_in_import_test_case_;
@@ -240,6 +247,24 @@ TEST(ImporterTest, TestCaseMetadataCorrectIfDoneIsCalledInTestCaseDivider) {
               ElementsAre(0, 0, 0, 0, 0, 0, 0));
 }
 
+TEST(ImporterTest, TestCaseMetadataStartsAtTheFirstTestCaseNumber) {
+  ImporterMetadata importer(ImporterMetadata::ImportStyle::kCallSetNumTestCases,
+                            3, 10);
+  MORIARTY_ASSERT_OK(importer.ImportTestCases());
+  EXPECT_THAT(importer.GetTestCaseNumbersInImportTestCase(),
+              ElementsAre(10, 11, 12));
+  EXPECT_THAT(importer.GetNumTestCasesInImportTestCase(),
+              ElementsAre(3, 3, 3));
+  EXPECT_THAT(importer.GetTestCaseNumbersInTestCaseDivider(),
+              ElementsAre(10, 11));
+
+  ImporterMetadata until_done(
+      ImporterMetadata::ImportStyle::kCallDoneInImportTestCase, 2, 4);
+  MORIARTY_ASSERT_OK(until_done.ImportTestCases());
+  EXPECT_THAT(until_done.GetTestCaseNumbersInImportTestCase(),
+              ElementsAre(4, 5));
+}
+
 TEST(ImporterTest, FunctionsCalledInAppropriateOrderForSetNumTestCases) {
   ImporterMetadata importer(ImporterMetadata::ImportStyle::kCallSetNumTestCases,
                             3);
@@ -345,6 +370,31 @@ TEST(ImporterTest, MultipleTestCasesSetsVariablesAppropriartely) {
   EXPECT_THAT(values[2].Get<MInteger>("X"), IsOkAndHolds(128));
 }
 
+TEST(ImporterTest, TakeTestCasesMovesTheTestCasesOutOfTheImporter) {
+  struct SimpleImporter : Importer {
+    absl::Status StartImport() override {
+      SetNumTestCases(2);
+      return absl::OkStatus();
+    }
+
+    absl::Status ImportTestCase() override {
+      SetValue<MInteger>("N", value++);
+      return absl::OkStatus();
+    }
+
+    int value = 5;
+  };
+  SimpleImporter importer;
+  MORIARTY_ASSERT_OK(importer.ImportTestCases());
+
+  std::vector<moriarty_internal::ValueSet> values =
+      moriarty_internal::ImporterManager(&importer).TakeTestCases();
+  ASSERT_THAT(values, SizeIs(2));
+  EXPECT_THAT(values[1].Get<MInteger>("N"), IsOkAndHolds(6));
+  EXPECT_THAT(moriarty_internal::ImporterManager(&importer).GetTestCases(),
+              IsEmpty());
+}
+
 TEST(ImporterTest, GetAbstractVariableCanAccessVariablesInGeneralConstraints) {
   ProtectedImporter importer;
   moriarty_internal::VariableSet variables;
@@ -406,5 +456,17 @@ TEST(ImporterTest, SatisfiesConstraintsUsesVariablesFromGeneralConstraints) {
               IsUnsatisfiedConstraint("range"));
 }
 
+TEST(ImporterTest, AllSatisfyConstraintsChecksEveryValue) {
+  ProtectedImporter I;
+  moriarty_internal::VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Is(10)));
+  moriarty_internal::ImporterManager(&I).SetGeneralConstraints(variables);
+  MORIARTY_EXPECT_OK(I.AllSatisfyConstraints(MInteger().Between(1, "N"),
+                                             std::vector<int64_t>{1, 5, 10}));
+  EXPECT_THAT(I.AllSatisfyConstraints(MInteger().Between(1, "N"),
+                                      std::vector<int64_t>{1, 11, 5}),
+              IsUnsatisfiedConstraint("range"));
+}
+
 }  // namespace
 }  // namespace moriarty
@@ -18,6 +18,7 @@
 #define MORIARTY_SRC_INTERNAL_ABSTRACT_VARIABLE_H_
 
 #include <any>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -27,12 +28,24 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "src/internal/range.h"
 #include "src/property.h"
 
 namespace moriarty {
 namespace moriarty_internal {
 
 class Universe;  // Forward declaring Universe
+class ValueSet;  // Forward declaring ValueSet
+
+// TypeIdOf<>
+//
+// Returns an identifier unique to `T`. Used to tag variables with their most
+// derived `MVariable` type so that conversions can skip `dynamic_cast`.
+template <typename T>
+const void* TypeIdOf() {
+  static constexpr char kId = 0;
+  return &kId;
+}
 
 // AbstractVariable
 //
@@ -52,18 +65,31 @@ class AbstractVariable {
   // Only derived classes should make copies of me directly to avoid accidental
   // slicing. Call derived class's constructors instead.
   AbstractVariable() = default;
+  explicit AbstractVariable(const void* type_id) : type_id_(type_id) {}
   AbstractVariable(const AbstractVariable&) = default;
   AbstractVariable(AbstractVariable&&) = default;
   AbstractVariable& operator=(const AbstractVariable&) = default;
   AbstractVariable& operator=(AbstractVariable&&) = default;
 
  public:
+  // TypeId()
+  //
+  // Returns `TypeIdOf<V>()`, where `V` is the `MVariable<V, ...>` this variable
+  // was constructed as (or `nullptr` if unknown). If this matches
+  // `TypeIdOf<T>()`, then this variable is a `T` (or derived from one).
+  const void* TypeId() const { return type_id_; }
+
   // Typename() [pure virtual]
   //
   // Returns a string representing the name of this type (for example,
   // "MInteger"). This is mostly used for debugging/error messages.
   virtual std::string Typename() const = 0;
 
+  // ToString() [pure virtual]
+  //
+  // Returns a string representation of the constraints on this variable.
+  virtual std::string ToString() const = 0;
+
   // Clone() [pure virtual]
   //
   // Create a copy and return a pointer to the newly created object. Ownership
@@ -114,6 +140,33 @@ class AbstractVariable {
   // unique value is 7.
   virtual std::optional<std::any> GetUniqueValueUntyped() const = 0;
 
+  // IsKnownUnsatisfiable() [pure virtual]
+  //
+  // Cheaply determines if no value can satisfy the constraints on this
+  // variable, using only values already known in its universe. Nothing is
+  // generated. Returning `false` does not guarantee there is a valid value,
+  // just that it is too hard to determine that there is not.
+  //
+  // Example: MInteger().Between(1, "N") is known to be unsatisfiable if N = 0
+  // is known.
+  virtual bool IsKnownUnsatisfiable() const = 0;
+
+  // GetIntegerBounds() [pure virtual]
+  //
+  // Returns the bounds on this variable if it is an integer, and `nullptr`
+  // otherwise. The pointer is invalidated by any change to this variable.
+  //
+  // Example: MInteger().Between(1, "N") returns the range [1, N].
+  virtual const Range* GetIntegerBounds() const = 0;
+
+  // TightenIntegerBounds() [pure virtual]
+  //
+  // Restricts this integer variable to `bounds`. Does nothing if this variable
+  // is not an integer. Only call this with bounds that every valid value is
+  // already known to satisfy (see `PropagateIntegerBounds()`), so that the
+  // values that are valid do not change.
+  virtual void TightenIntegerBounds(const Range& bounds) = 0;
+
   // ReadValue() [pure virtual]
   //
   // Given all current I/O constraints on this variable, read a value from the
@@ -189,6 +242,36 @@ class AbstractVariable {
   // element).
   virtual absl::StatusOr<std::any> GetSubvalue(
       const std::any& my_value, absl::string_view subvalue_name) const = 0;
+
+  // EncodeValue() [pure virtual]
+  //
+  // Appends the binary encoding of the value of `variable_name` in `values` to
+  // `out`. Returns kUnimplemented if this variable's type cannot be encoded.
+  virtual absl::Status EncodeValue(const ValueSet& values,
+                                   absl::string_view variable_name,
+                                   std::string& out) const = 0;
+
+  // DecodeValue() [pure virtual]
+  //
+  // Decodes a value encoded by `EncodeValue()` from the front of `in`, removes
+  // it from `in` and stores it in `values` under `variable_name`.
+  virtual absl::Status DecodeValue(absl::string_view& in,
+                                   absl::string_view variable_name,
+                                   ValueSet& values) const = 0;
+
+  // ShrinkValue() [pure virtual]
+  //
+  // Replaces the value of `variable_name` in `values` with its `index`-th
+  // smaller version at `level` (see `MVariable::ShrinkImpl()`). Returns the
+  // number of elements the value lost (0 for values without elements, such as
+  // integers), or `std::nullopt` if there is no such version. In that case,
+  // the value is unchanged.
+  virtual absl::StatusOr<std::optional<int64_t>> ShrinkValue(
+      ValueSet& values, absl::string_view variable_name, int level,
+      int64_t index) const = 0;
+
+ private:
+  const void* type_id_ = nullptr;
 };
 
 // A simple pair of name and variable.
@@ -215,7 +298,9 @@ namespace moriarty_internal {
 //  kInvalidArgument if it is not convertible.
 template <typename Type>
 absl::StatusOr<Type> ConvertTo(AbstractVariable* var, absl::string_view name) {
-  Type* typed_var = dynamic_cast<Type*>(var);
+  Type* typed_var = var->TypeId() == TypeIdOf<Type>()
+                        ? static_cast<Type*>(var)
+                        : dynamic_cast<Type*>(var);
   if (typed_var == nullptr)
     return absl::InvalidArgumentError(
         absl::Substitute("Unable to convert `$0` from $1 to $2", name,
@@ -223,6 +308,23 @@ absl::StatusOr<Type> ConvertTo(AbstractVariable* var, absl::string_view name) {
   return *typed_var;
 }
 
+// ConvertToPointer<>
+//
+//  Same as `ConvertTo<>`, but returns a pointer to `var` itself instead of a
+//  copy. Returns kInvalidArgument if it is not convertible.
+template <typename Type>
+absl::StatusOr<const Type*> ConvertToPointer(const AbstractVariable* var,
+                                             absl::string_view name) {
+  const Type* typed_var = var->TypeId() == TypeIdOf<Type>()
+                              ? static_cast<const Type*>(var)
+                              : dynamic_cast<const Type*>(var);
+  if (typed_var == nullptr)
+    return absl::InvalidArgumentError(
+        absl::Substitute("Unable to convert `$0` from $1 to $2", name,
+                         var->Typename(), Type().Typename()));
+  return typed_var;
+}
+
 // ConvertTo<>
 //
 //  Converts an AbstractVariable to some derived variable type. Returns
@@ -230,12 +332,9 @@ absl::StatusOr<Type> ConvertTo(AbstractVariable* var, absl::string_view name) {
 template <typename Type>
 absl::StatusOr<Type> ConvertTo(const AbstractVariable* var,
                                absl::string_view name) {
-  const Type* typed_var = dynamic_cast<const Type*>(var);
-  if (typed_var == nullptr)
-    return absl::InvalidArgumentError(
-        absl::Substitute("Unable to convert `$0` from $1 to $2", name,
-                         var->Typename(), Type().Typename()));
-  return *typed_var;
+  absl::StatusOr<const Type*> typed_var = ConvertToPointer<Type>(var, name);
+  if (!typed_var.ok()) return typed_var.status();
+  return **typed_var;
 }
 
 }  // namespace moriarty_internal
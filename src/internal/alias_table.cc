@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/alias_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+absl::StatusOr<AliasTable> AliasTable::Create(
+    absl::Span<const int64_t> weights) {
+  int64_t total = 0;
+  for (size_t i = 0; i < weights.size(); i++) {
+    if (weights[i] < 0) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "Weights must be non-negative, but weight $0 is $1", i, weights[i]));
+    }
+    if (weights[i] > std::numeric_limits<int64_t>::max() - total) {
+      return absl::InvalidArgumentError("Total weight must fit in an int64_t");
+    }
+    total += weights[i];
+  }
+  if (total == 0) {
+    return absl::InvalidArgumentError("Total weight must be positive");
+  }
+
+  const int64_t n = weights.size();
+  AliasTable table;
+  table.total_weight_ = total;
+  table.single_draw_ = absl::int128(n) * total <=
+                       std::numeric_limits<int64_t>::max();
+  table.threshold_.assign(n, total);
+  table.alias_.resize(n);
+  for (int64_t i = 0; i < n; i++) table.alias_[i] = i;
+
+  // Each column holds `total` units of probability. With the weights scaled
+  // by n, columns with less than `total` are topped up from one with more.
+  std::vector<absl::int128> scaled(n);
+  std::vector<int64_t> small, large;
+  for (int64_t i = 0; i < n; i++) {
+    scaled[i] = absl::int128(weights[i]) * n;
+    (scaled[i] < total ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    int64_t s = small.back();
+    small.pop_back();
+    int64_t l = large.back();
+    table.threshold_[s] = static_cast<int64_t>(scaled[s]);
+    table.alias_[s] = l;
+    scaled[l] -= total - scaled[s];
+    if (scaled[l] < total) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // The arithmetic is exact, so every remaining column is exactly full.
+  return table;
+}
+
+absl::StatusOr<int64_t> AliasTable::Sample(RandomEngine& rng) const {
+  absl::Status status;
+  int64_t index = Sample(rng, status);
+  MORIARTY_RETURN_IF_ERROR(status);
+  return index;
+}
+
+int64_t AliasTable::Sample(RandomEngine& rng, absl::Status& status) const {
+  const int64_t n = threshold_.size();
+  int64_t column, coin;
+  if (single_draw_) {
+    int64_t r = rng.RandInt(n * total_weight_, status);
+    column = r / total_weight_;
+    coin = r % total_weight_;
+  } else {
+    column = rng.RandInt(n, status);
+    coin = rng.RandInt(total_weight_, status);
+  }
+  return coin < threshold_[column] ? column : alias_[column];
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_ALIAS_TABLE_H_
+#define MORIARTY_SRC_INTERNAL_ALIAS_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// AliasTable
+//
+// Samples an index i with probability weights[i] / (sum of weights) in O(1)
+// time, after O(n) preprocessing (Vose's alias method).
+//
+// The weights are integers and the table is built with exact integer
+// arithmetic, so the probabilities are exact and the table (and the values
+// it samples) do not depend on the platform. Each sample uses the
+// RandomEngine the same way: one `RandInt()` call if n * (total weight) fits in
+// an int64_t, and two otherwise.
+class AliasTable {
+ public:
+  // Create()
+  //
+  // Builds the table for `weights`. Returns kInvalidArgument if a weight is
+  // negative, or the total weight is 0 or does not fit in an int64_t.
+  static absl::StatusOr<AliasTable> Create(absl::Span<const int64_t> weights);
+
+  // Sample()
+  //
+  // Returns a random index, picked with probability proportional to its
+  // weight.
+  absl::StatusOr<int64_t> Sample(RandomEngine& rng) const;
+
+  // Sample()
+  //
+  // Same as above, but errors are stored in `status` instead (useful in tight
+  // loops). `status` is only set if it is OK.
+  int64_t Sample(RandomEngine& rng, absl::Status& status) const;
+
+  // size()
+  //
+  // Returns the number of weights.
+  [[nodiscard]] size_t size() const { return threshold_.size(); }
+
+ private:
+  AliasTable() = default;
+
+  int64_t total_weight_ = 0;
+  // If n * total_weight_ fits in an int64_t, both parts of a sample come from
+  // a single random value in [0, n * total_weight_).
+  bool single_draw_ = false;
+  // Column i is picked uniformly, then it is i if a uniform value in
+  // [0, total_weight_) is less than threshold_[i], and alias_[i] otherwise.
+  std::vector<int64_t> threshold_;
+  std::vector<int64_t> alias_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_ALIAS_TABLE_H_
@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/alias_table.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/internal/random_engine.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::Ge;
+using ::testing::Le;
+using ::moriarty::StatusIs;
+
+// Returns how many times each index is sampled from `table` in `n` samples.
+std::vector<int> CountSamples(const AliasTable& table, int n) {
+  RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+  std::vector<int> counts(table.size());
+  absl::Status status;
+  for (int i = 0; i < n; i++) counts[table.Sample(rng, status)]++;
+  EXPECT_TRUE(status.ok());
+  return counts;
+}
+
+TEST(AliasTableTest, SampleShouldFollowTheWeights) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(AliasTable table,
+                                AliasTable::Create({1, 0, 3, 6}));
+  std::vector<int> counts = CountSamples(table, 100000);
+  EXPECT_EQ(counts[1], 0);
+  EXPECT_NEAR(counts[0], 10000, 1000);
+  EXPECT_NEAR(counts[2], 30000, 1500);
+  EXPECT_NEAR(counts[3], 60000, 1500);
+}
+
+TEST(AliasTableTest, EqualWeightsShouldBeUniform) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      AliasTable table, AliasTable::Create(std::vector<int64_t>(10, 7)));
+  EXPECT_THAT(CountSamples(table, 100000), Each(AllOf(Ge(9000), Le(11000))));
+}
+
+TEST(AliasTableTest, ASingleNonZeroWeightShouldAlwaysBePicked) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(AliasTable table,
+                                AliasTable::Create({0, 0, 5, 0}));
+  std::vector<int> counts = CountSamples(table, 1000);
+  EXPECT_EQ(counts[2], 1000);
+}
+
+TEST(AliasTableTest, HugeWeightsShouldWork) {
+  constexpr int64_t kHuge = std::numeric_limits<int64_t>::max() / 4;
+  MORIARTY_ASSERT_OK_AND_ASSIGN(AliasTable table,
+                                AliasTable::Create({kHuge, 1, 3 * kHuge}));
+  std::vector<int> counts = CountSamples(table, 10000);
+  EXPECT_EQ(counts[1], 0);
+  EXPECT_NEAR(counts[0], 2500, 400);
+  EXPECT_NEAR(counts[2], 7500, 400);
+}
+
+TEST(AliasTableTest, SampleShouldBeTheSameForTheSameSeed) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(AliasTable table,
+                                AliasTable::Create({5, 1, 2, 8, 3}));
+  RandomEngine rng1({4, 5, 6}, kCounterBasedVersion);
+  RandomEngine rng2({4, 5, 6}, kCounterBasedVersion);
+  for (int i = 0; i < 100; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t a, table.Sample(rng1));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t b, table.Sample(rng2));
+    EXPECT_EQ(a, b);
+  }
+}
+
+TEST(AliasTableTest, CreateShouldRejectInvalidWeights) {
+  EXPECT_THAT(AliasTable::Create({}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(AliasTable::Create({0, 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(AliasTable::Create({1, -1, 2}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(AliasTable::Create({std::numeric_limits<int64_t>::max(), 1}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -18,9 +18,13 @@
 #define MORIARTY_SRC_INTERNAL_ANALYSIS_BOOTSTRAP_H_
 
 #include <concepts>
+#include <memory>
+#include <utility>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
@@ -29,6 +33,42 @@
 namespace moriarty {
 namespace moriarty_internal {
 
+// ConstraintChecker
+//
+// Checks values against `constraints`, in the same way as
+// `SatisfiesConstraints()`, but the universe is only set up once. Prefer this
+// over calling `SatisfiesConstraints()` repeatedly with the same constraints
+// (e.g., once per element of an array).
+//
+// `known_values` and `variables` must outlive this object.
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+class ConstraintChecker {
+ public:
+  explicit ConstraintChecker(T constraints, const ValueSet& known_values,
+                             const VariableSet& variables,
+                             absl::string_view name = "constraints");
+
+  // Check()
+  //
+  // Returns an error with the reason if `value` does not satisfy the
+  // constraints.
+  absl::Status Check(const typename T::value_type& value);
+
+  // CheckAll()
+  //
+  // Returns an error with the reason (and the 0-based index of the value) for
+  // the first value in `values` that does not satisfy the constraints. Simple
+  // constraints may check all values at once, instead of one at a time.
+  absl::Status CheckAll(absl::Span<const typename T::value_type> values);
+
+ private:
+  // In its own allocation, so that `constraints_` can point to it even after
+  // this object is moved.
+  std::unique_ptr<Universe> universe_;
+  T constraints_;
+};
+
 // SatisfiesConstraints()
 //
 // Determines if `value` satisfies the constraints defined by `constraints`.
@@ -47,6 +87,42 @@ absl::Status SatisfiesConstraints(T constraints,
 // -----------------------------------------------------------------------------
 //  Template implementation below
 
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+ConstraintChecker<T>::ConstraintChecker(T constraints,
+                                        const ValueSet& known_values,
+                                        const VariableSet& variables,
+                                        absl::string_view name)
+    : universe_(std::make_unique<Universe>()),
+      constraints_(std::move(constraints)) {
+  universe_->SetConstValueSet(&known_values).SetConstVariableSet(&variables);
+  MVariableManager(&constraints_).SetUniverse(universe_.get(), name);
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::Status ConstraintChecker<T>::Check(const typename T::value_type& value) {
+  return MVariableManager(&constraints_).IsSatisfiedWith(value);
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::Status ConstraintChecker<T>::CheckAll(
+    absl::Span<const typename T::value_type> values) {
+  MVariableManager manager(&constraints_);
+  if (manager.AllSatisfiedWith(values)) return absl::OkStatus();
+
+  for (int i = 0; i < values.size(); i++) {
+    absl::Status status = manager.IsSatisfiedWith(values[i]);
+    if (!status.ok()) {
+      return absl::Status(status.code(),
+                          absl::Substitute("value $0 (0-based): $1", i,
+                                           status.message()));
+    }
+  }
+  return absl::OkStatus();
+}
+
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 absl::Status SatisfiesConstraints(T constraints,
@@ -54,12 +130,9 @@ absl::Status SatisfiesConstraints(T constraints,
                                   const ValueSet& known_values,
                                   const VariableSet& variables,
                                   absl::string_view name) {
-  Universe universe = Universe()
-                          .SetConstValueSet(&known_values)
-                          .SetConstVariableSet(&variables);
-  MVariableManager(&constraints).SetUniverse(&universe, name);
-
-  return MVariableManager(&constraints).IsSatisfiedWith(value);
+  return ConstraintChecker<T>(std::move(constraints), known_values, variables,
+                              name)
+      .Check(value);
 }
 
 }  // namespace moriarty_internal
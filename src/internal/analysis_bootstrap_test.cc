@@ -15,6 +15,8 @@
 #include "src/internal/analysis_bootstrap.h"
 
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -75,6 +77,60 @@ TEST(AnalyzeBootstrapTest, SatisfiesConstraintsUsesUniqueValuesFromVariables) {
       StatusIs(absl::StatusCode::kFailedPrecondition));
 }
 
+TEST(AnalyzeBootstrapTest, ConstraintCheckerCanCheckManyValues) {
+  ValueSet values;
+  values.Set<MInteger>("N", int64_t{10});
+  VariableSet variables;
+  ConstraintChecker<MInteger> checker(MInteger().Between(1, "N"), values,
+                                      variables);
+
+  MORIARTY_EXPECT_OK(checker.Check(1));
+  MORIARTY_EXPECT_OK(checker.Check(10));
+  EXPECT_THAT(checker.Check(0),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(checker.Check(11),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(AnalyzeBootstrapTest, ConstraintCheckerCheckAllWorks) {
+  ValueSet values;
+  values.Set<MInteger>("N", int64_t{10});
+  VariableSet variables;
+  ConstraintChecker<MInteger> checker(MInteger().Between(1, "N"), values,
+                                      variables);
+
+  MORIARTY_EXPECT_OK(checker.CheckAll(std::vector<int64_t>{1, 5, 10}));
+  MORIARTY_EXPECT_OK(checker.CheckAll(std::vector<int64_t>{}));
+  EXPECT_THAT(checker.CheckAll(std::vector<int64_t>{1, 5, 11, 0}),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("value 2")));
+}
+
+TEST(AnalyzeBootstrapTest, ConstraintCheckerCheckAllWorksWithCustomConstraints) {
+  ValueSet values;
+  VariableSet variables;
+  ConstraintChecker<MInteger> checker(
+      MInteger().Between(1, 10).AddCustomConstraint(
+          "Even", [](int64_t x) { return x % 2 == 0; }),
+      values, variables);
+
+  MORIARTY_EXPECT_OK(checker.CheckAll(std::vector<int64_t>{2, 4, 10}));
+  EXPECT_THAT(checker.CheckAll(std::vector<int64_t>{2, 3}),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("value 1")));
+}
+
+TEST(AnalyzeBootstrapTest, ConstraintCheckerCanBeMoved) {
+  ValueSet values;
+  VariableSet variables;
+  ConstraintChecker<MInteger> checker(MInteger().Between(1, 10), values,
+                                      variables);
+  ConstraintChecker<MInteger> moved = std::move(checker);
+
+  MORIARTY_EXPECT_OK(moved.Check(5));
+  EXPECT_THAT(moved.Check(11), StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 }  // namespace
 }  // namespace moriarty_internal
 }  // namespace moriarty
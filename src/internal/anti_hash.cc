@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/anti_hash.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/internal/random_engine.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// The number of random windows tried for each size of tree.
+constexpr int kTreeAttackTries = 8;
+
+int64_t MulMod(int64_t a, int64_t b, int64_t modulus) {
+  return static_cast<__int128>(a) * b % modulus;
+}
+
+// A node in the tree attack. Its value is the value of `plus` minus the value
+// of `minus`, or the weight of `position` for leaves.
+struct TreeNode {
+  int64_t value;
+  int plus = -1;
+  int minus = -1;
+  int64_t position = -1;
+};
+
+// Sets `signs[p]` for each leaf `p` under `nodes[index]`, so that the sum of
+// sign times weight is the node's value (times `sign`).
+void AssignSigns(const std::vector<TreeNode>& nodes, int index, int sign,
+                 std::vector<int>& signs) {
+  const TreeNode& node = nodes[index];
+  if (node.plus == -1) {
+    signs[node.position] = sign;
+    return;
+  }
+  AssignSigns(nodes, node.plus, sign, signs);
+  AssignSigns(nodes, node.minus, -sign, signs);
+}
+
+// Runs the tree attack on the weights of positions [start, start + 2^k).
+// Returns the signs (-1, 0 or 1) of each position of a combination that sums
+// to 0 modulo the modulus.
+std::optional<std::vector<int>> TreeAttack(
+    const std::vector<int64_t>& weights, int64_t start, int k) {
+  const int64_t n = int64_t{1} << k;
+  std::vector<TreeNode> nodes;
+  nodes.reserve(2 * n);
+  std::vector<int> level;
+  for (int64_t i = 0; i < n; i++) {
+    level.push_back(nodes.size());
+    nodes.push_back({.value = weights[start + i], .position = start + i});
+  }
+
+  std::optional<int> zero;
+  auto add_node = [&](int plus, int minus) {
+    int index = nodes.size();
+    nodes.push_back({.value = nodes[plus].value - nodes[minus].value,
+                     .plus = plus,
+                     .minus = minus});
+    if (nodes.back().value == 0) zero = index;
+    return index;
+  };
+
+  while (true) {
+    for (int index : level) {
+      if (nodes[index].value == 0) zero = index;
+    }
+    if (zero || level.size() < 2) break;
+    std::sort(level.begin(), level.end(), [&nodes](int a, int b) {
+      return nodes[a].value < nodes[b].value;
+    });
+    // Two equal values anywhere in the level are a collision.
+    for (int i = 0; i + 1 < level.size() && !zero; i++) {
+      if (nodes[level[i]].value == nodes[level[i + 1]].value)
+        add_node(level[i + 1], level[i]);
+    }
+    if (zero) break;
+    std::vector<int> next_level;
+    for (int i = 0; i + 1 < level.size(); i += 2)
+      next_level.push_back(add_node(level[i + 1], level[i]));
+    level = std::move(next_level);
+  }
+  if (!zero) return std::nullopt;
+
+  std::vector<int> signs(weights.size(), 0);
+  AssignSigns(nodes, *zero, 1, signs);
+  return signs;
+}
+
+// The bucket counts that libstdc++'s hash tables grow through (with the
+// default maximum load factor of 1).
+constexpr int64_t kUnorderedMapBucketCounts[] = {
+    13,       29,       59,        127,      257,      541,
+    1109,     2357,     5087,      10273,    20753,    42043,
+    85229,    172933,   351061,    712697,   1447153,  2938679,
+    5967347,  12117689, 24607243,  49969847, 101473717, 206062531};
+
+}  // namespace
+
+std::string ThueMorseString(int64_t length, char zero, char one) {
+  std::string result(length, zero);
+  for (int64_t i = 0; i < length; i++) {
+    if (std::popcount(static_cast<uint64_t>(i)) % 2 == 1) result[i] = one;
+  }
+  return result;
+}
+
+int64_t PolynomialHash(const std::string& str, int64_t base, int64_t modulus) {
+  int64_t hash = 0;
+  for (char c : str) {
+    hash = (MulMod(hash, base, modulus) + static_cast<unsigned char>(c)) %
+           modulus;
+  }
+  return hash;
+}
+
+absl::StatusOr<std::pair<std::string, std::string>> FindPolynomialHashCollision(
+    int64_t base, int64_t modulus, int64_t length, char low, char high,
+    RandomEngine& random_engine) {
+  if (modulus <= 0) {
+    return absl::InvalidArgumentError("The modulus must be positive.");
+  }
+  if (low == high) {
+    return absl::InvalidArgumentError(
+        "Two different characters are needed for a hash collision.");
+  }
+
+  // The weight of position i is base^(length - 1 - i).
+  std::vector<int64_t> weights(std::max<int64_t>(length, 0));
+  int64_t power = 1 % modulus;
+  int64_t reduced_base = (base % modulus + modulus) % modulus;
+  for (int64_t i = length - 1; i >= 0; i--) {
+    weights[i] = power;
+    power = MulMod(power, reduced_base, modulus);
+  }
+
+  for (int k = 0; (int64_t{1} << k) <= length; k++) {
+    const int64_t window = int64_t{1} << k;
+    for (int tries = 0; tries < kTreeAttackTries; tries++) {
+      MORIARTY_ASSIGN_OR_RETURN(int64_t start,
+                                random_engine.RandInt(length - window + 1));
+      std::optional<std::vector<int>> signs = TreeAttack(weights, start, k);
+      if (!signs) continue;
+
+      std::pair<std::string, std::string> result = {std::string(length, low),
+                                                    std::string(length, low)};
+      for (int64_t i = 0; i < length; i++) {
+        if ((*signs)[i] == 1) result.first[i] = high;
+        if ((*signs)[i] == -1) result.second[i] = high;
+      }
+      return result;
+    }
+  }
+  return absl::NotFoundError(
+      "Could not find a hash collision. Try a longer string.");
+}
+
+int64_t UnorderedMapBucketCount(int64_t num_elements) {
+  for (int64_t bucket_count : kUnorderedMapBucketCounts) {
+    if (bucket_count >= num_elements) return bucket_count;
+  }
+  return std::end(kUnorderedMapBucketCounts)[-1];
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_ANTI_HASH_H_
+#define MORIARTY_SRC_INTERNAL_ANTI_HASH_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// ThueMorseString()
+//
+// Returns the first `length` characters of the Thue-Morse sequence, with
+// `zero` and `one` as its two characters. The prefixes of length 2^k (for k at
+// least 11 or so) and their complements have the same polynomial hash modulo
+// 2^64, for every base.
+std::string ThueMorseString(int64_t length, char zero, char one);
+
+// PolynomialHash()
+//
+// Returns s[0] * base^(n-1) + s[1] * base^(n-2) + ... + s[n-1] modulo
+// `modulus`, where n is the length of `str`. `modulus` must be positive.
+int64_t PolynomialHash(const std::string& str, int64_t base, int64_t modulus);
+
+// FindPolynomialHashCollision()
+//
+// Returns two distinct strings of length `length`, made of the characters
+// `low` and `high`, that have the same `PolynomialHash()` for `base` and
+// `modulus`.
+//
+// Uses the tree attack: the weights base^i are repeatedly sorted and paired up
+// by their differences until a difference is 0. It needs a length of about
+// 2^sqrt(2 * log2(modulus)) (e.g., 512 for 10^9 + 7 and 4096 for 2^61 - 1), and
+// tries several random windows of the string. Returns `kNotFound` if no
+// collision was found.
+absl::StatusOr<std::pair<std::string, std::string>> FindPolynomialHashCollision(
+    int64_t base, int64_t modulus, int64_t length, char low, char high,
+    RandomEngine& random_engine);
+
+// UnorderedMapBucketCount()
+//
+// Returns the number of buckets that a libstdc++ `std::unordered_map` (or
+// `std::unordered_set`) has after `num_elements` (at least 1) elements are
+// inserted into it, without calling `reserve()`. Integers that are multiples
+// of this are all put in the same bucket.
+int64_t UnorderedMapBucketCount(int64_t num_elements);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_ANTI_HASH_H_
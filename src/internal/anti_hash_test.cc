@@ -0,0 +1,98 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/anti_hash.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/internal/random_engine.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::moriarty::StatusIs;
+using ::testing::Ne;
+using ::testing::SizeIs;
+
+TEST(AntiHashTest, ThueMorseStringShouldBeTheThueMorseSequence) {
+  EXPECT_EQ(ThueMorseString(16, 'a', 'b'), "abbabaabbaababba");
+  EXPECT_EQ(ThueMorseString(0, 'a', 'b'), "");
+}
+
+TEST(AntiHashTest, ThueMorseStringsShouldCollideModulo2To64) {
+  // With an odd base, uint64_t overflow hashing is a hash modulo 2^64.
+  std::string s = ThueMorseString(1 << 11, 'a', 'b');
+  std::string t = ThueMorseString(1 << 11, 'b', 'a');
+  for (uint64_t base : {31ULL, 131ULL, 1000003ULL, 0x9E3779B97F4A7C15ULL}) {
+    uint64_t hash_s = 0, hash_t = 0;
+    for (char c : s) hash_s = hash_s * base + c;
+    for (char c : t) hash_t = hash_t * base + c;
+    EXPECT_EQ(hash_s, hash_t) << base;
+  }
+}
+
+TEST(AntiHashTest, PolynomialHashShouldWork) {
+  EXPECT_EQ(PolynomialHash("ab", 10, 1000), (97 * 10 + 98) % 1000);
+  EXPECT_EQ(PolynomialHash("", 10, 1000), 0);
+}
+
+TEST(AntiHashTest, FindPolynomialHashCollisionShouldFindACollision) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (auto [base, modulus, length] :
+       {std::tuple<int64_t, int64_t, int64_t>{131, 1'000'000'007, 1024},
+        {31, 998'244'353, 1000},
+        {1'000'003, (int64_t{1} << 61) - 1, 10000}}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        (std::pair<std::string, std::string> collision),
+        FindPolynomialHashCollision(base, modulus, length, 'a', 'z', engine));
+    EXPECT_THAT(collision.first, SizeIs(length));
+    EXPECT_THAT(collision.second, SizeIs(length));
+    EXPECT_THAT(collision.first, Ne(collision.second));
+    EXPECT_EQ(PolynomialHash(collision.first, base, modulus),
+              PolynomialHash(collision.second, base, modulus));
+  }
+}
+
+TEST(AntiHashTest, FindPolynomialHashCollisionOnShortStringsShouldFail) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  EXPECT_THAT(FindPolynomialHashCollision(131, (int64_t{1} << 61) - 1, 10, 'a',
+                                          'b', engine),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(
+      FindPolynomialHashCollision(131, 1'000'000'007, 1000, 'a', 'a', engine),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(AntiHashTest, UnorderedMapBucketCountShouldMatchTheStandardLibrary) {
+  // This test only checks something on libstdc++.
+#ifdef __GLIBCXX__
+  std::unordered_set<int64_t> set;
+  for (int64_t i = 1; i <= 100000; i++) {
+    set.insert(i);
+    ASSERT_EQ(set.bucket_count(), UnorderedMapBucketCount(i)) << i;
+  }
+#endif
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
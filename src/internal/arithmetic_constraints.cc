@@ -0,0 +1,473 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/arithmetic_constraints.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/internal/integer_distributions.h"
+#include "src/internal/random_engine.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// Primes in large ranges are found by scanning from a random point. In ranges
+// with at most this many candidates, all primes are found instead, so they can
+// be picked exactly according to the distribution.
+constexpr uint64_t kMaxEnumeratedPrimeCandidates = 4096;
+
+// Returns `a mod m` in [0, m). `m` must be positive.
+int64_t Mod(absl::int128 a, int64_t m) {
+  absl::int128 r = a % m;
+  return static_cast<int64_t>(r < 0 ? r + m : r);
+}
+
+// Returns floor(a / m). `m` must be positive.
+absl::int128 FloorDiv(absl::int128 a, int64_t m) {
+  return a >= 0 ? a / m : -((-a + m - 1) / m);
+}
+
+// Returns the inverse of `a` mod `m`. `a` and `m` must be coprime.
+int64_t ModInverse(int64_t a, int64_t m) {
+  // Extended Euclidean algorithm, tracking only the coefficient of `a`.
+  absl::int128 old_r = a, r = m;
+  absl::int128 old_s = 1, s = 0;
+  while (r != 0) {
+    absl::int128 q = old_r / r;
+    old_r = std::exchange(r, old_r - q * r);
+    old_s = std::exchange(s, old_s - q * s);
+  }
+  return Mod(old_s, m);
+}
+
+uint64_t MulMod(uint64_t a, uint64_t b, uint64_t m) {
+  return static_cast<uint64_t>(absl::uint128(a) * b % m);
+}
+
+uint64_t PowMod(uint64_t base, uint64_t exponent, uint64_t m) {
+  uint64_t result = 1;
+  base %= m;
+  for (; exponent > 0; exponent >>= 1) {
+    if (exponent & 1) result = MulMod(result, base, m);
+    base = MulMod(base, base, m);
+  }
+  return result;
+}
+
+// The primes below 1000, used to sieve out most composites before the
+// (comparatively slow) Miller-Rabin test.
+const std::vector<int64_t>& SmallPrimes() {
+  static const std::vector<int64_t>* primes = [] {
+    constexpr int kLimit = 1000;
+    std::vector<bool> composite(kLimit);
+    auto* primes = new std::vector<int64_t>();
+    for (int p = 2; p < kLimit; p++) {
+      if (composite[p]) continue;
+      primes->push_back(p);
+      for (int q = p * p; q < kLimit; q += p) composite[q] = true;
+    }
+    return primes;
+  }();
+  return *primes;
+}
+
+// The values in [min, max] that are `remainder` mod `modulus`. That is,
+// `first`, `first + modulus`, ..., `first + last_index * modulus`.
+struct Progression {
+  absl::int128 first;
+  uint64_t last_index;
+  int64_t modulus;
+
+  int64_t ValueAt(absl::int128 index) const {
+    return static_cast<int64_t>(first + index * modulus);
+  }
+  // The first index whose value is at least `x`.
+  absl::int128 FirstIndexAt(int64_t x) const {
+    return -FloorDiv(first - x, modulus);
+  }
+  // The last index whose value is at most `x`.
+  absl::int128 LastIndexAt(int64_t x) const {
+    return FloorDiv(x - first, modulus);
+  }
+};
+
+// Returns the progression, or `std::nullopt` if no value in [min, max] is
+// `remainder` mod `modulus`.
+std::optional<Progression> MakeProgression(int64_t min, int64_t max,
+                                           int64_t modulus, int64_t remainder) {
+  if (min > max) return std::nullopt;
+  absl::int128 first =
+      absl::int128(min) + Mod(absl::int128(remainder) - min, modulus);
+  if (first > max) return std::nullopt;
+  return Progression{
+      .first = first,
+      .last_index =
+          static_cast<uint64_t>((absl::int128(max) - first) / modulus),
+      .modulus = modulus};
+}
+
+// Returns the first (or last, if `backwards`) index in [lo, hi] of `p` whose
+// value is prime and not in `excluded`. The progression's remainder must be
+// coprime to its modulus.
+//
+// The indices are processed in blocks. In each block, the multiples of
+// `SmallPrimes()` are sieved out first, so only about 8% of the candidates need
+// a Miller-Rabin test.
+std::optional<uint64_t> FindPrimeIndex(const Progression& p, uint64_t lo,
+                                       uint64_t hi, bool backwards,
+                                       absl::Span<const int64_t> excluded) {
+  constexpr uint64_t kBlockSize = 4096;
+
+  // `p.ValueAt(k)` is divisible by q if and only if k = k0 (mod q). If q
+  // divides the modulus, then no value is divisible by q.
+  std::vector<std::pair<int64_t, int64_t>> residues;  // {q, k0}
+  for (int64_t q : SmallPrimes()) {
+    if (p.modulus % q == 0) continue;
+    residues.push_back(
+        {q, Mod(absl::int128(Mod(-p.first, q)) * ModInverse(p.modulus % q, q),
+                q)});
+  }
+
+  std::vector<char> composite(kBlockSize);
+  auto find_in_block = [&](uint64_t block_lo,
+                           uint64_t size) -> std::optional<uint64_t> {
+    std::fill(composite.begin(), composite.begin() + size, 0);
+    for (auto [q, k0] : residues) {
+      for (uint64_t i = Mod(absl::int128(k0) - block_lo, q); i < size; i += q)
+        if (p.ValueAt(block_lo + i) != q) composite[i] = 1;
+    }
+    for (uint64_t step = 0; step < size; step++) {
+      uint64_t i = backwards ? size - 1 - step : step;
+      if (composite[i]) continue;
+      int64_t value = p.ValueAt(block_lo + i);
+      if (IsPrime(value) && !absl::c_binary_search(excluded, value))
+        return block_lo + i;
+    }
+    return std::nullopt;
+  };
+
+  if (lo > hi) return std::nullopt;
+  if (!backwards) {
+    for (uint64_t block_lo = lo;; block_lo += kBlockSize) {
+      uint64_t size = std::min(hi - block_lo, kBlockSize - 1) + 1;
+      if (auto index = find_in_block(block_lo, size)) return index;
+      if (hi - block_lo < kBlockSize) return std::nullopt;
+    }
+  }
+  for (uint64_t block_hi = hi;; block_hi -= kBlockSize) {
+    uint64_t size = std::min(block_hi - lo, kBlockSize - 1) + 1;
+    if (auto index = find_in_block(block_hi - (size - 1), size)) return index;
+    if (block_hi - lo < kBlockSize) return std::nullopt;
+  }
+}
+
+// Picks an index in [0, last_index] using `distribution`. Everything except
+// `kWeightedBuckets` only depends on the width of the range. The buckets are
+// in terms of values, so they are converted to indices with `first_index_at`
+// (the first index whose value is at least `x`) and `last_index_at` (the last
+// index whose value is at most `x`, or -1 if there is none).
+template <typename FirstIndexAt, typename LastIndexAt>
+absl::StatusOr<uint64_t> SampleIndex(RandomEngine& rng, uint64_t last_index,
+                                     const IntegerDistribution& distribution,
+                                     FirstIndexAt first_index_at,
+                                     LastIndexAt last_index_at) {
+  // Indices are shifted by `kShift` so that [0, 2^64) fits in an int64_t.
+  constexpr int64_t kShift = std::numeric_limits<int64_t>::min();
+  auto shifted = [](absl::int128 index) {
+    return static_cast<int64_t>(static_cast<uint64_t>(index) +
+                                static_cast<uint64_t>(kShift));
+  };
+
+  int64_t sampled;
+  if (distribution.shape != IntegerDistribution::Shape::kWeightedBuckets) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        sampled, RandIntFromDistribution(rng, kShift, shifted(last_index),
+                                         distribution));
+  } else {
+    IntegerDistribution indices = {.shape = distribution.shape};
+    for (const WeightedBucket& bucket : distribution.buckets) {
+      absl::int128 lo = std::max<absl::int128>(first_index_at(bucket.min), 0);
+      absl::int128 hi = std::min<absl::int128>(last_index_at(bucket.max),
+                                               absl::int128(last_index));
+      if (lo > hi) continue;
+      indices.buckets.push_back(
+          {.min = shifted(lo), .max = shifted(hi), .weight = bucket.weight});
+    }
+    MORIARTY_ASSIGN_OR_RETURN(
+        sampled,
+        RandIntFromDistribution(rng, kShift, shifted(last_index), indices));
+  }
+  return static_cast<uint64_t>(sampled) - static_cast<uint64_t>(kShift);
+}
+
+}  // namespace
+
+bool IsPrime(int64_t n) {
+  if (n < 2) return false;
+  for (int64_t p : SmallPrimes()) {
+    if (n % p == 0) return n == p;
+    if (p * p > n) return true;
+  }
+
+  // Miller-Rabin. These 7 witnesses (found by Jim Sinclair) are enough for
+  // all n < 2^64. Here, n has no factors below 1000, and n > 1000.
+  constexpr uint64_t kWitnesses[] = {2,      325,     9375,      28178,
+                                     450775, 9780504, 1795265022};
+  uint64_t m = n;
+  uint64_t d = m - 1;
+  int s = 0;
+  while (d % 2 == 0) {
+    d /= 2;
+    s++;
+  }
+  for (uint64_t a : kWitnesses) {
+    uint64_t x = PowMod(a, d, m);
+    if (x == 0 || x == 1 || x == m - 1) continue;  // x == 0 if m divides a.
+    bool composite = true;
+    for (int i = 1; i < s && composite; i++) {
+      x = MulMod(x, x, m);
+      if (x == m - 1) composite = false;
+    }
+    if (composite) return false;
+  }
+  return true;
+}
+
+absl::Status ArithmeticConstraints::AddModEquals(int64_t modulus,
+                                                 int64_t remainder) {
+  if (modulus <= 0) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Modulus must be positive, got $0", modulus));
+  }
+  remainder = Mod(remainder, modulus);
+
+  // Chinese remainder theorem. x = r1 (mod m1) and x = r2 (mod m2).
+  int64_t m1 = modulus_, r1 = remainder_;
+  int64_t m2 = modulus, r2 = remainder;
+  int64_t g = std::gcd(m1, m2);
+  absl::int128 diff = absl::int128(r2) - r1;
+  if (diff % g != 0) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Incompatible congruences: $0 mod $1 and $2 mod $3", r1, m1, r2, m2));
+  }
+  absl::int128 lcm = absl::int128(m1 / g) * m2;
+  if (lcm > std::numeric_limits<int64_t>::max()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Combined modulus of $0 and $1 does not fit in an int64_t", m1, m2));
+  }
+
+  // x = r1 + m1 * t, where t = (diff / g) * (m1 / g)^-1 (mod m2 / g).
+  int64_t m2g = m2 / g;
+  absl::int128 t = absl::int128(Mod(diff / g, m2g)) *
+                   ModInverse(Mod(m1 / g, m2g), m2g) % m2g;
+  modulus_ = static_cast<int64_t>(lcm);
+  remainder_ = Mod(absl::int128(r1) + absl::int128(m1) * t, modulus_);
+  return absl::OkStatus();
+}
+
+void ArithmeticConstraints::AddNotIn(absl::Span<const int64_t> values) {
+  excluded_.insert(excluded_.end(), values.begin(), values.end());
+  absl::c_sort(excluded_);
+  excluded_.erase(std::unique(excluded_.begin(), excluded_.end()),
+                  excluded_.end());
+}
+
+void ArithmeticConstraints::AddPrime() { prime_ = true; }
+
+absl::Status ArithmeticConstraints::MergeFrom(
+    const ArithmeticConstraints& other) {
+  MORIARTY_RETURN_IF_ERROR(AddModEquals(other.modulus_, other.remainder_));
+  AddNotIn(other.excluded_);
+  prime_ |= other.prime_;
+  return absl::OkStatus();
+}
+
+bool ArithmeticConstraints::IsTrivial() const {
+  return modulus_ == 1 && excluded_.empty() && !prime_;
+}
+
+std::optional<std::string> ArithmeticConstraints::FindViolation(
+    int64_t value) const {
+  if (Mod(value, modulus_) != remainder_) {
+    return absl::Substitute("$0 is not congruent to $1 mod $2", value,
+                            remainder_, modulus_);
+  }
+  if (absl::c_binary_search(excluded_, value))
+    return absl::Substitute("$0 is one of the excluded values", value);
+  if (prime_ && !IsPrime(value))
+    return absl::Substitute("$0 is not prime", value);
+  return std::nullopt;
+}
+
+absl::StatusOr<int64_t> ArithmeticConstraints::Sample(
+    RandomEngine& rng, int64_t min, int64_t max,
+    const IntegerDistribution& distribution) const {
+  auto not_found = [&]() {
+    return absl::NotFoundError(
+        absl::Substitute("No value in [$0, $1] is $2", min, max, ToString()));
+  };
+  // Primes are positive, and scanning through negative values would be slow.
+  if (prime_) min = std::max<int64_t>(min, 2);
+
+  // The candidates are first, first + m, first + 2m, ..., up to max.
+  std::optional<Progression> progression =
+      MakeProgression(min, max, modulus_, remainder_);
+  if (!progression) return not_found();
+  const int64_t m = modulus_;
+  const absl::int128 first = progression->first;
+  const uint64_t last_index = progression->last_index;
+  auto value_at = [&](absl::int128 index) {
+    return progression->ValueAt(index);
+  };
+  auto first_index_at = [&](int64_t x) {
+    return progression->FirstIndexAt(x);
+  };
+  auto last_index_at = [&](int64_t x) { return progression->LastIndexAt(x); };
+
+  if (prime_) {
+    // Every candidate is a multiple of g, so only g itself may be prime.
+    int64_t g = std::gcd(remainder_, m);
+    if (g > 1) {
+      if (min <= g && g <= max && !FindViolation(g)) return g;
+      return not_found();
+    }
+
+    if (last_index < kMaxEnumeratedPrimeCandidates) {
+      std::vector<int64_t> primes;
+      for (uint64_t i = 0; i <= last_index; i++) {
+        int64_t value = value_at(i);
+        if (IsPrime(value) && !absl::c_binary_search(excluded_, value))
+          primes.push_back(value);
+      }
+      if (primes.empty()) return not_found();
+      MORIARTY_ASSIGN_OR_RETURN(
+          uint64_t index,
+          SampleIndex(
+              rng, primes.size() - 1, distribution,
+              [&](int64_t x) { return absl::c_lower_bound(primes, x) -
+                                      primes.begin(); },
+              [&](int64_t x) {
+                return (absl::c_upper_bound(primes, x) - primes.begin()) - 1;
+              }));
+      return primes[index];
+    }
+
+    // Use the first prime at or after the sampled index, wrapping around.
+    MORIARTY_ASSIGN_OR_RETURN(
+        uint64_t start, SampleIndex(rng, last_index, distribution,
+                                    first_index_at, last_index_at));
+    std::optional<uint64_t> index = FindPrimeIndex(
+        *progression, start, last_index, /*backwards=*/false, excluded_);
+    if (!index && start > 0) {
+      index = FindPrimeIndex(*progression, 0, start - 1, /*backwards=*/false,
+                             excluded_);
+    }
+    if (!index) return not_found();
+    return value_at(*index);
+  }
+
+  // Remove the excluded candidates, then map the sampled index back.
+  std::vector<uint64_t> excluded_indices;
+  for (int64_t value : excluded_) {
+    if (value < first || value > max || Mod(value - first, m) != 0) continue;
+    excluded_indices.push_back(
+        static_cast<uint64_t>((absl::int128(value) - first) / m));
+  }
+  if (absl::uint128(last_index) + 1 <= excluded_indices.size())
+    return not_found();
+
+  MORIARTY_ASSIGN_OR_RETURN(
+      uint64_t index,
+      SampleIndex(rng, last_index - excluded_indices.size(), distribution,
+                  first_index_at, last_index_at));
+  for (uint64_t excluded_index : excluded_indices) {
+    if (excluded_index > index) break;
+    index++;
+  }
+  return value_at(index);
+}
+
+std::optional<int64_t> ArithmeticConstraints::FirstValid(int64_t min,
+                                                         int64_t max) const {
+  return FindValid(min, max, /*largest=*/false);
+}
+
+std::optional<int64_t> ArithmeticConstraints::LastValid(int64_t min,
+                                                        int64_t max) const {
+  return FindValid(min, max, /*largest=*/true);
+}
+
+std::optional<int64_t> ArithmeticConstraints::FindValid(int64_t min,
+                                                        int64_t max,
+                                                        bool largest) const {
+  if (prime_) min = std::max<int64_t>(min, 2);
+  std::optional<Progression> progression =
+      MakeProgression(min, max, modulus_, remainder_);
+  if (!progression) return std::nullopt;
+
+  if (prime_) {
+    int64_t g = std::gcd(remainder_, modulus_);
+    if (g > 1) {
+      if (min <= g && g <= max && !FindViolation(g)) return g;
+      return std::nullopt;
+    }
+    std::optional<uint64_t> index = FindPrimeIndex(
+        *progression, 0, progression->last_index, largest, excluded_);
+    if (!index) return std::nullopt;
+    return progression->ValueAt(*index);
+  }
+
+  // At most `excluded_.size()` candidates are skipped.
+  for (uint64_t step = 0; step <= progression->last_index; step++) {
+    int64_t value = progression->ValueAt(
+        largest ? progression->last_index - step : step);
+    if (!absl::c_binary_search(excluded_, value)) return value;
+    if (step == progression->last_index) break;  // Avoids overflow of `step`.
+  }
+  return std::nullopt;
+}
+
+std::string ArithmeticConstraints::ToString() const {
+  std::vector<std::string> parts;
+  if (modulus_ > 1)
+    parts.push_back(absl::Substitute("$0 mod $1", remainder_, modulus_));
+  if (!excluded_.empty()) {
+    parts.push_back(
+        absl::Substitute("not in {$0}", absl::StrJoin(excluded_, ", ")));
+  }
+  if (prime_) parts.push_back("prime");
+  if (parts.empty()) return "any integer";
+  return absl::StrJoin(parts, ", ");
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_ARITHMETIC_CONSTRAINTS_H_
+#define MORIARTY_SRC_INTERNAL_ARITHMETIC_CONSTRAINTS_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "src/internal/integer_distributions.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// IsPrime()
+//
+// Returns true if `n` is prime. Deterministic for all 64-bit integers. Uses
+// trial division by small primes, then Miller-Rabin with a fixed set of 7
+// witnesses that is known to be correct for all 64-bit integers.
+bool IsPrime(int64_t n);
+
+// ArithmeticConstraints
+//
+// Restrictions on an integer that are common in custom constraints (e.g., "x
+// is even", "x % k == r", "x is not 0", "x is prime"), but which may be
+// sampled from directly instead of by rejecting values until one satisfies
+// them.
+//
+// The restrictions are normalized, so any number of them can be combined. For
+// example, "x % 4 == 1" and "x % 6 == 3" become "x % 12 == 9".
+class ArithmeticConstraints {
+ public:
+  // AddModEquals()
+  //
+  // The value `x` must satisfy `x mod modulus == remainder` (using the
+  // mathematical definition of mod, so `-1 mod 3 == 2`). Returns
+  // kInvalidArgument if `modulus` is not positive, if this is incompatible with
+  // an earlier congruence (e.g., even and odd), or if the combined modulus does
+  // not fit in an int64_t.
+  absl::Status AddModEquals(int64_t modulus, int64_t remainder);
+
+  // AddNotIn()
+  //
+  // The value must not be any of `values`.
+  void AddNotIn(absl::Span<const int64_t> values);
+
+  // AddPrime()
+  //
+  // The value must be prime.
+  void AddPrime();
+
+  // MergeFrom()
+  //
+  // Adds all restrictions from `other` to this. Returns kInvalidArgument if
+  // the congruences are incompatible (see `AddModEquals()`).
+  absl::Status MergeFrom(const ArithmeticConstraints& other);
+
+  // IsTrivial()
+  //
+  // Returns true if there are no restrictions.
+  [[nodiscard]] bool IsTrivial() const;
+
+  // FindViolation()
+  //
+  // Returns a description of a restriction that `value` does not satisfy, or
+  // `std::nullopt` if it satisfies them all.
+  [[nodiscard]] std::optional<std::string> FindViolation(int64_t value) const;
+
+  // Sample()
+  //
+  // Returns a random value in [min, max] that satisfies the restrictions. The
+  // valid values are indexed from smallest to largest, and the index is picked
+  // from `distribution`. (For primes in large ranges, the first prime at or
+  // after the picked value is used, so the primes are only roughly
+  // distributed like this.) There is no rejection sampling.
+  //
+  // Returns kNotFound if no value in [min, max] satisfies the restrictions.
+  absl::StatusOr<int64_t> Sample(RandomEngine& rng, int64_t min, int64_t max,
+                                 const IntegerDistribution& distribution) const;
+
+  // FirstValid()
+  // LastValid()
+  //
+  // Returns the smallest (or largest) value in [min, max] that satisfies the
+  // restrictions, or `std::nullopt` if there are none. E.g., the primes
+  // closest to the bounds.
+  [[nodiscard]] std::optional<int64_t> FirstValid(int64_t min,
+                                                  int64_t max) const;
+  [[nodiscard]] std::optional<int64_t> LastValid(int64_t min,
+                                                 int64_t max) const;
+
+  // Returns a string representation of the restrictions.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  // Shared implementation of `FirstValid()` and `LastValid()`.
+  std::optional<int64_t> FindValid(int64_t min, int64_t max,
+                                   bool largest) const;
+
+  // The value must be `remainder_` mod `modulus_`. 0 <= remainder_ < modulus_.
+  int64_t modulus_ = 1;
+  int64_t remainder_ = 0;
+
+  // These values are not allowed. Sorted, without duplicates.
+  std::vector<int64_t> excluded_;
+
+  bool prime_ = false;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_ARITHMETIC_CONSTRAINTS_H_
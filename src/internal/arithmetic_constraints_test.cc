@@ -0,0 +1,252 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/arithmetic_constraints.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/internal/integer_distributions.h"
+#include "src/internal/random_engine.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Le;
+using ::testing::Optional;
+using ::testing::UnorderedElementsAre;
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+
+constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+
+// Returns `n` samples from `constraints` in [min, max].
+std::vector<int64_t> Sample(const ArithmeticConstraints& constraints,
+                            int64_t min, int64_t max, int n = 1000,
+                            const IntegerDistribution& distribution = {}) {
+  RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+  std::vector<int64_t> values;
+  for (int i = 0; i < n; i++) {
+    absl::StatusOr<int64_t> value =
+        constraints.Sample(rng, min, max, distribution);
+    EXPECT_TRUE(value.ok()) << value.status();
+    if (!value.ok()) break;
+    EXPECT_EQ(constraints.FindViolation(*value), std::nullopt);
+    values.push_back(*value);
+  }
+  return values;
+}
+
+TEST(ArithmeticConstraintsTest, IsPrimeWorks) {
+  std::vector<int64_t> primes;
+  for (int64_t n = -5; n <= 30; n++) {
+    if (IsPrime(n)) primes.push_back(n);
+  }
+  EXPECT_EQ(primes, (std::vector<int64_t>{2, 3, 5, 7, 11, 13, 17, 19, 23, 29}));
+
+  EXPECT_TRUE(IsPrime(1'000'000'007));
+  EXPECT_TRUE(IsPrime(9'223'372'036'854'775'783));  // Largest int64_t prime.
+  EXPECT_FALSE(IsPrime(kMax));
+  EXPECT_FALSE(IsPrime(3'215'031'751));  // Strong pseudoprime to 2, 3, 5, 7.
+  EXPECT_FALSE(IsPrime(1'000'000'007LL * 998'244'353));
+  // Strong pseudoprime to all prime bases up to 23.
+  EXPECT_FALSE(IsPrime(3'825'123'056'546'413'051));
+}
+
+TEST(ArithmeticConstraintsTest, IsPrimeMatchesASieve) {
+  constexpr int kLimit = 2'000'000;
+  std::vector<bool> composite(kLimit);
+  for (int64_t n = 2; n < kLimit; n++) {
+    ASSERT_EQ(IsPrime(n), !composite[n]) << n;
+    for (int64_t m = n * n; m < kLimit; m += n) composite[m] = true;
+  }
+}
+
+TEST(ArithmeticConstraintsTest, SampleShouldFindPrimesInHugeRanges) {
+  ArithmeticConstraints primes;
+  primes.AddPrime();
+  EXPECT_THAT(Sample(primes, kMin, kMax, 100), Each(Ge(2)));
+  EXPECT_THAT(Sample(primes, 1'000'000'000'000'000'000,
+                     1'000'000'000'001'000'000, 100),
+              Each(AllOf(Ge(1'000'000'000'000'000'000),
+                         Le(1'000'000'000'001'000'000))));
+  EXPECT_THAT(Sample(primes, kMax - 100, kMax, 10),
+              Each(9'223'372'036'854'775'783));
+}
+
+TEST(ArithmeticConstraintsTest, FirstAndLastValidShouldFindTheExtremes) {
+  ArithmeticConstraints primes;
+  primes.AddPrime();
+  EXPECT_THAT(primes.FirstValid(kMin, kMax), Optional(2));
+  EXPECT_THAT(primes.LastValid(kMin, kMax),
+              Optional(9'223'372'036'854'775'783));
+  EXPECT_THAT(primes.FirstValid(1'000'000'000'000'000'000, kMax),
+              Optional(1'000'000'000'000'000'003));
+  EXPECT_THAT(primes.LastValid(1, 1'000'000'000'000'000'000),
+              Optional(999'999'999'999'999'989));
+  EXPECT_EQ(primes.FirstValid(24, 28), std::nullopt);
+
+  ArithmeticConstraints odd;
+  MORIARTY_ASSERT_OK(odd.AddModEquals(2, 1));
+  odd.AddNotIn({-3, 1, 3});
+  EXPECT_THAT(odd.FirstValid(-3, 10), Optional(-1));
+  EXPECT_THAT(odd.LastValid(kMin, 3), Optional(-1));
+  EXPECT_THAT(odd.LastValid(kMin, kMax), Optional(kMax));
+  EXPECT_EQ(odd.FirstValid(1, 3), std::nullopt);
+}
+
+TEST(ArithmeticConstraintsTest, CongruencesShouldBeCombined) {
+  ArithmeticConstraints constraints;
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(4, 1));
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(6, -3));
+  EXPECT_EQ(constraints.ToString(), "9 mod 12");
+  EXPECT_THAT(Sample(constraints, -100, 100), Each(AllOf(Ge(-100), Le(100))));
+
+  EXPECT_THAT(constraints.AddModEquals(2, 0),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Incompatible")));
+  EXPECT_THAT(constraints.AddModEquals(0, 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(constraints.AddModEquals(kMax, 0),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("does not fit")));
+}
+
+TEST(ArithmeticConstraintsTest, SampleShouldCoverAllValidValues) {
+  ArithmeticConstraints constraints;
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(3, 1));
+  constraints.AddNotIn({4, 5, 100});
+  std::vector<int64_t> values = Sample(constraints, 1, 16);
+  EXPECT_THAT(absl::flat_hash_set<int64_t>(values.begin(), values.end()),
+              UnorderedElementsAre(1, 7, 10, 13, 16));
+
+  ArithmeticConstraints primes;
+  primes.AddPrime();
+  primes.AddNotIn({7});
+  values = Sample(primes, -10, 20);
+  EXPECT_THAT(absl::flat_hash_set<int64_t>(values.begin(), values.end()),
+              UnorderedElementsAre(2, 3, 5, 11, 13, 17, 19));
+}
+
+TEST(ArithmeticConstraintsTest, SampleShouldWorkForHugeRanges) {
+  ArithmeticConstraints even;
+  MORIARTY_ASSERT_OK(even.AddModEquals(2, 0));
+  even.AddNotIn({kMin, 0});
+  Sample(even, kMin, kMax);
+  EXPECT_THAT(Sample(even, kMin, kMin + 2, 10), Each(kMin + 2));
+
+  ArithmeticConstraints not_in;
+  not_in.AddNotIn({kMin, kMax});
+  Sample(not_in, kMin, kMax);
+
+  ArithmeticConstraints primes;
+  primes.AddPrime();
+  MORIARTY_ASSERT_OK(primes.AddModEquals(4, 3));
+  EXPECT_THAT(Sample(primes, 1'000'000'000'000, kMax, 100),
+              Each(Ge(1'000'000'000'000)));
+}
+
+TEST(ArithmeticConstraintsTest, PrimeWithASharedFactorOnlyAllowsThatFactor) {
+  ArithmeticConstraints constraints;
+  constraints.AddPrime();
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(4, 2));
+  EXPECT_THAT(Sample(constraints, 1, 1'000'000, 10), Each(2));
+
+  RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+  EXPECT_THAT(constraints.Sample(rng, 3, 1'000'000, {}),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(ArithmeticConstraintsTest, SampleWithNoValidValuesShouldFail) {
+  RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+  ArithmeticConstraints constraints;
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(10, 3));
+  EXPECT_THAT(constraints.Sample(rng, 4, 12, {}),
+              StatusIs(absl::StatusCode::kNotFound));
+  constraints.AddNotIn({3});
+  EXPECT_THAT(constraints.Sample(rng, 0, 12, {}),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(constraints.Sample(rng, 0, 13, {}), IsOkAndHolds(13));
+
+  ArithmeticConstraints primes;
+  primes.AddPrime();
+  EXPECT_THAT(primes.Sample(rng, 24, 28, {}),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(ArithmeticConstraintsTest, SampleShouldFollowTheDistribution) {
+  ArithmeticConstraints constraints;
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(10, 0));
+  constraints.AddNotIn({1000});
+  EXPECT_THAT(
+      Sample(constraints, 1, 1000, 10,
+             {.shape = IntegerDistribution::Shape::kClampedNormal, .mean = 1}),
+      Each(990));
+
+  IntegerDistribution buckets = {
+      .shape = IntegerDistribution::Shape::kWeightedBuckets,
+      .buckets = {{.min = 15, .max = 35, .weight = 1}}};
+  std::vector<int64_t> values = Sample(constraints, 1, 1000, 100, buckets);
+  EXPECT_THAT(absl::flat_hash_set<int64_t>(values.begin(), values.end()),
+              UnorderedElementsAre(20, 30));
+
+  ArithmeticConstraints primes;
+  primes.AddPrime();
+  values = Sample(primes, 1, 100, 100, buckets);
+  EXPECT_THAT(absl::flat_hash_set<int64_t>(values.begin(), values.end()),
+              UnorderedElementsAre(17, 19, 23, 29, 31));
+}
+
+TEST(ArithmeticConstraintsTest, MergeFromShouldCombineEverything) {
+  ArithmeticConstraints a;
+  MORIARTY_ASSERT_OK(a.AddModEquals(2, 1));
+  a.AddNotIn({3});
+  ArithmeticConstraints b;
+  MORIARTY_ASSERT_OK(b.AddModEquals(3, 0));
+  b.AddPrime();
+  MORIARTY_ASSERT_OK(a.MergeFrom(b));
+  EXPECT_EQ(a.ToString(), "3 mod 6, not in {3}, prime");
+  EXPECT_FALSE(a.IsTrivial());
+  EXPECT_TRUE(ArithmeticConstraints().IsTrivial());
+}
+
+TEST(ArithmeticConstraintsTest, FindViolationShouldExplainTheProblem) {
+  ArithmeticConstraints constraints;
+  MORIARTY_ASSERT_OK(constraints.AddModEquals(2, 1));
+  constraints.AddNotIn({5});
+  constraints.AddPrime();
+  EXPECT_EQ(constraints.FindViolation(7), std::nullopt);
+  EXPECT_THAT(constraints.FindViolation(4), Optional(HasSubstr("congruent")));
+  EXPECT_THAT(constraints.FindViolation(5), Optional(HasSubstr("excluded")));
+  EXPECT_THAT(constraints.FindViolation(9), Optional(HasSubstr("prime")));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,196 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/balanced_brackets.h"
+
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// Returns, for each position of a uniformly random balanced string of length
+// `length`, whether it is an opening bracket.
+//
+// A uniformly random sequence of `length / 2` opens and `length / 2 + 1`
+// closes has exactly one rotation whose proper prefixes are all balanced or
+// have more opens (the cycle lemma): the one starting just after the first
+// minimum of its prefix sums. That rotation ends with a close, and removing it
+// leaves a balanced string. Each balanced string comes from exactly
+// `length + 1` sequences, so it is uniform.
+absl::StatusOr<std::vector<bool>> UniformShape(int64_t length,
+                                               RandomEngine& random_engine) {
+  std::vector<bool> steps(length + 1);
+  int64_t opens_left = length / 2;
+  absl::Status status;
+  for (int64_t i = 0; i <= length; i++) {
+    steps[i] = random_engine.RandInt(length + 1 - i, status) < opens_left;
+    if (steps[i]) opens_left--;
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+
+  int64_t sum = 0;
+  int64_t min_sum = 0;
+  int64_t min_index = -1;
+  for (int64_t i = 0; i <= length; i++) {
+    sum += steps[i] ? 1 : -1;
+    if (sum < min_sum) {
+      min_sum = sum;
+      min_index = i;
+    }
+  }
+
+  std::vector<bool> shape(length);
+  for (int64_t i = 0; i < length; i++)
+    shape[i] = steps[(min_index + 1 + i) % (length + 1)];
+  return shape;
+}
+
+// Returns, for each position of a random balanced string of length `length`
+// with depth at most `max_depth` (at least 1), whether it is an opening
+// bracket. Each bracket is random among those that can still be completed.
+absl::StatusOr<std::vector<bool>> DepthLimitedShape(
+    int64_t length, int64_t max_depth, RandomEngine& random_engine) {
+  std::vector<bool> shape(length);
+  int64_t depth = 0;
+  absl::Status status;
+  for (int64_t i = 0; i < length; i++) {
+    int64_t remaining = length - i - 1;
+    bool can_open = depth < max_depth && depth + 1 <= remaining;
+    bool can_close = depth > 0;
+    shape[i] = can_open && (!can_close || random_engine.RandInt(2, status));
+    depth += shape[i] ? 1 : -1;
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+  return shape;
+}
+
+}  // namespace
+
+std::string BracketsError(absl::string_view brackets) {
+  if (brackets.empty() || brackets.size() % 2 != 0) {
+    return absl::Substitute(
+        "brackets must be pairs of opening and closing characters, but got "
+        "'$0'",
+        brackets);
+  }
+  std::bitset<256> seen;
+  for (char c : brackets) {
+    if (seen[static_cast<uint8_t>(c)])
+      return absl::Substitute("bracket '$0' appears multiple times", c);
+    seen[static_cast<uint8_t>(c)] = true;
+  }
+  return "";
+}
+
+absl::StatusOr<std::string> GenerateBalancedBrackets(
+    int64_t length, absl::string_view brackets,
+    std::optional<int64_t> max_depth, RandomEngine& random_engine) {
+  if (length < 0 || length % 2 != 0) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "balanced brackets need a non-negative, even length, but got $0",
+        length));
+  }
+  if (max_depth && *max_depth < 1 && length > 0) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "no balanced brackets of length $0 have depth at most $1", length,
+        *max_depth));
+  }
+
+  std::vector<bool> shape;
+  if (max_depth && *max_depth < length / 2) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        shape, DepthLimitedShape(length, *max_depth, random_engine));
+  } else {
+    MORIARTY_ASSIGN_OR_RETURN(shape, UniformShape(length, random_engine));
+  }
+
+  // Each pair gets a random type. The types of the pairs that are open are
+  // kept on a stack to close them.
+  int num_types = brackets.size() / 2;
+  std::vector<uint8_t> types(length / 2);
+  if (num_types > 1) {
+    MORIARTY_RETURN_IF_ERROR(
+        random_engine.RandIndices(num_types, absl::MakeSpan(types)));
+  }
+
+  std::string result(length, ' ');
+  std::vector<uint8_t> open_types;
+  int64_t next_type = 0;
+  for (int64_t i = 0; i < length; i++) {
+    if (shape[i]) {
+      open_types.push_back(types[next_type++]);
+      result[i] = brackets[2 * open_types.back()];
+    } else {
+      result[i] = brackets[2 * open_types.back() + 1];
+      open_types.pop_back();
+    }
+  }
+  return result;
+}
+
+std::string BalancedBracketsError(absl::string_view value,
+                                  absl::string_view brackets,
+                                  std::optional<int64_t> max_depth) {
+  // For each character, 1 + the index of its type if it opens a bracket, or
+  // -1 - the index of its type if it closes one.
+  int types[256] = {};
+  for (int i = 0; i < brackets.size(); i++) {
+    types[static_cast<uint8_t>(brackets[i])] =
+        i % 2 == 0 ? 1 + i / 2 : -1 - i / 2;
+  }
+
+  std::string open;  // The types of the brackets that are open.
+  for (int64_t i = 0; i < value.size(); i++) {
+    int type = types[static_cast<uint8_t>(value[i])];
+    if (type == 0) {
+      return absl::Substitute("character '$0' at index $1 is not a bracket",
+                              value[i], i);
+    }
+    if (type > 0) {
+      open.push_back(type);
+      if (max_depth && static_cast<int64_t>(open.size()) > *max_depth) {
+        return absl::Substitute(
+            "brackets are nested more than $0 deep at index $1", *max_depth,
+            i);
+      }
+      continue;
+    }
+    if (open.empty() || open.back() != -type) {
+      return absl::Substitute(
+          "'$0' at index $1 does not close the most recent open bracket",
+          value[i], i);
+    }
+    open.pop_back();
+  }
+  if (!open.empty())
+    return absl::Substitute("$0 bracket(s) are never closed", open.size());
+  return "";
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_BALANCED_BRACKETS_H_
+#define MORIARTY_SRC_INTERNAL_BALANCED_BRACKETS_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// In the functions below, `brackets` lists the opening and closing character
+// of each type of bracket, one pair after the other (e.g., "()" or "()[]{}").
+// The depth of a string is the most brackets that are open at once (e.g.,
+// "(())()" has depth 2).
+
+// BracketsError()
+//
+// Returns why `brackets` is not a valid list of pairs of brackets (it must
+// have a positive, even length and distinct characters), or an empty string
+// if it is valid.
+std::string BracketsError(absl::string_view brackets);
+
+// GenerateBalancedBrackets()
+//
+// Returns a balanced string of `length` brackets (which must be even). If
+// `max_depth` is not set (or at least `length / 2`), the string is uniformly
+// random among all balanced strings of this length: its shape is built with
+// the cycle lemma and each pair of brackets gets a random type. Otherwise,
+// the string is a random walk that stays within the depth, which is not
+// uniform. Both take O(length) time.
+//
+// `brackets` must be valid (see `BracketsError()`).
+absl::StatusOr<std::string> GenerateBalancedBrackets(
+    int64_t length, absl::string_view brackets,
+    std::optional<int64_t> max_depth, RandomEngine& random_engine);
+
+// BalancedBracketsError()
+//
+// Returns why `value` is not a balanced string of `brackets` with depth at
+// most `max_depth`, or an empty string if it is. Takes O(length) time.
+std::string BalancedBracketsError(absl::string_view value,
+                                  absl::string_view brackets,
+                                  std::optional<int64_t> max_depth);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_BALANCED_BRACKETS_H_
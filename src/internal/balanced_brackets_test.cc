@@ -0,0 +1,138 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/balanced_brackets.h"
+
+#include <optional>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "src/internal/random_engine.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::testing::AllOf;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Le;
+using ::testing::SizeIs;
+
+TEST(BalancedBracketsTest, BracketsErrorShouldAcceptPairsOfDistinctBrackets) {
+  EXPECT_THAT(BracketsError("()"), IsEmpty());
+  EXPECT_THAT(BracketsError("()[]{}<>"), IsEmpty());
+  EXPECT_THAT(BracketsError("ab"), IsEmpty());
+}
+
+TEST(BalancedBracketsTest, BracketsErrorShouldRejectInvalidBrackets) {
+  EXPECT_THAT(BracketsError(""), HasSubstr("pairs"));
+  EXPECT_THAT(BracketsError("()["), HasSubstr("pairs"));
+  EXPECT_THAT(BracketsError("(("), HasSubstr("multiple times"));
+  EXPECT_THAT(BracketsError("()[)"), HasSubstr("multiple times"));
+}
+
+TEST(BalancedBracketsTest, BalancedBracketsErrorShouldAcceptBalancedStrings) {
+  EXPECT_THAT(BalancedBracketsError("", "()", std::nullopt), IsEmpty());
+  EXPECT_THAT(BalancedBracketsError("(()())", "()", std::nullopt), IsEmpty());
+  EXPECT_THAT(BalancedBracketsError("([]{()})", "()[]{}", std::nullopt),
+              IsEmpty());
+  EXPECT_THAT(BalancedBracketsError("(())()", "()", 2), IsEmpty());
+}
+
+TEST(BalancedBracketsTest, BalancedBracketsErrorShouldExplainTheProblem) {
+  EXPECT_THAT(BalancedBracketsError("(a)", "()", std::nullopt),
+              HasSubstr("'a' at index 1 is not a bracket"));
+  EXPECT_THAT(BalancedBracketsError("())(", "()", std::nullopt),
+              HasSubstr("')' at index 2 does not close"));
+  EXPECT_THAT(BalancedBracketsError("([)]", "()[]", std::nullopt),
+              HasSubstr("')' at index 2 does not close"));
+  EXPECT_THAT(BalancedBracketsError("(()", "()", std::nullopt),
+              HasSubstr("1 bracket(s) are never closed"));
+  EXPECT_THAT(BalancedBracketsError("(()(()))", "()", 2),
+              HasSubstr("more than 2 deep at index 4"));
+}
+
+TEST(BalancedBracketsTest, GenerateShouldBeBalanced) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (int length : {0, 2, 10, 1000}) {
+    for (const char* brackets : {"()", "()[]{}"}) {
+      MORIARTY_ASSERT_OK_AND_ASSIGN(
+          std::string value,
+          GenerateBalancedBrackets(length, brackets, std::nullopt, engine));
+      EXPECT_THAT(value, SizeIs(length));
+      EXPECT_THAT(BalancedBracketsError(value, brackets, std::nullopt),
+                  IsEmpty())
+          << value;
+    }
+  }
+}
+
+TEST(BalancedBracketsTest, GenerateShouldBeUniform) {
+  // There are 5 balanced strings of length 6 with one type of bracket.
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  absl::flat_hash_map<std::string, int> counts;
+  for (int i = 0; i < 5000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::string value,
+        GenerateBalancedBrackets(6, "()", std::nullopt, engine));
+    counts[value]++;
+  }
+  EXPECT_THAT(counts, SizeIs(5));
+  for (const auto& [value, count] : counts)
+    EXPECT_THAT(count, AllOf(Ge(850), Le(1150))) << value;
+}
+
+TEST(BalancedBracketsTest, GenerateShouldUseAllTypesOfBrackets) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::string value,
+      GenerateBalancedBrackets(100, "()[]{}", std::nullopt, engine));
+  for (char c : std::string("()[]{}"))
+    EXPECT_NE(value.find(c), std::string::npos) << c;
+}
+
+TEST(BalancedBracketsTest, GenerateShouldRespectTheMaximumDepth) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (int max_depth : {1, 2, 5}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::string value,
+        GenerateBalancedBrackets(1000, "()[]", max_depth, engine));
+    EXPECT_THAT(value, SizeIs(1000));
+    EXPECT_THAT(BalancedBracketsError(value, "()[]", max_depth), IsEmpty())
+        << value;
+  }
+}
+
+TEST(BalancedBracketsTest, GenerateShouldFailForImpossibleStrings) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  EXPECT_THAT(GenerateBalancedBrackets(5, "()", std::nullopt, engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(GenerateBalancedBrackets(-2, "()", std::nullopt, engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(GenerateBalancedBrackets(2, "()", 0, engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(GenerateBalancedBrackets(0, "()", 0, engine), IsOkAndHolds(""));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
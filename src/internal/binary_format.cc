@@ -0,0 +1,323 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/binary_format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/strings/substitute.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "src/internal/abstract_variable.h"
+#include "src/internal/digest.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/value_codec.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+absl::Status CorruptTestCaseError(absl::string_view reason) {
+  return absl::InvalidArgumentError(
+      absl::StrCat("corrupt binary test case: ", reason));
+}
+
+absl::Status CorruptShardError(absl::string_view reason) {
+  return absl::InvalidArgumentError(absl::StrCat("corrupt shard: ", reason));
+}
+
+// Returns the names of the variables in `variables` that have a value in
+// `values`, sorted so the encoding does not depend on hash map order.
+std::vector<absl::string_view> SortedNames(const ValueSet& values,
+                                           const VariablesByName& variables) {
+  std::vector<absl::string_view> names;
+  for (const auto& [name, variable] : variables) {
+    if (values.Contains(name)) names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+}  // namespace
+
+VariablesByName GetVariablesByName(const VariableSet& variables) {
+  VariablesByName result;
+  for (const auto& [name, variable] : variables.GetAllVariables())
+    result.emplace(name, variable.get());
+  return result;
+}
+
+void AppendBinaryFormatHeader(std::string& out) {
+  out.append(kBinaryFormatMagic);
+  AppendVarint(kBinaryFormatVersion, out);
+}
+
+absl::Status ReadBinaryFormatHeader(absl::string_view& in) {
+  if (!absl::ConsumePrefix(&in, kBinaryFormatMagic)) {
+    return absl::InvalidArgumentError(
+        "not in Moriarty's binary format (missing magic string)");
+  }
+  uint64_t version;
+  if (!ReadVarint(in, version)) return CorruptTestCaseError("missing version");
+  if (version != kBinaryFormatVersion) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "binary format version $0 is not supported (expected version $1)",
+        version, kBinaryFormatVersion));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status AppendEncodedTestCase(const ValueSet& values,
+                                   const VariablesByName& variables,
+                                   std::string& out) {
+  std::vector<absl::string_view> names = SortedNames(values, variables);
+
+  std::string encoded;
+  AppendVarint(names.size(), encoded);
+  for (absl::string_view name : names) {
+    EncodeValue(std::string(name), encoded);
+    MORIARTY_RETURN_IF_ERROR(
+        variables.find(name)->second->EncodeValue(values, name, encoded));
+  }
+
+  AppendVarint(encoded.size(), out);
+  out.append(encoded);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<absl::uint128> FingerprintTestCase(
+    const ValueSet& values, const VariablesByName& variables) {
+  std::vector<absl::string_view> names = SortedNames(values, variables);
+  if (names.size() != static_cast<size_t>(values.NumValues())) {
+    return absl::FailedPreconditionError(
+        "cannot fingerprint a value without a variable");
+  }
+
+  Digest128 digest;
+  std::string encoded;
+  AppendVarint(names.size(), encoded);
+  digest.Update(encoded);
+  for (absl::string_view name : names) {
+    encoded.clear();
+    EncodeValue(std::string(name), encoded);
+    MORIARTY_RETURN_IF_ERROR(
+        variables.find(name)->second->EncodeValue(values, name, encoded));
+    digest.Update(encoded);
+  }
+  return digest.Finish();
+}
+
+absl::Status ReadEncodedTestCase(absl::string_view& in,
+                                 const VariablesByName& variables,
+                                 ValueSet& values) {
+  uint64_t size;
+  if (!ReadVarint(in, size) || size > in.size())
+    return CorruptTestCaseError("truncated test case");
+  absl::string_view test_case = in.substr(0, size);
+  in.remove_prefix(size);
+
+  uint64_t num_values;
+  if (!ReadVarint(test_case, num_values))
+    return CorruptTestCaseError("missing number of values");
+  for (uint64_t i = 0; i < num_values; i++) {
+    std::string name;
+    if (!DecodeValue(test_case, name))
+      return CorruptTestCaseError("missing variable name");
+    auto it = variables.find(name);
+    if (it == variables.end()) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("unknown variable `$0` in binary test case", name));
+    }
+    MORIARTY_RETURN_IF_ERROR(it->second->DecodeValue(test_case, name, values));
+  }
+  if (!test_case.empty())
+    return CorruptTestCaseError("extra bytes at the end of test case");
+  return absl::OkStatus();
+}
+
+absl::Status SkipEncodedTestCase(absl::string_view& in) {
+  uint64_t size;
+  if (!ReadVarint(in, size) || size > in.size())
+    return CorruptTestCaseError("truncated test case");
+  in.remove_prefix(size);
+  return absl::OkStatus();
+}
+
+void AppendShardHeader(int64_t shard_index, int64_t num_shards,
+                       std::string& out) {
+  out.append(kShardFormatMagic);
+  AppendVarint(kBinaryFormatVersion, out);
+  AppendVarint(shard_index, out);
+  AppendVarint(num_shards, out);
+}
+
+absl::Status ReadShardHeader(absl::string_view& in, int64_t& shard_index,
+                             int64_t& num_shards) {
+  if (!absl::ConsumePrefix(&in, kShardFormatMagic)) {
+    return absl::InvalidArgumentError(
+        "not a shard in Moriarty's binary format (missing magic string)");
+  }
+  uint64_t version;
+  if (!ReadVarint(in, version)) return CorruptShardError("missing version");
+  if (version != kBinaryFormatVersion) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "binary format version $0 is not supported (expected version $1)",
+        version, kBinaryFormatVersion));
+  }
+  uint64_t index, count;
+  if (!ReadVarint(in, index) || !ReadVarint(in, count))
+    return CorruptShardError("missing shard index");
+  shard_index = index;
+  num_shards = count;
+  return absl::OkStatus();
+}
+
+void AppendCheckpointHeader(absl::string_view run_key, std::string& out) {
+  out.append(kCheckpointFormatMagic);
+  AppendVarint(kBinaryFormatVersion, out);
+  EncodeValue(std::string(run_key), out);
+}
+
+absl::Status ReadCheckpointHeader(absl::string_view& in,
+                                  std::string& run_key) {
+  if (!absl::ConsumePrefix(&in, kCheckpointFormatMagic)) {
+    return absl::InvalidArgumentError(
+        "not a checkpoint in Moriarty's binary format (missing magic string)");
+  }
+  uint64_t version;
+  if (!ReadVarint(in, version))
+    return absl::InvalidArgumentError("corrupt checkpoint: missing version");
+  if (version != kBinaryFormatVersion) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "binary format version $0 is not supported (expected version $1)",
+        version, kBinaryFormatVersion));
+  }
+  if (!DecodeValue(in, run_key))
+    return absl::InvalidArgumentError("corrupt checkpoint: missing run key");
+  return absl::OkStatus();
+}
+
+absl::Status AppendShardWorkItem(
+    int64_t generator_index, absl::string_view generator_name, int64_t call,
+    const absl::StatusOr<std::vector<ValueSet>>& test_cases,
+    const VariablesByName& variables, std::string& out) {
+  std::string encoded;
+  AppendVarint(generator_index, encoded);
+  EncodeValue(std::string(generator_name), encoded);
+  AppendVarint(call, encoded);
+  absl::Status status = test_cases.status();
+  AppendVarint(static_cast<uint64_t>(status.code()), encoded);
+  EncodeValue(std::string(status.message()), encoded);
+  if (!test_cases.ok()) {
+    AppendVarint(0, encoded);
+  } else {
+    AppendVarint(test_cases->size(), encoded);
+    for (const ValueSet& values : *test_cases) {
+      MORIARTY_RETURN_IF_ERROR(
+          AppendEncodedTestCase(values, variables, encoded));
+    }
+  }
+
+  out.append(encoded);
+  return absl::OkStatus();
+}
+
+absl::Status ReadShardWorkItem(absl::string_view& in,
+                               ShardWorkItem& work_item) {
+  uint64_t generator_index, call, code, num_test_cases;
+  std::string message;
+  if (!ReadVarint(in, generator_index) ||
+      !DecodeValue(in, work_item.generator_name) || !ReadVarint(in, call) ||
+      !ReadVarint(in, code) || !DecodeValue(in, message) ||
+      !ReadVarint(in, num_test_cases)) {
+    return CorruptShardError("truncated work item");
+  }
+  work_item.generator_index = generator_index;
+  work_item.call = call;
+  work_item.status =
+      absl::Status(static_cast<absl::StatusCode>(code), message);
+  if (!work_item.status.ok() && num_test_cases > 0)
+    return CorruptShardError("failed work item has test cases");
+  work_item.num_test_cases = num_test_cases;
+
+  // Skip over the test cases, using the size in front of each of them.
+  absl::string_view test_cases = in;
+  for (uint64_t i = 0; i < num_test_cases; i++) {
+    uint64_t size;
+    if (!ReadVarint(in, size) || size > in.size())
+      return CorruptShardError("truncated test case");
+    in.remove_prefix(size);
+  }
+  work_item.test_cases = test_cases.substr(0, test_cases.size() - in.size());
+  return absl::OkStatus();
+}
+
+void AppendCheckpointBudgetUsage(const GenerationUsage& usage,
+                                 std::string& out) {
+  AppendVarint(usage.generate_calls, out);
+  AppendVarint(usage.bytes, out);
+  AppendVarint(absl::ToInt64Nanoseconds(usage.wall_time), out);
+}
+
+absl::Status ReadCheckpointBudgetUsage(absl::string_view& in,
+                                       GenerationUsage& usage) {
+  uint64_t generate_calls, bytes, wall_time_ns;
+  if (!ReadVarint(in, generate_calls) || !ReadVarint(in, bytes) ||
+      !ReadVarint(in, wall_time_ns)) {
+    return absl::InvalidArgumentError(
+        "corrupt checkpoint: truncated budget usage");
+  }
+  usage.generate_calls = generate_calls;
+  usage.bytes = bytes;
+  usage.wall_time = absl::Nanoseconds(wall_time_ns);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> EncodeValueSets(
+    absl::Span<const ValueSet> value_sets, const VariablesByName& variables) {
+  std::string encoded;
+  AppendBinaryFormatHeader(encoded);
+  for (const ValueSet& values : value_sets)
+    MORIARTY_RETURN_IF_ERROR(AppendEncodedTestCase(values, variables, encoded));
+  return encoded;
+}
+
+absl::StatusOr<std::vector<ValueSet>> DecodeValueSets(
+    absl::string_view encoded, const VariablesByName& variables) {
+  MORIARTY_RETURN_IF_ERROR(ReadBinaryFormatHeader(encoded));
+  std::vector<ValueSet> value_sets;
+  while (!encoded.empty()) {
+    ValueSet values;
+    MORIARTY_RETURN_IF_ERROR(ReadEncodedTestCase(encoded, variables, values));
+    value_sets.push_back(std::move(values));
+  }
+  return value_sets;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
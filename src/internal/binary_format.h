@@ -0,0 +1,225 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_BINARY_FORMAT_H_
+#define MORIARTY_SRC_INTERNAL_BINARY_FORMAT_H_
+
+// Moriarty's binary format for test cases. A file (or buffer) is
+//
+//   "MORIARTY" <varint: version> <test case>*
+//
+// and each test case is
+//
+//   <varint: size in bytes> <varint: number of values>
+//   (<string: variable name> <value>)*
+//
+// where values use the encoding in `value_codec.h` for their variable's type.
+// Variables are sorted by name. Prefixing each test case by its size allows
+// readers to skip test cases without decoding them.
+//
+// A shard of generator calls (see `Moriarty::SetShard()`) is
+//
+//   "MSHARD" <varint: version> <varint: shard index> <varint: number of shards>
+//   <work item>*
+//
+// and each work item (one call of one generator) is
+//
+//   <varint: generator index> <string: generator name> <varint: call>
+//   <varint: status code> <string: status message>
+//   <varint: number of test cases> <test case>*
+//
+// where a work item whose status is not ok has no test cases.
+//
+// A checkpoint of a generation run (see `Moriarty::SetCheckpointFile()`) is
+//
+//   "MCHECKPOINT" <varint: version> <string: run key>
+//   (<work item> <budget usage>)*
+//
+// where the work items are the calls completed so far, in order, and the run
+// key identifies the run (seed, generators, etc.) that wrote them. The budget
+// usage of a call is
+//
+//   <varint: generate calls> <varint: bytes> <varint: wall time in ns>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "src/internal/abstract_variable.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+inline constexpr absl::string_view kBinaryFormatMagic = "MORIARTY";
+inline constexpr int64_t kBinaryFormatVersion = 1;
+inline constexpr absl::string_view kShardFormatMagic = "MSHARD";
+inline constexpr absl::string_view kCheckpointFormatMagic = "MCHECKPOINT";
+
+// The variables used to encode and decode values, by name.
+using VariablesByName =
+    absl::flat_hash_map<std::string, const AbstractVariable*>;
+
+// GetVariablesByName()
+//
+// Returns the variables in `variables`, by name. The returned pointers are
+// owned by `variables`.
+VariablesByName GetVariablesByName(const VariableSet& variables);
+
+// AppendBinaryFormatHeader()
+//
+// Appends the magic string and version of the binary format to `out`.
+void AppendBinaryFormatHeader(std::string& out);
+
+// ReadBinaryFormatHeader()
+//
+// Reads the header written by `AppendBinaryFormatHeader()` from the front of
+// `in` and removes it. Returns kInvalidArgument if `in` does not start with a
+// header of a version this library can read.
+absl::Status ReadBinaryFormatHeader(absl::string_view& in);
+
+// AppendEncodedTestCase()
+//
+// Appends the encoding of the test case `values` to `out`. `variables` must
+// contain the variable for every value in `values`; values of other names are
+// not encoded.
+absl::Status AppendEncodedTestCase(const ValueSet& values,
+                                   const VariablesByName& variables,
+                                   std::string& out);
+
+// FingerprintTestCase()
+//
+// Returns a 128-bit fingerprint (see `Digest128`) of the values in `values`
+// that `AppendEncodedTestCase()` would encode. Test cases with the same values
+// have the same fingerprint and, barring hash collisions, different values
+// give different fingerprints. The values are hashed one at a time, so only
+// one value's encoding is held in memory at once.
+//
+// Returns kUnimplemented if some value cannot be encoded, and
+// kFailedPrecondition if some value has no variable in `variables`.
+absl::StatusOr<absl::uint128> FingerprintTestCase(
+    const ValueSet& values, const VariablesByName& variables);
+
+// ReadEncodedTestCase()
+//
+// Decodes a test case written by `AppendEncodedTestCase()` from the front of
+// `in` into `values`, and removes it from `in`.
+absl::Status ReadEncodedTestCase(absl::string_view& in,
+                                 const VariablesByName& variables,
+                                 ValueSet& values);
+
+// SkipEncodedTestCase()
+//
+// Removes a test case written by `AppendEncodedTestCase()` from the front of
+// `in` without decoding its values. Only its size prefix is read.
+absl::Status SkipEncodedTestCase(absl::string_view& in);
+
+// EncodeValueSets()
+//
+// Returns `value_sets` in the binary format (header included).
+absl::StatusOr<std::string> EncodeValueSets(
+    absl::Span<const ValueSet> value_sets, const VariablesByName& variables);
+
+// DecodeValueSets()
+//
+// Decodes the output of `EncodeValueSets()` using the same `variables`.
+absl::StatusOr<std::vector<ValueSet>> DecodeValueSets(
+    absl::string_view encoded, const VariablesByName& variables);
+
+// AppendShardHeader()
+//
+// Appends the header of shard number `shard_index` (0-based) out of
+// `num_shards` to `out`.
+void AppendShardHeader(int64_t shard_index, int64_t num_shards,
+                       std::string& out);
+
+// ReadShardHeader()
+//
+// Reads the header written by `AppendShardHeader()` from the front of `in`,
+// removes it and stores its shard index and number of shards.
+absl::Status ReadShardHeader(absl::string_view& in, int64_t& shard_index,
+                             int64_t& num_shards);
+
+// AppendCheckpointHeader()
+//
+// Appends the header of a checkpoint of the run identified by `run_key` to
+// `out`.
+void AppendCheckpointHeader(absl::string_view run_key, std::string& out);
+
+// ReadCheckpointHeader()
+//
+// Reads the header written by `AppendCheckpointHeader()` from the front of
+// `in`, removes it and stores its run key.
+absl::Status ReadCheckpointHeader(absl::string_view& in, std::string& run_key);
+
+// AppendShardWorkItem()
+//
+// Appends the work item for call `call` of the generator `generator_name`
+// (at index `generator_index`) to `out`. `test_cases` are the test cases
+// generated by the call, or the reason it failed. See `AppendEncodedTestCase()`
+// for the requirements on `variables`.
+absl::Status AppendShardWorkItem(
+    int64_t generator_index, absl::string_view generator_name, int64_t call,
+    const absl::StatusOr<std::vector<ValueSet>>& test_cases,
+    const VariablesByName& variables, std::string& out);
+
+// AppendCheckpointBudgetUsage()
+//
+// Appends the work done by a checkpointed generator call (which is charged to
+// its generator's budget when the call is read back) to `out`.
+void AppendCheckpointBudgetUsage(const GenerationUsage& usage,
+                                 std::string& out);
+
+// ReadCheckpointBudgetUsage()
+//
+// Reads the usage written by `AppendCheckpointBudgetUsage()` from the front of
+// `in`, removes it and stores it in `usage`.
+absl::Status ReadCheckpointBudgetUsage(absl::string_view& in,
+                                       GenerationUsage& usage);
+
+// A work item read from a shard. Its test cases are not decoded (they may
+// only be decoded with the variables of the test cases of that call).
+struct ShardWorkItem {
+  int64_t generator_index = 0;
+  std::string generator_name;
+  int64_t call = 0;
+  // If not ok, the call failed and there are no test cases.
+  absl::Status status;
+  int64_t num_test_cases = 0;
+  // The encoded test cases. Read them with `ReadEncodedTestCase()`.
+  absl::string_view test_cases;
+};
+
+// ReadShardWorkItem()
+//
+// Reads a work item written by `AppendShardWorkItem()` from the front of `in`
+// into `work_item`, and removes it from `in`. `work_item.test_cases` points
+// into `in`.
+absl::Status ReadShardWorkItem(absl::string_view& in,
+                               ShardWorkItem& work_item);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_BINARY_FORMAT_H_
@@ -0,0 +1,362 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/binary_format.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "src/internal/value_codec.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/testing/mtest_type.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::moriarty_testing::MTestType;
+using ::moriarty_testing::TestType;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Key;
+using ::testing::Ne;
+using ::testing::UnorderedElementsAre;
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+
+TEST(BinaryFormatTest, HeaderRoundTrips) {
+  std::string encoded;
+  AppendBinaryFormatHeader(encoded);
+  EXPECT_THAT(encoded, ::testing::StartsWith("MORIARTY"));
+
+  absl::string_view in = encoded;
+  MORIARTY_EXPECT_OK(ReadBinaryFormatHeader(in));
+  EXPECT_THAT(in, IsEmpty());
+}
+
+TEST(BinaryFormatTest, ReadingAHeaderWithTheWrongMagicOrVersionFails) {
+  absl::string_view text = "3\n1 2 3\n";
+  EXPECT_THAT(ReadBinaryFormatHeader(text),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("magic string")));
+
+  std::string future = std::string(kBinaryFormatMagic);
+  AppendVarint(kBinaryFormatVersion + 1, future);
+  absl::string_view in = future;
+  EXPECT_THAT(ReadBinaryFormatHeader(in),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not supported")));
+}
+
+TEST(BinaryFormatTest, GetVariablesByNameReturnsAllVariables) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger()));
+  MORIARTY_ASSERT_OK(variables.AddVariable("S", MString()));
+  EXPECT_THAT(GetVariablesByName(variables),
+              UnorderedElementsAre(Key("N"), Key("S")));
+}
+
+TEST(BinaryFormatTest, TestCasesCanBeReadOneAtATime) {
+  MInteger n;
+  VariablesByName variables = {{"N", &n}};
+  std::string encoded;
+  for (int64_t value : {3, 1, 4}) {
+    ValueSet values;
+    values.Set<MInteger>("N", value);
+    MORIARTY_ASSERT_OK(AppendEncodedTestCase(values, variables, encoded));
+  }
+
+  absl::string_view in = encoded;
+  std::vector<int64_t> decoded;
+  while (!in.empty()) {
+    ValueSet values;
+    MORIARTY_ASSERT_OK(ReadEncodedTestCase(in, variables, values));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t value, values.Get<MInteger>("N"));
+    decoded.push_back(value);
+  }
+  EXPECT_THAT(decoded, ElementsAre(3, 1, 4));
+}
+
+TEST(BinaryFormatTest, TestCasesCanBeSkippedWithoutDecodingThem) {
+  MInteger n;
+  VariablesByName variables = {{"N", &n}};
+  std::string encoded;
+  for (int64_t value : {3, 1, 4}) {
+    ValueSet values;
+    values.Set<MInteger>("N", value);
+    MORIARTY_ASSERT_OK(AppendEncodedTestCase(values, variables, encoded));
+  }
+
+  absl::string_view in = encoded;
+  MORIARTY_ASSERT_OK(SkipEncodedTestCase(in));
+  MORIARTY_ASSERT_OK(SkipEncodedTestCase(in));
+  ValueSet values;
+  MORIARTY_ASSERT_OK(ReadEncodedTestCase(in, variables, values));
+  EXPECT_THAT(values.Get<MInteger>("N"), IsOkAndHolds(4));
+  EXPECT_THAT(in, IsEmpty());
+
+  in = absl::string_view(encoded).substr(0, encoded.size() - 1);
+  MORIARTY_ASSERT_OK(SkipEncodedTestCase(in));
+  MORIARTY_ASSERT_OK(SkipEncodedTestCase(in));
+  EXPECT_THAT(SkipEncodedTestCase(in),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("truncated")));
+}
+
+TEST(BinaryFormatTest, ShardHeaderRoundTrips) {
+  std::string encoded;
+  AppendShardHeader(2, 7, encoded);
+
+  absl::string_view in = encoded;
+  int64_t shard_index, num_shards;
+  MORIARTY_ASSERT_OK(ReadShardHeader(in, shard_index, num_shards));
+  EXPECT_EQ(shard_index, 2);
+  EXPECT_EQ(num_shards, 7);
+  EXPECT_THAT(in, IsEmpty());
+
+  // A shard is not a list of test cases (and vice versa).
+  in = encoded;
+  EXPECT_THAT(ReadBinaryFormatHeader(in),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(BinaryFormatTest, CheckpointHeaderRoundTrips) {
+  std::string encoded;
+  AppendCheckpointHeader("seed: 1,2,3", encoded);
+
+  absl::string_view in = encoded;
+  std::string run_key;
+  MORIARTY_ASSERT_OK(ReadCheckpointHeader(in, run_key));
+  EXPECT_EQ(run_key, "seed: 1,2,3");
+  EXPECT_THAT(in, IsEmpty());
+
+  // A checkpoint is not a shard (and vice versa).
+  in = encoded;
+  int64_t shard_index, num_shards;
+  EXPECT_THAT(ReadShardHeader(in, shard_index, num_shards),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  in = absl::string_view(encoded).substr(0, encoded.size() - 1);
+  EXPECT_THAT(ReadCheckpointHeader(in, run_key),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(BinaryFormatTest, CheckpointBudgetUsageRoundTrips) {
+  std::string encoded;
+  AppendCheckpointBudgetUsage(
+      {.generate_calls = 12, .bytes = 345, .wall_time = absl::Seconds(6)},
+      encoded);
+
+  absl::string_view in = encoded;
+  GenerationUsage usage;
+  MORIARTY_ASSERT_OK(ReadCheckpointBudgetUsage(in, usage));
+  EXPECT_EQ(usage.generate_calls, 12);
+  EXPECT_EQ(usage.bytes, 345);
+  EXPECT_EQ(usage.wall_time, absl::Seconds(6));
+  EXPECT_THAT(in, IsEmpty());
+
+  in = absl::string_view(encoded).substr(0, encoded.size() - 1);
+  EXPECT_THAT(ReadCheckpointBudgetUsage(in, usage),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(BinaryFormatTest, ShardWorkItemsRoundTrip) {
+  MInteger n;
+  VariablesByName variables = {{"N", &n}};
+  std::vector<ValueSet> test_cases(2);
+  test_cases[0].Set<MInteger>("N", 10);
+  test_cases[1].Set<MInteger>("N", -20);
+
+  std::string encoded;
+  MORIARTY_ASSERT_OK(
+      AppendShardWorkItem(3, "Gen", 5, test_cases, variables, encoded));
+  MORIARTY_ASSERT_OK(AppendShardWorkItem(
+      4, "Failing", 1, absl::NotFoundError("oops"), variables, encoded));
+
+  absl::string_view in = encoded;
+  ShardWorkItem work_item;
+  MORIARTY_ASSERT_OK(ReadShardWorkItem(in, work_item));
+  EXPECT_EQ(work_item.generator_index, 3);
+  EXPECT_EQ(work_item.generator_name, "Gen");
+  EXPECT_EQ(work_item.call, 5);
+  MORIARTY_EXPECT_OK(work_item.status);
+  ASSERT_EQ(work_item.num_test_cases, 2);
+  std::vector<int64_t> decoded;
+  while (!work_item.test_cases.empty()) {
+    ValueSet values;
+    MORIARTY_ASSERT_OK(
+        ReadEncodedTestCase(work_item.test_cases, variables, values));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t value, values.Get<MInteger>("N"));
+    decoded.push_back(value);
+  }
+  EXPECT_THAT(decoded, ElementsAre(10, -20));
+
+  MORIARTY_ASSERT_OK(ReadShardWorkItem(in, work_item));
+  EXPECT_EQ(work_item.generator_name, "Failing");
+  EXPECT_THAT(work_item.status,
+              StatusIs(absl::StatusCode::kNotFound, HasSubstr("oops")));
+  EXPECT_EQ(work_item.num_test_cases, 0);
+  EXPECT_THAT(work_item.test_cases, IsEmpty());
+  EXPECT_THAT(in, IsEmpty());
+}
+
+TEST(BinaryFormatTest, ReadingATruncatedShardWorkItemFails) {
+  MInteger n;
+  VariablesByName variables = {{"N", &n}};
+  std::vector<ValueSet> test_cases(1);
+  test_cases[0].Set<MInteger>("N", 123456);
+  std::string encoded;
+  MORIARTY_ASSERT_OK(
+      AppendShardWorkItem(0, "Gen", 1, test_cases, variables, encoded));
+
+  absl::string_view in = absl::string_view(encoded).substr(
+      0, encoded.size() - 1);
+  ShardWorkItem work_item;
+  EXPECT_THAT(ReadShardWorkItem(in, work_item),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("truncated")));
+}
+
+TEST(BinaryFormatTest, BinaryIsSmallerThanText) {
+  MArray<MInteger> a;
+  VariablesByName variables = {{"A", &a}};
+  std::vector<int64_t> array;
+  std::string text;
+  for (int64_t i = 0; i < 1000; i++) {
+    array.push_back(i * 1000);
+    text += std::to_string(i * 1000) + " ";
+  }
+  std::vector<ValueSet> value_sets(1);
+  value_sets[0].Set<MArray<MInteger>>("A", array);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::string encoded,
+                                EncodeValueSets(value_sets, variables));
+  EXPECT_LT(encoded.size(), text.size() / 2);
+}
+
+TEST(BinaryFormatTest, ValueSetsRoundTrip) {
+  MInteger n;
+  MString s;
+  MArray<MInteger> a;
+  VariablesByName variables = {
+      {"N", &n}, {"S", &s}, {"A", &a}};
+
+  std::vector<ValueSet> value_sets(2);
+  value_sets[0].Set<MInteger>("N", -5);
+  value_sets[0].Set<MString>("S", "hello");
+  value_sets[0].Set<MArray<MInteger>>("A", {1, 2, 3});
+  value_sets[1].Set<MInteger>("N", 10);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::string encoded,
+                                EncodeValueSets(value_sets, variables));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<ValueSet> decoded,
+                                DecodeValueSets(encoded, variables));
+  ASSERT_EQ(decoded.size(), 2);
+  EXPECT_THAT(decoded[0].Get<MInteger>("N"), IsOkAndHolds(-5));
+  EXPECT_THAT(decoded[0].Get<MString>("S"), IsOkAndHolds("hello"));
+  EXPECT_THAT(decoded[0].Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(1, 2, 3)));
+  EXPECT_THAT(decoded[1].Get<MInteger>("N"), IsOkAndHolds(10));
+  EXPECT_FALSE(decoded[1].Contains("S"));
+  EXPECT_EQ(decoded[0].GetApproximateSize(),
+            value_sets[0].GetApproximateSize());
+}
+
+TEST(BinaryFormatTest, EncodingValuesWithoutABinaryEncodingFails) {
+  MTestType t;
+  VariablesByName variables = {
+      {"T", &t}};
+  std::vector<ValueSet> value_sets(1);
+  value_sets[0].Set<MTestType>("T", TestType(3));
+
+  EXPECT_THAT(EncodeValueSets(value_sets, variables),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+TEST(BinaryFormatTest, FingerprintsAreEqualExactlyForEqualValues) {
+  MInteger n;
+  MArray<MInteger> a;
+  VariablesByName variables = {{"N", &n}, {"A", &a}};
+
+  auto fingerprint = [&](int64_t n_value, std::vector<int64_t> a_value) {
+    ValueSet values;
+    values.Set<MInteger>("N", n_value);
+    values.Set<MArray<MInteger>>("A", std::move(a_value));
+    return FingerprintTestCase(values, variables);
+  };
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(absl::uint128 original,
+                                fingerprint(3, {1, 2, 3}));
+  EXPECT_THAT(fingerprint(3, {1, 2, 3}), IsOkAndHolds(original));
+  EXPECT_THAT(fingerprint(4, {1, 2, 3}), IsOkAndHolds(Ne(original)));
+  EXPECT_THAT(fingerprint(3, {1, 2, 4}), IsOkAndHolds(Ne(original)));
+  EXPECT_THAT(fingerprint(3, {1, 2}), IsOkAndHolds(Ne(original)));
+  EXPECT_THAT(FingerprintTestCase(ValueSet(), variables),
+              IsOkAndHolds(Ne(original)));
+}
+
+TEST(BinaryFormatTest, FingerprintingValuesWithoutABinaryEncodingFails) {
+  MTestType t;
+  VariablesByName variables = {{"T", &t}};
+  ValueSet values;
+  values.Set<MTestType>("T", TestType(3));
+
+  EXPECT_THAT(FingerprintTestCase(values, variables),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+TEST(BinaryFormatTest, FingerprintingValuesWithoutAVariableFails) {
+  MInteger n;
+  VariablesByName variables = {{"N", &n}};
+  ValueSet values;
+  values.Set<MInteger>("N", 1);
+  values.Set<MInteger>("M", 2);
+
+  EXPECT_THAT(FingerprintTestCase(values, variables),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(BinaryFormatTest, DecodingCorruptValueSetsFails) {
+  MInteger n;
+  VariablesByName variables = {
+      {"N", &n}};
+  std::vector<ValueSet> value_sets(1);
+  value_sets[0].Set<MInteger>("N", 1234567);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::string encoded,
+                                EncodeValueSets(value_sets, variables));
+
+  EXPECT_THAT(DecodeValueSets(encoded.substr(0, encoded.size() - 1), variables),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(DecodeValueSets(encoded + "x", variables),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(DecodeValueSets(encoded, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
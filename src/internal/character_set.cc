@@ -0,0 +1,73 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/character_set.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+CharacterSet::CharacterSet(absl::string_view characters) {
+  for (char c : characters) {
+    uint8_t u = static_cast<uint8_t>(c);
+    bitmap_[u / 64] |= uint64_t{1} << (u % 64);
+  }
+  // Sorted by `char`, not `uint8_t`, to match sorting a `std::string`.
+  for (int c = -128; c < 128; c++)
+    if (Contains(static_cast<char>(c))) characters_.push_back(c);
+}
+
+size_t CharacterSet::FindFirstNotInSet(absl::string_view str) const {
+  // Check blocks of characters without branching on each one, so the common
+  // case (every character is valid) is a straight scan.
+  constexpr size_t kBlockSize = 16;
+  size_t i = 0;
+  for (; i + kBlockSize <= str.size(); i += kBlockSize) {
+    bool all_valid = true;
+    for (size_t j = i; j < i + kBlockSize; j++) all_valid &= Contains(str[j]);
+    if (!all_valid) break;
+  }
+  for (; i < str.size(); i++)
+    if (!Contains(str[i])) return i;
+  return absl::string_view::npos;
+}
+
+void CharacterSet::IntersectWith(const CharacterSet& other) {
+  for (int i = 0; i < bitmap_.size(); i++) bitmap_[i] &= other.bitmap_[i];
+  characters_.erase(
+      std::remove_if(characters_.begin(), characters_.end(),
+                     [this](char c) { return !Contains(c); }),
+      characters_.end());
+}
+
+size_t FindFirstDuplicateCharacter(absl::string_view str) {
+  std::array<uint64_t, 4> seen = {};
+  for (size_t i = 0; i < str.size(); i++) {
+    uint8_t c = static_cast<uint8_t>(str[i]);
+    uint64_t bit = uint64_t{1} << (c % 64);
+    if (seen[c / 64] & bit) return i;
+    seen[c / 64] |= bit;
+  }
+  return absl::string_view::npos;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
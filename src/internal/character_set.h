@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_CHARACTER_SET_H_
+#define MORIARTY_SRC_INTERNAL_CHARACTER_SET_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// CharacterSet
+//
+// A set of characters, stored both as a 256-bit bitmap (for membership
+// checks) and as a sorted string of the distinct characters (for iteration and
+// random access). A default-constructed `CharacterSet` is empty.
+class CharacterSet {
+ public:
+  CharacterSet() = default;
+
+  // Creates the set of characters in `characters`. Duplicates are ignored and
+  // the order of `characters` does not matter.
+  explicit CharacterSet(absl::string_view characters);
+
+  // Contains()
+  //
+  // Returns true if `character` is in this set.
+  bool Contains(char character) const {
+    uint8_t c = static_cast<uint8_t>(character);
+    return (bitmap_[c / 64] >> (c % 64)) & 1;
+  }
+
+  // FindFirstNotInSet()
+  //
+  // Returns the index of the first character of `str` that is not in this
+  // set, or `absl::string_view::npos` if every character is in the set.
+  size_t FindFirstNotInSet(absl::string_view str) const;
+
+  // IntersectWith()
+  //
+  // Removes all characters from this set that are not in `other`.
+  void IntersectWith(const CharacterSet& other);
+
+  // Characters()
+  //
+  // Returns the characters in this set, sorted and without duplicates.
+  const std::string& Characters() const { return characters_; }
+
+  // size()
+  //
+  // Returns the number of distinct characters in this set.
+  int size() const { return characters_.size(); }
+  bool empty() const { return characters_.empty(); }
+
+  friend bool operator==(const CharacterSet& a, const CharacterSet& b) {
+    return a.bitmap_ == b.bitmap_;
+  }
+
+ private:
+  std::array<uint64_t, 4> bitmap_ = {};
+  std::string characters_;
+};
+
+// FindFirstDuplicateCharacter()
+//
+// Returns the index of the first character of `str` that also appears earlier
+// in `str`, or `absl::string_view::npos` if all characters are distinct.
+size_t FindFirstDuplicateCharacter(absl::string_view str);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_CHARACTER_SET_H_
@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/character_set.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+TEST(CharacterSetTest, DefaultIsEmpty) {
+  CharacterSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.size(), 0);
+  EXPECT_FALSE(set.Contains('a'));
+  EXPECT_FALSE(set.Contains('\0'));
+}
+
+TEST(CharacterSetTest, CharactersAreSortedAndDistinct) {
+  CharacterSet set("cabbac");
+  EXPECT_EQ(set.Characters(), "abc");
+  EXPECT_EQ(set.size(), 3);
+  EXPECT_TRUE(set.Contains('a'));
+  EXPECT_TRUE(set.Contains('c'));
+  EXPECT_FALSE(set.Contains('d'));
+}
+
+TEST(CharacterSetTest, NegativeCharactersWork) {
+  CharacterSet set("\xff" "a\x80");
+  EXPECT_EQ(set.Characters(), "\x80\xff" "a");
+  EXPECT_TRUE(set.Contains('\xff'));
+  EXPECT_TRUE(set.Contains('\x80'));
+  EXPECT_FALSE(set.Contains('\x7f'));
+}
+
+TEST(CharacterSetTest, FindFirstNotInSetFindsTheFirstInvalidCharacter) {
+  CharacterSet set("ab");
+  EXPECT_EQ(set.FindFirstNotInSet(""), absl::string_view::npos);
+  EXPECT_EQ(set.FindFirstNotInSet("abba"), absl::string_view::npos);
+  EXPECT_EQ(set.FindFirstNotInSet("abca"), 2);
+  EXPECT_EQ(set.FindFirstNotInSet("c"), 0);
+
+  // Long enough to use blocks of characters.
+  std::string long_str(1000, 'a');
+  EXPECT_EQ(set.FindFirstNotInSet(long_str), absl::string_view::npos);
+  long_str[517] = 'x';
+  long_str[900] = 'y';
+  EXPECT_EQ(set.FindFirstNotInSet(long_str), 517);
+}
+
+TEST(CharacterSetTest, IntersectWithKeepsCommonCharacters) {
+  CharacterSet set("abcdef");
+  set.IntersectWith(CharacterSet("fedxyz"));
+  EXPECT_EQ(set.Characters(), "def");
+  EXPECT_FALSE(set.Contains('a'));
+  EXPECT_FALSE(set.Contains('x'));
+  EXPECT_EQ(set, CharacterSet("dfe"));
+}
+
+TEST(CharacterSetTest, FindFirstDuplicateCharacterWorks) {
+  EXPECT_EQ(FindFirstDuplicateCharacter(""), absl::string_view::npos);
+  EXPECT_EQ(FindFirstDuplicateCharacter("abc"), absl::string_view::npos);
+  EXPECT_EQ(FindFirstDuplicateCharacter("abcb"), 3);
+  EXPECT_EQ(FindFirstDuplicateCharacter("\xff\xff"), 1);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
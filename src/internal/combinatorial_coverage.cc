@@ -14,44 +14,105 @@
 
 #include "src/internal/combinatorial_coverage.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 
 namespace moriarty {
 
 namespace {
 
-// We use bitmasks to reduce memory overhead. This limits the size to <= 62. If
-// more dimensions are needed, we may wish to have a non-bit version since its
-// likely the strength is small in that case.
-using BitMask = uint64_t;
-constexpr uint64_t ONE = 1;  // To avoid `(uint64_t)1 << val`
-
 using SerializedTestCase = int64_t;
 
+// Marks a dimension of a partial test case that has not been assigned yet.
+constexpr int kDontCare = -1;
+
+// When a scheduler is available, each task handles this many ColumnSets.
+constexpr int64_t kColumnSetsPerTask = 256;
+
+// A fixed number of bits, packed into words so that up to 64 consecutive bits
+// can be read at once.
+class Bitset {
+ public:
+  explicit Bitset(int64_t size) : size_(size), words_((size + 63) / 64, 0) {}
+
+  int64_t size() const { return size_; }
+  bool Test(int64_t i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+  void Set(int64_t i) { words_[i / 64] |= uint64_t{1} << (i % 64); }
+
+  // Returns bits [start, start + count) as the lowest bits. Requires
+  // 0 < count <= 64.
+  uint64_t GetBits(int64_t start, int count) const {
+    int offset = start % 64;
+    uint64_t bits = words_[start / 64] >> offset;
+    if (offset + count > 64) bits |= words_[start / 64 + 1] << (64 - offset);
+    return count == 64 ? bits : bits & ((uint64_t{1} << count) - 1);
+  }
+
+ private:
+  int64_t size_;
+  std::vector<uint64_t> words_;
+};
+
 // Represents a subset of the columns and which (partial) test cases we have
-// covered in those columns. The `covered` array stores which of the
+// covered in those columns. The `covered` bitset stores which of the
 //
 //    `dim_1_size * dim_2_size * ... * dim_strength_size`
 //
-// partial test cases for this `column_mask` have been seen. The `covered` array
+// partial test cases for these `columns` have been seen. The `covered` bitset
 // corresponds to the test cases in lexicographic order.
 struct ColumnSet {
-  BitMask column_mask;          // Which columns?
+  std::vector<int> columns;     // Which columns? In increasing order.
   int64_t remaining_uncovered;  // How many partial cases are not covered?
-  std::vector<bool> covered;    // Some case covers the serialized partial case.
+  Bitset covered;               // Some case covers the serialized partial case.
 };
 
+// The number of ranges ForEachColumnSetChunk() splits `num_column_sets` into.
+int64_t NumColumnSetChunks(int64_t num_column_sets) {
+  return (num_column_sets + kColumnSetsPerTask - 1) / kColumnSetsPerTask;
+}
+
+// Calls `fn(chunk, begin, end)` for consecutive ranges [begin, end) that
+// together cover [0, num_column_sets), where `chunk` is the index of the range.
+// The ranges are handled in parallel on `scheduler`, if it is not null.
+void ForEachColumnSetChunk(
+    int64_t num_column_sets, moriarty_internal::Scheduler* scheduler,
+    absl::FunctionRef<void(int chunk, int64_t begin, int64_t end)> fn) {
+  int num_chunks = NumColumnSetChunks(num_column_sets);
+  auto run_chunk = [&](int chunk) {
+    int64_t begin = chunk * kColumnSetsPerTask;
+    fn(chunk, begin, std::min(num_column_sets, begin + kColumnSetsPerTask));
+  };
+  if (scheduler == nullptr || num_chunks <= 1) {
+    for (int chunk = 0; chunk < num_chunks; chunk++) run_chunk(chunk);
+  } else {
+    scheduler->ParallelFor(num_chunks, run_chunk);
+  }
+}
+
 // SerializePartialTestCase()
 //
-// Compresses the projection of a test case into a single integer. The bits set
-// in `mask` are the only dimensions considered (projection onto these
+// Compresses the projection of a test case into a single integer. The
+// `columns` are the only dimensions considered (projection onto these
 // dimensions). For the projection, compresses the values into a single integer,
 // the lexicographic order of this test case.
 //
@@ -61,15 +122,13 @@ struct ColumnSet {
 //  3 = (0, 0, 1, 0)
 //   ...
 //
-// Assumes 0 <= test_cases[i] < dimension_sizes[i].
+// Assumes 0 <= test_cases[i] < dimension_sizes[i] for all i in `columns`.
 SerializedTestCase SerializePartialTestCase(
-    BitMask mask, const CoveringArrayTestCase& test_case,
+    absl::Span<const int> columns, const CoveringArrayTestCase& test_case,
     absl::Span<const int> dimension_sizes) {
   SerializedTestCase result = 0;
-  for (int i = 0; i < dimension_sizes.size(); i++) {
-    if ((mask >> i) & ONE)
-      result = test_case.test_case[i] + result * dimension_sizes[i];
-  }
+  for (int i : columns)
+    result = test_case.test_case[i] + result * dimension_sizes[i];
   return result;
 }
 
@@ -78,33 +137,52 @@ SerializedTestCase SerializePartialTestCase(
 // Opposite of SerializePartialTestCase(). Takes the serialized value and
 // deserializes the appropriate fields into `partial_test_case`. All other
 // fields are ignored.
-void DeserializePartialTestCaseInto(BitMask mask,
+void DeserializePartialTestCaseInto(absl::Span<const int> columns,
                                     SerializedTestCase serialized_value,
                                     absl::Span<const int> dimension_sizes,
                                     CoveringArrayTestCase& partial_test_case) {
-  for (int i = (int)dimension_sizes.size() - 1; i >= 0; i--) {
-    if (!((mask >> i) & ONE)) continue;
-    partial_test_case.test_case[i] = serialized_value % dimension_sizes[i];
-    serialized_value /= dimension_sizes[i];
+  for (int i = (int)columns.size() - 1; i >= 0; i--) {
+    int column = columns[i];
+    partial_test_case.test_case[column] =
+        serialized_value % dimension_sizes[column];
+    serialized_value /= dimension_sizes[column];
   }
   ABSL_CHECK_EQ(serialized_value, 0);
 }
 
 // GetAllNChooseK()
 //
-// Returns a list of all bitmasks of with n bits and k 1s.
-std::vector<BitMask> GetAllNChooseK(int n, int k) {
-  std::vector<BitMask> masks;
-
-  // Magic bit-hack. Requires #bits <= 62.
-  BitMask mask = (ONE << k) - 1;
-  while (mask < (ONE << n)) {
-    masks.push_back(mask);
-    BitMask rightmost_bit = mask & (-mask);
-    BitMask upper = mask + rightmost_bit;
-    mask = upper | ((mask ^ upper) / rightmost_bit) >> 2;
+// Returns all subsets of {0, 1, ... , n - 1} of size k, each in increasing
+// order. The subsets are ordered by their largest element, then by their
+// second largest, and so on (the order of the corresponding bitmasks).
+std::vector<std::vector<int>> GetAllNChooseK(int n, int k) {
+  std::vector<std::vector<int>> subsets;
+  if (k > n) return subsets;
+
+  std::vector<int> subset(k);
+  absl::c_iota(subset, 0);
+  while (true) {
+    subsets.push_back(subset);
+
+    // Increment the smallest element that can be, and reset all before it.
+    int i = 0;
+    while (i < k && subset[i] + 1 == (i + 1 < k ? subset[i + 1] : n)) i++;
+    if (i == k) break;
+    subset[i]++;
+    for (int j = 0; j < i; j++) subset[j] = j;
   }
-  return masks;
+  return subsets;
+}
+
+// Creates the ColumnSet for `columns` with nothing covered.
+ColumnSet MakeColumnSet(std::vector<int> columns,
+                        absl::Span<const int> dimension_sizes) {
+  int64_t partial_test_case_size = 1;
+  for (int i : columns) partial_test_case_size *= dimension_sizes[i];
+
+  return ColumnSet({.columns = std::move(columns),
+                    .remaining_uncovered = partial_test_case_size,
+                    .covered = Bitset(partial_test_case_size)});
 }
 
 // Find some test case to add.
@@ -115,9 +193,14 @@ std::vector<BitMask> GetAllNChooseK(int n, int k) {
 //     chosen columns and randomly selects one of those uncovered partial test
 //     cases.
 // (3) Repeat (2) until all columns have been covered.
+//
+// `rand` is called as `rand(n)` (see GenerateCoveringArray()). It is a
+// template parameter rather than a `std::function` so that the calls can be
+// inlined.
+template <typename Rand>
 std::optional<CoveringArrayTestCase> FindTestCaseToAdd(
     absl::Span<const ColumnSet> column_sets,
-    absl::Span<const int> dimension_sizes, std::function<int(int)> rand) {
+    absl::Span<const int> dimension_sizes, Rand& rand) {
   // Sort column_sets by number of remaining uncovered partial test cases. We
   // sort the indices rather than the columns themselves.
   std::vector<int64_t> column_set_index(column_sets.size());
@@ -134,31 +217,31 @@ std::optional<CoveringArrayTestCase> FindTestCaseToAdd(
     return std::nullopt;
 
   // `used` is the set of columns do we already have a value for.
-  BitMask used_mask = 0;
-
   int n = dimension_sizes.size();
+  std::vector<bool> used(n, false);
+
   CoveringArrayTestCase result_test_case({.test_case = std::vector<int>(n)});
   for (int i = 0; i < column_set_index.size(); i++) {
     const ColumnSet& column_set = column_sets[column_set_index[i]];
-    if (used_mask & column_set.column_mask) continue;
+    if (absl::c_any_of(column_set.columns, [&](int c) { return used[c]; }))
+      continue;
     if (column_set.remaining_uncovered == 0) continue;
 
     // Choose a random value that hasn't been seen before.
     int64_t projected_value;
     while (true) {
       projected_value = rand(column_set.covered.size());
-      if (!column_set.covered[projected_value]) break;
+      if (!column_set.covered.Test(projected_value)) break;
     }
 
-    DeserializePartialTestCaseInto(column_set.column_mask, projected_value,
+    DeserializePartialTestCaseInto(column_set.columns, projected_value,
                                    dimension_sizes, result_test_case);
-    used_mask |= column_set.column_mask;
+    for (int c : column_set.columns) used[c] = true;
   }
 
   // At this point, some fields may not be set still. Randomly assign those now.
   for (int i = 0; i < n; i++) {
-    if (!((used_mask >> i) & ONE))
-      result_test_case.test_case[i] = rand(dimension_sizes[i]);
+    if (!used[i]) result_test_case.test_case[i] = rand(dimension_sizes[i]);
   }
   return result_test_case;
 }
@@ -169,39 +252,338 @@ void UpdateColumnSet(const CoveringArrayTestCase& test_case,
                      absl::Span<const int> dimension_sizes,
                      ColumnSet& column_set) {
   SerializedTestCase serial_test_case = SerializePartialTestCase(
-      column_set.column_mask, test_case, dimension_sizes);
+      column_set.columns, test_case, dimension_sizes);
 
-  if (column_set.covered[serial_test_case]) return;  // Already covered.
-  column_set.covered[serial_test_case] = true;
+  if (column_set.covered.Test(serial_test_case)) return;  // Already covered.
+  column_set.covered.Set(serial_test_case);
   column_set.remaining_uncovered--;
 }
 
+// Returns if `test_case` has a value (not kDontCare) in all of `columns`.
+bool HasValuesIn(const CoveringArrayTestCase& test_case,
+                 absl::Span<const int> columns) {
+  return absl::c_none_of(
+      columns, [&](int c) { return test_case.test_case[c] == kDontCare; });
+}
+
+// Marks every partial test case in `column_sets` covered by `test_case`.
+void MarkCovered(const CoveringArrayTestCase& test_case,
+                 absl::Span<const int> dimension_sizes,
+                 absl::Span<ColumnSet> column_sets,
+                 moriarty_internal::Scheduler* scheduler) {
+  ForEachColumnSetChunk(
+      column_sets.size(), scheduler, [&](int, int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          if (HasValuesIn(test_case, column_sets[i].columns))
+            UpdateColumnSet(test_case, dimension_sizes, column_sets[i]);
+        }
+      });
+}
+
 // Create all (n choose strength) column sets. Each set of columns will have its
 // `covered` array set to the appropriate number of values.
 std::vector<ColumnSet> InitializeColumnSets(
     int n, int strength, absl::Span<const int> dimension_sizes) {
-  std::vector<BitMask> masks = GetAllNChooseK(n, strength);
+  std::vector<std::vector<int>> subsets = GetAllNChooseK(n, strength);
   std::vector<ColumnSet> column_sets;
-  column_sets.reserve(masks.size());
+  column_sets.reserve(subsets.size());
 
-  for (BitMask mask : masks) {
-    int64_t partial_test_case_size = 1;
-    for (int i = 0; i < dimension_sizes.size(); i++)
-      if ((mask >> i) & ONE) partial_test_case_size *= dimension_sizes[i];
+  for (std::vector<int>& columns : subsets)
+    column_sets.push_back(MakeColumnSet(std::move(columns), dimension_sizes));
+  return column_sets;
+}
 
-    column_sets.push_back(ColumnSet(
-        {.column_mask = mask,
-         .remaining_uncovered = partial_test_case_size,
-         .covered = std::vector<bool>(partial_test_case_size, false)}));
+// Each test case is final as soon as it is found, so it is passed to `on_row`
+// right away.
+template <typename Rand>
+void GenerateRandomizedGreedyCoveringArray(
+    absl::Span<const int> dimension_sizes, int strength, Rand& rand,
+    moriarty_internal::Scheduler* scheduler, CoveringArrayRowCallback on_row) {
+  int n = dimension_sizes.size();
+  std::vector<ColumnSet> column_sets =
+      InitializeColumnSets(n, strength, dimension_sizes);
+
+  while (true) {
+    std::optional<CoveringArrayTestCase> test_case =
+        FindTestCaseToAdd(column_sets, dimension_sizes, rand);
+
+    if (test_case == std::nullopt) break;
+
+    MarkCovered(*test_case, dimension_sizes, absl::MakeSpan(column_sets),
+                scheduler);
+    on_row(*test_case);
   }
-  return column_sets;
 }
 
-}  // namespace
+// Returns, for each value of the last dimension `k`, how many partial test
+// cases in `column_sets` would be newly covered if `test_case` had that value
+// in dimension `k`. Every ColumnSet must end with column `k`. Dimensions of
+// `test_case` that are kDontCare do not cover anything.
+std::vector<int64_t> CountNewlyCoveredByEachValue(
+    const CoveringArrayTestCase& test_case, int k,
+    absl::Span<const int> dimension_sizes,
+    absl::Span<const ColumnSet> column_sets,
+    moriarty_internal::Scheduler* scheduler) {
+  int size = dimension_sizes[k];
+  std::vector<std::vector<int64_t>> chunk_counts(
+      NumColumnSetChunks(column_sets.size()), std::vector<int64_t>(size, 0));
+  ForEachColumnSetChunk(
+      column_sets.size(), scheduler,
+      [&](int chunk, int64_t begin, int64_t end) {
+        std::vector<int64_t>& counts = chunk_counts[chunk];
+        for (int64_t i = begin; i < end; i++) {
+          const ColumnSet& column_set = column_sets[i];
+          absl::Span<const int> other_columns =
+              absl::MakeConstSpan(column_set.columns).first(
+                  column_set.columns.size() - 1);
+          if (!HasValuesIn(test_case, other_columns)) continue;
+
+          // The partial test cases for all values of `k` are consecutive.
+          SerializedTestCase start =
+              SerializePartialTestCase(other_columns, test_case,
+                                       dimension_sizes) *
+              size;
+          if (size <= 64) {
+            uint64_t uncovered = ~column_set.covered.GetBits(start, size);
+            if (size < 64) uncovered &= (uint64_t{1} << size) - 1;
+            for (; uncovered != 0; uncovered &= uncovered - 1)
+              counts[std::countr_zero(uncovered)]++;
+          } else {
+            for (int value = 0; value < size; value++)
+              if (!column_set.covered.Test(start + value)) counts[value]++;
+          }
+        }
+      });
+
+  std::vector<int64_t> counts(size, 0);
+  for (const std::vector<int64_t>& chunk : chunk_counts)
+    for (int value = 0; value < size; value++) counts[value] += chunk[value];
+  return counts;
+}
 
-std::vector<CoveringArrayTestCase> GenerateCoveringArray(
-    std::vector<int> dimension_sizes, int strength,
-    std::function<int(int)> rand) {
+// Returns if `partial_test_case` can be merged into `test_case`.  That is, in
+// each of `columns`, they are equal or `test_case` is kDontCare.
+bool IsCompatible(const CoveringArrayTestCase& test_case,
+                  const CoveringArrayTestCase& partial_test_case,
+                  absl::Span<const int> columns) {
+  return absl::c_all_of(columns, [&](int c) {
+    return test_case.test_case[c] == kDontCare ||
+           test_case.test_case[c] == partial_test_case.test_case[c];
+  });
+}
+
+// The in-parameter-order (IPOG) construction. Starts with all combinations of
+// the first `strength` dimensions, then adds the remaining dimensions one at a
+// time:
+//  * Horizontal growth: each existing test case gets the value for the new
+//    dimension that covers the most uncovered partial test cases.
+//  * Vertical growth: each partial test case that is still uncovered is merged
+//    into an existing test case that has kDontCare in the relevant dimensions,
+//    or added as a new test case.
+// Dimensions that are still kDontCare at the end are assigned randomly.
+//
+// Vertical growth only changes kDontCare dimensions, so a test case is final
+// once horizontal growth of the last dimension has assigned all of its
+// dimensions. The longest prefix of final test cases is passed to `on_row`
+// while the rest are still being grown.
+//
+// Assumes `dimension_sizes` is sorted in non-increasing order, which keeps the
+// initial array (and therefore the result) small.
+template <typename Rand>
+void GenerateIpogCoveringArray(absl::Span<const int> dimension_sizes,
+                               int strength, Rand& rand,
+                               moriarty_internal::Scheduler* scheduler,
+                               CoveringArrayRowCallback on_row) {
+  int n = dimension_sizes.size();
+  const CoveringArrayTestCase empty_test_case(
+      {.test_case = std::vector<int>(n, kDontCare)});
+
+  std::vector<int> initial_columns(strength);
+  absl::c_iota(initial_columns, 0);
+  ColumnSet initial = MakeColumnSet(initial_columns, dimension_sizes);
+  std::vector<CoveringArrayTestCase> result(initial.covered.size(),
+                                            empty_test_case);
+  for (int64_t i = 0; i < result.size(); i++) {
+    DeserializePartialTestCaseInto(initial_columns, i, dimension_sizes,
+                                   result[i]);
+  }
+
+  int64_t num_emitted = 0;
+  auto emit_final_rows = [&] {
+    while (num_emitted < result.size() &&
+           absl::c_none_of(result[num_emitted].test_case,
+                           [](int value) { return value == kDontCare; })) {
+      on_row(result[num_emitted++]);
+    }
+  };
+
+  for (int k = strength; k < n; k++) {
+    // All partial test cases using dimension `k` and `strength - 1` of the
+    // dimensions before it.
+    std::vector<ColumnSet> column_sets;
+    for (std::vector<int>& columns : GetAllNChooseK(k, strength - 1)) {
+      columns.push_back(k);
+      column_sets.push_back(MakeColumnSet(std::move(columns), dimension_sizes));
+    }
+
+    // Horizontal growth
+    for (CoveringArrayTestCase& test_case : result) {
+      std::vector<int64_t> counts = CountNewlyCoveredByEachValue(
+          test_case, k, dimension_sizes, column_sets, scheduler);
+      test_case.test_case[k] = absl::c_max_element(counts) - counts.begin();
+      MarkCovered(test_case, dimension_sizes, absl::MakeSpan(column_sets),
+                  scheduler);
+      if (k == n - 1) emit_final_rows();
+    }
+
+    // Vertical growth
+    for (const ColumnSet& column_set : column_sets) {
+      for (SerializedTestCase serialized = 0;
+           serialized < column_set.covered.size() &&
+           column_set.remaining_uncovered > 0;
+           serialized++) {
+        if (column_set.covered.Test(serialized)) continue;
+
+        CoveringArrayTestCase partial_test_case = empty_test_case;
+        DeserializePartialTestCaseInto(column_set.columns, serialized,
+                                       dimension_sizes, partial_test_case);
+        auto it = absl::c_find_if(result, [&](const CoveringArrayTestCase& tc) {
+          return IsCompatible(tc, partial_test_case, column_set.columns);
+        });
+        if (it == result.end()) {
+          result.push_back(empty_test_case);
+          it = std::prev(result.end());
+        }
+        for (int c : column_set.columns)
+          it->test_case[c] = partial_test_case.test_case[c];
+        MarkCovered(*it, dimension_sizes, absl::MakeSpan(column_sets),
+                    scheduler);
+      }
+    }
+  }
+
+  for (CoveringArrayTestCase& test_case : result) {
+    for (int i = 0; i < n; i++) {
+      if (test_case.test_case[i] == kDontCare)
+        test_case.test_case[i] = rand(dimension_sizes[i]);
+    }
+  }
+  for (; num_emitted < result.size(); num_emitted++)
+    on_row(result[num_emitted]);
+}
+
+bool IsPrime(int p) {
+  if (p < 2) return false;
+  for (int d = 2; d * d <= p; d++)
+    if (p % d == 0) return false;
+  return true;
+}
+
+// Returns a covering array for these parameters if we know how to build one
+// with the fewest possible test cases. These are:
+//  * Strength 1: `max(dimension_sizes)` test cases.
+//  * Strength 2, where the two largest dimensions have size p for some prime
+//    p, and there are at most p + 1 dimensions: the p * p test cases of the
+//    orthogonal array formed by the lines of the affine plane over Z_p. No
+//    array can have fewer, since the two largest dimensions alone need p * p.
+std::optional<std::vector<CoveringArrayTestCase>> KnownOptimalCoveringArray(
+    absl::Span<const int> dimension_sizes, int strength) {
+  int n = dimension_sizes.size();
+  if (strength == 1) {
+    std::vector<CoveringArrayTestCase> result(
+        *absl::c_max_element(dimension_sizes),
+        CoveringArrayTestCase({.test_case = std::vector<int>(n)}));
+    for (int i = 0; i < result.size(); i++) {
+      for (int c = 0; c < n; c++)
+        result[i].test_case[c] = i % dimension_sizes[c];
+    }
+    return result;
+  }
+
+  if (strength != 2) return std::nullopt;
+  std::vector<int> sorted_sizes(dimension_sizes.begin(), dimension_sizes.end());
+  absl::c_sort(sorted_sizes, std::greater<int>());
+  int p = sorted_sizes[0];
+  if (sorted_sizes[1] != p || !IsPrime(p) || n > p + 1) return std::nullopt;
+
+  // Column c < p of test case (a, b) is a + c * b, and column p is b. For two
+  // columns, the values determine (a, b) uniquely, so every pair appears.
+  // Smaller dimensions keep the pairs of their own values and wrap the rest.
+  std::vector<CoveringArrayTestCase> result;
+  result.reserve(p * p);
+  for (int a = 0; a < p; a++) {
+    for (int b = 0; b < p; b++) {
+      CoveringArrayTestCase test_case({.test_case = std::vector<int>(n)});
+      for (int c = 0; c < n; c++) {
+        int value = (c < p ? a + c * b : b) % p;
+        test_case.test_case[c] = value % dimension_sizes[c];
+      }
+      result.push_back(std::move(test_case));
+    }
+  }
+  return result;
+}
+
+// Everything a covering array from GenerateCoveringArrayFromSeed() depends on.
+using CoveringArrayKey =
+    std::tuple<std::vector<int>, int, CoveringArrayAlgorithm, int64_t>;
+
+class CoveringArrayCache {
+ public:
+  std::shared_ptr<const std::vector<CoveringArrayTestCase>> Find(
+      const CoveringArrayKey& key) {
+    absl::MutexLock lock(&mutex_);
+    auto it = arrays_.find(key);
+    if (it == arrays_.end()) return nullptr;
+    return it->second;
+  }
+
+  void Insert(CoveringArrayKey key,
+              std::shared_ptr<const std::vector<CoveringArrayTestCase>> array) {
+    absl::MutexLock lock(&mutex_);
+    // Start over rather than growing without bound.
+    if (arrays_.size() >= kMaxCachedArrays) arrays_.clear();
+    arrays_.try_emplace(std::move(key), std::move(array));
+  }
+
+ private:
+  static constexpr int kMaxCachedArrays = 64;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<CoveringArrayKey,
+                      std::shared_ptr<const std::vector<CoveringArrayTestCase>>>
+      arrays_ ABSL_GUARDED_BY(mutex_);
+};
+
+CoveringArrayCache& GetCoveringArrayCache() {
+  static auto* cache = new CoveringArrayCache();
+  return *cache;
+}
+
+// Adapts a RandomEngine to the `rand` of the functions above. Uses the
+// overload of `RandInt()` that reports errors in a status rather than
+// returning an `absl::StatusOr` for each call.
+class EngineRand {
+ public:
+  explicit EngineRand(moriarty_internal::RandomEngine& engine)
+      : engine_(engine) {}
+
+  int operator()(int n) { return engine_.RandInt(n, status_); }
+
+  const absl::Status& status() const { return status_; }
+
+ private:
+  moriarty_internal::RandomEngine& engine_;
+  absl::Status status_;
+};
+
+// ForEachCoveringArrayRow() for any `rand` (see FindTestCaseToAdd()).
+template <typename Rand>
+void ForEachCoveringArrayRowWith(absl::Span<const int> dimension_sizes,
+                                 int strength, Rand& rand,
+                                 CoveringArrayAlgorithm algorithm,
+                                 moriarty_internal::Scheduler* scheduler,
+                                 CoveringArrayRowCallback on_row) {
   ABSL_CHECK_GT(strength, 0) << "Strength must be > 0";
   ABSL_CHECK_LE(strength, dimension_sizes.size())
       << "Strength must be <= #dims";
@@ -209,25 +591,120 @@ std::vector<CoveringArrayTestCase> GenerateCoveringArray(
   for (int size : dimension_sizes) {
     ABSL_CHECK_GT(size, 0) << "Dimension sizes must be > 0";
   }
-  ABSL_CHECK_LE(dimension_sizes.size(), 62)
-      << "Number of dimensions must be <= 62 for the bitmasks to work.";
 
-  int n = dimension_sizes.size();
-  std::vector<ColumnSet> column_sets =
-      InitializeColumnSets(n, strength, dimension_sizes);
+  if (std::optional<std::vector<CoveringArrayTestCase>> known =
+          KnownOptimalCoveringArray(dimension_sizes, strength)) {
+    for (const CoveringArrayTestCase& test_case : *known) on_row(test_case);
+    return;
+  }
+
+  switch (algorithm) {
+    case CoveringArrayAlgorithm::kRandomizedGreedy:
+      GenerateRandomizedGreedyCoveringArray(dimension_sizes, strength, rand,
+                                            scheduler, on_row);
+      return;
+    case CoveringArrayAlgorithm::kIpog: {
+      // Work on the dimensions from largest to smallest, then put them back.
+      std::vector<int> order(dimension_sizes.size());
+      absl::c_iota(order, 0);
+      absl::c_stable_sort(order, [&](int a, int b) {
+        return dimension_sizes[a] > dimension_sizes[b];
+      });
+      std::vector<int> sorted_sizes;
+      sorted_sizes.reserve(order.size());
+      for (int i : order) sorted_sizes.push_back(dimension_sizes[i]);
+
+      GenerateIpogCoveringArray(
+          sorted_sizes, strength, rand, scheduler,
+          [&](const CoveringArrayTestCase& sorted_test_case) {
+            CoveringArrayTestCase test_case(
+                {.test_case = std::vector<int>(order.size())});
+            for (int i = 0; i < order.size(); i++)
+              test_case.test_case[order[i]] = sorted_test_case.test_case[i];
+            on_row(test_case);
+          });
+      return;
+    }
+  }
+  ABSL_LOG(FATAL) << "Unknown CoveringArrayAlgorithm";
+}
 
+}  // namespace
+
+void ForEachCoveringArrayRow(std::vector<int> dimension_sizes, int strength,
+                             std::function<int(int)> rand,
+                             CoveringArrayAlgorithm algorithm,
+                             moriarty_internal::Scheduler* scheduler,
+                             CoveringArrayRowCallback on_row) {
+  ForEachCoveringArrayRowWith(dimension_sizes, strength, rand, algorithm,
+                              scheduler, on_row);
+}
+
+void ForEachCoveringArrayRow(std::vector<int> dimension_sizes, int strength,
+                             moriarty_internal::RandomEngine& engine,
+                             CoveringArrayAlgorithm algorithm,
+                             moriarty_internal::Scheduler* scheduler,
+                             CoveringArrayRowCallback on_row) {
+  EngineRand rand(engine);
+  ForEachCoveringArrayRowWith(dimension_sizes, strength, rand, algorithm,
+                              scheduler, on_row);
+  // Only fails for non-positive bounds, which the dimension sizes are not.
+  ABSL_CHECK_OK(rand.status());
+}
+
+std::vector<CoveringArrayTestCase> GenerateCoveringArray(
+    std::vector<int> dimension_sizes, int strength,
+    std::function<int(int)> rand, CoveringArrayAlgorithm algorithm,
+    moriarty_internal::Scheduler* scheduler) {
   std::vector<CoveringArrayTestCase> result;
-  while (true) {
-    std::optional<CoveringArrayTestCase> test_case =
-        FindTestCaseToAdd(column_sets, dimension_sizes, rand);
+  ForEachCoveringArrayRow(
+      std::move(dimension_sizes), strength, std::move(rand), algorithm,
+      scheduler,
+      [&](const CoveringArrayTestCase& row) { result.push_back(row); });
+  return result;
+}
 
-    if (test_case == std::nullopt) break;
+std::vector<CoveringArrayTestCase> GenerateCoveringArray(
+    std::vector<int> dimension_sizes, int strength,
+    moriarty_internal::RandomEngine& engine, CoveringArrayAlgorithm algorithm,
+    moriarty_internal::Scheduler* scheduler) {
+  std::vector<CoveringArrayTestCase> result;
+  ForEachCoveringArrayRow(
+      std::move(dimension_sizes), strength, engine, algorithm, scheduler,
+      [&](const CoveringArrayTestCase& row) { result.push_back(row); });
+  return result;
+}
 
-    result.push_back(*test_case);
-    for (ColumnSet& column_set : column_sets)
-      UpdateColumnSet(*test_case, dimension_sizes, column_set);
+void ForEachCoveringArrayRowFromSeed(std::vector<int> dimension_sizes,
+                                     int strength, int64_t seed,
+                                     CoveringArrayAlgorithm algorithm,
+                                     moriarty_internal::Scheduler* scheduler,
+                                     CoveringArrayRowCallback on_row) {
+  CoveringArrayKey key(dimension_sizes, strength, algorithm, seed);
+  CoveringArrayCache& cache = GetCoveringArrayCache();
+  if (std::shared_ptr<const std::vector<CoveringArrayTestCase>> cached =
+          cache.Find(key)) {
+    for (const CoveringArrayTestCase& row : *cached) on_row(row);
+    return;
   }
 
+  moriarty_internal::RandomEngine rng({seed}, "");
+  auto array = std::make_shared<std::vector<CoveringArrayTestCase>>();
+  ForEachCoveringArrayRow(std::move(dimension_sizes), strength, rng, algorithm,
+                          scheduler, [&](const CoveringArrayTestCase& row) {
+                            array->push_back(row);
+                            on_row(row);
+                          });
+  cache.Insert(std::move(key), std::move(array));
+}
+
+std::vector<CoveringArrayTestCase> GenerateCoveringArrayFromSeed(
+    std::vector<int> dimension_sizes, int strength, int64_t seed,
+    CoveringArrayAlgorithm algorithm, moriarty_internal::Scheduler* scheduler) {
+  std::vector<CoveringArrayTestCase> result;
+  ForEachCoveringArrayRowFromSeed(
+      std::move(dimension_sizes), strength, seed, algorithm, scheduler,
+      [&](const CoveringArrayTestCase& row) { result.push_back(row); });
   return result;
 }
 
@@ -17,15 +17,39 @@
 #ifndef MORIARTY_SRC_INTERNAL_COMBINATORIAL_COVERAGE_H_
 #define MORIARTY_SRC_INTERNAL_COMBINATORIAL_COVERAGE_H_
 
+#include <cstdint>
 #include <functional>
 #include <vector>
 
+#include "absl/functional/function_ref.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+
 namespace moriarty {
 
 struct CoveringArrayTestCase {
   std::vector<int> test_case;
 };
 
+// Called with each test case of a covering array, in order.
+using CoveringArrayRowCallback =
+    absl::FunctionRef<void(const CoveringArrayTestCase&)>;
+
+// How GenerateCoveringArray() builds the array.
+enum class CoveringArrayAlgorithm {
+  // Repeatedly adds a random test case made of uncovered partial test cases,
+  // starting with the set of columns that has the most uncovered.
+  kRandomizedGreedy,
+
+  // In-parameter-order generation (IPOG): covers the dimensions one at a time,
+  // first by extending the existing test cases, then by adding new ones only
+  // for what is left uncovered. Typically produces noticeably fewer test cases
+  // than kRandomizedGreedy (especially for strength >= 3), at the cost of
+  // being slower to construct. Only dimensions that do not affect coverage
+  // are chosen with `rand`.
+  kIpog,
+};
+
 // GenerateCoveringArray()
 //
 // Generates a covering array with prescribed `strength`.
@@ -52,6 +76,10 @@ struct CoveringArrayTestCase {
 // some form of uniformly-distributed random number generator (and not simply,
 // for example, `return 0;`).
 //
+// When a covering array with the fewest possible test cases is known for these
+// parameters (e.g., strength 2 with the two largest dimensions of equal prime
+// size p and at most p + 1 dimensions), it is returned instead.
+//
 // On average, you should expect approximately this many elements in the output
 // (this is not guaranteed):
 //   O( t * D * log(N) )
@@ -60,10 +88,69 @@ struct CoveringArrayTestCase {
 //   D = product of the t largest dimension sizes. Think: pow(max_dim_size, t).
 //   N = number of dimensions
 //
-// NOTE: This implementation is currently limited to <= 62 dimensions.
+// If `scheduler` is not null, the coverage of each candidate test case is
+// computed in parallel on it. The result does not depend on the scheduler.
+std::vector<CoveringArrayTestCase> GenerateCoveringArray(
+    std::vector<int> dimension_sizes, int strength,
+    std::function<int(int)> rand,
+    CoveringArrayAlgorithm algorithm =
+        CoveringArrayAlgorithm::kRandomizedGreedy,
+    moriarty_internal::Scheduler* scheduler = nullptr);
+
+// Same as above, but the random choices are drawn from `engine` directly.
+// Prefer this for large arrays: `rand(n)` is called for every random choice,
+// and this avoids a `std::function` call and an `absl::StatusOr` for each.
+// The result is the same as with `rand(n) = engine.RandInt(n).value()`.
 std::vector<CoveringArrayTestCase> GenerateCoveringArray(
     std::vector<int> dimension_sizes, int strength,
-    std::function<int(int)> rand);
+    moriarty_internal::RandomEngine& engine,
+    CoveringArrayAlgorithm algorithm =
+        CoveringArrayAlgorithm::kRandomizedGreedy,
+    moriarty_internal::Scheduler* scheduler = nullptr);
+
+// ForEachCoveringArrayRow()
+//
+// Same as GenerateCoveringArray(), but calls `on_row` with each test case of
+// the covering array (in the same order) as soon as it is final, while the
+// rest of the array is still being built. So slow work on each test case can
+// be overlapped with building the array.
+//
+// kRandomizedGreedy finalizes each test case as it is found. kIpog finalizes
+// most test cases while covering the last dimension, and the rest at the end.
+void ForEachCoveringArrayRow(std::vector<int> dimension_sizes, int strength,
+                             std::function<int(int)> rand,
+                             CoveringArrayAlgorithm algorithm,
+                             moriarty_internal::Scheduler* scheduler,
+                             CoveringArrayRowCallback on_row);
+void ForEachCoveringArrayRow(std::vector<int> dimension_sizes, int strength,
+                             moriarty_internal::RandomEngine& engine,
+                             CoveringArrayAlgorithm algorithm,
+                             moriarty_internal::Scheduler* scheduler,
+                             CoveringArrayRowCallback on_row);
+
+// GenerateCoveringArrayFromSeed()
+//
+// Same as GenerateCoveringArray(), but the random choices are derived from
+// `seed`. The result then only depends on the arguments (not on `scheduler`),
+// so it is cached for the lifetime of the process: repeated calls with the
+// same arguments return the cached covering array instead of building it
+// again.
+std::vector<CoveringArrayTestCase> GenerateCoveringArrayFromSeed(
+    std::vector<int> dimension_sizes, int strength, int64_t seed,
+    CoveringArrayAlgorithm algorithm =
+        CoveringArrayAlgorithm::kRandomizedGreedy,
+    moriarty_internal::Scheduler* scheduler = nullptr);
+
+// ForEachCoveringArrayRowFromSeed()
+//
+// Same as GenerateCoveringArrayFromSeed(), but calls `on_row` with each test
+// case as soon as it is final (see ForEachCoveringArrayRow()). The array is
+// cached once it is complete.
+void ForEachCoveringArrayRowFromSeed(std::vector<int> dimension_sizes,
+                                     int strength, int64_t seed,
+                                     CoveringArrayAlgorithm algorithm,
+                                     moriarty_internal::Scheduler* scheduler,
+                                     CoveringArrayRowCallback on_row);
 
 }  // namespace moriarty
 
@@ -15,13 +15,18 @@
 #include "src/internal/combinatorial_coverage.h"
 
 #include <functional>
+#include <optional>
 #include <ostream>
+#include <set>
+#include <tuple>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_join.h"
 #include "src/internal/combinatorial_coverage_test_util.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 
 namespace moriarty {
 
@@ -33,6 +38,7 @@ std::ostream& operator<<(std::ostream& os, const CoveringArrayTestCase& tc) {
 
 namespace {
 
+using testing::AllOf;
 using testing::SizeIs;
 
 // For use in `GenerateCoveringArray`. No test should depend on the
@@ -57,5 +63,182 @@ TEST(CombinatorialCoverageTest, ProducesACoveringArray) {
               IsStrength2CoveringArray(std::vector<int>({3, 4, 1, 2})));
 }
 
+TEST(CombinatorialCoverageTest, SupportsMoreThan62Dimensions) {
+  std::vector<int> dimension_sizes(70, 2);
+  EXPECT_THAT(GenerateCoveringArray(dimension_sizes, 2, RandFn()),
+              IsStrength2CoveringArray(dimension_sizes));
+  EXPECT_THAT(GenerateCoveringArray(dimension_sizes, 2, RandFn(),
+                                    CoveringArrayAlgorithm::kIpog),
+              IsStrength2CoveringArray(dimension_sizes));
+}
+
+TEST(CombinatorialCoverageTest,
+     IpogCoveringArrayWithFullStrengthShouldCoverEveryOption) {
+  EXPECT_THAT(GenerateCoveringArray({3, 3, 3}, 3, RandFn(),
+                                    CoveringArrayAlgorithm::kIpog),
+              SizeIs(27));
+  EXPECT_THAT(GenerateCoveringArray({2, 3, 4, 2}, 4, RandFn(),
+                                    CoveringArrayAlgorithm::kIpog),
+              SizeIs(48));
+}
+
+TEST(CombinatorialCoverageTest, IpogProducesACoveringArray) {
+  EXPECT_THAT(GenerateCoveringArray({3, 3, 3, 3}, 2, RandFn(),
+                                    CoveringArrayAlgorithm::kIpog),
+              IsStrength2CoveringArray(std::vector<int>({3, 3, 3, 3})));
+  EXPECT_THAT(GenerateCoveringArray({3, 4, 1, 2}, 2, RandFn(),
+                                    CoveringArrayAlgorithm::kIpog),
+              IsStrength2CoveringArray(std::vector<int>({3, 4, 1, 2})));
+  EXPECT_THAT(GenerateCoveringArray({2, 5, 3, 4, 2, 3}, 1, RandFn(),
+                                    CoveringArrayAlgorithm::kIpog),
+              SizeIs(5));
+}
+
+TEST(CombinatorialCoverageTest, IpogProducesAStrength3CoveringArray) {
+  std::vector<int> dimension_sizes = {2, 3, 4, 3, 2, 3, 2};
+  std::vector<CoveringArrayTestCase> covering_array = GenerateCoveringArray(
+      dimension_sizes, 3, RandFn(), CoveringArrayAlgorithm::kIpog);
+
+  int n = dimension_sizes.size();
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      for (int k = j + 1; k < n; k++) {
+        std::set<std::tuple<int, int, int>> seen;
+        for (const CoveringArrayTestCase& tc : covering_array)
+          seen.insert({tc.test_case[i], tc.test_case[j], tc.test_case[k]});
+        EXPECT_THAT(seen, SizeIs(dimension_sizes[i] * dimension_sizes[j] *
+                                 dimension_sizes[k]))
+            << "columns " << i << " " << j << " " << k;
+      }
+    }
+  }
+}
+
+TEST(CombinatorialCoverageTest, Strength1ShouldUseTheLargestDimension) {
+  EXPECT_THAT(GenerateCoveringArray({2, 5, 3, 4, 2, 3}, 1, RandFn()),
+              SizeIs(5));
+}
+
+TEST(CombinatorialCoverageTest,
+     Strength2WithEqualPrimeDimensionsShouldUseAnOrthogonalArray) {
+  std::vector<int> dimension_sizes(6, 5);
+  EXPECT_THAT(GenerateCoveringArray(dimension_sizes, 2, RandFn()),
+              AllOf(SizeIs(25), IsStrength2CoveringArray(dimension_sizes)));
+  EXPECT_THAT(GenerateCoveringArray({3, 2, 3, 1}, 2, RandFn()),
+              AllOf(SizeIs(9), IsStrength2CoveringArray(
+                                   std::vector<int>({3, 2, 3, 1}))));
+}
+
+TEST(CombinatorialCoverageTest, GenerateCoveringArrayFromSeedIsCached) {
+  std::vector<int> dimension_sizes = {4, 3, 3, 2, 3};
+  std::vector<CoveringArrayTestCase> first =
+      GenerateCoveringArrayFromSeed(dimension_sizes, 2, /*seed=*/12345);
+  std::vector<CoveringArrayTestCase> second =
+      GenerateCoveringArrayFromSeed(dimension_sizes, 2, /*seed=*/12345);
+
+  EXPECT_THAT(first, IsStrength2CoveringArray(dimension_sizes));
+  ASSERT_THAT(second, SizeIs(first.size()));
+  for (int i = 0; i < first.size(); i++)
+    EXPECT_EQ(second[i].test_case, first[i].test_case);
+
+  EXPECT_THAT(GenerateCoveringArrayFromSeed(dimension_sizes, 2, /*seed=*/12345,
+                                            CoveringArrayAlgorithm::kIpog),
+              IsStrength2CoveringArray(dimension_sizes));
+}
+
+TEST(CombinatorialCoverageTest, SchedulerShouldNotChangeTheResult) {
+  // Enough ColumnSets to be split across several tasks.
+  std::vector<int> dimension_sizes = {4, 3, 3, 2, 5, 3, 3, 2, 3, 4,
+                                      2, 3, 2, 3, 3, 2, 3, 2, 2, 3};
+  moriarty_internal::WorkStealingScheduler scheduler(4);
+  for (CoveringArrayAlgorithm algorithm :
+       {CoveringArrayAlgorithm::kRandomizedGreedy,
+        CoveringArrayAlgorithm::kIpog}) {
+    std::vector<CoveringArrayTestCase> serial =
+        GenerateCoveringArray(dimension_sizes, 3, RandFn(), algorithm);
+    std::vector<CoveringArrayTestCase> parallel = GenerateCoveringArray(
+        dimension_sizes, 3, RandFn(), algorithm, &scheduler);
+
+    ASSERT_THAT(parallel, SizeIs(serial.size()));
+    for (int i = 0; i < serial.size(); i++)
+      EXPECT_EQ(parallel[i].test_case, serial[i].test_case);
+  }
+}
+
+TEST(CombinatorialCoverageTest,
+     ForEachCoveringArrayRowShouldMatchGenerateCoveringArray) {
+  std::vector<int> dimension_sizes = {4, 3, 3, 2, 5, 3, 3, 2, 3, 4};
+  for (CoveringArrayAlgorithm algorithm :
+       {CoveringArrayAlgorithm::kRandomizedGreedy,
+        CoveringArrayAlgorithm::kIpog}) {
+    std::vector<CoveringArrayTestCase> expected =
+        GenerateCoveringArray(dimension_sizes, 3, RandFn(), algorithm);
+
+    std::vector<CoveringArrayTestCase> rows;
+    ForEachCoveringArrayRow(
+        dimension_sizes, 3, RandFn(), algorithm, /*scheduler=*/nullptr,
+        [&](const CoveringArrayTestCase& row) { rows.push_back(row); });
+
+    ASSERT_THAT(rows, SizeIs(expected.size()));
+    for (int i = 0; i < expected.size(); i++)
+      EXPECT_EQ(rows[i].test_case, expected[i].test_case);
+  }
+}
+
+TEST(CombinatorialCoverageTest,
+     ForEachCoveringArrayRowShouldEmitRowsBeforeTheArrayIsComplete) {
+  std::vector<int> dimension_sizes = {4, 3, 3, 2, 5, 3, 3, 2, 3, 4};
+  for (CoveringArrayAlgorithm algorithm :
+       {CoveringArrayAlgorithm::kRandomizedGreedy,
+        CoveringArrayAlgorithm::kIpog}) {
+    int num_rand_calls = 0;
+    std::function<int(int)> rand = RandFn();
+    std::optional<int> rand_calls_at_first_row;
+    ForEachCoveringArrayRow(
+        dimension_sizes, 2,
+        [&](int n) {
+          num_rand_calls++;
+          return rand(n);
+        },
+        algorithm, /*scheduler=*/nullptr,
+        [&](const CoveringArrayTestCase&) {
+          if (!rand_calls_at_first_row)
+            rand_calls_at_first_row = num_rand_calls;
+        });
+
+    ASSERT_TRUE(rand_calls_at_first_row.has_value());
+    EXPECT_LT(*rand_calls_at_first_row, num_rand_calls);
+  }
+}
+
+TEST(CombinatorialCoverageTest, RandomEngineShouldMatchEquivalentRandFn) {
+  std::vector<int> dimension_sizes = {4, 3, 3, 2, 5, 3, 3, 2, 3, 4};
+  for (CoveringArrayAlgorithm algorithm :
+       {CoveringArrayAlgorithm::kRandomizedGreedy,
+        CoveringArrayAlgorithm::kIpog}) {
+    moriarty_internal::RandomEngine engine({1, 2, 3}, "");
+    moriarty_internal::RandomEngine engine_copy({1, 2, 3}, "");
+    std::vector<CoveringArrayTestCase> expected = GenerateCoveringArray(
+        dimension_sizes, 3,
+        [&](int n) -> int { return engine_copy.RandInt(n).value(); },
+        algorithm);
+
+    std::vector<CoveringArrayTestCase> actual =
+        GenerateCoveringArray(dimension_sizes, 3, engine, algorithm);
+
+    ASSERT_THAT(actual, SizeIs(expected.size()));
+    for (int i = 0; i < expected.size(); i++)
+      EXPECT_EQ(actual[i].test_case, expected[i].test_case);
+  }
+}
+
+TEST(CombinatorialCoverageTest, IpogShouldNotProduceMoreCasesThanRandomized) {
+  std::vector<int> dimension_sizes(30, 3);
+  EXPECT_LE(GenerateCoveringArray(dimension_sizes, 3, RandFn(),
+                                  CoveringArrayAlgorithm::kIpog)
+                .size(),
+            GenerateCoveringArray(dimension_sizes, 3, RandFn()).size());
+}
+
 }  // namespace
 }  // namespace moriarty
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_COPY_ON_WRITE_H_
+#define MORIARTY_SRC_INTERNAL_COPY_ON_WRITE_H_
+
+#include <memory>
+#include <utility>
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// CopyOnWrite
+//
+// Holds a value of type `T` which is shared between copies of this object.
+// Copying a `CopyOnWrite` only copies a pointer. The value is only copied when
+// `Mutable()` is called on a handle that shares its value with another handle.
+//
+// A default-constructed `CopyOnWrite` holds `T()` and does not allocate until
+// `Mutable()` is called.
+//
+// Each handle may be used from one thread at a time. Handles that share a value
+// may be read (`Get()`) concurrently, but a single handle must not be mutated
+// concurrently with copies of it: `Mutable()` checks whether the value is
+// shared with `use_count()`, which does not synchronize with other threads
+// copying or destroying the handles that share it.
+template <typename T>
+class CopyOnWrite {
+ public:
+  CopyOnWrite() = default;
+  explicit CopyOnWrite(T value)
+      : value_(std::make_shared<T>(std::move(value))) {}
+
+  // Get()
+  //
+  // Returns the current value.
+  const T& Get() const { return value_ ? *value_ : DefaultValue(); }
+
+  // Mutable()
+  //
+  // Returns a modifiable reference to the value. If the value is shared with
+  // another handle, it is copied first. The reference is invalidated by any
+  // copy of this handle. Must not be called while other threads use handles
+  // that share the value (see the class comment).
+  T& Mutable() {
+    if (!value_) {
+      value_ = std::make_shared<T>();
+    } else if (value_.use_count() > 1) {
+      value_ = std::make_shared<T>(std::as_const(*value_));
+    }
+    return *value_;
+  }
+
+ private:
+  // Never modified while shared with another handle.
+  std::shared_ptr<T> value_;
+
+  static const T& DefaultValue() {
+    static const T* default_value = new T();
+    return *default_value;
+  }
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_COPY_ON_WRITE_H_
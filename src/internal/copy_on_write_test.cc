@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/copy_on_write.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(CopyOnWriteTest, DefaultConstructedHoldsDefaultValue) {
+  CopyOnWrite<std::vector<int>> cow;
+  EXPECT_THAT(cow.Get(), IsEmpty());
+
+  CopyOnWrite<std::string> str;
+  EXPECT_EQ(str.Get(), "");
+}
+
+TEST(CopyOnWriteTest, ConstructorAndMutableShouldSetTheValue) {
+  CopyOnWrite<std::vector<int>> cow({1, 2, 3});
+  EXPECT_THAT(cow.Get(), ElementsAre(1, 2, 3));
+
+  cow.Mutable().push_back(4);
+  EXPECT_THAT(cow.Get(), ElementsAre(1, 2, 3, 4));
+
+  CopyOnWrite<std::vector<int>> empty;
+  empty.Mutable().push_back(5);
+  EXPECT_THAT(empty.Get(), ElementsAre(5));
+}
+
+TEST(CopyOnWriteTest, CopiesShareTheValueUntilMutated) {
+  CopyOnWrite<std::vector<int>> a({1, 2});
+  CopyOnWrite<std::vector<int>> b = a;
+  EXPECT_EQ(&a.Get(), &b.Get());
+
+  b.Mutable().push_back(3);
+  EXPECT_NE(&a.Get(), &b.Get());
+  EXPECT_THAT(a.Get(), ElementsAre(1, 2));
+  EXPECT_THAT(b.Get(), ElementsAre(1, 2, 3));
+
+  a.Mutable().push_back(4);
+  EXPECT_THAT(a.Get(), ElementsAre(1, 2, 4));
+  EXPECT_THAT(b.Get(), ElementsAre(1, 2, 3));
+}
+
+TEST(CopyOnWriteTest, MutatingAnUnsharedValueShouldNotCopyIt) {
+  CopyOnWrite<std::vector<int>> a({1, 2});
+  const std::vector<int>* original = &a.Get();
+  a.Mutable().push_back(3);
+  EXPECT_EQ(&a.Get(), original);
+
+  CopyOnWrite<std::vector<int>> b = std::move(a);
+  b.Mutable().push_back(4);
+  EXPECT_EQ(&b.Get(), original);
+  EXPECT_THAT(b.Get(), ElementsAre(1, 2, 3, 4));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
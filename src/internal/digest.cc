@@ -0,0 +1,222 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/digest.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// The constants and steps of XXH64.
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4F;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5;
+
+constexpr std::array<uint64_t, 2> kSeeds = {0, 0x6D6F726961727479};
+
+// Reads 8 (or 4) bytes as a little-endian integer, on any platform.
+uint64_t Load64(const char* p) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = (value << 8) | static_cast<uint8_t>(p[i]);
+  }
+  return value;
+}
+
+uint64_t Load32(const char* p) {
+  uint64_t value = 0;
+  for (int i = 3; i >= 0; i--) {
+    value = (value << 8) | static_cast<uint8_t>(p[i]);
+  }
+  return value;
+}
+
+uint64_t Round(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  acc = std::rotl(acc, 31);
+  return acc * kPrime1;
+}
+
+uint64_t MergeRound(uint64_t acc, uint64_t lane) {
+  acc ^= Round(0, lane);
+  return acc * kPrime1 + kPrime4;
+}
+
+void ProcessStripe(std::array<uint64_t, 4>& lanes, const char* p) {
+  for (int i = 0; i < 4; i++) lanes[i] = Round(lanes[i], Load64(p + 8 * i));
+}
+
+uint64_t FinishXxh64(const std::array<uint64_t, 4>& lanes, uint64_t seed,
+                     uint64_t total_length, absl::string_view tail) {
+  uint64_t h;
+  if (total_length >= 32) {
+    h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) +
+        std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+    for (uint64_t lane : lanes) h = MergeRound(h, lane);
+  } else {
+    h = seed + kPrime5;
+  }
+  h += total_length;
+
+  const char* p = tail.data();
+  const char* end = p + tail.size();
+  for (; p + 8 <= end; p += 8) {
+    h ^= Round(0, Load64(p));
+    h = std::rotl(h, 27) * kPrime1 + kPrime4;
+  }
+  if (p + 4 <= end) {
+    h ^= Load32(p) * kPrime1;
+    h = std::rotl(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  for (; p < end; p++) {
+    h ^= static_cast<uint8_t>(*p) * kPrime5;
+    h = std::rotl(h, 11) * kPrime1;
+  }
+
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+}  // namespace
+
+Digest128::Digest128() {
+  for (int i = 0; i < 2; i++) {
+    lanes_[i] = {kSeeds[i] + kPrime1 + kPrime2, kSeeds[i] + kPrime2,
+                 kSeeds[i], kSeeds[i] - kPrime1};
+  }
+}
+
+void Digest128::Update(absl::string_view bytes) {
+  total_length_ += bytes.size();
+  if (num_pending_ > 0) {
+    int n = std::min<size_t>(kStripeSize - num_pending_, bytes.size());
+    std::copy_n(bytes.data(), n, pending_.data() + num_pending_);
+    num_pending_ += n;
+    bytes.remove_prefix(n);
+    if (num_pending_ < kStripeSize) return;
+    for (auto& lanes : lanes_) ProcessStripe(lanes, pending_.data());
+    num_pending_ = 0;
+  }
+  for (; bytes.size() >= kStripeSize; bytes.remove_prefix(kStripeSize)) {
+    for (auto& lanes : lanes_) ProcessStripe(lanes, bytes.data());
+  }
+  std::copy(bytes.begin(), bytes.end(), pending_.data());
+  num_pending_ = bytes.size();
+}
+
+absl::uint128 Digest128::Finish() const {
+  absl::string_view tail(pending_.data(), num_pending_);
+  return absl::MakeUint128(
+      FinishXxh64(lanes_[1], kSeeds[1], total_length_, tail),
+      FinishXxh64(lanes_[0], kSeeds[0], total_length_, tail));
+}
+
+std::string DigestToHex(absl::uint128 digest) {
+  return absl::StrFormat("%016x%016x", absl::Uint128High64(digest),
+                         absl::Uint128Low64(digest));
+}
+
+// Hashes the bytes in blocks of `kBufferSize`, into both the digest since the
+// last `TakeDigest()` and the total digest.
+class DigestStream::Buffer : public std::streambuf {
+ public:
+  Buffer() { setp(buffer_.data(), buffer_.data() + buffer_.size()); }
+
+  absl::uint128 TakeDigest() {
+    sync();
+    absl::uint128 digest = current_.Finish();
+    current_ = Digest128();
+    return digest;
+  }
+
+  absl::uint128 TotalDigest() {
+    sync();
+    return total_.Finish();
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    sync();
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    // Large writes are hashed directly.
+    if (n > epptr() - pptr()) {
+      sync();
+      absl::string_view bytes(s, n);
+      current_.Update(bytes);
+      total_.Update(bytes);
+      return n;
+    }
+    std::copy(s, s + n, pptr());
+    pbump(static_cast<int>(n));
+    return n;
+  }
+
+  int sync() override {
+    absl::string_view bytes(pbase(), pptr() - pbase());
+    current_.Update(bytes);
+    total_.Update(bytes);
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    return 0;
+  }
+
+ private:
+  static constexpr int kBufferSize = 1 << 14;
+
+  std::array<char, kBufferSize> buffer_;
+  Digest128 current_;
+  Digest128 total_;
+};
+
+DigestStream::DigestStream()
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>()) {
+  rdbuf(buffer_.get());
+}
+
+DigestStream::~DigestStream() = default;
+
+absl::uint128 DigestStream::TakeDigest() { return buffer_->TakeDigest(); }
+
+absl::uint128 DigestStream::TotalDigest() { return buffer_->TotalDigest(); }
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
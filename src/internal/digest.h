@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_DIGEST_H_
+#define MORIARTY_SRC_INTERNAL_DIGEST_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// Digest128
+//
+// A streaming 128-bit hash of a sequence of bytes, used to check that two runs
+// (e.g., on different platforms) produced exactly the same bytes without
+// keeping or comparing the bytes themselves. The two halves are XXH64 of the
+// bytes with two different seeds, so the result only depends on the bytes, not
+// on the platform or on how the bytes were split between calls to `Update()`.
+//
+// This is not a cryptographic hash.
+class Digest128 {
+ public:
+  Digest128();
+
+  // Update()
+  //
+  // Appends `bytes` to the hashed sequence.
+  void Update(absl::string_view bytes);
+
+  // Finish()
+  //
+  // Returns the hash of all bytes passed to `Update()` so far. More bytes may
+  // be added afterwards.
+  [[nodiscard]] absl::uint128 Finish() const;
+
+ private:
+  static constexpr int kStripeSize = 32;
+
+  std::array<std::array<uint64_t, 4>, 2> lanes_;
+  uint64_t total_length_ = 0;
+  // Bytes not yet processed (always fewer than `kStripeSize`).
+  std::array<char, kStripeSize> pending_;
+  int num_pending_ = 0;
+};
+
+// DigestToHex()
+//
+// Returns `digest` as 32 lowercase hexadecimal digits.
+std::string DigestToHex(absl::uint128 digest);
+
+// DigestStream
+//
+// An output stream that discards everything written to it and only keeps the
+// `Digest128` of the bytes.
+class DigestStream : public std::ostream {
+ public:
+  DigestStream();
+  ~DigestStream() override;
+
+  DigestStream(const DigestStream&) = delete;
+  DigestStream& operator=(const DigestStream&) = delete;
+
+  // TakeDigest()
+  //
+  // Returns the digest of the bytes written since the previous call to
+  // `TakeDigest()` (or since this stream was created).
+  absl::uint128 TakeDigest();
+
+  // TotalDigest()
+  //
+  // Returns the digest of all bytes written to this stream.
+  absl::uint128 TotalDigest();
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_DIGEST_H_
@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/digest.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+absl::uint128 DigestOf(absl::string_view bytes) {
+  Digest128 digest;
+  digest.Update(bytes);
+  return digest.Finish();
+}
+
+TEST(DigestTest, LowHalfShouldBeXxh64) {
+  EXPECT_EQ(absl::Uint128Low64(DigestOf("")), 0xEF46DB3751D8E999);
+  EXPECT_EQ(absl::Uint128Low64(DigestOf("abc")), 0x44BC2CF5AD770999);
+  EXPECT_EQ(absl::Uint128Low64(
+                DigestOf("Nobody inspects the spammish repetition")),
+            0xFBCEA83C8A378BF1);
+}
+
+TEST(DigestTest, DigestShouldNotDependOnHowTheBytesAreSplit) {
+  std::string bytes;
+  for (int i = 0; i < 1000; i++) bytes += static_cast<char>(i * 37);
+
+  for (int piece_size : {1, 3, 31, 32, 33, 100}) {
+    Digest128 digest;
+    for (int i = 0; i < bytes.size(); i += piece_size) {
+      digest.Update(absl::string_view(bytes).substr(i, piece_size));
+    }
+    EXPECT_EQ(digest.Finish(), DigestOf(bytes)) << piece_size;
+  }
+}
+
+TEST(DigestTest, DifferentBytesShouldHaveDifferentDigests) {
+  EXPECT_NE(DigestOf("abc"), DigestOf("abd"));
+  EXPECT_NE(DigestOf("abc"), DigestOf("abc "));
+  EXPECT_NE(DigestOf(std::string(100, 'a')), DigestOf(std::string(101, 'a')));
+  EXPECT_NE(absl::Uint128High64(DigestOf("abc")),
+            absl::Uint128Low64(DigestOf("abc")));
+}
+
+TEST(DigestTest, DigestToHexShouldHave32Digits) {
+  EXPECT_EQ(DigestToHex(absl::MakeUint128(1, 0xABCDEF)),
+            "0000000000000001" "0000000000abcdef");
+}
+
+TEST(DigestTest, DigestStreamShouldHashWhatIsWritten) {
+  std::string large(100000, 'x');
+  DigestStream stream;
+  stream << "hello " << 42 << '\n';
+  EXPECT_EQ(stream.TakeDigest(), DigestOf("hello 42\n"));
+  stream << large;
+  EXPECT_EQ(stream.TakeDigest(), DigestOf(large));
+  EXPECT_EQ(stream.TakeDigest(), DigestOf(""));
+  EXPECT_EQ(stream.TotalDigest(), DigestOf("hello 42\n" + large));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_DISTINCT_ELEMENTS_H_
+#define MORIARTY_SRC_INTERNAL_DISTINCT_ELEMENTS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/types/span.h"
+#include "src/internal/scheduler.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// DistinctIndexSet
+//
+// A set of distinct values of a vector, stored as indices into the vector
+// instead of as copies of the values. For large values (e.g., strings or
+// tuples), this takes a fraction of the memory of an
+// `absl::flat_hash_set<T>` next to the vector. Values are looked up directly,
+// without first adding them to the vector.
+//
+// Example:
+//
+//   std::vector<std::string> values;
+//   DistinctIndexSet<std::string> seen(values);
+//   if (!seen.Contains(value)) {
+//     values.push_back(std::move(value));
+//     seen.Insert(values.size() - 1);
+//   }
+template <typename T>
+class DistinctIndexSet {
+ public:
+  // `values` must outlive this set. It may grow (and reallocate) while the
+  // set is used, but the values that were inserted must not change.
+  explicit DistinctIndexSet(const std::vector<T>& values)
+      : indices_(0, Hash{&values}, Eq{&values}) {}
+
+  // Contains()
+  //
+  // Returns true if a value equal to `value` was inserted.
+  bool Contains(const T& value) const { return indices_.contains(value); }
+
+  // Insert()
+  //
+  // Inserts `values[index]`. Returns false (and does nothing) if an equal
+  // value was already inserted.
+  bool Insert(size_t index) { return indices_.insert(Index{index}).second; }
+
+ private:
+  // A distinct type, so lookups by `T` are never confused with indices.
+  struct Index {
+    size_t index;
+  };
+
+  // Hash and Eq accept both indices and values (heterogeneous lookup).
+  struct Hash {
+    using is_transparent = void;
+    const std::vector<T>* values;
+    size_t operator()(Index i) const {
+      return absl::Hash<T>()((*values)[i.index]);
+    }
+    size_t operator()(const T& value) const { return absl::Hash<T>()(value); }
+  };
+  struct Eq {
+    using is_transparent = void;
+    const std::vector<T>* values;
+    bool operator()(Index a, Index b) const {
+      return (*values)[a.index] == (*values)[b.index];
+    }
+    bool operator()(Index a, const T& b) const {
+      return (*values)[a.index] == b;
+    }
+    bool operator()(const T& a, Index b) const {
+      return a == (*values)[b.index];
+    }
+  };
+
+  absl::flat_hash_set<Index, Hash, Eq> indices_;
+};
+
+// FindFirstDuplicateInParallel()
+//
+// Returns the index of the first value of `values` that also appears earlier
+// in `values`, or `std::nullopt` if all values are distinct.
+//
+// The values are partitioned by their hash, and each partition is checked
+// for duplicates by its own task on `scheduler` (equal values are always in
+// the same partition). The result does not depend on the number of threads.
+template <typename T>
+std::optional<size_t> FindFirstDuplicateInParallel(absl::Span<const T> values,
+                                                   Scheduler& scheduler);
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename T>
+std::optional<size_t> FindFirstDuplicateInParallel(absl::Span<const T> values,
+                                                   Scheduler& scheduler) {
+  constexpr size_t kChunkSize = 1 << 14;
+  constexpr int kMaxPartitions = 64;
+  const size_t n = values.size();
+  const int num_partitions =
+      std::clamp(scheduler.NumThreads(), 1, kMaxPartitions);
+
+  // The high bits of the hash pick the partition, so the hash set in each
+  // partition still sees well-mixed low bits.
+  std::vector<uint8_t> partition(n);
+  int num_chunks = (n + kChunkSize - 1) / kChunkSize;
+  scheduler.ParallelFor(num_chunks, [&](int chunk) {
+    size_t end = std::min(n, (chunk + 1) * kChunkSize);
+    for (size_t i = chunk * kChunkSize; i < end; i++) {
+      uint64_t hash = absl::Hash<T>()(values[i]);
+      partition[i] = (hash >> 32) % num_partitions;
+    }
+  });
+
+  struct PointeeHash {
+    size_t operator()(const T* value) const { return absl::Hash<T>()(*value); }
+  };
+  struct PointeeEq {
+    bool operator()(const T* a, const T* b) const { return *a == *b; }
+  };
+
+  // Each partition stops at its first duplicate, or once it passes the
+  // earliest duplicate found so far.
+  std::atomic<size_t> first_duplicate = n;
+  scheduler.ParallelFor(num_partitions, [&](int p) {
+    absl::flat_hash_set<const T*, PointeeHash, PointeeEq> seen;
+    for (size_t i = 0; i < n; i++) {
+      if (partition[i] != p) continue;
+      if (i > first_duplicate.load(std::memory_order_relaxed)) return;
+      if (seen.insert(&values[i]).second) continue;
+
+      size_t current = first_duplicate.load();
+      while (i < current &&
+             !first_duplicate.compare_exchange_weak(current, i)) {
+      }
+      return;
+    }
+  });
+
+  if (first_duplicate.load() == n) return std::nullopt;
+  return first_duplicate.load();
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_DISTINCT_ELEMENTS_H_
@@ -0,0 +1,115 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/distinct_elements.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+std::optional<size_t> FindFirstDuplicateSerially(
+    const std::vector<std::string>& values) {
+  absl::flat_hash_set<std::string> seen;
+  for (size_t i = 0; i < values.size(); i++)
+    if (!seen.insert(values[i]).second) return i;
+  return std::nullopt;
+}
+
+TEST(DistinctElementsTest, DistinctIndexSetFindsValuesThroughTheirIndex) {
+  std::vector<std::string> values;
+  DistinctIndexSet<std::string> seen(values);
+  EXPECT_FALSE(seen.Contains("a"));
+
+  // Enough values that the vector reallocates several times.
+  for (int i = 0; i < 1000; i++) {
+    std::string value = absl::StrCat("v", i % 700);
+    if (seen.Contains(value)) continue;
+    values.push_back(std::move(value));
+    EXPECT_TRUE(seen.Insert(values.size() - 1));
+  }
+  EXPECT_EQ(values.size(), 700);
+  EXPECT_TRUE(seen.Contains("v0"));
+  EXPECT_TRUE(seen.Contains("v699"));
+  EXPECT_FALSE(seen.Contains("v700"));
+
+  values.push_back("v5");
+  EXPECT_FALSE(seen.Insert(values.size() - 1));
+}
+
+TEST(DistinctElementsTest, DistinctIndexSetWorksWithIntegerValues) {
+  std::vector<size_t> values = {5, 0, 1};
+  DistinctIndexSet<size_t> seen(values);
+  EXPECT_TRUE(seen.Insert(1));  // The value 0, not the index 0.
+  EXPECT_TRUE(seen.Contains(0));
+  EXPECT_FALSE(seen.Contains(1));
+  EXPECT_TRUE(seen.Insert(0));
+  EXPECT_TRUE(seen.Contains(5));
+}
+
+TEST(DistinctElementsTest, FindFirstDuplicateInParallelOfShortInputsIsNullopt) {
+  WorkStealingScheduler scheduler(4);
+  EXPECT_EQ(FindFirstDuplicateInParallel<std::string>({}, scheduler),
+            std::nullopt);
+  EXPECT_EQ(FindFirstDuplicateInParallel<std::string>({"a"}, scheduler),
+            std::nullopt);
+}
+
+TEST(DistinctElementsTest, FindFirstDuplicateInParallelFindsTheFirstDuplicate) {
+  WorkStealingScheduler scheduler(4);
+  std::vector<std::string> values;
+  for (int i = 0; i < 100000; i++) values.push_back(absl::StrCat("v", i));
+  EXPECT_EQ(FindFirstDuplicateInParallel<std::string>(values, scheduler),
+            std::nullopt);
+
+  values[70000] = values[3];
+  values[54321] = values[12345];
+  EXPECT_THAT(FindFirstDuplicateInParallel<std::string>(values, scheduler),
+              Optional(Eq(54321)));
+}
+
+TEST(DistinctElementsTest,
+     FindFirstDuplicateInParallelShouldNotDependOnTheNumberOfThreads) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (int attempt = 0; attempt < 20; attempt++) {
+    std::vector<std::string> values;
+    for (int i = 0; i < 20000; i++)
+      values.push_back(absl::StrCat(engine.RandInt(1000000).value()));
+
+    for (int num_threads : {1, 2, 3, 8}) {
+      WorkStealingScheduler scheduler(num_threads);
+      EXPECT_EQ(FindFirstDuplicateInParallel<std::string>(values, scheduler),
+                FindFirstDuplicateSerially(values));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
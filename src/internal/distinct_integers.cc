@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/distinct_integers.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "src/internal/scratch_buffer.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// The bitmap is used if the range of values has at most this many values per
+// element (so the bitmap uses at most this many bits per element).
+constexpr uint64_t kMaxBitsPerValue = 64;
+
+std::optional<size_t> FindFirstDuplicateWithBitmap(
+    absl::Span<const int64_t> values, int64_t min, uint64_t width) {
+  ScratchBuffer<std::vector<uint64_t>> seen;
+  seen->resize(width / 64 + 1);
+  for (size_t i = 0; i < values.size(); i++) {
+    uint64_t offset =
+        static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(min);
+    uint64_t bit = uint64_t{1} << (offset % 64);
+    if ((*seen)[offset / 64] & bit) return i;
+    (*seen)[offset / 64] |= bit;
+  }
+  return std::nullopt;
+}
+
+std::optional<size_t> FindFirstDuplicateWithSort(
+    absl::Span<const int64_t> values) {
+  ScratchBuffer<std::vector<std::pair<int64_t, size_t>>> sorted;
+  sorted->reserve(values.size());
+  for (size_t i = 0; i < values.size(); i++) sorted->push_back({values[i], i});
+  std::sort(sorted->begin(), sorted->end());
+
+  // Equal values are sorted by index, so the first duplicate of each value is
+  // directly after its first occurrence.
+  std::optional<size_t> first;
+  for (size_t i = 1; i < sorted->size(); i++) {
+    if ((*sorted)[i].first != (*sorted)[i - 1].first) continue;
+    if (!first || (*sorted)[i].second < *first) first = (*sorted)[i].second;
+  }
+  return first;
+}
+
+}  // namespace
+
+std::optional<size_t> FindFirstDuplicateInteger(
+    absl::Span<const int64_t> values) {
+  if (values.size() < 2) return std::nullopt;
+
+  int64_t lo = values[0];
+  int64_t hi = values[0];
+  for (int64_t value : values) {
+    lo = std::min(lo, value);
+    hi = std::max(hi, value);
+  }
+
+  uint64_t width = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+  if (width / kMaxBitsPerValue < values.size())
+    return FindFirstDuplicateWithBitmap(values, lo, width);
+  return FindFirstDuplicateWithSort(values);
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
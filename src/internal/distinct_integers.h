@@ -0,0 +1,43 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_DISTINCT_INTEGERS_H_
+#define MORIARTY_SRC_INTERNAL_DISTINCT_INTEGERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "absl/types/span.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// FindFirstDuplicateInteger()
+//
+// Returns the index of the first value of `values` that also appears earlier
+// in `values`, or `std::nullopt` if all values are distinct.
+//
+// If the values are packed into a range that is not much wider than the number
+// of values (e.g., permutations), this uses a single pass over a bitmap.
+// Otherwise, it sorts a copy of the values. No hashing is done in either case.
+std::optional<size_t> FindFirstDuplicateInteger(
+    absl::Span<const int64_t> values);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_DISTINCT_INTEGERS_H_
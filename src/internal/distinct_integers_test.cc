@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/distinct_integers.h"
+
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+TEST(DistinctIntegersTest, FindFirstDuplicateIntegerOfShortInputsIsNullopt) {
+  EXPECT_EQ(FindFirstDuplicateInteger({}), std::nullopt);
+  EXPECT_EQ(FindFirstDuplicateInteger({5}), std::nullopt);
+}
+
+TEST(DistinctIntegersTest, FindFirstDuplicateIntegerWorksForDenseRanges) {
+  EXPECT_EQ(FindFirstDuplicateInteger({3, 1, 2}), std::nullopt);
+  EXPECT_THAT(FindFirstDuplicateInteger({1, 2, 1, 2}), Optional(Eq(2)));
+  EXPECT_THAT(FindFirstDuplicateInteger({-5, -6, -6, -5}), Optional(Eq(2)));
+}
+
+TEST(DistinctIntegersTest, FindFirstDuplicateIntegerWorksForSparseRanges) {
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+
+  EXPECT_EQ(FindFirstDuplicateInteger({kMin, 0, kMax}), std::nullopt);
+  EXPECT_THAT(FindFirstDuplicateInteger({kMax, 7, kMin, 7, kMax}),
+              Optional(Eq(3)));
+  EXPECT_THAT(FindFirstDuplicateInteger({kMax, kMin, 0, kMin, kMax}),
+              Optional(Eq(3)));
+}
+
+TEST(DistinctIntegersTest, FindFirstDuplicateIntegerAcceptsPermutations) {
+  std::vector<int64_t> permutation(100000);
+  std::iota(permutation.rbegin(), permutation.rend(), 1);
+  EXPECT_EQ(FindFirstDuplicateInteger(permutation), std::nullopt);
+
+  permutation[54321] = permutation[12345];
+  EXPECT_THAT(FindFirstDuplicateInteger(permutation), Optional(Eq(54321)));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -18,6 +18,7 @@
 #include <cctype>
 #include <cstdint>
 #include <cstdlib>
+#include <initializer_list>
 #include <limits>
 #include <memory>
 #include <stack>
@@ -28,12 +29,15 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/log/absl_check.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "src/util/status_macro/status_macros.h"
 
@@ -132,14 +136,48 @@ absl::StatusOr<int64_t> NegateWithSafetyChecks(int64_t x) {
   return -x;
 }
 
+absl::StatusOr<int64_t> ApplyBinaryOperator(
+    moriarty_internal::BinaryOperator op, int64_t lhs, int64_t rhs) {
+  switch (op) {
+    case moriarty_internal::BinaryOperator::kAdd:
+      return AddWithSafetyChecks(lhs, rhs);
+    case moriarty_internal::BinaryOperator::kSubtract:
+      return SubtractWithSafetyChecks(lhs, rhs);
+    case moriarty_internal::BinaryOperator::kMultiply:
+      return MultiplyWithSafetyChecks(lhs, rhs);
+    case moriarty_internal::BinaryOperator::kDivide:
+      return DivideWithSafetyChecks(lhs, rhs);
+    case moriarty_internal::BinaryOperator::kModulo:
+      return ModuloWithSafetyChecks(lhs, rhs);
+    case moriarty_internal::BinaryOperator::kExponentiate:
+      return ExponentiateWithSafetyChecks(lhs, rhs);
+  }
+  return absl::UnimplementedError("Unknown binary operator.");
+}
+
+absl::StatusOr<int64_t> ApplyUnaryOperator(moriarty_internal::UnaryOperator op,
+                                           int64_t rhs) {
+  switch (op) {
+    case moriarty_internal::UnaryOperator::kPlus:
+      return rhs;
+    case moriarty_internal::UnaryOperator::kNegate:
+      return NegateWithSafetyChecks(rhs);
+  }
+  return absl::UnimplementedError("Unknown unary operator.");
+}
+
+absl::Status UnknownVariableError(absl::string_view variable_name) {
+  return absl::InvalidArgumentError(absl::Substitute(
+      "Variable in expression with unknown value: $0", variable_name));
+}
+
 absl::StatusOr<int64_t> GetIntegerLiteral(
     const moriarty_internal::Literal& literal, const VariableMap& variables) {
   if (!literal.IsVariable()) return literal.Value();
 
   auto it = variables.find(literal.VariableName());
   if (it != variables.end()) return it->second;
-  return absl::InvalidArgumentError(absl::Substitute(
-      "Variable in expression with unknown value: $0", literal.VariableName()));
+  return UnknownVariableError(literal.VariableName());
 }
 
 /* -------------------------------------------------------------------------- */
@@ -166,23 +204,8 @@ absl::StatusOr<LiteralVariant> EvaluateBinaryOperationWithSafetyChecks(
   // int/int operations
   if (std::get_if<int64_t>(&lhs) != nullptr &&
       std::get_if<int64_t>(&rhs) != nullptr) {
-    int64_t lhs_int = std::get<int64_t>(lhs);
-    int64_t rhs_int = std::get<int64_t>(rhs);
-
-    switch (expr.Op()) {
-      case moriarty_internal::BinaryOperator::kAdd:
-        return AddWithSafetyChecks(lhs_int, rhs_int);
-      case moriarty_internal::BinaryOperator::kSubtract:
-        return SubtractWithSafetyChecks(lhs_int, rhs_int);
-      case moriarty_internal::BinaryOperator::kMultiply:
-        return MultiplyWithSafetyChecks(lhs_int, rhs_int);
-      case moriarty_internal::BinaryOperator::kDivide:
-        return DivideWithSafetyChecks(lhs_int, rhs_int);
-      case moriarty_internal::BinaryOperator::kModulo:
-        return ModuloWithSafetyChecks(lhs_int, rhs_int);
-      case moriarty_internal::BinaryOperator::kExponentiate:
-        return ExponentiateWithSafetyChecks(lhs_int, rhs_int);
-    }
+    return ApplyBinaryOperator(expr.Op(), std::get<int64_t>(lhs),
+                               std::get<int64_t>(rhs));
   }
 
   return absl::UnimplementedError("Only int/int operations are defined now.");
@@ -197,13 +220,7 @@ absl::StatusOr<LiteralVariant> EvaluateUnaryOperationWithSafetyChecks(
 
   // int operations
   if (std::get_if<int64_t>(&rhs) != nullptr) {
-    int64_t rhs_int = std::get<int64_t>(rhs);
-    switch (expr.Op()) {
-      case moriarty_internal::UnaryOperator::kPlus:
-        return rhs;
-      case moriarty_internal::UnaryOperator::kNegate:
-        return NegateWithSafetyChecks(rhs_int);
-    }
+    return ApplyUnaryOperator(expr.Op(), std::get<int64_t>(rhs));
   }
   return absl::UnimplementedError("Only int unary operations are defined now.");
 }
@@ -265,6 +282,251 @@ absl::StatusOr<LiteralVariant> EvaluateExpressionWithSafetyChecks(
   return std::visit(Visitor(variables), expression.Get());
 }
 
+/* -------------------------------------------------------------------------- */
+/*  INTERVAL EVALUATION                                                       */
+/* -------------------------------------------------------------------------- */
+
+using IntervalMap = absl::flat_hash_map<std::string, IntegerInterval>;
+
+int64_t Clamp(absl::int128 value) {
+  return static_cast<int64_t>(
+      std::clamp<absl::int128>(value, std::numeric_limits<int64_t>::min(),
+                               std::numeric_limits<int64_t>::max()));
+}
+
+// Returns the smallest interval containing all of `values`.
+IntegerInterval Hull(std::initializer_list<absl::int128> values) {
+  return {.min = Clamp(std::min(values)), .max = Clamp(std::max(values))};
+}
+
+// `base ^ exponent`, clamped to the limits of `int64_t`. Requires that
+// exponent >= 0 and that it is not 0^0.
+int64_t ClampedExponentiate(int64_t base, int64_t exponent) {
+  if (base == 0 || base == 1) return base;
+  if (base == -1) return exponent % 2 == 0 ? 1 : -1;
+  absl::int128 result = 1;
+  for (int64_t i = 0; i < exponent; i++) {
+    result *= base;
+    // |base| >= 2, so this happens within 64 iterations.
+    if (result > std::numeric_limits<int64_t>::max() ||
+        result < std::numeric_limits<int64_t>::min()) {
+      return Clamp(result);
+    }
+  }
+  return static_cast<int64_t>(result);
+}
+
+absl::StatusOr<IntegerInterval> ApplyBinaryOperatorToIntervals(
+    moriarty_internal::BinaryOperator op, IntegerInterval lhs,
+    IntegerInterval rhs) {
+  using absl::int128;
+  switch (op) {
+    case moriarty_internal::BinaryOperator::kAdd:
+      return Hull({int128(lhs.min) + rhs.min, int128(lhs.max) + rhs.max});
+    case moriarty_internal::BinaryOperator::kSubtract:
+      return Hull({int128(lhs.min) - rhs.max, int128(lhs.max) - rhs.min});
+    case moriarty_internal::BinaryOperator::kMultiply:
+      return Hull({int128(lhs.min) * rhs.min, int128(lhs.min) * rhs.max,
+                   int128(lhs.max) * rhs.min, int128(lhs.max) * rhs.max});
+    case moriarty_internal::BinaryOperator::kDivide: {
+      // Dividing by 0 fails, so only the non-zero divisors matter. For a fixed
+      // sign of the divisor, the extremes are at the ends of both intervals
+      // (or at a divisor of +/-1).
+      std::vector<int128> values;
+      for (IntegerInterval divisor :
+           {IntegerInterval{rhs.min, std::min<int64_t>(rhs.max, -1)},
+            IntegerInterval{std::max<int64_t>(rhs.min, 1), rhs.max}}) {
+        if (divisor.min > divisor.max) continue;
+        for (int128 dividend : {int128(lhs.min), int128(lhs.max)}) {
+          values.push_back(dividend / divisor.min);
+          values.push_back(dividend / divisor.max);
+        }
+      }
+      if (values.empty()) {
+        return absl::InvalidArgumentError("Division by zero in interval.");
+      }
+      auto [min, max] = std::minmax_element(values.begin(), values.end());
+      return Hull({*min, *max});
+    }
+    case moriarty_internal::BinaryOperator::kModulo: {
+      if (rhs.min == 0 && rhs.max == 0) {
+        return absl::InvalidArgumentError("Modulo by zero in interval.");
+      }
+      // The result has the sign of the dividend, and its absolute value is
+      // less than the divisor's and at most the dividend's.
+      int128 largest_remainder =
+          std::max(-int128(rhs.min), int128(rhs.max)) - 1;
+      return Hull({lhs.min >= 0 ? 0 : std::max(int128(lhs.min),
+                                               -largest_remainder),
+                   lhs.max <= 0 ? 0 : std::min(int128(lhs.max),
+                                               largest_remainder)});
+    }
+    case moriarty_internal::BinaryOperator::kExponentiate: {
+      if (rhs.max < 0) {
+        return absl::InvalidArgumentError(
+            "Exponentiation needs non-negative exponent.");
+      }
+      // For a fixed exponent, the largest magnitude is at an end of `lhs`. The
+      // sign alternates with the parity of the exponent, so the two largest
+      // and two smallest exponents are enough. -1, 0 and 1 do not grow.
+      int64_t min_exponent = std::max<int64_t>(rhs.min, 0);
+      std::vector<int64_t> bases = {lhs.min, lhs.max};
+      for (int64_t base : {-1, 0, 1}) {
+        if (lhs.min <= base && base <= lhs.max) bases.push_back(base);
+      }
+      std::vector<int128> values;
+      for (int64_t base : bases) {
+        for (int64_t exponent :
+             {min_exponent, std::min(min_exponent + 1, rhs.max),
+              std::max(rhs.max - 1, min_exponent), rhs.max}) {
+          if (base == 0 && exponent == 0) continue;
+          values.push_back(ClampedExponentiate(base, exponent));
+        }
+      }
+      if (values.empty()) {
+        return absl::InvalidArgumentError("0 to the power of 0 is undefined.");
+      }
+      auto [min, max] = std::minmax_element(values.begin(), values.end());
+      return Hull({*min, *max});
+    }
+  }
+  return absl::UnimplementedError("Unknown binary operator.");
+}
+
+absl::StatusOr<IntegerInterval> EvaluateIntervalImpl(
+    const Expression& expression, const IntervalMap& variables) {
+  struct Visitor {
+    const IntervalMap& variables;
+
+    absl::StatusOr<IntegerInterval> operator()(
+        const moriarty_internal::Literal& lit) {
+      if (!lit.IsVariable()) return IntegerInterval{lit.Value(), lit.Value()};
+      auto it = variables.find(lit.VariableName());
+      if (it == variables.end()) {
+        return UnknownVariableError(lit.VariableName());
+      }
+      return it->second;
+    }
+    absl::StatusOr<IntegerInterval> operator()(
+        const moriarty_internal::BinaryOperation& binary) {
+      MORIARTY_ASSIGN_OR_RETURN(IntegerInterval lhs,
+                                EvaluateIntervalImpl(binary.Lhs(), variables));
+      MORIARTY_ASSIGN_OR_RETURN(IntegerInterval rhs,
+                                EvaluateIntervalImpl(binary.Rhs(), variables));
+      return ApplyBinaryOperatorToIntervals(binary.Op(), lhs, rhs);
+    }
+    absl::StatusOr<IntegerInterval> operator()(
+        const moriarty_internal::UnaryOperation& unary) {
+      MORIARTY_ASSIGN_OR_RETURN(IntegerInterval rhs,
+                                EvaluateIntervalImpl(unary.Rhs(), variables));
+      if (unary.Op() == moriarty_internal::UnaryOperator::kPlus) return rhs;
+      return Hull({-absl::int128(rhs.max), -absl::int128(rhs.min)});
+    }
+    absl::StatusOr<IntegerInterval> operator()(
+        const moriarty_internal::Function& fn) {
+      std::vector<IntegerInterval> arguments;
+      for (const std::unique_ptr<Expression>& expr : fn.Arguments()) {
+        if (expr == nullptr)
+          return absl::InvalidArgumentError(
+              "function argument must not be null");
+        MORIARTY_ASSIGN_OR_RETURN(IntegerInterval arg,
+                                  EvaluateIntervalImpl(*expr, variables));
+        arguments.push_back(arg);
+      }
+
+      if ((fn.Name() == "min" || fn.Name() == "max") && !arguments.empty()) {
+        IntegerInterval result = arguments[0];
+        for (const IntegerInterval& arg : arguments) {
+          if (fn.Name() == "min") {
+            result = {std::min(result.min, arg.min),
+                      std::min(result.max, arg.max)};
+          } else {
+            result = {std::max(result.min, arg.min),
+                      std::max(result.max, arg.max)};
+          }
+        }
+        return result;
+      }
+      if (fn.Name() == "abs") {
+        if (arguments.size() != 1)
+          return absl::InvalidArgumentError(
+              "abs(x) can only take one parameter");
+        IntegerInterval arg = arguments[0];
+        if (arg.min >= 0) return arg;
+        if (arg.max <= 0) {
+          return Hull({-absl::int128(arg.max), -absl::int128(arg.min)});
+        }
+        return Hull(
+            {0, std::max(-absl::int128(arg.min), absl::int128(arg.max))});
+      }
+      return absl::InvalidArgumentError(
+          absl::Substitute("Unknown function name: \"$0\"", fn.Name()));
+    }
+  };
+  return std::visit(Visitor{variables}, expression.Get());
+}
+
+/* -------------------------------------------------------------------------- */
+/*  CONSTANT FOLDING                                                          */
+/* -------------------------------------------------------------------------- */
+
+bool IsConstant(const Expression& expression) {
+  const moriarty_internal::Literal* literal =
+      std::get_if<moriarty_internal::Literal>(&expression.Get());
+  return literal != nullptr && !literal->IsVariable();
+}
+
+// If `expression` only contains constants and evaluates successfully, returns
+// a Literal with its value. Otherwise, returns `expression` unchanged. Any
+// errors are left for evaluation to report.
+Expression FoldIfConstant(Expression expression, bool all_operands_constant) {
+  if (!all_operands_constant) return expression;
+  absl::StatusOr<LiteralVariant> value =
+      EvaluateExpressionWithSafetyChecks(expression, {});
+  if (!value.ok() || !std::holds_alternative<int64_t>(*value))
+    return expression;
+  return moriarty_internal::Literal(std::get<int64_t>(*value));
+}
+
+// Returns `expression` with each subtree that only contains constants replaced
+// by a Literal with its value.
+Expression FoldConstants(const Expression& expression) {
+  struct Visitor {
+    Expression operator()(const moriarty_internal::Literal& lit) { return lit; }
+    Expression operator()(const moriarty_internal::BinaryOperation& binary) {
+      Expression lhs = FoldConstants(binary.Lhs());
+      Expression rhs = FoldConstants(binary.Rhs());
+      bool constant = IsConstant(lhs) && IsConstant(rhs);
+      return FoldIfConstant(
+          moriarty_internal::BinaryOperation(std::move(lhs), binary.Op(),
+                                             std::move(rhs)),
+          constant);
+    }
+    Expression operator()(const moriarty_internal::UnaryOperation& unary) {
+      Expression rhs = FoldConstants(unary.Rhs());
+      bool constant = IsConstant(rhs);
+      return FoldIfConstant(
+          moriarty_internal::UnaryOperation(unary.Op(), std::move(rhs)),
+          constant);
+    }
+    Expression operator()(const moriarty_internal::Function& fn) {
+      std::vector<std::unique_ptr<Expression>> arguments;
+      arguments.reserve(fn.Arguments().size());
+      bool constant = true;
+      for (const std::unique_ptr<Expression>& arg : fn.Arguments()) {
+        if (arg == nullptr) return fn;
+        arguments.push_back(
+            std::make_unique<Expression>(FoldConstants(*arg)));
+        constant = constant && IsConstant(*arguments.back());
+      }
+      return FoldIfConstant(
+          moriarty_internal::Function(fn.Name(), std::move(arguments)),
+          constant);
+    }
+  };
+  return std::visit(Visitor(), expression.Get());
+}
+
 /* -------------------------------------------------------------------------- */
 /*  REPLACE VARIABLES                                                         */
 /* -------------------------------------------------------------------------- */
@@ -329,6 +591,11 @@ absl::StatusOr<int64_t> EvaluateIntegerExpression(
   return std::get<int64_t>(value);
 }
 
+absl::StatusOr<IntegerInterval> EvaluateIntegerInterval(
+    const Expression& expression, const IntervalMap& variables) {
+  return EvaluateIntervalImpl(expression, variables);
+}
+
 absl::StatusOr<absl::flat_hash_set<std::string>> NeededVariables(
     const Expression& expression) {
   absl::flat_hash_set<std::string> unknown_variables;
@@ -336,6 +603,242 @@ absl::StatusOr<absl::flat_hash_set<std::string>> NeededVariables(
   return unknown_variables;
 }
 
+/* -------------------------------------------------------------------------- */
+/*  CANONICAL STRINGS                                                         */
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+char OperatorSymbol(moriarty_internal::BinaryOperator op) {
+  switch (op) {
+    case moriarty_internal::BinaryOperator::kAdd:
+      return '+';
+    case moriarty_internal::BinaryOperator::kSubtract:
+      return '-';
+    case moriarty_internal::BinaryOperator::kMultiply:
+      return '*';
+    case moriarty_internal::BinaryOperator::kDivide:
+      return '/';
+    case moriarty_internal::BinaryOperator::kModulo:
+      return '%';
+    case moriarty_internal::BinaryOperator::kExponentiate:
+      return '^';
+  }
+  return '?';
+}
+
+void AppendCanonicalString(const Expression& expression, std::string& out) {
+  struct Visitor {
+    std::string& out;
+
+    void operator()(const moriarty_internal::Literal& lit) {
+      if (lit.IsVariable()) {
+        out += lit.VariableName();
+      } else {
+        absl::StrAppend(&out, lit.Value());
+      }
+    }
+    void operator()(const moriarty_internal::BinaryOperation& binary) {
+      out += '(';
+      AppendCanonicalString(binary.Lhs(), out);
+      out += OperatorSymbol(binary.Op());
+      AppendCanonicalString(binary.Rhs(), out);
+      out += ')';
+    }
+    void operator()(const moriarty_internal::UnaryOperation& unary) {
+      out += unary.Op() == moriarty_internal::UnaryOperator::kNegate ? "(-"
+                                                                      : "(+";
+      AppendCanonicalString(unary.Rhs(), out);
+      out += ')';
+    }
+    void operator()(const moriarty_internal::Function& fn) {
+      absl::StrAppend(&out, fn.Name(), "(");
+      for (int i = 0; i < fn.Arguments().size(); i++) {
+        if (i > 0) out += ',';
+        if (fn.Arguments()[i] == nullptr) {
+          out += "null";
+        } else {
+          AppendCanonicalString(*fn.Arguments()[i], out);
+        }
+      }
+      out += ')';
+    }
+  };
+  std::visit(Visitor{out}, expression.Get());
+}
+
+}  // namespace
+
+std::string CanonicalString(const Expression& expression) {
+  std::string result;
+  AppendCanonicalString(expression, result);
+  return result;
+}
+
+/* -------------------------------------------------------------------------- */
+/*  COMPILED EXPRESSIONS                                                      */
+/* -------------------------------------------------------------------------- */
+
+CompiledExpression CompileExpression(const Expression& expression) {
+  CompiledExpression compiled;
+  compiled.AppendInstructions(expression);
+  return compiled;
+}
+
+int64_t CompiledExpression::VariableIndex(const std::string& name) {
+  // Expressions only have a handful of variables, so a linear scan is fine.
+  auto it = absl::c_find(variable_names_, name);
+  if (it != variable_names_.end()) return it - variable_names_.begin();
+  variable_names_.push_back(name);
+  return variable_names_.size() - 1;
+}
+
+void CompiledExpression::AppendError(std::string message) {
+  error_messages_.push_back(std::move(message));
+  instructions_.push_back(
+      {.op_code = OpCode::kError,
+       .operand = static_cast<int64_t>(error_messages_.size() - 1)});
+}
+
+void CompiledExpression::AppendInstructions(const Expression& expression) {
+  struct Visitor {
+    CompiledExpression& compiled;
+
+    void operator()(const moriarty_internal::Literal& lit) {
+      if (lit.IsVariable()) {
+        compiled.instructions_.push_back(
+            {.op_code = OpCode::kPushVariable,
+             .operand = compiled.VariableIndex(lit.VariableName())});
+      } else {
+        compiled.instructions_.push_back(
+            {.op_code = OpCode::kPushConstant, .operand = lit.Value()});
+      }
+    }
+    void operator()(const moriarty_internal::BinaryOperation& binary) {
+      compiled.AppendInstructions(binary.Lhs());
+      compiled.AppendInstructions(binary.Rhs());
+      compiled.instructions_.push_back(
+          {.op_code = OpCode::kBinary, .binary_op = binary.Op()});
+    }
+    void operator()(const moriarty_internal::UnaryOperation& unary) {
+      compiled.AppendInstructions(unary.Rhs());
+      compiled.instructions_.push_back(
+          {.op_code = OpCode::kUnary, .unary_op = unary.Op()});
+    }
+    void operator()(const moriarty_internal::Function& fn) {
+      // The errors are emitted at the point the tree evaluation would find
+      // them, so both forms fail in the same way.
+      for (const std::unique_ptr<Expression>& arg : fn.Arguments()) {
+        if (arg == nullptr) {
+          compiled.AppendError("function argument must not be null");
+          return;
+        }
+        compiled.AppendInstructions(*arg);
+      }
+
+      int64_t num_arguments = fn.Arguments().size();
+      if ((fn.Name() == "min" || fn.Name() == "max") && num_arguments == 0) {
+        compiled.AppendError(
+            absl::Substitute("$0() needs at least one argument", fn.Name()));
+      } else if (fn.Name() == "min") {
+        compiled.instructions_.push_back(
+            {.op_code = OpCode::kMin, .operand = num_arguments});
+      } else if (fn.Name() == "max") {
+        compiled.instructions_.push_back(
+            {.op_code = OpCode::kMax, .operand = num_arguments});
+      } else if (fn.Name() == "abs") {
+        if (num_arguments != 1) {
+          compiled.AppendError("abs(x) can only take one parameter");
+        } else {
+          compiled.instructions_.push_back({.op_code = OpCode::kAbs});
+        }
+      } else {
+        compiled.AppendError(
+            absl::Substitute("Unknown function name: \"$0\"", fn.Name()));
+      }
+    }
+  };
+  std::visit(Visitor{*this}, expression.Get());
+}
+
+template <typename GetVariableFn>
+absl::StatusOr<int64_t> CompiledExpression::EvaluateImpl(
+    GetVariableFn get_variable) const {
+  absl::InlinedVector<int64_t, 16> stack;
+  for (const Instruction& instruction : instructions_) {
+    switch (instruction.op_code) {
+      case OpCode::kPushConstant:
+        stack.push_back(instruction.operand);
+        break;
+      case OpCode::kPushVariable: {
+        const int64_t* value = get_variable(instruction.operand);
+        if (value == nullptr)
+          return UnknownVariableError(variable_names_[instruction.operand]);
+        stack.push_back(*value);
+        break;
+      }
+      case OpCode::kBinary: {
+        int64_t rhs = stack.back();
+        stack.pop_back();
+        MORIARTY_ASSIGN_OR_RETURN(
+            stack.back(),
+            ApplyBinaryOperator(instruction.binary_op, stack.back(), rhs));
+        break;
+      }
+      case OpCode::kUnary: {
+        MORIARTY_ASSIGN_OR_RETURN(
+            stack.back(),
+            ApplyUnaryOperator(instruction.unary_op, stack.back()));
+        break;
+      }
+      case OpCode::kMin:
+      case OpCode::kMax: {
+        auto first = stack.end() - instruction.operand;
+        int64_t result = instruction.op_code == OpCode::kMin
+                             ? *std::min_element(first, stack.end())
+                             : *std::max_element(first, stack.end());
+        stack.erase(first, stack.end());
+        stack.push_back(result);
+        break;
+      }
+      case OpCode::kAbs:
+        stack.back() = std::abs(stack.back());
+        break;
+      case OpCode::kError:
+        return absl::InvalidArgumentError(
+            error_messages_[instruction.operand]);
+    }
+  }
+
+  if (stack.size() != 1) {
+    return absl::InvalidArgumentError(
+        "Expression does not parse to an integer value.");
+  }
+  return stack.back();
+}
+
+absl::StatusOr<int64_t> CompiledExpression::Evaluate(
+    const absl::flat_hash_map<std::string, int64_t>& variables) const {
+  absl::InlinedVector<const int64_t*, 4> values;
+  values.reserve(variable_names_.size());
+  for (const std::string& name : variable_names_) {
+    auto it = variables.find(name);
+    values.push_back(it == variables.end() ? nullptr : &it->second);
+  }
+  return EvaluateImpl([&values](int64_t idx) { return values[idx]; });
+}
+
+absl::StatusOr<int64_t> CompiledExpression::Evaluate(
+    absl::Span<const int64_t> variable_values) const {
+  if (variable_values.size() != variable_names_.size()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "CompiledExpression::Evaluate expected $0 variable values, got $1",
+        variable_names_.size(), variable_values.size()));
+  }
+  return EvaluateImpl(
+      [variable_values](int64_t idx) { return &variable_values[idx]; });
+}
+
 /* -------------------------------------------------------------------------- */
 /*  STRING PARSING                                                            */
 /* -------------------------------------------------------------------------- */
@@ -845,6 +1348,7 @@ absl::StatusOr<Expression> ParseExpression(absl::string_view expression) {
   }
 
   MORIARTY_ASSIGN_OR_RETURN(Expression result, shunting_yard.GetResult());
+  result = FoldConstants(result);
   result.SetString(original_expression);
   return result;
 }
@@ -29,6 +29,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace moriarty {
 
@@ -46,10 +47,39 @@ absl::StatusOr<int64_t> EvaluateIntegerExpression(
     const Expression& expression,
     const absl::flat_hash_map<std::string, int64_t>& variables);
 
+// IntegerInterval
+//
+// All integers in [min, max]. Precondition: min <= max.
+struct IntegerInterval {
+  int64_t min;
+  int64_t max;
+
+  friend bool operator==(const IntegerInterval& i1,
+                         const IntegerInterval& i2) = default;
+};
+
+// EvaluateIntegerInterval()
+//
+// Returns bounds on the value of `expression` when each variable `v` may be
+// any value in `variables[v]`, independently of the others. Every value that
+// `EvaluateIntegerExpression()` can successfully return for such variables is
+// inside the result, but the result may be wider than needed (e.g., "N - N"
+// with N in [0, 5] gives [-5, 5]). Bounds that do not fit in 64 bits are
+// clamped to the limits of `int64_t`.
+//
+// All variables must be present in `variables`. Returns an error if no value
+// can be computed at all (e.g., "N / 0").
+absl::StatusOr<IntegerInterval> EvaluateIntegerInterval(
+    const Expression& expression,
+    const absl::flat_hash_map<std::string, IntegerInterval>& variables);
+
 // ParseExpression()
 //
 // Given a string representation in infix notation, returns the corresponding
-// `Expression`.
+// `Expression`. Subexpressions that only contain constants (e.g., `10^9 + 7`
+// or `min(3, 5)`) are folded into a single `Literal`. Subexpressions whose
+// evaluation fails (e.g., `1 / 0`) are kept as-is, so the error is reported
+// when the expression is evaluated. `ToString()` returns the original string.
 absl::StatusOr<Expression> ParseExpression(absl::string_view expression);
 
 // NeededVariables()
@@ -58,6 +88,22 @@ absl::StatusOr<Expression> ParseExpression(absl::string_view expression);
 absl::StatusOr<absl::flat_hash_set<std::string>> NeededVariables(
     const Expression& expression);
 
+// CanonicalString()
+//
+// Returns a fully parenthesized string that only depends on the structure of
+// `expression`. Unlike `ToString()` (which returns the original string),
+// expressions that parse to the same tree have the same canonical string. E.g.,
+// "3*N+1" and "(3 * N) + 1" are both "((3*N)+1)".
+std::string CanonicalString(const Expression& expression);
+
+class CompiledExpression;  // Forward declaring CompiledExpression.
+
+// CompileExpression()
+//
+// Flattens `expression` into a form that is cheaper to evaluate repeatedly.
+// See `CompiledExpression`.
+CompiledExpression CompileExpression(const Expression& expression);
+
 namespace moriarty_internal {
 
 enum class BinaryOperator {
@@ -168,6 +214,76 @@ class Expression {
   std::string str_expression_;
 };
 
+// CompiledExpression
+//
+// An `Expression` flattened into a list of postfix instructions, with each
+// distinct variable resolved to an index into `VariableNames()`. Evaluating it
+// walks the list once with a small stack instead of recursing through the
+// tree. The result (including any error) is the same as
+// `EvaluateIntegerExpression()` on the original `Expression`.
+class CompiledExpression {
+ public:
+  // VariableNames()
+  //
+  // The distinct variables in the expression, in order of first appearance.
+  const std::vector<std::string>& VariableNames() const {
+    return variable_names_;
+  }
+
+  // Evaluate()
+  //
+  // Evaluates the expression. `variables` must contain all variables that are
+  // reached during evaluation. Each variable is looked up at most once.
+  absl::StatusOr<int64_t> Evaluate(
+      const absl::flat_hash_map<std::string, int64_t>& variables = {}) const;
+
+  // Evaluate()
+  //
+  // Evaluates the expression. `variable_values[i]` is the value of
+  // `VariableNames()[i]`.
+  absl::StatusOr<int64_t> Evaluate(
+      absl::Span<const int64_t> variable_values) const;
+
+ private:
+  friend CompiledExpression CompileExpression(const Expression& expression);
+
+  enum class OpCode {
+    kPushConstant,  // Pushes `operand`.
+    kPushVariable,  // Pushes the variable with index `operand`.
+    kBinary,        // Pops rhs, then lhs. Pushes `lhs binary_op rhs`.
+    kUnary,         // Pops rhs. Pushes `unary_op rhs`.
+    kMin,           // Pops `operand` values. Pushes the smallest.
+    kMax,           // Pops `operand` values. Pushes the largest.
+    kAbs,           // Pops one value. Pushes its absolute value.
+    kError,         // Fails with the error message with index `operand`.
+  };
+
+  struct Instruction {
+    OpCode op_code;
+    int64_t operand = 0;
+    moriarty_internal::BinaryOperator binary_op = {};
+    moriarty_internal::UnaryOperator unary_op = {};
+  };
+
+  // Appends the instructions that evaluate `expression`.
+  void AppendInstructions(const Expression& expression);
+
+  // Appends an instruction that fails with `message`.
+  void AppendError(std::string message);
+
+  // Returns the index of `name` in `variable_names_`, adding it if needed.
+  int64_t VariableIndex(const std::string& name);
+
+  // Evaluates the instructions. `get_variable(i)` returns a pointer to the
+  // value of the `i`-th variable, or nullptr if its value is not known.
+  template <typename GetVariableFn>
+  absl::StatusOr<int64_t> EvaluateImpl(GetVariableFn get_variable) const;
+
+  std::vector<Instruction> instructions_;
+  std::vector<std::string> variable_names_;
+  std::vector<std::string> error_messages_;
+};
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_INTERNAL_EXPRESSIONS_H_
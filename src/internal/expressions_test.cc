@@ -28,6 +28,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "src/util/status_macro/status_macros.h"
@@ -810,6 +811,21 @@ TEST(ExpressionsTest, NeededVariables) {
               IsOkAndHolds(UnorderedElementsAre("X", "Y")));
 }
 
+TEST(ExpressionsTest, CanonicalStringOnlyDependsOnTheStructure) {
+  auto canonical = [](absl::string_view expression)
+      -> absl::StatusOr<std::string> {
+    MORIARTY_ASSIGN_OR_RETURN(Expression expr, ParseExpression(expression));
+    return CanonicalString(expr);
+  };
+
+  EXPECT_THAT(canonical("3*N+1"), IsOkAndHolds("((3*N)+1)"));
+  EXPECT_THAT(canonical("(3 * N) + 1"), IsOkAndHolds("((3*N)+1)"));
+  EXPECT_THAT(canonical("3 * (N + 1)"), IsOkAndHolds("(3*(N+1))"));
+  EXPECT_EQ(canonical("-X ^ 2"), canonical("-(X^2)"));
+  EXPECT_THAT(canonical("min(N, 2 * 5)"), IsOkAndHolds("min(N,10)"));
+  EXPECT_NE(canonical("abs(N)"), canonical("abs(M)"));
+}
+
 /* -------------------------------------------------------------------------- */
 /*  STRING PARSING WITH FUNCTIONS                                             */
 /* -------------------------------------------------------------------------- */
@@ -879,6 +895,125 @@ TEST(ExpressionsTest, FunctionsAndVariablesMayHaveTheSameName) {
   EXPECT_TRUE(EvaluateAndCheck("min(min, max)", {{"min", 3}, {"max", 5}}, 3));
 }
 
+/* -------------------------------------------------------------------------- */
+/*  CONSTANT FOLDING                                                          */
+/* -------------------------------------------------------------------------- */
+
+TEST(ExpressionsTest, ParseExpressionFoldsConstantExpressions) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Expression expr, ParseExpression("10^9 + 7"));
+  EXPECT_THAT(expr.Get(), VariantWith<Literal>(Literal(1000000007)));
+  EXPECT_EQ(expr.ToString(), "10^9 + 7");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(expr,
+                                ParseExpression("max(3, min(7, abs(-5)))"));
+  EXPECT_THAT(expr.Get(), VariantWith<Literal>(Literal(5)));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(expr, ParseExpression("-(2 * 10^5)"));
+  EXPECT_THAT(expr.Get(), VariantWith<Literal>(Literal(-200000)));
+}
+
+TEST(ExpressionsTest, ParseExpressionFoldsConstantSubexpressions) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Expression expr,
+                                ParseExpression("N + 2 * 10^5"));
+  ASSERT_THAT(expr.Get(), VariantWith<BinaryOperation>(BinaryOperation(
+                              Literal("N"), BinaryOperator::kAdd,
+                              Literal(200000))));
+  EXPECT_THAT(EvaluateIntegerExpression(expr, {{"N", 3}}),
+              IsOkAndHolds(200003));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(expr, ParseExpression("min(N, 2 + 3)"));
+  EXPECT_THAT(EvaluateIntegerExpression(expr, {{"N", 7}}), IsOkAndHolds(5));
+}
+
+TEST(ExpressionsTest, ParseExpressionDoesNotFoldConstantExpressionsThatFail) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Expression expr, ParseExpression("1 / 0"));
+  EXPECT_THAT(expr.Get(), VariantWith<BinaryOperation>(BinaryOperation(
+                              Literal(1), BinaryOperator::kDivide,
+                              Literal(0))));
+  EXPECT_THAT(EvaluateIntegerExpression(expr),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(expr, ParseExpression("10^100"));
+  EXPECT_THAT(EvaluateIntegerExpression(expr), IsOverflow());
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(expr, ParseExpression("foo(1, 2)"));
+  EXPECT_THAT(EvaluateIntegerExpression(expr),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unknown function")));
+}
+
+/* -------------------------------------------------------------------------- */
+/*  COMPILED EXPRESSIONS                                                      */
+/* -------------------------------------------------------------------------- */
+
+// Checks that the compiled form of `expression` evaluates to the same value (or
+// error) as the tree form.
+testing::AssertionResult CompiledMatchesTree(
+    absl::string_view expression,
+    const absl::flat_hash_map<std::string, int64_t>& variables) {
+  absl::StatusOr<Expression> expr = ParseExpression(expression);
+  if (!expr.ok()) {
+    return testing::AssertionFailure()
+           << "Failed to parse " << expression << ": " << expr.status();
+  }
+  absl::StatusOr<int64_t> tree = EvaluateIntegerExpression(*expr, variables);
+  absl::StatusOr<int64_t> compiled =
+      CompileExpression(*expr).Evaluate(variables);
+  if (tree != compiled) {
+    auto to_string = [](const absl::StatusOr<int64_t>& value) {
+      return value.ok() ? absl::StrCat(*value) : value.status().ToString();
+    };
+    return testing::AssertionFailure()
+           << expression << ": tree form gives " << to_string(tree)
+           << ", compiled form gives " << to_string(compiled);
+  }
+  return testing::AssertionSuccess();
+}
+
+TEST(CompiledExpressionTest, EvaluatesTheSameAsTheTreeForm) {
+  absl::flat_hash_map<std::string, int64_t> variables = {
+      {"N", 5}, {"M", -3}, {"big", std::numeric_limits<int64_t>::max()}};
+  for (absl::string_view expression :
+       {"1", "-1", "+7", "N", "3 * N + 1", "N - M * 2", "(N + M) * (N - M)",
+        "N / 2", "N % 3", "-N / M", "2 ^ 10", "N ^ 2 ^ 2", "min(N, M)",
+        "max(N, M, 7)", "abs(M)", "min(max(N, 3), abs(M) + 1) * 2",
+        "min(min, 3)", "-(-N)"}) {
+    EXPECT_TRUE(CompiledMatchesTree(expression, variables));
+  }
+}
+
+TEST(CompiledExpressionTest, FailsTheSameWayAsTheTreeForm) {
+  absl::flat_hash_map<std::string, int64_t> variables = {
+      {"N", 5}, {"big", std::numeric_limits<int64_t>::max()}};
+  for (absl::string_view expression :
+       {"big + 1", "-big - 2", "big * 2", "N / 0", "N % 0", "2 ^ -1", "0 ^ 0",
+        "X", "N / 0 + X", "X + N / 0", "abs(1, 2)", "foo(N)", "foo(X)",
+        "min(N, X)"}) {
+    EXPECT_TRUE(CompiledMatchesTree(expression, variables));
+  }
+}
+
+TEST(CompiledExpressionTest, VariableNamesAreDistinctAndInOrder) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Expression expr,
+                                ParseExpression("N * M + N - min(K, M)"));
+  EXPECT_THAT(CompileExpression(expr).VariableNames(),
+              ElementsAre("N", "M", "K"));
+}
+
+TEST(CompiledExpressionTest, EvaluateWithAValueForEachVariableWorks) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Expression expr,
+                                ParseExpression("3 * N + M - N"));
+  CompiledExpression compiled = CompileExpression(expr);
+  ASSERT_THAT(compiled.VariableNames(), ElementsAre("N", "M"));
+
+  EXPECT_THAT(compiled.Evaluate(std::vector<int64_t>({10, 1})),
+              IsOkAndHolds(21));
+  EXPECT_THAT(compiled.Evaluate(std::vector<int64_t>({0, -4})),
+              IsOkAndHolds(-4));
+  EXPECT_THAT(compiled.Evaluate(std::vector<int64_t>({1})),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 /* -------------------------------------------------------------------------- */
 /*  EXPRESSION CLASSES                                                        */
 /* -------------------------------------------------------------------------- */
@@ -1083,5 +1218,91 @@ TEST(ExpressionsTest, IsVariableWorks) {
   EXPECT_TRUE(lit2.IsVariable());
 }
 
+absl::StatusOr<IntegerInterval> IntervalOf(
+    absl::string_view expression,
+    const absl::flat_hash_map<std::string, IntegerInterval>& variables = {}) {
+  MORIARTY_ASSIGN_OR_RETURN(Expression expr, ParseExpression(expression));
+  return EvaluateIntegerInterval(expr, variables);
+}
+
+TEST(EvaluateIntegerIntervalTest, ConstantsAndVariablesShouldWork) {
+  EXPECT_THAT(IntervalOf("3"), IsOkAndHolds(IntegerInterval{3, 3}));
+  EXPECT_THAT(IntervalOf("N", {{"N", {1, 5}}}),
+              IsOkAndHolds(IntegerInterval{1, 5}));
+  EXPECT_THAT(IntervalOf("2 * N + M", {{"N", {1, 5}}, {"M", {-3, 4}}}),
+              IsOkAndHolds(IntegerInterval{-1, 14}));
+  EXPECT_THAT(IntervalOf("N - M", {{"N", {1, 5}}, {"M", {-3, 4}}}),
+              IsOkAndHolds(IntegerInterval{-3, 8}));
+  EXPECT_THAT(IntervalOf("-N", {{"N", {1, 5}}}),
+              IsOkAndHolds(IntegerInterval{-5, -1}));
+}
+
+TEST(EvaluateIntegerIntervalTest, FunctionsShouldWork) {
+  EXPECT_THAT(IntervalOf("min(N, M)", {{"N", {1, 5}}, {"M", {3, 4}}}),
+              IsOkAndHolds(IntegerInterval{1, 4}));
+  EXPECT_THAT(IntervalOf("max(N, M)", {{"N", {1, 5}}, {"M", {3, 4}}}),
+              IsOkAndHolds(IntegerInterval{3, 5}));
+  EXPECT_THAT(IntervalOf("abs(N)", {{"N", {-7, 5}}}),
+              IsOkAndHolds(IntegerInterval{0, 7}));
+}
+
+TEST(EvaluateIntegerIntervalTest, OverflowShouldBeClamped) {
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  EXPECT_THAT(IntervalOf("N * N", {{"N", {-1, kMax}}}),
+              IsOkAndHolds(IntegerInterval{-kMax, kMax}));
+  EXPECT_THAT(IntervalOf("-N", {{"N", {kMin, 0}}}),
+              IsOkAndHolds(IntegerInterval{0, kMax}));
+  EXPECT_THAT(IntervalOf("2 ^ N", {{"N", {0, 100}}}),
+              IsOkAndHolds(IntegerInterval{1, kMax}));
+}
+
+TEST(EvaluateIntegerIntervalTest, UnknownVariablesOrNoValidValuesShouldFail) {
+  EXPECT_THAT(IntervalOf("N + 1"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(IntervalOf("N / 0", {{"N", {1, 5}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(IntervalOf("N % M", {{"N", {1, 5}}, {"M", {0, 0}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(IntervalOf("N ^ M", {{"N", {1, 5}}, {"M", {-5, -1}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(EvaluateIntegerIntervalTest, IntervalShouldContainAllValues) {
+  constexpr int kMin = -4;
+  constexpr int kMax = 4;
+  for (absl::string_view expression :
+       {"X + Y", "X - Y", "X * Y", "X / Y", "X % Y", "X ^ Y", "-X * Y + 3",
+        "min(X, Y) * max(X, 2)", "abs(X - Y) ^ 2", "(X + 10) / (Y - 1)",
+        "X ^ (Y % 3)"}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(Expression expr,
+                                  ParseExpression(expression));
+    // Every sub-interval of [kMin, kMax] for both variables.
+    for (int x_min = kMin; x_min <= kMax; x_min++) {
+      for (int x_max = x_min; x_max <= kMax; x_max++) {
+        for (int y_min = kMin; y_min <= kMax; y_min++) {
+          for (int y_max = y_min; y_max <= kMax; y_max++) {
+            absl::StatusOr<IntegerInterval> interval = EvaluateIntegerInterval(
+                expr, {{"X", {x_min, x_max}}, {"Y", {y_min, y_max}}});
+            for (int x = x_min; x <= x_max; x++) {
+              for (int y = y_min; y <= y_max; y++) {
+                absl::StatusOr<int64_t> value =
+                    EvaluateIntegerExpression(expr, {{"X", x}, {"Y", y}});
+                if (!value.ok()) continue;
+                ASSERT_TRUE(interval.ok())
+                    << expression << " X=" << x << " Y=" << y;
+                EXPECT_LE(interval->min, *value)
+                    << expression << " X=" << x << " Y=" << y;
+                EXPECT_GE(interval->max, *value)
+                    << expression << " X=" << x << " Y=" << y;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace moriarty
@@ -14,20 +14,32 @@
 
 #include "src/internal/generation_bootstrap.h"
 
+#include <algorithm>
+#include <any>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "src/errors.h"
 #include "src/internal/abstract_variable.h"
 #include "src/internal/generation_config.h"
+#include "src/internal/generation_context.h"
+#include "src/internal/range.h"
+#include "src/internal/tracing.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
@@ -38,16 +50,14 @@ namespace moriarty_internal {
 
 namespace {
 
-void SetUniverse(VariableSet& variables, Universe* universe) {
-  for (const auto& [var_name, var_ptr] : variables.GetAllVariables())
-    var_ptr->SetUniverse(universe, var_name);
-}
-
 GenerationConfig CreateGenerationConfig(const GenerationOptions& options) {
   GenerationConfig generation_config;
 
   if (options.soft_generation_limit)
     generation_config.SetSoftGenerationLimit(*options.soft_generation_limit);
+  generation_config.SetScheduler(options.scheduler);
+  generation_config.SetProfile(options.profile);
+  generation_config.SetBudget(options.budget);
 
   return generation_config;
 }
@@ -64,109 +74,415 @@ GetDependenciesMap(const VariableSet& variables) {
   return deps_map;
 }
 
-absl::flat_hash_map<std::string, int> CountIncomingEdges(
+// The dependency graph of `deps_map` with each variable replaced by its index
+// in `names`. Variables are indexed in sorted order, so comparing indices
+// compares names.
+struct IndexedDependencyGraph {
+  std::vector<std::string> names;
+  // `dependencies[i]` are the variables that `names[i]` depends on.
+  std::vector<std::vector<int>> dependencies;
+  // `external_dependencies[i]` are the dependencies of `names[i]` that are not
+  // variables.
+  std::vector<std::vector<std::string>> external_dependencies;
+};
+
+IndexedDependencyGraph CreateIndexedDependencyGraph(
+    const absl::flat_hash_map<std::string, std::vector<std::string>>&
+        deps_map) {
+  IndexedDependencyGraph graph;
+  graph.names.reserve(deps_map.size());
+  for (const auto& [var, deps] : deps_map) graph.names.push_back(var);
+  absl::c_sort(graph.names);
+
+  absl::flat_hash_map<std::string, int> index;
+  index.reserve(graph.names.size());
+  for (int i = 0; i < graph.names.size(); i++) index[graph.names[i]] = i;
+
+  graph.dependencies.resize(graph.names.size());
+  graph.external_dependencies.resize(graph.names.size());
+  for (int i = 0; i < graph.names.size(); i++) {
+    for (const std::string& dep : deps_map.at(graph.names[i])) {
+      auto it = index.find(dep);
+      if (it == index.end()) {
+        graph.external_dependencies[i].push_back(dep);
+      } else {
+        graph.dependencies[i].push_back(it->second);
+      }
+    }
+  }
+  return graph;
+}
+
+absl::Status CheckExternalDependencies(
+    const std::string& var, const std::vector<std::string>& external,
+    const ValueSet& known_values) {
+  for (const std::string& dep : external) {
+    if (!known_values.Contains(dep)) {
+      return absl::FailedPreconditionError(
+          absl::Substitute("Unknown dependency '$0' for var '$1!'", dep, var));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// The shape of a dependency graph: each variable with its sorted dependencies,
+// sorted by variable name. The generation order only depends on this.
+using GenerationPlanKey =
+    std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+GenerationPlanKey CreateGenerationPlanKey(
+    const absl::flat_hash_map<std::string, std::vector<std::string>>&
+        deps_map) {
+  GenerationPlanKey key(deps_map.begin(), deps_map.end());
+  for (auto& [var, deps] : key) std::sort(deps.begin(), deps.end());
+  std::sort(key.begin(), key.end());
+  return key;
+}
+
+class GenerationPlanCache {
+ public:
+  std::shared_ptr<const GenerationPlan> Find(const GenerationPlanKey& key) {
+    absl::MutexLock lock(&mutex_);
+    auto it = plans_.find(key);
+    if (it == plans_.end()) return nullptr;
+    return it->second;
+  }
+
+  void Insert(GenerationPlanKey key,
+              std::shared_ptr<const GenerationPlan> plan) {
+    absl::MutexLock lock(&mutex_);
+    // Generators mostly produce a handful of distinct shapes. If something is
+    // producing many, start over rather than growing without bound.
+    if (plans_.size() >= kMaxCachedPlans) plans_.clear();
+    plans_.try_emplace(std::move(key), std::move(plan));
+  }
+
+ private:
+  static constexpr int kMaxCachedPlans = 1024;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<GenerationPlanKey, std::shared_ptr<const GenerationPlan>>
+      plans_ ABSL_GUARDED_BY(mutex_);
+};
+
+GenerationPlanCache& GetGenerationPlanCache() {
+  static auto* cache = new GenerationPlanCache();
+  return *cache;
+}
+
+std::vector<std::string> GetExternalDependencies(
     const absl::flat_hash_map<std::string, std::vector<std::string>>&
         deps_map) {
-  absl::flat_hash_map<std::string, int> num_incoming_edges;
+  absl::flat_hash_set<std::string> external;
   for (const auto& [var, deps] : deps_map) {
-    if (!num_incoming_edges.contains(var)) num_incoming_edges[var] = 0;
+    for (const std::string& dep : deps)
+      if (!deps_map.contains(dep)) external.insert(dep);
+  }
+  std::vector<std::string> result(external.begin(), external.end());
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+bool AllAreKnown(const std::vector<std::string>& names,
+                 const ValueSet& known_values) {
+  return std::all_of(names.begin(), names.end(),
+                     [&](const std::string& name) {
+                       return known_values.Contains(name);
+                     });
+}
+
+// The most rounds `PropagateIntegerBounds()` does. Each round only shrinks the
+// intervals, but some constraints (e.g., `A <= B - 1` and `B <= A + 1`) only
+// shrink them a little at a time.
+constexpr int kMaxPropagationRounds = 8;
+
+enum class PropagationResult { kUnchanged, kTightened, kInfeasible };
 
-    for (const std::string& dep : deps) {
-      num_incoming_edges[dep]++;
+struct IntegerPropagationState {
+  // The integer variables being tightened, sorted so that the result does not
+  // depend on the order of a hash map.
+  std::vector<std::string> names;
+  absl::flat_hash_map<std::string, const Range*> bounds;
+  // The variables whose bounds depend on each variable.
+  absl::flat_hash_map<std::string, std::vector<std::string>> dependents;
+
+  // The interval that each integer is known to be in. Both hold the same
+  // values; `intervals` is in the form `Range::StaticExtremes()` needs.
+  absl::flat_hash_map<std::string, Range::ExtremeValues> current;
+  absl::flat_hash_map<std::string, Range> intervals;
+
+  void SetInterval(const std::string& name, int64_t min, int64_t max) {
+    current[name] = {.min = min, .max = max};
+    intervals.insert_or_assign(name, Range(min, max));
+  }
+};
+
+// Returns true if `name` has no value in its interval that is within its
+// bounds for any values of the variables in their intervals.
+bool IsKnownEmpty(const std::string& name,
+                  const IntegerPropagationState& state) {
+  absl::StatusOr<std::optional<Range::ExtremeValues>> extremes =
+      state.bounds.at(name)->StaticExtremes(state.intervals);
+  if (!extremes.ok()) return false;
+  if (!extremes->has_value()) return true;
+  Range::ExtremeValues current = state.current.at(name);
+  return (*extremes)->max < current.min || current.max < (*extremes)->min;
+}
+
+// Returns the last value from `good` towards `bad` for which `is_bad` is false,
+// given that `is_bad(good)` is false and `is_bad(bad)` is true. `good` may be
+// on either side of `bad`.
+template <typename IsBadFn>
+int64_t LastGoodValue(int64_t good, int64_t bad, IsBadFn is_bad) {
+  for (int64_t mid = std::midpoint(good, bad); mid != good;
+       mid = std::midpoint(good, bad)) {
+    if (is_bad(mid)) {
+      bad = mid;
+    } else {
+      good = mid;
     }
   }
-  return num_incoming_edges;
+  return good;
 }
 
-std::priority_queue<std::string, std::vector<std::string>,
-                    std::greater<std::string>>
-GetNodesWithNoIncomingEdges(
-    const absl::flat_hash_map<std::string, int>& num_incoming_edges) {
-  std::priority_queue<std::string, std::vector<std::string>,
-                      std::greater<std::string>>
-      queue;
+// Intersects the interval of `name` with the bounds of `name` evaluated over
+// the intervals of the variables they depend on.
+PropagationResult TightenFromBounds(const std::string& name,
+                                    IntegerPropagationState& state) {
+  absl::StatusOr<std::optional<Range::ExtremeValues>> extremes =
+      state.bounds.at(name)->StaticExtremes(state.intervals);
+  if (!extremes.ok()) return PropagationResult::kUnchanged;
+  if (!extremes->has_value()) return PropagationResult::kInfeasible;
+
+  Range::ExtremeValues current = state.current.at(name);
+  int64_t min = std::max(current.min, (*extremes)->min);
+  int64_t max = std::min(current.max, (*extremes)->max);
+  if (min > max) return PropagationResult::kInfeasible;
+  if (min == current.min && max == current.max)
+    return PropagationResult::kUnchanged;
+  state.SetInterval(name, min, max);
+  return PropagationResult::kTightened;
+}
+
+// Removes the values at either end of the interval of `name` that leave some
+// variable depending on `name` without any valid value.
+//
+// E.g., if `N` is in [1, 10] and `M` is in [N, 5], then `M` has no valid value
+// when `N` is in [6, 10], so `N` is shaved to [1, 5].
+PropagationResult ShaveInterval(const std::string& name,
+                                IntegerPropagationState& state) {
+  auto it = state.dependents.find(name);
+  if (it == state.dependents.end()) return PropagationResult::kUnchanged;
+  const std::vector<std::string>& dependents = it->second;
+
+  const Range::ExtremeValues original = state.current.at(name);
+  auto leaves_no_value = [&](int64_t min, int64_t max) {
+    state.intervals.insert_or_assign(name, Range(min, max));
+    return absl::c_any_of(dependents, [&](const std::string& dependent) {
+      return IsKnownEmpty(dependent, state);
+    });
+  };
+
+  int64_t min = original.min;
+  int64_t max = original.max;
+  if (leaves_no_value(min, max)) return PropagationResult::kInfeasible;
+  if (leaves_no_value(max, max)) {
+    max = LastGoodValue(min, max, [&](int64_t t) {
+      return leaves_no_value(t, original.max);
+    });
+  }
+  if (leaves_no_value(min, min)) {
+    if (leaves_no_value(min, max)) return PropagationResult::kInfeasible;
+    min = LastGoodValue(max, min, [&](int64_t t) {
+      return leaves_no_value(original.min, t);
+    });
+  }
 
-  for (const auto& [v, e] : num_incoming_edges)
-    if (e == 0) queue.push(v);
-  return queue;
+  state.SetInterval(name, min, max);
+  if (min == original.min && max == original.max)
+    return PropagationResult::kUnchanged;
+  return PropagationResult::kTightened;
 }
+
 }  // namespace
 
 absl::StatusOr<std::vector<std::string>> GetGenerationOrder(
     const absl::flat_hash_map<std::string, std::vector<std::string>>& deps_map,
     const ValueSet& known_values) {
+  IndexedDependencyGraph graph = CreateIndexedDependencyGraph(deps_map);
+  int num_variables = graph.names.size();
+
+  std::vector<int> num_incoming_edges(num_variables, 0);
+  for (const std::vector<int>& deps : graph.dependencies)
+    for (int dep : deps) num_incoming_edges[dep]++;
+
+  // Ties are broken by the smallest index (i.e., name) so the order is stable.
+  std::priority_queue<int, std::vector<int>, std::greater<int>>
+      no_incoming_edges;
+  for (int i = 0; i < num_variables; i++)
+    if (num_incoming_edges[i] == 0) no_incoming_edges.push(i);
+
   std::vector<std::string> ordered_variables;
-  absl::flat_hash_map<std::string, int> num_incoming_edges =
-      CountIncomingEdges(deps_map);
-  std::priority_queue<std::string, std::vector<std::string>,
-                      std::greater<std::string>>
-      no_incoming_edges = GetNodesWithNoIncomingEdges(num_incoming_edges);
+  ordered_variables.reserve(num_variables);
   while (!no_incoming_edges.empty()) {
-    std::string current = no_incoming_edges.top();
+    int current = no_incoming_edges.top();
     no_incoming_edges.pop();
-    ordered_variables.push_back(current);
-
-    for (const std::string& dep : deps_map.at(current)) {
-      if (!deps_map.contains(dep)) {
-        if (!known_values.Contains(dep)) {
-          return absl::FailedPreconditionError(absl::Substitute(
-              "Unknown dependency '$0' for var '$1!'", dep, current));
-        }
-        continue;
-      }
-      num_incoming_edges[dep]--;
-      if (num_incoming_edges[dep] == 0) no_incoming_edges.push(dep);
-    }
+    ordered_variables.push_back(graph.names[current]);
+
+    MORIARTY_RETURN_IF_ERROR(CheckExternalDependencies(
+        graph.names[current], graph.external_dependencies[current],
+        known_values));
+    for (int dep : graph.dependencies[current])
+      if (--num_incoming_edges[dep] == 0) no_incoming_edges.push(dep);
   }
-  if (ordered_variables.size() != deps_map.size()) {
+  if (ordered_variables.size() != graph.names.size()) {
     return absl::InvalidArgumentError("Cycle in the dependency order graph.");
   }
   return ordered_variables;
 }
 
+absl::StatusOr<std::shared_ptr<const GenerationPlan>> GetGenerationPlan(
+    const VariableSet& variables, const ValueSet& known_values) {
+  MORIARTY_ASSIGN_OR_RETURN(
+      (absl::flat_hash_map<std::string, std::vector<std::string>> deps_map),
+      GetDependenciesMap(variables));
+
+  GenerationPlanKey key = CreateGenerationPlanKey(deps_map);
+  std::shared_ptr<const GenerationPlan> cached =
+      GetGenerationPlanCache().Find(key);
+  if (cached != nullptr &&
+      AllAreKnown(cached->external_dependencies, known_values)) {
+    return cached;
+  }
+
+  if (cached != nullptr) {
+    // Some external dependency is missing. Report the first one generation
+    // would have reached, without ordering the variables again.
+    for (const std::string& var : cached->generation_order) {
+      std::vector<std::string> external;
+      for (const std::string& dep : cached->deps_map.at(var))
+        if (!cached->deps_map.contains(dep)) external.push_back(dep);
+      MORIARTY_RETURN_IF_ERROR(
+          CheckExternalDependencies(var, external, known_values));
+    }
+    return cached;
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(std::vector<std::string> generation_order,
+                            GetGenerationOrder(deps_map, known_values));
+
+  auto plan = std::make_shared<GenerationPlan>();
+  plan->external_dependencies = GetExternalDependencies(deps_map);
+  plan->generation_order = std::move(generation_order);
+  plan->deps_map = std::move(deps_map);
+  GetGenerationPlanCache().Insert(std::move(key), plan);
+  return plan;
+}
+
+void PropagateIntegerBounds(VariableSet& variables,
+                            const ValueSet& known_values) {
+  IntegerPropagationState state;
+  for (const auto& [name, variable] : variables.GetAllVariables()) {
+    if (known_values.Contains(name)) continue;
+    const Range* bounds = variable->GetIntegerBounds();
+    if (bounds == nullptr) continue;
+    absl::StatusOr<absl::flat_hash_set<std::string>> needed =
+        bounds->NeededVariables();
+    if (!needed.ok()) continue;  // Generation reports this error.
+
+    state.names.push_back(name);
+    state.bounds[name] = bounds;
+    for (const std::string& dependency : *needed)
+      state.dependents[dependency].push_back(name);
+  }
+  // If no integer depends on another, there is nothing to propagate.
+  if (state.dependents.empty()) return;
+  absl::c_sort(state.names);
+
+  absl::flat_hash_map<std::string, Range::ExtremeValues> initial;
+  for (const std::string& name : state.names) {
+    absl::StatusOr<std::optional<Range::ExtremeValues>> extremes =
+        state.bounds.at(name)->StaticExtremes();
+    // Leave empty (or broken) bounds for generation to report.
+    if (!extremes.ok() || !extremes->has_value()) return;
+    initial[name] = **extremes;
+    state.SetInterval(name, (*extremes)->min, (*extremes)->max);
+  }
+  // Known integers are fixed to their value. Anything else is unbounded.
+  for (const auto& [dependency, unused] : state.dependents) {
+    if (state.bounds.contains(dependency)) continue;
+    absl::StatusOr<std::any> value = known_values.UnsafeGet(dependency);
+    if (!value.ok()) continue;
+    if (const int64_t* integer = std::any_cast<int64_t>(&*value))
+      state.SetInterval(dependency, *integer, *integer);
+  }
+
+  for (int round = 0; round < kMaxPropagationRounds; round++) {
+    bool tightened = false;
+    for (const std::string& name : state.names) {
+      for (auto propagate : {TightenFromBounds, ShaveInterval}) {
+        PropagationResult result = propagate(name, state);
+        // The usual generation error is more helpful than anything here.
+        if (result == PropagationResult::kInfeasible) return;
+        if (result == PropagationResult::kTightened) tightened = true;
+      }
+    }
+    if (!tightened) break;
+  }
+
+  for (const std::string& name : state.names) {
+    Range::ExtremeValues tightened = state.current.at(name);
+    if (tightened == initial.at(name)) continue;
+    absl::StatusOr<AbstractVariable*> variable =
+        variables.GetAbstractVariable(name);
+    if (variable.ok())
+      (*variable)->TightenIntegerBounds(Range(tightened.min, tightened.max));
+  }
+}
+
 absl::StatusOr<ValueSet> GenerateAllValues(VariableSet variables,
                                            ValueSet known_values,
                                            const GenerationOptions& options) {
-  GenerationConfig generation_config = CreateGenerationConfig(options);
-  Universe universe;
-  universe.SetMutableValueSet(&known_values)
-      .SetMutableVariableSet(&variables)
-      .SetGenerationConfig(&generation_config)
-      .SetRandomEngine(&options.random_engine);
-
-  SetUniverse(variables, &universe);
+  MORIARTY_TRACE_SPAN("GenerateAllValues");
+  GenerationContext context(std::move(variables), std::move(known_values),
+                            options.random_engine,
+                            CreateGenerationConfig(options));
 
   MORIARTY_ASSIGN_OR_RETURN(
-      (absl::flat_hash_map<std::string, std::vector<std::string>> deps_map),
-      GetDependenciesMap(variables));
+      std::shared_ptr<const GenerationPlan> plan,
+      GetGenerationPlan(context.GetVariables(), context.GetValues()));
+  const std::vector<std::string>& variable_names = plan->generation_order;
+  context.GetGenerationConfig().SetDependencies(&plan->deps_map);
 
-  MORIARTY_ASSIGN_OR_RETURN(std::vector<std::string> variable_names,
-                            GetGenerationOrder(deps_map, known_values));
+  // Remove values that can never be valid before any of them are generated.
+  PropagateIntegerBounds(context.GetVariables(), context.GetValues());
 
-  // First do a quick assignment of all known values.
+  // Look each variable up once, rather than once per pass.
+  std::vector<AbstractVariable*> ordered_variables;
+  ordered_variables.reserve(variable_names.size());
   for (const std::string& name : variable_names) {
-    MORIARTY_ASSIGN_OR_RETURN(AbstractVariable * var,
-                              variables.GetAbstractVariable(name));
-    MORIARTY_RETURN_IF_ERROR(var->AssignUniqueValue());
+    std::optional<VariableSet::VariableHandle> handle =
+        context.GetVariables().GetHandle(name);
+    if (!handle.has_value()) return VariableNotFoundError(name);
+    ordered_variables.push_back(
+        context.GetVariables().GetAbstractVariable(*handle));
   }
 
+  // First do a quick assignment of all known values.
+  for (AbstractVariable* var : ordered_variables)
+    MORIARTY_RETURN_IF_ERROR(var->AssignUniqueValue());
+
   // Now do a deep generation.
-  for (const std::string& name : variable_names) {
-    MORIARTY_ASSIGN_OR_RETURN(AbstractVariable * var,
-                              variables.GetAbstractVariable(name));
+  for (AbstractVariable* var : ordered_variables)
     MORIARTY_RETURN_IF_ERROR(var->AssignValue());
-  }
 
   // We may have initially generated invalid values during the
   // AssignUniqueValues(). Let's check for those now...
   // TODO(darcybest): Determine if there's a better way of doing this...
-  for (const std::string& name : variable_names) {
-    MORIARTY_ASSIGN_OR_RETURN(AbstractVariable * var,
-                              variables.GetAbstractVariable(name));
+  for (AbstractVariable* var : ordered_variables)
     MORIARTY_RETURN_IF_ERROR(var->ValueSatisfiesConstraints());
-  }
 
-  return known_values;
+  return std::move(context.GetValues());
 }
 
 }  // namespace moriarty_internal
@@ -18,13 +18,17 @@
 #define MORIARTY_SRC_INTERNAL_GENERATION_BOOTSTRAP_H_
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 
@@ -34,8 +38,54 @@ namespace moriarty_internal {
 struct GenerationOptions {
   RandomEngine& random_engine;
   std::optional<int64_t> soft_generation_limit;
+  // If set, runs parallel work. See `GenerationConfig::SetScheduler()`.
+  Scheduler* scheduler = nullptr;
+  // If set, records where time is spent. See `GenerationConfig::SetProfile()`.
+  GenerationProfile* profile = nullptr;
+  // If set, limits the work done. See `GenerationConfig::SetBudget()`.
+  GenerationBudget* budget = nullptr;
 };
 
+// GenerationPlan
+//
+// The parts of generating a `VariableSet` that depend only on the shape of its
+// dependency graph (and not on the values being generated). Plans are cached by
+// `GetGenerationPlan()` so that test cases sharing the same variables do not
+// recompute them.
+struct GenerationPlan {
+  // Dependencies of each variable, as returned by `GetDependencies()`.
+  absl::flat_hash_map<std::string, std::vector<std::string>> deps_map;
+
+  // The order to generate variables in. Both the unique-value pass and the
+  // full generation pass walk the variables in this order.
+  std::vector<std::string> generation_order;
+
+  // Dependencies that are not variables themselves. Each must be a known value
+  // for this plan to be usable.
+  std::vector<std::string> external_dependencies;
+};
+
+// GetGenerationPlan()
+//
+// Returns the generation plan for `variables`. Plans are shared between all
+// calls whose variables have the same dependencies, so adding a dependency to
+// any variable results in a new plan.
+absl::StatusOr<std::shared_ptr<const GenerationPlan>> GetGenerationPlan(
+    const VariableSet& variables, const ValueSet& known_values);
+
+// PropagateIntegerBounds()
+//
+// Tightens the bounds of the integer variables in `variables` against each
+// other before anything is generated, so that fewer generated values are
+// rejected later. E.g., with `N` in [1, 10] and `M` in [N, 5], `N` is tightened
+// to [1, 5] since larger values of `N` leave no valid value for `M`.
+//
+// Only values that cannot be part of any valid assignment are removed, so the
+// values that are valid do not change. Variables with a value in
+// `known_values` are not modified.
+void PropagateIntegerBounds(VariableSet& variables,
+                            const ValueSet& known_values);
+
 // GenerateAllValues()
 //
 // Generates and returns a value for each variable in `variables`.
@@ -52,6 +102,9 @@ absl::StatusOr<ValueSet> GenerateAllValues(VariableSet variables,
 //
 // The order is from parent to child. E.g., 'A' depends on 'C' and 'C'
 // depends on 'B'. The final order will be {A, B, C}.
+//
+// Ties are broken by name. Takes O(E + V log V) time for V variables with E
+// dependencies between them.
 absl::StatusOr<std::vector<std::string>> GetGenerationOrder(
     const absl::flat_hash_map<std::string, std::vector<std::string>>& deps_map,
     const ValueSet& known_values);
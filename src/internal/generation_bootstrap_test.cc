@@ -15,6 +15,7 @@
 #include "src/internal/generation_bootstrap.h"
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -25,11 +26,17 @@
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "src/internal/abstract_variable.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/range.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/testing/status_test_util.h"
+#include "src/util/status_macro/status_macros.h"
 #include "src/util/test_status_macro/status_testutil.h"
 #include "src/variables/minteger.h"
 #include "src/variables/mstring.h"
@@ -43,12 +50,16 @@ using ::testing::AllOf;
 using ::testing::AnyOf;
 using ::testing::ContainerEq;
 using ::testing::Each;
+using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::Ge;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::Le;
+using ::testing::Optional;
 using ::testing::Property;
 using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 
@@ -288,6 +299,168 @@ TEST(GenerationBootstrapTest,
   EXPECT_THAT(results, Each(Eq(results[0])));
 }
 
+TEST(GenerationBootstrapTest,
+     GenerateAllValuesShouldNotGenerateValuesThatLeaveOthersWithoutValues) {
+  // Without propagation, N > 5 leaves no valid value for M.
+  for (int seed = 0; seed < 20; seed++) {
+    RandomEngine rng({seed}, "");
+    VariableSet variables;
+    MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 10)));
+    MORIARTY_ASSERT_OK(variables.AddVariable("M", MInteger().Between("N", 5)));
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        ValueSet values,
+        GenerateAllValues(variables, ValueSet(), {rng, std::nullopt}));
+    EXPECT_THAT(values.Get<MInteger>("N"), IsOkAndHolds(AllOf(Ge(1), Le(5))));
+  }
+}
+
+absl::StatusOr<std::optional<Range::ExtremeValues>> BoundsOf(
+    const VariableSet& variables, absl::string_view name) {
+  MORIARTY_ASSIGN_OR_RETURN(const AbstractVariable* variable,
+                            variables.GetAbstractVariable(name));
+  return variable->GetIntegerBounds()->StaticExtremes();
+}
+
+TEST(GenerationBootstrapTest,
+     PropagateIntegerBoundsShouldShaveValuesThatLeaveOthersWithoutValues) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable("M", MInteger().Between("N", 5)));
+
+  PropagateIntegerBounds(variables, ValueSet());
+
+  EXPECT_THAT(BoundsOf(variables, "N"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({1, 5}))));
+  EXPECT_THAT(BoundsOf(variables, "M"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({1, 5}))));
+}
+
+TEST(GenerationBootstrapTest,
+     PropagateIntegerBoundsShouldTightenThroughArithmeticExpressions) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 100)));
+  MORIARTY_ASSERT_OK(
+      variables.AddVariable("M", MInteger().Between(40, "N * (N - 1) / 2")));
+
+  PropagateIntegerBounds(variables, ValueSet());
+
+  // 9 * 8 / 2 = 36 < 40 <= 45 = 10 * 9 / 2.
+  EXPECT_THAT(BoundsOf(variables, "N"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({10, 100}))));
+  EXPECT_THAT(BoundsOf(variables, "M"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({40, 4950}))));
+}
+
+TEST(GenerationBootstrapTest,
+     PropagateIntegerBoundsShouldTightenThroughChainsOfVariables) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between(1, 100)));
+  MORIARTY_ASSERT_OK(
+      variables.AddVariable("B", MInteger().Between("2 * A", 50)));
+  MORIARTY_ASSERT_OK(
+      variables.AddVariable("C", MInteger().Between("B + 10", 30)));
+
+  PropagateIntegerBounds(variables, ValueSet());
+
+  EXPECT_THAT(BoundsOf(variables, "A"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({1, 10}))));
+  EXPECT_THAT(BoundsOf(variables, "B"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({2, 20}))));
+  EXPECT_THAT(BoundsOf(variables, "C"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({12, 30}))));
+}
+
+TEST(GenerationBootstrapTest,
+     PropagateIntegerBoundsShouldUseButNotModifyKnownValues) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable("M", MInteger().Between("N", 5)));
+  ValueSet known_values;
+  known_values.Set<MInteger>("N", 3);
+
+  PropagateIntegerBounds(variables, known_values);
+
+  EXPECT_THAT(BoundsOf(variables, "N"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({1, 10}))));
+  EXPECT_THAT(BoundsOf(variables, "M"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({3, 5}))));
+}
+
+TEST(GenerationBootstrapTest,
+     PropagateIntegerBoundsShouldLeaveInfeasibleVariablesUnchanged) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(6, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable("M", MInteger().Between("N", 5)));
+
+  PropagateIntegerBounds(variables, ValueSet());
+
+  EXPECT_THAT(BoundsOf(variables, "N"),
+              IsOkAndHolds(Optional(Range::ExtremeValues({6, 10}))));
+}
+
+TEST(GenerationBootstrapTest, GetGenerationPlanComputesOrderAndDependencies) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between("N", "M")));
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 10)));
+  ValueSet known_values;
+  known_values.Set<MInteger>("M", 20);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const GenerationPlan> plan,
+                                GetGenerationPlan(variables, known_values));
+
+  EXPECT_THAT(plan->generation_order, ElementsAre("A", "N"));
+  EXPECT_THAT(plan->deps_map.at("A"), UnorderedElementsAre("M", "N"));
+  EXPECT_THAT(plan->deps_map.at("N"), IsEmpty());
+  EXPECT_THAT(plan->external_dependencies, ElementsAre("M"));
+}
+
+TEST(GenerationBootstrapTest, GetGenerationPlanIsSharedBetweenSameShapes) {
+  VariableSet variables1;
+  MORIARTY_ASSERT_OK(variables1.AddVariable("A", MInteger().Between(1, "Q")));
+  MORIARTY_ASSERT_OK(variables1.AddVariable("Q", MInteger().Between(1, 10)));
+  // Different constraints, but the same dependencies.
+  VariableSet variables2;
+  MORIARTY_ASSERT_OK(variables2.AddVariable("A", MInteger().Between("Q", 5)));
+  MORIARTY_ASSERT_OK(variables2.AddVariable("Q", MInteger().Is(3)));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const GenerationPlan> plan1,
+                                GetGenerationPlan(variables1, ValueSet()));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const GenerationPlan> plan2,
+                                GetGenerationPlan(variables2, ValueSet()));
+
+  EXPECT_EQ(plan1, plan2);
+}
+
+TEST(GenerationBootstrapTest, GetGenerationPlanChangesWhenDependenciesChange) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variables.AddVariable("B", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const GenerationPlan> before,
+                                GetGenerationPlan(variables, ValueSet()));
+
+  MORIARTY_ASSERT_OK(variables.AddOrMergeVariable("A", MInteger().AtMost("B")));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::shared_ptr<const GenerationPlan> after,
+                                GetGenerationPlan(variables, ValueSet()));
+
+  EXPECT_NE(before, after);
+  EXPECT_THAT(before->deps_map.at("A"), IsEmpty());
+  EXPECT_THAT(after->deps_map.at("A"), ElementsAre("B"));
+}
+
+TEST(GenerationBootstrapTest,
+     GetGenerationPlanStillFailsOnMissingDependencyAfterBeingCached) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(
+      variables.AddVariable("A", MInteger().Between(1, "UNCACHED_N")));
+  ValueSet known_values;
+  known_values.Set<MInteger>("UNCACHED_N", 5);
+  MORIARTY_ASSERT_OK(GetGenerationPlan(variables, known_values).status());
+
+  EXPECT_THAT(GetGenerationPlan(variables, ValueSet()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 TEST(GenerationBootstrapTest, GetGenerationOrderSingleRoot) {
   absl::flat_hash_map<std::string, std::vector<std::string>> deps_map = {
       {"A", {"C"}}, {"X", {"Y"}},      {"C", {"D"}},
@@ -349,6 +522,26 @@ TEST(GenerationConfigTest, GetGenerationOrderRemainsStable) {
   EXPECT_THAT(results, Each(Eq(results[0])));
 }
 
+TEST(GenerationConfigTest, GetGenerationOrderHandlesManyVariables) {
+  // A long chain, with every variable also depending on the last one.
+  constexpr int kNumVariables = 5000;
+  absl::flat_hash_map<std::string, std::vector<std::string>> deps_map;
+  std::vector<std::string> expected_result;
+  for (int i = 0; i < kNumVariables; i++) {
+    std::string name = absl::StrCat("V", 100000 + i);
+    std::string last = absl::StrCat("V", 100000 + kNumVariables - 1);
+    if (i + 1 < kNumVariables) {
+      deps_map[name] = {absl::StrCat("V", 100000 + i + 1), last};
+    } else {
+      deps_map[name] = {};
+    }
+    expected_result.push_back(name);
+  }
+
+  EXPECT_THAT(GetGenerationOrder(deps_map, ValueSet()),
+              IsOkAndHolds(ContainerEq(expected_result)));
+}
+
 TEST(GenerationConfigTest, GetGenerationOrderNoElementsReturnsEmpty) {
   absl::flat_hash_map<std::string, std::vector<std::string>> deps_map = {};
 
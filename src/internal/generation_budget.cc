@@ -0,0 +1,84 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/generation_budget.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+GenerationBudget::GenerationBudget(GenerationLimits limits)
+    : limits_(std::move(limits)) {}
+
+void GenerationBudget::RecordGenerateCall() {
+  generate_calls_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool GenerationBudget::TracksBytes() const {
+  return limits_.max_bytes.has_value();
+}
+
+void GenerationBudget::RecordBytes(int64_t bytes) {
+  bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+absl::Status GenerationBudget::Check() const {
+  int64_t generate_calls = generate_calls_.load(std::memory_order_relaxed);
+  int64_t bytes = bytes_.load(std::memory_order_relaxed);
+  auto exhausted = [&](absl::string_view limit) {
+    return absl::ResourceExhaustedError(absl::Substitute(
+        "generation budget exceeded: $0 (after $1 generate calls and $2 "
+        "bytes generated)",
+        limit, generate_calls, bytes));
+  };
+
+  if (limits_.max_generate_calls &&
+      generate_calls > *limits_.max_generate_calls) {
+    return exhausted(absl::StrCat("more than ", *limits_.max_generate_calls,
+                                  " generate calls"));
+  }
+  if (limits_.max_bytes && bytes > *limits_.max_bytes)
+    return exhausted(
+        absl::StrCat("more than ", *limits_.max_bytes, " bytes generated"));
+  if (limits_.max_wall_time &&
+      absl::Now() - start_ + recorded_wall_time_ > *limits_.max_wall_time)
+    return exhausted(absl::StrCat("wall time limit of ",
+                                  absl::FormatDuration(*limits_.max_wall_time),
+                                  " reached"));
+  return absl::OkStatus();
+}
+
+GenerationUsage GenerationBudget::Usage() const {
+  return {.generate_calls = generate_calls_.load(std::memory_order_relaxed),
+          .bytes = bytes_.load(std::memory_order_relaxed),
+          .wall_time = absl::Now() - start_ + recorded_wall_time_};
+}
+
+void GenerationBudget::RecordUsage(const GenerationUsage& usage) {
+  generate_calls_.fetch_add(usage.generate_calls, std::memory_order_relaxed);
+  bytes_.fetch_add(usage.bytes, std::memory_order_relaxed);
+  recorded_wall_time_ += usage.wall_time;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
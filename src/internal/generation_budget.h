@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_GENERATION_BUDGET_H_
+#define MORIARTY_SRC_INTERNAL_GENERATION_BUDGET_H_
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// GenerationLimits
+//
+// Limits on how much work a single generator may do across all of its
+// iterations. Limits that are not set are not enforced.
+struct GenerationLimits {
+  // Wall-clock time since the generator started assigning values.
+  std::optional<absl::Duration> max_wall_time;
+
+  // Number of attempts to generate a value for any variable (including
+  // subvariables, elements of arrays and failed attempts).
+  std::optional<int64_t> max_generate_calls;
+
+  // Number of bytes in all top-level values generated. See
+  // `MVariable::ValueByteSize()`.
+  std::optional<int64_t> max_bytes;
+};
+
+// GenerationUsage
+//
+// The work recorded by a `GenerationBudget`.
+struct GenerationUsage {
+  int64_t generate_calls = 0;
+  int64_t bytes = 0;
+  absl::Duration wall_time;
+};
+
+// GenerationBudget
+//
+// Tracks the work done so far against a set of `GenerationLimits`. The wall
+// time starts when the budget is constructed. A budget may be shared between
+// several `GenerationConfig`s, including ones used on different threads.
+class GenerationBudget {
+ public:
+  explicit GenerationBudget(GenerationLimits limits);
+
+  // RecordGenerateCall()
+  //
+  // Records one attempt to generate a value.
+  void RecordGenerateCall();
+
+  // TracksBytes()
+  //
+  // Returns true if `RecordBytes()` has any effect.
+  bool TracksBytes() const;
+
+  // RecordBytes()
+  //
+  // Records that a top-level value of approximately `bytes` bytes was
+  // generated.
+  void RecordBytes(int64_t bytes);
+
+  // Check()
+  //
+  // Returns a ResourceExhausted status describing the first limit that has
+  // been exceeded, or OkStatus if none have.
+  absl::Status Check() const;
+
+  // Usage()
+  //
+  // Returns the work recorded so far, including the wall time since the
+  // budget was constructed.
+  GenerationUsage Usage() const;
+
+  // RecordUsage()
+  //
+  // Records `usage` as if it had been done by this budget (e.g., work done by
+  // an earlier run that is being resumed). Its wall time is added to the wall
+  // time used. Must not be called concurrently with `Check()` or `Usage()`.
+  void RecordUsage(const GenerationUsage& usage);
+
+ private:
+  GenerationLimits limits_;
+  absl::Time start_ = absl::Now();
+  absl::Duration recorded_wall_time_;
+  std::atomic<int64_t> generate_calls_ = 0;
+  std::atomic<int64_t> bytes_ = 0;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_GENERATION_BUDGET_H_
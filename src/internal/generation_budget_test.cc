@@ -0,0 +1,95 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/generation_budget.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::HasSubstr;
+using ::moriarty::IsOk;
+using ::moriarty::StatusIs;
+
+TEST(GenerationBudgetTest, WithoutLimitsTheBudgetIsNeverExceeded) {
+  GenerationBudget budget({});
+  for (int i = 0; i < 1000; i++) budget.RecordGenerateCall();
+  budget.RecordBytes(1 << 30);
+  EXPECT_FALSE(budget.TracksBytes());
+  MORIARTY_EXPECT_OK(budget.Check());
+}
+
+TEST(GenerationBudgetTest, ExceedingMaxGenerateCallsFails) {
+  GenerationBudget budget({.max_generate_calls = 3});
+  for (int i = 0; i < 3; i++) budget.RecordGenerateCall();
+  MORIARTY_EXPECT_OK(budget.Check());
+
+  budget.RecordGenerateCall();
+  EXPECT_THAT(budget.Check(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("more than 3 generate calls")));
+}
+
+TEST(GenerationBudgetTest, ExceedingMaxBytesFails) {
+  GenerationBudget budget({.max_bytes = 100});
+  EXPECT_TRUE(budget.TracksBytes());
+  budget.RecordBytes(60);
+  EXPECT_THAT(budget.Check(), IsOk());
+
+  budget.RecordBytes(60);
+  EXPECT_THAT(budget.Check(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("more than 100 bytes generated")));
+}
+
+TEST(GenerationBudgetTest, ExceedingMaxWallTimeFails) {
+  GenerationBudget generous({.max_wall_time = absl::Hours(1)});
+  MORIARTY_EXPECT_OK(generous.Check());
+
+  GenerationBudget budget({.max_wall_time = absl::ZeroDuration()});
+  absl::SleepFor(absl::Milliseconds(1));
+  EXPECT_THAT(budget.Check(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("wall time limit of 0 reached")));
+}
+
+TEST(GenerationBudgetTest, RecordedUsageCountsTowardsTheLimits) {
+  GenerationBudget budget({.max_wall_time = absl::Hours(1),
+                           .max_generate_calls = 10,
+                           .max_bytes = 100});
+  budget.RecordUsage(
+      {.generate_calls = 10, .bytes = 100, .wall_time = absl::Minutes(30)});
+  MORIARTY_EXPECT_OK(budget.Check());
+
+  GenerationUsage usage = budget.Usage();
+  EXPECT_EQ(usage.generate_calls, 10);
+  EXPECT_EQ(usage.bytes, 100);
+  EXPECT_GE(usage.wall_time, absl::Minutes(30));
+
+  budget.RecordUsage({.wall_time = absl::Minutes(30)});
+  EXPECT_THAT(budget.Check(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("wall time limit of 1h reached")));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -14,65 +14,149 @@
 
 #include "src/internal/generation_config.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <deque>
 #include <iterator>
 #include <optional>
-#include <stack>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/variable_name_utils.h"
 
 namespace moriarty {
 namespace moriarty_internal {
 
+namespace {
+
+// Returns true if `variable_name` is a subvariable of `parent_name`. E.g.,
+// "A.element[3]" is a subvariable of "A".
+bool IsSubvariableOf(absl::string_view variable_name,
+                     absl::string_view parent_name) {
+  return variable_name.size() > parent_name.size() &&
+         absl::StartsWith(variable_name, parent_name) &&
+         variable_name[parent_name.size()] == '.';
+}
+
+}  // namespace
+
 absl::Status GenerationConfig::MarkStartGeneration(
     absl::string_view variable_name) {
-  auto [it, inserted] =
-      generation_info_.insert({std::string(variable_name), GenerationInfo{}});
-
-  GenerationInfo& generation_info = it->second;
+  bool is_subvariable =
+      !variables_actively_being_generated_.empty() &&
+      IsSubvariableOf(variable_name,
+                      variables_actively_being_generated_.back().variable_name);
+  absl::flat_hash_map<std::string, GenerationInfo>& info_map =
+      is_subvariable
+          ? variables_actively_being_generated_.back().subvariable_info
+          : generation_info_;
+  GenerationInfo& generation_info =
+      info_map.insert({std::string(variable_name), GenerationInfo{}})
+          .first->second;
   if (generation_info.actively_being_generated) {
     return absl::FailedPreconditionError(absl::Substitute(
         "cyclic dependency while generating $0", variable_name));
   }
+  if (!CheckBudget(variable_name)) return budget_status_;
   generation_info.actively_being_generated = true;
   generation_info.generated_variables_size_before_generation =
       generated_variables_.size();
 
-  variables_actively_being_generated_.push(
-      {.variable_name = std::string(variable_name), .active_retry_count = 0});
+  ActiveGenerationMetadata metadata = {
+      .variable_name = std::string(variable_name),
+      .active_retry_count = 0,
+      .is_subvariable = is_subvariable};
+  if (profile_) {
+    metadata.profile_key = GenerationProfile::ChildKey(
+        variables_actively_being_generated_.empty()
+            ? ""
+            : variables_actively_being_generated_.back().profile_key,
+        variable_name);
+    metadata.start_time = absl::Now();
+  }
+  variables_actively_being_generated_.push_back(std::move(metadata));
 
   return absl::OkStatus();
 }
 
+GenerationConfig::GenerationInfo& GenerationConfig::ActiveGenerationInfo() {
+  int top = static_cast<int>(variables_actively_being_generated_.size()) - 1;
+  const ActiveGenerationMetadata& metadata =
+      variables_actively_being_generated_[top];
+  if (!metadata.is_subvariable)
+    return generation_info_.find(metadata.variable_name)->second;
+  return variables_actively_being_generated_[top - 1]
+      .subvariable_info.find(metadata.variable_name)
+      ->second;
+}
+
+void GenerationConfig::RecordWallTime(
+    const ActiveGenerationMetadata& metadata) {
+  if (!profile_) return;
+  profile_->GetEntry(metadata.profile_key).wall_time +=
+      absl::Now() - metadata.start_time;
+}
+
 absl::Status GenerationConfig::MarkSuccessfulGeneration(
-    absl::string_view variable_name) {
+    absl::string_view variable_name, int64_t bytes_generated,
+    int64_t allocated_bytes) {
   if (variables_actively_being_generated_.empty() ||
-      variables_actively_being_generated_.top().variable_name !=
+      variables_actively_being_generated_.back().variable_name !=
           variable_name) {
     return absl::InvalidArgumentError(absl::Substitute(
         "Marking a successful generation for the wrong variable. Expected "
         "the variable to be: `$0`, but was `$1`",
         variables_actively_being_generated_.empty()
             ? "(empty)"
-            : variables_actively_being_generated_.top().variable_name,
+            : variables_actively_being_generated_.back().variable_name,
         variable_name));
   }
 
-  variables_actively_being_generated_.pop();
-  generated_variables_.push_back(std::string(variable_name));
+  if (profile_) {
+    const ActiveGenerationMetadata& metadata =
+        variables_actively_being_generated_.back();
+    GenerationProfile::Entry& entry = profile_->GetEntry(metadata.profile_key);
+    entry.generate_attempts++;
+    entry.bytes_generated += bytes_generated;
+    entry.allocated_bytes += allocated_bytes;
+    RecordWallTime(metadata);
+  }
+  if (budget_) {
+    budget_->RecordGenerateCall();
+    if (count_budget_bytes_ && variables_actively_being_generated_.size() == 1)
+      budget_->RecordBytes(bytes_generated);
+  }
 
-  GenerationInfo& gen_info = generation_info_.find(variable_name)->second;
+  GenerationInfo& gen_info = ActiveGenerationInfo();
   gen_info.most_recent_generation_status = absl::OkStatus();
   gen_info.actively_being_generated = false;
+  if (variables_actively_being_generated_.back().is_subvariable) {
+    // Nothing needs to be remembered about a subvariable that never failed.
+    if (gen_info.total_retry_count == 0) {
+      int parent = variables_actively_being_generated_.size() - 2;
+      variables_actively_being_generated_[parent].subvariable_info.erase(
+          variable_name);
+    }
+  } else {
+    generated_variables_.push_back(std::string(variable_name));
+  }
+  variables_actively_being_generated_.pop_back();
 
   total_generate_calls_++;
 
@@ -82,25 +166,33 @@ absl::Status GenerationConfig::MarkSuccessfulGeneration(
 absl::Status GenerationConfig::MarkAbandonedGeneration(
     absl::string_view variable_name) {
   if (variables_actively_being_generated_.empty() ||
-      variables_actively_being_generated_.top().variable_name !=
+      variables_actively_being_generated_.back().variable_name !=
           variable_name) {
     return absl::InvalidArgumentError(absl::Substitute(
         "Marking an unsuccessful generation for the wrong variable. Expected "
         "the variable to be: `$0`, but was `$1`",
         variables_actively_being_generated_.empty()
             ? "(empty)"
-            : variables_actively_being_generated_.top().variable_name,
+            : variables_actively_being_generated_.back().variable_name,
         variable_name));
   }
 
-  variables_actively_being_generated_.pop();
-
-  GenerationInfo& gen_info = generation_info_.find(variable_name)->second;
-  gen_info.actively_being_generated = false;
+  RecordWallTime(variables_actively_being_generated_.back());
+  ActiveGenerationInfo().actively_being_generated = false;
+  variables_actively_being_generated_.pop_back();
 
   return absl::OkStatus();
 }
 
+void GenerationConfig::SetRetryBudget(absl::string_view variable_name,
+                                      RetryBudget budget) {
+  retry_budgets_[variable_name] = budget;
+}
+
+void GenerationConfig::SetDependencies(const DependencyMap* dependencies) {
+  dependencies_ = dependencies;
+}
+
 namespace {
 
 // Resizes `vec` to `desired_size`, and returns a vector with the contents
@@ -116,18 +208,60 @@ std::vector<std::string> ExtractSuffix(std::vector<std::string>& vec,
 
 }  // namespace
 
+std::vector<std::string> GenerationConfig::ExtractVariablesToDelete(
+    absl::string_view variable_name, int generated_variables_start,
+    bool keep_dependencies) {
+  if (dependencies_ == nullptr || !keep_dependencies)
+    return ExtractSuffix(generated_variables_, generated_variables_start);
+
+  // Follow the reverse edges from `variable_name`. A variable is always
+  // generated after its dependencies, so one pass in generation order sees
+  // every deleted variable before its dependents. Subvariables are not in
+  // `dependencies_`, so they go with their base variable.
+  absl::flat_hash_set<std::string> deleted = {std::string(variable_name)};
+  std::vector<std::string> to_delete;
+  std::vector<std::string> kept;
+  for (int i = generated_variables_start; i < generated_variables_.size();
+       i++) {
+    std::string& name = generated_variables_[i];
+    bool erase;
+    if (SubvariableName(name)) {
+      erase = deleted.contains(BaseVariableName(name));
+    } else if (auto it = dependencies_->find(name);
+               it == dependencies_->end()) {
+      erase = true;
+    } else {
+      erase = absl::c_any_of(it->second, [&](const std::string& dep) {
+        return deleted.contains(dep);
+      });
+    }
+    if (erase) {
+      deleted.insert(name);
+      to_delete.push_back(std::move(name));
+    } else {
+      kept.push_back(std::move(name));
+    }
+  }
+
+  generated_variables_.resize(generated_variables_start);
+  for (std::string& name : kept)
+    generated_variables_.push_back(std::move(name));
+  return to_delete;
+}
+
 absl::StatusOr<GenerationConfig::RetryRecommendation>
-GenerationConfig::AddGenerationFailure(absl::string_view variable_name,
-                                       absl::Status status) {
+GenerationConfig::AddGenerationFailure(
+    absl::string_view variable_name, absl::Status status,
+    GenerationProfile::Rejection rejection) {
   if (variables_actively_being_generated_.empty() ||
-      variables_actively_being_generated_.top().variable_name !=
+      variables_actively_being_generated_.back().variable_name !=
           variable_name) {
     return absl::InvalidArgumentError(absl::Substitute(
         "Marking an unsuccessful generation for the wrong variable. Expected "
         "the variable to be: `$0`, but was `$1`",
         variables_actively_being_generated_.empty()
             ? "(empty)"
-            : variables_actively_being_generated_.top().variable_name,
+            : variables_actively_being_generated_.back().variable_name,
         variable_name));
   }
   if (status.ok()) {
@@ -135,24 +269,38 @@ GenerationConfig::AddGenerationFailure(absl::string_view variable_name,
         "Passed absl::OkStatus() to AddGenerationFailure()");
   }
 
-  GenerationInfo& generation_info =
-      generation_info_.find(variable_name)->second;
+  GenerationInfo& generation_info = ActiveGenerationInfo();
   generation_info.most_recent_generation_status = std::move(status);
 
   ActiveGenerationMetadata& metadata =
-      variables_actively_being_generated_.top();
+      variables_actively_being_generated_.back();
+  if (profile_) {
+    GenerationProfile::Entry& entry = profile_->GetEntry(metadata.profile_key);
+    entry.generate_attempts++;
+    entry.AddRejection(rejection);
+  }
 
   int active_retries = ++metadata.active_retry_count;
   int total_retries = ++generation_info.total_retry_count;
   int total_generates = ++total_generate_calls_;
+  if (budget_) budget_->RecordGenerateCall();
 
+  bool keep_dependencies =
+      active_retries % kRetriesBeforeDeletingDependencies != 0;
   RetryRecommendation recommendation = {
-      .variable_names_to_delete = ExtractSuffix(
-          generated_variables_,
-          generation_info.generated_variables_size_before_generation)};
-
-  if (active_retries > kMaxActiveRetries || total_retries > kMaxTotalRetries ||
-      total_generates > kMaxTotalGenerateCalls) {
+      .variable_names_to_delete = ExtractVariablesToDelete(
+          variable_name,
+          generation_info.generated_variables_size_before_generation,
+          keep_dependencies)};
+
+  RetryBudget budget;
+  if (auto it = retry_budgets_.find(variable_name); it != retry_budgets_.end())
+    budget = it->second;
+
+  if (active_retries > budget.max_active_retries ||
+      total_retries > budget.max_total_retries ||
+      total_generates > kMaxTotalGenerateCalls ||
+      !CheckBudget(variable_name)) {
     recommendation.policy = RetryRecommendation::kAbort;
     return recommendation;
   }
@@ -163,14 +311,27 @@ GenerationConfig::AddGenerationFailure(absl::string_view variable_name,
 
 absl::Status GenerationConfig::GetGenerationStatus(
     absl::string_view variable_name) {
-  auto it = generation_info_.find(variable_name);
+  const GenerationInfo* info = nullptr;
+  if (auto it = generation_info_.find(variable_name);
+      it != generation_info_.end()) {
+    info = &it->second;
+  }
+  // Subvariables are kept by their parent, which is somewhere on the stack.
+  for (const ActiveGenerationMetadata& metadata :
+       variables_actively_being_generated_) {
+    if (info != nullptr) break;
+    if (auto it = metadata.subvariable_info.find(variable_name);
+        it != metadata.subvariable_info.end()) {
+      info = &it->second;
+    }
+  }
 
-  if (it == generation_info_.end()) {
+  if (info == nullptr) {
     return absl::InvalidArgumentError(absl::Substitute(
         "No generation status available for '$0'", variable_name));
   }
 
-  std::optional<absl::Status> status = it->second.most_recent_generation_status;
+  std::optional<absl::Status> status = info->most_recent_generation_status;
   if (!status.has_value()) {
     return absl::FailedPreconditionError(absl::Substitute(
         "No generation status available for '$0'", variable_name));
@@ -187,5 +348,70 @@ std::optional<int64_t> GenerationConfig::GetSoftGenerationLimit() const {
   return soft_generation_limit_;
 }
 
+ScopedSoftGenerationLimit::ScopedSoftGenerationLimit(GenerationConfig* config,
+                                                     int64_t limit)
+    : config_(config) {
+  if (config_ == nullptr || !config_->soft_generation_limit_) return;
+  previous_limit_ = config_->soft_generation_limit_;
+  config_->soft_generation_limit_ = std::min(*previous_limit_, limit);
+}
+
+ScopedSoftGenerationLimit::~ScopedSoftGenerationLimit() {
+  if (previous_limit_) config_->soft_generation_limit_ = previous_limit_;
+}
+
+void GenerationConfig::SetScheduler(Scheduler* scheduler) {
+  scheduler_ = scheduler;
+}
+
+Scheduler* GenerationConfig::GetScheduler() const { return scheduler_; }
+
+void GenerationConfig::SetProfile(GenerationProfile* profile) {
+  profile_ = profile;
+}
+
+GenerationProfile* GenerationConfig::GetProfile() const { return profile_; }
+
+void GenerationConfig::MergeProfile(const GenerationProfile& profile) {
+  if (!profile_) return;
+  if (variables_actively_being_generated_.empty()) {
+    profile_->MergeFrom(profile);
+  } else {
+    profile_->MergeFrom(profile,
+                        variables_actively_being_generated_.back().profile_key);
+  }
+}
+
+void GenerationConfig::SetBudget(GenerationBudget* budget, bool count_bytes) {
+  budget_ = budget;
+  count_budget_bytes_ = count_bytes;
+}
+
+GenerationBudget* GenerationConfig::GetBudget() const { return budget_; }
+
+absl::Status GenerationConfig::GetBudgetStatus() const {
+  return budget_status_;
+}
+
+bool GenerationConfig::ShouldComputeGeneratedBytes() const {
+  if (profile_) return true;
+  return budget_ && count_budget_bytes_ && budget_->TracksBytes() &&
+         variables_actively_being_generated_.size() == 1;
+}
+
+bool GenerationConfig::CheckBudget(absl::string_view variable_name) {
+  if (!budget_status_.ok()) return false;
+  if (!budget_) return true;
+  absl::Status status = budget_->Check();
+  if (status.ok()) return true;
+
+  std::string message =
+      absl::StrCat(status.message(), " while generating `", variable_name, "`");
+  if (profile_)
+    absl::StrAppend(&message, ". Generation profile: ", profile_->ToJson());
+  budget_status_ = absl::ResourceExhaustedError(message);
+  return false;
+}
+
 }  // namespace moriarty_internal
 }  // namespace moriarty
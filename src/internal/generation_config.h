@@ -19,7 +19,6 @@
 
 #include <cstdint>
 #include <optional>
-#include <stack>
 #include <string>
 #include <vector>
 
@@ -27,6 +26,10 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
+#include "src/internal/scheduler.h"
 
 namespace moriarty {
 namespace moriarty_internal {
@@ -43,26 +46,82 @@ namespace moriarty_internal {
 // Then you must MarkSuccessfulGeneration or AbandonGeneration to pop it.
 class GenerationConfig {
  public:
-  // TODO(darcybest): Consider letting the user specify these values.
+  // Default retry budgets. These may be overridden per variable with
+  // `SetRetryBudget()`.
   constexpr static int kMaxActiveRetries = 1000;
   constexpr static int kMaxTotalRetries = 100000;
   constexpr static int64_t kMaxTotalGenerateCalls = 10 * 1000 * 1000;
 
+  // If `SetDependencies()` was called, a failing variable keeps its generated
+  // dependencies, except on every `kRetriesBeforeDeletingDependencies`-th
+  // retry (in case those dependencies are what makes it fail).
+  constexpr static int kRetriesBeforeDeletingDependencies = 10;
+
+  // After this many values in a row are rejected by a variable's custom
+  // constraints, it enumerates its possible values (if there are at most
+  // `kMaxEnumeratedValues` of them) and samples from those that satisfy the
+  // custom constraints instead. See `MVariable::EnumerateImpl()`.
+  constexpr static int kRejectionsBeforeEnumerating = 32;
+  constexpr static int64_t kMaxEnumeratedValues = 1000 * 1000;
+
+  // The number of values generated together when a variable generates many
+  // independent values on several threads. See `SetScheduler()`.
+  constexpr static int kParallelGenerationChunkSize = 1 << 12;
+
+  // RetryBudget (class)
+  //
+  // The number of times a variable may fail to generate before
+  // `AddGenerationFailure()` recommends aborting.
+  //
+  //  * `max_active_retries` is the number of failures allowed between a call
+  //    to `MarkStartGeneration()` and its corresponding `MarkXXXGeneration()`.
+  //  * `max_total_retries` is the number of failures allowed overall.
+  struct RetryBudget {
+    int max_active_retries = kMaxActiveRetries;
+    int max_total_retries = kMaxTotalRetries;
+  };
+
+  using DependencyMap =
+      absl::flat_hash_map<std::string, std::vector<std::string>>;
+
+  // SetRetryBudget()
+  //
+  // Sets the retry budget for `variable_name`. Variables without a budget use
+  // `kMaxActiveRetries` and `kMaxTotalRetries`.
+  void SetRetryBudget(absl::string_view variable_name, RetryBudget budget);
+
+  // SetDependencies()
+  //
+  // Tells this class which variables each variable depends on. This is used to
+  // reduce the set of variables deleted by `AddGenerationFailure()`. If this is
+  // not called, every variable generated since the failing variable started is
+  // deleted.
+  //
+  // `dependencies` must outlive this class (or the next call to
+  // `SetDependencies()`).
+  void SetDependencies(const DependencyMap* dependencies);
+
   // MarkStartGeneration()
   //
   // Informs this class that `variable_name` has started generation.
   //
   // Returns a FailedPrecondition status if this variable is already in the
-  // process of being generated (cyclic dependency).
+  // process of being generated (cyclic dependency). Returns a
+  // ResourceExhausted status if the budget (see `SetBudget()`) is exceeded.
   absl::Status MarkStartGeneration(absl::string_view variable_name);
 
   // MarkSuccessfulGeneration()
   //
   // Informs this class that `variable_name` has succeeded in its generation.
+  // `bytes_generated` is only used for profiling and the budget (see
+  // `ShouldComputeGeneratedBytes()`). `allocated_bytes` (see
+  // `AllocatedByteSize()`) is only used for profiling.
   //
   // MarkStartGeneration(variable_name) must have been called and all generation
   // attempts for all other variables since must be complete.
-  absl::Status MarkSuccessfulGeneration(absl::string_view variable_name);
+  absl::Status MarkSuccessfulGeneration(absl::string_view variable_name,
+                                        int64_t bytes_generated = 0,
+                                        int64_t allocated_bytes = 0);
 
   // MarkAbandonedGeneration()
   //
@@ -77,7 +136,8 @@ class GenerationConfig {
   //
   // On a failed generation attempt, this recommends if you should retry to not.
   // Also, provides information about values of variables that should be deleted
-  // from the universe.
+  // from the universe. Generation is always aborted once the budget (see
+  // `SetBudget()`) is exceeded.
   struct RetryRecommendation {
     enum Policy {
       kAbort,  // Do not continue retrying
@@ -91,23 +151,33 @@ class GenerationConfig {
   //
   // Informs this class that `variable_name` has failed to generate a value with
   // a status of `failure_status`. Returns a recommendation for if the variable
-  // should retry generation or abort generation.
+  // should retry generation or abort generation. `rejection` is only used for
+  // profiling (see `SetProfile()`).
   //
   // The list of variables to be deleted in the recommendation are those that
-  // were generated since this variable started its generation. This class will
-  // assume that the value for those variables have been deleted from the
-  // universe.
+  // were generated since this variable started its generation. If
+  // `SetDependencies()` was called, this is restricted to the variables that
+  // (transitively) depend on `variable_name` and to its subvariables, so its
+  // dependencies (e.g., the length `N` of an array) keep their values. See
+  // `kRetriesBeforeDeletingDependencies`. Variables with no known dependencies
+  // are always deleted. This class will assume that the value for those
+  // variables have been deleted from the universe.
   //
   // MarkStartGeneration(variable_name) must have been called and all generation
   // attempts for all other variables since must be complete.
   absl::StatusOr<RetryRecommendation> AddGenerationFailure(
-      absl::string_view variable_name, absl::Status failure_status);
+      absl::string_view variable_name, absl::Status failure_status,
+      GenerationProfile::Rejection rejection =
+          GenerationProfile::Rejection::kError);
 
   // GetGenerationStatus()
   //
   // Returns the most recent generation status for `variable_name`. If no
   // attempts to generate were made, returns absl::InvalidArgumentError.
   //
+  // The status of a subvariable (e.g., "A.element[3]") is only kept while its
+  // parent is being generated, and is dropped once it generates successfully.
+  //
   // `MarkStartGeneration(variable_name)` must have been called previously.
   absl::Status GetGenerationStatus(absl::string_view variable_name);
 
@@ -132,34 +202,156 @@ class GenerationConfig {
   // If there is no soft limit, returns `std::nullopt`.
   std::optional<int64_t> GetSoftGenerationLimit() const;
 
+  // SetScheduler()
+  //
+  // The scheduler a single variable may use to generate its value on several
+  // threads (e.g., for the elements of a large array). Values generated this
+  // way must not depend on the number of threads. If `nullptr` (the default),
+  // everything is generated on the calling thread. Not owned.
+  void SetScheduler(Scheduler* scheduler);
+
+  // GetScheduler()
+  //
+  // Returns the scheduler, or `nullptr` if there is none. See `SetScheduler()`
+  // for info.
+  Scheduler* GetScheduler() const;
+
+  // SetProfile()
+  //
+  // Records the wall time, number of attempts, rejections and bytes generated
+  // for each variable in `profile`. If this is not called (or `profile` is
+  // `nullptr`), nothing is recorded. `profile` must outlive this class.
+  void SetProfile(GenerationProfile* profile);
+
+  // GetProfile()
+  //
+  // Returns the profile set by `SetProfile()`, or `nullptr`.
+  GenerationProfile* GetProfile() const;
+
+  // MergeProfile()
+  //
+  // Adds `profile` (e.g., from values generated with a separate
+  // `GenerationConfig`) to this config's profile, nested inside the variable
+  // that is currently being generated. No-op if there is no profile.
+  void MergeProfile(const GenerationProfile& profile);
+
+  // SetBudget()
+  //
+  // Enforces the limits of `budget` on all values generated with this config.
+  // Each generation attempt is counted against `budget`. If `count_bytes`, the
+  // size of each top-level value is too; pass false if the values generated
+  // here are part of a larger value generated with another config that shares
+  // `budget`. `budget` must outlive this class.
+  void SetBudget(GenerationBudget* budget, bool count_bytes = true);
+
+  // GetBudget()
+  //
+  // Returns the budget set by `SetBudget()`, or `nullptr`.
+  GenerationBudget* GetBudget() const;
+
+  // GetBudgetStatus()
+  //
+  // Returns the ResourceExhausted status from the first time the budget was
+  // exceeded, or OkStatus if it has not been. The message includes the
+  // variable being generated and, if profiling, the profile so far.
+  absl::Status GetBudgetStatus() const;
+
+  // ShouldComputeGeneratedBytes()
+  //
+  // Returns true if the size of the value of the variable currently being
+  // generated is needed by `MarkSuccessfulGeneration()`.
+  bool ShouldComputeGeneratedBytes() const;
+
  private:
   int64_t total_generate_calls_ = 0;
 
+  // Retry counts.
+  //  * "Active" is set to 0 whenever MarkXXXXGeneration() is called.
+  //  * "Total" is never reset
+  struct GenerationInfo {
+    std::optional<absl::Status> most_recent_generation_status;
+    int total_retry_count = 0;
+    bool actively_being_generated = false;
+    int generated_variables_size_before_generation;
+  };
+
   // Metadata related to variables that are actively being generated.
   struct ActiveGenerationMetadata {
     std::string variable_name;
     int64_t active_retry_count = 0;
+    // True if this is a subvariable (e.g., "A.element[3]") of the variable
+    // below it on the stack. Its `GenerationInfo` is then kept in that
+    // variable's `subvariable_info` rather than in `generation_info_`.
+    bool is_subvariable = false;
+    // The `GenerationInfo` of this variable's subvariables. Subvariables that
+    // succeed on their first attempt are removed right away, and the rest are
+    // freed with this entry, so e.g. the elements of a large array do not
+    // leave anything behind.
+    absl::flat_hash_map<std::string, GenerationInfo> subvariable_info;
+    // Only set when profiling.
+    std::string profile_key;
+    absl::Time start_time;
   };
 
   // Variables are generated in a stack-like fashion.
-  std::stack<ActiveGenerationMetadata> variables_actively_being_generated_;
+  std::vector<ActiveGenerationMetadata> variables_actively_being_generated_;
 
   // The variables that were successfully generated, in the order they were
-  // generated.
+  // generated. Subvariables are not included: their values are part of their
+  // parent's value, which is deleted instead.
   std::vector<std::string> generated_variables_;
 
-  // Retry counts.
-  //  * "Active" is set to 0 whenever MarkXXXXGeneration() is called.
-  //  * "Total" is never reset
-  struct GenerationInfo {
-    std::optional<absl::Status> most_recent_generation_status;
-    int total_retry_count = 0;
-    bool actively_being_generated = false;
-    int generated_variables_size_before_generation;
-  };
+  // The `GenerationInfo` of variables that are not subvariables.
   absl::flat_hash_map<std::string, GenerationInfo> generation_info_;
 
+  absl::flat_hash_map<std::string, RetryBudget> retry_budgets_;
+  const DependencyMap* dependencies_ = nullptr;  // Not owned.
+
   std::optional<int64_t> soft_generation_limit_;
+  Scheduler* scheduler_ = nullptr;       // Not owned.
+  GenerationProfile* profile_ = nullptr;  // Not owned.
+  GenerationBudget* budget_ = nullptr;    // Not owned.
+  bool count_budget_bytes_ = true;
+  absl::Status budget_status_;
+
+  // Returns the `GenerationInfo` of the variable being generated at the top of
+  // the stack.
+  GenerationInfo& ActiveGenerationInfo();
+
+  // Returns false (and records `budget_status_`) if the budget is exceeded.
+  bool CheckBudget(absl::string_view variable_name);
+
+  // Adds the time since `metadata` started to the profile (if any).
+  void RecordWallTime(const ActiveGenerationMetadata& metadata);
+
+  // Removes the variables that need to be regenerated after `variable_name`
+  // failed from `generated_variables_` and returns them. If
+  // `keep_dependencies`, only its dependents and subvariables are removed.
+  std::vector<std::string> ExtractVariablesToDelete(
+      absl::string_view variable_name, int generated_variables_start,
+      bool keep_dependencies);
+
+  friend class ScopedSoftGenerationLimit;
+};
+
+// ScopedSoftGenerationLimit
+//
+// Lowers the soft generation limit of a `GenerationConfig` to at most `limit`
+// for the lifetime of this object, then restores the previous limit. If the
+// config has no soft generation limit (or is `nullptr`), this has no effect.
+// Used to share a container's limit among its elements.
+class ScopedSoftGenerationLimit {
+ public:
+  ScopedSoftGenerationLimit(GenerationConfig* config, int64_t limit);
+  ~ScopedSoftGenerationLimit();
+
+  ScopedSoftGenerationLimit(const ScopedSoftGenerationLimit&) = delete;
+  ScopedSoftGenerationLimit& operator=(const ScopedSoftGenerationLimit&) =
+      delete;
+
+ private:
+  GenerationConfig* config_;  // Not owned.
+  std::optional<int64_t> previous_limit_;
 };
 
 }  // namespace moriarty_internal
@@ -21,6 +21,10 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
+#include "src/internal/scheduler.h"
 #include "src/util/test_status_macro/status_testutil.h"
 
 namespace moriarty {
@@ -369,6 +373,41 @@ TEST(GenerationConfigTest, SoftGenerationLimitIsUpdatedAppropriately) {
   EXPECT_THAT(g.GetSoftGenerationLimit(), Optional(123456));
 }
 
+TEST(GenerationConfigTest, ScopedSoftGenerationLimitLowersTheLimitInItsScope) {
+  GenerationConfig g;
+  g.SetSoftGenerationLimit(100);
+  {
+    ScopedSoftGenerationLimit lowered(&g, 30);
+    EXPECT_THAT(g.GetSoftGenerationLimit(), Optional(30));
+    {
+      ScopedSoftGenerationLimit not_lowered(&g, 50);
+      EXPECT_THAT(g.GetSoftGenerationLimit(), Optional(30));
+    }
+    EXPECT_THAT(g.GetSoftGenerationLimit(), Optional(30));
+  }
+  EXPECT_THAT(g.GetSoftGenerationLimit(), Optional(100));
+}
+
+TEST(GenerationConfigTest, ScopedSoftGenerationLimitWithoutALimitIsANoop) {
+  GenerationConfig g;
+  {
+    ScopedSoftGenerationLimit lowered(&g, 30);
+    EXPECT_EQ(g.GetSoftGenerationLimit(), std::nullopt);
+  }
+  EXPECT_EQ(g.GetSoftGenerationLimit(), std::nullopt);
+}
+
+TEST(GenerationConfigTest, SchedulerIsNullByDefaultAndCanBeSet) {
+  GenerationConfig g;
+  EXPECT_EQ(g.GetScheduler(), nullptr);
+
+  WorkStealingScheduler scheduler(8);
+  g.SetScheduler(&scheduler);
+  EXPECT_EQ(g.GetScheduler(), &scheduler);
+  g.SetScheduler(nullptr);
+  EXPECT_EQ(g.GetScheduler(), nullptr);
+}
+
 TEST(GenerationConfigTest,
      VariablesToDeleteAreOnesGeneratedBetweenBeginAndEnd) {
   absl::Status fail = absl::FailedPreconditionError("test");
@@ -412,6 +451,281 @@ TEST(GenerationConfigTest, VariablesToDeleteShouldNotDeleteUnrelatedVariables) {
               IsRetryWithDeletedVars(std::vector<std::string>({"p", "q"})));
 }
 
+TEST(GenerationConfigTest, VariablesToDeleteShouldNotIncludeSubvariables) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig g;
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x.element[0]"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("y"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("y"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x.element[0]"));
+
+  // "x.element[0]" is part of the value of "x".
+  EXPECT_THAT(g.AddGenerationFailure("x", fail),
+              IsRetryWithDeletedVars(std::vector<std::string>({"y"})));
+}
+
+TEST(GenerationConfigTest, SubvariableStatusShouldBeFreedWithItsParent) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig g;
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  for (int i = 0; i < 3; i++) {
+    MORIARTY_ASSERT_OK(g.MarkStartGeneration("x.element"));
+    MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x.element"));
+  }
+  // Nothing is kept for subvariables that succeed on their first attempt.
+  EXPECT_THAT(g.GetGenerationStatus("x.element"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x.element"));
+  MORIARTY_ASSERT_OK(g.AddGenerationFailure("x.element", fail));
+  MORIARTY_ASSERT_OK(g.MarkAbandonedGeneration("x.element"));
+  EXPECT_EQ(g.GetGenerationStatus("x.element"), fail);
+
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x"));
+  EXPECT_THAT(g.GetGenerationStatus("x.element"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  MORIARTY_EXPECT_OK(g.GetGenerationStatus("x"));
+}
+
+TEST(GenerationConfigTest, SubvariablesShouldKeepTheirTotalRetriesInTheParent) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig g;
+  g.SetRetryBudget("x.y", {.max_total_retries = 2});
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  for (int i = 0; i < 2; i++) {
+    MORIARTY_ASSERT_OK(g.MarkStartGeneration("x.y"));
+    EXPECT_THAT(g.AddGenerationFailure("x.y", fail), IsRetry());
+    MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x.y"));
+  }
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x.y"));
+  EXPECT_THAT(g.AddGenerationFailure("x.y", fail), IsAbort());
+  MORIARTY_ASSERT_OK(g.MarkAbandonedGeneration("x.y"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x"));
+}
+
+TEST(GenerationConfigTest, SetRetryBudgetOverridesTheDefaultActiveRetries) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig g;
+  g.SetRetryBudget("x", {.max_active_retries = 3});
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_THAT(g.AddGenerationFailure("x", fail), IsRetry());
+  }
+  EXPECT_THAT(g.AddGenerationFailure("x", fail), IsAbort());
+}
+
+TEST(GenerationConfigTest, SetRetryBudgetOverridesTheDefaultTotalRetries) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig g;
+  g.SetRetryBudget("x", {.max_total_retries = 5});
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_THAT(g.AddGenerationFailure("x", fail), IsRetry());
+  }
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x"));
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  for (int i = 0; i < 2; i++) {
+    ASSERT_THAT(g.AddGenerationFailure("x", fail), IsRetry());
+  }
+  EXPECT_THAT(g.AddGenerationFailure("x", fail), IsAbort());
+}
+
+TEST(GenerationConfigTest, SetRetryBudgetOnlyAffectsThatVariable) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig g;
+  g.SetRetryBudget("x", {.max_active_retries = 1});
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("y"));
+  for (int i = 0; i < GenerationConfig::kMaxActiveRetries; i++) {
+    ASSERT_THAT(g.AddGenerationFailure("y", fail), IsRetry());
+  }
+  EXPECT_THAT(g.AddGenerationFailure("y", fail), IsAbort());
+}
+
+TEST(GenerationConfigTest, VariablesToDeleteWithDependenciesKeepsDependencies) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig::DependencyMap deps = {{"A", {"N"}}, {"N", {}}};
+  GenerationConfig g;
+  g.SetDependencies(&deps);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("A"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("N"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("N"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("A.length"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("A.length"));
+
+  EXPECT_THAT(g.AddGenerationFailure("A", fail),
+              IsRetryWithDeletedVars(std::vector<std::string>({"A.length"})));
+  // `N` is still considered generated, so it is not deleted later either.
+  EXPECT_THAT(g.AddGenerationFailure("A", fail),
+              IsRetryWithDeletedVars(std::vector<std::string>()));
+}
+
+TEST(GenerationConfigTest,
+     VariablesToDeleteWithDependenciesDeletesDependenciesEventually) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig::DependencyMap deps = {{"A", {"N"}}, {"N", {}}};
+  GenerationConfig g;
+  g.SetDependencies(&deps);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("A"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("N"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("N"));
+
+  for (int i = 1; i < GenerationConfig::kRetriesBeforeDeletingDependencies;
+       i++) {
+    ASSERT_THAT(g.AddGenerationFailure("A", fail),
+                IsRetryWithDeletedVars(std::vector<std::string>()));
+  }
+  EXPECT_THAT(g.AddGenerationFailure("A", fail),
+              IsRetryWithDeletedVars(std::vector<std::string>({"N"})));
+}
+
+TEST(GenerationConfigTest,
+     VariablesToDeleteWithDependenciesDeletesDependentsOfDeletedVariables) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig::DependencyMap deps = {
+      {"x", {"n"}}, {"n", {}}, {"a", {"x"}}, {"b", {"a", "n"}}, {"c", {"n"}}};
+  GenerationConfig g;
+  g.SetDependencies(&deps);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  for (absl::string_view name : {"n", "a", "b", "b.size", "c", "c.size"}) {
+    MORIARTY_ASSERT_OK(g.MarkStartGeneration(name));
+    MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration(name));
+  }
+
+  EXPECT_THAT(
+      g.AddGenerationFailure("x", fail),
+      IsRetryWithDeletedVars(std::vector<std::string>({"a", "b", "b.size"})));
+}
+
+TEST(GenerationConfigTest,
+     VariablesToDeleteWithDependenciesDeletesVariablesWithUnknownDeps) {
+  absl::Status fail = absl::FailedPreconditionError("test");
+  GenerationConfig::DependencyMap deps = {{"x", {}}};
+  GenerationConfig g;
+  g.SetDependencies(&deps);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("unknown"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("unknown"));
+
+  EXPECT_THAT(g.AddGenerationFailure("x", fail),
+              IsRetryWithDeletedVars(std::vector<std::string>({"unknown"})));
+}
+
+TEST(GenerationConfigTest, ProfileRecordsAttemptsRejectionsAndBytes) {
+  GenerationProfile profile;
+  GenerationConfig g;
+  g.SetProfile(&profile);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(
+      g.AddGenerationFailure("x", absl::FailedPreconditionError("test"),
+                             GenerationProfile::Rejection::kCustomConstraint));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("y"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("y", 8));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x", 16));
+
+  const GenerationProfile::Entry& x = profile.GetEntry("x");
+  EXPECT_EQ(x.generate_attempts, 2);
+  EXPECT_EQ(x.custom_constraint_rejections, 1);
+  EXPECT_EQ(x.bytes_generated, 16);
+
+  const GenerationProfile::Entry& y = profile.GetEntry("x;y");
+  EXPECT_EQ(y.generate_attempts, 1);
+  EXPECT_EQ(y.bytes_generated, 8);
+}
+
+TEST(GenerationConfigTest, WithoutProfileNothingIsRecorded) {
+  GenerationConfig g;
+  EXPECT_EQ(g.GetProfile(), nullptr);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x", 8));
+}
+
+TEST(GenerationConfigTest, ExceedingTheBudgetStopsGeneration) {
+  GenerationBudget budget({.max_generate_calls = 2});
+  GenerationConfig g;
+  g.SetBudget(&budget);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("y"));
+  EXPECT_THAT(g.AddGenerationFailure("y", absl::FailedPreconditionError("y")),
+              IsRetry());
+  EXPECT_THAT(g.AddGenerationFailure("y", absl::FailedPreconditionError("y")),
+              IsAbort());
+  MORIARTY_ASSERT_OK(g.MarkAbandonedGeneration("y"));
+
+  EXPECT_THAT(g.GetBudgetStatus(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("while generating `y`")));
+  EXPECT_THAT(g.MarkStartGeneration("z"),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("while generating `y`")));
+}
+
+TEST(GenerationConfigTest, BudgetStatusContainsTheProfileIfProfiling) {
+  GenerationBudget budget({.max_generate_calls = 1});
+  GenerationProfile profile;
+  GenerationConfig g;
+  g.SetBudget(&budget);
+  g.SetProfile(&profile);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("y"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("y"));
+  EXPECT_THAT(g.MarkStartGeneration("z"),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("\"x\":{\"wall_time_ns\"")));
+}
+
+TEST(GenerationConfigTest, BudgetOnlyCountsBytesOfTopLevelVariables) {
+  GenerationBudget budget({.max_bytes = 10});
+  GenerationConfig g;
+  g.SetBudget(&budget);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x.element"));
+  EXPECT_FALSE(g.ShouldComputeGeneratedBytes());
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x.element", 8));
+  EXPECT_TRUE(g.ShouldComputeGeneratedBytes());
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x", 8));
+  MORIARTY_EXPECT_OK(budget.Check());
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("y"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("y", 8));
+  EXPECT_THAT(g.MarkStartGeneration("z"),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+}
+
+TEST(GenerationConfigTest, BudgetSharedWithoutCountingBytesOnlyCountsCalls) {
+  GenerationBudget budget({.max_generate_calls = 2, .max_bytes = 10});
+  GenerationConfig g;
+  g.SetBudget(&budget, /*count_bytes=*/false);
+
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  EXPECT_FALSE(g.ShouldComputeGeneratedBytes());
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x", 100));
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x", 100));
+  MORIARTY_EXPECT_OK(budget.Check());
+  MORIARTY_ASSERT_OK(g.MarkStartGeneration("x"));
+  MORIARTY_ASSERT_OK(g.MarkSuccessfulGeneration("x", 100));
+  EXPECT_THAT(budget.Check(), StatusIs(absl::StatusCode::kResourceExhausted));
+}
+
 }  // namespace
 }  // namespace moriarty_internal
 }  // namespace moriarty
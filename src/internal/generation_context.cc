@@ -0,0 +1,42 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/generation_context.h"
+
+#include <utility>
+
+#include "src/internal/generation_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+GenerationContext::GenerationContext(VariableSet variables,
+                                     ValueSet known_values, RandomEngine& rng,
+                                     GenerationConfig generation_config)
+    : variables_(std::move(variables)),
+      values_(std::move(known_values)),
+      generation_config_(std::move(generation_config)) {
+  universe_.SetMutableValueSet(&values_)
+      .SetMutableVariableSet(&variables_)
+      .SetGenerationConfig(&generation_config_)
+      .SetRandomEngine(&rng);
+  variables_.SetUniverse(&universe_);
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
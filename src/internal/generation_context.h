@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_GENERATION_CONTEXT_H_
+#define MORIARTY_SRC_INTERNAL_GENERATION_CONTEXT_H_
+
+#include "src/internal/generation_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// GenerationContext
+//
+// Everything that is modified while generating values: a copy of the
+// variables (which are pointed at this context's universe), the values
+// generated so far, the `GenerationConfig` and the `Universe` connecting them
+// to a random engine. Nothing mutable is shared between two contexts (other
+// than what the `GenerationConfig` points to, such as a profile or budget,
+// which are thread-safe), so generations in different contexts may run
+// concurrently as long as each uses its own random engine.
+//
+// The variables passed to the constructor are copied and never modified, so
+// the same constraints may be used by many contexts at once.
+class GenerationContext {
+ public:
+  // `rng` is not owned and must outlive this context.
+  GenerationContext(VariableSet variables, ValueSet known_values,
+                    RandomEngine& rng, GenerationConfig generation_config);
+
+  // The universe points into this object, so it may not be copied or moved.
+  GenerationContext(const GenerationContext&) = delete;
+  GenerationContext& operator=(const GenerationContext&) = delete;
+
+  VariableSet& GetVariables() { return variables_; }
+  ValueSet& GetValues() { return values_; }
+  GenerationConfig& GetGenerationConfig() { return generation_config_; }
+  Universe& GetUniverse() { return universe_; }
+
+ private:
+  VariableSet variables_;
+  ValueSet values_;
+  GenerationConfig generation_config_;
+  Universe universe_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_GENERATION_CONTEXT_H_
@@ -0,0 +1,113 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/generation_context.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/absl_check.h"
+#include "src/internal/abstract_variable.h"
+#include "src/internal/generation_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Ge;
+using ::testing::Le;
+using ::moriarty::IsOkAndHolds;
+
+VariableSet ExampleVariables() {
+  VariableSet variables;
+  ABSL_CHECK_OK(variables.AddVariable("N", MInteger().Between(1, 10)));
+  ABSL_CHECK_OK(variables.AddVariable("M", MInteger().Between(1, "N")));
+  return variables;
+}
+
+// Generates N and M inside `context` and returns M.
+int64_t GenerateInContext(GenerationContext& context) {
+  for (const char* name : {"N", "M"}) {
+    AbstractVariable* var = *context.GetVariables().GetAbstractVariable(name);
+    ABSL_CHECK_OK(var->AssignValue());
+  }
+  return *context.GetValues().Get<MInteger>("M");
+}
+
+TEST(GenerationContextTest, UniverseIsWiredToTheContext) {
+  RandomEngine rng({1, 2, 3}, "");
+  ValueSet known_values;
+  known_values.Set<MInteger>("N", 3);
+  GenerationContext context(ExampleVariables(), known_values, rng,
+                            GenerationConfig());
+
+  Universe& universe = context.GetUniverse();
+  MORIARTY_EXPECT_OK(universe.GetVariable<MInteger>("M"));
+  EXPECT_TRUE(universe.ValueIsKnown("N"));
+  EXPECT_EQ(universe.GetGenerationConfig(), &context.GetGenerationConfig());
+  EXPECT_EQ(universe.GetRandomEngine(), &rng);
+}
+
+TEST(GenerationContextTest, GeneratedValuesGoToTheContext) {
+  RandomEngine rng({1, 2, 3}, "");
+  ValueSet known_values;
+  known_values.Set<MInteger>("N", 3);
+  GenerationContext context(ExampleVariables(), known_values, rng,
+                            GenerationConfig());
+
+  GenerateInContext(context);
+
+  EXPECT_THAT(context.GetValues().Get<MInteger>("N"), IsOkAndHolds(3));
+  EXPECT_THAT(context.GetValues().Get<MInteger>("M"),
+              IsOkAndHolds(AllOf(Ge(1), Le(3))));
+  EXPECT_FALSE(known_values.Contains("M"));
+}
+
+TEST(GenerationContextTest, ConcurrentContextsMatchSerialGeneration) {
+  constexpr int kNumContexts = 64;
+  const VariableSet variables = ExampleVariables();
+  const std::string constraints = variables.ToString();
+
+  auto generate = [&](int i) {
+    RandomEngine rng({i}, "");
+    GenerationContext context(variables, ValueSet(), rng, GenerationConfig());
+    return GenerateInContext(context);
+  };
+
+  std::vector<int64_t> expected(kNumContexts);
+  for (int i = 0; i < kNumContexts; i++) expected[i] = generate(i);
+
+  std::vector<int64_t> actual(kNumContexts);
+  WorkStealingScheduler scheduler(4);
+  scheduler.ParallelFor(kNumContexts, [&](int i) { actual[i] = generate(i); });
+
+  EXPECT_EQ(actual, expected);
+  // The shared constraints are only ever read.
+  EXPECT_EQ(variables.ToString(), constraints);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
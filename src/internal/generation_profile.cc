@@ -0,0 +1,230 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/generation_profile.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/container/btree_map.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// Replaces every "[123]" in `variable_name` with "[*]".
+std::string CollapseIndices(absl::string_view variable_name) {
+  std::string result;
+  result.reserve(variable_name.size());
+  for (int i = 0; i < variable_name.size(); i++) {
+    result.push_back(variable_name[i]);
+    if (variable_name[i] != '[') continue;
+    int end = i + 1;
+    while (end < variable_name.size() &&
+           absl::ascii_isdigit(variable_name[end])) {
+      end++;
+    }
+    if (end > i + 1 && end < variable_name.size() &&
+        variable_name[end] == ']') {
+      result.push_back('*');
+      i = end - 1;
+    }
+  }
+  return result;
+}
+
+void AppendJsonString(std::string& out, absl::string_view str) {
+  out.push_back('"');
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppend(&out, "\\u00",
+                      absl::Hex(static_cast<uint8_t>(c), absl::kZeroPad2));
+    } else {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+using EntryMap = absl::btree_map<std::string, GenerationProfile::Entry>;
+
+void AppendJsonEntries(std::string& out, const EntryMap& entries) {
+  out.push_back('{');
+  bool first = true;
+  for (const auto& [key, entry] : entries) {
+    if (!first) out.push_back(',');
+    first = false;
+    AppendJsonString(out, key);
+    absl::StrAppend(
+        &out, ":{\"wall_time_ns\":", absl::ToInt64Nanoseconds(entry.wall_time),
+        ",\"generate_attempts\":", entry.generate_attempts,
+        ",\"constraint_rejections\":", entry.constraint_rejections,
+        ",\"custom_constraint_rejections\":",
+        entry.custom_constraint_rejections, ",\"errors\":", entry.errors,
+        ",\"bytes_generated\":", entry.bytes_generated,
+        ",\"allocated_bytes\":", entry.allocated_bytes, "}");
+  }
+  out.push_back('}');
+}
+
+void AppendJsonMemory(
+    std::string& out,
+    const absl::btree_map<std::string, GenerationProfile::MemoryStats>&
+        memory) {
+  out.push_back('{');
+  bool first = true;
+  for (const auto& [key, stats] : memory) {
+    if (!first) out.push_back(',');
+    first = false;
+    AppendJsonString(out, key);
+    absl::StrAppend(&out, ":{\"test_cases\":", stats.test_cases,
+                    ",\"allocated_bytes\":", stats.allocated_bytes,
+                    ",\"peak_test_case_bytes\":", stats.peak_test_case_bytes,
+                    ",\"peak_live_bytes\":", stats.peak_live_bytes, "}");
+  }
+  out.push_back('}');
+}
+
+}  // namespace
+
+void GenerationProfile::Entry::MergeFrom(const Entry& other) {
+  wall_time += other.wall_time;
+  generate_attempts += other.generate_attempts;
+  constraint_rejections += other.constraint_rejections;
+  custom_constraint_rejections += other.custom_constraint_rejections;
+  errors += other.errors;
+  bytes_generated += other.bytes_generated;
+  allocated_bytes += other.allocated_bytes;
+}
+
+void GenerationProfile::MemoryStats::MergeFrom(const MemoryStats& other) {
+  test_cases += other.test_cases;
+  allocated_bytes += other.allocated_bytes;
+  peak_test_case_bytes =
+      std::max(peak_test_case_bytes, other.peak_test_case_bytes);
+  peak_live_bytes = std::max(peak_live_bytes, other.peak_live_bytes);
+}
+
+void GenerationProfile::Entry::AddRejection(Rejection rejection) {
+  switch (rejection) {
+    case Rejection::kConstraint:
+      constraint_rejections++;
+      break;
+    case Rejection::kCustomConstraint:
+      custom_constraint_rejections++;
+      break;
+    case Rejection::kError:
+      errors++;
+      break;
+  }
+}
+
+std::string GenerationProfile::ChildKey(absl::string_view parent_key,
+                                        absl::string_view variable_name) {
+  if (parent_key.empty()) return CollapseIndices(variable_name);
+  return absl::StrCat(parent_key, ";", CollapseIndices(variable_name));
+}
+
+GenerationProfile::Entry& GenerationProfile::GetEntry(absl::string_view key) {
+  return entries_[key];
+}
+
+void GenerationProfile::RecordTestCase(int64_t allocated_bytes,
+                                       int64_t peak_bytes) {
+  MemoryStats& stats = memory_[""];
+  stats.test_cases++;
+  stats.allocated_bytes += allocated_bytes;
+  stats.peak_test_case_bytes = std::max(stats.peak_test_case_bytes, peak_bytes);
+}
+
+void GenerationProfile::RecordGeneratorCall(int64_t allocated_bytes) {
+  MemoryStats& stats = memory_[""];
+  stats.peak_live_bytes = std::max(stats.peak_live_bytes, allocated_bytes);
+}
+
+void GenerationProfile::MergeFrom(const GenerationProfile& other,
+                                  absl::string_view parent_key) {
+  for (const auto& [key, entry] : other.entries_) {
+    if (parent_key.empty()) {
+      entries_[key].MergeFrom(entry);
+    } else {
+      entries_[absl::StrCat(parent_key, ";", key)].MergeFrom(entry);
+    }
+  }
+  for (const auto& [key, stats] : other.memory_) {
+    if (parent_key.empty()) {
+      memory_[key].MergeFrom(stats);
+    } else if (key.empty()) {
+      memory_[parent_key].MergeFrom(stats);
+    } else {
+      memory_[absl::StrCat(parent_key, ";", key)].MergeFrom(stats);
+    }
+  }
+}
+
+absl::btree_map<std::string, GenerationProfile::Entry>
+GenerationProfile::EntriesByVariable() const {
+  absl::btree_map<std::string, Entry> by_variable;
+  for (const auto& [key, entry] : entries_) {
+    absl::string_view variable = key;
+    if (size_t pos = variable.rfind(';'); pos != absl::string_view::npos)
+      variable.remove_prefix(pos + 1);
+    by_variable[variable].MergeFrom(entry);
+  }
+  return by_variable;
+}
+
+std::string GenerationProfile::ToJson() const {
+  std::string out = "{\"variables\":";
+  AppendJsonEntries(out, EntriesByVariable());
+  out += ",\"stacks\":";
+  AppendJsonEntries(out, entries_);
+  out += ",\"memory\":";
+  AppendJsonMemory(out, memory_);
+  out += "}";
+  return out;
+}
+
+std::string GenerationProfile::ToFoldedStacks() const {
+  absl::btree_map<std::string, absl::Duration> self_time;
+  for (const auto& [key, entry] : entries_) {
+    self_time[key] += entry.wall_time;
+    absl::string_view parent = key;
+    if (size_t pos = parent.rfind(';'); pos != absl::string_view::npos) {
+      parent.remove_suffix(parent.size() - pos);
+      self_time[parent] -= entry.wall_time;
+    }
+  }
+
+  std::string out;
+  for (const auto& [key, time] : self_time) {
+    absl::StrAppend(&out, key, " ",
+                    std::max<int64_t>(0, absl::ToInt64Microseconds(time)),
+                    "\n");
+  }
+  return out;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_GENERATION_PROFILE_H_
+#define MORIARTY_SRC_INTERNAL_GENERATION_PROFILE_H_
+
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// GenerationProfile
+//
+// Records where the time went while generating variables. Entries are keyed by
+// the stack of variables that were being generated (outermost first, joined by
+// ';'). Indices in variable names are collapsed, so all elements of an array
+// share a single entry (e.g., "A;A.element[*]").
+class GenerationProfile {
+ public:
+  // Why a call to `GenerateOnce()` did not produce a value.
+  enum class Rejection {
+    kConstraint,        // The value failed `IsSatisfiedWith()`.
+    kCustomConstraint,  // The value failed a custom constraint.
+    kError,             // No value was generated (e.g., bad configuration).
+  };
+
+  struct Entry {
+    // Includes the time spent generating nested variables.
+    absl::Duration wall_time = absl::ZeroDuration();
+    int64_t generate_attempts = 0;
+    int64_t constraint_rejections = 0;
+    int64_t custom_constraint_rejections = 0;
+    int64_t errors = 0;
+    // Size of the successfully generated values. See
+    // `MVariable::ValueByteSize()`.
+    int64_t bytes_generated = 0;
+    // Memory held by the successfully generated values. See
+    // `AllocatedByteSize()`.
+    int64_t allocated_bytes = 0;
+
+    void MergeFrom(const Entry& other);
+    void AddRejection(Rejection rejection);
+  };
+
+  // Memory held by whole test cases. All test cases of one generator call are
+  // held in memory at the same time.
+  struct MemoryStats {
+    int64_t test_cases = 0;
+    // Sum over all test cases of the bytes held by their values.
+    int64_t allocated_bytes = 0;
+    // The most bytes held by the values of a single test case at any point
+    // while it was generated (including values erased on retries).
+    int64_t peak_test_case_bytes = 0;
+    // The most bytes held by all test cases of a single generator call.
+    int64_t peak_live_bytes = 0;
+
+    void MergeFrom(const MemoryStats& other);
+  };
+
+  // Returns the key for `variable_name` generated inside `parent_key` (empty
+  // for the outermost variables).
+  static std::string ChildKey(absl::string_view parent_key,
+                              absl::string_view variable_name);
+
+  // Returns the entry for `key`, creating it if needed.
+  Entry& GetEntry(absl::string_view key);
+
+  // RecordTestCase()
+  //
+  // Records a test case whose values hold `allocated_bytes` bytes, and held at
+  // most `peak_bytes` bytes while they were generated.
+  void RecordTestCase(int64_t allocated_bytes, int64_t peak_bytes);
+
+  // RecordGeneratorCall()
+  //
+  // Records a generator call whose test cases hold `allocated_bytes` bytes in
+  // total.
+  void RecordGeneratorCall(int64_t allocated_bytes);
+
+  // Adds all of `other`'s entries to this profile, with their keys nested
+  // inside of `parent_key`.
+  void MergeFrom(const GenerationProfile& other,
+                 absl::string_view parent_key = "");
+
+  // Entries keyed by the stack of variables.
+  const absl::btree_map<std::string, Entry>& Entries() const {
+    return entries_;
+  }
+
+  // Entries keyed by the innermost variable of each stack. Wall times are
+  // inclusive, so nested variables are also counted in their parents.
+  absl::btree_map<std::string, Entry> EntriesByVariable() const;
+
+  // Memory held by test cases, keyed by the `parent_key`s they were merged
+  // into (e.g., the name of the generator).
+  const absl::btree_map<std::string, MemoryStats>& Memory() const {
+    return memory_;
+  }
+
+  bool empty() const { return entries_.empty() && memory_.empty(); }
+
+  // ToJson()
+  //
+  // Returns the profile as a JSON object with three fields: "variables" (see
+  // `EntriesByVariable()`), "stacks" (see `Entries()`) and "memory" (see
+  // `Memory()`).
+  std::string ToJson() const;
+
+  // ToFoldedStacks()
+  //
+  // Returns the profile in the folded-stack format used by flamegraph tools
+  // (one "stack;of;variables microseconds" line per stack). The time for each
+  // stack excludes the time spent in the variables nested inside of it.
+  std::string ToFoldedStacks() const;
+
+ private:
+  absl::btree_map<std::string, Entry> entries_;
+  absl::btree_map<std::string, MemoryStats> memory_;
+};
+
+// ApproximateByteSize()
+//
+// A rough estimate of how many bytes `value` occupies: the characters of a
+// string, the sum over the elements of a container or tuple and `sizeof()` for
+// everything else.
+template <typename T>
+int64_t ApproximateByteSize(const T& value);
+
+// AllocatedByteSize()
+//
+// The number of bytes `value` actually occupies: `sizeof(value)` plus the heap
+// memory owned by strings and containers (their capacity, not their size),
+// recursively. Short strings stored inside the string object do not use the
+// heap. Allocator overhead (e.g., the nodes of a `std::map`) is not counted.
+template <typename T>
+int64_t AllocatedByteSize(const T& value);
+
+// AllocatedHeapBytes()
+//
+// Same as `AllocatedByteSize()`, but without `sizeof(value)`.
+template <typename T>
+int64_t AllocatedHeapBytes(const T& value);
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename T>
+int64_t ApproximateByteSize(const T& value) {
+  if constexpr (std::is_convertible_v<const T&, absl::string_view>) {
+    return absl::string_view(value).size();
+  } else if constexpr (std::ranges::range<const T>) {
+    using ElementType = std::ranges::range_value_t<const T>;
+    if constexpr (std::ranges::sized_range<const T> &&
+                  std::is_arithmetic_v<ElementType>) {
+      return std::ranges::size(value) * sizeof(ElementType);
+    } else {
+      int64_t bytes = 0;
+      for (const auto& element : value) bytes += ApproximateByteSize(element);
+      return bytes;
+    }
+  } else if constexpr (requires { std::tuple_size<T>::value; }) {
+    return std::apply(
+        [](const auto&... elements) {
+          return (int64_t{0} + ... + ApproximateByteSize(elements));
+        },
+        value);
+  } else {
+    return sizeof(T);
+  }
+}
+
+template <typename T>
+int64_t AllocatedByteSize(const T& value) {
+  return sizeof(T) + AllocatedHeapBytes(value);
+}
+
+template <typename T>
+int64_t AllocatedHeapBytes(const T& value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    const char* object = reinterpret_cast<const char*>(&value);
+    if (std::less_equal<const char*>()(object, value.data()) &&
+        std::less<const char*>()(value.data(), object + sizeof(value))) {
+      return 0;
+    }
+    return value.capacity() + 1;  // Including the null terminator.
+  } else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+    return (value.capacity() + 7) / 8;
+  } else if constexpr (std::ranges::contiguous_range<const T> &&
+                       requires { value.capacity(); }) {
+    using ElementType = std::ranges::range_value_t<const T>;
+    int64_t bytes = value.capacity() * sizeof(ElementType);
+    if constexpr (!std::is_arithmetic_v<ElementType>) {
+      for (const auto& element : value) bytes += AllocatedHeapBytes(element);
+    }
+    return bytes;
+  } else if constexpr (std::ranges::range<const T>) {
+    int64_t bytes = 0;
+    for (const auto& element : value) bytes += AllocatedByteSize(element);
+    return bytes;
+  } else if constexpr (requires { std::tuple_size<T>::value; }) {
+    return std::apply(
+        [](const auto&... elements) {
+          return (int64_t{0} + ... + AllocatedHeapBytes(elements));
+        },
+        value);
+  } else {
+    return 0;
+  }
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_GENERATION_PROFILE_H_
@@ -0,0 +1,175 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/generation_profile.h"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::HasSubstr;
+using ::testing::Key;
+using ::testing::Pair;
+
+TEST(GenerationProfileTest, ChildKeyCollapsesIndicesInVariableNames) {
+  EXPECT_EQ(GenerationProfile::ChildKey("", "A"), "A");
+  EXPECT_EQ(GenerationProfile::ChildKey("A", "A.element[12]"),
+            "A;A.element[*]");
+  EXPECT_EQ(GenerationProfile::ChildKey("A;A.element[*]",
+                                        "A.element[3].element[45]"),
+            "A;A.element[*];A.element[*].element[*]");
+  EXPECT_EQ(GenerationProfile::ChildKey("", "A[x]"), "A[x]");
+  EXPECT_EQ(GenerationProfile::ChildKey("", "A[]"), "A[]");
+}
+
+TEST(GenerationProfileTest, MergeFromNestsEntriesInsideTheParentKey) {
+  GenerationProfile a;
+  a.GetEntry("X").generate_attempts = 2;
+
+  GenerationProfile b;
+  b.GetEntry("X").generate_attempts = 3;
+  b.GetEntry("Y").bytes_generated = 8;
+
+  a.MergeFrom(b);
+  a.MergeFrom(b, "Gen");
+  EXPECT_THAT(a.Entries(),
+              ElementsAre(Key("Gen;X"), Key("Gen;Y"),
+                          Pair("X", Field(&GenerationProfile::Entry::
+                                              generate_attempts,
+                                          5)),
+                          Key("Y")));
+}
+
+TEST(GenerationProfileTest, AddRejectionCountsEachCauseSeparately) {
+  GenerationProfile::Entry entry;
+  entry.AddRejection(GenerationProfile::Rejection::kConstraint);
+  entry.AddRejection(GenerationProfile::Rejection::kCustomConstraint);
+  entry.AddRejection(GenerationProfile::Rejection::kCustomConstraint);
+  entry.AddRejection(GenerationProfile::Rejection::kError);
+  EXPECT_EQ(entry.constraint_rejections, 1);
+  EXPECT_EQ(entry.custom_constraint_rejections, 2);
+  EXPECT_EQ(entry.errors, 1);
+}
+
+TEST(GenerationProfileTest, EntriesByVariableUsesTheInnermostVariable) {
+  GenerationProfile profile;
+  profile.GetEntry("Gen1;N").generate_attempts = 1;
+  profile.GetEntry("Gen2;A;N").generate_attempts = 2;
+  profile.GetEntry("Gen2;A").generate_attempts = 4;
+
+  EXPECT_THAT(
+      profile.EntriesByVariable(),
+      ElementsAre(
+          Pair("A", Field(&GenerationProfile::Entry::generate_attempts, 4)),
+          Pair("N", Field(&GenerationProfile::Entry::generate_attempts, 3))));
+}
+
+TEST(GenerationProfileTest, ToFoldedStacksUsesTimeExcludingNestedVariables) {
+  GenerationProfile profile;
+  profile.GetEntry("A").wall_time = absl::Microseconds(100);
+  profile.GetEntry("A;B").wall_time = absl::Microseconds(30);
+  profile.GetEntry("A;C").wall_time = absl::Microseconds(50);
+  profile.GetEntry("D").wall_time = absl::Microseconds(7);
+
+  EXPECT_EQ(profile.ToFoldedStacks(), "A 20\nA;B 30\nA;C 50\nD 7\n");
+}
+
+TEST(GenerationProfileTest, ToJsonContainsVariablesAndStacks) {
+  GenerationProfile profile;
+  GenerationProfile::Entry& entry = profile.GetEntry("G;\"N\"");
+  entry.wall_time = absl::Nanoseconds(1234);
+  entry.generate_attempts = 3;
+  entry.custom_constraint_rejections = 2;
+  entry.bytes_generated = 8;
+
+  std::string fields =
+      "{\"wall_time_ns\":1234,\"generate_attempts\":3,"
+      "\"constraint_rejections\":0,\"custom_constraint_rejections\":2,"
+      "\"errors\":0,\"bytes_generated\":8,\"allocated_bytes\":0}";
+  EXPECT_EQ(profile.ToJson(), "{\"variables\":{\"\\\"N\\\"\":" + fields +
+                                  "},\"stacks\":{\"G;\\\"N\\\"\":" + fields +
+                                  "},\"memory\":{}}");
+}
+
+TEST(GenerationProfileTest, MemoryShouldBeKeyedByTheParentKey) {
+  GenerationProfile call1;
+  call1.RecordTestCase(/*allocated_bytes=*/100, /*peak_bytes=*/150);
+  call1.RecordTestCase(/*allocated_bytes=*/20, /*peak_bytes=*/20);
+  call1.RecordGeneratorCall(120);
+  GenerationProfile call2;
+  call2.RecordTestCase(/*allocated_bytes=*/50, /*peak_bytes=*/60);
+  call2.RecordGeneratorCall(50);
+
+  GenerationProfile profile;
+  profile.MergeFrom(call1, "G");
+  profile.MergeFrom(call2, "G");
+
+  ASSERT_THAT(profile.Memory(), ElementsAre(Key("G")));
+  const GenerationProfile::MemoryStats& stats = profile.Memory().at("G");
+  EXPECT_EQ(stats.test_cases, 3);
+  EXPECT_EQ(stats.allocated_bytes, 170);
+  EXPECT_EQ(stats.peak_test_case_bytes, 150);
+  EXPECT_EQ(stats.peak_live_bytes, 120);
+  EXPECT_THAT(profile.ToJson(),
+              HasSubstr("\"memory\":{\"G\":{\"test_cases\":3,"
+                        "\"allocated_bytes\":170,\"peak_test_case_bytes\":150,"
+                        "\"peak_live_bytes\":120}}"));
+}
+
+TEST(GenerationProfileTest, ApproximateByteSizeHandlesCommonTypes) {
+  EXPECT_EQ(ApproximateByteSize(int64_t{5}), 8);
+  EXPECT_EQ(ApproximateByteSize(std::string("hello")), 5);
+  EXPECT_EQ(ApproximateByteSize(std::vector<int64_t>(10)), 80);
+  EXPECT_EQ(ApproximateByteSize(std::vector<std::string>({"ab", "cde"})), 5);
+  EXPECT_EQ(ApproximateByteSize(std::tuple<int64_t, std::string>(1, "abc")),
+            11);
+  EXPECT_EQ(ApproximateByteSize(
+                std::vector<std::tuple<int32_t, std::string>>({{1, "a"}})),
+            5);
+}
+
+TEST(GenerationProfileTest, AllocatedByteSizeCountsCapacityAndTheObject) {
+  EXPECT_EQ(AllocatedByteSize(int64_t{5}), 8);
+
+  std::vector<int64_t> v;
+  v.reserve(10);
+  v.push_back(1);
+  EXPECT_EQ(AllocatedByteSize(v), sizeof(v) + 80);
+
+  std::string long_string(100, 'a');
+  EXPECT_EQ(AllocatedByteSize(long_string),
+            sizeof(std::string) + long_string.capacity() + 1);
+  // Short strings are stored inside the object.
+  EXPECT_EQ(AllocatedByteSize(std::string("a")), sizeof(std::string));
+
+  std::vector<std::string> strings = {long_string, "a"};
+  EXPECT_EQ(AllocatedByteSize(strings),
+            sizeof(strings) + strings.capacity() * sizeof(std::string) +
+                strings[0].capacity() + 1);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
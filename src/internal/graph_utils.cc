@@ -0,0 +1,93 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/graph_utils.h"
+
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+std::vector<std::pair<int, int>> PruferCodeToEdges(absl::Span<const int> code) {
+  const int n = code.size() + 2;
+  std::vector<int> degree(n, 1);
+  for (int v : code) degree[v]++;
+
+  // `leaf` is the smallest leaf. Every leaf smaller than `next` (other than
+  // `leaf`) has already been removed, so `next` only moves forward.
+  std::vector<std::pair<int, int>> edges;
+  edges.reserve(n - 1);
+  int next = 0;
+  while (degree[next] != 1) next++;
+  int leaf = next;
+  for (int v : code) {
+    edges.push_back({leaf, v});
+    if (--degree[v] == 1 && v < next) {
+      leaf = v;
+    } else {
+      next++;
+      while (degree[next] != 1) next++;
+      leaf = next;
+    }
+  }
+  edges.push_back({leaf, n - 1});
+  return edges;
+}
+
+int64_t UnorderedPairIndex(int u, int v) {
+  return static_cast<int64_t>(v) * (v - 1) / 2 + u;
+}
+
+std::pair<int, int> UnorderedPairFromIndex(int64_t index) {
+  // v is the largest value with v * (v - 1) / 2 <= index. The floating point
+  // estimate is only a starting point, so the result does not depend on the
+  // platform.
+  int64_t v = std::llround(std::sqrt(2.0 * index));
+  while (v > 1 && v * (v - 1) / 2 > index) v--;
+  while ((v + 1) * v / 2 <= index) v++;
+  return {static_cast<int>(index - v * (v - 1) / 2), static_cast<int>(v)};
+}
+
+DisjointSets::DisjointSets(int n) : parent_(n), size_(n, 1), num_sets_(n) {
+  std::iota(parent_.begin(), parent_.end(), 0);
+}
+
+int DisjointSets::Find(int x) {
+  while (parent_[x] != x) {
+    parent_[x] = parent_[parent_[x]];
+    x = parent_[x];
+  }
+  return x;
+}
+
+bool DisjointSets::Union(int x, int y) {
+  x = Find(x);
+  y = Find(y);
+  if (x == y) return false;
+  if (size_[x] < size_[y]) std::swap(x, y);
+  parent_[y] = x;
+  size_[x] += size_[y];
+  num_sets_--;
+  return true;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
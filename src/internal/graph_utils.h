@@ -0,0 +1,75 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_GRAPH_UTILS_H_
+#define MORIARTY_SRC_INTERNAL_GRAPH_UTILS_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// PruferCodeToEdges()
+//
+// Returns the `code.size() + 1` edges of the tree on the nodes
+// {0, 1, ... , code.size() + 1} with this Prüfer code. Each value in `code`
+// must be a node of the tree. Each labelled tree has exactly one Prüfer code,
+// so a uniformly random code gives a uniformly random tree. O(n).
+std::vector<std::pair<int, int>> PruferCodeToEdges(absl::Span<const int> code);
+
+// UnorderedPairIndex()
+//
+// Returns the index of the pair {u, v} (with u < v) when all such pairs are
+// ordered by v, then u. That is, {0, 1}, {0, 2}, {1, 2}, {0, 3}, ...
+int64_t UnorderedPairIndex(int u, int v);
+
+// UnorderedPairFromIndex()
+//
+// The inverse of `UnorderedPairIndex()`. Returns {u, v} with u < v.
+std::pair<int, int> UnorderedPairFromIndex(int64_t index);
+
+// DisjointSets
+//
+// Union-find over the elements {0, 1, ... , n-1}, with path halving and union
+// by size. Intended for connectivity checks over an edge list.
+class DisjointSets {
+ public:
+  explicit DisjointSets(int n);
+
+  // Returns the representative of the set containing `x`.
+  int Find(int x);
+
+  // Merges the sets containing `x` and `y`. Returns false if they were
+  // already in the same set.
+  bool Union(int x, int y);
+
+  // Returns the number of disjoint sets.
+  [[nodiscard]] int NumSets() const { return num_sets_; }
+
+ private:
+  std::vector<int> parent_;
+  std::vector<int> size_;
+  int num_sets_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_GRAPH_UTILS_H_
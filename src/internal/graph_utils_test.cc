@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/graph_utils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+using ::testing::SizeIs;
+
+TEST(GraphUtilsTest, PruferCodeToEdgesWorks) {
+  EXPECT_THAT(PruferCodeToEdges({}), ElementsAre(Pair(0, 1)));
+  EXPECT_THAT(PruferCodeToEdges({3, 3, 3, 4}),
+              ElementsAre(Pair(0, 3), Pair(1, 3), Pair(2, 3), Pair(3, 4),
+                          Pair(4, 5)));
+  // A path: 1 - 2 - 0 - 3.
+  EXPECT_THAT(PruferCodeToEdges({2, 0}),
+              ElementsAre(Pair(1, 2), Pair(2, 0), Pair(0, 3)));
+}
+
+TEST(GraphUtilsTest, PruferCodeToEdgesShouldGiveEveryTreeOnce) {
+  // There are 5^3 codes and 5^3 labelled trees on 5 nodes (Cayley's formula).
+  std::set<std::set<std::pair<int, int>>> trees;
+  for (int code = 0; code < 125; code++) {
+    std::vector<std::pair<int, int>> edges =
+        PruferCodeToEdges({code % 5, code / 5 % 5, code / 25});
+    ASSERT_THAT(edges, SizeIs(4));
+
+    std::set<std::pair<int, int>> tree;
+    DisjointSets sets(5);
+    for (auto [u, v] : edges) {
+      EXPECT_TRUE(sets.Union(u, v));
+      tree.insert({std::min(u, v), std::max(u, v)});
+    }
+    trees.insert(tree);
+  }
+  EXPECT_THAT(trees, SizeIs(125));
+}
+
+TEST(GraphUtilsTest, UnorderedPairIndexShouldRoundTrip) {
+  EXPECT_EQ(UnorderedPairIndex(0, 1), 0);
+  EXPECT_EQ(UnorderedPairIndex(0, 2), 1);
+  EXPECT_EQ(UnorderedPairIndex(1, 2), 2);
+  EXPECT_EQ(UnorderedPairIndex(0, 3), 3);
+
+  int64_t index = 0;
+  for (int v = 1; v < 300; v++) {
+    for (int u = 0; u < v; u++) {
+      ASSERT_EQ(UnorderedPairIndex(u, v), index);
+      ASSERT_THAT(UnorderedPairFromIndex(index++), Pair(u, v));
+    }
+  }
+
+  constexpr int kBig = 2'000'000'000;
+  EXPECT_THAT(UnorderedPairFromIndex(UnorderedPairIndex(kBig - 1, kBig)),
+              Pair(kBig - 1, kBig));
+  EXPECT_THAT(UnorderedPairFromIndex(UnorderedPairIndex(0, kBig)),
+              Pair(0, kBig));
+}
+
+TEST(GraphUtilsTest, DisjointSetsShouldTrackComponents) {
+  DisjointSets sets(5);
+  EXPECT_EQ(sets.NumSets(), 5);
+  EXPECT_TRUE(sets.Union(0, 1));
+  EXPECT_TRUE(sets.Union(3, 4));
+  EXPECT_FALSE(sets.Union(1, 0));
+  EXPECT_EQ(sets.NumSets(), 3);
+  EXPECT_EQ(sets.Find(0), sets.Find(1));
+  EXPECT_NE(sets.Find(0), sets.Find(2));
+  EXPECT_NE(sets.Find(0), sets.Find(3));
+  EXPECT_TRUE(sets.Union(1, 4));
+  EXPECT_EQ(sets.Find(0), sets.Find(3));
+  EXPECT_EQ(sets.NumSets(), 2);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,343 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/integer_distributions.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/internal/alias_table.h"
+#include "src/internal/random_engine.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// The math functions below only use basic arithmetic and exact operations
+// (e.g., std::frexp, std::ldexp, std::floor, std::sqrt), which IEEE 754
+// specifies exactly. std::log and std::exp are allowed to differ between
+// standard libraries, so they are not used.
+
+constexpr double kLn2 = 0.69314718055994530942;
+constexpr double kSqrtHalf = 0.70710678118654752440;
+
+// Returns the natural logarithm of `x`. `x` must be positive.
+double Log(double x) {
+  int exponent;
+  double m = std::frexp(x, &exponent);  // x = m * 2^exponent, m in [0.5, 1).
+  if (m < kSqrtHalf) {
+    m *= 2;
+    exponent--;
+  }
+
+  // ln(m) = 2 * (s + s^3 / 3 + s^5 / 5 + ...), where s = (m - 1) / (m + 1).
+  // Since m is in [sqrt(1/2), sqrt(2)), |s| < 0.172, so this converges fast.
+  double s = (m - 1) / (m + 1);
+  double s2 = s * s;
+  double term = s;
+  double sum = 0;
+  for (int k = 1; k <= 27; k += 2) {
+    sum += term / k;
+    term *= s2;
+  }
+  return exponent * kLn2 + 2 * sum;
+}
+
+// Returns e^x. `x` must not be positive.
+double Exp(double x) {
+  if (x < -746) return 0;
+
+  // e^x = 2^k * e^r, where |r| <= ln(2) / 2.
+  double k = std::floor(x / kLn2 + 0.5);
+  double r = x - k * kLn2;
+  double term = 1;
+  double sum = 1;
+  for (int i = 1; i <= 20; i++) {
+    term *= r / i;
+    sum += term;
+  }
+  return std::ldexp(sum, static_cast<int>(k));
+}
+
+// Returns the inverse of the standard normal CDF at `p`, which must be in
+// (0, 1). Uses Acklam's rational approximation (relative error < 1.2e-9).
+double InverseNormalCdf(double p) {
+  constexpr double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                          -2.759285104469687e+02, 1.383577518672690e+02,
+                          -3.066479806614716e+01, 2.506628277459239e+00};
+  constexpr double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                          -1.556989798598866e+02, 6.680131188771972e+01,
+                          -1.328068155288572e+01};
+  constexpr double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                          -2.400758277161838e+00, -2.549732539343734e+00,
+                          4.374664141464968e+00,  2.938163982698783e+00};
+  constexpr double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                          2.445134137142996e+00, 3.754408661907416e+00};
+  constexpr double kLow = 0.02425;
+
+  auto tail = [&](double q) {
+    return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q +
+            c[5]) /
+           ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+  };
+
+  if (p < kLow) return tail(std::sqrt(-2 * Log(p)));
+  if (p > 1 - kLow) return -tail(std::sqrt(-2 * Log(1 - p)));
+
+  double q = p - 0.5;
+  double r = q * q;
+  return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r +
+          a[5]) *
+         q /
+         (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+// Converts `x` to a distance in [0, width], rounding towards 0.
+uint64_t ToDistance(double x, uint64_t width) {
+  if (!(x > 0)) return 0;  // Also catches NaN.
+  if (x >= static_cast<double>(width)) return width;
+  return std::min(width, static_cast<uint64_t>(x));
+}
+
+absl::StatusOr<uint64_t> LogUniformDistance(RandomEngine& rng,
+                                            uint64_t width) {
+  int bits = std::bit_width(width);
+  MORIARTY_ASSIGN_OR_RETURN(int64_t num_bits, rng.RandInt(0, bits));
+  if (num_bits == 0) return 0;
+
+  uint64_t lo = uint64_t{1} << (num_bits - 1);
+  uint64_t hi =
+      num_bits == 64 ? width : std::min(width, (uint64_t{1} << num_bits) - 1);
+  // hi - lo < 2^63, so this fits in an int64_t.
+  MORIARTY_ASSIGN_OR_RETURN(int64_t offset,
+                            rng.RandInt(0, static_cast<int64_t>(hi - lo)));
+  return lo + offset;
+}
+
+uint64_t ExponentialDistance(RandomEngine& rng, uint64_t width,
+                             double relative_mean) {
+  double w = static_cast<double>(width);
+  double mean = relative_mean * w;
+  if (width == 0 || !(mean > 0)) return 0;
+
+  // Invert the CDF of the exponential distribution, restricted to
+  // [0, width + 1). Note that u * truncated_cdf < 1, so the log is finite.
+  double truncated_cdf = 1 - Exp(-(w + 1) / mean);
+  double u = rng.RandDouble();
+  return ToDistance(-mean * Log(1 - u * truncated_cdf), width);
+}
+
+uint64_t ClampedNormalDistance(RandomEngine& rng, uint64_t width,
+                               double relative_mean, double relative_stddev) {
+  double w = static_cast<double>(width);
+  double p = rng.RandDouble();
+  if (p == 0) p = 0x1.0p-54;  // Must be in (0, 1).
+
+  double x = relative_mean * w + relative_stddev * w * InverseNormalCdf(p);
+  return ToDistance(std::floor(x + 0.5), width);
+}
+
+// The buckets of a `kWeightedBuckets` distribution that have a positive weight,
+// clipped to [min, max], with an alias table over their weights. If there are
+// no such buckets, `table` is empty and the entire range is used.
+struct ClippedBuckets {
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  std::optional<AliasTable> table;
+};
+
+absl::StatusOr<ClippedBuckets> ClipBuckets(
+    int64_t min, int64_t max, const std::vector<WeightedBucket>& buckets) {
+  ClippedBuckets clipped;
+  std::vector<int64_t> weights;
+  for (const WeightedBucket& bucket : buckets) {
+    int64_t lo = std::max(bucket.min, min);
+    int64_t hi = std::min(bucket.max, max);
+    if (lo > hi || bucket.weight == 0) continue;
+    clipped.ranges.push_back({lo, hi});
+    weights.push_back(bucket.weight);
+  }
+  // `ValidateIntegerDistribution()` ensures that the total does not overflow.
+  if (!weights.empty()) {
+    MORIARTY_ASSIGN_OR_RETURN(clipped.table, AliasTable::Create(weights));
+  }
+  return clipped;
+}
+
+int64_t WeightedBucketsValue(RandomEngine& rng, int64_t min, int64_t max,
+                             const ClippedBuckets& buckets,
+                             absl::Status& status) {
+  if (!buckets.table) return rng.RandInt(min, max, status);
+  auto [lo, hi] = buckets.ranges[buckets.table->Sample(rng, status)];
+  return rng.RandInt(lo, hi, status);
+}
+
+}  // namespace
+
+absl::Status ValidateIntegerDistribution(
+    const IntegerDistribution& distribution) {
+  switch (distribution.shape) {
+    case IntegerDistribution::Shape::kUniform:
+    case IntegerDistribution::Shape::kLogUniform:
+      return absl::OkStatus();
+    case IntegerDistribution::Shape::kExponential:
+      if (!std::isfinite(distribution.mean) || distribution.mean <= 0) {
+        return absl::InvalidArgumentError(
+            "Exponential distribution must have a finite, positive mean");
+      }
+      return absl::OkStatus();
+    case IntegerDistribution::Shape::kClampedNormal:
+      if (!std::isfinite(distribution.mean) ||
+          !std::isfinite(distribution.stddev) || distribution.stddev < 0) {
+        return absl::InvalidArgumentError(
+            "Normal distribution must have a finite mean and a finite, "
+            "non-negative standard deviation");
+      }
+      return absl::OkStatus();
+    case IntegerDistribution::Shape::kWeightedBuckets: {
+      int64_t total_weight = 0;
+      for (const WeightedBucket& bucket : distribution.buckets) {
+        if (bucket.min > bucket.max || bucket.weight < 0) {
+          return absl::InvalidArgumentError(absl::Substitute(
+              "Invalid bucket [$0, $1] with weight $2. Buckets must have "
+              "min <= max and a non-negative weight",
+              bucket.min, bucket.max, bucket.weight));
+        }
+        if (bucket.weight >
+            std::numeric_limits<int64_t>::max() - total_weight) {
+          return absl::InvalidArgumentError(
+              "Total weight of the buckets must fit in an int64_t");
+        }
+        total_weight += bucket.weight;
+      }
+      if (total_weight == 0) {
+        return absl::InvalidArgumentError(
+            "Buckets must have a positive total weight");
+      }
+      return absl::OkStatus();
+    }
+  }
+  return absl::InvalidArgumentError("Unknown distribution shape");
+}
+
+absl::StatusOr<int64_t> RandIntFromDistribution(
+    RandomEngine& rng, int64_t min, int64_t max,
+    const IntegerDistribution& distribution) {
+  if (distribution.shape == IntegerDistribution::Shape::kUniform ||
+      min > max) {
+    return rng.RandInt(min, max);  // Also produces the error for min > max.
+  }
+  if (distribution.shape == IntegerDistribution::Shape::kWeightedBuckets) {
+    MORIARTY_ASSIGN_OR_RETURN(ClippedBuckets buckets,
+                              ClipBuckets(min, max, distribution.buckets));
+    absl::Status status;
+    int64_t value = WeightedBucketsValue(rng, min, max, buckets, status);
+    MORIARTY_RETURN_IF_ERROR(status);
+    return value;
+  }
+
+  uint64_t width = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+  uint64_t distance = 0;
+  switch (distribution.shape) {
+    case IntegerDistribution::Shape::kLogUniform: {
+      MORIARTY_ASSIGN_OR_RETURN(distance, LogUniformDistance(rng, width));
+      break;
+    }
+    case IntegerDistribution::Shape::kExponential:
+      distance = ExponentialDistance(rng, width, distribution.mean);
+      break;
+    case IntegerDistribution::Shape::kClampedNormal:
+      // The mean is always measured from `min`.
+      return static_cast<int64_t>(
+          static_cast<uint64_t>(min) +
+          ClampedNormalDistance(rng, width, distribution.mean,
+                                distribution.stddev));
+    default:
+      return absl::InvalidArgumentError("Unknown distribution shape");
+  }
+
+  return distribution.from_max
+             ? static_cast<int64_t>(static_cast<uint64_t>(max) - distance)
+             : static_cast<int64_t>(static_cast<uint64_t>(min) + distance);
+}
+
+absl::Status RandIntsFromDistribution(RandomEngine& rng, int64_t min,
+                                      int64_t max,
+                                      const IntegerDistribution& distribution,
+                                      absl::Span<int64_t> out) {
+  if (distribution.shape == IntegerDistribution::Shape::kUniform ||
+      min > max) {
+    return rng.RandInts(min, max, out);
+  }
+  if (distribution.shape == IntegerDistribution::Shape::kWeightedBuckets) {
+    MORIARTY_ASSIGN_OR_RETURN(ClippedBuckets buckets,
+                              ClipBuckets(min, max, distribution.buckets));
+    absl::Status status;
+    for (int64_t& value : out)
+      value = WeightedBucketsValue(rng, min, max, buckets, status);
+    return status;
+  }
+  for (int64_t& value : out) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        value, RandIntFromDistribution(rng, min, max, distribution));
+  }
+  return absl::OkStatus();
+}
+
+std::string IntegerDistributionToString(
+    const IntegerDistribution& distribution) {
+  absl::string_view near_max = distribution.from_max ? "_near_max" : "";
+  switch (distribution.shape) {
+    case IntegerDistribution::Shape::kUniform:
+      return "uniform";
+    case IntegerDistribution::Shape::kLogUniform:
+      return absl::StrCat("log_uniform", near_max);
+    case IntegerDistribution::Shape::kExponential:
+      return absl::StrCat("exponential", near_max,
+                          "(mean=", distribution.mean, ")");
+    case IntegerDistribution::Shape::kClampedNormal:
+      return absl::StrCat("clamped_normal(mean=", distribution.mean,
+                          ", stddev=", distribution.stddev, ")");
+    case IntegerDistribution::Shape::kWeightedBuckets:
+      return absl::StrCat(
+          "weighted_buckets(",
+          absl::StrJoin(distribution.buckets, ", ",
+                        [](std::string* out, const WeightedBucket& bucket) {
+                          absl::SubstituteAndAppend(out, "[$0, $1]: $2",
+                                                    bucket.min, bucket.max,
+                                                    bucket.weight);
+                        }),
+          ")");
+  }
+  return "unknown";
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
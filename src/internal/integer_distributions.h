@@ -0,0 +1,131 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_INTEGER_DISTRIBUTIONS_H_
+#define MORIARTY_SRC_INTERNAL_INTEGER_DISTRIBUTIONS_H_
+
+// Non-uniform distributions over an inclusive range of integers.
+//
+// Each value is sampled directly from `RandomEngine` (there is no rejection
+// loop), so asking for a skewed distribution costs about the same as asking
+// for a uniform one. Like `RandomEngine`, the samplers avoid anything that is
+// implementation-defined (e.g., std::*_distribution or the platform's
+// std::log), so the same seed gives the same values everywhere.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// An inclusive range of integers, [min, max], picked with probability
+// proportional to `weight`.
+struct WeightedBucket {
+  int64_t min;
+  int64_t max;
+  int64_t weight;
+
+  friend bool operator==(const WeightedBucket& b1,
+                         const WeightedBucket& b2) = default;
+};
+
+// The shape of a distribution over an inclusive range [min, max]. The
+// parameters are relative to the range, so the same distribution may be used
+// for ranges that depend on other variables (e.g., [1, N]).
+struct IntegerDistribution {
+  enum class Shape {
+    // Every value is equally likely.
+    kUniform,
+    // The number of bits in the distance from the origin is uniform. So
+    // distances of 0, [1, 2), [2, 4), [4, 8), etc are all equally likely.
+    kLogUniform,
+    // The distance from the origin is exponentially distributed with mean
+    // `mean * (max - min)`, truncated to the range.
+    kExponential,
+    // The distance from `min` is normally distributed with mean
+    // `mean * (max - min)` and standard deviation `stddev * (max - min)`,
+    // then clamped to the range.
+    kClampedNormal,
+    // A bucket is picked with probability proportional to its weight (with an
+    // alias table, in O(1)), then a value is picked uniformly from its
+    // intersection with [min, max]. Buckets that do not intersect [min, max]
+    // are ignored. If no buckets intersect, the entire range is used.
+    kWeightedBuckets,
+  };
+
+  Shape shape = Shape::kUniform;
+
+  // For `kLogUniform` and `kExponential`, the origin is `max` instead of
+  // `min`. That is, values are more likely to be near `max`.
+  bool from_max = false;
+
+  // Parameters for `kExponential` and `kClampedNormal`.
+  double mean = 0;
+  double stddev = 0;
+
+  // Parameters for `kWeightedBuckets`.
+  std::vector<WeightedBucket> buckets;
+
+  friend bool operator==(const IntegerDistribution& d1,
+                         const IntegerDistribution& d2) = default;
+};
+
+// ValidateIntegerDistribution()
+//
+// Returns kInvalidArgument if the parameters of `distribution` are invalid.
+// E.g., a non-positive mean for `kExponential`, a negative standard deviation,
+// or buckets with negative weights or a total weight of 0.
+absl::Status ValidateIntegerDistribution(
+    const IntegerDistribution& distribution);
+
+// RandIntFromDistribution()
+//
+// Generates a random integer in the range [min, max], distributed according to
+// `distribution`. `distribution` must be valid (see
+// `ValidateIntegerDistribution()`).
+//
+// For `kUniform`, this is identical to `rng.RandInt(min, max)`.
+absl::StatusOr<int64_t> RandIntFromDistribution(
+    RandomEngine& rng, int64_t min, int64_t max,
+    const IntegerDistribution& distribution);
+
+// RandIntsFromDistribution()
+//
+// Fills `out` with random integers in the range [min, max], distributed
+// according to `distribution`. Identical to calling `RandIntFromDistribution()`
+// once per element, but any setup (e.g., the alias table that picks the
+// buckets of `kWeightedBuckets`) is only done once.
+absl::Status RandIntsFromDistribution(RandomEngine& rng, int64_t min,
+                                      int64_t max,
+                                      const IntegerDistribution& distribution,
+                                      absl::Span<int64_t> out);
+
+// IntegerDistributionToString()
+//
+// Returns a string representation of `distribution`.
+std::string IntegerDistributionToString(
+    const IntegerDistribution& distribution);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_INTEGER_DISTRIBUTIONS_H_
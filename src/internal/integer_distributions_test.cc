@@ -0,0 +1,219 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/integer_distributions.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Le;
+using ::moriarty::IsOk;
+using ::moriarty::StatusIs;
+
+using Shape = IntegerDistribution::Shape;
+
+// Returns `n` values from `distribution` in the range [min, max].
+std::vector<int64_t> Sample(const IntegerDistribution& distribution,
+                            int64_t min, int64_t max, int n = 10000) {
+  RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+  std::vector<int64_t> values;
+  for (int i = 0; i < n; i++) {
+    absl::StatusOr<int64_t> value =
+        RandIntFromDistribution(rng, min, max, distribution);
+    EXPECT_THAT(value, IsOk());
+    values.push_back(value.value_or(0));
+  }
+  return values;
+}
+
+// Returns the number of elements of `values` in [lo, hi].
+int CountBetween(const std::vector<int64_t>& values, int64_t lo, int64_t hi) {
+  int count = 0;
+  for (int64_t value : values) count += (lo <= value && value <= hi);
+  return count;
+}
+
+TEST(IntegerDistributionsTest, UniformShouldMatchRandInt) {
+  RandomEngine rng1({1, 2, 3}, kCounterBasedVersion);
+  RandomEngine rng2({1, 2, 3}, kCounterBasedVersion);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(RandIntFromDistribution(rng1, -5, 100, IntegerDistribution()),
+              rng2.RandInt(-5, 100));
+  }
+}
+
+TEST(IntegerDistributionsTest, AllShapesShouldStayInRange) {
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  std::vector<IntegerDistribution> distributions = {
+      {.shape = Shape::kLogUniform},
+      {.shape = Shape::kLogUniform, .from_max = true},
+      {.shape = Shape::kExponential, .mean = 0.01},
+      {.shape = Shape::kExponential, .from_max = true, .mean = 5},
+      {.shape = Shape::kClampedNormal, .mean = 0.5, .stddev = 10},
+      {.shape = Shape::kWeightedBuckets,
+       .buckets = {{.min = kMin, .max = 0, .weight = 1},
+                   {.min = 50, .max = kMax, .weight = 2}}},
+  };
+  for (const IntegerDistribution& distribution : distributions) {
+    MORIARTY_ASSERT_OK(ValidateIntegerDistribution(distribution));
+    EXPECT_THAT(Sample(distribution, 10, 100, 1000),
+                Each(AllOf(Ge(10), Le(100))));
+    EXPECT_THAT(Sample(distribution, 7, 7, 10), Each(7));
+    EXPECT_THAT(Sample(distribution, -3, -2, 100), Each(AllOf(Ge(-3), Le(-2))));
+    Sample(distribution, kMin, kMax, 1000);  // Should not overflow.
+  }
+}
+
+TEST(IntegerDistributionsTest, LogUniformShouldFavourSmallDistances) {
+  std::vector<int64_t> values =
+      Sample({.shape = Shape::kLogUniform}, 0, 1'000'000'000);
+  // Each of the 31 bit lengths (0 through 30) is equally likely.
+  EXPECT_GT(CountBetween(values, 0, 1023), 10000 * 9 / 31);
+  EXPECT_LT(CountBetween(values, 0, 1023), 10000 * 13 / 31);
+
+  std::vector<int64_t> near_max =
+      Sample({.shape = Shape::kLogUniform, .from_max = true}, 0, 1'000'000'000);
+  EXPECT_GT(CountBetween(near_max, 1'000'000'000 - 1023, 1'000'000'000),
+            10000 * 9 / 31);
+}
+
+TEST(IntegerDistributionsTest, ExponentialShouldHaveTheRequestedMean) {
+  std::vector<int64_t> values =
+      Sample({.shape = Shape::kExponential, .mean = 0.01}, 1, 1'000'001);
+  double sum = 0;
+  for (int64_t value : values) sum += value - 1;
+  EXPECT_GT(sum / values.size(), 9000);
+  EXPECT_LT(sum / values.size(), 11000);
+
+  std::vector<int64_t> near_max = Sample(
+      {.shape = Shape::kExponential, .from_max = true, .mean = 0.01}, 1,
+      1'000'001);
+  EXPECT_GT(CountBetween(near_max, 900'001, 1'000'001), 9900);
+}
+
+TEST(IntegerDistributionsTest, ClampedNormalShouldClusterAroundTheMean) {
+  std::vector<int64_t> values = Sample(
+      {.shape = Shape::kClampedNormal, .mean = 0.5, .stddev = 0.01}, 0, 10000);
+  // About 95% of values are within two standard deviations.
+  EXPECT_GT(CountBetween(values, 4800, 5200), 9300);
+  EXPECT_LT(CountBetween(values, 4800, 5200), 9700);
+
+  // Values outside of the range are clamped.
+  EXPECT_THAT(Sample({.shape = Shape::kClampedNormal, .mean = 2, .stddev = 0},
+                     0, 10000, 10),
+              Each(10000));
+}
+
+TEST(IntegerDistributionsTest, WeightedBucketsShouldRespectTheWeights) {
+  IntegerDistribution distribution = {
+      .shape = Shape::kWeightedBuckets,
+      .buckets = {{.min = 1, .max = 10, .weight = 1},
+                  {.min = 91, .max = 100, .weight = 3},
+                  {.min = 500, .max = 600, .weight = 100}}};
+  // The last bucket does not intersect [1, 100], so is ignored.
+  std::vector<int64_t> values = Sample(distribution, 1, 100);
+  EXPECT_EQ(CountBetween(values, 1, 10) + CountBetween(values, 91, 100),
+            values.size());
+  EXPECT_GT(CountBetween(values, 91, 100), 7000);
+  EXPECT_LT(CountBetween(values, 91, 100), 8000);
+
+  // No bucket intersects [20, 30], so the entire range is used.
+  EXPECT_THAT(Sample(distribution, 20, 30, 100), Each(AllOf(Ge(20), Le(30))));
+}
+
+TEST(IntegerDistributionsTest, RandIntsShouldMatchRandIntForEachShape) {
+  const std::vector<IntegerDistribution> distributions = {
+      {.shape = Shape::kUniform},
+      {.shape = Shape::kLogUniform},
+      {.shape = Shape::kExponential, .mean = 0.1},
+      {.shape = Shape::kWeightedBuckets,
+       .buckets = {{.min = 1, .max = 10, .weight = 1},
+                   {.min = 91, .max = 100, .weight = 3},
+                   {.min = 50, .max = 50, .weight = 0}}},
+  };
+  for (const IntegerDistribution& distribution : distributions) {
+    std::vector<int64_t> one_at_a_time = Sample(distribution, 1, 100, 1000);
+    RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+    std::vector<int64_t> all_at_once(1000);
+    MORIARTY_ASSERT_OK(RandIntsFromDistribution(rng, 1, 100, distribution,
+                                                absl::MakeSpan(all_at_once)));
+    EXPECT_EQ(all_at_once, one_at_a_time)
+        << IntegerDistributionToString(distribution);
+  }
+}
+
+TEST(IntegerDistributionsTest, InvalidParametersShouldFailValidation) {
+  EXPECT_THAT(ValidateIntegerDistribution(
+                  {.shape = Shape::kExponential, .mean = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("mean")));
+  EXPECT_THAT(ValidateIntegerDistribution(
+                  {.shape = Shape::kClampedNormal, .mean = 0.5, .stddev = -1}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ValidateIntegerDistribution({.shape = Shape::kWeightedBuckets}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ValidateIntegerDistribution(
+                  {.shape = Shape::kWeightedBuckets,
+                   .buckets = {{.min = 5, .max = 1, .weight = 1}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      ValidateIntegerDistribution(
+          {.shape = Shape::kWeightedBuckets,
+           .buckets = {{.min = 1, .max = 5, .weight = -1},
+                       {.min = 1, .max = 5, .weight = 2}}}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(IntegerDistributionsTest, InvalidRangeShouldFail) {
+  RandomEngine rng({1, 2, 3}, kCounterBasedVersion);
+  EXPECT_THAT(
+      RandIntFromDistribution(rng, 5, 1, {.shape = Shape::kLogUniform}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(IntegerDistributionsTest, ToStringShouldDescribeTheShape) {
+  EXPECT_EQ(IntegerDistributionToString({}), "uniform");
+  EXPECT_EQ(IntegerDistributionToString(
+                {.shape = Shape::kLogUniform, .from_max = true}),
+            "log_uniform_near_max");
+  EXPECT_EQ(IntegerDistributionToString(
+                {.shape = Shape::kExponential, .mean = 0.5}),
+            "exponential(mean=0.5)");
+  EXPECT_EQ(IntegerDistributionToString(
+                {.shape = Shape::kWeightedBuckets,
+                 .buckets = {{.min = 1, .max = 2, .weight = 3}}}),
+            "weighted_buckets([1, 2]: 3)");
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,214 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/minimizer.h"
+
+#include <algorithm>
+#include <any>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "src/internal/abstract_variable.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_codec.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+using VariableHandle = VariableSet::VariableHandle;
+
+enum class CandidateResult { kNoCandidate, kRejected, kAccepted };
+
+// Everything needed to check one candidate. Each concurrently checked
+// candidate has its own `Slot`, since validation points the variables at a
+// Universe and caches their dependents.
+struct Slot {
+  VariableSet variables;
+  ValueSet candidate;
+  Universe universe;
+  absl::StatusOr<CandidateResult> result;
+};
+
+// Decreases each integer in `dependencies` by `num_removed`, so that, e.g., the
+// length `N` of an array matches the array after `num_removed` of its elements
+// were removed. Then validates all of them again.
+absl::Status RepairDependencies(Slot& slot,
+                                const std::vector<std::string>& dependencies,
+                                int64_t num_removed) {
+  for (const std::string& dependency : dependencies) {
+    MORIARTY_ASSIGN_OR_RETURN(const AbstractVariable* variable,
+                              slot.variables.GetAbstractVariable(dependency));
+    if (variable->GetIntegerBounds() == nullptr) continue;
+    MORIARTY_ASSIGN_OR_RETURN(std::any value,
+                              slot.candidate.UnsafeGet(dependency));
+    const int64_t* integer = std::any_cast<int64_t>(&value);
+    if (integer == nullptr) continue;
+
+    std::string encoded;
+    EncodeValue<int64_t>(*integer - num_removed, encoded);
+    absl::string_view in = encoded;
+    MORIARTY_RETURN_IF_ERROR(
+        variable->DecodeValue(in, dependency, slot.candidate));
+  }
+  for (const std::string& dependency : dependencies) {
+    MORIARTY_RETURN_IF_ERROR(slot.variables.ValidateAfterChange(dependency));
+  }
+  return absl::OkStatus();
+}
+
+// Replaces the value of `name` in a copy of `values` with its `index`-th
+// smaller version at `level`, and checks it.
+absl::StatusOr<CandidateResult> CheckCandidate(
+    Slot& slot, const ValueSet& values, VariableHandle handle,
+    const std::vector<std::string>& dependencies, int level, int64_t index,
+    absl::FunctionRef<bool(const ValueSet&)> still_fails) {
+  const std::string& name = slot.variables.GetName(handle);
+  const AbstractVariable* variable =
+      static_cast<const VariableSet&>(slot.variables)
+          .GetAbstractVariable(handle);
+
+  slot.candidate = values;
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::optional<int64_t> num_removed,
+      variable->ShrinkValue(slot.candidate, name, level, index));
+  if (!num_removed) return CandidateResult::kNoCandidate;
+
+  if (!slot.variables.ValidateAfterChange(name).ok()) {
+    if (*num_removed <= 0 ||
+        !RepairDependencies(slot, dependencies, *num_removed).ok() ||
+        !slot.variables.ValidateAfterChange(name).ok()) {
+      return CandidateResult::kRejected;
+    }
+  }
+  return still_fails(slot.candidate) ? CandidateResult::kAccepted
+                                     : CandidateResult::kRejected;
+}
+
+}  // namespace
+
+absl::StatusOr<ValueSet> MinimizeValues(
+    const VariableSet& variables, ValueSet values,
+    absl::FunctionRef<bool(const ValueSet&)> still_fails,
+    Scheduler* scheduler) {
+  // `GetDependencies()` is not const, so these are computed on a copy.
+  std::vector<std::vector<std::string>> dependencies;
+  {
+    VariableSet copy = variables;
+    Universe universe =
+        Universe().SetConstValueSet(&values).SetConstVariableSet(&copy);
+    copy.SetUniverse(&universe);
+    if (absl::Status status = copy.AllVariablesSatisfyConstraints();
+        !status.ok()) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("MinimizeValues() must start from valid values: ",
+                       status.message()));
+    }
+    for (VariableHandle handle = 0; handle < copy.NumVariables(); handle++) {
+      std::vector<std::string> names =
+          copy.GetAbstractVariable(handle)->GetDependencies();
+      std::sort(names.begin(), names.end());
+      names.erase(std::unique(names.begin(), names.end()), names.end());
+      dependencies.push_back(std::move(names));
+    }
+  }
+  if (!still_fails(values)) {
+    return absl::FailedPreconditionError(
+        "MinimizeValues() must start from values that fail.");
+  }
+
+  int num_slots =
+      scheduler == nullptr ? 1 : std::max(1, scheduler->NumThreads());
+  std::vector<Slot> slots(num_slots);
+  for (Slot& slot : slots) {
+    slot.variables = variables;
+    slot.universe = Universe()
+                        .SetConstValueSet(&slot.candidate)
+                        .SetConstVariableSet(&slot.variables);
+    slot.variables.SetUniverse(&slot.universe);
+  }
+
+  // Repeat until a whole pass over the variables shrinks nothing, since
+  // shrinking one variable may allow another to shrink further.
+  bool shrunk = true;
+  while (shrunk) {
+    shrunk = false;
+    for (VariableHandle handle = 0; handle < variables.NumVariables();
+         handle++) {
+      if (!values.Contains(variables.GetName(handle))) continue;
+
+      int level = 0;
+      int64_t first_index = 0;
+      while (true) {
+        auto check = [&](int i) {
+          slots[i].result =
+              CheckCandidate(slots[i], values, handle, dependencies[handle],
+                             level, first_index + i, still_fails);
+        };
+        if (num_slots == 1) {
+          check(0);
+        } else {
+          scheduler->ParallelFor(num_slots, check);
+        }
+
+        // Accept the first candidate that still fails, so the result does not
+        // depend on the number of slots.
+        std::optional<int> accepted;
+        bool no_more_candidates = false;
+        for (int i = 0; i < num_slots && !accepted && !no_more_candidates;
+             i++) {
+          MORIARTY_ASSIGN_OR_RETURN(CandidateResult result, slots[i].result);
+          if (result == CandidateResult::kAccepted) accepted = i;
+          if (result == CandidateResult::kNoCandidate) {
+            no_more_candidates = true;
+            // A level without any candidates means no later level has any.
+            if (first_index + i == 0) level = -1;
+          }
+        }
+
+        if (accepted) {
+          values = std::move(slots[*accepted].candidate);
+          shrunk = true;
+          // Smaller values may have fewer chunks, so step back a level.
+          level = std::max(level - 1, 0);
+          first_index = 0;
+        } else if (level == -1) {
+          break;
+        } else if (no_more_candidates) {
+          level++;
+          first_index = 0;
+        } else {
+          first_index += num_slots;
+        }
+      }
+    }
+  }
+  return values;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
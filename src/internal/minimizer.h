@@ -0,0 +1,57 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_MINIMIZER_H_
+#define MORIARTY_SRC_INTERNAL_MINIMIZER_H_
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// MinimizeValues()
+//
+// Shrinks `values` (e.g., a test case that a solution fails on) while they
+// still satisfy the constraints in `variables` and `still_fails` still returns
+// true for them, and returns the smallest values found.
+//
+// This is delta debugging over the values of the variables, one variable at a
+// time: each candidate replaces the value of one variable with a smaller
+// version of it (see `MVariable::ShrinkImpl()`). Only the changed variable and
+// the variables that depend on it are validated again (see
+// `VariableSet::ValidateAfterChange()`). If a candidate removes elements and
+// is invalid, the integers it depends on (e.g., its length `N`) are decreased
+// by the number of elements removed and it is validated again.
+//
+// Candidates are checked on `scheduler` (if not `nullptr`), so `still_fails`
+// may be called concurrently. The result does not depend on the number of
+// threads.
+//
+// Returns kFailedPrecondition if `values` do not satisfy the constraints in
+// `variables` or `still_fails` returns false for them.
+absl::StatusOr<ValueSet> MinimizeValues(
+    const VariableSet& variables, ValueSet values,
+    absl::FunctionRef<bool(const ValueSet&)> still_fails,
+    Scheduler* scheduler = nullptr);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_MINIMIZER_H_
@@ -0,0 +1,159 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/minimizer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(MinimizerTest, MinimizeValuesShrinksIntegersToTheSmallestFailingValue) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between(1, 1000)));
+  ValueSet values;
+  values.Set<MInteger>("A", 700);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      ValueSet minimized,
+      MinimizeValues(variables, values, [](const ValueSet& values) {
+        return *values.Get<MInteger>("A") >= 37;
+      }));
+
+  EXPECT_THAT(minimized.Get<MInteger>("A"), IsOkAndHolds(37));
+}
+
+TEST(MinimizerTest, MinimizeValuesKeepsIntegersWithinTheirConstraints) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between(10, 1000)));
+  ValueSet values;
+  values.Set<MInteger>("A", 700);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      ValueSet minimized, MinimizeValues(variables, values,
+                                         [](const ValueSet&) { return true; }));
+
+  EXPECT_THAT(minimized.Get<MInteger>("A"), IsOkAndHolds(10));
+}
+
+TEST(MinimizerTest, MinimizeValuesRemovesCharactersFromStrings) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "S", MString().WithAlphabet("abcx").OfLength(1, 50)));
+  ValueSet values;
+  values.Set<MString>("S", "xxxxabcxxxxxxx");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      ValueSet minimized,
+      MinimizeValues(variables, values, [](const ValueSet& values) {
+        return values.Get<MString>("S")->find("abc") != std::string::npos;
+      }));
+
+  EXPECT_THAT(minimized.Get<MString>("S"), IsOkAndHolds("abc"));
+}
+
+TEST(MinimizerTest, MinimizeValuesShrinksTheLengthOfAnArrayAlongWithIt) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 100)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 100)).OfLength("N")));
+  ValueSet values;
+  values.Set<MInteger>("N", 8);
+  values.Set<MArray<MInteger>>("A", {3, 1, 4, 1, 5, 9, 2, 6});
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      ValueSet minimized,
+      MinimizeValues(variables, values, [](const ValueSet& values) {
+        return absl::c_linear_search(*values.Get<MArray<MInteger>>("A"), 5);
+      }));
+
+  EXPECT_THAT(minimized.Get<MInteger>("N"), IsOkAndHolds(1));
+  EXPECT_THAT(minimized.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(5)));
+}
+
+TEST(MinimizerTest, MinimizeValuesGivesTheSameResultWithAnyNumberOfThreads) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("N", MInteger().Between(1, 100)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "A", MArray<MInteger>(MInteger().Between(1, 100)).OfLength("N")));
+  ValueSet values;
+  values.Set<MInteger>("N", 10);
+  values.Set<MArray<MInteger>>("A", {7, 3, 9, 3, 7, 1, 9, 8, 3, 2});
+  // Fails on any array with two equal elements.
+  auto still_fails = [](const ValueSet& values) {
+    std::vector<int64_t> array = *values.Get<MArray<MInteger>>("A");
+    absl::c_sort(array);
+    return absl::c_adjacent_find(array) != array.end();
+  };
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(ValueSet single_threaded,
+                                MinimizeValues(variables, values, still_fails));
+  WorkStealingScheduler scheduler(4);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      ValueSet multi_threaded,
+      MinimizeValues(variables, values, still_fails, &scheduler));
+
+  EXPECT_THAT(single_threaded.Get<MInteger>("N"), IsOkAndHolds(2));
+  EXPECT_EQ(*single_threaded.Get<MArray<MInteger>>("A"),
+            *multi_threaded.Get<MArray<MInteger>>("A"));
+}
+
+TEST(MinimizerTest, MinimizeValuesRequiresValidValues) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between(1, 10)));
+  ValueSet values;
+  values.Set<MInteger>("A", 700);
+
+  EXPECT_THAT(
+      MinimizeValues(variables, values, [](const ValueSet&) { return true; }),
+      StatusIs(absl::StatusCode::kFailedPrecondition,
+               HasSubstr("valid values")));
+}
+
+TEST(MinimizerTest, MinimizeValuesRequiresValuesThatFail) {
+  VariableSet variables;
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MInteger().Between(1, 10)));
+  ValueSet values;
+  values.Set<MInteger>("A", 7);
+
+  EXPECT_THAT(
+      MinimizeValues(variables, values, [](const ValueSet&) { return false; }),
+      StatusIs(absl::StatusCode::kFailedPrecondition,
+               HasSubstr("values that fail")));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,146 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/order_statistic_treap.h"
+
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// The SplitMix64 finalizer. Consecutive inputs give unrelated priorities.
+uint64_t Mix64(uint64_t z) {
+  z += 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+}  // namespace
+
+bool OrderStatisticTreap::Insert(int64_t key) {
+  if (Contains(key)) return false;
+  int32_t left, right;
+  Split(root_, key, left, right);
+  root_ = Merge(Merge(left, NewNode(key)), right);
+  return true;
+}
+
+bool OrderStatisticTreap::Erase(int64_t key) {
+  if (!Contains(key)) return false;
+  root_ = Erase(root_, key);
+  return true;
+}
+
+bool OrderStatisticTreap::Contains(int64_t key) const {
+  int32_t node = root_;
+  while (node != kNull && nodes_[node].key != key)
+    node = key < nodes_[node].key ? nodes_[node].left : nodes_[node].right;
+  return node != kNull;
+}
+
+int64_t OrderStatisticTreap::Kth(int64_t k) const {
+  ABSL_CHECK(0 <= k && k < size()) << "Kth(" << k << ") of " << size();
+  int32_t node = root_;
+  while (true) {
+    int64_t left_size = Size(nodes_[node].left);
+    if (k == left_size) return nodes_[node].key;
+    if (k < left_size) {
+      node = nodes_[node].left;
+    } else {
+      k -= left_size + 1;
+      node = nodes_[node].right;
+    }
+  }
+}
+
+int64_t OrderStatisticTreap::CountLessThan(int64_t key) const {
+  int64_t count = 0;
+  int32_t node = root_;
+  while (node != kNull) {
+    if (nodes_[node].key < key) {
+      count += Size(nodes_[node].left) + 1;
+      node = nodes_[node].right;
+    } else {
+      node = nodes_[node].left;
+    }
+  }
+  return count;
+}
+
+void OrderStatisticTreap::Update(int32_t node) {
+  nodes_[node].size = Size(nodes_[node].left) + Size(nodes_[node].right) + 1;
+}
+
+int32_t OrderStatisticTreap::NewNode(int64_t key) {
+  Node node = {.key = key, .priority = Mix64(num_created_++)};
+  if (!free_nodes_.empty()) {
+    int32_t index = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[index] = node;
+    return index;
+  }
+  nodes_.push_back(node);
+  return nodes_.size() - 1;
+}
+
+void OrderStatisticTreap::Split(int32_t node, int64_t key, int32_t& left,
+                                int32_t& right) {
+  if (node == kNull) {
+    left = right = kNull;
+    return;
+  }
+  if (nodes_[node].key < key) {
+    Split(nodes_[node].right, key, nodes_[node].right, right);
+    left = node;
+  } else {
+    Split(nodes_[node].left, key, left, nodes_[node].left);
+    right = node;
+  }
+  Update(node);
+}
+
+int32_t OrderStatisticTreap::Merge(int32_t left, int32_t right) {
+  if (left == kNull) return right;
+  if (right == kNull) return left;
+  if (nodes_[left].priority > nodes_[right].priority) {
+    nodes_[left].right = Merge(nodes_[left].right, right);
+    Update(left);
+    return left;
+  }
+  nodes_[right].left = Merge(left, nodes_[right].left);
+  Update(right);
+  return right;
+}
+
+int32_t OrderStatisticTreap::Erase(int32_t node, int64_t key) {
+  if (nodes_[node].key == key) {
+    free_nodes_.push_back(node);
+    return Merge(nodes_[node].left, nodes_[node].right);
+  }
+  if (key < nodes_[node].key) {
+    nodes_[node].left = Erase(nodes_[node].left, key);
+  } else {
+    nodes_[node].right = Erase(nodes_[node].right, key);
+  }
+  Update(node);
+  return node;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_ORDER_STATISTIC_TREAP_H_
+#define MORIARTY_SRC_INTERNAL_ORDER_STATISTIC_TREAP_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// OrderStatisticTreap
+//
+// A set of distinct integers that also answers order statistics (the k-th
+// smallest key and the rank of a key). Each operation takes O(log n) expected
+// time.
+//
+// The priorities of the nodes are a fixed hash of the order in which they
+// were created, so the treap uses no randomness and behaves the same on every
+// platform.
+class OrderStatisticTreap {
+ public:
+  // Insert()
+  //
+  // Adds `key` to the set. Returns false if it was already in the set.
+  bool Insert(int64_t key);
+
+  // Erase()
+  //
+  // Removes `key` from the set. Returns false if it was not in the set.
+  bool Erase(int64_t key);
+
+  // Contains()
+  //
+  // Returns true if `key` is in the set.
+  [[nodiscard]] bool Contains(int64_t key) const;
+
+  // size()
+  //
+  // The number of keys in the set.
+  [[nodiscard]] int64_t size() const { return Size(root_); }
+  [[nodiscard]] bool empty() const { return root_ == kNull; }
+
+  // Kth()
+  //
+  // Returns the `k`-th smallest key (0-based). `k` must be in [0, size()).
+  [[nodiscard]] int64_t Kth(int64_t k) const;
+
+  // CountLessThan()
+  //
+  // Returns the number of keys in the set that are less than `key`.
+  [[nodiscard]] int64_t CountLessThan(int64_t key) const;
+
+ private:
+  static constexpr int32_t kNull = -1;
+
+  struct Node {
+    int64_t key;
+    uint64_t priority;
+    int32_t left = kNull;
+    int32_t right = kNull;
+    int32_t size = 1;
+  };
+
+  // Nodes are referred to by their index in `nodes_`. Erased nodes are reused.
+  std::vector<Node> nodes_;
+  std::vector<int32_t> free_nodes_;
+  int32_t root_ = kNull;
+  uint64_t num_created_ = 0;
+
+  int32_t Size(int32_t node) const {
+    return node == kNull ? 0 : nodes_[node].size;
+  }
+  void Update(int32_t node);
+  int32_t NewNode(int64_t key);
+
+  // Splits the subtree at `node` into the keys less than `key` (`left`) and
+  // the rest (`right`).
+  void Split(int32_t node, int64_t key, int32_t& left, int32_t& right);
+  // Merges two subtrees, where every key in `left` is less than every key in
+  // `right`, and returns the root.
+  int32_t Merge(int32_t left, int32_t right);
+  // Removes `key` (which must be present) from the subtree at `node` and
+  // returns its new root.
+  int32_t Erase(int32_t node, int64_t key);
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_ORDER_STATISTIC_TREAP_H_
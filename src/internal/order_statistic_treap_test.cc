@@ -0,0 +1,109 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/order_statistic_treap.h"
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <set>
+
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+TEST(OrderStatisticTreapTest, EmptyTreapShouldHaveNoKeys) {
+  OrderStatisticTreap treap;
+  EXPECT_TRUE(treap.empty());
+  EXPECT_EQ(treap.size(), 0);
+  EXPECT_FALSE(treap.Contains(0));
+  EXPECT_EQ(treap.CountLessThan(0), 0);
+}
+
+TEST(OrderStatisticTreapTest, InsertAndEraseShouldReportWhetherKeyChanged) {
+  OrderStatisticTreap treap;
+  EXPECT_TRUE(treap.Insert(5));
+  EXPECT_FALSE(treap.Insert(5));
+  EXPECT_TRUE(treap.Contains(5));
+  EXPECT_EQ(treap.size(), 1);
+
+  EXPECT_FALSE(treap.Erase(4));
+  EXPECT_TRUE(treap.Erase(5));
+  EXPECT_FALSE(treap.Erase(5));
+  EXPECT_TRUE(treap.empty());
+}
+
+TEST(OrderStatisticTreapTest, KthAndCountLessThanShouldMatchSortedOrder) {
+  OrderStatisticTreap treap;
+  for (int64_t key : {50, 10, 40, 20, 30}) treap.Insert(key);
+  EXPECT_EQ(treap.Kth(0), 10);
+  EXPECT_EQ(treap.Kth(2), 30);
+  EXPECT_EQ(treap.Kth(4), 50);
+  EXPECT_EQ(treap.CountLessThan(10), 0);
+  EXPECT_EQ(treap.CountLessThan(35), 3);
+  EXPECT_EQ(treap.CountLessThan(100), 5);
+}
+
+TEST(OrderStatisticTreapTest, ExtremeKeysShouldWork) {
+  OrderStatisticTreap treap;
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  treap.Insert(kMax);
+  treap.Insert(kMin);
+  EXPECT_EQ(treap.Kth(0), kMin);
+  EXPECT_EQ(treap.Kth(1), kMax);
+  EXPECT_EQ(treap.CountLessThan(kMax), 1);
+  EXPECT_TRUE(treap.Erase(kMax));
+  EXPECT_FALSE(treap.Contains(kMax));
+}
+
+TEST(OrderStatisticTreapTest, ShouldMatchStdSetAfterManyOperations) {
+  OrderStatisticTreap treap;
+  std::set<int64_t> expected;
+  uint64_t state = 12345;
+  for (int i = 0; i < 20000; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    int64_t key = (state >> 33) % 1000;
+    if ((state >> 20) % 3 == 0) {
+      ASSERT_EQ(treap.Erase(key), expected.erase(key) == 1);
+    } else {
+      ASSERT_EQ(treap.Insert(key), expected.insert(key).second);
+    }
+    ASSERT_EQ(treap.size(), expected.size());
+  }
+
+  int64_t k = 0;
+  for (int64_t key : expected) EXPECT_EQ(treap.Kth(k++), key);
+  for (int64_t key = -1; key <= 1000; key++) {
+    EXPECT_EQ(treap.CountLessThan(key),
+              std::distance(expected.begin(), expected.lower_bound(key)));
+  }
+}
+
+TEST(OrderStatisticTreapTest, SortedInsertionsShouldStayShallow) {
+  // A plain binary search tree would recurse a million levels deep here.
+  OrderStatisticTreap treap;
+  for (int64_t key = 0; key < 1'000'000; key++) treap.Insert(key);
+  EXPECT_EQ(treap.size(), 1'000'000);
+  EXPECT_EQ(treap.Kth(123'456), 123'456);
+  for (int64_t key = 0; key < 1'000'000; key += 2) treap.Erase(key);
+  EXPECT_EQ(treap.Kth(0), 1);
+  EXPECT_EQ(treap.CountLessThan(500'000), 250'000);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
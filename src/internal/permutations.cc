@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/permutations.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/types/span.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// Returns values[i] - first as an index into `values`, or `std::nullopt` if it
+// is out of range. Computed without overflow for any `first`.
+std::optional<size_t> IndexOf(absl::Span<const int64_t> values, size_t i,
+                              int64_t first) {
+  uint64_t index =
+      static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(first);
+  if (index >= values.size()) return std::nullopt;
+  return index;
+}
+
+}  // namespace
+
+bool IsPermutation(absl::Span<const int64_t> values, int64_t first) {
+  std::vector<bool> seen(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    std::optional<size_t> index = IndexOf(values, i, first);
+    if (!index || seen[*index]) return false;
+    seen[*index] = true;
+  }
+  return true;
+}
+
+std::optional<int64_t> CountPermutationCycles(absl::Span<const int64_t> values,
+                                              int64_t first) {
+  if (!IsPermutation(values, first)) return std::nullopt;
+
+  std::vector<bool> visited(values.size());
+  int64_t cycles = 0;
+  for (size_t start = 0; start < values.size(); start++) {
+    if (visited[start]) continue;
+    cycles++;
+    for (size_t i = start; !visited[i]; i = values[i] - first)
+      visited[i] = true;
+  }
+  return cycles;
+}
+
+bool IsDerangement(absl::Span<const int64_t> values, int64_t first) {
+  for (size_t i = 0; i < values.size(); i++) {
+    if (IndexOf(values, i, first) == i) return false;
+  }
+  return IsPermutation(values, first);
+}
+
+bool IsInvolution(absl::Span<const int64_t> values, int64_t first) {
+  // If p(p(i)) == i for all i, then p is its own inverse, so a bijection.
+  for (size_t i = 0; i < values.size(); i++) {
+    std::optional<size_t> index = IndexOf(values, i, first);
+    if (!index || IndexOf(values, *index, first) != i) return false;
+  }
+  return true;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_PERMUTATIONS_H_
+#define MORIARTY_SRC_INTERNAL_PERMUTATIONS_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "absl/types/span.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// The functions below treat `values` as the permutation p that maps i to
+// values[i] - first, for i in [0, values.size()). Each takes O(n) time.
+
+// IsPermutation()
+//
+// Returns true if `values` is a permutation of
+// {first, first + 1, ... , first + (n-1)}, where n = values.size().
+bool IsPermutation(absl::Span<const int64_t> values, int64_t first = 0);
+
+// CountPermutationCycles()
+//
+// Returns the number of cycles of `values`, or `std::nullopt` if `values` is
+// not a permutation (see `IsPermutation()`).
+std::optional<int64_t> CountPermutationCycles(absl::Span<const int64_t> values,
+                                              int64_t first = 0);
+
+// IsDerangement()
+//
+// Returns true if `values` is a permutation with no fixed points (i.e.,
+// values[i] != first + i for all i).
+bool IsDerangement(absl::Span<const int64_t> values, int64_t first = 0);
+
+// IsInvolution()
+//
+// Returns true if `values` is a permutation that is its own inverse (i.e.,
+// values[values[i] - first] == first + i for all i).
+bool IsInvolution(absl::Span<const int64_t> values, int64_t first = 0);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_PERMUTATIONS_H_
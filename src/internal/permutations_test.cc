@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/permutations.h"
+
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+TEST(PermutationsTest, IsPermutationChecksTheValues) {
+  EXPECT_TRUE(IsPermutation({}));
+  EXPECT_TRUE(IsPermutation({2, 0, 1}));
+  EXPECT_TRUE(IsPermutation({3, 1, 2}, 1));
+  EXPECT_FALSE(IsPermutation({3, 1, 2}));
+  EXPECT_FALSE(IsPermutation({0, 0, 1}));
+  EXPECT_FALSE(IsPermutation({-1, 0}));
+}
+
+TEST(PermutationsTest, IsPermutationHandlesExtremeValues) {
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+
+  EXPECT_TRUE(IsPermutation({kMin + 1, kMin}, kMin));
+  EXPECT_FALSE(IsPermutation({kMax, kMin}, kMin));
+  EXPECT_FALSE(IsPermutation({kMin, 0}, kMax));
+}
+
+TEST(PermutationsTest, CountPermutationCyclesCountsTheCycles) {
+  EXPECT_THAT(CountPermutationCycles({}), Optional(Eq(0)));
+  EXPECT_THAT(CountPermutationCycles({0, 1, 2}), Optional(Eq(3)));
+  EXPECT_THAT(CountPermutationCycles({1, 2, 0}), Optional(Eq(1)));
+  EXPECT_THAT(CountPermutationCycles({2, 1, 4, 5, 3}, 1), Optional(Eq(2)));
+  EXPECT_EQ(CountPermutationCycles({1, 1, 0}), std::nullopt);
+}
+
+TEST(PermutationsTest, CountPermutationCyclesHandlesLongCycles) {
+  std::vector<int64_t> cycle(100000);
+  std::iota(cycle.begin(), cycle.end(), 1);
+  cycle.back() = 0;
+  EXPECT_THAT(CountPermutationCycles(cycle), Optional(Eq(1)));
+}
+
+TEST(PermutationsTest, IsDerangementRejectsFixedPoints) {
+  EXPECT_TRUE(IsDerangement({}));
+  EXPECT_TRUE(IsDerangement({1, 0}));
+  EXPECT_TRUE(IsDerangement({3, 1, 2}, 1));
+  EXPECT_FALSE(IsDerangement({0}));
+  EXPECT_FALSE(IsDerangement({1, 0, 2}));
+  EXPECT_FALSE(IsDerangement({1, 2, 3}));
+  EXPECT_FALSE(IsDerangement({1, 1}));
+}
+
+TEST(PermutationsTest, IsInvolutionChecksThatThePermutationIsItsOwnInverse) {
+  EXPECT_TRUE(IsInvolution({}));
+  EXPECT_TRUE(IsInvolution({0, 1, 2}));
+  EXPECT_TRUE(IsInvolution({2, 1, 0}));
+  EXPECT_TRUE(IsInvolution({2, 1, 4, 3}, 1));
+  EXPECT_FALSE(IsInvolution({1, 2, 0}));
+  EXPECT_FALSE(IsInvolution({1, 0, 3}));
+  EXPECT_FALSE(IsInvolution({0, 0}));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -15,10 +15,14 @@
 #include "src/internal/random_config.h"
 
 #include <cstdint>
+#include <limits>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "src/internal/random_engine.h"
+#include "src/lazy_permutation.h"
+#include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 namespace moriarty_internal {
@@ -44,5 +48,21 @@ absl::StatusOr<std::vector<int>> RandomPermutation(RandomEngine& engine,
   return RandomPermutation(engine, n, int{0});
 }
 
+absl::StatusOr<LazyPermutation> RandomLazyPermutation(RandomEngine& engine,
+                                                      int64_t n) {
+  if (n < 0) {
+    return absl::InvalidArgumentError("n must be non-negative");
+  }
+
+  LazyPermutation::Keys keys;
+  absl::Status status;
+  for (uint64_t& key : keys) {
+    key = engine.RandInt(std::numeric_limits<int64_t>::min(),
+                         std::numeric_limits<int64_t>::max(), status);
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+  return LazyPermutation(n, keys);
+}
+
 }  // namespace moriarty_internal
 }  // namespace moriarty
@@ -22,14 +22,23 @@
 #include <algorithm>
 #include <concepts>
 #include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "absl/base/prefetch.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/internal/alias_table.h"
 #include "src/internal/random_engine.h"
+#include "src/lazy_permutation.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
@@ -63,6 +72,10 @@ absl::StatusOr<int64_t> RandomInteger(RandomEngine& engine, int64_t n);
 // Shuffle()
 //
 // Shuffles the elements in `container`.
+//
+// A Fisher-Yates shuffle whose swap targets come from
+// `RandomEngine::RandIntsBelow()`, so the resulting order for a given seed is
+// fixed by the engine's version.
 template <typename T>
 absl::Status Shuffle(RandomEngine& engine, std::vector<T>& container);
 
@@ -81,6 +94,29 @@ template <typename T>
 absl::StatusOr<std::vector<T>> RandomElementsWithReplacement(
     RandomEngine& engine, const std::vector<T>& container, int k);
 
+// RandomWeightedElement()
+//
+// Returns a random element of `container`, where `container[i]` is picked with
+// probability weights[i] / (sum of weights). `weights` must be non-negative,
+// with the same size as `container` and a positive sum.
+//
+// Uses an `AliasTable`, so the element returned for a given seed does not
+// depend on the platform.
+template <typename T>
+absl::StatusOr<T> RandomWeightedElement(RandomEngine& engine,
+                                        const std::vector<T>& container,
+                                        absl::Span<const int64_t> weights);
+
+// RandomWeightedElements()
+//
+// Returns k (randomly ordered) elements of `container`, possibly with
+// duplicates, each picked as in `RandomWeightedElement()`. The weights are
+// only preprocessed once, so each element takes O(1) time.
+template <typename T>
+absl::StatusOr<std::vector<T>> RandomWeightedElements(
+    RandomEngine& engine, const std::vector<T>& container,
+    absl::Span<const int64_t> weights, int k);
+
 // RandomElementsWithoutReplacement()
 //
 // Returns k (randomly ordered) elements of `container`, without duplicates.
@@ -93,6 +129,24 @@ template <typename T>
 absl::StatusOr<std::vector<T>> RandomElementsWithoutReplacement(
     RandomEngine& engine, const std::vector<T>& container, int k);
 
+// ReservoirSample()
+//
+// Returns k (randomly ordered) elements of the range [first, last), without
+// duplicates, in one pass over the range and O(k) memory. Useful when the
+// range is too large to hold in memory, e.g., lines of a file or a lazily
+// generated sequence.
+//
+// Uses Algorithm R, which draws one random integer per element after the
+// first k. Only integers are drawn (no floating point math), so the same seed
+// gives the same sample everywhere.
+template <typename InputIt>
+absl::StatusOr<std::vector<std::iter_value_t<InputIt>>>
+ReservoirSample(RandomEngine& engine, InputIt first, InputIt last, int k);
+
+// The number of random values `Shuffle()` and `RandomPermutation()` draw at a
+// time.
+inline constexpr size_t kShuffleChunkSize = 256;
+
 // RandomPermutation()
 //
 // Returns a random permutation of {0, 1, ... , n-1}.
@@ -108,6 +162,67 @@ template <typename T>
 absl::StatusOr<std::vector<T>> RandomPermutation(RandomEngine& engine, int n,
                                                  T min);
 
+// RandomCyclicPermutation()
+//
+// Returns a random permutation p of {min, min + 1, ... , min + (n-1)} that is
+// a single cycle: starting anywhere and following x -> p[x - min] visits every
+// value. Each such permutation is equally likely (Sattolo's algorithm).
+//
+// Requires min + (n-1) to not overflow T.
+template <typename T = int>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomCyclicPermutation(RandomEngine& engine,
+                                                       int n, T min = 0);
+
+// RandomDerangement()
+//
+// Returns a random permutation p of {min, min + 1, ... , min + (n-1)} with no
+// fixed points (p[i] != min + i for all i). Each such permutation is equally
+// likely. Takes expected O(n) time: about e shuffles are started, and each is
+// abandoned at its first fixed point.
+//
+// Requires min + (n-1) to not overflow T.
+template <typename T = int>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomDerangement(RandomEngine& engine, int n,
+                                                 T min = 0);
+
+// RandomPermutationWithCycles()
+//
+// Returns a random permutation p of {min, min + 1, ... , min + (n-1)} with
+// exactly k cycles (following x -> p[x - min]). Takes O(n) time.
+//
+// The cycle lengths are a uniformly random composition of n and the values are
+// placed into them uniformly at random. This is *not* uniform over all
+// permutations with k cycles (that would need Stirling numbers), but every
+// such permutation is possible.
+//
+// Requires min + (n-1) to not overflow T.
+template <typename T = int>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomPermutationWithCycles(RandomEngine& engine,
+                                                           int n, int k,
+                                                           T min = 0);
+
+// RandomInvolution()
+//
+// Returns a random permutation p of {min, min + 1, ... , min + (n-1)} that is
+// its own inverse (p[p[i] - min] == min + i for all i). Each such permutation
+// is equally likely. Takes O(n) time.
+//
+// Requires min + (n-1) to not overflow T.
+template <typename T = int>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomInvolution(RandomEngine& engine, int n,
+                                                T min = 0);
+
+// RandomLazyPermutation()
+//
+// Returns a random `LazyPermutation` of {0, 1, ... , n-1}, keyed from
+// `engine`. Takes O(1) time and memory.
+absl::StatusOr<LazyPermutation> RandomLazyPermutation(RandomEngine& engine,
+                                                      int64_t n);
+
 // DistinctIntegers()
 //
 // Returns k (randomly ordered) distinct integers from
@@ -119,6 +234,20 @@ template <typename T>
 absl::StatusOr<std::vector<T>> DistinctIntegers(RandomEngine& engine, T n,
                                                 int k, T min = 0);
 
+// SortedDistinctIntegers()
+//
+// Returns k distinct integers from {min, min + 1, ... , min + (n-1)} in
+// increasing order. Each subset of size k is equally likely.
+//
+// Faster than sorting the result of `DistinctIntegers()` since no hashing is
+// needed. Uses O(min(k, n - k)) memory in addition to the result.
+//
+// Requires min + (n-1) to not overflow T.
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> SortedDistinctIntegers(RandomEngine& engine,
+                                                      T n, int k, T min = 0);
+
 // RandomComposition()
 //
 // Returns a random composition (a partition where the order of the buckets is
@@ -134,15 +263,48 @@ template <typename T>
 absl::StatusOr<std::vector<T>> RandomComposition(RandomEngine& engine, T n,
                                                  int k, T min_bucket_size = 1);
 
+// BoundedRandomComposition()
+//
+// Same as `RandomComposition()`, but each bucket also has at most
+// `max_bucket_size` elements. Takes O(k) time, independent of the sizes.
+//
+// If the bound is loose, the result is uniformly random. Otherwise, the excess
+// of an unbounded composition is moved to buckets that have room for it, which
+// is not exactly uniform.
+//
+// Requires n + (k - 1) to not overflow T.
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> BoundedRandomComposition(RandomEngine& engine,
+                                                        T n, int k,
+                                                        T min_bucket_size,
+                                                        T max_bucket_size);
+
 // -----------------------------------------------------------------------------
 //  Template implementation below
 
 template <typename T>
 absl::Status Shuffle(RandomEngine& engine, std::vector<T>& container) {
-  for (size_t i = 1; i < container.size(); i++) {
-    using std::swap;
-    MORIARTY_ASSIGN_OR_RETURN(size_t swap_with, engine.RandInt(i + 1));
-    if (i != swap_with) swap(container[i], container[swap_with]);
+  // The swap targets are drawn a chunk at a time, so that they are drawn in
+  // bulk and can be prefetched before they are swapped.
+  int64_t bounds[kShuffleChunkSize];
+  int64_t swap_with[kShuffleChunkSize];
+  for (size_t start = 1; start < container.size();
+       start += kShuffleChunkSize) {
+    size_t count = std::min(kShuffleChunkSize, container.size() - start);
+    for (size_t j = 0; j < count; j++) bounds[j] = start + j + 1;
+    MORIARTY_RETURN_IF_ERROR(engine.RandIntsBelow(
+        absl::MakeConstSpan(bounds, count), absl::MakeSpan(swap_with, count)));
+    if constexpr (!std::is_same_v<T, bool>) {
+      for (size_t j = 0; j < count; j++)
+        absl::PrefetchToLocalCache(&container[swap_with[j]]);
+    }
+    for (size_t j = 0; j < count; j++) {
+      using std::swap;
+      size_t i = start + j;
+      size_t target = swap_with[j];
+      if (i != target) swap(container[i], container[target]);
+    }
   }
   return absl::OkStatus();
 }
@@ -173,10 +335,44 @@ absl::StatusOr<std::vector<T>> RandomElementsWithReplacement(
   std::vector<T> result;
   result.reserve(k);
 
-  for (int i = 0; i < k; i++) {
-    MORIARTY_ASSIGN_OR_RETURN(int index, engine.RandInt(container.size()));
-    result.push_back(container[index]);
+  absl::Status status;
+  for (int i = 0; i < k; i++)
+    result.push_back(container[engine.RandInt(container.size(), status)]);
+  MORIARTY_RETURN_IF_ERROR(status);
+  return result;
+}
+
+template <typename T>
+absl::StatusOr<T> RandomWeightedElement(RandomEngine& engine,
+                                        const std::vector<T>& container,
+                                        absl::Span<const int64_t> weights) {
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<T> elements,
+      RandomWeightedElements(engine, container, weights, 1));
+  return std::move(elements[0]);
+}
+
+template <typename T>
+absl::StatusOr<std::vector<T>> RandomWeightedElements(
+    RandomEngine& engine, const std::vector<T>& container,
+    absl::Span<const int64_t> weights, int k) {
+  if (k < 0) {
+    return absl::InvalidArgumentError("k must be non-negative");
+  }
+  if (container.size() != weights.size()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "container has $0 elements, but there are $1 weights",
+        container.size(), weights.size()));
   }
+  MORIARTY_ASSIGN_OR_RETURN(AliasTable table, AliasTable::Create(weights));
+
+  std::vector<T> result;
+  result.reserve(k);
+
+  absl::Status status;
+  for (int i = 0; i < k; i++)
+    result.push_back(container[table.Sample(engine, status)]);
+  MORIARTY_RETURN_IF_ERROR(status);
   return result;
 }
 
@@ -201,6 +397,37 @@ absl::StatusOr<std::vector<T>> RandomElementsWithoutReplacement(
   return result;
 }
 
+template <typename InputIt>
+absl::StatusOr<std::vector<std::iter_value_t<InputIt>>>
+ReservoirSample(RandomEngine& engine, InputIt first, InputIt last, int k) {
+  if (k < 0) {
+    return absl::InvalidArgumentError("k must be non-negative");
+  }
+
+  std::vector<std::iter_value_t<InputIt>> reservoir;
+  reservoir.reserve(k);
+  for (; reservoir.size() < k && first != last; ++first)
+    reservoir.push_back(*first);
+  if (reservoir.size() < k) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Cannot get $0 distinct element from a range of size $1", k,
+        reservoir.size()));
+  }
+  if (k == 0) return reservoir;
+
+  // The i-th element (0-based) replaces a random element of the reservoir with
+  // probability k / (i + 1).
+  absl::Status status;
+  for (int64_t i = k; first != last; ++first, i++) {
+    int64_t j = engine.RandInt(i + 1, status);
+    if (j < k) reservoir[j] = *first;
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+
+  MORIARTY_RETURN_IF_ERROR(Shuffle(engine, reservoir));
+  return reservoir;
+}
+
 template <typename T>
   requires std::integral<T>
 absl::StatusOr<std::vector<T>> RandomPermutation(RandomEngine& engine, int n,
@@ -212,6 +439,123 @@ absl::StatusOr<std::vector<T>> RandomPermutation(RandomEngine& engine, int n,
   return DistinctIntegers(engine, T{n}, n, min);
 }
 
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomCyclicPermutation(RandomEngine& engine,
+                                                       int n, T min) {
+  if (n < 0) {
+    return absl::InvalidArgumentError("n must be non-negative");
+  }
+
+  std::vector<T> result(n);
+  for (int i = 0; i < n; i++) result[i] = min + i;
+  // Sattolo's algorithm: a Fisher-Yates shuffle that never swaps a position
+  // with itself.
+  absl::Status status;
+  for (int i = n - 1; i > 0; i--)
+    std::swap(result[i], result[engine.RandInt(i, status)]);
+  MORIARTY_RETURN_IF_ERROR(status);
+  return result;
+}
+
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomDerangement(RandomEngine& engine, int n,
+                                                 T min) {
+  if (n < 0) {
+    return absl::InvalidArgumentError("n must be non-negative");
+  }
+  if (n == 1) {
+    return absl::InvalidArgumentError("A single value has no derangement");
+  }
+
+  // A Fisher-Yates shuffle from the back fixes position i once it is swapped,
+  // so a shuffle with a fixed point is rejected as soon as one appears. Each
+  // derangement is as likely as it is in a full shuffle.
+  std::vector<T> result(n);
+  absl::Status status;
+  bool has_fixed_point = true;
+  while (has_fixed_point) {
+    for (int i = 0; i < n; i++) result[i] = i;
+    has_fixed_point = false;
+    for (int i = n - 1; i >= 0 && !has_fixed_point; i--) {
+      std::swap(result[i], result[engine.RandInt(i + 1, status)]);
+      has_fixed_point = result[i] == i;
+    }
+    MORIARTY_RETURN_IF_ERROR(status);
+  }
+  for (T& value : result) value += min;
+  return result;
+}
+
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomPermutationWithCycles(RandomEngine& engine,
+                                                           int n, int k,
+                                                           T min) {
+  if (n < 0) {
+    return absl::InvalidArgumentError("n must be non-negative");
+  }
+  if (k < 0 || k > n || (k == 0 && n > 0)) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Cannot split $0 values into $1 cycles", n, k));
+  }
+  if (n == 0) return std::vector<T>();
+
+  // Consecutive runs of a random order of the values are the cycles.
+  MORIARTY_ASSIGN_OR_RETURN(std::vector<T> order,
+                            RandomPermutation(engine, n, min));
+  MORIARTY_ASSIGN_OR_RETURN(std::vector<int> lengths,
+                            RandomComposition(engine, n, k));
+  std::vector<T> result(n);
+  int start = 0;
+  for (int length : lengths) {
+    for (int i = start; i < start + length - 1; i++)
+      result[order[i] - min] = order[i + 1];
+    result[order[start + length - 1] - min] = order[start];
+    start += length;
+  }
+  return result;
+}
+
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> RandomInvolution(RandomEngine& engine, int n,
+                                                T min) {
+  if (n < 0) {
+    return absl::InvalidArgumentError("n must be non-negative");
+  }
+
+  // With I(m) involutions of m values, I(m) = I(m-1) + (m-1) * I(m-2): the
+  // last value is either fixed or paired with one of the others. So it is fixed
+  // with probability I(m-1) / I(m) = 1 / (1 + (m-1) * I(m-2) / I(m-1)).
+  std::vector<double> fixed_probability(n + 1, 1.0);
+  for (int m = 2; m <= n; m++)
+    fixed_probability[m] = 1.0 / (1.0 + (m - 1) * fixed_probability[m - 1]);
+
+  std::vector<int> remaining(n);
+  for (int i = 0; i < n; i++) remaining[i] = i;
+  std::vector<T> result(n);
+  absl::Status status;
+  while (!remaining.empty()) {
+    int m = remaining.size();
+    int x = remaining.back();
+    remaining.pop_back();
+    if (engine.RandDouble() < fixed_probability[m]) {
+      result[x] = min + x;
+      continue;
+    }
+    int index = engine.RandInt(m - 1, status);
+    int y = remaining[index];
+    remaining[index] = remaining.back();
+    remaining.pop_back();
+    result[x] = min + y;
+    result[y] = min + x;
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+  return result;
+}
+
 template <typename T>
   requires std::integral<T>
 absl::StatusOr<std::vector<T>> DistinctIntegers(RandomEngine& engine, T n,
@@ -228,15 +572,34 @@ absl::StatusOr<std::vector<T>> DistinctIntegers(RandomEngine& engine, T n,
   }
 
   if (2 * k > n) {
-    // If we are asking for a dense set, then we generate the whole search
-    // space, shuffle it and return the first k elements. This will allocate at
-    // most 2 times the required memory.
-    std::vector<T> all;
-    all.reserve(n);
-    for (int i = 0; i < n; i++) all.push_back(i + min);
-    MORIARTY_RETURN_IF_ERROR(Shuffle(engine, all));
-    all.resize(k);
-    return all;
+    // If we are asking for a dense set, then we do the first k steps of a
+    // Fisher-Yates shuffle on {0, 1, ... , n-1}. Positions [0, k) are stored in
+    // `result`, and only the positions at or after k that have been swapped are
+    // stored in `swapped`, so this uses O(k) memory (instead of O(n)).
+    std::vector<T> result;
+    result.reserve(k);
+    for (int i = 0; i < k; i++) result.push_back(i);
+    absl::flat_hash_map<T, T> swapped;
+    int64_t bounds[kShuffleChunkSize];
+    int64_t offsets[kShuffleChunkSize];
+    for (int start = 0; start < k; start += kShuffleChunkSize) {
+      int count = std::min<int>(kShuffleChunkSize, k - start);
+      for (int c = 0; c < count; c++) bounds[c] = n - (start + c);
+      MORIARTY_RETURN_IF_ERROR(engine.RandIntsBelow(
+          absl::MakeConstSpan(bounds, count), absl::MakeSpan(offsets, count)));
+      for (int c = 0; c < count; c++) {
+        int i = start + c;
+        T j = i + offsets[c];
+        if (j < k) {
+          std::swap(result[i], result[j]);
+          continue;
+        }
+        auto [it, inserted] = swapped.try_emplace(j, j);
+        std::swap(result[i], it->second);
+      }
+    }
+    for (T& value : result) value += min;
+    return result;
   }
 
   // On average, the sampling should take fewer than log(2) * n iterations
@@ -249,8 +612,10 @@ absl::StatusOr<std::vector<T>> DistinctIntegers(RandomEngine& engine, T n,
   std::vector<T> result;
   result.reserve(k);
 
+  absl::Status status;
   while (result.size() < k) {
-    MORIARTY_ASSIGN_OR_RETURN(int64_t offset, engine.RandInt(n));
+    int64_t offset = engine.RandInt(n, status);
+    MORIARTY_RETURN_IF_ERROR(status);
     auto [it, inserted] = sample.insert(offset);
     if (inserted) result.push_back(offset + min);
   }
@@ -258,6 +623,61 @@ absl::StatusOr<std::vector<T>> DistinctIntegers(RandomEngine& engine, T n,
   return result;
 }
 
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> SortedDistinctIntegers(RandomEngine& engine,
+                                                      T n, int k, T min) {
+  if (n < 0) {
+    return absl::InvalidArgumentError("n must be non-negative");
+  }
+  if (k < 0) {
+    return absl::InvalidArgumentError("k must be non-negative");
+  }
+  if (k > n) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Cannot generate $0 distinct numbers from a range of size $1", k, n));
+  }
+
+  // If we are asking for a dense set, then we choose the n - k offsets that are
+  // *not* in the result instead.
+  const bool complement = 2 * k > n;
+  const int64_t count = complement ? n - k : k;
+
+  // Draw offsets until `count` of them are distinct. Instead of hashing, the
+  // offsets are drawn in batches and deduplicated by sorting. Since each batch
+  // only draws as many offsets as are missing, this stops at the same point as
+  // drawing one at a time. So each subset is equally likely.
+  std::vector<int64_t> offsets;
+  offsets.reserve(count);
+  while (offsets.size() < count) {
+    const size_t sorted_size = offsets.size();
+    absl::Status status;
+    for (int64_t i = sorted_size; i < count; i++)
+      offsets.push_back(engine.RandInt(n, status));
+    MORIARTY_RETURN_IF_ERROR(status);
+    std::sort(offsets.begin() + sorted_size, offsets.end());
+    std::inplace_merge(offsets.begin(), offsets.begin() + sorted_size,
+                       offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+  }
+
+  std::vector<T> result;
+  result.reserve(k);
+  if (!complement) {
+    for (int64_t offset : offsets) result.push_back(offset + min);
+    return result;
+  }
+  auto next_excluded = offsets.begin();
+  for (int64_t offset = 0; offset < n; offset++) {
+    if (next_excluded != offsets.end() && *next_excluded == offset) {
+      next_excluded++;
+      continue;
+    }
+    result.push_back(offset + min);
+  }
+  return result;
+}
+
 template <typename T>
   requires std::integral<T>
 absl::StatusOr<std::vector<T>> RandomComposition(RandomEngine& engine, T n,
@@ -286,7 +706,7 @@ absl::StatusOr<std::vector<T>> RandomComposition(RandomEngine& engine, T n,
     // Set the required size aside, generate a partition, then put them back.
     MORIARTY_ASSIGN_OR_RETURN(
         std::vector<T> result,
-        RandomComposition(engine, n - min_bucket_size * k, k, 0));
+        RandomComposition<T>(engine, n - min_bucket_size * k, k, 0));
     for (T& val : result) val += min_bucket_size;
     return result;
   }
@@ -295,8 +715,7 @@ absl::StatusOr<std::vector<T>> RandomComposition(RandomEngine& engine, T n,
   // We are now placing (k-1) "barriers" amongst the n values, which is
   // equivalent to (n + (k-1)) choose (k-1).
   MORIARTY_ASSIGN_OR_RETURN(std::vector<T> barriers,
-                            DistinctIntegers(engine, n + (k - 1), k - 1));
-  std::sort(barriers.begin(), barriers.end());
+                            SortedDistinctIntegers(engine, n + (k - 1), k - 1));
 
   std::vector<T> result;
   result.reserve(k);
@@ -311,6 +730,79 @@ absl::StatusOr<std::vector<T>> RandomComposition(RandomEngine& engine, T n,
   return result;
 }
 
+template <typename T>
+  requires std::integral<T>
+absl::StatusOr<std::vector<T>> BoundedRandomComposition(RandomEngine& engine,
+                                                        T n, int k,
+                                                        T min_bucket_size,
+                                                        T max_bucket_size) {
+  if (k < 0) {
+    return absl::InvalidArgumentError("k must be non-negative");
+  }
+  if (min_bucket_size < 0 || max_bucket_size < min_bucket_size) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Invalid bucket sizes [$0, $1]", min_bucket_size, max_bucket_size));
+  }
+  const absl::int128 min_total = absl::int128(min_bucket_size) * k;
+  const absl::int128 max_total = absl::int128(max_bucket_size) * k;
+  if (n < min_total || n > max_total) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Impossible to put $0 entries into $1 buckets with sizes in [$2, $3]",
+        n, k, min_bucket_size, max_bucket_size));
+  }
+  if (k == 0) return std::vector<T>();
+
+  // Set the required size aside. Each bucket then gets [0, capacity] more
+  // entries. Compositions above half of the total capacity are generated as
+  // the room left in each bucket instead, so there is less excess to move.
+  const T capacity = max_bucket_size - min_bucket_size;
+  T remaining = static_cast<T>(n - min_total);
+  const bool complement = 2 * absl::int128(remaining) > max_total - min_total;
+  if (complement) remaining = static_cast<T>(max_total - n);
+
+  auto finish = [&](std::vector<T> result) {
+    for (T& val : result)
+      val = (complement ? capacity - val : val) + min_bucket_size;
+    return result;
+  };
+
+  // A few unbounded compositions, in case one of them already fits.
+  static constexpr int kUniformAttempts = 4;
+  std::vector<T> result;
+  for (int attempt = 0; attempt < kUniformAttempts; attempt++) {
+    MORIARTY_ASSIGN_OR_RETURN(result,
+                              RandomComposition(engine, remaining, k, T{0}));
+    if (std::all_of(result.begin(), result.end(),
+                    [&](T val) { return val <= capacity; })) {
+      return finish(std::move(result));
+    }
+  }
+
+  // Cut the buckets down to size, then add the excess back to buckets with
+  // room for it: first a random amount each, then whatever is left, starting
+  // from a random bucket.
+  T excess = 0;
+  for (T& val : result) {
+    if (val > capacity) {
+      excess += val - capacity;
+      val = capacity;
+    }
+  }
+  MORIARTY_ASSIGN_OR_RETURN(int start, engine.RandInt(k));
+  absl::Status status;
+  for (int pass = 0; pass < 2 && excess > 0; pass++) {
+    for (int j = 0; j < k && excess > 0; j++) {
+      T& val = result[(start + j) % k];
+      T add = std::min<T>(capacity - val, excess);
+      if (pass == 0 && add > 0) add = engine.RandInt(0, add, status);
+      val += add;
+      excess -= add;
+    }
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+  return finish(std::move(result));
+}
+
 }  // namespace moriarty_internal
 }  // namespace moriarty
 
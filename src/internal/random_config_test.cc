@@ -17,14 +17,26 @@
 #include <stdint.h>
 
 #include <concepts>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "src/internal/permutations.h"
 #include "src/internal/random_engine.h"
+#include "src/lazy_permutation.h"
 #include "src/testing/random_test_util.h"
+#include "src/util/test_status_macro/status_testutil.h"
 
 namespace moriarty_testing {
 namespace {
@@ -106,6 +118,18 @@ namespace moriarty {
 namespace moriarty_internal {
 namespace {
 
+using ::testing::AllOf;
+using ::testing::AnyOf;
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::Lt;
+using ::testing::Optional;
+using ::testing::SizeIs;
+using ::moriarty::StatusIs;
+
 TEST(RandomConfigTest, GetRandomEngineShouldReturnNullIfNoEngineSet) {
   RandomConfig config;
   EXPECT_EQ(config.GetRandomEngine(), nullptr);
@@ -119,6 +143,358 @@ TEST(RandomConfigTest, GetRandomEngineShouldReturnTheSetRandomEngine) {
   EXPECT_EQ(config.GetRandomEngine(), &engine);
 }
 
+TEST(RandomConfigTest, DenseDistinctIntegersShouldBeDistinct) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      DistinctIntegers<int64_t>(engine, 1500, 1000, 7));
+  EXPECT_THAT(values, Each(AllOf(Ge(7), Lt(1507))));
+  EXPECT_THAT(absl::flat_hash_set<int64_t>(values.begin(), values.end()),
+              SizeIs(1000));
+}
+
+TEST(RandomConfigTest, DenseDistinctIntegersShouldBeAllOrderings) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  absl::flat_hash_set<std::vector<int>> seen;
+  for (int i = 0; i < 1000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int> values,
+                                  DistinctIntegers(engine, 4, 3));
+    seen.insert(values);
+  }
+  EXPECT_THAT(seen, SizeIs(24));  // 4 * 3 * 2
+}
+
+TEST(RandomConfigTest, ShuffleShouldBeAPermutationForEachVersion) {
+  for (absl::string_view version : {kMersenneTwisterVersion,
+                                    kCounterBasedVersion}) {
+    RandomEngine engine({1, 2, 3}, version);
+    // More than one chunk of swap targets.
+    std::vector<int> values(3 * kShuffleChunkSize + 5);
+    absl::c_iota(values, 0);
+    MORIARTY_ASSERT_OK(Shuffle(engine, values));
+
+    std::vector<int> sorted = values;
+    absl::c_sort(sorted);
+    std::vector<int> expected(values.size());
+    absl::c_iota(expected, 0);
+    EXPECT_EQ(sorted, expected) << version;
+    EXPECT_NE(values, expected) << version;
+  }
+}
+
+TEST(RandomConfigTest, ShuffleShouldBeAllOrderingsForCounterBasedVersion) {
+  RandomEngine engine({1, 2, 3}, kCounterBasedVersion);
+  absl::flat_hash_set<std::vector<int>> seen;
+  for (int i = 0; i < 1000; i++) {
+    std::vector<int> values = {0, 1, 2, 3};
+    MORIARTY_ASSERT_OK(Shuffle(engine, values));
+    seen.insert(values);
+  }
+  EXPECT_THAT(seen, SizeIs(24));
+}
+
+TEST(RandomConfigTest, RandomPermutationShouldBeAllOrderingsForEachVersion) {
+  for (absl::string_view version : {kMersenneTwisterVersion,
+                                    kCounterBasedVersion}) {
+    RandomEngine engine({1, 2, 3}, version);
+    absl::flat_hash_set<std::vector<int>> seen;
+    for (int i = 0; i < 1000; i++) {
+      MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int> values,
+                                    RandomPermutation(engine, 4));
+      seen.insert(values);
+    }
+    EXPECT_THAT(seen, SizeIs(24)) << version;
+  }
+}
+
+// Returns the values as the `int64_t`s that the validators take.
+std::vector<int64_t> AsInt64s(const std::vector<int>& values) {
+  return std::vector<int64_t>(values.begin(), values.end());
+}
+
+TEST(RandomConfigTest, StructuredPermutationsShouldHaveTheirStructure) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (int n : {0, 2, 3, 10, 100'000}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<int64_t> cycle,
+        RandomCyclicPermutation<int64_t>(engine, n, 7));
+    EXPECT_THAT(CountPermutationCycles(cycle, 7),
+                Optional(Eq(n == 0 ? 0 : 1)));
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> derangement,
+                                  RandomDerangement<int64_t>(engine, n, -3));
+    EXPECT_TRUE(IsDerangement(derangement, -3));
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> involution,
+                                  RandomInvolution<int64_t>(engine, n, 1));
+    EXPECT_TRUE(IsInvolution(involution, 1));
+
+    for (int k : {1, n / 2, n}) {
+      if (k > n || (k == 0 && n > 0)) continue;
+      MORIARTY_ASSERT_OK_AND_ASSIGN(
+          std::vector<int64_t> cycles,
+          RandomPermutationWithCycles<int64_t>(engine, n, k, 0));
+      EXPECT_THAT(CountPermutationCycles(cycles), Optional(Eq(k)));
+    }
+  }
+}
+
+TEST(RandomConfigTest, StructuredPermutationsShouldBeAllOfTheirKind) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  absl::flat_hash_set<std::vector<int>> cycles, derangements, involutions,
+      two_cycles;
+  for (int i = 0; i < 2000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int> values,
+                                  RandomCyclicPermutation(engine, 4));
+    EXPECT_THAT(CountPermutationCycles(AsInt64s(values)), Optional(Eq(1)));
+    cycles.insert(values);
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(values, RandomDerangement(engine, 4));
+    EXPECT_TRUE(IsDerangement(AsInt64s(values)));
+    derangements.insert(values);
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(values, RandomInvolution(engine, 4));
+    EXPECT_TRUE(IsInvolution(AsInt64s(values)));
+    involutions.insert(values);
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(values,
+                                  RandomPermutationWithCycles(engine, 4, 2));
+    EXPECT_THAT(CountPermutationCycles(AsInt64s(values)), Optional(Eq(2)));
+    two_cycles.insert(values);
+  }
+  EXPECT_THAT(cycles, SizeIs(6));         // 3!
+  EXPECT_THAT(derangements, SizeIs(9));   // !4
+  EXPECT_THAT(involutions, SizeIs(10));   // 1 + 6 + 3
+  EXPECT_THAT(two_cycles, SizeIs(11));    // c(4, 2)
+}
+
+TEST(RandomConfigTest, StructuredPermutationsShouldRejectInvalidInput) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  EXPECT_THAT(RandomCyclicPermutation(engine, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomDerangement(engine, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomDerangement(engine, 1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomInvolution(engine, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomPermutationWithCycles(engine, 5, 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomPermutationWithCycles(engine, 5, 6),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomConfigTest, RandomLazyPermutationShouldDependOnTheEngine) {
+  RandomEngine engine1({1, 2, 3}, "v0.1");
+  RandomEngine engine2({1, 2, 3}, "v0.1");
+  RandomEngine engine3({4, 5, 6}, "v0.1");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(LazyPermutation a,
+                                RandomLazyPermutation(engine1, 1000));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(LazyPermutation b,
+                                RandomLazyPermutation(engine2, 1000));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(LazyPermutation c,
+                                RandomLazyPermutation(engine3, 1000));
+  int same_as_b = 0;
+  int same_as_c = 0;
+  for (int64_t i = 0; i < 1000; i++) {
+    same_as_b += a(i) == b(i);
+    same_as_c += a(i) == c(i);
+  }
+  EXPECT_EQ(same_as_b, 1000);
+  EXPECT_LT(same_as_c, 100);
+}
+
+TEST(RandomConfigTest, RandomLazyPermutationShouldRejectNegativeSizes) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  EXPECT_THAT(RandomLazyPermutation(engine, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomConfigTest, RandomWeightedElementsShouldFollowTheWeights) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  std::vector<char> letters = {'a', 'b', 'c', 'd'};
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<char> sample,
+      RandomWeightedElements(engine, letters, {1, 0, 3, 6}, 10000));
+  ASSERT_EQ(sample.size(), 10000);
+  EXPECT_EQ(absl::c_count(sample, 'b'), 0);
+  EXPECT_NEAR(absl::c_count(sample, 'a'), 1000, 200);
+  EXPECT_NEAR(absl::c_count(sample, 'c'), 3000, 300);
+  EXPECT_NEAR(absl::c_count(sample, 'd'), 6000, 300);
+}
+
+TEST(RandomConfigTest, RandomWeightedElementShouldMatchTheFirstOfElements) {
+  RandomEngine engine1({1, 2, 3}, "v0.1");
+  RandomEngine engine2({1, 2, 3}, "v0.1");
+  std::vector<int> values = {10, 20, 30};
+  std::vector<int64_t> weights = {5, 1, 7};
+  for (int i = 0; i < 100; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<int> one,
+        RandomWeightedElements(engine2, values, weights, 1));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        int value, RandomWeightedElement(engine1, values, weights));
+    EXPECT_EQ(value, one[0]);
+  }
+}
+
+TEST(RandomConfigTest, RandomWeightedElementsShouldRejectInvalidInput) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  std::vector<int> values = {1, 2, 3};
+  EXPECT_THAT(RandomWeightedElement(engine, values, {1, 2}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomWeightedElement(engine, values, {1, -1, 2}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomWeightedElement(engine, values, {0, 0, 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RandomWeightedElements(engine, values, {1, 1, 1}, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomConfigTest, ReservoirSampleShouldBeDistinctElementsOfTheRange) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  std::vector<int> values(10000);
+  absl::c_iota(values, 0);
+  for (int k : {0, 1, 5, 100, 10000}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<int> sample,
+        ReservoirSample(engine, values.begin(), values.end(), k));
+    ASSERT_THAT(sample, SizeIs(k));
+    EXPECT_THAT(sample, Each(AllOf(Ge(0), Lt(10000))));
+    EXPECT_EQ(absl::flat_hash_set<int>(sample.begin(), sample.end()).size(),
+              k);
+  }
+}
+
+TEST(RandomConfigTest, ReservoirSampleShouldPickEachElementEquallyOften) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  std::vector<int> values(100);
+  absl::c_iota(values, 0);
+  std::vector<int> count(100);
+  for (int i = 0; i < 2000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<int> sample,
+        ReservoirSample(engine, values.begin(), values.end(), 10));
+    for (int x : sample) count[x]++;
+  }
+  // Each element is expected to be picked 200 times.
+  EXPECT_THAT(count, Each(AllOf(Ge(130), Le(270))));
+}
+
+TEST(RandomConfigTest, ReservoirSampleShouldReadInputIteratorsOnce) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  std::istringstream input("5 3 8 1 9 2 7");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int> sample,
+      ReservoirSample(engine, std::istream_iterator<int>(input),
+                      std::istream_iterator<int>(), 3));
+  EXPECT_THAT(sample, SizeIs(3));
+  EXPECT_THAT(sample, Each(AnyOf(5, 3, 8, 1, 9, 2, 7)));
+}
+
+TEST(RandomConfigTest, ReservoirSampleShouldOnlyDependOnTheSeed) {
+  std::vector<int> values(1000);
+  absl::c_iota(values, 0);
+  // The counter-based engine gives the same integers on every platform, so
+  // the sample for a fixed seed is pinned.
+  RandomEngine engine({1, 2, 3}, kCounterBasedVersion);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int> sample,
+      ReservoirSample(engine, values.begin(), values.end(), 8));
+  EXPECT_THAT(sample, ElementsAre(979, 481, 390, 442, 905, 407, 457, 742));
+}
+
+TEST(RandomConfigTest, ReservoirSampleShouldRejectInvalidInput) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  std::vector<int> values = {1, 2, 3};
+  EXPECT_THAT(ReservoirSample(engine, values.begin(), values.end(), -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReservoirSample(engine, values.begin(), values.end(), 4),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomConfigTest, SortedDistinctIntegersShouldBeSortedAndDistinct) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (auto [n, k] : std::vector<std::pair<int64_t, int>>{
+           {0, 0}, {10, 0}, {10, 3}, {10, 7}, {10, 10}, {1'000'000'000, 500}}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<int64_t> values,
+        SortedDistinctIntegers<int64_t>(engine, n, k, -5));
+    EXPECT_THAT(values, SizeIs(k));
+    EXPECT_TRUE(absl::c_adjacent_find(values, std::greater_equal<>()) ==
+                values.end());
+    EXPECT_THAT(values, Each(AllOf(Ge(-5), Lt(n - 5))));
+  }
+}
+
+TEST(RandomConfigTest, SortedDistinctIntegersShouldBeAllSubsets) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (int k : {2, 4}) {
+    absl::flat_hash_set<std::vector<int>> seen;
+    for (int i = 0; i < 1000; i++) {
+      MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int> values,
+                                    SortedDistinctIntegers(engine, 6, k));
+      seen.insert(values);
+    }
+    EXPECT_THAT(seen, SizeIs(15));  // 6 choose 2 == 6 choose 4
+  }
+}
+
+TEST(RandomConfigTest, SortedDistinctIntegersShouldRejectInvalidInput) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  EXPECT_THAT(SortedDistinctIntegers(engine, -1, 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(SortedDistinctIntegers(engine, 5, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(SortedDistinctIntegers(engine, 5, 6),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomConfigTest, BoundedRandomCompositionShouldRespectTheBounds) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (auto [n, k, lo, hi] : std::vector<std::tuple<int64_t, int, int64_t,
+                                                    int64_t>>{
+           {0, 0, 0, 0},
+           {10, 10, 1, 1},
+           {100, 10, 0, 1000},
+           {100, 10, 9, 11},
+           {1'000'000, 100'000, 1, 20},
+           {1'999'999, 100'000, 1, 20},
+           {50, 100'000, 0, 1},
+           {1'000'000'000'000, 1000, 0, 1'000'000'000}}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<int64_t> values,
+        BoundedRandomComposition<int64_t>(engine, n, k, lo, hi));
+    EXPECT_THAT(values, SizeIs(k));
+    EXPECT_THAT(values, Each(AllOf(Ge(lo), Le(hi))));
+    EXPECT_EQ(absl::c_accumulate(values, int64_t{0}), n);
+  }
+}
+
+TEST(RandomConfigTest, BoundedRandomCompositionShouldBeAllCompositions) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  absl::flat_hash_set<std::vector<int>> seen;
+  for (int i = 0; i < 1000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int> values,
+                                  BoundedRandomComposition(engine, 6, 3, 1, 3));
+    seen.insert(values);
+  }
+  // (1, 2, 3) in any order, (2, 2, 2), and (1, 1, 4) is not allowed.
+  EXPECT_THAT(seen, SizeIs(7));
+}
+
+TEST(RandomConfigTest, BoundedRandomCompositionShouldRejectInvalidInput) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  EXPECT_THAT(BoundedRandomComposition(engine, 5, -1, 0, 5),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BoundedRandomComposition(engine, 5, 2, 3, 2),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BoundedRandomComposition(engine, 5, 2, 3, 5),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BoundedRandomComposition(engine, 11, 2, 0, 5),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 /*
 TEST(RandomConfigTest, AllFunctionsFailWithoutRandomEngineSet) {
   RandomConfig config;
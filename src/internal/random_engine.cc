@@ -14,13 +14,22 @@
 
 #include "src/internal/random_engine.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <limits>
+#include <optional>
 #include <random>
 #include <string>
+#include <vector>
 
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/types/span.h"
@@ -28,9 +37,45 @@
 namespace moriarty {
 namespace moriarty_internal {
 
+namespace {
+
+// The golden ratio, used as the step between consecutive counter values.
+constexpr uint64_t kGoldenGamma = 0x9e3779b97f4a7c15ULL;
+
+// The SplitMix64 finalizer (Stafford's "Mix13"). A bijection on 64-bit
+// integers which thoroughly mixes the bits of `z`.
+uint64_t Mix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// `RandIntsBelow()` groups bounds while their product is at most this, so each
+// group is rejected (and redrawn) with probability below 2^-8.
+constexpr uint64_t kMaxBatchedProduct = uint64_t{1} << 56;
+
+// Sets `out[i]` to the i-th digit of `random * product(bounds) / 2^64` in the
+// mixed radix given by `bounds`, and returns the bits that are left over.
+uint64_t SliceBoundedInts(uint64_t random,
+                          absl::Span<const int64_t> exclusive_upper_bounds,
+                          absl::Span<int64_t> out) {
+  for (size_t i = 0; i < out.size(); i++) {
+    absl::uint128 product = absl::uint128(random) *
+                            static_cast<uint64_t>(exclusive_upper_bounds[i]);
+    out[i] = static_cast<int64_t>(absl::Uint128High64(product));
+    random = absl::Uint128Low64(product);
+  }
+  return random;
+}
+
+}  // namespace
+
 RandomEngine::RandomEngine(absl::Span<const int64_t> seed,
                            absl::string_view moriarty_version_num)
-    : moriarty_version_num_(moriarty_version_num) {
+    : moriarty_version_num_(moriarty_version_num),
+      engine_type_(moriarty_version_num == kCounterBasedVersion
+                       ? EngineType::kCounterBased
+                       : EngineType::kMersenneTwister) {
   InitRandomEngine(seed);
 }
 
@@ -56,11 +101,258 @@ absl::StatusOr<int64_t> RandomEngine::RandInt(int64_t inclusive_lower_bound,
                           static_cast<uint64_t>(inclusive_lower_bound));
 }
 
+int64_t RandomEngine::RandInt(int64_t exclusive_upper_bound,
+                              absl::Status& status) {
+  if (exclusive_upper_bound <= 0) {
+    if (status.ok()) status = RandInt(exclusive_upper_bound).status();
+    return 0;
+  }
+  return RandIntInclusive(exclusive_upper_bound - 1);
+}
+
+int64_t RandomEngine::RandInt(int64_t inclusive_lower_bound,
+                              int64_t inclusive_upper_bound,
+                              absl::Status& status) {
+  if (inclusive_lower_bound > inclusive_upper_bound) {
+    if (status.ok()) {
+      status = RandInt(inclusive_lower_bound, inclusive_upper_bound).status();
+    }
+    return 0;
+  }
+  return inclusive_lower_bound +
+         RandIntInclusive(static_cast<uint64_t>(inclusive_upper_bound) -
+                          static_cast<uint64_t>(inclusive_lower_bound));
+}
+
+absl::Status RandomEngine::RandInts(int64_t inclusive_lower_bound,
+                                    int64_t inclusive_upper_bound,
+                                    absl::Span<int64_t> out) {
+  if (inclusive_lower_bound > inclusive_upper_bound) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("RandInts(x, y, out) called with x > y ($0, $1)",
+                         inclusive_lower_bound, inclusive_upper_bound));
+  }
+
+  // This must match `RandIntInclusive()` exactly so that the generated values
+  // do not depend on whether they were requested one at a time or in bulk.
+  const uint64_t inclusive_upper =
+      static_cast<uint64_t>(inclusive_upper_bound) -
+      static_cast<uint64_t>(inclusive_lower_bound);
+  const uint64_t range = inclusive_upper + 1;
+  if ((inclusive_upper & range) == 0) {
+    for (int64_t& val : out)
+      val = inclusive_lower_bound + (RandUInt64() & inclusive_upper);
+    return absl::OkStatus();
+  }
+
+  const uint64_t scale = std::numeric_limits<uint64_t>::max() / range;
+  const uint64_t limit = range * scale;
+  for (int64_t& val : out) {
+    uint64_t answer;
+    do {
+      answer = RandUInt64();
+    } while (answer >= limit);
+    val = inclusive_lower_bound + answer / scale;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RandomEngine::RandIndices(int exclusive_upper_bound,
+                                       absl::Span<uint8_t> out) {
+  if (exclusive_upper_bound <= 0 || exclusive_upper_bound > 256) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "RandIndices(x, out) called with x not in [1, 256] ($0)",
+        exclusive_upper_bound));
+  }
+
+  const uint64_t range = exclusive_upper_bound;
+  const uint64_t inclusive_upper = range - 1;
+  if ((inclusive_upper & range) == 0) {
+    // The Mersenne Twister must match `RandIntInclusive()` to keep old seeds
+    // reproducible, so only the counter-based engine slices its integers.
+    if (engine_type_ == EngineType::kCounterBased) {
+      const int bits = std::countr_zero(range);
+      if (bits == 0) {
+        std::fill(out.begin(), out.end(), 0);
+        return absl::OkStatus();
+      }
+      const int values_per_integer = 64 / bits;
+      for (size_t i = 0; i < out.size();) {
+        uint64_t random = RandUInt64();
+        for (int j = 0; j < values_per_integer && i < out.size(); j++, i++) {
+          out[i] = random & inclusive_upper;
+          random >>= bits;
+        }
+      }
+      return absl::OkStatus();
+    }
+
+    for (uint8_t& val : out) val = RandUInt64() & inclusive_upper;
+    return absl::OkStatus();
+  }
+
+  // This must match `RandIntInclusive()` exactly.
+  const uint64_t scale = std::numeric_limits<uint64_t>::max() / range;
+  const uint64_t limit = range * scale;
+  for (uint8_t& val : out) {
+    uint64_t answer;
+    do {
+      answer = RandUInt64();
+    } while (answer >= limit);
+    val = answer / scale;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RandomEngine::RandIntsBelow(
+    absl::Span<const int64_t> exclusive_upper_bounds, absl::Span<int64_t> out) {
+  if (exclusive_upper_bounds.size() != out.size()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "RandIntsBelow(bounds, out) called with $0 bounds for $1 values",
+        exclusive_upper_bounds.size(), out.size()));
+  }
+  for (int64_t bound : exclusive_upper_bounds) {
+    if (bound <= 0) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "RandIntsBelow(bounds, out) called with a bound <= 0 ($0)", bound));
+    }
+  }
+
+  // The Mersenne Twister must match `RandIntInclusive()` to keep old seeds
+  // reproducible, so only the counter-based engine batches its integers.
+  if (engine_type_ != EngineType::kCounterBased) {
+    for (size_t i = 0; i < out.size(); i++)
+      out[i] = RandIntInclusive(exclusive_upper_bounds[i] - 1);
+    return absl::OkStatus();
+  }
+
+  for (size_t start = 0; start < out.size();) {
+    uint64_t product = exclusive_upper_bounds[start];
+    size_t end = start + 1;
+    while (end < out.size() &&
+           product <= kMaxBatchedProduct / exclusive_upper_bounds[end]) {
+      product *= exclusive_upper_bounds[end++];
+    }
+    absl::Span<const int64_t> bounds =
+        exclusive_upper_bounds.subspan(start, end - start);
+    absl::Span<int64_t> values = out.subspan(start, end - start);
+
+    // Lemire's nearly divisionless method with the whole group as the range:
+    // only leftovers below 2^64 mod `product` are biased.
+    uint64_t leftover = SliceBoundedInts(RandUInt64(), bounds, values);
+    if (leftover < product) {
+      const uint64_t threshold = -product % product;
+      while (leftover < threshold)
+        leftover = SliceBoundedInts(RandUInt64(), bounds, values);
+    }
+    start = end;
+  }
+  return absl::OkStatus();
+}
+
+RandomEngine RandomEngine::Split() {
+  RandomEngine split = *this;
+  if (engine_type_ == EngineType::kCounterBased) {
+    // Mixing once more ensures the new key is not simply a value that was
+    // (or will be) returned by this engine.
+    split.key_ = Mix64(RandUInt64() ^ kGoldenGamma);
+    split.counter_ = 0;
+    return split;
+  }
+
+  std::vector<int64_t> seed(4);
+  for (int64_t& s : seed) s = static_cast<int64_t>(RandUInt64());
+  split.InitRandomEngine(seed);
+  return split;
+}
+
+void RandomEngine::Jump(uint64_t n) {
+  if (engine_type_ == EngineType::kCounterBased) {
+    counter_ += n;
+    return;
+  }
+  re_->discard(n);
+  draws_ += n;
+}
+
+// The state is "<version>;<a>;<b>". For the counter-based engine, `a` is the
+// key and `b` is the counter. For std::mt19937_64, `a` is the number of
+// integers generated and `b` is the comma-separated seed.
+std::string RandomEngine::SaveState() const {
+  if (engine_type_ == EngineType::kCounterBased)
+    return absl::StrCat(moriarty_version_num_, ";", key_, ";", counter_);
+  return absl::StrCat(moriarty_version_num_, ";", draws_, ";",
+                      absl::StrJoin(seed_, ","));
+}
+
+absl::Status RandomEngine::LoadState(absl::string_view state) {
+  std::vector<absl::string_view> parts = absl::StrSplit(state, ';');
+  if (parts.size() != 3) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("malformed RandomEngine state: '$0'", state));
+  }
+  if (parts[0] != moriarty_version_num_) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "RandomEngine state was saved with version '$0', but this engine uses "
+        "version '$1'",
+        parts[0], moriarty_version_num_));
+  }
+
+  uint64_t a;
+  if (!absl::SimpleAtoi(parts[1], &a)) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("malformed RandomEngine state: '$0'", state));
+  }
+
+  if (engine_type_ == EngineType::kCounterBased) {
+    uint64_t counter;
+    if (!absl::SimpleAtoi(parts[2], &counter)) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("malformed RandomEngine state: '$0'", state));
+    }
+    key_ = a;
+    counter_ = counter;
+    return absl::OkStatus();
+  }
+
+  std::vector<int64_t> seed;
+  if (!parts[2].empty()) {
+    for (absl::string_view s : absl::StrSplit(parts[2], ',')) {
+      if (!absl::SimpleAtoi(s, &seed.emplace_back())) {
+        return absl::InvalidArgumentError(
+            absl::Substitute("malformed RandomEngine state: '$0'", state));
+      }
+    }
+  }
+  InitRandomEngine(seed);
+  Jump(a);
+  return absl::OkStatus();
+}
+
 void RandomEngine::InitRandomEngine(absl::Span<const int64_t> seed,
                                     int64_t initial_discards) {
+  if (engine_type_ == EngineType::kCounterBased) {
+    // Absorb each element of the seed into the key. Every step is a bijection
+    // on the key, so seeds that differ in a single element give different
+    // keys. No warm up is needed since every output is fully mixed.
+    key_ = 0;
+    for (int64_t s : seed)
+      key_ = Mix64(key_ + kGoldenGamma) ^ static_cast<uint64_t>(s);
+    key_ = Mix64(key_ + seed.size());
+    counter_ = 0;
+    return;
+  }
+
   std::seed_seq sseq(std::begin(seed), std::end(seed));
-  re_.seed(sseq);
-  re_.discard(initial_discards);
+  re_.emplace(sseq);
+  re_->discard(initial_discards);
+  seed_.assign(seed.begin(), seed.end());
+  draws_ = 0;
+}
+
+// If this changes, `RandInts()` must change as well.
+double RandomEngine::RandDouble() {
+  return static_cast<double>(RandUInt64() >> 11) * 0x1.0p-53;
 }
 
 uint64_t RandomEngine::RandIntInclusive(uint64_t inclusive_upper_bound) {
@@ -98,7 +390,13 @@ uint64_t RandomEngine::RandIntInclusive(uint64_t inclusive_upper_bound) {
   return answer / scale;
 }
 
-uint64_t RandomEngine::RandUInt64() { return re_(); }
+uint64_t RandomEngine::RandUInt64() {
+  if (engine_type_ == EngineType::kCounterBased) {
+    return Mix64(key_ + (++counter_) * kGoldenGamma);
+  }
+  draws_++;
+  return (*re_)();
+}
 
 }  // namespace moriarty_internal
 }  // namespace moriarty
@@ -37,14 +37,27 @@
 // However, note that the internal state of std::mt19937_64 is
 // implementation-dependent, so do not use `RandomEngine() << s` or
 // `RandomEngine() >> s` in hopes of saving the internal state for later. We
-// provide `SaveState()` and `LoadState(state)` to re-load the state. Note that
-// loading the state requires us to call the random generator many, many
-// times, so it is not necessarily fast.
+// provide `SaveState()` and `LoadState(state)` to re-load the state. For
+// std::mt19937_64, loading the state requires us to call the random generator
+// many, many times, so it is not necessarily fast. For the counter-based
+// engine, both are O(1).
+//
+// The underlying engine is chosen by `moriarty_version_num`:
+//
+//  * `kMersenneTwisterVersion` ("v0.1") uses std::mt19937_64 as described
+//    above. This is the default for all unknown versions, so old seeds remain
+//    reproducible.
+//  * `kCounterBasedVersion` ("v0.2") uses a counter-based SplitMix64 engine.
+//    Its state is two 64-bit integers, it does not need to be warmed up, and
+//    both `Split()` and `Jump()` are O(1).
 
 #include <cstdint>
+#include <optional>
 #include <random>
 #include <string>
+#include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -52,12 +65,17 @@
 namespace moriarty {
 namespace moriarty_internal {
 
+// Versions understood by `RandomEngine`. See the comment at the top of this
+// file.
+inline constexpr absl::string_view kMersenneTwisterVersion = "v0.1";
+inline constexpr absl::string_view kCounterBasedVersion = "v0.2";
+
 class RandomEngine {
  public:
   // Constructors. Note that this constructor contains abnormal parameters.
   //
-  // `moriarty_version_num` will be used to ensure backwards compatibility. At
-  // the moment, this string is ignored.
+  // `moriarty_version_num` will be used to ensure backwards compatibility. It
+  // selects the underlying engine. Unknown versions use std::mt19937_64.
   // TODO(b/182810006): Enforce a specific version_num for first launch.
   //
   // TODO(b/182810006): Our random seeds may be fixed length eventually.
@@ -80,11 +98,122 @@ class RandomEngine {
   absl::StatusOr<int64_t> RandInt(int64_t inclusive_lower_bound,
                                   int64_t inclusive_upper_bound);
 
+  // RandInt()
+  //
+  // Same as the versions above, but intended for hot loops. Instead of
+  // returning an `absl::StatusOr`, errors are reported in `status`. The first
+  // error is kept: if `status` is not ok, it is not overwritten. So a loop may
+  // check `status` once at the end. On error, returns 0 and does not advance
+  // the engine.
+  int64_t RandInt(int64_t exclusive_upper_bound, absl::Status& status);
+  int64_t RandInt(int64_t inclusive_lower_bound, int64_t inclusive_upper_bound,
+                  absl::Status& status);
+
+  // RandInts()
+  //
+  // Fills `out` with uniformly random integers in the range:
+  // [inclusive_lower_bound, inclusive_upper_bound].
+  //
+  // The values (and the state of the engine afterwards) are identical to
+  // calling `RandInt(inclusive_lower_bound, inclusive_upper_bound)` once for
+  // each element of `out`, but the bounds are only checked and processed once.
+  absl::Status RandInts(int64_t inclusive_lower_bound,
+                        int64_t inclusive_upper_bound, absl::Span<int64_t> out);
+
+  // RandIndices()
+  //
+  // Fills `out` with uniformly random integers in the range:
+  // [0, exclusive_upper_bound). Intended for picking many elements from a
+  // small container (e.g., characters from an alphabet).
+  //
+  // For the counter-based engine, if `exclusive_upper_bound` is a power of
+  // two, several values are sliced out of each random 64-bit integer (e.g., 10
+  // values per integer for a bound of 64). Otherwise, the values (and the
+  // state of the engine afterwards) are identical to calling
+  // `RandInt(exclusive_upper_bound)` once for each element of `out`.
+  //
+  // Returns kInvalidArgument unless 0 < exclusive_upper_bound <= 256.
+  absl::Status RandIndices(int exclusive_upper_bound, absl::Span<uint8_t> out);
+
+  // RandIntsBelow()
+  //
+  // Sets each `out[i]` to a uniformly random integer in the range:
+  // [0, exclusive_upper_bounds[i]). Intended for many small, varying bounds
+  // (e.g., the swap targets of a Fisher-Yates shuffle).
+  //
+  // For the counter-based engine, consecutive bounds are grouped while their
+  // product is at most 2^56, and each group is sliced out of one random 64-bit
+  // integer by repeated multiplication (as in batched shuffling by
+  // Brackett-Rozinsky and Lemire), drawing a new integer for the whole group
+  // if it would be biased. Otherwise, the values (and the state of the engine
+  // afterwards) are identical to calling `RandInt(exclusive_upper_bounds[i])`
+  // once for each element of `out`.
+  //
+  // Returns kInvalidArgument if the spans have different sizes or any bound is
+  // non-positive.
+  absl::Status RandIntsBelow(absl::Span<const int64_t> exclusive_upper_bounds,
+                             absl::Span<int64_t> out);
+
+  // RandDouble()
+  //
+  // Generates a uniformly random double in the range [0, 1). The value is
+  // built from the top 53 bits of one random 64-bit integer, so it is exact and
+  // does not depend on the platform.
+  double RandDouble();
+
+  // Split()
+  //
+  // Returns a new RandomEngine whose stream is independent from this one. The
+  // returned engine uses the same version as this one. This advances this
+  // engine as if one random number was generated, so calling `Split()` several
+  // times gives several different engines.
+  //
+  // O(1) for the counter-based engine. For std::mt19937_64, a new engine must
+  // be seeded and warmed up.
+  RandomEngine Split();
+
+  // Jump()
+  //
+  // Advances this engine as if `n` random 64-bit integers were generated.
+  // Note that `RandInt()` may consume more than one random 64-bit integer.
+  //
+  // O(1) for the counter-based engine. O(n) for std::mt19937_64.
+  void Jump(uint64_t n);
+
+  // IsCounterBased()
+  //
+  // Returns true if this engine uses the counter-based engine (see
+  // `kCounterBasedVersion`), so `Split()` and `Jump()` are O(1).
+  bool IsCounterBased() const {
+    return engine_type_ == EngineType::kCounterBased;
+  }
+
+  // SaveState()
+  //
+  // Returns a snapshot of the state of this engine. The snapshot is a
+  // printable string that does not depend on the platform or compiler, so it
+  // may be stored and loaded elsewhere with `LoadState()`.
+  //
+  // O(1) for the counter-based engine. For std::mt19937_64, the snapshot
+  // contains the seed and the number of random integers generated since.
+  std::string SaveState() const;
+
+  // LoadState()
+  //
+  // Restores the state returned by `SaveState()`. Afterwards, this engine
+  // produces the same stream as the engine that was saved.
+  //
+  // Returns kInvalidArgument if `state` is malformed or was saved by an
+  // engine with a different version. O(1) for the counter-based engine.
+  // O(n) for std::mt19937_64, where n is the number of random integers that
+  // had been generated when `state` was saved.
+  absl::Status LoadState(absl::string_view state);
+
  private:
   // InitRandomEngine()
   //
   // Sets the internal state of the random engine appropriately. Separate from
-  // the constructor so that we can later add SaveState and LoadState.
+  // the constructor so that `Split()` and `LoadState()` can reuse it.
   void InitRandomEngine(
       absl::Span<const int64_t> seed,
       int64_t initial_discards = kInitialDiscardsFromRandomEngine);
@@ -100,13 +229,28 @@ class RandomEngine {
   // Generates a random integer in the range [0, 2^64).
   uint64_t RandUInt64();
 
+  enum class EngineType { kMersenneTwister, kCounterBased };
+
   // The random engine needs to be "warmed up" before producing truly random
   // values that are independent (in some sense) from the seeds passed in. This
   // acts as the "warm up". This fully clears Mersenne Twister's internal state
   // once and a bit.
   static constexpr int64_t kInitialDiscardsFromRandomEngine = 1024;
   const std::string moriarty_version_num_;
-  std::mt19937_64 re_;
+  EngineType engine_type_;
+
+  // Only used if `engine_type_ == kMersenneTwister`. `seed_` and `draws_`
+  // (the number of integers generated since seeding) are only needed for
+  // `SaveState()`. `re_` is empty for the counter-based engine, so creating
+  // one does not seed a std::mt19937_64.
+  std::optional<std::mt19937_64> re_;
+  std::vector<int64_t> seed_;
+  uint64_t draws_ = 0;
+
+  // Only used if `engine_type_ == kCounterBased`. The i-th random number in
+  // the stream only depends on `key_` and `i`.
+  uint64_t key_ = 0;
+  uint64_t counter_ = 0;
 };
 
 }  // namespace moriarty_internal
@@ -16,12 +16,16 @@
 
 #include <cstdint>
 #include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "src/util/status_macro/status_macros.h"
 #include "src/util/test_status_macro/status_testutil.h"
@@ -30,6 +34,9 @@ namespace moriarty {
 namespace moriarty_internal {
 namespace {
 
+using ::testing::Each;
+using ::testing::HasSubstr;
+using ::testing::Lt;
 using ::moriarty::IsOk;
 using ::moriarty::StatusIs;
 
@@ -126,6 +133,378 @@ TEST(RandomEngineTest, SameSeedsProduceTheSameResults) {
   EXPECT_EQ(values1, values2);
 }
 
+TEST(RandomEngineTest, CounterBasedRandIntShouldReturnValue) {
+  RandomEngine random({}, kCounterBasedVersion);
+
+  EXPECT_THAT(random.RandInt(10), IsOk());
+  EXPECT_THAT(random.RandInt(5, 20), IsOk());
+  EXPECT_THAT(random.RandInt(std::numeric_limits<int64_t>::min(),
+                             std::numeric_limits<int64_t>::max()),
+              IsOk());
+  EXPECT_THAT(random.RandInt(0), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomEngineTest, CounterBasedShouldProduceReproducibleResults) {
+  RandomEngine random({1, 117, 1337}, kCounterBasedVersion);
+
+  // Same as above. The counter-based engine must be identical everywhere.
+  int64_t hash = 0;
+  for (int i = 0; i < 5000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(int64_t val,
+                                  random.RandInt((1LL << 60) - 1 + i));
+    hash = (hash << 5) ^ val;
+  }
+  for (int i = 0; i < 5000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        int64_t val, random.RandInt(-(1LL << 60) + 1, (1LL << 60) + i));
+    hash = (hash << 5) ^ val;
+  }
+
+  EXPECT_EQ(hash, -7495755727327244314LL);
+}
+
+TEST(RandomEngineTest, CounterBasedSeedsShouldBeDeterministicAndDistinct) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values1,
+      GetNRandomNumbersUnderK(RandomEngine({1, 2, 3}, kCounterBasedVersion),
+                              10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values2,
+      GetNRandomNumbersUnderK(RandomEngine({2, 3, 5}, kCounterBasedVersion),
+                              10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values3,
+      GetNRandomNumbersUnderK(RandomEngine({1, 2, 3}, kCounterBasedVersion),
+                              10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> mersenne_values,
+      GetNRandomNumbersUnderK(RandomEngine({1, 2, 3}, kMersenneTwisterVersion),
+                              10, 123456));
+
+  EXPECT_NE(values1, values2);
+  EXPECT_EQ(values1, values3);
+  EXPECT_NE(values1, mersenne_values);
+}
+
+TEST(RandomEngineTest, UnknownVersionsShouldUseMersenneTwister) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values1,
+      GetNRandomNumbersUnderK(RandomEngine({1, 2, 3}, "unknown"), 10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values2,
+      GetNRandomNumbersUnderK(RandomEngine({1, 2, 3}, kMersenneTwisterVersion),
+                              10, 123456));
+
+  EXPECT_EQ(values1, values2);
+}
+
+TEST(RandomEngineTest, RandIntsWithInvalidArgumentsShouldThrowStatusError) {
+  RandomEngine random({}, "v0.1");
+  std::vector<int64_t> values(3);
+
+  EXPECT_THAT(random.RandInts(0, -1, absl::MakeSpan(values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(random.RandInts(std::numeric_limits<int64_t>::max(),
+                              std::numeric_limits<int64_t>::min(),
+                              absl::MakeSpan(values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+class RandomEngineVersionTest
+    : public ::testing::TestWithParam<absl::string_view> {};
+
+TEST_P(RandomEngineVersionTest, JumpShouldSkipValues) {
+  RandomEngine skipped({1, 2, 3}, GetParam());
+  RandomEngine jumped({1, 2, 3}, GetParam());
+
+  // Power of two ranges consume exactly one random 64-bit integer.
+  for (int i = 0; i < 17; i++) ASSERT_THAT(skipped.RandInt(1LL << 40), IsOk());
+  jumped.Jump(17);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> skipped_values,
+      GetNRandomNumbersUnderK(skipped, 10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> jumped_values,
+                                GetNRandomNumbersUnderK(jumped, 10, 123456));
+  EXPECT_EQ(skipped_values, jumped_values);
+}
+
+TEST_P(RandomEngineVersionTest, SplitShouldGiveDifferentStreams) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  RandomEngine split1 = random.Split();
+  RandomEngine split2 = random.Split();
+
+  // Each has a (1/123456)^10 chance of being equal.
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values,
+                                GetNRandomNumbersUnderK(random, 10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values1,
+                                GetNRandomNumbersUnderK(split1, 10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values2,
+                                GetNRandomNumbersUnderK(split2, 10, 123456));
+  EXPECT_NE(values, values1);
+  EXPECT_NE(values, values2);
+  EXPECT_NE(values1, values2);
+}
+
+TEST_P(RandomEngineVersionTest, SplitShouldBeReproducible) {
+  RandomEngine random1({1, 2, 3}, GetParam());
+  RandomEngine random2({1, 2, 3}, GetParam());
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values1,
+      GetNRandomNumbersUnderK(random1.Split(), 10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values2,
+      GetNRandomNumbersUnderK(random2.Split(), 10, 123456));
+  EXPECT_EQ(values1, values2);
+}
+
+TEST_P(RandomEngineVersionTest, RandIntsShouldMatchRepeatedRandInt) {
+  const std::vector<std::pair<int64_t, int64_t>> ranges = {
+      {0, 0},
+      {1, 10},
+      {-5, 5},
+      {0, (1LL << 40) - 1},  // Power of two.
+      {-(1LL << 60) + 1, (1LL << 60) + 3},
+      {std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()},
+  };
+
+  for (const auto& [lo, hi] : ranges) {
+    RandomEngine one_at_a_time({1, 117, 1337}, GetParam());
+    RandomEngine in_bulk({1, 117, 1337}, GetParam());
+
+    std::vector<int64_t> expected(1000);
+    for (int64_t& val : expected) {
+      MORIARTY_ASSERT_OK_AND_ASSIGN(val, one_at_a_time.RandInt(lo, hi));
+    }
+    std::vector<int64_t> values(1000);
+    MORIARTY_ASSERT_OK(in_bulk.RandInts(lo, hi, absl::MakeSpan(values)));
+    EXPECT_EQ(values, expected);
+
+    // Both engines should be in the same state afterwards.
+    EXPECT_EQ(in_bulk.RandInt(lo, hi), one_at_a_time.RandInt(lo, hi));
+  }
+}
+
+TEST_P(RandomEngineVersionTest, RandIntWithStatusShouldMatchStatusOrRandInt) {
+  RandomEngine with_status_or({1, 117, 1337}, GetParam());
+  RandomEngine with_status({1, 117, 1337}, GetParam());
+
+  absl::Status status;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(with_status.RandInt(-5, 5, status),
+              *with_status_or.RandInt(-5, 5));
+    EXPECT_EQ(with_status.RandInt(123456, status),
+              *with_status_or.RandInt(123456));
+  }
+  MORIARTY_EXPECT_OK(status);
+}
+
+TEST_P(RandomEngineVersionTest, RandIntWithStatusShouldKeepTheFirstError) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  RandomEngine untouched({1, 2, 3}, GetParam());
+
+  absl::Status status;
+  EXPECT_EQ(random.RandInt(0, status), 0);
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kInvalidArgument,
+                               HasSubstr("RandInt(x) called with x <= 0")));
+  EXPECT_EQ(random.RandInt(5, 4, status), 0);
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kInvalidArgument,
+                               HasSubstr("RandInt(x) called with x <= 0")));
+
+  // Errors do not advance the engine.
+  EXPECT_EQ(random.RandInt(1, 10), untouched.RandInt(1, 10));
+}
+
+TEST_P(RandomEngineVersionTest, RandIntsWithEmptySpanShouldDoNothing) {
+  RandomEngine random1({1, 2, 3}, GetParam());
+  RandomEngine random2({1, 2, 3}, GetParam());
+
+  MORIARTY_ASSERT_OK(random1.RandInts(1, 10, absl::Span<int64_t>()));
+  EXPECT_EQ(random1.RandInt(1, 10), random2.RandInt(1, 10));
+}
+
+TEST_P(RandomEngineVersionTest, RandIndicesShouldBeInRangeAndCoverIt) {
+  for (int bound : {1, 2, 3, 26, 64, 100, 128, 256}) {
+    RandomEngine random({1, 2, 3}, GetParam());
+    std::vector<uint8_t> values(10000);
+    MORIARTY_ASSERT_OK(random.RandIndices(bound, absl::MakeSpan(values)));
+
+    absl::flat_hash_set<int> seen(values.begin(), values.end());
+    EXPECT_EQ(seen.size(), bound);
+    EXPECT_THAT(values, Each(Lt(bound)));
+  }
+}
+
+TEST_P(RandomEngineVersionTest, RandIndicesWithInvalidBoundShouldFail) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  std::vector<uint8_t> values(3);
+
+  EXPECT_THAT(random.RandIndices(0, absl::MakeSpan(values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(random.RandIndices(257, absl::MakeSpan(values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_P(RandomEngineVersionTest, RandDoubleShouldBeInUnitIntervalAndUseOneDraw) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  RandomEngine jumped({1, 2, 3}, GetParam());
+
+  double sum = 0;
+  for (int i = 0; i < 10000; i++) {
+    double value = random.RandDouble();
+    ASSERT_GE(value, 0.0);
+    ASSERT_LT(value, 1.0);
+    sum += value;
+  }
+  EXPECT_GT(sum / 10000, 0.45);
+  EXPECT_LT(sum / 10000, 0.55);
+
+  jumped.Jump(10000);
+  EXPECT_EQ(random.RandInt(1000), jumped.RandInt(1000));
+}
+
+TEST_P(RandomEngineVersionTest, LoadStateShouldContinueTheSavedStream) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  MORIARTY_ASSERT_OK(GetNRandomNumbersUnderK(random, 100, 1000).status());
+  random.Jump(5);
+  std::string state = random.SaveState();
+
+  RandomEngine loaded({4, 5, 6}, GetParam());
+  MORIARTY_ASSERT_OK(loaded.LoadState(state));
+  EXPECT_EQ(loaded.SaveState(), state);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values,
+                                GetNRandomNumbersUnderK(random, 10, 123456));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> loaded_values,
+                                GetNRandomNumbersUnderK(loaded, 10, 123456));
+  EXPECT_EQ(values, loaded_values);
+}
+
+TEST_P(RandomEngineVersionTest, LoadStateShouldWorkForSplitEngines) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  RandomEngine split = random.Split();
+  MORIARTY_ASSERT_OK(GetNRandomNumbersUnderK(split, 10, 1000).status());
+
+  RandomEngine loaded({}, GetParam());
+  MORIARTY_ASSERT_OK(loaded.LoadState(split.SaveState()));
+  EXPECT_EQ(split.RandInt(1000000), loaded.RandInt(1000000));
+}
+
+TEST_P(RandomEngineVersionTest, LoadStateWithMalformedStateShouldFail) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  std::string version(GetParam());
+  EXPECT_THAT(random.LoadState(""),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(random.LoadState(version + ";1"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(random.LoadState(version + ";x;1"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(random.LoadState(version + ";1;1,y"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RandomEngineTest, LoadStateFromADifferentVersionShouldFail) {
+  RandomEngine old_version({1, 2, 3}, kMersenneTwisterVersion);
+  RandomEngine new_version({1, 2, 3}, kCounterBasedVersion);
+  EXPECT_THAT(old_version.LoadState(new_version.SaveState()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("but this engine uses version")));
+}
+
+TEST(RandomEngineTest, RandIndicesShouldMatchRepeatedRandIntForOldVersion) {
+  for (int bound : {1, 7, 64, 256}) {
+    RandomEngine one_at_a_time({1, 117, 1337}, kMersenneTwisterVersion);
+    RandomEngine in_bulk({1, 117, 1337}, kMersenneTwisterVersion);
+
+    std::vector<uint8_t> expected(1000);
+    for (uint8_t& val : expected) {
+      MORIARTY_ASSERT_OK_AND_ASSIGN(val, one_at_a_time.RandInt(bound));
+    }
+    std::vector<uint8_t> values(1000);
+    MORIARTY_ASSERT_OK(in_bulk.RandIndices(bound, absl::MakeSpan(values)));
+    EXPECT_EQ(values, expected);
+  }
+}
+
+TEST(RandomEngineTest, RandIndicesSlicesPowersOfTwoForCounterBasedVersion) {
+  RandomEngine sliced({1, 2, 3}, kCounterBasedVersion);
+  RandomEngine jumped({1, 2, 3}, kCounterBasedVersion);
+
+  // 6 bits per value, so 10 values per random 64-bit integer.
+  std::vector<uint8_t> values(100);
+  MORIARTY_ASSERT_OK(sliced.RandIndices(64, absl::MakeSpan(values)));
+  jumped.Jump(10);
+
+  EXPECT_EQ(sliced.RandInt(1000), jumped.RandInt(1000));
+}
+
+TEST(RandomEngineTest, RandIntsBelowShouldMatchRepeatedRandIntForOldVersion) {
+  RandomEngine one_at_a_time({1, 117, 1337}, kMersenneTwisterVersion);
+  RandomEngine in_bulk({1, 117, 1337}, kMersenneTwisterVersion);
+
+  std::vector<int64_t> bounds(1000);
+  for (int i = 0; i < bounds.size(); i++) bounds[i] = i + 1;
+  std::vector<int64_t> expected(bounds.size());
+  for (int i = 0; i < bounds.size(); i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(expected[i],
+                                  one_at_a_time.RandInt(bounds[i]));
+  }
+  std::vector<int64_t> values(bounds.size());
+  MORIARTY_ASSERT_OK(in_bulk.RandIntsBelow(bounds, absl::MakeSpan(values)));
+  EXPECT_EQ(values, expected);
+}
+
+TEST(RandomEngineTest, RandIntsBelowBatchesSmallBoundsForCounterBasedVersion) {
+  RandomEngine batched({1, 2, 3}, kCounterBasedVersion);
+  RandomEngine jumped({1, 2, 3}, kCounterBasedVersion);
+
+  // 256^7 = 2^56, so 7 values per random 64-bit integer, and never biased.
+  std::vector<int64_t> bounds(70, 256);
+  std::vector<int64_t> values(70);
+  MORIARTY_ASSERT_OK(batched.RandIntsBelow(bounds, absl::MakeSpan(values)));
+  jumped.Jump(10);
+
+  EXPECT_EQ(batched.RandInt(1000), jumped.RandInt(1000));
+}
+
+TEST_P(RandomEngineVersionTest, RandIntsBelowShouldBeUniformInEachRange) {
+  RandomEngine random({1, 2, 3}, GetParam());
+
+  std::vector<int64_t> bounds;
+  for (int i = 0; i < 30000; i++) bounds.push_back(1 + i % 6);
+  std::vector<int64_t> values(bounds.size());
+  MORIARTY_ASSERT_OK(random.RandIntsBelow(bounds, absl::MakeSpan(values)));
+
+  // counts[b][v] is the number of times `v` was drawn with bound `b`.
+  std::vector<std::vector<int>> counts(7, std::vector<int>(7, 0));
+  for (int i = 0; i < bounds.size(); i++) {
+    ASSERT_GE(values[i], 0);
+    ASSERT_LT(values[i], bounds[i]);
+    counts[bounds[i]][values[i]]++;
+  }
+  for (int bound = 1; bound <= 6; bound++) {
+    for (int value = 0; value < bound; value++) {
+      EXPECT_NEAR(counts[bound][value], 5000.0 / bound, 300)
+          << bound << " " << value;
+    }
+  }
+}
+
+TEST_P(RandomEngineVersionTest, RandIntsBelowWithInvalidArgumentsShouldFail) {
+  RandomEngine random({1, 2, 3}, GetParam());
+  std::vector<int64_t> values(2);
+
+  EXPECT_THAT(random.RandIntsBelow({3, 0}, absl::MakeSpan(values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(random.RandIntsBelow({3}, absl::MakeSpan(values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllVersions, RandomEngineVersionTest,
+                         ::testing::Values(kMersenneTwisterVersion,
+                                           kCounterBasedVersion));
+
 }  // namespace
 }  // namespace moriarty_internal
 }  // namespace moriarty
@@ -18,12 +18,16 @@
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
@@ -32,18 +36,94 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "src/internal/expressions.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 
+namespace {
+
+// Returns the value of `expr` if it is a single integer (which includes all
+// constant expressions, since they are folded by `ParseExpression()`).
+std::optional<int64_t> GetConstantValue(const Expression& expr) {
+  const moriarty_internal::Literal* literal =
+      std::get_if<moriarty_internal::Literal>(&expr.Get());
+  if (literal == nullptr || literal->IsVariable()) return std::nullopt;
+  return literal->Value();
+}
+
+using ParsedExpressionPtr =
+    std::shared_ptr<const moriarty_internal::ParsedExpression>;
+
+struct ParsedExpressionTable {
+  absl::Mutex mutex;
+  // Keyed by both the original strings and the `CanonicalString()` of the
+  // parsed expression, so equal expressions share one `ParsedExpression`.
+  absl::flat_hash_map<std::string, ParsedExpressionPtr> parsed
+      ABSL_GUARDED_BY(mutex);
+};
+
+// Returns the `ParsedExpression` for `integer_expression`. Each distinct string
+// is only parsed once per process, so copying, merging or rebuilding variables
+// does not parse their bounds again. Strings that parse to the same expression
+// return the same pointer. Thread-safe.
+absl::StatusOr<ParsedExpressionPtr> GetParsedExpression(
+    absl::string_view integer_expression) {
+  // Never cleared: a program only uses a limited number of distinct
+  // expression strings.
+  static auto* table = new ParsedExpressionTable();
+  {
+    absl::MutexLock lock(&table->mutex);
+    auto it = table->parsed.find(integer_expression);
+    if (it != table->parsed.end()) return it->second;
+  }
+
+  // Parse without holding the lock. If another thread parses the same string
+  // in the meantime, the first one inserted is kept.
+  MORIARTY_ASSIGN_OR_RETURN(Expression expr,
+                            ParseExpression(integer_expression));
+  std::string canonical = CanonicalString(expr);
+  MORIARTY_ASSIGN_OR_RETURN(absl::flat_hash_set<std::string> needed_variables,
+                            moriarty::NeededVariables(expr));
+  CompiledExpression compiled = CompileExpression(expr);
+  auto parsed = std::make_shared<const moriarty_internal::ParsedExpression>(
+      moriarty_internal::ParsedExpression{
+          .expression = std::move(expr),
+          .compiled = std::move(compiled),
+          .needed_variables = std::move(needed_variables)});
+
+  absl::MutexLock lock(&table->mutex);
+  ParsedExpressionPtr shared =
+      table->parsed.try_emplace(std::move(canonical), std::move(parsed))
+          .first->second;
+  return table->parsed.try_emplace(integer_expression, shared).first->second;
+}
+
+// Appends `expr` to `exprs` unless it is already there.
+void AddIfMissing(std::vector<ParsedExpressionPtr>& exprs,
+                  const ParsedExpressionPtr& expr) {
+  if (!absl::c_linear_search(exprs, expr)) exprs.push_back(expr);
+}
+
+// Returns true if every expression in `others` is in `exprs`.
+bool ContainsAll(absl::Span<const ParsedExpressionPtr> exprs,
+                 absl::Span<const ParsedExpressionPtr> others) {
+  return absl::c_all_of(others, [&](const ParsedExpressionPtr& expr) {
+    return absl::c_linear_search(exprs, expr);
+  });
+}
+
+}  // namespace
+
 Range::Range(int64_t minimum, int64_t maximum) : min_(minimum), max_(maximum) {}
 
 void Range::AtLeast(int64_t minimum) { min_ = std::max(min_, minimum); }
 
 absl::Status Range::AtLeast(absl::string_view integer_expression) {
-  absl::StatusOr<Expression> expr = ParseExpression(integer_expression);
+  absl::StatusOr<ParsedExpressionPtr> expr =
+      GetParsedExpression(integer_expression);
   if (!expr.ok()) {
     absl::Status status = absl::InvalidArgumentError(absl::Substitute(
         "AtLeast called with invalid expression; $0", expr.status().message()));
@@ -51,18 +131,25 @@ absl::Status Range::AtLeast(absl::string_view integer_expression) {
     return status;
   }
 
-  MORIARTY_ASSIGN_OR_RETURN(absl::flat_hash_set<std::string> vars,
-                            moriarty::NeededVariables(*expr));
-  needed_variables_.merge(vars);
+  if (std::optional<int64_t> value = GetConstantValue((*expr)->expression)) {
+    AtLeast(*value);
+    return absl::OkStatus();
+  }
 
-  min_exprs_.push_back(std::move(*expr));
+  if (absl::c_linear_search(exprs_.Get().min_exprs, *expr))
+    return absl::OkStatus();
+  ExpressionBounds& exprs = exprs_.Mutable();
+  exprs.min_exprs.push_back(*expr);
+  exprs.needed_variables.insert((*expr)->needed_variables.begin(),
+                                (*expr)->needed_variables.end());
   return absl::OkStatus();
 }
 
 void Range::AtMost(int64_t maximum) { max_ = std::min(max_, maximum); }
 
 absl::Status Range::AtMost(absl::string_view integer_expression) {
-  absl::StatusOr<Expression> expr = ParseExpression(integer_expression);
+  absl::StatusOr<ParsedExpressionPtr> expr =
+      GetParsedExpression(integer_expression);
   if (!expr.ok()) {
     absl::Status status = absl::InvalidArgumentError(absl::Substitute(
         "AtMost called with invalid expression; $0", expr.status().message()));
@@ -70,11 +157,17 @@ absl::Status Range::AtMost(absl::string_view integer_expression) {
     return status;
   }
 
-  MORIARTY_ASSIGN_OR_RETURN(absl::flat_hash_set<std::string> vars,
-                            moriarty::NeededVariables(*expr));
-  needed_variables_.merge(vars);
+  if (std::optional<int64_t> value = GetConstantValue((*expr)->expression)) {
+    AtMost(*value);
+    return absl::OkStatus();
+  }
 
-  max_exprs_.push_back(std::move(*expr));
+  if (absl::c_linear_search(exprs_.Get().max_exprs, *expr))
+    return absl::OkStatus();
+  ExpressionBounds& exprs = exprs_.Mutable();
+  exprs.max_exprs.push_back(*expr);
+  exprs.needed_variables.insert((*expr)->needed_variables.begin(),
+                                (*expr)->needed_variables.end());
   return absl::OkStatus();
 }
 
@@ -86,11 +179,10 @@ namespace {
 // value of `compare`.
 template <typename F>
 absl::StatusOr<int64_t> FindExtreme(
-    int64_t initial_value, absl::Span<const Expression> exprs,
+    int64_t initial_value, absl::Span<const ParsedExpressionPtr> exprs,
     const absl::flat_hash_map<std::string, int64_t>& variables, F compare) {
-  for (const Expression& expr : exprs) {
-    MORIARTY_ASSIGN_OR_RETURN(int64_t val,
-                              EvaluateIntegerExpression(expr, variables));
+  for (const ParsedExpressionPtr& expr : exprs) {
+    MORIARTY_ASSIGN_OR_RETURN(int64_t val, expr->compiled.Evaluate(variables));
     if (compare(val, initial_value)) initial_value = val;
   }
   return initial_value;
@@ -105,21 +197,60 @@ absl::StatusOr<std::optional<Range::ExtremeValues>> Range::Extremes(
   ExtremeValues extremes;
   MORIARTY_ASSIGN_OR_RETURN(
       extremes.min,
-      FindExtreme(min_, min_exprs_, variables, std::greater<int64_t>()));
+      FindExtreme(min_, exprs_.Get().min_exprs, variables,
+                  std::greater<int64_t>()));
   MORIARTY_ASSIGN_OR_RETURN(
       extremes.max,
-      FindExtreme(max_, max_exprs_, variables, std::less<int64_t>()));
+      FindExtreme(max_, exprs_.Get().max_exprs, variables,
+                  std::less<int64_t>()));
 
   if (extremes.min > extremes.max) return std::nullopt;
 
   return extremes;
 }
 
+absl::StatusOr<std::optional<Range::ExtremeValues>> Range::StaticExtremes(
+    const absl::flat_hash_map<std::string, Range>& variable_ranges) const {
+  MORIARTY_RETURN_IF_ERROR(parameter_status_);
+
+  absl::flat_hash_map<std::string, IntegerInterval> intervals;
+  const ExpressionBounds& exprs = exprs_.Get();
+  for (const std::string& name : exprs.needed_variables) {
+    auto it = variable_ranges.find(name);
+    if (it == variable_ranges.end()) {
+      intervals[name] = {std::numeric_limits<int64_t>::min(),
+                         std::numeric_limits<int64_t>::max()};
+    } else if (it->second.IsEmpty()) {
+      return std::nullopt;  // There are no values for this variable.
+    } else {
+      intervals[name] = {it->second.min_, it->second.max_};
+    }
+  }
+
+  // The lower bound is at least the smallest value of each expression and the
+  // upper bound is at most the largest value of each. An expression that
+  // cannot be bounded (e.g., it always divides by zero) is ignored.
+  ExtremeValues extremes = {.min = min_, .max = max_};
+  for (const ParsedExpressionPtr& expr : exprs.min_exprs) {
+    absl::StatusOr<IntegerInterval> interval =
+        EvaluateIntegerInterval(expr->expression, intervals);
+    if (interval.ok()) extremes.min = std::max(extremes.min, interval->min);
+  }
+  for (const ParsedExpressionPtr& expr : exprs.max_exprs) {
+    absl::StatusOr<IntegerInterval> interval =
+        EvaluateIntegerInterval(expr->expression, intervals);
+    if (interval.ok()) extremes.max = std::min(extremes.max, interval->max);
+  }
+
+  if (extremes.min > extremes.max) return std::nullopt;
+  return extremes;
+}
+
 absl::StatusOr<absl::flat_hash_set<std::string>> Range::NeededVariables()
     const {
   MORIARTY_RETURN_IF_ERROR(parameter_status_);
 
-  return needed_variables_;
+  return exprs_.Get().needed_variables;
 }
 
 void Range::Intersect(const Range& other) {
@@ -128,13 +259,25 @@ void Range::Intersect(const Range& other) {
   AtLeast(other.min_);
   AtMost(other.max_);
 
-  min_exprs_.insert(min_exprs_.end(), other.min_exprs_.begin(),
-                    other.min_exprs_.end());
-  max_exprs_.insert(max_exprs_.end(), other.max_exprs_.begin(),
-                    other.max_exprs_.end());
+  if (&other == this) return;
+  const ExpressionBounds& current = exprs_.Get();
+  const ExpressionBounds& added = other.exprs_.Get();
+  if (ContainsAll(current.min_exprs, added.min_exprs) &&
+      ContainsAll(current.max_exprs, added.max_exprs)) {
+    return;
+  }
+  if (current.min_exprs.empty() && current.max_exprs.empty()) {
+    exprs_ = other.exprs_;  // Share them instead of copying.
+    return;
+  }
 
-  needed_variables_.insert(other.needed_variables_.begin(),
-                           other.needed_variables_.end());
+  ExpressionBounds& exprs = exprs_.Mutable();
+  for (const ParsedExpressionPtr& expr : added.min_exprs)
+    AddIfMissing(exprs.min_exprs, expr);
+  for (const ParsedExpressionPtr& expr : added.max_exprs)
+    AddIfMissing(exprs.max_exprs, expr);
+  exprs.needed_variables.insert(added.needed_variables.begin(),
+                                added.needed_variables.end());
 }
 
 namespace {
@@ -144,7 +287,7 @@ namespace {
 // just return that. Otherwise, will return a comma separated list of bounds.
 std::optional<std::string> BoundsToString(
     bool is_minimum, int64_t numeric_limit,
-    absl::Span<const Expression> expression_limits) {
+    absl::Span<const ParsedExpressionPtr> expression_limits) {
   bool unchanged_numeric_limit =
       (is_minimum && numeric_limit == std::numeric_limits<int64_t>::min()) ||
       (!is_minimum && numeric_limit == std::numeric_limits<int64_t>::max());
@@ -155,8 +298,8 @@ std::optional<std::string> BoundsToString(
   std::vector<std::string> bounds;
   bounds.reserve(expression_limits.size() + 1);
   if (!unchanged_numeric_limit) bounds.push_back(absl::StrCat(numeric_limit));
-  for (const Expression& expr : expression_limits)
-    bounds.push_back(expr.ToString());
+  for (const ParsedExpressionPtr& expr : expression_limits)
+    bounds.push_back(expr->expression.ToString());
 
   if (bounds.size() == 1) return bounds[0];
 
@@ -171,9 +314,9 @@ std::string Range::ToString() const {
   if (min_ > max_) return "(Empty Range)";
 
   std::optional<std::string> min_bounds =
-      BoundsToString(/* is_minimum = */ true, min_, min_exprs_);
+      BoundsToString(/* is_minimum = */ true, min_, exprs_.Get().min_exprs);
   std::optional<std::string> max_bounds =
-      BoundsToString(/* is_minimum = */ false, max_, max_exprs_);
+      BoundsToString(/* is_minimum = */ false, max_, exprs_.Get().max_exprs);
 
   if (!min_bounds.has_value() && !max_bounds.has_value()) return "(-inf, inf)";
   if (!min_bounds.has_value())
@@ -190,18 +333,13 @@ bool operator==(const Range& r1, const Range& r2) {
   if (r1.IsEmpty() || r2.IsEmpty()) return r1.IsEmpty() == r2.IsEmpty();
 
   if (std::tie(r1.min_, r1.max_) != std::tie(r2.min_, r2.max_)) return false;
-  if (r1.min_exprs_.size() != r2.min_exprs_.size() ||
-      r1.max_exprs_.size() != r2.max_exprs_.size())
+  const Range::ExpressionBounds& e1 = r1.exprs_.Get();
+  const Range::ExpressionBounds& e2 = r2.exprs_.Get();
+  if (e1.min_exprs.size() != e2.min_exprs.size() ||
+      e1.max_exprs.size() != e2.max_exprs.size())
     return false;
-  for (int i = 0; i < r1.min_exprs_.size(); ++i) {
-    if (r1.min_exprs_[i].ToString() != r2.min_exprs_[i].ToString())
-      return false;
-  }
-  for (int i = 0; i < r1.max_exprs_.size(); ++i) {
-    if (r1.max_exprs_[i].ToString() != r2.max_exprs_[i].ToString())
-      return false;
-  }
-  return true;
+  // Equal expressions share a `ParsedExpression`, so pointers can be compared.
+  return e1.min_exprs == e2.min_exprs && e1.max_exprs == e2.max_exprs;
 }
 
 Range EmptyRange() { return Range(0, -1); }
@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -28,17 +29,36 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "src/internal/copy_on_write.h"
 #include "src/internal/expressions.h"
 
 namespace moriarty {
 
+namespace moriarty_internal {
+
+// ParsedExpression
+//
+// An expression passed to `Range::AtLeast()` or `Range::AtMost()`, along with
+// everything needed to evaluate it. These are immutable once created and are
+// shared between all Ranges that use the same expression. Strings that parse to
+// the same expression (e.g., "N+1" and "N + 1") share a single instance, so
+// comparing pointers compares expressions.
+struct ParsedExpression {
+  Expression expression;        // Used for `ToString()`.
+  CompiledExpression compiled;  // Used for `Extremes()`.
+  absl::flat_hash_set<std::string> needed_variables;
+};
+
+}  // namespace moriarty_internal
+
 // Range
 //
 // All integers between min and max, inclusive.
 //
 // * An empty range can be created by setting min > max.
 // * Additional calls to `AtMost` and `AtLeast` add extra constraints, and does
-//   not overwrite the old ones.
+//   not overwrite the old ones. Adding an expression that is already a bound
+//   (e.g., when intersecting two ranges with the same bounds) does nothing.
 class Range {
  public:
   // Creates a range covering all 64-bit signed integers.
@@ -63,6 +83,9 @@ class Range {
   // This range is at least `integer_expression`. For example,
   //   `AtLeast("3 * N + 1")`
   //
+  // A constant expression (e.g., `AtLeast("10^9 + 7")`) is the same as
+  // calling `AtLeast(int64_t)` with its value.
+  //
   // Multiple calls to `AtLeast` are ANDed  together. For example,
   //   `AtLeast(5); AtLeast("X + Y"); AtLeast("W");`
   // means that this is at least max({5, Evaluate("X + Y"), Evaluate("W")}).
@@ -85,6 +108,9 @@ class Range {
   // This range is at most `integer_expression`. For example,
   //   `AtMost("3 * N + 1")`
   //
+  // A constant expression (e.g., `AtMost("2 * 10^5")`) is the same as calling
+  // `AtMost(int64_t)` with its value.
+  //
   // Multiple calls to `AtMost` are ANDed  together. For example,
   //   `AtMost(5); AtMost("X + Y"); AtMost("W");`
   // means that this is at most min({5, Evaluate("X + Y"), Evaluate("W")}).
@@ -112,6 +138,20 @@ class Range {
   absl::StatusOr<std::optional<ExtremeValues>> Extremes(
       const absl::flat_hash_map<std::string, int64_t>& variables = {}) const;
 
+  // StaticExtremes()
+  //
+  // Returns bounds on `Extremes()` that hold for all values of the variables,
+  // before any of them is known. Each variable `v` is assumed to take any value
+  // within the integer bounds of `variable_ranges[v]` (its expression bounds
+  // are ignored), and any 64-bit value if it is not in `variable_ranges`.
+  //
+  // Every value that is inside the range for *some* values of the variables is
+  // inside the returned bounds (which may be wider than needed). Returns
+  // `std::nullopt` if the range is empty for all values of the variables.
+  absl::StatusOr<std::optional<ExtremeValues>> StaticExtremes(
+      const absl::flat_hash_map<std::string, Range>& variable_ranges = {})
+      const;
+
   // NeededVariables()
   //
   // Returns a set of all variable's values needed in order to evaluate
@@ -132,8 +172,11 @@ class Range {
   // Determine if two Ranges are equal.
   //
   // The exact implementation is not guaranteed to be stable over time.
-  // For now, Range.AtMost(5) and Range.AtMost("5") are considered different and
-  // insertion order of expressions matters, but may not in the future.
+  // For now, Range.AtMost(5) and Range.AtMost("5") are considered equal (since
+  // constant expressions become integer bounds), as are Range.AtMost("N+1")
+  // and Range.AtMost("N + 1"). However, Range.AtMost("N") and
+  // Range.AtMost("N + 0") are different and insertion order of expressions
+  // matters. This may change in the future.
   friend bool operator==(const Range& r1, const Range& r2);
 
  private:
@@ -147,13 +190,24 @@ class Range {
   // the value back to the user and they should fail as needed.
   absl::Status parameter_status_ = absl::OkStatus();
 
-  // `min_exprs_` and `max_exprs_` are lists of Expressions that represent the
+  // `min_exprs` and `max_exprs` are lists of Expressions that represent the
   // lower/upper bounds. They must be evaluated when `Extremes()` is called in
-  // order to determine which is largest/smallest.
-  std::vector<Expression> min_exprs_;
-  std::vector<Expression> max_exprs_;
+  // order to determine which is largest/smallest. Neither contains duplicates
+  // or constant expressions (those are folded into `min_` and `max_`).
+  struct ExpressionBounds {
+    std::vector<std::shared_ptr<const moriarty_internal::ParsedExpression>>
+        min_exprs;
+    std::vector<std::shared_ptr<const moriarty_internal::ParsedExpression>>
+        max_exprs;
+
+    absl::flat_hash_set<std::string> needed_variables;
+  };
 
-  absl::flat_hash_set<std::string> needed_variables_;
+  // Most ranges only have numeric bounds, so the expressions are kept out of
+  // line (and not allocated until the first one is added). Copying a range
+  // then only copies a few words, and copies share their expressions until
+  // one of them adds another.
+  moriarty_internal::CopyOnWrite<ExpressionBounds> exprs_;
 };
 
 // Creates a range with no elements in it.
@@ -17,10 +17,13 @@
 #include <cstdint>
 #include <limits>
 #include <optional>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "src/util/test_status_macro/status_testutil.h"
 
 namespace moriarty {
@@ -129,13 +132,19 @@ TEST(RangeTest, EqualityWorks) {
   EXPECT_EQ(EmptyRange(), Range(10, 5));
 
   // Expressions are considered. This is not guaranteed to be stable over time.
+  // Constant expressions become integer bounds.
   Range r1;
   r1.AtLeast(1);
   r1.AtMost(2);
   Range r2;
   MORIARTY_ASSERT_OK(r2.AtLeast("1"));
   MORIARTY_ASSERT_OK(r2.AtMost("2"));
-  EXPECT_NE(r1, r2);
+  EXPECT_EQ(r1, r2);
+  Range r5;
+  MORIARTY_ASSERT_OK(r5.AtLeast("N"));
+  Range r6;
+  MORIARTY_ASSERT_OK(r6.AtLeast("N + 0"));
+  EXPECT_NE(r5, r6);
 
   Range r3(1, 4);
   MORIARTY_ASSERT_OK(r3.AtLeast("a"));
@@ -365,6 +374,82 @@ TEST(RangeTest, OneSidedInequalitiesToStringShouldWork) {
   EXPECT_EQ(r4.ToString(), "[M, inf)");
 }
 
+TEST(RangeTest, ConstantExpressionsShouldBecomeIntegerBounds) {
+  Range r;
+  MORIARTY_ASSERT_OK(r.AtLeast("-10^9"));
+  MORIARTY_ASSERT_OK(r.AtMost("2 * 10^5"));
+  EXPECT_EQ(r.ToString(), "[-1000000000, 200000]");
+  EXPECT_THAT(r.NeededVariables(), IsOkAndHolds(IsEmpty()));
+  EXPECT_EQ(r, Range(-1000000000, 200000));
+}
+
+TEST(RangeTest, RangesWithTheSameExpressionStringShouldBeIndependent) {
+  Range r1;
+  MORIARTY_ASSERT_OK(r1.AtMost("3 * N + 1"));
+  Range r2;
+  MORIARTY_ASSERT_OK(r2.AtMost("3 * N + 1"));
+  MORIARTY_ASSERT_OK(r2.AtLeast("N"));
+
+  EXPECT_EQ(r1.ToString(), "(-inf, 3 * N + 1]");
+  EXPECT_EQ(r2.ToString(), "[N, 3 * N + 1]");
+  EXPECT_THAT(r1.Extremes({{"N", 2}}),
+              IsOkAndHolds(Optional(Range::ExtremeValues(
+                  {std::numeric_limits<int64_t>::min(), 7}))));
+  EXPECT_THAT(r2.Extremes({{"N", 3}}),
+              IsOkAndHolds(Optional(Range::ExtremeValues({3, 10}))));
+}
+
+TEST(RangeTest, CopiesShouldBeIndependent) {
+  Range original(1, 10);
+  MORIARTY_ASSERT_OK(original.AtMost("N"));
+
+  Range copy = original;
+  MORIARTY_ASSERT_OK(copy.AtLeast("M"));
+  copy.AtMost(5);
+
+  EXPECT_EQ(original.ToString(), "[1, min(10, N)]");
+  EXPECT_EQ(copy.ToString(), "[max(1, M), min(5, N)]");
+  EXPECT_THAT(original.NeededVariables(),
+              IsOkAndHolds(UnorderedElementsAre("N")));
+  EXPECT_THAT(copy.NeededVariables(),
+              IsOkAndHolds(UnorderedElementsAre("N", "M")));
+}
+
+TEST(RangeTest, IntersectingARangeWithoutExpressionsShouldKeepOthers) {
+  Range numeric(1, 10);
+  Range with_exprs;
+  MORIARTY_ASSERT_OK(with_exprs.AtMost("N"));
+
+  numeric.Intersect(with_exprs);
+  MORIARTY_ASSERT_OK(with_exprs.AtLeast("M"));
+
+  EXPECT_EQ(numeric.ToString(), "[1, min(10, N)]");
+  EXPECT_THAT(numeric.NeededVariables(),
+              IsOkAndHolds(UnorderedElementsAre("N")));
+}
+
+TEST(RangeTest, ParsingTheSameExpressionFromSeveralThreadsShouldWork) {
+  std::vector<absl::StatusOr<std::optional<Range::ExtremeValues>>> results(8);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < results.size(); i++) {
+    threads.emplace_back([&results, i]() {
+      Range r;
+      r.AtLeast(0);
+      if (absl::Status status = r.AtMost("N * M + 5"); !status.ok()) {
+        results[i] = status;
+        return;
+      }
+      results[i] = r.Extremes({{"N", i}, {"M", 2}});
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int i = 0; i < results.size(); i++) {
+    EXPECT_THAT(results[i],
+                IsOkAndHolds(Optional(Range::ExtremeValues({0, 2 * i + 5}))));
+  }
+}
+
 TEST(RangeTest, InequalitiesWithMultipleItemsShouldWork) {
   Range r1;
   r1.AtLeast(1);
@@ -390,5 +475,61 @@ TEST(RangeTest, InequalitiesWithMultipleItemsShouldWork) {
   EXPECT_EQ(r4.ToString(), "[a, min(c, d)]");
 }
 
+TEST(RangeTest, AddingTheSameExpressionTwiceShouldOnlyKeepOne) {
+  Range r;
+  MORIARTY_ASSERT_OK(r.AtLeast("N"));
+  MORIARTY_ASSERT_OK(r.AtLeast("N"));
+  MORIARTY_ASSERT_OK(r.AtMost("7*N+2"));
+  MORIARTY_ASSERT_OK(r.AtMost("(7 * N) + 2"));
+
+  EXPECT_EQ(r.ToString(), "[N, 7*N+2]");
+
+  Range expected;
+  MORIARTY_ASSERT_OK(expected.AtLeast("N"));
+  MORIARTY_ASSERT_OK(expected.AtMost("7 * N + 2"));
+  EXPECT_EQ(r, expected);
+}
+
+TEST(RangeTest, RepeatedIntersectionsShouldNotGrowTheExpressions) {
+  Range other(1, 10);
+  MORIARTY_ASSERT_OK(other.AtLeast("N"));
+  MORIARTY_ASSERT_OK(other.AtMost("M"));
+
+  Range r;
+  for (int i = 0; i < 40; i++) r.Intersect(other);
+  r.Intersect(r);
+
+  EXPECT_EQ(r, other);
+  EXPECT_EQ(r.ToString(), "[max(1, N), min(10, M)]");
+  EXPECT_THAT(r.NeededVariables(),
+              IsOkAndHolds(UnorderedElementsAre("N", "M")));
+}
+
+TEST(RangeTest, StaticExtremesShouldBoundExpressionsByTheVariableRanges) {
+  Range r(0, 100);
+  MORIARTY_ASSERT_OK(r.AtLeast("N"));
+  MORIARTY_ASSERT_OK(r.AtMost("2 * N + M"));
+
+  EXPECT_THAT(r.StaticExtremes({{"N", Range(3, 10)}, {"M", Range(-1, 50)}}),
+              IsOkAndHolds(Optional(Range::ExtremeValues{3, 70})));
+  EXPECT_THAT(r.StaticExtremes({{"N", Range(3, 10)}}),
+              IsOkAndHolds(Optional(Range::ExtremeValues{3, 100})));
+  EXPECT_THAT(r.StaticExtremes(),
+              IsOkAndHolds(Optional(Range::ExtremeValues{0, 100})));
+}
+
+TEST(RangeTest, StaticExtremesShouldDetectRangesThatAreAlwaysEmpty) {
+  Range r;
+  MORIARTY_ASSERT_OK(r.AtLeast("N + 1"));
+  MORIARTY_ASSERT_OK(r.AtMost("M"));
+
+  EXPECT_THAT(r.StaticExtremes({{"N", Range(10, 20)}, {"M", Range(1, 5)}}),
+              IsOkAndHolds(std::nullopt));
+  EXPECT_THAT(r.StaticExtremes({{"N", Range(10, 20)}, {"M", Range(1, 11)}}),
+              IsOkAndHolds(Optional(Range::ExtremeValues{11, 11})));
+  EXPECT_THAT(r.StaticExtremes({{"N", EmptyRange()}}),
+              IsOkAndHolds(std::nullopt));
+}
+
 }  // namespace
 }  // namespace moriarty
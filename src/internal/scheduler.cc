@@ -0,0 +1,98 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/scheduler.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+WorkStealingScheduler::WorkStealingScheduler(int num_threads) {
+  for (int i = 1; i < num_threads; i++)
+    workers_.emplace_back([this]() { WorkerLoop(); });
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  for (std::thread& worker : workers_) worker.join();
+}
+
+int WorkStealingScheduler::NumThreads() const { return workers_.size() + 1; }
+
+void WorkStealingScheduler::ParallelFor(int num_tasks,
+                                        absl::FunctionRef<void(int)> task) {
+  if (workers_.empty() || num_tasks <= 1) {
+    for (int i = 0; i < num_tasks; i++) task(i);
+    return;
+  }
+
+  Job job(num_tasks, task);
+  {
+    absl::MutexLock lock(&mutex_);
+    jobs_.push_back(&job);
+  }
+  RunTasks(job);
+
+  // Every task has been claimed. Once no worker is running one, they have all
+  // finished (and no worker can find `job` anymore).
+  absl::MutexLock lock(&mutex_);
+  RemoveJob(&job);
+  mutex_.Await(absl::Condition(
+      +[](Job* job) { return job->num_workers == 0; }, &job));
+}
+
+void WorkStealingScheduler::RunTasks(Job& job) {
+  for (int i = job.next_task++; i < job.num_tasks; i = job.next_task++)
+    job.task(i);
+}
+
+void WorkStealingScheduler::RemoveJob(const Job* job) {
+  auto it = std::find(jobs_.begin(), jobs_.end(), job);
+  if (it != jobs_.end()) jobs_.erase(it);
+}
+
+bool WorkStealingScheduler::HasJobsOrStopping() const {
+  return stopping_ || !jobs_.empty();
+}
+
+void WorkStealingScheduler::WorkerLoop() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    mutex_.Await(
+        absl::Condition(this, &WorkStealingScheduler::HasJobsOrStopping));
+    if (jobs_.empty()) return;  // Stopping.
+
+    Job* job = jobs_.front();
+    job->num_workers++;
+    mutex_.Unlock();
+    RunTasks(*job);
+    mutex_.Lock();
+    // All tasks of `job` have been claimed. Remove it before its caller may
+    // return (which needs `num_workers` to reach 0 while holding `mutex_`).
+    RemoveJob(job);
+    job->num_workers--;
+  }
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_SCHEDULER_H_
+#define MORIARTY_SRC_INTERNAL_SCHEDULER_H_
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// Scheduler
+//
+// Runs independent tasks on several threads. All of Moriarty's parallel work
+// (running generators, generating large arrays and validating test cases)
+// goes through a single `Scheduler`, so nested parallel work shares the same
+// threads instead of each level spawning its own.
+//
+// Tasks are identified by their index, never by the thread that runs them.
+// Any randomness a task needs must be decided by its index (e.g., task `i`
+// uses the `i`-th engine from `RandomEngine::Split()`), so the results do not
+// depend on the number of threads or on scheduling.
+//
+// Implement this interface to run Moriarty on your own thread pool.
+class Scheduler {
+ public:
+  virtual ~Scheduler() = default;
+
+  // NumThreads()
+  //
+  // Returns the number of tasks that may run at the same time. Callers use
+  // this to decide whether splitting work is worthwhile.
+  virtual int NumThreads() const = 0;
+
+  // ParallelFor()
+  //
+  // Calls `task(i)` exactly once for every `i` in [0, `num_tasks`), possibly
+  // concurrently and in any order, and returns once all calls have finished.
+  // `task` may itself call `ParallelFor()`.
+  virtual void ParallelFor(int num_tasks,
+                           absl::FunctionRef<void(int)> task) = 0;
+};
+
+// WorkStealingScheduler
+//
+// A fixed pool of `num_threads - 1` worker threads. The thread calling
+// `ParallelFor()` runs tasks as well, so a scheduler with one thread runs
+// everything on the caller's thread, in order.
+//
+// Each call to `ParallelFor()` publishes its tasks, and idle workers steal
+// tasks from the oldest call that still has unclaimed ones. Tasks are claimed
+// with an atomic counter (without locking), so workers only take the lock when
+// looking for a new call to help with. Since the caller always works on its own
+// tasks, nested calls cannot deadlock.
+class WorkStealingScheduler : public Scheduler {
+ public:
+  explicit WorkStealingScheduler(int num_threads);
+  ~WorkStealingScheduler() override;
+
+  WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+  WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+  int NumThreads() const override;
+  void ParallelFor(int num_tasks, absl::FunctionRef<void(int)> task) override;
+
+ private:
+  // The tasks of a single call to `ParallelFor()`.
+  struct Job {
+    Job(int num_tasks, absl::FunctionRef<void(int)> task)
+        : num_tasks(num_tasks), task(task) {}
+
+    const int num_tasks;
+    const absl::FunctionRef<void(int)> task;
+    std::atomic<int> next_task = 0;
+    // Workers (other than the caller) currently running tasks of this job.
+    int num_workers = 0;
+  };
+
+  // Runs tasks from `job` until all of them have been claimed.
+  static void RunTasks(Job& job);
+
+  // Removes `job` from `jobs_`, if it is there.
+  void RemoveJob(const Job* job) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  bool HasJobsOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void WorkerLoop();
+
+  absl::Mutex mutex_;
+  // Jobs that may have unclaimed tasks, oldest first. Not owned.
+  std::vector<Job*> jobs_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_SCHEDULER_H_
@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/scheduler.h"
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::Each;
+using ::testing::ElementsAre;
+
+TEST(WorkStealingSchedulerTest, NumThreadsIncludesTheCaller) {
+  EXPECT_EQ(WorkStealingScheduler(1).NumThreads(), 1);
+  EXPECT_EQ(WorkStealingScheduler(4).NumThreads(), 4);
+}
+
+TEST(WorkStealingSchedulerTest, SingleThreadRunsTasksInOrderOnTheCaller) {
+  WorkStealingScheduler scheduler(1);
+  std::vector<int> order;
+  std::thread::id caller = std::this_thread::get_id();
+  scheduler.ParallelFor(5, [&](int i) {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+    order.push_back(i);
+  });
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(WorkStealingSchedulerTest, EveryTaskRunsExactlyOnce) {
+  WorkStealingScheduler scheduler(4);
+  for (int num_tasks : {0, 1, 2, 3, 100, 1000}) {
+    std::vector<std::atomic<int>> runs(num_tasks);
+    scheduler.ParallelFor(num_tasks, [&](int i) { runs[i]++; });
+    for (int i = 0; i < num_tasks; i++) EXPECT_EQ(runs[i].load(), 1);
+  }
+}
+
+TEST(WorkStealingSchedulerTest, NestedParallelForShouldFinish) {
+  WorkStealingScheduler scheduler(3);
+  std::vector<std::vector<int>> results(20, std::vector<int>(50));
+  scheduler.ParallelFor(20, [&](int i) {
+    scheduler.ParallelFor(50, [&](int j) { results[i][j] = i * j; });
+  });
+  for (int i = 0; i < 20; i++) {
+    for (int j = 0; j < 50; j++) EXPECT_EQ(results[i][j], i * j);
+  }
+}
+
+TEST(WorkStealingSchedulerTest, ConcurrentCallersShareThePool) {
+  WorkStealingScheduler scheduler(4);
+  std::vector<std::vector<int>> results(4, std::vector<int>(200));
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 4; c++) {
+    callers.emplace_back([&, c]() {
+      scheduler.ParallelFor(200, [&](int i) { results[c][i] = 1; });
+    });
+  }
+  for (std::thread& caller : callers) caller.join();
+  for (const std::vector<int>& result : results) EXPECT_THAT(result, Each(1));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_SCRATCH_BUFFER_H_
+#define MORIARTY_SRC_INTERNAL_SCRATCH_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// ScratchBuffer
+//
+// A temporary container (e.g., a `std::vector` or an `absl::flat_hash_set`)
+// borrowed from a per-thread pool. It is empty when borrowed and goes back to
+// the pool, keeping its capacity, when the `ScratchBuffer` is destroyed. So
+// code that runs once per generated value (or per test case) reuses the same
+// memory instead of allocating it every time. Only temporaries should be
+// stored here, never the value being returned.
+//
+// `Container` must have `begin()`, `end()`, `erase(first, last)` and
+// `capacity()`.
+//
+// Example:
+//   ScratchBuffer<absl::flat_hash_set<int64_t>> seen;
+//   for (int64_t x : values) seen->insert(x);
+template <typename Container>
+class ScratchBuffer {
+ public:
+  // At most this many containers of each type are kept per thread.
+  static constexpr int kMaxPooled = 8;
+
+  // Containers with more capacity than this are freed instead of being kept,
+  // so one huge value does not hold on to its memory for the rest of the run.
+  static constexpr size_t kMaxPooledCapacity = size_t{1} << 22;
+
+  ScratchBuffer();
+  ~ScratchBuffer();
+
+  ScratchBuffer(const ScratchBuffer&) = delete;
+  ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+  Container& operator*() { return *container_; }
+  const Container& operator*() const { return *container_; }
+  Container* operator->() { return container_.get(); }
+  const Container* operator->() const { return container_.get(); }
+
+  // NumPooled()
+  //
+  // The number of containers of this type that are waiting in this thread's
+  // pool.
+  static int NumPooled() { return Pool().size(); }
+
+ private:
+  static std::vector<std::unique_ptr<Container>>& Pool();
+
+  std::unique_ptr<Container> container_;
+};
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename Container>
+std::vector<std::unique_ptr<Container>>& ScratchBuffer<Container>::Pool() {
+  thread_local std::vector<std::unique_ptr<Container>> pool;
+  return pool;
+}
+
+template <typename Container>
+ScratchBuffer<Container>::ScratchBuffer() {
+  std::vector<std::unique_ptr<Container>>& pool = Pool();
+  if (pool.empty()) {
+    container_ = std::make_unique<Container>();
+  } else {
+    container_ = std::move(pool.back());
+    pool.pop_back();
+  }
+}
+
+template <typename Container>
+ScratchBuffer<Container>::~ScratchBuffer() {
+  std::vector<std::unique_ptr<Container>>& pool = Pool();
+  if (pool.size() >= kMaxPooled || container_->capacity() > kMaxPooledCapacity)
+    return;
+  // Unlike `clear()`, erasing everything keeps the capacity of hash sets.
+  container_->erase(container_->begin(), container_->end());
+  pool.push_back(std::move(container_));
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_SCRATCH_BUFFER_H_
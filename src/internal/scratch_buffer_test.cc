@@ -0,0 +1,103 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/scratch_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::Ge;
+using ::testing::IsEmpty;
+
+TEST(ScratchBufferTest, BorrowedContainersStartEmpty) {
+  {
+    ScratchBuffer<std::vector<int>> buffer;
+    buffer->assign({1, 2, 3});
+  }
+  ScratchBuffer<std::vector<int>> buffer;
+  EXPECT_THAT(*buffer, IsEmpty());
+}
+
+TEST(ScratchBufferTest, ReturnedContainersKeepTheirCapacity) {
+  const int* data = nullptr;
+  {
+    ScratchBuffer<std::vector<int>> buffer;
+    buffer->reserve(1000);
+    data = buffer->data();
+  }
+  ScratchBuffer<std::vector<int>> buffer;
+  EXPECT_THAT(buffer->capacity(), Ge(1000));
+  EXPECT_EQ(buffer->data(), data);
+}
+
+TEST(ScratchBufferTest, HashSetsKeepTheirCapacity) {
+  {
+    ScratchBuffer<absl::flat_hash_set<int64_t>> seen;
+    for (int64_t i = 0; i < 10000; i++) seen->insert(i);
+  }
+  ScratchBuffer<absl::flat_hash_set<int64_t>> seen;
+  EXPECT_THAT(*seen, IsEmpty());
+  EXPECT_THAT(seen->capacity(), Ge(10000));
+}
+
+TEST(ScratchBufferTest, NestedBuffersAreDifferentContainers) {
+  ScratchBuffer<std::string> outer;
+  ScratchBuffer<std::string> inner;
+  EXPECT_NE(&*outer, &*inner);
+}
+
+TEST(ScratchBufferTest, TheNumberOfPooledContainersIsBounded) {
+  using Buffer = ScratchBuffer<std::vector<char>>;
+  {
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    for (int i = 0; i < 2 * Buffer::kMaxPooled; i++)
+      buffers.push_back(std::make_unique<Buffer>());
+  }
+  EXPECT_EQ(Buffer::NumPooled(), Buffer::kMaxPooled);
+}
+
+TEST(ScratchBufferTest, HugeContainersAreNotPooled) {
+  using Buffer = ScratchBuffer<std::vector<int16_t>>;
+  int pooled = Buffer::NumPooled();
+  {
+    Buffer buffer;
+    buffer->reserve(Buffer::kMaxPooledCapacity + 1);
+  }
+  EXPECT_EQ(Buffer::NumPooled(), pooled);
+}
+
+TEST(ScratchBufferTest, EachThreadHasItsOwnPool) {
+  using Buffer = ScratchBuffer<std::vector<double>>;
+  { Buffer buffer; }
+  ASSERT_EQ(Buffer::NumPooled(), 1);
+
+  int pooled_in_other_thread = -1;
+  std::thread([&] { pooled_in_other_thread = Buffer::NumPooled(); }).join();
+  EXPECT_EQ(pooled_in_other_thread, 0);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,49 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/shrink.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+#include "absl/numeric/int128.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+std::optional<int64_t> ShrinkTowardsZero(int64_t value, int level) {
+  if (level < 0 || level >= 64) return std::nullopt;
+  uint64_t magnitude =
+      value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  uint64_t step = magnitude >> level;
+  if (step == 0) return std::nullopt;
+  // `magnitude - step` < `magnitude` <= 2^63, so it fits in an int64_t.
+  int64_t smaller = static_cast<int64_t>(magnitude - step);
+  return value < 0 ? -smaller : smaller;
+}
+
+int64_t NumChunks(int64_t size, int level) {
+  if (size <= 0 || level < 0 || level >= 62) return 0;
+  // The previous level already had one chunk per element.
+  if (level > 0 && (int64_t{1} << level) >= size) return 0;
+  return std::min(size, int64_t{1} << (level + 1));
+}
+
+int64_t ChunkStart(int64_t size, int64_t num_chunks, int64_t index) {
+  return static_cast<int64_t>(absl::int128(size) * index / num_chunks);
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
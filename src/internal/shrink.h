@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MORIARTY_SRC_INTERNAL_SHRINK_H_
+#define MORIARTY_SRC_INTERNAL_SHRINK_H_
+
+#include <cstdint>
+#include <optional>
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// Helpers for `MVariable::ShrinkImpl()`. Each returns the `index`-th smaller
+// version of a value at `level`. Level 0 has the largest changes, and each
+// later level has smaller ones. Once a level has no smaller version at all, no
+// later level has one either.
+
+// ShrinkTowardsZero()
+//
+// Returns `value` moved towards 0 by |value| / 2^level (rounded down), or
+// `std::nullopt` if that is 0. So level 0 is 0 itself, and later levels are
+// the steps a binary search towards 0 would try. Only level 0 has more than
+// zero versions, so `index` is not needed.
+std::optional<int64_t> ShrinkTowardsZero(int64_t value, int level);
+
+// RemoveChunk()
+//
+// Splits `container` into 2^(level + 1) chunks of (almost) equal size, or one
+// chunk per element if there are fewer elements, and returns `container`
+// without its `index`-th chunk. Returns `std::nullopt` if there is no such
+// chunk, and at every level after the first with one chunk per element.
+//
+// These are the candidates of delta debugging (ddmin).
+template <typename Container>
+std::optional<Container> RemoveChunk(const Container& container, int level,
+                                     int64_t index);
+
+// NumChunks()
+//
+// The number of chunks `RemoveChunk()` splits `size` elements into at
+// `level`. 0 if there is no such level.
+int64_t NumChunks(int64_t size, int level);
+
+// ChunkStart()
+//
+// The index of the first element of the `index`-th of `num_chunks` chunks of
+// `size` elements. `ChunkStart(size, num_chunks, num_chunks) == size`.
+int64_t ChunkStart(int64_t size, int64_t num_chunks, int64_t index);
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename Container>
+std::optional<Container> RemoveChunk(const Container& container, int level,
+                                     int64_t index) {
+  int64_t size = container.size();
+  int64_t num_chunks = NumChunks(size, level);
+  if (index < 0 || index >= num_chunks) return std::nullopt;
+
+  int64_t begin = ChunkStart(size, num_chunks, index);
+  int64_t end = ChunkStart(size, num_chunks, index + 1);
+  Container result;
+  result.reserve(size - (end - begin));
+  result.insert(result.end(), container.begin(), container.begin() + begin);
+  result.insert(result.end(), container.begin() + end, container.end());
+  return result;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_SHRINK_H_
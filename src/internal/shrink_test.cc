@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/shrink.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Optional;
+
+TEST(ShrinkTest, ShrinkTowardsZeroHalvesTheDistanceEachLevel) {
+  EXPECT_THAT(ShrinkTowardsZero(100, 0), Optional(0));
+  EXPECT_THAT(ShrinkTowardsZero(100, 1), Optional(50));
+  EXPECT_THAT(ShrinkTowardsZero(100, 2), Optional(75));
+  EXPECT_THAT(ShrinkTowardsZero(100, 6), Optional(99));
+  EXPECT_EQ(ShrinkTowardsZero(100, 7), std::nullopt);
+
+  EXPECT_THAT(ShrinkTowardsZero(-100, 1), Optional(-50));
+  EXPECT_EQ(ShrinkTowardsZero(0, 0), std::nullopt);
+}
+
+TEST(ShrinkTest, ShrinkTowardsZeroWorksAtTheExtremes) {
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  EXPECT_THAT(ShrinkTowardsZero(kMin, 0), Optional(0));
+  EXPECT_THAT(ShrinkTowardsZero(kMin, 63), Optional(kMin + 1));
+  EXPECT_THAT(ShrinkTowardsZero(kMax, 62), Optional(kMax - 1));
+  EXPECT_EQ(ShrinkTowardsZero(kMax, 63), std::nullopt);
+  EXPECT_EQ(ShrinkTowardsZero(kMin, 64), std::nullopt);
+}
+
+TEST(ShrinkTest, RemoveChunkSplitsIntoMoreChunksEachLevel) {
+  std::vector<int> v = {1, 2, 3, 4, 5, 6};
+  EXPECT_THAT(RemoveChunk(v, 0, 0), Optional(ElementsAre(4, 5, 6)));
+  EXPECT_THAT(RemoveChunk(v, 0, 1), Optional(ElementsAre(1, 2, 3)));
+  EXPECT_EQ(RemoveChunk(v, 0, 2), std::nullopt);
+
+  EXPECT_THAT(RemoveChunk(v, 1, 0), Optional(ElementsAre(2, 3, 4, 5, 6)));
+  EXPECT_THAT(RemoveChunk(v, 1, 1), Optional(ElementsAre(1, 4, 5, 6)));
+  EXPECT_THAT(RemoveChunk(v, 1, 3), Optional(ElementsAre(1, 2, 3, 4)));
+  EXPECT_EQ(RemoveChunk(v, 1, 4), std::nullopt);
+
+  // One chunk per element.
+  EXPECT_THAT(RemoveChunk(v, 2, 5), Optional(ElementsAre(1, 2, 3, 4, 5)));
+  EXPECT_EQ(RemoveChunk(v, 2, 6), std::nullopt);
+  EXPECT_EQ(RemoveChunk(v, 3, 0), std::nullopt);
+}
+
+TEST(ShrinkTest, RemoveChunkWorksOnStrings) {
+  EXPECT_THAT(RemoveChunk(std::string("abcd"), 0, 1),
+              Optional(std::string("ab")));
+  EXPECT_THAT(RemoveChunk(std::string("a"), 0, 0), Optional(std::string("")));
+  EXPECT_EQ(RemoveChunk(std::string("a"), 1, 0), std::nullopt);
+  EXPECT_EQ(RemoveChunk(std::string(""), 0, 0), std::nullopt);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -31,7 +31,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
-#include "src/internal/random_config.h"
+#include "absl/types/span.h"
 #include "src/internal/random_engine.h"
 #include "src/util/status_macro/status_macros.h"
 
@@ -366,39 +366,6 @@ absl::StatusOr<PatternNode> ParseScopePrefix(absl::string_view pattern) {
   return anyof_node;
 }
 
-absl::StatusOr<int64_t> MatchesPrefixLength(const PatternNode& pattern_node,
-                                            absl::string_view str) {
-  MORIARTY_ASSIGN_OR_RETURN(
-      int64_t prefix_length,
-      pattern_node.repeated_character_set.LongestValidPrefix(str));
-  str.remove_prefix(prefix_length);
-
-  for (const PatternNode& subpattern : pattern_node.subpatterns) {
-    absl::StatusOr<int64_t> subpattern_length =
-        MatchesPrefixLength(subpattern, str);
-    if (!subpattern_length.ok()) {
-      if (pattern_node.subpattern_type == PatternNode::SubpatternType::kAllOf) {
-        return absl::InvalidArgumentError("Invalid subpattern.");
-      }
-      continue;  // We are in a kAnyOf, so we don't *have* to match this.
-    }
-
-    prefix_length += *subpattern_length;
-
-    if (pattern_node.subpattern_type == PatternNode::SubpatternType::kAnyOf) {
-      return prefix_length;
-    }
-
-    str.remove_prefix(*subpattern_length);
-  }
-
-  if (pattern_node.subpattern_type == PatternNode::SubpatternType::kAnyOf) {
-    // We are in a kAnyOf, but we didn't match anything...
-    return absl::InvalidArgumentError("Invalid subpattern.");
-  }
-  return prefix_length;
-}
-
 absl::StatusOr<SimplePattern> SimplePattern::Create(absl::string_view pattern) {
   MORIARTY_ASSIGN_OR_RETURN(std::string sanitized_pattern, Sanitize(pattern));
   if (sanitized_pattern.empty())
@@ -415,34 +382,101 @@ absl::StatusOr<SimplePattern> SimplePattern::Create(absl::string_view pattern) {
         "Invalid pattern. Extra characters found.");
   }
 
+  simple_pattern.matcher_nodes_.resize(1);
+  simple_pattern.CompileMatcher(simple_pattern.pattern_node_, 0);
+
   return simple_pattern;
 }
 
+void SimplePattern::CompileMatcher(const PatternNode& pattern_node,
+                                   int index) {
+  int first_subpattern = matcher_nodes_.size();
+  int num_subpatterns = pattern_node.subpatterns.size();
+  matcher_nodes_[index] = {
+      .repeated_character_set = pattern_node.repeated_character_set,
+      .subpattern_type = pattern_node.subpattern_type,
+      .first_subpattern = first_subpattern,
+      .num_subpatterns = num_subpatterns};
+
+  matcher_nodes_.resize(first_subpattern + num_subpatterns);
+  for (int i = 0; i < num_subpatterns; i++)
+    CompileMatcher(pattern_node.subpatterns[i], first_subpattern + i);
+}
+
 SimplePattern::SimplePattern(std::string pattern)
     : pattern_(std::move(pattern)) {}
 
 std::string SimplePattern::Pattern() const { return pattern_; }
 
+int64_t SimplePattern::MatchesPrefixLength(int index,
+                                           absl::string_view str) const {
+  const MatcherNode& node = matcher_nodes_[index];
+  const RepeatedCharSet& char_set = node.repeated_character_set;
+  const bool any_of =
+      node.subpattern_type == PatternNode::SubpatternType::kAnyOf;
+
+  // Same as `RepeatedCharSet::LongestValidPrefix()`, without the status.
+  int64_t prefix_length = 0;
+  while (prefix_length < str.size() &&
+         prefix_length < char_set.MaxLength() &&
+         char_set.IsValidCharacter(str[prefix_length])) {
+    prefix_length++;
+  }
+  if (prefix_length < char_set.MinLength()) return -1;
+  str.remove_prefix(prefix_length);
+
+  for (int i = 0; i < node.num_subpatterns; i++) {
+    int64_t subpattern_length =
+        MatchesPrefixLength(node.first_subpattern + i, str);
+    if (subpattern_length < 0) {
+      if (!any_of) return -1;
+      continue;  // We are in a kAnyOf, so we don't *have* to match this.
+    }
+
+    prefix_length += subpattern_length;
+    if (any_of) return prefix_length;
+    str.remove_prefix(subpattern_length);
+  }
+
+  // If we are in a kAnyOf, we didn't match anything...
+  return any_of ? -1 : prefix_length;
+}
+
 bool SimplePattern::Matches(absl::string_view str) const {
-  absl::StatusOr<int64_t> prefix_length =
-      MatchesPrefixLength(pattern_node_, str);
-  return prefix_length.ok() && *prefix_length == str.length();
+  int64_t prefix_length = MatchesPrefixLength(0, str);
+  return prefix_length >= 0 && prefix_length == str.length();
+}
+
+bool SimplePattern::AppendSequentialCharSets(
+    int index, std::vector<RepeatedCharSet>& char_sets) const {
+  const MatcherNode& node = matcher_nodes_[index];
+  // An or-expression with a single option is the same as that option.
+  if (node.subpattern_type == PatternNode::SubpatternType::kAnyOf &&
+      node.num_subpatterns != 1) {
+    return false;
+  }
+  char_sets.push_back(node.repeated_character_set);
+  for (int i = 0; i < node.num_subpatterns; i++) {
+    if (!AppendSequentialCharSets(node.first_subpattern + i, char_sets))
+      return false;
+  }
+  return true;
+}
+
+std::optional<std::vector<RepeatedCharSet>> SimplePattern::SequentialCharSets()
+    const {
+  std::vector<RepeatedCharSet> char_sets;
+  if (!AppendSequentialCharSets(0, char_sets)) return std::nullopt;
+  return char_sets;
 }
 
 namespace {
 
-absl::StatusOr<std::string> GenerateRepeatedCharSet(
+// Returns the characters in `char_set` which are also in `restricted_alphabet`
+// (if set).
+absl::StatusOr<std::vector<char>> RestrictedValidCharacters(
     const RepeatedCharSet& char_set,
-    std::optional<absl::string_view> restricted_alphabet,
-    RandomEngine& random_engine) {
-  if (char_set.MaxLength() == std::numeric_limits<int64_t>::max()) {
-    return absl::InvalidArgumentError(
-        "Cannot generate with `*` or `+` or large lengths.");
-  }
-  MORIARTY_ASSIGN_OR_RETURN(
-      int64_t len,
-      random_engine.RandInt(char_set.MinLength(), char_set.MaxLength()));
-
+    std::optional<absl::string_view> restricted_alphabet) {
   RepeatedCharSet restricted_char_set;
   if (restricted_alphabet.has_value()) {
     for (char c : *restricted_alphabet) {
@@ -455,49 +489,208 @@ absl::StatusOr<std::string> GenerateRepeatedCharSet(
   for (char c : char_set.ValidCharacters()) {
     if (restricted_char_set.IsValidCharacter(c)) valid_chars.push_back(c);
   }
+  return valid_chars;
+}
+
+// The characters that generated strings may use: those in
+// `restricted_alphabet` if it is set, and all characters otherwise.
+absl::StatusOr<RepeatedCharSet> AllowedCharacters(
+    std::optional<absl::string_view> restricted_alphabet) {
+  RepeatedCharSet allowed;
+  if (restricted_alphabet.has_value()) {
+    for (char c : *restricted_alphabet) {
+      MORIARTY_RETURN_IF_ERROR(allowed.Add(c));
+    }
+  } else {
+    allowed.FlipValidCharacters();  // Allow all characters.
+  }
+  return allowed;
+}
+
+// Appends a random string from `char_set` (with characters in `allowed`) to
+// `result`. The characters are drawn straight into `result`.
+absl::Status AppendRepeatedCharSet(const RepeatedCharSet& char_set,
+                                   const RepeatedCharSet& allowed,
+                                   RandomEngine& random_engine,
+                                   std::string& result) {
+  if (char_set.MaxLength() == std::numeric_limits<int64_t>::max()) {
+    return absl::InvalidArgumentError(
+        "Cannot generate with `*` or `+` or large lengths.");
+  }
+  MORIARTY_ASSIGN_OR_RETURN(
+      int64_t len,
+      random_engine.RandInt(char_set.MinLength(), char_set.MaxLength()));
+
+  char valid_chars[128];
+  int num_valid_chars = 0;
+  for (int c = 0; c < 128; c++) {
+    if (char_set.IsValidCharacter(c) && allowed.IsValidCharacter(c))
+      valid_chars[num_valid_chars++] = c;
+  }
 
-  if (valid_chars.empty()) {
+  if (num_valid_chars == 0) {
     // No valid characters, so the only valid string is the empty string.
-    if (char_set.MinLength() <= 0) return "";
+    if (char_set.MinLength() <= 0) return absl::OkStatus();
     return absl::InvalidArgumentError(
         "No valid characters for generation, but empty string is not "
         "allowed.");
   }
 
+  size_t begin = result.size();
+  result.resize(begin + len);
+  absl::Span<uint8_t> indices = absl::MakeSpan(
+      reinterpret_cast<uint8_t*>(result.data() + begin), len);
+  MORIARTY_RETURN_IF_ERROR(random_engine.RandIndices(num_valid_chars, indices));
+  for (uint8_t& index : indices) index = valid_chars[index];
+  return absl::OkStatus();
+}
+
+// Addition and multiplication of non-negative counts, saturating at
+// `SimplePattern::kMaxCount`.
+int64_t SaturatingAdd(int64_t a, int64_t b) {
+  return a > SimplePattern::kMaxCount - b ? SimplePattern::kMaxCount : a + b;
+}
+
+int64_t SaturatingMultiply(int64_t a, int64_t b) {
+  if (a == 0 || b == 0) return 0;
+  return a > SimplePattern::kMaxCount / b ? SimplePattern::kMaxCount : a * b;
+}
+
+// The number of strings of length `len` made from `num_chars` characters.
+int64_t SaturatingPower(int64_t num_chars, int64_t len) {
+  int64_t result = 1;
+  for (int64_t i = 0; i < len && result < SimplePattern::kMaxCount; i++)
+    result = SaturatingMultiply(result, num_chars);
+  return result;
+}
+
+absl::StatusOr<int64_t> CountRepeatedCharSet(
+    const RepeatedCharSet& char_set,
+    std::optional<absl::string_view> restricted_alphabet) {
   MORIARTY_ASSIGN_OR_RETURN(
-      std::vector<char> result,
-      RandomElementsWithReplacement(random_engine, valid_chars, len));
-  return std::string(result.begin(), result.end());
+      std::vector<char> valid_chars,
+      RestrictedValidCharacters(char_set, restricted_alphabet));
+  // Matches `GenerateRepeatedCharSet()`: only the empty string is possible.
+  if (valid_chars.empty()) return char_set.MinLength() <= 0 ? 1 : 0;
+  if (valid_chars.size() == 1)
+    return SaturatingAdd(char_set.MaxLength() - char_set.MinLength(), 1);
+
+  int64_t count = 0;
+  for (int64_t len = char_set.MinLength();
+       len <= char_set.MaxLength() && count < SimplePattern::kMaxCount; len++) {
+    count = SaturatingAdd(count, SaturatingPower(valid_chars.size(), len));
+  }
+  return count;
 }
 
-absl::StatusOr<std::string> GeneratePatternNode(
+// Returns the number of strings for the subpatterns of `node` (that is, after
+// its repeated character set).
+absl::StatusOr<int64_t> CountSubpatterns(
     const PatternNode& node,
-    std::optional<absl::string_view> restricted_alphabet,
-    RandomEngine& random_engine) {
+    std::optional<absl::string_view> restricted_alphabet);
+
+absl::StatusOr<int64_t> CountPatternNode(
+    const PatternNode& node,
+    std::optional<absl::string_view> restricted_alphabet) {
   MORIARTY_ASSIGN_OR_RETURN(
-      std::string result,
-      GenerateRepeatedCharSet(node.repeated_character_set, restricted_alphabet,
-                              random_engine));
+      int64_t char_set_count,
+      CountRepeatedCharSet(node.repeated_character_set, restricted_alphabet));
+  MORIARTY_ASSIGN_OR_RETURN(int64_t subpatterns_count,
+                            CountSubpatterns(node, restricted_alphabet));
+  return SaturatingMultiply(char_set_count, subpatterns_count);
+}
 
-  if (node.subpatterns.empty()) return result;
+absl::StatusOr<int64_t> CountSubpatterns(
+    const PatternNode& node,
+    std::optional<absl::string_view> restricted_alphabet) {
+  if (node.subpatterns.empty()) return 1;
 
-  if (node.subpattern_type == PatternNode::SubpatternType::kAnyOf) {
-    MORIARTY_ASSIGN_OR_RETURN(int64_t idx,
-                              random_engine.RandInt(node.subpatterns.size()));
+  const bool any_of =
+      node.subpattern_type == PatternNode::SubpatternType::kAnyOf;
+  int64_t count = any_of ? 0 : 1;
+  for (const PatternNode& subpattern : node.subpatterns) {
     MORIARTY_ASSIGN_OR_RETURN(
-        std::string subresult,
-        GeneratePatternNode(node.subpatterns[idx], restricted_alphabet,
-                            random_engine));
-    return absl::StrCat(result, subresult);
+        int64_t subpattern_count,
+        CountPatternNode(subpattern, restricted_alphabet));
+    count = any_of ? SaturatingAdd(count, subpattern_count)
+                   : SaturatingMultiply(count, subpattern_count);
   }
+  return count;
+}
 
-  for (const PatternNode& subpattern : node.subpatterns) {
+// In all of the `Unrank` functions below, `rank` is less than the appropriate
+// count. When a count has saturated, its true value is larger than `rank`, so
+// dividing by (or subtracting) the saturated value gives the same result.
+
+absl::Status UnrankRepeatedCharSet(
+    const RepeatedCharSet& char_set,
+    std::optional<absl::string_view> restricted_alphabet, int64_t rank,
+    std::string& result) {
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<char> valid_chars,
+      RestrictedValidCharacters(char_set, restricted_alphabet));
+  if (valid_chars.empty()) return absl::OkStatus();
+  if (valid_chars.size() == 1) {
+    result.append(char_set.MinLength() + rank, valid_chars[0]);
+    return absl::OkStatus();
+  }
+
+  int64_t len = char_set.MinLength();
+  for (;; len++) {
+    int64_t count = SaturatingPower(valid_chars.size(), len);
+    if (rank < count) break;
+    rank -= count;
+  }
+
+  // Write `rank` in base `num_chars`, with `len` digits.
+  const int64_t num_chars = valid_chars.size();
+  result.append(len, valid_chars[0]);
+  for (size_t i = result.size(); rank > 0; i--) {
+    result[i - 1] = valid_chars[rank % num_chars];
+    rank /= num_chars;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status UnrankPatternNode(
+    const PatternNode& node,
+    std::optional<absl::string_view> restricted_alphabet, int64_t rank,
+    std::string& result) {
+  MORIARTY_ASSIGN_OR_RETURN(int64_t subpatterns_count,
+                            CountSubpatterns(node, restricted_alphabet));
+  MORIARTY_RETURN_IF_ERROR(UnrankRepeatedCharSet(
+      node.repeated_character_set, restricted_alphabet,
+      rank / subpatterns_count, result));
+  rank %= subpatterns_count;
+
+  if (node.subpatterns.empty()) return absl::OkStatus();
+
+  if (node.subpattern_type == PatternNode::SubpatternType::kAnyOf) {
+    for (const PatternNode& subpattern : node.subpatterns) {
+      MORIARTY_ASSIGN_OR_RETURN(
+          int64_t count, CountPatternNode(subpattern, restricted_alphabet));
+      if (rank < count)
+        return UnrankPatternNode(subpattern, restricted_alphabet, rank, result);
+      rank -= count;
+    }
+    return absl::InternalError("Rank larger than number of strings.");
+  }
+
+  // The first subpattern is the most significant "digit".
+  std::vector<int64_t> suffix_counts(node.subpatterns.size() + 1, 1);
+  for (int i = node.subpatterns.size() - 1; i >= 0; i--) {
     MORIARTY_ASSIGN_OR_RETURN(
-        std::string subresult,
-        GeneratePatternNode(subpattern, restricted_alphabet, random_engine));
-    absl::StrAppend(&result, subresult);
+        int64_t count,
+        CountPatternNode(node.subpatterns[i], restricted_alphabet));
+    suffix_counts[i] = SaturatingMultiply(count, suffix_counts[i + 1]);
   }
-  return result;
+  for (int i = 0; i < node.subpatterns.size(); i++) {
+    MORIARTY_RETURN_IF_ERROR(
+        UnrankPatternNode(node.subpatterns[i], restricted_alphabet,
+                          rank / suffix_counts[i + 1], result));
+    rank %= suffix_counts[i + 1];
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace
@@ -511,7 +704,66 @@ absl::StatusOr<std::string> SimplePattern::Generate(
 absl::StatusOr<std::string> SimplePattern::GenerateWithRestrictions(
     std::optional<absl::string_view> restricted_alphabet,
     RandomEngine& random_engine) const {
-  return GeneratePatternNode(pattern_node_, restricted_alphabet, random_engine);
+  MORIARTY_ASSIGN_OR_RETURN(RepeatedCharSet allowed,
+                            AllowedCharacters(restricted_alphabet));
+
+  // Walks the nodes in the same order as a recursive pre-order traversal: a
+  // node's character set, then its chosen (or all) subpatterns left to right.
+  std::string result;
+  std::vector<const PatternNode*> stack = {&pattern_node_};
+  while (!stack.empty()) {
+    const PatternNode& node = *stack.back();
+    stack.pop_back();
+    MORIARTY_RETURN_IF_ERROR(AppendRepeatedCharSet(
+        node.repeated_character_set, allowed, random_engine, result));
+    if (node.subpatterns.empty()) continue;
+
+    if (node.subpattern_type == PatternNode::SubpatternType::kAnyOf) {
+      MORIARTY_ASSIGN_OR_RETURN(int64_t idx,
+                                random_engine.RandInt(node.subpatterns.size()));
+      stack.push_back(&node.subpatterns[idx]);
+      continue;
+    }
+    for (auto it = node.subpatterns.rbegin(); it != node.subpatterns.rend();
+         ++it) {
+      stack.push_back(&*it);
+    }
+  }
+  return result;
+}
+
+absl::StatusOr<int64_t> SimplePattern::Count(
+    std::optional<absl::string_view> restricted_alphabet) const {
+  return CountPatternNode(pattern_node_, restricted_alphabet);
+}
+
+absl::StatusOr<std::string> SimplePattern::Unrank(
+    int64_t rank, std::optional<absl::string_view> restricted_alphabet) const {
+  MORIARTY_ASSIGN_OR_RETURN(int64_t count, Count(restricted_alphabet));
+  if (rank < 0 || rank >= count) {
+    return absl::OutOfRangeError(absl::Substitute(
+        "Rank $0 is not in [0, $1) for pattern $2", rank, count, pattern_));
+  }
+
+  std::string result;
+  MORIARTY_RETURN_IF_ERROR(
+      UnrankPatternNode(pattern_node_, restricted_alphabet, rank, result));
+  return result;
+}
+
+absl::StatusOr<std::string> SimplePattern::GenerateUniformly(
+    RandomEngine& random_engine,
+    std::optional<absl::string_view> restricted_alphabet) const {
+  MORIARTY_ASSIGN_OR_RETURN(int64_t count, Count(restricted_alphabet));
+  if (count == kMaxCount) {
+    return absl::InvalidArgumentError(
+        "Too many strings match the pattern to generate uniformly.");
+  }
+  if (count == 0) {
+    return absl::InvalidArgumentError("No strings match the pattern.");
+  }
+  MORIARTY_ASSIGN_OR_RETURN(int64_t rank, random_engine.RandInt(count));
+  return Unrank(rank, restricted_alphabet);
 }
 
 }  // namespace moriarty_internal
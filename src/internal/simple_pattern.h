@@ -19,6 +19,7 @@
 
 #include <bitset>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <vector>
@@ -205,11 +206,84 @@ class SimplePattern {
       std::optional<absl::string_view> restricted_alphabet,
       RandomEngine& random_engine) const;
 
+  // Enumeration
+  //
+  // The strings `Generate()` may produce can be enumerated. They are ordered
+  // by each repeated character set from left to right: first by length, then
+  // lexicographically. Or-expressions list their options from left to right.
+  //
+  // Like `Generate()`, these describe the strings built from the pattern, not
+  // the strings accepted by `Matches()`. If the pattern is ambiguous (e.g.,
+  // "a|a" or "a?a?"), the same string appears more than once.
+  //
+  // If `restricted_alphabet` is set, only strings with characters from that
+  // string are considered.
+
+  // Count()
+  //
+  // Returns the number of strings in the enumeration. Saturates at
+  // `kMaxCount`, which `*` and `+` (almost) always hit.
+  static constexpr int64_t kMaxCount = std::numeric_limits<int64_t>::max();
+  absl::StatusOr<int64_t> Count(
+      std::optional<absl::string_view> restricted_alphabet = std::nullopt)
+      const;
+
+  // Unrank()
+  //
+  // Returns the `rank`-th string (0-indexed) in the enumeration. Returns
+  // `absl::kOutOfRange` if `rank` is not in [0, Count()).
+  absl::StatusOr<std::string> Unrank(
+      int64_t rank,
+      std::optional<absl::string_view> restricted_alphabet = std::nullopt)
+      const;
+
+  // GenerateUniformly()
+  //
+  // Generates a string in the enumeration, where each rank is equally likely
+  // (unlike `Generate()`, which picks each component independently). Returns
+  // `absl::kInvalidArgument` if `Count()` saturates.
+  absl::StatusOr<std::string> GenerateUniformly(
+      RandomEngine& random_engine,
+      std::optional<absl::string_view> restricted_alphabet = std::nullopt)
+      const;
+
+  // SequentialCharSets()
+  //
+  // Returns the repeated character sets of the pattern, in the order that
+  // `Matches()` consumes them. Returns `std::nullopt` if the pattern has an
+  // or-expression with more than one option, since it is then not a single
+  // sequence of character sets.
+  std::optional<std::vector<RepeatedCharSet>> SequentialCharSets() const;
+
  private:
   explicit SimplePattern(std::string pattern);
 
+  // A flattened copy of a `PatternNode`, used by `Matches()`. The children of
+  // a node are stored contiguously in `matcher_nodes_`, starting at
+  // `first_subpattern`. Unlike `PatternNode`, this does not point into
+  // `pattern_`.
+  struct MatcherNode {
+    RepeatedCharSet repeated_character_set;
+    PatternNode::SubpatternType subpattern_type;
+    int first_subpattern;
+    int num_subpatterns;
+  };
+
+  // Flattens `pattern_node` into `matcher_nodes_[index]`, then its children.
+  void CompileMatcher(const PatternNode& pattern_node, int index);
+
+  // Returns the length of the prefix of `str` matched by
+  // `matcher_nodes_[index]`, or -1 if it does not match.
+  int64_t MatchesPrefixLength(int index, absl::string_view str) const;
+
+  // Appends the character sets of `matcher_nodes_[index]` to `char_sets`.
+  // Returns false if it has an or-expression with more than one option.
+  bool AppendSequentialCharSets(int index,
+                                std::vector<RepeatedCharSet>& char_sets) const;
+
   std::string pattern_;
   PatternNode pattern_node_;
+  std::vector<MatcherNode> matcher_nodes_;
 };
 
 // Returns the length of the prefix that corresponds to a character set. This
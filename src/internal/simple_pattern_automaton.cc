@@ -0,0 +1,396 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/simple_pattern_automaton.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "src/internal/alias_table.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/simple_pattern.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+constexpr int kRejectedState = -1;
+
+// The length of the longest string that `char_sets` may match (saturating at
+// the int64_t maximum).
+int64_t MaxMatchLength(absl::Span<const RepeatedCharSet> char_sets) {
+  int64_t length = 0;
+  for (const RepeatedCharSet& char_set : char_sets) {
+    if (char_set.MaxLength() > std::numeric_limits<int64_t>::max() - length)
+      return std::numeric_limits<int64_t>::max();
+    length += char_set.MaxLength();
+  }
+  return length;
+}
+
+// The automaton for a single pattern without or-expressions, which greedily
+// matches its character sets one after another (as `SimplePattern::Matches()`
+// does). A state is a character set and the number of characters it has
+// matched so far. Only strings of length at most `max_length` are considered,
+// so counts that can no longer reach a character set's maximum are merged.
+class SequenceAutomaton {
+ public:
+  // Returns `std::nullopt` if the automaton would have more than `max_states`
+  // states.
+  static std::optional<SequenceAutomaton> Create(
+      std::vector<RepeatedCharSet> char_sets, int64_t max_length,
+      int max_states) {
+    SequenceAutomaton automaton;
+    const int n = char_sets.size();
+    automaton.suffix_is_optional_.assign(n + 1, true);
+    for (int i = n - 1; i >= 0; i--) {
+      automaton.suffix_is_optional_[i] =
+          automaton.suffix_is_optional_[i + 1] &&
+          char_sets[i].MinLength() == 0;
+    }
+
+    int64_t num_states = 0;
+    for (const RepeatedCharSet& char_set : char_sets) {
+      if (char_set.MinLength() > max_length) {
+        automaton.matches_nothing_ = true;
+        return automaton;
+      }
+      bool bounded = char_set.MaxLength() <= max_length;
+      int64_t max_count = bounded ? char_set.MaxLength() : char_set.MinLength();
+      automaton.first_state_.push_back(num_states);
+      automaton.bounded_.push_back(bounded);
+      num_states += max_count + 1;
+      if (num_states > max_states) return std::nullopt;
+    }
+    automaton.first_state_.push_back(num_states);  // After every character set.
+    automaton.char_sets_ = std::move(char_sets);
+    return automaton;
+  }
+
+  bool MatchesNothing() const { return matches_nothing_; }
+
+  int StartState() const { return 0; }
+
+  // Returns the state after reading `c` in `state`.
+  int Next(int state, char c) const {
+    auto [index, count] = Decode(state);
+    for (; index < char_sets_.size(); index++, count = 0) {
+      const RepeatedCharSet& char_set = char_sets_[index];
+      if (char_set.IsValidCharacter(c) &&
+          (!bounded_[index] || count < char_set.MaxLength())) {
+        int64_t next_count = bounded_[index]
+                                 ? count + 1
+                                 : std::min(count + 1, char_set.MinLength());
+        return first_state_[index] + next_count;
+      }
+      if (count < char_set.MinLength()) return kRejectedState;
+    }
+    return kRejectedState;
+  }
+
+  bool IsAccepting(int state) const {
+    auto [index, count] = Decode(state);
+    if (index == char_sets_.size()) return true;
+    return count >= char_sets_[index].MinLength() &&
+           suffix_is_optional_[index + 1];
+  }
+
+  // Returns true if some character set accepts `c`.
+  bool UsesCharacter(char c) const {
+    return std::any_of(
+        char_sets_.begin(), char_sets_.end(),
+        [c](const RepeatedCharSet& set) { return set.IsValidCharacter(c); });
+  }
+
+ private:
+  // Returns the character set and count of `state`.
+  std::pair<int, int64_t> Decode(int state) const {
+    int index = std::upper_bound(first_state_.begin(), first_state_.end(),
+                                 state) -
+                first_state_.begin() - 1;
+    return {index, state - first_state_[index]};
+  }
+
+  std::vector<RepeatedCharSet> char_sets_;
+  // The state of each character set with a count of 0, followed by the state
+  // after all character sets.
+  std::vector<int> first_state_;
+  // If a character set's maximum may be reached.
+  std::vector<bool> bounded_;
+  // Whether all character sets from each index onwards may be empty.
+  std::vector<bool> suffix_is_optional_;
+  bool matches_nothing_ = false;
+};
+
+// Returns integer weights proportional to `counts[i] * 2^exponents[i]`
+// (rounded down to about 57 significant bits), whose total fits in an int64_t.
+// The largest weight is positive. Only exact floating-point operations are
+// used, so the weights do not depend on the platform.
+std::vector<int64_t> IntegerWeights(absl::Span<const double> counts,
+                                    absl::Span<const int64_t> exponents) {
+  // Each count is mantissa * 2^(exponent + frexp exponent), with the mantissa
+  // in [0.5, 1).
+  std::vector<int64_t> total_exponents(counts.size());
+  int64_t largest_exponent = std::numeric_limits<int64_t>::min();
+  for (int i = 0; i < counts.size(); i++) {
+    if (counts[i] <= 0) continue;
+    int exponent;
+    std::frexp(counts[i], &exponent);
+    total_exponents[i] = exponents[i] + exponent;
+    largest_exponent = std::max(largest_exponent, total_exponents[i]);
+  }
+
+  // Each weight is below 2^bits, so their total is below 2^62.
+  const int bits = 62 - std::bit_width(counts.size());
+  std::vector<int64_t> weights(counts.size(), 0);
+  for (int i = 0; i < counts.size(); i++) {
+    if (counts[i] <= 0) continue;
+    int64_t shift = total_exponents[i] - largest_exponent;
+    if (shift < -bits) continue;  // Rounds to 0.
+    int exponent;
+    double mantissa = std::frexp(counts[i], &exponent);
+    weights[i] = static_cast<int64_t>(std::ldexp(mantissa, bits + shift));
+  }
+  return weights;
+}
+
+// Returns an index in `weights`, each with probability proportional to its
+// weight.
+absl::StatusOr<int64_t> PickWeighted(absl::Span<const int64_t> weights,
+                                     RandomEngine& random_engine) {
+  MORIARTY_ASSIGN_OR_RETURN(AliasTable table, AliasTable::Create(weights));
+  return table.Sample(random_engine);
+}
+
+}  // namespace
+
+absl::StatusOr<SimplePatternAutomaton> SimplePatternAutomaton::Create(
+    absl::Span<const SimplePattern> patterns,
+    std::optional<absl::string_view> alphabet, int64_t min_length,
+    int64_t max_length) {
+  SimplePatternAutomaton automaton;
+  automaton.min_length_ = std::max<int64_t>(min_length, 0);
+
+  std::vector<std::vector<RepeatedCharSet>> all_char_sets;
+  for (const SimplePattern& pattern : patterns) {
+    std::optional<std::vector<RepeatedCharSet>> char_sets =
+        pattern.SequentialCharSets();
+    if (!char_sets) {
+      return absl::UnimplementedError(
+          "Only simple patterns without or-expressions are supported.");
+    }
+    // No string may be longer than what each pattern can match.
+    max_length = std::min(max_length, MaxMatchLength(*char_sets));
+    all_char_sets.push_back(*std::move(char_sets));
+  }
+  if (max_length >= kMaxTableSize) {
+    return absl::UnimplementedError(
+        "The length of the string is not bounded enough to count the strings "
+        "that match the simple patterns.");
+  }
+  // If no length is allowed, keep `max_length_ < min_length_`.
+  automaton.max_length_ = std::max(max_length, automaton.min_length_ - 1);
+
+  std::vector<SequenceAutomaton> sequences;
+  for (std::vector<RepeatedCharSet>& char_sets : all_char_sets) {
+    std::optional<SequenceAutomaton> sequence = SequenceAutomaton::Create(
+        std::move(char_sets), max_length, kMaxStates);
+    if (!sequence) {
+      return absl::UnimplementedError(
+          "The simple patterns have too many states to be combined.");
+    }
+    if (sequence->MatchesNothing()) {
+      // A single state that rejects everything.
+      automaton.accepting_ = {false};
+      automaton.transitions_.assign(automaton.alphabet_.size(), kRejected);
+      automaton.CountStrings();
+      return automaton;
+    }
+    sequences.push_back(*std::move(sequence));
+  }
+
+  // Characters that every pattern (and the alphabet) allows.
+  for (int c = 0; c < 128; c++) {
+    if (alphabet && !absl::StrContains(*alphabet, static_cast<char>(c)))
+      continue;
+    if (std::all_of(sequences.begin(), sequences.end(),
+                    [c](const SequenceAutomaton& sequence) {
+                      return sequence.UsesCharacter(c);
+                    })) {
+      automaton.alphabet_.push_back(c);
+    }
+  }
+
+  // Explore the product of the automata from the start state.
+  absl::flat_hash_map<std::vector<int>, int> state_ids;
+  std::deque<std::vector<int>> queue;
+  std::vector<int> start;
+  for (const SequenceAutomaton& sequence : sequences)
+    start.push_back(sequence.StartState());
+  state_ids[start] = 0;
+  queue.push_back(start);
+  automaton.accepting_.push_back(false);
+
+  for (int state = 0; !queue.empty(); state++) {
+    std::vector<int> states = std::move(queue.front());
+    queue.pop_front();
+    bool accepting = true;
+    for (int i = 0; i < states.size(); i++)
+      accepting = accepting && sequences[i].IsAccepting(states[i]);
+    automaton.accepting_[state] = accepting;
+
+    for (char c : automaton.alphabet_) {
+      std::vector<int> next;
+      next.reserve(states.size());
+      for (int i = 0; i < states.size(); i++) {
+        int s = sequences[i].Next(states[i], c);
+        if (s == kRejectedState) break;
+        next.push_back(s);
+      }
+      if (next.size() != states.size()) {
+        automaton.transitions_.push_back(kRejected);
+        continue;
+      }
+      auto [it, inserted] = state_ids.emplace(next, state_ids.size());
+      if (inserted) {
+        if (state_ids.size() > kMaxStates) {
+          return absl::UnimplementedError(
+              "The simple patterns have too many states to be combined.");
+        }
+        queue.push_back(std::move(next));
+        automaton.accepting_.push_back(false);
+      }
+      automaton.transitions_.push_back(it->second);
+    }
+  }
+
+  if ((automaton.max_length_ + 1) * automaton.NumStates() > kMaxTableSize) {
+    return absl::UnimplementedError(
+        "The simple patterns have too many strings to count.");
+  }
+  automaton.CountStrings();
+  return automaton;
+}
+
+void SimplePatternAutomaton::CountStrings() {
+  const int num_states = NumStates();
+  const int64_t num_lengths = std::max<int64_t>(max_length_, 0) + 1;
+  counts_.assign(num_lengths * num_states, 0.0);
+  scale_exponents_.assign(num_lengths, 0);
+  for (int state = 0; state < num_states; state++)
+    counts_[state] = accepting_[state] ? 1.0 : 0.0;
+
+  for (int64_t t = 1; t <= max_length_; t++) {
+    const double* previous = &counts_[(t - 1) * num_states];
+    double* current = &counts_[t * num_states];
+    double largest = 0;
+    for (int state = 0; state < num_states; state++) {
+      double count = 0;
+      for (int i = 0; i < alphabet_.size(); i++) {
+        int next = Next(state, i);
+        if (next != kRejected) count += previous[next];
+      }
+      current[state] = count;
+      largest = std::max(largest, count);
+    }
+    scale_exponents_[t] = scale_exponents_[t - 1];
+    if (largest > 0) {
+      // Dividing by a power of two is exact.
+      int exponent;
+      std::frexp(largest, &exponent);
+      for (int state = 0; state < num_states; state++)
+        current[state] = std::ldexp(current[state], -exponent);
+      scale_exponents_[t] += exponent;
+    }
+  }
+}
+
+int SimplePatternAutomaton::CharIndex(char c) const {
+  auto it = std::lower_bound(alphabet_.begin(), alphabet_.end(), c);
+  if (it == alphabet_.end() || *it != c) return -1;
+  return it - alphabet_.begin();
+}
+
+bool SimplePatternAutomaton::Accepts(absl::string_view str) const {
+  if (str.size() < min_length_ || str.size() > max_length_) return false;
+  int state = 0;
+  for (char c : str) {
+    int char_index = CharIndex(c);
+    if (char_index == -1) return false;
+    state = Next(state, char_index);
+    if (state == kRejected) return false;
+  }
+  return accepting_[state];
+}
+
+absl::StatusOr<std::string> SimplePatternAutomaton::Generate(
+    RandomEngine& random_engine) const {
+  // Pick the length, weighted by the number of strings of that length.
+  std::vector<double> counts;
+  std::vector<int64_t> exponents;
+  for (int64_t length = min_length_; length <= max_length_; length++) {
+    counts.push_back(counts_[length * NumStates()]);
+    exponents.push_back(scale_exponents_[length]);
+  }
+  if (absl::c_none_of(counts, [](double count) { return count > 0; })) {
+    return absl::InvalidArgumentError(
+        "No string with the given length and alphabet matches all of the "
+        "simple patterns.");
+  }
+  MORIARTY_ASSIGN_OR_RETURN(
+      int64_t length_index,
+      PickWeighted(IntegerWeights(counts, exponents), random_engine));
+  int64_t length = min_length_ + length_index;
+
+  // Then each character, weighted by the number of ways to finish the string.
+  // All of them have the same scale.
+  std::string result;
+  result.reserve(length);
+  counts.resize(alphabet_.size());
+  exponents.assign(alphabet_.size(), 0);
+  int state = 0;
+  for (int64_t remaining = length; remaining > 0; remaining--) {
+    const double* row = &counts_[(remaining - 1) * NumStates()];
+    for (int i = 0; i < alphabet_.size(); i++) {
+      int next = Next(state, i);
+      counts[i] = next == kRejected ? 0 : row[next];
+    }
+    MORIARTY_ASSIGN_OR_RETURN(
+        int64_t char_index,
+        PickWeighted(IntegerWeights(counts, exponents), random_engine));
+    result.push_back(alphabet_[char_index]);
+    state = Next(state, char_index);
+  }
+  return result;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_SIMPLE_PATTERN_AUTOMATON_H_
+#define MORIARTY_SRC_INTERNAL_SIMPLE_PATTERN_AUTOMATON_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/simple_pattern.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// SimplePatternAutomaton
+//
+// A deterministic automaton that accepts the strings which match every one of
+// several `SimplePattern`s (with the same greedy semantics as
+// `SimplePattern::Matches()`), only use characters from an alphabet and have a
+// length in some range. It also counts the accepted strings of each length, so
+// it can generate an accepted string uniformly at random without rejection.
+//
+// Only patterns without or-expressions are supported (see
+// `SimplePattern::SequentialCharSets()`).
+class SimplePatternAutomaton {
+ public:
+  // The largest automaton and table of counts (states times lengths) that
+  // `Create()` builds.
+  static constexpr int kMaxStates = 1 << 12;
+  static constexpr int64_t kMaxTableSize = 1 << 22;
+
+  // Create()
+  //
+  // Builds the automaton for the strings with length in [`min_length`,
+  // `max_length`] that match all of `patterns` and only use characters in
+  // `alphabet` (if set; otherwise, any character the patterns allow).
+  //
+  // Returns `absl::kUnimplemented` if a pattern has an or-expression, or if the
+  // automaton would be too large (e.g., when neither `max_length` nor the
+  // patterns bound the length of the string).
+  static absl::StatusOr<SimplePatternAutomaton> Create(
+      absl::Span<const SimplePattern> patterns,
+      std::optional<absl::string_view> alphabet, int64_t min_length,
+      int64_t max_length);
+
+  // Accepts()
+  //
+  // Returns true if `str` is accepted by this automaton.
+  bool Accepts(absl::string_view str) const;
+
+  // Generate()
+  //
+  // Returns one of the accepted strings, each with the same probability (up to
+  // floating-point rounding). All randomness comes from `random_engine`.
+  // Returns `absl::kInvalidArgument` if no string is accepted.
+  absl::StatusOr<std::string> Generate(RandomEngine& random_engine) const;
+
+  // NumStates()
+  //
+  // The number of states, not including the (implicit) rejecting state.
+  int NumStates() const { return accepting_.size(); }
+
+ private:
+  static constexpr int kRejected = -1;
+
+  SimplePatternAutomaton() = default;
+
+  // Returns the state after reading `alphabet_[char_index]` in `state`.
+  int Next(int state, int char_index) const {
+    return transitions_[state * alphabet_.size() + char_index];
+  }
+
+  // Returns the index of `c` in `alphabet_`, or -1 if it is not there.
+  int CharIndex(char c) const;
+
+  // Fills `counts_` and `scale_exponents_`.
+  void CountStrings();
+
+  // The start state is 0.
+  std::vector<char> alphabet_;
+  std::vector<int> transitions_;
+  std::vector<bool> accepting_;
+  int64_t min_length_ = 0;
+  int64_t max_length_ = 0;
+
+  // `counts_[t * NumStates() + state]` is proportional to the number of strings
+  // of length `t` that lead from `state` to an accepting state. The counts of
+  // each length are divided by `2^scale_exponents_[t]` so that the largest is
+  // in [0.5, 1). Only powers of two are used, so the counts do not depend on
+  // the platform's math library.
+  std::vector<double> counts_;
+  std::vector<int64_t> scale_exponents_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_SIMPLE_PATTERN_AUTOMATON_H_
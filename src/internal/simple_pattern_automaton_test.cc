@@ -0,0 +1,206 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/simple_pattern_automaton.h"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/simple_pattern.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::moriarty::IsOk;
+using ::moriarty::StatusIs;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::SizeIs;
+
+std::vector<SimplePattern> CreatePatterns(
+    const std::vector<std::string>& patterns) {
+  std::vector<SimplePattern> simple_patterns;
+  for (const std::string& pattern : patterns)
+    simple_patterns.push_back(*SimplePattern::Create(pattern));
+  return simple_patterns;
+}
+
+// Calls `fn` with every string over `alphabet` of length at most `max_length`.
+void ForEachString(absl::string_view alphabet, int max_length,
+                   const std::function<void(const std::string&)>& fn,
+                   std::string prefix = "") {
+  fn(prefix);
+  if (prefix.size() == max_length) return;
+  for (char c : alphabet) ForEachString(alphabet, max_length, fn, prefix + c);
+}
+
+// Checks that `automaton` accepts exactly the strings over `alphabet` with
+// length in [`min_length`, `max_length`] that match all of `patterns`.
+void ExpectSameAsMatches(const SimplePatternAutomaton& automaton,
+                         const std::vector<SimplePattern>& patterns,
+                         absl::string_view alphabet, int min_length,
+                         int max_length) {
+  ForEachString(alphabet, max_length + 1, [&](const std::string& str) {
+    bool expected = min_length <= str.size() && str.size() <= max_length;
+    for (const SimplePattern& pattern : patterns)
+      expected = expected && pattern.Matches(str);
+    EXPECT_EQ(automaton.Accepts(str), expected) << str;
+  });
+}
+
+TEST(SimplePatternAutomatonTest, AcceptsShouldMatchEveryPattern) {
+  std::vector<SimplePattern> patterns =
+      CreatePatterns({"[a-c]{2,4}", "a[a-z]*"});
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create(patterns, std::nullopt, 0, 10));
+
+  ExpectSameAsMatches(automaton, patterns, "abcd", 0, 10);
+}
+
+TEST(SimplePatternAutomatonTest, AcceptsShouldUseTheGreedySemantics) {
+  // Greedily, "a*" consumes every "a", so "a" can never match.
+  std::vector<SimplePattern> patterns = CreatePatterns({"a*a", "a{0,2}ab?"});
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create({patterns[0]}, std::nullopt, 0, 5));
+  ExpectSameAsMatches(automaton, {patterns[0]}, "ab", 0, 5);
+  EXPECT_FALSE(automaton.Accepts("aa"));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      automaton,
+      SimplePatternAutomaton::Create({patterns[1]}, std::nullopt, 0, 5));
+  ExpectSameAsMatches(automaton, {patterns[1]}, "ab", 0, 5);
+}
+
+TEST(SimplePatternAutomatonTest, AcceptsShouldRespectLengthAndAlphabet) {
+  std::vector<SimplePattern> patterns = CreatePatterns({"[a-z]*", "b*[xyz]*"});
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create(patterns, "abxy", 2, 4));
+
+  ExpectSameAsMatches(automaton, patterns, "abxy", 2, 4);
+  EXPECT_FALSE(automaton.Accepts("bz"));
+}
+
+TEST(SimplePatternAutomatonTest, GenerateShouldSatisfyEveryConstraint) {
+  std::vector<SimplePattern> patterns =
+      CreatePatterns({"[a-f]*[0-9]+", "[a-c]{1,3}[0-9a-z]*"});
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create(patterns, "abcdef0123", 5, 20));
+
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  for (int tries = 0; tries < 100; tries++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::string str, automaton.Generate(engine));
+    EXPECT_THAT(str, SizeIs(Ge(5)));
+    EXPECT_THAT(str, SizeIs(Le(20)));
+    for (const SimplePattern& pattern : patterns)
+      EXPECT_TRUE(pattern.Matches(str)) << str;
+  }
+}
+
+TEST(SimplePatternAutomatonTest, GenerateShouldWorkForLongStrings) {
+  std::vector<SimplePattern> patterns =
+      CreatePatterns({"[a-z]{1,100000}", "[a-m]*[n-z]*"});
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create(patterns, std::nullopt, 50000, 50000));
+
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::string str, automaton.Generate(engine));
+  EXPECT_THAT(str, SizeIs(50000));
+  for (const SimplePattern& pattern : patterns) EXPECT_TRUE(pattern.Matches(str));
+}
+
+TEST(SimplePatternAutomatonTest, GenerateShouldBeRoughlyUniform) {
+  // Matches "", "a", "b", "aa", "ab", "bb" (6 strings).
+  std::vector<SimplePattern> patterns = CreatePatterns({"a{0,2}b{0,2}"});
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create(patterns, std::nullopt, 0, 2));
+
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  absl::flat_hash_map<std::string, int> counts;
+  for (int tries = 0; tries < 6000; tries++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::string str, automaton.Generate(engine));
+    counts[str]++;
+  }
+  EXPECT_THAT(counts, SizeIs(6));
+  for (const auto& [str, count] : counts) {
+    EXPECT_GE(count, 800) << str;
+    EXPECT_LE(count, 1200) << str;
+  }
+}
+
+TEST(SimplePatternAutomatonTest, GenerateShouldFailIfNothingIsAccepted) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePatternAutomaton automaton,
+      SimplePatternAutomaton::Create(CreatePatterns({"a{3,5}", "[ab]{1,2}"}),
+                                     std::nullopt, 0, 10));
+  EXPECT_THAT(automaton.Generate(engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      automaton, SimplePatternAutomaton::Create(CreatePatterns({"a*"}), "b",
+                                                1, 10));
+  EXPECT_THAT(automaton.Generate(engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      automaton, SimplePatternAutomaton::Create(CreatePatterns({"a*"}),
+                                                std::nullopt, 5, 4));
+  EXPECT_THAT(automaton.Generate(engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SimplePatternAutomatonTest, CreateShouldRejectOrExpressions) {
+  EXPECT_THAT(SimplePatternAutomaton::Create(CreatePatterns({"a|b"}),
+                                             std::nullopt, 0, 10),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(SimplePatternAutomaton::Create(CreatePatterns({"x(a|b)"}),
+                                             std::nullopt, 0, 10),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+TEST(SimplePatternAutomatonTest, CreateShouldRejectUnboundedLengths) {
+  EXPECT_THAT(
+      SimplePatternAutomaton::Create(CreatePatterns({"a*"}), std::nullopt, 0,
+                                     std::numeric_limits<int64_t>::max()),
+      StatusIs(absl::StatusCode::kUnimplemented));
+  // The pattern bounds the length, even if `max_length` does not.
+  EXPECT_THAT(
+      SimplePatternAutomaton::Create(CreatePatterns({"a{1,10}b{1,10}"}),
+                                     std::nullopt, 0,
+                                     std::numeric_limits<int64_t>::max()),
+      IsOk());
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
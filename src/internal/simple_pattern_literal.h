@@ -0,0 +1,323 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_SIMPLE_PATTERN_LITERAL_H_
+#define MORIARTY_SRC_INTERNAL_SIMPLE_PATTERN_LITERAL_H_
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// SimplePatternError()
+//
+// Returns why `SimplePattern::Create(pattern)` would fail, or an empty string
+// if `pattern` is valid. Unlike `SimplePattern::Create()`, this can run at
+// compile time, so literal patterns can be checked while compiling.
+//
+// This follows the exact same rules as the parser in simple_pattern.cc. It
+// uses `std::string_view`, since `absl::string_view` is not always constexpr.
+constexpr std::string_view SimplePatternError(std::string_view pattern);
+
+// SimplePatternLiteral
+//
+// A pattern that is known to be valid at compile time. Constructing one from a
+// string literal checks the pattern while compiling, so an invalid pattern
+// fails to compile (with a call to `InvalidSimplePatternLiteral()` in the
+// error) instead of failing when the test cases are generated.
+//
+// Only constant expressions can be used. For patterns built at runtime, use
+// `SimplePattern::Create()`.
+class SimplePatternLiteral {
+ public:
+  template <typename T>
+    requires std::convertible_to<const T&, std::string_view>
+  consteval SimplePatternLiteral(const T& pattern)  // NOLINT: implicit
+      : pattern_(pattern) {
+    if (!SimplePatternError(pattern_).empty()) InvalidSimplePatternLiteral();
+  }
+
+  constexpr std::string_view Pattern() const { return pattern_; }
+
+ private:
+  std::string_view pattern_;
+
+  // Not constexpr, so calling this from the consteval constructor stops the
+  // compilation.
+  static void InvalidSimplePatternLiteral() {}
+};
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+namespace simple_pattern_literal_internal {
+
+// The result of parsing a prefix of a pattern: either the length of the
+// prefix, or an error.
+struct PrefixLength {
+  int64_t length = 0;
+  std::string_view error;
+};
+
+constexpr PrefixLength Error(std::string_view error) {
+  return {.length = 0, .error = error};
+}
+
+constexpr bool IsSpecialCharacter(char ch) {
+  return std::string_view(R"(\()[]{}^?*+-|)").find(ch) !=
+         std::string_view::npos;
+}
+
+constexpr bool IsLower(char ch) { return 'a' <= ch && ch <= 'z'; }
+constexpr bool IsUpper(char ch) { return 'A' <= ch && ch <= 'Z'; }
+constexpr bool IsDigit(char ch) { return '0' <= ch && ch <= '9'; }
+
+constexpr bool ValidCharSetRange(std::string_view range) {
+  if (range.size() != 3 || range[1] != '-') return false;
+  char a = range[0];
+  char b = range[2];
+  return a <= b && ((IsLower(a) && IsLower(b)) || (IsUpper(a) && IsUpper(b)) ||
+                    (IsDigit(a) && IsDigit(b)));
+}
+
+// The characters seen so far in a character set.
+class CharSet {
+ public:
+  constexpr std::string_view Add(char ch) {
+    if (ch < 0) return "Invalid character.";
+    if (seen_[static_cast<int>(ch)]) return "Duplicate character.";
+    seen_[static_cast<int>(ch)] = true;
+    return "";
+  }
+
+ private:
+  bool seen_[128] = {};
+};
+
+// Same as `CharacterSetPrefixLength()`.
+constexpr PrefixLength CharacterSetPrefixLength(std::string_view pattern) {
+  if (pattern.empty()) return Error("Empty pattern.");
+  if (pattern[0] != '[') {
+    if (IsSpecialCharacter(pattern[0]))
+      return Error("Invalid character to start character set.");
+    return {.length = 1, .error = {}};
+  }
+
+  int64_t close_index = -1;
+  for (int64_t i = 1; i < static_cast<int64_t>(pattern.size()); i++) {
+    if (pattern[i] == ']') {
+      bool second = close_index != -1;
+      close_index = i;
+      if (second) break;
+    } else if (pattern[i] == '[') {
+      if (close_index != -1) break;
+    }
+  }
+  if (close_index == -1) return Error("No ']' found to end character set.");
+  return {.length = close_index + 1, .error = {}};
+}
+
+// Same as `ParseCharacterSetBody()`.
+constexpr std::string_view CharacterSetBodyError(std::string_view chars) {
+  if (chars.empty()) return "Empty character set.";
+
+  CharSet char_set;
+  if (chars[0] == '^') {
+    chars.remove_prefix(1);
+    if (chars.empty()) return "";
+  }
+  if (chars.back() == '-') {
+    (void)char_set.Add('-');
+    chars.remove_suffix(1);
+  }
+
+  size_t open = chars.find('[');
+  size_t close = chars.find(']');
+  if (open != std::string_view::npos && close != std::string_view::npos &&
+      open > close) {
+    return "The character ']' cannot come after '[' inside a character set.";
+  }
+
+  for (size_t i = 0; i < chars.size(); i++) {
+    if (ValidCharSetRange(chars.substr(i, 3))) {
+      for (char c = chars[i]; c <= chars[i + 2]; c++) {
+        std::string_view error = char_set.Add(c);
+        if (!error.empty()) return error;
+      }
+      i += 2;
+      continue;
+    }
+    if (chars[i] == '-') return "Invalid '-' in character set.";
+    std::string_view error = char_set.Add(chars[i]);
+    if (!error.empty()) return error;
+  }
+  return "";
+}
+
+// Same as `absl::SimpleAtoi()` for an `int64_t`.
+constexpr bool SimpleAtoi(std::string_view str, int64_t& value) {
+  constexpr std::string_view kWhitespace = " \t\n\v\f\r";
+  while (!str.empty() && kWhitespace.find(str.front()) != str.npos)
+    str.remove_prefix(1);
+  while (!str.empty() && kWhitespace.find(str.back()) != str.npos)
+    str.remove_suffix(1);
+
+  bool negative = false;
+  if (!str.empty() && (str[0] == '-' || str[0] == '+')) {
+    negative = str[0] == '-';
+    str.remove_prefix(1);
+  }
+  if (str.empty()) return false;
+
+  // Accumulate negatively, so that the minimum int64_t does not overflow.
+  value = 0;
+  for (char ch : str) {
+    if (!IsDigit(ch)) return false;
+    if (value < (std::numeric_limits<int64_t>::min() + (ch - '0')) / 10)
+      return false;
+    value = value * 10 - (ch - '0');
+  }
+  if (!negative) {
+    if (value == std::numeric_limits<int64_t>::min()) return false;
+    value = -value;
+  }
+  return true;
+}
+
+// Same as `RepetitionPrefixLength()` followed by `ParseRepetitionBody()` and
+// `RepeatedCharSet::SetRange()`.
+constexpr PrefixLength RepetitionPrefixLength(std::string_view pattern) {
+  if (pattern.empty() || pattern[0] != '{') {
+    bool single = !pattern.empty() &&
+                  (pattern[0] == '?' || pattern[0] == '+' || pattern[0] == '*');
+    return {.length = single ? 1 : 0, .error = {}};
+  }
+
+  size_t close = pattern.find('}');
+  if (close == std::string_view::npos)
+    return Error("No '}' found to end repetition block.");
+
+  std::string_view body = pattern.substr(1, close - 1);
+  std::string_view min_str = body;
+  std::string_view max_str = body;
+  if (size_t comma = body.find(','); comma != std::string_view::npos) {
+    min_str = body.substr(0, comma);
+    max_str = body.substr(comma + 1);
+  }
+
+  int64_t min = 0;
+  int64_t max = std::numeric_limits<int64_t>::max();
+  if (!min_str.empty() && !SimpleAtoi(min_str, min))
+    return Error("Invalid min value in repetition.");
+  if (!max_str.empty() && !SimpleAtoi(max_str, max))
+    return Error("Invalid max value in repetition.");
+  if (min > max || max < 0) return Error("Invalid range.");
+  return {.length = static_cast<int64_t>(close) + 1, .error = {}};
+}
+
+// Same as `ParseRepeatedCharSetPrefix()`.
+constexpr PrefixLength RepeatedCharSetPrefixLength(std::string_view pattern) {
+  PrefixLength char_set = CharacterSetPrefixLength(pattern);
+  if (!char_set.error.empty()) return char_set;
+
+  std::string_view chars = pattern.substr(0, char_set.length);
+  if (chars.size() >= 2 && chars.front() == '[' && chars.back() == ']')
+    chars = chars.substr(1, chars.size() - 2);
+  std::string_view error = CharacterSetBodyError(chars);
+  if (!error.empty()) return Error(error);
+
+  PrefixLength repetition =
+      RepetitionPrefixLength(pattern.substr(char_set.length));
+  if (!repetition.error.empty()) return repetition;
+  return {.length = char_set.length + repetition.length, .error = {}};
+}
+
+constexpr PrefixLength ScopePrefixLength(std::string_view pattern);
+
+// Same as `ParseAllOfNodeScopePrefix()`.
+constexpr PrefixLength AllOfPrefixLength(std::string_view pattern) {
+  size_t idx = 0;
+  while (idx < pattern.size() && pattern[idx] != '|' && pattern[idx] != ')') {
+    if (pattern[idx] != '(') {
+      PrefixLength char_set = RepeatedCharSetPrefixLength(pattern.substr(idx));
+      if (!char_set.error.empty()) return char_set;
+      idx += char_set.length;
+      continue;
+    }
+
+    PrefixLength inner = ScopePrefixLength(pattern.substr(idx + 1));
+    if (!inner.error.empty()) return inner;
+    if (idx + 1 + inner.length >= pattern.size() ||
+        pattern[idx + 1 + inner.length] != ')')
+      return Error("Invalid end of scope. Expected ')'.");
+    idx += inner.length + 2;
+  }
+  return {.length = static_cast<int64_t>(idx), .error = {}};
+}
+
+// Same as `ParseScopePrefix()`.
+constexpr PrefixLength ScopePrefixLength(std::string_view pattern) {
+  if (pattern.empty() || pattern[0] == ')') return Error("Empty scope.");
+
+  size_t idx = 0;
+  while (idx < pattern.size() && pattern[idx] != ')') {
+    if (pattern[idx] == '|') {
+      if (idx == 0 || idx + 1 >= pattern.size() || pattern[idx + 1] == '|')
+        return Error("Empty or-block not allowed.");
+      idx++;
+    }
+    PrefixLength all_of = AllOfPrefixLength(pattern.substr(idx));
+    if (!all_of.error.empty()) return all_of;
+    idx += all_of.length;
+  }
+  return {.length = static_cast<int64_t>(idx), .error = {}};
+}
+
+}  // namespace simple_pattern_literal_internal
+
+constexpr std::string_view SimplePatternError(std::string_view pattern) {
+  // Same as `Sanitize()`.
+  std::string sanitized;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      if (i + 1 == pattern.size())
+        return "Cannot have unescaped '\\' at the end of pattern.";
+      if (pattern[i + 1] != '\\' && pattern[i + 1] != ' ')
+        return "Invalid escaped character in pattern.";
+      sanitized += pattern[++i];
+    } else if (pattern[i] != ' ') {
+      sanitized += pattern[i];
+    }
+  }
+  if (sanitized.empty()) return "Empty pattern.";
+
+  simple_pattern_literal_internal::PrefixLength scope =
+      simple_pattern_literal_internal::ScopePrefixLength(sanitized);
+  if (!scope.error.empty()) return scope.error;
+  if (scope.length != static_cast<int64_t>(sanitized.size()))
+    return "Invalid pattern. Extra characters found.";
+  return "";
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_SIMPLE_PATTERN_LITERAL_H_
@@ -0,0 +1,71 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/simple_pattern_literal.h"
+
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/simple_pattern.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+static_assert(SimplePatternError("[a-z]{1,10}").empty());
+static_assert(SimplePatternError("(hello|world)[0-9]*").empty());
+static_assert(!SimplePatternError("(ab)*").empty());
+static_assert(!SimplePatternError("[z-a]").empty());
+static_assert(SimplePatternLiteral("a[b\\ c]d").Pattern() == "a[b\\ c]d");
+
+TEST(SimplePatternLiteralTest, ShouldAcceptTheSamePatternsAsCreate) {
+  for (const char* pattern :
+       {"abc", "a*", "a*b+", "a|b|c", "a(bc)", "[a][b][X][Y][Z][@][!]",
+        "[(][)][*][[][]][?][+]", "a[b c]d", R"(a[b\ c]d)", R"(a[b\\c]d)",
+        "[+-]?[0-9]", "[^a]", "[^]", "[a-]", "a{3}", "a{,3}", "a{3,}", "a{}",
+        "a{-5,2}", "a{+2,+3}", "((hello|bye)world)", "(a|)", "[]]"}) {
+    EXPECT_TRUE(SimplePatternError(pattern).empty()) << pattern;
+    EXPECT_TRUE(SimplePattern::Create(pattern).ok()) << pattern;
+  }
+}
+
+TEST(SimplePatternLiteralTest, ShouldRejectTheSamePatternsAsCreate) {
+  for (const char* pattern :
+       {"", " ", "ab)", "(*)", "*", "|", "[", "]", "(ac)*", R"(abc\)", R"(\n)",
+        "a||b", "a|", "[aa]", "[a-cb]", "[A-z]", "[a-]-", "a{3,2}", "a{,-1}",
+        "a{x}", "a{99999999999999999999}", "a{1", "[][]", "(a", "a)b"}) {
+    EXPECT_FALSE(SimplePatternError(pattern).empty()) << pattern;
+    EXPECT_FALSE(SimplePattern::Create(pattern).ok()) << pattern;
+  }
+}
+
+TEST(SimplePatternLiteralTest, ShouldAgreeWithCreateOnRandomPatterns) {
+  RandomEngine engine({1, 2, 3}, "v0.1");
+  constexpr std::string_view kCharacters = R"(ab09[]{}()|*+?-^,\ )";
+  for (int i = 0; i < 100000; i++) {
+    std::string pattern;
+    int length = engine.RandInt(1, 8).value();
+    for (int j = 0; j < length; j++)
+      pattern += kCharacters[engine.RandInt(kCharacters.size()).value()];
+    EXPECT_EQ(SimplePatternError(pattern).empty(),
+              SimplePattern::Create(pattern).ok())
+        << pattern;
+  }
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -16,12 +16,15 @@
 
 #include <cstdint>
 #include <limits>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -48,6 +51,8 @@ namespace {
 
 using ::testing::AllOf;
 using ::testing::AnyOf;
+using ::testing::Each;
+using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::ExplainMatchResult;
 using ::testing::Field;
@@ -58,6 +63,7 @@ using ::testing::Le;
 using ::testing::Matches;
 using ::testing::Not;
 using ::testing::SizeIs;
+using ::testing::Truly;
 using ::moriarty::IsOk;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
@@ -109,6 +115,48 @@ TEST(SimplePatternTest, NestedPatternShouldMatch) {
   EXPECT_FALSE(p.Matches("xe"));
 }
 
+TEST(SimplePatternTest, MatchesIsGreedyWithoutBacktracking) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern a, SimplePattern::Create("a*a"));
+  EXPECT_FALSE(a.Matches("aaaa"));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern b,
+                                SimplePattern::Create("a{3,4}a"));
+  EXPECT_FALSE(b.Matches("aaaa"));
+  EXPECT_TRUE(b.Matches("aaaaa"));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern c,
+                                SimplePattern::Create("(hello|helloworld)"));
+  EXPECT_FALSE(c.Matches("helloworld"));
+  EXPECT_TRUE(c.Matches("hello"));
+}
+
+TEST(SimplePatternTest, CopiedPatternShouldStillMatch) {
+  std::vector<SimplePattern> patterns;
+  {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        SimplePattern p, SimplePattern::Create("[a-z]+(_|[-])([0-9]{2}|x)"));
+    patterns.push_back(p);
+    patterns.push_back(std::move(p));
+  }
+
+  for (const SimplePattern& p : patterns) {
+    EXPECT_TRUE(p.Matches("abc_12"));
+    EXPECT_TRUE(p.Matches("abc-x"));
+    EXPECT_FALSE(p.Matches("abc_1"));
+    EXPECT_FALSE(p.Matches("_12"));
+  }
+}
+
+TEST(SimplePatternTest, MatchesShouldHandleLongStrings) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("[ab]*c(d|e)"));
+  std::string str(1000000, 'a');
+
+  EXPECT_TRUE(p.Matches(str + "cd"));
+  EXPECT_FALSE(p.Matches(str + "cx"));
+  EXPECT_FALSE(p.Matches(str + "d"));
+}
+
 TEST(SimplePatternTest, DotWildcardDoesNotExist) {
   MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
                                          SimplePattern::Create("."));
@@ -476,6 +524,17 @@ TEST(SimplePatternTest, GenerationWithSmallWildcardShouldWork) {
               GeneratedValuesAre(AnyOf("ab", "b")));
 }
 
+TEST(SimplePatternTest, GenerationOfLongRepetitionsShouldUseEveryCharacter) {
+  RandomEngine engine({1, 2, 3, 4}, "v0.1");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("x[a-z]{100000}y"));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::string value, p.Generate(engine));
+  ASSERT_THAT(value, SizeIs(100002));
+  EXPECT_TRUE(p.Matches(value));
+  EXPECT_THAT(absl::flat_hash_set<char>(value.begin() + 1, value.end() - 1),
+              SizeIs(26));
+}
+
 TEST(SimplePatternTest, GenerationWithAlphabetRestrictionsShouldWork) {
   // Restricting the alphabet to only 'f's should only be able to generate one
   // string.
@@ -503,6 +562,139 @@ TEST(SimplePatternTest,
       StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+// Returns every string in the enumeration of `pattern`, in order.
+std::vector<std::string> AllStrings(
+    const SimplePattern& pattern,
+    std::optional<absl::string_view> restricted_alphabet = std::nullopt) {
+  std::vector<std::string> result;
+  int64_t count = *pattern.Count(restricted_alphabet);
+  for (int64_t rank = 0; rank < count; rank++)
+    result.push_back(*pattern.Unrank(rank, restricted_alphabet));
+  return result;
+}
+
+TEST(SimplePatternTest, CountShouldCountEveryGeneratableString) {
+  auto count = [](absl::string_view pattern) {
+    return SimplePattern::Create(pattern)->Count();
+  };
+  EXPECT_THAT(count("abc"), IsOkAndHolds(1));
+  EXPECT_THAT(count("[a-c]{1,3}"), IsOkAndHolds(3 + 9 + 27));
+  EXPECT_THAT(count("a|bb|ccc"), IsOkAndHolds(3));
+  EXPECT_THAT(count("[ab](c|[de]{2})"), IsOkAndHolds(2 * (1 + 4)));
+  EXPECT_THAT(count("a{2,10}"), IsOkAndHolds(9));
+}
+
+TEST(SimplePatternTest, CountShouldSaturate) {
+  auto count = [](absl::string_view pattern) {
+    return SimplePattern::Create(pattern)->Count();
+  };
+  EXPECT_THAT(count("[a-z]*"), IsOkAndHolds(SimplePattern::kMaxCount));
+  EXPECT_THAT(count("[0-9]{100}"), IsOkAndHolds(SimplePattern::kMaxCount));
+  EXPECT_THAT(count("[0-9]{100}[0-9]{100}"),
+              IsOkAndHolds(SimplePattern::kMaxCount));
+}
+
+TEST(SimplePatternTest, CountShouldRespectAlphabetRestrictions) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("[a-z]{2}"));
+  EXPECT_THAT(p.Count("fx"), IsOkAndHolds(4));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern q,
+                                SimplePattern::Create("[a-f]{1,10}"));
+  EXPECT_THAT(q.Count("x"), IsOkAndHolds(0));
+}
+
+TEST(SimplePatternTest, UnrankShouldEnumerateInOrder) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("[a-b]{1,2}"));
+  EXPECT_THAT(AllStrings(p), ElementsAre("a", "b", "aa", "ab", "ba", "bb"));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern q,
+                                SimplePattern::Create("(x|y)[01]"));
+  EXPECT_THAT(AllStrings(q), ElementsAre("x0", "x1", "y0", "y1"));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern r,
+                                SimplePattern::Create("[a-z]{2}"));
+  EXPECT_THAT(AllStrings(r, "fx"), ElementsAre("ff", "fx", "xf", "xx"));
+}
+
+TEST(SimplePatternTest, UnrankShouldProduceEveryStringExactlyOnce) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimplePattern p, SimplePattern::Create("[a-c]{1,3}(_|[0-9]{2})"));
+  std::vector<std::string> strings = AllStrings(p);
+
+  EXPECT_THAT(strings, SizeIs(39 * 101));
+  EXPECT_EQ(absl::flat_hash_set<std::string>(strings.begin(), strings.end())
+                .size(),
+            strings.size());
+  EXPECT_THAT(strings, Each(Truly([&](const std::string& str) {
+                return p.Matches(str);
+              })));
+}
+
+TEST(SimplePatternTest, UnrankShouldWorkForLargeRanksOfSaturatedPatterns) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("[0-9]{30}"));
+  EXPECT_THAT(p.Unrank(0), IsOkAndHolds(std::string(30, '0')));
+  EXPECT_THAT(p.Unrank(1234567),
+              IsOkAndHolds(std::string(23, '0') + "1234567"));
+  EXPECT_THAT(p.Unrank(SimplePattern::kMaxCount - 1),
+              IsOkAndHolds(std::string(11, '0') + "9223372036854775806"));
+}
+
+TEST(SimplePatternTest, UnrankOutOfRangeShouldFail) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("a|b"));
+  EXPECT_THAT(p.Unrank(-1), StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(p.Unrank(2), StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(SimplePatternTest, GenerateUniformlyShouldGiveEachStringEqualWeight) {
+  // `Generate()` picks "a" half of the time. Uniformly, it is 1 in 101.
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("a|[0-9]{2}"));
+  RandomEngine engine({1, 2, 3, 4}, "v0.1");
+
+  int num_a = 0;
+  for (int i = 0; i < 10100; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::string str,
+                                  p.GenerateUniformly(engine));
+    ASSERT_TRUE(p.Matches(str));
+    if (str == "a") num_a++;
+  }
+  EXPECT_THAT(num_a, AllOf(Ge(50), Le(150)));
+}
+
+TEST(SimplePatternTest, GenerateUniformlyWithTooManyStringsShouldFail) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("a*"));
+  RandomEngine engine({1, 2, 3, 4}, "v0.1");
+  EXPECT_THAT(p.GenerateUniformly(engine),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SimplePatternTest, SequentialCharSetsShouldBeInMatchingOrder) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("a*b{2,3}(c(d))"));
+  std::optional<std::vector<RepeatedCharSet>> char_sets =
+      p.SequentialCharSets();
+  ASSERT_TRUE(char_sets.has_value());
+
+  std::string valid_characters;
+  for (const RepeatedCharSet& char_set : *char_sets) {
+    if (char_set.MaxLength() == 0) continue;  // Empty scopes.
+    for (char c : absl::string_view("abcd"))
+      if (char_set.IsValidCharacter(c)) valid_characters += c;
+  }
+  EXPECT_EQ(valid_characters, "abcd");
+}
+
+TEST(SimplePatternTest, SequentialCharSetsWithOrExpressionsShouldBeNullopt) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimplePattern p,
+                                SimplePattern::Create("a(b|c)"));
+  EXPECT_EQ(p.SequentialCharSets(), std::nullopt);
+}
+
 // -----------------------------------------------------------------------------
 //  Tests below here are for more internal-facing functions. Only functions
 //  above are for the external API.
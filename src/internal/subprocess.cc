@@ -0,0 +1,303 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/subprocess.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+extern char** environ;
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+constexpr size_t kChunkSize = 1 << 16;
+
+// A file descriptor that is closed when it goes out of scope.
+class FileDescriptor {
+ public:
+  FileDescriptor() = default;
+  ~FileDescriptor() { Close(); }
+
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  int get() const { return fd_; }
+  bool is_open() const { return fd_ >= 0; }
+  void Reset(int fd) {
+    Close();
+    fd_ = fd;
+  }
+  void Close() {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+absl::Status ErrnoError(absl::string_view what) {
+  return absl::InternalError(absl::StrCat(what, ": ", std::strerror(errno)));
+}
+
+// Creates a pipe. Both ends are closed in child processes, except where they
+// are `dup2()`-ed onto the standard streams, so pipes made by other threads
+// at the same time do not stay open in each other's processes.
+absl::Status MakePipe(FileDescriptor& read_end, FileDescriptor& write_end) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) != 0) return ErrnoError("pipe2() failed");
+  read_end.Reset(fds[0]);
+  write_end.Reset(fds[1]);
+  return absl::OkStatus();
+}
+
+// Blocks SIGPIPE on this thread while it is in scope, so writing to a process
+// that has exited returns EPIPE instead of killing this process.
+class BlockSigpipe {
+ public:
+  BlockSigpipe() {
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &old_mask_);
+  }
+
+  ~BlockSigpipe() {
+    // Discard a SIGPIPE from writing to a closed pipe before unblocking it.
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    timespec no_wait = {0, 0};
+    while (sigtimedwait(&sigpipe, nullptr, &no_wait) == SIGPIPE) {
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+  }
+
+  // The signal mask from before this was created, for child processes.
+  const sigset_t& OldMask() const { return old_mask_; }
+
+ private:
+  sigset_t old_mask_;
+};
+
+// Starts `command` with `stdin_fd` and `stdout_fd` as its standard input and
+// output, and its standard error discarded.
+absl::Status Spawn(const std::vector<std::string>& command, int stdin_fd,
+                   int stdout_fd, const sigset_t& signal_mask, pid_t& pid) {
+  std::vector<char*> argv;
+  for (const std::string& arg : command)
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, stdin_fd, STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, stdout_fd, STDOUT_FILENO);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+
+  // The process starts with the signal mask and SIGPIPE handling this
+  // process would have had, not those used while running it.
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t default_signals;
+  sigemptyset(&default_signals);
+  sigaddset(&default_signals, SIGPIPE);
+  posix_spawnattr_setsigmask(&attributes, &signal_mask);
+  posix_spawnattr_setsigdefault(&attributes, &default_signals);
+  posix_spawnattr_setflags(&attributes,
+                           POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+  int error = posix_spawn(&pid, argv[0], &actions, &attributes, argv.data(),
+                          environ);
+  posix_spawnattr_destroy(&attributes);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error != 0) {
+    return absl::InternalError(absl::StrCat("Unable to start '", command[0],
+                                            "': ", std::strerror(error)));
+  }
+  return absl::OkStatus();
+}
+
+// The number of milliseconds until `deadline` for `poll()`, or -1 if there is
+// no deadline.
+int PollTimeoutMs(absl::Time deadline) {
+  if (deadline == absl::InfiniteFuture()) return -1;
+  return static_cast<int>(std::clamp<int64_t>(
+      absl::ToInt64Milliseconds(
+          absl::Ceil(deadline - absl::Now(), absl::Milliseconds(1))),
+      0, std::numeric_limits<int>::max()));
+}
+
+absl::Status ExitStatus(int wait_status) {
+  if (WIFEXITED(wait_status)) {
+    int code = WEXITSTATUS(wait_status);
+    if (code == 0) return absl::OkStatus();
+    return absl::AbortedError(absl::StrCat("Exited with code ", code));
+  }
+  if (WIFSIGNALED(wait_status)) {
+    int signal = WTERMSIG(wait_status);
+    return absl::AbortedError(absl::StrCat("Killed by signal ", signal, " (",
+                                           strsignal(signal), ")"));
+  }
+  return absl::AbortedError("Exited abnormally");
+}
+
+}  // namespace
+
+SubprocessResult RunSubprocess(const std::vector<std::string>& command,
+                               absl::string_view input,
+                               absl::Duration timeout) {
+  SubprocessResult result;
+  if (command.empty()) {
+    result.status = absl::InvalidArgumentError("The command is empty");
+    return result;
+  }
+
+  BlockSigpipe block_sigpipe;
+  FileDescriptor child_stdin, to_child, from_child, child_stdout;
+  if (absl::Status status = MakePipe(child_stdin, to_child); !status.ok()) {
+    result.status = status;
+    return result;
+  }
+  if (absl::Status status = MakePipe(from_child, child_stdout); !status.ok()) {
+    result.status = status;
+    return result;
+  }
+
+  absl::Time start = absl::Now();
+  absl::Time deadline = timeout == absl::InfiniteDuration()
+                            ? absl::InfiniteFuture()
+                            : start + timeout;
+  pid_t pid;
+  if (absl::Status status =
+          Spawn(command, child_stdin.get(), child_stdout.get(),
+                block_sigpipe.OldMask(), pid);
+      !status.ok()) {
+    result.status = status;
+    return result;
+  }
+  // Only the child uses these ends, so closing them here lets the pipes
+  // report the end of the input or output once the child closes its ends.
+  child_stdin.Close();
+  child_stdout.Close();
+  fcntl(to_child.get(), F_SETFL, O_NONBLOCK);
+  fcntl(from_child.get(), F_SETFL, O_NONBLOCK);
+
+  size_t written = 0;
+  if (input.empty()) to_child.Close();
+  bool timed_out = false;
+  std::vector<char> buffer(kChunkSize);
+  while (to_child.is_open() || from_child.is_open()) {
+    pollfd requests[2];
+    int num_requests = 0;
+    if (from_child.is_open())
+      requests[num_requests++] = {from_child.get(), POLLIN, 0};
+    if (to_child.is_open())
+      requests[num_requests++] = {to_child.get(), POLLOUT, 0};
+
+    int ready = poll(requests, num_requests, PollTimeoutMs(deadline));
+    if (ready < 0 && errno == EINTR) continue;
+    if (ready < 0) {
+      result.status = ErrnoError("poll() failed");
+      kill(pid, SIGKILL);
+      break;
+    }
+    if (ready == 0) {
+      timed_out = true;
+      break;
+    }
+
+    for (int i = 0; i < num_requests; i++) {
+      if (requests[i].revents == 0) continue;
+      if (requests[i].fd == from_child.get()) {
+        ssize_t size = read(from_child.get(), buffer.data(), buffer.size());
+        if (size > 0) {
+          result.output.append(buffer.data(), size);
+        } else if (size == 0 || (errno != EAGAIN && errno != EINTR)) {
+          from_child.Close();
+        }
+      } else {
+        ssize_t size = write(to_child.get(), input.data() + written,
+                             std::min(input.size() - written, kChunkSize));
+        if (size > 0) written += size;
+        // EPIPE: the child exited (or closed its input) without reading all
+        // of it, which is up to the child.
+        if (written == input.size() ||
+            (size < 0 && errno != EAGAIN && errno != EINTR)) {
+          to_child.Close();
+        }
+      }
+    }
+  }
+  to_child.Close();
+  from_child.Close();
+
+  // The child may still be running after closing its output.
+  int wait_status = 0;
+  rusage usage = {};
+  while (true) {
+    if (timed_out) kill(pid, SIGKILL);
+    pid_t waited = wait4(pid, &wait_status, timed_out ? 0 : WNOHANG, &usage);
+    if (waited == pid) break;
+    if (waited < 0 && errno != EINTR) {
+      result.status = ErrnoError("wait4() failed");
+      return result;
+    }
+    if (waited == 0) {
+      if (absl::Now() >= deadline) {
+        timed_out = true;
+      } else {
+        absl::SleepFor(std::min(absl::Milliseconds(1), deadline - absl::Now()));
+      }
+    }
+  }
+
+  result.wall_time = absl::Now() - start;
+  result.peak_memory_bytes = int64_t{usage.ru_maxrss} * 1024;  // KB on Linux.
+  if (!result.status.ok()) return result;
+  if (timed_out) {
+    result.status = absl::DeadlineExceededError(
+        absl::StrCat("Did not exit within ", absl::FormatDuration(timeout)));
+    return result;
+  }
+  result.status = ExitStatus(wait_status);
+  return result;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
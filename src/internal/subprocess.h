@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_SUBPROCESS_H_
+#define MORIARTY_SRC_INTERNAL_SUBPROCESS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// SubprocessResult
+//
+// What happened when a subprocess was run by `RunSubprocess()`.
+struct SubprocessResult {
+  // Ok if the process exited with code 0. Otherwise, kAborted if it exited
+  // with another code or was killed by a signal, and kDeadlineExceeded if it
+  // ran out of time.
+  absl::Status status;
+
+  // Everything the process wrote to its standard output.
+  std::string output;
+
+  // From starting the process until it exited.
+  absl::Duration wall_time = absl::ZeroDuration();
+
+  // The peak resident memory of the process, in bytes.
+  int64_t peak_memory_bytes = 0;
+};
+
+// RunSubprocess()
+//
+// Runs `command` (the path of the program, then its arguments) with `input` as
+// its standard input, and waits for it to exit. Its standard error is
+// discarded. If it does not exit within `timeout`, it is killed and the status
+// is kDeadlineExceeded.
+//
+// Input and output are exchanged at the same time, so a process may write
+// any amount of output before reading all of its input. A process that exits
+// without reading all of its input is fine.
+//
+// Returns kInvalidArgument in `status` if `command` is empty, and kInternal if
+// the process could not be started.
+SubprocessResult RunSubprocess(const std::vector<std::string>& command,
+                               absl::string_view input,
+                               absl::Duration timeout =
+                                   absl::InfiniteDuration());
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_SUBPROCESS_H_
@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/subprocess.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::moriarty::StatusIs;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+
+TEST(SubprocessTest, OutputShouldBeCollected) {
+  SubprocessResult result =
+      RunSubprocess({"/bin/sh", "-c", "read a b; echo $((a + b))"}, "3 4\n");
+  MORIARTY_EXPECT_OK(result.status);
+  EXPECT_EQ(result.output, "7\n");
+  EXPECT_THAT(result.peak_memory_bytes, Gt(0));
+  EXPECT_GT(result.wall_time, absl::ZeroDuration());
+}
+
+TEST(SubprocessTest, LargeInputAndOutputShouldNotDeadlock) {
+  // Much larger than a pipe's buffer, in both directions at the same time.
+  std::string input;
+  for (int i = 0; i < 100000; i++) input += "line " + std::to_string(i) + "\n";
+  SubprocessResult result = RunSubprocess({"/bin/cat"}, input);
+  MORIARTY_EXPECT_OK(result.status);
+  EXPECT_EQ(result.output, input);
+}
+
+TEST(SubprocessTest, UnreadInputShouldBeFine) {
+  SubprocessResult result =
+      RunSubprocess({"/bin/sh", "-c", "echo done"}, std::string(1 << 20, 'x'));
+  MORIARTY_EXPECT_OK(result.status);
+  EXPECT_EQ(result.output, "done\n");
+}
+
+TEST(SubprocessTest, FailuresShouldBeReported) {
+  EXPECT_THAT(RunSubprocess({"/bin/sh", "-c", "echo partial; exit 3"}, "")
+                  .status,
+              StatusIs(absl::StatusCode::kAborted, HasSubstr("code 3")));
+  EXPECT_THAT(RunSubprocess({"/bin/sh", "-c", "kill -9 $$"}, "").status,
+              StatusIs(absl::StatusCode::kAborted, HasSubstr("signal 9")));
+  EXPECT_THAT(RunSubprocess({"/does/not/exist"}, "").status,
+              StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(RunSubprocess({}, "").status,
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SubprocessTest, SlowProcessesShouldBeKilled) {
+  SubprocessResult result =
+      RunSubprocess({"/bin/sleep", "10"}, "", absl::Milliseconds(50));
+  EXPECT_THAT(result.status, StatusIs(absl::StatusCode::kDeadlineExceeded));
+  EXPECT_LT(result.wall_time, absl::Seconds(5));
+}
+
+TEST(SubprocessTest, ClosingOutputEarlyShouldStillTimeOut) {
+  SubprocessResult result = RunSubprocess(
+      {"/bin/sh", "-c", "exec >&-; sleep 10"}, "", absl::Milliseconds(50));
+  EXPECT_THAT(result.status, StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,127 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/test_case_cache.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "src/internal/value_codec.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// 64-bit FNV-1a, which (unlike `std::hash`) is stable across platforms and
+// runs, so the cache can be reused.
+uint64_t Fnv1a(absl::string_view data, uint64_t hash) {
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+// Returns a random suffix for a temporary file, so that writers in this
+// process and in other processes sharing the directory never write to the same
+// temporary file.
+std::string TemporaryFileSuffix() {
+  std::random_device random;
+  uint64_t nonce = (uint64_t{random()} << 32) ^ random();
+  return absl::StrFormat(".tmp%016x", nonce);
+}
+
+// Each entry is the length-prefixed key followed by the contents.
+std::string MakeEntry(absl::string_view key, absl::string_view contents) {
+  std::string entry;
+  AppendVarint(key.size(), entry);
+  absl::StrAppend(&entry, key, contents);
+  return entry;
+}
+
+}  // namespace
+
+TestCaseCache::TestCaseCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+std::string TestCaseCache::PathFor(absl::string_view key) const {
+  // Two differently seeded hashes, for 128 bits of file name.
+  std::string file_name =
+      absl::StrFormat("%016x%016x", Fnv1a(key, 0xcbf29ce484222325),
+                      Fnv1a(key, 0x84222325cbf29ce4));
+  return (std::filesystem::path(directory_) / file_name).string();
+}
+
+std::optional<std::string> TestCaseCache::Lookup(absl::string_view key) const {
+  std::ifstream file(PathFor(key), std::ios::binary);
+  if (!file) return std::nullopt;
+  std::string entry((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+  if (file.bad()) return std::nullopt;
+
+  absl::string_view in = entry;
+  uint64_t key_size;
+  if (!ReadVarint(in, key_size) || key_size > in.size()) return std::nullopt;
+  if (in.substr(0, key_size) != key) return std::nullopt;
+  in.remove_prefix(key_size);
+  return std::string(in);
+}
+
+absl::Status TestCaseCache::Store(absl::string_view key,
+                                  absl::string_view contents) const {
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    return absl::UnavailableError(absl::Substitute(
+        "unable to create cache directory $0: $1", directory_,
+        error.message()));
+  }
+
+  std::string path = PathFor(key);
+  std::string temp_path = absl::StrCat(path, TemporaryFileSuffix());
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file << MakeEntry(key, contents);
+    if (!file.flush()) {
+      std::filesystem::remove(temp_path, error);
+      return absl::UnavailableError(
+          absl::StrCat("unable to write cache entry ", temp_path));
+    }
+  }
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    std::error_code ignored;
+    std::filesystem::remove(temp_path, ignored);
+    return absl::UnavailableError(absl::Substitute(
+        "unable to write cache entry $0: $1", path, error.message()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
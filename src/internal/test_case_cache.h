@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_TEST_CASE_CACHE_H_
+#define MORIARTY_SRC_INTERNAL_TEST_CASE_CACHE_H_
+
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// TestCaseCache
+//
+// A content-addressed cache of generated test cases stored in a directory on
+// disk. Each entry is a file named by a hash of its key. The full key is stored
+// in the file as well, so a hash collision is a cache miss rather than a wrong
+// result.
+//
+// The cache is best-effort: it is safe to delete the directory (or any file in
+// it) at any time. Entries are written to a temporary file and then renamed,
+// so concurrent readers never see a partially written entry.
+class TestCaseCache {
+ public:
+  // `directory` is created on the first call to `Store()`.
+  explicit TestCaseCache(std::string directory);
+
+  // Lookup()
+  //
+  // Returns the contents stored under `key`, or `std::nullopt` if there are
+  // none (or they cannot be read).
+  std::optional<std::string> Lookup(absl::string_view key) const;
+
+  // Store()
+  //
+  // Stores `contents` under `key`, replacing any previous contents.
+  absl::Status Store(absl::string_view key, absl::string_view contents) const;
+
+ private:
+  std::string directory_;
+
+  // The path of the file that stores `key`.
+  std::string PathFor(absl::string_view key) const;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_TEST_CASE_CACHE_H_
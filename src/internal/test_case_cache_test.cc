@@ -0,0 +1,93 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/test_case_cache.h"
+
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+std::string TempDirectory(absl::string_view name) {
+  std::filesystem::path path = std::filesystem::path(::testing::TempDir()) /
+                               absl::StrCat("test_case_cache_", name);
+  std::filesystem::remove_all(path);
+  return path.string();
+}
+
+TEST(TestCaseCacheTest, LookupOfMissingKeyReturnsNothing) {
+  TestCaseCache cache(TempDirectory("missing"));
+  EXPECT_EQ(cache.Lookup("key"), std::nullopt);
+}
+
+TEST(TestCaseCacheTest, StoredContentsCanBeLookedUp) {
+  TestCaseCache cache(TempDirectory("stored"));
+  MORIARTY_ASSERT_OK(cache.Store("key", std::string("a\0b", 3)));
+  MORIARTY_ASSERT_OK(cache.Store("other key", "other"));
+
+  EXPECT_THAT(cache.Lookup("key"), Optional(Eq(std::string("a\0b", 3))));
+  EXPECT_THAT(cache.Lookup("other key"), Optional(Eq("other")));
+  EXPECT_EQ(cache.Lookup("third key"), std::nullopt);
+}
+
+TEST(TestCaseCacheTest, StoreReplacesPreviousContents) {
+  TestCaseCache cache(TempDirectory("replace"));
+  MORIARTY_ASSERT_OK(cache.Store("key", "first"));
+  MORIARTY_ASSERT_OK(cache.Store("key", "second"));
+  EXPECT_THAT(cache.Lookup("key"), Optional(Eq("second")));
+}
+
+TEST(TestCaseCacheTest, EntriesPersistAcrossInstances) {
+  std::string directory = TempDirectory("persist");
+  MORIARTY_ASSERT_OK(TestCaseCache(directory).Store("key", "value"));
+  EXPECT_THAT(TestCaseCache(directory).Lookup("key"), Optional(Eq("value")));
+}
+
+TEST(TestCaseCacheTest, ConcurrentCachesSharingADirectoryLeaveOneFile) {
+  // E.g., several processes storing the same entry at the same time. Each
+  // writes its own temporary file, which is renamed into place.
+  std::string directory = TempDirectory("concurrent");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&directory]() {
+      ABSL_CHECK_OK(TestCaseCache(directory).Store("key", "value"));
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_THAT(TestCaseCache(directory).Lookup("key"), Optional(Eq("value")));
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(directory),
+                          std::filesystem::directory_iterator()),
+            1);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,100 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/tracing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/attributes.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// Returns a small id for the current thread, assigned on first use.
+int CurrentThreadId() {
+  static std::atomic<int> next_thread_id = 0;
+  thread_local const int thread_id = next_thread_id.fetch_add(1);
+  return thread_id;
+}
+
+void AppendJsonString(std::string& out, absl::string_view str) {
+  out.push_back('"');
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppend(&out, "\\u00",
+                      absl::Hex(static_cast<uint8_t>(c), absl::kZeroPad2));
+    } else {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+}  // namespace
+
+ABSL_CONST_INIT std::atomic<TraceSink*> ScopedTraceSpan::trace_sink_ = nullptr;
+
+void SetTraceSink(TraceSink* sink) {
+  ScopedTraceSpan::trace_sink_.store(sink, std::memory_order_release);
+}
+
+TraceSink* GetTraceSink() {
+  return ScopedTraceSpan::trace_sink_.load(std::memory_order_acquire);
+}
+
+void ScopedTraceSpan::Finish() {
+  sink_->RecordSpan(name_, start_, absl::Now() - start_, CurrentThreadId());
+}
+
+void ChromeTraceSink::RecordSpan(absl::string_view name, absl::Time start,
+                                 absl::Duration duration, int thread_id) {
+  absl::MutexLock lock(&mutex_);
+  spans_.push_back({.name = name,
+                    .start = start,
+                    .duration = duration,
+                    .thread_id = thread_id});
+}
+
+std::string ChromeTraceSink::ToJson() const {
+  absl::MutexLock lock(&mutex_);
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+  for (const Span& span : spans_) {
+    if (!first) out.push_back(',');
+    first = false;
+    out += "{\"name\":";
+    AppendJsonString(out, span.name);
+    absl::StrAppend(
+        &out, ",\"ph\":\"X\",\"ts\":",
+        absl::ToDoubleMicroseconds(span.start - created_),
+        ",\"dur\":", absl::ToDoubleMicroseconds(span.duration),
+        ",\"pid\":0,\"tid\":", span.thread_id, "}");
+  }
+  out += "]}";
+  return out;
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
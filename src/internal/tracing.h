@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_TRACING_H_
+#define MORIARTY_SRC_INTERNAL_TRACING_H_
+
+// Moriarty's tracing hooks
+//
+// `MORIARTY_TRACE_SPAN("name")` records how long the rest of the enclosing
+// scope takes into the `TraceSink` set with `SetTraceSink()`. Spans surround
+// the main phases of generation (e.g., `GenerateAllValues` and
+// `MVariable::Generate`), importing and exporting.
+//
+// Without a sink, a span costs a single (predictable) branch, so the spans stay
+// compiled into release builds. Define `MORIARTY_DISABLE_TRACING` (e.g.,
+// `--copt=-DMORIARTY_DISABLE_TRACING`) to remove them entirely.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// TraceSink
+//
+// Receives the spans recorded by `MORIARTY_TRACE_SPAN`. Implement this
+// interface to forward spans to your own tracing system.
+class TraceSink {
+ public:
+  virtual ~TraceSink() = default;
+
+  // RecordSpan()
+  //
+  // Records that `name` ran on the thread `thread_id` from `start` for
+  // `duration`. `name` is a string literal. Thread ids are small integers,
+  // unique for the lifetime of the program. May be called concurrently from
+  // several threads.
+  virtual void RecordSpan(absl::string_view name, absl::Time start,
+                          absl::Duration duration, int thread_id) = 0;
+};
+
+// ChromeTraceSink
+//
+// Keeps all spans in memory and writes them in the Chrome trace event format,
+// which both chrome://tracing and Perfetto (ui.perfetto.dev) can open.
+class ChromeTraceSink : public TraceSink {
+ public:
+  void RecordSpan(absl::string_view name, absl::Time start,
+                  absl::Duration duration, int thread_id) override;
+
+  // ToJson()
+  //
+  // Returns a JSON object whose "traceEvents" field has one complete event
+  // ("ph": "X") per span, in the order they were recorded. Timestamps are in
+  // microseconds since this sink was created.
+  std::string ToJson() const;
+
+ private:
+  struct Span {
+    absl::string_view name;
+    absl::Time start;
+    absl::Duration duration;
+    int thread_id;
+  };
+
+  const absl::Time created_ = absl::Now();
+  mutable absl::Mutex mutex_;
+  std::vector<Span> spans_ ABSL_GUARDED_BY(mutex_);
+};
+
+// SetTraceSink()
+//
+// Sends all spans (from every thread) to `sink`, or stops tracing if `sink` is
+// `nullptr`. `sink` is not owned, and must outlive all spans that start while
+// it is set.
+void SetTraceSink(TraceSink* sink);
+
+// GetTraceSink()
+//
+// Returns the sink set with `SetTraceSink()`, or `nullptr` if there is none.
+TraceSink* GetTraceSink();
+
+// ScopedTraceSpan
+//
+// Records the time between its construction and destruction as a span. Use
+// `MORIARTY_TRACE_SPAN` instead of using this directly.
+class ScopedTraceSpan {
+ public:
+  explicit ScopedTraceSpan(absl::string_view name)
+      : sink_(trace_sink_.load(std::memory_order_acquire)), name_(name) {
+    if (ABSL_PREDICT_FALSE(sink_ != nullptr)) start_ = absl::Now();
+  }
+  ~ScopedTraceSpan() {
+    if (ABSL_PREDICT_FALSE(sink_ != nullptr)) Finish();
+  }
+
+  ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+  ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+ private:
+  friend void SetTraceSink(TraceSink* sink);
+  friend TraceSink* GetTraceSink();
+
+  // Kept out of line, so the disabled path stays small.
+  void Finish();
+
+  static std::atomic<TraceSink*> trace_sink_;
+
+  TraceSink* const sink_;
+  const absl::string_view name_;
+  absl::Time start_;
+};
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#define MORIARTY_TRACING_IMPL_CONCAT_INNER_(x, y) x##y
+#define MORIARTY_TRACING_IMPL_CONCAT_(x, y) \
+  MORIARTY_TRACING_IMPL_CONCAT_INNER_(x, y)
+
+// MORIARTY_TRACE_SPAN()
+//
+// Records the rest of the enclosing scope as a span named `name` (a string
+// literal). See the comment at the top of this file.
+#ifdef MORIARTY_DISABLE_TRACING
+#define MORIARTY_TRACE_SPAN(name) static_cast<void>(0)
+#else
+#define MORIARTY_TRACE_SPAN(name)                                   \
+  ::moriarty::moriarty_internal::ScopedTraceSpan                    \
+  MORIARTY_TRACING_IMPL_CONCAT_(moriarty_trace_span_, __LINE__)(name)
+#endif
+
+#endif  // MORIARTY_SRC_INTERNAL_TRACING_H_
@@ -0,0 +1,98 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/tracing.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
+class RecordingSink : public TraceSink {
+ public:
+  void RecordSpan(absl::string_view name, absl::Time start,
+                  absl::Duration duration, int thread_id) override {
+    names.push_back(std::string(name));
+  }
+
+  std::vector<std::string> names;
+};
+
+// Sets `sink` for the lifetime of this object.
+class ScopedSink {
+ public:
+  explicit ScopedSink(TraceSink* sink) { SetTraceSink(sink); }
+  ~ScopedSink() { SetTraceSink(nullptr); }
+};
+
+TEST(TracingTest, SpansShouldBeRecordedWhenTheyEnd) {
+  RecordingSink sink;
+  ScopedSink scoped(&sink);
+  {
+    MORIARTY_TRACE_SPAN("outer");
+    {
+      MORIARTY_TRACE_SPAN("inner1");
+    }
+    MORIARTY_TRACE_SPAN("inner2");
+  }
+
+  EXPECT_THAT(sink.names, ElementsAre("inner1", "inner2", "outer"));
+}
+
+TEST(TracingTest, SpansWithoutASinkShouldNotBeRecorded) {
+  RecordingSink sink;
+  {
+    MORIARTY_TRACE_SPAN("before");
+  }
+  {
+    ScopedSink scoped(&sink);
+    EXPECT_EQ(GetTraceSink(), &sink);
+  }
+  EXPECT_EQ(GetTraceSink(), nullptr);
+  {
+    MORIARTY_TRACE_SPAN("after");
+  }
+
+  EXPECT_THAT(sink.names, IsEmpty());
+}
+
+TEST(TracingTest, ChromeTraceSinkWithoutSpansShouldHaveNoEvents) {
+  EXPECT_EQ(ChromeTraceSink().ToJson(), "{\"traceEvents\":[]}");
+}
+
+TEST(TracingTest, ChromeTraceSinkShouldWriteCompleteEvents) {
+  ChromeTraceSink sink;
+  sink.RecordSpan("Generate\"A\"", absl::Now(), absl::Microseconds(5), 3);
+
+  std::string json = sink.ToJson();
+  EXPECT_THAT(json, HasSubstr("\"name\":\"Generate\\\"A\\\"\""));
+  EXPECT_THAT(json, HasSubstr("\"ph\":\"X\""));
+  EXPECT_THAT(json, HasSubstr("\"dur\":5,"));
+  EXPECT_THAT(json, HasSubstr("\"tid\":3}"));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
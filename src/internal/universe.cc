@@ -28,6 +28,7 @@
 #include "src/internal/generation_config.h"
 #include "src/internal/random_config.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/librarian/io_config.h"
@@ -185,5 +186,15 @@ Universe& Universe::SetGenerationConfig(GenerationConfig* generation_config) {
 
 GenerationConfig* Universe::GetGenerationConfig() { return generation_config_; }
 
+// ---------------------------------------------------------------------------
+//  Scheduler
+
+Universe& Universe::SetScheduler(Scheduler* scheduler) {
+  scheduler_ = scheduler;
+  return *this;
+}
+
+Scheduler* Universe::GetScheduler() const { return scheduler_; }
+
 }  // namespace moriarty_internal
 }  // namespace moriarty
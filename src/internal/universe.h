@@ -36,6 +36,7 @@
 #include "src/internal/generation_config.h"
 #include "src/internal/random_config.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_name_utils.h"
 #include "src/internal/variable_set.h"
@@ -126,6 +127,18 @@ class Universe {
   absl::StatusOr<typename T::value_type> GetValue(
       absl::string_view variable_name) const;
 
+  // GetValueRef<>()
+  //
+  // Same as `GetValue<>()`, but returns a pointer to the stored value instead
+  // of a copy (see `ValueSet::GetRef()`). Only values that are stored can be
+  // referenced, so unlike `GetValue<>()`, this does not compute subvalues
+  // (e.g., "A.length") or uniquely determined values of unassigned variables.
+  // Returns `ValueNotFoundError()` for the latter.
+  template <typename T>
+    requires std::derived_from<T, AbstractVariable>
+  absl::StatusOr<absl::Nonnull<const typename T::value_type*>> GetValueRef(
+      absl::string_view variable_name) const;
+
   // GetSubvalue<>()
   //
   // Returns the value for `subvalue_name` using the value assigned to
@@ -137,6 +150,14 @@ class Universe {
   absl::StatusOr<T> GetSubvalue(
       const VariableNameBreakdown& variable_name) const;
 
+  // GetSubvalue<>()
+  //
+  // Same as above, with the name already split into its base variable name
+  // (e.g., "A") and subvariable name (e.g., "length"), without copying either.
+  template <typename T>
+  absl::StatusOr<T> GetSubvalue(absl::string_view base_variable_name,
+                                absl::string_view subvariable_name) const;
+
   // GetOrGenerateAndSetValue<>()
   //
   // Returns the assigned value for `variable_name`. If that variable has not
@@ -216,6 +237,28 @@ class Universe {
   // determined by the caller of `SetGenerationConfig()`.
   GenerationConfig* GetGenerationConfig();
 
+  // ---------------------------------------------------------------------------
+  //  Scheduler
+
+  // The number of values checked together when a variable checks many
+  // independent values on several threads. See `SetScheduler()`.
+  constexpr static int kParallelValidationChunkSize = 1 << 14;
+
+  // SetScheduler()
+  //
+  // Sets the scheduler a single variable may use to check its value on several
+  // threads (e.g., the elements of a huge array). Ownership is not
+  // transferred to this class. Only set this when the values are not changed
+  // while checking them (e.g., when validating), since the checks may look up
+  // values from several threads at once.
+  Universe& SetScheduler(Scheduler* scheduler);
+
+  // GetScheduler()
+  //
+  // Returns the scheduler, or `nullptr` if there is none. See
+  // `SetScheduler()`.
+  Scheduler* GetScheduler() const;
+
  private:
   // None of these pointers are owned by this class
 
@@ -238,6 +281,8 @@ class Universe {
   // GenerationConfig
   GenerationConfig* generation_config_ = nullptr;
 
+  Scheduler* scheduler_ = nullptr;
+
   // Returns a const-correct version of VariableSet. See above. Returns
   // nullptr if non-existent.
   VariableSet* GetVariableSet();
@@ -248,6 +293,17 @@ class Universe {
   ValueSet* GetValueSet();
   const ValueSet* GetValueSet() const;
 
+  // TryGetValue<>()
+  //
+  // Same as `GetValue<>()`, but returns `std::nullopt` instead of
+  // `ValueNotFoundError()` if `variable_name` has no value. Every variable is
+  // missing the first time it is looked up while generating, so this is not
+  // an error for `GetOrGenerateAndSetValue<>()`.
+  template <typename T>
+    requires std::derived_from<T, AbstractVariable>
+  absl::StatusOr<std::optional<typename T::value_type>> TryGetValue(
+      absl::string_view variable_name) const;
+
   // AssignValueToVariable()
   //
   // Assigns `variable_name` to a specific value. If this variable has been
@@ -281,33 +337,69 @@ absl::StatusOr<T> Universe::GetVariable(absl::string_view variable_name) const {
   return ConvertTo<T>(var, variable_name);
 }
 
+template <typename T>
+  requires std::derived_from<T, AbstractVariable>
+absl::StatusOr<absl::Nonnull<const typename T::value_type*>>
+Universe::GetValueRef(absl::string_view variable_name) const {
+  if (!GetValueSet()) {
+    return MisconfiguredError("Universe", "GetValueRef",
+                              InternalConfigurationType::kValueSet);
+  }
+  if (SubvariableName(variable_name)) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "GetValueRef() cannot reference the subvalue `$0`. Use GetValue().",
+        variable_name));
+  }
+
+  return GetValueSet()->GetRef<T>(variable_name);
+}
+
 template <typename T>
   requires std::derived_from<T, AbstractVariable>
 absl::StatusOr<typename T::value_type> Universe::GetValue(
     absl::string_view variable_name) const {
+  MORIARTY_ASSIGN_OR_RETURN(std::optional<typename T::value_type> value,
+                            TryGetValue<T>(variable_name));
+  if (!value.has_value()) return ValueNotFoundError(variable_name);
+  return *std::move(value);
+}
+
+template <typename T>
+  requires std::derived_from<T, AbstractVariable>
+absl::StatusOr<std::optional<typename T::value_type>> Universe::TryGetValue(
+    absl::string_view variable_name) const {
   if (!GetValueSet()) {
     return MisconfiguredError("Universe", "GetValue",
                               InternalConfigurationType::kValueSet);
   }
 
-  if (HasSubvariable(variable_name)) {
-    return GetSubvalue<typename T::value_type>(
-        CreateVariableNameBreakdown(variable_name));
+  if (std::optional<absl::string_view> subvariable_name =
+          SubvariableName(variable_name)) {
+    absl::string_view base_variable_name = BaseVariableName(variable_name);
+    if (!GetValueSet()->Contains(base_variable_name)) {
+      MORIARTY_RETURN_IF_ERROR(
+          GetAbstractVariable(base_variable_name).status());
+      return std::nullopt;
+    }
+    return GetSubvalue<typename T::value_type>(base_variable_name,
+                                               *subvariable_name);
   }
 
-  absl::StatusOr<typename T::value_type> val =
-      GetValueSet()->Get<T>(variable_name);
-  if (val.ok() || !IsValueNotFoundError(val.status())) return val;
+  MORIARTY_ASSIGN_OR_RETURN(const typename T::value_type* stored,
+                            GetValueSet()->TryGetRef<T>(variable_name));
+  if (stored != nullptr) return *stored;
 
   // If no value is found with that name, we can see if there is a uniquely
   // determined value for the corresponding variable.
   MORIARTY_ASSIGN_OR_RETURN(const AbstractVariable* var,
                             GetAbstractVariable(variable_name));
 
+  // Fast path: the variable is exactly a `T`, so skip the `std::any`.
+  if (var->TypeId() == TypeIdOf<T>())
+    return static_cast<const T*>(var)->GetUniqueValueTyped();
+
   std::optional<std::any> unique_value = var->GetUniqueValueUntyped();
-  if (!unique_value.has_value()) {
-    return ValueNotFoundError(variable_name);
-  }
+  if (!unique_value.has_value()) return std::nullopt;
 
   using TV = typename T::value_type;
   const TV* typed_value = std::any_cast<TV>(&(*unique_value));
@@ -329,20 +421,26 @@ absl::StatusOr<T> Universe::GetSubvalue(
     return absl::FailedPreconditionError(absl::StrCat(
         variable_name.base_variable_name, " has no subvariable name"));
   }
+  return GetSubvalue<T>(variable_name.base_variable_name,
+                        *variable_name.subvariable_name);
+}
+
+template <typename T>
+absl::StatusOr<T> Universe::GetSubvalue(
+    absl::string_view base_variable_name,
+    absl::string_view subvariable_name) const {
+  MORIARTY_ASSIGN_OR_RETURN(const AbstractVariable* var,
+                            GetAbstractVariable(base_variable_name));
+  // Avoid copying the (possibly large) base value just to extract a piece.
   MORIARTY_ASSIGN_OR_RETURN(
-      const AbstractVariable* var,
-      GetAbstractVariable(variable_name.base_variable_name));
-  MORIARTY_ASSIGN_OR_RETURN(
-      std::any base_value,
-      GetValueSet()->UnsafeGet(variable_name.base_variable_name));
-  MORIARTY_ASSIGN_OR_RETURN(
-      std::any value,
-      var->GetSubvalue(base_value, *variable_name.subvariable_name));
+      std::any value, GetValueSet()->UnsafeGetSubvalue(base_variable_name, *var,
+                                                       subvariable_name));
   const T* val = std::any_cast<const T>(&value);
   if (val == nullptr)
-    return absl::FailedPreconditionError(
-        absl::StrCat("Subvalue ", ConstructVariableName(variable_name),
-                     " returned the wrong type"));
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Subvalue ",
+        ConstructVariableName(base_variable_name, subvariable_name),
+        " returned the wrong type"));
   return *val;
 }
 
@@ -350,9 +448,9 @@ template <typename T>
   requires std::derived_from<T, AbstractVariable>
 absl::StatusOr<typename T::value_type> Universe::GetOrGenerateAndSetValue(
     absl::string_view variable_name) {
-  auto val = GetValue<T>(variable_name);
-
-  if (val.ok() || !IsValueNotFoundError(val.status())) return val;
+  MORIARTY_ASSIGN_OR_RETURN(std::optional<typename T::value_type> value,
+                            TryGetValue<T>(variable_name));
+  if (value.has_value()) return *std::move(value);
 
   if (const_value_set_ != nullptr) {
     return absl::FailedPreconditionError(absl::Substitute(
@@ -158,6 +158,29 @@ TEST(UniverseTest, GetValueShouldWorkIfValuesAreProvided) {
   EXPECT_THAT(universe.GetValue<MTestType>("B"), IsOkAndHolds(20));
 }
 
+TEST(UniverseTest, GetValueRefReturnsTheStoredValue) {
+  ValueSet values;
+  values.Set<MTestType>("A", TestType(10));
+
+  Universe universe = Universe().SetConstValueSet(&values);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(const TestType* a,
+                                universe.GetValueRef<MTestType>("A"));
+  EXPECT_EQ(*a, 10);
+  EXPECT_THAT(universe.GetValueRef<MTestType>("A"), IsOkAndHolds(a));
+  EXPECT_THAT(universe.GetValueRef<MTestType>("B"), IsValueNotFound("B"));
+}
+
+TEST(UniverseTest, GetValueRefCannotReferenceSubvalues) {
+  ValueSet values;
+  values.Set<MTestType>("A", TestType(10));
+
+  Universe universe = Universe().SetConstValueSet(&values);
+
+  EXPECT_THAT(universe.GetValueRef<MTestType>("A.length"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(UniverseTest, ConstGetValueDoesNotAttemptToGenerate) {
   VariableSet variables;
   ValueSet values;
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_VALUE_CODEC_H_
+#define MORIARTY_SRC_INTERNAL_VALUE_CODEC_H_
+
+// A compact, portable binary encoding for the values of Moriarty's built-in
+// types. Integers are zigzag-encoded varints, strings and vectors are prefixed
+// by their length and tuples are their elements in order. The encoding does
+// not include the type, so values must be decoded with the type they were
+// encoded with.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// IsBinaryEncodable()
+//
+// Returns true if values of type `T` can be passed to `EncodeValue()` and
+// `DecodeValue()`: integers, strings, and vectors or tuples of these.
+template <typename T>
+constexpr bool IsBinaryEncodable();
+
+// EncodeValue()
+//
+// Appends the encoding of `value` to `out`.
+template <typename T>
+  requires(IsBinaryEncodable<T>())
+void EncodeValue(const T& value, std::string& out);
+
+// DecodeValue()
+//
+// Decodes a value of type `T` from the front of `in` into `value`, and
+// removes it from `in`. Returns false if `in` does not start with a valid
+// encoding of a `T`.
+template <typename T>
+  requires(IsBinaryEncodable<T>())
+[[nodiscard]] bool DecodeValue(absl::string_view& in, T& value);
+
+// AppendVarint()
+//
+// Appends `value` to `out` as a varint (7 bits per byte, least significant
+// first).
+void AppendVarint(uint64_t value, std::string& out);
+
+// ReadVarint()
+//
+// Reads a varint from the front of `in` into `value`, and removes it from
+// `in`. Returns false if `in` does not start with a valid varint.
+[[nodiscard]] bool ReadVarint(absl::string_view& in, uint64_t& value);
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+namespace value_codec_internal {
+
+template <typename T>
+struct IsVector : std::false_type {};
+template <typename T>
+struct IsVector<std::vector<T>> : std::true_type {};
+
+template <typename T>
+struct IsTuple : std::false_type {};
+template <typename... Ts>
+struct IsTuple<std::tuple<Ts...>> : std::true_type {};
+
+}  // namespace value_codec_internal
+
+template <typename T>
+constexpr bool IsBinaryEncodable() {
+  if constexpr (std::is_integral_v<T>) {
+    return true;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    return true;
+  } else if constexpr (value_codec_internal::IsVector<T>::value) {
+    return IsBinaryEncodable<typename T::value_type>();
+  } else if constexpr (value_codec_internal::IsTuple<T>::value) {
+    return []<size_t... I>(std::index_sequence<I...>) {
+      return (IsBinaryEncodable<std::tuple_element_t<I, T>>() && ...);
+    }(std::make_index_sequence<std::tuple_size_v<T>>());
+  } else {
+    return false;
+  }
+}
+
+template <typename T>
+  requires(IsBinaryEncodable<T>())
+void EncodeValue(const T& value, std::string& out) {
+  if constexpr (std::is_integral_v<T>) {
+    if constexpr (std::is_signed_v<T>) {
+      // Zigzag, so small negative numbers are short too.
+      uint64_t bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+      AppendVarint((bits << 1) ^ (value < 0 ? ~uint64_t{0} : 0), out);
+    } else {
+      AppendVarint(static_cast<uint64_t>(value), out);
+    }
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    AppendVarint(value.size(), out);
+    out.append(value);
+  } else if constexpr (value_codec_internal::IsVector<T>::value) {
+    AppendVarint(value.size(), out);
+    for (const auto& element : value) EncodeValue(element, out);
+  } else {
+    std::apply(
+        [&out](const auto&... elements) { (EncodeValue(elements, out), ...); },
+        value);
+  }
+}
+
+template <typename T>
+  requires(IsBinaryEncodable<T>())
+bool DecodeValue(absl::string_view& in, T& value) {
+  if constexpr (std::is_integral_v<T>) {
+    uint64_t bits;
+    if (!ReadVarint(in, bits)) return false;
+    if constexpr (std::is_signed_v<T>) {
+      int64_t decoded = static_cast<int64_t>(bits >> 1) ^
+                        -static_cast<int64_t>(bits & 1);
+      if (decoded < std::numeric_limits<T>::min() ||
+          decoded > std::numeric_limits<T>::max()) {
+        return false;
+      }
+      value = static_cast<T>(decoded);
+    } else {
+      if (bits > std::numeric_limits<T>::max()) return false;
+      value = static_cast<T>(bits);
+    }
+    return true;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    uint64_t size;
+    if (!ReadVarint(in, size) || size > in.size()) return false;
+    value.assign(in.substr(0, size));
+    in.remove_prefix(size);
+    return true;
+  } else if constexpr (value_codec_internal::IsVector<T>::value) {
+    uint64_t size;
+    // Each element takes at least one byte, so this also guards against
+    // allocating a huge vector for a corrupt length.
+    if (!ReadVarint(in, size) || size > in.size()) return false;
+    value.clear();
+    value.reserve(size);
+    for (uint64_t i = 0; i < size; i++) {
+      typename T::value_type element;
+      if (!DecodeValue(in, element)) return false;
+      value.push_back(std::move(element));
+    }
+    return true;
+  } else {
+    return std::apply(
+        [&in](auto&... elements) { return (DecodeValue(in, elements) && ...); },
+        value);
+  }
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_VALUE_CODEC_H_
@@ -0,0 +1,125 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/internal/value_codec.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+template <typename T>
+T RoundTrip(const T& value) {
+  std::string encoded;
+  EncodeValue(value, encoded);
+  absl::string_view in = encoded;
+  T decoded;
+  EXPECT_TRUE(DecodeValue(in, decoded));
+  EXPECT_THAT(in, IsEmpty());
+  return decoded;
+}
+
+TEST(ValueCodecTest, IsBinaryEncodableAcceptsBuiltInTypes) {
+  static_assert(IsBinaryEncodable<int64_t>());
+  static_assert(IsBinaryEncodable<char>());
+  static_assert(IsBinaryEncodable<std::string>());
+  static_assert(IsBinaryEncodable<std::vector<std::vector<int64_t>>>());
+  static_assert(
+      IsBinaryEncodable<std::tuple<int64_t, std::vector<std::string>>>());
+  static_assert(!IsBinaryEncodable<double>());
+  static_assert(!IsBinaryEncodable<std::vector<double>>());
+  static_assert(!IsBinaryEncodable<std::tuple<int64_t, double>>());
+}
+
+TEST(ValueCodecTest, IntegersRoundTrip) {
+  for (int64_t value : {int64_t{0}, int64_t{1}, int64_t{-1}, int64_t{127},
+                        int64_t{-128}, int64_t{1} << 40,
+                        std::numeric_limits<int64_t>::min(),
+                        std::numeric_limits<int64_t>::max()}) {
+    EXPECT_EQ(RoundTrip(value), value);
+  }
+  EXPECT_EQ(RoundTrip(std::numeric_limits<uint64_t>::max()),
+            std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(RoundTrip('x'), 'x');
+}
+
+TEST(ValueCodecTest, SmallIntegersAreEncodedInOneByte) {
+  for (int64_t value : {0, 1, -1, 63, -64}) {
+    std::string encoded;
+    EncodeValue(value, encoded);
+    EXPECT_EQ(encoded.size(), 1) << value;
+  }
+}
+
+TEST(ValueCodecTest, ContainersRoundTrip) {
+  EXPECT_EQ(RoundTrip(std::string("hello\0world", 11)),
+            std::string("hello\0world", 11));
+  EXPECT_THAT(RoundTrip(std::vector<std::string>{"a", "", "bc"}),
+              ElementsAre("a", "", "bc"));
+  EXPECT_THAT(RoundTrip(std::vector<std::vector<int64_t>>{{1, 2}, {}, {-3}}),
+              ElementsAre(ElementsAre(1, 2), IsEmpty(), ElementsAre(-3)));
+
+  std::tuple<int64_t, std::string, std::vector<int64_t>> tuple = {
+      -5, "abc", {7, 8}};
+  EXPECT_EQ(RoundTrip(tuple), tuple);
+}
+
+TEST(ValueCodecTest, DecodingConsumesOnlyOneValue) {
+  std::string encoded;
+  EncodeValue(int64_t{5}, encoded);
+  EncodeValue(std::string("six"), encoded);
+
+  absl::string_view in = encoded;
+  int64_t first;
+  std::string second;
+  ASSERT_TRUE(DecodeValue(in, first));
+  ASSERT_TRUE(DecodeValue(in, second));
+  EXPECT_EQ(first, 5);
+  EXPECT_EQ(second, "six");
+  EXPECT_THAT(in, IsEmpty());
+}
+
+TEST(ValueCodecTest, DecodingTruncatedInputFails) {
+  std::string encoded;
+  EncodeValue(std::vector<std::string>{"hello", "world"}, encoded);
+  for (int size = 0; size < encoded.size(); size++) {
+    absl::string_view in = absl::string_view(encoded).substr(0, size);
+    std::vector<std::string> decoded;
+    EXPECT_FALSE(DecodeValue(in, decoded)) << size;
+  }
+}
+
+TEST(ValueCodecTest, DecodingOutOfRangeIntegerFails) {
+  std::string encoded;
+  EncodeValue(int64_t{1000}, encoded);
+  absl::string_view in = encoded;
+  char decoded;
+  EXPECT_FALSE(DecodeValue(in, decoded));
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -16,19 +16,30 @@
 
 #include <any>
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <variant>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "src/errors.h"
+#include "src/internal/abstract_variable.h"
+#include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 namespace moriarty_internal {
 
 bool ValueSet::Contains(absl::string_view variable_name) const {
-  return values_.contains(variable_name);
+  return values_.contains(variable_name) ||
+         (shared_values_ != nullptr && shared_values_->Contains(variable_name));
+}
+
+void ValueSet::SetSharedValues(std::shared_ptr<const ValueSet> shared_values) {
+  shared_values_ = std::move(shared_values);
 }
 
 void ValueSet::Erase(absl::string_view variable_name) {
@@ -39,14 +50,100 @@ void ValueSet::Erase(absl::string_view variable_name) {
   // size of the objects as they are `Set` and subtract the proper size rather
   // than just 1.
   approximate_size_--;
+  byte_size_ -= it->second.byte_size;
+  allocated_bytes_ -= it->second.allocated_bytes;
   values_.erase(it);
+  subvalue_cache_.Erase(variable_name);
 }
 
 absl::StatusOr<std::any> ValueSet::UnsafeGet(
     absl::string_view variable_name) const {
   auto it = values_.find(variable_name);
-  if (it == values_.end()) return ValueNotFoundError(variable_name);
-  return it->second;
+  if (it == values_.end()) {
+    if (shared_values_ != nullptr)
+      return shared_values_->UnsafeGet(variable_name);
+    return ValueNotFoundError(variable_name);
+  }
+  return std::visit([](const auto& value) -> std::any { return value; },
+                    it->second.value);
+}
+
+absl::StatusOr<std::any> ValueSet::UnsafeGetSubvalue(
+    absl::string_view variable_name, const AbstractVariable& variable,
+    absl::string_view subvalue_name) const {
+  auto it = values_.find(variable_name);
+  if (it == values_.end()) {
+    // The shared values keep their own cache, so it is shared as well.
+    if (shared_values_ != nullptr) {
+      return shared_values_->UnsafeGetSubvalue(variable_name, variable,
+                                               subvalue_name);
+    }
+    return ValueNotFoundError(variable_name);
+  }
+
+  if (std::optional<int64_t> cached =
+          subvalue_cache_.Find(variable_name, subvalue_name)) {
+    return *cached;
+  }
+
+  // Containers and user types are already in a std::any, so those are not
+  // copied. Values stored directly are small enough to copy.
+  absl::StatusOr<std::any> subvalue;
+  if (const std::any* stored = std::get_if<std::any>(&it->second.value)) {
+    subvalue = variable.GetSubvalue(*stored, subvalue_name);
+  } else {
+    MORIARTY_ASSIGN_OR_RETURN(std::any value, UnsafeGet(variable_name));
+    subvalue = variable.GetSubvalue(value, subvalue_name);
+  }
+
+  if (subvalue.ok()) {
+    if (const int64_t* integer = std::any_cast<int64_t>(&*subvalue))
+      subvalue_cache_.Insert(variable_name, subvalue_name, *integer);
+  }
+  return subvalue;
+}
+
+ValueSet::SubvalueCache& ValueSet::SubvalueCache::operator=(
+    const SubvalueCache&) {
+  absl::MutexLock lock(&mutex_);
+  values_.clear();
+  has_values_ = false;
+  return *this;
+}
+
+ValueSet::SubvalueCache& ValueSet::SubvalueCache::operator=(
+    SubvalueCache&&) noexcept {
+  absl::MutexLock lock(&mutex_);
+  values_.clear();
+  has_values_ = false;
+  return *this;
+}
+
+std::optional<int64_t> ValueSet::SubvalueCache::Find(
+    absl::string_view variable_name, absl::string_view subvalue_name) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = values_.find(variable_name);
+  if (it == values_.end()) return std::nullopt;
+  auto subvalue_it = it->second.find(subvalue_name);
+  if (subvalue_it == it->second.end()) return std::nullopt;
+  return subvalue_it->second;
+}
+
+void ValueSet::SubvalueCache::Insert(absl::string_view variable_name,
+                                     absl::string_view subvalue_name,
+                                     int64_t value) {
+  absl::MutexLock lock(&mutex_);
+  values_[variable_name][subvalue_name] = value;
+  has_values_ = true;
+}
+
+void ValueSet::SubvalueCache::Erase(absl::string_view variable_name) {
+  // `Erase()` is only called on a non-const ValueSet, so no `Insert()` runs
+  // concurrently.
+  if (!has_values_) return;
+  absl::MutexLock lock(&mutex_);
+  values_.erase(variable_name);
+  has_values_ = !values_.empty();
 }
 
 int64_t ValueSet::ApproximateSize(const std::string& value) const {
@@ -17,20 +17,31 @@
 #ifndef MORIARTY_SRC_INTERNAL_VALUE_SET_H_
 #define MORIARTY_SRC_INTERNAL_VALUE_SET_H_
 
+#include <algorithm>
 #include <any>
+#include <atomic>
 #include <concepts>
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "src/errors.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/generation_profile.h"
 
 namespace moriarty {
 namespace moriarty_internal {
@@ -41,6 +52,12 @@ namespace moriarty_internal {
 // in and take them out. Nothing more. Logically equivalent to
 //
 //   std::map<std::string, std::any>
+//
+// Internally, `int64_t` and `std::string` values are stored directly (not in a
+// `std::any`) so the most common lookups avoid an `any_cast`.
+//
+// A ValueSet may also see the values of another, immutable, ValueSet (see
+// `SetSharedValues()`) without copying them.
 class ValueSet {
  public:
   // Set()
@@ -62,6 +79,47 @@ class ValueSet {
   absl::StatusOr<typename T::value_type> Get(
       absl::string_view variable_name) const;
 
+  // GetRef()
+  //
+  // Same as `Get()`, but returns a pointer to the stored value instead of a
+  // copy. The pointer is valid until `variable_name` is `Set()`, `Mutate()`d or
+  // `Erase()`d, or this set is destroyed.
+  //
+  //  * If `variable_name` is non-existent, returns `ValueNotFoundError()`.
+  //  * If the value cannot be converted to T, returns kFailedPrecondition.
+  template <typename T>
+    requires std::derived_from<T, AbstractVariable>
+  absl::StatusOr<absl::Nonnull<const typename T::value_type*>> GetRef(
+      absl::string_view variable_name) const;
+
+  // TryGetRef()
+  //
+  // Same as `GetRef()`, but returns `nullptr` if `variable_name` is
+  // non-existent. Missing values are expected while generating, so this avoids
+  // building a `ValueNotFoundError()` for each one.
+  //
+  //  * If the value cannot be converted to T, returns kFailedPrecondition.
+  template <typename T>
+    requires std::derived_from<T, AbstractVariable>
+  absl::StatusOr<absl::Nullable<const typename T::value_type*>> TryGetRef(
+      absl::string_view variable_name) const;
+
+  // Mutate()
+  //
+  // Calls `mutate` on the stored value for the variable `variable_name`,
+  // changing it in place instead of copying it out and `Set()`ing it back.
+  // Returns the status returned by `mutate`. The value may be changed even if
+  // that status is not OK. A shared value (see `SetSharedValues()`) is copied
+  // into this set first, and the shared value is left unchanged.
+  //
+  //  * If `variable_name` is non-existent, returns `ValueNotFoundError()`.
+  //  * If the value cannot be converted to T, returns kFailedPrecondition.
+  template <typename T>
+    requires std::derived_from<T, AbstractVariable>
+  absl::Status Mutate(
+      absl::string_view variable_name,
+      absl::FunctionRef<absl::Status(typename T::value_type&)> mutate);
+
   // UnsafeGet()
   //
   // Returns the std::any value for the variable `variable_name`. Should only be
@@ -70,17 +128,56 @@ class ValueSet {
   //  Returns ValueNotFoundError if the variable has not been set.
   absl::StatusOr<std::any> UnsafeGet(absl::string_view variable_name) const;
 
+  // UnsafeGetSubvalue()
+  //
+  // Returns `variable.GetSubvalue(value, subvalue_name)`, where `value` is the
+  // stored value for `variable_name`. This does not copy the stored value, so
+  // should be preferred over `UnsafeGet()` when only a subvalue is needed.
+  //
+  // Integer subvalues (e.g., "length") are cached until `variable_name` is
+  // `Set()` or `Erase()`d, since they are often needed once per element of
+  // another variable.
+  //
+  //  Returns ValueNotFoundError if the variable has not been set.
+  absl::StatusOr<std::any> UnsafeGetSubvalue(
+      absl::string_view variable_name, const AbstractVariable& variable,
+      absl::string_view subvalue_name) const;
+
   // Contains()
   //
-  // Determines if `variable_name` is in this ValueSet.
+  // Determines if `variable_name` is in this ValueSet (or its shared values).
   bool Contains(absl::string_view variable_name) const;
 
+  // NumValues()
+  //
+  // The number of variables with a stored value in this ValueSet, not
+  // counting its shared values.
+  int NumValues() const { return values_.size(); }
+
   // Erase()
   //
   // Deletes the stored value for the variable `variable_name`. If
-  // `variable_name` is non-existent, this is a no-op.
+  // `variable_name` is non-existent, this is a no-op. Shared values are never
+  // erased.
   void Erase(absl::string_view variable_name);
 
+  // SetSharedValues()
+  //
+  // Makes the values in `shared_values` visible from this set, without copying
+  // them. They are looked up when `variable_name` is not stored in this set,
+  // and are never changed through it. Shared values are not counted by
+  // `NumValues()` or by any of the sizes below, so the same shared values may
+  // be used by many sets (e.g., every test case) for free.
+  void SetSharedValues(std::shared_ptr<const ValueSet> shared_values);
+
+  // GetSharedValues()
+  //
+  // Returns the values set by `SetSharedValues()`, or `nullptr` if there are
+  // none.
+  const std::shared_ptr<const ValueSet>& GetSharedValues() const {
+    return shared_values_;
+  }
+
   // GetApproximateSize()
   //
   // The "size" of a value set is a rough approximation of how large the whole
@@ -95,10 +192,76 @@ class ValueSet {
   // since we are not sure if this is a long term solution.
   int64_t GetApproximateSize() const { return approximate_size_; }
 
+  // GetByteSize()
+  //
+  // The number of bytes of data in the values currently in this set, where
+  // each value's size is `T::ValueByteSize()` of the `T` it was `Set()` with
+  // (see `MVariable::ValueByteSize()`). Unlike `GetApproximateSize()`,
+  // overwritten and erased values are no longer counted.
+  int64_t GetByteSize() const { return byte_size_; }
+
+  // GetAllocatedBytes()
+  //
+  // The number of bytes held by the values currently in this set (see
+  // `AllocatedByteSize()`). Unlike `GetApproximateSize()`, overwritten and
+  // erased values are no longer counted.
+  int64_t GetAllocatedBytes() const { return allocated_bytes_; }
+
+  // GetPeakAllocatedBytes()
+  //
+  // The largest `GetAllocatedBytes()` has been since this set was created.
+  int64_t GetPeakAllocatedBytes() const { return peak_allocated_bytes_; }
+
  private:
-  absl::flat_hash_map<std::string, std::any> values_;
+  // Types that are stored directly in `StoredValue` instead of in a
+  // `std::any`. These must be alternatives of `StoredValue`.
+  template <typename T>
+  static constexpr bool kStoredDirectly =
+      std::is_same_v<T, int64_t> || std::is_same_v<T, std::string>;
+  using StoredValue = std::variant<std::any, int64_t, std::string>;
+
+  struct Entry {
+    StoredValue value;
+    int64_t byte_size = 0;
+    int64_t allocated_bytes = 0;
+  };
+  absl::flat_hash_map<std::string, Entry> values_;
+
+  // See `SetSharedValues()`.
+  std::shared_ptr<const ValueSet> shared_values_;
 
   int64_t approximate_size_ = 0;
+  int64_t byte_size_ = 0;
+  int64_t allocated_bytes_ = 0;
+  int64_t peak_allocated_bytes_ = 0;
+
+  // Integer subvalues that have already been computed, by variable name and
+  // then subvalue name. Thread-safe, so that const ValueSets may be shared.
+  // Copies (and moved-to caches) start empty. `Erase()` is called on every
+  // `Set()` (e.g., once per value read by an importer), so it does not lock
+  // the mutex when nothing is cached.
+  class SubvalueCache {
+   public:
+    SubvalueCache() = default;
+    SubvalueCache(const SubvalueCache&) {}
+    SubvalueCache(SubvalueCache&&) noexcept {}
+    SubvalueCache& operator=(const SubvalueCache&);
+    SubvalueCache& operator=(SubvalueCache&&) noexcept;
+
+    std::optional<int64_t> Find(absl::string_view variable_name,
+                                absl::string_view subvalue_name) const;
+    void Insert(absl::string_view variable_name,
+                absl::string_view subvalue_name, int64_t value);
+    void Erase(absl::string_view variable_name);
+
+   private:
+    mutable absl::Mutex mutex_;
+    absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, int64_t>>
+        values_ ABSL_GUARDED_BY(mutex_);
+    // False only if `values_` is empty. Only changed while holding `mutex_`.
+    std::atomic<bool> has_values_ = false;
+  };
+  mutable SubvalueCache subvalue_cache_;
 
   template <typename T>
   int64_t ApproximateSize(const T& value) const;
@@ -107,6 +270,11 @@ class ValueSet {
   int64_t ApproximateSize(const std::vector<T>& values) const;
 
   int64_t ApproximateSize(const std::string& value) const;
+
+  // `T::ValueByteSize(value)`, or `ApproximateByteSize(value)` for types
+  // without one.
+  template <typename T>
+  static int64_t ValueByteSize(const typename T::value_type& value);
 };
 
 // -----------------------------------------------------------------------------
@@ -116,23 +284,114 @@ template <typename T>
   requires std::derived_from<T, AbstractVariable>
 absl::StatusOr<typename T::value_type> ValueSet::Get(
     absl::string_view variable_name) const {
+  absl::StatusOr<const typename T::value_type*> val = GetRef<T>(variable_name);
+  if (!val.ok()) return val.status();
+  return **val;
+}
+
+template <typename T>
+  requires std::derived_from<T, AbstractVariable>
+absl::StatusOr<absl::Nonnull<const typename T::value_type*>> ValueSet::GetRef(
+    absl::string_view variable_name) const {
+  absl::StatusOr<const typename T::value_type*> val =
+      TryGetRef<T>(variable_name);
+  if (val.ok() && *val == nullptr) return ValueNotFoundError(variable_name);
+  return val;
+}
+
+template <typename T>
+  requires std::derived_from<T, AbstractVariable>
+absl::StatusOr<absl::Nullable<const typename T::value_type*>>
+ValueSet::TryGetRef(absl::string_view variable_name) const {
   auto it = values_.find(variable_name);
-  if (it == values_.end()) return ValueNotFoundError(variable_name);
+  if (it == values_.end()) {
+    if (shared_values_ == nullptr) return nullptr;
+    return shared_values_->TryGetRef<T>(variable_name);
+  }
 
   using TV = typename T::value_type;
-  const TV* val = std::any_cast<const TV>(&it->second);
+  const TV* val = nullptr;
+  if constexpr (kStoredDirectly<TV>) {
+    val = std::get_if<TV>(&it->second.value);
+  } else if (const std::any* stored =
+                 std::get_if<std::any>(&it->second.value)) {
+    val = std::any_cast<const TV>(stored);
+  }
   if (val == nullptr)
     return absl::FailedPreconditionError(
         absl::Substitute("Unable to cast $0", variable_name));
 
-  return *val;
+  return val;
 }
 
 template <typename T>
   requires std::derived_from<T, AbstractVariable>
 void ValueSet::Set(absl::string_view variable_name, T::value_type value) {
+  using TV = typename T::value_type;
   approximate_size_ += ApproximateSize(value);
-  values_[variable_name] = std::move(value);
+  subvalue_cache_.Erase(variable_name);
+  Entry& entry = values_[variable_name];
+  const int64_t byte_size = ValueByteSize<T>(value);
+  byte_size_ += byte_size - entry.byte_size;
+  entry.byte_size = byte_size;
+  const int64_t allocated_bytes = AllocatedByteSize(value);
+  allocated_bytes_ += allocated_bytes - entry.allocated_bytes;
+  entry.allocated_bytes = allocated_bytes;
+  peak_allocated_bytes_ = std::max(peak_allocated_bytes_, allocated_bytes_);
+  if constexpr (kStoredDirectly<TV>) {
+    entry.value.template emplace<TV>(std::move(value));
+  } else {
+    entry.value.template emplace<std::any>(std::move(value));
+  }
+}
+
+template <typename T>
+  requires std::derived_from<T, AbstractVariable>
+absl::Status ValueSet::Mutate(
+    absl::string_view variable_name,
+    absl::FunctionRef<absl::Status(typename T::value_type&)> mutate) {
+  using TV = typename T::value_type;
+  auto it = values_.find(variable_name);
+  if (it == values_.end()) {
+    if (shared_values_ == nullptr) return ValueNotFoundError(variable_name);
+    // Shared values are immutable, so this set gets its own copy to change.
+    absl::StatusOr<const TV*> shared =
+        shared_values_->GetRef<T>(variable_name);
+    if (!shared.ok()) return shared.status();
+    Set<T>(variable_name, **shared);
+    it = values_.find(variable_name);
+  }
+
+  Entry& entry = it->second;
+  TV* val = nullptr;
+  if constexpr (kStoredDirectly<TV>) {
+    val = std::get_if<TV>(&entry.value);
+  } else if (std::any* stored = std::get_if<std::any>(&entry.value)) {
+    val = std::any_cast<TV>(stored);
+  }
+  if (val == nullptr)
+    return absl::FailedPreconditionError(
+        absl::Substitute("Unable to cast $0", variable_name));
+
+  subvalue_cache_.Erase(variable_name);
+  absl::Status status = mutate(*val);
+  const int64_t byte_size = ValueByteSize<T>(*val);
+  byte_size_ += byte_size - entry.byte_size;
+  entry.byte_size = byte_size;
+  const int64_t allocated_bytes = AllocatedByteSize(*val);
+  allocated_bytes_ += allocated_bytes - entry.allocated_bytes;
+  entry.allocated_bytes = allocated_bytes;
+  peak_allocated_bytes_ = std::max(peak_allocated_bytes_, allocated_bytes_);
+  return status;
+}
+
+template <typename T>
+int64_t ValueSet::ValueByteSize(const typename T::value_type& value) {
+  if constexpr (requires { T::ValueByteSize(value); }) {
+    return T::ValueByteSize(value);
+  } else {
+    return ApproximateByteSize(value);
+  }
 }
 
 template <typename T>
@@ -16,12 +16,17 @@
 
 #include <any>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "src/internal/generation_profile.h"
+#include "src/testing/mtest_type.h"
 #include "src/testing/status_test_util.h"
 #include "src/util/test_status_macro/status_testutil.h"
 #include "src/variables/marray.h"
@@ -35,7 +40,10 @@ namespace {
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 using ::moriarty_testing::IsValueNotFound;
+using ::moriarty_testing::MTestType;
 using ::testing::AnyWith;
+using ::testing::ElementsAre;
+using ::testing::Pointee;
 using ::testing::StrEq;
 
 TEST(ValueSetTest, SimpleGetAndSetWorks) {
@@ -80,6 +88,95 @@ TEST(ValueSetTest, RequestingTheWrongTypeShouldThrow) {
   EXPECT_THAT(value_set.Get<MString>("x"), IsOkAndHolds(StrEq("hello")));
 }
 
+TEST(ValueSetTest, GetRefReturnsTheStoredValueWithoutCopyingIt) {
+  ValueSet value_set;
+  value_set.Set<MArray<MInteger>>("x", {1, 2, 3});
+  value_set.Set<MString>("y", "hello");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(const std::vector<int64_t>* x,
+                                value_set.GetRef<MArray<MInteger>>("x"));
+  EXPECT_THAT(*x, ElementsAre(1, 2, 3));
+  EXPECT_THAT(value_set.GetRef<MArray<MInteger>>("x"), IsOkAndHolds(x));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(const std::string* y,
+                                value_set.GetRef<MString>("y"));
+  EXPECT_EQ(*y, "hello");
+}
+
+TEST(ValueSetTest, GetRefWithAMissingVariableOrTheWrongTypeFails) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 10);
+
+  EXPECT_THAT(value_set.GetRef<MInteger>("y"), IsValueNotFound("y"));
+  EXPECT_THAT(value_set.GetRef<MString>("x"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(ValueSetTest, TryGetRefReturnsNullForAMissingVariable) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 10);
+
+  EXPECT_THAT(value_set.TryGetRef<MInteger>("y"), IsOkAndHolds(nullptr));
+  EXPECT_THAT(value_set.TryGetRef<MInteger>("x"), IsOkAndHolds(Pointee(10)));
+  EXPECT_THAT(value_set.TryGetRef<MString>("x"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(ValueSetTest, MutateChangesTheStoredValueInPlace) {
+  ValueSet value_set;
+  value_set.Set<MArray<MInteger>>("x", {1, 2, 3});
+  value_set.Set<MString>("y", "hello");
+
+  MORIARTY_EXPECT_OK(value_set.Mutate<MArray<MInteger>>(
+      "x", [](std::vector<int64_t>& x) {
+        x[1] = 20;
+        return absl::OkStatus();
+      }));
+  MORIARTY_EXPECT_OK(value_set.Mutate<MString>("y", [](std::string& y) {
+    y += " world";
+    return absl::OkStatus();
+  }));
+
+  EXPECT_THAT(value_set.Get<MArray<MInteger>>("x"),
+              IsOkAndHolds(ElementsAre(1, 20, 3)));
+  EXPECT_THAT(value_set.Get<MString>("y"), IsOkAndHolds(StrEq("hello world")));
+  EXPECT_EQ(value_set.GetByteSize(), 3 * 8 + 11);
+}
+
+TEST(ValueSetTest, MutateReturnsTheStatusOfTheMutation) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 5);
+  EXPECT_THAT(value_set.Mutate<MInteger>("x",
+                                         [](int64_t& x) {
+                                           return absl::InvalidArgumentError(
+                                               "bad mutation");
+                                         }),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ValueSetTest, MutateWithAMissingVariableOrTheWrongTypeFails) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 5);
+  auto no_op = [](std::string&) { return absl::OkStatus(); };
+  EXPECT_THAT(value_set.Mutate<MString>("y", no_op), IsValueNotFound("y"));
+  EXPECT_THAT(value_set.Mutate<MString>("x", no_op),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(ValueSetTest, MutateShouldResetTheSubvalueCache) {
+  ValueSet value_set;
+  value_set.Set<MTestType>("x", 3 * MTestType::kGeneratedValue);
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+
+  MORIARTY_EXPECT_OK(value_set.Mutate<MTestType>(
+      "x", [](moriarty_testing::TestType& x) {
+        x = 5 * MTestType::kGeneratedValue;
+        return absl::OkStatus();
+      }));
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(5)));
+}
+
 TEST(ValueSetTest, SimpleUnsafeGetWorks) {
   ValueSet value_set;
   value_set.Set<MInteger>("x", 5);
@@ -108,6 +205,93 @@ TEST(ValueSetTest, UnsafeGetRequestingANonExistentVariableFails) {
   EXPECT_THAT(value_set.UnsafeGet("y"), IsValueNotFound("y"));
 }
 
+TEST(ValueSetTest, UnsafeGetSubvalueWorks) {
+  ValueSet value_set;
+  value_set.Set<MTestType>("x", 3 * MTestType::kGeneratedValue);
+
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+}
+
+TEST(ValueSetTest, UnsafeGetSubvalueOfDirectlyStoredTypesUsesTheValue) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 5);
+
+  // MInteger has no subvalues, but the value is still passed along.
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MInteger(), "length"),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+TEST(ValueSetTest, UnsafeGetSubvalueShouldReuseIntegerSubvaluesUntilSetAgain) {
+  ValueSet value_set;
+  value_set.Set<MTestType>("x", 3 * MTestType::kGeneratedValue);
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+
+  // MInteger has no subvalues, so this can only succeed through the cache.
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MInteger(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+
+  value_set.Set<MTestType>("x", 5 * MTestType::kGeneratedValue);
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(5)));
+
+  value_set.Erase("x");
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsValueNotFound("x"));
+}
+
+TEST(ValueSetTest, ErasingOtherVariablesShouldKeepResettingTheSubvalueCache) {
+  ValueSet value_set;
+  value_set.Set<MTestType>("x", 3 * MTestType::kGeneratedValue);
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+
+  value_set.Set<MTestType>("y", 4 * MTestType::kGeneratedValue);
+  value_set.Erase("y");
+  value_set.Erase("z");
+
+  value_set.Set<MTestType>("x", 5 * MTestType::kGeneratedValue);
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(5)));
+}
+
+TEST(ValueSetTest, UnsafeGetSubvalueOnACopyShouldNotUseTheOriginalsCache) {
+  ValueSet value_set;
+  value_set.Set<MTestType>("x", 3 * MTestType::kGeneratedValue);
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+
+  ValueSet copy = value_set;
+  copy.Set<MTestType>("x", 5 * MTestType::kGeneratedValue);
+  EXPECT_THAT(copy.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(5)));
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+}
+
+TEST(ValueSetTest, UnsafeGetSubvalueRequestingANonExistentVariableFails) {
+  ValueSet value_set;
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsValueNotFound("x"));
+}
+
+TEST(ValueSetTest, GetWithTheWrongTypeFailsForDirectlyStoredTypes) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 5);
+  value_set.Set<MString>("s", "hello");
+  value_set.Set<MArray<MInteger>>("A", {1, 2, 3});
+
+  EXPECT_THAT(value_set.Get<MString>("x"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(value_set.Get<MInteger>("s"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(value_set.Get<MInteger>("A"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(value_set.Get<MArray<MInteger>>("x"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 TEST(ValueSetTest, ContainsShouldWork) {
   ValueSet value_set;
   EXPECT_FALSE(value_set.Contains("x"));
@@ -152,6 +336,55 @@ TEST(ValueSetTest, GetApproximateSizeWorksForNestedVectorsAndMixedTypes) {
   EXPECT_EQ(value_set.GetApproximateSize(), 5 + 5 + 3 + 3 + 4 + 1);
 }
 
+TEST(ValueSetTest, GetByteSizeCountsTheBytesOfEachValue) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 5);
+  EXPECT_EQ(value_set.GetByteSize(), 8);
+  value_set.Set<MString>("y", "hello");
+  EXPECT_EQ(value_set.GetByteSize(), 8 + 5);
+  value_set.Set<MArray<MString>>("z", {"ab", "cde", ""});
+  EXPECT_EQ(value_set.GetByteSize(), 8 + 5 + 5);
+}
+
+TEST(ValueSetTest, GetByteSizeShouldNotCountOverwrittenOrErasedValues) {
+  ValueSet value_set;
+  value_set.Set<MString>("x", "hello");
+  value_set.Set<MString>("x", "hi");
+  EXPECT_EQ(value_set.GetByteSize(), 2);
+
+  value_set.Set<MArray<MInteger>>("y", {1, 2, 3});
+  value_set.Erase("x");
+  EXPECT_EQ(value_set.GetByteSize(), 3 * 8);
+}
+
+TEST(ValueSetTest, GetAllocatedBytesCountsTheCapacityOfContainers) {
+  ValueSet value_set;
+  value_set.Set<MInteger>("x", 5);
+  EXPECT_EQ(value_set.GetAllocatedBytes(), sizeof(int64_t));
+
+  std::vector<int64_t> y;
+  y.reserve(100);
+  y.push_back(1);
+  value_set.Set<MArray<MInteger>>("y", y);
+  // Copies only keep the capacity they need.
+  EXPECT_EQ(value_set.GetAllocatedBytes(),
+            sizeof(int64_t) + AllocatedByteSize(std::vector<int64_t>(y)));
+}
+
+TEST(ValueSetTest, GetAllocatedBytesShouldNotCountOverwrittenOrErasedValues) {
+  ValueSet value_set;
+  std::string long_string(1000, 'a');
+  value_set.Set<MString>("x", long_string);
+  value_set.Set<MString>("x", "short");
+  EXPECT_EQ(value_set.GetAllocatedBytes(), sizeof(std::string));
+
+  value_set.Set<MInteger>("y", 5);
+  value_set.Erase("x");
+  EXPECT_EQ(value_set.GetAllocatedBytes(), sizeof(int64_t));
+  EXPECT_EQ(value_set.GetPeakAllocatedBytes(),
+            AllocatedByteSize(long_string));
+}
+
 TEST(ValueSetTest, EraseRemovesTheValueFromTheSet) {
   ValueSet value_set;
   value_set.Set<MInteger>("x", 5);
@@ -184,6 +417,89 @@ TEST(ValueSetTest, ErasingVariableLeavesOthersAlone) {
   EXPECT_TRUE(value_set.Contains("y"));
 }
 
+// Returns a ValueSet that only sees `shared` through `SetSharedValues()`.
+ValueSet WithSharedValues(ValueSet shared) {
+  ValueSet value_set;
+  value_set.SetSharedValues(
+      std::make_shared<const ValueSet>(std::move(shared)));
+  return value_set;
+}
+
+TEST(ValueSetTest, SharedValuesCanBeReadWithoutBeingCopied) {
+  ValueSet shared;
+  shared.Set<MArray<MInteger>>("A", {1, 2, 3});
+  shared.Set<MString>("S", "hello");
+  ValueSet value_set = WithSharedValues(std::move(shared));
+  value_set.Set<MInteger>("x", 5);
+
+  EXPECT_TRUE(value_set.Contains("A"));
+  EXPECT_THAT(value_set.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(1, 2, 3)));
+  EXPECT_THAT(value_set.GetRef<MString>("S"),
+              IsOkAndHolds(Pointee(StrEq("hello"))));
+  EXPECT_EQ(*value_set.GetRef<MString>("S"),
+            *value_set.GetSharedValues()->GetRef<MString>("S"));
+  EXPECT_THAT(value_set.UnsafeGet("S"),
+              IsOkAndHolds(AnyWith<std::string>("hello")));
+  EXPECT_THAT(value_set.Get<MInteger>("x"), IsOkAndHolds(5));
+  EXPECT_THAT(value_set.Get<MInteger>("y"), IsValueNotFound("y"));
+}
+
+TEST(ValueSetTest, SharedValuesAreNotCountedInTheSizes) {
+  ValueSet shared;
+  shared.Set<MArray<MInteger>>("A", {1, 2, 3});
+  ValueSet value_set = WithSharedValues(std::move(shared));
+  value_set.Set<MInteger>("x", 5);
+
+  EXPECT_EQ(value_set.NumValues(), 1);
+  EXPECT_EQ(value_set.GetApproximateSize(), 1);
+  EXPECT_EQ(value_set.GetByteSize(), 8);
+}
+
+TEST(ValueSetTest, ValuesSetDirectlyHideSharedValues) {
+  ValueSet shared;
+  shared.Set<MInteger>("x", 5);
+  ValueSet value_set = WithSharedValues(std::move(shared));
+
+  value_set.Set<MInteger>("x", 10);
+  EXPECT_THAT(value_set.Get<MInteger>("x"), IsOkAndHolds(10));
+
+  value_set.Erase("x");
+  EXPECT_THAT(value_set.Get<MInteger>("x"), IsOkAndHolds(5));
+}
+
+TEST(ValueSetTest, MutatingASharedValueShouldOnlyChangeACopy) {
+  ValueSet shared;
+  shared.Set<MArray<MInteger>>("A", {1, 2, 3});
+  ValueSet value_set = WithSharedValues(std::move(shared));
+  ValueSet other = value_set;
+
+  MORIARTY_EXPECT_OK(value_set.Mutate<MArray<MInteger>>(
+      "A", [](std::vector<int64_t>& A) {
+        A[1] = 20;
+        return absl::OkStatus();
+      }));
+
+  EXPECT_THAT(value_set.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(1, 20, 3)));
+  EXPECT_THAT(other.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(1, 2, 3)));
+  EXPECT_THAT(value_set.GetSharedValues()->Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(1, 2, 3)));
+  EXPECT_EQ(value_set.NumValues(), 1);
+}
+
+TEST(ValueSetTest, UnsafeGetSubvalueWorksForSharedValues) {
+  ValueSet shared;
+  shared.Set<MTestType>("x", 3 * MTestType::kGeneratedValue);
+  ValueSet value_set = WithSharedValues(std::move(shared));
+
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("x", MTestType(), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+  EXPECT_THAT(value_set.UnsafeGetSubvalue("y", MTestType(), "multiplier"),
+              IsValueNotFound("y"));
+}
+
 }  // namespace
 }  // namespace moriarty_internal
 }  // namespace moriarty
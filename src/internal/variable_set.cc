@@ -14,14 +14,18 @@
 
 #include "src/internal/variable_set.h"
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "src/errors.h"
@@ -35,9 +39,10 @@ namespace moriarty_internal {
 
 // Copy constructor, making a copy of all constraints
 VariableSet::VariableSet(const VariableSet& other) {
-  for (const auto& [variable_name, abstract_var_ptr] : other.variables_) {
-    variables_.emplace(variable_name, abstract_var_ptr->Clone());
-  }
+  // Insert in handle order so that the copy has the same handles.
+  variables_.reserve(other.by_handle_.size());
+  for (const NamedVariable& named : other.by_handle_)
+    Insert(named.name, named.variable->Clone());
 }
 
 VariableSet& VariableSet::operator=(VariableSet other) {
@@ -47,6 +52,24 @@ VariableSet& VariableSet::operator=(VariableSet other) {
 
 void VariableSet::Swap(VariableSet& other) {
   std::swap(variables_, other.variables_);
+  std::swap(by_handle_, other.by_handle_);
+  std::swap(handles_, other.handles_);
+  std::swap(dependents_, other.dependents_);
+}
+
+std::optional<VariableSet::VariableHandle> VariableSet::GetHandle(
+    absl::string_view name) const {
+  auto it = handles_.find(name);
+  if (it == handles_.end()) return std::nullopt;
+  return it->second;
+}
+
+void VariableSet::Insert(absl::string_view name,
+                         std::unique_ptr<AbstractVariable> variable) {
+  dependents_.reset();
+  handles_.emplace(name, by_handle_.size());
+  by_handle_.push_back({.name = std::string(name), .variable = variable.get()});
+  variables_.emplace(name, std::move(variable));
 }
 
 absl::StatusOr<const AbstractVariable*> VariableSet::GetAbstractVariable(
@@ -72,6 +95,7 @@ void VariableSet::SetUniverse(Universe* universe) {
 
 AbstractVariable* VariableSet::GetAbstractVariableOrNull(
     absl::string_view name) {
+  dependents_.reset();  // The caller may add constraints.
   auto it = variables_.find(name);
   if (it == variables_.end()) return nullptr;
   return it->second.get();
@@ -85,12 +109,15 @@ const AbstractVariable* VariableSet::GetAbstractVariableOrNull(
 }
 
 absl::Status VariableSet::WithScenario(const Scenario& scenario) {
+  dependents_.reset();
+  // `Typename()` is only needed if some properties are type-specific.
+  bool by_type = scenario.HasTypeSpecificProperties();
+  const std::vector<Property>& general = scenario.GetGeneralProperties();
+  if (!by_type && general.empty()) return absl::OkStatus();
+
   for (const auto& [var_name, var_ptr] : variables_) {
-    for (const Property& property : scenario.GetGeneralProperties()) {
-      MORIARTY_RETURN_IF_ERROR(var_ptr->WithProperty(property));
-    }
     for (const Property& property :
-         scenario.GetTypeSpecificProperties(var_ptr->Typename())) {
+         by_type ? scenario.GetPropertiesFor(var_ptr->Typename()) : general) {
       MORIARTY_RETURN_IF_ERROR(var_ptr->WithProperty(property));
     }
   }
@@ -105,30 +132,78 @@ absl::Status VariableSet::AllVariablesSatisfyConstraints() const {
   return absl::OkStatus();
 }
 
+std::vector<std::string> VariableSet::GetDependents(absl::string_view name) {
+  if (!dependents_) {
+    dependents_.emplace();
+    for (const NamedVariable& named : by_handle_) {
+      std::vector<std::string> dependencies = named.variable->GetDependencies();
+      std::sort(dependencies.begin(), dependencies.end());
+      dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+                         dependencies.end());
+      for (std::string& dependency : dependencies)
+        (*dependents_)[std::move(dependency)].push_back(named.name);
+    }
+    for (auto& [dependency, dependents] : *dependents_)
+      std::sort(dependents.begin(), dependents.end());
+  }
+
+  auto it = dependents_->find(name);
+  if (it == dependents_->end()) return {};
+  return it->second;
+}
+
+absl::Status VariableSet::ValidateAfterChange(
+    absl::string_view changed_variable) {
+  if (auto it = variables_.find(changed_variable); it != variables_.end()) {
+    MORIARTY_RETURN_IF_ERROR(it->second->ValueSatisfiesConstraints())
+        << "'" << changed_variable << "' does not satisfy constraints";
+  }
+  for (const std::string& name : GetDependents(changed_variable)) {
+    MORIARTY_RETURN_IF_ERROR(
+        variables_.find(name)->second->ValueSatisfiesConstraints())
+        << "'" << name << "' does not satisfy constraints";
+  }
+  return absl::OkStatus();
+}
+
 const absl::flat_hash_map<std::string, std::unique_ptr<AbstractVariable>>&
 VariableSet::GetAllVariables() const {
   return variables_;
 }
 
+std::string VariableSet::ToString() const {
+  std::vector<absl::string_view> names;
+  names.reserve(variables_.size());
+  for (const auto& [name, variable] : variables_) names.push_back(name);
+  std::sort(names.begin(), names.end());
+
+  std::string result;
+  for (absl::string_view name : names) {
+    absl::StrAppend(&result, name, ": ",
+                    variables_.find(name)->second->ToString(), "\n");
+  }
+  return result;
+}
+
 absl::Status VariableSet::AddVariable(absl::string_view name,
                                       const AbstractVariable& variable) {
-  auto [it, inserted] = variables_.emplace(name, variable.Clone());
-
-  if (!inserted)
+  if (variables_.contains(name))
     return absl::AlreadyExistsError(absl::Substitute(
         "Variable '$0' already added to to this VariableSet instance", name));
 
+  Insert(name, variable.Clone());
   return absl::OkStatus();
 }
 
 absl::Status VariableSet::AddOrMergeVariable(absl::string_view name,
                                              const AbstractVariable& variable) {
-  auto [it, inserted] = variables_.try_emplace(name, nullptr);
-  if (inserted) {
-    it->second = std::unique_ptr<AbstractVariable>(variable.Clone());
+  auto it = variables_.find(name);
+  if (it == variables_.end()) {
+    Insert(name, variable.Clone());
     return absl::OkStatus();
   }
 
+  dependents_.reset();
   return it->second->MergeFrom(variable);
 }
 
@@ -22,7 +22,9 @@
 
 #include <concepts>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
@@ -82,12 +84,72 @@ class VariableSet {
     requires std::derived_from<T, AbstractVariable>
   absl::StatusOr<T> GetVariable(absl::string_view name) const;
 
+  // GetVariableView<>()
+  //
+  // Same as `GetVariable<>()`, but returns a pointer to the variable owned by
+  // this set instead of a copy. The pointer is valid for the lifetime of this
+  // set.
+  //
+  // Errors:
+  //  * VariableNotFoundError() if the variable does not exist.
+  //  * kInvalidArgument if it is not convertible to `T`
+  template <typename T>
+    requires std::derived_from<T, AbstractVariable>
+  absl::StatusOr<const T*> GetVariableView(absl::string_view name) const;
+
+  // VariableHandle
+  //
+  // A dense index for a variable in this set. Handles are assigned in the order
+  // variables are added, starting at 0, and never change. Copies of this set
+  // have the same handles. Looking a variable up by handle does not hash its
+  // name, so code that accesses the same variables repeatedly should resolve
+  // their names once with `GetHandle()`.
+  using VariableHandle = int;
+
+  // GetHandle()
+  //
+  // Returns the handle of the variable named `name`, or `std::nullopt` if there
+  // is no such variable.
+  std::optional<VariableHandle> GetHandle(absl::string_view name) const;
+
+  // NumVariables()
+  //
+  // Returns the number of variables in this set. Valid handles are in
+  // [0, NumVariables()).
+  int NumVariables() const { return by_handle_.size(); }
+
+  // GetAbstractVariable()
+  //
+  // Returns the variable with handle `handle`. Ownership of this pointer is
+  // *not* transferred to the caller. `handle` must be a valid handle.
+  const AbstractVariable* GetAbstractVariable(VariableHandle handle) const {
+    return by_handle_[handle].variable;
+  }
+  AbstractVariable* GetAbstractVariable(VariableHandle handle) {
+    dependents_.reset();  // The caller may add constraints.
+    return by_handle_[handle].variable;
+  }
+
+  // GetName()
+  //
+  // Returns the name of the variable with handle `handle`. `handle` must be a
+  // valid handle.
+  const std::string& GetName(VariableHandle handle) const {
+    return by_handle_[handle].name;
+  }
+
   // GetAllVariables()
   //
   // Returns the map of internal variables.
   const absl::flat_hash_map<std::string, std::unique_ptr<AbstractVariable>>&
   GetAllVariables() const;
 
+  // ToString()
+  //
+  // Returns the constraints of all variables, one per line and sorted by
+  // variable name, so equivalent sets have the same string.
+  std::string ToString() const;
+
   // SetUniverse()
   //
   // Calls SetUniverse() on all variables owned by this variable set.
@@ -108,10 +170,42 @@ class VariableSet {
   // If a value does not have a variable, this will return ok.
   absl::Status AllVariablesSatisfyConstraints() const;
 
+  // GetDependents()
+  //
+  // Returns the names of the variables whose constraints depend on the value
+  // of the variable named `name` (directly, via `GetDependencies()`), sorted.
+  //
+  // The dependency graph is computed once and reused until this set's
+  // variables are added to, merged into or accessed mutably.
+  std::vector<std::string> GetDependents(absl::string_view name);
+
+  // ValidateAfterChange()
+  //
+  // Same as `AllVariablesSatisfyConstraints()`, but assumes that all values
+  // satisfied their constraints before the value of `changed_variable` was
+  // changed. Only `changed_variable` (if it is a variable in this set) and the
+  // variables that depend on it are checked, so values that did not change and
+  // do not depend on the change (e.g., large arrays) are not checked again.
+  absl::Status ValidateAfterChange(absl::string_view changed_variable);
+
  private:
   absl::flat_hash_map<std::string, std::unique_ptr<AbstractVariable>>
       variables_;
 
+  // The variables in `variables_`, indexed by their handle.
+  std::vector<NamedVariable> by_handle_;
+  absl::flat_hash_map<std::string, VariableHandle> handles_;
+
+  // For each variable name, the variables that depend on it (see
+  // `GetDependents()`). Only computed when needed.
+  std::optional<absl::flat_hash_map<std::string, std::vector<std::string>>>
+      dependents_;
+
+  // Adds `variable` to `variables_` and gives it the next handle. `name` must
+  // not already be a variable.
+  void Insert(absl::string_view name,
+              std::unique_ptr<AbstractVariable> variable);
+
   // Returns either a pointer to the AbstractVariable or `nullptr` if it doesn't
   // exist.
   const AbstractVariable* GetAbstractVariableOrNull(
@@ -131,6 +225,16 @@ absl::StatusOr<T> VariableSet::GetVariable(absl::string_view name) const {
   return ConvertTo<T>(var, name);
 }
 
+template <typename T>
+  requires std::derived_from<T, AbstractVariable>
+absl::StatusOr<const T*> VariableSet::GetVariableView(
+    absl::string_view name) const {
+  const AbstractVariable* var = GetAbstractVariableOrNull(name);
+  if (var == nullptr) return VariableNotFoundError(name);
+
+  return ConvertToPointer<T>(var, name);
+}
+
 }  // namespace moriarty_internal
 }  // namespace moriarty
 
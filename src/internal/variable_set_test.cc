@@ -14,12 +14,19 @@
 
 #include "src/internal/variable_set.h"
 
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "src/constraint_values.h"
 #include "src/errors.h"
 #include "src/internal/abstract_variable.h"
 #include "src/internal/generation_bootstrap.h"
@@ -45,7 +52,12 @@ using ::moriarty_testing::IsVariableNotFound;
 using ::moriarty_testing::MTestType;
 using ::moriarty_testing::MTestType2;
 using ::moriarty_testing::TestType;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 
@@ -63,6 +75,21 @@ TEST(VariableSetTest, GetVariableCanRetrieveFromAddVariable) {
   EXPECT_THAT(Generate(B), IsOkAndHolds(222222));
 }
 
+TEST(VariableSetTest, ToStringDoesNotDependOnInsertionOrder) {
+  VariableSet v1;
+  MORIARTY_ASSERT_OK(v1.AddVariable("A", MTestType().Is(111111)));
+  MORIARTY_ASSERT_OK(v1.AddVariable("B", MTestType()));
+  VariableSet v2;
+  MORIARTY_ASSERT_OK(v2.AddVariable("B", MTestType()));
+  MORIARTY_ASSERT_OK(v2.AddVariable("A", MTestType().Is(111111)));
+
+  EXPECT_EQ(v1.ToString(), v2.ToString());
+  EXPECT_THAT(v1.ToString(), HasSubstr("A: MTestType"));
+
+  MORIARTY_ASSERT_OK(v2.AddOrMergeVariable("B", MTestType().Is(2)));
+  EXPECT_NE(v1.ToString(), v2.ToString());
+}
+
 TEST(VariableSetTest, AddOrMergeVariableSetsProperlyWhenNotMerging) {
   VariableSet v;
   MORIARTY_ASSERT_OK(v.AddOrMergeVariable("A", MTestType().Is(111111)));
@@ -87,6 +114,44 @@ TEST(VariableSetTest, AddOrMergeVariableSetsProperlyWhenMerging) {
   EXPECT_THAT(Generate(A), IsOkAndHolds(22));
 }
 
+TEST(VariableSetTest, HandlesAreAssignedInInsertionOrder) {
+  VariableSet v;
+  MORIARTY_ASSERT_OK(v.AddVariable("B", MTestType()));
+  MORIARTY_ASSERT_OK(v.AddOrMergeVariable("A", MTestType()));
+  MORIARTY_ASSERT_OK(v.AddOrMergeVariable("B", MTestType()));  // Merged.
+
+  EXPECT_EQ(v.NumVariables(), 2);
+  EXPECT_THAT(v.GetHandle("B"), Optional(0));
+  EXPECT_THAT(v.GetHandle("A"), Optional(1));
+  EXPECT_EQ(v.GetHandle("C"), std::nullopt);
+  EXPECT_EQ(v.GetName(1), "A");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(AbstractVariable * A,
+                                v.GetAbstractVariable("A"));
+  EXPECT_EQ(v.GetAbstractVariable(1), A);
+}
+
+TEST(VariableSetTest, HandlesAreKeptByCopiesAndMoves) {
+  VariableSet v;
+  for (absl::string_view name : {"Z", "Y", "X", "W", "V", "U"})
+    MORIARTY_ASSERT_OK(v.AddVariable(name, MTestType()));
+
+  VariableSet copy = v;
+  VariableSet moved = std::move(v);
+  for (const VariableSet* set : {&copy, &moved}) {
+    ASSERT_EQ(set->NumVariables(), 6);
+    for (int handle = 0; handle < 6; handle++) {
+      const std::string& name = set->GetName(handle);
+      EXPECT_THAT(set->GetHandle(name), Optional(handle));
+      MORIARTY_ASSERT_OK_AND_ASSIGN(const AbstractVariable* variable,
+                                    set->GetAbstractVariable(name));
+      EXPECT_EQ(set->GetAbstractVariable(handle), variable);
+    }
+  }
+  EXPECT_EQ(copy.GetName(0), "Z");
+  EXPECT_EQ(copy.GetName(5), "U");
+}
+
 TEST(VariableSetTest, GetVariableOnNonExistentVariableFails) {
   VariableSet v;
 
@@ -284,6 +349,82 @@ TEST(VariableSetTest,
   MORIARTY_EXPECT_OK(variables.AllVariablesSatisfyConstraints());
 }
 
+TEST(VariableSetTest, GetDependentsReturnsTheVariablesThatDependOnAVariable) {
+  VariableSet variables;
+  auto always = [](const TestType&, const ConstraintValues&) { return true; };
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", MTestType()));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "B", MTestType().AddCustomConstraint("uses A", {"A"}, always)));
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "C", MTestType().AddCustomConstraint("uses A and B", {"B", "A"}, always)));
+
+  EXPECT_THAT(variables.GetDependents("A"), ElementsAre("B", "C"));
+  EXPECT_THAT(variables.GetDependents("B"), ElementsAre("C"));
+  EXPECT_THAT(variables.GetDependents("C"), IsEmpty());
+  EXPECT_THAT(variables.GetDependents("unknown"), IsEmpty());
+
+  // Adding constraints updates the dependents.
+  MORIARTY_ASSERT_OK(variables.AddOrMergeVariable(
+      "A", MTestType().AddCustomConstraint("uses C", {"C"}, always)));
+  EXPECT_THAT(variables.GetDependents("C"), ElementsAre("A"));
+}
+
+TEST(VariableSetTest, ValidateAfterChangeOnlyChecksTheChangeAndItsDependents) {
+  VariableSet variables;
+  ValueSet values;
+  Universe universe =
+      Universe().SetConstValueSet(&values).SetConstVariableSet(&variables);
+
+  // Counts the number of times each variable is checked.
+  auto checks = std::make_shared<absl::flat_hash_map<std::string, int>>();
+  auto counted = [checks](std::string name, std::vector<std::string> deps) {
+    return MTestType().AddCustomConstraint(
+        "counted", std::move(deps),
+        [checks, name](const TestType& value, const ConstraintValues&) {
+          (*checks)[name]++;
+          return value.value < 100;
+        });
+  };
+  MORIARTY_ASSERT_OK(variables.AddVariable("A", counted("A", {})));
+  MORIARTY_ASSERT_OK(variables.AddVariable("B", counted("B", {"A"})));
+  MORIARTY_ASSERT_OK(variables.AddVariable("C", counted("C", {})));
+
+  values.Set<MTestType>("A", TestType(1));
+  values.Set<MTestType>("B", TestType(2));
+  values.Set<MTestType>("C", TestType(3));
+  variables.SetUniverse(&universe);
+  MORIARTY_ASSERT_OK(variables.AllVariablesSatisfyConstraints());
+  checks->clear();
+
+  values.Set<MTestType>("A", TestType(4));
+  MORIARTY_EXPECT_OK(variables.ValidateAfterChange("A"));
+  EXPECT_THAT(*checks, UnorderedElementsAre(Pair("A", 1), Pair("B", 1)));
+
+  checks->clear();
+  values.Set<MTestType>("C", TestType(500));
+  EXPECT_THAT(variables.ValidateAfterChange("C"), IsUnsatisfiedConstraint("C"));
+  EXPECT_THAT(*checks, UnorderedElementsAre(Pair("C", 1)));
+}
+
+TEST(VariableSetTest, ValidateAfterChangeChecksDependentsOfUnknownVariables) {
+  VariableSet variables;
+  ValueSet values;
+  Universe universe =
+      Universe().SetConstValueSet(&values).SetConstVariableSet(&variables);
+
+  MORIARTY_ASSERT_OK(variables.AddVariable(
+      "B", MTestType().AddCustomConstraint(
+               "B < X", {"X"},
+               [](const TestType& value, const ConstraintValues& known) {
+                 return value.value < known.GetValue<MTestType>("X").value;
+               })));
+  values.Set<MTestType>("B", TestType(5));
+  values.Set<MTestType>("X", TestType(3));
+
+  variables.SetUniverse(&universe);
+  EXPECT_THAT(variables.ValidateAfterChange("X"), IsUnsatisfiedConstraint("B"));
+}
+
 TEST(VariableSetTest, AllVariablesSatisfyConstraintsFailsIfMissingValues) {
   VariableSet variables;
   Universe universe = Universe().SetConstVariableSet(&variables);
@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/whitespace_scanner.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace moriarty {
+namespace moriarty_internal {
+
+namespace {
+
+// Each block of `kBlockSize` characters is turned into a mask with
+// `kBitsPerChar` consecutive bits per character, set for whitespace
+// characters. The first character is in the lowest bits.
+#if defined(__AVX2__)
+
+constexpr size_t kBlockSize = 32;
+constexpr int kBitsPerChar = 1;
+constexpr uint64_t kAllChars = 0xFFFFFFFF;
+
+uint64_t WhitespaceMask(const char* p) {
+  __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  // `c` is in ['\t', '\r'] if and only if `c - '\t'` is at most 4 (unsigned).
+  __m256i shifted = _mm256_sub_epi8(c, _mm256_set1_epi8('\t'));
+  __m256i control = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+  __m256i space = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '));
+  return static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_or_si256(control, space)));
+}
+
+#elif defined(__SSE2__)
+
+constexpr size_t kBlockSize = 16;
+constexpr int kBitsPerChar = 1;
+constexpr uint64_t kAllChars = 0xFFFF;
+
+uint64_t WhitespaceMask(const char* p) {
+  __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  // `c` is in ['\t', '\r'] if and only if `c - '\t'` is at most 4 (unsigned).
+  __m128i shifted = _mm_sub_epi8(c, _mm_set1_epi8('\t'));
+  __m128i control =
+      _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+  __m128i space = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(control, space)));
+}
+
+#elif defined(__ARM_NEON)
+
+constexpr size_t kBlockSize = 16;
+constexpr int kBitsPerChar = 4;
+constexpr uint64_t kAllChars = ~uint64_t{0};
+
+uint64_t WhitespaceMask(const char* p) {
+  uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+  // `c` is in ['\t', '\r'] if and only if `c - '\t'` is at most 4 (unsigned).
+  uint8x16_t control = vcleq_u8(vsubq_u8(c, vdupq_n_u8('\t')), vdupq_n_u8(4));
+  uint8x16_t space = vceqq_u8(c, vdupq_n_u8(' '));
+  uint8x16_t whitespace = vorrq_u8(control, space);
+  // NEON has no movemask; narrowing each 16-bit lane by 4 bits keeps 4 bits of
+  // every byte.
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(whitespace), 4)),
+      0);
+}
+
+#else
+
+constexpr size_t kBlockSize = 0;  // No vectorized scanning.
+constexpr int kBitsPerChar = 1;
+constexpr uint64_t kAllChars = 0;
+
+uint64_t WhitespaceMask(const char*) { return 0; }
+
+#endif
+
+// Returns the index of the first character in `s` for which `IsWhitespace()`
+// is `want_whitespace`, or `s.size()`.
+size_t Find(absl::string_view s, bool want_whitespace) {
+  const char* p = s.data();
+  size_t i = 0;
+  if constexpr (kBlockSize > 0) {
+    uint64_t flip = want_whitespace ? 0 : kAllChars;
+    for (; i + kBlockSize <= s.size(); i += kBlockSize) {
+      uint64_t mask = WhitespaceMask(p + i) ^ flip;
+      if (mask != 0) return i + std::countr_zero(mask) / kBitsPerChar;
+    }
+  }
+  for (; i < s.size(); i++) {
+    if (IsWhitespace(static_cast<unsigned char>(p[i])) == want_whitespace)
+      return i;
+  }
+  return s.size();
+}
+
+}  // namespace
+
+size_t FindWhitespace(absl::string_view s) {
+  return Find(s, /* want_whitespace = */ true);
+}
+
+size_t FindNonWhitespace(absl::string_view s) {
+  return Find(s, /* want_whitespace = */ false);
+}
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_INTERNAL_WHITESPACE_SCANNER_H_
+#define MORIARTY_SRC_INTERNAL_WHITESPACE_SCANNER_H_
+
+#include <cstddef>
+
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+
+// IsWhitespace()
+//
+// Returns true if `c` is one of ' ', '\t', '\n', '\v', '\f' or '\r' (the
+// characters `std::istream >> token` skips in the "C" locale).
+inline bool IsWhitespace(int c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// FindWhitespace()
+//
+// Returns the index of the first whitespace character (see `IsWhitespace()`)
+// in `s`, or `s.size()` if there is none. The characters are checked 16 (or
+// 32, with AVX2) at a time with SSE2/AVX2/NEON where available.
+size_t FindWhitespace(absl::string_view s);
+
+// FindNonWhitespace()
+//
+// Returns the index of the first character in `s` that is not whitespace, or
+// `s.size()` if there is none. Vectorized the same way as `FindWhitespace()`.
+size_t FindNonWhitespace(absl::string_view s);
+
+}  // namespace moriarty_internal
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_INTERNAL_WHITESPACE_SCANNER_H_
@@ -0,0 +1,78 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/internal/whitespace_scanner.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+namespace moriarty_internal {
+namespace {
+
+TEST(WhitespaceScannerTest, IsWhitespaceMatchesTheCLocale) {
+  for (int c = -1; c < 256; c++) {
+    bool expected = c == ' ' || c == '\t' || c == '\n' || c == '\v' ||
+                    c == '\f' || c == '\r';
+    EXPECT_EQ(IsWhitespace(c), expected) << c;
+  }
+}
+
+TEST(WhitespaceScannerTest, FindWhitespaceShouldFindTheFirstWhitespace) {
+  EXPECT_EQ(FindWhitespace(""), 0);
+  EXPECT_EQ(FindWhitespace("abc"), 3);
+  EXPECT_EQ(FindWhitespace(" abc"), 0);
+  EXPECT_EQ(FindWhitespace("abc def"), 3);
+  EXPECT_EQ(FindWhitespace("abc\r\n"), 3);
+}
+
+TEST(WhitespaceScannerTest, FindNonWhitespaceShouldFindTheFirstNonWhitespace) {
+  EXPECT_EQ(FindNonWhitespace(""), 0);
+  EXPECT_EQ(FindNonWhitespace(" \t\n\v\f\r"), 6);
+  EXPECT_EQ(FindNonWhitespace("abc"), 0);
+  EXPECT_EQ(FindNonWhitespace("  \nabc"), 3);
+}
+
+// Checks every position in strings longer than a vector block, so that both
+// the vectorized and the scalar parts are covered.
+TEST(WhitespaceScannerTest, FindShouldWorkAtEveryPosition) {
+  for (int length = 0; length <= 100; length++) {
+    for (int pos = 0; pos <= length; pos++) {
+      for (char c : std::string(" \t\n\v\f\r")) {
+        std::string token(length, 'x');
+        if (pos < length) token[pos] = c;
+        EXPECT_EQ(FindWhitespace(token), pos) << length << " " << pos;
+
+        std::string spaces(length, c);
+        if (pos < length) spaces[pos] = 'x';
+        EXPECT_EQ(FindNonWhitespace(spaces), pos) << length << " " << pos;
+      }
+    }
+  }
+}
+
+TEST(WhitespaceScannerTest, FindShouldTreatOtherBytesAsNonWhitespace) {
+  // Bytes just outside of ['\t', '\r'], and bytes with the high bit set.
+  std::string s = "\x08\x0e\x1f!\x80\x89\xa0\xff";
+  s += std::string(40, '\xff');
+  EXPECT_EQ(FindWhitespace(s), s.size());
+  EXPECT_EQ(FindNonWhitespace(s), 0);
+}
+
+}  // namespace
+}  // namespace moriarty_internal
+}  // namespace moriarty
@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/lazy_permutation.h"
+
+#include <cstdint>
+
+#include "absl/log/check.h"
+
+namespace moriarty {
+
+namespace {
+
+// The round function of the Feistel network: mixes `half` with `key` (the
+// finalizer of SplitMix64).
+uint64_t Round(uint64_t half, uint64_t key) {
+  uint64_t z = half ^ key;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+}  // namespace
+
+LazyPermutation::LazyPermutation(int64_t n, const Keys& keys)
+    : n_(n), half_bits_(1), keys_(keys) {
+  ABSL_CHECK_GE(n, 0) << "LazyPermutation requires a non-negative size";
+  while (half_bits_ < 32 &&
+         (uint64_t{1} << (2 * half_bits_)) < static_cast<uint64_t>(n))
+    half_bits_++;
+  half_mask_ = (uint64_t{1} << half_bits_) - 1;
+}
+
+int64_t LazyPermutation::operator()(int64_t i) const {
+  ABSL_DCHECK(0 <= i && i < n_);
+  uint64_t x = i;
+  do {
+    x = Encrypt(x);
+  } while (x >= static_cast<uint64_t>(n_));
+  return x;
+}
+
+int64_t LazyPermutation::Inverse(int64_t value) const {
+  ABSL_DCHECK(0 <= value && value < n_);
+  uint64_t x = value;
+  do {
+    x = Decrypt(x);
+  } while (x >= static_cast<uint64_t>(n_));
+  return x;
+}
+
+uint64_t LazyPermutation::Encrypt(uint64_t x) const {
+  uint64_t left = x >> half_bits_;
+  uint64_t right = x & half_mask_;
+  for (uint64_t key : keys_) {
+    uint64_t next = left ^ (Round(right, key) & half_mask_);
+    left = right;
+    right = next;
+  }
+  return (left << half_bits_) | right;
+}
+
+uint64_t LazyPermutation::Decrypt(uint64_t x) const {
+  uint64_t left = x >> half_bits_;
+  uint64_t right = x & half_mask_;
+  for (int round = kNumRounds - 1; round >= 0; round--) {
+    uint64_t previous = right ^ (Round(left, keys_[round]) & half_mask_);
+    right = left;
+    left = previous;
+  }
+  return (left << half_bits_) | right;
+}
+
+}  // namespace moriarty
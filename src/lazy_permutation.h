@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_LAZY_PERMUTATION_H_
+#define MORIARTY_SRC_LAZY_PERMUTATION_H_
+
+#include <array>
+#include <cstdint>
+
+namespace moriarty {
+
+// LazyPermutation
+//
+// A permutation of {0, 1, ... , n-1} whose values are computed when they are
+// asked for instead of being stored, so it uses O(1) memory for any n (e.g., a
+// random relabelling of 10^9 vertices). Each value takes expected O(1) time.
+//
+// The permutation is a keyed Feistel network over the smallest power of 4 that
+// is at least n. Values outside of [0, n) are mapped again ("cycle walking")
+// until they land in [0, n), which takes fewer than 4 rounds on average. The
+// keys come from the random engine, so the permutation looks random, but it
+// is not uniformly random over all n! permutations.
+//
+// Use `Generator::RandomLazyPermutation()` to create a random one.
+//
+// Example usage (in a Generator):
+//
+//   LazyPermutation label = RandomLazyPermutation(1'000'000'000);
+//   for (auto [u, v] : edges) AddEdge(label(u), label(v));
+class LazyPermutation {
+ public:
+  static constexpr int kNumRounds = 6;
+  using Keys = std::array<uint64_t, kNumRounds>;
+
+  // The permutation of {0, 1, ... , n-1} given by `keys`. Requires n >= 0.
+  LazyPermutation(int64_t n, const Keys& keys);
+
+  // size()
+  //
+  // Returns n, the number of values in this permutation.
+  [[nodiscard]] int64_t size() const { return n_; }
+
+  // operator()
+  //
+  // Returns the value at position `i`. Requires 0 <= i < size().
+  [[nodiscard]] int64_t operator()(int64_t i) const;
+
+  // Inverse()
+  //
+  // Returns the position of `value`, so that `(*this)(Inverse(value)) ==
+  // value`. Requires 0 <= value < size().
+  [[nodiscard]] int64_t Inverse(int64_t value) const;
+
+ private:
+  int64_t n_;
+  int half_bits_;  // Each half of the Feistel network has this many bits.
+  uint64_t half_mask_;
+  Keys keys_;
+
+  // One pass of the Feistel network (or its inverse) over [0, 4^half_bits_).
+  uint64_t Encrypt(uint64_t x) const;
+  uint64_t Decrypt(uint64_t x) const;
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_LAZY_PERMUTATION_H_
@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/lazy_permutation.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+
+namespace moriarty {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::Ge;
+using ::testing::Lt;
+
+constexpr LazyPermutation::Keys kKeys = {1, 22, 333, 4444, 55555, 666666};
+
+TEST(LazyPermutationTest, ShouldBeAPermutationForManySizes) {
+  for (int64_t n : {0, 1, 2, 3, 4, 5, 15, 16, 17, 1000, 65537}) {
+    LazyPermutation permutation(n, kKeys);
+    EXPECT_EQ(permutation.size(), n);
+    std::vector<bool> seen(n);
+    for (int64_t i = 0; i < n; i++) {
+      int64_t value = permutation(i);
+      ASSERT_THAT(value, AllOf(Ge(0), Lt(n)));
+      EXPECT_FALSE(seen[value]) << n;
+      seen[value] = true;
+    }
+  }
+}
+
+TEST(LazyPermutationTest, InverseShouldUndoThePermutation) {
+  LazyPermutation permutation(1000, kKeys);
+  for (int64_t i = 0; i < 1000; i++)
+    EXPECT_EQ(permutation.Inverse(permutation(i)), i);
+}
+
+TEST(LazyPermutationTest, ShouldWorkForHugeSizes) {
+  for (int64_t n : {int64_t{1'000'000'000}, int64_t{1} << 62,
+                    std::numeric_limits<int64_t>::max()}) {
+    LazyPermutation permutation(n, kKeys);
+    std::vector<int64_t> values;
+    absl::flat_hash_set<int64_t> distinct;
+    for (int64_t i : {int64_t{0}, int64_t{1}, n / 2, n - 2, n - 1}) {
+      int64_t value = permutation(i);
+      values.push_back(value);
+      distinct.insert(value);
+      EXPECT_EQ(permutation.Inverse(value), i);
+    }
+    EXPECT_THAT(values, Each(AllOf(Ge(0), Lt(n))));
+    EXPECT_EQ(distinct.size(), values.size());
+  }
+}
+
+TEST(LazyPermutationTest, DifferentKeysShouldGiveDifferentPermutations) {
+  LazyPermutation a(1000, kKeys);
+  LazyPermutation b(1000, {6, 5, 4, 3, 2, 1});
+  int differences = 0;
+  for (int64_t i = 0; i < 1000; i++) differences += a(i) != b(i);
+  EXPECT_GT(differences, 900);
+}
+
+TEST(LazyPermutationTest, ShouldNotLookLikeTheIdentity) {
+  LazyPermutation permutation(1000, kKeys);
+  int fixed_points = 0;
+  for (int64_t i = 0; i < 1000; i++) fixed_points += permutation(i) == i;
+  EXPECT_LT(fixed_points, 10);
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -14,17 +14,30 @@
 
 #include "src/librarian/io_config.h"
 
+#include <algorithm>
 #include <cassert>
-#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
 #include <istream>
+#include <limits>
+#include <optional>
 #include <ostream>
+#include <streambuf>
 #include <string>
+#include <system_error>
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "src/errors.h"
+#include "src/internal/whitespace_scanner.h"
+#include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 namespace librarian {
@@ -38,10 +51,107 @@ IOConfig::WhitespacePolicy IOConfig::GetWhitespacePolicy() const {
   return whitespace_policy_;
 }
 
+IOConfig& IOConfig::SetIntegerPolicy(IOConfig::IntegerPolicy policy) {
+  integer_policy_ = policy;
+  return *this;
+}
+
+IOConfig::IntegerPolicy IOConfig::GetIntegerPolicy() const {
+  return integer_policy_;
+}
+
 namespace {
 
+// All reads and writes below go directly through the stream's buffer instead
+// of the `std::istream`/`std::ostream` formatted/unformatted functions. This
+// avoids constructing a sentry (and the locale lookups that come with it) for
+// every character or token. The stream's state flags are updated the same way
+// the corresponding stream calls would.
+
+constexpr int kEof = std::char_traits<char>::eof();
+
+// Returns the next character in `is` without extracting it, or `kEof`.
+int PeekChar(std::istream& is) {
+  if (!is) return kEof;
+  int c = is.rdbuf()->sgetc();
+  if (c == kEof) is.setstate(std::ios_base::eofbit);
+  return c;
+}
+
+using ::moriarty::moriarty_internal::FindNonWhitespace;
+using ::moriarty::moriarty_internal::FindWhitespace;
+using ::moriarty::moriarty_internal::IsWhitespace;
+
+// Gives access to the get area (the buffered characters) of any
+// `std::streambuf`, so that whitespace and tokens can be found many characters
+// at a time. A pointer to a protected member formed through a derived class
+// can be used on any object of the base class.
+class GetArea : public std::streambuf {
+ public:
+  // Returns the characters that can be read without refilling the buffer.
+  static absl::string_view Of(std::streambuf& buf) {
+    const char* begin = (buf.*&GetArea::gptr)();
+    return absl::string_view(begin, (buf.*&GetArea::egptr)() - begin);
+  }
+
+  // Consumes the first `n` characters of `Of(buf)`.
+  static void Skip(std::streambuf& buf, size_t n) {
+    for (; n > std::numeric_limits<int>::max();
+         n -= std::numeric_limits<int>::max()) {
+      (buf.*&GetArea::gbump)(std::numeric_limits<int>::max());
+    }
+    (buf.*&GetArea::gbump)(static_cast<int>(n));
+  }
+};
+
+// Skips whitespace at the start of `buf`, then returns the next character (or
+// `kEof`) without extracting it.
+int SkipWhitespace(std::streambuf& buf) {
+  while (true) {
+    absl::string_view area = GetArea::Of(buf);
+    if (area.empty()) {
+      // Refill the buffer (or, for unbuffered streams, read one character).
+      int c = buf.sgetc();
+      if (c == kEof || !IsWhitespace(c)) return c;
+      if (GetArea::Of(buf).empty()) buf.sbumpc();
+      continue;
+    }
+    size_t n = FindNonWhitespace(area);
+    GetArea::Skip(buf, n);
+    if (n < area.size()) return static_cast<unsigned char>(area[n]);
+  }
+}
+
+// Extracts the characters at the start of `buf` up to the next whitespace (or
+// EOF), and passes them to `consume` in consecutive pieces of at most
+// `max_piece` characters. If `consume` returns false, stops right after that
+// piece and returns `kEof`. Otherwise, returns the character after the token
+// (whitespace or `kEof`) without extracting it.
+template <typename Consume>
+int ExtractTokenPieces(std::streambuf& buf, Consume consume,
+                       size_t max_piece = absl::string_view::npos) {
+  while (true) {
+    absl::string_view area = GetArea::Of(buf);
+    if (area.empty()) {
+      // Refill the buffer (or, for unbuffered streams, read one character).
+      int c = buf.sgetc();
+      if (c == kEof || IsWhitespace(c)) return c;
+      if (!GetArea::Of(buf).empty()) continue;
+      char piece = static_cast<char>(c);
+      buf.sbumpc();
+      if (!consume(absl::string_view(&piece, 1))) return kEof;
+      continue;
+    }
+    area = area.substr(0, max_piece);
+    size_t n = FindWhitespace(area);
+    GetArea::Skip(buf, n);
+    if (n > 0 && !consume(area.substr(0, n))) return kEof;
+    if (n < area.size()) return static_cast<unsigned char>(area[n]);
+  }
+}
+
 absl::Status ReadSingleChar(std::istream& is, char expected) {
-  char c = is.peek();
+  int c = PeekChar(is);
 
   auto get_name_for_error_msg = [](char c) -> std::string {
     switch (c) {
@@ -66,10 +176,44 @@ absl::Status ReadSingleChar(std::istream& is, char expected) {
         "Expected '$0', but got '$1'.", get_name_for_error_msg(expected),
         get_name_for_error_msg(c)));
 
-  is.get();
+  is.rdbuf()->sbumpc();
   return absl::OkStatus();
 }
 
+// Equivalent to `os << chars` (ignoring formatting flags such as `width()`),
+// but writes directly to the stream's buffer.
+void WriteChars(std::ostream& os, absl::string_view chars) {
+  if (!os) return;
+  if (os.rdbuf()->sputn(chars.data(), chars.size()) != chars.size())
+    os.setstate(std::ios_base::badbit);
+  if (os.flags() & std::ios_base::unitbuf) os.flush();
+}
+
+// Equivalent to `is >> token`: skips leading whitespace, then reads until the
+// next whitespace character or EOF. Returns false (and sets failbit) if no
+// characters were read.
+bool ExtractToken(std::istream& is, std::string& token) {
+  token.clear();
+  if (!is) {
+    is.setstate(std::ios_base::failbit);
+    return false;
+  }
+
+  std::streambuf& buf = *is.rdbuf();
+  SkipWhitespace(buf);
+  int c = ExtractTokenPieces(buf, [&token](absl::string_view piece) {
+    token.append(piece.data(), piece.size());
+    return true;
+  });
+
+  if (c == kEof) is.setstate(std::ios_base::eofbit);
+  if (token.empty()) {
+    is.setstate(std::ios_base::failbit);
+    return false;
+  }
+  return true;
+}
+
 char GetChar(Whitespace whitespace) {
   switch (whitespace) {
     case Whitespace::kNewline:
@@ -84,6 +228,18 @@ char GetChar(Whitespace whitespace) {
 
 }  // namespace
 
+absl::string_view WhitespaceName(Whitespace whitespace) {
+  switch (whitespace) {
+    case Whitespace::kNewline:
+      return "newline";
+    case Whitespace::kTab:
+      return "tab";
+    case Whitespace::kSpace:
+      return "space";
+  }
+  assert(false);
+}
+
 absl::Status IOConfig::ReadWhitespace(Whitespace whitespace) {
   if (GetWhitespacePolicy() == WhitespacePolicy::kIgnoreWhitespace)
     return absl::OkStatus();
@@ -97,31 +253,213 @@ absl::Status IOConfig::ReadWhitespace(Whitespace whitespace) {
 }
 
 absl::StatusOr<std::string> IOConfig::ReadToken() {
+  std::string s;
+  MORIARTY_RETURN_IF_ERROR(ReadTokenInto("ReadToken", s));
+  return s;
+}
+
+absl::StatusOr<int64_t> IOConfig::ReadInteger() {
+  MORIARTY_RETURN_IF_ERROR(CheckReadyForToken("ReadInteger"));
+  if (!*is_) {
+    is_->setstate(std::ios_base::failbit);
+    return NoTokenError();
+  }
+
+  // The token is parsed while it is read from the stream's buffer, without
+  // being stored. After an error, the rest of the token is still read, so the
+  // stream ends up in the same place as with `ReadToken()`.
+  std::streambuf& buf = *is_->rdbuf();
+  SkipWhitespace(buf);
+
+  int64_t length = 0;
+  bool plus = false;
+  bool minus = false;
+  int64_t num_digits = 0;
+  bool leading_zero = false;
+  bool not_an_integer = false;  // No digits right after the (optional) sign.
+  bool extra_characters = false;
+  bool overflow = false;
+  uint64_t magnitude = 0;
+  // The largest magnitude is 2^63 for negative numbers, 2^63 - 1 otherwise.
+  uint64_t max_magnitude = uint64_t{std::numeric_limits<int64_t>::max()};
+  int c = ExtractTokenPieces(buf, [&](absl::string_view piece) {
+    for (char ch : piece) {
+      int64_t index = length++;
+      if (not_an_integer || extra_characters) continue;
+      if (index == 0 && (ch == '+' || ch == '-')) {
+        (ch == '+' ? plus : minus) = true;
+        if (minus) max_magnitude++;
+        continue;
+      }
+      if (ch < '0' || ch > '9') {
+        (num_digits == 0 ? not_an_integer : extra_characters) = true;
+        continue;
+      }
+      if (num_digits == 1 && magnitude == 0) leading_zero = true;
+      num_digits++;
+      if (overflow) continue;
+      uint64_t digit = ch - '0';
+      if (magnitude > (max_magnitude - digit) / 10) {
+        overflow = true;
+      } else {
+        magnitude = magnitude * 10 + digit;
+      }
+    }
+    return true;
+  });
+
+  if (c == kEof) is_->setstate(std::ios_base::eofbit);
+  if (length == 0) {
+    is_->setstate(std::ios_base::failbit);
+    return NoTokenError();
+  }
+
+  if (not_an_integer || num_digits == 0 || overflow)
+    return absl::InvalidArgumentError("Unable to read an integer.");
+  if (extra_characters)
+    return absl::InvalidArgumentError(
+        "Found extra characters after reading an integer!");
+
+  if (GetIntegerPolicy() == IntegerPolicy::kStrict) {
+    if (plus)
+      return absl::InvalidArgumentError(
+          "Integers must not start with '+' (strict integer policy).");
+    if (leading_zero)
+      return absl::InvalidArgumentError(
+          "Integers must not have leading zeros (strict integer policy).");
+    if (minus && magnitude == 0)
+      return absl::InvalidArgumentError(
+          "Zero must be written as \"0\" (strict integer policy).");
+  }
+
+  // Converting to `int64_t` wraps around, which is exactly right for 2^63.
+  return static_cast<int64_t>(minus ? 0 - magnitude : magnitude);
+}
+
+absl::Status IOConfig::ReadIntegers(absl::Span<int64_t> values,
+                                    Whitespace separator) {
+  for (int64_t i = 0; i < values.size(); i++) {
+    if (i > 0) MORIARTY_RETURN_IF_ERROR(ReadWhitespace(separator));
+    MORIARTY_ASSIGN_OR_RETURN(values[i], ReadInteger());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<double> IOConfig::ReadReal() {
+  std::string token;
+  MORIARTY_RETURN_IF_ERROR(ReadTokenInto("ReadReal", token));
+
+  // `std::from_chars()` also accepts "inf" and "nan", so the token must start
+  // like a decimal number.
+  absl::string_view digits = token;
+  if (!digits.empty() && digits.front() == '-') digits.remove_prefix(1);
+  if (digits.empty() ||
+      !((digits.front() >= '0' && digits.front() <= '9') ||
+        digits.front() == '.')) {
+    return absl::InvalidArgumentError("Unable to read a real number.");
+  }
+
+  double value;
+  auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(),
+                                   value, std::chars_format::general);
+  if (ec != std::errc() || !std::isfinite(value))
+    return absl::InvalidArgumentError("Unable to read a real number.");
+  if (ptr != token.data() + token.size())
+    return absl::InvalidArgumentError(
+        "Found extra characters after reading a real number!");
+  return value;
+}
+
+bool IOConfig::AtEof() { return PeekAfterIgnoredWhitespace() == kEof; }
+
+bool IOConfig::HasMoreTokens() {
+  int c = PeekAfterIgnoredWhitespace();
+  return c != kEof && !IsWhitespace(c);
+}
+
+int IOConfig::PeekAfterIgnoredWhitespace() {
+  if (!is_ || !*is_) return kEof;
+  int c = GetWhitespacePolicy() == WhitespacePolicy::kIgnoreWhitespace
+              ? SkipWhitespace(*is_->rdbuf())
+              : is_->rdbuf()->sgetc();
+  if (c == kEof) is_->setstate(std::ios_base::eofbit);
+  return c;
+}
+
+absl::Status IOConfig::ReadTokenInChunks(
+    absl::FunctionRef<absl::Status(absl::string_view)> consume) {
+  MORIARTY_RETURN_IF_ERROR(CheckReadyForToken("ReadTokenInChunks"));
+  if (!*is_) {
+    is_->setstate(std::ios_base::failbit);
+    return NoTokenError();
+  }
+
+  std::streambuf& buf = *is_->rdbuf();
+  char chunk[kTokenChunkSize];
+  int chunk_size = 0;
+  bool consumed_any = false;
+
+  SkipWhitespace(buf);
+  int c;
+  do {
+    c = ExtractTokenPieces(
+        buf,
+        [&](absl::string_view piece) {
+          std::copy(piece.begin(), piece.end(), chunk + chunk_size);
+          chunk_size += piece.size();
+          return chunk_size < kTokenChunkSize;
+        },
+        kTokenChunkSize - chunk_size);
+    if (chunk_size == kTokenChunkSize) {
+      consumed_any = true;
+      MORIARTY_RETURN_IF_ERROR(consume(absl::string_view(chunk, chunk_size)));
+      chunk_size = 0;
+      c = buf.sgetc();
+    }
+  } while (c != kEof && !IsWhitespace(c));
+
+  if (c == kEof) is_->setstate(std::ios_base::eofbit);
+  if (!consumed_any && chunk_size == 0) {
+    is_->setstate(std::ios_base::failbit);
+    return NoTokenError();
+  }
+  if (chunk_size > 0) return consume(absl::string_view(chunk, chunk_size));
+  return absl::OkStatus();
+}
+
+absl::Status IOConfig::CheckReadyForToken(
+    absl::string_view function_name) const {
   if (!is_) {
-    return MisconfiguredError("IOConfig", "ReadToken",
+    return MisconfiguredError("IOConfig", function_name,
                               InternalConfigurationType::kInputStream);
   }
 
   if (GetWhitespacePolicy() == WhitespacePolicy::kExact) {
-    char c = is_->peek();
+    int c = PeekChar(*is_);
     if (is_->eof())
       return absl::FailedPreconditionError(
           "Attempted to read a token, but got EOF.");
-    if (std::isspace(c))
+    if (IsWhitespace(c))
       return absl::FailedPreconditionError(
           "Attempted to read a token, but got whitespace instead.");
   }
 
-  std::string s;
-  if (!(*is_ >> s)) {
-    if (is_->eof())
-      return absl::FailedPreconditionError(
-          "Attempted to read a token, but read EOF.");
+  return absl::OkStatus();
+}
+
+absl::Status IOConfig::NoTokenError() const {
+  if (is_->eof())
     return absl::FailedPreconditionError(
-        "Attempted to read a token, but got a non-EOF std::istream error.");
-  }
+        "Attempted to read a token, but read EOF.");
+  return absl::FailedPreconditionError(
+      "Attempted to read a token, but got a non-EOF std::istream error.");
+}
 
-  return s;
+absl::Status IOConfig::ReadTokenInto(absl::string_view function_name,
+                                     std::string& token) {
+  MORIARTY_RETURN_IF_ERROR(CheckReadyForToken(function_name));
+  if (!ExtractToken(*is_, token)) return NoTokenError();
+  return absl::OkStatus();
 }
 
 absl::Status IOConfig::PrintWhitespace(Whitespace whitespace) {
@@ -130,7 +468,8 @@ absl::Status IOConfig::PrintWhitespace(Whitespace whitespace) {
                               InternalConfigurationType::kOutputStream);
   }
 
-  *os_ << GetChar(whitespace);
+  char c = GetChar(whitespace);
+  WriteChars(*os_, absl::string_view(&c, 1));
   return absl::OkStatus();
 }
 
@@ -140,7 +479,78 @@ absl::Status IOConfig::PrintToken(absl::string_view token) {
                               InternalConfigurationType::kOutputStream);
   }
 
-  *os_ << token;
+  WriteChars(*os_, token);
+  return absl::OkStatus();
+}
+
+absl::Status IOConfig::PrintInteger(int64_t value) {
+  if (!os_) {
+    return MisconfiguredError("IOConfig", "PrintInteger",
+                              InternalConfigurationType::kOutputStream);
+  }
+
+  // Large enough for any int64_t, including the sign.
+  char buffer[20];
+  auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  WriteChars(*os_, absl::string_view(buffer, ptr - buffer));
+  return absl::OkStatus();
+}
+
+absl::Status IOConfig::PrintIntegers(absl::Span<const int64_t> values,
+                                     Whitespace separator) {
+  if (!os_) {
+    return MisconfiguredError("IOConfig", "PrintIntegers",
+                              InternalConfigurationType::kOutputStream);
+  }
+
+  // Each value takes at most 20 characters, plus one for the separator.
+  std::string buffer(values.size() * 21, '\0');
+  char* end = buffer.data();
+  const char separator_char = GetChar(separator);
+  for (int64_t i = 0; i < values.size(); i++) {
+    if (i > 0) *end++ = separator_char;
+    end = std::to_chars(end, buffer.data() + buffer.size(), values[i]).ptr;
+  }
+  WriteChars(*os_, absl::string_view(buffer.data(), end - buffer.data()));
+  return absl::OkStatus();
+}
+
+absl::Status IOConfig::PrintReal(double value, std::optional<int> digits) {
+  if (!os_) {
+    return MisconfiguredError("IOConfig", "PrintReal",
+                              InternalConfigurationType::kOutputStream);
+  }
+  if (!std::isfinite(value))
+    return absl::InvalidArgumentError("Cannot print a non-finite real number.");
+  if (digits && (*digits < 0 || *digits > kMaxRealDigits)) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Cannot print a real number with $0 digits after the decimal point.",
+        *digits));
+  }
+
+  // Large enough for any finite double in fixed notation: at most 309 digits
+  // before the decimal point, and the shortest representation has at most 325
+  // digits after it.
+  char buffer[400];
+  std::to_chars_result result =
+      digits ? std::to_chars(buffer, buffer + sizeof(buffer), value,
+                             std::chars_format::fixed, *digits)
+             : std::to_chars(buffer, buffer + sizeof(buffer), value,
+                             std::chars_format::fixed);
+  if (result.ec != std::errc())
+    return absl::InternalError("Unable to format a real number.");
+  WriteChars(*os_, absl::string_view(buffer, result.ptr - buffer));
+  return absl::OkStatus();
+}
+
+absl::Status IOConfig::Flush() {
+  if (!os_) {
+    return MisconfiguredError("IOConfig", "Flush",
+                              InternalConfigurationType::kOutputStream);
+  }
+
+  if (!os_->flush())
+    return absl::UnavailableError("Unable to flush the output stream.");
   return absl::OkStatus();
 }
 
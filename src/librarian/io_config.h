@@ -17,13 +17,17 @@
 #ifndef MORIARTY_SRC_LIBRARIAN_IO_CONFIG_H_
 #define MORIARTY_SRC_LIBRARIAN_IO_CONFIG_H_
 
+#include <cstdint>
 #include <istream>
+#include <optional>
 #include <ostream>
 #include <string>
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace moriarty {
 
@@ -31,10 +35,28 @@ enum class Whitespace { kSpace, kTab, kNewline };
 
 namespace librarian {
 
+// WhitespaceName()
+//
+// Returns a name for `whitespace` (e.g., "space") for debugging.
+absl::string_view WhitespaceName(Whitespace whitespace);
+
 class IOConfig {
  public:
   enum class WhitespacePolicy { kExact, kIgnoreWhitespace };
 
+  // How strict `ReadInteger()` is about the format of an integer:
+  //  * kLenient: anything `std::istream >> int64_t` accepts as a whole token
+  //    (e.g., "+5", "007" and "-0").
+  //  * kStrict: only the canonical form: an optional '-' followed by digits,
+  //    without leading zeros. Zero is only "0".
+  enum class IntegerPolicy { kLenient, kStrict };
+
+  // Maximum number of characters passed at once by `ReadTokenInChunks()`.
+  static constexpr int kTokenChunkSize = 4096;
+
+  // Maximum number of digits after the decimal point for `PrintReal()`.
+  static constexpr int kMaxRealDigits = 18;
+
   // SetWhitespacePolicy()
   //
   // Sets the configuration around how strict to be with whitespace. See
@@ -46,6 +68,16 @@ class IOConfig {
   // Returns the whitespace policy. Default = `kExact`.
   [[nodiscard]] WhitespacePolicy GetWhitespacePolicy() const;
 
+  // SetIntegerPolicy()
+  //
+  // Sets how strict `ReadInteger()` is about the format of integers.
+  IOConfig& SetIntegerPolicy(IntegerPolicy policy);
+
+  // GetIntegerPolicy()
+  //
+  // Returns the integer policy. Default = `kLenient`.
+  [[nodiscard]] IntegerPolicy GetIntegerPolicy() const;
+
   // ReadWhitespace()
   //
   // Attempts to reads the next whitespace character from the input stream. If
@@ -66,6 +98,72 @@ class IOConfig {
   //    thrown.
   absl::StatusOr<std::string> ReadToken();
 
+  // ReadTokenInChunks()
+  //
+  // Reads the next token in the input stream, but instead of storing it, passes
+  // it to `consume` in consecutive pieces of at most `kTokenChunkSize`
+  // characters. The concatenation of all pieces is the token. Whitespace before
+  // the token is treated the same as in `ReadToken()`.
+  //
+  // If `consume` returns a non-OK status, reading stops immediately (leaving
+  // the rest of the token in the input stream) and that status is returned.
+  absl::Status ReadTokenInChunks(
+      absl::FunctionRef<absl::Status(absl::string_view)> consume);
+
+  // ReadInteger()
+  //
+  // Reads the next token in the input stream and parses it as a base-10
+  // integer. Whitespace before the token is treated the same as in
+  // `ReadToken()`.
+  //
+  // Returns kInvalidArgument if the token is not an integer (or has extra
+  // characters after the integer), if it does not fit in an `int64_t`, or if it
+  // is not in the format required by `GetIntegerPolicy()`. The whole token is
+  // read from the input stream either way.
+  absl::StatusOr<int64_t> ReadInteger();
+
+  // ReadIntegers()
+  //
+  // Reads `values.size()` integers (as with `ReadInteger()`) into `values`,
+  // with `separator` between consecutive integers. There is no whitespace read
+  // before the first integer or after the last one. Useful for reading a whole
+  // row of a grid at once.
+  absl::Status ReadIntegers(absl::Span<int64_t> values, Whitespace separator);
+
+  // ReadReal()
+  //
+  // Reads the next token in the input stream and parses it as a real number
+  // in decimal notation (e.g., "-1.25", "3" or "1e-9"). Whitespace before the
+  // token is treated the same as in `ReadToken()`. Parsing does not depend on
+  // the locale.
+  //
+  // Returns kInvalidArgument if the token is not a finite real number (or has
+  // extra characters after it). A leading '+', hexadecimal, "inf" and "nan"
+  // are not accepted. The whole token is read from the input stream either
+  // way.
+  absl::StatusOr<double> ReadReal();
+
+  // AtEof()
+  //
+  // Returns true if there is nothing left to read from the input stream (or
+  // there is no input stream). Nothing is read and no error is created, so
+  // importers can use this to check for the end of the input after each test
+  // case.
+  //
+  // If `GetWhitespacePolicy() == kIgnoreWhitespace`, then leading whitespace is
+  // skipped first (it would be ignored by the next read anyway).
+  bool AtEof();
+
+  // HasMoreTokens()
+  //
+  // Returns true if `ReadToken()` would find a token, without reading it (or
+  // creating an error if it would not).
+  //
+  // If `GetWhitespacePolicy() == kIgnoreWhitespace`, then leading whitespace is
+  // skipped first. If `GetWhitespacePolicy() == kExact`, then this is false if
+  // the next character is whitespace.
+  bool HasMoreTokens();
+
   // PrintWhitespace()
   //
   // Prints the whitespace character to the output stream.
@@ -76,6 +174,38 @@ class IOConfig {
   // Prints a single token to the output stream.
   absl::Status PrintToken(absl::string_view token);
 
+  // PrintInteger()
+  //
+  // Prints `value` (in base 10) as a single token to the output stream.
+  absl::Status PrintInteger(int64_t value);
+
+  // PrintIntegers()
+  //
+  // Prints `values` (in base 10) with `separator` between consecutive values.
+  // The whole row is formatted first and written to the output stream at once.
+  absl::Status PrintIntegers(absl::Span<const int64_t> values,
+                             Whitespace separator);
+
+  // PrintReal()
+  //
+  // Prints `value` as a single token to the output stream, in fixed notation
+  // (never with an exponent). With `digits`, exactly that many digits are
+  // printed after the decimal point (e.g., "1.50" for 2 digits). Otherwise,
+  // the shortest representation that reads back as exactly `value` is printed.
+  // Formatting does not depend on the locale.
+  absl::Status PrintReal(double value,
+                         std::optional<int> digits = std::nullopt);
+
+  // Flush()
+  //
+  // Writes everything printed so far to the destination of the output stream.
+  // In interactive problems, call this after each message (e.g., the answer to
+  // a query) so that the other side can read it. Printing never flushes on
+  // its own.
+  //
+  // Returns kUnavailable if the output stream could not be flushed.
+  absl::Status Flush();
+
   // SetInputStream()
   //
   // Sets the input stream to `is`.
@@ -88,9 +218,25 @@ class IOConfig {
 
  private:
   WhitespacePolicy whitespace_policy_ = WhitespacePolicy::kExact;
+  IntegerPolicy integer_policy_ = IntegerPolicy::kLenient;
 
   std::ostream* os_ = nullptr;
   std::istream* is_ = nullptr;
+
+  // Returns an error if the input stream is missing, or if the whitespace
+  // policy forbids reading a token at the current position.
+  absl::Status CheckReadyForToken(absl::string_view function_name) const;
+
+  // The error to return when no characters of a token could be read.
+  absl::Status NoTokenError() const;
+
+  // Returns the next character of the input stream without extracting it (or
+  // EOF), after skipping whitespace if the whitespace policy ignores it.
+  int PeekAfterIgnoredWhitespace();
+
+  // Reads the next token into `token`. `function_name` is used for errors.
+  absl::Status ReadTokenInto(absl::string_view function_name,
+                             std::string& token);
 };
 
 }  // namespace librarian
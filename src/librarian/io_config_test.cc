@@ -14,11 +14,24 @@
 
 #include "src/librarian/io_config.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
 #include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "src/errors.h"
 #include "src/testing/status_test_util.h"
 #include "src/util/test_status_macro/status_testutil.h"
@@ -30,6 +43,9 @@ namespace {
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 using ::moriarty_testing::IsMisconfigured;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
 using ::testing::StrEq;
 
 TEST(IOConfigTest, DefaultWhitespacePolicyShouldBeExact) {
@@ -58,6 +74,10 @@ TEST(IOConfigTest, AnyPrintFunctionWithoutSetOutputStreamShouldFail) {
               IsMisconfigured(InternalConfigurationType::kOutputStream));
   EXPECT_THAT(c.PrintToken("hello!"),
               IsMisconfigured(InternalConfigurationType::kOutputStream));
+  EXPECT_THAT(c.PrintInteger(123),
+              IsMisconfigured(InternalConfigurationType::kOutputStream));
+  EXPECT_THAT(c.Flush(),
+              IsMisconfigured(InternalConfigurationType::kOutputStream));
 }
 
 TEST(IOConfigTest, ReadWhitespaceShouldRespectWhitespacePolicy) {
@@ -172,6 +192,418 @@ TEST(IOConfigTest, ReadTokenShouldRespectWhitespacePolicy) {
   }
 }
 
+TEST(IOConfigTest, ReadTokenAtEndOfInputShouldGiveEOFErrors) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetInputStream(ss);
+
+  {
+    c.SetWhitespacePolicy(IOConfig::WhitespacePolicy::kExact);
+    ss = std::stringstream("");
+    EXPECT_THAT(c.ReadToken(),
+                StatusIs(absl::StatusCode::kFailedPrecondition,
+                         HasSubstr("Attempted to read a token, but got EOF.")));
+  }
+  {
+    c.SetWhitespacePolicy(IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+    ss = std::stringstream(" \n\t ");
+    EXPECT_THAT(
+        c.ReadToken(),
+        StatusIs(absl::StatusCode::kFailedPrecondition,
+                 HasSubstr("Attempted to read a token, but read EOF.")));
+  }
+}
+
+TEST(IOConfigTest, ReadTokenShouldLeaveTheStreamInTheSameStateAsExtraction) {
+  for (absl::string_view input : {"abc", "abc ", " abc\n", "a b", "", "  "}) {
+    std::stringstream expected((std::string(input)));
+    std::string token;
+    expected >> token;
+
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss).SetWhitespacePolicy(
+        IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+    (void)c.ReadToken();
+
+    EXPECT_EQ(ss.rdstate(), expected.rdstate()) << "input: " << input;
+    EXPECT_EQ(ss.rdbuf()->in_avail(), expected.rdbuf()->in_avail())
+        << "input: " << input;
+  }
+}
+
+TEST(IOConfigTest, ReadTokenInChunksShouldPassTheWholeTokenInPieces) {
+  std::string long_token(2 * IOConfig::kTokenChunkSize + 5, 'x');
+  std::stringstream ss(absl::StrCat("abc ", long_token, " def"));
+  IOConfig c;
+  c.SetInputStream(ss).SetWhitespacePolicy(
+      IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+  std::vector<std::string> chunks;
+  auto consume = [&chunks](absl::string_view chunk) {
+    chunks.push_back(std::string(chunk));
+    return absl::OkStatus();
+  };
+
+  MORIARTY_EXPECT_OK(c.ReadTokenInChunks(consume));
+  EXPECT_THAT(chunks, ElementsAre("abc"));
+
+  chunks.clear();
+  MORIARTY_EXPECT_OK(c.ReadTokenInChunks(consume));
+  ASSERT_THAT(chunks, SizeIs(3));
+  EXPECT_THAT(chunks[0], SizeIs(IOConfig::kTokenChunkSize));
+  EXPECT_THAT(chunks[2], SizeIs(5));
+  EXPECT_EQ(absl::StrJoin(chunks, ""), long_token);
+
+  EXPECT_THAT(c.ReadToken(), IsOkAndHolds("def"));
+  EXPECT_THAT(c.ReadTokenInChunks(consume),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("Attempted to read a token, but read EOF.")));
+}
+
+TEST(IOConfigTest, ReadTokenInChunksShouldStopWhenConsumeFails) {
+  std::string long_token(IOConfig::kTokenChunkSize + 1, 'x');
+  std::stringstream ss(long_token);
+  IOConfig c;
+  c.SetInputStream(ss);
+
+  int calls = 0;
+  EXPECT_THAT(c.ReadTokenInChunks([&calls](absl::string_view) {
+    calls++;
+    return absl::InvalidArgumentError("bad chunk");
+  }),
+              StatusIs(absl::StatusCode::kInvalidArgument, "bad chunk"));
+  EXPECT_EQ(calls, 1);
+  EXPECT_THAT(c.ReadToken(), IsOkAndHolds("x"));
+}
+
+TEST(IOConfigTest, ReadTokenInChunksShouldRespectWhitespacePolicy) {
+  std::stringstream ss(" abc");
+  IOConfig c;
+  c.SetInputStream(ss);
+  auto consume = [](absl::string_view) { return absl::OkStatus(); };
+
+  EXPECT_THAT(c.ReadTokenInChunks(consume),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("got whitespace instead")));
+  c.SetWhitespacePolicy(IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+  MORIARTY_EXPECT_OK(c.ReadTokenInChunks(consume));
+}
+
+TEST(IOConfigTest, ReadWhitespaceAtEndOfInputShouldGiveEOFError) {
+  std::stringstream ss("");
+  IOConfig c;
+  c.SetInputStream(ss);
+  EXPECT_THAT(c.ReadWhitespace(Whitespace::kNewline),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("Expected '\\n', but got EOF.")));
+  EXPECT_TRUE(ss.eof());
+}
+
+TEST(IOConfigTest, ReadIntegerShouldReadIntegers) {
+  std::stringstream ss("123 -456 +789 0 -0 007");
+  IOConfig c;
+  c.SetInputStream(ss).SetWhitespacePolicy(
+      IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(123));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(-456));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(789));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(0));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(0));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(7));
+}
+
+TEST(IOConfigTest, ReadIntegersShouldReadARow) {
+  std::stringstream ss("1 -2 3\n4");
+  IOConfig c;
+  c.SetInputStream(ss);
+
+  std::vector<int64_t> values(3);
+  MORIARTY_ASSERT_OK(
+      c.ReadIntegers(absl::MakeSpan(values), Whitespace::kSpace));
+  EXPECT_THAT(values, ElementsAre(1, -2, 3));
+  MORIARTY_EXPECT_OK(c.ReadWhitespace(Whitespace::kNewline));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(4));
+}
+
+TEST(IOConfigTest, ReadIntegersShouldRespectTheSeparator) {
+  std::stringstream ss("1 2");
+  IOConfig c;
+  c.SetInputStream(ss);
+
+  std::vector<int64_t> values(2);
+  EXPECT_THAT(c.ReadIntegers(absl::MakeSpan(values), Whitespace::kTab),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected '\\t', but got ' '.")));
+}
+
+// Reads `contents` through a get area of at most `buffer_size` characters, or
+// without any get area (one character at a time) if `buffer_size` is 0.
+class SmallBuffer : public std::streambuf {
+ public:
+  SmallBuffer(std::string contents, int buffer_size)
+      : contents_(std::move(contents)), buffer_size_(buffer_size) {}
+
+ protected:
+  int_type underflow() override {
+    if (pos_ == contents_.size()) return traits_type::eof();
+    if (buffer_size_ == 0) return traits_type::to_int_type(contents_[pos_]);
+    char* begin = contents_.data() + pos_;
+    pos_ = std::min(contents_.size(), pos_ + buffer_size_);
+    setg(begin, begin, contents_.data() + pos_);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  int_type uflow() override {
+    if (buffer_size_ > 0) return std::streambuf::uflow();
+    if (pos_ == contents_.size()) return traits_type::eof();
+    return traits_type::to_int_type(contents_[pos_++]);
+  }
+
+ private:
+  std::string contents_;
+  size_t buffer_size_;
+  size_t pos_ = 0;
+};
+
+TEST(IOConfigTest, ReadsShouldWorkAcrossBufferBoundaries) {
+  std::string long_token(100, 'x');
+  std::string input =
+      absl::StrCat("12345 -678   ", long_token, "\n\t tok 99999");
+  for (int buffer_size : {0, 1, 2, 3, 7, 16, 1000}) {
+    SmallBuffer buffer(input, buffer_size);
+    std::istream is(&buffer);
+    IOConfig c;
+    c.SetInputStream(is).SetWhitespacePolicy(
+        IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+    EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(12345)) << buffer_size;
+    EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(-678)) << buffer_size;
+    EXPECT_THAT(c.ReadToken(), IsOkAndHolds(long_token)) << buffer_size;
+    std::string chunks;
+    MORIARTY_EXPECT_OK(c.ReadTokenInChunks([&](absl::string_view chunk) {
+      absl::StrAppend(&chunks, chunk);
+      return absl::OkStatus();
+    }));
+    EXPECT_EQ(chunks, "tok") << buffer_size;
+    EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(99999)) << buffer_size;
+    EXPECT_TRUE(is.eof());
+  }
+}
+
+TEST(IOConfigTest, ReadIntegersShouldCheckEverySeparatorAcrossBuffers) {
+  std::vector<std::string> row;
+  for (int i = 0; i < 100; i++) row.push_back(absl::StrCat(i * 1001));
+  std::string input = absl::StrJoin(row, " ");
+
+  for (int buffer_size : {0, 1, 5, 16, 1000}) {
+    SmallBuffer buffer(input, buffer_size);
+    std::istream is(&buffer);
+    IOConfig c;
+    c.SetInputStream(is);
+    std::vector<int64_t> values(row.size());
+    MORIARTY_ASSERT_OK(
+        c.ReadIntegers(absl::MakeSpan(values), Whitespace::kSpace));
+    for (int i = 0; i < 100; i++) EXPECT_EQ(values[i], i * 1001);
+
+    SmallBuffer bad_buffer(input + "  1", buffer_size);
+    std::istream bad_is(&bad_buffer);
+    c.SetInputStream(bad_is);
+    values.resize(row.size() + 1);
+    EXPECT_THAT(c.ReadIntegers(absl::MakeSpan(values), Whitespace::kSpace),
+                StatusIs(absl::StatusCode::kFailedPrecondition,
+                         HasSubstr("got whitespace instead")));
+  }
+}
+
+TEST(IOConfigTest, ReadIntegerShouldHandleTheExtremes) {
+  std::stringstream ss(
+      "9223372036854775807 -9223372036854775808 9223372036854775808 "
+      "-9223372036854775809 100000000000000000000");
+  IOConfig c;
+  c.SetInputStream(ss).SetWhitespacePolicy(
+      IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+  EXPECT_THAT(c.ReadInteger(),
+              IsOkAndHolds(std::numeric_limits<int64_t>::max()));
+  EXPECT_THAT(c.ReadInteger(),
+              IsOkAndHolds(std::numeric_limits<int64_t>::min()));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_THAT(c.ReadInteger(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Unable to read an integer.")));
+  }
+}
+
+TEST(IOConfigTest, ReadIntegerWithInvalidTokensShouldFail) {
+  for (absl::string_view input : {"abc", "-", "+", "--1", "+-1", "++1", ".5"}) {
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss);
+    EXPECT_THAT(c.ReadInteger(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Unable to read an integer.")))
+        << input;
+  }
+
+  for (absl::string_view input : {"12c", "1-", "5.0", "0x10"}) {
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss);
+    EXPECT_THAT(c.ReadInteger(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Found extra characters")))
+        << input;
+  }
+}
+
+TEST(IOConfigTest, ReadIntegerShouldReadTheWholeTokenAfterAnError) {
+  std::stringstream ss("1x2 99999999999999999999 --5 7");
+  IOConfig c;
+  c.SetInputStream(ss).SetWhitespacePolicy(
+      IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+  EXPECT_THAT(c.ReadInteger(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(c.ReadInteger(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(c.ReadInteger(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(7));
+}
+
+TEST(IOConfigTest, StrictIntegerPolicyShouldOnlyAcceptCanonicalIntegers) {
+  std::stringstream ss(
+      "0 123 -456 9223372036854775807 -9223372036854775808 10 -10");
+  IOConfig c;
+  c.SetInputStream(ss)
+      .SetWhitespacePolicy(IOConfig::WhitespacePolicy::kIgnoreWhitespace)
+      .SetIntegerPolicy(IOConfig::IntegerPolicy::kStrict);
+
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(0));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(123));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(-456));
+  EXPECT_THAT(c.ReadInteger(),
+              IsOkAndHolds(std::numeric_limits<int64_t>::max()));
+  EXPECT_THAT(c.ReadInteger(),
+              IsOkAndHolds(std::numeric_limits<int64_t>::min()));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(10));
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(-10));
+}
+
+TEST(IOConfigTest, StrictIntegerPolicyShouldRejectNonCanonicalIntegers) {
+  for (absl::string_view input : {"+5", "+0"}) {
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss).SetIntegerPolicy(IOConfig::IntegerPolicy::kStrict);
+    EXPECT_THAT(c.ReadInteger(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                          HasSubstr("'+'")))
+        << input;
+  }
+
+  for (absl::string_view input : {"00", "007", "-007", "0123456"}) {
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss).SetIntegerPolicy(IOConfig::IntegerPolicy::kStrict);
+    EXPECT_THAT(c.ReadInteger(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                          HasSubstr("leading zeros")))
+        << input;
+  }
+
+  std::stringstream ss("-0");
+  IOConfig c;
+  c.SetInputStream(ss).SetIntegerPolicy(IOConfig::IntegerPolicy::kStrict);
+  EXPECT_THAT(c.ReadInteger(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                        HasSubstr("Zero")));
+}
+
+TEST(IOConfigTest, ReadIntegerShouldRespectWhitespacePolicy) {
+  std::stringstream ss(" 5");
+  IOConfig c;
+  c.SetInputStream(ss);
+
+  EXPECT_THAT(c.ReadInteger(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("got whitespace instead")));
+  c.SetWhitespacePolicy(IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(5));
+  EXPECT_THAT(c.ReadInteger(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("read EOF")));
+}
+
+TEST(IOConfigTest, ReadRealShouldReadRealNumbers) {
+  std::stringstream ss("1.25 -3 0.1 .5 1e-3 -0.0");
+  IOConfig c;
+  c.SetInputStream(ss).SetWhitespacePolicy(
+      IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+  EXPECT_THAT(c.ReadReal(), IsOkAndHolds(1.25));
+  EXPECT_THAT(c.ReadReal(), IsOkAndHolds(-3.0));
+  EXPECT_THAT(c.ReadReal(), IsOkAndHolds(0.1));
+  EXPECT_THAT(c.ReadReal(), IsOkAndHolds(0.5));
+  EXPECT_THAT(c.ReadReal(), IsOkAndHolds(0.001));
+  EXPECT_THAT(c.ReadReal(), IsOkAndHolds(0.0));
+}
+
+TEST(IOConfigTest, ReadRealWithInvalidTokensShouldFail) {
+  for (absl::string_view input :
+       {"abc", "-", "+1.5", "--1", "nan", "inf", "-inf", "1e999"}) {
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss);
+    EXPECT_THAT(c.ReadReal(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Unable to read a real number.")))
+        << input;
+  }
+
+  for (absl::string_view input : {"1.5x", "1,5", "0x10", "1.2.3"}) {
+    std::stringstream ss((std::string(input)));
+    IOConfig c;
+    c.SetInputStream(ss);
+    EXPECT_THAT(c.ReadReal(),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Found extra characters")))
+        << input;
+  }
+}
+
+TEST(IOConfigTest, AtEofAndHasMoreTokensShouldNotReadAnything) {
+  std::stringstream ss("5 6\n");
+  IOConfig c;
+  c.SetInputStream(ss);
+
+  EXPECT_FALSE(c.AtEof());
+  EXPECT_TRUE(c.HasMoreTokens());
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(5));
+  EXPECT_FALSE(c.AtEof());
+  EXPECT_FALSE(c.HasMoreTokens());  // The next character is a space.
+  MORIARTY_EXPECT_OK(c.ReadWhitespace(Whitespace::kSpace));
+  EXPECT_TRUE(c.HasMoreTokens());
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(6));
+  EXPECT_FALSE(c.AtEof());
+  MORIARTY_EXPECT_OK(c.ReadWhitespace(Whitespace::kNewline));
+  EXPECT_TRUE(c.AtEof());
+  EXPECT_FALSE(c.HasMoreTokens());
+}
+
+TEST(IOConfigTest, AtEofAndHasMoreTokensShouldRespectWhitespacePolicy) {
+  std::stringstream ss("5 \n\t \n");
+  IOConfig c;
+  c.SetInputStream(ss).SetWhitespacePolicy(
+      IOConfig::WhitespacePolicy::kIgnoreWhitespace);
+
+  EXPECT_TRUE(c.HasMoreTokens());
+  EXPECT_THAT(c.ReadInteger(), IsOkAndHolds(5));
+  EXPECT_FALSE(c.HasMoreTokens());
+  EXPECT_TRUE(c.AtEof());
+}
+
+TEST(IOConfigTest, AtEofWithoutAnInputStreamShouldBeTrue) {
+  IOConfig c;
+  EXPECT_TRUE(c.AtEof());
+  EXPECT_FALSE(c.HasMoreTokens());
+}
+
 TEST(IOConfigTest, PrintTokenShouldPrintProperly) {
   std::stringstream ss;
   IOConfig c;
@@ -180,6 +612,98 @@ TEST(IOConfigTest, PrintTokenShouldPrintProperly) {
   EXPECT_EQ(ss.str(), "Hello!");
 }
 
+TEST(IOConfigTest, PrintIntegerShouldPrintProperly) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetOutputStream(ss);
+  for (int64_t value : {int64_t{0}, int64_t{-5}, int64_t{1234567890123},
+                        std::numeric_limits<int64_t>::min(),
+                        std::numeric_limits<int64_t>::max()}) {
+    MORIARTY_EXPECT_OK(c.PrintInteger(value));
+    MORIARTY_EXPECT_OK(c.PrintWhitespace(Whitespace::kSpace));
+  }
+  EXPECT_EQ(ss.str(),
+            "0 -5 1234567890123 -9223372036854775808 9223372036854775807 ");
+}
+
+TEST(IOConfigTest, PrintIntegersShouldPrintARow) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetOutputStream(ss);
+  MORIARTY_EXPECT_OK(c.PrintIntegers(
+      std::vector<int64_t>{0, -5, std::numeric_limits<int64_t>::min(),
+                           std::numeric_limits<int64_t>::max()},
+      Whitespace::kSpace));
+  MORIARTY_EXPECT_OK(c.PrintWhitespace(Whitespace::kNewline));
+  MORIARTY_EXPECT_OK(
+      c.PrintIntegers(std::vector<int64_t>{1, 2}, Whitespace::kTab));
+  MORIARTY_EXPECT_OK(c.PrintWhitespace(Whitespace::kNewline));
+  MORIARTY_EXPECT_OK(c.PrintIntegers({}, Whitespace::kSpace));
+  EXPECT_EQ(ss.str(),
+            "0 -5 -9223372036854775808 9223372036854775807\n1\t2\n");
+}
+
+TEST(IOConfigTest, PrintRealShouldPrintTheShortestExactValue) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetOutputStream(ss);
+  for (double value : {0.0, -3.0, 0.1, 1.25, 1e-5, 123456789.5}) {
+    MORIARTY_EXPECT_OK(c.PrintReal(value));
+    MORIARTY_EXPECT_OK(c.PrintWhitespace(Whitespace::kSpace));
+  }
+  EXPECT_EQ(ss.str(), "0 -3 0.1 1.25 0.00001 123456789.5 ");
+}
+
+TEST(IOConfigTest, PrintRealWithDigitsShouldPrintExactlyThatManyDigits) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetOutputStream(ss);
+  MORIARTY_EXPECT_OK(c.PrintReal(1.25, 3));
+  MORIARTY_EXPECT_OK(c.PrintWhitespace(Whitespace::kSpace));
+  MORIARTY_EXPECT_OK(c.PrintReal(-0.5, 0));
+  MORIARTY_EXPECT_OK(c.PrintWhitespace(Whitespace::kSpace));
+  MORIARTY_EXPECT_OK(c.PrintReal(2.0 / 3.0, 4));
+  EXPECT_EQ(ss.str(), "1.250 -0 0.6667");
+}
+
+TEST(IOConfigTest, PrintRealWithInvalidArgumentsShouldFail) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetOutputStream(ss);
+  EXPECT_THAT(c.PrintReal(std::numeric_limits<double>::infinity()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(c.PrintReal(std::numeric_limits<double>::quiet_NaN()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(c.PrintReal(1.0, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(c.PrintReal(1.0, IOConfig::kMaxRealDigits + 1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(ss.str(), "");
+}
+
+TEST(IOConfigTest, FlushShouldFlushTheOutputStream) {
+  std::stringstream ss;
+  IOConfig c;
+  c.SetOutputStream(ss);
+  MORIARTY_EXPECT_OK(c.PrintInteger(5));
+  MORIARTY_EXPECT_OK(c.Flush());
+  EXPECT_EQ(ss.str(), "5");
+
+  ss.setstate(std::ios_base::badbit);
+  EXPECT_THAT(c.Flush(), StatusIs(absl::StatusCode::kUnavailable));
+}
+
+TEST(IOConfigTest, PrintingToAFailedStreamShouldNotWrite) {
+  std::stringstream ss;
+  ss.setstate(std::ios_base::failbit);
+  IOConfig c;
+  c.SetOutputStream(ss);
+  MORIARTY_EXPECT_OK(c.PrintToken("Hello!"));
+  MORIARTY_EXPECT_OK(c.PrintInteger(5));
+  ss.clear();
+  EXPECT_EQ(ss.str(), "");
+}
+
 }  // namespace
 }  // namespace librarian
 }  // namespace moriarty
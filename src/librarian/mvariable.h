@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <any>
+#include <atomic>
 #include <concepts>
 #include <cstdint>
 #include <functional>
@@ -32,21 +33,34 @@
 #include "absl/algorithm/container.h"
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "src/constraint_values.h"
 #include "src/errors.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/copy_on_write.h"
+#include "src/internal/generation_budget.h"
 #include "src/internal/generation_config.h"
+#include "src/internal/generation_context.h"
+#include "src/internal/generation_profile.h"
 #include "src/internal/random_config.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/range.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
+#include "src/internal/tracing.h"
 #include "src/internal/universe.h"
+#include "src/internal/value_codec.h"
+#include "src/internal/value_set.h"
 #include "src/internal/variable_name_utils.h"
 #include "src/librarian/io_config.h"
 #include "src/librarian/subvalues.h"
@@ -84,7 +98,9 @@ class MVariable : public moriarty_internal::AbstractVariable {
  protected:
   // Only derived classes should make copies of me directly to avoid accidental
   // slicing. Call derived class's constructors instead.
-  MVariable() {
+  MVariable()
+      : moriarty_internal::AbstractVariable(
+            moriarty_internal::TypeIdOf<VariableType>()) {
     static_assert(std::default_initializable<VariableType>,
                   "Moriarty needs to be able to construct default versions of "
                   "your MVariable using its default constructor.");
@@ -112,7 +128,7 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // ToString()
   //
   // Returns a string representation of the constraints this MVariable has.
-  [[nodiscard]] std::string ToString() const;
+  [[nodiscard]] std::string ToString() const override;
 
   // Is()
   //
@@ -203,6 +219,19 @@ class MVariable : public moriarty_internal::AbstractVariable {
   [[nodiscard]] absl::StatusOr<std::vector<VariableType>>
   GetDifficultInstances() const;
 
+  // ValueByteSize() [static/optional]
+  //
+  // Returns the number of bytes of data in `value`. This is what generation
+  // budgets and `Moriarty::SetGenerationByteLimit()` count. By default, this is
+  // `ApproximateByteSize(value)`.
+  //
+  // Variables whose values are not described well by the default (e.g., a
+  // class holding a vector) should hide this with their own static
+  // `ValueByteSize()` with the same signature.
+  [[nodiscard]] static int64_t ValueByteSize(const ValueType& value) {
+    return moriarty_internal::ApproximateByteSize(value);
+  }
+
  protected:
   // ---------------------------------------------------------------------------
   //  Functions that need to be overridden by all `MVariable`s.
@@ -293,6 +322,28 @@ class MVariable : public moriarty_internal::AbstractVariable {
   virtual absl::StatusOr<Subvalues> GetSubvaluesImpl(
       const ValueType& value) const;
 
+  // GetSubvalueImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `GetSubvalue()` instead.
+  //
+  // Returns the subvalue of `value` named `subvalue_name` (e.g., "length", not
+  // "length.x"), inside a `Subvalues`. Only that subvalue needs to be added.
+  // Override this instead of `GetSubvaluesImpl()` if some subvalues are
+  // expensive to compute, so that each lookup only computes the one it needs.
+  //
+  // Example implementation:
+  //
+  //  absl::StatusOr<Subvalues> CustomType::GetSubvalueImpl(
+  //      const Value& value, absl::string_view subvalue_name) const {
+  //    if (subvalue_name == "length")
+  //      return Subvalues().AddSubvalue<MInteger>("length", value.length());
+  //    return Subvalues();  // Unknown subvalue.
+  //  }
+  //
+  // Default: All of `GetSubvaluesImpl(value)`.
+  virtual absl::StatusOr<Subvalues> GetSubvalueImpl(
+      const ValueType& value, absl::string_view subvalue_name) const;
+
   // GetDifficultInstancesImpl() [virtual/optional]
   //
   // Users should not call this directly. Call `GetDifficultInstances()`
@@ -303,6 +354,23 @@ class MVariable : public moriarty_internal::AbstractVariable {
   virtual absl::StatusOr<std::vector<VariableType>> GetDifficultInstancesImpl()
       const;
 
+  // ShrinkImpl() [virtual/optional]
+  //
+  // Users should not call this directly. It is used by minimizers, which try
+  // smaller versions of a failing test case.
+  //
+  // Returns the `index`-th version of `value` at `level` that is smaller than
+  // `value` (e.g., shorter, or closer to 0), or `std::nullopt` if there is no
+  // such version. Level 0 has the largest changes, and each later level has
+  // smaller ones. A level without any version (`index` 0 returns
+  // `std::nullopt`) means there are no more levels. The versions do not need
+  // to satisfy the constraints of this variable. See `moriarty_internal::
+  // RemoveChunk()` and `ShrinkTowardsZero()`.
+  //
+  // By default, there are no smaller versions.
+  virtual std::optional<ValueType> ShrinkImpl(const ValueType& value,
+                                              int level, int64_t index) const;
+
   // GetUniqueValueImpl() [virtual/optional]
   //
   // Users should not call this directly. Call `MergeFrom()` instead.
@@ -316,6 +384,61 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // By default, this returns `std::nullopt`.
   virtual std::optional<ValueType> GetUniqueValueImpl() const;
 
+  // EnumerateImpl() [virtual/optional]
+  //
+  // Users should not call this directly. It is used by `Generate()`.
+  //
+  // Returns every value that `GenerateImpl()` may return, if there are at most
+  // `max_values` of them and `GenerateImpl()` picks each of them equally
+  // often. Otherwise, returns `nullptr`. When custom constraints keep
+  // rejecting generated values, `Generate()` samples from the values returned
+  // here that satisfy them instead. Those are cached by the address of the
+  // returned vector, so the same vector should be returned until the
+  // constraints of this variable change.
+  //
+  // By default, this returns `nullptr`.
+  virtual std::shared_ptr<const std::vector<ValueType>> EnumerateImpl(
+      int64_t max_values) const;
+
+  // IsKnownUnsatisfiableImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `IsKnownUnsatisfiable()` from
+  // the Internal Extended API instead.
+  //
+  // Determines, without generating anything, if no value can satisfy the
+  // constraints on this variable. This should be cheap, since it is used to
+  // discard impossible combinations of constraints before generating them.
+  // Only use values that are already known (e.g., via `GetKnownValue()`); if
+  // something is not known, return `false`. Returning `false` does not
+  // guarantee there is a valid value, just that it is too hard to determine
+  // that there is not.
+  //
+  // By default, this returns `false`.
+  virtual bool IsKnownUnsatisfiableImpl() const;
+
+  // GetIntegerBoundsImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `GetIntegerBounds()` from the
+  // Internal Extended API instead.
+  //
+  // If this variable is an integer, returns its bounds so they can be
+  // tightened against the bounds of other variables before generation.
+  //
+  // By default, this returns `nullptr`.
+  virtual const Range* GetIntegerBoundsImpl() const;
+
+  // TightenIntegerBoundsImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `TightenIntegerBounds()` from
+  // the Internal Extended API instead.
+  //
+  // Restricts this integer variable to `bounds`. Every valid value is already
+  // known to be within `bounds`. Only needs to be overridden if
+  // `GetIntegerBoundsImpl()` is.
+  //
+  // By default, this does nothing.
+  virtual void TightenIntegerBoundsImpl(const Range& bounds);
+
   // ToStringImpl() [virtual/optional]
   //
   // Returns the constraints on this variable in a string format so the user can
@@ -332,6 +455,114 @@ class MVariable : public moriarty_internal::AbstractVariable {
   virtual absl::StatusOr<std::string> ValueToStringImpl(
       const ValueType& value) const;
 
+  // GenerateInBulkImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `RandomInBulk()` instead.
+  //
+  // Generates `n` independent values at once. This must be equivalent to
+  // calling `GenerateImpl()` `n` times (including how the RandomEngine is
+  // used), and every value returned must satisfy `IsSatisfiedWithImpl()`.
+  // The only exception is a counter-based RandomEngine (see
+  // `RandomEngine::IsCounterBased()`), which may be used in a different order
+  // (e.g., `MTuple` draws one component of all of the tuples at a time).
+  //
+  // Return `std::nullopt` if this variable cannot generate values in bulk
+  // (for example, if the values may need to be retried).
+  //
+  // GenerateInBulkImpl() will only be called if Is()/IsOneOf() and custom
+  // constraints have not been used.
+  //
+  // By default, this returns `std::nullopt`.
+  virtual absl::StatusOr<std::optional<std::vector<ValueType>>>
+  GenerateInBulkImpl(int n);
+
+  // GenerateDistinctInBulkImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `RandomDistinctInBulk()`
+  // instead.
+  //
+  // Generates `n` distinct values at once. Every value returned must satisfy
+  // `IsSatisfiedWithImpl()`. Unlike `GenerateInBulkImpl()`, this need not use
+  // the RandomEngine the same way as repeated calls to `GenerateImpl()`.
+  //
+  // Return `std::nullopt` if this variable cannot generate distinct values in
+  // bulk (for example, if there may not be `n` distinct values).
+  //
+  // GenerateDistinctInBulkImpl() will only be called if Is()/IsOneOf() and
+  // custom constraints have not been used.
+  //
+  // By default, this returns `std::nullopt`.
+  virtual absl::StatusOr<std::optional<std::vector<ValueType>>>
+  GenerateDistinctInBulkImpl(int n);
+
+  // GenerateSortedInBulkImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `RandomSortedInBulk()` instead.
+  //
+  // Generates `n` values at once, in non-decreasing order (or increasing order
+  // if `strictly_increasing`), without sorting them afterwards. Every value
+  // returned must satisfy `IsSatisfiedWithImpl()`. This need not use the
+  // RandomEngine the same way as repeated calls to `GenerateImpl()`.
+  //
+  // Return `std::nullopt` if this variable cannot generate sorted values in
+  // bulk.
+  //
+  // GenerateSortedInBulkImpl() will only be called if Is()/IsOneOf() and custom
+  // constraints have not been used.
+  //
+  // By default, this returns `std::nullopt`.
+  virtual absl::StatusOr<std::optional<std::vector<ValueType>>>
+  GenerateSortedInBulkImpl(int n, bool strictly_increasing);
+
+  // GenerateInBulkWithSumImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `RandomInBulkWithSum()` instead.
+  //
+  // Generates `n` values at once whose sum is `sum`. For strings, this is the
+  // sum of their lengths. Every value returned must satisfy
+  // `IsSatisfiedWithImpl()`. This need not use the RandomEngine the same way as
+  // repeated calls to `GenerateImpl()`.
+  //
+  // Return `std::nullopt` if this variable cannot generate values with a given
+  // sum in bulk.
+  //
+  // GenerateInBulkWithSumImpl() will only be called if Is()/IsOneOf() and
+  // custom constraints have not been used.
+  //
+  // By default, this returns `std::nullopt`.
+  virtual absl::StatusOr<std::optional<std::vector<ValueType>>>
+  GenerateInBulkWithSumImpl(int n, int64_t sum);
+
+  // AllSatisfiedWithImpl() [virtual/optional]
+  //
+  // Users should not call this directly. Call `AllSatisfyConstraints()`
+  // instead.
+  //
+  // Returns true if `IsSatisfiedWithImpl()` would accept every value in
+  // `values`. Return false if that cannot be decided quickly or if some value
+  // is invalid. The caller then checks the values one at a time (which also
+  // produces the error message).
+  //
+  // AllSatisfiedWithImpl() will only be called if Is()/IsOneOf() and custom
+  // constraints have not been used.
+  //
+  // By default, this returns false.
+  virtual bool AllSatisfiedWithImpl(absl::Span<const ValueType> values) const;
+
+  // IsSatisfiedWithGeneratedImpl() [virtual/optional]
+  //
+  // Users should not call this directly.
+  //
+  // Same as `IsSatisfiedWithImpl()`, but `value` was just returned by
+  // `GenerateImpl()`. Override this to skip the constraints that
+  // `GenerateImpl()` guarantees by construction (e.g., the elements of an array
+  // that were each generated, and checked, by the element's variable). Custom
+  // constraints are checked separately, so they are never skipped.
+  //
+  // By default, this calls `IsSatisfiedWithImpl()`.
+  virtual absl::Status IsSatisfiedWithGeneratedImpl(
+      const ValueType& value) const;
+
   // ---------------------------------------------------------------------------
   //  Functions to fully register this MVariable with Moriarty.
 
@@ -376,6 +607,109 @@ class MVariable : public moriarty_internal::AbstractVariable {
   absl::StatusOr<typename T::value_type> Random(absl::string_view debug_name,
                                                 T m);
 
+  // RandomInBulk() [Helper for Librarians]
+  //
+  // Generates `n` independent random values that are described by `m`, if `m`
+  // is able to generate them all at once. This is much faster than calling
+  // `Random()` `n` times since the retry machinery is skipped.
+  //
+  // Returns `std::nullopt` if `m` cannot generate values in bulk. In that
+  // case, call `Random()` for each value instead.
+  //
+  // `debug_name` is for better debugging messages on failure and is local
+  // only to this function call.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+  RandomInBulk(absl::string_view debug_name, T m, int n);
+
+  // RandomInPlace() [Helper for Librarians]
+  //
+  // Generates a random value that is described by `m` without copying `m`,
+  // naming it, or going through the retry machinery of `Random()`. Any changes
+  // `m` makes to itself while generating are kept, so only use this for
+  // variables whose generation leaves them unchanged.
+  //
+  // Returns `std::nullopt` if `m` cannot be generated this way (it has
+  // dependencies, `Is()`/`IsOneOf()` or custom constraints) or if the single
+  // attempt failed. In that case, call `Random()` instead.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  std::optional<typename T::value_type> RandomInPlace(T& m);
+
+  // RandomDistinctInBulk() [Helper for Librarians]
+  //
+  // Generates `n` distinct random values that are described by `m`, if `m` is
+  // able to generate them all at once. This avoids generating values one at a
+  // time and rejecting duplicates.
+  //
+  // Returns `std::nullopt` if `m` cannot generate distinct values in bulk.
+  //
+  // `debug_name` is for better debugging messages on failure and is local
+  // only to this function call.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+  RandomDistinctInBulk(absl::string_view debug_name, T m, int n);
+
+  // RandomSortedInBulk() [Helper for Librarians]
+  //
+  // Generates `n` random values that are described by `m` in non-decreasing
+  // order (or increasing order if `strictly_increasing`), if `m` is able to
+  // generate them that way directly. This avoids sorting the values afterwards.
+  //
+  // Returns `std::nullopt` if `m` cannot generate sorted values in bulk.
+  //
+  // `debug_name` is for better debugging messages on failure and is local
+  // only to this function call.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+  RandomSortedInBulk(absl::string_view debug_name, T m, int n,
+                     bool strictly_increasing);
+
+  // RandomInBulkWithSum() [Helper for Librarians]
+  //
+  // Generates `n` random values that are described by `m` and sum to `sum` (for
+  // strings, whose lengths sum to `sum`), if `m` is able to generate them that
+  // way directly. This avoids generating values until their sum happens to be
+  // right.
+  //
+  // Returns `std::nullopt` if `m` cannot generate values with a given sum in
+  // bulk.
+  //
+  // `debug_name` is for better debugging messages on failure and is local
+  // only to this function call.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+  RandomInBulkWithSum(absl::string_view debug_name, T m, int n, int64_t sum);
+
+  // RandomInParallel() [Helper for Librarians]
+  //
+  // Generates `n` independent random values that are described by `m`, split
+  // into chunks of `GenerationConfig::kParallelGenerationChunkSize` values
+  // which are generated in parallel on `GenerationConfig::GetScheduler()`.
+  // Each chunk has its own RandomEngine, split from this variable's engine in
+  // chunk order, so the values do not depend on the number of threads.
+  //
+  // Returns `std::nullopt` if `m` depends on other variables (so may not be
+  // generated concurrently), if `n` fits in a single chunk, or if the random
+  // engine is not counter-based (so existing seeds keep their values).
+  //
+  // `debug_name` is for better debugging messages on failure and is local
+  // only to this function call.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+  RandomInParallel(absl::string_view debug_name, T m, int n);
+
   // SatisfiesConstraints() [Helper for Librarians]
   //
   // Determines if `value` satisfies the constraints of `m`. Any global context
@@ -388,6 +722,31 @@ class MVariable : public moriarty_internal::AbstractVariable {
                                librarian::MVariable<T, typename T::value_type>>
   absl::Status SatisfiesConstraints(T m, const T::value_type& value) const;
 
+  // AllSatisfyConstraints() [Helper for Librarians]
+  //
+  // Returns true if every value in `values` is known to satisfy the
+  // constraints of `m`, without checking them one at a time. If this returns
+  // false, call `SatisfiesConstraints()` on each value instead (some may still
+  // be valid). Any global context needed will come from *this* variable.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  bool AllSatisfyConstraints(
+      T m, absl::Span<const typename T::value_type> values) const;
+
+  // FindFirstUnsatisfied() [Helper for Librarians]
+  //
+  // Returns the index of the first value in `values` that does not satisfy
+  // the constraints of `m` (see `SatisfiesConstraints()`), or `std::nullopt`
+  // if all of them do. If there is a scheduler (see `GetScheduler()`), large
+  // spans are split into chunks of `Universe::kParallelValidationChunkSize`
+  // values that are checked in parallel. The result is the same either way.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  std::optional<int64_t> FindFirstUnsatisfied(
+      T m, absl::Span<const typename T::value_type> values) const;
+
   // Read() [Helper for Librarians]
   //
   // Reads a value using any configuration provided by `m` (whitespace
@@ -473,6 +832,22 @@ class MVariable : public moriarty_internal::AbstractVariable {
   std::optional<typename T::value_type> GetUniqueValue(
       absl::string_view debug_name, T m) const;
 
+  // IsKnownUnsatisfiable() [Helper for Librarians]
+  //
+  // Determines if it is cheap to tell that no value can satisfy `m`, using
+  // the values known in this variable's universe. Useful to implement
+  // `IsKnownUnsatisfiableImpl()` for variables that contain other variables.
+  //
+  // `debug_name` is for better debugging messages on failure and is local
+  // only to this function call.
+  //
+  // Example Usage:
+  //  if (IsKnownUnsatisfiable("length", *length_)) return true;
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  bool IsKnownUnsatisfiable(absl::string_view debug_name, T m) const;
+
   // RandomInteger() [Helper for Librarians]
   //
   // Returns a random integer in the closed interval [min, max].
@@ -567,6 +942,13 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // this IOConfig.
   absl::StatusOr<absl::Nonnull<IOConfig*>> GetIOConfig();
 
+  // GetScheduler() [Helper for Librarians]
+  //
+  // Returns the scheduler to use for checking a single value on several
+  // threads (e.g., in `IsSatisfiedWithImpl()`), or `nullptr` if there is
+  // none. Any other variables that are looked up must only be read.
+  moriarty_internal::Scheduler* GetScheduler() const;
+
   // GetApproximateGenerationLimit() [Helper for Librarians]
   //
   // Returns the threshold for approximately how much data to generate. If
@@ -582,6 +964,16 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // stop generation at any point.
   [[nodiscard]] std::optional<int64_t> GetApproximateGenerationLimit() const;
 
+  // LowerApproximateGenerationLimit() [Helper for Librarians]
+  //
+  // Lowers the approximate generation limit (see
+  // `GetApproximateGenerationLimit()`) to at most `limit` until the returned
+  // object is destroyed. If there is no limit, this has no effect. Use this to
+  // share your limit among the variables you generate, e.g., the elements of
+  // an array.
+  [[nodiscard]] moriarty_internal::ScopedSoftGenerationLimit
+  LowerApproximateGenerationLimit(int64_t limit);
+
   // GetDependencies() [Helper for Librarians]
   //
   // Returns the list of names of the variables that `variable` depends on,
@@ -600,9 +992,14 @@ class MVariable : public moriarty_internal::AbstractVariable {
   void DeclareSelfAsInvalid(absl::Status status);
 
  private:
+  // The constraints below are wrapped in `CopyOnWrite`, so copies of this
+  // variable (e.g., the one made by each call to `Random()`) share them until
+  // one of the copies adds a constraint.
+
   // `is_one_of_` is a list of values that Generate() should produce. If the
   // optional is set and the list is empty, then there are no viable values.
-  std::optional<std::vector<ValueType>> is_one_of_;
+  moriarty_internal::CopyOnWrite<std::optional<std::vector<ValueType>>>
+      is_one_of_;
 
   // `universe_` is set iff SetUniverse has been called.
   // The universe contains all context of the outside world around this
@@ -618,7 +1015,8 @@ class MVariable : public moriarty_internal::AbstractVariable {
 
   // `custom_constraints_deps_` is a list of the needed variables for all the
   // custom constraints defined for this variable.
-  std::vector<std::string> custom_constraints_deps_;
+  moriarty_internal::CopyOnWrite<std::vector<std::string>>
+      custom_constraints_deps_;
 
   // `custom_constraints_` is a list of constraints, in the form of functions,
   // to check when `SatisfiesConstraints()` is called.
@@ -626,10 +1024,25 @@ class MVariable : public moriarty_internal::AbstractVariable {
     std::string name;
     std::function<bool(const ValueType&, const ConstraintValues& cv)> checker;
   };
-  std::vector<CustomConstraint> custom_constraints_;
+  moriarty_internal::CopyOnWrite<std::vector<CustomConstraint>>
+      custom_constraints_;
+
+  // The values of `EnumerateImpl()` (`domain`) that satisfy the custom
+  // constraints. Copies of this variable share the cache, so it may be used
+  // from several threads. It is replaced whenever a custom constraint is
+  // added.
+  struct EnumerationCache {
+    absl::Mutex mutex;
+    std::shared_ptr<const std::vector<ValueType>> domain ABSL_GUARDED_BY(mutex);
+    std::shared_ptr<const std::vector<ValueType>> candidates
+        ABSL_GUARDED_BY(mutex);
+  };
+  std::shared_ptr<EnumerationCache> enumeration_cache_ =
+      std::make_shared<EnumerationCache>();
 
   // The known properties of this variable. Maps from category -> function.
-  absl::flat_hash_map<std::string, PropertyCallbackFunction>
+  moriarty_internal::CopyOnWrite<
+      absl::flat_hash_map<std::string, PropertyCallbackFunction>>
       known_property_categories_;
 
   // The overall status of this variable. If this is not ok, then all FooImpl()
@@ -637,6 +1050,12 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // (E.g., GenerateImpl(), PrintImpl(), etc.)
   absl::Status overall_status_ = absl::OkStatus();
 
+  // Calls `fn` with the value of this variable in `universe_`. The stored value
+  // is passed by reference, so large values are not copied. `universe_` must
+  // be set.
+  absl::Status WithValueInUniverse(
+      absl::FunctionRef<absl::Status(const ValueType&)> fn) const;
+
   // ---------------------------------------------------------------------------
   //    Start of Internal Extended API
   //
@@ -644,6 +1063,8 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // Users and Librarians should not need to access these functions. See
   // `ImporterManager` for more details.
   friend class moriarty_internal::MVariableManager<VariableType, ValueType>;
+  // Universe reads unique values directly when it knows this exact type.
+  friend class moriarty_internal::Universe;
 
   // Generate() [Internal Extended API]
   //
@@ -656,6 +1077,68 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // random values.
   absl::StatusOr<ValueType> Generate();
 
+  // GenerateInBulk() [Internal Extended API]
+  //
+  // Generates `n` random values for the constraints in this MVariable at once,
+  // if possible. Returns `std::nullopt` if not possible (for example, `Is()`
+  // or custom constraints were used, or `GenerateInBulkImpl()` declined).
+  //
+  // Users should not need to call this function directly. Use
+  // `RandomInBulk(MVariable)` in the appropriate Moriarty component.
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateInBulk(int n);
+
+  // GenerateDistinctInBulk() [Internal Extended API]
+  //
+  // Same as `GenerateInBulk()`, but all `n` values are distinct. Returns
+  // `std::nullopt` if not possible.
+  //
+  // Users should not need to call this function directly. Use
+  // `RandomDistinctInBulk(MVariable)` in the appropriate Moriarty component.
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateDistinctInBulk(
+      int n);
+
+  // GenerateSortedInBulk() [Internal Extended API]
+  //
+  // Same as `GenerateInBulk()`, but the `n` values are in non-decreasing order
+  // (or increasing order if `strictly_increasing`). Returns `std::nullopt` if
+  // not possible.
+  //
+  // Users should not need to call this function directly. Use
+  // `RandomSortedInBulk(MVariable)` in the appropriate Moriarty component.
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateSortedInBulk(
+      int n, bool strictly_increasing);
+
+  // GenerateInBulkWithSum() [Internal Extended API]
+  //
+  // Same as `GenerateInBulk()`, but the `n` values sum to `sum`. Returns
+  // `std::nullopt` if not possible.
+  //
+  // Users should not need to call this function directly. Use
+  // `RandomInBulkWithSum(MVariable)` in the appropriate Moriarty component.
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateInBulkWithSum(
+      int n, int64_t sum);
+
+  // GenerateDirectly() [Internal Extended API]
+  //
+  // Generates a single value with one call to `GenerateImpl()`, skipping the
+  // bookkeeping and retries of `Generate()`. Returns `std::nullopt` if this
+  // variable needs other variables or may reject values, or if the attempt
+  // failed. `Generate()` should then be used to retry or report the error.
+  //
+  // Users should not need to call this function directly. Use
+  // `RandomInPlace(MVariable)` in the appropriate Moriarty component.
+  std::optional<ValueType> GenerateDirectly();
+
+  // AllSatisfiedWith() [Internal Extended API]
+  //
+  // Returns true if every value in `values` is known to satisfy all of the
+  // constraints specified by this variable. False means that the values must
+  // be checked one at a time with `IsSatisfiedWith()`.
+  //
+  // Users should not need to call this function directly. Use
+  // `AllSatisfyConstraints(MVariable)` in the appropriate Moriarty component.
+  bool AllSatisfiedWith(absl::Span<const ValueType> values) const;
+
   // IsSatisfiedWith() [Internal Extended API]
   //
   // Determines if `value` satisfies all of the constraints spcecified by this
@@ -715,6 +1198,32 @@ class MVariable : public moriarty_internal::AbstractVariable {
   absl::StatusOr<std::any> GetSubvalue(
       const std::any& my_value, absl::string_view subvalue_name) const override;
 
+  // EncodeValue() [Internal Extended API]
+  //
+  // Appends the binary encoding of the value of `variable_name` in `values` to
+  // `out`. Returns kUnimplemented unless `ValueType` is built from integers,
+  // strings, vectors and tuples.
+  absl::Status EncodeValue(const moriarty_internal::ValueSet& values,
+                           absl::string_view variable_name,
+                           std::string& out) const override;
+
+  // DecodeValue() [Internal Extended API]
+  //
+  // Decodes a value encoded by `EncodeValue()` from the front of `in`, removes
+  // it from `in` and stores it in `values` under `variable_name`.
+  absl::Status DecodeValue(absl::string_view& in,
+                           absl::string_view variable_name,
+                           moriarty_internal::ValueSet& values) const override;
+
+  // ShrinkValue() [Internal Extended API]
+  //
+  // Replaces the value of `variable_name` in `values` with its `index`-th
+  // smaller version at `level` from `ShrinkImpl()`. Returns the number of
+  // elements removed from it, or `std::nullopt` if there is no such version.
+  absl::StatusOr<std::optional<int64_t>> ShrinkValue(
+      moriarty_internal::ValueSet& values, absl::string_view variable_name,
+      int level, int64_t index) const override;
+
   // GetRandomEngine() [Internal Extended API]
   //
   // Retrieves the internal RandomEngine used for random generation. Only
@@ -744,8 +1253,34 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // Tells this variable that it should satisfy `property`.
   absl::Status WithProperty(Property property) override;
 
-  // Try to generate exactly once, without any retries.
-  absl::StatusOr<ValueType> GenerateOnce();
+  // A variable used in a custom constraint, tracked across the attempts of a
+  // single `Generate()` call. `variable` is looked up in `universe_` on first
+  // use. `assigned` is reset whenever a retry erases values.
+  struct CustomConstraintsDep {
+    AbstractVariable* variable = nullptr;
+    bool assigned = false;
+  };
+
+  // Try to generate exactly once, without any retries. On failure, `rejection`
+  // is set to the reason the attempt failed. `deps` has one entry per element
+  // of `custom_constraints_deps_`.
+  absl::StatusOr<ValueType> GenerateOnce(
+      moriarty_internal::GenerationProfile::Rejection& rejection,
+      std::vector<CustomConstraintsDep>& deps);
+
+  // The parts of `IsSatisfiedWith()` before and after custom constraints. If
+  // `generated_by_impl`, `value` was just returned by `GenerateImpl()`, so only
+  // the constraints it does not guarantee are checked (see
+  // `IsSatisfiedWithGeneratedImpl()`).
+  absl::Status IsSatisfiedWithBuiltInConstraints(
+      const ValueType& value, bool generated_by_impl = false) const;
+  absl::Status IsSatisfiedWithCustomConstraints(const ValueType& value) const;
+
+  // Returns the values of `EnumerateImpl()` that satisfy the custom
+  // constraints (cached in `enumeration_cache_`), or `nullptr` if they cannot
+  // be enumerated. Custom constraints with dependent variables and `IsOneOf()`
+  // are not supported, so this returns `nullptr` for those.
+  std::shared_ptr<const std::vector<ValueType>> EnumerateCandidates() const;
 
   // AssignValue()
   //
@@ -774,6 +1309,31 @@ class MVariable : public moriarty_internal::AbstractVariable {
   // returns `std::nullopt`. The `std::any` will be a `ValueType`.
   std::optional<std::any> GetUniqueValueUntyped() const override;
 
+  // GetUniqueValueTyped()
+  //
+  // Same as `GetUniqueValueUntyped()`, but without wrapping the value in an
+  // `std::any`.
+  std::optional<ValueType> GetUniqueValueTyped() const;
+
+  // IsKnownUnsatisfiable()
+  //
+  // Returns true if it is cheap to tell that no value can satisfy the
+  // constraints on this variable (e.g., none of the options in `IsOneOf()`
+  // are valid).
+  bool IsKnownUnsatisfiable() const override;
+
+  // GetIntegerBounds()
+  //
+  // Returns the bounds on this variable if it is an integer, and `nullptr`
+  // otherwise.
+  const Range* GetIntegerBounds() const override;
+
+  // TightenIntegerBounds()
+  //
+  // Restricts this integer variable to `bounds`, which every valid value is
+  // already known to satisfy.
+  void TightenIntegerBounds(const Range& bounds) override;
+
   // ValueSatisfiesConstraints()
   //
   // Determines if all variable constraints specified here have a
@@ -848,6 +1408,15 @@ class MVariableManager {
       librarian::MVariable<VariableType, ValueType>* mvariable_to_manage);
 
   absl::StatusOr<ValueType> Generate();
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateInBulk(int n);
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateDistinctInBulk(
+      int n);
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateSortedInBulk(
+      int n, bool strictly_increasing);
+  absl::StatusOr<std::optional<std::vector<ValueType>>> GenerateInBulkWithSum(
+      int n, int64_t sum);
+  std::optional<ValueType> GenerateDirectly();
+  bool AllSatisfiedWith(absl::Span<const ValueType> values) const;
   absl::Status IsSatisfiedWith(const ValueType& value) const;
   absl::Status MergeFrom(const AbstractVariable& other);
   absl::StatusOr<ValueType> TryRead();
@@ -858,6 +1427,8 @@ class MVariableManager {
   void SetUniverse(moriarty_internal::Universe* universe,
                    absl::string_view my_name_in_universe);
   std::optional<std::any> GetUniqueValueUntyped() const;
+  std::optional<ValueType> GetUniqueValueTyped() const;
+  bool IsKnownUnsatisfiable() const;
   std::vector<std::string> GetDependencies() const;
 
  private:
@@ -889,44 +1460,61 @@ template <typename V, typename G>
 std::string MVariable<V, G>::ToString() const {
   if (!overall_status_.ok()) return overall_status_.ToString();
   std::string result = Typename();
-  if (is_one_of_) {
+  if (const std::optional<std::vector<G>>& is_one_of = is_one_of_.Get()) {
     absl::StrAppend(&result,
                     absl::Substitute("; $0 option(s) from Is()/IsOneOf()",
-                                     is_one_of_->size()));
-    if (!is_one_of_->empty() &&
+                                     is_one_of->size()));
+    if (!is_one_of->empty() &&
         !absl::IsUnimplemented(
-            ValueToStringImpl(is_one_of_->front()).status())) {
+            ValueToStringImpl(is_one_of->front()).status())) {
       bool first = true;
-      for (const G& value : *is_one_of_) {
+      for (const G& value : *is_one_of) {
         absl::StrAppend(&result, (first ? ": " : ", "),
                         ValueToStringImpl(value).value_or("[ToString error]"));
         first = false;
       }
+    } else if constexpr (moriarty_internal::IsBinaryEncodable<G>()) {
+      // Without a readable form, the encoded options still distinguish two
+      // variables with different options.
+      if (!is_one_of->empty()) {
+        std::string encoded;
+        for (const G& value : *is_one_of)
+          moriarty_internal::EncodeValue(value, encoded);
+        absl::StrAppend(&result, ": encoded ",
+                        absl::BytesToHexString(encoded));
+      }
     }
   }
+  for (const CustomConstraint& constraint : custom_constraints_.Get())
+    absl::StrAppend(&result, "; custom constraint: ", constraint.name);
 
   return absl::StrCat(result, "; ", ToStringImpl());
 }
 
 template <typename V, typename G>
 V& MVariable<V, G>::Is(G value) {
-  return IsOneOf({std::move(value)});
+  // Not `IsOneOf({std::move(value)})`, which would copy `value` out of the
+  // `std::initializer_list`.
+  std::vector<G> values;
+  values.push_back(std::move(value));
+  return IsOneOf(std::move(values));
 }
 
 template <typename V, typename G>
 V& MVariable<V, G>::IsOneOf(std::vector<G> values) {
   std::sort(values.begin(), values.end());
 
-  if (!is_one_of_) {
-    is_one_of_ = std::move(values);
+  std::optional<std::vector<G>>& is_one_of = is_one_of_.Mutable();
+  if (!is_one_of) {
+    is_one_of = std::move(values);
     return UnderlyingVariableType();
   }
 
-  is_one_of_->erase(
+  is_one_of->erase(
       std::set_intersection(std::begin(values), std::end(values),
-                            std::begin(*is_one_of_), std::end(*is_one_of_),
-                            std::begin(*is_one_of_)),
-      std::end(*is_one_of_));
+                            std::begin(*is_one_of), std::end(*is_one_of),
+                            std::begin(*is_one_of)),
+      std::end(*is_one_of));
   return UnderlyingVariableType();
 }
 
@@ -943,7 +1531,7 @@ absl::Status MVariable<V, G>::TryMergeFrom(const V& other) {
   if (!other.overall_status_.ok()) overall_status_ = other.overall_status_;
   MORIARTY_RETURN_IF_ERROR(overall_status_);
 
-  if (other.is_one_of_) IsOneOf(*other.is_one_of_);
+  if (other.is_one_of_.Get()) IsOneOf(*other.is_one_of_.Get());
   MORIARTY_RETURN_IF_ERROR(MergeFromImpl(other));
 
   // The merge may have caused a new error to occur.
@@ -965,12 +1553,13 @@ V& MVariable<V, G>::AddCustomConstraint(
   CustomConstraint c;
   c.name = constraint_name;
   c.checker = checker;
-  custom_constraints_deps_.insert(custom_constraints_deps_.end(),
-                                  std::make_move_iterator(deps.begin()),
-                                  std::make_move_iterator(deps.end()));
+  std::vector<std::string>& all_deps = custom_constraints_deps_.Mutable();
+  all_deps.insert(all_deps.end(), std::make_move_iterator(deps.begin()),
+                  std::make_move_iterator(deps.end()));
   // Sort the dependencies so the order of the generation is consistent.
-  absl::c_sort(custom_constraints_deps_);
-  custom_constraints_.push_back(c);
+  absl::c_sort(all_deps);
+  custom_constraints_.Mutable().push_back(c);
+  enumeration_cache_ = std::make_shared<EnumerationCache>();
   return UnderlyingVariableType();
 }
 
@@ -987,8 +1576,8 @@ V& MVariable<V, G>::WithKnownProperty(Property property) {
 template <typename V, typename G>
 absl::Status MVariable<V, G>::TryWithKnownProperty(Property property) {
   MORIARTY_RETURN_IF_ERROR(overall_status_);
-  auto it = known_property_categories_.find(property.category);
-  if (it == known_property_categories_.end()) {
+  auto it = known_property_categories_.Get().find(property.category);
+  if (it == known_property_categories_.Get().end()) {
     if (property.enforcement == Property::Enforcement::kIgnoreIfUnknown)
       return absl::OkStatus();
 
@@ -1053,17 +1642,50 @@ absl::StatusOr<Subvalues> MVariable<V, G>::GetSubvaluesImpl(
       absl::StrCat("GetSubvalues() not implemented for ", Typename()));
 }
 
+template <typename V, typename G>
+absl::StatusOr<Subvalues> MVariable<V, G>::GetSubvalueImpl(
+    const G& value, absl::string_view subvalue_name) const {
+  return GetSubvaluesImpl(value);
+}
+
 template <typename V, typename G>
 absl::StatusOr<std::vector<V>> MVariable<V, G>::GetDifficultInstancesImpl()
     const {
   return std::vector<V>();  // By default, return an empty list.
 }
 
+template <typename V, typename G>
+std::optional<G> MVariable<V, G>::ShrinkImpl(const G& value, int level,
+                                             int64_t index) const {
+  return std::nullopt;  // By default, there are no smaller versions.
+}
+
 template <typename V, typename G>
 std::optional<G> MVariable<V, G>::GetUniqueValueImpl() const {
   return std::nullopt;  // By default, return no unique value.
 }
 
+template <typename V, typename G>
+std::shared_ptr<const std::vector<G>> MVariable<V, G>::EnumerateImpl(
+    int64_t max_values) const {
+  return nullptr;  // By default, the values are not known.
+}
+
+template <typename V, typename G>
+bool MVariable<V, G>::IsKnownUnsatisfiableImpl() const {
+  return false;  // By default, nothing is known.
+}
+
+template <typename V, typename G>
+const Range* MVariable<V, G>::GetIntegerBoundsImpl() const {
+  return nullptr;  // By default, this is not an integer.
+}
+
+template <typename V, typename G>
+void MVariable<V, G>::TightenIntegerBoundsImpl(const Range& bounds) {
+  // By default, there are no integer bounds to tighten.
+}
+
 template <typename V, typename G>
 std::string MVariable<V, G>::ToStringImpl() const {
   return absl::Substitute("[No custom ToString() for $0]", Typename());
@@ -1076,10 +1698,45 @@ absl::StatusOr<std::string> MVariable<V, G>::ValueToStringImpl(
       absl::StrCat("ValueToString() not implemented for ", Typename()));
 }
 
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateInBulkImpl(int n) {
+  return std::nullopt;  // By default, values are generated one at a time.
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateDistinctInBulkImpl(int n) {
+  return std::nullopt;  // By default, duplicates are rejected one at a time.
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateSortedInBulkImpl(int n, bool strictly_increasing) {
+  return std::nullopt;  // By default, values are sorted after generation.
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateInBulkWithSumImpl(int n, int64_t sum) {
+  return std::nullopt;  // By default, the sum is checked after generation.
+}
+
+template <typename V, typename G>
+bool MVariable<V, G>::AllSatisfiedWithImpl(absl::Span<const G> values) const {
+  return false;  // By default, values are checked one at a time.
+}
+
+template <typename V, typename G>
+absl::Status MVariable<V, G>::IsSatisfiedWithGeneratedImpl(
+    const G& value) const {
+  return IsSatisfiedWithImpl(value);
+}
+
 template <typename V, typename G>
 void MVariable<V, G>::RegisterKnownProperty(
     absl::string_view property_category, PropertyCallbackFunction property_fn) {
-  known_property_categories_[property_category] = property_fn;
+  known_property_categories_.Mutable()[property_category] = property_fn;
 }
 
 template <typename V, typename G>
@@ -1099,6 +1756,192 @@ absl::StatusOr<typename T::value_type> MVariable<V, G>::Random(
   return moriarty_internal::MVariableManager(&m).Generate();
 }
 
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+MVariable<V, G>::RandomInBulk(absl::string_view debug_name, T m, int n) {
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "RandomInBulk",
+                              InternalConfigurationType::kUniverse);
+  }
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_,
+      /* my_name_in_universe = */ moriarty_internal::ConstructVariableName(
+          variable_name_inside_universe_, debug_name));
+  return moriarty_internal::MVariableManager(&m).GenerateInBulk(n);
+}
+
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+std::optional<typename T::value_type> MVariable<V, G>::RandomInPlace(T& m) {
+  if (!universe_) return std::nullopt;  // Let `Random()` report the error.
+
+  moriarty_internal::MVariableManager manager(&m);
+  manager.SetUniverse(universe_, variable_name_inside_universe_);
+  return manager.GenerateDirectly();
+}
+
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+MVariable<V, G>::RandomDistinctInBulk(absl::string_view debug_name, T m,
+                                      int n) {
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "RandomDistinctInBulk",
+                              InternalConfigurationType::kUniverse);
+  }
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_,
+      /* my_name_in_universe = */ moriarty_internal::ConstructVariableName(
+          variable_name_inside_universe_, debug_name));
+  return moriarty_internal::MVariableManager(&m).GenerateDistinctInBulk(n);
+}
+
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+MVariable<V, G>::RandomSortedInBulk(absl::string_view debug_name, T m, int n,
+                                    bool strictly_increasing) {
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "RandomSortedInBulk",
+                              InternalConfigurationType::kUniverse);
+  }
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_,
+      /* my_name_in_universe = */ moriarty_internal::ConstructVariableName(
+          variable_name_inside_universe_, debug_name));
+  return moriarty_internal::MVariableManager(&m).GenerateSortedInBulk(
+      n, strictly_increasing);
+}
+
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+MVariable<V, G>::RandomInBulkWithSum(absl::string_view debug_name, T m, int n,
+                                     int64_t sum) {
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "RandomInBulkWithSum",
+                              InternalConfigurationType::kUniverse);
+  }
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_,
+      /* my_name_in_universe = */ moriarty_internal::ConstructVariableName(
+          variable_name_inside_universe_, debug_name));
+  return moriarty_internal::MVariableManager(&m).GenerateInBulkWithSum(n, sum);
+}
+
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::optional<std::vector<typename T::value_type>>>
+MVariable<V, G>::RandomInParallel(absl::string_view debug_name, T m, int n) {
+  using ElementType = typename T::value_type;
+  constexpr int kChunkSize =
+      moriarty_internal::GenerationConfig::kParallelGenerationChunkSize;
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "RandomInParallel",
+                              InternalConfigurationType::kUniverse);
+  }
+  moriarty_internal::GenerationConfig* generation_config =
+      universe_->GetGenerationConfig();
+  if (!generation_config) {
+    return MisconfiguredError(Typename(), "RandomInParallel",
+                              InternalConfigurationType::kGenerationConfig);
+  }
+  moriarty_internal::RandomEngine* rng = universe_->GetRandomEngine();
+  if (!rng) {
+    return MisconfiguredError(Typename(), "RandomInParallel",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  if (n <= kChunkSize) return std::nullopt;
+  // Splitting changes the values, so only the counter-based engine (whose
+  // splits are O(1)) generates in chunks. Older seeds keep their values.
+  if (!rng->IsCounterBased()) return std::nullopt;
+  if (!moriarty_internal::MVariableManager(&m).GetDependencies().empty())
+    return std::nullopt;
+
+  int num_chunks = (n + kChunkSize - 1) / kChunkSize;
+  std::vector<moriarty_internal::RandomEngine> engines;
+  engines.reserve(num_chunks);
+  for (int i = 0; i < num_chunks; i++) engines.push_back(rng->Split());
+
+  const std::string name = moriarty_internal::ConstructVariableName(
+      variable_name_inside_universe_, debug_name);
+  std::optional<int64_t> soft_generation_limit =
+      generation_config->GetSoftGenerationLimit();
+  moriarty_internal::GenerationBudget* budget = generation_config->GetBudget();
+
+  std::vector<std::vector<ElementType>> chunks(num_chunks);
+  std::vector<absl::Status> statuses(num_chunks);
+  std::vector<moriarty_internal::GenerationProfile> profiles(
+      generation_config->GetProfile() ? num_chunks : 0);
+  auto generate_chunk = [&](int chunk) -> absl::Status {
+    // Elements have no dependencies, so each chunk only needs its own engine
+    // and bookkeeping. Values created while generating an element (and
+    // erased on retries) go to the chunk's own context.
+    moriarty_internal::GenerationConfig chunk_config;
+    if (soft_generation_limit)
+      chunk_config.SetSoftGenerationLimit(*soft_generation_limit);
+    if (!profiles.empty()) chunk_config.SetProfile(&profiles[chunk]);
+    // The whole array is counted towards the byte budget by the caller.
+    chunk_config.SetBudget(budget, /*count_bytes=*/false);
+    moriarty_internal::GenerationContext context(
+        moriarty_internal::VariableSet(), moriarty_internal::ValueSet(),
+        engines[chunk], std::move(chunk_config));
+
+    T element = m;
+    moriarty_internal::MVariableManager(&element).SetUniverse(
+        &context.GetUniverse(), name);
+
+    int begin = chunk * kChunkSize;
+    int end = std::min(n, begin + kChunkSize);
+    chunks[chunk].reserve(end - begin);
+    for (int i = begin; i < end; i++) {
+      MORIARTY_ASSIGN_OR_RETURN(
+          ElementType value,
+          moriarty_internal::MVariableManager(&element).Generate());
+      chunks[chunk].push_back(std::move(value));
+    }
+    return absl::OkStatus();
+  };
+
+  moriarty_internal::Scheduler* scheduler = generation_config->GetScheduler();
+  if (scheduler == nullptr || scheduler->NumThreads() == 1) {
+    for (int chunk = 0; chunk < num_chunks; chunk++)
+      MORIARTY_RETURN_IF_ERROR(generate_chunk(chunk));
+  } else {
+    // Each chunk's engine was split off above, so the values do not depend on
+    // which thread generates which chunk.
+    scheduler->ParallelFor(num_chunks, [&](int chunk) {
+      statuses[chunk] = generate_chunk(chunk);
+    });
+
+    // Report the error from the earliest chunk, as the serial version would.
+    for (const absl::Status& status : statuses)
+      MORIARTY_RETURN_IF_ERROR(status);
+  }
+  for (const moriarty_internal::GenerationProfile& profile : profiles)
+    generation_config->MergeProfile(profile);
+
+  std::vector<ElementType> result;
+  result.reserve(n);
+  for (std::vector<ElementType>& chunk : chunks) {
+    std::move(chunk.begin(), chunk.end(), std::back_inserter(result));
+    chunk = std::vector<ElementType>();
+  }
+  return result;
+}
+
 template <typename V, typename G>
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
@@ -1114,6 +1957,65 @@ absl::Status MVariable<V, G>::SatisfiesConstraints(
   return moriarty_internal::MVariableManager(&m).IsSatisfiedWith(value);
 }
 
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+bool MVariable<V, G>::AllSatisfyConstraints(
+    T m, absl::Span<const typename T::value_type> values) const {
+  if (!universe_) return false;
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_, absl::Substitute("SatisfiesConstraints::$0", m.Typename()));
+  return moriarty_internal::MVariableManager(&m).AllSatisfiedWith(values);
+}
+
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+std::optional<int64_t> MVariable<V, G>::FindFirstUnsatisfied(
+    T m, absl::Span<const typename T::value_type> values) const {
+  constexpr int kChunkSize =
+      moriarty_internal::Universe::kParallelValidationChunkSize;
+  if (values.empty()) return std::nullopt;
+  // Every value fails with a misconfiguration error.
+  if (!universe_) return 0;
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_, absl::Substitute("SatisfiesConstraints::$0", m.Typename()));
+  moriarty_internal::MVariableManager manager(&m);
+  auto find_in_range = [&](int64_t begin,
+                           int64_t end) -> std::optional<int64_t> {
+    if (manager.AllSatisfiedWith(values.subspan(begin, end - begin)))
+      return std::nullopt;
+    for (int64_t i = begin; i < end; i++)
+      if (!manager.IsSatisfiedWith(values[i]).ok()) return i;
+    return std::nullopt;
+  };
+
+  int64_t n = values.size();
+  moriarty_internal::Scheduler* scheduler = GetScheduler();
+  if (scheduler == nullptr || scheduler->NumThreads() == 1 || n <= kChunkSize)
+    return find_in_range(0, n);
+
+  // Chunks after the earliest failing chunk found so far are skipped, so the
+  // result is always the first failure, as in the serial version.
+  int num_chunks = (n + kChunkSize - 1) / kChunkSize;
+  std::atomic<int64_t> first_failure = n;
+  scheduler->ParallelFor(num_chunks, [&](int chunk) {
+    int64_t begin = static_cast<int64_t>(chunk) * kChunkSize;
+    if (begin > first_failure.load()) return;
+    std::optional<int64_t> failure =
+        find_in_range(begin, std::min(n, begin + kChunkSize));
+    if (!failure) return;
+    int64_t current = first_failure.load();
+    while (*failure < current &&
+           !first_failure.compare_exchange_weak(current, *failure)) {
+    }
+  });
+  if (first_failure.load() == n) return std::nullopt;
+  return first_failure.load();
+}
+
 template <typename V, typename G>
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
@@ -1208,6 +2110,20 @@ std::optional<typename T::value_type> MVariable<V, G>::GetUniqueValue(
   return *typed_value;
 }
 
+template <typename V, typename G>
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+bool MVariable<V, G>::IsKnownUnsatisfiable(absl::string_view debug_name,
+                                           T m) const {
+  if (!universe_) return false;
+
+  moriarty_internal::MVariableManager(&m).SetUniverse(
+      universe_,
+      /* my_name_in_universe = */ moriarty_internal::ConstructVariableName(
+          variable_name_inside_universe_, debug_name));
+  return moriarty_internal::MVariableManager(&m).IsKnownUnsatisfiable();
+}
+
 template <typename V, typename G>
 absl::StatusOr<int64_t> MVariable<V, G>::RandomInteger(int64_t min,
                                                        int64_t max) {
@@ -1396,6 +2312,12 @@ absl::StatusOr<absl::Nonnull<IOConfig*>> MVariable<V, G>::GetIOConfig() {
   return universe_->GetIOConfig();
 }
 
+template <typename V, typename G>
+moriarty_internal::Scheduler* MVariable<V, G>::GetScheduler() const {
+  if (!universe_) return nullptr;
+  return universe_->GetScheduler();
+}
+
 template <typename V, typename G>
 std::optional<int64_t> MVariable<V, G>::GetApproximateGenerationLimit() const {
   if (!universe_) return std::nullopt;
@@ -1404,6 +2326,13 @@ std::optional<int64_t> MVariable<V, G>::GetApproximateGenerationLimit() const {
   return universe_->GetGenerationConfig()->GetSoftGenerationLimit();
 }
 
+template <typename V, typename G>
+moriarty_internal::ScopedSoftGenerationLimit
+MVariable<V, G>::LowerApproximateGenerationLimit(int64_t limit) {
+  return moriarty_internal::ScopedSoftGenerationLimit(
+      universe_ ? universe_->GetGenerationConfig() : nullptr, limit);
+}
+
 template <typename V, typename G>
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
@@ -1423,6 +2352,7 @@ void MVariable<V, G>::DeclareSelfAsInvalid(absl::Status status) {
 
 template <typename V, typename G>
 absl::StatusOr<G> MVariable<V, G>::Generate() {
+  MORIARTY_TRACE_SPAN("MVariable::Generate");
   MORIARTY_RETURN_IF_ERROR(overall_status_);
   if (!universe_) {
     return MisconfiguredError(Typename(), "Generate",
@@ -1437,7 +2367,7 @@ absl::StatusOr<G> MVariable<V, G>::Generate() {
                               InternalConfigurationType::kRandomEngine);
   }
 
-  if (is_one_of_ && is_one_of_->empty())
+  if (is_one_of_.Get() && is_one_of_.Get()->empty())
     return absl::FailedPreconditionError(
         "Is/IsOneOf used, but no viable value found.");
 
@@ -1447,11 +2377,34 @@ absl::StatusOr<G> MVariable<V, G>::Generate() {
   MORIARTY_RETURN_IF_ERROR(
       generation_config.MarkStartGeneration(variable_name_inside_universe_));
 
+  using Rejection = moriarty_internal::GenerationProfile::Rejection;
+  std::vector<CustomConstraintsDep> deps(custom_constraints_deps_.Get().size());
+  // Only rejections in this call are counted, so the values generated do not
+  // depend on what other copies of this variable have cached.
+  int custom_constraint_rejections = 0;
+  bool no_candidates = false;
   while (true) {
-    absl::StatusOr<G> value = GenerateOnce();
+    Rejection rejection;
+    absl::StatusOr<G> value = GenerateOnce(rejection, deps);
+    if (!value.ok() && rejection == Rejection::kCustomConstraint &&
+        ++custom_constraint_rejections ==
+            moriarty_internal::GenerationConfig::kRejectionsBeforeEnumerating) {
+      // The custom constraints reject most values. If there are few enough
+      // values, sample from those that satisfy them instead.
+      std::shared_ptr<const std::vector<G>> candidates = EnumerateCandidates();
+      if (candidates && candidates->empty()) no_candidates = true;
+      if (candidates && !candidates->empty())
+        value = RandomElement(*candidates);
+    }
     if (value.ok()) {
       MORIARTY_RETURN_IF_ERROR(generation_config.MarkSuccessfulGeneration(
-          variable_name_inside_universe_));
+          variable_name_inside_universe_,
+          generation_config.ShouldComputeGeneratedBytes()
+              ? V::ValueByteSize(*value)
+              : 0,
+          generation_config.GetProfile()
+              ? moriarty_internal::AllocatedByteSize(*value)
+              : 0));
       return value;
     }
 
@@ -1461,21 +2414,28 @@ absl::StatusOr<G> MVariable<V, G>::Generate() {
         moriarty_internal::GenerationConfig::RetryRecommendation
             retry_recommendation,
         generation_config.AddGenerationFailure(variable_name_inside_universe_,
-                                               value.status()));
+                                               value.status(), rejection));
 
     for (absl::string_view variable_name :
          retry_recommendation.variable_names_to_delete) {
       MORIARTY_RETURN_IF_ERROR(universe_->EraseValue(variable_name));
     }
+    // Erased values may include the dependencies, so they are re-assigned on
+    // the next attempt (a no-op for those that are still known).
+    if (!retry_recommendation.variable_names_to_delete.empty()) {
+      for (CustomConstraintsDep& dep : deps) dep.assigned = false;
+    }
 
-    if (retry_recommendation.policy ==
-        moriarty_internal::GenerationConfig::RetryRecommendation::kAbort) {
+    if (no_candidates ||
+        retry_recommendation.policy ==
+            moriarty_internal::GenerationConfig::RetryRecommendation::kAbort) {
       break;
     }
   }
 
   MORIARTY_RETURN_IF_ERROR(generation_config.MarkAbandonedGeneration(
       variable_name_inside_universe_));
+  MORIARTY_RETURN_IF_ERROR(generation_config.GetBudgetStatus());
 
   return absl::FailedPreconditionError(absl::Substitute(
       "Error generating '$0' (even with retries). One such error: $1",
@@ -1484,6 +2444,118 @@ absl::StatusOr<G> MVariable<V, G>::Generate() {
           .ToString()));
 }
 
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>> MVariable<V, G>::GenerateInBulk(
+    int n) {
+  // Let `Generate()` deal with errors.
+  if (!overall_status_.ok()) return std::nullopt;
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "GenerateInBulk",
+                              InternalConfigurationType::kUniverse);
+  }
+  if (!universe_->GetRandomEngine()) {
+    return MisconfiguredError(Typename(), "GenerateInBulk",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  // These may reject values, so each value must go through `Generate()`.
+  if (is_one_of_.Get() || !custom_constraints_.Get().empty())
+    return std::nullopt;
+
+  return GenerateInBulkImpl(n);
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateDistinctInBulk(int n) {
+  // Let `Generate()` deal with errors.
+  if (!overall_status_.ok()) return std::nullopt;
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "GenerateDistinctInBulk",
+                              InternalConfigurationType::kUniverse);
+  }
+  if (!universe_->GetRandomEngine()) {
+    return MisconfiguredError(Typename(), "GenerateDistinctInBulk",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  // These may reject values, so each value must go through `Generate()`.
+  if (is_one_of_.Get() || !custom_constraints_.Get().empty())
+    return std::nullopt;
+
+  return GenerateDistinctInBulkImpl(n);
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateSortedInBulk(int n, bool strictly_increasing) {
+  // Let `Generate()` deal with errors.
+  if (!overall_status_.ok()) return std::nullopt;
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "GenerateSortedInBulk",
+                              InternalConfigurationType::kUniverse);
+  }
+  if (!universe_->GetRandomEngine()) {
+    return MisconfiguredError(Typename(), "GenerateSortedInBulk",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  // These may reject values, so each value must go through `Generate()`.
+  if (is_one_of_.Get() || !custom_constraints_.Get().empty())
+    return std::nullopt;
+
+  return GenerateSortedInBulkImpl(n, strictly_increasing);
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<std::vector<G>>>
+MVariable<V, G>::GenerateInBulkWithSum(int n, int64_t sum) {
+  // Let `Generate()` deal with errors.
+  if (!overall_status_.ok()) return std::nullopt;
+  if (!universe_) {
+    return MisconfiguredError(Typename(), "GenerateInBulkWithSum",
+                              InternalConfigurationType::kUniverse);
+  }
+  if (!universe_->GetRandomEngine()) {
+    return MisconfiguredError(Typename(), "GenerateInBulkWithSum",
+                              InternalConfigurationType::kRandomEngine);
+  }
+
+  // These may reject values, so each value must go through `Generate()`.
+  if (is_one_of_.Get() || !custom_constraints_.Get().empty())
+    return std::nullopt;
+
+  return GenerateInBulkWithSumImpl(n, sum);
+}
+
+template <typename V, typename G>
+std::optional<G> MVariable<V, G>::GenerateDirectly() {
+  // Let `Generate()` deal with errors.
+  if (!overall_status_.ok() || !universe_ || !universe_->GetRandomEngine())
+    return std::nullopt;
+
+  // These may reject values or need other variables to be generated first, so
+  // the value must go through `Generate()`.
+  if (is_one_of_.Get() || !custom_constraints_.Get().empty() ||
+      !GetDependenciesImpl().empty()) {
+    return std::nullopt;
+  }
+
+  absl::StatusOr<G> value = GenerateImpl();
+  if (!value.ok()) return std::nullopt;
+  return *std::move(value);
+}
+
+template <typename V, typename G>
+bool MVariable<V, G>::AllSatisfiedWith(absl::Span<const G> values) const {
+  if (!overall_status_.ok() || !universe_) return false;
+
+  // These need to look at each value individually.
+  if (is_one_of_.Get() || !custom_constraints_.Get().empty()) return false;
+
+  return AllSatisfiedWithImpl(values);
+}
+
 template <typename V, typename G>
 absl::Status MVariable<V, G>::IsSatisfiedWith(const G& value) const {
   MORIARTY_RETURN_IF_ERROR(overall_status_);
@@ -1492,21 +2564,34 @@ absl::Status MVariable<V, G>::IsSatisfiedWith(const G& value) const {
                               InternalConfigurationType::kUniverse);
   }
 
-  if (is_one_of_) {
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithBuiltInConstraints(value));
+  return IsSatisfiedWithCustomConstraints(value);
+}
+
+template <typename V, typename G>
+absl::Status MVariable<V, G>::IsSatisfiedWithBuiltInConstraints(
+    const G& value, bool generated_by_impl) const {
+  if (is_one_of_.Get()) {
     MORIARTY_RETURN_IF_ERROR(CheckConstraint(
-        absl::c_binary_search(*is_one_of_, value),
+        absl::c_binary_search(*is_one_of_.Get(), value),
         "`value` must be one of the options in Is() and IsOneOf()"));
   }
 
-  absl::Status status = IsSatisfiedWithImpl(value);
+  absl::Status status = generated_by_impl ? IsSatisfiedWithGeneratedImpl(value)
+                                          : IsSatisfiedWithImpl(value);
   if (!status.ok()) {
     if (IsVariableNotFoundError(status) || IsValueNotFoundError(status))
       return UnsatisfiedConstraintError(status.message());
     return status;
   }
+  return absl::OkStatus();
+}
 
+template <typename V, typename G>
+absl::Status MVariable<V, G>::IsSatisfiedWithCustomConstraints(
+    const G& value) const {
   ConstraintValues cv(universe_);
-  for (const auto& [checker_name, checker] : custom_constraints_) {
+  for (const auto& [checker_name, checker] : custom_constraints_.Get()) {
     MORIARTY_RETURN_IF_ERROR(CheckConstraint(
         checker(value, cv),
         absl::Substitute("Custom constraint '$0' not satisfied.",
@@ -1516,10 +2601,45 @@ absl::Status MVariable<V, G>::IsSatisfiedWith(const G& value) const {
   return absl::OkStatus();
 }
 
+template <typename V, typename G>
+std::shared_ptr<const std::vector<G>> MVariable<V, G>::EnumerateCandidates()
+    const {
+  if (is_one_of_.Get() || !custom_constraints_deps_.Get().empty())
+    return nullptr;
+  std::shared_ptr<const std::vector<G>> domain =
+      EnumerateImpl(moriarty_internal::GenerationConfig::kMaxEnumeratedValues);
+  if (!domain) return nullptr;
+
+  EnumerationCache& cache = *enumeration_cache_;
+  {
+    absl::MutexLock lock(&cache.mutex);
+    if (cache.domain == domain) return cache.candidates;
+  }
+
+  ConstraintValues cv(universe_);
+  auto candidates = std::make_shared<std::vector<G>>();
+  for (const G& value : *domain) {
+    if (absl::c_all_of(custom_constraints_.Get(),
+                       [&](const CustomConstraint& constraint) {
+                         return constraint.checker(value, cv);
+                       })) {
+      candidates->push_back(value);
+    }
+  }
+
+  absl::MutexLock lock(&cache.mutex);
+  cache.domain = std::move(domain);
+  cache.candidates = std::move(candidates);
+  return cache.candidates;
+}
+
 template <typename V, typename G>
 absl::Status MVariable<V, G>::MergeFrom(
     const moriarty_internal::AbstractVariable& other) {
-  const V* const other_derived_class = dynamic_cast<const V* const>(&other);
+  const V* const other_derived_class =
+      other.TypeId() == moriarty_internal::TypeIdOf<V>()
+          ? static_cast<const V*>(&other)
+          : dynamic_cast<const V*>(&other);
 
   if (other_derived_class == nullptr)
     return absl::InvalidArgumentError(
@@ -1544,13 +2664,21 @@ template <typename V, typename G>
 absl::StatusOr<std::any> MVariable<V, G>::GetSubvalue(
     const std::any& my_value, absl::string_view subvalue_name) const {
   MORIARTY_RETURN_IF_ERROR(overall_status_);
-  const G val = std::any_cast<const G>(my_value);
-  MORIARTY_ASSIGN_OR_RETURN(Subvalues subvalues, GetSubvaluesImpl(val));
+  // Avoid copying the (possibly large) value just to extract a piece.
+  const G* val = std::any_cast<const G>(&my_value);
+  if (val == nullptr) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "GetSubvalue() called on $0 with a value of the wrong type",
+        Typename()));
+  }
+  // Only compute the subvalue that was asked for (e.g., "length" for
+  // "length.x").
+  absl::string_view name = moriarty_internal::BaseVariableName(subvalue_name);
+  MORIARTY_ASSIGN_OR_RETURN(Subvalues subvalues, GetSubvalueImpl(*val, name));
 
   MORIARTY_ASSIGN_OR_RETURN(
       const moriarty_internal::VariableValue* subvalue,
-      moriarty_internal::SubvaluesManager(&subvalues)
-          .GetSubvalue(moriarty_internal::BaseVariableName(subvalue_name)));
+      moriarty_internal::SubvaluesManager(&subvalues).GetSubvalue(name));
 
   if (!moriarty_internal::HasSubvariable(subvalue_name)) return subvalue->value;
 
@@ -1600,24 +2728,41 @@ absl::Status MVariable<V, G>::WithProperty(Property property) {
 }
 
 template <typename V, typename G>
-absl::StatusOr<G> MVariable<V, G>::GenerateOnce() {
+absl::StatusOr<G> MVariable<V, G>::GenerateOnce(
+    moriarty_internal::GenerationProfile::Rejection& rejection,
+    std::vector<CustomConstraintsDep>& deps) {
+  rejection = moriarty_internal::GenerationProfile::Rejection::kError;
   MORIARTY_RETURN_IF_ERROR(overall_status_);
+  // Values from Is()/IsOneOf() may not satisfy the other constraints.
+  const bool generated_by_impl = !is_one_of_.Get();
   MORIARTY_ASSIGN_OR_RETURN(G potential_value, [this]() -> absl::StatusOr<G> {
-    if (is_one_of_) {
-      return RandomElement(*is_one_of_);
+    if (is_one_of_.Get()) {
+      return RandomElement(*is_one_of_.Get());
     }
     return GenerateImpl();
   }());
 
-  // Generate dependent variables used in custom constraints.
-  for (const std::string& dep : custom_constraints_deps_) {
-    MORIARTY_ASSIGN_OR_RETURN(AbstractVariable * var,
-                              universe_->GetAbstractVariable(dep));
-    MORIARTY_RETURN_IF_ERROR(var->AssignValue());
+  // Generate dependent variables used in custom constraints. Those assigned by
+  // a previous attempt are skipped.
+  const std::vector<std::string>& dep_names = custom_constraints_deps_.Get();
+  for (int i = 0; i < dep_names.size(); i++) {
+    CustomConstraintsDep& dep = deps[i];
+    if (dep.assigned) continue;
+    if (!dep.variable) {
+      MORIARTY_ASSIGN_OR_RETURN(dep.variable,
+                                universe_->GetAbstractVariable(dep_names[i]));
+    }
+    MORIARTY_RETURN_IF_ERROR(dep.variable->AssignValue());
+    dep.assigned = true;
   }
 
-  absl::Status satisfies = IsSatisfiedWith(potential_value);
-  if (!satisfies.ok()) return satisfies;
+  using Rejection = moriarty_internal::GenerationProfile::Rejection;
+  rejection = Rejection::kConstraint;
+  MORIARTY_RETURN_IF_ERROR(
+      IsSatisfiedWithBuiltInConstraints(potential_value, generated_by_impl));
+
+  rejection = Rejection::kCustomConstraint;
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithCustomConstraints(potential_value));
 
   return potential_value;
 }
@@ -1634,7 +2779,8 @@ absl::Status MVariable<V, G>::AssignValue() {
     return absl::OkStatus();
 
   MORIARTY_ASSIGN_OR_RETURN(G value, Generate());
-  return universe_->SetValue<V>(variable_name_inside_universe_, value);
+  return universe_->SetValue<V>(variable_name_inside_universe_,
+                                std::move(value));
 }
 
 template <typename V, typename G>
@@ -1648,34 +2794,73 @@ absl::Status MVariable<V, G>::AssignUniqueValue() {
   if (universe_->ValueIsKnown(variable_name_inside_universe_))
     return absl::OkStatus();
 
-  std::optional<std::any> value = GetUniqueValueUntyped();
+  std::optional<G> value = GetUniqueValueTyped();
 
   if (!value) return absl::OkStatus();
 
-  G* typed_value = std::any_cast<G>(&(*value));
-  if (typed_value == nullptr) {
-    // This should not happen. It means the MVariable is returning the
-    // wrong type from GetUniqueValueUntyped(). It must be exactly the right
-    // type.
-    return absl::InternalError(
-        "Unable to cast value from GetUniqueValueUntyped to the correct type.");
-  }
-
-  return universe_->SetValue<V>(variable_name_inside_universe_, *typed_value);
+  return universe_->SetValue<V>(variable_name_inside_universe_,
+                                *std::move(value));
 }
 
 template <typename V, typename G>
 std::optional<std::any> MVariable<V, G>::GetUniqueValueUntyped() const {
+  // Casting std::optional<G> to std::optional<std::any>.
+  std::optional<G> value = GetUniqueValueTyped();
+  if (!value) return std::nullopt;
+  return *std::move(value);
+}
+
+template <typename V, typename G>
+std::optional<G> MVariable<V, G>::GetUniqueValueTyped() const {
   if (!overall_status_.ok()) return std::nullopt;
-  if (is_one_of_) {
-    if (is_one_of_->size() == 1) return is_one_of_->at(0);
+  if (is_one_of_.Get()) {
+    if (is_one_of_.Get()->size() == 1) return is_one_of_.Get()->at(0);
     return std::nullopt;  // Not sure which one is correct.
   }
+  return GetUniqueValueImpl();
+}
 
-  // Casting std::optional<G> to std::optional<std::any>.
-  std::optional<G> value = GetUniqueValueImpl();
-  if (!value) return std::nullopt;
-  return *value;
+template <typename V, typename G>
+bool MVariable<V, G>::IsKnownUnsatisfiable() const {
+  if (!overall_status_.ok()) return true;
+  if (IsKnownUnsatisfiableImpl()) return true;
+
+  const std::optional<std::vector<G>>& options = is_one_of_.Get();
+  if (!options) return false;
+  if (options->empty()) return true;
+
+  // Once every dependency is known, an option failing the built-in checks
+  // really violates them (rather than missing a value).
+  if (!universe_) return false;
+  for (const std::string& dependency : GetDependenciesImpl())
+    if (!universe_->ValueIsKnown(dependency)) return false;
+  return absl::c_none_of(*options, [this](const G& option) {
+    return IsSatisfiedWithImpl(option).ok();
+  });
+}
+
+template <typename V, typename G>
+const Range* MVariable<V, G>::GetIntegerBounds() const {
+  return GetIntegerBoundsImpl();
+}
+
+template <typename V, typename G>
+void MVariable<V, G>::TightenIntegerBounds(const Range& bounds) {
+  TightenIntegerBoundsImpl(bounds);
+}
+
+template <typename V, typename G>
+absl::Status MVariable<V, G>::WithValueInUniverse(
+    absl::FunctionRef<absl::Status(const G&)> fn) const {
+  absl::StatusOr<const G*> stored =
+      universe_->GetValueRef<V>(variable_name_inside_universe_);
+  if (stored.ok()) return fn(**stored);
+
+  // The value may not be stored, but still be known (e.g., a unique value or a
+  // subvalue). `GetValue()` computes it, or returns the appropriate error.
+  MORIARTY_ASSIGN_OR_RETURN(
+      G value, universe_->GetValue<V>(variable_name_inside_universe_));
+  return fn(value);
 }
 
 template <typename V, typename G>
@@ -1686,9 +2871,8 @@ absl::Status MVariable<V, G>::ValueSatisfiesConstraints() const {
                               InternalConfigurationType::kUniverse);
   }
 
-  MORIARTY_ASSIGN_OR_RETURN(
-      G value, universe_->GetValue<V>(variable_name_inside_universe_));
-  return IsSatisfiedWith(value);
+  return WithValueInUniverse(
+      [this](const G& value) { return IsSatisfiedWith(value); });
 }
 
 template <typename V, typename G>
@@ -1714,15 +2898,14 @@ absl::Status MVariable<V, G>::PrintValue() {
                               InternalConfigurationType::kUniverse);
   }
 
-  MORIARTY_ASSIGN_OR_RETURN(
-      G value, universe_->GetValue<V>(variable_name_inside_universe_));
-  return TryPrint(value);
+  return WithValueInUniverse(
+      [this](const G& value) { return TryPrint(value); });
 }
 
 template <typename V, typename G>
 std::vector<std::string> MVariable<V, G>::GetDependencies() {
   std::vector<std::string> this_deps = GetDependenciesImpl();
-  absl::c_copy(custom_constraints_deps_, std::back_inserter(this_deps));
+  absl::c_copy(custom_constraints_deps_.Get(), std::back_inserter(this_deps));
   return this_deps;
 }
 
@@ -1741,6 +2924,60 @@ MVariable<V, G>::GetDifficultAbstractVariables() const {
   return new_vec;
 }
 
+template <typename V, typename G>
+absl::Status MVariable<V, G>::EncodeValue(
+    const moriarty_internal::ValueSet& values, absl::string_view variable_name,
+    std::string& out) const {
+  if constexpr (moriarty_internal::IsBinaryEncodable<G>()) {
+    MORIARTY_ASSIGN_OR_RETURN(const G* value, values.GetRef<V>(variable_name));
+    moriarty_internal::EncodeValue(*value, out);
+    return absl::OkStatus();
+  } else {
+    return absl::UnimplementedError(
+        absl::StrCat("EncodeValue() not implemented for ", Typename()));
+  }
+}
+
+template <typename V, typename G>
+absl::Status MVariable<V, G>::DecodeValue(
+    absl::string_view& in, absl::string_view variable_name,
+    moriarty_internal::ValueSet& values) const {
+  if constexpr (moriarty_internal::IsBinaryEncodable<G>()) {
+    G value;
+    if (!moriarty_internal::DecodeValue(in, value)) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "unable to decode a value of type $0 for `$1`", Typename(),
+          variable_name));
+    }
+    values.Set<V>(variable_name, std::move(value));
+    return absl::OkStatus();
+  } else {
+    return absl::UnimplementedError(
+        absl::StrCat("DecodeValue() not implemented for ", Typename()));
+  }
+}
+
+template <typename V, typename G>
+absl::StatusOr<std::optional<int64_t>> MVariable<V, G>::ShrinkValue(
+    moriarty_internal::ValueSet& values, absl::string_view variable_name,
+    int level, int64_t index) const {
+  MORIARTY_RETURN_IF_ERROR(overall_status_);
+  std::optional<int64_t> num_removed;
+  MORIARTY_RETURN_IF_ERROR(
+      values.Mutate<V>(variable_name, [&](G& value) -> absl::Status {
+        std::optional<G> smaller = ShrinkImpl(value, level, index);
+        if (!smaller) return absl::OkStatus();
+        num_removed = 0;
+        if constexpr (requires { value.size(); }) {
+          num_removed = static_cast<int64_t>(value.size()) -
+                        static_cast<int64_t>(smaller->size());
+        }
+        value = *std::move(smaller);
+        return absl::OkStatus();
+      }));
+  return num_removed;
+}
+
 }  // namespace librarian
 
 namespace moriarty_internal {
@@ -1757,6 +2994,44 @@ MVariableManager<VariableType, ValueType>::Generate() {
   return managed_mvariable_.Generate();
 }
 
+template <typename VariableType, typename ValueType>
+absl::StatusOr<std::optional<std::vector<ValueType>>>
+MVariableManager<VariableType, ValueType>::GenerateInBulk(int n) {
+  return managed_mvariable_.GenerateInBulk(n);
+}
+
+template <typename VariableType, typename ValueType>
+absl::StatusOr<std::optional<std::vector<ValueType>>>
+MVariableManager<VariableType, ValueType>::GenerateDistinctInBulk(int n) {
+  return managed_mvariable_.GenerateDistinctInBulk(n);
+}
+
+template <typename VariableType, typename ValueType>
+absl::StatusOr<std::optional<std::vector<ValueType>>>
+MVariableManager<VariableType, ValueType>::GenerateSortedInBulk(
+    int n, bool strictly_increasing) {
+  return managed_mvariable_.GenerateSortedInBulk(n, strictly_increasing);
+}
+
+template <typename VariableType, typename ValueType>
+absl::StatusOr<std::optional<std::vector<ValueType>>>
+MVariableManager<VariableType, ValueType>::GenerateInBulkWithSum(int n,
+                                                                 int64_t sum) {
+  return managed_mvariable_.GenerateInBulkWithSum(n, sum);
+}
+
+template <typename VariableType, typename ValueType>
+std::optional<ValueType>
+MVariableManager<VariableType, ValueType>::GenerateDirectly() {
+  return managed_mvariable_.GenerateDirectly();
+}
+
+template <typename VariableType, typename ValueType>
+bool MVariableManager<VariableType, ValueType>::AllSatisfiedWith(
+    absl::Span<const ValueType> values) const {
+  return managed_mvariable_.AllSatisfiedWith(values);
+}
+
 template <typename VariableType, typename ValueType>
 absl::Status MVariableManager<VariableType, ValueType>::IsSatisfiedWith(
     const ValueType& value) const {
@@ -1805,6 +3080,17 @@ MVariableManager<VariableType, ValueType>::GetUniqueValueUntyped() const {
   return managed_mvariable_.GetUniqueValueUntyped();
 }
 
+template <typename VariableType, typename ValueType>
+std::optional<ValueType>
+MVariableManager<VariableType, ValueType>::GetUniqueValueTyped() const {
+  return managed_mvariable_.GetUniqueValueTyped();
+}
+
+template <typename VariableType, typename ValueType>
+bool MVariableManager<VariableType, ValueType>::IsKnownUnsatisfiable() const {
+  return managed_mvariable_.IsKnownUnsatisfiable();
+}
+
 template <typename VariableType, typename ValueType>
 std::vector<std::string>
 MVariableManager<VariableType, ValueType>::GetDependencies() const {
@@ -40,6 +40,7 @@
 #include "src/librarian/test_utils.h"
 #include "src/property.h"
 #include "src/testing/mtest_type.h"
+#include "src/testing/mtest_type2.h"
 #include "src/testing/random_test_util.h"
 #include "src/testing/status_test_util.h"
 #include "src/util/test_status_macro/status_testutil.h"
@@ -58,14 +59,18 @@ using ::moriarty_testing::IsMisconfigured;
 using ::moriarty_testing::IsNotSatisfiedWith;
 using ::moriarty_testing::IsSatisfiedWith;
 using ::moriarty_testing::MTestType;
+using ::moriarty_testing::MTestType2;
 using ::moriarty_testing::Print;
 using ::moriarty_testing::Read;
 using ::moriarty_testing::TestType;
+using ::moriarty_testing::TestType2;
 using ::testing::AllOf;
 using ::testing::AnyOf;
 using ::testing::AnyWith;
 using ::testing::Contains;
+using ::testing::Ge;
 using ::testing::HasSubstr;
+using ::testing::Le;
 using ::testing::Optional;
 using ::testing::SizeIs;
 using ::testing::Truly;
@@ -199,6 +204,39 @@ TEST(MVariableTest, MergeFromUsingAbstractVariablesShouldRespectIsAndIsOneOf) {
   }
 }
 
+TEST(MVariableTest, TypeIdShouldIdentifyTheMostDerivedVariableType) {
+  MTestType test_type;
+  moriarty::MInteger integer;
+
+  EXPECT_EQ(test_type.TypeId(), moriarty_internal::TypeIdOf<MTestType>());
+  EXPECT_EQ(integer.TypeId(),
+            moriarty_internal::TypeIdOf<moriarty::MInteger>());
+  EXPECT_NE(test_type.TypeId(), integer.TypeId());
+  EXPECT_EQ(MTestType(test_type).TypeId(), test_type.TypeId());
+}
+
+TEST(MVariableTest, ConvertToShouldWorkThroughTheTypeIdAndFailOtherwise) {
+  MTestType variable = MTestType().Is(TestType(7));
+  moriarty_internal::AbstractVariable* abstract_variable = &variable;
+
+  MORIARTY_EXPECT_OK(
+      moriarty_internal::ConvertTo<MTestType>(abstract_variable, "x"));
+  EXPECT_THAT(moriarty_internal::ConvertTo<moriarty::MInteger>(
+                  abstract_variable, "x"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unable to convert `x`")));
+}
+
+TEST(MVariableTest, GetUniqueValueTypedShouldMatchGetUniqueValueUntyped) {
+  MTestType unique = MTestType().Is(TestType(7));
+  MTestType not_unique = MTestType().IsOneOf({TestType(7), TestType(8)});
+
+  EXPECT_THAT(MVariableManager(&unique).GetUniqueValueTyped(),
+              Optional(TestType(7)));
+  EXPECT_EQ(MVariableManager(&not_unique).GetUniqueValueTyped(),
+            std::nullopt);
+}
+
 TEST(MVariableTest, SubvariablesShouldBeSetableAndUseable) {
   MTestType var = MTestType().SetMultiplier(MInteger().Between(2, 2));
 
@@ -221,6 +259,17 @@ TEST(MVariableTest, SubvaluesThatDontExistFail) {
               StatusIs(absl::StatusCode::kNotFound));
 }
 
+TEST(MVariableTest, SubvaluesShouldFallBackToComputingAllSubvalues) {
+  // Unlike `MTestType`, `MTestType2` only implements `GetSubvaluesImpl()`.
+  MTestType2 M = MTestType2();
+  EXPECT_THAT(MVariableManager(&M).GetSubvalue(
+                  TestType2(3 * MTestType2::kGeneratedValue), "multiplier"),
+              IsOkAndHolds(AnyWith<int64_t>(3)));
+  EXPECT_THAT(MVariableManager(&M).GetSubvalue(
+                  TestType2(3 * MTestType2::kGeneratedValue), "hat"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 TEST(MVariableTest, GeneratingDependentVariableWithNoUniverseShouldFail) {
   moriarty_internal::VariableSet variables;
   MORIARTY_EXPECT_OK(
@@ -450,6 +499,24 @@ TEST(MVariableTest, CustomConstraintWithDependentVariables) {
       IsOkAndHolds(MTestType::kGeneratedValue * 2));
 }
 
+TEST(MVariableTest, CustomConstraintWithDependentVariablesSurvivesRetries) {
+  // Most attempts are rejected, and "A" is regenerated after each rejection.
+  for (int i = 0; i < 10; i++) {
+    EXPECT_THAT(
+        Generate(MInteger()
+                     .Between(1, 5)
+                     .AddCustomConstraint(
+                         "EqualsA", {"A"},
+                         [](int64_t value,
+                            const ConstraintValues& known_values) -> bool {
+                           return known_values.GetValue<MInteger>("A") ==
+                                  value;
+                         }),
+                 Context().WithVariable("A", MInteger().Between(1, 5))),
+        IsOkAndHolds(AllOf(Ge(1), Le(5))));
+  }
+}
+
 TEST(MVariableTest, CustomConstraintInvalidFailsToGenerate) {
   EXPECT_THAT(
       Generate(MTestType()
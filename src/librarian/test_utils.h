@@ -36,6 +36,13 @@
 //         use `GeneratedValuesAre()` matcher below instead of generating lots
 //         of values and checking each for a property.
 //
+// Performance Helpers:
+//
+//     * BenchmarkGenerate(x, sizes, [optional] N, [optional] context)
+//         Generates N values of each size in `sizes` and reports how long
+//         generating and validating them took, how often generation was
+//         retried and how much memory the values hold.
+//
 // Input / Output Helpers:
 //
 //    * Read(x, stream/string, [optional] context)
@@ -87,6 +94,7 @@
 
 #include <any>
 #include <concepts>
+#include <cstdint>
 #include <istream>
 #include <iterator>
 #include <optional>
@@ -104,17 +112,22 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "src/errors.h"
 #include "src/internal/abstract_variable.h"
 #include "src/internal/analysis_bootstrap.h"
 #include "src/internal/generation_bootstrap.h"
 #include "src/internal/generation_config.h"
+#include "src/internal/generation_profile.h"
 #include "src/internal/random_engine.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/librarian/io_config.h"
 #include "src/librarian/mvariable.h"
+#include "src/librarian/size_property.h"
+#include "src/property.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty_testing {
@@ -229,6 +242,70 @@ template <typename T>
 absl::StatusOr<std::vector<typename T::value_type>>
 GenerateDifficultInstancesValues(T variable);
 
+// GenerateBenchmark
+//
+// The cost of generating values of a single size. See `BenchmarkGenerate()`.
+struct GenerateBenchmark {
+  moriarty::CommonSize size = moriarty::CommonSize::kAny;
+  int64_t num_values = 0;
+
+  // Wall time spent generating the values (including retries) and checking
+  // them against the constraints afterwards.
+  absl::Duration generate_time = absl::ZeroDuration();
+  absl::Duration validate_time = absl::ZeroDuration();
+
+  // Attempts to generate a value for the variable itself (not including its
+  // subvariables), and why the values from those attempts were thrown away.
+  int64_t generate_attempts = 0;
+  int64_t constraint_rejections = 0;
+  int64_t errors = 0;
+
+  // Memory held by the generated values. See `AllocatedByteSize()`.
+  int64_t allocated_bytes = 0;
+
+  double ValuesPerSecond() const {
+    return num_values / absl::ToDoubleSeconds(generate_time);
+  }
+  double RetriesPerValue() const {
+    return static_cast<double>(generate_attempts - num_values) / num_values;
+  }
+  double AllocatedBytesPerValue() const {
+    return static_cast<double>(allocated_bytes) / num_values;
+  }
+
+  std::string ToString() const {
+    return absl::Substitute(
+        "size=$0: $1 values/s, $2 retries/value, $3 bytes/value, $4/value "
+        "to validate",
+        moriarty::librarian::ToString(size), ValuesPerSecond(),
+        RetriesPerValue(), AllocatedBytesPerValue(),
+        absl::FormatDuration(validate_time / num_values));
+  }
+};
+
+// BenchmarkGenerate() [For tests only]
+//
+// Generates `values_per_size` values from `variable` with each size in
+// `sizes` (applied with the "size" property, except for `kAny`), and returns
+// the cost of each size, in the same order. Compare the sizes to spot
+// `GenerateImpl()`s that are slower than expected as values grow.
+//
+// Example:
+//   MORIARTY_ASSERT_OK_AND_ASSIGN(
+//       std::vector<GenerateBenchmark> benchmarks,
+//       BenchmarkGenerate(MCustomType(), {CommonSize::kSmall,
+//                                         CommonSize::kLarge}));
+//   for (const GenerateBenchmark& b : benchmarks) LOG(INFO) << b.ToString();
+//
+// Returns an error if a value cannot be generated or, since that is a bug in
+// the variable, does not satisfy the constraints it was generated from.
+template <typename T>
+  requires std::derived_from<
+      T, moriarty::librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::vector<GenerateBenchmark>> BenchmarkGenerate(
+    T variable, std::vector<moriarty::CommonSize> sizes,
+    int values_per_size = 30, Context context = {});
+
 // Read() [For tests only]
 //
 // Reads a value from the input stream and returns that value. (see version
@@ -570,6 +647,77 @@ GenerateDifficultInstancesValues(T variable) {
   return values;
 }
 
+template <typename T>
+  requires std::derived_from<
+      T, moriarty::librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<std::vector<GenerateBenchmark>> BenchmarkGenerate(
+    T variable, std::vector<moriarty::CommonSize> sizes,
+    int values_per_size, Context context) {
+  std::string var_name =
+      absl::Substitute("BenchmarkGenerate($0)", variable.Typename());
+  moriarty::moriarty_internal::RandomEngine rng({3, 4, 5}, "");
+
+  std::vector<GenerateBenchmark> benchmarks;
+  for (moriarty::CommonSize size : sizes) {
+    T sized_variable = variable;
+    if (size != moriarty::CommonSize::kAny) {
+      MORIARTY_RETURN_IF_ERROR(sized_variable.TryWithKnownProperty(
+          {.category = "size",
+           .descriptor = moriarty::librarian::ToString(size)}));
+    }
+    Context sized_context = context;
+    sized_context.WithVariable(var_name, sized_variable);
+
+    GenerateBenchmark benchmark = {.size = size,
+                                   .num_values = values_per_size};
+    moriarty::moriarty_internal::GenerationProfile profile;
+    std::vector<typename T::value_type> values;
+    values.reserve(values_per_size);
+    absl::Time start = absl::Now();
+    for (int i = 0; i < values_per_size; i++) {
+      Context context_copy = sized_context;
+      moriarty_testing_internal::ContextManager manager(&context_copy);
+      MORIARTY_ASSIGN_OR_RETURN(
+          moriarty::moriarty_internal::ValueSet generated,
+          moriarty::moriarty_internal::GenerateAllValues(
+              *manager.GetVariables(), *manager.GetValues(),
+              {.random_engine = rng,
+               .soft_generation_limit = std::nullopt,
+               .profile = &profile}));
+      MORIARTY_ASSIGN_OR_RETURN(typename T::value_type value,
+                                generated.Get<T>(var_name));
+      values.push_back(std::move(value));
+    }
+    benchmark.generate_time = absl::Now() - start;
+
+    auto entry = profile.Entries().find(
+        moriarty::moriarty_internal::GenerationProfile::ChildKey("", var_name));
+    if (entry != profile.Entries().end()) {
+      benchmark.generate_attempts = entry->second.generate_attempts;
+      benchmark.constraint_rejections =
+          entry->second.constraint_rejections +
+          entry->second.custom_constraint_rejections;
+      benchmark.errors = entry->second.errors;
+    }
+    for (const typename T::value_type& value : values) {
+      benchmark.allocated_bytes +=
+          moriarty::moriarty_internal::AllocatedByteSize(value);
+    }
+
+    moriarty_testing_internal::ContextManager manager(&sized_context);
+    moriarty::moriarty_internal::ConstraintChecker<T> checker(
+        sized_variable, *manager.GetValues(), *manager.GetVariables(),
+        var_name);
+    start = absl::Now();
+    for (const typename T::value_type& value : values)
+      MORIARTY_RETURN_IF_ERROR(checker.Check(value));
+    benchmark.validate_time = absl::Now() - start;
+
+    benchmarks.push_back(benchmark);
+  }
+  return benchmarks;
+}
+
 // IsSatisfiedWith() [for use with GoogleTest]
 //
 // Determines if values generated from this variable satisfy a constraint.
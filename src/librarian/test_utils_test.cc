@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/librarian/test_utils.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/librarian/size_property.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty_testing {
+namespace {
+
+using ::moriarty::CommonSize;
+using ::moriarty::MInteger;
+using ::testing::Gt;
+
+TEST(BenchmarkGenerateTest, ShouldReportEachSizeInOrder) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<GenerateBenchmark> benchmarks,
+      BenchmarkGenerate(MInteger().Between(1, 1000000),
+                        {CommonSize::kSmall, CommonSize::kAny,
+                         CommonSize::kLarge},
+                        /* values_per_size = */ 10));
+
+  ASSERT_EQ(benchmarks.size(), 3);
+  EXPECT_EQ(benchmarks[0].size, CommonSize::kSmall);
+  EXPECT_EQ(benchmarks[1].size, CommonSize::kAny);
+  EXPECT_EQ(benchmarks[2].size, CommonSize::kLarge);
+  for (const GenerateBenchmark& benchmark : benchmarks) {
+    EXPECT_EQ(benchmark.num_values, 10);
+    EXPECT_EQ(benchmark.generate_attempts, 10);
+    EXPECT_EQ(benchmark.constraint_rejections, 0);
+    EXPECT_EQ(benchmark.allocated_bytes, 10 * sizeof(int64_t));
+  }
+}
+
+TEST(BenchmarkGenerateTest, ShouldCountRetries) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<GenerateBenchmark> benchmarks,
+      BenchmarkGenerate(
+          MInteger().Between(1, 1000).AddCustomConstraint(
+              "Even", [](int64_t x) { return x % 2 == 0; }),
+          {CommonSize::kAny}));
+
+  ASSERT_EQ(benchmarks.size(), 1);
+  EXPECT_THAT(benchmarks[0].constraint_rejections, Gt(0));
+  EXPECT_EQ(benchmarks[0].generate_attempts,
+            benchmarks[0].num_values + benchmarks[0].constraint_rejections);
+  EXPECT_THAT(benchmarks[0].RetriesPerValue(), Gt(0));
+}
+
+TEST(BenchmarkGenerateTest, ShouldUseTheContext) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<GenerateBenchmark> benchmarks,
+      BenchmarkGenerate(MInteger().Between(1, "N"), {CommonSize::kMax},
+                        /* values_per_size = */ 5,
+                        Context().WithValue<MInteger>("N", 7)));
+
+  ASSERT_EQ(benchmarks.size(), 1);
+  EXPECT_EQ(benchmarks[0].num_values, 5);
+}
+
+}  // namespace
+}  // namespace moriarty_testing
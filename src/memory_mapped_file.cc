@@ -0,0 +1,91 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/memory_mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+
+namespace moriarty {
+
+absl::StatusOr<MemoryMappedFile> MemoryMappedFile::Open(
+    absl::string_view path) {
+  std::string path_string(path);
+  int fd = open(path_string.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return absl::NotFoundError(absl::Substitute(
+        "unable to open $0: $1", path, std::strerror(errno)));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int error = errno;
+    close(fd);
+    return absl::UnavailableError(absl::Substitute(
+        "unable to stat $0: $1", path, std::strerror(error)));
+  }
+
+  if (!S_ISREG(st.st_mode)) {
+    // E.g., a pipe, whose size is unknown.
+    close(fd);
+    return absl::FailedPreconditionError(
+        absl::Substitute("unable to map $0: not a regular file", path));
+  }
+
+  size_t size = st.st_size;
+  void* data = nullptr;
+  if (size > 0) {  // Mapping an empty file fails.
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      int error = errno;
+      close(fd);
+      return absl::UnavailableError(absl::Substitute(
+          "unable to map $0: $1", path, std::strerror(error)));
+    }
+  }
+  close(fd);  // The mapping stays valid after the file is closed.
+  return MemoryMappedFile(data, size);
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other)
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+
+absl::string_view MemoryMappedFile::Contents() const {
+  return absl::string_view(static_cast<const char*>(data_), size_);
+}
+
+}  // namespace moriarty
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_MEMORY_MAPPED_FILE_H_
+#define MORIARTY_SRC_MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace moriarty {
+
+// MemoryMappedFile
+//
+// A read-only view of a whole file, mapped into memory. Pages are only read
+// from disk when they are accessed, so large files can be read without copying
+// them into a buffer first.
+//
+// Needs POSIX `mmap()`, so portable targets only use it through optional
+// targets such as `//src:simple_io_mmap` and `//src:binary_io_mmap`.
+class MemoryMappedFile {
+ public:
+  // Open()
+  //
+  // Maps the file at `path` into memory. Returns kFailedPrecondition if it is
+  // not a regular file (e.g., a pipe).
+  static absl::StatusOr<MemoryMappedFile> Open(absl::string_view path);
+
+  MemoryMappedFile(MemoryMappedFile&& other);
+  MemoryMappedFile& operator=(MemoryMappedFile&& other);
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+  ~MemoryMappedFile();
+
+  // Contents()
+  //
+  // Returns the contents of the file. Valid as long as this object is.
+  [[nodiscard]] absl::string_view Contents() const;
+
+ private:
+  MemoryMappedFile(void* data, size_t size) : data_(data), size_(size) {}
+
+  void* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_MEMORY_MAPPED_FILE_H_
@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/memory_mapped_file.h"
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty {
+namespace {
+
+using ::testing::IsEmpty;
+using ::moriarty::StatusIs;
+
+TEST(MemoryMappedFileTest, OpenMissingFileFails) {
+  EXPECT_THAT(MemoryMappedFile::Open("/this/file/does/not/exist"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(MemoryMappedFileTest, ContentsMatchTheFile) {
+  std::filesystem::path dir = ::testing::TempDir();
+  std::string path = (dir / "memory_mapped_file_test").string();
+  std::ofstream(path, std::ios::binary) << std::string("a\0b", 3);
+  std::string empty_path = (dir / "memory_mapped_file_test_empty").string();
+  std::ofstream(empty_path, std::ios::binary);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(MemoryMappedFile file,
+                                MemoryMappedFile::Open(path));
+  EXPECT_EQ(file.Contents(), absl::string_view("a\0b", 3));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(MemoryMappedFile empty,
+                                MemoryMappedFile::Open(empty_path));
+  EXPECT_THAT(empty.Contents(), IsEmpty());
+
+  // Moving keeps the mapping alive.
+  MemoryMappedFile moved = std::move(file);
+  EXPECT_EQ(moved.Contents(), absl::string_view("a\0b", 3));
+}
+
+}  // namespace
+}  // namespace moriarty
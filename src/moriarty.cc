@@ -14,21 +14,45 @@
 
 #include "src/moriarty.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <fstream>
+#include <ios>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "src/exporter.h"
 #include "src/generator.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/abstract_variable.h"
+#include "src/internal/binary_format.h"
+#include "src/internal/generation_bootstrap.h"
+#include "src/internal/generation_profile.h"
+#include "src/internal/minimizer.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
+#include "src/internal/test_case_cache.h"
+#include "src/internal/tracing.h"
 #include "src/internal/universe.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
@@ -37,6 +61,25 @@
 
 namespace moriarty {
 
+namespace {
+
+// Appends the limits that are set in `limits` to the run key `key`.
+void AppendGenerationLimits(const moriarty_internal::GenerationLimits& limits,
+                            std::string& key) {
+  if (limits.max_wall_time) {
+    absl::StrAppend(&key, "max wall time: ",
+                    absl::FormatDuration(*limits.max_wall_time), "\n");
+  }
+  if (limits.max_generate_calls) {
+    absl::StrAppend(&key, "max generate calls: ", *limits.max_generate_calls,
+                    "\n");
+  }
+  if (limits.max_bytes)
+    absl::StrAppend(&key, "max bytes: ", *limits.max_bytes, "\n");
+}
+
+}  // namespace
+
 Moriarty& Moriarty::SetName(absl::string_view name) {
   name_ = name;
   return *this;
@@ -74,6 +117,25 @@ absl::Status Moriarty::TrySetSeed(absl::string_view seed) {
   // generator.
   seed_.resize(seed.size() + 1);
   for (int i = 0; i < seed.size(); i++) seed_[i] = seed[i];
+  shared_values_ = nullptr;  // Generated again with the new seed.
+  return absl::OkStatus();
+}
+
+Moriarty& Moriarty::SetRandomEngineVersion(absl::string_view version) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&]() { return TrySetRandomEngineVersion(version); },
+      "SetRandomEngineVersion");
+  return *this;
+}
+
+absl::Status Moriarty::TrySetRandomEngineVersion(absl::string_view version) {
+  if (version != moriarty_internal::kMersenneTwisterVersion &&
+      version != moriarty_internal::kCounterBasedVersion) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Unknown random engine version: '$0'", version));
+  }
+  random_engine_version_ = version;
+  shared_values_ = nullptr;  // Generated again with the new engine.
   return absl::OkStatus();
 }
 
@@ -87,6 +149,41 @@ absl::StatusOr<absl::Span<const int64_t>> Moriarty::GetSeedForGenerator(
   return seed_;
 }
 
+absl::Status Moriarty::GenerateSharedValues() {
+  if (shared_values_ != nullptr || shared_variables_.NumVariables() == 0)
+    return absl::OkStatus();
+
+  MORIARTY_ASSIGN_OR_RETURN(auto seed,
+                            GetSeedForGenerator(kSharedValuesSeedIndex),
+                            _ << "error retrieving seed");
+  moriarty_internal::RandomEngine rng(seed, random_engine_version_);
+  MORIARTY_ASSIGN_OR_RETURN(
+      moriarty_internal::ValueSet values,
+      moriarty_internal::GenerateAllValues(
+          shared_variables_, /*known_values = */ {},
+          {.random_engine = rng, .scheduler = scheduler_.get()}),
+      _ << "Assigning the shared variables failed.");
+  shared_values_ =
+      std::make_shared<const moriarty_internal::ValueSet>(std::move(values));
+  return absl::OkStatus();
+}
+
+moriarty_internal::VariableSet Moriarty::GetExportedVariables() const {
+  moriarty_internal::VariableSet variables = variables_;
+  for (const auto& [name, variable] : shared_variables_.GetAllVariables()) {
+    // The names are distinct (see `TryAddSharedVariable()`).
+    ABSL_CHECK_OK(variables.AddVariable(name, *variable));
+  }
+  return variables;
+}
+
+std::vector<int64_t> Moriarty::GetSeedForGeneratorCall(
+    absl::Span<const int64_t> generator_seed, int call) {
+  std::vector<int64_t> seed(generator_seed.begin(), generator_seed.end());
+  if (call > 1) seed.push_back(call);
+  return seed;
+}
+
 void Moriarty::GenerateTestCases() {
   moriarty_internal::TryFunctionOrCrash(
       [this]() { return this->TryGenerateTestCases(); }, "GenerateTestCases");
@@ -98,80 +195,1132 @@ absl::Status Moriarty::TryGenerateTestCases() {
         "no generators were found, maybe you need to add them?");
   }
 
-  // The approximate size of all data generated
-  int total_approximate_size = 0;
+  MORIARTY_RETURN_IF_ERROR(GenerateSharedValues());
+  StoredFingerprints fingerprints = FingerprintStoredTestCases();
+  auto store_test_case =
+      [this, &fingerprints](
+          moriarty_internal::ValueSet values,
+          TestCaseMetadata::GeneratedTestCaseMetadata generator_metadata) {
+        StoreTestCase(std::move(values), std::move(generator_metadata),
+                      fingerprints);
+      };
+
+  if (checkpoint_file_) return GenerateTestCasesWithCheckpoint(store_test_case);
+  if (NumThreads() == 1) return GenerateTestCasesSerially(store_test_case);
 
-  int generator_idx = 0;
-  for (auto& [generator_name, generator_ptr, call_n_times] : generators_) {
-    moriarty_internal::GeneratorManager generator_manager(generator_ptr.get());
+  // Each generator (with all of its iterations) is one task on the scheduler,
+  // and its large arrays may be split into more tasks on the same scheduler.
+  // The results are appended in order afterwards so the output
+  // matches the single-threaded version exactly. Since we do not know how much
+  // the earlier generators will produce, each generator is allowed to use the
+  // full approximate generation limit (unless it is planned, see
+  // `EnableGenerationLimitPlanning()`).
+  std::vector<std::vector<int64_t>> seeds;
+  seeds.reserve(generators_.size());
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
     MORIARTY_ASSIGN_OR_RETURN(auto seed, GetSeedForGenerator(generator_idx),
                               _ << "error retrieving seed");
-    generator_manager.SetSeed(seed);
-    for (int call = 1; call <= call_n_times; call++) {
-      generator_manager.ClearCases();
-      generator_manager.SetGeneralConstraints(variables_);
-      if (approximate_generation_limit_) {
-        generator_manager.SetApproximateGenerationLimit(
-            *approximate_generation_limit_);
-      }
-      generator_ptr->GenerateTestCases();
-
-      MORIARTY_ASSIGN_OR_RETURN(
-          std::vector<moriarty_internal::ValueSet> test_cases,
-          generator_manager.AssignValuesInAllTestCases(),
-          _ << "Assigning variables in GenerateTestCases() failed.");
-
-      int case_number = 1;
-      for (moriarty_internal::ValueSet values : test_cases) {
-        total_approximate_size += values.GetApproximateSize();
-        assigned_test_cases_.push_back(std::move(values));
-        test_case_metadata_.push_back(
-            TestCaseMetadata()
-                .SetTestCaseNumber(assigned_test_cases_.size())
-                .SetGeneratorMetadata(
-                    {.generator_name = generator_name,
-                     .generator_iteration = call,
-                     .case_number_in_generator = case_number++}));
+    seeds.push_back(std::vector<int64_t>(seed.begin(), seed.end()));
+  }
+
+  std::vector<GeneratorRun> runs(generators_.size());
+  scheduler_->ParallelFor(generators_.size(), [&](int idx) {
+    runs[idx] = RunGenerator(generators_[idx], seeds[idx]);
+  });
+
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    generation_profile_.MergeFrom(runs[generator_idx].profile,
+                                  generators_[generator_idx].name);
+  }
+
+  // The size of all data generated
+  GenerationTotals totals;
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    GeneratorRun& run = runs[generator_idx];
+    for (int call = 1; call <= run.test_cases.size(); call++) {
+      if (ConsumeTestCases(generators_[generator_idx], call,
+                           std::move(run.test_cases[call - 1]), totals,
+                           store_test_case)) {
+        return absl::OkStatus();
+      }
+    }
+    MORIARTY_RETURN_IF_ERROR(run.status)
+        << "Assigning variables in GenerateTestCases() failed.";
+  }
+  return absl::OkStatus();
+}
+
+void Moriarty::GenerateTestCasesFromCall(absl::string_view generator_name,
+                                         int call) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&, this]() {
+        return this->TryGenerateTestCasesFromCall(generator_name, call);
+      },
+      "GenerateTestCasesFromCall");
+}
+
+absl::Status Moriarty::TryGenerateTestCasesFromCall(
+    absl::string_view generator_name, int call) {
+  auto it = std::find_if(generators_.begin(), generators_.end(),
+                         [&](const GeneratorInfo& generator) {
+                           return generator.name == generator_name;
+                         });
+  if (it == generators_.end()) {
+    return absl::NotFoundError(
+        absl::Substitute("no generator named '$0'", generator_name));
+  }
+  const GeneratorInfo& generator = *it;
+  if (call < 1 || call > generator.call_n_times) {
+    return absl::OutOfRangeError(absl::Substitute(
+        "generator '$0' is called $1 times, but call $2 was requested",
+        generator_name, generator.call_n_times, call));
+  }
+
+  MORIARTY_RETURN_IF_ERROR(GenerateSharedValues());
+  MORIARTY_ASSIGN_OR_RETURN(auto seed,
+                            GetSeedForGenerator(it - generators_.begin()),
+                            _ << "error retrieving seed");
+  moriarty_internal::GeneratorManager generator_manager(
+      generator.generator.get());
+
+  moriarty_internal::GenerationProfile profile;
+  std::unique_ptr<moriarty_internal::GenerationBudget> budget =
+      CreateGeneratorBudget(generator);
+  absl::StatusOr<std::vector<moriarty_internal::ValueSet>> test_cases =
+      RunGeneratorIteration(generator, generator_manager, seed, call, profile,
+                            budget.get());
+  generation_profile_.MergeFrom(profile, generator.name);
+  MORIARTY_RETURN_IF_ERROR(test_cases.status())
+      << "Assigning variables in GenerateTestCasesFromCall() failed.";
+
+  int case_number = 1;
+  for (moriarty_internal::ValueSet& values : *test_cases) {
+    assigned_test_cases_.push_back(std::move(values));
+    test_case_metadata_.push_back(
+        TestCaseMetadata()
+            .SetTestCaseNumber(assigned_test_cases_.size())
+            .SetGeneratorMetadata({.generator_name = generator.name,
+                                   .generator_iteration = call,
+                                   .case_number_in_generator = case_number++}));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Moriarty::GenerateTestCasesSerially(TestCaseConsumer consume) {
+  // The size of all data generated
+  GenerationTotals totals;
+
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    MORIARTY_ASSIGN_OR_RETURN(auto seed, GetSeedForGenerator(generator_idx),
+                              _ << "error retrieving seed");
+    const GeneratorInfo& generator = generators_[generator_idx];
+    moriarty_internal::GeneratorManager generator_manager(
+        generator.generator.get());
+
+    std::unique_ptr<moriarty_internal::GenerationBudget> budget =
+        CreateGeneratorBudget(generator);
+
+    for (int call = 1; call <= generator.call_n_times; call++) {
+      moriarty_internal::GenerationProfile profile;
+      // Streamed test cases cannot be cached, since the cache key depends on
+      // all of the test cases of the call.
+      if (generator_manager.IsStreaming() && !test_case_cache_) {
+        absl::StatusOr<bool> reached_limit = StreamGeneratorIteration(
+            generator, generator_manager, seed, call, profile, budget.get(),
+            totals, consume);
+        generation_profile_.MergeFrom(profile, generator.name);
+        MORIARTY_RETURN_IF_ERROR(reached_limit.status())
+            << "Assigning variables in GenerateTestCases() failed.";
+        if (*reached_limit) return absl::OkStatus();
+        continue;
+      }
+      absl::StatusOr<std::vector<moriarty_internal::ValueSet>> test_cases =
+          RunGeneratorIteration(generator, generator_manager, seed, call,
+                                profile, budget.get());
+      generation_profile_.MergeFrom(profile, generator.name);
+      MORIARTY_RETURN_IF_ERROR(test_cases.status())
+          << "Assigning variables in GenerateTestCases() failed.";
+      if (ConsumeTestCases(generator, call, *std::move(test_cases), totals,
+                           consume)) {
+        return absl::OkStatus();
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Moriarty::GenerateTestCasesWithCheckpoint(
+    TestCaseConsumer consume) {
+  std::string run_key = GetCheckpointRunKey();
+
+  // The calls recorded by an earlier run. A call that was cut short while
+  // being written is dropped (and generated again).
+  std::string contents;
+  {
+    std::ifstream file(*checkpoint_file_, std::ios::binary);
+    if (file) {
+      contents.assign(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+    }
+  }
+  std::string header;
+  moriarty_internal::AppendCheckpointHeader(run_key, header);
+  std::vector<moriarty_internal::ShardWorkItem> recorded;
+  // The work done by each recorded call, charged to its generator's budget.
+  std::vector<moriarty_internal::GenerationUsage> recorded_usage;
+  absl::string_view in = contents;
+  if (absl::StartsWith(header, contents)) {
+    // There is no checkpoint yet, or it was cut short in its header.
+    contents = header;
+    in = "";
+  } else {
+    std::string recorded_run_key;
+    MORIARTY_RETURN_IF_ERROR(
+        moriarty_internal::ReadCheckpointHeader(in, recorded_run_key))
+        << "reading checkpoint file " << *checkpoint_file_ << " failed";
+    if (recorded_run_key != run_key) {
+      return absl::FailedPreconditionError(absl::Substitute(
+          "checkpoint file $0 was written by a different run (seed, "
+          "generators, generation limits or generator budgets); delete it "
+          "to start over",
+          *checkpoint_file_));
+    }
+    while (!in.empty()) {
+      moriarty_internal::ShardWorkItem work_item;
+      moriarty_internal::GenerationUsage usage;
+      absl::string_view rest = in;
+      if (!moriarty_internal::ReadShardWorkItem(rest, work_item).ok() ||
+          !moriarty_internal::ReadCheckpointBudgetUsage(rest, usage).ok()) {
+        break;
+      }
+      recorded.push_back(std::move(work_item));
+      recorded_usage.push_back(usage);
+      in = rest;
+    }
+  }
+
+  // Rewrite the file without the partial call (if any) before appending.
+  std::ofstream file(*checkpoint_file_, std::ios::binary | std::ios::trunc);
+  file.write(contents.data(), contents.size() - in.size());
+  if (!file.flush()) {
+    return absl::UnavailableError(
+        absl::StrCat("unable to write checkpoint file ", *checkpoint_file_));
+  }
+
+  // The size of all data generated
+  GenerationTotals totals;
+  // The position of the current call among the calls of all generators.
+  int64_t work_item_idx = 0;
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    MORIARTY_ASSIGN_OR_RETURN(auto seed, GetSeedForGenerator(generator_idx),
+                              _ << "error retrieving seed");
+    const GeneratorInfo& generator = generators_[generator_idx];
+    moriarty_internal::GeneratorManager generator_manager(
+        generator.generator.get());
+
+    std::unique_ptr<moriarty_internal::GenerationBudget> budget =
+        CreateGeneratorBudget(generator);
+
+    for (int call = 1; call <= generator.call_n_times; call++) {
+      std::vector<moriarty_internal::ValueSet> test_cases;
+      if (work_item_idx < recorded.size()) {
+        const moriarty_internal::ShardWorkItem& work_item =
+            recorded[work_item_idx];
+        if (work_item.generator_index != generator_idx ||
+            work_item.generator_name != generator.name ||
+            work_item.call != call || !work_item.status.ok()) {
+          return absl::InvalidArgumentError(absl::Substitute(
+              "checkpoint file $0 does not match the generators added to "
+              "Moriarty",
+              *checkpoint_file_));
+        }
+
+        // As in `TryMergeShards()`, only the variables of this call's test
+        // cases are needed to decode them.
+        AddGeneratorIterationTestCases(generator, generator_manager, seed,
+                                       call);
+        moriarty_internal::VariablesByName variables =
+            GetTestCaseVariables(generator_manager);
+        absl::string_view encoded = work_item.test_cases;
+        for (int64_t i = 0; i < work_item.num_test_cases; i++) {
+          moriarty_internal::ValueSet values;
+          MORIARTY_RETURN_IF_ERROR(moriarty_internal::ReadEncodedTestCase(
+              encoded, variables, values))
+              << "reading generator '" << generator.name << "' call " << call
+              << " from the checkpoint file failed";
+          test_cases.push_back(std::move(values));
+        }
+        if (budget != nullptr) {
+          budget->RecordUsage(recorded_usage[work_item_idx]);
+          MORIARTY_RETURN_IF_ERROR(budget->Check())
+              << "generator '" << generator.name << "' call " << call
+              << " from the checkpoint file is over its budget";
+        }
+      } else {
+        moriarty_internal::GenerationProfile profile;
+        moriarty_internal::GenerationUsage usage_before;
+        if (budget != nullptr) usage_before = budget->Usage();
+        absl::StatusOr<std::vector<moriarty_internal::ValueSet>> generated =
+            RunGeneratorIteration(generator, generator_manager, seed, call,
+                                  profile, budget.get());
+        generation_profile_.MergeFrom(profile, generator.name);
+        MORIARTY_RETURN_IF_ERROR(generated.status())
+            << "Assigning variables in GenerateTestCases() failed.";
+
+        // The test cases of this call are still in `generator_manager`.
+        std::string encoded;
+        MORIARTY_RETURN_IF_ERROR(moriarty_internal::AppendShardWorkItem(
+            generator_idx, generator.name, call, generated,
+            GetTestCaseVariables(generator_manager), encoded))
+            << "writing generator '" << generator.name << "' call " << call
+            << " to the checkpoint file failed";
+        moriarty_internal::GenerationUsage usage;
+        if (budget != nullptr) {
+          moriarty_internal::GenerationUsage usage_after = budget->Usage();
+          usage = {.generate_calls = usage_after.generate_calls -
+                                     usage_before.generate_calls,
+                   .bytes = usage_after.bytes - usage_before.bytes,
+                   .wall_time = usage_after.wall_time - usage_before.wall_time};
+        }
+        moriarty_internal::AppendCheckpointBudgetUsage(usage, encoded);
+        file.write(encoded.data(), encoded.size());
+        if (!file.flush()) {
+          return absl::UnavailableError(absl::StrCat(
+              "unable to write checkpoint file ", *checkpoint_file_));
+        }
+        test_cases = *std::move(generated);
       }
+      work_item_idx++;
 
-      if (approximate_generation_limit_ &&
-          total_approximate_size >= *approximate_generation_limit_) {
+      if (ConsumeTestCases(generator, call, std::move(test_cases), totals,
+                           consume)) {
         return absl::OkStatus();
       }
     }
-    generator_idx++;
   }
   return absl::OkStatus();
 }
 
+std::string Moriarty::GetCheckpointRunKey() const {
+  std::string key = absl::StrCat(
+      "name: ", name_, "\nseed: ", absl::StrJoin(seed_, ","),
+      "\nrandom engine: ", random_engine_version_,
+      "\napproximate generation limit: ",
+      approximate_generation_limit_.value_or(-1),
+      "\ngeneration byte limit: ", generation_byte_limit_.value_or(-1),
+      "\nplanned: ", plan_generation_limit_, "\n");
+  for (const GeneratorInfo& generator : generators_) {
+    auto it = generator_weights_.find(generator.name);
+    absl::StrAppend(&key, "generator: ", generator.name,
+                    "\ncalls: ", generator.call_n_times, "\nweight: ",
+                    it == generator_weights_.end() ? 1 : it->second, "\n");
+    auto limits = generator_limits_.find(generator.name);
+    if (limits != generator_limits_.end()) {
+      AppendGenerationLimits(limits->second, key);
+    } else if (default_generator_limits_) {
+      AppendGenerationLimits(*default_generator_limits_, key);
+    }
+  }
+  return key;
+}
+
+absl::StatusOr<std::vector<moriarty_internal::ValueSet>>
+Moriarty::RunGeneratorIteration(
+    const GeneratorInfo& generator,
+    moriarty_internal::GeneratorManager& generator_manager,
+    absl::Span<const int64_t> generator_seed, int call,
+    moriarty_internal::GenerationProfile& profile,
+    moriarty_internal::GenerationBudget* budget) const {
+  std::vector<int64_t> seed =
+      AddGeneratorIterationTestCases(generator, generator_manager,
+                                     generator_seed, call);
+
+  // The variables of every test case, used to encode and decode their values.
+  moriarty_internal::VariablesByName variables;
+  std::optional<std::string> cache_key;
+  if (test_case_cache_) {
+    variables = GetTestCaseVariables(generator_manager);
+    absl::StatusOr<std::string> key =
+        GetTestCaseCacheKey(generator, generator_manager, seed, call);
+    if (key.ok()) {
+      cache_key = *std::move(key);
+      if (std::optional<std::string> cached =
+              test_case_cache_->Lookup(*cache_key)) {
+        absl::StatusOr<std::vector<moriarty_internal::ValueSet>> decoded =
+            moriarty_internal::DecodeValueSets(*cached, variables);
+        if (decoded.ok()) return decoded;
+      }
+    }
+  }
+
+  if (profile_generation_) generator_manager.SetGenerationProfile(&profile);
+  generator_manager.SetGenerationBudget(budget);
+  absl::StatusOr<std::vector<moriarty_internal::ValueSet>> test_cases =
+      generator_manager.AssignValuesInAllTestCases();
+  generator_manager.SetGenerationProfile(nullptr);
+  generator_manager.SetGenerationBudget(nullptr);
+
+  if (cache_key && test_cases.ok()) {
+    // The cache is best-effort, so failing to store the test cases (e.g.,
+    // because they cannot be encoded) is not an error.
+    absl::StatusOr<std::string> encoded =
+        moriarty_internal::EncodeValueSets(*test_cases, variables);
+    if (encoded.ok())
+      test_case_cache_->Store(*cache_key, *encoded).IgnoreError();
+  }
+  return test_cases;
+}
+
+std::vector<int64_t> Moriarty::AddGeneratorIterationTestCases(
+    const GeneratorInfo& generator,
+    moriarty_internal::GeneratorManager& generator_manager,
+    absl::Span<const int64_t> generator_seed, int call) const {
+  std::vector<int64_t> seed = StartGeneratorIteration(
+      generator, generator_manager, generator_seed, call);
+  {
+    MORIARTY_TRACE_SPAN("Generator::GenerateTestCases");
+    generator.generator->GenerateTestCases();
+  }
+  // The limit is only used once the values are assigned, so the share of a
+  // planned limit can be split between the test cases that were just added.
+  // A `StreamingGenerator` assigns each test case before adding the next one,
+  // so each of its test cases may use the whole share.
+  std::optional<int64_t> limit = GenerationLimitForCall(generator, call);
+  if (limit && plan_generation_limit_ && !generator_manager.IsStreaming()) {
+    int64_t num_test_cases = std::max<int64_t>(
+        1, generator_manager.GetTestCases().size() +
+               generator_manager.GetOptionalTestCases().size());
+    generator_manager.SetApproximateGenerationLimit(
+        std::max<int64_t>(1, *limit / num_test_cases));
+  }
+  return seed;
+}
+
+std::vector<int64_t> Moriarty::StartGeneratorIteration(
+    const GeneratorInfo& generator,
+    moriarty_internal::GeneratorManager& generator_manager,
+    absl::Span<const int64_t> generator_seed, int call) const {
+  std::vector<int64_t> seed = GetSeedForGeneratorCall(generator_seed, call);
+  generator_manager.SetSeed(seed, random_engine_version_);
+  generator_manager.ClearCases();
+  generator_manager.SetGeneralConstraints(variables_);
+  generator_manager.SetSharedValues(shared_values_);
+  generator_manager.SetScheduler(scheduler_.get());
+  if (std::optional<int64_t> limit = GenerationLimitForCall(generator, call)) {
+    generator_manager.SetApproximateGenerationLimit(*limit);
+  }
+  return seed;
+}
+
+absl::StatusOr<bool> Moriarty::StreamGeneratorIteration(
+    const GeneratorInfo& generator,
+    moriarty_internal::GeneratorManager& generator_manager,
+    absl::Span<const int64_t> generator_seed, int call,
+    moriarty_internal::GenerationProfile& profile,
+    moriarty_internal::GenerationBudget* budget, GenerationTotals& totals,
+    TestCaseConsumer consume) const {
+  StartGeneratorIteration(generator, generator_manager, generator_seed, call);
+  if (profile_generation_) generator_manager.SetGenerationProfile(&profile);
+  generator_manager.SetGenerationBudget(budget);
+
+  // Optional test cases come after all other test cases of the call (as in
+  // `AssignValuesInAllTestCases()`), so they are held until the end.
+  std::vector<moriarty_internal::ValueSet> optional_test_cases;
+  absl::StatusOr<bool> reached_limit = false;
+  int case_number = 1;
+  while (true) {
+    {
+      MORIARTY_TRACE_SPAN("StreamingGenerator::GenerateNextTestCase");
+      if (!generator_manager.GenerateNextTestCase()) break;
+    }
+    int num_test_cases = generator_manager.GetTestCases().size();
+    absl::StatusOr<std::vector<moriarty_internal::ValueSet>> test_cases =
+        generator_manager.AssignValuesInAllTestCases();
+    generator_manager.ReleaseTestCases();
+    if (!test_cases.ok()) {
+      reached_limit = std::move(test_cases).status();
+      break;
+    }
+    // All of the (non-optional) test cases were assigned, and come first.
+    for (int i = 0; i < test_cases->size(); i++) {
+      if (i >= num_test_cases) {
+        optional_test_cases.push_back(std::move((*test_cases)[i]));
+      } else if (ConsumeTestCase(generator, call, case_number++,
+                                 std::move((*test_cases)[i]), totals,
+                                 consume)) {
+        reached_limit = true;
+        break;
+      }
+    }
+    if (*reached_limit) break;
+  }
+  generator_manager.SetGenerationProfile(nullptr);
+  generator_manager.SetGenerationBudget(nullptr);
+  generator_manager.ClearCases();
+  if (!reached_limit.ok() || *reached_limit) return reached_limit;
+
+  for (moriarty_internal::ValueSet& values : optional_test_cases) {
+    if (ConsumeTestCase(generator, call, case_number++, std::move(values),
+                        totals, consume)) {
+      return true;
+    }
+  }
+  return ReachedGenerationLimit(totals);
+}
+
+moriarty_internal::VariablesByName Moriarty::GetTestCaseVariables(
+    moriarty_internal::GeneratorManager& generator_manager) {
+  moriarty_internal::VariablesByName variables;
+  for (const auto* cases : {&generator_manager.GetTestCases(),
+                            &generator_manager.GetOptionalTestCases()}) {
+    for (const std::unique_ptr<TestCase>& test_case : *cases) {
+      moriarty_internal::TestCaseManager manager(test_case.get());
+      // A test case's own variables hide the general ones with the same name.
+      for (const moriarty_internal::VariableSet* variable_set :
+           {&manager.GetOverriddenVariables(),
+            &manager.GetGeneralVariables()}) {
+        for (const auto& [name, variable] : variable_set->GetAllVariables()) {
+          variables.emplace(name, variable.get());
+        }
+      }
+    }
+  }
+  return variables;
+}
+
+absl::StatusOr<std::string> Moriarty::GetTestCaseCacheKey(
+    const GeneratorInfo& generator,
+    moriarty_internal::GeneratorManager& generator_manager,
+    absl::Span<const int64_t> seed, int call) const {
+  // The test cases do not depend on the number of threads, so it is not part
+  // of the key.
+  std::string key = absl::StrCat(
+      "cache version: ", test_case_cache_version_,
+      "\nrandom engine: ", random_engine_version_,
+      "\nseed: ", absl::StrJoin(seed, ","), "\ngenerator: ", generator.name,
+      "\ncall: ", call, "\ngeneration limit: ",
+      GenerationLimitForCall(generator, call).value_or(-1), "\n");
+  if (shared_variables_.NumVariables() > 0) {
+    absl::StrAppend(&key, "shared variables:\n", shared_variables_.ToString());
+  }
+
+  int case_number = 1;
+  for (const std::unique_ptr<TestCase>& test_case :
+       generator_manager.GetTestCases()) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::string constraints,
+        moriarty_internal::TestCaseManager(test_case.get())
+            .ConstraintsToString());
+    absl::StrAppend(&key, "test case ", case_number++, ":\n", constraints);
+  }
+  case_number = 1;
+  for (const std::unique_ptr<TestCase>& test_case :
+       generator_manager.GetOptionalTestCases()) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::string constraints,
+        moriarty_internal::TestCaseManager(test_case.get())
+            .ConstraintsToString());
+    absl::StrAppend(&key, "optional test case ", case_number++, ":\n",
+                    constraints);
+  }
+  return key;
+}
+
+std::unique_ptr<moriarty_internal::GenerationBudget>
+Moriarty::CreateGeneratorBudget(const GeneratorInfo& generator) const {
+  if (auto it = generator_limits_.find(generator.name);
+      it != generator_limits_.end()) {
+    return std::make_unique<moriarty_internal::GenerationBudget>(it->second);
+  }
+  if (default_generator_limits_) {
+    return std::make_unique<moriarty_internal::GenerationBudget>(
+        *default_generator_limits_);
+  }
+  return nullptr;
+}
+
+Moriarty::GeneratorRun Moriarty::RunGenerator(
+    const GeneratorInfo& generator, absl::Span<const int64_t> seed) const {
+  GeneratorRun run;
+  GenerationTotals totals;
+
+  moriarty_internal::GeneratorManager generator_manager(
+      generator.generator.get());
+  std::unique_ptr<moriarty_internal::GenerationBudget> budget =
+      CreateGeneratorBudget(generator);
+  for (int call = 1; call <= generator.call_n_times; call++) {
+    absl::StatusOr<std::vector<moriarty_internal::ValueSet>> test_cases =
+        RunGeneratorIteration(generator, generator_manager, seed, call,
+                              run.profile, budget.get());
+    if (!test_cases.ok()) {
+      run.status = std::move(test_cases).status();
+      return run;
+    }
+
+    for (const moriarty_internal::ValueSet& values : *test_cases) {
+      totals.approximate_size += values.GetApproximateSize();
+      totals.bytes += values.GetByteSize();
+    }
+    run.test_cases.push_back(*std::move(test_cases));
+
+    if (ReachedGenerationLimit(totals)) break;
+  }
+  return run;
+}
+
+Moriarty::StoredFingerprints Moriarty::FingerprintStoredTestCases() const {
+  StoredFingerprints fingerprints;
+  if (!remove_duplicate_test_cases_) return fingerprints;
+  fingerprints.variables = moriarty_internal::GetVariablesByName(variables_);
+  for (int i = 0; i < assigned_test_cases_.size(); i++) {
+    absl::StatusOr<absl::uint128> fingerprint =
+        moriarty_internal::FingerprintTestCase(assigned_test_cases_[i],
+                                               fingerprints.variables);
+    if (fingerprint.ok()) {
+      fingerprints.first_test_case.try_emplace(*fingerprint, i);
+    }
+  }
+  return fingerprints;
+}
+
+void Moriarty::StoreTestCase(
+    moriarty_internal::ValueSet values,
+    TestCaseMetadata::GeneratedTestCaseMetadata generator_metadata,
+    StoredFingerprints& fingerprints) {
+  if (remove_duplicate_test_cases_) {
+    absl::StatusOr<absl::uint128> fingerprint =
+        moriarty_internal::FingerprintTestCase(values, fingerprints.variables);
+    if (fingerprint.ok()) {
+      auto [it, inserted] = fingerprints.first_test_case.try_emplace(
+          *fingerprint, assigned_test_cases_.size());
+      if (!inserted) {
+        test_case_metadata_[it->second].AddDroppedDuplicate(
+            std::move(generator_metadata));
+        return;
+      }
+    }
+  }
+
+  assigned_test_cases_.push_back(std::move(values));
+  test_case_metadata_.push_back(
+      TestCaseMetadata()
+          .SetTestCaseNumber(assigned_test_cases_.size())
+          .SetGeneratorMetadata(std::move(generator_metadata)));
+}
+
+bool Moriarty::ConsumeTestCases(
+    const GeneratorInfo& generator, int call,
+    std::vector<moriarty_internal::ValueSet> test_cases,
+    GenerationTotals& totals, TestCaseConsumer consume) const {
+  int case_number = 1;
+  for (moriarty_internal::ValueSet& values : test_cases) {
+    if (ConsumeTestCase(generator, call, case_number++, std::move(values),
+                        totals, consume)) {
+      return true;
+    }
+  }
+
+  return ReachedGenerationLimit(totals);
+}
+
+bool Moriarty::ConsumeTestCase(const GeneratorInfo& generator, int call,
+                               int case_number,
+                               moriarty_internal::ValueSet values,
+                               GenerationTotals& totals,
+                               TestCaseConsumer consume) const {
+  // The byte limit is a hard cap: a test case that does not fit is dropped.
+  if (generation_byte_limit_ &&
+      totals.bytes + values.GetByteSize() > *generation_byte_limit_) {
+    return true;
+  }
+  totals.approximate_size += values.GetApproximateSize();
+  totals.bytes += values.GetByteSize();
+  // Test cases read back from a cache, checkpoint or shard only store their
+  // own values.
+  values.SetSharedValues(shared_values_);
+  consume(std::move(values), {.generator_name = generator.name,
+                              .generator_iteration = call,
+                              .case_number_in_generator = case_number});
+
+  // The later test cases of a `StreamingGenerator` have not been added yet,
+  // so it stops right away. This happens whether or not it was streamed, so
+  // the test cases are the same either way.
+  return moriarty_internal::GeneratorManager(generator.generator.get())
+             .IsStreaming() &&
+         ReachedGenerationLimit(totals);
+}
+
+bool Moriarty::ReachedGenerationLimit(const GenerationTotals& totals) const {
+  // A planned approximate limit is already split between all calls.
+  return (approximate_generation_limit_ && !plan_generation_limit_ &&
+          totals.approximate_size >= *approximate_generation_limit_) ||
+         (generation_byte_limit_ && totals.bytes >= *generation_byte_limit_);
+}
+
+std::optional<int64_t> Moriarty::SoftGenerationLimit() const {
+  if (!generation_byte_limit_) return approximate_generation_limit_;
+  if (!approximate_generation_limit_) return generation_byte_limit_;
+  return std::min(*approximate_generation_limit_, *generation_byte_limit_);
+}
+
+std::optional<int64_t> Moriarty::GenerationLimitForCall(
+    const GeneratorInfo& generator, int call) const {
+  std::optional<int64_t> limit = SoftGenerationLimit();
+  if (!limit || !plan_generation_limit_) return limit;
+
+  // The calls of all generators, in order, split the limit in proportion to
+  // their weights. The calls before this one get the first
+  // `limit * weight_before / total_weight` of it.
+  auto weight_of = [this](const GeneratorInfo& info) -> int64_t {
+    auto it = generator_weights_.find(info.name);
+    return it == generator_weights_.end() ? 1 : it->second;
+  };
+  absl::int128 weight_before = 0;
+  absl::int128 total_weight = 0;
+  for (const GeneratorInfo& other : generators_) {
+    if (&other == &generator) {
+      weight_before =
+          total_weight + absl::int128(weight_of(other)) * (call - 1);
+    }
+    total_weight += absl::int128(weight_of(other)) * other.call_n_times;
+  }
+  if (total_weight == 0) return 0;
+  auto limit_before = [&](absl::int128 weight) {
+    return static_cast<int64_t>(absl::int128(*limit) * weight / total_weight);
+  };
+  return limit_before(weight_before + weight_of(generator)) -
+         limit_before(weight_before);
+}
+
+absl::Status Moriarty::GenerateAndStreamTestCases(Exporter& exporter) {
+  if (generators_.empty()) {
+    return absl::FailedPreconditionError(
+        "no generators were found, maybe you need to add them?");
+  }
+
+  MORIARTY_RETURN_IF_ERROR(GenerateSharedValues());
+  moriarty_internal::ExporterManager manager(&exporter);
+  manager.SetGeneralConstraints(GetExportedVariables());
+  manager.SetSharedValues(shared_values_);
+  manager.StartStreamingExport();
+
+  int num_test_cases = 0;
+  absl::Status status = GenerateTestCasesSerially(
+      [&](moriarty_internal::ValueSet values,
+          TestCaseMetadata::GeneratedTestCaseMetadata generator_metadata) {
+        manager.StreamTestCase(
+            std::move(values),
+            TestCaseMetadata()
+                .SetTestCaseNumber(++num_test_cases)
+                .SetGeneratorMetadata(std::move(generator_metadata)));
+      });
+
+  manager.EndStreamingExport();
+  return status;
+}
+
 absl::Status Moriarty::TryValidateTestCases() {
   if (assigned_test_cases_.empty()) {
     return absl::FailedPreconditionError("No TestCases to validate.");
   }
 
+  if (NumThreads() == 1) {
+    // Validation points the variables at a Universe, so use a copy to leave
+    // `variables_` untouched.
+    moriarty_internal::VariableSet variables = variables_;
+    int case_num = 1;
+    for (const moriarty_internal::ValueSet& test_case : assigned_test_cases_) {
+      MORIARTY_RETURN_IF_ERROR(TryValidateSingleTestCase(test_case, variables))
+          << "Case " << case_num << " invalid";
+      case_num++;
+    }
+    return absl::OkStatus();
+  }
+
+  // Each worker (a task on the scheduler) validates with its own copy of the
+  // variables, since validation points them at a Universe. Workers claim cases
+  // in increasing order and skip any case after the earliest failure seen so
+  // far, so the reported failure is always the first invalid case, as in the
+  // single-threaded version.
+  int num_cases = assigned_test_cases_.size();
+  int num_workers = std::min<int>(NumThreads(), num_cases);
+  std::atomic<int> next_case_idx = 0;
+  std::atomic<int> first_failed_idx = num_cases;
+  std::vector<absl::Status> first_failure(num_workers);
+  std::vector<int> first_failure_idx(num_workers, num_cases);
+
+  auto worker = [&](int worker_idx) {
+    moriarty_internal::VariableSet variables = variables_;
+    for (int idx = next_case_idx++; idx < num_cases; idx = next_case_idx++) {
+      if (idx > first_failed_idx.load()) return;
+      absl::Status status =
+          TryValidateSingleTestCase(assigned_test_cases_[idx], variables);
+      if (status.ok()) continue;
+
+      // Cases are claimed in increasing order, so this is the first failure
+      // for this worker.
+      first_failure[worker_idx] = std::move(status);
+      first_failure_idx[worker_idx] = idx;
+      int current = first_failed_idx.load();
+      while (idx < current &&
+             !first_failed_idx.compare_exchange_weak(current, idx)) {
+      }
+      return;
+    }
+  };
+
+  scheduler_->ParallelFor(num_workers, worker);
+
+  for (int i = 0; i < num_workers; i++) {
+    if (first_failure_idx[i] == first_failed_idx.load()) {
+      MORIARTY_RETURN_IF_ERROR(first_failure[i])
+          << "Case " << first_failure_idx[i] + 1 << " invalid";
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Moriarty::TryMinimizeTestCases(
+    absl::FunctionRef<bool(const ConstraintValues&)> still_fails) {
+  auto fails = [&](const moriarty_internal::ValueSet& values) {
+    moriarty_internal::Universe universe =
+        moriarty_internal::Universe()
+            .SetConstValueSet(&values)
+            .SetConstVariableSet(&variables_);
+    return still_fails(ConstraintValues(&universe));
+  };
+
   int case_num = 1;
-  for (const moriarty_internal::ValueSet& test_case : assigned_test_cases_) {
-    MORIARTY_RETURN_IF_ERROR(TryValidateSingleTestCase(test_case))
-        << "Case " << case_num << " invalid";
+  for (moriarty_internal::ValueSet& test_case : assigned_test_cases_) {
+    if (fails(test_case)) {
+      absl::StatusOr<moriarty_internal::ValueSet> minimized =
+          moriarty_internal::MinimizeValues(variables_, test_case, fails,
+                                            scheduler_.get());
+      MORIARTY_RETURN_IF_ERROR(minimized.status())
+          << "Case " << case_num << " could not be minimized";
+      test_case = *std::move(minimized);
+    }
     case_num++;
   }
   return absl::OkStatus();
 }
 
 absl::Status Moriarty::TryValidateSingleTestCase(
-    const moriarty_internal::ValueSet& values) {
+    const moriarty_internal::ValueSet& values,
+    moriarty_internal::VariableSet& variables) const {
+  // The values are only read, so a single variable (e.g., a huge array) may
+  // check its value on several threads.
   moriarty_internal::Universe universe = moriarty_internal::Universe()
                                              .SetConstValueSet(&values)
-                                             .SetConstVariableSet(&variables_);
+                                             .SetConstVariableSet(&variables)
+                                             .SetScheduler(scheduler_.get());
 
-  variables_.SetUniverse(&universe);
-  return variables_.AllVariablesSatisfyConstraints();
+  variables.SetUniverse(&universe);
+  return variables.AllVariablesSatisfyConstraints();
 }
 
 void Moriarty::SetApproximateGenerationLimit(int64_t limit) {
   approximate_generation_limit_ = limit;
 }
 
+Moriarty& Moriarty::SetGenerationByteLimit(int64_t limit) {
+  generation_byte_limit_ = limit;
+  return *this;
+}
+
+Moriarty& Moriarty::EnableGenerationLimitPlanning() {
+  plan_generation_limit_ = true;
+  return *this;
+}
+
+Moriarty& Moriarty::SetGeneratorWeight(absl::string_view generator_name,
+                                       int64_t weight) {
+  ABSL_CHECK_GE(weight, 0) << "The weight of generator '" << generator_name
+                           << "' must be non-negative.";
+  generator_weights_[generator_name] = weight;
+  return *this;
+}
+
+Moriarty& Moriarty::SetNumThreads(int num_threads) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&]() { return TrySetNumThreads(num_threads); }, "SetNumThreads");
+  return *this;
+}
+
+absl::Status Moriarty::TrySetNumThreads(int num_threads) {
+  if (num_threads <= 0)
+    return absl::InvalidArgumentError("num_threads must be positive");
+
+  if (num_threads == 1) {
+    scheduler_ = nullptr;
+  } else {
+    scheduler_ =
+        std::make_shared<moriarty_internal::WorkStealingScheduler>(num_threads);
+  }
+  return absl::OkStatus();
+}
+
+Moriarty& Moriarty::SetScheduler(
+    std::shared_ptr<moriarty_internal::Scheduler> scheduler) {
+  scheduler_ = std::move(scheduler);
+  return *this;
+}
+
+int Moriarty::NumThreads() const {
+  return scheduler_ == nullptr ? 1 : scheduler_->NumThreads();
+}
+
+Moriarty& Moriarty::EnableGenerationProfiling() {
+  profile_generation_ = true;
+  return *this;
+}
+
+Moriarty& Moriarty::EnableDuplicateTestCaseRemoval() {
+  remove_duplicate_test_cases_ = true;
+  return *this;
+}
+
+const moriarty_internal::GenerationProfile& Moriarty::GetGenerationProfile()
+    const {
+  return generation_profile_;
+}
+
+Moriarty& Moriarty::SetGeneratorBudget(
+    moriarty_internal::GenerationLimits limits) {
+  default_generator_limits_ = std::move(limits);
+  return *this;
+}
+
+Moriarty& Moriarty::SetGeneratorBudget(
+    absl::string_view generator_name,
+    moriarty_internal::GenerationLimits limits) {
+  generator_limits_[generator_name] = std::move(limits);
+  return *this;
+}
+
+Moriarty& Moriarty::SetTestCaseCache(absl::string_view directory,
+                                     absl::string_view version) {
+  test_case_cache_.emplace(std::string(directory));
+  test_case_cache_version_ = version;
+  return *this;
+}
+
+Moriarty& Moriarty::SetCheckpointFile(absl::string_view path) {
+  checkpoint_file_ = std::string(path);
+  return *this;
+}
+
+Moriarty& Moriarty::SetShard(int index, int num_shards) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&]() { return TrySetShard(index, num_shards); }, "SetShard");
+  return *this;
+}
+
+absl::Status Moriarty::TrySetShard(int index, int num_shards) {
+  if (num_shards <= 0)
+    return absl::InvalidArgumentError("num_shards must be positive");
+  if (index < 0 || index >= num_shards) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "shard index must be between 0 and $0, but got $1", num_shards - 1,
+        index));
+  }
+
+  shard_index_ = index;
+  num_shards_ = num_shards;
+  return absl::OkStatus();
+}
+
+void Moriarty::GenerateShard(std::ostream& os) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&, this]() { return this->TryGenerateShard(os); }, "GenerateShard");
+}
+
+absl::Status Moriarty::TryGenerateShard(std::ostream& os) {
+  if (generators_.empty()) {
+    return absl::FailedPreconditionError(
+        "no generators were found, maybe you need to add them?");
+  }
+
+  MORIARTY_RETURN_IF_ERROR(GenerateSharedValues());
+
+  std::string encoded;
+  moriarty_internal::AppendShardHeader(shard_index_, num_shards_, encoded);
+  os.write(encoded.data(), encoded.size());
+
+  // The position of the current call among the calls of all generators.
+  int64_t work_item_idx = 0;
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    MORIARTY_ASSIGN_OR_RETURN(auto seed, GetSeedForGenerator(generator_idx),
+                              _ << "error retrieving seed");
+    const GeneratorInfo& generator = generators_[generator_idx];
+    moriarty_internal::GeneratorManager generator_manager(
+        generator.generator.get());
+
+    std::unique_ptr<moriarty_internal::GenerationBudget> budget =
+        CreateGeneratorBudget(generator);
+
+    for (int call = 1; call <= generator.call_n_times; call++) {
+      if (work_item_idx++ % num_shards_ != shard_index_) continue;
+
+      moriarty_internal::GenerationProfile profile;
+      absl::StatusOr<std::vector<moriarty_internal::ValueSet>> test_cases =
+          RunGeneratorIteration(generator, generator_manager, seed, call,
+                                profile, budget.get());
+      generation_profile_.MergeFrom(profile, generator.name);
+
+      // The test cases of this call are still in `generator_manager`.
+      encoded.clear();
+      MORIARTY_RETURN_IF_ERROR(moriarty_internal::AppendShardWorkItem(
+          generator_idx, generator.name, call, test_cases,
+          GetTestCaseVariables(generator_manager), encoded))
+          << "writing generator '" << generator.name << "' call " << call
+          << " to the shard failed";
+      os.write(encoded.data(), encoded.size());
+    }
+  }
+
+  if (!os) return absl::UnavailableError("failed to write the shard");
+  return absl::OkStatus();
+}
+
+void Moriarty::MergeShards(absl::Span<const absl::string_view> shards) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&, this]() { return this->TryMergeShards(shards); }, "MergeShards");
+}
+
+absl::Status Moriarty::TryMergeShards(
+    absl::Span<const absl::string_view> shards) {
+  if (generators_.empty()) {
+    return absl::FailedPreconditionError(
+        "no generators were found, maybe you need to add them?");
+  }
+
+  // The position of each generator's first call among the calls of all
+  // generators.
+  std::vector<int64_t> first_work_item_idx;
+  int64_t num_work_items = 0;
+  for (const GeneratorInfo& generator : generators_) {
+    first_work_item_idx.push_back(num_work_items);
+    num_work_items += generator.call_n_times;
+  }
+
+  std::vector<std::optional<moriarty_internal::ShardWorkItem>> work_items(
+      num_work_items);
+  std::vector<bool> seen_shard(shards.size(), false);
+  for (absl::string_view shard : shards) {
+    int64_t shard_index, num_shards;
+    MORIARTY_RETURN_IF_ERROR(
+        moriarty_internal::ReadShardHeader(shard, shard_index, num_shards));
+    if (num_shards != shards.size()) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "shard $0 is one of $1 shards, but $2 shards were given",
+          shard_index, num_shards, shards.size()));
+    }
+    if (shard_index >= num_shards || seen_shard[shard_index]) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("shard $0 was given more than once", shard_index));
+    }
+    seen_shard[shard_index] = true;
+
+    while (!shard.empty()) {
+      moriarty_internal::ShardWorkItem work_item;
+      MORIARTY_RETURN_IF_ERROR(
+          moriarty_internal::ReadShardWorkItem(shard, work_item))
+          << "reading shard " << shard_index << " failed";
+
+      int64_t generator_idx = work_item.generator_index;
+      if (generator_idx >= generators_.size() ||
+          generators_[generator_idx].name != work_item.generator_name ||
+          work_item.call < 1 ||
+          work_item.call > generators_[generator_idx].call_n_times) {
+        return absl::InvalidArgumentError(absl::Substitute(
+            "shard $0 contains call $1 of generator '$2', which does not "
+            "match the generators added to Moriarty",
+            shard_index, work_item.call, work_item.generator_name));
+      }
+      int64_t work_item_idx =
+          first_work_item_idx[generator_idx] + work_item.call - 1;
+      if (work_item_idx % num_shards != shard_index ||
+          work_items[work_item_idx].has_value()) {
+        return absl::InvalidArgumentError(absl::Substitute(
+            "shard $0 should not contain call $1 of generator '$2'",
+            shard_index, work_item.call, work_item.generator_name));
+      }
+      work_items[work_item_idx] = std::move(work_item);
+    }
+  }
+
+  // Check that no shard was cut short before storing anything.
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    for (int call = 1; call <= generators_[generator_idx].call_n_times;
+         call++) {
+      if (!work_items[first_work_item_idx[generator_idx] + call - 1]) {
+        return absl::InvalidArgumentError(absl::Substitute(
+            "no shard contains call $0 of generator '$1'", call,
+            generators_[generator_idx].name));
+      }
+    }
+  }
+
+  MORIARTY_RETURN_IF_ERROR(GenerateSharedValues());
+  StoredFingerprints fingerprints = FingerprintStoredTestCases();
+  auto store_test_case =
+      [this, &fingerprints](
+          moriarty_internal::ValueSet values,
+          TestCaseMetadata::GeneratedTestCaseMetadata generator_metadata) {
+        StoreTestCase(std::move(values), std::move(generator_metadata),
+                      fingerprints);
+      };
+
+  // The size of all data generated
+  GenerationTotals totals;
+  for (int generator_idx = 0; generator_idx < generators_.size();
+       generator_idx++) {
+    MORIARTY_ASSIGN_OR_RETURN(auto seed, GetSeedForGenerator(generator_idx),
+                              _ << "error retrieving seed");
+    const GeneratorInfo& generator = generators_[generator_idx];
+    moriarty_internal::GeneratorManager generator_manager(
+        generator.generator.get());
+
+    for (int call = 1; call <= generator.call_n_times; call++) {
+      const moriarty_internal::ShardWorkItem& work_item =
+          *work_items[first_work_item_idx[generator_idx] + call - 1];
+      MORIARTY_RETURN_IF_ERROR(work_item.status)
+          << "Assigning variables in GenerateTestCases() failed.";
+
+      // The test cases are decoded with the variables of this call's test
+      // cases, which only requires calling the generator, not assigning any
+      // values.
+      AddGeneratorIterationTestCases(generator, generator_manager, seed, call);
+      moriarty_internal::VariablesByName variables =
+          GetTestCaseVariables(generator_manager);
+      std::vector<moriarty_internal::ValueSet> test_cases;
+      absl::string_view encoded = work_item.test_cases;
+      for (int64_t i = 0; i < work_item.num_test_cases; i++) {
+        moriarty_internal::ValueSet values;
+        MORIARTY_RETURN_IF_ERROR(
+            moriarty_internal::ReadEncodedTestCase(encoded, variables, values))
+            << "reading generator '" << generator.name << "' call " << call
+            << " failed";
+        test_cases.push_back(std::move(values));
+      }
+
+      if (ConsumeTestCases(generator, call, std::move(test_cases), totals,
+                           store_test_case)) {
+        return absl::OkStatus();
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::Status Moriarty::ValidateVariableName(absl::string_view name) {
   if (name.empty())
     return absl::InvalidArgumentError("Variable name cannot be empty");
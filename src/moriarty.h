@@ -24,22 +24,35 @@
 #ifndef MORIARTY_SRC_MORIARTY_H_
 #define MORIARTY_SRC_MORIARTY_H_
 
+#include <array>
 #include <concepts>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "src/constraint_values.h"
 #include "src/exporter.h"
 #include "src/generator.h"
 #include "src/importer.h"
+#include "src/internal/binary_format.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/status_utils.h"
+#include "src/internal/test_case_cache.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/librarian/mvariable.h"
@@ -121,6 +134,33 @@ class Moriarty {
   // Returns status on failure. See `SetSeed()` for simpler API version.
   absl::Status TrySetSeed(absl::string_view seed);
 
+  // SetRandomEngineVersion() [optional]
+  //
+  // Selects the random engine used for generation:
+  //  * "v0.1" (the default) uses std::mt19937_64.
+  //  * "v0.2" uses a counter-based engine. It is cheaper to create (e.g., one
+  //    per test case) and to split into independent streams, so test cases
+  //    and large arrays may be generated in parallel. Each test case has its
+  //    own engine, so its values do not depend on the other test cases.
+  //
+  // With "v0.1", all test cases of a generator share one engine (so old seeds
+  // keep giving the same test cases), and they are generated one at a time.
+  //
+  // The same seed gives different test cases with different versions.
+  //
+  // Crashes on failure. See `TrySetRandomEngineVersion()` for non-crashing
+  // version.
+  Moriarty& SetRandomEngineVersion(absl::string_view version);
+
+  // TrySetRandomEngineVersion()
+  //
+  // Selects the random engine used for generation. See
+  // `SetRandomEngineVersion()` for the available versions.
+  //
+  // Returns kInvalidArgument if `version` is unknown. See
+  // `SetRandomEngineVersion()` for simpler API version.
+  absl::Status TrySetRandomEngineVersion(absl::string_view version);
+
   // AddVariable()
   //
   // Adds a variable to Moriarty with all global constraints applied to it. For
@@ -168,11 +208,49 @@ class Moriarty {
                                librarian::MVariable<T, typename T::value_type>>
   absl::Status TryAddVariable(absl::string_view name, T variable);
 
+  // AddSharedVariable()
+  //
+  // Adds a suite-level variable to Moriarty. Unlike `AddVariable()`, its value
+  // is generated only once and is shared by all test cases, without being
+  // copied into each of them. For example,
+  //
+  //  `M.AddSharedVariable("K", MInteger().Between(1, 1'000'000'000))
+  //     .AddVariable("A", MArray(MInteger().Between(1, "K")).OfLength(10));`
+  //
+  // means that every test case has the same `K`, and the elements of `A` in
+  // every test case are at most that `K`. Exporters may print shared variables
+  // in each test case or once (e.g., `SimpleIO::AddHeaderLine()`), and
+  // `Exporter::GetValue()` may read them in `StartExport()` and `EndExport()`.
+  //
+  // Shared variables may only depend on other shared variables, and cannot be
+  // changed by generators. Their values are generated (with their own random
+  // seed) before the first test case, and do not count towards the generation
+  // limits. The names of all variables must be distinct.
+  //
+  // Crashes on failure. See `TryAddSharedVariable()` for non-crashing version.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  Moriarty& AddSharedVariable(absl::string_view name, T variable);
+
+  // TryAddSharedVariable()
+  //
+  // Adds a suite-level variable to Moriarty. See `AddSharedVariable()`.
+  //
+  // Returns status on failure. See `AddSharedVariable()` for simpler API
+  // version.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  absl::Status TryAddSharedVariable(absl::string_view name, T variable);
+
   // AddGenerator()
   //
   // Adds a generator to Moriarty. `generator.Generate()` will be called to
   // create one or more `Case`s. This generator will be called `call_n_times`
-  // times. Each call will use a different random seed.
+  // times. Each call will use a different random seed, which only depends on
+  // the seed, the position of this generator and the call number, so any
+  // call can be regenerated on its own (see `GenerateTestCasesFromCall()`).
   //
   // TODO(b/233664034): The following behavior may change in the future.
   // *Please do not depend on it.*
@@ -205,14 +283,100 @@ class Moriarty {
   // version.
   absl::Status TryGenerateTestCases();
 
+  // GenerateTestCasesFromCall()
+  //
+  // Generates only the cases created by call number `call` (1-based, up to
+  // `call_n_times`) of the generator named `generator_name`, without running
+  // any other generator or call. The values are identical to the ones that
+  // `GenerateTestCases()` generates for that call. The cases are stored
+  // internally (after any cases already stored) and are ready to be
+  // exported. Their `TestCaseMetadata` has the generator name and call
+  // number, but the test case numbers only count the stored cases.
+  //
+  // The approximate generation limit (see `SetApproximateGenerationLimit()`)
+  // is passed to the generator, but it never skips the call.
+  //
+  // Crashes on failure. See `TryGenerateTestCasesFromCall()` for non-crashing
+  // version.
+  void GenerateTestCasesFromCall(absl::string_view generator_name, int call);
+
+  // TryGenerateTestCasesFromCall()
+  //
+  // Generates only the cases created by call number `call` (1-based, up to
+  // `call_n_times`) of the generator named `generator_name`, without running
+  // any other generator or call. The values are identical to the ones that
+  // `GenerateTestCases()` generates for that call. The cases are stored
+  // internally (after any cases already stored) and are ready to be
+  // exported. Their `TestCaseMetadata` has the generator name and call
+  // number, but the test case numbers only count the stored cases.
+  //
+  // The approximate generation limit (see `SetApproximateGenerationLimit()`)
+  // is passed to the generator, but it never skips the call.
+  //
+  // Returns status on failure. See `GenerateTestCasesFromCall()` for simpler
+  // API version.
+  absl::Status TryGenerateTestCasesFromCall(absl::string_view generator_name,
+                                            int call);
+
   // ExportTestCases()
   //
-  // Exports all cases in order using the provided exporter. This exporter must
-  // be derived from `Exporter`. `exporter.Export()` will be called exactly
-  // once.
+  // Exports all cases in order using each of the provided exporters. Each
+  // exporter must be derived from `Exporter`. `exporter.Export()` will be
+  // called exactly once per exporter. Exporters whose cases are independent
+  // (e.g., `SimpleIOFileExporter`) may export them on `SetNumThreads()`
+  // threads.
+  //
+  // The test cases are not copied. If several exporters are given, they all
+  // read the same test cases and run at the same time on `SetNumThreads()`
+  // threads, so they must not share an output stream.
+  //
+  // Example usage:
+  //
+  //   std::ofstream file("tests.bin", std::ios::binary);
+  //   M.ExportTestCases(SimpleIO().AddLine("N").FileExporter(dir, "$0.in"),
+  //                     BinaryExporter(file));
+  template <typename... T>
+    requires(sizeof...(T) > 0 && (std::derived_from<T, Exporter> && ...))
+  void ExportTestCases(T... exporters);
+
+  // GenerateAndExportTestCases()
+  //
+  // Goes through all generators (in the same way as `GenerateTestCases()`) and
+  // exports each case with `exporter` as soon as it has been generated. The
+  // cases are not stored internally, so only a handful of them are in memory
+  // at any time. The values and `TestCaseMetadata` are the same as with
+  // `GenerateTestCases()` followed by `ExportTestCases()`.
+  //
+  //  * Generators are run one at a time (see `SetNumThreads()`).
+  //  * `exporter` may not call `NumTestCases()`, since it is not yet known.
+  //  * Cases already stored (e.g., from `ImportTestCases()`) are not exported.
+  //
+  // Crashes on failure. See `TryGenerateAndExportTestCases()` for non-crashing
+  // version.
+  template <typename T>
+    requires std::derived_from<T, Exporter>
+  void GenerateAndExportTestCases(T exporter);
+
+  // TryGenerateAndExportTestCases()
+  //
+  // Goes through all generators (in the same way as `GenerateTestCases()`) and
+  // exports each case with `exporter` as soon as it has been generated. The
+  // cases are not stored internally, so only a handful of them are in memory
+  // at any time. The values and `TestCaseMetadata` are the same as with
+  // `GenerateTestCases()` followed by `ExportTestCases()`.
+  //
+  //  * Generators are run one at a time (see `SetNumThreads()`).
+  //  * `exporter` may not call `NumTestCases()`, since it is not yet known.
+  //  * Cases already stored (e.g., from `ImportTestCases()`) are not exported.
+  //
+  // If generation fails, the cases generated before the failure will have
+  // been exported and `EndExport()` is still called.
+  //
+  // Returns status on failure. See `GenerateAndExportTestCases()` for simpler
+  // API version.
   template <typename T>
     requires std::derived_from<T, Exporter>
-  void ExportTestCases(T exporter);
+  absl::Status TryGenerateAndExportTestCases(T exporter);
 
   // ImportTestCases()
   //
@@ -226,9 +390,26 @@ class Moriarty {
   // TryValidateTestCases()
   //
   // Checks if all variables in all test cases are valid. If there are multiple
-  // failures, this will return one of them.
+  // failures, this will return the one from the earliest test case.
+  //
+  // The test cases are validated on `SetNumThreads()` threads. The result does
+  // not depend on the number of threads.
   absl::Status TryValidateTestCases();
 
+  // TryMinimizeTestCases()
+  //
+  // Replaces each test case for which `still_fails` returns true (e.g., a
+  // solution fails on it) with a smaller test case that is still valid and for
+  // which `still_fails` still returns true. Arrays and strings lose elements
+  // and integers move towards 0 (see `MVariable::ShrinkImpl()`). Test cases
+  // for which `still_fails` returns false are unchanged.
+  //
+  // The candidates are checked on `SetNumThreads()` threads, so `still_fails`
+  // may be called concurrently. The result does not depend on the number of
+  // threads.
+  absl::Status TryMinimizeTestCases(
+      absl::FunctionRef<bool(const ConstraintValues&)> still_fails);
+
   // SetApproximateGenerationLimit()
   //
   // Sets a threshold for approximately how much data to generate. If set,
@@ -239,13 +420,273 @@ class Moriarty {
   //
   // None of these values are guaranteed to remain the same in the future and
   // this function is a suggestion to Moriarty, not a guarantee that it will
-  // stop generation at any point.
+  // stop generation at any point. See `SetGenerationByteLimit()` for a limit
+  // that is enforced.
   void SetApproximateGenerationLimit(int64_t limit);
 
+  // SetGenerationByteLimit() [optional]
+  //
+  // Limits the total number of bytes of data in all generated test cases to
+  // `limit`, where the size of each value is its `MVariable::ValueByteSize()`
+  // (e.g., 8 per integer and 1 per character). Moriarty stops calling
+  // generators once `limit` is reached, and a test case that would exceed
+  // `limit` is dropped, so the test cases never exceed it.
+  //
+  // `limit` is also passed to generators as a soft limit (like the
+  // approximate generation limit), so that, e.g., arrays and strings choose
+  // lengths that fit.
+  Moriarty& SetGenerationByteLimit(int64_t limit);
+
+  // EnableGenerationLimitPlanning() [optional]
+  //
+  // Splits the generation limits (see `SetApproximateGenerationLimit()` and
+  // `SetGenerationByteLimit()`) between the generator calls up front, instead
+  // of passing the whole limit to every call. Each call of each generator gets
+  // a share in proportion to the generator's weight (see
+  // `SetGeneratorWeight()`), which is split evenly between the test cases it
+  // adds. So an early generator cannot use up the limit and leave nothing for
+  // the later ones, and generators running on several threads do not generate
+  // test cases that are thrown away.
+  //
+  // The share of a call only depends on the limits and the generators (with
+  // their weights and numbers of calls), so `GenerateTestCasesFromCall()` and
+  // shards (see `SetShard()`) still match `GenerateTestCases()`. Since every
+  // call already has its share, the approximate generation limit no longer
+  // stops generation early. The generation byte limit is still enforced. Off
+  // by default.
+  Moriarty& EnableGenerationLimitPlanning();
+
+  // SetGeneratorWeight() [optional]
+  //
+  // The share of the generation limits for each call of the generator named
+  // `generator_name`, relative to the calls of other generators, when the
+  // limits are planned (see `EnableGenerationLimitPlanning()`). For example, a
+  // generator of large test cases may have weight 10 and a generator of small
+  // examples weight 1. Default = 1.
+  //
+  // Crashes if `weight` is negative.
+  Moriarty& SetGeneratorWeight(absl::string_view generator_name,
+                               int64_t weight);
+
+  // SetNumThreads() [optional]
+  //
+  // Sets the number of threads used by `GenerateTestCases()` and
+  // `TryValidateTestCases()`. Each generator (along with all of its
+  // `call_n_times` iterations) is run on a single worker, and different
+  // generators may run concurrently. The generated test cases (values, order
+  // and metadata) are identical to those generated with a single thread.
+  // Validation reports the same failing case as with a single thread.
+  // Large arrays of independent elements are also generated on up to
+  // `num_threads` threads, again without changing their values. All of this
+  // work shares a single pool of threads (see `SetScheduler()`). Default = 1.
+  //
+  // Your generators must not share mutable state with one another.
+  //
+  // Crashes on failure. See `TrySetNumThreads()` for non-crashing version.
+  Moriarty& SetNumThreads(int num_threads);
+
+  // TrySetNumThreads() [optional]
+  //
+  // Sets the number of threads used by `GenerateTestCases()` and
+  // `TryValidateTestCases()`. Each generator (along with all of its
+  // `call_n_times` iterations) is run on a single worker, and different
+  // generators may run concurrently. The generated test cases (values, order
+  // and metadata) are identical to those generated with a single thread.
+  // Validation reports the same failing case as with a single thread.
+  // Large arrays of independent elements are also generated on up to
+  // `num_threads` threads, again without changing their values. All of this
+  // work shares a single pool of threads (see `SetScheduler()`). Default = 1.
+  //
+  // Your generators must not share mutable state with one another.
+  //
+  // Returns status on failure. See `SetNumThreads()` for simpler API version.
+  absl::Status TrySetNumThreads(int num_threads);
+
+  // SetScheduler() [optional]
+  //
+  // Runs all of the parallel work described in `SetNumThreads()` on
+  // `scheduler` (e.g., a wrapper around your own thread pool) instead of a
+  // pool created by Moriarty. The number of threads is
+  // `scheduler->NumThreads()`. This replaces any previous call to
+  // `SetNumThreads()`, and vice versa.
+  Moriarty& SetScheduler(
+      std::shared_ptr<moriarty_internal::Scheduler> scheduler);
+
+  // EnableGenerationProfiling() [optional]
+  //
+  // Records the wall time, number of generation attempts, rejections (by
+  // cause), approximate bytes generated and memory held for each variable
+  // during `GenerateTestCases()`, along with the memory held by the test cases
+  // of each generator. Retrieve the results with `GetGenerationProfile()`.
+  // Profiling slows down generation slightly, so it is off by default.
+  Moriarty& EnableGenerationProfiling();
+
+  // GetGenerationProfile()
+  //
+  // Returns the profile of all calls to `GenerateTestCases()` (and
+  // `GenerateAndExportTestCases()`) since `EnableGenerationProfiling()` was
+  // called. Each stack of variables starts with the name of the generator.
+  // See `GenerationProfile::ToJson()` and `GenerationProfile::ToFoldedStacks()`
+  // to dump it.
+  const moriarty_internal::GenerationProfile& GetGenerationProfile() const;
+
+  // EnableDuplicateTestCaseRemoval() [optional]
+  //
+  // Drops each generated test case that has exactly the same values as an
+  // earlier test case (generated or imported) in `GenerateTestCases()`, so
+  // duplicates do not cost a run of the solution. The metadata of the test
+  // case that is kept lists the dropped ones (see
+  // `TestCaseMetadata::GetDroppedDuplicates()`).
+  //
+  // Test cases are compared by a 128-bit fingerprint of their values. Test
+  // cases with values that cannot be fingerprinted (e.g., of custom MVariable
+  // types) are never dropped. Dropped test cases still count towards the
+  // generation limits. Off by default.
+  Moriarty& EnableDuplicateTestCaseRemoval();
+
+  // SetGeneratorBudget() [optional]
+  //
+  // Limits the work each generator may do across all of its `call_n_times`
+  // iterations: wall time, number of generate calls and approximate bytes
+  // generated. Each generator has its own budget. Once a generator exceeds
+  // its budget, `GenerateTestCases()` stops with a ResourceExhausted status.
+  // If profiling is enabled (see `EnableGenerationProfiling()`), that status
+  // contains the profile of the test case being generated.
+  //
+  // The limits are checked whenever a variable starts generating, so a single
+  // slow step (e.g., a custom constraint) may overrun them slightly.
+  Moriarty& SetGeneratorBudget(moriarty_internal::GenerationLimits limits);
+
+  // SetGeneratorBudget() [optional]
+  //
+  // Same as above, but only for the generator named `generator_name`. This
+  // takes priority over the budget for all generators.
+  Moriarty& SetGeneratorBudget(absl::string_view generator_name,
+                               moriarty_internal::GenerationLimits limits);
+
+  // SetTestCaseCache() [optional]
+  //
+  // Caches the test cases generated by each generator call in `directory`, so
+  // later runs with the same seed, generators and constraints read them from
+  // disk instead of regenerating them. The cache key contains `version`, the
+  // seed, the generator's name and iteration, the random engine version and
+  // the constraints (`ToString()`) of every variable in every test case.
+  //
+  // The key cannot see code: custom constraints are identified only by their
+  // names, and a generator's own logic is only seen through the constraints it
+  // adds. Change `version` (or clear `directory`) whenever such code changes,
+  // otherwise stale test cases are read from the cache.
+  //
+  // Generators whose values cannot be encoded (e.g., custom MVariable types)
+  // are not cached. Cached generator calls are not profiled and do not use
+  // their budget.
+  Moriarty& SetTestCaseCache(absl::string_view directory,
+                             absl::string_view version);
+
+  // SetCheckpointFile() [optional]
+  //
+  // Makes `GenerateTestCases()` record each generator call in the file at
+  // `path` as soon as it is done, so an interrupted run can be resumed: the
+  // next run with the same `path` reads the calls recorded there instead of
+  // generating them again, then continues from the first call that is
+  // missing. The test cases (and their metadata) are the same as in a run
+  // that was never interrupted.
+  //
+  //  * The file records the seed, the generators (names, `call_n_times` and
+  //    weights), the generation limits and the generator budgets, and is
+  //    rejected if any of those changed. Do not change the variables or the
+  //    generators between runs.
+  //  * Generator calls run one at a time (a single variable may still use
+  //    several threads, see `SetNumThreads()`).
+  //  * The file records the work done by each call (see
+  //    `SetGeneratorBudget()`), and calls read from it are charged to their
+  //    generator's budget as if they had been generated again.
+  //  * Generators whose values cannot be encoded (e.g., custom MVariable
+  //    types) cannot be checkpointed.
+  //  * The file is left in place afterwards. Delete it to start over.
+  Moriarty& SetCheckpointFile(absl::string_view path);
+
+  // SetShard() [optional]
+  //
+  // Splits the generator calls into `num_shards` disjoint shards, so they can
+  // be generated by different processes (or machines) with
+  // `GenerateShard()` and then merged with `MergeShards()`. The calls (every
+  // iteration of every generator, in order) are dealt out round-robin, so
+  // this process generates calls number `index`, `index + num_shards`, etc.
+  // `index` is 0-based. Default = shard 0 of 1 (all calls).
+  //
+  // Crashes on failure. See `TrySetShard()` for non-crashing version.
+  Moriarty& SetShard(int index, int num_shards);
+
+  // TrySetShard() [optional]
+  //
+  // Splits the generator calls into `num_shards` disjoint shards, so they can
+  // be generated by different processes (or machines) with
+  // `GenerateShard()` and then merged with `MergeShards()`. The calls (every
+  // iteration of every generator, in order) are dealt out round-robin, so
+  // this process generates calls number `index`, `index + num_shards`, etc.
+  // `index` is 0-based. Default = shard 0 of 1 (all calls).
+  //
+  // Returns status on failure. See `SetShard()` for simpler API version.
+  absl::Status TrySetShard(int index, int num_shards);
+
+  // GenerateShard()
+  //
+  // Generates the calls in this process's shard (see `SetShard()`) and
+  // writes them to `os` in Moriarty's binary format. The test cases are not
+  // stored internally. Generators whose values cannot be encoded (e.g., custom
+  // MVariable types) cannot be sharded.
+  //
+  //  * The calls are generated one at a time (see `SetNumThreads()`).
+  //  * Generator budgets (see `SetGeneratorBudget()`) apply to the calls of
+  //    each generator in this shard.
+  //  * Calls past the approximate generation limit are still generated, since
+  //    a shard does not know how much the other shards generated. The merge
+  //    drops them.
+  //  * A call that fails is written to the shard along with its error, which
+  //    `MergeShards()` returns if it reaches that call.
+  //
+  // Crashes on failure. See `TryGenerateShard()` for non-crashing version.
+  void GenerateShard(std::ostream& os);
+
+  // TryGenerateShard()
+  //
+  // Generates the calls in this process's shard (see `SetShard()`) and
+  // writes them to `os` in Moriarty's binary format. See `GenerateShard()`
+  // for details.
+  //
+  // Returns status on failure. See `GenerateShard()` for simpler API version.
+  absl::Status TryGenerateShard(std::ostream& os);
+
+  // MergeShards()
+  //
+  // Stores the test cases from all `shards` (the contents written by
+  // `GenerateShard()` for every shard index, in any order). The test cases,
+  // their order and their `TestCaseMetadata` are the same as with
+  // `GenerateTestCases()`, including the approximate generation limit. The
+  // generators must be added (with the same names and `call_n_times`) and
+  // the variables must be the same as in the processes that generated the
+  // shards. Each generator is called again to know the variables of its test
+  // cases, but no values are generated.
+  //
+  // Crashes on failure. See `TryMergeShards()` for non-crashing version.
+  void MergeShards(absl::Span<const absl::string_view> shards);
+
+  // TryMergeShards()
+  //
+  // Stores the test cases from all `shards` (the contents written by
+  // `GenerateShard()` for every shard index, in any order). See
+  // `MergeShards()` for details.
+  //
+  // Returns status on failure. See `MergeShards()` for simpler API version.
+  absl::Status TryMergeShards(absl::Span<const absl::string_view> shards);
+
  private:
   // Seed info
   static constexpr int kMinimumSeedLength = 10;
   std::vector<int64_t> seed_;
+  std::string random_engine_version_ =
+      std::string(moriarty_internal::kMersenneTwisterVersion);
 
   // Metadata
   std::string name_;
@@ -254,6 +695,11 @@ class Moriarty {
   // Variables
   moriarty_internal::VariableSet variables_;
 
+  // Suite-level variables (see `AddSharedVariable()`) and their values, which
+  // are generated by `GenerateSharedValues()`.
+  moriarty_internal::VariableSet shared_variables_;
+  std::shared_ptr<const moriarty_internal::ValueSet> shared_values_;
+
   // Generators
   struct GeneratorInfo {
     std::string name;
@@ -264,6 +710,35 @@ class Moriarty {
   };
   std::vector<GeneratorInfo> generators_;
   std::optional<int64_t> approximate_generation_limit_;
+  std::optional<int64_t> generation_byte_limit_;
+  bool plan_generation_limit_ = false;
+  absl::flat_hash_map<std::string, int64_t> generator_weights_;
+  // Runs all parallel work. If `nullptr`, everything runs on the calling
+  // thread.
+  std::shared_ptr<moriarty_internal::Scheduler> scheduler_;
+
+  // Budgets
+  std::optional<moriarty_internal::GenerationLimits> default_generator_limits_;
+  absl::flat_hash_map<std::string, moriarty_internal::GenerationLimits>
+      generator_limits_;
+
+  // Caching
+  std::optional<moriarty_internal::TestCaseCache> test_case_cache_;
+  std::string test_case_cache_version_;
+
+  // Checkpointing
+  std::optional<std::string> checkpoint_file_;
+
+  // Sharding
+  int shard_index_ = 0;
+  int num_shards_ = 1;
+
+  // Removing duplicate test cases
+  bool remove_duplicate_test_cases_ = false;
+
+  // Profiling
+  bool profile_generation_ = false;
+  moriarty_internal::GenerationProfile generation_profile_;
 
   // TestCases
   std::vector<moriarty_internal::ValueSet> assigned_test_cases_;
@@ -273,9 +748,185 @@ class Moriarty {
   // for specialized generators (e.g., min_, max_, random_ generators).
   absl::StatusOr<absl::Span<const int64_t>> GetSeedForGenerator(int index);
 
-  // Determines if a single test case is valid
+  // The seed index of the shared variables. Generators use non-negative ones.
+  static constexpr int kSharedValuesSeedIndex = -1;
+
+  // Generates the values of `shared_variables_` into `shared_values_`, unless
+  // that has already been done.
+  absl::Status GenerateSharedValues();
+
+  // Returns the variables known to exporters: `variables_` and
+  // `shared_variables_`.
+  moriarty_internal::VariableSet GetExportedVariables() const;
+
+  // Returns the seed for call number `call` of the generator whose seed is
+  // `generator_seed`. The first call uses `generator_seed` itself.
+  static std::vector<int64_t> GetSeedForGeneratorCall(
+      absl::Span<const int64_t> generator_seed, int call);
+
+  // The result of running all iterations of a single generator. If `status`
+  // is not ok, it is the failure from iteration `test_cases.size() + 1`.
+  struct GeneratorRun {
+    std::vector<std::vector<moriarty_internal::ValueSet>> test_cases;
+    absl::Status status;
+    moriarty_internal::GenerationProfile profile;
+  };
+
+  // Runs every iteration of `generator` using the random seed `seed`. Stops
+  // early once the generated test cases reach a generation limit (see
+  // `ReachedGenerationLimit()`). Only reads from `this`, so several generators
+  // may be run concurrently.
+  GeneratorRun RunGenerator(const GeneratorInfo& generator,
+                            absl::Span<const int64_t> seed) const;
+
+  // Returns a new budget for running `generator`, or `nullptr` if it has no
+  // limits.
+  std::unique_ptr<moriarty_internal::GenerationBudget> CreateGeneratorBudget(
+      const GeneratorInfo& generator) const;
+
+  // Runs iteration `call` of `generator` (which is managed by
+  // `generator_manager`) and assigns the values in all of its test cases. If
+  // profiling is enabled, the time spent is added to `profile`. If `budget` is
+  // set, assigning values stops once it is exceeded. If a test case cache is
+  // set, the values are read from (or written to) it.
+  absl::StatusOr<std::vector<moriarty_internal::ValueSet>>
+  RunGeneratorIteration(
+      const GeneratorInfo& generator,
+      moriarty_internal::GeneratorManager& generator_manager,
+      absl::Span<const int64_t> generator_seed, int call,
+      moriarty_internal::GenerationProfile& profile,
+      moriarty_internal::GenerationBudget* budget) const;
+
+  // Calls iteration `call` of `generator` (which is managed by
+  // `generator_manager`) so it adds its test cases, without assigning their
+  // values. Returns the seed of the iteration's random engine.
+  std::vector<int64_t> AddGeneratorIterationTestCases(
+      const GeneratorInfo& generator,
+      moriarty_internal::GeneratorManager& generator_manager,
+      absl::Span<const int64_t> generator_seed, int call) const;
+
+  // Sets up `generator_manager` for iteration `call` of `generator`, before
+  // any test case is added. Returns the seed of the iteration's random engine.
+  std::vector<int64_t> StartGeneratorIteration(
+      const GeneratorInfo& generator,
+      moriarty_internal::GeneratorManager& generator_manager,
+      absl::Span<const int64_t> generator_seed, int call) const;
+
+  // Returns the variables of all test cases (optional ones included) added to
+  // `generator_manager`. These are used to encode and decode their values.
+  static moriarty_internal::VariablesByName GetTestCaseVariables(
+      moriarty_internal::GeneratorManager& generator_manager);
+
+  // Returns the key identifying the test cases of iteration `call` of
+  // `generator`, whose test cases have already been added to
+  // `generator_manager` and whose random engine uses `seed`.
+  absl::StatusOr<std::string> GetTestCaseCacheKey(
+      const GeneratorInfo& generator,
+      moriarty_internal::GeneratorManager& generator_manager,
+      absl::Span<const int64_t> seed, int call) const;
+
+  // Receives each generated test case (in order) along with the metadata about
+  // which generator created it.
+  using TestCaseConsumer = absl::FunctionRef<void(
+      moriarty_internal::ValueSet,
+      TestCaseMetadata::GeneratedTestCaseMetadata)>;
+
+  // Runs all generators one after another on this thread, passing each test
+  // case to `consume` as soon as its generator iteration is done. Only one
+  // iteration's worth of test cases is held at any time (or, for a
+  // `StreamingGenerator`, only one of its test cases at a time).
+  absl::Status GenerateTestCasesSerially(TestCaseConsumer consume);
+
+  // The fingerprints of the stored test cases, used to drop duplicates (see
+  // `EnableDuplicateTestCaseRemoval()`). Empty if duplicates are kept.
+  struct StoredFingerprints {
+    moriarty_internal::VariablesByName variables;
+    // The index of the first stored test case with each fingerprint.
+    absl::flat_hash_map<absl::uint128, int> first_test_case;
+  };
+
+  // Returns the fingerprints of the test cases already stored.
+  StoredFingerprints FingerprintStoredTestCases() const;
+
+  // Stores `values` (and its metadata) after the test cases already stored,
+  // unless duplicates are removed and `fingerprints` already has a test case
+  // with the same values. In that case, the metadata is added to that test
+  // case's dropped duplicates instead.
+  void StoreTestCase(
+      moriarty_internal::ValueSet values,
+      TestCaseMetadata::GeneratedTestCaseMetadata generator_metadata,
+      StoredFingerprints& fingerprints);
+
+  // The total size of the test cases generated so far.
+  struct GenerationTotals {
+    int64_t approximate_size = 0;  // See `SetApproximateGenerationLimit()`.
+    int64_t bytes = 0;             // See `SetGenerationByteLimit()`.
+  };
+
+  // Returns true if `totals` has reached the approximate generation limit or
+  // the generation byte limit.
+  bool ReachedGenerationLimit(const GenerationTotals& totals) const;
+
+  // The soft limit passed to generators: the smaller of the approximate
+  // generation limit and the generation byte limit.
+  std::optional<int64_t> SoftGenerationLimit() const;
+
+  // The soft limit passed to call `call` of `generator` (an element of
+  // `generators_`). This is `SoftGenerationLimit()`, or its share for this
+  // call if the limits are planned (see `EnableGenerationLimitPlanning()`).
+  std::optional<int64_t> GenerationLimitForCall(const GeneratorInfo& generator,
+                                                int call) const;
+
+  // Passes `test_cases` (from iteration `call` of `generator`) to `consume`
+  // and adds them to `totals`. Test cases that would exceed the generation
+  // byte limit are not passed. Returns `true` if a generation limit has been
+  // reached.
+  bool ConsumeTestCases(const GeneratorInfo& generator, int call,
+                        std::vector<moriarty_internal::ValueSet> test_cases,
+                        GenerationTotals& totals,
+                        TestCaseConsumer consume) const;
+
+  // Passes `values` (test case `case_number` of iteration `call` of
+  // `generator`) to `consume`, as in `ConsumeTestCases()`. Returns `true` if
+  // generation should stop: `values` did not fit in the generation byte limit,
+  // or `generator` is a `StreamingGenerator` and a generation limit has been
+  // reached.
+  bool ConsumeTestCase(const GeneratorInfo& generator, int call,
+                       int case_number, moriarty_internal::ValueSet values,
+                       GenerationTotals& totals,
+                       TestCaseConsumer consume) const;
+
+  // Runs iteration `call` of `generator`, a `StreamingGenerator`, passing each
+  // test case to `consume` (as in `ConsumeTestCases()`) before the next one is
+  // added. Returns `true` if a generation limit has been reached.
+  absl::StatusOr<bool> StreamGeneratorIteration(
+      const GeneratorInfo& generator,
+      moriarty_internal::GeneratorManager& generator_manager,
+      absl::Span<const int64_t> generator_seed, int call,
+      moriarty_internal::GenerationProfile& profile,
+      moriarty_internal::GenerationBudget* budget, GenerationTotals& totals,
+      TestCaseConsumer consume) const;
+
+  // Generates all test cases one generator call at a time (as
+  // `GenerateTestCasesSerially()`), recording each call in the checkpoint file
+  // and reading the calls already recorded there instead of generating them.
+  absl::Status GenerateTestCasesWithCheckpoint(TestCaseConsumer consume);
+
+  // Returns the key identifying this run in its checkpoint file. See
+  // `SetCheckpointFile()` for what it contains.
+  std::string GetCheckpointRunKey() const;
+
+  // Non-template implementation of `TryGenerateAndExportTestCases()`.
+  absl::Status GenerateAndStreamTestCases(Exporter& exporter);
+
+  // Determines if a single test case is valid. `variables` will be pointed at
+  // a Universe containing `values` (and the scheduler, if any).
   absl::Status TryValidateSingleTestCase(
-      const moriarty_internal::ValueSet& values);
+      const moriarty_internal::ValueSet& values,
+      moriarty_internal::VariableSet& variables) const;
+
+  // Returns the number of threads of `scheduler_` (1 if there is none).
+  int NumThreads() const;
 
   // Determines if a variable name is valid.
   static absl::Status ValidateVariableName(absl::string_view name);
@@ -299,11 +950,42 @@ template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 absl::Status Moriarty::TryAddVariable(absl::string_view name, T variable) {
   MORIARTY_RETURN_IF_ERROR(ValidateVariableName(name));
+  if (shared_variables_.GetHandle(name).has_value()) {
+    return absl::AlreadyExistsError(
+        absl::StrCat("'", name, "' is already a shared variable"));
+  }
   MORIARTY_RETURN_IF_ERROR(variables_.AddVariable(name, std::move(variable)))
       << "Adding the same variable multiple times";
   return absl::OkStatus();
 }
 
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+Moriarty& Moriarty::AddSharedVariable(absl::string_view name, T variable) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&, this]() {
+        return this->TryAddSharedVariable<T>(name, std::move(variable));
+      },
+      "AddSharedVariable");
+  return *this;
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::Status Moriarty::TryAddSharedVariable(absl::string_view name,
+                                            T variable) {
+  MORIARTY_RETURN_IF_ERROR(ValidateVariableName(name));
+  if (variables_.GetHandle(name).has_value()) {
+    return absl::AlreadyExistsError(
+        absl::StrCat("'", name, "' is already a (non-shared) variable"));
+  }
+  MORIARTY_RETURN_IF_ERROR(
+      shared_variables_.AddVariable(name, std::move(variable)))
+      << "Adding the same variable multiple times";
+  shared_values_ = nullptr;  // Generated again with the new variable.
+  return absl::OkStatus();
+}
+
 template <typename T>
   requires std::derived_from<T, Generator>
 Moriarty& Moriarty::AddGenerator(absl::string_view name, T generator,
@@ -317,15 +999,44 @@ Moriarty& Moriarty::AddGenerator(absl::string_view name, T generator,
   return *this;
 }
 
+template <typename... T>
+  requires(sizeof...(T) > 0 && (std::derived_from<T, Exporter> && ...))
+void Moriarty::ExportTestCases(T... exporters) {
+  std::array<Exporter*, sizeof...(T)> all_exporters = {&exporters...};
+  for (Exporter* exporter : all_exporters) {
+    moriarty_internal::ExporterManager manager(exporter);
+    // The test cases are not copied, so they must not change during the
+    // export.
+    manager.BorrowAllValues(assigned_test_cases_);
+    manager.SetTestCaseMetadata(test_case_metadata_);
+    manager.SetGeneralConstraints(GetExportedVariables());
+    manager.SetSharedValues(shared_values_);
+    manager.SetScheduler(scheduler_.get());
+  }
+
+  if (all_exporters.size() == 1 || scheduler_ == nullptr) {
+    for (Exporter* exporter : all_exporters) exporter->ExportTestCases();
+    return;
+  }
+  scheduler_->ParallelFor(all_exporters.size(), [&](int idx) {
+    all_exporters[idx]->ExportTestCases();
+  });
+}
+
 template <typename T>
   requires std::derived_from<T, Exporter>
-void Moriarty::ExportTestCases(T exporter) {
-  moriarty_internal::ExporterManager manager(&exporter);
-  manager.SetAllValues(assigned_test_cases_);
-  manager.SetTestCaseMetadata(test_case_metadata_);
-  manager.SetGeneralConstraints(variables_);
+void Moriarty::GenerateAndExportTestCases(T exporter) {
+  moriarty_internal::TryFunctionOrCrash(
+      [&, this]() {
+        return this->TryGenerateAndExportTestCases(std::move(exporter));
+      },
+      "GenerateAndExportTestCases");
+}
 
-  exporter.ExportTestCases();
+template <typename T>
+  requires std::derived_from<T, Exporter>
+absl::Status Moriarty::TryGenerateAndExportTestCases(T exporter) {
+  return GenerateAndStreamTestCases(exporter);
 }
 
 template <typename T>
@@ -335,8 +1046,8 @@ absl::Status Moriarty::ImportTestCases(T importer) {
       variables_);
 
   MORIARTY_RETURN_IF_ERROR(importer.ImportTestCases()) << "Importer failed.";
-  for (moriarty_internal::ValueSet values :
-       moriarty_internal::ImporterManager(&importer).GetTestCases()) {
+  for (moriarty_internal::ValueSet& values :
+       moriarty_internal::ImporterManager(&importer).TakeTestCases()) {
     assigned_test_cases_.push_back(std::move(values));
     test_case_metadata_.push_back(
         TestCaseMetadata().SetTestCaseNumber(assigned_test_cases_.size()));
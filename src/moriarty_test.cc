@@ -14,21 +14,38 @@
 
 #include "src/moriarty.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/constraint_values.h"
+#include "src/internal/generation_profile.h"
+#include "src/internal/scheduler.h"
+#include "src/simple_io.h"
 #include "src/test_case.h"
 #include "src/testing/exporter_test_util.h"
 #include "src/testing/generator_test_util.h"
 #include "src/testing/importer_test_util.h"
 #include "src/testing/mtest_type.h"
 #include "src/testing/status_test_util.h"
+#include "src/util/status_macro/status_macros.h"
 #include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
 #include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
 
 namespace moriarty {
 namespace {
@@ -46,10 +63,16 @@ using ::moriarty_testing::TwoIntegerGenerator;
 using ::moriarty_testing::TwoIntegerGeneratorWithRandomness;
 using ::moriarty_testing::TwoTestTypeWrongTypeExporter;
 using ::moriarty_testing::TwoVariableFromVectorImporter;
+using ::testing::Contains;
+using ::testing::Each;
 using ::testing::ElementsAre;
 using ::testing::Field;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Key;
 using ::testing::Le;
+using ::testing::Not;
+using ::testing::Pair;
 using ::testing::SizeIs;
 
 TEST(MoriartyTest, SetNumCasesWorksForValidInput) {
@@ -84,6 +107,15 @@ TEST(MoriartyDeathTest, ShouldSeedWithInvalidInputShouldCrash) {
   EXPECT_DEATH(M.SetSeed("abcde"), "seed's length must be at least");
 }
 
+TEST(MoriartyTest, SetRandomEngineVersionShouldAcceptOnlyKnownVersions) {
+  moriarty::Moriarty M;
+
+  MORIARTY_EXPECT_OK(M.TrySetRandomEngineVersion("v0.1"));
+  MORIARTY_EXPECT_OK(M.TrySetRandomEngineVersion("v0.2"));
+  EXPECT_THAT(M.TrySetRandomEngineVersion("v9.9"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(MoriartyTest, AddVariableWorks) {
   moriarty::Moriarty M;
 
@@ -260,6 +292,49 @@ TEST(MoriartyTest, ExportCasesShouldExportProperMetadata) {
   }
 }
 
+TEST(MoriartyTest, DuplicateTestCaseRemovalKeepsTheFirstOfEachTestCase) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("R", MInteger());
+  M.AddVariable("S", MInteger());
+  M.AddGenerator("Gen 1", TwoIntegerGenerator(1, 11), 2);
+  M.AddGenerator("Gen 2", TwoIntegerGenerator(2, 22), 3);
+  M.EnableDuplicateTestCaseRemoval();
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+
+  ASSERT_THAT(test_cases, SizeIs(2));
+  EXPECT_EQ(test_cases[0].r, 1);
+  EXPECT_EQ(test_cases[1].r, 2);
+  EXPECT_EQ(test_cases[1].metadata.GetTestCaseNumber(), 2);
+
+  std::vector<int> dropped_iterations;
+  for (const TestCaseMetadata::GeneratedTestCaseMetadata& dropped :
+       test_cases[0].metadata.GetDroppedDuplicates()) {
+    EXPECT_EQ(dropped.generator_name, "Gen 1");
+    dropped_iterations.push_back(dropped.generator_iteration);
+  }
+  EXPECT_THAT(dropped_iterations, ElementsAre(1, 2, 2));
+  EXPECT_THAT(test_cases[1].metadata.GetDroppedDuplicates(), SizeIs(5));
+}
+
+TEST(MoriartyTest, DuplicateTestCasesAreKeptByDefault) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Gen 1", TwoIntegerGenerator(1, 11), 2);
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+
+  ASSERT_THAT(test_cases, SizeIs(4));
+  EXPECT_THAT(test_cases[0].metadata.GetDroppedDuplicates(), IsEmpty());
+}
+
 TEST(MoriartyTest, GeneralConstraintsSetValueAreConsideredInGenerators) {
   moriarty::Moriarty M;
   M.SetSeed("abcde0123456789");
@@ -292,6 +367,81 @@ TEST(MoriartyTest, GeneralConstraintsAreConsideredInGenerators) {
   }
 }
 
+TEST(MoriartyTest, GenerationProfilingCountsRejectionsPerVariable) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("R", MInteger().AddCustomConstraint(
+                         "Even", [](const int64_t& x) { return x % 2 == 0; }));
+  M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness(), 10);
+  M.EnableGenerationProfiling();
+  M.GenerateTestCases();
+
+  const moriarty_internal::GenerationProfile& profile =
+      M.GetGenerationProfile();
+  EXPECT_THAT(profile.Entries(), Contains(Key("Two Var;R")));
+  auto by_variable = profile.EntriesByVariable();
+  ASSERT_TRUE(by_variable.contains("R"));
+  EXPECT_GT(by_variable["R"].custom_constraint_rejections, 0);
+  EXPECT_EQ(by_variable["R"].generate_attempts,
+            by_variable["R"].custom_constraint_rejections + 40);
+  ASSERT_TRUE(by_variable.contains("S"));
+  EXPECT_EQ(by_variable["S"].custom_constraint_rejections, 0);
+}
+
+TEST(MoriartyTest, GenerationProfileIsEmptyWithoutProfiling) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness(), 10);
+  M.GenerateTestCases();
+
+  EXPECT_TRUE(M.GetGenerationProfile().empty());
+}
+
+TEST(MoriartyTest, GeneratorsThatExceedTheirBudgetShouldFail) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness(), 10);
+  M.SetGeneratorBudget({.max_generate_calls = 20});
+
+  EXPECT_THAT(M.TryGenerateTestCases(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("more than 20 generate calls")));
+}
+
+TEST(MoriartyTest, GeneratorBudgetsApplyToEachGeneratorSeparately) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Gen 1", TwoIntegerGeneratorWithRandomness(), 2);
+  M.AddGenerator("Gen 2", TwoIntegerGeneratorWithRandomness(), 2);
+  M.SetGeneratorBudget({.max_generate_calls = 16});
+
+  MORIARTY_EXPECT_OK(M.TryGenerateTestCases());
+}
+
+TEST(MoriartyTest, GeneratorBudgetForASingleGeneratorOverridesTheDefault) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Small", TwoIntegerGeneratorWithRandomness(), 1);
+  M.AddGenerator("Big", TwoIntegerGeneratorWithRandomness(), 10);
+  M.SetGeneratorBudget({.max_generate_calls = 10});
+  M.SetGeneratorBudget("Big", {.max_generate_calls = 100});
+
+  MORIARTY_EXPECT_OK(M.TryGenerateTestCases());
+}
+
+TEST(MoriartyTest, GeneratorBudgetFailuresIncludeTheProfileIfProfiling) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.SetNumThreads(2);
+  M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness(), 10);
+  M.SetGeneratorBudget("Two Var", {.max_bytes = 100});
+  M.EnableGenerationProfiling();
+
+  EXPECT_THAT(M.TryGenerateTestCases(),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("Generation profile: {\"variables\"")));
+}
+
 TEST(MoriartyTest, ImporterShouldProperlyImportData) {
   using Case = ExampleTestCase;
   Moriarty M;
@@ -305,6 +455,26 @@ TEST(MoriartyTest, ImporterShouldProperlyImportData) {
                                       Case({.n = 3}), Case({.n = 4})));
 }
 
+TEST(MoriartyTest, ExportTestCasesWithSeveralExportersExportsToEachOfThem) {
+  using Case = ExampleTestCase;
+  for (int num_threads : {1, 4}) {
+    Moriarty M;
+    M.SetNumThreads(num_threads);
+    MORIARTY_EXPECT_OK(
+        M.ImportTestCases(SingleIntegerFromVectorImporter({1, 2, 3})));
+
+    std::vector<ExampleTestCase> first, second, third;
+    M.ExportTestCases(SingleIntegerExporter(&first),
+                      SingleIntegerExporter(&second),
+                      SingleIntegerExporter(&third));
+
+    auto expected = ElementsAre(Case({.n = 1}), Case({.n = 2}), Case({.n = 3}));
+    EXPECT_THAT(first, expected);
+    EXPECT_THAT(second, expected);
+    EXPECT_THAT(third, expected);
+  }
+}
+
 TEST(MoriartyTest, ValidateAllTestCasesWorksWhenAllVariablesAreValid) {
   Moriarty M;
   M.AddVariable("N", MInteger().Between(1, 5));
@@ -342,6 +512,51 @@ TEST(MoriartyTest, ValidateAllTestCasesFailsIfAVariableIsMissing) {
   EXPECT_THAT(M.TryValidateTestCases(), IsValueNotFound("X"));
 }
 
+TEST(MoriartyTest, ValidateAllTestCasesWithThreadsWorksWhenAllValid) {
+  Moriarty M;
+  M.AddVariable("N", MInteger().Between(1, 100)).SetNumThreads(4);
+  std::vector<int> values(100);
+  for (int i = 0; i < values.size(); i++) values[i] = i + 1;
+  MORIARTY_EXPECT_OK(
+      M.ImportTestCases(SingleIntegerFromVectorImporter(values)));
+  MORIARTY_EXPECT_OK(M.TryValidateTestCases());
+}
+
+TEST(MoriartyTest, ValidateAllTestCasesWithThreadsReportsTheFirstFailure) {
+  for (int num_threads : {1, 2, 3, 8}) {
+    Moriarty M;
+    M.AddVariable("N", MInteger().Between(1, 50)).SetNumThreads(num_threads);
+    std::vector<int> values(100);
+    for (int i = 0; i < values.size(); i++) values[i] = i + 1;
+    values[30] = 0;  // Case 31
+    MORIARTY_EXPECT_OK(
+        M.ImportTestCases(SingleIntegerFromVectorImporter(values)));
+
+    EXPECT_THAT(M.TryValidateTestCases(), IsUnsatisfiedConstraint("Case 31"))
+        << "num_threads = " << num_threads;
+  }
+}
+
+TEST(MoriartyTest, MinimizeTestCasesShrinksOnlyTheFailingTestCases) {
+  using Case = ExampleTestCase;
+  for (int num_threads : {1, 4}) {
+    Moriarty M;
+    M.AddVariable("N", MInteger().Between(1, 100)).SetNumThreads(num_threads);
+    MORIARTY_EXPECT_OK(
+        M.ImportTestCases(SingleIntegerFromVectorImporter({50, 8, 90})));
+
+    MORIARTY_EXPECT_OK(
+        M.TryMinimizeTestCases([](const ConstraintValues& values) {
+          return values.GetValue<MInteger>("N") >= 20;
+        }));
+
+    std::vector<Case> test_cases;
+    M.ExportTestCases(SingleIntegerExporter(&test_cases));
+    EXPECT_THAT(test_cases, ElementsAre(Case({.n = 20}), Case({.n = 8}),
+                                        Case({.n = 20})));
+  }
+}
+
 TEST(MoriartyTest, ApproximateGenerationLimitStopsGenerationEarly) {
   using Case = ExampleTestCase;
 
@@ -381,6 +596,870 @@ TEST(MoriartyTest, ApproximateGenerationLimitTruncatesTheSizeOfArrays) {
                                      SizeIs(Le(30)))));
 }
 
+// Two generators of 3 strings per call: "Small" (weight 1) and "Large"
+// (weight 4), each called twice.
+moriarty::Moriarty MoriartyWithPlannedGenerationLimit() {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Small", SingleStringGenerator(), 2);
+  M.AddGenerator("Large", SingleStringGenerator(), 2);
+  M.SetApproximateGenerationLimit(300);
+  M.EnableGenerationLimitPlanning();
+  M.SetGeneratorWeight("Large", 4);
+  return M;
+}
+
+TEST(MoriartyTest, PlannedGenerationLimitIsSplitBetweenAllCalls) {
+  moriarty::Moriarty M = MoriartyWithPlannedGenerationLimit();
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  moriarty_testing::SingleStringExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+
+  // The total weight is 2 * 1 + 2 * 4 = 10, so each call of "Small" gets 30
+  // (10 per test case) and each call of "Large" gets 120 (40 per test case).
+  ASSERT_THAT(test_cases, SizeIs(12));
+  for (const ExampleTestCase& c : test_cases) {
+    const auto& metadata = *c.metadata.GetGeneratorMetadata();
+    int max_length = metadata.generator_name == "Small" ? 10 : 40;
+    EXPECT_THAT(c.str, SizeIs(Le(max_length)));
+  }
+}
+
+TEST(MoriartyTest, PlannedGenerationLimitShouldMatchGenerateTestCasesFromCall) {
+  moriarty::Moriarty all = MoriartyWithPlannedGenerationLimit();
+  all.GenerateTestCases();
+  std::vector<ExampleTestCase> all_test_cases;
+  moriarty_testing::SingleStringExporter all_exporter(&all_test_cases);
+  all.ExportTestCases(all_exporter);
+  ASSERT_THAT(all_test_cases, SizeIs(12));
+
+  moriarty::Moriarty M = MoriartyWithPlannedGenerationLimit();
+  M.GenerateTestCasesFromCall("Large", 2);
+  std::vector<ExampleTestCase> test_cases;
+  moriarty_testing::SingleStringExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+
+  ASSERT_THAT(test_cases, SizeIs(3));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(test_cases[i].str, all_test_cases[9 + i].str);
+  }
+}
+
+TEST(MoriartyTest, GenerationByteLimitShouldNeverBeExceeded) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Generator", TwoIntegerGenerator(1, 11), 50);
+
+  // Each test case has 2 integers (16 bytes). After 6 test cases (96 bytes),
+  // the next one does not fit.
+  M.SetGenerationByteLimit(100);
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+
+  EXPECT_THAT(test_cases, SizeIs(6));
+}
+
+// Generates one case with an array of strings A.
+class StringArrayGenerator : public Generator {
+ public:
+  void GenerateTestCases() override {
+    AddTestCase().ConstrainVariable(
+        "A", MArray<MString>()
+                 .OfLength(1, 1000)
+                 .Of(MString().OfLength(1, 1000).WithAlphabet(
+                     MString::kLowerCase)));
+  }
+};
+
+class StringArrayExporter : public Exporter {
+ public:
+  explicit StringArrayExporter(std::vector<std::vector<std::string>>* arrays)
+      : arrays_(*arrays) {}
+
+  void ExportTestCase() override {
+    arrays_.push_back(GetValue<MArray<MString>>("A"));
+  }
+
+ private:
+  std::vector<std::vector<std::string>>& arrays_;
+};
+
+TEST(MoriartyTest, GenerationByteLimitShouldBeSharedByTheElementsOfArrays) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Generator", StringArrayGenerator(), 20);
+  M.SetGenerationByteLimit(1000);
+  M.GenerateTestCases();
+
+  std::vector<std::vector<std::string>> arrays;
+  StringArrayExporter exporter(&arrays);
+  M.ExportTestCases(exporter);
+
+  // Each string is at most 1000 / (length of the array) characters, so at
+  // least the first test case fits.
+  ASSERT_THAT(arrays, Not(IsEmpty()));
+  int64_t total_length = 0;
+  for (const std::vector<std::string>& array : arrays) {
+    for (const std::string& str : array) total_length += str.size();
+  }
+  EXPECT_LE(total_length, 1000);
+}
+
+TEST(MoriartyTest, SetNumThreadsWithInvalidInputShouldFail) {
+  EXPECT_THAT(Moriarty().TrySetNumThreads(0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Moriarty().TrySetNumThreads(-1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  MORIARTY_EXPECT_OK(Moriarty().TrySetNumThreads(1));
+  MORIARTY_EXPECT_OK(Moriarty().TrySetNumThreads(8));
+}
+
+// Generates test cases from several random generators using `num_threads`.
+moriarty::Moriarty MoriartyWithSeveralGenerators(
+    std::optional<int64_t> generation_limit) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("R", MInteger().Between(3, 50));
+  M.AddGenerator("Gen 1", TwoIntegerGeneratorWithRandomness(), 7);
+  M.AddGenerator("Gen 2", TwoIntegerGenerator(3, 33), 2);
+  M.AddGenerator("Gen 3", TwoIntegerGeneratorWithRandomness(), 5);
+  M.AddGenerator("Gen 4", TwoIntegerGeneratorWithRandomness(), 1);
+  if (generation_limit) M.SetApproximateGenerationLimit(*generation_limit);
+  return M;
+}
+
+std::vector<ExampleTestCase> GenerateWithThreads(
+    int num_threads, std::optional<int64_t> generation_limit = std::nullopt) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(generation_limit);
+  M.SetNumThreads(num_threads);
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+  return test_cases;
+}
+
+// ExampleTestCase's equality does not consider R and S.
+std::vector<std::pair<int, int>> GetRAndS(
+    const std::vector<ExampleTestCase>& test_cases) {
+  std::vector<std::pair<int, int>> result;
+  for (const ExampleTestCase& c : test_cases) result.push_back({c.r, c.s});
+  return result;
+}
+
+TEST(MoriartyTest, MultipleThreadsShouldGenerateTheSameTestCases) {
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1);
+  ASSERT_THAT(expected, SizeIs(4 * 7 + 2 * 2 + 4 * 5 + 4 * 1));
+
+  for (int num_threads : {2, 3, 4, 16}) {
+    std::vector<ExampleTestCase> test_cases = GenerateWithThreads(num_threads);
+    EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+
+    ASSERT_THAT(test_cases, SizeIs(expected.size()));
+    for (int i = 0; i < test_cases.size(); i++) {
+      const auto& metadata = test_cases[i].metadata;
+      const auto& expected_metadata = expected[i].metadata;
+      EXPECT_EQ(metadata.GetTestCaseNumber(), i + 1);
+      EXPECT_EQ(metadata.GetGeneratorMetadata()->generator_name,
+                expected_metadata.GetGeneratorMetadata()->generator_name);
+      EXPECT_EQ(metadata.GetGeneratorMetadata()->generator_iteration,
+                expected_metadata.GetGeneratorMetadata()->generator_iteration);
+      EXPECT_EQ(
+          metadata.GetGeneratorMetadata()->case_number_in_generator,
+          expected_metadata.GetGeneratorMetadata()->case_number_in_generator);
+    }
+  }
+}
+
+std::vector<ExampleTestCase> GenerateWithRandomEngineVersion(
+    absl::string_view version, int num_threads) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  M.SetRandomEngineVersion(version);
+  M.SetNumThreads(num_threads);
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  M.ExportTestCases(TwoIntegerExporter(&test_cases));
+  return test_cases;
+}
+
+TEST(MoriartyTest, RandomEngineVersionShouldSelectTheRandomEngine) {
+  std::vector<ExampleTestCase> v1 = GenerateWithRandomEngineVersion("v0.1", 1);
+  std::vector<ExampleTestCase> v2 = GenerateWithRandomEngineVersion("v0.2", 1);
+
+  EXPECT_EQ(GetRAndS(v1), GetRAndS(GenerateWithThreads(1)));
+  EXPECT_NE(GetRAndS(v2), GetRAndS(v1));
+  for (int num_threads : {2, 4}) {
+    EXPECT_EQ(GetRAndS(GenerateWithRandomEngineVersion("v0.2", num_threads)),
+              GetRAndS(v2));
+  }
+}
+
+TEST(MoriartyTest, MultipleThreadsShouldRespectApproximateGenerationLimit) {
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1, 50);
+  // Each test case has size 2. Gen 1 creates 4 test cases per call, so 7 calls
+  // (size 56) are more than enough.
+  EXPECT_THAT(expected, SizeIs(28));
+
+  EXPECT_EQ(GetRAndS(GenerateWithThreads(4, 50)), GetRAndS(expected));
+}
+
+// Claims to have several threads, but runs every task on the caller's thread
+// in reverse order.
+class ReversingScheduler : public moriarty_internal::Scheduler {
+ public:
+  int NumThreads() const override { return 4; }
+  void ParallelFor(int num_tasks, absl::FunctionRef<void(int)> task) override {
+    num_calls_++;
+    for (int i = num_tasks - 1; i >= 0; i--) task(i);
+  }
+  int NumCalls() const { return num_calls_; }
+
+ private:
+  int num_calls_ = 0;
+};
+
+TEST(MoriartyTest, InjectedSchedulerShouldRunParallelWork) {
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1);
+
+  auto scheduler = std::make_shared<ReversingScheduler>();
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  M.SetScheduler(scheduler);
+  M.GenerateTestCases();
+  EXPECT_EQ(scheduler->NumCalls(), 1);
+  MORIARTY_EXPECT_OK(M.TryValidateTestCases());
+  EXPECT_EQ(scheduler->NumCalls(), 2);
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+  EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+}
+
+TEST(MoriartyTest, MultipleThreadsShouldReturnGeneratorFailures) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("N", MInteger().Is(5));
+  M.AddGenerator("Gen 1", TwoIntegerGenerator(1, 11));
+  M.AddGenerator("Gen 2", SingleIntegerGenerator());  // N = 0 always fails.
+  M.SetNumThreads(2);
+
+  EXPECT_FALSE(M.TryGenerateTestCases().ok());
+}
+
+std::vector<ExampleTestCase> GenerateAndExportWhileStreaming(
+    std::optional<int64_t> generation_limit = std::nullopt) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(generation_limit);
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.GenerateAndExportTestCases(exporter);
+  return test_cases;
+}
+
+TEST(MoriartyTest, GenerateAndExportTestCasesShouldMatchGenerateThenExport) {
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1);
+  std::vector<ExampleTestCase> test_cases = GenerateAndExportWhileStreaming();
+  EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+
+  ASSERT_THAT(test_cases, SizeIs(expected.size()));
+  for (int i = 0; i < test_cases.size(); i++) {
+    const auto& metadata = test_cases[i].metadata;
+    const auto& expected_metadata = expected[i].metadata;
+    EXPECT_EQ(metadata.GetTestCaseNumber(), i + 1);
+    EXPECT_EQ(metadata.GetGeneratorMetadata()->generator_name,
+              expected_metadata.GetGeneratorMetadata()->generator_name);
+    EXPECT_EQ(metadata.GetGeneratorMetadata()->generator_iteration,
+              expected_metadata.GetGeneratorMetadata()->generator_iteration);
+    EXPECT_EQ(
+        metadata.GetGeneratorMetadata()->case_number_in_generator,
+        expected_metadata.GetGeneratorMetadata()->case_number_in_generator);
+  }
+}
+
+TEST(MoriartyTest, GenerateTestCasesFromCallShouldMatchGenerateTestCases) {
+  std::vector<ExampleTestCase> all_test_cases = GenerateWithThreads(1);
+
+  for (auto [generator_name, call] :
+       std::vector<std::pair<std::string, int>>(
+           {{"Gen 1", 1}, {"Gen 1", 5}, {"Gen 2", 2}, {"Gen 3", 4}})) {
+    moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+    M.GenerateTestCasesFromCall(generator_name, call);
+    std::vector<ExampleTestCase> test_cases;
+    TwoIntegerExporter exporter(&test_cases);
+    M.ExportTestCases(exporter);
+
+    std::vector<ExampleTestCase> expected;
+    for (const ExampleTestCase& c : all_test_cases) {
+      const auto& metadata = *c.metadata.GetGeneratorMetadata();
+      if (metadata.generator_name == generator_name &&
+          metadata.generator_iteration == call) {
+        expected.push_back(c);
+      }
+    }
+    ASSERT_THAT(expected, Not(IsEmpty()));
+    EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+
+    ASSERT_THAT(test_cases, SizeIs(expected.size()));
+    for (int i = 0; i < test_cases.size(); i++) {
+      const auto& metadata = *test_cases[i].metadata.GetGeneratorMetadata();
+      EXPECT_EQ(test_cases[i].metadata.GetTestCaseNumber(), i + 1);
+      EXPECT_EQ(metadata.generator_name, generator_name);
+      EXPECT_EQ(metadata.generator_iteration, call);
+      EXPECT_EQ(metadata.case_number_in_generator, i + 1);
+    }
+  }
+}
+
+TEST(MoriartyTest, DifferentCallsOfAGeneratorShouldUseDifferentSeeds) {
+  std::vector<ExampleTestCase> test_cases = GenerateWithThreads(1);
+  // Gen 1 creates 4 test cases per call.
+  std::vector<std::pair<int, int>> values = GetRAndS(test_cases);
+  EXPECT_NE(std::vector(values.begin(), values.begin() + 4),
+            std::vector(values.begin() + 4, values.begin() + 8));
+}
+
+TEST(MoriartyTest, GenerateTestCasesFromCallWithUnknownGeneratorShouldFail) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  EXPECT_THAT(M.TryGenerateTestCasesFromCall("Gen 5", 1),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(MoriartyTest, GenerateTestCasesFromCallWithInvalidCallShouldFail) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  EXPECT_THAT(M.TryGenerateTestCasesFromCall("Gen 2", 0),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(M.TryGenerateTestCasesFromCall("Gen 2", 3),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  MORIARTY_EXPECT_OK(M.TryGenerateTestCasesFromCall("Gen 2", 2));
+}
+
+std::vector<ExampleTestCase> GenerateWithCache(
+    absl::string_view directory, absl::string_view seed,
+    absl::string_view version = "1", int num_threads = 1) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  M.SetSeed(seed);
+  M.SetTestCaseCache(directory, version);
+  M.SetNumThreads(num_threads);
+  M.GenerateTestCases();
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+  return test_cases;
+}
+
+std::string EmptyTempDirectory(absl::string_view name) {
+  std::filesystem::path path =
+      std::filesystem::path(::testing::TempDir()) / std::string(name);
+  std::filesystem::remove_all(path);
+  return path.string();
+}
+
+TEST(MoriartyTest, TestCaseCacheShouldNotChangeTheTestCases) {
+  std::string directory = EmptyTempDirectory("moriarty_cache_same");
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1);
+
+  // The first run fills the cache (one entry per generator call), the second
+  // reads from it.
+  EXPECT_EQ(GetRAndS(GenerateWithCache(directory, "abcde0123456789")),
+            GetRAndS(expected));
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(directory),
+                          std::filesystem::directory_iterator()),
+            7 + 2 + 5 + 1);
+  EXPECT_EQ(GetRAndS(GenerateWithCache(directory, "abcde0123456789")),
+            GetRAndS(expected));
+}
+
+TEST(MoriartyTest, TestCaseCacheShouldNotBeSharedBetweenSeeds) {
+  std::string directory = EmptyTempDirectory("moriarty_cache_seeds");
+  std::vector<ExampleTestCase> first =
+      GenerateWithCache(directory, "abcde0123456789");
+  std::vector<ExampleTestCase> second =
+      GenerateWithCache(directory, "zyxwv9876543210");
+  EXPECT_NE(GetRAndS(first), GetRAndS(second));
+
+  std::vector<ExampleTestCase> uncached;
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  M.SetSeed("zyxwv9876543210");
+  M.GenerateTestCases();
+  TwoIntegerExporter exporter(&uncached);
+  M.ExportTestCases(exporter);
+  EXPECT_EQ(GetRAndS(second), GetRAndS(uncached));
+}
+
+int NumFilesIn(const std::string& directory) {
+  return std::distance(std::filesystem::directory_iterator(directory),
+                       std::filesystem::directory_iterator());
+}
+
+TEST(MoriartyTest, TestCaseCacheShouldNotBeSharedBetweenCacheVersions) {
+  std::string directory = EmptyTempDirectory("moriarty_cache_versions");
+  GenerateWithCache(directory, "abcde0123456789", "1");
+  ASSERT_EQ(NumFilesIn(directory), 7 + 2 + 5 + 1);
+
+  GenerateWithCache(directory, "abcde0123456789", "2");
+  EXPECT_EQ(NumFilesIn(directory), 2 * (7 + 2 + 5 + 1));
+}
+
+TEST(MoriartyTest, TestCaseCacheShouldBeSharedBetweenThreadCounts) {
+  std::string directory = EmptyTempDirectory("moriarty_cache_threads");
+  std::vector<ExampleTestCase> expected =
+      GenerateWithCache(directory, "abcde0123456789", "1", 1);
+  ASSERT_EQ(NumFilesIn(directory), 7 + 2 + 5 + 1);
+
+  EXPECT_EQ(
+      GetRAndS(GenerateWithCache(directory, "abcde0123456789", "1", 4)),
+      GetRAndS(expected));
+  EXPECT_EQ(NumFilesIn(directory), 7 + 2 + 5 + 1);
+}
+
+TEST(MoriartyTest, CachedGeneratorCallsShouldNotUseTheirBudget) {
+  std::string directory = EmptyTempDirectory("moriarty_cache_budget");
+  GenerateWithCache(directory, "abcde0123456789");
+
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  M.SetGeneratorBudget({.max_generate_calls = 1});
+  EXPECT_THAT(M.TryGenerateTestCases(),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+
+  moriarty::Moriarty cached = MoriartyWithSeveralGenerators(std::nullopt);
+  cached.SetGeneratorBudget({.max_generate_calls = 1});
+  cached.SetTestCaseCache(directory, "1");
+  MORIARTY_EXPECT_OK(cached.TryGenerateTestCases());
+}
+
+absl::StatusOr<std::vector<ExampleTestCase>> GenerateWithCheckpoint(
+    absl::string_view path, absl::string_view seed = "abcde0123456789",
+    std::optional<int64_t> generation_limit = std::nullopt) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(generation_limit);
+  M.SetSeed(seed);
+  M.SetCheckpointFile(path);
+  MORIARTY_RETURN_IF_ERROR(M.TryGenerateTestCases());
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+  return test_cases;
+}
+
+std::string EmptyTempFile(absl::string_view name) {
+  std::filesystem::path path =
+      std::filesystem::path(::testing::TempDir()) / std::string(name);
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+TEST(MoriartyTest, ResumingFromACheckpointShouldNotChangeTheTestCases) {
+  std::string path = EmptyTempFile("moriarty_checkpoint_resume");
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<ExampleTestCase> test_cases,
+                                GenerateWithCheckpoint(path));
+  EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+
+  // Cut the checkpoint short (in the middle of a call or of its header), as
+  // if the run was interrupted while writing it.
+  uintmax_t size = std::filesystem::file_size(path);
+  for (uintmax_t cut : {size, size / 2, size / 5, uintmax_t{5}, uintmax_t{0}}) {
+    std::filesystem::resize_file(path, cut);
+    MORIARTY_ASSERT_OK_AND_ASSIGN(test_cases, GenerateWithCheckpoint(path));
+    EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+    EXPECT_EQ(std::filesystem::file_size(path), size);
+  }
+}
+
+TEST(MoriartyTest, ResumingFromACheckpointShouldRespectGenerationLimit) {
+  std::string path = EmptyTempFile("moriarty_checkpoint_limit");
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1, 50);
+
+  for (int run = 0; run < 2; run++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        std::vector<ExampleTestCase> test_cases,
+        GenerateWithCheckpoint(path, "abcde0123456789", 50));
+    EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+  }
+}
+
+TEST(MoriartyTest, CheckpointedGeneratorCallsShouldBeChargedToTheBudget) {
+  std::string path = EmptyTempFile("moriarty_checkpoint_budget");
+
+  // The budget runs out part way through the calls. Each run resumes after
+  // the calls recorded by the previous one, so if those were free, a later
+  // run would have enough budget left to finish.
+  for (int run = 0; run < 10; run++) {
+    moriarty::Moriarty M;
+    M.SetSeed("abcde0123456789");
+    M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness(), 10);
+    M.SetGeneratorBudget({.max_generate_calls = 20});
+    M.SetCheckpointFile(path);
+    EXPECT_THAT(M.TryGenerateTestCases(),
+                StatusIs(absl::StatusCode::kResourceExhausted,
+                         HasSubstr("more than 20 generate calls")));
+  }
+}
+
+TEST(MoriartyTest, CheckpointWithADifferentGeneratorBudgetShouldBeRejected) {
+  std::string path = EmptyTempFile("moriarty_checkpoint_budget_change");
+  MORIARTY_ASSERT_OK(GenerateWithCheckpoint(path).status());
+
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  M.SetGeneratorBudget("Gen 2", {.max_generate_calls = 1000});
+  M.SetCheckpointFile(path);
+  EXPECT_THAT(M.TryGenerateTestCases(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("different run")));
+}
+
+TEST(MoriartyTest, CheckpointFromADifferentRunShouldBeRejected) {
+  std::string path = EmptyTempFile("moriarty_checkpoint_seeds");
+  MORIARTY_ASSERT_OK(GenerateWithCheckpoint(path).status());
+
+  EXPECT_THAT(GenerateWithCheckpoint(path, "zyxwv9876543210"),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("different run")));
+}
+
+// Generates each of the `num_shards` shards with its own Moriarty, as
+// separate processes would.
+std::vector<std::string> GenerateShards(
+    int num_shards, std::optional<int64_t> generation_limit = std::nullopt) {
+  std::vector<std::string> shards;
+  for (int i = 0; i < num_shards; i++) {
+    moriarty::Moriarty M = MoriartyWithSeveralGenerators(generation_limit);
+    M.SetShard(i, num_shards);
+    std::stringstream ss;
+    M.GenerateShard(ss);
+    shards.push_back(ss.str());
+  }
+  return shards;
+}
+
+absl::StatusOr<std::vector<ExampleTestCase>> MergeShards(
+    const std::vector<std::string>& shards,
+    std::optional<int64_t> generation_limit = std::nullopt) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(generation_limit);
+  MORIARTY_RETURN_IF_ERROR(M.TryMergeShards(
+      std::vector<absl::string_view>(shards.begin(), shards.end())));
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  M.ExportTestCases(exporter);
+  return test_cases;
+}
+
+TEST(MoriartyTest, TrySetShardWithInvalidInputShouldFail) {
+  EXPECT_THAT(Moriarty().TrySetShard(0, 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Moriarty().TrySetShard(3, 3),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Moriarty().TrySetShard(-1, 3),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  MORIARTY_EXPECT_OK(Moriarty().TrySetShard(2, 3));
+}
+
+TEST(MoriartyTest, MergedShardsShouldMatchGenerateTestCases) {
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1);
+
+  for (int num_shards : {1, 2, 4, 20}) {
+    std::vector<std::string> shards = GenerateShards(num_shards);
+    // Shards may be given in any order.
+    std::reverse(shards.begin(), shards.end());
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<ExampleTestCase> test_cases,
+                                  MergeShards(shards));
+    EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+
+    ASSERT_THAT(test_cases, SizeIs(expected.size()));
+    for (int i = 0; i < test_cases.size(); i++) {
+      const auto& metadata = test_cases[i].metadata;
+      const auto& expected_metadata = expected[i].metadata;
+      EXPECT_EQ(metadata.GetTestCaseNumber(), i + 1);
+      EXPECT_EQ(metadata.GetGeneratorMetadata()->generator_name,
+                expected_metadata.GetGeneratorMetadata()->generator_name);
+      EXPECT_EQ(metadata.GetGeneratorMetadata()->generator_iteration,
+                expected_metadata.GetGeneratorMetadata()->generator_iteration);
+      EXPECT_EQ(
+          metadata.GetGeneratorMetadata()->case_number_in_generator,
+          expected_metadata.GetGeneratorMetadata()->case_number_in_generator);
+    }
+  }
+}
+
+TEST(MoriartyTest, MergedShardsShouldRespectApproximateGenerationLimit) {
+  std::vector<ExampleTestCase> expected = GenerateWithThreads(1, 50);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<ExampleTestCase> test_cases,
+                                MergeShards(GenerateShards(3, 50), 50));
+  EXPECT_EQ(GetRAndS(test_cases), GetRAndS(expected));
+}
+
+TEST(MoriartyTest, MergingMissingOrRepeatedShardsShouldFail) {
+  std::vector<std::string> shards = GenerateShards(3);
+
+  EXPECT_THAT(MergeShards({shards[0], shards[1]}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(MergeShards({shards[0], shards[1], shards[1]}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("more than once")));
+
+  // A shard that was cut short.
+  EXPECT_THAT(MergeShards({shards[0], shards[1],
+                           shards[2].substr(0, shards[2].size() - 1)}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MoriartyTest, MergingShardsWithDifferentGeneratorsShouldFail) {
+  std::vector<std::string> shards = GenerateShards(2);
+
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("R", MInteger().Between(3, 50));
+  M.AddGenerator("Other", TwoIntegerGeneratorWithRandomness(), 15);
+  EXPECT_THAT(M.TryMergeShards(
+                  std::vector<absl::string_view>(shards.begin(), shards.end())),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("does not match")));
+}
+
+TEST(MoriartyTest, MergingShardsShouldReturnGeneratorFailures) {
+  std::vector<std::string> shards;
+  for (int i = 0; i < 2; i++) {
+    moriarty::Moriarty M;
+    M.SetSeed("abcde0123456789");
+    M.AddVariable("N", MInteger().Is(5));
+    M.AddGenerator("Gen 1", TwoIntegerGenerator(1, 11));
+    M.AddGenerator("Gen 2", SingleIntegerGenerator());  // N = 0 always fails.
+    M.SetShard(i, 2);
+    std::stringstream ss;
+    // The failure is written to the shard.
+    MORIARTY_ASSERT_OK(M.TryGenerateShard(ss));
+    shards.push_back(ss.str());
+  }
+
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("N", MInteger().Is(5));
+  M.AddGenerator("Gen 1", TwoIntegerGenerator(1, 11));
+  M.AddGenerator("Gen 2", SingleIntegerGenerator());
+  EXPECT_FALSE(
+      M.TryMergeShards(
+           std::vector<absl::string_view>(shards.begin(), shards.end()))
+          .ok());
+}
+
+TEST(MoriartyTest,
+     GenerateAndExportTestCasesShouldRespectApproximateGenerationLimit) {
+  EXPECT_EQ(GetRAndS(GenerateAndExportWhileStreaming(50)),
+            GetRAndS(GenerateWithThreads(1, 50)));
+}
+
+TEST(MoriartyTest, GenerateAndExportTestCasesShouldNotStoreTestCases) {
+  moriarty::Moriarty M = MoriartyWithSeveralGenerators(std::nullopt);
+  std::vector<ExampleTestCase> streamed;
+  M.GenerateAndExportTestCases(TwoIntegerExporter(&streamed));
+  EXPECT_THAT(streamed, Not(IsEmpty()));
+
+  EXPECT_THAT(M.TryValidateTestCases(),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MoriartyTest, GenerateAndExportTestCasesShouldReturnGeneratorFailures) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("N", MInteger().Is(5));
+  M.AddGenerator("Gen 1", TwoIntegerGenerator(1, 11));
+  M.AddGenerator("Gen 2", SingleIntegerGenerator());  // N = 0 always fails.
+
+  // The test cases from the first generator are still exported.
+  std::vector<ExampleTestCase> test_cases;
+  EXPECT_FALSE(
+      M.TryGenerateAndExportTestCases(TwoIntegerExporter(&test_cases)).ok());
+  EXPECT_THAT(GetRAndS(test_cases), ElementsAre(Pair(1, 11), Pair(1, 11)));
+}
+
+// Same as TwoIntegerGeneratorWithRandomness, but adds its 4 test cases one at
+// a time.
+class StreamingTwoIntegerGenerator : public StreamingGenerator {
+ public:
+  bool GenerateNextTestCase() override {
+    if (NumTestCasesAdded() == 4) return false;
+    AddTestCase()
+        .ConstrainVariable("R", MInteger().Between(1, 10))
+        .ConstrainVariable("S", MInteger().Between(8, 20));
+    return true;
+  }
+};
+
+// Generates with a `StreamingTwoIntegerGenerator` called 3 times, streaming
+// the test cases to the exporter if `stream` is true.
+std::vector<ExampleTestCase> GenerateWithStreamingGenerator(
+    bool stream, int num_threads,
+    std::optional<int64_t> generation_limit = std::nullopt) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Gen", StreamingTwoIntegerGenerator(), 3);
+  M.SetNumThreads(num_threads);
+  if (generation_limit) M.SetApproximateGenerationLimit(*generation_limit);
+
+  std::vector<ExampleTestCase> test_cases;
+  TwoIntegerExporter exporter(&test_cases);
+  if (stream) {
+    M.GenerateAndExportTestCases(exporter);
+  } else {
+    M.GenerateTestCases();
+    M.ExportTestCases(exporter);
+  }
+  return test_cases;
+}
+
+TEST(MoriartyTest, StreamingGeneratorShouldMatchGenerator) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddGenerator("Gen", TwoIntegerGeneratorWithRandomness(), 3);
+  M.GenerateTestCases();
+  std::vector<ExampleTestCase> expected;
+  M.ExportTestCases(TwoIntegerExporter(&expected));
+  ASSERT_THAT(expected, SizeIs(12));
+
+  EXPECT_EQ(GetRAndS(GenerateWithStreamingGenerator(/*stream=*/true, 1)),
+            GetRAndS(expected));
+  EXPECT_EQ(GetRAndS(GenerateWithStreamingGenerator(/*stream=*/false, 1)),
+            GetRAndS(expected));
+  EXPECT_EQ(GetRAndS(GenerateWithStreamingGenerator(/*stream=*/false, 4)),
+            GetRAndS(expected));
+}
+
+TEST(MoriartyTest, StreamingGeneratorShouldStopAtTheGenerationLimit) {
+  // Each test case has size 2, so the limit is reached by the 3rd test case,
+  // in the middle of the first call.
+  std::vector<ExampleTestCase> expected =
+      GenerateWithStreamingGenerator(/*stream=*/true, 1, 5);
+  EXPECT_THAT(expected, SizeIs(3));
+
+  EXPECT_EQ(GetRAndS(GenerateWithStreamingGenerator(/*stream=*/false, 1, 5)),
+            GetRAndS(expected));
+  EXPECT_EQ(GetRAndS(GenerateWithStreamingGenerator(/*stream=*/false, 4, 5)),
+            GetRAndS(expected));
+}
+
+TEST(MoriartyTest, GenerateAndExportTestCasesWithoutGeneratorsShouldFail) {
+  moriarty::Moriarty M;
+  M.SetSeed("abcde0123456789");
+  std::vector<ExampleTestCase> test_cases;
+  EXPECT_THAT(M.TryGenerateAndExportTestCases(TwoIntegerExporter(&test_cases)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+struct SharedBoundValues {
+  std::vector<int64_t> outside;  // "K", read in StartExport() and EndExport().
+  std::vector<int64_t> k;        // "K", read in each test case.
+  std::vector<int64_t> r;        // "R", read in each test case.
+};
+
+class SharedBoundExporter : public Exporter {
+ public:
+  explicit SharedBoundExporter(SharedBoundValues* values) : values_(values) {}
+
+  void StartExport() override {
+    values_->outside.push_back(GetValue<MInteger>("K"));
+  }
+  void ExportTestCase() override {
+    values_->k.push_back(GetValue<MInteger>("K"));
+    values_->r.push_back(GetValue<MInteger>("R"));
+  }
+  void EndExport() override {
+    values_->outside.push_back(GetValue<MInteger>("K"));
+  }
+
+ private:
+  SharedBoundValues* values_;
+};
+
+Moriarty MoriartyWithSharedBound() {
+  Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddSharedVariable("K", MInteger().Between(3, 1'000'000));
+  M.AddVariable("R", MInteger().Between(1, "K"));
+  M.AddVariable("S", MInteger());
+  M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness(), 5);
+  return M;
+}
+
+TEST(MoriartyTest, SharedVariablesShouldBeTheSameInEveryTestCase) {
+  Moriarty M = MoriartyWithSharedBound();
+  M.GenerateTestCases();
+  SharedBoundValues values;
+  M.ExportTestCases(SharedBoundExporter(&values));
+
+  ASSERT_THAT(values.outside, SizeIs(2));
+  int64_t K = values.outside[0];
+  EXPECT_EQ(values.outside[1], K);
+  EXPECT_THAT(values.k, Not(IsEmpty()));
+  EXPECT_THAT(values.k, Each(K));
+  EXPECT_THAT(values.r, SizeIs(values.k.size()));
+  EXPECT_THAT(values.r, Each(Le(K)));
+}
+
+TEST(MoriartyTest, SharedVariablesShouldNotDependOnHowTestCasesAreGenerated) {
+  auto generate = [](int num_threads, bool stream) {
+    Moriarty M = MoriartyWithSharedBound();
+    M.SetNumThreads(num_threads);
+    SharedBoundValues values;
+    if (stream) {
+      M.GenerateAndExportTestCases(SharedBoundExporter(&values));
+    } else {
+      M.GenerateTestCases();
+      M.ExportTestCases(SharedBoundExporter(&values));
+    }
+    return std::pair(values.k, values.r);
+  };
+
+  auto expected = generate(1, /*stream=*/false);
+  EXPECT_EQ(generate(4, /*stream=*/false), expected);
+  EXPECT_EQ(generate(1, /*stream=*/true), expected);
+}
+
+TEST(MoriartyTest, SharedVariablesCanBePrintedOnceInTheHeader) {
+  Moriarty M = MoriartyWithSharedBound();
+  M.GenerateTestCases();
+  std::stringstream ss;
+  M.ExportTestCases(SimpleIO().AddHeaderLine("K").AddLine("R").Exporter(ss));
+
+  SharedBoundValues values;
+  M.ExportTestCases(SharedBoundExporter(&values));
+  std::stringstream expected;
+  expected << values.outside[0] << "\n";
+  for (int64_t r : values.r) expected << r << "\n";
+  EXPECT_EQ(ss.str(), expected.str());
+}
+
+TEST(MoriartyTest, SharedVariablesShouldHaveDistinctNames) {
+  Moriarty M;
+  MORIARTY_EXPECT_OK(M.TryAddSharedVariable("K", MInteger()));
+  MORIARTY_EXPECT_OK(M.TryAddVariable("N", MInteger()));
+
+  EXPECT_THAT(M.TryAddSharedVariable("K", MInteger()), Not(IsOk()));
+  EXPECT_THAT(M.TryAddSharedVariable("N", MInteger()),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  EXPECT_THAT(M.TryAddVariable("K", MInteger()),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+}
+
+TEST(MoriartyTest, SharedVariablesCannotDependOnOtherVariables) {
+  Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("N", MInteger().Between(1, 10));
+  M.AddSharedVariable("K", MInteger().Between(1, "N"));
+  M.AddGenerator("Two Var", TwoIntegerGeneratorWithRandomness());
+
+  EXPECT_THAT(M.TryGenerateTestCases(), Not(IsOk()));
+}
+
 TEST(MoriartyTest, VariableNameValidationShouldWork) {
   EXPECT_OK(Moriarty().TryAddVariable("good", MInteger()));
   EXPECT_OK(Moriarty().TryAddVariable("a1_b", MInteger()));
@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/pipe_stream.h"
+
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+
+class PipeInputStream::Buffer : public std::streambuf {
+ public:
+  Buffer(int fd, absl::Duration timeout, int buffer_size)
+      : fd_(fd), timeout_(timeout), buffer_(std::max(buffer_size, 1)) {}
+
+  void SetTimeout(absl::Duration timeout) { timeout_ = timeout; }
+  bool TimedOut() const { return timed_out_; }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    timed_out_ = false;
+    if (!WaitForInput()) return traits_type::eof();
+    ssize_t size;
+    do {
+      size = ::read(fd_, buffer_.data(), buffer_.size());
+    } while (size < 0 && errno == EINTR);
+    if (size <= 0) return traits_type::eof();
+
+    setg(buffer_.data(), buffer_.data(), buffer_.data() + size);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  std::streamsize showmanyc() override {
+    // Only what is buffered is known to be readable without waiting.
+    return egptr() - gptr();
+  }
+
+ private:
+  int fd_;
+  absl::Duration timeout_;
+  bool timed_out_ = false;
+  std::vector<char> buffer_;
+
+  // Waits until `fd_` can be read without blocking. Returns false if the
+  // timeout expired first.
+  bool WaitForInput() {
+    if (timeout_ == absl::InfiniteDuration()) return true;
+    absl::Time deadline = absl::Now() + timeout_;
+    while (true) {
+      int64_t wait_ms = std::clamp<int64_t>(
+          absl::ToInt64Milliseconds(absl::Ceil(deadline - absl::Now(),
+                                               absl::Milliseconds(1))),
+          0, std::numeric_limits<int>::max());
+      pollfd request = {.fd = fd_, .events = POLLIN, .revents = 0};
+      int ready = poll(&request, 1, static_cast<int>(wait_ms));
+      if (ready > 0) return true;  // Readable, closed, or an error to `read()`.
+      if (ready < 0 && errno == EINTR) continue;
+      if (ready < 0) return true;  // Let `read()` report the error.
+      timed_out_ = true;
+      return false;
+    }
+  }
+};
+
+class PipeOutputStream::Buffer : public std::streambuf {
+ public:
+  Buffer(int fd, int buffer_size) : fd_(fd), buffer_(std::max(buffer_size, 1)) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+  }
+
+  ~Buffer() override { sync(); }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!WriteBuffer()) return traits_type::eof();
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    // Large writes skip the buffer. They are written straight from `s`,
+    // together with the buffered bytes before them.
+    if (n > epptr() - pptr()) {
+      iovec pieces[2] = {
+          {.iov_base = pbase(),
+           .iov_len = static_cast<size_t>(pptr() - pbase())},
+          {.iov_base = const_cast<char*>(s),
+           .iov_len = static_cast<size_t>(n)}};
+      setp(buffer_.data(), buffer_.data() + buffer_.size());
+      if (!WriteAll(pieces, 2)) return 0;
+      return n;
+    }
+    std::copy(s, s + n, pptr());
+    pbump(static_cast<int>(n));
+    return n;
+  }
+
+  int sync() override { return WriteBuffer() ? 0 : -1; }
+
+ private:
+  int fd_;
+  std::vector<char> buffer_;
+
+  // Writes the buffered bytes to `fd_` and empties the buffer.
+  bool WriteBuffer() {
+    iovec piece = {.iov_base = pbase(),
+                   .iov_len = static_cast<size_t>(pptr() - pbase())};
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    return WriteAll(&piece, 1);
+  }
+
+  // Writes all `count` pieces to `fd_`, in order. Usually one `writev()`.
+  bool WriteAll(iovec* pieces, int count) {
+    while (count > 0) {
+      if (pieces->iov_len == 0) {
+        pieces++;
+        count--;
+        continue;
+      }
+      ssize_t written = ::writev(fd_, pieces, count);
+      if (written < 0 && errno == EINTR) continue;
+      if (written <= 0) return false;
+      // Skip what was written, which may end partway through a piece.
+      size_t remaining = written;
+      for (; count > 0 && remaining >= pieces->iov_len; pieces++, count--)
+        remaining -= pieces->iov_len;
+      if (count > 0) {
+        pieces->iov_base = static_cast<char*>(pieces->iov_base) + remaining;
+        pieces->iov_len -= remaining;
+      }
+    }
+    return true;
+  }
+};
+
+PipeInputStream::PipeInputStream(int fd, absl::Duration timeout,
+                                 int buffer_size)
+    : std::istream(nullptr),
+      buffer_(std::make_unique<Buffer>(fd, timeout, buffer_size)) {
+  rdbuf(buffer_.get());
+}
+
+PipeInputStream::~PipeInputStream() = default;
+
+void PipeInputStream::SetTimeout(absl::Duration timeout) {
+  buffer_->SetTimeout(timeout);
+}
+
+bool PipeInputStream::TimedOut() const { return buffer_->TimedOut(); }
+
+PipeOutputStream::PipeOutputStream(int fd, int buffer_size)
+    : std::ostream(nullptr),
+      buffer_(std::make_unique<Buffer>(fd, buffer_size)) {
+  rdbuf(buffer_.get());
+}
+
+PipeOutputStream::~PipeOutputStream() = default;
+
+}  // namespace moriarty
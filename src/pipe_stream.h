@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_PIPE_STREAM_H_
+#define MORIARTY_SRC_PIPE_STREAM_H_
+
+#include <istream>
+#include <memory>
+#include <ostream>
+
+#include "absl/time/time.h"
+
+namespace moriarty {
+
+// PipeInputStream
+//
+// An input stream over the file descriptor `fd` (e.g., the read end of a pipe
+// from an interactive solution), for reading queries one at a time. Unlike
+// `std::ifstream`, every read returns as soon as any bytes are available, and
+// waiting for bytes can time out.
+//
+// If no bytes arrive within the timeout, the stream reports the end of the
+// input (so `IOConfig` returns an error for the token it was reading) and
+// `TimedOut()` returns true. After `clear()`, the stream can be read again.
+//
+// `fd` is not closed by this stream and must outlive it.
+//
+// Example usage (an interactor):
+//
+//   PipeInputStream from_solution(fd_in, absl::Seconds(1));
+//   PipeOutputStream to_solution(fd_out);
+//   IOConfig io;
+//   io.SetInputStream(from_solution).SetOutputStream(to_solution);
+//   ... read a query with `MInteger` or `MArray`, print the answer ...
+//   MORIARTY_RETURN_IF_ERROR(io.Flush());
+class PipeInputStream : public std::istream {
+ public:
+  static constexpr int kDefaultBufferSize = 1 << 16;
+
+  explicit PipeInputStream(int fd,
+                           absl::Duration timeout = absl::InfiniteDuration(),
+                           int buffer_size = kDefaultBufferSize);
+  ~PipeInputStream() override;
+
+  PipeInputStream(const PipeInputStream&) = delete;
+  PipeInputStream& operator=(const PipeInputStream&) = delete;
+
+  // SetTimeout()
+  //
+  // The longest time to wait for more bytes. Default = no limit.
+  void SetTimeout(absl::Duration timeout);
+
+  // TimedOut()
+  //
+  // Returns true if the last wait for more bytes timed out.
+  [[nodiscard]] bool TimedOut() const;
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+// PipeOutputStream
+//
+// An output stream over the file descriptor `fd` (e.g., the write end of a
+// pipe to an interactive solution). Bytes are only written to `fd` when the
+// buffer is full, on `flush()` (e.g., `IOConfig::Flush()`), and when this
+// stream is destroyed, so each message costs one `write()`. A write larger
+// than the free space in the buffer (e.g., a long string token) is not copied
+// into the buffer: it is sent straight from the caller's memory, together
+// with the buffered bytes before it, in a single `writev()`.
+//
+// `fd` is not closed by this stream and must outlive it.
+class PipeOutputStream : public std::ostream {
+ public:
+  static constexpr int kDefaultBufferSize = 1 << 16;
+
+  explicit PipeOutputStream(int fd, int buffer_size = kDefaultBufferSize);
+  ~PipeOutputStream() override;
+
+  PipeOutputStream(const PipeOutputStream&) = delete;
+  PipeOutputStream& operator=(const PipeOutputStream&) = delete;
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_PIPE_STREAM_H_
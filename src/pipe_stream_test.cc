@@ -0,0 +1,135 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/pipe_stream.h"
+
+#include <unistd.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+
+namespace moriarty {
+namespace {
+
+// A pipe that is closed when it goes out of scope.
+class Pipe {
+ public:
+  Pipe() { EXPECT_EQ(pipe(fds_), 0); }
+  ~Pipe() {
+    CloseWriteEnd();
+    close(fds_[0]);
+  }
+
+  int ReadEnd() const { return fds_[0]; }
+  int WriteEnd() const { return fds_[1]; }
+  void CloseWriteEnd() {
+    if (fds_[1] >= 0) close(fds_[1]);
+    fds_[1] = -1;
+  }
+
+ private:
+  int fds_[2] = {-1, -1};
+};
+
+TEST(PipeStreamTest, ShouldReadWhatWasWritten) {
+  Pipe pipe;
+  {
+    PipeOutputStream out(pipe.WriteEnd(), /* buffer_size = */ 7);
+    for (int i = 0; i < 1000; i++) out << i << " ";
+  }
+  pipe.CloseWriteEnd();
+
+  PipeInputStream in(pipe.ReadEnd(), absl::InfiniteDuration(),
+                     /* buffer_size = */ 5);
+  for (int i = 0; i < 1000; i++) {
+    int value;
+    ASSERT_TRUE(in >> value);
+    EXPECT_EQ(value, i);
+  }
+  int value;
+  EXPECT_FALSE(in >> value);
+  EXPECT_FALSE(in.TimedOut());
+}
+
+TEST(PipeStreamTest, OutputShouldOnlyBeWrittenWhenFlushed) {
+  Pipe pipe;
+  PipeOutputStream out(pipe.WriteEnd());
+  PipeInputStream in(pipe.ReadEnd(), absl::Milliseconds(10));
+
+  out << "42\n";
+  std::string token;
+  EXPECT_FALSE(in >> token);
+  EXPECT_TRUE(in.TimedOut());
+
+  in.clear();
+  out.flush();
+  EXPECT_TRUE(in >> token);
+  EXPECT_EQ(token, "42");
+  EXPECT_FALSE(in.TimedOut());
+}
+
+TEST(PipeStreamTest, ReadingShouldNotWaitForAFullBuffer) {
+  Pipe pipe;
+  PipeOutputStream out(pipe.WriteEnd());
+  PipeInputStream in(pipe.ReadEnd(), absl::Seconds(10));
+
+  // Each round trip returns as soon as the message is available, even though
+  // it is much smaller than the buffer.
+  for (int i = 0; i < 100; i++) {
+    out << absl::StrCat("query", i, "\n") << std::flush;
+    std::string token;
+    ASSERT_TRUE(in >> token);
+    EXPECT_EQ(token, absl::StrCat("query", i));
+  }
+}
+
+TEST(PipeStreamTest, LargeWritesShouldBypassTheBuffer) {
+  Pipe pipe;
+  std::string data(1000, 'x');
+  {
+    PipeOutputStream out(pipe.WriteEnd(), /* buffer_size = */ 10);
+    out << "ab" << data << "cd";
+  }
+  pipe.CloseWriteEnd();
+
+  PipeInputStream in(pipe.ReadEnd());
+  std::string token;
+  ASSERT_TRUE(in >> token);
+  EXPECT_EQ(token, "ab" + data + "cd");
+}
+
+TEST(PipeStreamTest, LargeAndSmallWritesShouldStayInOrder) {
+  Pipe pipe;
+  std::string expected;
+  {
+    PipeOutputStream out(pipe.WriteEnd(), /* buffer_size = */ 16);
+    for (int i = 0; i < 50; i++) {
+      std::string token = absl::StrCat(i, std::string(i * 7, 'a' + i % 26));
+      out << token << " ";
+      expected += token + " ";
+    }
+  }
+  pipe.CloseWriteEnd();
+
+  PipeInputStream in(pipe.ReadEnd());
+  std::string actual;
+  for (std::string token; in >> token;) actual += token + " ";
+  EXPECT_EQ(actual, expected);
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,126 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/read_ahead_stream.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace moriarty {
+
+// The buffers are filled in order: the n-th piece of `is` goes into
+// `buffers_[n % 2]`. The reader holds the piece `num_consumed_` while it is
+// reading it, so the background thread may fill up to one piece ahead of it.
+class ReadAheadInputStream::Buffer : public std::streambuf {
+ public:
+  Buffer(std::istream& is, int buffer_size) : is_(is) {
+    for (std::vector<char>& buffer : buffers_)
+      buffer.resize(std::max(buffer_size, 1));
+    reader_ = std::thread([this] { FillBuffers(); });
+  }
+
+  ~Buffer() override {
+    {
+      absl::MutexLock lock(&mutex_);
+      stopping_ = true;
+    }
+    reader_.join();
+  }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    absl::MutexLock lock(&mutex_);
+    if (holding_piece_) {
+      num_consumed_++;  // Hand the buffer back to the background thread.
+      holding_piece_ = false;
+    }
+    mutex_.Await(absl::Condition(this, &Buffer::NextPieceIsReady));
+    if (num_filled_ == num_consumed_) return traits_type::eof();
+
+    holding_piece_ = true;
+    std::vector<char>& buffer = buffers_[num_consumed_ % 2];
+    setg(buffer.data(), buffer.data(),
+         buffer.data() + sizes_[num_consumed_ % 2]);
+    return traits_type::to_int_type(*gptr());
+  }
+
+ private:
+  std::istream& is_;
+  std::array<std::vector<char>, 2> buffers_;
+  std::thread reader_;
+
+  absl::Mutex mutex_;
+  std::array<int64_t, 2> sizes_ ABSL_GUARDED_BY(mutex_) = {0, 0};
+  int64_t num_filled_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t num_consumed_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool holding_piece_ ABSL_GUARDED_BY(mutex_) = false;
+  bool end_of_input_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+
+  bool NextPieceIsReady() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return num_filled_ > num_consumed_ || end_of_input_;
+  }
+
+  bool CanFill() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stopping_ || num_filled_ < num_consumed_ + 2;
+  }
+
+  // Runs on `reader_`. Reads `is_` into whichever buffer is free until the end
+  // of the input.
+  void FillBuffers() {
+    while (true) {
+      int64_t piece;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(this, &Buffer::CanFill));
+        if (stopping_) return;
+        piece = num_filled_;
+      }
+
+      // The reader does not touch this buffer until `num_filled_` passes it.
+      std::vector<char>& buffer = buffers_[piece % 2];
+      is_.read(buffer.data(), buffer.size());
+      int64_t size = is_.gcount();
+
+      absl::MutexLock lock(&mutex_);
+      if (size == 0) {
+        end_of_input_ = true;
+        return;
+      }
+      sizes_[piece % 2] = size;
+      num_filled_++;
+    }
+  }
+};
+
+ReadAheadInputStream::ReadAheadInputStream(std::istream& is, int buffer_size)
+    : std::istream(nullptr),
+      buffer_(std::make_unique<Buffer>(is, buffer_size)) {
+  rdbuf(buffer_.get());
+}
+
+ReadAheadInputStream::~ReadAheadInputStream() = default;
+
+}  // namespace moriarty
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_READ_AHEAD_STREAM_H_
+#define MORIARTY_SRC_READ_AHEAD_STREAM_H_
+
+#include <istream>
+#include <memory>
+
+namespace moriarty {
+
+// ReadAheadInputStream
+//
+// An input stream that reads `is` on a background thread, one buffer ahead of
+// the reader. While the importer parses and validates one buffer, the next one
+// is being read, so slow reads (e.g., from a network filesystem) overlap with
+// the work done on the input. Use it anywhere an `std::istream` is accepted
+// (e.g., `SimpleIO::Importer()`).
+//
+// The background thread reads `is` up to two buffers past what has been
+// consumed from this stream, so `is` must not be used by anything else while
+// this stream exists. Seeking is not supported. `is` must outlive this stream.
+//
+// Example usage:
+//
+//   std::ifstream file("/network/tests.txt", std::ios::binary);
+//   ReadAheadInputStream read_ahead(file);
+//   M.ImportTestCases(SimpleIO().AddLine("N").Importer(read_ahead));
+class ReadAheadInputStream : public std::istream {
+ public:
+  static constexpr int kDefaultBufferSize = 1 << 20;
+
+  // Reads `is` in pieces of `buffer_size` bytes. Two buffers are allocated.
+  explicit ReadAheadInputStream(std::istream& is,
+                                int buffer_size = kDefaultBufferSize);
+  ~ReadAheadInputStream() override;
+
+  ReadAheadInputStream(const ReadAheadInputStream&) = delete;
+  ReadAheadInputStream& operator=(const ReadAheadInputStream&) = delete;
+
+ private:
+  class Buffer;
+  std::unique_ptr<Buffer> buffer_;
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_READ_AHEAD_STREAM_H_
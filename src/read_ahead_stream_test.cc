@@ -0,0 +1,74 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/read_ahead_stream.h"
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace moriarty {
+namespace {
+
+std::string ReadAll(const std::string& data, int buffer_size) {
+  std::stringstream source(data);
+  ReadAheadInputStream read_ahead(source, buffer_size);
+  std::stringstream result;
+  result << read_ahead.rdbuf();
+  return result.str();
+}
+
+TEST(ReadAheadStreamTest, ShouldReadAllOfTheData) {
+  std::string data;
+  for (int i = 0; i < 100000; i++) absl::StrAppend(&data, i, " ");
+
+  EXPECT_EQ(ReadAll(data, ReadAheadInputStream::kDefaultBufferSize), data);
+  EXPECT_EQ(ReadAll(data, 1000), data);
+  EXPECT_EQ(ReadAll(data, 1), data);
+}
+
+TEST(ReadAheadStreamTest, EmptyDataShouldBeEmpty) {
+  EXPECT_EQ(ReadAll("", 1000), "");
+}
+
+TEST(ReadAheadStreamTest, ReadingTokensAcrossBuffersShouldWork) {
+  std::stringstream source("12345 abcdef\nx");
+  ReadAheadInputStream read_ahead(source, /* buffer_size = */ 3);
+  int n;
+  std::string s;
+  char c;
+  read_ahead >> n >> s >> c;
+  EXPECT_EQ(n, 12345);
+  EXPECT_EQ(s, "abcdef");
+  EXPECT_EQ(c, 'x');
+  EXPECT_FALSE(read_ahead >> c);
+}
+
+TEST(ReadAheadStreamTest, DestroyingTheStreamBeforeTheEndShouldNotBlock) {
+  std::string data(1 << 20, 'a');
+  std::stringstream source(data);
+  {
+    ReadAheadInputStream read_ahead(source, /* buffer_size = */ 100);
+    char c;
+    read_ahead >> c;
+    EXPECT_EQ(c, 'a');
+  }
+  // The background thread read at most two buffers past the first one.
+  EXPECT_LE(source.tellg(), 300);
+}
+
+}  // namespace
+}  // namespace moriarty
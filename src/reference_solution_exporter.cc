@@ -0,0 +1,173 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/reference_solution_exporter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/log/absl_check.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "src/exporter.h"
+#include "src/internal/subprocess.h"
+#include "src/librarian/io_config.h"
+#include "src/simple_io.h"
+#include "src/test_case.h"
+
+namespace moriarty {
+
+// Runs the solution on queued test cases on `num_workers` threads. At most
+// `2 * num_workers` test cases wait in the queue at a time.
+class ReferenceSolutionExporter::WorkerPool {
+ public:
+  WorkerPool(std::vector<std::string> command, absl::Duration timeout,
+             int num_workers)
+      : command_(std::move(command)),
+        timeout_(timeout),
+        max_queued_(2 * num_workers) {
+    for (int i = 0; i < num_workers; i++)
+      workers_.emplace_back([this] { Work(); });
+  }
+
+  ~WorkerPool() { Finish(); }
+
+  // Queues `input` for a worker. Waits while the queue is full.
+  void Add(TestCaseMetadata metadata, std::string input) {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(this, &WorkerPool::HasRoom));
+    queue_.push_back({std::move(metadata), std::move(input)});
+  }
+
+  // Waits for all queued test cases and returns their runs, in the order they
+  // finished.
+  std::vector<ReferenceSolutionRun> Finish() {
+    {
+      absl::MutexLock lock(&mutex_);
+      finishing_ = true;
+    }
+    for (std::thread& worker : workers_) {
+      if (worker.joinable()) worker.join();
+    }
+    absl::MutexLock lock(&mutex_);
+    return std::move(runs_);
+  }
+
+ private:
+  struct Job {
+    TestCaseMetadata metadata;
+    std::string input;
+  };
+
+  const std::vector<std::string> command_;
+  const absl::Duration timeout_;
+  const size_t max_queued_;
+  std::vector<std::thread> workers_;
+
+  absl::Mutex mutex_;
+  std::deque<Job> queue_ ABSL_GUARDED_BY(mutex_);
+  std::vector<ReferenceSolutionRun> runs_ ABSL_GUARDED_BY(mutex_);
+  bool finishing_ ABSL_GUARDED_BY(mutex_) = false;
+
+  bool HasRoom() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return queue_.size() < max_queued_;
+  }
+
+  bool HasJobOrIsFinishing() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !queue_.empty() || finishing_;
+  }
+
+  // Runs on each worker thread until the queue is empty and `Finish()` has
+  // been called.
+  void Work() {
+    while (true) {
+      Job job;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(this, &WorkerPool::HasJobOrIsFinishing));
+        if (queue_.empty()) return;
+        job = std::move(queue_.front());
+        queue_.pop_front();
+      }
+
+      moriarty_internal::SubprocessResult result =
+          moriarty_internal::RunSubprocess(command_, job.input, timeout_);
+      ReferenceSolutionRun run = {
+          .metadata = std::move(job.metadata),
+          .status = std::move(result.status),
+          .output = std::move(result.output),
+          .wall_time = result.wall_time,
+          .peak_memory_bytes = result.peak_memory_bytes};
+
+      absl::MutexLock lock(&mutex_);
+      runs_.push_back(std::move(run));
+    }
+  }
+};
+
+ReferenceSolutionExporter::ReferenceSolutionExporter(
+    SimpleIO simple_io, std::vector<std::string> command,
+    std::vector<ReferenceSolutionRun>& runs)
+    : simple_io_(std::move(simple_io)),
+      command_(std::move(command)),
+      runs_(&runs),
+      num_workers_(std::max(1u, std::thread::hardware_concurrency())) {}
+
+ReferenceSolutionExporter& ReferenceSolutionExporter::SetNumWorkers(
+    int num_workers) {
+  ABSL_CHECK_GE(num_workers, 1) << "There must be at least one worker.";
+  num_workers_ = num_workers;
+  return *this;
+}
+
+ReferenceSolutionExporter& ReferenceSolutionExporter::SetTimeout(
+    absl::Duration timeout) {
+  timeout_ = timeout;
+  return *this;
+}
+
+void ReferenceSolutionExporter::StartExport() {
+  variables_ = moriarty_internal::ExporterManager(this).GetGeneralConstraints();
+  pool_ = std::make_shared<WorkerPool>(command_, timeout_, num_workers_);
+}
+
+void ReferenceSolutionExporter::ExportTestCase() {
+  std::ostringstream input;
+  librarian::IOConfig io_config;
+  io_config.SetOutputStream(input);
+  simple_io_.PrintSingleTestCase(
+      variables_, moriarty_internal::ExporterManager(this).GetCurrentValues(),
+      io_config);
+  pool_->Add(GetTestCaseMetadata(), std::move(input).str());
+}
+
+void ReferenceSolutionExporter::EndExport() {
+  std::vector<ReferenceSolutionRun> runs = pool_->Finish();
+  pool_ = nullptr;
+  absl::c_sort(runs, [](const ReferenceSolutionRun& a,
+                        const ReferenceSolutionRun& b) {
+    return a.metadata.GetTestCaseNumber() < b.metadata.GetTestCaseNumber();
+  });
+  *runs_ = std::move(runs);
+}
+
+}  // namespace moriarty
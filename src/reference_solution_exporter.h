@@ -0,0 +1,134 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_REFERENCE_SOLUTION_EXPORTER_H_
+#define MORIARTY_SRC_REFERENCE_SOLUTION_EXPORTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "src/exporter.h"
+#include "src/internal/variable_set.h"
+#include "src/simple_io.h"
+#include "src/test_case.h"
+
+namespace moriarty {
+
+// ReferenceSolutionRun
+//
+// The result of running the reference solution on a single test case.
+struct ReferenceSolutionRun {
+  // The test case that was given to the solution.
+  TestCaseMetadata metadata;
+
+  // Ok if the solution exited with code 0. Otherwise, kAborted if it exited
+  // with another code or was killed by a signal, kDeadlineExceeded if it ran
+  // out of time, and kInternal if it could not be started.
+  absl::Status status;
+
+  // Everything the solution wrote to its standard output (i.e., the expected
+  // output of the test case if `status` is ok).
+  std::string output;
+
+  // How long the solution ran for.
+  absl::Duration wall_time = absl::ZeroDuration();
+
+  // The peak resident memory of the solution, in bytes.
+  int64_t peak_memory_bytes = 0;
+};
+
+// ReferenceSolutionExporter
+//
+// Produces the expected output of each test case by running a reference
+// solution on it. Each test case is printed with `SimpleIO` on its own (as
+// `SimpleIOFileExporter` would write it) and piped into a new process of
+// `command` (the path of the solution, then its arguments). Its standard
+// output, exit status, running time and peak memory are stored in `runs`, in
+// the order of the test cases, once the export ends.
+//
+// The solution runs on `SetNumWorkers()` test cases at a time, in the
+// background, while the next test cases are exported. With
+// `Moriarty::GenerateAndExportTestCases()`, generating, printing and solving
+// the test cases all overlap. If all workers are busy and a few test cases are
+// already waiting, exporting waits for a worker, so the test cases waiting for
+// a solution do not pile up in memory.
+//
+// Example usage:
+//
+//   std::vector<ReferenceSolutionRun> runs;
+//   M.GenerateAndExportTestCases(
+//       ReferenceSolutionExporter(SimpleIO().AddLine("N").AddLine("A"),
+//                                 {"./solution"}, runs)
+//           .SetNumWorkers(8));
+//   for (const ReferenceSolutionRun& run : runs) { ... }
+class ReferenceSolutionExporter : public Exporter {
+ public:
+  // `runs` must outlive the export.
+  explicit ReferenceSolutionExporter(SimpleIO simple_io,
+                                     std::vector<std::string> command,
+                                     std::vector<ReferenceSolutionRun>& runs);
+
+  // SetNumWorkers()
+  //
+  // The number of solutions that may run at the same time. Default = the
+  // number of hardware threads.
+  ReferenceSolutionExporter& SetNumWorkers(int num_workers);
+
+  // SetTimeout()
+  //
+  // The solution is killed if it runs longer than this on a test case.
+  // Default = no limit.
+  ReferenceSolutionExporter& SetTimeout(absl::Duration timeout);
+
+  // StartExport()
+  //
+  // Starts the workers.
+  void StartExport() override;
+
+  // ExportTestCase()
+  //
+  // Prints the current test case and queues it for a worker.
+  void ExportTestCase() override;
+
+  // EndExport()
+  //
+  // Waits for the solution to finish on every test case and stores the runs.
+  void EndExport() override;
+
+ private:
+  class WorkerPool;
+
+  SimpleIO simple_io_;
+  std::vector<std::string> command_;
+  std::vector<ReferenceSolutionRun>* runs_;
+  int num_workers_;
+  absl::Duration timeout_ = absl::InfiniteDuration();
+
+  // A copy of the general constraints, used to print the test cases.
+  moriarty_internal::VariableSet variables_;
+
+  // Created by `StartExport()`. Shared so that this exporter can be copied
+  // before the export starts (e.g., into `Moriarty::ExportTestCases()`).
+  std::shared_ptr<WorkerPool> pool_;
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_REFERENCE_SOLUTION_EXPORTER_H_
@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/reference_solution_exporter.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "src/generator.h"
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::StatusIs;
+using ::testing::Gt;
+using ::testing::SizeIs;
+
+constexpr int kNumTestCases = 10;
+
+// Test case `n` has N = n.
+class CountingGenerator : public Generator {
+ public:
+  void GenerateTestCases() override {
+    for (int n = 1; n <= kNumTestCases; n++)
+      AddTestCase().ConstrainVariable("N", MInteger().Is(n));
+  }
+};
+
+Moriarty CountingMoriarty() {
+  Moriarty M;
+  M.SetSeed("reference-solution-exporter");
+  M.AddVariable("N", MInteger().Between(1, 100));
+  M.AddGenerator("Counting", CountingGenerator());
+  return M;
+}
+
+// Each test case is the header line "2", then N.
+SimpleIO TestSimpleIO() {
+  return SimpleIO().AddHeaderLine(StringLiteral("2")).AddLine("N");
+}
+
+// A solution that prints `N * 2`, after running `extra` (a shell command that
+// may use $n).
+std::vector<std::string> Solution(absl::string_view extra = "true") {
+  return {"/bin/sh", "-c",
+          absl::StrCat("read k; read n; ", extra, "; echo $((k * n))")};
+}
+
+void ExpectDoubledOutputs(const std::vector<ReferenceSolutionRun>& runs) {
+  ASSERT_THAT(runs, SizeIs(kNumTestCases));
+  for (int i = 0; i < kNumTestCases; i++) {
+    const ReferenceSolutionRun& run = runs[i];
+    MORIARTY_EXPECT_OK(run.status);
+    EXPECT_EQ(run.output, absl::StrCat(2 * (i + 1), "\n"));
+    EXPECT_EQ(run.metadata.GetTestCaseNumber(), i + 1);
+    EXPECT_EQ(run.metadata.GetGeneratorMetadata()->generator_name,
+              "Counting");
+    EXPECT_THAT(run.peak_memory_bytes, Gt(0));
+    EXPECT_GT(run.wall_time, absl::ZeroDuration());
+  }
+}
+
+TEST(ReferenceSolutionExporterTest, ShouldRunTheSolutionOnEveryTestCase) {
+  Moriarty M = CountingMoriarty();
+  M.GenerateTestCases();
+
+  std::vector<ReferenceSolutionRun> runs;
+  M.ExportTestCases(
+      ReferenceSolutionExporter(TestSimpleIO(), Solution(), runs)
+          .SetNumWorkers(3));
+  ExpectDoubledOutputs(runs);
+}
+
+TEST(ReferenceSolutionExporterTest, ShouldRunWhileTestCasesAreStreamed) {
+  Moriarty M = CountingMoriarty();
+
+  std::vector<ReferenceSolutionRun> runs;
+  M.GenerateAndExportTestCases(
+      ReferenceSolutionExporter(TestSimpleIO(), Solution(), runs)
+          .SetNumWorkers(2));
+  ExpectDoubledOutputs(runs);
+}
+
+TEST(ReferenceSolutionExporterTest, OneWorkerShouldRunEveryTestCase) {
+  Moriarty M = CountingMoriarty();
+
+  std::vector<ReferenceSolutionRun> runs;
+  M.GenerateAndExportTestCases(
+      ReferenceSolutionExporter(TestSimpleIO(), Solution(), runs)
+          .SetNumWorkers(1));
+  ExpectDoubledOutputs(runs);
+}
+
+TEST(ReferenceSolutionExporterTest, FailuresShouldBeRecordedPerTestCase) {
+  Moriarty M = CountingMoriarty();
+  M.GenerateTestCases();
+
+  std::vector<ReferenceSolutionRun> runs;
+  M.ExportTestCases(
+      ReferenceSolutionExporter(TestSimpleIO(),
+                                Solution("[ $((n % 3)) -ne 0 ] || exit 7"),
+                                runs)
+          .SetNumWorkers(4));
+
+  ASSERT_THAT(runs, SizeIs(kNumTestCases));
+  for (int i = 0; i < kNumTestCases; i++) {
+    if ((i + 1) % 3 == 0) {
+      EXPECT_THAT(runs[i].status, StatusIs(absl::StatusCode::kAborted));
+    } else {
+      MORIARTY_EXPECT_OK(runs[i].status);
+    }
+  }
+}
+
+TEST(ReferenceSolutionExporterTest, SlowSolutionsShouldBeKilled) {
+  Moriarty M = CountingMoriarty();
+  M.GenerateTestCases();
+
+  std::vector<ReferenceSolutionRun> runs;
+  M.ExportTestCases(
+      ReferenceSolutionExporter(TestSimpleIO(),
+                                Solution("[ $n -ne 4 ] || sleep 10"), runs)
+          .SetTimeout(absl::Milliseconds(200)));
+
+  ASSERT_THAT(runs, SizeIs(kNumTestCases));
+  EXPECT_THAT(runs[3].status, StatusIs(absl::StatusCode::kDeadlineExceeded));
+  MORIARTY_EXPECT_OK(runs[4].status);
+}
+
+}  // namespace
+}  // namespace moriarty
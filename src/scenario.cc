@@ -24,17 +24,22 @@
 namespace moriarty {
 
 Scenario& Scenario::WithGeneralProperty(Property property) {
+  // General properties come before the type-specific ones.
+  for (auto& [type, properties] : properties_by_type_)
+    properties.insert(properties.begin() + properties_.size(), property);
   properties_.push_back(std::move(property));
   return *this;
 }
 
 Scenario& Scenario::WithTypeSpecificProperty(absl::string_view mvariable_type,
                                              Property property) {
+  properties_by_type_.try_emplace(mvariable_type, properties_)
+      .first->second.push_back(property);
   type_specific_properties_[mvariable_type].push_back(std::move(property));
   return *this;
 }
 
-std::vector<Property> Scenario::GetGeneralProperties() const {
+const std::vector<Property>& Scenario::GetGeneralProperties() const {
   return properties_;
 }
 
@@ -45,4 +50,11 @@ std::vector<Property> Scenario::GetTypeSpecificProperties(
   return it->second;
 }
 
+const std::vector<Property>& Scenario::GetPropertiesFor(
+    absl::string_view mvariable_type) const {
+  auto it = properties_by_type_.find(mvariable_type);
+  if (it == properties_by_type_.end()) return properties_;
+  return it->second;
+}
+
 }  // namespace moriarty
@@ -50,7 +50,7 @@ class Scenario {
   // GetGeneralProperties()
   //
   // Returns a list of all properties that apply to all types.
-  std::vector<Property> GetGeneralProperties() const;
+  const std::vector<Property>& GetGeneralProperties() const;
 
   // GetTypeSpecificProperties()
   //
@@ -59,10 +59,29 @@ class Scenario {
   std::vector<Property> GetTypeSpecificProperties(
       absl::string_view mvariable_type) const;
 
+  // HasTypeSpecificProperties()
+  //
+  // Returns true if some property is only for some types.
+  bool HasTypeSpecificProperties() const {
+    return !type_specific_properties_.empty();
+  }
+
+  // GetPropertiesFor()
+  //
+  // Returns all properties for `mvariable_type`: the general ones, then the
+  // type-specific ones. The lists are kept up to date as properties are added,
+  // so applying a scenario to many variables does not build them again.
+  const std::vector<Property>& GetPropertiesFor(
+      absl::string_view mvariable_type) const;
+
  private:
   std::vector<Property> properties_;
   absl::flat_hash_map<std::string, std::vector<Property>>
       type_specific_properties_;
+
+  // For each type in `type_specific_properties_`, `properties_` followed by
+  // its type-specific properties.
+  absl::flat_hash_map<std::string, std::vector<Property>> properties_by_type_;
 };
 
 }  // namespace moriarty
@@ -63,5 +63,21 @@ TEST(ScenarioTest, TypeSpecificPropertiesGetAndSetAreConnectedAppropriately) {
   EXPECT_THAT(S.GetTypeSpecificProperties("MString"), IsEmpty());
 }
 
+TEST(ScenarioTest, GetPropertiesForShouldListGeneralThenTypeSpecificOnes) {
+  Scenario S = Scenario()
+                   .WithGeneralProperty({.category = "A", .descriptor = "a"})
+                   .WithTypeSpecificProperty(
+                       "MInteger", {.category = "B", .descriptor = "b"})
+                   .WithGeneralProperty({.category = "C", .descriptor = "c"});
+
+  EXPECT_THAT(S.GetPropertiesFor("MInteger"),
+              ElementsAre(Property({.category = "A", .descriptor = "a"}),
+                          Property({.category = "C", .descriptor = "c"}),
+                          Property({.category = "B", .descriptor = "b"})));
+  EXPECT_THAT(S.GetPropertiesFor("MString"),
+              ElementsAre(Property({.category = "A", .descriptor = "a"}),
+                          Property({.category = "C", .descriptor = "c"})));
+}
+
 }  // namespace
 }  // namespace moriarty
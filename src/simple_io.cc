@@ -14,17 +14,30 @@
 
 #include "src/simple_io.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <ios>
 #include <istream>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
@@ -32,11 +45,26 @@
 #include "src/exporter.h"
 #include "src/importer.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_name_utils.h"
+#include "src/internal/variable_set.h"
 #include "src/librarian/io_config.h"
+#include "src/test_case.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 
+namespace moriarty_internal {
+
+SimpleIOFileSupport& GetSimpleIOFileSupport() {
+  static SimpleIOFileSupport* support = new SimpleIOFileSupport();
+  return *support;
+}
+
+}  // namespace moriarty_internal
+
 // -----------------------------------------------------------------------------
 //  SimpleIO
 
@@ -65,33 +93,354 @@ SimpleIOExporter SimpleIO::Exporter(std::ostream& os) const {
   return SimpleIOExporter(*this, os);
 }
 
+SimpleIOFileExporter SimpleIO::FileExporter(
+    absl::string_view directory, absl::string_view filename_pattern) const {
+  return SimpleIOFileExporter(*this, directory, filename_pattern);
+}
+
 SimpleIOImporter SimpleIO::Importer(std::istream& is) const {
   return SimpleIOImporter(*this, is);
 }
 
+namespace {
+
+// Width of the number of test cases placeholder when streaming. Enough digits
+// for any `int`.
+constexpr int kNumTestCasesWidth = 10;
+
+// The buffer for `BufferedFileStream`. This is a separate base class so that it
+// is constructed before (and destroyed after) the `std::ifstream`.
+struct FileBuffer {
+  // Reading in large chunks keeps the number of reads from the OS low.
+  static constexpr int kBufferSize = 1 << 20;
+  std::vector<char> buffer = std::vector<char>(kBufferSize);
+};
+
+class BufferedFileStream : private FileBuffer, public std::ifstream {
+ public:
+  explicit BufferedFileStream(const std::string& path) {
+    // Must be called before the file is opened.
+    rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    open(path, std::ios_base::in | std::ios_base::binary);
+  }
+};
+
+class BufferedOutputFileStream : private FileBuffer, public std::ofstream {
+ public:
+  explicit BufferedOutputFileStream(const std::string& path) {
+    // Must be called before the file is opened.
+    rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    open(path, std::ios_base::out | std::ios_base::binary |
+                   std::ios_base::trunc);
+  }
+};
+
+// Returns true if the stream starts with the gzip magic bytes. `is` is
+// rewound.
+bool StartsWithGzipData(std::istream& is) {
+  char magic[2];
+  is.read(magic, sizeof(magic));
+  bool is_gzip = is.gcount() == 2 &&
+                 static_cast<unsigned char>(magic[0]) == 0x1f &&
+                 static_cast<unsigned char>(magic[1]) == 0x8b;
+  is.clear();
+  is.seekg(0);
+  return is_gzip;
+}
+
+// Prints `lines` to `io_config`, using the variables in `variables`.
+void PrintLinesTo(absl::Span<const SimpleIO::Line> lines,
+                  moriarty_internal::VariableSet& variables,
+                  librarian::IOConfig& io_config) {
+  for (const SimpleIO::Line& line : lines) {
+    for (int i = 0; i < line.size(); i++) {
+      if (i != 0) ABSL_CHECK_OK(io_config.PrintWhitespace(Whitespace::kSpace));
+      if (std::holds_alternative<StringLiteral>(line[i])) {
+        ABSL_CHECK_OK(io_config.PrintToken(
+            std::string(std::get<StringLiteral>(line[i]))));
+        continue;
+      }
+      const std::string& name = std::get<std::string>(line[i]);
+      absl::StatusOr<moriarty_internal::AbstractVariable*> var =
+          variables.GetAbstractVariable(name);
+      ABSL_CHECK_OK(var) << "Unknown variable name: " << name;
+      ABSL_CHECK_OK((*var)->PrintValue());
+    }
+    ABSL_CHECK_OK(io_config.PrintWhitespace(Whitespace::kNewline));
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<SimpleIOImporter> SimpleIO::ImporterFromFile(
+    absl::string_view path) const {
+  // With `//src:simple_io_mmap`, regular files are read in place. Other files
+  // (e.g., pipes) are read through a buffer.
+  std::shared_ptr<std::istream> is;
+  if (auto open_mapped_file =
+          moriarty_internal::GetSimpleIOFileSupport().open_mapped_file;
+      open_mapped_file != nullptr) {
+    is = open_mapped_file(path);
+  }
+  if (is == nullptr) {
+    auto buffered = std::make_shared<BufferedFileStream>(std::string(path));
+    if (!buffered->is_open()) {
+      return absl::NotFoundError(
+          absl::Substitute("Unable to open file '$0'", path));
+    }
+    is = std::move(buffered);
+  }
+  if (!StartsWithGzipData(*is)) return SimpleIOImporter(*this, std::move(is));
+
+  auto decompress_gzip =
+      moriarty_internal::GetSimpleIOFileSupport().decompress_gzip;
+  if (decompress_gzip == nullptr) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "File '$0' is gzip-compressed. Depend on //src:simple_io_gzip to read "
+        "it.",
+        path));
+  }
+  return SimpleIOImporter(*this, decompress_gzip(std::move(is)));
+}
+
+absl::StatusOr<SimpleIOCaseIndex> SimpleIO::IndexFile(
+    absl::string_view path) const {
+  BufferedFileStream is((std::string(path)));
+  if (!is.is_open()) {
+    return absl::NotFoundError(
+        absl::Substitute("Unable to open file '$0'", path));
+  }
+  if (StartsWithGzipData(is)) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Cannot index gzip-compressed file '$0'. Decompress it first.", path));
+  }
+  if (lines_per_test_case_.empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot index test cases without any lines per test case.");
+  }
+
+  std::optional<int> declared_num_cases;
+  if (has_number_of_test_cases_in_header_) {
+    std::string first_line;
+    std::getline(is, first_line);
+    int num_cases;
+    if (!absl::SimpleAtoi(absl::StripAsciiWhitespace(first_line),
+                          &num_cases) ||
+        num_cases < 0) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "Unable to parse number of test cases: $0", first_line));
+    }
+    declared_num_cases = num_cases;
+    is.clear();
+    is.seekg(0);
+  }
+
+  // Find the start of every line with `memchr`, but only keep the offsets of
+  // lines that start a test case (assuming every line is a test case line
+  // after the header).
+  int64_t header_lines =
+      lines_in_header_.size() + (has_number_of_test_cases_in_header_ ? 1 : 0);
+  int64_t lines_per_case = lines_per_test_case_.size();
+  int64_t num_lines = 0;
+  std::vector<int64_t> case_offsets;
+  // The start of the last few lines, to find where the footer starts.
+  std::deque<int64_t> last_line_offsets;
+  auto start_line = [&](int64_t offset) {
+    if (num_lines >= header_lines &&
+        (num_lines - header_lines) % lines_per_case == 0) {
+      case_offsets.push_back(offset);
+    }
+    last_line_offsets.push_back(offset);
+    if (last_line_offsets.size() > lines_in_footer_.size())
+      last_line_offsets.pop_front();
+    num_lines++;
+  };
+
+  std::vector<char> chunk(1 << 20);
+  int64_t chunk_offset = 0;
+  bool at_line_start = true;
+  while (is.read(chunk.data(), chunk.size()) || is.gcount() > 0) {
+    const char* begin = chunk.data();
+    const char* end = begin + is.gcount();
+    if (at_line_start) start_line(chunk_offset);
+    at_line_start = false;
+    for (const char* p = begin;
+         (p = static_cast<const char*>(std::memchr(p, '\n', end - p)));) {
+      if (++p == end) {
+        at_line_start = true;  // The next line starts in the next chunk.
+      } else {
+        start_line(chunk_offset + (p - begin));
+      }
+    }
+    chunk_offset += end - begin;
+  }
+
+  int64_t case_lines = num_lines - header_lines - lines_in_footer_.size();
+  int64_t num_cases = declared_num_cases.value_or(
+      std::max<int64_t>(case_lines, 0) / lines_per_case);
+  if (case_lines != num_cases * lines_per_case) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Expected $0 lines in '$1' for $2 test case(s), but found $3.",
+        num_cases * lines_per_case + header_lines + lines_in_footer_.size(),
+        path, num_cases, num_lines));
+  }
+  case_offsets.resize(num_cases);
+  // The test cases end where the footer (or the file) starts.
+  case_offsets.push_back(lines_in_footer_.empty() ? chunk_offset
+                                                  : last_line_offsets.front());
+
+  SimpleIO test_case_io;
+  test_case_io.lines_per_test_case_ = lines_per_test_case_;
+  return SimpleIOCaseIndex(std::move(test_case_io), std::string(path),
+                           std::move(case_offsets));
+}
+
+void SimpleIO::PrintSingleTestCase(moriarty_internal::VariableSet& variables,
+                                   const moriarty_internal::ValueSet& values,
+                                   librarian::IOConfig& io_config) const {
+  moriarty_internal::Universe universe = moriarty_internal::Universe()
+                                             .SetConstVariableSet(&variables)
+                                             .SetIOConfig(&io_config)
+                                             .SetConstValueSet(&values);
+  variables.SetUniverse(&universe);
+
+  if (has_number_of_test_cases_in_header_) {
+    ABSL_CHECK_OK(io_config.PrintInteger(1));
+    ABSL_CHECK_OK(io_config.PrintWhitespace(Whitespace::kNewline));
+  }
+  PrintLinesTo(lines_in_header_, variables, io_config);
+  PrintLinesTo(lines_per_test_case_, variables, io_config);
+  PrintLinesTo(lines_in_footer_, variables, io_config);
+}
+
+// -----------------------------------------------------------------------------
+//  SimpleIOCaseIndex
+
+SimpleIOCaseIndex::SimpleIOCaseIndex(SimpleIO test_case_io, std::string path,
+                                     std::vector<int64_t> case_offsets)
+    : test_case_io_(std::move(test_case_io)),
+      path_(std::move(path)),
+      case_offsets_(std::move(case_offsets)) {}
+
+int SimpleIOCaseIndex::NumTestCases() const {
+  return case_offsets_.size() - 1;
+}
+
+absl::StatusOr<SimpleIOImporter> SimpleIOCaseIndex::ImporterForCases(
+    int first_case, int num_cases) const {
+  if (first_case < 1 || num_cases < 0 ||
+      first_case - 1 + num_cases > NumTestCases()) {
+    return absl::OutOfRangeError(absl::Substitute(
+        "Cannot import $0 test case(s) starting at case $1; the file has $2.",
+        num_cases, first_case, NumTestCases()));
+  }
+  auto is = std::make_shared<BufferedFileStream>(path_);
+  if (!is->is_open()) {
+    return absl::NotFoundError(
+        absl::Substitute("Unable to open file '$0'", path_));
+  }
+  if (num_cases > 0) is->seekg(case_offsets_[first_case - 1]);
+
+  SimpleIOImporter importer(test_case_io_, std::move(is));
+  importer.SetNumTestCases(num_cases);
+  importer.first_test_case_number_ = first_case;
+  importer.case_end_offsets_.assign(
+      case_offsets_.begin() + first_case,
+      case_offsets_.begin() + first_case + num_cases);
+  return importer;
+}
+
 // -----------------------------------------------------------------------------
 //  SimpleIOExporter
 
 SimpleIOExporter::SimpleIOExporter(SimpleIO simple_io, std::ostream& os)
-    : simple_io_(std::move(simple_io)) {
+    : simple_io_(std::move(simple_io)), os_(&os) {
   io_config_.SetOutputStream(os);
   SetIOConfig(&io_config_);
 }
 
 void SimpleIOExporter::StartExport() {
+  num_test_cases_position_ = std::nullopt;
   if (simple_io_.HasNumberOfTestCasesInHeader()) {
-    ABSL_CHECK_OK(io_config_.PrintToken(absl::StrCat(NumTestCases())));
+    if (!IsStreaming()) {
+      ABSL_CHECK_OK(io_config_.PrintInteger(NumTestCases()));
+    } else {
+      // The number of test cases is filled in by `EndExport()`.
+      std::streampos position = os_->tellp();
+      ABSL_CHECK(position != std::streampos(-1))
+          << "WithNumberOfTestCasesInHeader() requires a seekable output "
+             "stream when test cases are streamed.";
+      num_test_cases_position_ = position;
+      ABSL_CHECK_OK(
+          io_config_.PrintToken(std::string(kNumTestCasesWidth, ' ')));
+    }
     ABSL_CHECK_OK(io_config_.PrintWhitespace(Whitespace::kNewline));
   }
 
   PrintLines(simple_io_.LinesInHeader());
+  CompileTestCaseLines();
+}
+
+void SimpleIOExporter::CompileTestCaseLines() {
+  using Type = PrintInstruction::Type;
+  moriarty_internal::ExporterManager manager(this);
+
+  test_case_instructions_.clear();
+  auto append_text = [this](absl::string_view text) {
+    if (test_case_instructions_.empty() ||
+        test_case_instructions_.back().type != Type::kText) {
+      test_case_instructions_.push_back({.type = Type::kText});
+    }
+    absl::StrAppend(&test_case_instructions_.back().text, text);
+  };
+
+  for (const SimpleIO::Line& line : simple_io_.LinesPerTestCase()) {
+    for (int i = 0; i < line.size(); i++) {
+      if (i != 0) append_text(" ");
+      if (std::holds_alternative<StringLiteral>(line[i])) {
+        append_text(std::string(std::get<StringLiteral>(line[i])));
+        continue;
+      }
+      const std::string& name = std::get<std::string>(line[i]);
+      // Unknown variables are reported when (and if) they are printed.
+      absl::StatusOr<moriarty_internal::AbstractVariable*> var =
+          manager.GetAbstractVariable(name);
+      test_case_instructions_.push_back(
+          {.type = Type::kVariable,
+           .text = name,
+           .variable = var.ok() ? *var : nullptr});
+    }
+    append_text("\n");
+  }
 }
 
 void SimpleIOExporter::ExportTestCase() {
-  PrintLines(simple_io_.LinesPerTestCase());
+  using Type = PrintInstruction::Type;
+  for (const PrintInstruction& instruction : test_case_instructions_) {
+    if (instruction.type == Type::kText) {
+      ABSL_CHECK_OK(io_config_.PrintToken(instruction.text));
+    } else if (instruction.variable == nullptr) {
+      PrintVariable(instruction.text);
+    } else {
+      ABSL_CHECK_OK(instruction.variable->PrintValue());
+    }
+  }
 }
 
-void SimpleIOExporter::EndExport() { PrintLines(simple_io_.LinesInFooter()); }
+void SimpleIOExporter::EndExport() {
+  PrintLines(simple_io_.LinesInFooter());
+  if (!num_test_cases_position_) return;
+
+  // The rest of the placeholder is left as trailing spaces, so the number
+  // itself has no leading zeros.
+  std::string num_test_cases = absl::StrCat(NumTestCases());
+  std::streampos end = os_->tellp();
+  ABSL_CHECK(os_->seekp(*num_test_cases_position_))
+      << "Unable to seek back to the number of test cases in the header.";
+  ABSL_CHECK_OK(io_config_.PrintToken(num_test_cases));
+  ABSL_CHECK(os_->seekp(end));
+  num_test_cases_position_ = std::nullopt;
+}
 
 void SimpleIOExporter::PrintLines(absl::Span<const SimpleIO::Line> lines) {
   for (const SimpleIO::Line& line : lines) PrintLine(line);
@@ -121,6 +470,85 @@ void SimpleIOExporter::PrintToken(const SimpleIOToken& token) {
         io_config_.PrintToken(std::string(std::get<StringLiteral>(token))));
 }
 
+// -----------------------------------------------------------------------------
+//  SimpleIOFileExporter
+
+SimpleIOFileExporter::SimpleIOFileExporter(SimpleIO simple_io,
+                                           absl::string_view directory,
+                                           absl::string_view filename_pattern)
+    : simple_io_(std::move(simple_io)),
+      directory_(directory),
+      filename_pattern_(filename_pattern) {
+  ABSL_CHECK(absl::StrContains(filename_pattern_, "$0"))
+      << "filename_pattern must contain $0 (the test case number), but got: "
+      << filename_pattern_;
+}
+
+void SimpleIOFileExporter::StartExport() {
+  variables_ = moriarty_internal::ExporterManager(this).GetGeneralConstraints();
+}
+
+void SimpleIOFileExporter::ExportTestCase() {
+  WriteTestCase(variables_,
+                moriarty_internal::ExporterManager(this).GetCurrentValues(),
+                GetTestCaseMetadata());
+}
+
+bool SimpleIOFileExporter::ExportTestCasesConcurrently() {
+  moriarty_internal::ExporterManager manager(this);
+  moriarty_internal::Scheduler* scheduler = manager.GetScheduler();
+  if (scheduler == nullptr) return false;  // Write them one at a time.
+
+  absl::Span<const moriarty_internal::ValueSet> values = manager.GetAllValues();
+  const std::vector<TestCaseMetadata>& metadata =
+      manager.GetAllTestCaseMetadata();
+
+  // Each worker (a task on the scheduler) writes with its own copy of the
+  // variables and claims the next unwritten test case until none are left.
+  // The file names only depend on the metadata, not on which worker wrote it.
+  int num_cases = values.size();
+  int num_workers = std::min(scheduler->NumThreads(), num_cases);
+  std::atomic<int> next_case_idx = 0;
+  scheduler->ParallelFor(num_workers, [&](int) {
+    moriarty_internal::VariableSet variables = variables_;
+    for (int idx = next_case_idx++; idx < num_cases; idx = next_case_idx++)
+      WriteTestCase(variables, values[idx], metadata[idx]);
+  });
+  return true;
+}
+
+void SimpleIOFileExporter::WriteTestCase(
+    moriarty_internal::VariableSet& variables,
+    const moriarty_internal::ValueSet& values,
+    const TestCaseMetadata& metadata) const {
+  std::string path = absl::StrCat(
+      directory_, "/",
+      absl::Substitute(filename_pattern_, metadata.GetTestCaseNumber()));
+  BufferedOutputFileStream os(path);
+  ABSL_CHECK(os.is_open()) << "Unable to open file '" << path << "'";
+
+  const moriarty_internal::SimpleIOFileSupport& support =
+      moriarty_internal::GetSimpleIOFileSupport();
+  std::unique_ptr<std::ostream> gzip;
+  if (absl::EndsWith(path, ".gz")) {
+    ABSL_CHECK(support.compress_gzip != nullptr)
+        << "Unable to compress file '" << path
+        << "'. Depend on //src:simple_io_gzip to write .gz files.";
+    gzip = support.compress_gzip(os);
+  }
+
+  librarian::IOConfig io_config;
+  io_config.SetOutputStream(gzip != nullptr ? *gzip : os);
+  simple_io_.PrintSingleTestCase(variables, values, io_config);
+
+  if (gzip != nullptr) {
+    ABSL_CHECK(support.finish_gzip(*gzip))
+        << "Unable to compress file '" << path << "'";
+  }
+  os.flush();
+  ABSL_CHECK(os.good()) << "Unable to write file '" << path << "'";
+}
+
 // -----------------------------------------------------------------------------
 //  SimpleIOImporter
 
@@ -130,11 +558,29 @@ SimpleIOImporter::SimpleIOImporter(SimpleIO simple_io, std::istream& is)
   SetIOConfig(&io_config_);
 }
 
+SimpleIOImporter::SimpleIOImporter(SimpleIO simple_io,
+                                   std::shared_ptr<std::istream> is)
+    : SimpleIOImporter(std::move(simple_io), *is) {
+  owned_input_ = std::move(is);
+}
+
 void SimpleIOImporter::SetNumTestCases(int num_test_cases) {
   num_test_cases_ = num_test_cases;
 }
 
+void SimpleIOImporter::SetReadUntilEndOfInput(bool read_until_end) {
+  read_until_end_of_input_ = read_until_end;
+}
+
+void SimpleIOImporter::SetValidateWhileReading(bool validate) {
+  validate_while_reading_ = validate;
+}
+
 absl::Status SimpleIOImporter::StartImport() {
+  // This importer may have been copied or moved since it was constructed
+  // (e.g., out of an `absl::StatusOr`), so point at our own `io_config_`.
+  SetIOConfig(&io_config_);
+
   if (simple_io_.HasNumberOfTestCasesInHeader()) {
     MORIARTY_ASSIGN_OR_RETURN(std::string num_cases_str, io_config_.ReadToken(),
                               _ << "Unable to read number of cases.");
@@ -149,16 +595,159 @@ absl::Status SimpleIOImporter::StartImport() {
           num_test_cases));
     }
     SetNumTestCases(num_test_cases);
+    // A streamed export pads the number with trailing spaces to exactly
+    // `kNumTestCasesWidth` characters (see `WithNumberOfTestCasesInHeader()`).
+    // Any other trailing spaces are still an error with `kExact`.
+    if (io_config_.GetWhitespacePolicy() ==
+        librarian::IOConfig::WhitespacePolicy::kExact) {
+      int padding = kNumTestCasesWidth - static_cast<int>(num_cases_str.size());
+      int spaces = 0;
+      while (spaces < padding &&
+             io_config_.ReadWhitespace(Whitespace::kSpace).ok()) {
+        spaces++;
+      }
+      if (spaces != 0 && spaces != padding) {
+        return absl::InvalidArgumentError(
+            "Unexpected whitespace after the number of test cases.");
+      }
+    }
     MORIARTY_RETURN_IF_ERROR(io_config_.ReadWhitespace(Whitespace::kNewline));
   }
 
   MORIARTY_RETURN_IF_ERROR(ReadLines(simple_io_.LinesInHeader()));
-  Importer::SetNumTestCases(num_test_cases_);
+  if (read_until_end_of_input_ && !simple_io_.HasNumberOfTestCasesInHeader()) {
+    if (!simple_io_.LinesInFooter().empty()) {
+      return absl::FailedPreconditionError(
+          "Footer lines cannot be used when reading until the end of input.");
+    }
+    // Leaving the number of test cases unset makes `ImportTestCase()` run
+    // until it calls `Done()`.
+  } else {
+    Importer::SetNumTestCases(num_test_cases_);
+  }
+  SetFirstTestCaseNumber(first_test_case_number_);
+  CompileTestCaseLines();
   return absl::OkStatus();
 }
 
+void SimpleIOImporter::CompileTestCaseLines() {
+  using Type = ReadInstruction::Type;
+  moriarty_internal::ImporterManager manager(this);
+
+  test_case_instructions_.clear();
+  for (const SimpleIO::Line& line : simple_io_.LinesPerTestCase()) {
+    for (int i = 0; i < line.size(); i++) {
+      if (i != 0) test_case_instructions_.push_back({.type = Type::kSpace});
+      if (std::holds_alternative<StringLiteral>(line[i])) {
+        test_case_instructions_.push_back(
+            {.type = Type::kLiteral,
+             .text = std::string(std::get<StringLiteral>(line[i]))});
+        continue;
+      }
+      const std::string& name = std::get<std::string>(line[i]);
+      // Unknown variables are reported when (and if) they are read.
+      absl::StatusOr<moriarty_internal::AbstractVariable*> var =
+          manager.GetAbstractVariable(name);
+      test_case_instructions_.push_back(
+          {.type = Type::kVariable,
+           .text = name,
+           .variable = var.ok() ? *var : nullptr});
+    }
+    test_case_instructions_.push_back({.type = Type::kNewline});
+  }
+  if (validate_while_reading_) ScheduleValidationWhileReading();
+}
+
+void SimpleIOImporter::ScheduleValidationWhileReading() {
+  using Type = ReadInstruction::Type;
+
+  // The last instruction reading each variable.
+  absl::flat_hash_map<std::string, int> read_at;
+  for (int i = 0; i < test_case_instructions_.size(); i++) {
+    const ReadInstruction& instruction = test_case_instructions_[i];
+    if (instruction.type == Type::kVariable && instruction.variable != nullptr)
+      read_at[instruction.text] = i;
+  }
+
+  // Each variable is validated right after the last of it and its dependencies
+  // is read.
+  for (const auto& [name, index] : read_at) {
+    int ready_at = index;
+    bool all_read = true;
+    for (const std::string& dependency :
+         test_case_instructions_[index].variable->GetDependencies()) {
+      auto it = read_at.find(moriarty_internal::BaseVariableName(dependency));
+      if (it == read_at.end()) {
+        all_read = false;
+        break;
+      }
+      ready_at = std::max(ready_at, it->second);
+    }
+    if (all_read)
+      test_case_instructions_[ready_at].validate_after.push_back(index);
+  }
+  for (ReadInstruction& instruction : test_case_instructions_)
+    absl::c_sort(instruction.validate_after);
+}
+
 absl::Status SimpleIOImporter::ImportTestCase() {
-  return ReadLines(simple_io_.LinesPerTestCase());
+  using Type = ReadInstruction::Type;
+  if (read_until_end_of_input_ && !simple_io_.HasNumberOfTestCasesInHeader() &&
+      io_config_.AtEof()) {
+    Done();
+    return absl::OkStatus();
+  }
+  for (const ReadInstruction& instruction : test_case_instructions_) {
+    switch (instruction.type) {
+      case Type::kVariable:
+        if (instruction.variable == nullptr) {
+          MORIARTY_RETURN_IF_ERROR(ReadVariable(instruction.text));
+        } else {
+          MORIARTY_RETURN_IF_ERROR(instruction.variable->ReadValue());
+        }
+        for (int index : instruction.validate_after) {
+          const ReadInstruction& validate = test_case_instructions_[index];
+          MORIARTY_RETURN_IF_ERROR(
+              validate.variable->ValueSatisfiesConstraints())
+              << "'" << validate.text << "' does not satisfy constraints";
+        }
+        break;
+      case Type::kLiteral:
+        MORIARTY_RETURN_IF_ERROR(ReadLiteral(instruction.text));
+        break;
+      case Type::kSpace:
+        MORIARTY_RETURN_IF_ERROR(io_config_.ReadWhitespace(Whitespace::kSpace));
+        break;
+      case Type::kNewline:
+        MORIARTY_RETURN_IF_ERROR(
+            io_config_.ReadWhitespace(Whitespace::kNewline));
+        break;
+    }
+  }
+  return CheckTestCaseEnd();
+}
+
+absl::Status SimpleIOImporter::CheckTestCaseEnd() {
+  // Without exact whitespace, the newline at the end is not read.
+  if (case_end_offsets_.empty() ||
+      io_config_.GetWhitespacePolicy() !=
+          librarian::IOConfig::WhitespacePolicy::kExact) {
+    return absl::OkStatus();
+  }
+
+  int test_case_number = GetTestCaseMetadata().test_case_number;
+  int64_t expected =
+      case_end_offsets_[test_case_number - first_test_case_number_];
+  int64_t offset = owned_input_->tellg();
+  if (offset != expected) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "Test case $0 ends at byte $1, but the index expected byte $2. "
+        "SimpleIOCaseIndex assumes each test case has exactly $3 line(s), so "
+        "it cannot be used if a variable's value spans several lines.",
+        test_case_number, offset, expected,
+        simple_io_.LinesPerTestCase().size()));
+  }
+  return absl::OkStatus();
 }
 
 absl::Status SimpleIOImporter::EndImport() {
@@ -196,9 +785,11 @@ absl::Status SimpleIOImporter::ReadToken(const SimpleIOToken& token) {
   if (std::holds_alternative<std::string>(token)) {
     return ReadVariable(std::get<std::string>(token));
   }
+  return ReadLiteral(std::string(std::get<StringLiteral>(token)));
+}
 
+absl::Status SimpleIOImporter::ReadLiteral(absl::string_view expected) {
   MORIARTY_ASSIGN_OR_RETURN(std::string read_token, io_config_.ReadToken());
-  std::string expected = std::string(std::get<StringLiteral>(token));
   if (read_token != expected) {
     return absl::InvalidArgumentError(absl::Substitute(
         "Expected to read '$0', but read '$1' instead.", expected, read_token));
@@ -17,8 +17,12 @@
 #ifndef MORIARTY_SRC_SIMPLE_IO_H_
 #define MORIARTY_SRC_SIMPLE_IO_H_
 
+#include <cstdint>
+#include <ios>
 #include <iostream>
 #include <istream>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -26,11 +30,16 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "src/exporter.h"
 #include "src/importer.h"
+#include "src/internal/abstract_variable.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
 #include "src/librarian/io_config.h"
+#include "src/test_case.h"
 
 namespace moriarty {
 
@@ -57,8 +66,10 @@ class StringLiteral {
 //  - `StringLiteral`: An exact string to be printed/read.
 using SimpleIOToken = std::variant<std::string, StringLiteral>;
 
-class SimpleIOExporter;  // Forward declaration.
-class SimpleIOImporter;  // Forward declaration.
+class SimpleIOCaseIndex;     // Forward declaration.
+class SimpleIOExporter;      // Forward declaration.
+class SimpleIOFileExporter;  // Forward declaration.
+class SimpleIOImporter;      // Forward declaration.
 
 // SimpleIO
 //
@@ -101,6 +112,16 @@ class SimpleIO {
   // The first line of the header (regardless of other calls to
   // `AddHeaderLine()`) will be a line containing a single integer, the number
   // of test cases.
+  //
+  // When the test cases are streamed (e.g., `GenerateAndExportTestCases()`),
+  // the number is not known until the end. The exporter then writes a
+  // placeholder of spaces and fills in the number once all test cases have
+  // been exported. This requires a seekable output stream (e.g., a file or a
+  // `std::stringstream`). The number has no leading zeros, but the rest of the
+  // placeholder is left as trailing spaces on that line (e.g., "42" followed
+  // by 8 spaces). `SimpleIOImporter` accepts a number padded to exactly 10
+  // characters (and no other trailing spaces); a reader that rejects trailing
+  // whitespace needs the test cases to not be streamed.
   SimpleIO& WithNumberOfTestCasesInHeader();
 
   // Exporter()
@@ -109,12 +130,64 @@ class SimpleIO {
   // The output will be printed to `os`.
   [[nodiscard]] SimpleIOExporter Exporter(std::ostream& os) const;
 
+  // FileExporter()
+  //
+  // Creates a SimpleIOFileExporter from the configuration provided by this
+  // class. Each test case is written to its own file in `directory`. See
+  // `SimpleIOFileExporter` for the format of `filename_pattern`.
+  [[nodiscard]] SimpleIOFileExporter FileExporter(
+      absl::string_view directory, absl::string_view filename_pattern) const;
+
   // Importer()
   //
   // Creates a SimpleIOImporter from the configuration provided by this class.
   // The output will be read from `is`.
   [[nodiscard]] SimpleIOImporter Importer(std::istream& is) const;
 
+  // ImporterFromFile()
+  //
+  // Creates a SimpleIOImporter from the configuration provided by this class.
+  // The input will be read from the file at `path` using a large read buffer.
+  // If the program depends on `//src:simple_io_mmap`, regular files are
+  // memory-mapped and read in place instead.
+  // The importer owns the file, so it does not need to outlive any stream.
+  // Gzip-compressed files are detected and decompressed automatically if the
+  // program depends on `//src:simple_io_gzip`.
+  //
+  // Returns kNotFound if the file cannot be opened, and kFailedPrecondition if
+  // it is gzip-compressed without `//src:simple_io_gzip`.
+  absl::StatusOr<SimpleIOImporter> ImporterFromFile(
+      absl::string_view path) const;
+
+  // IndexFile()
+  //
+  // Scans the file at `path` once, without reading any values, and records
+  // where each test case starts. Use the index to import (and validate) only
+  // some of the test cases in a large file, e.g., when bisecting for a bad
+  // case. This assumes that each line here is exactly one line in the file
+  // (i.e., no variable prints a newline). If a variable's value spans several
+  // lines, the index is wrong; this is caught here if the file does not have
+  // the number of lines the number of test cases in the header implies, and
+  // otherwise when a test case imported with the index does not end where the
+  // index expects it to.
+  //
+  // Returns kNotFound if the file cannot be opened, and kInvalidArgument if it
+  // is gzip-compressed or does not have the expected number of lines.
+  absl::StatusOr<SimpleIOCaseIndex> IndexFile(absl::string_view path) const;
+
+  // PrintSingleTestCase()
+  //
+  // Prints the test case with `values` to `io_config` as if it were the only
+  // one: the header lines (with 1 as the number of test cases, if requested),
+  // its lines and the footer lines. `variables` are the general constraints
+  // used to print the values. Used by exporters that write each test case on
+  // its own (e.g., `SimpleIOFileExporter`).
+  //
+  // Crashes if a value cannot be printed.
+  void PrintSingleTestCase(moriarty_internal::VariableSet& variables,
+                           const moriarty_internal::ValueSet& values,
+                           librarian::IOConfig& io_config) const;
+
   // Access the lines
   using Line = std::vector<SimpleIOToken>;
   const std::vector<Line>& LinesInHeader() const;
@@ -162,15 +235,118 @@ class SimpleIOImporter : public Importer {
   // Sets the number of test cases to import. Default = 1.
   void SetNumTestCases(int num_test_cases);
 
+  // SetReadUntilEndOfInput()
+  //
+  // If `read_until_end`, test cases are imported until the end of the input
+  // instead of a fixed number of them (see `SetNumTestCases()`). The end is
+  // checked with `IOConfig::AtEof()` before each test case. Cannot be used
+  // with footer lines. Ignored if the number of test cases is in the header.
+  // Default = false.
+  void SetReadUntilEndOfInput(bool read_until_end);
+
+  // SetValidateWhileReading()
+  //
+  // If `validate`, each variable of a test case is checked against its
+  // constraints as soon as it and all of its dependencies have been read, so
+  // a bad input is rejected at the first invalid variable instead of after the
+  // whole input has been read. Variables that depend on a variable not read in
+  // the test case are not checked early. Default = false.
+  void SetValidateWhileReading(bool validate);
+
  private:
+  friend class SimpleIO;
+  friend class SimpleIOCaseIndex;
+
+  // Same as above, but keeps `is` alive as long as this importer (or any copy
+  // of it) is.
+  explicit SimpleIOImporter(SimpleIO simple_io,
+                            std::shared_ptr<std::istream> is);
+
   SimpleIO simple_io_;
   librarian::IOConfig io_config_;
+  std::shared_ptr<std::istream> owned_input_;
   int num_test_cases_ = 1;
-
+  int first_test_case_number_ = 1;
+  bool read_until_end_of_input_ = false;
+  bool validate_while_reading_ = false;
+  // Only set by `SimpleIOCaseIndex::ImporterForCases()`. The byte offset where
+  // each test case read should end (see `CheckTestCaseEnd()`).
+  std::vector<int64_t> case_end_offsets_;
+
+  // One step of reading a test case. `LinesPerTestCase()` is flattened into a
+  // list of these in `StartImport()`, with each variable looked up once, so
+  // reading a test case does not look up any variables by name.
+  struct ReadInstruction {
+    enum class Type { kVariable, kLiteral, kSpace, kNewline };
+    Type type;
+    // The variable name (kVariable) or the expected token (kLiteral).
+    std::string text;
+    // kVariable only. `nullptr` if there is no variable named `text`.
+    moriarty_internal::AbstractVariable* variable = nullptr;
+    // kVariable only. The variables (indices of their kVariable instructions)
+    // to validate once this one has been read. See
+    // `SetValidateWhileReading()`.
+    std::vector<int> validate_after;
+  };
+  std::vector<ReadInstruction> test_case_instructions_;
+
+  void CompileTestCaseLines();
+  void ScheduleValidationWhileReading();
   absl::Status ReadLines(absl::Span<const SimpleIO::Line> lines);
   absl::Status ReadLine(const std::vector<SimpleIOToken>& line);
   absl::Status ReadToken(const SimpleIOToken& token);
   absl::Status ReadVariable(absl::string_view variable_name);
+  absl::Status ReadLiteral(absl::string_view expected);
+  // Checks that the test case just read ends where `case_end_offsets_` says.
+  absl::Status CheckTestCaseEnd();
+};
+
+// SimpleIOCaseIndex
+//
+// The byte offset of each test case in a file written with `SimpleIO`. Create
+// one with `SimpleIO::IndexFile()`.
+//
+// Example usage:
+//
+//   MORIARTY_ASSIGN_OR_RETURN(SimpleIOCaseIndex index,
+//                             SimpleIO().AddLine("N").IndexFile("big.txt"));
+//   // Import (and validate) only cases 900 to 1000.
+//   MORIARTY_ASSIGN_OR_RETURN(SimpleIOImporter importer,
+//                             index.ImporterForCases(900, 101));
+//   M.ImportTestCases(importer);
+class SimpleIOCaseIndex {
+ public:
+  // NumTestCases()
+  //
+  // The number of test cases in the file.
+  [[nodiscard]] int NumTestCases() const;
+
+  // ImporterForCases()
+  //
+  // Creates a SimpleIOImporter that reads the `num_cases` test cases starting
+  // at `first_case` (1-based) directly from the file, without reading any
+  // other test case. The header and footer are not read. The test cases keep
+  // their numbers in the file (see `Importer::GetTestCaseMetadata()`).
+  //
+  // Returns kOutOfRange if those test cases are not all in the file and
+  // kNotFound if the file can no longer be opened. Importing fails with
+  // kInvalidArgument if a test case does not end where the index expects it
+  // to (see `SimpleIO::IndexFile()`).
+  absl::StatusOr<SimpleIOImporter> ImporterForCases(int first_case,
+                                                    int num_cases) const;
+
+ private:
+  friend class SimpleIO;
+
+  explicit SimpleIOCaseIndex(SimpleIO test_case_io, std::string path,
+                             std::vector<int64_t> case_offsets);
+
+  // Only the lines of a single test case (no header or footer).
+  SimpleIO test_case_io_;
+  std::string path_;
+  // `case_offsets_[i]` is the byte offset of the (i+1)-th test case. The last
+  // element is the byte offset where the test cases end.
+  std::vector<int64_t> case_offsets_;
 };
 
 // SimpleIOExporter
@@ -183,6 +359,9 @@ class SimpleIOExporter : public Exporter {
   // StartExport()
   //
   // Prints the header lines.
+  //
+  // Crashes if the number of test cases must be printed while streaming, but
+  // the output stream is not seekable.
   void StartExport() override;
 
   // ExportTestCase()
@@ -192,19 +371,121 @@ class SimpleIOExporter : public Exporter {
 
   // EndExport()
   //
-  // Prints the footer lines.
+  // Prints the footer lines. While streaming, this also fills in the number of
+  // test cases in the header.
   void EndExport() override;
 
  private:
   SimpleIO simple_io_;
   librarian::IOConfig io_config_;
-
+  std::ostream* os_;
+
+  // While streaming, where the number of test cases placeholder starts.
+  std::optional<std::streampos> num_test_cases_position_;
+
+  // One step of printing a test case. `LinesPerTestCase()` is flattened into a
+  // list of these in `StartExport()`. Each variable is looked up once, and each
+  // run of literals and whitespace is joined into a single piece of text.
+  struct PrintInstruction {
+    enum class Type { kVariable, kText };
+    Type type;
+    // The variable name (kVariable) or the text to print (kText).
+    std::string text;
+    // kVariable only. `nullptr` if there is no variable named `text`.
+    moriarty_internal::AbstractVariable* variable = nullptr;
+  };
+  std::vector<PrintInstruction> test_case_instructions_;
+
+  void CompileTestCaseLines();
   void PrintLines(absl::Span<const SimpleIO::Line> lines);
   void PrintLine(const std::vector<SimpleIOToken>& line);
   void PrintToken(const SimpleIOToken& token);
   void PrintVariable(absl::string_view variable_name);
 };
 
+// SimpleIOFileExporter
+//
+// Exports each test case to its own file using `SimpleIO` to orchestrate how
+// to print the data. Each file contains the header lines, the lines of a
+// single test case, and the footer lines, as if it were exported on its own
+// (so the number of test cases in the header, if requested, is 1).
+//
+// The file for a test case is `directory/filename_pattern`, with "$0" in
+// `filename_pattern` replaced by the test case number. For example, "$0.in"
+// gives "1.in", "2.in", etc. If the file name ends in ".gz", the file is
+// gzip-compressed, which requires a dependency on `//src:simple_io_gzip`.
+//
+// The files are independent, so they are written in parallel on Moriarty's
+// threads (see `Moriarty::SetNumThreads()`). Crashes if a file cannot be
+// written.
+class SimpleIOFileExporter : public Exporter {
+ public:
+  explicit SimpleIOFileExporter(SimpleIO simple_io, absl::string_view directory,
+                                absl::string_view filename_pattern);
+
+  // StartExport()
+  //
+  // Prepares the variables used to print the test cases. Nothing is written.
+  void StartExport() override;
+
+  // ExportTestCase()
+  //
+  // Writes the file for the current test case.
+  void ExportTestCase() override;
+
+ private:
+  SimpleIO simple_io_;
+  std::string directory_;
+  std::string filename_pattern_;
+
+  // A copy of the general constraints, used by `ExportTestCase()`. Printing
+  // points the variables at a Universe, so each thread needs its own copy.
+  moriarty_internal::VariableSet variables_;
+
+  // Writes all files, in parallel if there is a scheduler.
+  bool ExportTestCasesConcurrently() override;
+
+  // Writes the file for the test case with `values` and `metadata`, using
+  // `variables` to print them.
+  void WriteTestCase(moriarty_internal::VariableSet& variables,
+                     const moriarty_internal::ValueSet& values,
+                     const TestCaseMetadata& metadata) const;
+};
+
+namespace moriarty_internal {
+
+// SimpleIOFileSupport
+//
+// Optional ways for SimpleIO to read and write files, provided by other
+// targets so that `:simple_io` only needs the C++ standard library (see
+// `src/simple_io_gzip.h` and `src/simple_io_mmap.h`). Each is `nullptr` until
+// its target registers it, which happens during static initialization.
+struct SimpleIOFileSupport {
+  // Returns a stream that reads the file at `path` in place, or `nullptr` if
+  // it cannot (e.g., it is not a regular file).
+  std::shared_ptr<std::istream> (*open_mapped_file)(absl::string_view path) =
+      nullptr;
+
+  // Returns a stream that decompresses the gzip data read from `source`. The
+  // returned stream keeps `source` alive.
+  std::shared_ptr<std::istream> (*decompress_gzip)(
+      std::shared_ptr<std::istream> source) = nullptr;
+
+  // Returns a stream that gzip-compresses everything written to it into `os`.
+  std::unique_ptr<std::ostream> (*compress_gzip)(std::ostream& os) = nullptr;
+
+  // Writes the end of a stream returned by `compress_gzip`. Returns false on
+  // failure.
+  bool (*finish_gzip)(std::ostream& compressed) = nullptr;
+};
+
+// GetSimpleIOFileSupport()
+//
+// Returns the file support registered so far.
+SimpleIOFileSupport& GetSimpleIOFileSupport();
+
+}  // namespace moriarty_internal
+
 template <typename... Tokens>
 std::vector<SimpleIOToken> SimpleIO::GetTokens(Tokens&&... token) {
   std::vector<SimpleIOToken> line;
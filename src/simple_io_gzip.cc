@@ -0,0 +1,70 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/simple_io_gzip.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <utility>
+
+#include "src/gzip_stream.h"
+#include "src/simple_io.h"
+
+namespace moriarty {
+
+namespace {
+
+// Decompresses `source` while keeping it alive. `source` is held in a base
+// class so that it is constructed before `GzipInputStream` reads from it.
+struct SourceHolder {
+  std::shared_ptr<std::istream> source;
+};
+
+class OwningGzipInputStream : private SourceHolder, public GzipInputStream {
+ public:
+  explicit OwningGzipInputStream(std::shared_ptr<std::istream> source)
+      : SourceHolder{std::move(source)}, GzipInputStream(*this->source) {}
+};
+
+std::shared_ptr<std::istream> DecompressGzip(
+    std::shared_ptr<std::istream> source) {
+  return std::make_shared<OwningGzipInputStream>(std::move(source));
+}
+
+std::unique_ptr<std::ostream> CompressGzip(std::ostream& os) {
+  return std::make_unique<GzipOutputStream>(os);
+}
+
+bool FinishGzip(std::ostream& compressed) {
+  // `compressed` was created by `CompressGzip()`.
+  GzipOutputStream& gzip = static_cast<GzipOutputStream&>(compressed);
+  gzip.Finish();
+  return gzip.good();
+}
+
+[[maybe_unused]] const bool kRegistered = RegisterSimpleIOGzip();
+
+}  // namespace
+
+bool RegisterSimpleIOGzip() {
+  moriarty_internal::SimpleIOFileSupport& support =
+      moriarty_internal::GetSimpleIOFileSupport();
+  support.decompress_gzip = &DecompressGzip;
+  support.compress_gzip = &CompressGzip;
+  support.finish_gzip = &FinishGzip;
+  return true;
+}
+
+}  // namespace moriarty
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_SIMPLE_IO_GZIP_H_
+#define MORIARTY_SRC_SIMPLE_IO_GZIP_H_
+
+namespace moriarty {
+
+// Gzip support for SimpleIO.
+//
+// `//src:simple_io` does not depend on zlib. Depending on
+// `//src:simple_io_gzip` as well lets SimpleIO read and write gzip-compressed
+// files:
+//
+//  * `SimpleIO::ImporterFromFile()` decompresses gzip files.
+//  * `SimpleIOFileExporter` compresses files whose names end in ".gz".
+//
+// The support is registered during static initialization, so nothing needs to
+// be called.
+
+// RegisterSimpleIOGzip()
+//
+// Registers gzip support for SimpleIO. Called during static initialization;
+// calling it again has no effect. Always returns true.
+bool RegisterSimpleIOGzip();
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_SIMPLE_IO_GZIP_H_
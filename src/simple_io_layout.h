@@ -0,0 +1,388 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_SIMPLE_IO_LAYOUT_H_
+#define MORIARTY_SRC_SIMPLE_IO_LAYOUT_H_
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "src/exporter.h"
+#include "src/importer.h"
+#include "src/internal/abstract_variable.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+// SimpleIOName
+//
+// A string known at compile time. Only used as the template argument of
+// `SimpleIOVar` and `SimpleIOLiteral`, so that a string literal can be passed
+// (e.g., `SimpleIOVar<"N", MInteger>`).
+template <size_t N>
+struct SimpleIOName {
+  // Implicit, so that string literals can be used as template arguments.
+  constexpr SimpleIOName(const char (&str)[N]) { std::copy_n(str, N, value); }
+
+  constexpr absl::string_view View() const {
+    return absl::string_view(value, N - 1);
+  }
+
+  char value[N];
+};
+
+// SimpleIOVar
+//
+// A token of a `SimpleIOLayout`: the variable `Name`, whose type is `T` (e.g.,
+// `MInteger` or `MArray<MInteger>`).
+template <SimpleIOName Name, typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+struct SimpleIOVar {
+  using variable_type = T;
+  static constexpr absl::string_view kName = Name.View();
+};
+
+// SimpleIOLiteral
+//
+// A token of a `SimpleIOLayout`: the exact string `Text`, like `StringLiteral`
+// in `SimpleIO`.
+template <SimpleIOName Text>
+struct SimpleIOLiteral {
+  static constexpr absl::string_view kText = Text.View();
+};
+
+// SimpleIOLine
+//
+// A line of a `SimpleIOLayout`. Each token is a `SimpleIOVar` or a
+// `SimpleIOLiteral`.
+template <typename... Tokens>
+struct SimpleIOLine {};
+
+template <typename... Lines>
+class SimpleIOLayoutImporter;  // Forward declaration.
+template <typename... Lines>
+class SimpleIOLayoutExporter;  // Forward declaration.
+
+// SimpleIOLayout
+//
+// The lines of each test case, like `SimpleIO::AddLine()`, but known at
+// compile time. The importer and exporter are generated for these lines: each
+// variable is looked up once (in `StartImport()` or `StartExport()`), and each
+// value is read or printed by its own `MVariable` type directly, without
+// looking at a `SimpleIOToken` or calling `AbstractVariable`'s virtual
+// functions. The values are still stored by name in the test case. The format
+// is exactly the same as `SimpleIO`'s: the tokens of a line separated by a
+// single space, followed by '\n'.
+//
+// There are no header or footer lines; use `SimpleIO` for those.
+//
+// Example usage:
+//
+//   using Layout = SimpleIOLayout<
+//       SimpleIOLine<SimpleIOVar<"N", MInteger>>,
+//       SimpleIOLine<SimpleIOVar<"A", MArray<MInteger>>>>;
+//
+//   M.ExportTestCases(Layout().Exporter(std::cout));
+//   M.ImportTestCases(Layout().Importer(std::cin));
+template <typename... Lines>
+class SimpleIOLayout {
+ public:
+  // Exporter()
+  //
+  // Creates an exporter for these lines. The output will be printed to `os`.
+  [[nodiscard]] SimpleIOLayoutExporter<Lines...> Exporter(
+      std::ostream& os) const {
+    return SimpleIOLayoutExporter<Lines...>(os);
+  }
+
+  // Importer()
+  //
+  // Creates an importer for these lines. The input will be read from `is`.
+  [[nodiscard]] SimpleIOLayoutImporter<Lines...> Importer(
+      std::istream& is) const {
+    return SimpleIOLayoutImporter<Lines...>(is);
+  }
+};
+
+namespace moriarty_internal {
+
+template <typename... Ts>
+struct TypeList {
+  static constexpr size_t kSize = sizeof...(Ts);
+};
+
+template <typename... Lists>
+struct ConcatTypeLists;
+
+template <>
+struct ConcatTypeLists<> {
+  using type = TypeList<>;
+};
+
+template <typename... As>
+struct ConcatTypeLists<TypeList<As...>> {
+  using type = TypeList<As...>;
+};
+
+template <typename... As, typename... Bs, typename... Rest>
+struct ConcatTypeLists<TypeList<As...>, TypeList<Bs...>, Rest...> {
+  using type =
+      typename ConcatTypeLists<TypeList<As..., Bs...>, Rest...>::type;
+};
+
+// The whitespace between the tokens of a `SimpleIOLayout`.
+struct SimpleIOSpace {};
+struct SimpleIONewline {};
+
+// The tokens of a line, with a `SimpleIOSpace` between each pair of them and a
+// `SimpleIONewline` at the end.
+template <typename Line>
+struct FlattenSimpleIOLine;
+
+template <>
+struct FlattenSimpleIOLine<SimpleIOLine<>> {
+  using type = TypeList<SimpleIONewline>;
+};
+
+template <typename First, typename... Rest>
+struct FlattenSimpleIOLine<SimpleIOLine<First, Rest...>> {
+  using type = typename ConcatTypeLists<TypeList<First>,
+                                        TypeList<SimpleIOSpace, Rest>...,
+                                        TypeList<SimpleIONewline>>::type;
+};
+
+// All tokens of a test case, in the order they are read or printed.
+template <typename... Lines>
+using SimpleIOLayoutTokens = typename ConcatTypeLists<
+    typename FlattenSimpleIOLine<Lines>::type...>::type;
+
+template <typename Token>
+concept IsSimpleIOVar = requires { typename Token::variable_type; };
+
+// Sets `variable` to the variable of `Token`, found with `manager`, if `Token`
+// is a `SimpleIOVar`. Returns an error if there is no such variable or it is
+// not of the type in the layout.
+template <typename Token, typename Manager>
+absl::Status ResolveSimpleIOVariable(Manager manager,
+                                     AbstractVariable*& variable) {
+  if constexpr (IsSimpleIOVar<Token>) {
+    absl::StatusOr<AbstractVariable*> found =
+        manager.GetAbstractVariable(Token::kName);
+    if (!found.ok()) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("Unknown variable name: $0", Token::kName));
+    }
+    if (dynamic_cast<typename Token::variable_type*>(*found) == nullptr) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "Variable '$0' is a $1, which is not its type in the SimpleIOLayout.",
+          Token::kName, (*found)->Typename()));
+    }
+    variable = *found;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace moriarty_internal
+
+// SimpleIOLayoutImporter
+//
+// Imports test cases using a `SimpleIOLayout`. By default, this importer will
+// only read one test case. To alter this, use `SetNumTestCases`.
+template <typename... Lines>
+class SimpleIOLayoutImporter : public Importer {
+ public:
+  explicit SimpleIOLayoutImporter(std::istream& is) {
+    io_config_.SetInputStream(is);
+    SetIOConfig(&io_config_);
+  }
+
+  // StartImport()
+  //
+  // Looks up the variables of the layout.
+  absl::Status StartImport() override {
+    Importer::SetNumTestCases(num_test_cases_);
+    return ResolveVariables(Tokens(),
+                            std::make_index_sequence<Tokens::kSize>());
+  }
+
+  // ImportTestCase()
+  //
+  // Reads the lines of the layout.
+  absl::Status ImportTestCase() override {
+    return ReadTokens(Tokens(), std::make_index_sequence<Tokens::kSize>());
+  }
+
+  // SetNumTestCases()
+  //
+  // Sets the number of test cases to import. Default = 1.
+  void SetNumTestCases(int num_test_cases) { num_test_cases_ = num_test_cases; }
+
+ private:
+  using Tokens = moriarty_internal::SimpleIOLayoutTokens<Lines...>;
+
+  librarian::IOConfig io_config_;
+  int num_test_cases_ = 1;
+  // The variable of each token (`nullptr` if it is not a `SimpleIOVar`). Set
+  // by `StartImport()`, which checks their types.
+  std::array<moriarty_internal::AbstractVariable*, Tokens::kSize> variables_ =
+      {};
+
+  template <typename... Ts, size_t... I>
+  absl::Status ResolveVariables(moriarty_internal::TypeList<Ts...>,
+                                std::index_sequence<I...>) {
+    absl::Status status;
+    // Stops at the first error.
+    (... && (status = moriarty_internal::ResolveSimpleIOVariable<Ts>(
+                 moriarty_internal::ImporterManager(this), variables_[I]))
+                .ok());
+    return status;
+  }
+
+  template <typename... Ts, size_t... I>
+  absl::Status ReadTokens(moriarty_internal::TypeList<Ts...>,
+                          std::index_sequence<I...>) {
+    absl::Status status;
+    // Stops at the first error.
+    (... && (status = ReadToken<Ts, I>()).ok());
+    return status;
+  }
+
+  template <typename Token, size_t I>
+  absl::Status ReadToken() {
+    if constexpr (moriarty_internal::IsSimpleIOVar<Token>) {
+      using T = typename Token::variable_type;
+      // The type was checked by `StartImport()`.
+      T* variable = static_cast<T*>(variables_[I]);
+      MORIARTY_ASSIGN_OR_RETURN(
+          typename T::value_type value,
+          (moriarty_internal::MVariableManager<T, typename T::value_type>(
+               variable)
+               .TryRead()),
+          _ << "failed to read " << Token::kName);
+      SetValue<T>(Token::kName, std::move(value));
+      return absl::OkStatus();
+    } else if constexpr (std::is_same_v<Token,
+                                        moriarty_internal::SimpleIOSpace>) {
+      return io_config_.ReadWhitespace(Whitespace::kSpace);
+    } else if constexpr (std::is_same_v<Token,
+                                        moriarty_internal::SimpleIONewline>) {
+      return io_config_.ReadWhitespace(Whitespace::kNewline);
+    } else {
+      MORIARTY_ASSIGN_OR_RETURN(std::string read_token, io_config_.ReadToken());
+      if (read_token != Token::kText) {
+        return absl::InvalidArgumentError(
+            absl::Substitute("Expected to read '$0', but read '$1' instead.",
+                             Token::kText, read_token));
+      }
+      return absl::OkStatus();
+    }
+  }
+};
+
+// SimpleIOLayoutExporter
+//
+// Exports test cases using a `SimpleIOLayout`.
+//
+// Crashes if a variable of the layout is unknown or of another type, or if a
+// value cannot be printed.
+template <typename... Lines>
+class SimpleIOLayoutExporter : public Exporter {
+ public:
+  explicit SimpleIOLayoutExporter(std::ostream& os) {
+    io_config_.SetOutputStream(os);
+    SetIOConfig(&io_config_);
+  }
+
+  // StartExport()
+  //
+  // Looks up the variables of the layout.
+  void StartExport() override {
+    ABSL_CHECK_OK(
+        ResolveVariables(Tokens(), std::make_index_sequence<Tokens::kSize>()));
+  }
+
+  // ExportTestCase()
+  //
+  // Prints the lines of the layout.
+  void ExportTestCase() override {
+    PrintTokens(Tokens(), std::make_index_sequence<Tokens::kSize>());
+  }
+
+ private:
+  using Tokens = moriarty_internal::SimpleIOLayoutTokens<Lines...>;
+
+  librarian::IOConfig io_config_;
+  // The variable of each token (`nullptr` if it is not a `SimpleIOVar`). Set
+  // by `StartExport()`, which checks their types.
+  std::array<moriarty_internal::AbstractVariable*, Tokens::kSize> variables_ =
+      {};
+
+  template <typename... Ts, size_t... I>
+  absl::Status ResolveVariables(moriarty_internal::TypeList<Ts...>,
+                                std::index_sequence<I...>) {
+    absl::Status status;
+    // Stops at the first error.
+    (... && (status = moriarty_internal::ResolveSimpleIOVariable<Ts>(
+                 moriarty_internal::ExporterManager(this), variables_[I]))
+                .ok());
+    return status;
+  }
+
+  template <typename... Ts, size_t... I>
+  void PrintTokens(moriarty_internal::TypeList<Ts...>,
+                   std::index_sequence<I...>) {
+    (PrintToken<Ts, I>(), ...);
+  }
+
+  template <typename Token, size_t I>
+  void PrintToken() {
+    if constexpr (moriarty_internal::IsSimpleIOVar<Token>) {
+      using T = typename Token::variable_type;
+      // The type was checked by `StartExport()`.
+      T* variable = static_cast<T*>(variables_[I]);
+      ABSL_CHECK_OK(
+          (moriarty_internal::MVariableManager<T, typename T::value_type>(
+               variable)
+               .TryPrint(GetValueRef<T>(Token::kName))));
+    } else if constexpr (std::is_same_v<Token,
+                                        moriarty_internal::SimpleIOSpace>) {
+      ABSL_CHECK_OK(io_config_.PrintWhitespace(Whitespace::kSpace));
+    } else if constexpr (std::is_same_v<Token,
+                                        moriarty_internal::SimpleIONewline>) {
+      ABSL_CHECK_OK(io_config_.PrintWhitespace(Whitespace::kNewline));
+    } else {
+      ABSL_CHECK_OK(io_config_.PrintToken(Token::kText));
+    }
+  }
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_SIMPLE_IO_LAYOUT_H_
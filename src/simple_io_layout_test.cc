@@ -0,0 +1,128 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/simple_io_layout.h"
+
+#include <sstream>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/generator.h"
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace {
+
+using ::testing::HasSubstr;
+using ::moriarty::StatusIs;
+
+using Layout = SimpleIOLayout<
+    SimpleIOLine<SimpleIOVar<"N", MInteger>, SimpleIOLiteral<"x">,
+                 SimpleIOVar<"S", MString>>,
+    SimpleIOLine<SimpleIOVar<"A", MArray<MInteger>>>>;
+
+// The same lines as `Layout`.
+SimpleIO LayoutAsSimpleIO() {
+  return SimpleIO().AddLine("N", StringLiteral("x"), "S").AddLine("A");
+}
+
+class FiveCasesGenerator : public Generator {
+ public:
+  void GenerateTestCases() override {
+    for (int i = 0; i < 5; i++) AddTestCase();
+  }
+};
+
+Moriarty MoriartyWithSeveralTypes() {
+  Moriarty M;
+  M.SetSeed("abcde0123456789");
+  M.AddVariable("N", MInteger().Between(1, 100));
+  M.AddVariable("S", MString().OfLength(1, 10).WithAlphabet("abc"));
+  M.AddVariable("A", MArray(MInteger().Between(-1000000, 1000000))
+                         .OfLength("N"));
+  return M;
+}
+
+std::string GenerateText() {
+  Moriarty M = MoriartyWithSeveralTypes();
+  M.AddGenerator("Five", FiveCasesGenerator());
+  M.GenerateTestCases();
+  std::stringstream ss;
+  M.ExportTestCases(LayoutAsSimpleIO().Exporter(ss));
+  return ss.str();
+}
+
+TEST(SimpleIOLayoutTest, ExportMatchesSimpleIO) {
+  Moriarty M = MoriartyWithSeveralTypes();
+  M.AddGenerator("Five", FiveCasesGenerator());
+  M.GenerateTestCases();
+  std::stringstream layout;
+  M.ExportTestCases(Layout().Exporter(layout));
+
+  EXPECT_EQ(layout.str(), GenerateText());
+}
+
+TEST(SimpleIOLayoutTest, ImportedTestCasesMatchTheInput) {
+  std::string text = GenerateText();
+  std::stringstream in(text);
+  SimpleIOLayoutImporter importer = Layout().Importer(in);
+  importer.SetNumTestCases(5);
+
+  Moriarty M = MoriartyWithSeveralTypes();
+  MORIARTY_ASSERT_OK(M.ImportTestCases(importer));
+  MORIARTY_EXPECT_OK(M.TryValidateTestCases());
+  std::stringstream out;
+  M.ExportTestCases(LayoutAsSimpleIO().Exporter(out));
+  EXPECT_EQ(out.str(), text);
+}
+
+TEST(SimpleIOLayoutTest, ImportingTheWrongLiteralFails) {
+  std::stringstream in("3 y abc\n1 2 3\n");
+  Moriarty M = MoriartyWithSeveralTypes();
+  EXPECT_THAT(M.ImportTestCases(Layout().Importer(in)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected to read 'x'")));
+}
+
+TEST(SimpleIOLayoutTest, UnknownVariablesFail) {
+  std::stringstream in("3\n");
+  Moriarty M = MoriartyWithSeveralTypes();
+  EXPECT_THAT(
+      M.ImportTestCases(
+          SimpleIOLayout<SimpleIOLine<SimpleIOVar<"Q", MInteger>>>().Importer(
+              in)),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Unknown variable name: Q")));
+}
+
+TEST(SimpleIOLayoutTest, VariablesOfAnotherTypeFail) {
+  std::stringstream in("abc\n");
+  Moriarty M = MoriartyWithSeveralTypes();
+  EXPECT_THAT(
+      M.ImportTestCases(
+          SimpleIOLayout<SimpleIOLine<SimpleIOVar<"S", MInteger>>>().Importer(
+              in)),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("not its type")));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/simple_io_mmap.h"
+
+#include <ios>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/memory_mapped_file.h"
+#include "src/simple_io.h"
+
+namespace moriarty {
+
+namespace {
+
+// The contents of a memory-mapped file, read in place without copying them
+// into a buffer.
+class MappedFileStream : public std::istream {
+ public:
+  explicit MappedFileStream(MemoryMappedFile file)
+      : std::istream(nullptr), file_(std::move(file)), buffer_(file_) {
+    rdbuf(&buffer_);
+  }
+
+ private:
+  class Buffer : public std::streambuf {
+   public:
+    explicit Buffer(const MemoryMappedFile& file) {
+      // The get area is only read from, never written to.
+      char* data = const_cast<char*>(file.Contents().data());
+      setg(data, data, data + file.Contents().size());
+    }
+
+   protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override {
+      off_type base = dir == std::ios_base::beg   ? 0
+                      : dir == std::ios_base::cur ? gptr() - eback()
+                                                  : egptr() - eback();
+      return seekpos(base + off, which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+      if (!(which & std::ios_base::in) || pos < 0 || pos > egptr() - eback())
+        return pos_type(off_type(-1));
+      setg(eback(), eback() + pos, egptr());
+      return pos;
+    }
+  };
+
+  MemoryMappedFile file_;
+  Buffer buffer_;
+};
+
+std::shared_ptr<std::istream> OpenMappedFile(absl::string_view path) {
+  absl::StatusOr<MemoryMappedFile> file = MemoryMappedFile::Open(path);
+  if (!file.ok()) return nullptr;
+  return std::make_shared<MappedFileStream>(*std::move(file));
+}
+
+[[maybe_unused]] const bool kRegistered = RegisterSimpleIOMmap();
+
+}  // namespace
+
+bool RegisterSimpleIOMmap() {
+  moriarty_internal::GetSimpleIOFileSupport().open_mapped_file =
+      &OpenMappedFile;
+  return true;
+}
+
+}  // namespace moriarty
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_SIMPLE_IO_MMAP_H_
+#define MORIARTY_SRC_SIMPLE_IO_MMAP_H_
+
+namespace moriarty {
+
+// Memory-mapped files for SimpleIO.
+//
+// By default, `SimpleIO::ImporterFromFile()` reads files through a large read
+// buffer, which works on any platform. Depending on `//src:simple_io_mmap` as
+// well (which needs POSIX `mmap()`) memory-maps regular files instead, so they
+// are read in place without being copied into a buffer first.
+//
+// The support is registered during static initialization, so nothing needs to
+// be called.
+
+// RegisterSimpleIOMmap()
+//
+// Registers memory-mapped files for SimpleIO. Called during static
+// initialization; calling it again has no effect. Always returns true.
+bool RegisterSimpleIOMmap();
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_SIMPLE_IO_MMAP_H_
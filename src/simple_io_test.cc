@@ -14,7 +14,12 @@
 
 #include "src/simple_io.h"
 
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <vector>
 
@@ -22,13 +27,21 @@
 #include "gtest/gtest.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "src/exporter.h"
+#include "src/gzip_stream.h"
 #include "src/importer.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/test_case.h"
 #include "src/testing/exporter_test_util.h"
+#include "src/util/status_macro/status_macros.h"
 #include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
 #include "src/variables/minteger.h"
 
 namespace moriarty {
@@ -39,8 +52,10 @@ using ::moriarty_testing::GetExportedCases;
 using ::moriarty_testing::TwoIntegerExporter;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::SizeIs;
 using ::testing::StrEq;
 using ::testing::VariantWith;
+using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 
 // -----------------------------------------------------------------------------
@@ -126,6 +141,33 @@ TEST(SimpleIOExporterTest, ExportLinesWorksAsExpected) {
   }
 }
 
+TEST(SimpleIOExporterTest, ExportLinesWithLiteralsAndVariablesWorks) {
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("N", MInteger()));
+  ABSL_CHECK_OK(variable_set.AddVariable("M", MInteger()));
+
+  std::vector<moriarty_internal::ValueSet> value_sets(2);
+  value_sets[0].Set<MInteger>("N", 1);
+  value_sets[0].Set<MInteger>("M", 2);
+  value_sets[1].Set<MInteger>("N", 3);
+  value_sets[1].Set<MInteger>("M", 4);
+
+  std::stringstream ss;
+  SimpleIOExporter exporter = SimpleIO()
+                                  .AddLine(StringLiteral("Case"), "N", "M")
+                                  .AddLine("M", StringLiteral("end"))
+                                  .Exporter(ss);
+
+  moriarty_internal::ExporterManager(&exporter).SetGeneralConstraints(
+      variable_set);
+  moriarty_internal::ExporterManager(&exporter).SetAllValues(value_sets);
+  moriarty_internal::ExporterManager(&exporter).SetTestCaseMetadata(
+      std::vector<TestCaseMetadata>(2));
+
+  exporter.ExportTestCases();
+  EXPECT_THAT(ss.str(), StrEq("Case 1 2\n2 end\nCase 3 4\n4 end\n"));
+}
+
 TEST(SimpleIOExporterTest, ExportHeaderAndFooterLinesWorksAsExpected) {
   moriarty_internal::VariableSet variable_set;
   ABSL_CHECK_OK(variable_set.AddVariable("a", MInteger()));
@@ -205,6 +247,156 @@ TEST(SimpleIOExporterTest, ExportWithNumberOfTestCasesPrintsCases) {
   }
 }
 
+// Streams `values` of "a" (one per test case) to `exporter`.
+void StreamValuesOfA(SimpleIOExporter& exporter, std::vector<int64_t> values) {
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("a", MInteger()));
+
+  moriarty_internal::ExporterManager manager(&exporter);
+  manager.SetGeneralConstraints(variable_set);
+  manager.StartStreamingExport();
+  for (int64_t a : values) {
+    moriarty_internal::ValueSet value_set;
+    value_set.Set<MInteger>("a", a);
+    manager.StreamTestCase(value_set, TestCaseMetadata());
+  }
+  manager.EndStreamingExport();
+}
+
+TEST(SimpleIOExporterTest, StreamingWithNumberOfTestCasesFillsInTheHeader) {
+  std::stringstream ss;
+  SimpleIOExporter exporter = SimpleIO()
+                                  .WithNumberOfTestCasesInHeader()
+                                  .AddHeaderLine(StringLiteral("start"))
+                                  .AddLine("a")
+                                  .AddFooterLine(StringLiteral("end"))
+                                  .Exporter(ss);
+  StreamValuesOfA(exporter, {10, 11, 12});
+
+  // The number is padded with trailing spaces, not leading zeros.
+  EXPECT_THAT(ss.str(), StrEq(absl::StrCat("3", std::string(9, ' '), R"(
+start
+10
+11
+12
+end
+)")));
+}
+
+TEST(SimpleIOExporterTest, StreamingWithNumberOfTestCasesCanBeImported) {
+  std::stringstream ss;
+  SimpleIO simple_io = SimpleIO().WithNumberOfTestCasesInHeader().AddLine("a");
+  SimpleIOExporter exporter = simple_io.Exporter(ss);
+  StreamValuesOfA(exporter, {5, 6});
+
+  std::stringstream in(ss.str());
+  SimpleIOImporter importer = simple_io.Importer(in);
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("a", MInteger()));
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  MORIARTY_ASSERT_OK(importer.ImportTestCases());
+  EXPECT_THAT(moriarty_internal::ImporterManager(&importer).GetTestCases(),
+              SizeIs(2));
+}
+
+TEST(SimpleIOExporterDeathTest,
+     StreamingWithNumberOfTestCasesToANonSeekableStreamShouldCrash) {
+  class NonSeekableBuffer : public std::streambuf {};
+  NonSeekableBuffer buffer;
+  std::ostream os(&buffer);
+  SimpleIOExporter exporter =
+      SimpleIO().WithNumberOfTestCasesInHeader().AddLine("a").Exporter(os);
+  EXPECT_DEATH({ StreamValuesOfA(exporter, {1}); }, "seekable");
+}
+
+// -----------------------------------------------------------------------------
+//  SimpleIOFileExporter
+
+// Returns the contents of the file at `path`, decompressed if it is a ".gz".
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream ss;
+  if (absl::EndsWith(path, ".gz")) {
+    GzipInputStream gzip(file);
+    ss << gzip.rdbuf();
+  } else {
+    ss << file.rdbuf();
+  }
+  return ss.str();
+}
+
+// Exports 20 cases with `scheduler` (which may be nullptr) into a new
+// directory named `name` and returns the contents of each file, in order. The
+// files are named "case$0" followed by `extension`.
+std::vector<std::string> ExportToFiles(
+    absl::string_view name, moriarty_internal::Scheduler* scheduler,
+    absl::string_view extension = ".in") {
+  constexpr int kNumCases = 20;
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("N", MInteger()));
+  ABSL_CHECK_OK(variable_set.AddVariable("M", MInteger()));
+
+  std::vector<moriarty_internal::ValueSet> value_sets(kNumCases);
+  std::vector<TestCaseMetadata> metadata(kNumCases);
+  for (int i = 0; i < kNumCases; i++) {
+    value_sets[i].Set<MInteger>("N", i + 1);
+    value_sets[i].Set<MInteger>("M", 10 * (i + 1));
+    metadata[i].SetTestCaseNumber(i + 1);
+  }
+
+  std::string directory = absl::StrCat(::testing::TempDir(), "/", name);
+  std::filesystem::create_directories(directory);
+  std::string pattern = absl::StrCat("case$0", extension);
+  SimpleIOFileExporter exporter = SimpleIO()
+                                      .WithNumberOfTestCasesInHeader()
+                                      .AddHeaderLine(StringLiteral("start"))
+                                      .AddLine("N", "M")
+                                      .AddFooterLine("N")
+                                      .FileExporter(directory, pattern);
+
+  moriarty_internal::ExporterManager manager(&exporter);
+  manager.SetGeneralConstraints(variable_set);
+  manager.SetAllValues(value_sets);
+  manager.SetTestCaseMetadata(metadata);
+  manager.SetScheduler(scheduler);
+  exporter.ExportTestCases();
+
+  std::vector<std::string> contents;
+  for (int i = 1; i <= kNumCases; i++)
+    contents.push_back(
+        ReadFile(absl::StrCat(directory, "/case", i, extension)));
+  return contents;
+}
+
+TEST(SimpleIOFileExporterTest, EachCaseIsWrittenToItsOwnFile) {
+  std::vector<std::string> contents =
+      ExportToFiles("file_exporter_serial", /* scheduler = */ nullptr);
+  ASSERT_EQ(contents.size(), 20);
+  EXPECT_EQ(contents[0], "1\nstart\n1 10\n1\n");
+  EXPECT_EQ(contents[19], "1\nstart\n20 200\n20\n");
+}
+
+TEST(SimpleIOFileExporterTest, ParallelExportWritesTheSameFiles) {
+  moriarty_internal::WorkStealingScheduler scheduler(4);
+  EXPECT_EQ(ExportToFiles("file_exporter_parallel", &scheduler),
+            ExportToFiles("file_exporter_serial", nullptr));
+}
+
+TEST(SimpleIOFileExporterTest, GzFilesAreCompressed) {
+  moriarty_internal::WorkStealingScheduler scheduler(4);
+  std::vector<std::string> contents =
+      ExportToFiles("file_exporter_gzip", &scheduler, ".in.gz");
+  EXPECT_EQ(contents, ExportToFiles("file_exporter_serial", nullptr));
+
+  std::ifstream file(absl::StrCat(::testing::TempDir(),
+                                  "/file_exporter_gzip/case1.in.gz"),
+                     std::ios::binary);
+  char magic[2];
+  file.read(magic, sizeof(magic));
+  EXPECT_TRUE(IsGzipData(magic, file.gcount()));
+}
+
 // -----------------------------------------------------------------------------
 //  SimpleIOImporter
 
@@ -229,6 +421,240 @@ TEST(SimpleIOImporterTest, ImportLinesWorksAsExpected) {
                           Case({.r = 3, .s = 33}), Case({.r = 4, .s = 44})));
 }
 
+TEST(SimpleIOImporterTest, ImporterFromFileWorksAsExpected) {
+  using Case = ExampleTestCase;
+
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("R", MInteger()));
+  ABSL_CHECK_OK(variable_set.AddVariable("S", MInteger()));
+
+  std::string path = absl::StrCat(::testing::TempDir(), "/simple_io_input.txt");
+  {
+    std::ofstream file(path);
+    file << "3\n1 11\n2 22\n3 33\n";
+  }
+
+  absl::StatusOr<SimpleIOImporter> importer =
+      SimpleIO().WithNumberOfTestCasesInHeader().AddLine("R", "S")
+          .ImporterFromFile(path);
+  MORIARTY_ASSERT_OK(importer);
+
+  // Import from a moved copy; the importer owns the file.
+  SimpleIOImporter moved_importer = *std::move(importer);
+  moriarty_internal::ImporterManager(&moved_importer)
+      .SetGeneralConstraints(variable_set);
+
+  MORIARTY_ASSERT_OK(moved_importer.ImportTestCases());
+  EXPECT_THAT(
+      GetExportedCases<TwoIntegerExporter>(
+          moriarty_internal::ImporterManager(&moved_importer).GetTestCases()),
+      ElementsAre(Case({.r = 1, .s = 11}), Case({.r = 2, .s = 22}),
+                  Case({.r = 3, .s = 33})));
+}
+
+TEST(SimpleIOImporterTest, ImporterFromFileWorksWithoutMemoryMapping) {
+  std::string path =
+      absl::StrCat(::testing::TempDir(), "/simple_io_buffered.txt");
+  {
+    std::ofstream file(path);
+    file << "1 11\n2 22\n";
+  }
+
+  // Only this test acts as if `//src:simple_io_mmap` was not linked in.
+  moriarty_internal::SimpleIOFileSupport& support =
+      moriarty_internal::GetSimpleIOFileSupport();
+  moriarty_internal::SimpleIOFileSupport registered = support;
+  support.open_mapped_file = nullptr;
+  absl::StatusOr<SimpleIOImporter> importer =
+      SimpleIO().AddLine("R", "S").ImporterFromFile(path);
+  support = registered;
+  MORIARTY_ASSERT_OK(importer);
+
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("R", MInteger()));
+  ABSL_CHECK_OK(variable_set.AddVariable("S", MInteger()));
+  importer->SetNumTestCases(2);
+  moriarty_internal::ImporterManager(&*importer)
+      .SetGeneralConstraints(variable_set);
+  MORIARTY_ASSERT_OK(importer->ImportTestCases());
+  EXPECT_THAT(
+      GetExportedCases<TwoIntegerExporter>(
+          moriarty_internal::ImporterManager(&*importer).GetTestCases()),
+      ElementsAre(ExampleTestCase({.r = 1, .s = 11}),
+                  ExampleTestCase({.r = 2, .s = 22})));
+}
+
+TEST(SimpleIOImporterTest, ImporterFromFileDecompressesGzipFiles) {
+  using Case = ExampleTestCase;
+
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("R", MInteger()));
+  ABSL_CHECK_OK(variable_set.AddVariable("S", MInteger()));
+
+  std::string path =
+      absl::StrCat(::testing::TempDir(), "/simple_io_input.txt.gz");
+  {
+    std::ofstream file(path, std::ios::binary);
+    GzipOutputStream gzip(file);
+    gzip << "2\n1 11\n2 22\n";
+  }
+
+  absl::StatusOr<SimpleIOImporter> importer =
+      SimpleIO().WithNumberOfTestCasesInHeader().AddLine("R", "S")
+          .ImporterFromFile(path);
+  MORIARTY_ASSERT_OK(importer);
+  moriarty_internal::ImporterManager(&*importer)
+      .SetGeneralConstraints(variable_set);
+
+  MORIARTY_ASSERT_OK(importer->ImportTestCases());
+  EXPECT_THAT(
+      GetExportedCases<TwoIntegerExporter>(
+          moriarty_internal::ImporterManager(&*importer).GetTestCases()),
+      ElementsAre(Case({.r = 1, .s = 11}), Case({.r = 2, .s = 22})));
+}
+
+TEST(SimpleIOImporterTest, ImporterFromFileRejectsGzipFilesWithoutGzipSupport) {
+  std::string path =
+      absl::StrCat(::testing::TempDir(), "/simple_io_unsupported.txt.gz");
+  {
+    std::ofstream file(path, std::ios::binary);
+    GzipOutputStream gzip(file);
+    gzip << "1\n1 11\n";
+  }
+
+  // Only this test acts as if `//src:simple_io_gzip` was not linked in.
+  moriarty_internal::SimpleIOFileSupport& support =
+      moriarty_internal::GetSimpleIOFileSupport();
+  moriarty_internal::SimpleIOFileSupport registered = support;
+  support = {};
+  EXPECT_THAT(SimpleIO().AddLine("R", "S").ImporterFromFile(path),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("simple_io_gzip")));
+  support = registered;
+}
+
+// Writes `contents` to a new file named `name` and returns its path.
+std::string WriteFile(absl::string_view name, absl::string_view contents) {
+  std::string path = absl::StrCat(::testing::TempDir(), "/", name);
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+  return path;
+}
+
+// Imports all cases of `importer`, using "R" and "S" as MIntegers.
+absl::StatusOr<std::vector<ExampleTestCase>> ImportRS(
+    SimpleIOImporter& importer) {
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("R", MInteger()));
+  ABSL_CHECK_OK(variable_set.AddVariable("S", MInteger()));
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  MORIARTY_RETURN_IF_ERROR(importer.ImportTestCases());
+  return GetExportedCases<TwoIntegerExporter>(
+      moriarty_internal::ImporterManager(&importer).GetTestCases());
+}
+
+TEST(SimpleIOCaseIndexTest, ImporterForCasesReadsOnlyThoseCases) {
+  using Case = ExampleTestCase;
+  std::string contents = "5\nheader\n";
+  for (int i = 1; i <= 5; i++) {
+    absl::StrAppend(&contents, "A\n", i, " ", i, "\n");
+  }
+  absl::StrAppend(&contents, "footer\n");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimpleIOCaseIndex index,
+      SimpleIO()
+          .WithNumberOfTestCasesInHeader()
+          .AddHeaderLine(StringLiteral("header"))
+          .AddLine(StringLiteral("A"))
+          .AddLine("R", "S")
+          .AddFooterLine(StringLiteral("footer"))
+          .IndexFile(WriteFile("simple_io_index.txt", contents)));
+  EXPECT_EQ(index.NumTestCases(), 5);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimpleIOImporter importer,
+                                index.ImporterForCases(3, 2));
+  EXPECT_THAT(ImportRS(importer),
+              IsOkAndHolds(ElementsAre(Case({.r = 3, .s = 3}),
+                                       Case({.r = 4, .s = 4}))));
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimpleIOImporter last,
+                                index.ImporterForCases(5, 1));
+  EXPECT_THAT(ImportRS(last),
+              IsOkAndHolds(ElementsAre(Case({.r = 5, .s = 5}))));
+}
+
+TEST(SimpleIOCaseIndexTest, NumberOfCasesIsInferredWithoutAHeader) {
+  using Case = ExampleTestCase;
+  std::string path = WriteFile("simple_io_index_no_header.txt", "1 2\n3 4\n");
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimpleIOCaseIndex index,
+                                SimpleIO().AddLine("R", "S").IndexFile(path));
+  EXPECT_EQ(index.NumTestCases(), 2);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimpleIOImporter importer,
+                                index.ImporterForCases(2, 1));
+  EXPECT_THAT(ImportRS(importer),
+              IsOkAndHolds(ElementsAre(Case({.r = 3, .s = 4}))));
+}
+
+TEST(SimpleIOCaseIndexTest, ImportingAVariableOnSeveralLinesFails) {
+  // Each test case is an array of 2 integers on 2 lines, but the index
+  // assumes each test case is a single line.
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimpleIOCaseIndex index,
+      SimpleIO().AddLine("A").IndexFile(
+          WriteFile("simple_io_index_multiline.txt", "1\n2\n3\n4\n")));
+  ASSERT_EQ(index.NumTestCases(), 4);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(SimpleIOImporter importer,
+                                index.ImporterForCases(2, 1));
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable(
+      "A", MArray<MInteger>().OfLength(2).WithSeparator(Whitespace::kNewline)));
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  // The test case keeps its number in the file.
+  EXPECT_THAT(importer.ImportTestCases(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Test case 2 ends at byte 6, but the index "
+                                 "expected byte 4")));
+}
+
+TEST(SimpleIOCaseIndexTest, ImporterForCasesOutsideTheFileFails) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SimpleIOCaseIndex index,
+      SimpleIO().AddLine("R", "S").IndexFile(
+          WriteFile("simple_io_index_range.txt", "1 2\n3 4\n")));
+  EXPECT_THAT(index.ImporterForCases(0, 1),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(index.ImporterForCases(2, 2),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  MORIARTY_EXPECT_OK(index.ImporterForCases(3, 0));
+}
+
+TEST(SimpleIOCaseIndexTest, IndexFileWithWrongNumberOfLinesFails) {
+  EXPECT_THAT(SimpleIO()
+                  .WithNumberOfTestCasesInHeader()
+                  .AddLine("R", "S")
+                  .IndexFile(WriteFile("simple_io_index_bad.txt", "3\n1 2\n")),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("for 3 test case(s)")));
+  std::string odd = WriteFile("simple_io_index_odd.txt", "A\n1 2\nA\n");
+  EXPECT_THAT(SimpleIO().AddLine(StringLiteral("A")).AddLine("R").IndexFile(
+                  odd),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(SimpleIO().AddLine("R").IndexFile(
+                  absl::StrCat(::testing::TempDir(), "/does_not_exist.txt")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(SimpleIOImporterTest, ImporterFromFileWithMissingFileFails) {
+  EXPECT_THAT(SimpleIO().AddLine("R").ImporterFromFile(absl::StrCat(
+                  ::testing::TempDir(), "/this_file_does_not_exist.txt")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 TEST(SimpleIOImporterTest, ExportHeaderAndFooterLinesWorksAsExpected) {
   using Case = ExampleTestCase;
 
@@ -278,6 +704,41 @@ TEST(SimpleIOImporterTest, ImportWrongTokenFails) {
                        HasSubstr("Expected to read 'right'")));
 }
 
+TEST(SimpleIOImporterTest, ImportManyCasesWithLiteralsAndVariablesWorks) {
+  using Case = ExampleTestCase;
+
+  moriarty_internal::VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger()));
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("S", MInteger()));
+
+  std::string input;
+  for (int i = 1; i <= 100; i++)
+    absl::StrAppend(&input, "R= ", i, "\n", -i, "\n");
+  std::stringstream ss(input);
+  SimpleIOImporter importer =
+      SimpleIO().AddLine(StringLiteral("R="), "R").AddLine("S").Importer(ss);
+  importer.SetNumTestCases(100);
+
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+
+  MORIARTY_ASSERT_OK(importer.ImportTestCases());
+  std::vector<Case> cases = GetExportedCases<TwoIntegerExporter>(
+      moriarty_internal::ImporterManager(&importer).GetTestCases());
+  ASSERT_EQ(cases.size(), 100);
+  for (int i = 1; i <= 100; i++)
+    EXPECT_EQ(cases[i - 1], Case({.r = i, .s = -i}));
+}
+
+TEST(SimpleIOImporterTest, ImportUnknownVariableFails) {
+  std::stringstream ss("1\n");
+  SimpleIOImporter importer = SimpleIO().AddLine("R").Importer(ss);
+
+  EXPECT_THAT(importer.ImportTestCases(),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("Unknown variable name: R")));
+}
+
 TEST(SimpleIOImporterTest, ImportWrongWhitespaceFails) {
   moriarty_internal::VariableSet variable_set;
   MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger()));
@@ -295,6 +756,112 @@ TEST(SimpleIOImporterTest, ImportWrongWhitespaceFails) {
                        HasSubstr("Expected ' ', but got '\\t'")));
 }
 
+TEST(SimpleIOImporterTest, ReadUntilEndOfInputImportsEveryTestCase) {
+  using Case = ExampleTestCase;
+
+  moriarty_internal::VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger()));
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("S", MInteger()));
+
+  std::stringstream ss("start\n1 11\n2 22\n3 33\n");
+  SimpleIOImporter importer = SimpleIO()
+                                  .AddHeaderLine(StringLiteral("start"))
+                                  .AddLine("R", "S")
+                                  .Importer(ss);
+  importer.SetReadUntilEndOfInput(true);
+
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  MORIARTY_ASSERT_OK(importer.ImportTestCases());
+  EXPECT_THAT(GetExportedCases<TwoIntegerExporter>(
+                  moriarty_internal::ImporterManager(&importer).GetTestCases()),
+              ElementsAre(Case({.r = 1, .s = 11}), Case({.r = 2, .s = 22}),
+                          Case({.r = 3, .s = 33})));
+}
+
+TEST(SimpleIOImporterTest, ReadUntilEndOfInputRejectsTrailingWhitespace) {
+  moriarty_internal::VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger()));
+
+  std::stringstream ss("1\n2\n\n");
+  SimpleIOImporter importer = SimpleIO().AddLine("R").Importer(ss);
+  importer.SetReadUntilEndOfInput(true);
+
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  EXPECT_THAT(importer.ImportTestCases(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("got whitespace instead")));
+}
+
+TEST(SimpleIOImporterTest, ReadUntilEndOfInputCannotHaveFooterLines) {
+  std::stringstream ss("1\nend\n");
+  SimpleIOImporter importer = SimpleIO()
+                                  .AddLine("R")
+                                  .AddFooterLine(StringLiteral("end"))
+                                  .Importer(ss);
+  importer.SetReadUntilEndOfInput(true);
+
+  EXPECT_THAT(importer.ImportTestCases(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("Footer lines")));
+}
+
+TEST(SimpleIOImporterTest, ValidateWhileReadingStopsAtTheFirstInvalidVariable) {
+  moriarty_internal::VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("S", MInteger()));
+
+  // The third test case cannot be read, but is never reached.
+  std::stringstream ss("5 3\n20 1\nbad input\n");
+  SimpleIOImporter importer = SimpleIO().AddLine("R", "S").Importer(ss);
+  importer.SetNumTestCases(3);
+  importer.SetValidateWhileReading(true);
+
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  EXPECT_THAT(importer.ImportTestCases(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("'R' does not satisfy constraints")));
+}
+
+TEST(SimpleIOImporterTest, ValidateWhileReadingWaitsForDependencies) {
+  moriarty_internal::VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(
+      variable_set.AddVariable("S", MInteger().Between(1, "R")));
+
+  {
+    std::stringstream ss("3 5\n");
+    SimpleIOImporter importer = SimpleIO().AddLine("S", "R").Importer(ss);
+    importer.SetValidateWhileReading(true);
+    moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+        variable_set);
+    MORIARTY_EXPECT_OK(importer.ImportTestCases());
+  }
+  {
+    std::stringstream ss("7 5\n");
+    SimpleIOImporter importer = SimpleIO().AddLine("S", "R").Importer(ss);
+    importer.SetValidateWhileReading(true);
+    moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+        variable_set);
+    EXPECT_THAT(importer.ImportTestCases(),
+                StatusIs(absl::StatusCode::kFailedPrecondition,
+                         HasSubstr("'S' does not satisfy constraints")));
+  }
+}
+
+TEST(SimpleIOImporterTest, ImportWithoutValidateWhileReadingAcceptsBadValues) {
+  moriarty_internal::VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("R", MInteger().Between(1, 10)));
+
+  std::stringstream ss("20\n");
+  SimpleIOImporter importer = SimpleIO().AddLine("R").Importer(ss);
+  moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+      variable_set);
+  MORIARTY_EXPECT_OK(importer.ImportTestCases());
+}
+
 TEST(SimpleIOImporterTest, ImportWithNumberOfTestCasesInHeaderWorksAsExpected) {
   using Case = ExampleTestCase;
 
@@ -315,6 +882,25 @@ TEST(SimpleIOImporterTest, ImportWithNumberOfTestCasesInHeaderWorksAsExpected) {
                           Case({.r = 3, .s = 33}), Case({.r = 4, .s = 44})));
 }
 
+TEST(SimpleIOImporterTest,
+     ImportWithNumberOfTestCasesInHeaderOnlyAcceptsTheStreamedPadding) {
+  moriarty_internal::VariableSet variable_set;
+  ABSL_CHECK_OK(variable_set.AddVariable("R", MInteger()));
+  auto import = [&](absl::string_view header) {
+    std::stringstream ss(absl::StrCat(header, "\n1\n2\n"));
+    SimpleIOImporter importer =
+        SimpleIO().WithNumberOfTestCasesInHeader().AddLine("R").Importer(ss);
+    moriarty_internal::ImporterManager(&importer).SetGeneralConstraints(
+        variable_set);
+    return importer.ImportTestCases();
+  };
+
+  // "2" padded to the placeholder's width of 10 characters.
+  MORIARTY_EXPECT_OK(import(absl::StrCat("2", std::string(9, ' '))));
+  EXPECT_THAT(import("2 "), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_FALSE(import(absl::StrCat("2", std::string(10, ' '))).ok());
+}
+
 TEST(SimpleIOImporterTest,
      ImportWithNumberOfTestCasesInHeaderFailsOnTooHighNumberOfCases) {
   moriarty_internal::VariableSet variable_set;
@@ -16,7 +16,9 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -27,45 +29,151 @@
 #include "src/internal/abstract_variable.h"
 #include "src/internal/generation_bootstrap.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/scenario.h"
+#include "src/test_case_mutation.h"
 #include "src/util/status_macro/status_macros.h"
 
 namespace moriarty {
 
+namespace {
+using VariableHandle = moriarty_internal::VariableSet::VariableHandle;
+}  // namespace
+
 TestCase& TestCase::WithScenario(Scenario scenario) {
   scenarios_.push_back(std::move(scenario));
   return *this;
 }
 
 void TestCase::SetVariables(moriarty_internal::VariableSet variables) {
-  variables_ = std::move(variables);
+  SetGeneralVariables(std::make_shared<const moriarty_internal::VariableSet>(
+      std::move(variables)));
+}
+
+void TestCase::SetGeneralVariables(
+    std::shared_ptr<const moriarty_internal::VariableSet> variables) {
+  general_variables_ = std::move(variables);
+  overrides_ = moriarty_internal::VariableSet();
+}
+
+void TestCase::SetSharedValues(
+    std::shared_ptr<const moriarty_internal::ValueSet> shared_values) {
+  shared_values_ = std::move(shared_values);
 }
 
 absl::StatusOr<moriarty_internal::ValueSet> TestCase::AssignAllValues(
     moriarty_internal::RandomEngine& rng,
-    std::optional<int64_t> approximate_generation_limit) {
-  MORIARTY_RETURN_IF_ERROR(DistributeScenarios());
+    std::optional<int64_t> approximate_generation_limit,
+    moriarty_internal::Scheduler* scheduler,
+    moriarty_internal::GenerationProfile* profile,
+    moriarty_internal::GenerationBudget* budget) {
+  if (values_) return *values_;
+
+  MORIARTY_ASSIGN_OR_RETURN(moriarty_internal::VariableSet variables,
+                            MaterializeVariables());
 
+  moriarty_internal::ValueSet known_values;
+  known_values.SetSharedValues(shared_values_);
   return moriarty_internal::GenerateAllValues(
-      variables_, /*known_values = */ {}, {rng, approximate_generation_limit});
+      variables, std::move(known_values),
+      {.random_engine = rng,
+       .soft_generation_limit = approximate_generation_limit,
+       .scheduler = scheduler,
+       .profile = profile,
+       .budget = budget});
 }
 
-absl::Status TestCase::DistributeScenarios() {
+absl::StatusOr<moriarty_internal::VariableSet>
+TestCase::MaterializeVariables() const {
+  const moriarty_internal::VariableSet& general = GetGeneralVariables();
+
+  // Keep the order of the variables the same as if `overrides_` had been
+  // merged into a copy of `general`: general variables first, then the new
+  // ones in the order they were added.
+  moriarty_internal::VariableSet variables;
+  for (VariableHandle handle = 0; handle < general.NumVariables(); handle++) {
+    const std::string& name = general.GetName(handle);
+    std::optional<VariableHandle> override = overrides_.GetHandle(name);
+    MORIARTY_RETURN_IF_ERROR(variables.AddVariable(
+        name, override ? *overrides_.GetAbstractVariable(*override)
+                       : *general.GetAbstractVariable(handle)));
+  }
+  for (VariableHandle handle = 0; handle < overrides_.NumVariables();
+       handle++) {
+    const std::string& name = overrides_.GetName(handle);
+    if (general.GetHandle(name).has_value()) continue;
+    MORIARTY_RETURN_IF_ERROR(
+        variables.AddVariable(name, *overrides_.GetAbstractVariable(handle)));
+  }
+
   for (const Scenario& scenario : scenarios_) {
-    MORIARTY_RETURN_IF_ERROR(variables_.WithScenario(scenario));
+    MORIARTY_RETURN_IF_ERROR(variables.WithScenario(scenario));
   }
-  return absl::OkStatus();
+  return variables;
 }
 
 TestCase& TestCase::ConstrainVariable(
     absl::string_view variable_name,
     const moriarty_internal::AbstractVariable& var) {
-  ABSL_CHECK_OK(variables_.AddOrMergeVariable(variable_name, var));
+  // The first change to a general variable starts from a copy of it.
+  if (!overrides_.GetHandle(variable_name).has_value()) {
+    const moriarty_internal::VariableSet& general = GetGeneralVariables();
+    if (std::optional<VariableHandle> handle =
+            general.GetHandle(variable_name)) {
+      ABSL_CHECK_OK(overrides_.AddVariable(
+          variable_name, *general.GetAbstractVariable(*handle)));
+    }
+  }
+  ABSL_CHECK_OK(overrides_.AddOrMergeVariable(variable_name, var));
   return *this;
 }
 
+const moriarty_internal::VariableSet& TestCase::GetGeneralVariables() const {
+  static const moriarty_internal::VariableSet* const kNoVariables =
+      new moriarty_internal::VariableSet();
+  return general_variables_ ? *general_variables_ : *kNoVariables;
+}
+
+const moriarty_internal::VariableSet& TestCase::GetOverriddenVariables()
+    const {
+  return overrides_;
+}
+
+void TestCase::SetOverriddenVariable(
+    absl::string_view variable_name,
+    const moriarty_internal::AbstractVariable& merged) {
+  ABSL_CHECK_OK(overrides_.AddVariable(variable_name, merged));
+}
+
+absl::StatusOr<std::string> TestCase::ConstraintsToString() const {
+  if (derivation_) {
+    return absl::UnimplementedError(
+        "A derived test case is not described by its constraints alone.");
+  }
+  if (values_) {
+    return absl::UnimplementedError(
+        "A test case with known values is not described by its constraints "
+        "alone.");
+  }
+  MORIARTY_ASSIGN_OR_RETURN(moriarty_internal::VariableSet variables,
+                            MaterializeVariables());
+  return variables.ToString();
+}
+
+void TestCase::SetDerivation(moriarty_internal::TestCaseDerivation derivation) {
+  derivation_ = std::move(derivation);
+}
+
+const moriarty_internal::TestCaseDerivation* TestCase::GetDerivation() const {
+  return derivation_ ? &*derivation_ : nullptr;
+}
+
+void TestCase::SetValues(moriarty_internal::ValueSet values) {
+  values_ = std::move(values);
+}
+
 namespace moriarty_internal {
 
 TestCaseManager::TestCaseManager(moriarty::TestCase* test_case_to_manage)
@@ -76,8 +184,11 @@ void TestCaseManager::SetVariables(VariableSet variables) {
 }
 
 absl::StatusOr<ValueSet> TestCaseManager::AssignAllValues(
-    RandomEngine& rng, std::optional<int64_t> approximate_generation_limit) {
-  return managed_test_case_.AssignAllValues(rng, approximate_generation_limit);
+    RandomEngine& rng, std::optional<int64_t> approximate_generation_limit,
+    Scheduler* scheduler, GenerationProfile* profile,
+    GenerationBudget* budget) {
+  return managed_test_case_.AssignAllValues(rng, approximate_generation_limit,
+                                            scheduler, profile, budget);
 }
 
 TestCase& TestCaseManager::ConstrainVariable(
@@ -86,6 +197,46 @@ TestCase& TestCaseManager::ConstrainVariable(
   return managed_test_case_.ConstrainVariable(variable_name, var);
 }
 
+void TestCaseManager::SetGeneralVariables(
+    std::shared_ptr<const VariableSet> variables) {
+  managed_test_case_.SetGeneralVariables(std::move(variables));
+}
+
+void TestCaseManager::SetSharedValues(
+    std::shared_ptr<const ValueSet> shared_values) {
+  managed_test_case_.SetSharedValues(std::move(shared_values));
+}
+
+const VariableSet& TestCaseManager::GetGeneralVariables() const {
+  return managed_test_case_.GetGeneralVariables();
+}
+
+const VariableSet& TestCaseManager::GetOverriddenVariables() const {
+  return managed_test_case_.GetOverriddenVariables();
+}
+
+void TestCaseManager::SetOverriddenVariable(
+    absl::string_view variable_name,
+    const moriarty_internal::AbstractVariable& merged) {
+  managed_test_case_.SetOverriddenVariable(variable_name, merged);
+}
+
+absl::StatusOr<std::string> TestCaseManager::ConstraintsToString() const {
+  return managed_test_case_.ConstraintsToString();
+}
+
+void TestCaseManager::SetDerivation(TestCaseDerivation derivation) {
+  managed_test_case_.SetDerivation(std::move(derivation));
+}
+
+const TestCaseDerivation* TestCaseManager::GetDerivation() const {
+  return managed_test_case_.GetDerivation();
+}
+
+void TestCaseManager::SetValues(ValueSet values) {
+  managed_test_case_.SetValues(std::move(values));
+}
+
 }  // namespace moriarty_internal
 
 }  // namespace moriarty
@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <concepts>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -30,16 +31,30 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "src/internal/abstract_variable.h"
+#include "src/internal/generation_budget.h"
+#include "src/internal/generation_profile.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
 #include "src/internal/value_set.h"
 #include "src/internal/variable_set.h"
 #include "src/librarian/mvariable.h"
 #include "src/scenario.h"
+#include "src/test_case_mutation.h"
 
 namespace moriarty {
 
 namespace moriarty_internal {
 class TestCaseManager;  // Forward declaring the internal API
+
+// TestCaseDerivation
+//
+// The values of a derived test case are a copy of the values of the
+// `base_index`-th test case of its generator, changed by `mutation` (see
+// `Generator::AddDerivedTestCase()`).
+struct TestCaseDerivation {
+  int base_index;
+  TestCaseMutation mutation;
+};
 }  // namespace moriarty_internal
 
 // TestCase
@@ -101,9 +116,29 @@ class TestCase {
   TestCase& WithScenario(Scenario scenario);
 
  private:
-  moriarty_internal::VariableSet variables_;
+  // The variables shared by all test cases of a generator (see
+  // `SetGeneralVariables()`). They are never modified through a TestCase.
+  std::shared_ptr<const moriarty_internal::VariableSet> general_variables_;
+
+  // The values of the suite-level variables, which are known to every test
+  // case (see `SetSharedValues()`). Never modified through a TestCase.
+  std::shared_ptr<const moriarty_internal::ValueSet> shared_values_;
+
+  // The variables changed by this test case (via `ConstrainVariable()` or
+  // `SetValue()`), each with all of its constraints, including the general
+  // ones. Only these are copied per test case until values are assigned.
+  moriarty_internal::VariableSet overrides_;
+
   std::vector<Scenario> scenarios_;
 
+  // Set if this test case is derived from another one. Its values are then not
+  // generated from its variables.
+  std::optional<moriarty_internal::TestCaseDerivation> derivation_;
+
+  // Set if the values of this test case are known (see `SetValues()`). They
+  // are then not generated from its variables.
+  std::optional<moriarty_internal::ValueSet> values_;
+
   // ---------------------------------------------------------------------------
   //    Start of Internal Extended API
   //
@@ -118,13 +153,34 @@ class TestCase {
   // variables that were set in the test case.
   void SetVariables(moriarty_internal::VariableSet variables);
 
+  // SetGeneralVariables() [Internal Extended API]
+  //
+  // Same as `SetVariables()`, but `variables` may be shared with other test
+  // cases instead of being copied into each of them.
+  void SetGeneralVariables(
+      std::shared_ptr<const moriarty_internal::VariableSet> variables);
+
+  // SetSharedValues() [Internal Extended API]
+  //
+  // Values that are known before this test case is generated, and are shared
+  // (not copied) with other test cases. The variables of this test case may
+  // depend on them, and they are visible in the assigned values.
+  void SetSharedValues(
+      std::shared_ptr<const moriarty_internal::ValueSet> shared_values);
+
   // AssignAllValues() [Internal Extended API]
   //
   // Assigns the value of all variables in this test case, with all
-  // randomization provided by `rng`.
+  // randomization provided by `rng`. If `scheduler` is set, a single variable
+  // may use it to generate its value on several threads. If `profile` is set,
+  // the time spent generating each variable is added to it. If `budget` is
+  // set, generation stops once it is exceeded.
   absl::StatusOr<moriarty_internal::ValueSet> AssignAllValues(
       moriarty_internal::RandomEngine& rng,
-      std::optional<int64_t> approximate_generation_limit);
+      std::optional<int64_t> approximate_generation_limit,
+      moriarty_internal::Scheduler* scheduler = nullptr,
+      moriarty_internal::GenerationProfile* profile = nullptr,
+      moriarty_internal::GenerationBudget* budget = nullptr);
 
   // GetVariable() [Internal Extended API]
   //
@@ -145,11 +201,65 @@ class TestCase {
   TestCase& ConstrainVariable(absl::string_view variable_name,
                               const moriarty_internal::AbstractVariable& var);
 
+  // GetGeneralVariables() [Internal Extended API]
+  //
+  // Returns the variables set via `SetVariables()` or `SetGeneralVariables()`,
+  // without the changes made by this test case.
+  const moriarty_internal::VariableSet& GetGeneralVariables() const;
+
+  // GetOverriddenVariables() [Internal Extended API]
+  //
+  // Returns the variables changed by this test case. These take precedence
+  // over the general variables with the same name.
+  const moriarty_internal::VariableSet& GetOverriddenVariables() const;
+
+  // SetOverriddenVariable() [Internal Extended API]
+  //
+  // Sets `variable_name` to exactly `merged`, which must already include the
+  // general constraints of `variable_name` (i.e., the result of
+  // `ConstrainVariable()` on another test case with the same general
+  // variables). Nothing is merged, and the copy of `merged` shares its
+  // constraints with it, so test cases with identical constraints share them
+  // instead of repeating the merge. `variable_name` must not have been changed
+  // by this test case yet.
+  void SetOverriddenVariable(absl::string_view variable_name,
+                             const moriarty_internal::AbstractVariable& merged);
+
+  // ConstraintsToString() [Internal Extended API]
+  //
+  // Returns `VariableSet::ToString()` of the variables in this test case, after
+  // all of its scenarios have been applied. Equal strings describe test cases
+  // that generate the same values from the same random engine.
+  //
+  // Returns `kUnimplemented` for derived test cases and test cases with known
+  // values, whose values do not only depend on their variables.
+  absl::StatusOr<std::string> ConstraintsToString() const;
+
+  // SetDerivation() [Internal Extended API]
+  //
+  // Marks this test case as derived from another one (see
+  // `TestCaseDerivation`).
+  void SetDerivation(moriarty_internal::TestCaseDerivation derivation);
+
+  // GetDerivation() [Internal Extended API]
+  //
+  // Returns how this test case is derived from another one, or `nullptr` if its
+  // values are generated from its variables.
+  const moriarty_internal::TestCaseDerivation* GetDerivation() const;
+
+  // SetValues() [Internal Extended API]
+  //
+  // The values of this test case are exactly `values`. `AssignAllValues()`
+  // returns them instead of generating values from the variables, so they
+  // must already satisfy the constraints.
+  void SetValues(moriarty_internal::ValueSet values);
+
   //    End of Internal Extended API
   // ---------------------------------------------------------------------------
 
-  // Distributes all known scenarios to the variable set.
-  absl::Status DistributeScenarios();
+  // Returns the general variables with this test case's changes (and all of its
+  // scenarios) applied.
+  absl::StatusOr<moriarty_internal::VariableSet> MaterializeVariables() const;
 };
 
 // TestCaseMetadata
@@ -198,9 +308,24 @@ class TestCaseMetadata {
     return generator_metadata_;
   }
 
+  // Records that a generated test case identical to this one was dropped (see
+  // `Moriarty::EnableDuplicateTestCaseRemoval()`).
+  TestCaseMetadata& AddDroppedDuplicate(
+      GeneratedTestCaseMetadata duplicate_metadata) {
+    dropped_duplicates_.push_back(std::move(duplicate_metadata));
+    return *this;
+  }
+
+  // The generated test cases that were dropped because they were identical to
+  // this one, in the order they were generated.
+  const std::vector<GeneratedTestCaseMetadata>& GetDroppedDuplicates() const {
+    return dropped_duplicates_;
+  }
+
  private:
   int test_case_number_;
   std::optional<GeneratedTestCaseMetadata> generator_metadata_;
+  std::vector<GeneratedTestCaseMetadata> dropped_duplicates_;
 };
 
 namespace moriarty_internal {
@@ -232,13 +357,26 @@ class TestCaseManager {
   void SetVariables(VariableSet variables);
   absl::StatusOr<ValueSet> AssignAllValues(
       moriarty_internal::RandomEngine& rng,
-      std::optional<int64_t> approximate_generation_limit);
+      std::optional<int64_t> approximate_generation_limit,
+      moriarty_internal::Scheduler* scheduler = nullptr,
+      moriarty_internal::GenerationProfile* profile = nullptr,
+      moriarty_internal::GenerationBudget* budget = nullptr);
   template <typename T>
     requires std::derived_from<T,
                                librarian::MVariable<T, typename T::value_type>>
   absl::StatusOr<T> GetVariable(absl::string_view variable_name) const;
   TestCase& ConstrainVariable(absl::string_view variable_name,
                               const moriarty_internal::AbstractVariable& var);
+  void SetGeneralVariables(std::shared_ptr<const VariableSet> variables);
+  void SetSharedValues(std::shared_ptr<const ValueSet> shared_values);
+  const VariableSet& GetGeneralVariables() const;
+  const VariableSet& GetOverriddenVariables() const;
+  void SetOverriddenVariable(absl::string_view variable_name,
+                             const moriarty_internal::AbstractVariable& merged);
+  absl::StatusOr<std::string> ConstraintsToString() const;
+  void SetDerivation(TestCaseDerivation derivation);
+  const TestCaseDerivation* GetDerivation() const;
+  void SetValues(ValueSet values);
 
  private:
   TestCase& managed_test_case_;  // Not owned by this class
@@ -261,15 +399,18 @@ template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 TestCase& TestCase::ConstrainVariable(absl::string_view variable_name,
                                       T constraints) {
-  ABSL_CHECK_OK(
-      variables_.AddOrMergeVariable(variable_name, std::move(constraints)));
-  return *this;
+  return ConstrainVariable(
+      variable_name,
+      static_cast<const moriarty_internal::AbstractVariable&>(constraints));
 }
 
 template <typename T>
   requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
 absl::StatusOr<T> TestCase::GetVariable(absl::string_view variable_name) const {
-  return variables_.GetVariable<T>(variable_name);
+  if (overrides_.GetHandle(variable_name).has_value()) {
+    return overrides_.GetVariable<T>(variable_name);
+  }
+  return GetGeneralVariables().GetVariable<T>(variable_name);
 }
 
 namespace moriarty_internal {
@@ -0,0 +1,63 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/test_case_mutation.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/value_set.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+absl::Status TestCaseMutation::Apply(
+    moriarty_internal::ValueSet& values,
+    moriarty_internal::RandomEngine& engine) const {
+  for (const Change& change : changes_) {
+    MORIARTY_RETURN_IF_ERROR(change(values, engine));
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::string> TestCaseMutation::GetChangedVariables() const {
+  std::vector<std::string> variables;
+  absl::flat_hash_set<std::string> seen;
+  for (const std::string& name : changed_variables_) {
+    if (seen.insert(name).second) variables.push_back(name);
+  }
+  return variables;
+}
+
+namespace moriarty_internal {
+
+TestCaseMutationManager::TestCaseMutationManager(
+    const moriarty::TestCaseMutation* mutation_to_manage)
+    : managed_mutation_(*mutation_to_manage) {}
+
+absl::Status TestCaseMutationManager::Apply(ValueSet& values,
+                                            RandomEngine& engine) const {
+  return managed_mutation_.Apply(values, engine);
+}
+
+std::vector<std::string> TestCaseMutationManager::GetChangedVariables() const {
+  return managed_mutation_.GetChangedVariables();
+}
+
+}  // namespace moriarty_internal
+
+}  // namespace moriarty
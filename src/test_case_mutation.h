@@ -0,0 +1,293 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_TEST_CASE_MUTATION_H_
+#define MORIARTY_SRC_TEST_CASE_MUTATION_H_
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "src/internal/generation_config.h"
+#include "src/internal/random_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty {
+
+namespace moriarty_internal {
+class TestCaseMutationManager;  // Forward declaring the internal API
+}  // namespace moriarty_internal
+
+// TestCaseMutation
+//
+// A list of changes to the values of a test case, applied in the order they
+// were added. See `Generator::AddDerivedTestCase()`, which builds a test case
+// from the values of a previous one, instead of generating a similar (large)
+// test case from scratch.
+//
+// The changed values are not checked against the constraints of their
+// variables. The constraints given to a `TestCaseMutation` must not depend on
+// other variables.
+//
+// Example:
+//
+//   // Same as `base`, except for 5 elements of A and the order of B.
+//   AddDerivedTestCase(
+//       base, TestCaseMutation()
+//                 .ChangeElements<MArray<MInteger>>("A", 5,
+//                                                   MInteger().Between(1, 9))
+//                 .Shuffle<MArray<MInteger>>("B"));
+class TestCaseMutation {
+ public:
+  // SetValue()
+  //
+  // Sets the variable `variable_name` to `value`.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  TestCaseMutation& SetValue(absl::string_view variable_name,
+                             T::value_type value);
+
+  // RegenerateValue()
+  //
+  // Replaces the value of `variable_name` with a new random value described by
+  // `constraints`.
+  template <typename T>
+    requires std::derived_from<T,
+                               librarian::MVariable<T, typename T::value_type>>
+  TestCaseMutation& RegenerateValue(absl::string_view variable_name,
+                                    T constraints);
+
+  // ChangeElements()
+  //
+  // Replaces `k` elements (at distinct random positions) of the array
+  // `variable_name`, whose MVariable is `T` (e.g., `MArray<MInteger>`), with
+  // new random values described by `element`. Fails if the array has fewer
+  // than `k` elements. Only the changed elements are touched.
+  template <typename T, typename E>
+    requires std::derived_from<
+                 T, librarian::MVariable<T, typename T::value_type>> &&
+             std::derived_from<
+                 E, librarian::MVariable<E, typename E::value_type>> &&
+             std::same_as<typename T::value_type,
+                          std::vector<typename E::value_type>>
+  TestCaseMutation& ChangeElements(absl::string_view variable_name, int64_t k,
+                                   E element);
+
+  // Shuffle()
+  //
+  // Randomly reorders the elements of the array `variable_name`, whose
+  // MVariable is `T` (e.g., `MArray<MInteger>`).
+  template <typename T>
+    requires std::derived_from<
+                 T, librarian::MVariable<T, typename T::value_type>> &&
+             std::same_as<typename T::value_type,
+                          std::vector<typename T::value_type::value_type>>
+  TestCaseMutation& Shuffle(absl::string_view variable_name);
+
+ private:
+  using Change = std::function<absl::Status(moriarty_internal::ValueSet&,
+                                            moriarty_internal::RandomEngine&)>;
+  std::vector<Change> changes_;
+
+  // The variable changed by each change in `changes_`.
+  std::vector<std::string> changed_variables_;
+
+  // ---------------------------------------------------------------------------
+  //    Start of Internal Extended API
+  //
+  // These functions can be accessed via
+  // `moriarty_internal::TestCaseMutationManager`. Users and Librarians should
+  // not need to access these functions.
+  friend class moriarty_internal::TestCaseMutationManager;
+
+  // Apply() [Internal Extended API]
+  //
+  // Applies all changes to `values`, with all randomness from `engine`.
+  absl::Status Apply(moriarty_internal::ValueSet& values,
+                     moriarty_internal::RandomEngine& engine) const;
+
+  // GetChangedVariables() [Internal Extended API]
+  //
+  // Returns the names of the variables whose values may be changed by
+  // `Apply()`, without duplicates, in the order they are first changed.
+  std::vector<std::string> GetChangedVariables() const;
+
+  //    End of Internal Extended API
+  // ---------------------------------------------------------------------------
+};
+
+namespace moriarty_internal {
+
+// TestCaseMutationManager [Internal Extended API]
+//
+// Contains functions that are public with respect to `TestCaseMutation`, but
+// should be considered `private` with respect to users of Moriarty. See
+// corresponding functions in `TestCaseMutation` for documentation.
+class TestCaseMutationManager {
+ public:
+  // This class does not take ownership of `mutation_to_manage`
+  explicit TestCaseMutationManager(
+      const moriarty::TestCaseMutation* mutation_to_manage);
+
+  absl::Status Apply(ValueSet& values, RandomEngine& engine) const;
+  std::vector<std::string> GetChangedVariables() const;
+
+ private:
+  const moriarty::TestCaseMutation& managed_mutation_;  // Not owned
+};
+
+// GenerateIndependentValue()
+//
+// Generates a value described by `variable`, which must not depend on other
+// variables, with all randomness from `engine`. `debug_name` is used in error
+// messages.
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<typename T::value_type> GenerateIndependentValue(
+    T variable, RandomEngine& engine, absl::string_view debug_name);
+
+}  // namespace moriarty_internal
+
+// -----------------------------------------------------------------------------
+//  Template implementation below
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+TestCaseMutation& TestCaseMutation::SetValue(absl::string_view variable_name,
+                                             T::value_type value) {
+  changed_variables_.push_back(std::string(variable_name));
+  changes_.push_back([name = std::string(variable_name),
+                      value = std::move(value)](
+                         moriarty_internal::ValueSet& values,
+                         moriarty_internal::RandomEngine&) {
+    values.Set<T>(name, value);
+    return absl::OkStatus();
+  });
+  return *this;
+}
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+TestCaseMutation& TestCaseMutation::RegenerateValue(
+    absl::string_view variable_name, T constraints) {
+  changed_variables_.push_back(std::string(variable_name));
+  changes_.push_back([name = std::string(variable_name),
+                      constraints = std::move(constraints)](
+                         moriarty_internal::ValueSet& values,
+                         moriarty_internal::RandomEngine& engine)
+                         -> absl::Status {
+    MORIARTY_ASSIGN_OR_RETURN(
+        typename T::value_type value,
+        moriarty_internal::GenerateIndependentValue(constraints, engine, name));
+    values.Set<T>(name, std::move(value));
+    return absl::OkStatus();
+  });
+  return *this;
+}
+
+template <typename T, typename E>
+  requires std::derived_from<T,
+                             librarian::MVariable<T, typename T::value_type>> &&
+           std::derived_from<E,
+                             librarian::MVariable<E, typename E::value_type>> &&
+           std::same_as<typename T::value_type,
+                        std::vector<typename E::value_type>>
+TestCaseMutation& TestCaseMutation::ChangeElements(
+    absl::string_view variable_name, int64_t k, E element) {
+  changed_variables_.push_back(std::string(variable_name));
+  changes_.push_back([name = std::string(variable_name), k,
+                      element = std::move(element)](
+                         moriarty_internal::ValueSet& values,
+                         moriarty_internal::RandomEngine& engine) {
+    return values.Mutate<T>(
+        name, [&](typename T::value_type& array) -> absl::Status {
+          if (k < 0 || k > static_cast<int64_t>(array.size())) {
+            return absl::InvalidArgumentError(absl::Substitute(
+                "ChangeElements() cannot change $0 elements of `$1`, which "
+                "has $2 elements.",
+                k, name, array.size()));
+          }
+          MORIARTY_ASSIGN_OR_RETURN(
+              std::vector<int64_t> indices,
+              moriarty_internal::DistinctIntegers<int64_t>(engine, array.size(),
+                                                           k));
+          for (int64_t index : indices) {
+            MORIARTY_ASSIGN_OR_RETURN(
+                array[index], moriarty_internal::GenerateIndependentValue(
+                                  element, engine, name));
+          }
+          return absl::OkStatus();
+        });
+  });
+  return *this;
+}
+
+template <typename T>
+  requires std::derived_from<T,
+                             librarian::MVariable<T, typename T::value_type>> &&
+           std::same_as<typename T::value_type,
+                        std::vector<typename T::value_type::value_type>>
+TestCaseMutation& TestCaseMutation::Shuffle(absl::string_view variable_name) {
+  changed_variables_.push_back(std::string(variable_name));
+  changes_.push_back([name = std::string(variable_name)](
+                         moriarty_internal::ValueSet& values,
+                         moriarty_internal::RandomEngine& engine) {
+    return values.Mutate<T>(name, [&](typename T::value_type& array) {
+      return moriarty_internal::Shuffle(engine, array);
+    });
+  });
+  return *this;
+}
+
+namespace moriarty_internal {
+
+template <typename T>
+  requires std::derived_from<T, librarian::MVariable<T, typename T::value_type>>
+absl::StatusOr<typename T::value_type> GenerateIndependentValue(
+    T variable, RandomEngine& engine, absl::string_view debug_name) {
+  VariableSet variables;
+  ValueSet values;
+  GenerationConfig generation_config;
+
+  Universe universe = Universe()
+                          .SetRandomEngine(&engine)
+                          .SetMutableVariableSet(&variables)
+                          .SetMutableValueSet(&values)
+                          .SetGenerationConfig(&generation_config);
+
+  MVariableManager(&variable).SetUniverse(&universe, debug_name);
+  return MVariableManager(&variable).Generate();
+}
+
+}  // namespace moriarty_internal
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_TEST_CASE_MUTATION_H_
@@ -0,0 +1,158 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/test_case_mutation.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/generator.h"
+#include "src/internal/value_set.h"
+#include "src/test_case.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::Not;
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAreArray;
+
+// Generates X = 5 and A = [1, 2, ..., 20], then applies `mutation` to them.
+class MutationGenerator : public Generator {
+ public:
+  explicit MutationGenerator(TestCaseMutation mutation)
+      : mutation_(std::move(mutation)) {
+    moriarty_internal::GeneratorManager(this).SetSeed({1, 2, 3});
+    moriarty_internal::GeneratorManager(this).SetGeneralConstraints({});
+  }
+
+  void GenerateTestCases() override {
+    TestCase& base =
+        AddTestCase()
+            .ConstrainVariable("X", MInteger().Is(5))
+            .ConstrainVariable("A", MArray<MInteger>().Is(Range()));
+    AddDerivedTestCase(base, mutation_);
+  }
+
+  static std::vector<int64_t> Range() {
+    std::vector<int64_t> range;
+    for (int64_t i = 1; i <= 20; i++) range.push_back(i);
+    return range;
+  }
+
+ private:
+  TestCaseMutation mutation_;
+};
+
+// Returns the values of the derived test case of `MutationGenerator`.
+absl::StatusOr<moriarty_internal::ValueSet> Mutate(TestCaseMutation mutation) {
+  MutationGenerator generator(std::move(mutation));
+  generator.GenerateTestCases();
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<moriarty_internal::ValueSet> values,
+      moriarty_internal::GeneratorManager(&generator)
+          .AssignValuesInAllTestCases());
+  return values.back();
+}
+
+TEST(TestCaseMutationTest, EmptyMutationKeepsAllValues) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(moriarty_internal::ValueSet values,
+                                Mutate(TestCaseMutation()));
+  EXPECT_THAT(values.Get<MInteger>("X"), IsOkAndHolds(5));
+  EXPECT_THAT(values.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(MutationGenerator::Range()));
+}
+
+TEST(TestCaseMutationTest, SetValueReplacesTheValue) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      moriarty_internal::ValueSet values,
+      Mutate(TestCaseMutation()
+                 .SetValue<MInteger>("X", 10)
+                 .SetValue<MArray<MInteger>>("A", {3, 2, 1})));
+  EXPECT_THAT(values.Get<MInteger>("X"), IsOkAndHolds(10));
+  EXPECT_THAT(values.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(ElementsAre(3, 2, 1)));
+}
+
+TEST(TestCaseMutationTest, RegenerateValueUsesTheNewConstraints) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      moriarty_internal::ValueSet values,
+      Mutate(TestCaseMutation().RegenerateValue(
+          "A", MArray<MInteger>(MInteger().Between(100, 200)).OfLength(7))));
+  EXPECT_THAT(values.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(AllOf(SizeIs(7), Each(AllOf(Ge(100), Le(200))))));
+  EXPECT_THAT(values.Get<MInteger>("X"), IsOkAndHolds(5));
+}
+
+TEST(TestCaseMutationTest, ChangeElementsChangesExactlyKElements) {
+  for (int k : {0, 1, 7, 20}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        moriarty_internal::ValueSet values,
+        Mutate(TestCaseMutation().ChangeElements<MArray<MInteger>>(
+            "A", k, MInteger().Between(100, 200))));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> a,
+                                  values.Get<MArray<MInteger>>("A"));
+    ASSERT_THAT(a, SizeIs(20));
+    int num_changed = 0;
+    for (int i = 0; i < 20; i++) {
+      if (a[i] == i + 1) continue;
+      num_changed++;
+      EXPECT_THAT(a[i], AllOf(Ge(100), Le(200)));
+    }
+    EXPECT_EQ(num_changed, k);
+  }
+}
+
+TEST(TestCaseMutationTest, ChangeElementsWithTooManyElementsFails) {
+  EXPECT_THAT(Mutate(TestCaseMutation().ChangeElements<MArray<MInteger>>(
+                  "A", 21, MInteger())),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Mutate(TestCaseMutation().ChangeElements<MArray<MInteger>>(
+                  "A", -1, MInteger())),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TestCaseMutationTest, ShuffleKeepsTheSameElements) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      moriarty_internal::ValueSet values,
+      Mutate(TestCaseMutation().Shuffle<MArray<MInteger>>("A")));
+  EXPECT_THAT(values.Get<MArray<MInteger>>("A"),
+              IsOkAndHolds(AllOf(
+                  UnorderedElementsAreArray(MutationGenerator::Range()),
+                  Not(Eq(MutationGenerator::Range())))));
+}
+
+TEST(TestCaseMutationTest, MutatingAMissingVariableFails) {
+  EXPECT_FALSE(
+      Mutate(TestCaseMutation().Shuffle<MArray<MInteger>>("missing")).ok());
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -14,6 +14,7 @@
 
 #include "src/test_case.h"
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -46,7 +47,10 @@ using ::moriarty_testing::IsVariableNotFound;
 using ::moriarty_testing::MTestType;
 using ::moriarty_testing::MTestType2;
 using ::moriarty_testing::TestType;
+using ::testing::AllOf;
+using ::testing::Ge;
 using ::testing::HasSubstr;
+using ::testing::Le;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 
@@ -110,6 +114,89 @@ TEST(TestCaseTest, SetVariablesOverwritesAllVariablesPreviouslyThere) {
   MORIARTY_EXPECT_OK(TestCaseManager(&T).GetVariable<MTestType>("B"));
 }
 
+TEST(TestCaseTest, ConstrainVariableDoesNotChangeSharedGeneralVariables) {
+  VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("A", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("B", MInteger().Between(1, 10)));
+  auto general = std::make_shared<const VariableSet>(std::move(variable_set));
+
+  TestCase T1;
+  TestCase T2;
+  TestCaseManager(&T1).SetGeneralVariables(general);
+  TestCaseManager(&T2).SetGeneralVariables(general);
+  T1.ConstrainVariable("A", MInteger().Between(5, 6));
+  T1.ConstrainVariable("C", MInteger().Between(7, 7));
+
+  EXPECT_EQ(&TestCaseManager(&T1).GetGeneralVariables(), general.get());
+  EXPECT_EQ(TestCaseManager(&T1).GetOverriddenVariables().NumVariables(), 2);
+  EXPECT_EQ(TestCaseManager(&T2).GetOverriddenVariables().NumVariables(), 0);
+
+  RandomEngine rng({1, 2, 3}, "v0.1");
+  for (int i = 0; i < 10; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        ValueSet values1,
+        TestCaseManager(&T1).AssignAllValues(rng, std::nullopt));
+    EXPECT_THAT(values1.Get<MInteger>("A"), IsOkAndHolds(AllOf(Ge(5), Le(6))));
+    EXPECT_THAT(values1.Get<MInteger>("B"), IsOkAndHolds(AllOf(Ge(1), Le(10))));
+    EXPECT_THAT(values1.Get<MInteger>("C"), IsOkAndHolds(7));
+
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        ValueSet values2,
+        TestCaseManager(&T2).AssignAllValues(rng, std::nullopt));
+    EXPECT_THAT(values2.Get<MInteger>("A"), IsOkAndHolds(AllOf(Ge(1), Le(10))));
+    EXPECT_FALSE(values2.Contains("C"));
+  }
+}
+
+TEST(TestCaseTest, ConstrainVariableMergesWithTheGeneralVariable) {
+  VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("A", MInteger().Between(1, 10)));
+  TestCase T;
+  TestCaseManager(&T).SetVariables(variable_set);
+
+  T.ConstrainVariable("A", MInteger().AtLeast(10));
+
+  RandomEngine rng({1, 2, 3}, "v0.1");
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      ValueSet values, TestCaseManager(&T).AssignAllValues(rng, std::nullopt));
+  EXPECT_THAT(values.Get<MInteger>("A"), IsOkAndHolds(10));
+}
+
+TEST(TestCaseTest, SetOverriddenVariableMatchesConstrainVariable) {
+  VariableSet variable_set;
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("A", MInteger().Between(1, 10)));
+  MORIARTY_ASSERT_OK(variable_set.AddVariable("B", MInteger().Between(1, 10)));
+  auto general = std::make_shared<const VariableSet>(std::move(variable_set));
+
+  TestCase T1;
+  TestCaseManager(&T1).SetGeneralVariables(general);
+  T1.ConstrainVariable("A", MInteger().AtLeast(7));
+
+  // T2 copies the merged variable of T1 instead of merging again.
+  TestCase T2;
+  TestCaseManager(&T2).SetGeneralVariables(general);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      const moriarty_internal::AbstractVariable* merged,
+      TestCaseManager(&T1).GetOverriddenVariables().GetAbstractVariable("A"));
+  TestCaseManager(&T2).SetOverriddenVariable("A", *merged);
+
+  EXPECT_EQ(TestCaseManager(&T2).ConstraintsToString(),
+            TestCaseManager(&T1).ConstraintsToString());
+  RandomEngine rng1({1, 2, 3}, "v0.1");
+  RandomEngine rng2({1, 2, 3}, "v0.1");
+  for (int i = 0; i < 10; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        ValueSet values1,
+        TestCaseManager(&T1).AssignAllValues(rng1, std::nullopt));
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        ValueSet values2,
+        TestCaseManager(&T2).AssignAllValues(rng2, std::nullopt));
+    EXPECT_THAT(values2.Get<MInteger>("A"), IsOkAndHolds(AllOf(Ge(7), Le(10))));
+    EXPECT_EQ(values2.Get<MInteger>("A"), values1.Get<MInteger>("A"));
+    EXPECT_EQ(values2.Get<MInteger>("B"), values1.Get<MInteger>("B"));
+  }
+}
+
 TEST(TestCaseTest, AssignAllValuesGivesSomeValueForEachVariable) {
   TestCase T;
   T.ConstrainVariable("A", MTestType());
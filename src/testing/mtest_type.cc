@@ -151,8 +151,10 @@ std::vector<std::string> MTestType::GetDependenciesImpl() const {
   return GetDependencies(multiplier_);
 }
 
-absl::StatusOr<moriarty::librarian::Subvalues> MTestType::GetSubvaluesImpl(
-    const TestType& value) const {
+absl::StatusOr<moriarty::librarian::Subvalues> MTestType::GetSubvalueImpl(
+    const TestType& value, absl::string_view subvalue_name) const {
+  if (subvalue_name != "multiplier") return Subvalues();
+
   TestType addition = 0;
   if (adder_variable_name_) {
     MORIARTY_ASSIGN_OR_RETURN(addition,
@@ -119,8 +119,10 @@ class MTestType : public moriarty::librarian::MVariable<MTestType, TestType> {
 
   bool merged_ = false;
 
-  absl::StatusOr<moriarty::librarian::Subvalues> GetSubvaluesImpl(
-      const TestType& value) const override;
+  // Only computes the requested subvalue (unlike `MTestType2`, which computes
+  // all of them).
+  absl::StatusOr<moriarty::librarian::Subvalues> GetSubvalueImpl(
+      const TestType& value, absl::string_view subvalue_name) const override;
 
   // Always returns pi. Does not directly depend on `rng`, but we generate a
   // random number between 1 and 1 (aka, 1) to ensure the RandomEngine is
@@ -0,0 +1,264 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the statistical quality of `RandomEngine` and the samplers built on
+// it with many more samples than unit tests can afford. Each sampler is run
+// over many independent streams in parallel, and its samples are checked with
+// chi-square, Kolmogorov-Smirnov and serial correlation tests.
+//
+// This takes a long time with the default 10^9 samples per sampler, so it is a
+// separate binary rather than a test:
+//
+//   bazel run -c opt //src/testing:random_quality -- --threads=16
+//
+// Flags:
+//   --samples=N   The number of samples per sampler (default: 10^9).
+//   --seed=S      The seed of the first stream (default: 1).
+//   --threads=T   The number of threads (default: all cores).
+//   --alpha=A     p-values below this fail (default: 10^-6).
+//
+// Exits with 1 if any p-value is below `alpha`.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "src/internal/random_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/simple_pattern.h"
+#include "src/testing/statistical_tests.h"
+#include "src/util/status_macro/status_macros.h"
+
+namespace moriarty_testing {
+namespace {
+
+using ::moriarty::moriarty_internal::RandomEngine;
+
+// Each stream draws this many samples.
+constexpr int64_t kChunkSize = 1 << 20;
+
+struct Options {
+  int64_t num_samples = 1'000'000'000;
+  int64_t seed = 1;
+  int num_threads = 1;
+  double alpha = 1e-6;
+};
+
+absl::StatusOr<Options> ParseArgs(int argc, char* argv[]) {
+  Options options;
+  options.num_threads =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for (int i = 1; i < argc; i++) {
+    absl::string_view arg = argv[i];
+    bool ok = true;
+    if (absl::ConsumePrefix(&arg, "--samples=")) {
+      ok = absl::SimpleAtoi(arg, &options.num_samples) &&
+           options.num_samples > 0;
+    } else if (absl::ConsumePrefix(&arg, "--seed=")) {
+      ok = absl::SimpleAtoi(arg, &options.seed);
+    } else if (absl::ConsumePrefix(&arg, "--threads=")) {
+      ok = absl::SimpleAtoi(arg, &options.num_threads) &&
+           options.num_threads > 0;
+    } else if (absl::ConsumePrefix(&arg, "--alpha=")) {
+      ok = absl::SimpleAtod(arg, &options.alpha) && options.alpha > 0;
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("unknown flag: '%s'", argv[i]));
+    }
+    if (!ok) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("invalid flag: '%s'", argv[i]));
+    }
+  }
+  return options;
+}
+
+// A sampler under test. `sample` adds `n` samples to `statistics`.
+struct Subject {
+  std::string name;
+  int num_outcomes;
+  std::function<absl::Status(RandomEngine& engine, int64_t n,
+                             SampleStatistics& statistics)>
+      sample;
+};
+
+std::vector<Subject> Subjects() {
+  std::vector<Subject> subjects;
+
+  subjects.push_back(
+      {"RandomEngine::RandInt(1000)", 1000,
+       [](RandomEngine& engine, int64_t n,
+          SampleStatistics& statistics) -> absl::Status {
+         absl::Status status;
+         for (int64_t i = 0; i < n; i++)
+           statistics.AddOutcome(engine.RandInt(1000, status));
+         return status;
+       }});
+
+  subjects.push_back(
+      {"RandomEngine::RandDouble()", 0,
+       [](RandomEngine& engine, int64_t n,
+          SampleStatistics& statistics) -> absl::Status {
+         for (int64_t i = 0; i < n; i++)
+           statistics.AddUniform(engine.RandDouble());
+         return absl::OkStatus();
+       }});
+
+  // Each value should be in a sample of k distinct values equally often.
+  subjects.push_back(
+      {"DistinctIntegers(100, 10)", 100,
+       [](RandomEngine& engine, int64_t n,
+          SampleStatistics& statistics) -> absl::Status {
+         for (int64_t i = 0; i < n; i++) {
+           MORIARTY_ASSIGN_OR_RETURN(
+               std::vector<int> values,
+               moriarty::moriarty_internal::DistinctIntegers(engine, 100, 10));
+           for (int value : values) statistics.AddOutcome(value);
+         }
+         return absl::OkStatus();
+       }});
+
+  // Each of the 5! permutations should be equally likely.
+  subjects.push_back(
+      {"Shuffle(5 elements)", 120,
+       [](RandomEngine& engine, int64_t n,
+          SampleStatistics& statistics) -> absl::Status {
+         std::vector<int> values(5);
+         for (int64_t i = 0; i < n; i++) {
+           for (int j = 0; j < 5; j++) values[j] = j;
+           MORIARTY_RETURN_IF_ERROR(
+               moriarty::moriarty_internal::Shuffle(engine, values));
+           // The index of the permutation (its Lehmer code).
+           int index = 0;
+           for (int j = 0; j < 5; j++) {
+             int smaller_after = 0;
+             for (int k = j + 1; k < 5; k++)
+               smaller_after += values[k] < values[j];
+             index = index * (5 - j) + smaller_after;
+           }
+           statistics.AddOutcome(index);
+         }
+         return absl::OkStatus();
+       }});
+
+  // Each of the C(9, 2) = 36 compositions of 10 into 3 positive parts should
+  // be equally likely.
+  subjects.push_back(
+      {"RandomComposition(10, 3)", 36,
+       [](RandomEngine& engine, int64_t n,
+          SampleStatistics& statistics) -> absl::Status {
+         // `index[a][b]` numbers the compositions (a, b, 10 - a - b).
+         std::array<std::array<int, 10>, 10> index = {};
+         int num_compositions = 0;
+         for (int a = 1; a <= 8; a++) {
+           for (int b = 1; a + b <= 9; b++) index[a][b] = num_compositions++;
+         }
+         for (int64_t i = 0; i < n; i++) {
+           MORIARTY_ASSIGN_OR_RETURN(
+               std::vector<int> parts,
+               moriarty::moriarty_internal::RandomComposition(engine, 10, 3));
+           statistics.AddOutcome(index[parts[0]][parts[1]]);
+         }
+         return absl::OkStatus();
+       }});
+
+  // Each character at each position should be equally likely.
+  subjects.push_back(
+      {"SimplePattern(\"[a-z]{4}\").Generate()", 4 * 26,
+       [](RandomEngine& engine, int64_t n,
+          SampleStatistics& statistics) -> absl::Status {
+         MORIARTY_ASSIGN_OR_RETURN(
+             moriarty::moriarty_internal::SimplePattern pattern,
+             moriarty::moriarty_internal::SimplePattern::Create("[a-z]{4}"));
+         for (int64_t i = 0; i < n; i++) {
+           MORIARTY_ASSIGN_OR_RETURN(std::string value,
+                                     pattern.Generate(engine));
+           if (value.size() != 4) {
+             return absl::InternalError(
+                 absl::StrFormat("generated '%s', which has the wrong length",
+                                 value));
+           }
+           for (int j = 0; j < 4; j++)
+             statistics.AddOutcome(j * 26 + (value[j] - 'a'));
+         }
+         return absl::OkStatus();
+       }});
+
+  return subjects;
+}
+
+// Formats `p_value`, marking it if it is below `alpha`.
+std::string FormatPValue(double p_value, double alpha) {
+  return absl::StrFormat("%.3g%s", p_value, p_value < alpha ? " FAIL" : "");
+}
+
+int Run(int argc, char* argv[]) {
+  absl::StatusOr<Options> options = ParseArgs(argc, argv);
+  if (!options.ok()) {
+    std::cerr << options.status() << '\n';
+    return 2;
+  }
+
+  bool all_passed = true;
+  for (const Subject& subject : Subjects()) {
+    absl::Time start = absl::Now();
+    absl::StatusOr<SampleStatistics> statistics = CollectStatistics(
+        options->seed, options->num_samples, kChunkSize, subject.num_outcomes,
+        options->num_threads, subject.sample);
+    if (!statistics.ok()) {
+      std::cout << subject.name << ": " << statistics.status() << '\n';
+      all_passed = false;
+      continue;
+    }
+
+    std::cout << absl::StrFormat("%s (%d samples in %s)\n", subject.name,
+                                 options->num_samples,
+                                 absl::FormatDuration(absl::Now() - start));
+    if (statistics->NumOutcomeSamples() > 0) {
+      double p_value = statistics->ChiSquarePValue();
+      all_passed &= p_value >= options->alpha;
+      std::cout << "  chi-square:         "
+                << FormatPValue(p_value, options->alpha) << '\n';
+    }
+    if (statistics->NumUniformSamples() > 0) {
+      double ks_p_value = statistics->KolmogorovSmirnovPValue();
+      double serial_p_value = statistics->SerialCorrelationPValue();
+      all_passed &= ks_p_value >= options->alpha;
+      all_passed &= serial_p_value >= options->alpha;
+      std::cout << "  Kolmogorov-Smirnov: "
+                << FormatPValue(ks_p_value, options->alpha) << '\n'
+                << "  serial correlation: "
+                << FormatPValue(serial_p_value, options->alpha) << '\n';
+    }
+  }
+  return all_passed ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace moriarty_testing
+
+int main(int argc, char* argv[]) { return moriarty_testing::Run(argc, argv); }
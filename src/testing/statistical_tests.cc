@@ -0,0 +1,239 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/testing/statistical_tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+
+namespace moriarty_testing {
+
+namespace {
+
+using ::moriarty::moriarty_internal::kCounterBasedVersion;
+using ::moriarty::moriarty_internal::RandomEngine;
+using ::moriarty::moriarty_internal::WorkStealingScheduler;
+
+// The most tasks `CollectStatistics()` splits the chunks into. Each task keeps
+// its own `SampleStatistics`.
+constexpr int kMaxTasks = 64;
+
+// The regularized upper incomplete gamma function Q(a, x), computed with its
+// series for small `x` and its continued fraction otherwise.
+double UpperIncompleteGamma(double a, double x) {
+  constexpr int kMaxIterations = 10000;
+  constexpr double kEpsilon = 1e-15;
+  constexpr double kTiny = 1e-300;
+  if (x <= 0) return 1;
+  double log_prefix = a * std::log(x) - x - std::lgamma(a);
+
+  if (x < a + 1) {
+    // P(a, x) = e^-x x^a / Gamma(a + 1) * sum_n x^n / ((a + 1)...(a + n)).
+    double term = 1 / a;
+    double sum = term;
+    for (int n = 1; n < kMaxIterations; n++) {
+      term *= x / (a + n);
+      sum += term;
+      if (std::abs(term) < std::abs(sum) * kEpsilon) break;
+    }
+    return std::max(0.0, 1 - sum * std::exp(log_prefix));
+  }
+
+  // Lentz's method for the continued fraction of Q(a, x).
+  double b = x + 1 - a;
+  double c = 1 / kTiny;
+  double d = 1 / b;
+  double h = d;
+  for (int n = 1; n < kMaxIterations; n++) {
+    double an = -n * (n - a);
+    b += 2;
+    d = an * d + b;
+    if (std::abs(d) < kTiny) d = kTiny;
+    c = b + an / c;
+    if (std::abs(c) < kTiny) c = kTiny;
+    d = 1 / d;
+    double delta = d * c;
+    h *= delta;
+    if (std::abs(delta - 1) < kEpsilon) break;
+  }
+  return std::exp(log_prefix) * h;
+}
+
+// The probability that a standard normal variable is at least `|z|` away from
+// 0.
+double TwoSidedNormalPValue(double z) {
+  return std::erfc(std::abs(z) / std::sqrt(2.0));
+}
+
+}  // namespace
+
+double ChiSquarePValue(absl::Span<const int64_t> counts) {
+  ABSL_CHECK_GE(counts.size(), 2);
+  int64_t total = 0;
+  for (int64_t count : counts) total += count;
+  if (total == 0) return 1;
+
+  double expected = static_cast<double>(total) / counts.size();
+  double statistic = 0;
+  for (int64_t count : counts) {
+    double difference = count - expected;
+    statistic += difference * difference / expected;
+  }
+  double degrees_of_freedom = counts.size() - 1;
+  return UpperIncompleteGamma(degrees_of_freedom / 2, statistic / 2);
+}
+
+double KolmogorovSmirnovPValue(double max_difference, int64_t n) {
+  if (n <= 0) return 1;
+  // Stephens' correction makes the asymptotic distribution accurate for
+  // small `n` as well.
+  double sqrt_n = std::sqrt(static_cast<double>(n));
+  double lambda = (sqrt_n + 0.12 + 0.11 / sqrt_n) * max_difference;
+  if (lambda < 0.2) return 1;
+
+  // Q(lambda) = 2 * sum_{k >= 1} (-1)^(k - 1) e^(-2 k^2 lambda^2).
+  double sum = 0;
+  for (int k = 1; k <= 100; k++) {
+    double term = std::exp(-2.0 * k * k * lambda * lambda);
+    sum += (k % 2 == 1 ? term : -term);
+    if (term < 1e-16) break;
+  }
+  return std::clamp(2 * sum, 0.0, 1.0);
+}
+
+SampleStatistics::SampleStatistics(int num_outcomes)
+    : outcome_counts_(num_outcomes), uniform_bins_(kNumUniformBins) {}
+
+void SampleStatistics::AddOutcome(int64_t outcome) {
+  ABSL_CHECK(0 <= outcome && outcome < outcome_counts_.size())
+      << "outcome " << outcome << " of " << outcome_counts_.size();
+  outcome_counts_[outcome]++;
+}
+
+void SampleStatistics::AddUniform(double value) {
+  ABSL_CHECK(0 <= value && value < 1) << "not in [0, 1): " << value;
+  uniform_bins_[static_cast<int64_t>(value * kNumUniformBins)]++;
+  if (num_uniforms_ > 0) {
+    num_pairs_++;
+    sum_x_ += previous_;
+    sum_y_ += value;
+    sum_xx_ += previous_ * previous_;
+    sum_yy_ += value * value;
+    sum_xy_ += previous_ * value;
+  }
+  previous_ = value;
+  num_uniforms_++;
+}
+
+void SampleStatistics::Merge(const SampleStatistics& other) {
+  ABSL_CHECK_EQ(outcome_counts_.size(), other.outcome_counts_.size());
+  for (int i = 0; i < outcome_counts_.size(); i++)
+    outcome_counts_[i] += other.outcome_counts_[i];
+  for (int i = 0; i < kNumUniformBins; i++)
+    uniform_bins_[i] += other.uniform_bins_[i];
+  num_uniforms_ += other.num_uniforms_;
+  num_pairs_ += other.num_pairs_;
+  sum_x_ += other.sum_x_;
+  sum_y_ += other.sum_y_;
+  sum_xx_ += other.sum_xx_;
+  sum_yy_ += other.sum_yy_;
+  sum_xy_ += other.sum_xy_;
+}
+
+int64_t SampleStatistics::NumOutcomeSamples() const {
+  int64_t total = 0;
+  for (int64_t count : outcome_counts_) total += count;
+  return total;
+}
+
+int64_t SampleStatistics::NumUniformSamples() const { return num_uniforms_; }
+
+double SampleStatistics::ChiSquarePValue() const {
+  return moriarty_testing::ChiSquarePValue(outcome_counts_);
+}
+
+double SampleStatistics::KolmogorovSmirnovPValue() const {
+  if (num_uniforms_ == 0) return 1;
+  // The empirical distribution function is only known at the bin edges.
+  double max_difference = 0;
+  int64_t seen = 0;
+  for (int i = 0; i < kNumUniformBins; i++) {
+    seen += uniform_bins_[i];
+    double empirical = static_cast<double>(seen) / num_uniforms_;
+    double expected = static_cast<double>(i + 1) / kNumUniformBins;
+    max_difference = std::max(max_difference, std::abs(empirical - expected));
+  }
+  return moriarty_testing::KolmogorovSmirnovPValue(max_difference,
+                                                   num_uniforms_);
+}
+
+double SampleStatistics::SerialCorrelationPValue() const {
+  if (num_pairs_ < 2) return 1;
+  double n = num_pairs_;
+  double covariance = sum_xy_ / n - (sum_x_ / n) * (sum_y_ / n);
+  double variance_x = sum_xx_ / n - (sum_x_ / n) * (sum_x_ / n);
+  double variance_y = sum_yy_ / n - (sum_y_ / n) * (sum_y_ / n);
+  if (variance_x <= 0 || variance_y <= 0) return 0;
+  double correlation = covariance / std::sqrt(variance_x * variance_y);
+  return TwoSidedNormalPValue(correlation * std::sqrt(n));
+}
+
+absl::StatusOr<SampleStatistics> CollectStatistics(
+    int64_t seed, int64_t num_samples, int64_t chunk_size, int num_outcomes,
+    int num_threads,
+    absl::FunctionRef<absl::Status(RandomEngine&, int64_t, SampleStatistics&)>
+        sample) {
+  if (num_samples < 0 || chunk_size <= 0) {
+    return absl::InvalidArgumentError(
+        "num_samples must be non-negative and chunk_size positive");
+  }
+  int64_t num_chunks = (num_samples + chunk_size - 1) / chunk_size;
+  int num_tasks = std::min<int64_t>(num_chunks, kMaxTasks);
+
+  // Task `t` handles a fixed range of chunks, so the result does not depend on
+  // which thread runs which task.
+  std::vector<SampleStatistics> statistics(num_tasks,
+                                           SampleStatistics(num_outcomes));
+  std::vector<absl::Status> statuses(num_tasks);
+  WorkStealingScheduler scheduler(std::max(num_threads, 1));
+  scheduler.ParallelFor(num_tasks, [&](int task) {
+    int64_t begin = num_chunks * task / num_tasks;
+    int64_t end = num_chunks * (task + 1) / num_tasks;
+    for (int64_t chunk = begin; chunk < end && statuses[task].ok(); chunk++) {
+      RandomEngine engine({seed, chunk}, kCounterBasedVersion);
+      int64_t n = std::min(chunk_size, num_samples - chunk * chunk_size);
+      statuses[task] = sample(engine, n, statistics[task]);
+    }
+  });
+
+  SampleStatistics result(num_outcomes);
+  for (int task = 0; task < num_tasks; task++) {
+    if (!statuses[task].ok()) return statuses[task];
+    result.Merge(statistics[task]);
+  }
+  return result;
+}
+
+}  // namespace moriarty_testing
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_TESTING_STATISTICAL_TESTS_H_
+#define MORIARTY_SRC_TESTING_STATISTICAL_TESTS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "src/internal/random_engine.h"
+
+namespace moriarty_testing {
+
+// Statistical tests for the quality of random samples, for checking
+// `RandomEngine` and the samplers built on it with far more samples than a
+// unit test can afford (e.g., 10^9).
+//
+// Each function returns a p-value: the probability that truly random samples
+// would look at least this far from the expected distribution. A correct
+// sampler gives p-values that are uniformly distributed in [0, 1], so only
+// tiny p-values (e.g., below 10^-6) indicate a problem.
+
+// ChiSquarePValue()
+//
+// Pearson's chi-square test that each outcome is equally likely, where
+// `counts[i]` is the number of times outcome `i` was seen. There must be at
+// least 2 outcomes.
+double ChiSquarePValue(absl::Span<const int64_t> counts);
+
+// KolmogorovSmirnovPValue()
+//
+// The (asymptotic) probability that the Kolmogorov-Smirnov statistic of `n`
+// uniform samples is at least `max_difference`, the largest difference
+// between their empirical distribution function and the expected one.
+double KolmogorovSmirnovPValue(double max_difference, int64_t n);
+
+// SampleStatistics
+//
+// Summarizes a stream of samples with a fixed amount of memory, for the tests
+// above. Summaries of different chunks of samples can be merged, so chunks may
+// be summarized in parallel.
+class SampleStatistics {
+ public:
+  // Uniform samples are bucketed into this many bins for the Kolmogorov-Smirnov
+  // test, so its statistic is measured at a resolution of 2^-16.
+  static constexpr int kNumUniformBins = 1 << 16;
+
+  // Outcomes (see `AddOutcome()`) are in [0, `num_outcomes`).
+  explicit SampleStatistics(int num_outcomes = 0);
+
+  // AddOutcome()
+  //
+  // Adds a sample of a discrete distribution in which each outcome in
+  // [0, num_outcomes) should be equally likely.
+  void AddOutcome(int64_t outcome);
+
+  // AddUniform()
+  //
+  // Adds a sample that should be uniform in [0, 1). Consecutive calls are
+  // checked for serial correlation.
+  void AddUniform(double value);
+
+  // Merge()
+  //
+  // Adds the samples of `other`, which must have the same number of outcomes.
+  // Serial correlation is only measured within each summary, never between the
+  // last sample of this one and the first of `other`.
+  void Merge(const SampleStatistics& other);
+
+  [[nodiscard]] int64_t NumOutcomeSamples() const;
+  [[nodiscard]] int64_t NumUniformSamples() const;
+
+  // ChiSquarePValue()
+  //
+  // The chi-square test on the outcomes.
+  [[nodiscard]] double ChiSquarePValue() const;
+
+  // KolmogorovSmirnovPValue()
+  //
+  // The Kolmogorov-Smirnov test on the uniform samples.
+  [[nodiscard]] double KolmogorovSmirnovPValue() const;
+
+  // SerialCorrelationPValue()
+  //
+  // Tests that consecutive uniform samples are uncorrelated (the lag-1
+  // correlation is approximately normal with variance 1/n).
+  [[nodiscard]] double SerialCorrelationPValue() const;
+
+ private:
+  std::vector<int64_t> outcome_counts_;
+  std::vector<int64_t> uniform_bins_;
+  int64_t num_uniforms_ = 0;
+
+  // Sums over the pairs of consecutive uniform samples (x, y).
+  double previous_ = 0;
+  int64_t num_pairs_ = 0;
+  double sum_x_ = 0, sum_y_ = 0;
+  double sum_xx_ = 0, sum_yy_ = 0, sum_xy_ = 0;
+};
+
+// CollectStatistics()
+//
+// Summarizes `num_samples` samples, drawn in parallel on `num_threads`
+// threads. The samples are split into chunks of at most `chunk_size`, and
+// `sample(engine, n, statistics)` adds `n` samples of one chunk to
+// `statistics`, using `engine`.
+//
+// Chunk `i` uses its own engine, seeded with {`seed`, `i`}, so the chunks are
+// independent streams. The result only depends on the seed, `num_samples` and
+// `chunk_size`, not on the number of threads.
+absl::StatusOr<SampleStatistics> CollectStatistics(
+    int64_t seed, int64_t num_samples, int64_t chunk_size, int num_outcomes,
+    int num_threads,
+    absl::FunctionRef<absl::Status(moriarty::moriarty_internal::RandomEngine&,
+                                   int64_t, SampleStatistics&)>
+        sample);
+
+}  // namespace moriarty_testing
+
+#endif  // MORIARTY_SRC_TESTING_STATISTICAL_TESTS_H_
@@ -0,0 +1,158 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/testing/statistical_tests.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/internal/random_engine.h"
+#include "src/util/test_status_macro/status_testutil.h"
+
+namespace moriarty_testing {
+namespace {
+
+using ::moriarty::IsOk;
+using ::moriarty::StatusIs;
+using ::moriarty::moriarty_internal::kCounterBasedVersion;
+using ::moriarty::moriarty_internal::RandomEngine;
+using ::testing::DoubleNear;
+using ::testing::Gt;
+using ::testing::Lt;
+
+TEST(StatisticalTestsTest, ChiSquarePValueMatchesKnownValues) {
+  EXPECT_THAT(ChiSquarePValue({100, 100, 100, 100}), DoubleNear(1, 1e-12));
+  // 1 degree of freedom, statistic 4: 2 * (1 - Phi(2)).
+  EXPECT_THAT(ChiSquarePValue({220, 180}), DoubleNear(0.0455003, 1e-6));
+  // 2 degrees of freedom, statistic x: e^(-x / 2).
+  EXPECT_THAT(ChiSquarePValue({110, 90, 100}),
+              DoubleNear(std::exp(-1.0), 1e-9));
+  EXPECT_THAT(ChiSquarePValue({75, 25, 50}),
+              DoubleNear(std::exp(-12.5), 1e-12));
+  // 4 degrees of freedom, statistic x: e^(-x / 2) * (1 + x / 2).
+  EXPECT_THAT(ChiSquarePValue({110, 90, 100, 100, 100}),
+              DoubleNear(2 * std::exp(-1.0), 1e-9));
+  EXPECT_THAT(ChiSquarePValue({1000, 0, 0}), Lt(1e-100));
+}
+
+TEST(StatisticalTestsTest, KolmogorovSmirnovPValueMatchesKnownValues) {
+  constexpr int64_t kN = 100'000'000;
+  EXPECT_THAT(KolmogorovSmirnovPValue(1.358 / std::sqrt(kN), kN),
+              DoubleNear(0.05, 1e-3));
+  EXPECT_THAT(KolmogorovSmirnovPValue(1.0 / std::sqrt(kN), kN),
+              DoubleNear(0.2700, 1e-3));
+  EXPECT_THAT(KolmogorovSmirnovPValue(0, 100), DoubleNear(1, 1e-12));
+  EXPECT_THAT(KolmogorovSmirnovPValue(0.5, 1000), Lt(1e-100));
+}
+
+TEST(StatisticalTestsTest, RandomSamplesShouldPassEveryTest) {
+  RandomEngine engine({1, 2, 3}, kCounterBasedVersion);
+  SampleStatistics statistics(10);
+  absl::Status status;
+  for (int i = 0; i < 100'000; i++) {
+    statistics.AddOutcome(engine.RandInt(10, status));
+    statistics.AddUniform(engine.RandDouble());
+  }
+  ASSERT_THAT(status, IsOk());
+  EXPECT_THAT(statistics.ChiSquarePValue(), Gt(1e-6));
+  EXPECT_THAT(statistics.KolmogorovSmirnovPValue(), Gt(1e-6));
+  EXPECT_THAT(statistics.SerialCorrelationPValue(), Gt(1e-6));
+}
+
+TEST(StatisticalTestsTest, BiasedSamplesShouldFail) {
+  RandomEngine engine({1, 2, 3}, kCounterBasedVersion);
+  SampleStatistics statistics(10);
+  absl::Status status;
+  for (int i = 0; i < 100'000; i++) {
+    // Outcome 0 is twice as likely as the others.
+    statistics.AddOutcome(engine.RandInt(11, status) % 10);
+    double value = engine.RandDouble();
+    statistics.AddUniform(value * value);
+  }
+  ASSERT_THAT(status, IsOk());
+  EXPECT_THAT(statistics.ChiSquarePValue(), Lt(1e-6));
+  EXPECT_THAT(statistics.KolmogorovSmirnovPValue(), Lt(1e-6));
+}
+
+TEST(StatisticalTestsTest, CorrelatedSamplesShouldFailSerialCorrelation) {
+  // Evenly spread, but each sample is close to the previous one.
+  SampleStatistics statistics;
+  for (int i = 0; i < 100'000; i++) statistics.AddUniform(i / 100'000.0);
+  EXPECT_THAT(statistics.KolmogorovSmirnovPValue(), Gt(0.5));
+  EXPECT_THAT(statistics.SerialCorrelationPValue(), Lt(1e-6));
+}
+
+TEST(StatisticalTestsTest, MergeShouldCombineTheSamples) {
+  SampleStatistics first(3);
+  SampleStatistics second(3);
+  first.AddOutcome(0);
+  first.AddUniform(0.25);
+  second.AddOutcome(2);
+  second.AddOutcome(2);
+  second.AddUniform(0.75);
+  first.Merge(second);
+  EXPECT_EQ(first.NumOutcomeSamples(), 3);
+  EXPECT_EQ(first.NumUniformSamples(), 2);
+}
+
+TEST(StatisticalTestsTest, CollectStatisticsShouldNotDependOnTheThreads) {
+  auto sample = [](RandomEngine& engine, int64_t n,
+                   SampleStatistics& statistics) {
+    absl::Status status;
+    for (int64_t i = 0; i < n; i++) {
+      statistics.AddOutcome(engine.RandInt(6, status));
+      statistics.AddUniform(engine.RandDouble());
+    }
+    return status;
+  };
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SampleStatistics one_thread,
+      CollectStatistics(/* seed = */ 7, /* num_samples = */ 100'000,
+                        /* chunk_size = */ 1000, /* num_outcomes = */ 6,
+                        /* num_threads = */ 1, sample));
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      SampleStatistics four_threads,
+      CollectStatistics(7, 100'000, 1000, 6, 4, sample));
+
+  EXPECT_EQ(one_thread.NumOutcomeSamples(), 100'000);
+  EXPECT_EQ(one_thread.NumUniformSamples(), 100'000);
+  EXPECT_EQ(one_thread.ChiSquarePValue(), four_threads.ChiSquarePValue());
+  EXPECT_EQ(one_thread.KolmogorovSmirnovPValue(),
+            four_threads.KolmogorovSmirnovPValue());
+  EXPECT_EQ(one_thread.SerialCorrelationPValue(),
+            four_threads.SerialCorrelationPValue());
+  EXPECT_THAT(one_thread.ChiSquarePValue(), Gt(1e-6));
+}
+
+TEST(StatisticalTestsTest, CollectStatisticsShouldReturnSamplerErrors) {
+  EXPECT_THAT(CollectStatistics(
+                  7, 100, 10, 0, 2,
+                  [](RandomEngine&, int64_t, SampleStatistics&) {
+                    return absl::InternalError("oops");
+                  }),
+              StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(CollectStatistics(
+                  7, 100, 0, 0, 2,
+                  [](RandomEngine&, int64_t, SampleStatistics&) {
+                    return absl::OkStatus();
+                  }),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace moriarty_testing
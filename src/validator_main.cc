@@ -0,0 +1,154 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/validator_main.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+
+namespace moriarty {
+
+namespace {
+
+constexpr int kValid = 0;
+constexpr int kInvalid = 1;
+constexpr int kUsageError = 2;
+
+ValidatorDefinition& RegisteredDefinition() {
+  static ValidatorDefinition definition = nullptr;
+  return definition;
+}
+
+struct ValidatorOptions {
+  int num_threads = 1;
+  bool quiet = false;
+  std::vector<std::string> paths;
+};
+
+absl::StatusOr<ValidatorOptions> ParseArgs(int argc, char* argv[]) {
+  ValidatorOptions options;
+  options.num_threads =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for (int i = 1; i < argc; i++) {
+    absl::string_view arg = argv[i];
+    if (arg == "--quiet") {
+      options.quiet = true;
+    } else if (absl::ConsumePrefix(&arg, "--threads=")) {
+      if (!absl::SimpleAtoi(arg, &options.num_threads) ||
+          options.num_threads < 1) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("invalid --threads: '%s'", arg));
+      }
+    } else if (absl::StartsWith(arg, "--")) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("unknown flag: '%s'", arg));
+    } else {
+      options.paths.push_back(std::string(arg));
+    }
+  }
+  if (options.paths.empty()) options.paths.push_back("/dev/stdin");
+  return options;
+}
+
+// Returns the size of `path` if it is a regular file.
+std::optional<int64_t> FileSize(const std::string& path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+    return std::nullopt;
+  }
+  return info.st_size;
+}
+
+// Validates the file at `path`. Returns the exit code for it.
+int ValidateFile(const ValidatorOptions& options, const std::string& path) {
+  Moriarty M;
+  SimpleIO io;
+  RegisteredDefinition()(M, io);
+  M.SetNumThreads(options.num_threads);
+
+  absl::Time start = absl::Now();
+  absl::StatusOr<SimpleIOImporter> importer = io.ImporterFromFile(path);
+  if (!importer.ok()) {
+    std::cerr << path << ": " << importer.status() << '\n';
+    return kUsageError;
+  }
+  absl::Status status = M.ImportTestCases(*std::move(importer));
+  if (status.ok()) status = M.TryValidateTestCases();
+  if (!status.ok()) {
+    std::cerr << path << ": INVALID: " << status << '\n';
+    return kInvalid;
+  }
+  absl::Duration elapsed = absl::Now() - start;
+
+  if (!options.quiet) {
+    std::optional<int64_t> bytes = FileSize(path);
+    double seconds = absl::ToDoubleSeconds(elapsed);
+    if (bytes.has_value() && seconds > 0) {
+      std::cerr << absl::StrFormat("%s: valid (%d bytes in %s, %.1f MB/s)\n",
+                                   path, *bytes, absl::FormatDuration(elapsed),
+                                   *bytes / seconds / 1e6);
+    } else {
+      std::cerr << absl::StrFormat("%s: valid (%s)\n", path,
+                                   absl::FormatDuration(elapsed));
+    }
+  }
+  return kValid;
+}
+
+}  // namespace
+
+bool RegisterValidator(ValidatorDefinition define) {
+  RegisteredDefinition() = define;
+  return true;
+}
+
+int ValidatorMain(int argc, char* argv[]) {
+  if (RegisteredDefinition() == nullptr) {
+    std::cerr << "No validator registered. See RegisterValidator().\n";
+    return kUsageError;
+  }
+  absl::StatusOr<ValidatorOptions> options = ParseArgs(argc, argv);
+  if (!options.ok()) {
+    std::cerr << options.status().message() << '\n'
+              << "usage: " << argv[0] << " [--threads=N] [--quiet] [file...]\n";
+    return kUsageError;
+  }
+  for (const std::string& path : options->paths) {
+    if (int code = ValidateFile(*options, path); code != kValid) return code;
+  }
+  return kValid;
+}
+
+}  // namespace moriarty
+
+int main(int argc, char* argv[]) { return moriarty::ValidatorMain(argc, argv); }
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MORIARTY_SRC_VALIDATOR_MAIN_H_
+#define MORIARTY_SRC_VALIDATOR_MAIN_H_
+
+#include "src/moriarty.h"
+#include "src/simple_io.h"
+
+namespace moriarty {
+
+// A function that adds the problem's variables to `M` and describes the input
+// format in `io`.
+using ValidatorDefinition = void (*)(Moriarty& M, SimpleIO& io);
+
+// RegisterValidator()
+//
+// Registers the problem validated by the `main()` in the `validator_main`
+// library. Call this exactly once, from a static initializer in the binary:
+//
+//   void DefineProblem(moriarty::Moriarty& M, moriarty::SimpleIO& io) {
+//     M.SetName("Example").AddVariable("N", MInteger().Between(1, 100));
+//     io.AddLine("N");
+//   }
+//
+//   const bool kRegistered = moriarty::RegisterValidator(DefineProblem);
+//
+// and depend on `//src:validator_main` from a `cc_binary`. Always returns
+// true.
+bool RegisterValidator(ValidatorDefinition define);
+
+// ValidatorMain()
+//
+// Validates the files named in `argv` (or stdin if there are none), one file
+// at a time, stopping at the first invalid file:
+//
+//   validator [--threads=N] [--quiet] [file...]
+//
+// Regular files are memory-mapped and read in place. The cases of each file
+// are validated on `--threads` threads (default: one per core). Unless
+// `--quiet` is given, the number of bytes, the time, and the throughput of
+// each file are reported on stderr.
+//
+// Returns the exit code: 0 if every file is valid, 1 if a file is invalid, and
+// 2 if the arguments are malformed or a file cannot be read.
+int ValidatorMain(int argc, char* argv[]);
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VALIDATOR_MAIN_H_
@@ -16,6 +16,7 @@
 
 #include "src/variables/constraints/container_constraints.h"
 
+#include <cstdint>
 #include <string>
 
 #include "absl/strings/str_cat.h"
@@ -33,4 +34,103 @@ std::string Length::ToString() const {
   return absl::StrCat("Length(", length_.ToString(), ")");
 }
 
+MInteger Sum::GetConstraints() const { return sum_; }
+
+Sum::Sum(absl::string_view expression) : sum_(Exactly(expression)) {}
+
+std::string Sum::ToString() const {
+  return absl::StrCat("Sum(", sum_.ToString(), ")");
+}
+
+MInteger TotalLength::GetConstraints() const { return total_length_; }
+
+TotalLength::TotalLength(absl::string_view expression)
+    : total_length_(Exactly(expression)) {}
+
+std::string TotalLength::ToString() const {
+  return absl::StrCat("TotalLength(", total_length_.ToString(), ")");
+}
+
+ElementOrder::ElementOrder(Kind kind, int64_t swaps)
+    : kind_(kind), swaps_(swaps) {}
+
+ElementOrder ElementOrder::Sorted() { return ElementOrder(Kind::kSorted, 0); }
+
+ElementOrder ElementOrder::StrictlyIncreasing() {
+  return ElementOrder(Kind::kStrictlyIncreasing, 0);
+}
+
+ElementOrder ElementOrder::Reversed() {
+  return ElementOrder(Kind::kReversed, 0);
+}
+
+ElementOrder ElementOrder::NearlySorted(int64_t swaps) {
+  return ElementOrder(Kind::kNearlySorted, swaps);
+}
+
+ElementOrder::Kind ElementOrder::GetKind() const { return kind_; }
+
+int64_t ElementOrder::GetSwaps() const { return swaps_; }
+
+std::string ElementOrder::ToString() const {
+  switch (kind_) {
+    case Kind::kSorted:
+      return "ElementOrder(Sorted)";
+    case Kind::kStrictlyIncreasing:
+      return "ElementOrder(StrictlyIncreasing)";
+    case Kind::kReversed:
+      return "ElementOrder(Reversed)";
+    case Kind::kNearlySorted:
+      return absl::StrCat("ElementOrder(NearlySorted(", swaps_, "))");
+  }
+  return "ElementOrder(Unknown)";
+}
+
+Permutation::Permutation(Kind kind, int cycles, int64_t first)
+    : kind_(kind), cycles_(cycles), first_(first) {}
+
+Permutation Permutation::Any(int64_t first) {
+  return Permutation(Kind::kAny, 0, first);
+}
+
+Permutation Permutation::SingleCycle(int64_t first) {
+  return Permutation(Kind::kSingleCycle, 1, first);
+}
+
+Permutation Permutation::Derangement(int64_t first) {
+  return Permutation(Kind::kDerangement, 0, first);
+}
+
+Permutation Permutation::WithCycles(int cycles, int64_t first) {
+  return Permutation(Kind::kCycles, cycles, first);
+}
+
+Permutation Permutation::Involution(int64_t first) {
+  return Permutation(Kind::kInvolution, 0, first);
+}
+
+Permutation::Kind Permutation::GetKind() const { return kind_; }
+
+int64_t Permutation::GetFirst() const { return first_; }
+
+int Permutation::GetCycles() const { return cycles_; }
+
+std::string Permutation::ToString() const {
+  std::string first = absl::StrCat("first: ", first_);
+  switch (kind_) {
+    case Kind::kAny:
+      return absl::StrCat("Permutation(Any, ", first, ")");
+    case Kind::kSingleCycle:
+      return absl::StrCat("Permutation(SingleCycle, ", first, ")");
+    case Kind::kDerangement:
+      return absl::StrCat("Permutation(Derangement, ", first, ")");
+    case Kind::kCycles:
+      return absl::StrCat("Permutation(WithCycles(", cycles_, "), ", first,
+                          ")");
+    case Kind::kInvolution:
+      return absl::StrCat("Permutation(Involution, ", first, ")");
+  }
+  return "Permutation(Unknown)";
+}
+
 }  // namespace moriarty
@@ -18,6 +18,7 @@
 #define MORIARTY_SRC_VARIABLES_CONSTRAINTS_CONTAINERS_H_
 
 #include <concepts>
+#include <cstdint>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -56,6 +57,68 @@ class Length : public MConstraint {
   MInteger length_;
 };
 
+// Constraint stating that the elements of a container of integers must sum to
+// this value.
+class Sum : public MConstraint {
+ public:
+  // The sum must be exactly this value.
+  // E.g., Sum(100)
+  template <typename Integer>
+    requires std::integral<Integer>
+  explicit Sum(Integer value);
+
+  // The sum must be exactly this integer expression.
+  // E.g., Sum("3 * N + 1").
+  explicit Sum(absl::string_view expression);
+
+  // The sum must satisfy all of these constraints.
+  // E.g., Sum(Between(1, "S"))
+  template <typename... Constraints>
+    requires(std::constructible_from<MInteger, Constraints...> &&
+             sizeof...(Constraints) > 0)
+  explicit Sum(Constraints&&... constraints);
+
+  // Returns the constraints on the sum.
+  [[nodiscard]] MInteger GetConstraints() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  MInteger sum_;
+};
+
+// Constraint stating that the lengths of the elements of a container of
+// strings must sum to this value.
+class TotalLength : public MConstraint {
+ public:
+  // The total length must be exactly this value.
+  // E.g., TotalLength(1000000)
+  template <typename Integer>
+    requires std::integral<Integer>
+  explicit TotalLength(Integer value);
+
+  // The total length must be exactly this integer expression.
+  // E.g., TotalLength("S").
+  explicit TotalLength(absl::string_view expression);
+
+  // The total length must satisfy all of these constraints.
+  // E.g., TotalLength(Between(1, "S"))
+  template <typename... Constraints>
+    requires(std::constructible_from<MInteger, Constraints...> &&
+             sizeof...(Constraints) > 0)
+  explicit TotalLength(Constraints&&... constraints);
+
+  // Returns the constraints on the total length.
+  [[nodiscard]] MInteger GetConstraints() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  MInteger total_length_;
+};
+
 // Constraints that elements of a container must satisfy.
 template <typename MElementType>
 class Elements : public MConstraint {
@@ -82,6 +145,87 @@ class DistinctElements : public MConstraint {
   explicit DistinctElements() = default;
 };
 
+// Constraint stating that the elements of a container must be in some order.
+// Ordered containers are generated directly when the elements can be (e.g.,
+// `MInteger`s), instead of being sorted after generation.
+class ElementOrder : public MConstraint {
+ public:
+  enum class Kind { kSorted, kStrictlyIncreasing, kReversed, kNearlySorted };
+
+  // The elements must be in non-decreasing order.
+  static ElementOrder Sorted();
+  // The elements must be in increasing order.
+  static ElementOrder StrictlyIncreasing();
+  // The elements must be in non-increasing order.
+  static ElementOrder Reversed();
+  // Generated elements should be `swaps` swaps away from non-decreasing order.
+  // This only guides generation: any order is valid.
+  static ElementOrder NearlySorted(int64_t swaps);
+
+  // Returns the kind of order.
+  [[nodiscard]] Kind GetKind() const;
+
+  // Returns the number of swaps (only meaningful for `kNearlySorted`).
+  [[nodiscard]] int64_t GetSwaps() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+  bool operator==(const ElementOrder& other) const {
+    return kind_ == other.kind_ && swaps_ == other.swaps_;
+  }
+
+ private:
+  ElementOrder(Kind kind, int64_t swaps);
+
+  Kind kind_;
+  int64_t swaps_;
+};
+
+// Constraint stating that the elements of a container must be a permutation p
+// of {first, first + 1, ... , first + (n-1)}, where n is the length, possibly
+// with more structure. Cycles follow x -> p[x - first]. Arrays of `MInteger`s
+// are generated directly, in linear time.
+class Permutation : public MConstraint {
+ public:
+  enum class Kind { kAny, kSingleCycle, kDerangement, kCycles, kInvolution };
+
+  // Any permutation.
+  static Permutation Any(int64_t first = 1);
+  // A permutation that is a single cycle.
+  static Permutation SingleCycle(int64_t first = 1);
+  // A permutation with no fixed points (p[i] != first + i).
+  static Permutation Derangement(int64_t first = 1);
+  // A permutation with exactly `cycles` cycles.
+  static Permutation WithCycles(int cycles, int64_t first = 1);
+  // A permutation that is its own inverse.
+  static Permutation Involution(int64_t first = 1);
+
+  // Returns the kind of permutation.
+  [[nodiscard]] Kind GetKind() const;
+
+  // Returns the smallest value of the permutation.
+  [[nodiscard]] int64_t GetFirst() const;
+
+  // Returns the number of cycles (only meaningful for `kCycles`).
+  [[nodiscard]] int GetCycles() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+  bool operator==(const Permutation& other) const {
+    return kind_ == other.kind_ && cycles_ == other.cycles_ &&
+           first_ == other.first_;
+  }
+
+ private:
+  Permutation(Kind kind, int cycles, int64_t first);
+
+  Kind kind_;
+  int cycles_;
+  int64_t first_;
+};
+
 // -----------------------------------------------------------------------------
 //  Template Implementation Below
 
@@ -95,6 +239,26 @@ template <typename... Constraints>
 Length::Length(Constraints&&... constraints)
     : length_(std::forward<Constraints>(constraints)...) {}
 
+template <typename Integer>
+  requires std::integral<Integer>
+Sum::Sum(Integer value) : sum_(Exactly(value)) {}
+
+template <typename... Constraints>
+  requires(std::constructible_from<MInteger, Constraints...> &&
+           sizeof...(Constraints) > 0)
+Sum::Sum(Constraints&&... constraints)
+    : sum_(std::forward<Constraints>(constraints)...) {}
+
+template <typename Integer>
+  requires std::integral<Integer>
+TotalLength::TotalLength(Integer value) : total_length_(Exactly(value)) {}
+
+template <typename... Constraints>
+  requires(std::constructible_from<MInteger, Constraints...> &&
+           sizeof...(Constraints) > 0)
+TotalLength::TotalLength(Constraints&&... constraints)
+    : total_length_(std::forward<Constraints>(constraints)...) {}
+
 template <typename MElementType>
 template <typename... MElementTypeConstraints>
   requires(std::constructible_from<MElementType, MElementTypeConstraints...> &&
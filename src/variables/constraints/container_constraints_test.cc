@@ -45,6 +45,27 @@ TEST(ContainerConstraintsTest, LengthConstraintsAreCorrect) {
               IsOkAndHolds(Each(AllOf(Ge(3), Le(15)))));
 }
 
+TEST(ContainerConstraintsTest, SumConstraintsAreCorrect) {
+  EXPECT_THAT(Sum(100).GetConstraints(), GeneratedValuesAre(100));
+  EXPECT_THAT(GenerateLots(Sum("2 * N").GetConstraints(),
+                           Context().WithValue<MInteger>("N", 7)),
+              IsOkAndHolds(Each(14)));
+  EXPECT_THAT(GenerateLots(Sum(AtLeast("X"), AtMost(15)).GetConstraints(),
+                           Context().WithValue<MInteger>("X", 3)),
+              IsOkAndHolds(Each(AllOf(Ge(3), Le(15)))));
+}
+
+TEST(ContainerConstraintsTest, TotalLengthConstraintsAreCorrect) {
+  EXPECT_THAT(TotalLength(100).GetConstraints(), GeneratedValuesAre(100));
+  EXPECT_THAT(GenerateLots(TotalLength("2 * N").GetConstraints(),
+                           Context().WithValue<MInteger>("N", 7)),
+              IsOkAndHolds(Each(14)));
+  EXPECT_THAT(
+      GenerateLots(TotalLength(AtLeast("X"), AtMost(15)).GetConstraints(),
+                   Context().WithValue<MInteger>("X", 3)),
+      IsOkAndHolds(Each(AllOf(Ge(3), Le(15)))));
+}
+
 TEST(ContainerConstraintsTest, ElementsConstraintsAreCorrect) {
   EXPECT_THAT(Elements<MInteger>(Between(1, 10)).GetConstraints(),
               GeneratedValuesAre(AllOf(Ge(1), Le(10))));
@@ -59,5 +80,51 @@ TEST(ContainerConstraintsTest, LengthToStringWorks) {
               AllOf(HasSubstr("Length"), HasSubstr("1, 10")));
 }
 
+TEST(ContainerConstraintsTest, SumToStringWorks) {
+  EXPECT_THAT(Sum(Between(1, 10)).ToString(),
+              AllOf(HasSubstr("Sum"), HasSubstr("1, 10")));
+}
+
+TEST(ContainerConstraintsTest, TotalLengthToStringWorks) {
+  EXPECT_THAT(TotalLength(Between(1, 10)).ToString(),
+              AllOf(HasSubstr("TotalLength"), HasSubstr("1, 10")));
+}
+
+TEST(ContainerConstraintsTest, ElementOrderGettersAreCorrect) {
+  EXPECT_EQ(ElementOrder::Sorted().GetKind(), ElementOrder::Kind::kSorted);
+  EXPECT_EQ(ElementOrder::StrictlyIncreasing().GetKind(),
+            ElementOrder::Kind::kStrictlyIncreasing);
+  EXPECT_EQ(ElementOrder::Reversed().GetKind(), ElementOrder::Kind::kReversed);
+  EXPECT_EQ(ElementOrder::NearlySorted(3).GetKind(),
+            ElementOrder::Kind::kNearlySorted);
+  EXPECT_EQ(ElementOrder::NearlySorted(3).GetSwaps(), 3);
+}
+
+TEST(ContainerConstraintsTest, ElementOrderToStringWorks) {
+  EXPECT_EQ(ElementOrder::Sorted().ToString(), "ElementOrder(Sorted)");
+  EXPECT_EQ(ElementOrder::NearlySorted(3).ToString(),
+            "ElementOrder(NearlySorted(3))");
+}
+
+TEST(ContainerConstraintsTest, PermutationGettersAreCorrect) {
+  EXPECT_EQ(Permutation::Any().GetKind(), Permutation::Kind::kAny);
+  EXPECT_EQ(Permutation::Any().GetFirst(), 1);
+  EXPECT_EQ(Permutation::SingleCycle(0).GetKind(),
+            Permutation::Kind::kSingleCycle);
+  EXPECT_EQ(Permutation::SingleCycle(0).GetFirst(), 0);
+  EXPECT_EQ(Permutation::Derangement().GetKind(),
+            Permutation::Kind::kDerangement);
+  EXPECT_EQ(Permutation::WithCycles(3).GetKind(), Permutation::Kind::kCycles);
+  EXPECT_EQ(Permutation::WithCycles(3).GetCycles(), 3);
+  EXPECT_EQ(Permutation::Involution().GetKind(),
+            Permutation::Kind::kInvolution);
+}
+
+TEST(ContainerConstraintsTest, PermutationToStringWorks) {
+  EXPECT_EQ(Permutation::Any().ToString(), "Permutation(Any, first: 1)");
+  EXPECT_EQ(Permutation::WithCycles(3, 0).ToString(),
+            "Permutation(WithCycles(3), first: 0)");
+}
+
 }  // namespace
 }  // namespace moriarty
@@ -0,0 +1,53 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/variables/constraints/graph_constraints.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+NumNodes::NumNodes(absl::string_view expression)
+    : num_nodes_(Exactly(expression)) {}
+
+MInteger NumNodes::GetConstraints() const { return num_nodes_; }
+
+std::string NumNodes::ToString() const {
+  return absl::StrCat("NumNodes(", num_nodes_.ToString(), ")");
+}
+
+NumEdges::NumEdges(absl::string_view expression)
+    : num_edges_(Exactly(expression)) {}
+
+MInteger NumEdges::GetConstraints() const { return num_edges_; }
+
+std::string NumEdges::ToString() const {
+  return absl::StrCat("NumEdges(", num_edges_.ToString(), ")");
+}
+
+NodeLabelsFrom::NodeLabelsFrom(int first_label) : first_label_(first_label) {}
+
+int NodeLabelsFrom::GetFirstLabel() const { return first_label_; }
+
+std::string NodeLabelsFrom::ToString() const {
+  return absl::StrCat("NodeLabelsFrom(", first_label_, ")");
+}
+
+}  // namespace moriarty
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_CONSTRAINTS_GRAPH_CONSTRAINTS_H_
+#define MORIARTY_SRC_VARIABLES_CONSTRAINTS_GRAPH_CONSTRAINTS_H_
+
+#include <concepts>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+// Constraint stating that the graph must have this many nodes.
+class NumNodes : public MConstraint {
+ public:
+  // The number of nodes must be exactly this value.
+  // E.g., NumNodes(10)
+  template <typename Integer>
+    requires std::integral<Integer>
+  explicit NumNodes(Integer value);
+
+  // The number of nodes must be exactly this integer expression.
+  // E.g., NumNodes("N").
+  explicit NumNodes(absl::string_view expression);
+
+  // The number of nodes must satisfy all of these constraints.
+  // E.g., NumNodes(Between(1, "N"))
+  template <typename... Constraints>
+    requires(std::constructible_from<MInteger, Constraints...> &&
+             sizeof...(Constraints) > 0)
+  explicit NumNodes(Constraints&&... constraints);
+
+  // Returns the constraints on the number of nodes.
+  [[nodiscard]] MInteger GetConstraints() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  MInteger num_nodes_;
+};
+
+// Constraint stating that the graph must have this many edges.
+class NumEdges : public MConstraint {
+ public:
+  // The number of edges must be exactly this value.
+  // E.g., NumEdges(10)
+  template <typename Integer>
+    requires std::integral<Integer>
+  explicit NumEdges(Integer value);
+
+  // The number of edges must be exactly this integer expression.
+  // E.g., NumEdges("M").
+  explicit NumEdges(absl::string_view expression);
+
+  // The number of edges must satisfy all of these constraints.
+  // E.g., NumEdges(Between(1, "M"))
+  template <typename... Constraints>
+    requires(std::constructible_from<MInteger, Constraints...> &&
+             sizeof...(Constraints) > 0)
+  explicit NumEdges(Constraints&&... constraints);
+
+  // Returns the constraints on the number of edges.
+  [[nodiscard]] MInteger GetConstraints() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  MInteger num_edges_;
+};
+
+// Constraint stating that the graph must be connected. For directed graphs,
+// the direction of the edges is ignored (weakly connected).
+class Connected : public MConstraint {
+ public:
+  explicit Connected() = default;
+};
+
+// Constraint stating that the graph must be a tree. That is, a connected graph
+// with exactly one less edge than nodes.
+class Tree : public MConstraint {
+ public:
+  explicit Tree() = default;
+};
+
+// Constraint stating that the graph must not have self-loops or multiple edges
+// between the same pair of nodes.
+class SimpleGraph : public MConstraint {
+ public:
+  explicit SimpleGraph() = default;
+};
+
+// Constraint stating that the edges are directed (edge (u, v) goes from u to
+// v), and that there are no directed cycles.
+class DirectedAcyclic : public MConstraint {
+ public:
+  explicit DirectedAcyclic() = default;
+};
+
+// Constraint stating that the nodes can be split into two sides such that
+// every edge goes between the sides.
+class Bipartite : public MConstraint {
+ public:
+  explicit Bipartite() = default;
+};
+
+// Constraint stating how the nodes are labelled when printed or read. Node `u`
+// is labelled `first_label + u`. By default, nodes are labelled from 0.
+// E.g., NodeLabelsFrom(1) for 1-based input.
+class NodeLabelsFrom : public MConstraint {
+ public:
+  explicit NodeLabelsFrom(int first_label);
+
+  // Returns the label of node 0.
+  [[nodiscard]] int GetFirstLabel() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  int first_label_;
+};
+
+// -----------------------------------------------------------------------------
+//  Template Implementation Below
+
+template <typename Integer>
+  requires std::integral<Integer>
+NumNodes::NumNodes(Integer value) : num_nodes_(Exactly(value)) {}
+
+template <typename... Constraints>
+  requires(std::constructible_from<MInteger, Constraints...> &&
+           sizeof...(Constraints) > 0)
+NumNodes::NumNodes(Constraints&&... constraints)
+    : num_nodes_(std::forward<Constraints>(constraints)...) {}
+
+template <typename Integer>
+  requires std::integral<Integer>
+NumEdges::NumEdges(Integer value) : num_edges_(Exactly(value)) {}
+
+template <typename... Constraints>
+  requires(std::constructible_from<MInteger, Constraints...> &&
+           sizeof...(Constraints) > 0)
+NumEdges::NumEdges(Constraints&&... constraints)
+    : num_edges_(std::forward<Constraints>(constraints)...) {}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_CONSTRAINTS_GRAPH_CONSTRAINTS_H_
@@ -0,0 +1,71 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/variables/constraints/graph_constraints.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/constraints/numeric_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty_testing::Context;
+using ::moriarty_testing::GeneratedValuesAre;
+using ::moriarty_testing::GenerateLots;
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Le;
+using ::moriarty::IsOkAndHolds;
+
+TEST(GraphConstraintsTest, NumNodesConstraintsAreCorrect) {
+  EXPECT_THAT(NumNodes(10).GetConstraints(), GeneratedValuesAre(10));
+  EXPECT_THAT(GenerateLots(NumNodes("2 * N").GetConstraints(),
+                           Context().WithValue<MInteger>("N", 7)),
+              IsOkAndHolds(Each(14)));
+  EXPECT_THAT(GenerateLots(NumNodes(AtLeast("X"), AtMost(15)).GetConstraints(),
+                           Context().WithValue<MInteger>("X", 3)),
+              IsOkAndHolds(Each(AllOf(Ge(3), Le(15)))));
+}
+
+TEST(GraphConstraintsTest, NumEdgesConstraintsAreCorrect) {
+  EXPECT_THAT(NumEdges(10).GetConstraints(), GeneratedValuesAre(10));
+  EXPECT_THAT(GenerateLots(NumEdges("M - 1").GetConstraints(),
+                           Context().WithValue<MInteger>("M", 7)),
+              IsOkAndHolds(Each(6)));
+  EXPECT_THAT(NumEdges(Between(1, 5)).GetConstraints(),
+              GeneratedValuesAre(AllOf(Ge(1), Le(5))));
+}
+
+TEST(GraphConstraintsTest, NodeLabelsFromShouldKeepTheFirstLabel) {
+  EXPECT_EQ(NodeLabelsFrom(1).GetFirstLabel(), 1);
+  EXPECT_EQ(NodeLabelsFrom(0).GetFirstLabel(), 0);
+}
+
+TEST(GraphConstraintsTest, ToStringWorks) {
+  EXPECT_THAT(NumNodes(Between(1, 10)).ToString(),
+              AllOf(HasSubstr("NumNodes"), HasSubstr("1, 10")));
+  EXPECT_THAT(NumEdges(Between(2, 20)).ToString(),
+              AllOf(HasSubstr("NumEdges"), HasSubstr("2, 20")));
+  EXPECT_EQ(NodeLabelsFrom(1).ToString(), "NodeLabelsFrom(1)");
+}
+
+}  // namespace
+}  // namespace moriarty
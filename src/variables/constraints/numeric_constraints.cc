@@ -19,7 +19,13 @@
 #include <cstdint>
 #include <limits>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/substitute.h"
+#include "src/internal/integer_distributions.h"
 #include "src/internal/range.h"
 
 namespace moriarty {
@@ -81,4 +87,80 @@ Range AtLeast::GetRange() const { return bounds_; }
 // TODO(darcybest): This should say the word "AtLeast".
 std::string AtLeast::ToString() const { return bounds_.ToString(); }
 
+MultipleOf::MultipleOf(int64_t factor) : factor_(factor) {}
+
+int64_t MultipleOf::GetFactor() const { return factor_; }
+
+std::string MultipleOf::ToString() const {
+  return absl::Substitute("MultipleOf($0)", factor_);
+}
+
+ModEquals::ModEquals(int64_t modulus, int64_t remainder)
+    : modulus_(modulus), remainder_(remainder) {}
+
+int64_t ModEquals::GetModulus() const { return modulus_; }
+
+int64_t ModEquals::GetRemainder() const { return remainder_; }
+
+std::string ModEquals::ToString() const {
+  return absl::Substitute("ModEquals($0, $1)", modulus_, remainder_);
+}
+
+NotIn::NotIn(std::vector<int64_t> values) : values_(std::move(values)) {}
+
+const std::vector<int64_t>& NotIn::GetValues() const { return values_; }
+
+std::string NotIn::ToString() const {
+  return absl::Substitute("NotIn({$0})", absl::StrJoin(values_, ", "));
+}
+
+std::string Prime::ToString() const { return "Prime()"; }
+
+using Shape = moriarty_internal::IntegerDistribution::Shape;
+
+Distribution::Distribution(moriarty_internal::IntegerDistribution distribution)
+    : distribution_(std::move(distribution)) {}
+
+Distribution Distribution::Uniform() {
+  return Distribution({.shape = Shape::kUniform});
+}
+
+Distribution Distribution::LogUniform() {
+  return Distribution({.shape = Shape::kLogUniform});
+}
+
+Distribution Distribution::LogUniformNearMax() {
+  return Distribution({.shape = Shape::kLogUniform, .from_max = true});
+}
+
+Distribution Distribution::Exponential(double mean) {
+  return Distribution({.shape = Shape::kExponential, .mean = mean});
+}
+
+Distribution Distribution::ExponentialNearMax(double mean) {
+  return Distribution(
+      {.shape = Shape::kExponential, .from_max = true, .mean = mean});
+}
+
+Distribution Distribution::ClampedNormal(double mean, double stddev) {
+  return Distribution(
+      {.shape = Shape::kClampedNormal, .mean = mean, .stddev = stddev});
+}
+
+Distribution Distribution::WeightedBuckets(std::vector<Bucket> buckets) {
+  return Distribution(
+      {.shape = Shape::kWeightedBuckets, .buckets = std::move(buckets)});
+}
+
+const moriarty_internal::IntegerDistribution& Distribution::GetDistribution()
+    const {
+  return distribution_;
+}
+
+std::string Distribution::ToString() const {
+  return absl::StrCat(
+      "Distribution(",
+      moriarty_internal::IntegerDistributionToString(distribution_), ")");
+}
+
 }  // namespace moriarty
@@ -19,8 +19,10 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
+#include "src/internal/integer_distributions.h"
 #include "src/internal/range.h"
 #include "src/variables/constraints/base_constraints.h"
 
@@ -94,6 +96,125 @@ class AtLeast : public MConstraint {
   Range bounds_;
 };
 
+// Constraint stating that the numeric value must be a multiple of `factor`.
+// Unlike an equivalent custom constraint, values are generated directly
+// instead of by rejecting the ones that are not multiples.
+class MultipleOf : public MConstraint {
+ public:
+  // The numeric value must be a multiple of `factor`. E.g., MultipleOf(2)
+  // `factor` must be positive.
+  explicit MultipleOf(int64_t factor);
+
+  // Returns the factor.
+  [[nodiscard]] int64_t GetFactor() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  int64_t factor_;
+};
+
+// Constraint stating that the numeric value `x` must satisfy
+// `x mod modulus == remainder`. The mathematical definition of mod is used,
+// so `ModEquals(3, 2)` allows -1. Values are generated directly instead of by
+// rejecting the ones that do not satisfy this.
+class ModEquals : public MConstraint {
+ public:
+  // The numeric value mod `modulus` must be `remainder`. E.g., ModEquals(4, 1)
+  // `modulus` must be positive.
+  explicit ModEquals(int64_t modulus, int64_t remainder);
+
+  // Returns the modulus.
+  [[nodiscard]] int64_t GetModulus() const;
+
+  // Returns the remainder.
+  [[nodiscard]] int64_t GetRemainder() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  int64_t modulus_;
+  int64_t remainder_;
+};
+
+// Constraint stating that the numeric value must not be any of these values.
+// Values are generated directly instead of by rejecting the excluded ones.
+class NotIn : public MConstraint {
+ public:
+  // The numeric value must not be any of `values`. E.g., NotIn({0, 1})
+  explicit NotIn(std::vector<int64_t> values);
+
+  // Returns the excluded values.
+  [[nodiscard]] const std::vector<int64_t>& GetValues() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  std::vector<int64_t> values_;
+};
+
+// Constraint stating that the numeric value must be prime. Values are found
+// directly (e.g., by scanning from a random point for the next prime) instead
+// of by rejecting values that are not prime.
+class Prime : public MConstraint {
+ public:
+  // The numeric value must be prime.
+  Prime() = default;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+};
+
+// Weak constraint stating how the numeric value should be distributed in its
+// range when it is generated. The parameters are fractions of the width of
+// the range (e.g., `Exponential(0.01)` has a mean 1% of the way from the
+// minimum to the maximum), so they work for ranges like [1, N].
+//
+// Like `SizeCategory`, this is a generation hint, not a validation function.
+// Values are sampled directly from the distribution, so there are no retries.
+class Distribution : public MConstraint {
+ public:
+  using Bucket = moriarty_internal::WeightedBucket;
+
+  // Every value is equally likely. This is the default.
+  static Distribution Uniform();
+  // Values are log-uniformly distributed. That is, the distance from the
+  // minimum (or maximum, for `LogUniformNearMax()`) is equally likely to be
+  // 0, in [1, 2), in [2, 4), in [4, 8), etc.
+  static Distribution LogUniform();
+  static Distribution LogUniformNearMax();
+  // The distance from the minimum (or maximum, for `ExponentialNearMax()`) is
+  // exponentially distributed with mean `mean * (maximum - minimum)`.
+  // `mean` must be positive.
+  static Distribution Exponential(double mean);
+  static Distribution ExponentialNearMax(double mean);
+  // The distance from the minimum is normally distributed with mean
+  // `mean * (maximum - minimum)` and standard deviation
+  // `stddev * (maximum - minimum)`. Values outside of the range are clamped.
+  static Distribution ClampedNormal(double mean, double stddev);
+  // A bucket is picked with probability proportional to its weight (ignoring
+  // the buckets that do not intersect the range), then a value is picked
+  // uniformly from that bucket. Unlike the others, the buckets are in absolute
+  // values. E.g., WeightedBuckets({{.min = 1, .max = 10, .weight = 9},
+  //                                {.min = 11, .max = 1000, .weight = 1}})
+  static Distribution WeightedBuckets(std::vector<Bucket> buckets);
+
+  // Returns the underlying distribution.
+  [[nodiscard]] const moriarty_internal::IntegerDistribution& GetDistribution()
+      const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  explicit Distribution(moriarty_internal::IntegerDistribution distribution);
+
+  moriarty_internal::IntegerDistribution distribution_;
+};
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_VARIABLES_NUMERIC_CONSTRAINTS_H_
@@ -16,6 +16,9 @@
 
 #include "src/variables/constraints/numeric_constraints.h"
 
+#include <cstdint>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "src/internal/range.h"
 
@@ -25,6 +28,11 @@ namespace {
 using ::moriarty::AtLeast;
 using ::moriarty::AtMost;
 using ::moriarty::Between;
+using ::moriarty::Distribution;
+using ::moriarty::ModEquals;
+using ::moriarty::MultipleOf;
+using ::moriarty::NotIn;
+using ::moriarty::Prime;
 
 testing::AssertionResult EqualRanges(const Range& r1, const Range& r2) {
   auto extremes1 = r1.Extremes();
@@ -112,5 +120,41 @@ TEST(NumericConstraintsTest, AtLeastToStringWorks) {
   EXPECT_EQ(AtLeast("N").ToString(), "[N, inf)");
 }
 
+TEST(NumericConstraintsTest, ArithmeticConstraintsShouldStoreTheirParameters) {
+  EXPECT_EQ(MultipleOf(3).GetFactor(), 3);
+  EXPECT_EQ(ModEquals(5, 2).GetModulus(), 5);
+  EXPECT_EQ(ModEquals(5, 2).GetRemainder(), 2);
+  EXPECT_EQ(NotIn({1, 2}).GetValues(), (std::vector<int64_t>{1, 2}));
+}
+
+TEST(NumericConstraintsTest, ArithmeticConstraintsToStringWorks) {
+  EXPECT_EQ(MultipleOf(3).ToString(), "MultipleOf(3)");
+  EXPECT_EQ(ModEquals(5, 2).ToString(), "ModEquals(5, 2)");
+  EXPECT_EQ(NotIn({1, 2}).ToString(), "NotIn({1, 2})");
+  EXPECT_EQ(Prime().ToString(), "Prime()");
+}
+
+TEST(NumericConstraintsTest, DistributionShouldStoreItsParameters) {
+  using Shape = moriarty_internal::IntegerDistribution::Shape;
+  EXPECT_EQ(Distribution::Uniform().GetDistribution().shape, Shape::kUniform);
+  EXPECT_EQ(Distribution::LogUniform().GetDistribution().shape,
+            Shape::kLogUniform);
+  EXPECT_TRUE(Distribution::LogUniformNearMax().GetDistribution().from_max);
+  EXPECT_EQ(Distribution::Exponential(0.25).GetDistribution().mean, 0.25);
+  EXPECT_TRUE(Distribution::ExponentialNearMax(0.5).GetDistribution().from_max);
+  EXPECT_EQ(Distribution::ClampedNormal(0.5, 0.1).GetDistribution().stddev,
+            0.1);
+  EXPECT_EQ(Distribution::WeightedBuckets({{.min = 1, .max = 2, .weight = 3}})
+                .GetDistribution()
+                .buckets.size(),
+            1);
+}
+
+TEST(NumericConstraintsTest, DistributionToStringWorks) {
+  EXPECT_EQ(Distribution::Uniform().ToString(), "Distribution(uniform)");
+  EXPECT_EQ(Distribution::ExponentialNearMax(0.5).ToString(),
+            "Distribution(exponential_near_max(mean=0.5))");
+}
+
 }  // namespace
 }  // namespace moriarty
@@ -16,10 +16,13 @@
 
 #include "src/variables/constraints/string_constraints.h"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "src/internal/simple_pattern_literal.h"
 
 namespace moriarty {
 
@@ -55,7 +58,8 @@ std::string Alphabet::ToString() const {
   return absl::Substitute("Alphabet($0)", alphabet_);
 }
 
-SimplePattern::SimplePattern(absl::string_view pattern) : pattern_(pattern) {}
+SimplePattern::SimplePattern(moriarty_internal::SimplePatternLiteral pattern)
+    : pattern_(pattern.Pattern()) {}
 
 std::string SimplePattern::GetPattern() const { return pattern_; }
 
@@ -63,4 +67,61 @@ std::string SimplePattern::ToString() const {
   return absl::Substitute("SimplePattern($0)", pattern_);
 }
 
+StringStructure::StringStructure(Kind kind, int64_t period)
+    : kind_(kind), period_(period) {}
+
+StringStructure::Kind StringStructure::GetKind() const { return kind_; }
+
+StringStructure StringStructure::PolynomialHashCollision(int64_t base,
+                                                         int64_t modulus) {
+  StringStructure structure(Kind::kPolynomialHashCollision);
+  structure.base_ = base;
+  structure.modulus_ = modulus;
+  return structure;
+}
+
+int64_t StringStructure::GetPeriod() const { return period_; }
+
+int64_t StringStructure::GetBase() const { return base_; }
+
+int64_t StringStructure::GetModulus() const { return modulus_; }
+
+std::string StringStructure::ToString() const {
+  switch (kind_) {
+    case Kind::kPeriodic:
+      return absl::Substitute("StringStructure(Periodic($0))", period_);
+    case Kind::kFibonacciWord:
+      return "StringStructure(FibonacciWord)";
+    case Kind::kLowEntropy:
+      return "StringStructure(LowEntropy)";
+    case Kind::kThueMorse:
+      return "StringStructure(ThueMorse)";
+    case Kind::kPolynomialHashCollision:
+      return absl::Substitute("StringStructure(PolynomialHashCollision($0, $1))",
+                              base_, modulus_);
+  }
+  return "StringStructure(Unknown)";
+}
+
+BalancedBrackets::BalancedBrackets(absl::string_view brackets)
+    : brackets_(brackets) {}
+
+BalancedBrackets::BalancedBrackets(absl::string_view brackets,
+                                   int64_t max_depth)
+    : brackets_(brackets), max_depth_(max_depth) {}
+
+std::string BalancedBrackets::GetBrackets() const { return brackets_; }
+
+std::optional<int64_t> BalancedBrackets::GetMaxDepth() const {
+  return max_depth_;
+}
+
+std::string BalancedBrackets::ToString() const {
+  if (max_depth_) {
+    return absl::Substitute("BalancedBrackets($0, max depth $1)", brackets_,
+                            *max_depth_);
+  }
+  return absl::Substitute("BalancedBrackets($0)", brackets_);
+}
+
 }  // namespace moriarty
@@ -17,9 +17,14 @@
 #ifndef MORIARTY_SRC_VARIABLES_CONSTRAINTS_STRING_CONSTRAINTS_H_
 #define MORIARTY_SRC_VARIABLES_CONSTRAINTS_STRING_CONSTRAINTS_H_
 
+#include <concepts>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <type_traits>
 
 #include "absl/strings/string_view.h"
+#include "src/internal/simple_pattern_literal.h"
 #include "src/variables/constraints/base_constraints.h"
 
 namespace moriarty {
@@ -76,8 +81,17 @@ class DistinctCharacters : public MConstraint {
 // pattern.
 class SimplePattern : public MConstraint {
  public:
-  // The string must match this simple pattern.
-  explicit SimplePattern(absl::string_view pattern);
+  // The string must match this simple pattern. String literals are checked at
+  // compile time, so an invalid literal pattern does not compile.
+  explicit SimplePattern(moriarty_internal::SimplePatternLiteral pattern);
+
+  // The string must match this simple pattern, which is built at runtime. An
+  // invalid pattern is reported when the constraint is used.
+  template <typename T>
+    requires(std::convertible_to<const T&, absl::string_view> &&
+             !std::is_array_v<T>)
+  explicit SimplePattern(const T& pattern)
+      : pattern_(absl::string_view(pattern)) {}
 
   // Returns the pattern that the string must match.
   [[nodiscard]] std::string GetPattern() const;
@@ -89,6 +103,98 @@ class SimplePattern : public MConstraint {
   std::string pattern_;
 };
 
+// Constraint stating that generated strings should have a particular
+// structure. These are the classical worst cases for string algorithms (KMP,
+// the Z-function, hashing, ...) and are built directly in linear time, using
+// characters from the alphabet.
+//
+// This only guides generation: it does not restrict which strings are valid.
+class StringStructure : public MConstraint {
+ public:
+  enum class Kind {
+    // The string is a random block of `period` characters, repeated.
+    kPeriodic,
+    // The string is a prefix of the infinite Fibonacci word
+    // (abaababaabaab...), with two characters from the alphabet.
+    kFibonacciWord,
+    // The string is made of long runs of at most two characters.
+    kLowEntropy,
+    // The string is a prefix of the Thue-Morse sequence (abbabaabbaab...),
+    // with two characters from the alphabet. Its prefixes of length 2^k and
+    // their complements collide for polynomial hashes modulo 2^64 (i.e.,
+    // hashing with unsigned overflow).
+    kThueMorse,
+    // The string is two halves with the same polynomial hash for some base and
+    // modulus (see `PolynomialHashCollision()`).
+    kPolynomialHashCollision,
+  };
+
+  // Generated strings should have this structure. `period` is only used by
+  // `kPeriodic`, and must be positive for it.
+  explicit StringStructure(Kind kind, int64_t period = 0);
+
+  // PolynomialHashCollision()
+  //
+  // The first and second halves of the string (of length `length / 2`) are
+  // different, but s[0] * base^(n-1) + ... + s[n-1] modulo `modulus` is the
+  // same for both. Finding a collision needs a long enough string (e.g., 512
+  // characters for a 30-bit modulus and 8192 for a 61-bit modulus).
+  static StringStructure PolynomialHashCollision(int64_t base, int64_t modulus);
+
+  // Returns the kind of structure.
+  [[nodiscard]] Kind GetKind() const;
+
+  // Returns the period (only meaningful for `kPeriodic`).
+  [[nodiscard]] int64_t GetPeriod() const;
+
+  // Returns the base and modulus (only meaningful for
+  // `kPolynomialHashCollision`).
+  [[nodiscard]] int64_t GetBase() const;
+  [[nodiscard]] int64_t GetModulus() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  Kind kind_;
+  int64_t period_;
+  int64_t base_ = 0;
+  int64_t modulus_ = 0;
+};
+
+// Constraint stating that the string must be a balanced sequence of brackets
+// (e.g., "(()[])"): each closing bracket closes the most recent bracket that is
+// still open, which must be of the same type, and every bracket is closed.
+//
+// Generated strings are made only of these brackets, in linear time. Without
+// a maximum depth, they are uniformly random among all balanced strings of
+// their length (which must be even).
+class BalancedBrackets : public MConstraint {
+ public:
+  // The string must be balanced, using the pairs of brackets in `brackets`:
+  // the opening and closing character of each type, one pair after the other
+  // (e.g., "()" or "()[]{}").
+  explicit BalancedBrackets(absl::string_view brackets = "()");
+
+  // Same as above, but the brackets may be nested at most `max_depth` deep
+  // (e.g., "(())()" is nested 2 deep). Generated strings are then no longer
+  // uniformly random.
+  BalancedBrackets(absl::string_view brackets, int64_t max_depth);
+
+  // Returns the pairs of brackets the string is made of.
+  [[nodiscard]] std::string GetBrackets() const;
+
+  // Returns how deep the brackets may be nested, if limited.
+  [[nodiscard]] std::optional<int64_t> GetMaxDepth() const;
+
+  // Returns a string representation of this constraint.
+  [[nodiscard]] std::string ToString() const;
+
+ private:
+  std::string brackets_;
+  std::optional<int64_t> max_depth_;
+};
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_VARIABLES_CONSTRAINTS_STRING_CONSTRAINTS_H_
@@ -16,9 +16,13 @@
 
 #include "src/variables/constraints/string_constraints.h"
 
+#include <optional>
+#include <string>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
 
 namespace moriarty {
 namespace {
@@ -84,5 +88,55 @@ TEST(SimplePatternTest, ToStringShouldWork) {
   EXPECT_EQ(SimplePattern("[^a-z]?").ToString(), "SimplePattern([^a-z]?)");
 }
 
+TEST(SimplePatternTest, RuntimePatternsShouldNotBeCheckedWhenConstructed) {
+  std::string pattern = "[a-z]{1,5}";
+  EXPECT_EQ(SimplePattern(pattern).GetPattern(), "[a-z]{1,5}");
+  EXPECT_EQ(SimplePattern(absl::string_view("(ab)*")).GetPattern(), "(ab)*");
+}
+
+TEST(StringStructureTest, GettersShouldReturnTheStructure) {
+  StringStructure periodic(StringStructure::Kind::kPeriodic, 3);
+  EXPECT_EQ(periodic.GetKind(), StringStructure::Kind::kPeriodic);
+  EXPECT_EQ(periodic.GetPeriod(), 3);
+
+  EXPECT_EQ(StringStructure(StringStructure::Kind::kFibonacciWord).GetKind(),
+            StringStructure::Kind::kFibonacciWord);
+}
+
+TEST(StringStructureTest, ToStringShouldWork) {
+  EXPECT_EQ(StringStructure(StringStructure::Kind::kPeriodic, 3).ToString(),
+            "StringStructure(Periodic(3))");
+  EXPECT_EQ(StringStructure(StringStructure::Kind::kFibonacciWord).ToString(),
+            "StringStructure(FibonacciWord)");
+  EXPECT_EQ(StringStructure(StringStructure::Kind::kLowEntropy).ToString(),
+            "StringStructure(LowEntropy)");
+  EXPECT_EQ(StringStructure(StringStructure::Kind::kThueMorse).ToString(),
+            "StringStructure(ThueMorse)");
+  EXPECT_EQ(StringStructure::PolynomialHashCollision(131, 1000).ToString(),
+            "StringStructure(PolynomialHashCollision(131, 1000))");
+}
+
+TEST(StringStructureTest, PolynomialHashCollisionShouldKeepBaseAndModulus) {
+  StringStructure structure =
+      StringStructure::PolynomialHashCollision(131, 1000000007);
+  EXPECT_EQ(structure.GetKind(),
+            StringStructure::Kind::kPolynomialHashCollision);
+  EXPECT_EQ(structure.GetBase(), 131);
+  EXPECT_EQ(structure.GetModulus(), 1000000007);
+}
+
+TEST(BalancedBracketsTest, GettersShouldReturnTheBrackets) {
+  EXPECT_EQ(BalancedBrackets().GetBrackets(), "()");
+  EXPECT_EQ(BalancedBrackets().GetMaxDepth(), std::nullopt);
+  EXPECT_EQ(BalancedBrackets("()[]").GetBrackets(), "()[]");
+  EXPECT_EQ(BalancedBrackets("()[]", 3).GetMaxDepth(), 3);
+}
+
+TEST(BalancedBracketsTest, ToStringShouldWork) {
+  EXPECT_EQ(BalancedBrackets("()[]").ToString(), "BalancedBrackets(()[])");
+  EXPECT_EQ(BalancedBrackets("()", 3).ToString(),
+            "BalancedBrackets((), max depth 3)");
+}
+
 }  // namespace
 }  // namespace moriarty
@@ -0,0 +1,63 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/variables/graph.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/types/span.h"
+
+namespace moriarty {
+
+Graph::Graph(int num_nodes, std::vector<std::pair<int, int>> edges)
+    : num_nodes_(num_nodes),
+      edges_(std::move(edges)),
+      offsets_(num_nodes + 1),
+      out_degree_(num_nodes),
+      adjacent_(2 * edges_.size()) {
+  // Counting sort: out-neighbours first, then the others.
+  std::vector<int> in_degree(num_nodes);
+  for (auto [u, v] : edges_) {
+    ABSL_CHECK(0 <= u && u < num_nodes && 0 <= v && v < num_nodes)
+        << "Edge (" << u << ", " << v << ") is not in a graph with "
+        << num_nodes << " nodes";
+    out_degree_[u]++;
+    in_degree[v]++;
+  }
+  for (int u = 0; u < num_nodes; u++)
+    offsets_[u + 1] = offsets_[u] + out_degree_[u] + in_degree[u];
+
+  std::vector<int64_t> next_out(offsets_.begin(), offsets_.end() - 1);
+  std::vector<int64_t> next_in(num_nodes);
+  for (int u = 0; u < num_nodes; u++) next_in[u] = offsets_[u] + out_degree_[u];
+  for (auto [u, v] : edges_) {
+    adjacent_[next_out[u]++] = v;
+    adjacent_[next_in[v]++] = u;
+  }
+}
+
+absl::Span<const int> Graph::OutNeighbors(int u) const {
+  return absl::MakeConstSpan(adjacent_).subspan(offsets_[u], out_degree_[u]);
+}
+
+absl::Span<const int> Graph::Neighbors(int u) const {
+  return absl::MakeConstSpan(adjacent_).subspan(offsets_[u],
+                                                offsets_[u + 1] - offsets_[u]);
+}
+
+}  // namespace moriarty
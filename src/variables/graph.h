@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_GRAPH_H_
+#define MORIARTY_SRC_VARIABLES_GRAPH_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+
+namespace moriarty {
+
+// Graph
+//
+// A graph on the nodes {0, 1, ... , NumNodes() - 1}. The edges are kept in the
+// order they were given, along with a compressed sparse row (CSR) adjacency
+// list, so neighbours can be iterated without any per-node allocations.
+//
+// Whether the edges are directed is up to the user (e.g., `MGraph`). `u` and
+// `v` are neighbours of each other for each edge (u, v), and `v` is an
+// out-neighbour of `u`.
+class Graph {
+ public:
+  Graph() = default;
+
+  // Creates a graph with these edges. Each endpoint must be in
+  // [0, num_nodes).
+  Graph(int num_nodes, std::vector<std::pair<int, int>> edges);
+
+  [[nodiscard]] int NumNodes() const { return num_nodes_; }
+  [[nodiscard]] int64_t NumEdges() const { return edges_.size(); }
+
+  // Returns the edges, in the order they were given.
+  [[nodiscard]] absl::Span<const std::pair<int, int>> Edges() const {
+    return edges_;
+  }
+
+  // Returns the nodes `v` for each edge (u, v), in edge order.
+  [[nodiscard]] absl::Span<const int> OutNeighbors(int u) const;
+
+  // Returns the out-neighbours of `u` (as in `OutNeighbors()`), followed by the
+  // nodes `w` for each edge (w, u). A self-loop appears twice.
+  [[nodiscard]] absl::Span<const int> Neighbors(int u) const;
+
+  friend bool operator==(const Graph& a, const Graph& b) {
+    return a.num_nodes_ == b.num_nodes_ && a.edges_ == b.edges_;
+  }
+  friend bool operator<(const Graph& a, const Graph& b) {
+    if (a.num_nodes_ != b.num_nodes_) return a.num_nodes_ < b.num_nodes_;
+    return a.edges_ < b.edges_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const Graph& g) {
+    return H::combine(std::move(h), g.num_nodes_, g.edges_);
+  }
+
+ private:
+  int num_nodes_ = 0;
+  std::vector<std::pair<int, int>> edges_;
+
+  // Node u's neighbours are `adjacent_[offsets_[u], offsets_[u + 1])`, and the
+  // first `out_degree_[u]` of those are its out-neighbours.
+  std::vector<int64_t> offsets_ = {0};
+  std::vector<int> out_degree_;
+  std::vector<int> adjacent_;
+};
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_GRAPH_H_
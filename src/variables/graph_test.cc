@@ -0,0 +1,65 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/variables/graph.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace moriarty {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(GraphTest, EmptyGraphHasNoNodesOrEdges) {
+  Graph g;
+  EXPECT_EQ(g.NumNodes(), 0);
+  EXPECT_EQ(g.NumEdges(), 0);
+  EXPECT_THAT(g.Edges(), IsEmpty());
+}
+
+TEST(GraphTest, EdgesShouldKeepTheirOrder) {
+  Graph g(4, {{2, 1}, {0, 3}, {1, 2}});
+  EXPECT_EQ(g.NumNodes(), 4);
+  EXPECT_EQ(g.NumEdges(), 3);
+  EXPECT_THAT(g.Edges(), ElementsAre(Pair(2, 1), Pair(0, 3), Pair(1, 2)));
+}
+
+TEST(GraphTest, NeighborsShouldFollowTheEdges) {
+  Graph g(4, {{2, 1}, {0, 3}, {1, 2}, {1, 1}, {0, 2}});
+  EXPECT_THAT(g.OutNeighbors(0), ElementsAre(3, 2));
+  EXPECT_THAT(g.OutNeighbors(1), ElementsAre(2, 1));
+  EXPECT_THAT(g.OutNeighbors(2), ElementsAre(1));
+  EXPECT_THAT(g.OutNeighbors(3), IsEmpty());
+
+  EXPECT_THAT(g.Neighbors(0), UnorderedElementsAre(3, 2));
+  EXPECT_THAT(g.Neighbors(1), UnorderedElementsAre(2, 2, 1, 1));
+  EXPECT_THAT(g.Neighbors(2), UnorderedElementsAre(1, 1, 0));
+  EXPECT_THAT(g.Neighbors(3), UnorderedElementsAre(0));
+}
+
+TEST(GraphTest, ComparisonsShouldUseNodesAndEdges) {
+  EXPECT_EQ(Graph(3, {{0, 1}}), Graph(3, {{0, 1}}));
+  EXPECT_NE(Graph(3, {{0, 1}}), Graph(3, {{1, 0}}));
+  EXPECT_NE(Graph(3, {{0, 1}}), Graph(4, {{0, 1}}));
+  EXPECT_LT(Graph(3, {{0, 1}}), Graph(4, {}));
+  EXPECT_LT(Graph(3, {{0, 1}}), Graph(3, {{0, 2}}));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -19,8 +19,10 @@
 
 #include <algorithm>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -28,14 +30,24 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
-#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "src/errors.h"
+#include "src/internal/anti_hash.h"
+#include "src/internal/distinct_elements.h"
+#include "src/internal/distinct_integers.h"
+#include "src/internal/generation_config.h"
+#include "src/internal/permutations.h"
+#include "src/internal/random_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/shrink.h"
 #include "src/librarian/io_config.h"
 #include "src/librarian/mvariable.h"
 #include "src/property.h"
@@ -43,6 +55,7 @@
 #include "src/variables/constraints/base_constraints.h"
 #include "src/variables/constraints/container_constraints.h"
 #include "src/variables/constraints/io_constraints.h"
+#include "src/variables/constraints/numeric_constraints.h"
 #include "src/variables/constraints/size_constraints.h"
 #include "src/variables/minteger.h"
 
@@ -87,6 +100,18 @@ class MArray : public librarian::MVariable<
   MArray& AddConstraint(const IOSeparator& constraint);
   // The array should be approximately this size.
   MArray& AddConstraint(const SizeCategory& constraint);
+  // The array's elements must be in this order.
+  MArray& AddConstraint(const ElementOrder& constraint)
+    requires std::totally_ordered<element_value_type>;
+  // The array's elements must sum to this value.
+  MArray& AddConstraint(const Sum& constraint)
+    requires std::same_as<MElementType, MInteger>;
+  // The array must be a permutation with this structure.
+  MArray& AddConstraint(const Permutation& constraint)
+    requires std::same_as<MElementType, MInteger>;
+  // The lengths of the array's elements must sum to this value.
+  MArray& AddConstraint(const TotalLength& constraint)
+    requires std::same_as<element_value_type, std::string>;
 
   // Typename()
   //
@@ -94,6 +119,21 @@ class MArray : public librarian::MVariable<
   // "MArray<MInteger>"). This is mostly used for debugging/error messages.
   [[nodiscard]] std::string Typename() const override;
 
+  // ValueByteSize()
+  //
+  // Returns the sum of `MElementType::ValueByteSize()` over the elements of
+  // `value`. Arrays of integral types are `sizeof()` their elements.
+  [[nodiscard]] static int64_t ValueByteSize(const vector_value_type& value) {
+    if constexpr (std::is_arithmetic_v<element_value_type>) {
+      return value.size() * sizeof(element_value_type);
+    } else {
+      int64_t bytes = 0;
+      for (const element_value_type& element : value)
+        bytes += MElementType::ValueByteSize(element);
+      return bytes;
+    }
+  }
+
   // Of()
   //
   // Add extra constraints to the elements of the array.
@@ -129,12 +169,60 @@ class MArray : public librarian::MVariable<
   [[deprecated("Use WithDistinctElements() instead.")]] MArray&
   WithDistinctElementsWithArg(bool distinct_elements = true);
 
+  // WithElementOrder()
+  //
+  // States that the elements of this array must be in this order (e.g.,
+  // `ElementOrder::Sorted()`). Arrays of `MInteger`s are generated in order
+  // directly, in linear time. Other arrays are sorted after generation.
+  MArray& WithElementOrder(ElementOrder order)
+    requires std::totally_ordered<element_value_type>;
+
   // WithSeparator()
   //
   // Sets the whitespace separator to be used between different array entries
   // when reading/writing. Default = kSpace.
   MArray& WithSeparator(Whitespace separator);
 
+  // WithUnorderedMapCollisions()
+  //
+  // Generates integers that are all multiples of the number of buckets of a
+  // (libstdc++) `std::unordered_map` or `std::unordered_set` that contains the
+  // array. They all go in the same bucket, so inserting the array takes
+  // quadratic time. The elements must still be able to be such multiples
+  // (e.g., `MInteger().Between(1, 1e18)`).
+  //
+  // This only affects generation, not which arrays are valid.
+  MArray& WithUnorderedMapCollisions()
+    requires std::same_as<MElementType, MInteger>;
+
+  // WithSum()
+  //
+  // States that the elements of this array must sum to this value (or integer
+  // expression, e.g., "S"). If the elements are simple enough (e.g.,
+  // `MInteger().Between(1, "C")`), the array is generated directly in linear
+  // time. Otherwise, arrays are generated until one has the right sum.
+  MArray& WithSum(int64_t sum)
+    requires std::same_as<MElementType, MInteger>;
+  MArray& WithSum(absl::string_view sum_expression)
+    requires std::same_as<MElementType, MInteger>;
+  MArray& WithSum(const MInteger& sum)
+    requires std::same_as<MElementType, MInteger>;
+
+  // WithTotalLength()
+  //
+  // States that the lengths of the strings in this array must sum to this value
+  // (or integer expression, e.g., "S"). If the strings are simple enough (e.g.,
+  // `MString().WithAlphabet("ab").OfLength(1, 10)`), the total length is split
+  // between them first (respecting their lengths), so the array is generated
+  // directly in linear time. Otherwise, arrays are generated until one has the
+  // right total length.
+  MArray& WithTotalLength(int64_t total_length)
+    requires std::same_as<element_value_type, std::string>;
+  MArray& WithTotalLength(absl::string_view total_length_expression)
+    requires std::same_as<element_value_type, std::string>;
+  MArray& WithTotalLength(const MInteger& total_length)
+    requires std::same_as<element_value_type, std::string>;
+
   // OfSizeProperty()
   //
   // Tells this string to have a specific size. `property.category` must
@@ -152,6 +240,11 @@ class MArray : public librarian::MVariable<
   MElementType element_constraints_;
   std::optional<MInteger> length_;
   bool distinct_elements_ = false;
+  bool unordered_map_collisions_ = false;
+  std::optional<ElementOrder> order_;
+  std::optional<Permutation> permutation_;
+  std::optional<MInteger> sum_;
+  std::optional<MInteger> total_length_;
   std::optional<Whitespace> separator_;
   Whitespace GetSeparator() const;
 
@@ -160,15 +253,40 @@ class MArray : public librarian::MVariable<
   // GenerateNDistinctImpl()
   //
   // Same as GenerateImpl(), but guarantees that all elements are distinct.
-  absl::StatusOr<vector_value_type> GenerateNDistinctImpl(int n);
+  absl::StatusOr<vector_value_type> GenerateNDistinctImpl(
+      const MElementType& elements, int n);
+
+  // GenerateElements()
+  //
+  // Generates `length` elements from `elements`, with no order or distinctness
+  // requirements. `generation_limit` is the array's generation limit. If `sum`
+  // is set, the elements are generated with that sum (for strings, that total
+  // length) if possible.
+  absl::StatusOr<vector_value_type> GenerateElements(
+      const MElementType& elements, int length,
+      std::optional<int64_t> generation_limit, std::optional<int64_t> sum);
+
+  // GenerateOrderedImpl()
+  //
+  // Same as GenerateImpl(), but the elements are in `order_`.
+  absl::StatusOr<vector_value_type> GenerateOrderedImpl(
+      const MElementType& elements, int length,
+      std::optional<int64_t> generation_limit, std::optional<int64_t> sum);
+
+  // GeneratePermutationImpl()
+  //
+  // Same as GenerateImpl(), but the elements are the permutation in
+  // `permutation_`. The element constraints are not used.
+  absl::StatusOr<vector_value_type> GeneratePermutationImpl(int length);
 
   // GenerateUnseenElement()
   //
-  // Returns a element that is not in `seen`. `remaining_retries` is the maximum
-  // number of times `Generate()` may be called. This function updates
-  // `remaining_retries`.
+  // Returns a element from `elements` that is not in `seen`.
+  // `remaining_retries` is the maximum number of times `Generate()` may be
+  // called. This function updates `remaining_retries`.
   absl::StatusOr<element_value_type> GenerateUnseenElement(
-      const absl::flat_hash_set<element_value_type>& seen,
+      const MElementType& elements,
+      const moriarty_internal::DistinctIndexSet<element_value_type>& seen,
       int& remaining_retries, int index);
 
   // GetNumberOfRetriesForDistinctElements()
@@ -178,17 +296,30 @@ class MArray : public librarian::MVariable<
   // may change over time, but is aimed at <1% failure rate at the moment.
   static int GetNumberOfRetriesForDistinctElements(int n);
 
+  // The parts of `IsSatisfiedWithImpl()` that check the length and the sum (or
+  // total length) of the elements.
+  absl::Status IsSatisfiedWithLength(const vector_value_type& value) const;
+  absl::Status IsSatisfiedWithSum(const vector_value_type& value) const;
+
   // ---------------------------------------------------------------------------
   //  MVariable overrides
   absl::StatusOr<vector_value_type> GenerateImpl() override;
   absl::Status IsSatisfiedWithImpl(
       const vector_value_type& value) const override;
+  absl::Status IsSatisfiedWithGeneratedImpl(
+      const vector_value_type& value) const override;
   absl::Status MergeFromImpl(const MArray<MElementType>& other) override;
   absl::StatusOr<vector_value_type> ReadImpl() override;
   absl::Status PrintImpl(const vector_value_type& value) override;
   std::vector<std::string> GetDependenciesImpl() const override;
   absl::StatusOr<std::vector<MArray<MElementType>>> GetDifficultInstancesImpl()
       const override;
+  // Only removes elements. The elements themselves are not shrunk.
+  std::optional<vector_value_type> ShrinkImpl(const vector_value_type& value,
+                                              int level,
+                                              int64_t index) const override;
+  bool IsKnownUnsatisfiableImpl() const override;
+  std::string ToStringImpl() const override;
   // ---------------------------------------------------------------------------
 };
 
@@ -334,6 +465,49 @@ MArray<MElementType>& MArray<MElementType>::OfLength(
       MInteger().Between(min_length_expression, max_length_expression));
 }
 
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::AddConstraint(
+    const ElementOrder& constraint)
+  requires std::totally_ordered<element_value_type>
+{
+  if (order_.has_value() && *order_ != constraint) {
+    this->DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        "Attempting to set multiple element orders for the same MArray."));
+  } else {
+    order_ = constraint;
+  }
+  return *this;
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::AddConstraint(const Sum& constraint)
+  requires std::same_as<MElementType, MInteger>
+{
+  return WithSum(constraint.GetConstraints());
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::AddConstraint(
+    const Permutation& constraint)
+  requires std::same_as<MElementType, MInteger>
+{
+  if (permutation_.has_value() && *permutation_ != constraint) {
+    this->DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        "Attempting to set multiple permutations for the same MArray."));
+  } else {
+    permutation_ = constraint;
+  }
+  return *this;
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::AddConstraint(
+    const TotalLength& constraint)
+  requires std::same_as<element_value_type, std::string>
+{
+  return WithTotalLength(constraint.GetConstraints());
+}
+
 template <typename MElementType>
 MArray<MElementType>& MArray<MElementType>::WithDistinctElements() {
   distinct_elements_ = true;
@@ -347,6 +521,75 @@ MArray<MElementType>& MArray<MElementType>::WithDistinctElementsWithArg(
   return *this;
 }
 
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithElementOrder(ElementOrder order)
+  requires std::totally_ordered<element_value_type>
+{
+  return AddConstraint(order);
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithSum(int64_t sum)
+  requires std::same_as<MElementType, MInteger>
+{
+  return WithSum(MInteger().Is(sum));
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithSum(
+    absl::string_view sum_expression)
+  requires std::same_as<MElementType, MInteger>
+{
+  return WithSum(MInteger().Is(sum_expression));
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithSum(const MInteger& sum)
+  requires std::same_as<MElementType, MInteger>
+{
+  if (sum_)
+    sum_->MergeFrom(sum);
+  else
+    sum_ = sum;
+  return *this;
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithTotalLength(
+    int64_t total_length)
+  requires std::same_as<element_value_type, std::string>
+{
+  return WithTotalLength(MInteger().Is(total_length));
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithTotalLength(
+    absl::string_view total_length_expression)
+  requires std::same_as<element_value_type, std::string>
+{
+  return WithTotalLength(MInteger().Is(total_length_expression));
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithTotalLength(
+    const MInteger& total_length)
+  requires std::same_as<element_value_type, std::string>
+{
+  if (total_length_)
+    total_length_->MergeFrom(total_length);
+  else
+    total_length_ = total_length;
+  return *this;
+}
+
+template <typename MElementType>
+MArray<MElementType>& MArray<MElementType>::WithUnorderedMapCollisions()
+  requires std::same_as<MElementType, MInteger>
+{
+  unordered_map_collisions_ = true;
+  return *this;
+}
+
 template <typename MElementType>
 MArray<MElementType>& MArray<MElementType>::WithSeparator(
     Whitespace separator) {
@@ -364,6 +607,17 @@ absl::Status MArray<MElementType>::MergeFromImpl(
     const MArray<MElementType>& other) {
   Of(other.element_constraints_);
   if (other.length_) OfLength(*other.length_);
+  if (other.unordered_map_collisions_) unordered_map_collisions_ = true;
+  if constexpr (std::totally_ordered<element_value_type>) {
+    if (other.order_) AddConstraint(*other.order_);
+  }
+  if constexpr (std::same_as<MElementType, MInteger>) {
+    if (other.sum_) WithSum(*other.sum_);
+    if (other.permutation_) AddConstraint(*other.permutation_);
+  }
+  if constexpr (std::same_as<element_value_type, std::string>) {
+    if (other.total_length_) WithTotalLength(*other.total_length_);
+  }
 
   return absl::OkStatus();
 }
@@ -389,42 +643,199 @@ auto MArray<MElementType>::GenerateImpl() -> absl::StatusOr<vector_value_type> {
   }
 
   MORIARTY_ASSIGN_OR_RETURN(int length, this->Random("length", *length_));
+  if (permutation_) return GeneratePermutationImpl(length);
+
+  // The bucket count depends on the length, so only this generation's copy of
+  // the element constraints is restricted.
+  std::optional<MElementType> colliding_elements;
+  if constexpr (std::same_as<MElementType, MInteger>) {
+    if (unordered_map_collisions_) {
+      colliding_elements = element_constraints_;
+      colliding_elements->AddConstraint(MultipleOf(
+          moriarty_internal::UnorderedMapBucketCount(std::max(length, 1))));
+    }
+  }
+  const MElementType& elements =
+      colliding_elements ? *colliding_elements : element_constraints_;
+
+  std::optional<int64_t> sum;
+  if (sum_) {
+    MORIARTY_ASSIGN_OR_RETURN(sum, this->Random("sum", *sum_));
+  }
+  if (total_length_) {
+    total_length_->AtLeast(0);
+    if (generation_limit) total_length_->AtMost(*generation_limit);
+    MORIARTY_ASSIGN_OR_RETURN(sum,
+                              this->Random("total_length", *total_length_));
+  }
+
+  if (order_) {
+    return GenerateOrderedImpl(elements, length, generation_limit, sum);
+  }
+  if (distinct_elements_) return GenerateNDistinctImpl(elements, length);
+  return GenerateElements(elements, length, generation_limit, sum);
+}
+
+template <typename MElementType>
+auto MArray<MElementType>::GenerateElements(
+    const MElementType& elements, int length,
+    std::optional<int64_t> generation_limit, std::optional<int64_t> sum)
+    -> absl::StatusOr<vector_value_type> {
+  // Otherwise, arrays are generated until one has the right sum.
+  if (sum) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::optional<vector_value_type> values,
+        this->RandomInBulkWithSum("elements", elements, length, *sum));
+    if (values) return *std::move(values);
+  }
 
-  if (distinct_elements_) return GenerateNDistinctImpl(length);
+  // The elements share the array's generation limit. Otherwise, each of them
+  // (e.g., each string in an array of strings) could be as large as the limit.
+  moriarty_internal::ScopedSoftGenerationLimit element_generation_limit =
+      this->LowerApproximateGenerationLimit(
+          generation_limit ? *generation_limit / std::max(length, 1) : 0);
+
+  // If the elements are simple enough, generate them all at once.
+  if (length > 0) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::optional<vector_value_type> bulk_values,
+        this->RandomInBulk("elements", elements, length));
+    if (bulk_values) return *std::move(bulk_values);
+  }
+
+  // Large arrays of independent elements are generated in chunks, possibly on
+  // several threads.
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::optional<vector_value_type> parallel_values,
+      this->RandomInParallel("elements", elements, length));
+  if (parallel_values) return *std::move(parallel_values);
 
   vector_value_type res;
   res.reserve(length);
 
+  // Reuse the same buffer for each element's name to avoid an allocation per
+  // element.
+  std::string element_name;
   for (int i = 0; i < length; i++) {
-    // `auto` is the type generated by element_constraints_
-    MORIARTY_ASSIGN_OR_RETURN(
-        auto value,
-        this->Random(absl::StrCat("element[", i, "]"), element_constraints_));
+    element_name.clear();
+    absl::StrAppend(&element_name, "element[", i, "]");
+    // `auto` is the type generated by elements
+    MORIARTY_ASSIGN_OR_RETURN(auto value, this->Random(element_name, elements));
     res.push_back(std::move(value));
   }
 
   return res;
 }
 
+template <typename MElementType>
+auto MArray<MElementType>::GenerateOrderedImpl(
+    const MElementType& elements, int length,
+    std::optional<int64_t> generation_limit, std::optional<int64_t> sum)
+    -> absl::StatusOr<vector_value_type> {
+  if constexpr (!std::totally_ordered<element_value_type>) {
+    return absl::InternalError("Only ordered elements can have an order.");
+  } else {
+    const ElementOrder::Kind kind = order_->GetKind();
+    const bool strictly_increasing =
+        kind == ElementOrder::Kind::kStrictlyIncreasing || distinct_elements_;
+
+    // Values generated in order do not have a given sum.
+    std::optional<vector_value_type> values;
+    if (length > 0 && !sum) {
+      MORIARTY_ASSIGN_OR_RETURN(
+          values, this->RandomSortedInBulk("elements", elements, length,
+                                           strictly_increasing));
+    }
+    if (!values) {
+      // The elements cannot be generated in order, so sort them instead.
+      MORIARTY_ASSIGN_OR_RETURN(
+          values, strictly_increasing
+                      ? GenerateNDistinctImpl(elements, length)
+                      : GenerateElements(elements, length, generation_limit,
+                                         sum));
+      std::sort(values->begin(), values->end());
+    }
+
+    if (kind == ElementOrder::Kind::kReversed)
+      std::reverse(values->begin(), values->end());
+    if (kind == ElementOrder::Kind::kNearlySorted && length > 1 &&
+        order_->GetSwaps() > 0) {
+      // More swaps than elements already gives a random-looking order.
+      int num_swaps = std::min<int64_t>(order_->GetSwaps(), length);
+      MORIARTY_ASSIGN_OR_RETURN(
+          std::optional<std::vector<int64_t>> positions,
+          this->RandomInBulk("swaps", MInteger().Between(0, length - 1),
+                             2 * num_swaps));
+      if (!positions) {
+        return absl::InternalError(
+            "Unable to generate the positions of the swaps.");
+      }
+      for (int i = 0; i < num_swaps; i++) {
+        using std::swap;
+        swap((*values)[(*positions)[2 * i]],
+             (*values)[(*positions)[2 * i + 1]]);
+      }
+    }
+    return *std::move(values);
+  }
+}
+
+template <typename MElementType>
+auto MArray<MElementType>::GeneratePermutationImpl(int length)
+    -> absl::StatusOr<vector_value_type> {
+  if constexpr (!std::same_as<MElementType, MInteger>) {
+    return absl::InternalError("Only arrays of integers can be permutations.");
+  } else {
+    // MArray needs direct access to its RandomEngine to generate the
+    // permutation in linear time.
+    moriarty_internal::RandomEngine& rng =
+        moriarty_internal::MVariableManager(this).GetRandomEngine();
+    const int64_t first = permutation_->GetFirst();
+    switch (permutation_->GetKind()) {
+      case Permutation::Kind::kAny:
+        return moriarty_internal::RandomPermutation(rng, length, first);
+      case Permutation::Kind::kSingleCycle:
+        return moriarty_internal::RandomCyclicPermutation(rng, length, first);
+      case Permutation::Kind::kDerangement:
+        return moriarty_internal::RandomDerangement(rng, length, first);
+      case Permutation::Kind::kCycles:
+        return moriarty_internal::RandomPermutationWithCycles(
+            rng, length, permutation_->GetCycles(), first);
+      case Permutation::Kind::kInvolution:
+        return moriarty_internal::RandomInvolution(rng, length, first);
+    }
+    return absl::InternalError("Unknown kind of permutation.");
+  }
+}
+
 template <typename MElementType>
 Whitespace MArray<MElementType>::GetSeparator() const {
   return separator_.value_or(Whitespace::kSpace);
 }
 
 template <typename MElementType>
-auto MArray<MElementType>::GenerateNDistinctImpl(int n)
+auto MArray<MElementType>::GenerateNDistinctImpl(const MElementType& elements,
+                                                 int n)
     -> absl::StatusOr<vector_value_type> {
+  if (n > 0) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::optional<vector_value_type> bulk_values,
+        this->RandomDistinctInBulk("elements", elements, n));
+    if (bulk_values) return *std::move(bulk_values);
+  }
+
   vector_value_type res;  // Do not res.reserve(n) in case n is massive.
 
-  absl::flat_hash_set<element_value_type> values_seen;
+  // The elements are only stored once, in `res`.
+  moriarty_internal::DistinctIndexSet<element_value_type> values_seen(res);
   int remaining_retries = GetNumberOfRetriesForDistinctElements(n);
 
   for (int i = 0; i < n && remaining_retries > 0; i++) {
     MORIARTY_ASSIGN_OR_RETURN(
         element_value_type value,
-        GenerateUnseenElement(values_seen, remaining_retries, i));
-    values_seen.insert(value);
+        GenerateUnseenElement(elements, values_seen, remaining_retries, i));
     res.push_back(std::move(value));
+    values_seen.Insert(res.size() - 1);
   }
 
   return res;
@@ -432,13 +843,14 @@ auto MArray<MElementType>::GenerateNDistinctImpl(int n)
 
 template <typename MElementType>
 auto MArray<MElementType>::GenerateUnseenElement(
-    const absl::flat_hash_set<element_value_type>& seen, int& remaining_retries,
-    int index) -> absl::StatusOr<element_value_type> {
+    const MElementType& elements,
+    const moriarty_internal::DistinctIndexSet<element_value_type>& seen,
+    int& remaining_retries, int index) -> absl::StatusOr<element_value_type> {
+  std::string element_name = absl::StrCat("element[", index, "]");
   for (; remaining_retries > 0; remaining_retries--) {
     MORIARTY_ASSIGN_OR_RETURN(element_value_type value,
-                              this->Random(absl::StrCat("element[", index, "]"),
-                                           element_constraints_));
-    if (!seen.contains(value)) return value;
+                              this->Random(element_name, elements));
+    if (!seen.Contains(value)) return value;
   }
 
   return absl::FailedPreconditionError(
@@ -463,6 +875,33 @@ int MArray<MElementType>::GetNumberOfRetriesForDistinctElements(int n) {
   return n * H_n + 14 * n;
 }
 
+template <typename MElementType>
+std::string MArray<MElementType>::ToStringImpl() const {
+  std::string result =
+      absl::StrCat("elements: (", element_constraints_.ToString(), "); ");
+  if (length_)
+    absl::StrAppend(&result, "length: (", length_->ToString(), "); ");
+  if (distinct_elements_) absl::StrAppend(&result, "Only distinct elements; ");
+  if (unordered_map_collisions_)
+    absl::StrAppend(&result, "Elements collide in std::unordered_map; ");
+  if (order_) absl::StrAppend(&result, "order: ", order_->ToString(), "; ");
+  if (permutation_) absl::StrAppend(&result, permutation_->ToString(), "; ");
+  if (sum_) absl::StrAppend(&result, "sum: (", sum_->ToString(), "); ");
+  if (total_length_) {
+    absl::StrAppend(&result, "total length: (", total_length_->ToString(),
+                    "); ");
+  }
+  if (separator_) {
+    absl::StrAppend(&result, "separator: ",
+                    librarian::WhitespaceName(*separator_), "; ");
+  }
+  if (length_size_property_.has_value()) {
+    absl::StrAppend(&result, "length: ", length_size_property_->ToString(),
+                    "; ");
+  }
+  return result;
+}
+
 template <typename MElementType>
 absl::Status MArray<MElementType>::OfSizeProperty(Property property) {
   length_size_property_ = std::move(property);
@@ -474,20 +913,29 @@ std::vector<std::string> MArray<MElementType>::GetDependenciesImpl() const {
   std::vector<std::string> deps = this->GetDependencies(element_constraints_);
   if (length_)
     absl::c_move(this->GetDependencies(*length_), std::back_inserter(deps));
+  if (sum_)
+    absl::c_move(this->GetDependencies(*sum_), std::back_inserter(deps));
+  if (total_length_) {
+    absl::c_move(this->GetDependencies(*total_length_),
+                 std::back_inserter(deps));
+  }
   return deps;
 }
 
 template <typename MoriartyElementType>
 absl::Status MArray<MoriartyElementType>::PrintImpl(
     const vector_value_type& value) {
+  std::string element_name;
   for (int i = 0; i < value.size(); i++) {
     if (i > 0) {
       MORIARTY_ASSIGN_OR_RETURN(librarian::IOConfig * io_config,
                                 this->GetIOConfig());
       MORIARTY_RETURN_IF_ERROR(io_config->PrintWhitespace(GetSeparator()));
     }
-    MORIARTY_RETURN_IF_ERROR(this->Print(absl::StrCat("element[", i, "]"),
-                                         element_constraints_, value[i]));
+    element_name.clear();
+    absl::StrAppend(&element_name, "element[", i, "]");
+    MORIARTY_RETURN_IF_ERROR(
+        this->Print(element_name, element_constraints_, value[i]));
   }
   return absl::OkStatus();
 }
@@ -509,14 +957,23 @@ MArray<MoriartyElementType>::ReadImpl() {
   MORIARTY_ASSIGN_OR_RETURN(librarian::IOConfig * io_config,
                             this->GetIOConfig());
   vector_value_type res;
+  // Integers are read directly, the whole array at once.
+  if constexpr (std::same_as<MoriartyElementType, MInteger>) {
+    res.resize(std::max<int64_t>(*length, 0));
+    MORIARTY_RETURN_IF_ERROR(
+        io_config->ReadIntegers(absl::MakeSpan(res), GetSeparator()));
+    return res;
+  }
   res.reserve(*length);
+  std::string element_name;
   for (int i = 0; i < *length; i++) {
     if (i > 0) {
       MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(GetSeparator()));
     }
-    MORIARTY_ASSIGN_OR_RETURN(
-        element_value_type elem,
-        this->Read(absl::StrCat("element[", i, "]"), element_constraints_));
+    element_name.clear();
+    absl::StrAppend(&element_name, "element[", i, "]");
+    MORIARTY_ASSIGN_OR_RETURN(element_value_type elem,
+                              this->Read(element_name, element_constraints_));
     res.push_back(std::move(elem));
   }
   return res;
@@ -525,33 +982,169 @@ MArray<MoriartyElementType>::ReadImpl() {
 template <typename MoriartyElementType>
 absl::Status MArray<MoriartyElementType>::IsSatisfiedWithImpl(
     const vector_value_type& value) const {
-  if (length_) {
-    MORIARTY_RETURN_IF_ERROR(
-        CheckConstraint(this->SatisfiesConstraints(*length_, value.size()),
-                        "invalid MArray length"));
-  }
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithLength(value));
 
-  for (int i = 0; i < value.size(); i++) {
+  // Huge arrays are checked in chunks on several threads, if possible. Only
+  // the first invalid element is checked again to get its error.
+  if (std::optional<int64_t> invalid =
+          this->FindFirstUnsatisfied(element_constraints_, value)) {
     MORIARTY_RETURN_IF_ERROR(CheckConstraint(
-        this->SatisfiesConstraints(element_constraints_, value[i]),
-        absl::Substitute("invalid element $0 (0-based)", i)));
+        this->SatisfiesConstraints(element_constraints_, value[*invalid]),
+        absl::Substitute("invalid element $0 (0-based)", *invalid)));
   }
 
   if (distinct_elements_) {
-    absl::flat_hash_set<element_value_type> seen;
-    int idx = 0;
-    for (const element_value_type& x : value) {
-      auto [it, inserted] = seen.insert(x);
+    if constexpr (std::is_same_v<element_value_type, int64_t>) {
+      // Integers are checked without hashing (via a bitmap or sorting).
+      std::optional<size_t> duplicate =
+          moriarty_internal::FindFirstDuplicateInteger(value);
+      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+          !duplicate.has_value(),
+          absl::Substitute("elements are not distinct. Element at "
+                           "index $0 appears multiple times.",
+                           duplicate.value_or(0))));
+    } else if (moriarty_internal::Scheduler* scheduler = this->GetScheduler();
+               scheduler != nullptr && scheduler->NumThreads() > 1 &&
+               value.size() >
+                   moriarty_internal::Universe::kParallelValidationChunkSize) {
+      std::optional<size_t> duplicate =
+          moriarty_internal::FindFirstDuplicateInParallel<element_value_type>(
+              value, *scheduler);
+      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+          !duplicate.has_value(),
+          absl::Substitute("elements are not distinct. Element at "
+                           "index $0 appears multiple times.",
+                           duplicate.value_or(0))));
+    } else {
+      moriarty_internal::DistinctIndexSet<element_value_type> seen(value);
+      for (int idx = 0; idx < value.size(); idx++) {
+        MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+            seen.Insert(idx),
+            absl::Substitute("elements are not distinct. Element at "
+                             "index $0 appears multiple times.",
+                             idx)));
+      }
+    }
+  }
+
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithSum(value));
+
+  if constexpr (std::totally_ordered<element_value_type>) {
+    if (order_ && order_->GetKind() != ElementOrder::Kind::kNearlySorted) {
+      // A single pass comparing neighbours.
+      for (int i = 1; i < value.size(); i++) {
+        bool in_order = true;
+        switch (order_->GetKind()) {
+          case ElementOrder::Kind::kSorted:
+            in_order = !(value[i] < value[i - 1]);
+            break;
+          case ElementOrder::Kind::kStrictlyIncreasing:
+            in_order = value[i - 1] < value[i];
+            break;
+          case ElementOrder::Kind::kReversed:
+            in_order = !(value[i - 1] < value[i]);
+            break;
+          case ElementOrder::Kind::kNearlySorted:
+            break;
+        }
+        MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+            in_order,
+            absl::Substitute("elements at indices $0 and $1 are not in the "
+                             "order $2",
+                             i - 1, i, order_->ToString())));
+      }
+    }
+  }
+
+  if constexpr (std::same_as<MoriartyElementType, MInteger>) {
+    if (permutation_) {
+      const int64_t first = permutation_->GetFirst();
+      bool valid = false;
+      switch (permutation_->GetKind()) {
+        case Permutation::Kind::kAny:
+          valid = moriarty_internal::IsPermutation(value, first);
+          break;
+        case Permutation::Kind::kSingleCycle:
+          valid = value.empty() ||
+                  moriarty_internal::CountPermutationCycles(value, first) == 1;
+          break;
+        case Permutation::Kind::kDerangement:
+          valid = moriarty_internal::IsDerangement(value, first);
+          break;
+        case Permutation::Kind::kCycles:
+          valid = moriarty_internal::CountPermutationCycles(value, first) ==
+                  permutation_->GetCycles();
+          break;
+        case Permutation::Kind::kInvolution:
+          valid = moriarty_internal::IsInvolution(value, first);
+          break;
+      }
       MORIARTY_RETURN_IF_ERROR(CheckConstraint(
-          inserted, absl::Substitute("elements are not distinct. Element at "
-                                     "index $0 appears multiple times.",
-                                     idx)));
-      idx++;
+          valid, absl::StrCat("elements are not a ",
+                              permutation_->ToString())));
     }
   }
 
   return absl::OkStatus();
 }
+
+template <typename MoriartyElementType>
+absl::Status MArray<MoriartyElementType>::IsSatisfiedWithGeneratedImpl(
+    const vector_value_type& value) const {
+  // `GenerateImpl()` generates (and checks) each element with the element
+  // constraints, and makes them distinct and ordered as needed. Only the length
+  // (distinct elements may run out of retries) and the sum (arrays are
+  // regenerated until the sum is right) are not guaranteed. Permutations are
+  // generated without the element constraints, so they are checked in full.
+  if constexpr (std::same_as<MoriartyElementType, MInteger>) {
+    if (permutation_) return IsSatisfiedWithImpl(value);
+  }
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithLength(value));
+  return IsSatisfiedWithSum(value);
+}
+
+template <typename MoriartyElementType>
+absl::Status MArray<MoriartyElementType>::IsSatisfiedWithLength(
+    const vector_value_type& value) const {
+  if (!length_) return absl::OkStatus();
+  return CheckConstraint(this->SatisfiesConstraints(*length_, value.size()),
+                         "invalid MArray length");
+}
+
+template <typename MoriartyElementType>
+absl::Status MArray<MoriartyElementType>::IsSatisfiedWithSum(
+    const vector_value_type& value) const {
+  if constexpr (std::same_as<MoriartyElementType, MInteger>) {
+    if (sum_) {
+      absl::int128 sum = 0;
+      for (int64_t x : value) sum += x;
+      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+          sum >= std::numeric_limits<int64_t>::min() &&
+              sum <= std::numeric_limits<int64_t>::max(),
+          "the sum of the elements does not fit in 64 bits"));
+      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+          this->SatisfiesConstraints(*sum_, static_cast<int64_t>(sum)),
+          "invalid sum of the elements"));
+    }
+  }
+  if constexpr (std::same_as<element_value_type, std::string>) {
+    if (total_length_) {
+      int64_t total_length = 0;
+      for (const std::string& x : value) total_length += x.size();
+      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+          this->SatisfiesConstraints(*total_length_, total_length),
+          "invalid total length of the elements"));
+    }
+  }
+  return absl::OkStatus();
+}
+template <typename MoriartyElementType>
+std::optional<typename MArray<MoriartyElementType>::vector_value_type>
+MArray<MoriartyElementType>::ShrinkImpl(const vector_value_type& value,
+                                        int level, int64_t index) const {
+  return moriarty_internal::RemoveChunk(value, level, index);
+}
+
 template <typename MoriartyElementType>
 absl::StatusOr<std::vector<MArray<MoriartyElementType>>>
 MArray<MoriartyElementType>::GetDifficultInstancesImpl() const {
@@ -573,6 +1166,14 @@ MArray<MoriartyElementType>::GetDifficultInstancesImpl() const {
   return cases;
 };
 
+template <typename MoriartyElementType>
+bool MArray<MoriartyElementType>::IsKnownUnsatisfiableImpl() const {
+  if (!length_) return false;
+  MInteger length = *length_;
+  length.AtLeast(0);  // As in GenerateImpl().
+  return this->IsKnownUnsatisfiable("length", length);
+}
+
 }  // namespace moriarty
 
 #endif  // MORIARTY_SRC_VARIABLES_MARRAY_H_
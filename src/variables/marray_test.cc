@@ -14,22 +14,42 @@
 
 #include "src/variables/marray.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/log/absl_check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "src/internal/generation_bootstrap.h"
+#include "src/internal/generation_config.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/scheduler.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
 #include "src/librarian/io_config.h"
 #include "src/librarian/mvariable.h"
+#include "src/librarian/size_property.h"
 #include "src/librarian/test_utils.h"
 #include "src/util/test_status_macro/status_testutil.h"
 #include "src/variables/constraints/base_constraints.h"
 #include "src/variables/constraints/container_constraints.h"
 #include "src/variables/constraints/io_constraints.h"
 #include "src/variables/constraints/numeric_constraints.h"
+#include "src/variables/constraints/string_constraints.h"
 #include "src/variables/minteger.h"
 #include "src/variables/mstring.h"
 #include "src/variables/mtuple.h"
@@ -48,17 +68,23 @@ using ::moriarty_testing::IsSatisfiedWith;
 using ::moriarty_testing::Print;
 using ::moriarty_testing::Read;
 using ::testing::AllOf;
+using ::testing::AnyOf;
 using ::testing::Each;
 using ::testing::ElementsAre;
 using ::testing::Eq;
+using ::testing::FieldsAre;
 using ::testing::Ge;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::IsSupersetOf;
 using ::testing::Le;
+using ::testing::MatchesRegex;
 using ::testing::Not;
+using ::testing::ResultOf;
 using ::testing::SizeIs;
+using ::testing::Truly;
 using ::testing::UnorderedElementsAre;
+using ::moriarty::IsOk;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 
@@ -73,6 +99,22 @@ TEST(MArrayTest, TypenameIsCorrect) {
       "MArray<MTuple<MInteger, MTuple<MInteger, MInteger>>>");
 }
 
+TEST(MArrayTest, ToStringIncludesElementAndLengthConstraints) {
+  std::string str = MArray(MInteger().Between(1, 10))
+                        .OfLength(3, 5)
+                        .WithDistinctElements()
+                        .ToString();
+  EXPECT_THAT(str, HasSubstr("MArray<MInteger>"));
+  EXPECT_THAT(str, HasSubstr("[1, 10]"));
+  EXPECT_THAT(str, HasSubstr("[3, 5]"));
+  EXPECT_THAT(str, HasSubstr("distinct"));
+}
+
+TEST(MArrayTest, ToStringDistinguishesIsValues) {
+  EXPECT_NE(MArray(MInteger()).Is({1, 2}).ToString(),
+            MArray(MInteger()).Is({1, 3}).ToString());
+}
+
 TEST(MArrayTest, PrintShouldSucceed) {
   EXPECT_THAT(Print(MArray(MInteger()), {1, 2, 3}), IsOkAndHolds("1 2 3"));
 }
@@ -127,6 +169,40 @@ TEST(MArrayTest, NestedMArrayWorks) {
   }
 }
 
+TEST(MArrayTest, GenerateOfNestedMArrayStillChecksCustomConstraints) {
+  auto is_sorted = [](const std::vector<int64_t>& v) {
+    return absl::c_is_sorted(v);
+  };
+  auto starts_small = [](const std::vector<std::vector<int64_t>>& v) {
+    return v[0][0] <= 5;
+  };
+
+  EXPECT_THAT(
+      Generate(NestedMArray(MArray(MInteger().Between(1, 10))
+                                .OfLength(3)
+                                .AddCustomConstraint("Sorted", is_sorted))
+                   .OfLength(5)
+                   .AddCustomConstraint("StartsSmall", starts_small)),
+      IsOkAndHolds(AllOf(SizeIs(5), Each(Truly(is_sorted)),
+                         Truly(starts_small))));
+}
+
+TEST(MArrayTest, RetryingACustomConstraintKeepsTheGeneratedLength) {
+  std::vector<size_t> sizes;
+  auto fails_three_times = [&sizes](const std::vector<int64_t>& v) {
+    sizes.push_back(v.size());
+    return sizes.size() > 3;
+  };
+
+  MORIARTY_ASSERT_OK(
+      Generate(MArray(MInteger()).OfLength("N").AddCustomConstraint(
+                   "FailsThreeTimes", fails_three_times),
+               Context().WithVariable("N", MInteger().Between(1, 1000))));
+  ASSERT_GE(sizes.size(), 4);
+  // `N` is only generated once. The array is retried with the same length.
+  EXPECT_THAT(sizes, Each(sizes[0]));
+}
+
 TEST(MArrayTest, GenerateShouldSuccessfullyComplete) {
   MORIARTY_EXPECT_OK(Generate(MArray<MInteger>(MInteger()).OfLength(4, 10)));
   MORIARTY_EXPECT_OK(Generate(MArray(MInteger()).OfLength(4, 10)));
@@ -242,6 +318,24 @@ TEST(MArrayTest, SatisfiesConstraintsChecksMArrayContentsProperly) {
                                  "element 2"));
 }
 
+TEST(MArrayTest, SatisfiesConstraintsChecksLargeMArraysOfIntegers) {
+  std::vector<int64_t> values(100000);
+  for (int i = 0; i < values.size(); i++) values[i] = 1 + i % 10;
+  EXPECT_THAT(MArray(MInteger().Between(1, 10)), IsSatisfiedWith(values));
+
+  values[98765] = 11;
+  EXPECT_THAT(MArray(MInteger().Between(1, 10)),
+              IsNotSatisfiedWith(values, "element 98765"));
+}
+
+TEST(MArrayTest, SatisfiesConstraintsChecksEachElementWithIsOneOf) {
+  EXPECT_THAT(MArray(MInteger().Between(1, 10).IsOneOf({2, 4})),
+              IsSatisfiedWith(std::vector<int64_t>({2, 4, 4, 2})));
+  EXPECT_THAT(MArray(MInteger().Between(1, 10).IsOneOf({2, 4})),
+              IsNotSatisfiedWith(std::vector<int64_t>({2, 4, 3, 2}),
+                                 "element 2"));
+}
+
 TEST(MArrayTest, SatisfiesConstraintsChecksMArraySizeWhenItIsVariable) {
   EXPECT_THAT(MArray(MInteger()).OfLength("N"),
               IsSatisfiedWith(std::vector<int64_t>({10, 20, 30}),
@@ -320,6 +414,31 @@ TEST(MArrayTest, SatisfiesConstraintsShouldCheckForDistinctElements) {
       IsNotSatisfiedWith(std::vector<int64_t>({1, 2, 2}), "distinct"));
 }
 
+TEST(MArrayTest, SatisfiesConstraintsShouldCheckForDistinctLargeIntegers) {
+  EXPECT_THAT(MArray(MInteger()).WithDistinctElements(),
+              IsSatisfiedWith(std::vector<int64_t>(
+                  {std::numeric_limits<int64_t>::max(), 0,
+                   std::numeric_limits<int64_t>::min()})));
+  EXPECT_THAT(
+      MArray(MInteger()).WithDistinctElements(),
+      IsNotSatisfiedWith(std::vector<int64_t>({-1000000000000, 5, 123456789,
+                                               5, -1000000000000}),
+                         "index 3"));
+}
+
+TEST(MArrayTest, SatisfiesConstraintsShouldCheckForDistinctPermutations) {
+  std::vector<int64_t> permutation(100000);
+  for (int i = 0; i < permutation.size(); i++) {
+    permutation[i] = permutation.size() - i;
+  }
+  EXPECT_THAT(MArray(MInteger().Between(1, 100000)).WithDistinctElements(),
+              IsSatisfiedWith(permutation));
+
+  permutation[54321] = permutation[12345];
+  EXPECT_THAT(MArray(MInteger().Between(1, 100000)).WithDistinctElements(),
+              IsNotSatisfiedWith(permutation, "index 54321"));
+}
+
 TEST(MArrayTest, SatisfiesConstraintsShouldCheckForDistinctElementsWithArg) {
   EXPECT_THAT(MArray(MInteger().Between(1, 5))
                   .WithDistinctElementsWithArg()
@@ -350,6 +469,243 @@ TEST(MArrayTest, AllOverloadsForOfLengthProduceTheSameSequenceOfData) {
        MArray(MInteger()).OfLength("1", "9")}));
 }
 
+// Unwraps the values from a vector of std::tuple<int64_t>.
+std::vector<int64_t> Unwrap(const std::vector<std::tuple<int64_t>>& values) {
+  std::vector<int64_t> result;
+  for (const auto& [x] : values) result.push_back(x);
+  return result;
+}
+
+TEST(MArrayTest, SimpleIntegerElementsGenerateTheSameValuesInBulk) {
+  // MTuple elements are generated one at a time, and each of them makes the
+  // same calls to the RandomEngine as a single MInteger.
+  EXPECT_THAT(
+      Generate(MArray(MInteger().Between(1, 1000000)).OfLength(1000)),
+      IsOkAndHolds(Unwrap(
+          *Generate(MArray(MTuple(MInteger().Between(1, 1000000))).OfLength(
+              1000)))));
+  EXPECT_THAT(
+      Generate(MArray(MInteger().Between(-5, 5)).OfLength(1, 100)),
+      IsOkAndHolds(Unwrap(*Generate(
+          MArray(MTuple(MInteger().Between(-5, 5))).OfLength(1, 100)))));
+  EXPECT_THAT(Generate(MArray(MInteger()).OfLength(50)),
+              IsOkAndHolds(Unwrap(
+                  *Generate(MArray(MTuple(MInteger())).OfLength(50)))));
+}
+
+TEST(MArrayTest, SimpleStringElementsGenerateTheSameValuesInBulk) {
+  // A custom constraint forces each string through `Random()`.
+  auto always = [](const std::string&) { return true; };
+  EXPECT_TRUE(GenerateSameValues(
+      MArray(MString().WithAlphabet("abc").OfLength(0, 10)).OfLength(100),
+      MArray(MString()
+                 .WithAlphabet("abc")
+                 .OfLength(0, 10)
+                 .AddCustomConstraint("any", always))
+          .OfLength(100)));
+}
+
+// Returns the `I`-th component of each tuple in `values`.
+template <std::size_t I, typename... T>
+auto Column(const std::vector<std::tuple<T...>>& values) {
+  std::vector<std::tuple_element_t<I, std::tuple<T...>>> result;
+  for (const std::tuple<T...>& value : values)
+    result.push_back(std::get<I>(value));
+  return result;
+}
+
+// Generates a value for `variable` with the RandomEngine `version`.
+template <typename T>
+typename T::value_type GenerateWithEngine(T variable,
+                                          absl::string_view version) {
+  moriarty_internal::VariableSet variables;
+  ABSL_CHECK_OK(variables.AddVariable("A", variable));
+  moriarty_internal::RandomEngine rng({1, 2, 3}, version);
+  absl::StatusOr<moriarty_internal::ValueSet> values =
+      moriarty_internal::GenerateAllValues(variables, /* known_values = */ {},
+                                           {.random_engine = rng});
+  ABSL_CHECK_OK(values);
+  return *values->Get<T>("A");
+}
+
+TEST(MArrayTest, TupleElementsAreGeneratedOneColumnAtATime) {
+  auto values = GenerateWithEngine(
+      MArray(MTuple(MInteger().Between(1, 1000000), MInteger().Between(-5, 5)))
+          .OfLength(1000),
+      moriarty_internal::kCounterBasedVersion);
+
+  // The first column uses the same random numbers as an array of integers.
+  EXPECT_EQ(
+      GenerateWithEngine(MArray(MInteger().Between(1, 1000000)).OfLength(1000),
+                         moriarty_internal::kCounterBasedVersion),
+      Column<0>(values));
+  EXPECT_THAT(Column<1>(values), Each(AllOf(Ge(-5), Le(5))));
+}
+
+TEST(MArrayTest, TupleElementsMatchOneAtATimeWithTheMersenneTwister) {
+  // A custom constraint forces each tuple through `Random()`, so this checks
+  // that generating tuples in bulk uses the RandomEngine the same way as
+  // generating them one at a time.
+  using Tuple = std::tuple<int64_t, std::string>;
+  auto always = [](const Tuple&) { return true; };
+  auto elements = [] {
+    return MTuple(MInteger().Between(1, 1000000),
+                  MString().WithAlphabet("abc").OfLength(0, 10));
+  };
+  EXPECT_EQ(GenerateWithEngine(MArray(elements()).OfLength(100),
+                               moriarty_internal::kMersenneTwisterVersion),
+            GenerateWithEngine(
+                MArray(elements().AddCustomConstraint("any", always))
+                    .OfLength(100),
+                moriarty_internal::kMersenneTwisterVersion));
+}
+
+TEST(MArrayTest, TupleElementsNotSuitableForBulkGenerationStillWork) {
+  EXPECT_THAT(
+      Generate(MArray(MTuple(MInteger().Between(1, 10),
+                             MString().OfLength(2).WithAlphabet("xy")))
+                   .OfLength(100)),
+      IsOkAndHolds(Each(FieldsAre(AllOf(Ge(1), Le(10)),
+                                  MatchesRegex("[xy][xy]")))));
+  EXPECT_THAT(
+      Generate(MArray(MTuple(MInteger().Between(1, "N"), MInteger().Is(3)))
+                   .OfLength(100),
+               Context().WithValue<MInteger>("N", 7)),
+      IsOkAndHolds(Each(FieldsAre(AllOf(Ge(1), Le(7)), 3))));
+}
+
+TEST(MArrayTest, IntegerElementsNotSuitableForBulkGenerationStillWork) {
+  EXPECT_THAT(Generate(MArray(MInteger().IsOneOf({3, 5})).OfLength(100)),
+              IsOkAndHolds(Each(AnyOf(3, 5))));
+  EXPECT_THAT(
+      Generate(MArray(MInteger().Between(1, 10).WithSize(CommonSize::kSmall))
+                   .OfLength(100)),
+      IsOkAndHolds(Each(AllOf(Ge(1), Le(10)))));
+}
+
+TEST(MArrayTest, BulkGenerationRespectsDependentVariables) {
+  EXPECT_THAT(Generate(MArray(MInteger().Between(1, "N")).OfLength(1000),
+                       Context().WithValue<MInteger>("N", 7)),
+              IsOkAndHolds(Each(AllOf(Ge(1), Le(7)))));
+}
+
+// Generates an array of `length` random tuples with `version`'s random engine
+// on `num_threads` threads.
+std::vector<std::tuple<int64_t, std::string>> GenerateLargeTupleArray(
+    int length, absl::string_view version, int num_threads) {
+  using TupleArray = MArray<MTuple<MInteger, MString>>;
+  moriarty_internal::VariableSet variables;
+  ABSL_CHECK_OK(variables.AddVariable(
+      "A", TupleArray(MTuple(MInteger().Between(1, 10),
+                             MString().OfLength(1, 3).WithAlphabet("ab")))
+               .OfLength(length)));
+  moriarty_internal::RandomEngine rng({1, 2, 3}, version);
+  moriarty_internal::WorkStealingScheduler scheduler(num_threads);
+  absl::StatusOr<moriarty_internal::ValueSet> values =
+      moriarty_internal::GenerateAllValues(
+          variables, /* known_values = */ {},
+          {.random_engine = rng, .scheduler = &scheduler});
+  ABSL_CHECK_OK(values);
+  return *values->Get<TupleArray>("A");
+}
+
+TEST(MArrayTest, LargeArraysGenerateTheSameValuesOnAnyNumberOfThreads) {
+  constexpr int kChunkSize =
+      moriarty_internal::GenerationConfig::kParallelGenerationChunkSize;
+  int length = 5 * kChunkSize + 17;
+
+  for (absl::string_view version : {"v0.1", "v0.2"}) {
+    std::vector<std::tuple<int64_t, std::string>> values =
+        GenerateLargeTupleArray(length, version, 1);
+    ASSERT_THAT(values, SizeIs(length));
+    for (const auto& [x, s] : values) {
+      EXPECT_THAT(x, AllOf(Ge(1), Le(10)));
+      EXPECT_THAT(s, MatchesRegex("[ab]{1,3}"));
+    }
+    EXPECT_EQ(GenerateLargeTupleArray(length, version, 2), values);
+    EXPECT_EQ(GenerateLargeTupleArray(length, version, 8), values);
+  }
+}
+
+TEST(MArrayTest, LargeArraysAreNotSplitIntoChunksWithTheMersenneTwister) {
+  constexpr int kChunkSize =
+      moriarty_internal::GenerationConfig::kParallelGenerationChunkSize;
+
+  // Without chunks, the first elements do not depend on the length.
+  std::vector<std::tuple<int64_t, std::string>> small =
+      GenerateLargeTupleArray(kChunkSize, "v0.1", 4);
+  std::vector<std::tuple<int64_t, std::string>> large =
+      GenerateLargeTupleArray(3 * kChunkSize, "v0.1", 4);
+  ASSERT_THAT(large, SizeIs(3 * kChunkSize));
+  EXPECT_EQ(std::vector(large.begin(), large.begin() + kChunkSize), small);
+}
+
+// Checks `value` against `variable` the way validation does, with the
+// elements checked on `num_threads` threads.
+template <typename T>
+absl::Status SatisfiesConstraintsWithThreads(
+    MArray<T> variable, std::vector<typename T::value_type> value,
+    int num_threads) {
+  moriarty_internal::VariableSet variables;
+  ABSL_CHECK_OK(variables.AddVariable("A", variable));
+  moriarty_internal::ValueSet values;
+  values.Set<MArray<T>>("A", std::move(value));
+  moriarty_internal::WorkStealingScheduler scheduler(num_threads);
+  moriarty_internal::Universe universe = moriarty_internal::Universe()
+                                             .SetConstValueSet(&values)
+                                             .SetConstVariableSet(&variables)
+                                             .SetScheduler(&scheduler);
+  variables.SetUniverse(&universe);
+  return variables.AllVariablesSatisfyConstraints();
+}
+
+TEST(MArrayTest, HugeArraysReportTheFirstInvalidElementOnAnyNumberOfThreads) {
+  constexpr int kChunkSize =
+      moriarty_internal::Universe::kParallelValidationChunkSize;
+  std::vector<int64_t> value(7 * kChunkSize + 5, 5);
+  value[6 * kChunkSize] = 0;
+  value[3 * kChunkSize + 1] = 11;
+  value[3 * kChunkSize + 7] = 12;
+
+  for (int num_threads : {1, 2, 8}) {
+    EXPECT_THAT(
+        SatisfiesConstraintsWithThreads(MArray(MInteger().Between(1, 10)),
+                                        value, num_threads),
+        StatusIs(absl::StatusCode::kFailedPrecondition,
+                 HasSubstr(absl::StrCat("invalid element ",
+                                        3 * kChunkSize + 1))))
+        << "num_threads = " << num_threads;
+  }
+  for (int i : {6 * kChunkSize, 3 * kChunkSize + 1, 3 * kChunkSize + 7})
+    value[i] = 5;
+  for (int num_threads : {1, 2, 8}) {
+    MORIARTY_EXPECT_OK(SatisfiesConstraintsWithThreads(
+        MArray(MInteger().Between(1, 10)), value, num_threads));
+  }
+}
+
+TEST(MArrayTest, HugeArraysReportTheFirstDuplicateOnAnyNumberOfThreads) {
+  constexpr int kChunkSize =
+      moriarty_internal::Universe::kParallelValidationChunkSize;
+  std::vector<std::string> value;
+  for (int i = 0; i < 3 * kChunkSize; i++) value.push_back(absl::StrCat(i));
+  for (int num_threads : {1, 2, 8}) {
+    MORIARTY_EXPECT_OK(SatisfiesConstraintsWithThreads(
+        MArray(MString()).WithDistinctElements(), value, num_threads));
+  }
+
+  value[2 * kChunkSize] = value[5];
+  value[kChunkSize + 3] = value[kChunkSize];
+  for (int num_threads : {1, 2, 8}) {
+    EXPECT_THAT(SatisfiesConstraintsWithThreads(
+                    MArray(MString()).WithDistinctElements(), value,
+                    num_threads),
+                StatusIs(absl::StatusCode::kFailedPrecondition,
+                         HasSubstr(absl::StrCat("index ", kChunkSize + 3))))
+        << "num_threads = " << num_threads;
+  }
+}
+
 MATCHER(HasDuplicateIntegers,
         negation ? "has no duplicate values" : "has duplicate values") {
   absl::flat_hash_set<int64_t> seen;
@@ -389,6 +745,257 @@ TEST(MArrayTest, WithDistinctElementsIsAbleToGenerateWithHugeValue) {
                                   .WithDistinctElements()));
 }
 
+TEST(MArrayTest, WithDistinctElementsOverAnExactRangeIsAPermutation) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values,
+                                Generate(MArray(MInteger().Between(1, "10^5"))
+                                             .OfLength("10^5")
+                                             .WithDistinctElements()));
+
+  absl::c_sort(values);
+  std::vector<int64_t> expected(100000);
+  absl::c_iota(expected, 1);
+  EXPECT_EQ(values, expected);
+}
+
+TEST(MArrayTest, WithDistinctElementsRespectsDependentVariables) {
+  EXPECT_THAT(Generate(MArray(MInteger().Between("N", "2 * N"))
+                           .OfLength("N + 1")
+                           .WithDistinctElements(),
+                       Context().WithValue<MInteger>("N", 500)),
+              IsOkAndHolds(AllOf(SizeIs(501), Each(AllOf(Ge(500), Le(1000))),
+                                 Not(HasDuplicateIntegers()))));
+}
+
+TEST(MArrayTest, WithDistinctElementsWorksOverTheFullIntegerRange) {
+  EXPECT_THAT(
+      Generate(MArray(MInteger()).OfLength(100).WithDistinctElements()),
+      IsOkAndHolds(AllOf(SizeIs(100), Not(HasDuplicateIntegers()))));
+}
+
+TEST(MArrayTest, WithUnorderedMapCollisionsShouldUseOneBucket) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      Generate(MArray(MInteger().Between(1, "10^18"))
+                   .OfLength(1000)
+                   .WithUnorderedMapCollisions()
+                   .WithDistinctElements()));
+  EXPECT_THAT(values, Not(HasDuplicateIntegers()));
+
+#ifdef __GLIBCXX__
+  std::unordered_set<int64_t> set;
+  for (int64_t value : values) set.insert(value);
+  EXPECT_EQ(set.bucket_size(set.bucket(values[0])), values.size());
+#endif
+}
+
+TEST(MArrayTest, WithElementOrderSortedShouldGenerateSortedArrays) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      Generate(MArray(MInteger().Between(1, 1000))
+                   .OfLength(100000)
+                   .WithElementOrder(ElementOrder::Sorted())));
+  EXPECT_THAT(values, AllOf(SizeIs(100000), Each(AllOf(Ge(1), Le(1000)))));
+  EXPECT_TRUE(absl::c_is_sorted(values));
+}
+
+TEST(MArrayTest, WithElementOrderStrictlyIncreasingShouldGenerateSetsInOrder) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      Generate(MArray(MInteger().Between(1, "10^18"))
+                   .OfLength(100000)
+                   .WithElementOrder(ElementOrder::StrictlyIncreasing())));
+  ASSERT_THAT(values, SizeIs(100000));
+  EXPECT_TRUE(absl::c_adjacent_find(values, [](int64_t a, int64_t b) {
+                return a >= b;
+              }) == values.end());
+
+  // Every value in the range is used.
+  EXPECT_THAT(
+      Generate(MArray(MInteger().Between(1, 5))
+                   .OfLength(5)
+                   .WithElementOrder(ElementOrder::StrictlyIncreasing())),
+      IsOkAndHolds(ElementsAre(1, 2, 3, 4, 5)));
+}
+
+TEST(MArrayTest, WithElementOrderAndDistinctElementsShouldBeStrictlyIncreasing) {
+  EXPECT_THAT(Generate(MArray(MInteger().Between(1, 5))
+                           .OfLength(5)
+                           .WithDistinctElements()
+                           .WithElementOrder(ElementOrder::Sorted())),
+              IsOkAndHolds(ElementsAre(1, 2, 3, 4, 5)));
+}
+
+TEST(MArrayTest, WithElementOrderReversedShouldGenerateNonIncreasingArrays) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      Generate(MArray(MInteger().Between(-10, 10))
+                   .OfLength(100000)
+                   .WithElementOrder(ElementOrder::Reversed())));
+  ASSERT_THAT(values, SizeIs(100000));
+  EXPECT_TRUE(absl::c_is_sorted(values, std::greater<int64_t>()));
+}
+
+TEST(MArrayTest, WithElementOrderNearlySortedShouldHaveFewSwaps) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      Generate(MArray(MInteger().Between(1, "10^9"))
+                   .OfLength(100000)
+                   .WithDistinctElements()
+                   .WithElementOrder(ElementOrder::NearlySorted(3))));
+  ASSERT_THAT(values, SizeIs(100000));
+  std::vector<int64_t> sorted = values;
+  absl::c_sort(sorted);
+  int misplaced = 0;
+  for (int i = 0; i < values.size(); i++) misplaced += values[i] != sorted[i];
+  EXPECT_LE(misplaced, 6);
+}
+
+TEST(MArrayTest, WithElementOrderShouldSortOtherElementTypes) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::string> values,
+      Generate(MArray(MString().WithAlphabet("ab").OfLength(1, 5))
+                   .OfLength(100)
+                   .WithElementOrder(ElementOrder::Sorted())));
+  ASSERT_THAT(values, SizeIs(100));
+  EXPECT_TRUE(absl::c_is_sorted(values));
+}
+
+TEST(MArrayTest, WithElementOrderShouldRejectMultipleOrders) {
+  EXPECT_THAT(Generate(MArray(MInteger().Between(1, 10))
+                           .OfLength(5)
+                           .WithElementOrder(ElementOrder::Sorted())
+                           .WithElementOrder(ElementOrder::Reversed())),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MArrayTest, PermutationShouldGenerateThatKindOfPermutation) {
+  for (Permutation permutation :
+       {Permutation::Any(), Permutation::SingleCycle(),
+        Permutation::Derangement(), Permutation::WithCycles(10),
+        Permutation::Involution()}) {
+    MArray<MInteger> array(Length(100000), permutation);
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values,
+                                  Generate(array));
+    EXPECT_THAT(values, SizeIs(100000)) << permutation.ToString();
+    EXPECT_THAT(array, IsSatisfiedWith(values)) << permutation.ToString();
+  }
+}
+
+TEST(MArrayTest, PermutationShouldStartAtFirst) {
+  EXPECT_THAT(Generate(MArray<MInteger>(Length(4), Permutation::Any(-2))),
+              IsOkAndHolds(UnorderedElementsAre(-2, -1, 0, 1)));
+}
+
+TEST(MArrayTest, PermutationShouldStillCheckTheElementConstraints) {
+  EXPECT_FALSE(Generate(MArray<MInteger>(Elements<MInteger>(Between(1, 3)),
+                                         Length(5), Permutation::Any()))
+                   .ok());
+}
+
+TEST(MArrayTest, PermutationShouldRejectMultiplePermutations) {
+  EXPECT_THAT(Generate(MArray<MInteger>(Length(5), Permutation::Any(),
+                                        Permutation::Involution())),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MArrayTest, WithSumShouldGenerateArraysWithThatSum) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> values,
+                                Generate(MArray(MInteger().Between(1, 20))
+                                             .OfLength(100000)
+                                             .WithSum(1000000)));
+  EXPECT_THAT(values, AllOf(SizeIs(100000), Each(AllOf(Ge(1), Le(20)))));
+  EXPECT_EQ(absl::c_accumulate(values, int64_t{0}), 1000000);
+}
+
+TEST(MArrayTest, WithSumShouldAcceptAnExpression) {
+  EXPECT_THAT(
+      Generate(MArray(MInteger().Between(-5, "C")).OfLength("N").WithSum("S"),
+               Context()
+                   .WithValue<MInteger>("N", 1000)
+                   .WithValue<MInteger>("C", 10)
+                   .WithValue<MInteger>("S", 9990)),
+      IsOkAndHolds(AllOf(SizeIs(1000), Each(AllOf(Ge(-5), Le(10))),
+                         ResultOf(
+                             [](const std::vector<int64_t>& values) {
+                               return absl::c_accumulate(values, int64_t{0});
+                             },
+                             9990))));
+}
+
+TEST(MArrayTest, WithSumAndElementOrderShouldGenerateBoth) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> values,
+      Generate(MArray<MInteger>(Elements<MInteger>(Between(0, "10^9")),
+                                Length(1000), Sum("10^11"),
+                                ElementOrder::Sorted())));
+  EXPECT_TRUE(absl::c_is_sorted(values));
+  EXPECT_EQ(absl::c_accumulate(values, int64_t{0}), 100'000'000'000);
+}
+
+TEST(MArrayTest, WithSumShouldFailIfTheSumIsImpossible) {
+  EXPECT_THAT(Generate(MArray(MInteger().Between(1, 20))
+                           .OfLength(10)
+                           .WithSum(201)),
+              Not(IsOk()));
+  EXPECT_THAT(Generate(MArray(MInteger().Between(1, 20))
+                           .OfLength(10)
+                           .WithSum(9)),
+              Not(IsOk()));
+}
+
+// Returns the sum of the lengths of `values`.
+int64_t TotalLengthOf(const std::vector<std::string>& values) {
+  int64_t total_length = 0;
+  for (const std::string& value : values) total_length += value.size();
+  return total_length;
+}
+
+TEST(MArrayTest, WithTotalLengthShouldSplitTheLengthBetweenTheStrings) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::string> values,
+      Generate(MArray(MString().WithAlphabet("ab").OfLength(1, 20))
+                   .OfLength(100000)
+                   .WithTotalLength(1000000)));
+  EXPECT_THAT(values,
+              AllOf(SizeIs(100000), Each(SizeIs(AllOf(Ge(1), Le(20))))));
+  EXPECT_EQ(TotalLengthOf(values), 1000000);
+}
+
+TEST(MArrayTest, WithTotalLengthShouldGenerateTheMaximumTotalLength) {
+  EXPECT_THAT(Generate(MArray<MString>(
+                  Elements<MString>(Alphabet("ab"), Length(Between(1, 10))),
+                  Length(1000), TotalLength(10000))),
+              IsOkAndHolds(Each(SizeIs(10))));
+}
+
+TEST(MArrayTest, WithTotalLengthShouldAcceptAnExpression) {
+  EXPECT_THAT(
+      Generate(MArray(MString().WithAlphabet("a").OfLength(0, "C"))
+                   .OfLength("N")
+                   .WithTotalLength("S"),
+               Context()
+                   .WithValue<MInteger>("N", 1000)
+                   .WithValue<MInteger>("C", 10)
+                   .WithValue<MInteger>("S", 9990)),
+      IsOkAndHolds(AllOf(SizeIs(1000), ResultOf(TotalLengthOf, 9990))));
+}
+
+TEST(MArrayTest, WithTotalLengthShouldWorkForStringsThatCannotBeSplit) {
+  // Simple patterns are not generated in bulk, so arrays are generated until
+  // one has the right total length.
+  EXPECT_THAT(Generate(MArray(MString().WithSimplePattern("a{1, 2}"))
+                           .OfLength(2)
+                           .WithTotalLength(3)),
+              IsOkAndHolds(ResultOf(TotalLengthOf, 3)));
+}
+
+TEST(MArrayTest, WithTotalLengthShouldFailIfTheTotalLengthIsImpossible) {
+  EXPECT_THAT(Generate(MArray(MString().WithAlphabet("a").OfLength(1, 20))
+                           .OfLength(10)
+                           .WithTotalLength(201)),
+              Not(IsOk()));
+}
+
 TEST(MArrayTest, WhitespaceSeparatorShouldAffectPrint) {
   EXPECT_THAT(
       Print(MArray(MInteger()).WithSeparator(Whitespace::kNewline), {1, 2, 3}),
@@ -774,6 +1381,77 @@ TEST(MArrayNonBuilderTest, SatisfiesConstraintsShouldCheckForDistinctElements) {
               IsNotSatisfiedWith(std::vector<int64_t>({1, 2, 2}), "distinct"));
 }
 
+TEST(MArrayNonBuilderTest, SatisfiesConstraintsShouldCheckTheSum) {
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)), Sum(8)),
+              IsSatisfiedWith(std::vector<int64_t>({1, 2, 5})));
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)), Sum(8)),
+              IsNotSatisfiedWith(std::vector<int64_t>({1, 2, 4}), "sum"));
+  EXPECT_THAT(MArray<MInteger>(Sum(0)),
+              IsNotSatisfiedWith(
+                  std::vector<int64_t>({std::numeric_limits<int64_t>::max(), 1}),
+                  "sum"));
+}
+
+TEST(MArrayNonBuilderTest, SatisfiesConstraintsShouldCheckTheTotalLength) {
+  EXPECT_THAT(MArray<MString>(TotalLength(5)),
+              IsSatisfiedWith(std::vector<std::string>({"ab", "cde"})));
+  EXPECT_THAT(MArray<MString>(TotalLength(5)),
+              IsNotSatisfiedWith(std::vector<std::string>({"ab", "cd"}),
+                                 "total length"));
+}
+
+TEST(MArrayNonBuilderTest, SatisfiesConstraintsShouldCheckPermutations) {
+  EXPECT_THAT(MArray<MInteger>(Permutation::Any()),
+              IsSatisfiedWith(std::vector<int64_t>({3, 1, 2})));
+  EXPECT_THAT(MArray<MInteger>(Permutation::Any()),
+              IsNotSatisfiedWith(std::vector<int64_t>({0, 1, 2}), "Any"));
+  EXPECT_THAT(MArray<MInteger>(Permutation::SingleCycle(0)),
+              IsSatisfiedWith(std::vector<int64_t>({1, 2, 0})));
+  EXPECT_THAT(MArray<MInteger>(Permutation::SingleCycle(0)),
+              IsNotSatisfiedWith(std::vector<int64_t>({1, 0, 2}), "Cycle"));
+  EXPECT_THAT(MArray<MInteger>(Permutation::Derangement()),
+              IsSatisfiedWith(std::vector<int64_t>({2, 1})));
+  EXPECT_THAT(MArray<MInteger>(Permutation::Derangement()),
+              IsNotSatisfiedWith(std::vector<int64_t>({1, 2}), "Derangement"));
+  EXPECT_THAT(MArray<MInteger>(Permutation::WithCycles(2)),
+              IsSatisfiedWith(std::vector<int64_t>({2, 1, 3})));
+  EXPECT_THAT(MArray<MInteger>(Permutation::WithCycles(2)),
+              IsNotSatisfiedWith(std::vector<int64_t>({2, 3, 1}), "Cycles"));
+  EXPECT_THAT(MArray<MInteger>(Permutation::Involution()),
+              IsSatisfiedWith(std::vector<int64_t>({3, 2, 1})));
+  EXPECT_THAT(MArray<MInteger>(Permutation::Involution()),
+              IsNotSatisfiedWith(std::vector<int64_t>({2, 3, 1}),
+                                 "Involution"));
+}
+
+TEST(MArrayNonBuilderTest, SatisfiesConstraintsShouldCheckElementOrder) {
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::Sorted()),
+              IsSatisfiedWith(std::vector<int64_t>({1, 2, 2, 5})));
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::Sorted()),
+              IsNotSatisfiedWith(std::vector<int64_t>({1, 3, 2}), "order"));
+
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::StrictlyIncreasing()),
+              IsSatisfiedWith(std::vector<int64_t>({1, 2, 5})));
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::StrictlyIncreasing()),
+              IsNotSatisfiedWith(std::vector<int64_t>({1, 2, 2}), "order"));
+
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::Reversed()),
+              IsSatisfiedWith(std::vector<int64_t>({5, 2, 2, 1})));
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::Reversed()),
+              IsNotSatisfiedWith(std::vector<int64_t>({5, 1, 2}), "order"));
+
+  // Nearly sorted only guides generation.
+  EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)),
+                               ElementOrder::NearlySorted(1)),
+              IsSatisfiedWith(std::vector<int64_t>({5, 1, 3})));
+}
+
 TEST(MArrayNonBuilderTest,
      SatisfiesConstraintsShouldCheckForDistinctElementsWithArg) {
   EXPECT_THAT(MArray<MInteger>(Elements<MInteger>(Between(1, 5)), Length(3))
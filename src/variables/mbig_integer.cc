@@ -0,0 +1,393 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mbig_integer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/errors.h"
+#include "src/internal/random_engine.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+using moriarty::librarian::IOConfig;
+
+namespace {
+
+// The largest power of ten accepted as a bound ("10^k"), to catch typos before
+// allocating the digits.
+constexpr int64_t kMaxPowerOfTenExponent = int64_t{1} << 30;
+
+// While generating, the number of digits drawn at once while the digits so far
+// match the upper end of the range.
+constexpr int64_t kTightDigitsPerDraw = 64;
+
+bool AllDigits(absl::string_view s) {
+  return !s.empty() && absl::c_all_of(s, absl::ascii_isdigit);
+}
+
+// Compares two magnitudes without leading zeros. Returns <0, 0 or >0.
+int CompareMagnitudes(absl::string_view a, absl::string_view b) {
+  if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+  return a.compare(b);
+}
+
+// Returns `a + b` for two magnitudes.
+std::string AddMagnitudes(absl::string_view a, absl::string_view b) {
+  if (a.size() < b.size()) std::swap(a, b);
+  std::string result(a.size() + 1, '0');
+  int carry = 0;
+  for (int64_t i = 0; i < a.size(); i++) {
+    int digit = (a[a.size() - 1 - i] - '0') + carry;
+    if (i < b.size()) digit += b[b.size() - 1 - i] - '0';
+    carry = digit / 10;
+    result[result.size() - 1 - i] = static_cast<char>('0' + digit % 10);
+  }
+  if (carry == 0) return result.substr(1);
+  result[0] = '1';
+  return result;
+}
+
+// Returns `a - b` for two magnitudes with `a >= b`.
+std::string SubtractMagnitudes(absl::string_view a, absl::string_view b) {
+  std::string result(a);
+  int borrow = 0;
+  for (int64_t i = 0; i < a.size(); i++) {
+    int digit = (a[a.size() - 1 - i] - '0') - borrow;
+    if (i < b.size()) digit -= b[b.size() - 1 - i] - '0';
+    borrow = digit < 0;
+    result[result.size() - 1 - i] =
+        static_cast<char>('0' + digit + 10 * borrow);
+  }
+  int64_t leading_zeros = result.find_first_not_of('0');
+  if (leading_zeros == std::string::npos) return "0";
+  return result.substr(leading_zeros);
+}
+
+// Parses a bound that is a literal (see `MBigInteger`). Returns `std::nullopt`
+// if `bound` is not a literal, so is an integer expression.
+std::optional<absl::StatusOr<BigInteger>> ParseLiteralBound(
+    absl::string_view bound) {
+  bound = absl::StripAsciiWhitespace(bound);
+  bool negative = absl::ConsumePrefix(&bound, "-");
+
+  if (AllDigits(bound)) {
+    // Allow leading zeros in bounds, unlike in values.
+    int64_t leading_zeros = bound.find_first_not_of('0');
+    bound.remove_prefix(leading_zeros == absl::string_view::npos
+                            ? bound.size() - 1
+                            : leading_zeros);
+    if (bound == "0") return BigInteger(0);
+    return BigInteger::FromString(negative ? absl::StrCat("-", bound)
+                                           : std::string(bound));
+  }
+
+  absl::string_view exponent = bound;
+  int64_t k;
+  if (absl::ConsumePrefix(&exponent, "10^") && AllDigits(exponent)) {
+    if (!absl::SimpleAtoi(exponent, &k) || k > kMaxPowerOfTenExponent) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Bound is too large: ", bound));
+    }
+    std::string value(negative ? k + 2 : k + 1, '0');
+    value[negative ? 1 : 0] = '1';
+    if (negative) value[0] = '-';
+    return BigInteger::FromString(value);
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+BigInteger::BigInteger(int64_t value)
+    : negative_(value < 0),
+      // Avoid negating int64 min.
+      digits_(absl::StrCat(value < 0 ? -static_cast<uint64_t>(value)
+                                     : static_cast<uint64_t>(value))) {}
+
+BigInteger::BigInteger(bool negative, std::string digits)
+    : negative_(negative && digits != "0"), digits_(std::move(digits)) {}
+
+absl::StatusOr<BigInteger> BigInteger::FromString(absl::string_view value) {
+  bool negative = absl::ConsumePrefix(&value, "-");
+  if (!AllDigits(value) || (value.size() > 1 && value[0] == '0') ||
+      (negative && value == "0")) {
+    return absl::InvalidArgumentError(
+        "Unable to read a big integer (expected a canonical decimal "
+        "integer).");
+  }
+  return BigInteger(negative, std::string(value));
+}
+
+std::string BigInteger::ToString() const {
+  return negative_ ? absl::StrCat("-", digits_) : digits_;
+}
+
+bool operator<(const BigInteger& lhs, const BigInteger& rhs) {
+  if (lhs.IsNegative() != rhs.IsNegative()) return lhs.IsNegative();
+  int cmp = CompareMagnitudes(lhs.Digits(), rhs.Digits());
+  return lhs.IsNegative() ? cmp > 0 : cmp < 0;
+}
+
+MBigInteger& MBigInteger::AddConstraint(
+    const Exactly<std::string>& constraint) {
+  return Between(constraint.GetValue(), constraint.GetValue());
+}
+
+MBigInteger& MBigInteger::Between(absl::string_view minimum,
+                                  absl::string_view maximum) {
+  return AtLeast(minimum).AtMost(maximum);
+}
+
+MBigInteger& MBigInteger::Between(int64_t minimum, absl::string_view maximum) {
+  return AtLeast(minimum).AtMost(maximum);
+}
+
+MBigInteger& MBigInteger::Between(int64_t minimum, int64_t maximum) {
+  return AtLeast(minimum).AtMost(maximum);
+}
+
+MBigInteger& MBigInteger::AtLeast(absl::string_view minimum) {
+  std::optional<absl::StatusOr<BigInteger>> literal =
+      ParseLiteralBound(minimum);
+  if (!literal) {
+    if (!absl::c_linear_search(minimum_expressions_, minimum))
+      minimum_expressions_.push_back(std::string(minimum));
+    return *this;
+  }
+  if (!literal->ok()) {
+    DeclareSelfAsInvalid(
+        UnsatisfiedConstraintError(literal->status().message()));
+    return *this;
+  }
+  if (!minimum_ || *minimum_ < **literal) minimum_ = *std::move(*literal);
+  return *this;
+}
+
+MBigInteger& MBigInteger::AtLeast(int64_t minimum) {
+  BigInteger literal(minimum);
+  if (!minimum_ || *minimum_ < literal) minimum_ = std::move(literal);
+  return *this;
+}
+
+MBigInteger& MBigInteger::AtMost(absl::string_view maximum) {
+  std::optional<absl::StatusOr<BigInteger>> literal =
+      ParseLiteralBound(maximum);
+  if (!literal) {
+    if (!absl::c_linear_search(maximum_expressions_, maximum))
+      maximum_expressions_.push_back(std::string(maximum));
+    return *this;
+  }
+  if (!literal->ok()) {
+    DeclareSelfAsInvalid(
+        UnsatisfiedConstraintError(literal->status().message()));
+    return *this;
+  }
+  if (!maximum_ || **literal < *maximum_) maximum_ = *std::move(*literal);
+  return *this;
+}
+
+MBigInteger& MBigInteger::AtMost(int64_t maximum) {
+  BigInteger literal(maximum);
+  if (!maximum_ || literal < *maximum_) maximum_ = std::move(literal);
+  return *this;
+}
+
+absl::StatusOr<std::pair<BigInteger, BigInteger>> MBigInteger::GetBounds()
+    const {
+  std::optional<BigInteger> minimum = minimum_;
+  std::optional<BigInteger> maximum = maximum_;
+
+  auto evaluate = [this](absl::string_view expression)
+      -> absl::StatusOr<BigInteger> {
+    std::optional<int64_t> value =
+        GetUniqueValue("bound", MInteger().Between(expression, expression));
+    if (!value) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("Unable to evaluate the bound: ", expression));
+    }
+    return BigInteger(*value);
+  };
+  for (const std::string& expression : minimum_expressions_) {
+    MORIARTY_ASSIGN_OR_RETURN(BigInteger value, evaluate(expression));
+    if (!minimum || *minimum < value) minimum = std::move(value);
+  }
+  for (const std::string& expression : maximum_expressions_) {
+    MORIARTY_ASSIGN_OR_RETURN(BigInteger value, evaluate(expression));
+    if (!maximum || value < *maximum) maximum = std::move(value);
+  }
+
+  if (!minimum || !maximum) {
+    return absl::FailedPreconditionError(
+        "MBigInteger must have both a lower and an upper bound.");
+  }
+  return std::make_pair(*std::move(minimum), *std::move(maximum));
+}
+
+absl::StatusOr<BigInteger> MBigInteger::GenerateImpl() {
+  MORIARTY_ASSIGN_OR_RETURN(auto bounds, GetBounds());
+  const auto& [minimum, maximum] = bounds;
+  if (maximum < minimum)
+    return absl::InvalidArgumentError("Valid range is empty");
+
+  // width = maximum - minimum >= 0.
+  std::string width;
+  if (minimum.IsNegative() == maximum.IsNegative()) {
+    width = minimum.IsNegative()
+                ? SubtractMagnitudes(minimum.Digits(), maximum.Digits())
+                : SubtractMagnitudes(maximum.Digits(), minimum.Digits());
+  } else {
+    width = AddMagnitudes(minimum.Digits(), maximum.Digits());
+  }
+
+  // Pick an offset in [0, width] uniformly, one digit at a time. The leading
+  // digit is uniform in [0, width[0]] and the others are uniform in [0, 9].
+  // Every number in [0, width] is equally likely to be built, so rejecting
+  // the ones that are too large keeps the distribution uniform. At least half
+  // of the attempts are accepted when width[0] >= 1 (and all of them when the
+  // width has one digit), and an attempt stops at the first digit that makes
+  // it too large.
+  //
+  // MBigInteger needs direct access its RandomEngine. Non built-in types should
+  // not access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  std::string offset(width.size(), '0');
+  auto draw_digits = [&](int64_t begin, int64_t n) -> absl::Status {
+    MORIARTY_RETURN_IF_ERROR(rng.RandIndices(
+        10, absl::MakeSpan(reinterpret_cast<uint8_t*>(&offset[begin]), n)));
+    for (int64_t i = begin; i < begin + n; i++) offset[i] += '0';
+    return absl::OkStatus();
+  };
+  while (true) {
+    MORIARTY_ASSIGN_OR_RETURN(int64_t leading, rng.RandInt(0, width[0] - '0'));
+    offset[0] = static_cast<char>('0' + leading);
+    bool tight = offset[0] == width[0];
+    bool too_large = false;
+    int64_t begin = 1;
+    // While the prefix matches the width, the attempt may still be rejected,
+    // so only draw a few digits at a time.
+    while (tight && !too_large && begin < width.size()) {
+      int64_t n = std::min<int64_t>(kTightDigitsPerDraw, width.size() - begin);
+      MORIARTY_RETURN_IF_ERROR(draw_digits(begin, n));
+      for (int64_t i = begin; i < begin + n && tight; i++) {
+        if (offset[i] != width[i]) {
+          tight = false;
+          too_large = offset[i] > width[i];
+        }
+      }
+      begin += n;
+    }
+    if (too_large) continue;
+    MORIARTY_RETURN_IF_ERROR(draw_digits(begin, width.size() - begin));
+    break;
+  }
+  int64_t leading_zeros = offset.find_first_not_of('0');
+  offset =
+      leading_zeros == std::string::npos ? "0" : offset.substr(leading_zeros);
+
+  // value = minimum + offset.
+  if (!minimum.IsNegative())
+    return BigInteger(false, AddMagnitudes(minimum.Digits(), offset));
+  if (CompareMagnitudes(minimum.Digits(), offset) > 0)
+    return BigInteger(true, SubtractMagnitudes(minimum.Digits(), offset));
+  return BigInteger(false, SubtractMagnitudes(offset, minimum.Digits()));
+}
+
+absl::Status MBigInteger::IsSatisfiedWithImpl(const BigInteger& value) const {
+  MORIARTY_ASSIGN_OR_RETURN(auto bounds, GetBounds());
+  if (value < bounds.first || bounds.second < value) {
+    return UnsatisfiedConstraintError(absl::Substitute(
+        "big integer with $0 digits is not in the range",
+        value.Digits().size()));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MBigInteger::MergeFromImpl(const MBigInteger& other) {
+  if (other.minimum_) AtLeast(other.minimum_->ToString());
+  if (other.maximum_) AtMost(other.maximum_->ToString());
+  for (const std::string& expression : other.minimum_expressions_)
+    AtLeast(expression);
+  for (const std::string& expression : other.maximum_expressions_)
+    AtMost(expression);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<BigInteger> MBigInteger::ReadImpl() {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  MORIARTY_ASSIGN_OR_RETURN(std::string token, io_config->ReadToken());
+  return BigInteger::FromString(token);
+}
+
+absl::Status MBigInteger::PrintImpl(const BigInteger& value) {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  if (!value.IsNegative()) return io_config->PrintToken(value.Digits());
+  return io_config->PrintToken(value.ToString());
+}
+
+std::vector<std::string> MBigInteger::GetDependenciesImpl() const {
+  std::vector<std::string> deps;
+  for (const std::vector<std::string>* expressions :
+       {&minimum_expressions_, &maximum_expressions_}) {
+    for (const std::string& expression : *expressions) {
+      absl::c_move(
+          GetDependencies(MInteger().Between(expression, expression)),
+          std::back_inserter(deps));
+    }
+  }
+  return deps;
+}
+
+bool MBigInteger::IsKnownUnsatisfiableImpl() const {
+  return minimum_ && maximum_ && *maximum_ < *minimum_;
+}
+
+std::string MBigInteger::ToStringImpl() const {
+  std::vector<std::string> minimums = minimum_expressions_;
+  if (minimum_) minimums.push_back(minimum_->ToString());
+  std::vector<std::string> maximums = maximum_expressions_;
+  if (maximum_) maximums.push_back(maximum_->ToString());
+  return absl::Substitute("bounds: [max($0), min($1)]; ",
+                          absl::StrJoin(minimums, ", "),
+                          absl::StrJoin(maximums, ", "));
+}
+
+absl::StatusOr<std::string> MBigInteger::ValueToStringImpl(
+    const BigInteger& value) const {
+  return value.ToString();
+}
+
+}  // namespace moriarty
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MBIG_INTEGER_H_
+#define MORIARTY_SRC_VARIABLES_MBIG_INTEGER_H_
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "src/librarian/mvariable.h"
+#include "src/variables/constraints/base_constraints.h"
+
+namespace moriarty {
+
+// BigInteger
+//
+// An integer with any number of digits, stored as its sign and a buffer of its
+// decimal digits (most significant first, without leading zeros). Zero is
+// never negative.
+class BigInteger {
+ public:
+  // Creates the integer 0.
+  BigInteger() = default;
+  explicit BigInteger(int64_t value);
+
+  // FromString()
+  //
+  // Parses `value` in canonical decimal form: an optional '-' followed by the
+  // digits, without leading zeros (e.g., "-123" or "0", but not "+1", "007" or
+  // "-0"). Returns kInvalidArgument otherwise.
+  static absl::StatusOr<BigInteger> FromString(absl::string_view value);
+
+  [[nodiscard]] bool IsNegative() const { return negative_; }
+
+  // Digits()
+  //
+  // The decimal digits of the absolute value, most significant first.
+  [[nodiscard]] absl::string_view Digits() const { return digits_; }
+
+  // ToString()
+  //
+  // The canonical decimal form of this integer (see `FromString()`).
+  [[nodiscard]] std::string ToString() const;
+
+  friend bool operator==(const BigInteger& lhs, const BigInteger& rhs) {
+    return lhs.negative_ == rhs.negative_ && lhs.digits_ == rhs.digits_;
+  }
+  // Numeric order.
+  friend bool operator<(const BigInteger& lhs, const BigInteger& rhs);
+  friend bool operator>(const BigInteger& lhs, const BigInteger& rhs) {
+    return rhs < lhs;
+  }
+  friend bool operator<=(const BigInteger& lhs, const BigInteger& rhs) {
+    return !(rhs < lhs);
+  }
+  friend bool operator>=(const BigInteger& lhs, const BigInteger& rhs) {
+    return !(lhs < rhs);
+  }
+
+ private:
+  friend class MBigInteger;
+  BigInteger(bool negative, std::string digits);
+
+  bool negative_ = false;
+  std::string digits_ = "0";
+};
+
+// MBigInteger
+//
+// Describes constraints placed on an integer with any number of digits (e.g.,
+// 1 <= N <= 10^100000). Generation, reading, printing and checking all take
+// time linear in the number of digits.
+//
+// Each bound is one of:
+//  * A decimal literal of any length (e.g., "-123456789012345678901234567890").
+//  * A power of ten, possibly negated (e.g., "10^100000" or "-10^5").
+//  * An integer expression (e.g., "3 * N + 1"), which must fit in 64 bits.
+class MBigInteger : public librarian::MVariable<MBigInteger, BigInteger> {
+ public:
+  // Create an MBigInteger from a set of constraints. Logically equivalent to
+  // calling AddConstraint() for each constraint.
+  //
+  // E.g., MBigInteger(Exactly("123456789012345678901234567890"))
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MBigInteger(Constraints&&... constraints);
+
+  // The integer must be exactly this value (a bound, as described above).
+  MBigInteger& AddConstraint(const Exactly<std::string>& constraint);
+
+  [[nodiscard]] std::string Typename() const override { return "MBigInteger"; }
+
+  // ValueByteSize()
+  //
+  // Returns the number of digits in `value`.
+  [[nodiscard]] static int64_t ValueByteSize(const BigInteger& value) {
+    return value.Digits().size();
+  }
+
+  // Between()
+  //
+  // Restrict this integer to be in the inclusive range [`minimum`,
+  // `maximum`]. If this restriction is called multiple times, the ranges are
+  // intersected together.
+  //
+  // E.g., `Between("1", "10^100000")` or `Between(1, "N")`.
+  MBigInteger& Between(absl::string_view minimum, absl::string_view maximum);
+  MBigInteger& Between(int64_t minimum, absl::string_view maximum);
+  MBigInteger& Between(int64_t minimum, int64_t maximum);
+
+  // AtLeast()
+  //
+  // Restricts this integer to be larger than or equal to `minimum`.
+  MBigInteger& AtLeast(absl::string_view minimum);
+  MBigInteger& AtLeast(int64_t minimum);
+
+  // AtMost()
+  //
+  // Restricts this integer to be smaller than or equal to `maximum`.
+  MBigInteger& AtMost(absl::string_view maximum);
+  MBigInteger& AtMost(int64_t maximum);
+
+ private:
+  // The literal bounds are intersected as they are added. Expression bounds
+  // are evaluated when they are needed.
+  std::optional<BigInteger> minimum_;
+  std::optional<BigInteger> maximum_;
+  std::vector<std::string> minimum_expressions_;
+  std::vector<std::string> maximum_expressions_;
+
+  // GetBounds()
+  //
+  // Returns the inclusive range of valid values, evaluating the expression
+  // bounds. Returns an error if either end is unbounded or an expression
+  // cannot be evaluated.
+  absl::StatusOr<std::pair<BigInteger, BigInteger>> GetBounds() const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<BigInteger> GenerateImpl() override;
+  absl::Status IsSatisfiedWithImpl(const BigInteger& value) const override;
+  absl::Status MergeFromImpl(const MBigInteger& other) override;
+  absl::StatusOr<BigInteger> ReadImpl() override;
+  absl::Status PrintImpl(const BigInteger& value) override;
+  std::vector<std::string> GetDependenciesImpl() const override;
+  bool IsKnownUnsatisfiableImpl() const override;
+  std::string ToStringImpl() const override;
+  absl::StatusOr<std::string> ValueToStringImpl(
+      const BigInteger& value) const override;
+  // ---------------------------------------------------------------------------
+};
+
+// -----------------------------------------------------------------------------
+//  Implementation details
+// -----------------------------------------------------------------------------
+
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MBigInteger::MBigInteger(Constraints&&... constraints) {
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MBIG_INTEGER_H_
@@ -0,0 +1,160 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mbig_integer.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::moriarty_testing::Context;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::AllOf;
+using ::testing::Ge;
+using ::testing::Le;
+
+BigInteger Big(absl::string_view value) {
+  return *BigInteger::FromString(value);
+}
+
+TEST(MBigIntegerTest, TypenameIsCorrect) {
+  EXPECT_EQ(MBigInteger().Typename(), "MBigInteger");
+}
+
+TEST(MBigIntegerTest, FromStringShouldOnlyAcceptCanonicalIntegers) {
+  EXPECT_THAT(BigInteger::FromString("0"), IsOkAndHolds(BigInteger(0)));
+  EXPECT_THAT(BigInteger::FromString("-123"), IsOkAndHolds(BigInteger(-123)));
+  for (absl::string_view input : {"", "-", "+1", "007", "-0", "1.0", "1e5"}) {
+    EXPECT_THAT(BigInteger::FromString(input),
+                StatusIs(absl::StatusCode::kInvalidArgument))
+        << input;
+  }
+}
+
+TEST(MBigIntegerTest, BigIntegersShouldBeOrderedNumerically) {
+  EXPECT_LT(Big("9"), Big("10"));
+  EXPECT_LT(Big("-10"), Big("-9"));
+  EXPECT_LT(Big("-1"), Big("0"));
+  EXPECT_LT(Big("123456789012345678901234567890"),
+            Big("123456789012345678901234567891"));
+  EXPECT_EQ(BigInteger(std::numeric_limits<int64_t>::min()).ToString(),
+            "-9223372036854775808");
+}
+
+TEST(MBigIntegerTest, GenerateShouldBeInTheRange) {
+  for (int i = 0; i < 100; i++) {
+    EXPECT_THAT(Generate(MBigInteger().Between("1", "10^1000")),
+                IsOkAndHolds(AllOf(Ge(Big("1")),
+                                   Le(Big("1" + std::string(1000, '0'))))));
+    EXPECT_THAT(Generate(MBigInteger().Between("-10^50", "-10^49")),
+                IsOkAndHolds(AllOf(Ge(Big("-1" + std::string(50, '0'))),
+                                   Le(Big("-1" + std::string(49, '0'))))));
+  }
+}
+
+TEST(MBigIntegerTest, GenerateShouldGenerateEveryValueInASmallRange) {
+  absl::flat_hash_set<std::string> values;
+  for (int i = 0; i < 1000; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(BigInteger value,
+                                  Generate(MBigInteger().Between(-5, 15)));
+    EXPECT_THAT(value, AllOf(Ge(BigInteger(-5)), Le(BigInteger(15))));
+    values.insert(value.ToString());
+  }
+  EXPECT_EQ(values.size(), 21);
+}
+
+TEST(MBigIntegerTest, GenerateWithHugeRangesShouldHaveManyDigits) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      BigInteger value,
+      Generate(MBigInteger().Between("10^99999", "10^100000")));
+  EXPECT_THAT(value.Digits().size(), AllOf(Ge(100000), Le(100001)));
+}
+
+TEST(MBigIntegerTest, GenerateWithASingleValueShouldReturnIt) {
+  std::string value = "-123456789012345678901234567890";
+  EXPECT_THAT(Generate(MBigInteger(Exactly(value))),
+              IsOkAndHolds(Big(value)));
+}
+
+TEST(MBigIntegerTest, GenerateWithExpressionBoundsShouldWork) {
+  for (int i = 0; i < 20; i++) {
+    EXPECT_THAT(Generate(MBigInteger().Between("N", "2 * N"),
+                         Context().WithValue<MInteger>("N", 10)),
+                IsOkAndHolds(AllOf(Ge(BigInteger(10)), Le(BigInteger(20)))));
+  }
+}
+
+TEST(MBigIntegerTest, GenerateWithoutBoundsShouldFail) {
+  EXPECT_THAT(Generate(MBigInteger()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(MBigInteger().AtLeast(0)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MBigIntegerTest, GenerateWithAnEmptyRangeShouldFail) {
+  EXPECT_FALSE(Generate(MBigInteger().Between("10^5", "10^4")).ok());
+}
+
+TEST(MBigIntegerTest, IsSatisfiedWithShouldCheckTheBounds) {
+  MBigInteger big = MBigInteger().Between("-10^20", "10^20");
+  EXPECT_THAT(big, IsSatisfiedWith(Big("-1" + std::string(20, '0'))));
+  EXPECT_THAT(big, IsSatisfiedWith(Big("99999999999999999999")));
+  EXPECT_THAT(big, IsNotSatisfiedWith(Big("100000000000000000001"), "range"));
+  EXPECT_THAT(big, IsNotSatisfiedWith(Big("-100000000000000000001"), "range"));
+}
+
+TEST(MBigIntegerTest, MergeFromShouldIntersectTheRanges) {
+  MBigInteger big = MBigInteger().Between(0, "10^30");
+  big.MergeFrom(MBigInteger().Between("-10^40", "10^20"));
+
+  EXPECT_THAT(big, IsSatisfiedWith(Big("1" + std::string(20, '0'))));
+  EXPECT_THAT(big,
+              IsNotSatisfiedWith(Big("1" + std::string(21, '0')), "range"));
+  EXPECT_THAT(big, IsNotSatisfiedWith(Big("-1"), "range"));
+}
+
+TEST(MBigIntegerTest, PrintShouldPrintTheDigits) {
+  EXPECT_THAT(Print(MBigInteger(), Big("123456789012345678901234567890")),
+              IsOkAndHolds("123456789012345678901234567890"));
+  EXPECT_THAT(Print(MBigInteger(), Big("-5")), IsOkAndHolds("-5"));
+}
+
+TEST(MBigIntegerTest, ReadShouldOnlyAcceptCanonicalIntegers) {
+  EXPECT_THAT(Read(MBigInteger(), "-123456789012345678901234567890"),
+              IsOkAndHolds(Big("-123456789012345678901234567890")));
+  EXPECT_THAT(Read(MBigInteger(), "0123"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace moriarty
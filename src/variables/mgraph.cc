@@ -0,0 +1,528 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/variables/mgraph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "src/errors.h"
+#include "src/internal/graph_utils.h"
+#include "src/internal/random_config.h"
+#include "src/internal/random_engine.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/graph_constraints.h"
+#include "src/variables/constraints/size_constraints.h"
+#include "src/variables/graph.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+using moriarty::librarian::IOConfig;
+
+MGraph& MGraph::AddConstraint(const NumNodes& constraint) {
+  if (num_nodes_)
+    num_nodes_->MergeFrom(constraint.GetConstraints());
+  else
+    num_nodes_ = constraint.GetConstraints();
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const NumEdges& constraint) {
+  if (num_edges_)
+    num_edges_->MergeFrom(constraint.GetConstraints());
+  else
+    num_edges_ = constraint.GetConstraints();
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const Connected& constraint) {
+  connected_ = true;
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const Tree& constraint) {
+  tree_ = true;
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const SimpleGraph& constraint) {
+  simple_ = true;
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const DirectedAcyclic& constraint) {
+  directed_acyclic_ = true;
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const Bipartite& constraint) {
+  bipartite_ = true;
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const NodeLabelsFrom& constraint) {
+  first_label_ = constraint.GetFirstLabel();
+  return *this;
+}
+
+MGraph& MGraph::AddConstraint(const SizeCategory& constraint) {
+  return AddConstraint(NumNodes(constraint));
+}
+
+absl::Status MGraph::MergeFromImpl(const MGraph& other) {
+  if (other.num_nodes_) AddConstraint(NumNodes(*other.num_nodes_));
+  if (other.num_edges_) AddConstraint(NumEdges(*other.num_edges_));
+  connected_ |= other.connected_;
+  tree_ |= other.tree_;
+  simple_ |= other.simple_;
+  directed_acyclic_ |= other.directed_acyclic_;
+  bipartite_ |= other.bipartite_;
+  if (other.first_label_ != 0) first_label_ = other.first_label_;
+  return absl::OkStatus();
+}
+
+namespace {
+
+using EdgeList = std::vector<std::pair<int, int>>;
+
+// The most edges a graph with `n` nodes can have without self-loops or
+// multiple edges.
+int64_t MaxSimpleEdges(int64_t n, bool bipartite) {
+  if (bipartite) return (n / 2) * ((n + 1) / 2);
+  return n * (n - 1) / 2;
+}
+
+// The candidate edges of a graph, indexed from 0. For bipartite graphs, the
+// sides are [0, left) and [left, n), and (u, v) has index
+// `u * (n - left) + (v - left)`. Otherwise, the candidates are all pairs
+// u < v, indexed by `UnorderedPairIndex()`.
+struct EdgeSpace {
+  int n;
+  bool bipartite;
+  int left;
+
+  int64_t Size() const {
+    if (bipartite) return static_cast<int64_t>(left) * (n - left);
+    return MaxSimpleEdges(n, /*bipartite=*/false);
+  }
+  int64_t Index(std::pair<int, int> edge) const {
+    auto [u, v] = edge;
+    if (u > v) std::swap(u, v);
+    if (bipartite) return static_cast<int64_t>(u) * (n - left) + (v - left);
+    return moriarty_internal::UnorderedPairIndex(u, v);
+  }
+  std::pair<int, int> Edge(int64_t index) const {
+    if (bipartite) {
+      return {static_cast<int>(index / (n - left)),
+              left + static_cast<int>(index % (n - left))};
+    }
+    return moriarty_internal::UnorderedPairFromIndex(index);
+  }
+};
+
+// Returns a uniformly random spanning tree (via a random Prüfer code).
+absl::StatusOr<EdgeList> RandomTree(
+    moriarty_internal::RandomEngine& rng, int n) {
+  if (n < 2) return EdgeList();
+  std::vector<int> code(n - 2);
+  absl::Status status;
+  for (int& v : code) v = rng.RandInt(n, status);
+  MORIARTY_RETURN_IF_ERROR(status);
+  return moriarty_internal::PruferCodeToEdges(code);
+}
+
+// Returns a random spanning tree where every edge goes between the sides of
+// `space`. Each node (in random order) is attached to a random node on the
+// other side that is already in the tree. Both sides must be non-empty.
+absl::StatusOr<EdgeList> RandomBipartiteTree(
+    moriarty_internal::RandomEngine& rng, const EdgeSpace& space) {
+  const int n = space.n;
+  MORIARTY_ASSIGN_OR_RETURN(int first_left, rng.RandInt(space.left));
+  MORIARTY_ASSIGN_OR_RETURN(int first_right,
+                            rng.RandInt(space.left, space.n - 1));
+  std::vector<int> in_tree[2] = {{first_left}, {first_right}};
+  EdgeList edges = {{first_left, first_right}};
+  edges.reserve(n - 1);
+
+  MORIARTY_ASSIGN_OR_RETURN(std::vector<int> order,
+                            moriarty_internal::RandomPermutation(rng, n));
+  for (int u : order) {
+    if (u == first_left || u == first_right) continue;
+    const int side = u < space.left ? 0 : 1;
+    const std::vector<int>& other_side = in_tree[1 - side];
+    MORIARTY_ASSIGN_OR_RETURN(int64_t index, rng.RandInt(other_side.size()));
+    edges.push_back({u, other_side[index]});
+    in_tree[side].push_back(u);
+  }
+  return edges;
+}
+
+struct EdgeOptions {
+  bool connected;
+  bool simple;
+  bool directed_acyclic;
+  bool bipartite;
+};
+
+// Returns `m` random edges on `n` nodes that satisfy `options`. `m` must be
+// possible (e.g., at least n - 1 if connected). O(n + m).
+absl::StatusOr<EdgeList> RandomEdges(
+    moriarty_internal::RandomEngine& rng, int n, int m,
+    const EdgeOptions& options) {
+  EdgeSpace space = {.n = n, .bipartite = options.bipartite, .left = 0};
+  if (options.bipartite) {
+    // Pick the size of the first side so that there is room for the edges.
+    int min_left = m > 0 ? 1 : 0;
+    if (options.simple) {
+      while (static_cast<int64_t>(min_left) * (n - min_left) < m) min_left++;
+    }
+    MORIARTY_ASSIGN_OR_RETURN(space.left, rng.RandInt(min_left, n - min_left));
+  }
+
+  EdgeList edges;
+  edges.reserve(m);
+  if (options.connected && n >= 2) {
+    MORIARTY_ASSIGN_OR_RETURN(edges, options.bipartite
+                                         ? RandomBipartiteTree(rng, space)
+                                         : RandomTree(rng, n));
+  }
+
+  const int extra = m - static_cast<int>(edges.size());
+  if (options.simple) {
+    // Choose the extra edges by index among the candidates that are not
+    // already a tree edge. Both lists are sorted, so this is a single merge.
+    std::vector<int64_t> taken;
+    taken.reserve(edges.size());
+    for (const std::pair<int, int>& edge : edges)
+      taken.push_back(space.Index(edge));
+    std::sort(taken.begin(), taken.end());
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::vector<int64_t> chosen,
+        moriarty_internal::SortedDistinctIntegers<int64_t>(
+            rng, space.Size() - static_cast<int64_t>(taken.size()), extra));
+    size_t skipped = 0;
+    for (int64_t index : chosen) {
+      while (skipped < taken.size() && taken[skipped] <= index + skipped)
+        skipped++;
+      edges.push_back(space.Edge(index + skipped));
+    }
+  } else if (options.directed_acyclic || options.bipartite) {
+    absl::Status status;
+    // `space.Edge()` is only valid for a valid index, so stop at an error.
+    for (int i = 0; i < extra && status.ok(); i++)
+      edges.push_back(space.Edge(rng.RandInt(space.Size(), status)));
+    MORIARTY_RETURN_IF_ERROR(status);
+  } else {
+    absl::Status status;
+    for (int i = 0; i < extra; i++) {
+      int u = rng.RandInt(n, status);
+      int v = rng.RandInt(n, status);
+      edges.push_back({u, v});
+    }
+    MORIARTY_RETURN_IF_ERROR(status);
+  }
+
+  // Directed edges go from the smaller node to the larger node, so there are
+  // no cycles. Undirected edges are given a random orientation.
+  absl::Status status;
+  for (auto& [u, v] : edges) {
+    if (options.directed_acyclic) {
+      if (u > v) std::swap(u, v);
+    } else if (rng.RandInt(2, status)) {
+      std::swap(u, v);
+    }
+  }
+  MORIARTY_RETURN_IF_ERROR(status);
+
+  // Hide the structure of the construction (e.g., the topological order and
+  // the sides) behind a random labelling.
+  if (options.directed_acyclic || options.bipartite) {
+    MORIARTY_ASSIGN_OR_RETURN(std::vector<int> label,
+                              moriarty_internal::RandomPermutation(rng, n));
+    for (auto& [u, v] : edges) {
+      u = label[u];
+      v = label[v];
+    }
+  }
+  MORIARTY_RETURN_IF_ERROR(moriarty_internal::Shuffle(rng, edges));
+  return edges;
+}
+
+}  // namespace
+
+absl::StatusOr<MInteger> MGraph::NumEdgesFor(int num_nodes) const {
+  if (!num_edges_ && !tree_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a graph with no NumEdges() constraint.");
+  }
+  MInteger num_edges = num_edges_ ? *num_edges_ : MInteger();
+  num_edges.AtLeast(0);
+  num_edges.AtMost(std::numeric_limits<int>::max());
+  if (tree_) num_edges.Between(num_nodes - 1, num_nodes - 1);
+  if ((connected_ || tree_) && num_nodes > 0) num_edges.AtLeast(num_nodes - 1);
+  // Every edge needs two distinct nodes, except for self-loops.
+  if (num_nodes == 0 ||
+      (num_nodes == 1 && (simple_ || directed_acyclic_ || bipartite_)))
+    num_edges.AtMost(0);
+  if (simple_) num_edges.AtMost(MaxSimpleEdges(num_nodes, bipartite_));
+  return num_edges;
+}
+
+absl::StatusOr<Graph> MGraph::GenerateImpl() {
+  if (!num_nodes_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a graph with no NumNodes() constraint.");
+  }
+  MInteger num_nodes = *num_nodes_;
+  num_nodes.AtLeast(tree_ ? 1 : 0);
+  num_nodes.AtMost(std::numeric_limits<int>::max());
+  std::optional<int64_t> generation_limit =
+      this->GetApproximateGenerationLimit();
+  if (generation_limit) num_nodes.AtMost(*generation_limit);
+  MORIARTY_ASSIGN_OR_RETURN(int n, Random("num_nodes", num_nodes),
+                            _ << "Error determining the number of nodes");
+
+  MORIARTY_ASSIGN_OR_RETURN(MInteger num_edges, NumEdgesFor(n));
+  if (generation_limit) num_edges.AtMost(*generation_limit);
+  MORIARTY_ASSIGN_OR_RETURN(int m, Random("num_edges", num_edges),
+                            _ << "Error determining the number of edges");
+
+  // MGraph needs direct access its RandomEngine. Non built-in types should not
+  // access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  EdgeOptions options = {.connected = connected_ || tree_,
+                         .simple = simple_,
+                         .directed_acyclic = directed_acyclic_,
+                         .bipartite = bipartite_};
+  MORIARTY_ASSIGN_OR_RETURN(EdgeList edges,
+                            RandomEdges(rng, n, m, options));
+  return Graph(n, std::move(edges));
+}
+
+namespace {
+
+absl::Status CheckSimple(const Graph& g, bool directed) {
+  // `last_seen[v] == u` if v has already been seen as a neighbour of u.
+  std::vector<int> last_seen(g.NumNodes(), -1);
+  for (int u = 0; u < g.NumNodes(); u++) {
+    for (int v : directed ? g.OutNeighbors(u) : g.Neighbors(u)) {
+      if (u == v) {
+        return UnsatisfiedConstraintError(
+            absl::Substitute("graph has a self-loop at node $0", u));
+      }
+      if (last_seen[v] == u) {
+        return UnsatisfiedConstraintError(absl::Substitute(
+            "graph has multiple edges between nodes $0 and $1", u, v));
+      }
+      last_seen[v] = u;
+    }
+  }
+  return absl::OkStatus();
+}
+
+bool IsConnected(const Graph& g) {
+  moriarty_internal::DisjointSets sets(g.NumNodes());
+  for (auto [u, v] : g.Edges()) sets.Union(u, v);
+  return sets.NumSets() <= 1;
+}
+
+// Kahn's algorithm: repeatedly remove nodes with no incoming edges.
+bool IsDirectedAcyclic(const Graph& g) {
+  std::vector<int> in_degree(g.NumNodes());
+  for (auto [u, v] : g.Edges()) in_degree[v]++;
+  std::vector<int> ready;
+  for (int u = 0; u < g.NumNodes(); u++)
+    if (in_degree[u] == 0) ready.push_back(u);
+  int removed = 0;
+  while (!ready.empty()) {
+    int u = ready.back();
+    ready.pop_back();
+    removed++;
+    for (int v : g.OutNeighbors(u))
+      if (--in_degree[v] == 0) ready.push_back(v);
+  }
+  return removed == g.NumNodes();
+}
+
+// Two-colours each component with a depth-first search.
+bool IsBipartite(const Graph& g) {
+  std::vector<int> colour(g.NumNodes(), -1);
+  std::vector<int> stack;
+  for (int start = 0; start < g.NumNodes(); start++) {
+    if (colour[start] != -1) continue;
+    colour[start] = 0;
+    stack.push_back(start);
+    while (!stack.empty()) {
+      int u = stack.back();
+      stack.pop_back();
+      for (int v : g.Neighbors(u)) {
+        if (colour[v] == colour[u]) return false;
+        if (colour[v] == -1) {
+          colour[v] = 1 - colour[u];
+          stack.push_back(v);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+absl::Status MGraph::IsSatisfiedWithImpl(const Graph& value) const {
+  if (num_nodes_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(SatisfiesConstraints(*num_nodes_, value.NumNodes()),
+                        "number of nodes is invalid"));
+  }
+  if (num_edges_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(SatisfiesConstraints(*num_edges_, value.NumEdges()),
+                        "number of edges is invalid"));
+  }
+  if (tree_ && value.NumEdges() != value.NumNodes() - 1) {
+    return UnsatisfiedConstraintError(absl::Substitute(
+        "a tree with $0 nodes has $1 edges, but the graph has $2 edges",
+        value.NumNodes(), value.NumNodes() - 1, value.NumEdges()));
+  }
+  if (simple_) {
+    MORIARTY_RETURN_IF_ERROR(CheckSimple(value, directed_acyclic_));
+  }
+  if ((connected_ || tree_) && !IsConnected(value))
+    return UnsatisfiedConstraintError("graph is not connected");
+  if (directed_acyclic_ && !IsDirectedAcyclic(value))
+    return UnsatisfiedConstraintError("graph has a directed cycle");
+  if (bipartite_ && !IsBipartite(value))
+    return UnsatisfiedConstraintError("graph is not bipartite");
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Graph> MGraph::ReadImpl() {
+  if (!num_nodes_) {
+    return absl::FailedPreconditionError(
+        "Unknown number of nodes of graph before read.");
+  }
+  std::optional<int64_t> num_nodes = GetUniqueValue("num_nodes", *num_nodes_);
+  if (!num_nodes) {
+    return absl::FailedPreconditionError(
+        "Cannot determine the number of nodes of graph before read.");
+  }
+  std::optional<int64_t> num_edges;
+  if (num_edges_) num_edges = GetUniqueValue("num_edges", *num_edges_);
+  if (!num_edges && tree_) num_edges = *num_nodes - 1;
+  if (!num_edges) {
+    return absl::FailedPreconditionError(
+        "Cannot determine the number of edges of graph before read.");
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  EdgeList edges;
+  edges.reserve(*num_edges);
+  for (int64_t i = 0; i < *num_edges; i++) {
+    if (i > 0) {
+      MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(Whitespace::kNewline));
+    }
+    int endpoints[2];
+    for (int j = 0; j < 2; j++) {
+      if (j > 0) {
+        MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(Whitespace::kSpace));
+      }
+      MORIARTY_ASSIGN_OR_RETURN(int64_t label, io_config->ReadInteger());
+      if (label < first_label_ || label - first_label_ >= *num_nodes) {
+        return absl::InvalidArgumentError(
+            absl::Substitute("node $0 is not in [$1, $2]", label, first_label_,
+                             first_label_ + *num_nodes - 1));
+      }
+      endpoints[j] = label - first_label_;
+    }
+    edges.push_back({endpoints[0], endpoints[1]});
+  }
+  return Graph(*num_nodes, std::move(edges));
+}
+
+absl::Status MGraph::PrintImpl(const Graph& value) {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  for (int64_t i = 0; i < value.NumEdges(); i++) {
+    if (i > 0) {
+      MORIARTY_RETURN_IF_ERROR(
+          io_config->PrintWhitespace(Whitespace::kNewline));
+    }
+    auto [u, v] = value.Edges()[i];
+    MORIARTY_RETURN_IF_ERROR(
+        io_config->PrintInteger(static_cast<int64_t>(u) + first_label_));
+    MORIARTY_RETURN_IF_ERROR(io_config->PrintWhitespace(Whitespace::kSpace));
+    MORIARTY_RETURN_IF_ERROR(
+        io_config->PrintInteger(static_cast<int64_t>(v) + first_label_));
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::string> MGraph::GetDependenciesImpl() const {
+  std::vector<std::string> dependencies;
+  if (num_nodes_) dependencies = GetDependencies(*num_nodes_);
+  if (num_edges_) {
+    for (std::string& dependency : GetDependencies(*num_edges_))
+      dependencies.push_back(std::move(dependency));
+  }
+  return dependencies;
+}
+
+bool MGraph::IsKnownUnsatisfiableImpl() const {
+  if (!num_nodes_) return false;
+  MInteger num_nodes = *num_nodes_;
+  num_nodes.AtLeast(tree_ ? 1 : 0);
+  return IsKnownUnsatisfiable("num_nodes", num_nodes);
+}
+
+std::string MGraph::ToStringImpl() const {
+  std::string result;
+  if (num_nodes_)
+    absl::StrAppend(&result, "num_nodes: ", num_nodes_->ToString(), "; ");
+  if (num_edges_)
+    absl::StrAppend(&result, "num_edges: ", num_edges_->ToString(), "; ");
+  if (tree_) absl::StrAppend(&result, "tree; ");
+  if (connected_) absl::StrAppend(&result, "connected; ");
+  if (simple_) absl::StrAppend(&result, "simple; ");
+  if (directed_acyclic_) absl::StrAppend(&result, "directed acyclic; ");
+  if (bipartite_) absl::StrAppend(&result, "bipartite; ");
+  if (first_label_ != 0)
+    absl::StrAppend(&result, "nodes labelled from ", first_label_, "; ");
+  return result;
+}
+
+absl::StatusOr<std::string> MGraph::ValueToStringImpl(
+    const Graph& value) const {
+  std::string result = absl::StrCat(value.NumNodes(), " nodes:");
+  for (auto [u, v] : value.Edges()) {
+    absl::StrAppend(&result, " (", static_cast<int64_t>(u) + first_label_,
+                    ", ", static_cast<int64_t>(v) + first_label_, ")");
+  }
+  return result;
+}
+
+}  // namespace moriarty
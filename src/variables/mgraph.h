@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MGRAPH_H_
+#define MORIARTY_SRC_VARIABLES_MGRAPH_H_
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/librarian/mvariable.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/constraints/graph_constraints.h"
+#include "src/variables/constraints/size_constraints.h"
+#include "src/variables/graph.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+// MGraph
+//
+// Describes constraints placed on a graph. By default, the graph is undirected
+// and may have self-loops and multiple edges. See `graph_constraints.h` for the
+// available constraints (`Connected()`, `Tree()`, `SimpleGraph()`,
+// `DirectedAcyclic()`, `Bipartite()`, ...).
+//
+// In order to generate, the number of nodes must be constrained, and the
+// number of edges must be constrained unless this is a `Tree()`. Generation
+// takes O(n + m) time (the extra edges of a `SimpleGraph()` are chosen by
+// index, with no hashing).
+//
+// A graph is printed (and read) as one edge per line, with the two endpoints
+// separated by a space. The number of nodes and edges are not printed.
+//
+// E.g., MGraph(NumNodes(Between(1, "N")), NumEdges("M"), Connected(),
+//              SimpleGraph(), NodeLabelsFrom(1))
+class MGraph : public librarian::MVariable<MGraph, Graph> {
+ public:
+  // Create an MGraph from a set of constraints. Logically equivalent to
+  // calling AddConstraint() for each constraint.
+  //
+  // E.g., MGraph(NumNodes(10), Tree()).
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MGraph(Constraints&&... constraints);
+
+  // The graph must have this many nodes.
+  MGraph& AddConstraint(const NumNodes& constraint);
+  // The graph must have this many edges.
+  MGraph& AddConstraint(const NumEdges& constraint);
+  // The graph must be connected.
+  MGraph& AddConstraint(const Connected& constraint);
+  // The graph must be a tree.
+  MGraph& AddConstraint(const Tree& constraint);
+  // The graph must not have self-loops or multiple edges.
+  MGraph& AddConstraint(const SimpleGraph& constraint);
+  // The graph must be directed and acyclic.
+  MGraph& AddConstraint(const DirectedAcyclic& constraint);
+  // The graph must be bipartite.
+  MGraph& AddConstraint(const Bipartite& constraint);
+  // The nodes are labelled from this value when printed or read.
+  MGraph& AddConstraint(const NodeLabelsFrom& constraint);
+  // The graph should have approximately this many nodes.
+  MGraph& AddConstraint(const SizeCategory& constraint);
+
+  [[nodiscard]] std::string Typename() const override { return "MGraph"; }
+
+  // ValueByteSize()
+  //
+  // Returns the bytes needed for the number of nodes and the edges of `value`.
+  [[nodiscard]] static int64_t ValueByteSize(const Graph& value) {
+    return sizeof(int) + value.NumEdges() * sizeof(std::pair<int, int>);
+  }
+
+ private:
+  std::optional<MInteger> num_nodes_;
+  std::optional<MInteger> num_edges_;
+  bool connected_ = false;
+  bool tree_ = false;
+  bool simple_ = false;
+  bool directed_acyclic_ = false;
+  bool bipartite_ = false;
+  int first_label_ = 0;
+
+  // Returns the constraints on the number of edges of a graph with
+  // `num_nodes` nodes, including the ones implied by the other constraints
+  // (e.g., at least `num_nodes - 1` edges for a connected graph).
+  absl::StatusOr<MInteger> NumEdgesFor(int num_nodes) const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<Graph> GenerateImpl() override;
+  absl::Status IsSatisfiedWithImpl(const Graph& value) const override;
+  absl::Status MergeFromImpl(const MGraph& other) override;
+  absl::StatusOr<Graph> ReadImpl() override;
+  absl::Status PrintImpl(const Graph& value) override;
+  std::vector<std::string> GetDependenciesImpl() const override;
+  bool IsKnownUnsatisfiableImpl() const override;
+  std::string ToStringImpl() const override;
+  absl::StatusOr<std::string> ValueToStringImpl(
+      const Graph& value) const override;
+  // ---------------------------------------------------------------------------
+};
+
+// -----------------------------------------------------------------------------
+//  Implementation details
+// -----------------------------------------------------------------------------
+
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MGraph::MGraph(Constraints&&... constraints) {
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MGRAPH_H_
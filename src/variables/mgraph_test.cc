@@ -0,0 +1,272 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "src/variables/mgraph.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/constraints/graph_constraints.h"
+#include "src/variables/constraints/numeric_constraints.h"
+#include "src/variables/graph.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty_testing::Context;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::GenerateLots;
+using ::moriarty_testing::GenerateN;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Le;
+using ::testing::Pair;
+using ::testing::Property;
+using ::testing::SizeIs;
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+
+// Independent checks of the graph properties, so the generator is not only
+// tested against MGraph's own IsSatisfiedWith().
+bool IsConnected(const Graph& g) {
+  std::vector<std::vector<int>> adjacent(g.NumNodes());
+  for (auto [u, v] : g.Edges()) {
+    adjacent[u].push_back(v);
+    adjacent[v].push_back(u);
+  }
+  std::vector<bool> seen(g.NumNodes());
+  std::vector<int> stack = {0};
+  int num_seen = 0;
+  while (!stack.empty() && g.NumNodes() > 0) {
+    int u = stack.back();
+    stack.pop_back();
+    if (seen[u]) continue;
+    seen[u] = true;
+    num_seen++;
+    for (int v : adjacent[u]) stack.push_back(v);
+  }
+  return num_seen == g.NumNodes();
+}
+
+bool IsSimple(const Graph& g) {
+  std::set<std::pair<int, int>> edges;
+  for (auto [u, v] : g.Edges()) {
+    if (u == v) return false;
+    if (!edges.insert({std::min(u, v), std::max(u, v)}).second) return false;
+  }
+  return true;
+}
+
+TEST(MGraphTest, TypenameIsCorrect) {
+  EXPECT_EQ(MGraph().Typename(), "MGraph");
+}
+
+TEST(MGraphTest, GenerateShouldRespectTheNumberOfNodesAndEdges) {
+  EXPECT_THAT(
+      GenerateLots(MGraph(NumNodes(Between(1, 10)), NumEdges(Between(0, 20)))),
+      IsOkAndHolds(Each(AllOf(Property(&Graph::NumNodes, AllOf(Ge(1), Le(10))),
+                              Property(&Graph::NumEdges,
+                                       AllOf(Ge(0), Le(20)))))));
+  EXPECT_THAT(GenerateLots(MGraph(NumNodes("N"), NumEdges("2 * N")),
+                           Context().WithValue<MInteger>("N", 7)),
+              IsOkAndHolds(Each(AllOf(Property(&Graph::NumNodes, 7),
+                                      Property(&Graph::NumEdges, 14)))));
+}
+
+TEST(MGraphTest, TreesShouldBeConnectedWithOneLessEdgeThanNodes) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<Graph> trees,
+                                GenerateLots(MGraph(NumNodes(Between(1, 50)),
+                                                    Tree())));
+  for (const Graph& tree : trees) {
+    EXPECT_EQ(tree.NumEdges(), tree.NumNodes() - 1);
+    EXPECT_TRUE(IsConnected(tree));
+  }
+}
+
+TEST(MGraphTest, AllTreesShouldBeGenerated) {
+  // There are 4^2 = 16 labelled trees on 4 nodes.
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<Graph> trees,
+                                GenerateN(MGraph(NumNodes(4), Tree()), 500));
+  std::set<std::set<std::pair<int, int>>> seen;
+  for (const Graph& tree : trees) {
+    std::set<std::pair<int, int>> edges;
+    for (auto [u, v] : tree.Edges())
+      edges.insert({std::min(u, v), std::max(u, v)});
+    seen.insert(edges);
+  }
+  EXPECT_THAT(seen, SizeIs(16));
+}
+
+TEST(MGraphTest, ConnectedSimpleGraphsShouldBeGenerated) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<Graph> graphs,
+      GenerateLots(MGraph(NumNodes(Between(2, 30)), NumEdges(Between(1, 60)),
+                          Connected(), SimpleGraph())));
+  for (const Graph& g : graphs) {
+    EXPECT_TRUE(IsConnected(g));
+    EXPECT_TRUE(IsSimple(g));
+  }
+}
+
+TEST(MGraphTest, DenseSimpleGraphsShouldBeGenerated) {
+  // Complete graph.
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      Graph complete,
+      Generate(MGraph(NumNodes(20), NumEdges(190), SimpleGraph())));
+  EXPECT_TRUE(IsSimple(complete));
+  EXPECT_EQ(complete.NumEdges(), 190);
+
+  EXPECT_FALSE(
+      Generate(MGraph(NumNodes(20), NumEdges(191), SimpleGraph())).ok());
+}
+
+TEST(MGraphTest, LargeSparseSimpleGraphsShouldBeGenerated) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      Graph g, Generate(MGraph(NumNodes(100'000), NumEdges(200'000),
+                               Connected(), SimpleGraph())));
+  EXPECT_TRUE(IsConnected(g));
+  EXPECT_TRUE(IsSimple(g));
+}
+
+TEST(MGraphTest, DirectedAcyclicGraphsShouldHaveNoCycles) {
+  MGraph dag(NumNodes(Between(1, 20)), NumEdges(Between(0, 40)),
+             DirectedAcyclic());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<Graph> graphs, GenerateLots(dag));
+  for (const Graph& g : graphs) {
+    EXPECT_THAT(dag, IsSatisfiedWith(g));
+    for (auto [u, v] : g.Edges()) EXPECT_NE(u, v);
+  }
+
+  MGraph simple_dag(NumNodes(10), NumEdges(45), DirectedAcyclic(),
+                    SimpleGraph());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Graph complete, Generate(simple_dag));
+  EXPECT_THAT(simple_dag, IsSatisfiedWith(complete));
+}
+
+TEST(MGraphTest, BipartiteGraphsShouldBeTwoColourable) {
+  MGraph bipartite(NumNodes(Between(2, 20)), NumEdges(Between(1, 60)),
+                   Bipartite(), Connected(), SimpleGraph());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<Graph> graphs,
+                                GenerateLots(bipartite));
+  for (const Graph& g : graphs) {
+    EXPECT_THAT(bipartite, IsSatisfiedWith(g));
+    EXPECT_TRUE(IsConnected(g));
+    EXPECT_TRUE(IsSimple(g));
+  }
+
+  // Complete bipartite graph K_{5, 5}.
+  MGraph complete(NumNodes(10), NumEdges(25), Bipartite(), SimpleGraph());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(Graph g, Generate(complete));
+  EXPECT_THAT(complete, IsSatisfiedWith(g));
+}
+
+TEST(MGraphTest, GenerateWithoutEnoughConstraintsShouldFail) {
+  EXPECT_THAT(Generate(MGraph(NumEdges(3))),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("NumNodes")));
+  EXPECT_THAT(Generate(MGraph(NumNodes(3))),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("NumEdges")));
+  EXPECT_FALSE(Generate(MGraph(NumNodes(5), NumEdges(3), Connected())).ok());
+}
+
+TEST(MGraphTest, IsSatisfiedWithShouldCheckEachConstraint) {
+  EXPECT_THAT(MGraph(NumNodes(3)), IsSatisfiedWith(Graph(3, {{0, 1}})));
+  EXPECT_THAT(MGraph(NumNodes(4)),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}}), "number of nodes"));
+  EXPECT_THAT(MGraph(NumEdges(2)),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}}), "number of edges"));
+
+  EXPECT_THAT(MGraph(Connected()), IsSatisfiedWith(Graph(3, {{0, 1}, {2, 1}})));
+  EXPECT_THAT(MGraph(Connected()),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}, {1, 0}}), "connected"));
+
+  EXPECT_THAT(MGraph(Tree()), IsSatisfiedWith(Graph(3, {{0, 1}, {2, 1}})));
+  EXPECT_THAT(MGraph(Tree()),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}, {2, 1}, {0, 2}}), "tree"));
+
+  EXPECT_THAT(MGraph(SimpleGraph()),
+              IsSatisfiedWith(Graph(3, {{0, 1}, {2, 1}})));
+  EXPECT_THAT(MGraph(SimpleGraph()),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}, {1, 0}}), "multiple"));
+  EXPECT_THAT(MGraph(SimpleGraph()),
+              IsNotSatisfiedWith(Graph(3, {{2, 2}}), "self-loop"));
+  // In a directed graph, (0, 1) and (1, 0) are different edges.
+  EXPECT_THAT(MGraph(SimpleGraph(), DirectedAcyclic()),
+              IsNotSatisfiedWith(Graph(2, {{0, 1}, {1, 0}}), "cycle"));
+
+  EXPECT_THAT(MGraph(DirectedAcyclic()),
+              IsSatisfiedWith(Graph(3, {{0, 1}, {0, 2}, {1, 2}})));
+  EXPECT_THAT(MGraph(DirectedAcyclic()),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}, {1, 2}, {2, 0}}), "cycle"));
+
+  EXPECT_THAT(MGraph(Bipartite()),
+              IsSatisfiedWith(Graph(4, {{0, 1}, {1, 2}, {2, 3}, {3, 0}})));
+  EXPECT_THAT(MGraph(Bipartite()),
+              IsNotSatisfiedWith(Graph(3, {{0, 1}, {1, 2}, {2, 0}}),
+                                 "bipartite"));
+}
+
+TEST(MGraphTest, PrintShouldPrintOneEdgePerLine) {
+  EXPECT_THAT(Print(MGraph(), Graph(3, {{0, 1}, {2, 1}})),
+              IsOkAndHolds("0 1\n2 1"));
+  EXPECT_THAT(Print(MGraph(NodeLabelsFrom(1)), Graph(3, {{0, 1}, {2, 1}})),
+              IsOkAndHolds("1 2\n3 2"));
+  EXPECT_THAT(Print(MGraph(), Graph(3, {})), IsOkAndHolds(""));
+}
+
+TEST(MGraphTest, ReadShouldReadOneEdgePerLine) {
+  EXPECT_THAT(Read(MGraph(NumNodes(3), NumEdges(2)), "0 1\n2 1"),
+              IsOkAndHolds(Graph(3, {{0, 1}, {2, 1}})));
+  EXPECT_THAT(Read(MGraph(NumNodes(3), Tree(), NodeLabelsFrom(1)), "1 2\n3 2"),
+              IsOkAndHolds(Graph(3, {{0, 1}, {2, 1}})));
+  EXPECT_THAT(Read(MGraph(NumNodes(3), NumEdges(1)), "0 3"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not in [0, 2]")));
+  EXPECT_THAT(Read(MGraph(NumNodes(3)), "0 1"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MGraphTest, MergeFromShouldCombineConstraints) {
+  MGraph a(NumNodes(Between(1, 10)), Connected());
+  a.MergeFrom(MGraph(NumNodes(Between(5, 20)), NumEdges(4)));
+  EXPECT_THAT(GenerateLots(a),
+              IsOkAndHolds(Each(AllOf(Property(&Graph::NumNodes, 5),
+                                      Property(&Graph::NumEdges, 4)))));
+}
+
+TEST(MGraphTest, ToStringShouldMentionTheConstraints) {
+  EXPECT_THAT(MGraph(NumNodes(5), Tree(), Bipartite()).ToString(),
+              AllOf(HasSubstr("num_nodes"), HasSubstr("tree"),
+                    HasSubstr("bipartite")));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,758 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MGRID_H_
+#define MORIARTY_SRC_VARIABLES_MGRID_H_
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/errors.h"
+#include "src/internal/generation_config.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/container_constraints.h"
+#include "src/variables/constraints/io_constraints.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+// Grid<>
+//
+// A 2D grid with `NumRows()` rows and `NumCols()` columns. The elements are
+// stored in a single buffer, row by row, so each row is contiguous in memory.
+template <typename T>
+class Grid {
+ public:
+  // An empty grid (0 rows and 0 columns).
+  Grid() = default;
+
+  // A grid with `num_rows` rows and `num_cols` columns, all equal to `T()`.
+  Grid(int64_t num_rows, int64_t num_cols)
+      : Grid(num_rows, num_cols, std::vector<T>(num_rows * num_cols)) {}
+
+  // A grid with `num_rows` rows and `num_cols` columns with these elements, in
+  // row-major order. `elements.size()` must be `num_rows * num_cols`.
+  Grid(int64_t num_rows, int64_t num_cols, std::vector<T> elements)
+      : num_rows_(num_rows),
+        num_cols_(num_cols),
+        elements_(std::move(elements)) {
+    ABSL_CHECK_GE(num_rows_, 0);
+    ABSL_CHECK_GE(num_cols_, 0);
+    ABSL_CHECK_EQ(static_cast<int64_t>(elements_.size()),
+                  num_rows_ * num_cols_);
+  }
+
+  // FromRows()
+  //
+  // A grid with these rows. All rows must have the same length.
+  static Grid FromRows(const std::vector<std::vector<T>>& rows);
+
+  // NumRows()
+  //
+  // The number of rows in this grid.
+  [[nodiscard]] int64_t NumRows() const { return num_rows_; }
+
+  // NumCols()
+  //
+  // The number of columns in this grid.
+  [[nodiscard]] int64_t NumCols() const { return num_cols_; }
+
+  // size()
+  //
+  // The number of elements in this grid.
+  [[nodiscard]] int64_t size() const { return elements_.size(); }
+
+  // operator()
+  //
+  // The element in row `row` and column `col` (both 0-based).
+  T& operator()(int64_t row, int64_t col) {
+    return elements_[row * num_cols_ + col];
+  }
+  const T& operator()(int64_t row, int64_t col) const {
+    return elements_[row * num_cols_ + col];
+  }
+
+  // Row()
+  //
+  // The elements of row `row` (0-based). No copies are made.
+  absl::Span<T> Row(int64_t row) {
+    return absl::MakeSpan(elements_).subspan(row * num_cols_, num_cols_);
+  }
+  absl::Span<const T> Row(int64_t row) const {
+    return absl::MakeConstSpan(elements_).subspan(row * num_cols_, num_cols_);
+  }
+
+  // Column()
+  //
+  // A copy of the elements of column `col` (0-based).
+  [[nodiscard]] std::vector<T> Column(int64_t col) const;
+
+  // Elements()
+  //
+  // All of the elements, in row-major order.
+  absl::Span<const T> Elements() const { return elements_; }
+
+  // Iterates over the elements in row-major order.
+  auto begin() const { return elements_.begin(); }
+  auto end() const { return elements_.end(); }
+
+  friend bool operator==(const Grid& lhs, const Grid& rhs) = default;
+  friend bool operator<(const Grid& lhs, const Grid& rhs) {
+    return std::tie(lhs.num_rows_, lhs.num_cols_, lhs.elements_) <
+           std::tie(rhs.num_rows_, rhs.num_cols_, rhs.elements_);
+  }
+
+ private:
+  int64_t num_rows_ = 0;
+  int64_t num_cols_ = 0;
+  std::vector<T> elements_;
+};
+
+// MGrid<>
+//
+// Describes constraints placed on a 2D grid (e.g., an N x M grid of integers or
+// characters). Unlike `NestedMArray(MArray(MInteger()))`, the generated value
+// is a `Grid` whose elements are in one contiguous buffer, the elements are
+// generated all at once when possible, and the elements are validated over the
+// whole buffer at once.
+//
+// Each row may also be constrained as an `MArray` (e.g., distinct elements or a
+// fixed sum), and so may each column. Row constraints are used to generate
+// each row, while column constraints are only checked after generating.
+//
+// When reading or writing, the elements of a row are separated by a space (see
+// `WithSeparator()`) and rows are separated by a newline. Grids of integers
+// are read and written a row at a time.
+//
+// In order to generate or read, the number of rows and the number of columns
+// must be constrained (via `OfNumRows()` and `OfNumCols()`).
+template <typename MElementType>
+class MGrid
+    : public librarian::MVariable<MGrid<MElementType>,
+                                  Grid<typename MElementType::value_type>> {
+ public:
+  using element_value_type = typename MElementType::value_type;
+  using grid_value_type = Grid<element_value_type>;
+
+  // Create an MGrid from a set of constraints. Logically equivalent to calling
+  // AddConstraint() for each constraint.
+  //
+  // E.g., MGrid<MInteger>(Elements<MInteger>(Between(1, 10)))
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MGrid(Constraints&&... constraints);
+
+  // Create an MGrid with this set of constraints on each element.
+  explicit MGrid(MElementType element_constraints);
+
+  // The grid's elements must satisfy these constraints.
+  MGrid& AddConstraint(const Elements<MElementType>& constraint);
+  // The elements in each row must be separated by this whitespace.
+  MGrid& AddConstraint(const IOSeparator& constraint);
+
+  // Typename()
+  //
+  // Returns a string representing the name of this type (for example,
+  // "MGrid<MInteger>"). This is mostly used for debugging/error messages.
+  [[nodiscard]] std::string Typename() const override;
+
+  // ValueByteSize()
+  //
+  // Returns the sum of `MElementType::ValueByteSize()` over the elements of
+  // `value`. Grids of integral types are `sizeof()` their elements.
+  [[nodiscard]] static int64_t ValueByteSize(const grid_value_type& value) {
+    if constexpr (std::is_arithmetic_v<element_value_type>) {
+      return value.size() * sizeof(element_value_type);
+    } else {
+      int64_t bytes = 0;
+      for (const element_value_type& element : value)
+        bytes += MElementType::ValueByteSize(element);
+      return bytes;
+    }
+  }
+
+  // Of()
+  //
+  // Add extra constraints to the elements of the grid.
+  MGrid& Of(MElementType variable);
+
+  // OfNumRows()
+  //
+  // Sets the constraints for the number of rows of this grid. If two
+  // parameters are provided, the number of rows is in the closed range
+  // [`min_rows`, `max_rows`].
+  //
+  // For example:
+  // `OfNumRows(5, 10)` is equivalent to `OfNumRows(MInteger().Between(5, 10))`.
+  // `OfNumRows("N")` is equivalent to `OfNumRows(MInteger().Is("N"))`.
+  MGrid& OfNumRows(const MInteger& num_rows);
+  MGrid& OfNumRows(int64_t num_rows);
+  MGrid& OfNumRows(absl::string_view num_rows_expression);
+  MGrid& OfNumRows(int64_t min_rows, int64_t max_rows);
+
+  // OfNumCols()
+  //
+  // Sets the constraints for the number of columns of this grid. Same as
+  // `OfNumRows()`, but for columns.
+  MGrid& OfNumCols(const MInteger& num_cols);
+  MGrid& OfNumCols(int64_t num_cols);
+  MGrid& OfNumCols(absl::string_view num_cols_expression);
+  MGrid& OfNumCols(int64_t min_cols, int64_t max_cols);
+
+  // WithRows()
+  //
+  // Each row of the grid must satisfy these constraints. The length and the
+  // elements of the rows are already constrained by this grid, so these are
+  // mostly useful for the other properties of an `MArray` (e.g., distinct
+  // elements or their sum). Rows are generated with these constraints.
+  MGrid& WithRows(MArray<MElementType> rows);
+
+  // WithColumns()
+  //
+  // Each column of the grid must satisfy these constraints. Same as
+  // `WithRows()`, but the columns are checked after the grid is generated
+  // (instead of being generated with these constraints), so the constraints
+  // should be easy to satisfy by chance.
+  MGrid& WithColumns(MArray<MElementType> columns);
+
+  // WithSeparator()
+  //
+  // Sets the whitespace separator to be used between the elements of a row
+  // when reading/writing. Rows are always separated by a newline. Default =
+  // kSpace.
+  MGrid& WithSeparator(Whitespace separator);
+
+ private:
+  MElementType element_constraints_;
+  std::optional<MInteger> num_rows_;
+  std::optional<MInteger> num_cols_;
+  std::optional<MArray<MElementType>> row_constraints_;
+  std::optional<MArray<MElementType>> column_constraints_;
+  std::optional<Whitespace> separator_;
+  Whitespace GetSeparator() const;
+
+  // GenerateElements()
+  //
+  // Generates the `num_rows * num_cols` elements of the grid, in row-major
+  // order. `generation_limit` is the grid's generation limit.
+  absl::StatusOr<std::vector<element_value_type>> GenerateElements(
+      int64_t num_rows, int64_t num_cols,
+      std::optional<int64_t> generation_limit);
+
+  // The parts of `IsSatisfiedWithImpl()` that check the dimensions and the
+  // column constraints.
+  absl::Status IsSatisfiedWithDimensions(const grid_value_type& value) const;
+  absl::Status IsSatisfiedWithColumns(const grid_value_type& value) const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<grid_value_type> GenerateImpl() override;
+  absl::Status IsSatisfiedWithImpl(const grid_value_type& value) const override;
+  absl::Status IsSatisfiedWithGeneratedImpl(
+      const grid_value_type& value) const override;
+  absl::Status MergeFromImpl(const MGrid<MElementType>& other) override;
+  absl::StatusOr<grid_value_type> ReadImpl() override;
+  absl::Status PrintImpl(const grid_value_type& value) override;
+  std::vector<std::string> GetDependenciesImpl() const override;
+  std::string ToStringImpl() const override;
+  // ---------------------------------------------------------------------------
+};
+
+// Class template argument deduction (CTAD). Allows for `MGrid(MInteger())`
+// instead of `MGrid<MInteger>(MInteger())`.
+template <typename MoriartyElementType>
+MGrid(MoriartyElementType) -> MGrid<MoriartyElementType>;
+
+// -----------------------------------------------------------------------------
+//  Template Implementation Below
+
+template <typename T>
+Grid<T> Grid<T>::FromRows(const std::vector<std::vector<T>>& rows) {
+  int64_t num_cols = rows.empty() ? 0 : rows[0].size();
+  std::vector<T> elements;
+  elements.reserve(rows.size() * num_cols);
+  for (const std::vector<T>& row : rows) {
+    ABSL_CHECK_EQ(static_cast<int64_t>(row.size()), num_cols)
+        << "All rows must have the same length";
+    elements.insert(elements.end(), row.begin(), row.end());
+  }
+  return Grid(rows.size(), num_cols, std::move(elements));
+}
+
+template <typename T>
+std::vector<T> Grid<T>::Column(int64_t col) const {
+  std::vector<T> column;
+  column.reserve(num_rows_);
+  for (int64_t row = 0; row < num_rows_; row++)
+    column.push_back((*this)(row, col));
+  return column;
+}
+
+template <typename MElementType>
+MGrid<MElementType>::MGrid(MElementType element_constraints)
+    : MGrid<MElementType>(
+          Elements<MElementType>(std::move(element_constraints))) {}
+
+template <typename MElementType>
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MGrid<MElementType>::MGrid(Constraints&&... constraints) {
+  static_assert(
+      std::derived_from<MElementType,
+                        librarian::MVariable<
+                            MElementType, typename MElementType::value_type>>,
+      "The T used in MGrid<T> must be a Moriarty variable. For example, "
+      "MGrid<MInteger>.");
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::AddConstraint(
+    const Elements<MElementType>& constraint) {
+  return Of(constraint.GetConstraints());
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::AddConstraint(
+    const IOSeparator& constraint) {
+  return WithSeparator(constraint.GetSeparator());
+}
+
+template <typename MElementType>
+std::string MGrid<MElementType>::Typename() const {
+  return absl::StrCat("MGrid<", element_constraints_.Typename(), ">");
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::Of(MElementType variable) {
+  element_constraints_.MergeFrom(std::move(variable));
+  return *this;
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumRows(const MInteger& num_rows) {
+  if (num_rows_)
+    num_rows_->MergeFrom(num_rows);
+  else
+    num_rows_ = num_rows;
+  return *this;
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumRows(int64_t num_rows) {
+  return OfNumRows(num_rows, num_rows);
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumRows(
+    absl::string_view num_rows_expression) {
+  return OfNumRows(
+      MInteger().Between(num_rows_expression, num_rows_expression));
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumRows(int64_t min_rows,
+                                                    int64_t max_rows) {
+  return OfNumRows(MInteger().Between(min_rows, max_rows));
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumCols(const MInteger& num_cols) {
+  if (num_cols_)
+    num_cols_->MergeFrom(num_cols);
+  else
+    num_cols_ = num_cols;
+  return *this;
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumCols(int64_t num_cols) {
+  return OfNumCols(num_cols, num_cols);
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumCols(
+    absl::string_view num_cols_expression) {
+  return OfNumCols(
+      MInteger().Between(num_cols_expression, num_cols_expression));
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::OfNumCols(int64_t min_cols,
+                                                    int64_t max_cols) {
+  return OfNumCols(MInteger().Between(min_cols, max_cols));
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::WithRows(MArray<MElementType> rows) {
+  if (row_constraints_)
+    row_constraints_->MergeFrom(std::move(rows));
+  else
+    row_constraints_ = std::move(rows);
+  return *this;
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::WithColumns(
+    MArray<MElementType> columns) {
+  if (column_constraints_)
+    column_constraints_->MergeFrom(std::move(columns));
+  else
+    column_constraints_ = std::move(columns);
+  return *this;
+}
+
+template <typename MElementType>
+MGrid<MElementType>& MGrid<MElementType>::WithSeparator(Whitespace separator) {
+  if (separator_.has_value() && *separator_ != separator) {
+    this->DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        "Attempting to set multiple I/O separators for the same MGrid."));
+  } else {
+    separator_ = separator;
+  }
+  return *this;
+}
+
+template <typename MElementType>
+Whitespace MGrid<MElementType>::GetSeparator() const {
+  return separator_.value_or(Whitespace::kSpace);
+}
+
+template <typename MElementType>
+absl::Status MGrid<MElementType>::MergeFromImpl(
+    const MGrid<MElementType>& other) {
+  Of(other.element_constraints_);
+  if (other.num_rows_) OfNumRows(*other.num_rows_);
+  if (other.num_cols_) OfNumCols(*other.num_cols_);
+  if (other.row_constraints_) WithRows(*other.row_constraints_);
+  if (other.column_constraints_) WithColumns(*other.column_constraints_);
+  if (other.separator_) WithSeparator(*other.separator_);
+  return absl::OkStatus();
+}
+
+template <typename MElementType>
+auto MGrid<MElementType>::GenerateImpl() -> absl::StatusOr<grid_value_type> {
+  if (!num_rows_ || !num_cols_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a grid without both the number of rows and "
+        "the number of columns given.");
+  }
+
+  // Ensure that the dimensions are non-negative.
+  num_rows_->AtLeast(0);
+  num_cols_->AtLeast(0);
+
+  std::optional<int64_t> generation_limit =
+      this->GetApproximateGenerationLimit();
+  if (generation_limit) num_rows_->AtMost(*generation_limit);
+
+  MORIARTY_ASSIGN_OR_RETURN(int64_t num_rows,
+                            this->Random("num_rows", *num_rows_));
+
+  // The limit on the number of columns depends on the number of rows, so only
+  // this generation's copy is restricted.
+  MInteger num_cols_constraints = *num_cols_;
+  if (generation_limit) {
+    num_cols_constraints.AtMost(*generation_limit /
+                                std::max<int64_t>(num_rows, 1));
+  }
+  MORIARTY_ASSIGN_OR_RETURN(int64_t num_cols,
+                            this->Random("num_cols", num_cols_constraints));
+
+  if (num_cols > 0 && num_rows > std::numeric_limits<int>::max() / num_cols) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "A $0 x $1 grid has too many elements to generate.", num_rows,
+        num_cols));
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<element_value_type> elements,
+      GenerateElements(num_rows, num_cols, generation_limit));
+  return grid_value_type(num_rows, num_cols, std::move(elements));
+}
+
+template <typename MElementType>
+auto MGrid<MElementType>::GenerateElements(
+    int64_t num_rows, int64_t num_cols, std::optional<int64_t> generation_limit)
+    -> absl::StatusOr<std::vector<element_value_type>> {
+  const int size = num_rows * num_cols;
+
+  // The elements share the grid's generation limit. Otherwise, each of them
+  // (e.g., each string in a grid of strings) could be as large as the limit.
+  moriarty_internal::ScopedSoftGenerationLimit element_generation_limit =
+      this->LowerApproximateGenerationLimit(
+          generation_limit ? *generation_limit / std::max(size, 1) : 0);
+
+  std::vector<element_value_type> elements;
+
+  // Each row is generated as an array, straight into the grid's buffer.
+  if (row_constraints_) {
+    MArray<MElementType> row = *row_constraints_;
+    row.Of(element_constraints_).OfLength(num_cols);
+    elements.reserve(size);
+    std::string row_name;
+    for (int64_t r = 0; r < num_rows; r++) {
+      row_name.clear();
+      absl::StrAppend(&row_name, "row[", r, "]");
+      MORIARTY_ASSIGN_OR_RETURN(std::vector<element_value_type> values,
+                                this->Random(row_name, row));
+      std::move(values.begin(), values.end(), std::back_inserter(elements));
+    }
+    return elements;
+  }
+
+  // If the elements are simple enough, generate them all at once.
+  if (size > 0) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::optional<std::vector<element_value_type>> bulk_values,
+        this->RandomInBulk("elements", element_constraints_, size));
+    if (bulk_values) return *std::move(bulk_values);
+  }
+
+  // Large grids of independent elements are generated in chunks, possibly on
+  // several threads.
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::optional<std::vector<element_value_type>> parallel_values,
+      this->RandomInParallel("elements", element_constraints_, size));
+  if (parallel_values) return *std::move(parallel_values);
+
+  elements.reserve(size);
+  std::string element_name;
+  for (int64_t r = 0; r < num_rows; r++) {
+    for (int64_t c = 0; c < num_cols; c++) {
+      element_name.clear();
+      absl::StrAppend(&element_name, "element[", r, "][", c, "]");
+      MORIARTY_ASSIGN_OR_RETURN(
+          element_value_type value,
+          this->Random(element_name, element_constraints_));
+      elements.push_back(std::move(value));
+    }
+  }
+  return elements;
+}
+
+template <typename MElementType>
+absl::Status MGrid<MElementType>::IsSatisfiedWithImpl(
+    const grid_value_type& value) const {
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithDimensions(value));
+
+  // The whole buffer is checked at once. Only check the elements one at a
+  // time if the fast path cannot vouch for all of them (this also finds the
+  // first invalid element).
+  if (!this->AllSatisfyConstraints(element_constraints_, value.Elements())) {
+    for (int64_t r = 0; r < value.NumRows(); r++) {
+      for (int64_t c = 0; c < value.NumCols(); c++) {
+        MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+            this->SatisfiesConstraints(element_constraints_, value(r, c)),
+            absl::Substitute("invalid element in row $0, column $1 (0-based)",
+                             r, c)));
+      }
+    }
+  }
+
+  if (row_constraints_) {
+    // Reuse the same buffer for each row.
+    std::vector<element_value_type> row;
+    for (int64_t r = 0; r < value.NumRows(); r++) {
+      row.assign(value.Row(r).begin(), value.Row(r).end());
+      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+          this->SatisfiesConstraints(*row_constraints_, row),
+          absl::Substitute("invalid row $0 (0-based)", r)));
+    }
+  }
+
+  return IsSatisfiedWithColumns(value);
+}
+
+template <typename MElementType>
+absl::Status MGrid<MElementType>::IsSatisfiedWithGeneratedImpl(
+    const grid_value_type& value) const {
+  // `GenerateImpl()` generates (and checks) the elements and the rows with
+  // their constraints, but the dimensions may not satisfy constraints that
+  // depend on each other and the columns are never generated directly.
+  MORIARTY_RETURN_IF_ERROR(IsSatisfiedWithDimensions(value));
+  return IsSatisfiedWithColumns(value);
+}
+
+template <typename MElementType>
+absl::Status MGrid<MElementType>::IsSatisfiedWithDimensions(
+    const grid_value_type& value) const {
+  if (num_rows_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(this->SatisfiesConstraints(*num_rows_, value.NumRows()),
+                        "invalid number of rows in MGrid"));
+  }
+  if (num_cols_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(this->SatisfiesConstraints(*num_cols_, value.NumCols()),
+                        "invalid number of columns in MGrid"));
+  }
+  return absl::OkStatus();
+}
+
+template <typename MElementType>
+absl::Status MGrid<MElementType>::IsSatisfiedWithColumns(
+    const grid_value_type& value) const {
+  if (!column_constraints_) return absl::OkStatus();
+
+  // Reuse the same buffer for each column.
+  std::vector<element_value_type> column(value.NumRows());
+  for (int64_t c = 0; c < value.NumCols(); c++) {
+    for (int64_t r = 0; r < value.NumRows(); r++) column[r] = value(r, c);
+    MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+        this->SatisfiesConstraints(*column_constraints_, column),
+        absl::Substitute("invalid column $0 (0-based)", c)));
+  }
+  return absl::OkStatus();
+}
+
+template <typename MElementType>
+auto MGrid<MElementType>::ReadImpl() -> absl::StatusOr<grid_value_type> {
+  if (!num_rows_ || !num_cols_) {
+    return absl::FailedPreconditionError(
+        "Unknown dimensions of grid before read.");
+  }
+  std::optional<int64_t> num_rows =
+      this->GetUniqueValue("num_rows", *num_rows_);
+  std::optional<int64_t> num_cols =
+      this->GetUniqueValue("num_cols", *num_cols_);
+  if (!num_rows || !num_cols) {
+    return absl::FailedPreconditionError(
+        "Cannot determine the dimensions of grid before read.");
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(librarian::IOConfig * io_config,
+                            this->GetIOConfig());
+  grid_value_type grid(*num_rows, *num_cols);
+  std::string element_name;
+  for (int64_t r = 0; r < *num_rows; r++) {
+    if (r > 0) {
+      MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(Whitespace::kNewline));
+    }
+    // Integers are read directly, a whole row at a time.
+    if constexpr (std::same_as<MElementType, MInteger>) {
+      MORIARTY_RETURN_IF_ERROR(
+          io_config->ReadIntegers(grid.Row(r), GetSeparator()));
+    } else {
+      for (int64_t c = 0; c < *num_cols; c++) {
+        if (c > 0) {
+          MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(GetSeparator()));
+        }
+        element_name.clear();
+        absl::StrAppend(&element_name, "element[", r, "][", c, "]");
+        MORIARTY_ASSIGN_OR_RETURN(
+            element_value_type element,
+            this->Read(element_name, element_constraints_));
+        grid(r, c) = std::move(element);
+      }
+    }
+  }
+  return grid;
+}
+
+template <typename MElementType>
+absl::Status MGrid<MElementType>::PrintImpl(const grid_value_type& value) {
+  MORIARTY_ASSIGN_OR_RETURN(librarian::IOConfig * io_config,
+                            this->GetIOConfig());
+  std::string element_name;
+  for (int64_t r = 0; r < value.NumRows(); r++) {
+    if (r > 0) {
+      MORIARTY_RETURN_IF_ERROR(
+          io_config->PrintWhitespace(Whitespace::kNewline));
+    }
+    // Integers are written directly, a whole row at a time.
+    if constexpr (std::same_as<MElementType, MInteger>) {
+      MORIARTY_RETURN_IF_ERROR(
+          io_config->PrintIntegers(value.Row(r), GetSeparator()));
+    } else {
+      for (int64_t c = 0; c < value.NumCols(); c++) {
+        if (c > 0) {
+          MORIARTY_RETURN_IF_ERROR(io_config->PrintWhitespace(GetSeparator()));
+        }
+        element_name.clear();
+        absl::StrAppend(&element_name, "element[", r, "][", c, "]");
+        MORIARTY_RETURN_IF_ERROR(
+            this->Print(element_name, element_constraints_, value(r, c)));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+template <typename MElementType>
+std::vector<std::string> MGrid<MElementType>::GetDependenciesImpl() const {
+  std::vector<std::string> deps = this->GetDependencies(element_constraints_);
+  if (num_rows_)
+    absl::c_move(this->GetDependencies(*num_rows_), std::back_inserter(deps));
+  if (num_cols_)
+    absl::c_move(this->GetDependencies(*num_cols_), std::back_inserter(deps));
+  if (row_constraints_) {
+    absl::c_move(this->GetDependencies(*row_constraints_),
+                 std::back_inserter(deps));
+  }
+  if (column_constraints_) {
+    absl::c_move(this->GetDependencies(*column_constraints_),
+                 std::back_inserter(deps));
+  }
+  return deps;
+}
+
+template <typename MElementType>
+std::string MGrid<MElementType>::ToStringImpl() const {
+  std::string result =
+      absl::StrCat("elements: (", element_constraints_.ToString(), "); ");
+  if (num_rows_)
+    absl::StrAppend(&result, "rows: (", num_rows_->ToString(), "); ");
+  if (num_cols_)
+    absl::StrAppend(&result, "columns: (", num_cols_->ToString(), "); ");
+  if (row_constraints_) {
+    absl::StrAppend(&result, "each row: (", row_constraints_->ToString(),
+                    "); ");
+  }
+  if (column_constraints_) {
+    absl::StrAppend(&result, "each column: (", column_constraints_->ToString(),
+                    "); ");
+  }
+  if (separator_) {
+    absl::StrAppend(&result, "separator: ",
+                    librarian::WhitespaceName(*separator_), "; ");
+  }
+  return result;
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MGRID_H_
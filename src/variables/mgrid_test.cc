@@ -0,0 +1,187 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mgrid.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::moriarty_testing::Context;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::AllOf;
+using ::testing::AnyOf;
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::Property;
+
+TEST(MGridTest, TypenameIsCorrect) {
+  EXPECT_EQ(MGrid(MInteger()).Typename(), "MGrid<MInteger>");
+  EXPECT_EQ(MGrid(MString()).Typename(), "MGrid<MString>");
+}
+
+TEST(MGridTest, GridStoresTheRowsContiguously) {
+  Grid<int64_t> grid = Grid<int64_t>::FromRows({{1, 2, 3}, {4, 5, 6}});
+
+  EXPECT_EQ(grid.NumRows(), 2);
+  EXPECT_EQ(grid.NumCols(), 3);
+  EXPECT_THAT(grid.Elements(), ElementsAre(1, 2, 3, 4, 5, 6));
+  EXPECT_THAT(grid.Row(1), ElementsAre(4, 5, 6));
+  EXPECT_THAT(grid.Column(2), ElementsAre(3, 6));
+  EXPECT_EQ(grid(1, 0), 4);
+}
+
+TEST(MGridTest, GenerateRespectsTheDimensionsAndElements) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      Grid<int64_t> grid,
+      Generate(
+          MGrid(MInteger().Between(1, 10)).OfNumRows(5, 20).OfNumCols(30)));
+
+  EXPECT_THAT(grid.NumRows(), AllOf(Ge(5), Le(20)));
+  EXPECT_EQ(grid.NumCols(), 30);
+  EXPECT_THAT(grid.Elements(), Each(AllOf(Ge(1), Le(10))));
+}
+
+TEST(MGridTest, GenerateWithDimensionsFromOtherVariablesWorks) {
+  EXPECT_THAT(Generate(MGrid(MInteger()).OfNumRows("N").OfNumCols("M"),
+                       Context()
+                           .WithValue<MInteger>("N", 7)
+                           .WithValue<MInteger>("M", 3)),
+              IsOkAndHolds(AllOf(Property(&Grid<int64_t>::NumRows, 7),
+                                 Property(&Grid<int64_t>::NumCols, 3))));
+}
+
+TEST(MGridTest, GenerateWithoutDimensionsFails) {
+  EXPECT_THAT(Generate(MGrid(MInteger()).OfNumRows(3)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(MGrid(MInteger()).OfNumCols(3)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MGridTest, GenerateWithRowConstraintsGeneratesEachRowWithThem) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      Grid<int64_t> grid,
+      Generate(MGrid(MInteger().Between(1, 5))
+                   .OfNumRows(10)
+                   .OfNumCols(5)
+                   .WithRows(MArray<MInteger>().WithDistinctElements())));
+
+  for (int64_t r = 0; r < grid.NumRows(); r++) {
+    std::vector<int64_t> row(grid.Row(r).begin(), grid.Row(r).end());
+    absl::c_sort(row);
+    EXPECT_THAT(row, ElementsAre(1, 2, 3, 4, 5));
+  }
+}
+
+TEST(MGridTest, GenerateChecksColumnConstraints) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      Grid<int64_t> grid,
+      Generate(MGrid(MInteger().Between(1, 2))
+                   .OfNumRows(2)
+                   .OfNumCols(2)
+                   .WithColumns(MArray<MInteger>().WithSum(3))));
+
+  for (int64_t c = 0; c < grid.NumCols(); c++) {
+    EXPECT_THAT(grid.Column(c), AnyOf(ElementsAre(1, 2), ElementsAre(2, 1)));
+  }
+}
+
+TEST(MGridTest, IsSatisfiedWithChecksTheDimensions) {
+  Grid<int64_t> grid = Grid<int64_t>::FromRows({{1, 2, 3}, {4, 5, 6}});
+
+  EXPECT_THAT(MGrid(MInteger()).OfNumRows(2).OfNumCols(3),
+              IsSatisfiedWith(grid));
+  EXPECT_THAT(MGrid(MInteger()).OfNumRows(3).OfNumCols(3),
+              IsNotSatisfiedWith(grid, "rows"));
+  EXPECT_THAT(MGrid(MInteger()).OfNumRows(2).OfNumCols(2),
+              IsNotSatisfiedWith(grid, "columns"));
+}
+
+TEST(MGridTest, IsSatisfiedWithChecksEveryElement) {
+  Grid<int64_t> grid = Grid<int64_t>::FromRows({{1, 2, 3}, {4, 5, 6}});
+
+  EXPECT_THAT(MGrid(MInteger().Between(1, 6)), IsSatisfiedWith(grid));
+  EXPECT_THAT(MGrid(MInteger().Between(1, 5)),
+              IsNotSatisfiedWith(grid, "row 1, column 2"));
+}
+
+TEST(MGridTest, IsSatisfiedWithChecksRowsAndColumns) {
+  Grid<int64_t> grid = Grid<int64_t>::FromRows({{1, 2, 3}, {3, 2, 1}});
+
+  EXPECT_THAT(MGrid(MInteger()).WithRows(MArray<MInteger>().WithSum(6)),
+              IsSatisfiedWith(grid));
+  EXPECT_THAT(MGrid(MInteger()).WithColumns(MArray<MInteger>().WithSum(4)),
+              IsSatisfiedWith(grid));
+  EXPECT_THAT(MGrid(MInteger()).WithRows(
+                  MArray<MInteger>().WithElementOrder(ElementOrder::Sorted())),
+              IsNotSatisfiedWith(grid, "row 1"));
+  EXPECT_THAT(MGrid(MInteger()).WithColumns(
+                  MArray<MInteger>().WithDistinctElements()),
+              IsNotSatisfiedWith(grid, "column 1"));
+}
+
+TEST(MGridTest, PrintWritesOneRowPerLine) {
+  Grid<int64_t> grid = Grid<int64_t>::FromRows({{1, 2, 3}, {4, 5, 6}});
+
+  EXPECT_THAT(Print(MGrid(MInteger()), grid), IsOkAndHolds("1 2 3\n4 5 6"));
+  EXPECT_THAT(Print(MGrid(MInteger()).WithSeparator(Whitespace::kTab), grid),
+              IsOkAndHolds("1\t2\t3\n4\t5\t6"));
+  EXPECT_THAT(Print(MGrid(MString()),
+                    Grid<std::string>::FromRows({{"ab", "c"}, {"d", "ef"}})),
+              IsOkAndHolds("ab c\nd ef"));
+}
+
+TEST(MGridTest, ReadReadsOneRowPerLine) {
+  EXPECT_THAT(
+      Read(MGrid(MInteger()).OfNumRows(2).OfNumCols(3), "1 2 3\n4 5 6"),
+      IsOkAndHolds(Grid<int64_t>::FromRows({{1, 2, 3}, {4, 5, 6}})));
+  EXPECT_THAT(
+      Read(MGrid(MString()).OfNumRows(2).OfNumCols(2), "ab c\nd ef"),
+      IsOkAndHolds(Grid<std::string>::FromRows({{"ab", "c"}, {"d", "ef"}})));
+}
+
+TEST(MGridTest, ReadWithWrongWhitespaceFails) {
+  EXPECT_THAT(Read(MGrid(MInteger()).OfNumRows(2).OfNumCols(2), "1 2 3 4"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MGridTest, ReadWithUnknownDimensionsFails) {
+  EXPECT_THAT(Read(MGrid(MInteger()).OfNumRows(2), "1 2\n3 4"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -14,26 +14,34 @@
 
 #include "src/variables/minteger.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <optional>
-#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "src/errors.h"
+#include "src/internal/integer_distributions.h"
+#include "src/internal/random_config.h"
 #include "src/internal/random_engine.h"
 #include "src/internal/range.h"
+#include "src/internal/shrink.h"
 #include "src/librarian/io_config.h"
 #include "src/librarian/mvariable.h"
 #include "src/librarian/size_property.h"
@@ -48,7 +56,7 @@ namespace moriarty {
 using ::moriarty::librarian::IOConfig;
 
 MInteger& MInteger::AddConstraint(const Exactly<int64_t>& constraint) {
-  bounds_.Intersect(Range(constraint.GetValue(), constraint.GetValue()));
+  IntersectBounds(Range(constraint.GetValue(), constraint.GetValue()));
   return *this;
 }
 
@@ -65,22 +73,22 @@ MInteger& MInteger::AddConstraint(const Exactly<std::string>& constraint) {
     return *this;
   }
 
-  bounds_.Intersect(r);
+  IntersectBounds(r);
   return *this;
 }
 
 MInteger& MInteger::AddConstraint(const class Between& constraint) {
-  bounds_.Intersect(constraint.GetRange());
+  IntersectBounds(constraint.GetRange());
   return *this;
 }
 
 MInteger& MInteger::AddConstraint(const class AtMost& constraint) {
-  bounds_.Intersect(constraint.GetRange());
+  IntersectBounds(constraint.GetRange());
   return *this;
 }
 
 MInteger& MInteger::AddConstraint(const class AtLeast& constraint) {
-  bounds_.Intersect(constraint.GetRange());
+  IntersectBounds(constraint.GetRange());
   return *this;
 }
 
@@ -98,6 +106,52 @@ MInteger& MInteger::AddConstraint(const SizeCategory& constraint) {
   return *this;
 }
 
+MInteger& MInteger::AddConstraint(const Distribution& constraint) {
+  if (absl::Status status = moriarty_internal::ValidateIntegerDistribution(
+          constraint.GetDistribution());
+      !status.ok()) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        absl::StrCat("Invalid distribution. ", status.message())));
+    return *this;
+  }
+  distribution_ = constraint.GetDistribution();
+  return *this;
+}
+
+MInteger& MInteger::AddConstraint(const MultipleOf& constraint) {
+  AddModEquals(ModEquals(constraint.GetFactor(), 0));
+  return *this;
+}
+
+MInteger& MInteger::AddConstraint(const ModEquals& constraint) {
+  AddModEquals(constraint);
+  return *this;
+}
+
+MInteger& MInteger::AddConstraint(const NotIn& constraint) {
+  arithmetic_.Mutable().AddNotIn(constraint.GetValues());
+  extremes_cache_ =
+      std::make_shared<ExtremesCache>(bounds_.Get(), arithmetic_.Get());
+  return *this;
+}
+
+MInteger& MInteger::AddConstraint(const Prime& constraint) {
+  arithmetic_.Mutable().AddPrime();
+  extremes_cache_ =
+      std::make_shared<ExtremesCache>(bounds_.Get(), arithmetic_.Get());
+  return *this;
+}
+
+void MInteger::AddModEquals(const ModEquals& constraint) {
+  if (absl::Status status = arithmetic_.Mutable().AddModEquals(
+          constraint.GetModulus(), constraint.GetRemainder());
+      !status.ok()) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(status.message()));
+  }
+  extremes_cache_ =
+      std::make_shared<ExtremesCache>(bounds_.Get(), arithmetic_.Get());
+}
+
 MInteger& MInteger::Is(absl::string_view integer_expression) {
   return AddConstraint(Exactly(integer_expression));
 }
@@ -141,55 +195,212 @@ MInteger& MInteger::AtMost(absl::string_view maximum_integer_expression) {
 }
 
 std::optional<int64_t> MInteger::GetUniqueValueImpl() const {
+  // Without dependent variables, the answer never changes.
+  const ExtremesCache& cache = *extremes_cache_;
+  if (cache.needed_variables.ok() && cache.needed_variables->empty())
+    return cache.unique_value;
+
   absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
   if (!extremes.ok()) return std::nullopt;
   if (extremes->min != extremes->max) return std::nullopt;
+  if (arithmetic_.Get().FindViolation(extremes->min)) return std::nullopt;
 
   return extremes->min;
 }
 
-absl::StatusOr<Range::ExtremeValues> MInteger::GetExtremeValues() {
-  MORIARTY_ASSIGN_OR_RETURN(
-      absl::flat_hash_set<std::string> needed_dependent_variables,
-      bounds_.NeededVariables(), _ << "Error getting the needed variables");
+std::shared_ptr<const std::vector<int64_t>> MInteger::EnumerateImpl(
+    int64_t max_values) const {
+  // Other sizes and distributions do not pick every value equally often.
+  if (approx_size_ != CommonSize::kAny ||
+      distribution_ != moriarty_internal::IntegerDistribution()) {
+    return nullptr;
+  }
+  // The range must not change between calls to `Generate()`.
+  ExtremesCache& cache = *extremes_cache_;
+  if (!cache.needed_variables.ok() || !cache.needed_variables->empty())
+    return nullptr;
+  {
+    absl::MutexLock lock(&cache.mutex);
+    if (cache.domain_max_values == max_values) return cache.domain;
+  }
 
-  absl::flat_hash_map<std::string, int64_t> dependent_variables;
+  std::shared_ptr<const std::vector<int64_t>> domain;
+  absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
+  if (extremes.ok() &&
+      absl::int128(extremes->max) - extremes->min + 1 <= max_values) {
+    auto values = std::make_shared<std::vector<int64_t>>();
+    const moriarty_internal::ArithmeticConstraints& arithmetic =
+        arithmetic_.Get();
+    for (std::optional<int64_t> value =
+             arithmetic.FirstValid(extremes->min, extremes->max);
+         value; value = arithmetic.FirstValid(*value + 1, extremes->max)) {
+      values->push_back(*value);
+      if (*value == extremes->max) break;
+    }
+    domain = std::move(values);
+  }
 
-  for (absl::string_view name : needed_dependent_variables) {
-    MORIARTY_ASSIGN_OR_RETURN(
-        dependent_variables[name], GenerateValue<MInteger>(name),
-        _ << "Error getting the dependent variable " << name);
+  // Another thread may have computed it first. Return the same vector, since
+  // the values that satisfy the custom constraints are cached by its address.
+  absl::MutexLock lock(&cache.mutex);
+  if (cache.domain_max_values != max_values) {
+    cache.domain = std::move(domain);
+    cache.domain_max_values = max_values;
   }
+  return cache.domain;
+}
 
-  MORIARTY_ASSIGN_OR_RETURN(std::optional<Range::ExtremeValues> extremes,
-                            bounds_.Extremes(dependent_variables));
-  if (!extremes) return absl::InvalidArgumentError("Valid range is empty");
-  return *extremes;
+bool MInteger::IsKnownUnsatisfiableImpl() const {
+  const absl::StatusOr<std::vector<std::string>>& needed_variables =
+      extremes_cache_->needed_variables;
+  if (!needed_variables.ok()) return false;
+
+  absl::flat_hash_map<std::string, int64_t> known_values;
+  for (const std::string& name : *needed_variables) {
+    absl::StatusOr<int64_t> value = GetKnownValue<MInteger>(name);
+    if (!value.ok()) return false;  // Not known yet, so we cannot tell.
+    known_values[name] = *value;
+  }
+
+  absl::StatusOr<std::optional<Range::ExtremeValues>> extremes =
+      bounds_.Get().Extremes(known_values);
+  return extremes.ok() && !extremes->has_value();
 }
 
-absl::StatusOr<Range::ExtremeValues> MInteger::GetExtremeValues() const {
-  MORIARTY_ASSIGN_OR_RETURN(
-      absl::flat_hash_set<std::string> needed_dependent_variables,
-      bounds_.NeededVariables(), _ << "Error getting the needed variables");
+const Range* MInteger::GetIntegerBoundsImpl() const { return &bounds_.Get(); }
 
-  absl::flat_hash_map<std::string, int64_t> dependent_variables;
+void MInteger::TightenIntegerBoundsImpl(const Range& bounds) {
+  IntersectBounds(bounds);
+}
+
+namespace {
+
+absl::StatusOr<std::vector<std::string>> SortedNeededVariables(
+    const Range& bounds) {
+  MORIARTY_ASSIGN_OR_RETURN(absl::flat_hash_set<std::string> needed,
+                            bounds.NeededVariables());
+  std::vector<std::string> sorted(needed.begin(), needed.end());
+  absl::c_sort(sorted);
+  return sorted;
+}
+
+// Returns the unique value in `bounds` that satisfies `arithmetic`, if `bounds`
+// does not depend on other variables and there is exactly one such value.
+std::optional<int64_t> StaticUniqueValue(
+    const Range& bounds,
+    const moriarty_internal::ArithmeticConstraints& arithmetic) {
+  absl::StatusOr<std::optional<Range::ExtremeValues>> extremes =
+      bounds.Extremes();
+  if (!extremes.ok() || !extremes->has_value()) return std::nullopt;
+  if ((*extremes)->min != (*extremes)->max) return std::nullopt;
+  if (arithmetic.FindViolation((*extremes)->min)) return std::nullopt;
+  return (*extremes)->min;
+}
+
+// Returns the part of [1, `n`] that values of size `size` should be generated
+// from (as in `librarian::GetRange()`), or `std::nullopt` if there is none.
+// Unlike `GetRange()`, `n` may be as large as 2^64.
+std::optional<std::pair<absl::int128, absl::int128>> SizedPart(
+    CommonSize size, absl::int128 n) {
+  constexpr int64_t kInt64Max = std::numeric_limits<int64_t>::max();
+  auto part = [](const Range& range)
+      -> std::optional<std::pair<absl::int128, absl::int128>> {
+    absl::StatusOr<std::optional<Range::ExtremeValues>> extremes =
+        range.Extremes();
+    if (!extremes.ok() || !extremes->has_value()) return std::nullopt;
+    return std::make_pair(absl::int128((*extremes)->min),
+                          absl::int128((*extremes)->max));
+  };
+
+  if (n <= kInt64Max) return part(librarian::GetRange(size, int64_t(n)));
+
+  // For `n` this large, the thresholds of the smaller sizes no longer depend
+  // on `n`, and the larger sizes extend up to `n`.
+  switch (size) {
+    case CommonSize::kLarge: {
+      auto large = part(librarian::GetLargeRange(kInt64Max));
+      if (!large) return std::nullopt;
+      return std::make_pair(large->first, n);
+    }
+    case CommonSize::kHuge:
+      return std::make_pair(n / 10 * 9, n);
+    case CommonSize::kMax:
+      return std::make_pair(n, n);
+    default:
+      return part(librarian::GetRange(size, kInt64Max));
+  }
+}
+
+}  // namespace
+
+MInteger::ExtremesCache::ExtremesCache(
+    const Range& bounds,
+    const moriarty_internal::ArithmeticConstraints& arithmetic)
+    : needed_variables(SortedNeededVariables(bounds)),
+      unique_value(needed_variables.ok() && needed_variables->empty()
+                       ? StaticUniqueValue(bounds, arithmetic)
+                       : std::nullopt) {}
+
+void MInteger::IntersectBounds(const Range& range) {
+  bounds_.Mutable().Intersect(range);
+  extremes_cache_ =
+      std::make_shared<ExtremesCache>(bounds_.Get(), arithmetic_.Get());
+}
 
-  for (absl::string_view name : needed_dependent_variables) {
+template <typename GetValueFn>
+absl::StatusOr<Range::ExtremeValues> MInteger::GetExtremeValuesImpl(
+    GetValueFn get_value) const {
+  ExtremesCache& cache = *extremes_cache_;
+  MORIARTY_RETURN_IF_ERROR(cache.needed_variables.status())
+      << "Error getting the needed variables";
+  const std::vector<std::string>& needed_dependent_variables =
+      *cache.needed_variables;
+
+  absl::InlinedVector<int64_t, 4> values(needed_dependent_variables.size());
+  for (int i = 0; i < needed_dependent_variables.size(); i++) {
     MORIARTY_ASSIGN_OR_RETURN(
-        dependent_variables[name], GetKnownValue<MInteger>(name),
-        _ << "Error getting the dependent variable " << name);
+        values[i], get_value(needed_dependent_variables[i]),
+        _ << "Error getting the dependent variable "
+          << needed_dependent_variables[i]);
   }
 
+  {
+    absl::MutexLock lock(&cache.mutex);
+    if (cache.extremes && cache.values == values) return *cache.extremes;
+  }
+
+  absl::flat_hash_map<std::string, int64_t> dependent_variables;
+  for (int i = 0; i < needed_dependent_variables.size(); i++)
+    dependent_variables[needed_dependent_variables[i]] = values[i];
+
   MORIARTY_ASSIGN_OR_RETURN(std::optional<Range::ExtremeValues> extremes,
-                            bounds_.Extremes(dependent_variables));
+                            bounds_.Get().Extremes(dependent_variables));
   if (!extremes) return absl::InvalidArgumentError("Valid range is empty");
+
+  absl::MutexLock lock(&cache.mutex);
+  cache.values = std::move(values);
+  cache.extremes = *extremes;
   return *extremes;
 }
 
+absl::StatusOr<Range::ExtremeValues> MInteger::GetExtremeValues() {
+  return GetExtremeValuesImpl(
+      [this](absl::string_view name) { return GenerateValue<MInteger>(name); });
+}
+
+absl::StatusOr<Range::ExtremeValues> MInteger::GetExtremeValues() const {
+  return GetExtremeValuesImpl(
+      [this](absl::string_view name) { return GetKnownValue<MInteger>(name); });
+}
+
 MInteger& MInteger::WithSize(CommonSize size) {
   return AddConstraint(SizeCategory(size));
 }
 
+MInteger& MInteger::WithDistribution(const Distribution& distribution) {
+  return AddConstraint(distribution);
+}
+
 absl::Status MInteger::OfSizeProperty(Property property) {
   if (property.category != "size") {
     return absl::InvalidArgumentError(
@@ -213,33 +424,190 @@ absl::StatusOr<int64_t> MInteger::GenerateImpl() {
 
   if (approx_size_ == CommonSize::kAny) return GenerateInRange(extremes);
 
-  // TODO(darcybest): Make this work for larger ranges.
-  if ((extremes.min <= std::numeric_limits<int64_t>::min() / 2) &&
-      (extremes.max >= std::numeric_limits<int64_t>::max() / 2)) {
-    absl::StatusOr<int64_t> value = GenerateInRange(extremes);
-    if (value.ok()) return value;
+  absl::StatusOr<int64_t> value = GenerateInRange(GetSizedExtremes(extremes));
+  // If no value of this size satisfies `arithmetic_`, ignore the size.
+  if (absl::IsNotFound(value.status())) return GenerateInRange(extremes);
+  return value;
+}
+
+Range::ExtremeValues MInteger::GetSizedExtremes(
+    Range::ExtremeValues extremes) const {
+  if (approx_size_ == CommonSize::kAny) return extremes;
+
+  ExtremesCache& cache = *extremes_cache_;
+  {
+    absl::MutexLock lock(&cache.mutex);
+    if (cache.sized_extremes_key == extremes) {
+      auto it = cache.sized_extremes.find(approx_size_);
+      if (it != cache.sized_extremes.end()) return it->second;
+    }
+  }
+
+  // `max - min + 1` may not fit in an `int64_t` (up to 2^64).
+  std::optional<std::pair<absl::int128, absl::int128>> part =
+      SizedPart(approx_size_, absl::int128(extremes.max) - extremes.min + 1);
+
+  // If a special size has been requested, generate from that part. If there
+  // is no such part, generate from the full range.
+  Range::ExtremeValues sized = extremes;
+  if (part.has_value()) {
+    // Offset the values appropriately. These parts are for [1, N].
+    sized.min = static_cast<int64_t>(part->first + extremes.min - 1);
+    sized.max = static_cast<int64_t>(part->second + extremes.min - 1);
   }
 
-  // Note: `max - min + 1` does not overflow because of the check above.
-  Range range =
-      librarian::GetRange(approx_size_, extremes.max - extremes.min + 1);
+  absl::MutexLock lock(&cache.mutex);
+  if (cache.sized_extremes_key != extremes) {
+    cache.sized_extremes.clear();
+    cache.sized_extremes_key = extremes;
+  }
+  cache.sized_extremes[approx_size_] = sized;
+  return sized;
+}
+
+absl::StatusOr<std::optional<std::vector<int64_t>>>
+MInteger::GenerateInBulkImpl(int n) {
+  // Let `Generate()` deal with (and possibly retry) any errors.
+  absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
+  if (!extremes.ok()) return std::nullopt;
+  extremes = GetSizedExtremes(*extremes);
 
-  MORIARTY_ASSIGN_OR_RETURN(std::optional<Range::ExtremeValues> rng_extremes,
-                            range.Extremes());
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager<MInteger, int64_t>(this)
+          .GetRandomEngine();
 
-  // If a special size has been requested, attempt to generate that. If that
-  // fails, generate the full range.
-  if (rng_extremes) {
-    // Offset the values appropriately. These ranges were supposed to be for
-    // [1, N].
-    rng_extremes->min += extremes.min - 1;
-    rng_extremes->max += extremes.min - 1;
+  // Identical to calling `GenerateInRange(*extremes)` `n` times.
+  std::vector<int64_t> values(n);
+  if (arithmetic_.Get().IsTrivial()) {
+    MORIARTY_RETURN_IF_ERROR(moriarty_internal::RandIntsFromDistribution(
+        rng, extremes->min, extremes->max, distribution_,
+        absl::MakeSpan(values)));
+    return values;
+  }
+  for (int64_t& value : values) {
+    absl::StatusOr<int64_t> generated = GenerateInRange(*extremes);
+    if (!generated.ok()) return std::nullopt;  // Let `Generate()` fall back.
+    value = *generated;
+  }
+  return values;
+}
 
-    absl::StatusOr<int64_t> value = GenerateInRange(*rng_extremes);
-    if (value.ok()) return value;
+absl::StatusOr<std::optional<std::vector<int64_t>>>
+MInteger::GenerateDistinctInBulkImpl(int n) {
+  // Sized integers may need to fall back to the full range, so go one by one.
+  // Same for non-uniform distributions, which would be skewed by this.
+  if (approx_size_ != CommonSize::kAny) return std::nullopt;
+  if (distribution_.shape !=
+          moriarty_internal::IntegerDistribution::Shape::kUniform ||
+      !arithmetic_.Get().IsTrivial()) {
+    return std::nullopt;
   }
 
-  return GenerateInRange(extremes);
+  // Let `Generate()` deal with (and possibly retry) any errors.
+  absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
+  if (!extremes.ok()) return std::nullopt;
+
+  // The number of values in the range must fit in an int64_t.
+  uint64_t width = static_cast<uint64_t>(extremes->max) -
+                   static_cast<uint64_t>(extremes->min);
+  if (width >= std::numeric_limits<int64_t>::max()) return std::nullopt;
+  int64_t num_values = static_cast<int64_t>(width) + 1;
+
+  // Not enough values. Let the caller produce the appropriate error.
+  if (num_values < n) return std::nullopt;
+
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager<MInteger, int64_t>(this)
+          .GetRandomEngine();
+
+  return moriarty_internal::DistinctIntegers(rng, num_values, n,
+                                             extremes->min);
+}
+
+absl::StatusOr<std::optional<std::vector<int64_t>>>
+MInteger::GenerateSortedInBulkImpl(int n, bool strictly_increasing) {
+  // Same restrictions as `GenerateDistinctInBulkImpl()`.
+  if (approx_size_ != CommonSize::kAny) return std::nullopt;
+  if (distribution_.shape !=
+          moriarty_internal::IntegerDistribution::Shape::kUniform ||
+      !arithmetic_.Get().IsTrivial()) {
+    return std::nullopt;
+  }
+
+  // Let `Generate()` deal with (and possibly retry) any errors.
+  absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
+  if (!extremes.ok()) return std::nullopt;
+
+  // A non-decreasing sequence a_0 <= a_1 <= ... is the increasing sequence
+  // a_0 + 0 < a_1 + 1 < ... in a range that is n - 1 values longer.
+  uint64_t width = static_cast<uint64_t>(extremes->max) -
+                   static_cast<uint64_t>(extremes->min);
+  if (!strictly_increasing && n > 0) width += n - 1;
+  if (width >= std::numeric_limits<int64_t>::max()) return std::nullopt;
+  int64_t num_values = static_cast<int64_t>(width) + 1;
+
+  // Not enough values. Let the caller produce the appropriate error.
+  if (num_values < n) return std::nullopt;
+
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager<MInteger, int64_t>(this)
+          .GetRandomEngine();
+
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<int64_t> values,
+      moriarty_internal::SortedDistinctIntegers<int64_t>(rng, num_values, n));
+  for (int i = 0; i < n; i++) {
+    if (!strictly_increasing) values[i] -= i;
+    values[i] += extremes->min;
+  }
+  return values;
+}
+
+absl::StatusOr<std::optional<std::vector<int64_t>>>
+MInteger::GenerateInBulkWithSumImpl(int n, int64_t sum) {
+  // Same restrictions as `GenerateDistinctInBulkImpl()`.
+  if (approx_size_ != CommonSize::kAny) return std::nullopt;
+  if (distribution_.shape !=
+          moriarty_internal::IntegerDistribution::Shape::kUniform ||
+      !arithmetic_.Get().IsTrivial()) {
+    return std::nullopt;
+  }
+
+  // Let `Generate()` deal with (and possibly retry) any errors.
+  absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
+  if (!extremes.ok()) return std::nullopt;
+
+  // Shift every value by `min`, so they are all in [0, max - min]. No value
+  // can be more than the (shifted) sum, so larger ranges are cut down to it.
+  absl::int128 shifted_sum = absl::int128(sum) - absl::int128(n) * extremes->min;
+  absl::int128 capacity = absl::int128(extremes->max) - extremes->min;
+  if (shifted_sum < 0) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The sum of $0 integers that are at least $1 cannot be $2", n,
+        extremes->min, sum));
+  }
+  if (shifted_sum > capacity * n) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The sum of $0 integers that are at most $1 cannot be $2", n,
+        extremes->max, sum));
+  }
+  if (shifted_sum >
+      absl::int128(std::numeric_limits<int64_t>::max()) - std::max(n, 1)) {
+    return std::nullopt;
+  }
+  capacity = std::min(capacity, shifted_sum);
+
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager<MInteger, int64_t>(this)
+          .GetRandomEngine();
+
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<int64_t> values,
+      moriarty_internal::BoundedRandomComposition<int64_t>(
+          rng, static_cast<int64_t>(shifted_sum), n, 0,
+          static_cast<int64_t>(capacity)));
+  for (int64_t& value : values) value += extremes->min;
+  return values;
 }
 
 absl::StatusOr<int64_t> MInteger::GenerateInRange(
@@ -251,11 +619,16 @@ absl::StatusOr<int64_t> MInteger::GenerateInRange(
       moriarty_internal::MVariableManager<MInteger, int64_t>(this)
           .GetRandomEngine();
 
-  return rng.RandInt(extremes.min, extremes.max);
+  if (!arithmetic_.Get().IsTrivial()) {
+    return arithmetic_.Get().Sample(rng, extremes.min, extremes.max,
+                                    distribution_);
+  }
+  return moriarty_internal::RandIntFromDistribution(
+      rng, extremes.min, extremes.max, distribution_);
 }
 
 absl::Status MInteger::MergeFromImpl(const MInteger& other) {
-  bounds_.Intersect(other.bounds_);
+  IntersectBounds(other.bounds_.Get());
 
   std::optional<CommonSize> merged_size =
       librarian::MergeSizes(approx_size_, other.approx_size_);
@@ -265,28 +638,28 @@ absl::Status MInteger::MergeFromImpl(const MInteger& other) {
   }
   WithSize(*merged_size);
 
+  if (other.distribution_.shape !=
+      moriarty_internal::IntegerDistribution::Shape::kUniform) {
+    distribution_ = other.distribution_;
+  }
+  if (!other.arithmetic_.Get().IsTrivial()) {
+    MORIARTY_RETURN_IF_ERROR(
+        arithmetic_.Mutable().MergeFrom(other.arithmetic_.Get()));
+    extremes_cache_ =
+        std::make_shared<ExtremesCache>(bounds_.Get(), arithmetic_.Get());
+  }
+
   return absl::OkStatus();
 }
 
 absl::StatusOr<int64_t> MInteger::ReadImpl() {
   MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
-  // TODO(darcybest): do parsing ourselves?
-  MORIARTY_ASSIGN_OR_RETURN(std::string token, io_config->ReadToken());
-  std::stringstream is(token);
-
-  int64_t value;
-  if (!(is >> value))
-    return absl::InvalidArgumentError("Unable to read an integer.");
-  std::string garbage;
-  if (is >> garbage)
-    return absl::InvalidArgumentError(
-        "Found extra characters after reading an integer!");
-  return value;
+  return io_config->ReadInteger();
 }
 
 absl::Status MInteger::PrintImpl(const int64_t& value) {
   MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
-  return io_config->PrintToken(std::to_string(value));
+  return io_config->PrintInteger(value);
 }
 
 absl::Status MInteger::IsSatisfiedWithImpl(const int64_t& value) const {
@@ -299,13 +672,59 @@ absl::Status MInteger::IsSatisfiedWithImpl(const int64_t& value) const {
                       absl::Substitute("$0 is not in the range [$1, $2]", value,
                                        extremes->min, extremes->max)));
 
+  if (std::optional<std::string> violation =
+          arithmetic_.Get().FindViolation(value)) {
+    return UnsatisfiedConstraintError(*violation);
+  }
+
   return absl::OkStatus();
 }
 
+bool MInteger::AllSatisfiedWithImpl(absl::Span<const int64_t> values) const {
+  if (values.empty()) return true;
+
+  // Let `IsSatisfiedWithImpl()` produce the error message.
+  absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
+  if (!extremes.ok()) return false;
+
+  // A branch-free reduction, which the compiler is able to vectorize.
+  int64_t lo = values[0];
+  int64_t hi = values[0];
+  for (int64_t value : values) {
+    lo = std::min(lo, value);
+    hi = std::max(hi, value);
+  }
+  if (extremes->min > lo || hi > extremes->max) return false;
+
+  if (arithmetic_.Get().IsTrivial()) return true;
+  return absl::c_none_of(values, [this](int64_t value) {
+    return arithmetic_.Get().FindViolation(value).has_value();
+  });
+}
+
+std::optional<int64_t> MInteger::ShrinkImpl(const int64_t& value, int level,
+                                            int64_t index) const {
+  if (index != 0) return std::nullopt;
+  return moriarty_internal::ShrinkTowardsZero(value, level);
+}
+
 absl::StatusOr<std::vector<MInteger>> MInteger::GetDifficultInstancesImpl()
     const {
   absl::StatusOr<Range::ExtremeValues> extremes = GetExtremeValues();
 
+  // The instances only depend on the extremes, so reuse the last ones if
+  // nothing changed.
+  ExtremesCache& cache = *extremes_cache_;
+  std::optional<Range::ExtremeValues> cache_key;
+  if (extremes.ok()) cache_key = *extremes;
+  {
+    absl::MutexLock lock(&cache.mutex);
+    if (cache.difficult_instances &&
+        cache.difficult_instances_extremes == cache_key) {
+      return *cache.difficult_instances;
+    }
+  }
+
   int64_t min =
       extremes.ok() ? extremes->min : std::numeric_limits<int64_t>::min();
   int64_t max =
@@ -343,18 +762,57 @@ absl::StatusOr<std::vector<MInteger>> MInteger::GetDifficultInstancesImpl()
     insert_into_values({square_root, square_root + 1, square_root - 1});
   }
 
-  std::vector<MInteger> instances;
-  instances.reserve(values.size());
+  // Only keep the values that satisfy `MultipleOf()`, `Prime()`, etc.
+  if (!arithmetic_.Get().IsTrivial()) {
+    values.erase(std::remove_if(values.begin(), values.end(),
+                                [this](int64_t value) {
+                                  return arithmetic_.Get()
+                                      .FindViolation(value)
+                                      .has_value();
+                                }),
+                 values.end());
+
+    // The valid values closest to the bounds (e.g., the smallest and largest
+    // primes) are the interesting ones, even if `min` and `max` are not valid.
+    const moriarty_internal::ArithmeticConstraints& arithmetic =
+        arithmetic_.Get();
+    std::vector<int64_t> near_bounds;
+    if (std::optional<int64_t> smallest = arithmetic.FirstValid(min, max)) {
+      near_bounds.push_back(*smallest);
+      if (*smallest < max) {
+        if (std::optional<int64_t> next =
+                arithmetic.FirstValid(*smallest + 1, max))
+          near_bounds.push_back(*next);
+      }
+    }
+    if (std::optional<int64_t> largest = arithmetic.LastValid(min, max)) {
+      near_bounds.push_back(*largest);
+      if (*largest > min) {
+        if (std::optional<int64_t> previous =
+                arithmetic.LastValid(min, *largest - 1))
+          near_bounds.push_back(*previous);
+      }
+    }
+    for (int64_t v : near_bounds) {
+      if (absl::c_find(values, v) == values.end()) values.push_back(v);
+    }
+  }
+
+  auto instances = std::make_shared<std::vector<MInteger>>();
+  instances->reserve(values.size());
   for (const auto& v : values) {
-    instances.push_back(MInteger().Is(v));
+    instances->push_back(MInteger().Is(v));
   }
 
-  return instances;
+  absl::MutexLock lock(&cache.mutex);
+  cache.difficult_instances = instances;
+  cache.difficult_instances_extremes = cache_key;
+  return *instances;
 }
 
 std::vector<std::string> MInteger::GetDependenciesImpl() const {
   absl::StatusOr<absl::flat_hash_set<std::string>> needed =
-      bounds_.NeededVariables();
+      bounds_.Get().NeededVariables();
   if (!needed.ok()) return {};
   return std::vector<std::string>(needed->begin(), needed->end());
 }
@@ -363,7 +821,15 @@ std::string MInteger::ToStringImpl() const {
   std::string result;
   if (approx_size_ != CommonSize::kAny)
     absl::StrAppend(&result, "size: ", librarian::ToString(approx_size_), "; ");
-  absl::StrAppend(&result, "bounds: ", bounds_.ToString(), "; ");
+  absl::StrAppend(&result, "bounds: ", bounds_.Get().ToString(), "; ");
+  if (!arithmetic_.Get().IsTrivial())
+    absl::StrAppend(&result, "values: ", arithmetic_.Get().ToString(), "; ");
+  if (distribution_.shape !=
+      moriarty_internal::IntegerDistribution::Shape::kUniform) {
+    absl::StrAppend(
+        &result, "distribution: ",
+        moriarty_internal::IntegerDistributionToString(distribution_), "; ");
+  }
   return result;
 }
 
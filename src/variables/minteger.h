@@ -19,14 +19,23 @@
 
 #include <concepts>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "src/internal/arithmetic_constraints.h"
+#include "src/internal/copy_on_write.h"
+#include "src/internal/integer_distributions.h"
 #include "src/internal/range.h"
 #include "src/librarian/mvariable.h"
 #include "src/librarian/size_property.h"
@@ -64,6 +73,16 @@ class MInteger : public librarian::MVariable<MInteger, int64_t> {
   MInteger& AddConstraint(const AtLeast& constraint);
   // The integer should be approximately this size.
   MInteger& AddConstraint(const SizeCategory& constraint);
+  // The integer should be generated from this distribution.
+  MInteger& AddConstraint(const Distribution& constraint);
+  // The integer must be a multiple of this value.
+  MInteger& AddConstraint(const MultipleOf& constraint);
+  // The integer must have this remainder.
+  MInteger& AddConstraint(const ModEquals& constraint);
+  // The integer must not be any of these values.
+  MInteger& AddConstraint(const NotIn& constraint);
+  // The integer must be prime.
+  MInteger& AddConstraint(const Prime& constraint);
 
   [[nodiscard]] std::string Typename() const override { return "MInteger"; }
 
@@ -157,6 +176,14 @@ class MInteger : public librarian::MVariable<MInteger, int64_t> {
   // smaller than "medium", etc.)
   MInteger& WithSize(CommonSize size);
 
+  // WithDistribution()
+  //
+  // Sets how this integer is distributed in its range when it is generated
+  // (e.g., `Distribution::LogUniform()`). If a size is also set, the
+  // distribution is over the values of that size. If this is called multiple
+  // times, the last distribution is used.
+  MInteger& WithDistribution(const Distribution& distribution);
+
   // OfSizeProperty()
   //
   // Tells this int to have a specific size. `property.category` must be
@@ -165,34 +192,122 @@ class MInteger : public librarian::MVariable<MInteger, int64_t> {
   absl::Status OfSizeProperty(Property property);
 
  private:
-  Range bounds_;
+  // Shared between copies of this MInteger until modified.
+  moriarty_internal::CopyOnWrite<Range> bounds_;
 
   // What approximate size should the int64_t be when it is generated.
   CommonSize approx_size_ = CommonSize::kAny;
 
+  // How the int64_t should be distributed in its range when it is generated.
+  moriarty_internal::IntegerDistribution distribution_;
+
+  // Restrictions such as `MultipleOf()` and `Prime()`, which are sampled from
+  // directly when generating. Shared between copies until modified.
+  moriarty_internal::CopyOnWrite<moriarty_internal::ArithmeticConstraints>
+      arithmetic_;
+
+  // The most recent result of `GetExtremeValues()`, along with the values of
+  // the dependent variables it was computed with, and the most recent result
+  // of `GetDifficultInstancesImpl()`, along with the extremes it was computed
+  // with (`std::nullopt` if they were not available).
+  //
+  // Copies of this MInteger share the cache (e.g., each element of an
+  // `MArray<MInteger>` is generated from a copy of the same MInteger), so it
+  // may be used from several threads. The cache is replaced whenever `bounds_`
+  // or `arithmetic_` changes.
+  struct ExtremesCache {
+    ExtremesCache(const Range& bounds,
+                  const moriarty_internal::ArithmeticConstraints& arithmetic);
+
+    // The names in `bounds.NeededVariables()`, sorted.
+    const absl::StatusOr<std::vector<std::string>> needed_variables;
+
+    // If `needed_variables` is empty, the unique value satisfying `bounds` and
+    // `arithmetic` (`std::nullopt` if there is not exactly one). Computed once
+    // here so fixed variables (e.g., `Exactly(1)`) are cheap to assign.
+    const std::optional<int64_t> unique_value;
+
+    absl::Mutex mutex;
+    absl::InlinedVector<int64_t, 4> values ABSL_GUARDED_BY(mutex);
+    std::optional<Range::ExtremeValues> extremes ABSL_GUARDED_BY(mutex);
+
+    std::shared_ptr<const std::vector<MInteger>> difficult_instances
+        ABSL_GUARDED_BY(mutex);
+    std::optional<Range::ExtremeValues> difficult_instances_extremes
+        ABSL_GUARDED_BY(mutex);
+
+    // The part of `sized_extremes_key` to generate from for each size. Copies
+    // with different sizes share this cache, so it is keyed by size.
+    absl::flat_hash_map<CommonSize, Range::ExtremeValues> sized_extremes
+        ABSL_GUARDED_BY(mutex);
+    std::optional<Range::ExtremeValues> sized_extremes_key
+        ABSL_GUARDED_BY(mutex);
+
+    // The most recent result of `EnumerateImpl()`, along with the
+    // `max_values` it was computed with.
+    std::shared_ptr<const std::vector<int64_t>> domain ABSL_GUARDED_BY(mutex);
+    std::optional<int64_t> domain_max_values ABSL_GUARDED_BY(mutex);
+  };
+  std::shared_ptr<ExtremesCache> extremes_cache_ =
+      std::make_shared<ExtremesCache>(bounds_.Get(), arithmetic_.Get());
+
+  // Intersects `bounds_` with `range` and resets `extremes_cache_`.
+  void IntersectBounds(const Range& range);
+
   // Computes and returns the minimum and maximum of `bounds_`. Returns
   // `kInvalidArgumentError` if the range is empty. The `non-const` version
   // may generate other dependent variables if needed along the way.
   absl::StatusOr<Range::ExtremeValues> GetExtremeValues() const;
   absl::StatusOr<Range::ExtremeValues> GetExtremeValues();
 
-  // Generates a value between `minimum` and `maximum`.
+  // Shared implementation of `GetExtremeValues()`. `get_value(name)` returns
+  // the value of the dependent variable `name`.
+  template <typename GetValueFn>
+  absl::StatusOr<Range::ExtremeValues> GetExtremeValuesImpl(
+      GetValueFn get_value) const;
+
+  // Returns the part of `extremes` that values of size `approx_size_` should
+  // be generated from. This is all of `extremes` if no such part exists.
+  Range::ExtremeValues GetSizedExtremes(Range::ExtremeValues extremes) const;
+
+  // Generates a value between `minimum` and `maximum`. Returns kNotFound if
+  // no value in that range satisfies `arithmetic_`.
   absl::StatusOr<int64_t> GenerateInRange(Range::ExtremeValues extremes);
 
+  // Adds `constraint` to `arithmetic_`, or declares this invalid if it is not
+  // compatible with the others.
+  void AddModEquals(const ModEquals& constraint);
+
   // ---------------------------------------------------------------------------
   //  MVariable overrides
   absl::StatusOr<int64_t> GenerateImpl() override;
   absl::Status IsSatisfiedWithImpl(const int64_t& value) const override;
+  bool AllSatisfiedWithImpl(absl::Span<const int64_t> values) const override;
   absl::Status MergeFromImpl(const MInteger& other) override;
   absl::StatusOr<int64_t> ReadImpl() override;
   absl::Status PrintImpl(const int64_t& value) override;
   std::vector<std::string> GetDependenciesImpl() const override;
   absl::StatusOr<std::vector<MInteger>> GetDifficultInstancesImpl()
       const override;
+  std::optional<int64_t> ShrinkImpl(const int64_t& value, int level,
+                                    int64_t index) const override;
   std::optional<int64_t> GetUniqueValueImpl() const override;
+  std::shared_ptr<const std::vector<int64_t>> EnumerateImpl(
+      int64_t max_values) const override;
+  bool IsKnownUnsatisfiableImpl() const override;
+  const Range* GetIntegerBoundsImpl() const override;
+  void TightenIntegerBoundsImpl(const Range& bounds) override;
   std::string ToStringImpl() const override;
   absl::StatusOr<std::string> ValueToStringImpl(
       const int64_t& value) const override;
+  absl::StatusOr<std::optional<std::vector<int64_t>>> GenerateInBulkImpl(
+      int n) override;
+  absl::StatusOr<std::optional<std::vector<int64_t>>>
+  GenerateDistinctInBulkImpl(int n) override;
+  absl::StatusOr<std::optional<std::vector<int64_t>>> GenerateSortedInBulkImpl(
+      int n, bool strictly_increasing) override;
+  absl::StatusOr<std::optional<std::vector<int64_t>>>
+  GenerateInBulkWithSumImpl(int n, int64_t sum) override;
   // ---------------------------------------------------------------------------
 };
 
@@ -22,6 +22,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "src/librarian/size_property.h"
 #include "src/librarian/test_utils.h"
@@ -36,6 +37,7 @@ namespace {
 using ::moriarty_testing::Context;
 using ::moriarty_testing::Generate;
 using ::moriarty_testing::GenerateDifficultInstancesValues;
+using ::moriarty_testing::GenerateN;
 using ::moriarty_testing::GeneratedValuesAre;
 using ::moriarty_testing::GenerateSameValues;
 using ::moriarty_testing::GetUniqueValue;
@@ -44,6 +46,7 @@ using ::moriarty_testing::IsSatisfiedWith;
 using ::moriarty_testing::Print;
 using ::moriarty_testing::Read;
 using ::testing::AllOf;
+using ::testing::AnyOf;
 using ::testing::Each;
 using ::testing::Eq;
 using ::testing::Ge;
@@ -294,6 +297,31 @@ TEST(MIntegerTest, IsMIntegerExpressionShouldRestrictInput) {
               IsOkAndHolds(31));
 }
 
+TEST(MIntegerTest, CopiesShouldUseTheCurrentValuesOfDependentVariables) {
+  // Copies share cached extremes, which must not be reused once the values of
+  // the dependent variables change.
+  MInteger x = MInteger().Is("3 * N + 1");
+  EXPECT_THAT(Generate(x, Context().WithValue<MInteger>("N", 10)),
+              IsOkAndHolds(31));
+  EXPECT_THAT(Generate(x, Context().WithValue<MInteger>("N", 5)),
+              IsOkAndHolds(16));
+  EXPECT_THAT(Generate(x, Context().WithValue<MInteger>("N", 10)),
+              IsOkAndHolds(31));
+}
+
+TEST(MIntegerTest, AddingConstraintsToACopyShouldNotAffectTheOriginal) {
+  MInteger x = MInteger().Between(1, "N");
+  EXPECT_THAT(Generate(x, Context().WithValue<MInteger>("N", 1)),
+              IsOkAndHolds(1));
+
+  MInteger y = x;
+  y.AtLeast(5);
+  EXPECT_THAT(Generate(y, Context().WithValue<MInteger>("N", 1)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(x, Context().WithValue<MInteger>("N", 1)),
+              IsOkAndHolds(1));
+}
+
 TEST(MIntegerTest, GetUniqueValueWorksWhenUniqueValueKnown) {
   EXPECT_THAT(GetUniqueValue(MInteger().Between("N", "N"),
                              Context().WithValue<MInteger>("N", 10)),
@@ -327,6 +355,13 @@ TEST(MIntegerTest, GetUniqueValueFailsWhenTheValueIsNotUnique) {
   EXPECT_EQ(GetUniqueValue(MInteger().Between(8, 10)), std::nullopt);
 }
 
+TEST(MIntegerTest, GetUniqueValueShouldRespectArithmeticConstraints) {
+  EXPECT_EQ(GetUniqueValue(MInteger(Exactly(4), MultipleOf(3))), std::nullopt);
+  EXPECT_THAT(GetUniqueValue(MInteger(Exactly(6), MultipleOf(3))), Optional(6));
+  EXPECT_EQ(GetUniqueValue(MInteger(Exactly(4)).MergeFrom(MInteger(Prime()))),
+            std::nullopt);
+}
+
 TEST(MIntegerTest, OfSizePropertyOnlyAcceptsSizeAsCategory) {
   EXPECT_THAT(
       MInteger().OfSizeProperty({.category = "wrong"}),
@@ -363,6 +398,18 @@ TEST(MIntegerTest, GetDifficultInstancesValuesAreNotRepeated) {
               IsOkAndHolds(UnorderedElementsAre(-1, 0, 1)));
 }
 
+TEST(MIntegerTest, GetDifficultInstancesShouldReflectLaterConstraints) {
+  MInteger x = MInteger().Between(-100, 100);
+  EXPECT_THAT(GenerateDifficultInstancesValues(x),
+              IsOkAndHolds(IsSupersetOf({-100, 100})));
+  EXPECT_THAT(GenerateDifficultInstancesValues(x),
+              IsOkAndHolds(IsSupersetOf({-100, 100})));
+
+  x.Between(-1, 1);
+  EXPECT_THAT(GenerateDifficultInstancesValues(x),
+              IsOkAndHolds(UnorderedElementsAre(-1, 0, 1)));
+}
+
 TEST(MIntegerTest,
      GetDifficultInstancesForFixedNonDifficultValueFailsGeneration) {
   MORIARTY_ASSERT_OK_AND_ASSIGN(
@@ -397,6 +444,31 @@ TEST(MIntegerTest, WithSizeGivesAppropriatelySizedValues) {
               GeneratedValuesAre(Eq(1000000000)));
 }
 
+TEST(MIntegerTest, WithSizeWorksForTheFullInt64Range) {
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kMin),
+              GeneratedValuesAre(Eq(kMin)));
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kTiny),
+              GeneratedValuesAre(Le(kMin + 100)));
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kSmall),
+              GeneratedValuesAre(Le(kMin + 2000)));
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kMedium),
+              GeneratedValuesAre(Le(kMin + 1000000)));
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kLarge),
+              GeneratedValuesAre(Ge(kMin + 1000000)));
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kHuge),
+              GeneratedValuesAre(Ge(kMax / 10 * 7)));
+  EXPECT_THAT(MInteger().Between(kMin, kMax).WithSize(CommonSize::kMax),
+              GeneratedValuesAre(Eq(kMax)));
+
+  // Just over half of the range.
+  EXPECT_THAT(
+      MInteger().Between(kMin / 2 - 1, kMax).WithSize(CommonSize::kMin),
+      GeneratedValuesAre(Eq(kMin / 2 - 1)));
+}
+
 TEST(MIntegerTest, WithSizeBehavesWithMergeFrom) {
   MInteger small = MInteger().Between(1, "10^9").WithSize(CommonSize::kSmall);
   MInteger tiny = MInteger().Between(1, "10^9").WithSize(CommonSize::kTiny);
@@ -765,6 +837,146 @@ TEST(MIntegerNonBuilderTest, InvalidSizeCombinationsFailGeneration) {
               HasSubstr("Invalid size"));
 }
 
+// Returns the number of elements of `values` in [lo, hi].
+int CountBetween(const std::vector<int64_t>& values, int64_t lo, int64_t hi) {
+  return absl::c_count_if(
+      values, [&](int64_t value) { return lo <= value && value <= hi; });
+}
+
+TEST(MIntegerNonBuilderTest, DistributionsShouldSkewTheGeneratedValues) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> log_uniform,
+      GenerateN(MInteger(Between(1, "10^9"), Distribution::LogUniform()),
+                1000));
+  EXPECT_THAT(log_uniform, Each(AllOf(Ge(1), Le(1000000000))));
+  EXPECT_GT(CountBetween(log_uniform, 1, 1000000), 500);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> near_max,
+      GenerateN(MInteger(Between(1, "10^9"),
+                         Distribution::ExponentialNearMax(0.001)),
+                1000));
+  EXPECT_GT(CountBetween(near_max, 990000000, 1000000000), 990);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> buckets,
+      GenerateN(MInteger(Between(1, 100),
+                         Distribution::WeightedBuckets(
+                             {{.min = 1, .max = 1, .weight = 1},
+                              {.min = 100, .max = 100, .weight = 1}})),
+                100));
+  EXPECT_THAT(buckets, Each(AnyOf(1, 100)));
+}
+
+TEST(MIntegerNonBuilderTest, DistributionShouldApplyWithinTheSize) {
+  EXPECT_THAT(MInteger(Between(1, "10^9"), SizeCategory::Small(),
+                       Distribution::ClampedNormal(2, 0)),
+              GeneratedValuesAre(Eq(2000)));
+  EXPECT_THAT(MInteger(Between(1, "10^9"), Distribution::ClampedNormal(-1, 0),
+                       SizeCategory::Large()),
+              GeneratedValuesAre(Eq(1000000)));
+}
+
+TEST(MIntegerNonBuilderTest, DistributionShouldBeKeptByMergeFrom) {
+  MInteger skewed(Between(1, 100), Distribution::ClampedNormal(1, 0));
+  MInteger uniform(Between(1, 100));
+  MORIARTY_ASSERT_OK(uniform.TryMergeFrom(skewed));
+  EXPECT_THAT(uniform, GeneratedValuesAre(Eq(100)));
+  EXPECT_THAT(uniform.ToString(), HasSubstr("clamped_normal"));
+}
+
+TEST(MIntegerNonBuilderTest, InvalidDistributionShouldFailGeneration) {
+  EXPECT_THAT(
+      Generate(MInteger(Between(1, 10), Distribution::Exponential(-1))),
+      StatusIs(absl::StatusCode::kFailedPrecondition, HasSubstr("mean")));
+}
+
+TEST(MIntegerNonBuilderTest, ArithmeticConstraintsShouldBeGeneratedDirectly) {
+  EXPECT_THAT(MInteger(Between(1, "10^18"), MultipleOf(1000000007)),
+              GeneratedValuesAre(AllOf(Ge(1), Le(1000000000000000000))));
+  EXPECT_THAT(MInteger(Between(-100, 100), ModEquals(7, 3), NotIn({3, 10})),
+              GeneratedValuesAre(AllOf(Ge(-100), Le(100))));
+  EXPECT_THAT(MInteger(Between(1, "10^18"), Prime()),
+              GeneratedValuesAre(Ge(2)));
+  EXPECT_THAT(MInteger(Between(1, 10), NotIn({1, 2, 3, 4, 5, 6, 7, 8, 9})),
+              GeneratedValuesAre(Eq(10)));
+
+  // Dense exclusions would need 1000s of retries with custom constraints.
+  std::vector<int64_t> excluded(9999);
+  absl::c_iota(excluded, 1);
+  EXPECT_THAT(MInteger(Between(1, 10000), NotIn(excluded)),
+              GeneratedValuesAre(Eq(10000)));
+}
+
+TEST(MIntegerNonBuilderTest, ArithmeticConstraintsShouldBeValidated) {
+  EXPECT_THAT(MInteger(MultipleOf(3)), IsSatisfiedWith(-9));
+  EXPECT_THAT(MInteger(MultipleOf(3)), IsNotSatisfiedWith(10, "congruent"));
+  EXPECT_THAT(MInteger(ModEquals(4, -1)), IsSatisfiedWith(7));
+  EXPECT_THAT(MInteger(NotIn({5})), IsNotSatisfiedWith(5, "excluded"));
+  EXPECT_THAT(MInteger(Prime()), IsSatisfiedWith(1000000007));
+  EXPECT_THAT(MInteger(Prime()), IsNotSatisfiedWith(1, "prime"));
+}
+
+TEST(MIntegerNonBuilderTest, ArithmeticConstraintsShouldApplyWithinTheSize) {
+  EXPECT_THAT(MInteger(Between(1, "10^9"), SizeCategory::Small(), Prime()),
+              GeneratedValuesAre(Le(2000)));
+  // No multiple of 10^6 is small, so the size is ignored.
+  EXPECT_THAT(
+      MInteger(Between(1, "10^9"), SizeCategory::Small(), MultipleOf(1000000)),
+      GeneratedValuesAre(Ge(1000000)));
+}
+
+TEST(MIntegerNonBuilderTest, ArithmeticConstraintsShouldBeMerged) {
+  MInteger x(Between(1, 100), MultipleOf(2));
+  MORIARTY_ASSERT_OK(x.TryMergeFrom(MInteger(MultipleOf(3), NotIn({6}))));
+  EXPECT_THAT(x, GeneratedValuesAre(AllOf(Ge(12), Le(96))));
+  EXPECT_THAT(x, IsNotSatisfiedWith(6, "excluded"));
+  EXPECT_THAT(x.ToString(), HasSubstr("0 mod 6"));
+}
+
+TEST(MIntegerNonBuilderTest, IncompatibleArithmeticConstraintsShouldFail) {
+  EXPECT_THAT(Generate(MInteger(MultipleOf(2), ModEquals(4, 1))),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("Incompatible")));
+  EXPECT_THAT(Generate(MInteger(MultipleOf(0))),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("positive")));
+  EXPECT_FALSE(Generate(MInteger(Between(24, 28), Prime())).ok());
+}
+
+TEST(MIntegerNonBuilderTest, RareCustomConstraintsShouldBeEnumerated) {
+  // Rejection sampling alone would almost never find these.
+  EXPECT_THAT(MInteger(Between(1, 1000000))
+                  .AddCustomConstraint(
+                      "12345", [](int64_t value) { return value == 12345; }),
+              GeneratedValuesAre(Eq(12345)));
+  EXPECT_THAT(MInteger(Between(-500000, 500000), MultipleOf(5))
+                  .AddCustomConstraint("Small multiple of 25",
+                                       [](int64_t value) {
+                                         return value >= 0 && value < 1000 &&
+                                                value % 25 == 0;
+                                       }),
+              GeneratedValuesAre(AllOf(Ge(0), Le(975))));
+}
+
+TEST(MIntegerNonBuilderTest, UnsatisfiableCustomConstraintsShouldFail) {
+  EXPECT_THAT(Generate(MInteger(Between(1, 1000))
+                           .AddCustomConstraint(
+                               "Negative",
+                               [](int64_t value) { return value < 0; })),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MIntegerNonBuilderTest,
+     GetDifficultInstancesShouldRespectArithmeticConstraints) {
+  EXPECT_THAT(
+      GenerateDifficultInstancesValues(MInteger(Between(1, 1000), Prime())),
+      IsOkAndHolds(UnorderedElementsAre(2, 3, 31, 127, 257, 991, 997)));
+  EXPECT_THAT(GenerateDifficultInstancesValues(
+                  MInteger(Between(24, 100), MultipleOf(7), NotIn({28}))),
+              IsOkAndHolds(UnorderedElementsAre(35, 42, 91, 98)));
+}
+
 TEST(MIntegerNonBuilderTest, InvalidExpressionsShouldFail) {
   EXPECT_THAT(Generate(MInteger(Exactly("N + "))),
               StatusIs(absl::StatusCode::kFailedPrecondition,
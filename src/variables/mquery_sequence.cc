@@ -0,0 +1,337 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mquery_sequence.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/errors.h"
+#include "src/internal/alias_table.h"
+#include "src/internal/random_engine.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/container_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+using moriarty::librarian::IOConfig;
+
+namespace {
+
+// The number of operations tried for one query before giving up, when the
+// samplers keep saying that their operation cannot be applied.
+constexpr int kMaxOperationAttempts = 1000;
+
+}  // namespace
+
+void QuerySequence::Reserve(int64_t num_queries, int64_t num_arguments) {
+  operations_.reserve(num_queries);
+  offsets_.reserve(num_queries + 1);
+  arguments_.reserve(num_arguments);
+}
+
+void QuerySequence::Add(int operation, absl::Span<const int64_t> arguments) {
+  operations_.push_back(operation);
+  arguments_.insert(arguments_.end(), arguments.begin(), arguments.end());
+  offsets_.push_back(arguments_.size());
+}
+
+bool operator<(const QuerySequence& lhs, const QuerySequence& rhs) {
+  int64_t n = std::min(lhs.size(), rhs.size());
+  for (int64_t i = 0; i < n; i++) {
+    if (lhs.Operation(i) != rhs.Operation(i))
+      return lhs.Operation(i) < rhs.Operation(i);
+    absl::Span<const int64_t> lhs_arguments = lhs.Arguments(i);
+    absl::Span<const int64_t> rhs_arguments = rhs.Arguments(i);
+    if (lhs_arguments != rhs_arguments) {
+      return absl::c_lexicographical_compare(lhs_arguments, rhs_arguments);
+    }
+  }
+  return lhs.size() < rhs.size();
+}
+
+int64_t QueryState::RandomInteger(int64_t min, int64_t max) {
+  if (min > max) {
+    if (status_.ok()) {
+      status_ = absl::InvalidArgumentError(absl::Substitute(
+          "RandomInteger($0, $1) in query $2 has an empty range", min, max,
+          query_index_));
+    }
+    return min;
+  }
+  return random_engine_.RandInt(min, max, status_);
+}
+
+int64_t QueryState::RandomKey() {
+  if (NumKeys() == 0) {
+    if (status_.ok()) {
+      status_ = absl::FailedPreconditionError(absl::Substitute(
+          "RandomKey() in query $0, but there are no keys", query_index_));
+    }
+    return 0;
+  }
+  return KthKey(random_engine_.RandInt(NumKeys(), status_));
+}
+
+MQuerySequence& MQuerySequence::AddConstraint(const Length& constraint) {
+  return OfLength(constraint.GetConstraints());
+}
+
+MQuerySequence& MQuerySequence::OfLength(const MInteger& length) {
+  if (length_)
+    length_->MergeFrom(length);
+  else
+    length_ = length;
+  return *this;
+}
+
+MQuerySequence& MQuerySequence::OfLength(int64_t length) {
+  return OfLength(length, length);
+}
+
+MQuerySequence& MQuerySequence::OfLength(
+    absl::string_view length_expression) {
+  return OfLength(MInteger().Between(length_expression, length_expression));
+}
+
+MQuerySequence& MQuerySequence::OfLength(int64_t min_length,
+                                         int64_t max_length) {
+  return OfLength(MInteger().Between(min_length, max_length));
+}
+
+MQuerySequence& MQuerySequence::AddOperation(absl::string_view name,
+                                             int64_t weight, int num_arguments,
+                                             Sampler sampler) {
+  if (name.empty() || absl::c_any_of(name, absl::ascii_isspace)) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(absl::Substitute(
+        "The name of an operation must be a token, but got '$0'", name)));
+    return *this;
+  }
+  if (weight < 0 || num_arguments < 0) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(absl::Substitute(
+        "Operation '$0' must have a non-negative weight and number of "
+        "arguments, but got $1 and $2",
+        name, weight, num_arguments)));
+    return *this;
+  }
+
+  Operation operation = {.name = std::string(name),
+                         .weight = weight,
+                         .num_arguments = num_arguments,
+                         .sampler = std::move(sampler)};
+  if (std::optional<int> index = FindOperation(name)) {
+    operations_[*index] = std::move(operation);
+  } else {
+    operations_.push_back(std::move(operation));
+  }
+  return *this;
+}
+
+std::optional<int> MQuerySequence::FindOperation(absl::string_view name) const {
+  for (int i = 0; i < operations_.size(); i++) {
+    if (operations_[i].name == name) return i;
+  }
+  return std::nullopt;
+}
+
+absl::StatusOr<QuerySequence> MQuerySequence::GenerateImpl() {
+  if (!length_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a query sequence with no length parameter "
+        "given.");
+  }
+  if (operations_.empty()) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a query sequence with no operations.");
+  }
+
+  // Ensure that the size is non-negative.
+  length_->AtLeast(0);
+
+  std::optional<int64_t> generation_limit = GetApproximateGenerationLimit();
+  if (generation_limit) length_->AtMost(*generation_limit);
+
+  MORIARTY_ASSIGN_OR_RETURN(int64_t length, Random("length", *length_));
+
+  std::vector<int64_t> weights;
+  weights.reserve(operations_.size());
+  for (const Operation& operation : operations_)
+    weights.push_back(operation.weight);
+  MORIARTY_ASSIGN_OR_RETURN(moriarty_internal::AliasTable operation_table,
+                            moriarty_internal::AliasTable::Create(weights),
+                            _ << "Invalid operation weights");
+
+  // MQuerySequence needs direct access its RandomEngine. Non built-in types
+  // should not access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  QueryState state(rng);
+
+  // The queries are written straight into the columns of the result. Only
+  // the arguments of the current query are held separately.
+  QuerySequence result;
+  result.Reserve(length, 0);
+  std::vector<int64_t> arguments;
+  for (int64_t i = 0; i < length; i++) {
+    state.query_index_ = i;
+    bool added = false;
+    for (int attempt = 0; attempt < kMaxOperationAttempts && !added;
+         attempt++) {
+      int index = operation_table.Sample(rng, state.status_);
+      MORIARTY_RETURN_IF_ERROR(state.status_);
+      const Operation& operation = operations_[index];
+
+      arguments.clear();
+      bool applied = operation.sampler(state, arguments);
+      MORIARTY_RETURN_IF_ERROR(state.status_);
+      if (!applied) continue;
+      if (arguments.size() != operation.num_arguments) {
+        return absl::InvalidArgumentError(absl::Substitute(
+            "Operation '$0' has $1 arguments, but its sampler wrote $2 in "
+            "query $3",
+            operation.name, operation.num_arguments, arguments.size(), i));
+      }
+      result.Add(index, arguments);
+      added = true;
+    }
+    if (!added) {
+      return absl::FailedPreconditionError(absl::Substitute(
+          "No operation could be applied to query $0 after $1 attempts", i,
+          kMaxOperationAttempts));
+    }
+  }
+  return result;
+}
+
+absl::Status MQuerySequence::IsSatisfiedWithImpl(
+    const QuerySequence& value) const {
+  if (length_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(SatisfiesConstraints(*length_, value.size()),
+                        "invalid MQuerySequence length"));
+  }
+
+  for (int64_t i = 0; i < value.size(); i++) {
+    int index = value.Operation(i);
+    if (index < 0 || index >= operations_.size()) {
+      return UnsatisfiedConstraintError(
+          absl::Substitute("query $0 has an unknown operation", i));
+    }
+    const Operation& operation = operations_[index];
+    if (value.Arguments(i).size() != operation.num_arguments) {
+      return UnsatisfiedConstraintError(absl::Substitute(
+          "query $0 ('$1') has $2 arguments, but should have $3", i,
+          operation.name, value.Arguments(i).size(), operation.num_arguments));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MQuerySequence::MergeFromImpl(const MQuerySequence& other) {
+  if (other.length_) OfLength(*other.length_);
+  for (const Operation& operation : other.operations_) {
+    AddOperation(operation.name, operation.weight, operation.num_arguments,
+                 operation.sampler);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<QuerySequence> MQuerySequence::ReadImpl() {
+  if (!length_) {
+    return absl::FailedPreconditionError(
+        "Unknown length of query sequence before read.");
+  }
+  std::optional<int64_t> length = GetUniqueValue("length", *length_);
+  if (!length) {
+    return absl::FailedPreconditionError(
+        "Cannot determine the length of query sequence before read.");
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  QuerySequence result;
+  result.Reserve(*length, 0);
+  std::vector<int64_t> arguments;
+  for (int64_t i = 0; i < *length; i++) {
+    if (i > 0) {
+      MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(Whitespace::kNewline));
+    }
+    MORIARTY_ASSIGN_OR_RETURN(std::string name, io_config->ReadToken());
+    std::optional<int> index = FindOperation(name);
+    if (!index) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("Unknown operation '$0' in query $1", name, i));
+    }
+    arguments.resize(operations_[*index].num_arguments);
+    for (int64_t& argument : arguments) {
+      MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(Whitespace::kSpace));
+      MORIARTY_ASSIGN_OR_RETURN(argument, io_config->ReadInteger());
+    }
+    result.Add(*index, arguments);
+  }
+  return result;
+}
+
+absl::Status MQuerySequence::PrintImpl(const QuerySequence& value) {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  for (int64_t i = 0; i < value.size(); i++) {
+    if (i > 0) {
+      MORIARTY_RETURN_IF_ERROR(
+          io_config->PrintWhitespace(Whitespace::kNewline));
+    }
+    int index = value.Operation(i);
+    if (index < 0 || index >= operations_.size()) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("Query $0 has an unknown operation", i));
+    }
+    MORIARTY_RETURN_IF_ERROR(io_config->PrintToken(operations_[index].name));
+    for (int64_t argument : value.Arguments(i)) {
+      MORIARTY_RETURN_IF_ERROR(io_config->PrintWhitespace(Whitespace::kSpace));
+      MORIARTY_RETURN_IF_ERROR(io_config->PrintInteger(argument));
+    }
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::string> MQuerySequence::GetDependenciesImpl() const {
+  return length_ ? GetDependencies(*length_) : std::vector<std::string>();
+}
+
+std::string MQuerySequence::ToStringImpl() const {
+  std::string result;
+  if (length_)
+    absl::StrAppend(&result, "length: (", length_->ToString(), "); ");
+  for (const Operation& operation : operations_) {
+    absl::StrAppend(&result, "operation: ", operation.name, " (weight ",
+                    operation.weight, ", ", operation.num_arguments,
+                    " arguments); ");
+  }
+  return result;
+}
+
+}  // namespace moriarty
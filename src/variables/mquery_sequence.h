@@ -0,0 +1,298 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MQUERY_SEQUENCE_H_
+#define MORIARTY_SRC_VARIABLES_MQUERY_SEQUENCE_H_
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "src/internal/order_statistic_treap.h"
+#include "src/internal/random_engine.h"
+#include "src/librarian/mvariable.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/constraints/container_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+// QuerySequence
+//
+// A list of queries, each an operation and its integer arguments. The queries
+// are stored column by column (the operations in one array, and the arguments
+// of all of the queries back to back in another), so there is no per-query
+// allocation, which matters for 10^5-10^6 queries.
+class QuerySequence {
+ public:
+  QuerySequence() = default;
+
+  // size()
+  //
+  // The number of queries.
+  [[nodiscard]] int64_t size() const { return operations_.size(); }
+  [[nodiscard]] bool empty() const { return operations_.empty(); }
+
+  // Operation()
+  //
+  // The operation of the `index`-th query: its index in the order the
+  // operations were added to the `MQuerySequence`.
+  [[nodiscard]] int Operation(int64_t index) const {
+    return operations_[index];
+  }
+
+  // Arguments()
+  //
+  // The arguments of the `index`-th query. The span is invalidated by `Add()`.
+  [[nodiscard]] absl::Span<const int64_t> Arguments(int64_t index) const {
+    return absl::MakeConstSpan(arguments_)
+        .subspan(offsets_[index], offsets_[index + 1] - offsets_[index]);
+  }
+
+  // Reserve()
+  //
+  // Reserves space for `num_queries` queries with `num_arguments` arguments in
+  // total.
+  void Reserve(int64_t num_queries, int64_t num_arguments);
+
+  // Add()
+  //
+  // Appends a query to the end of this sequence.
+  void Add(int operation, absl::Span<const int64_t> arguments);
+
+  friend bool operator==(const QuerySequence& lhs, const QuerySequence& rhs) {
+    return lhs.operations_ == rhs.operations_ &&
+           lhs.offsets_ == rhs.offsets_ && lhs.arguments_ == rhs.arguments_;
+  }
+  // Lexicographic order of the queries, each compared by its operation and
+  // then its arguments.
+  friend bool operator<(const QuerySequence& lhs, const QuerySequence& rhs);
+
+ private:
+  std::vector<int> operations_;
+  // The arguments of the `i`-th query are `arguments_[offsets_[i],
+  // offsets_[i + 1])`.
+  std::vector<int64_t> offsets_ = {0};
+  std::vector<int64_t> arguments_;
+};
+
+// QueryState
+//
+// The state shared by the queries of one `QuerySequence` while it is
+// generated, given to each operation's sampler. It is empty at the start of
+// each sequence.
+//
+// Besides random integers, it holds a set of distinct integer keys with
+// O(log n) order statistics, which covers most data-structure problems (e.g.,
+// "insert a new key", "delete an existing key", "the k-th smallest key").
+class QueryState {
+ public:
+  // RandomInteger()
+  //
+  // Returns a uniformly random integer in [`min`, `max`]. If `min` > `max`,
+  // generation of the sequence fails.
+  int64_t RandomInteger(int64_t min, int64_t max);
+
+  // QueryIndex()
+  //
+  // The index (0-based) of the query being generated.
+  [[nodiscard]] int64_t QueryIndex() const { return query_index_; }
+
+  // InsertKey()
+  //
+  // Adds `key` to the set of keys. Returns false if it was already there.
+  bool InsertKey(int64_t key) { return keys_.Insert(key); }
+
+  // EraseKey()
+  //
+  // Removes `key` from the set of keys. Returns false if it was not there.
+  bool EraseKey(int64_t key) { return keys_.Erase(key); }
+
+  // ContainsKey()
+  //
+  // Returns true if `key` is in the set of keys.
+  [[nodiscard]] bool ContainsKey(int64_t key) const {
+    return keys_.Contains(key);
+  }
+
+  // NumKeys()
+  //
+  // The number of keys in the set.
+  [[nodiscard]] int64_t NumKeys() const { return keys_.size(); }
+
+  // KthKey()
+  //
+  // The `k`-th smallest key (0-based). `k` must be in [0, NumKeys()).
+  [[nodiscard]] int64_t KthKey(int64_t k) const { return keys_.Kth(k); }
+
+  // CountKeysLessThan()
+  //
+  // The number of keys that are less than `key`.
+  [[nodiscard]] int64_t CountKeysLessThan(int64_t key) const {
+    return keys_.CountLessThan(key);
+  }
+
+  // RandomKey()
+  //
+  // Returns a uniformly random key from the set. There must be at least one
+  // key.
+  int64_t RandomKey();
+
+ private:
+  friend class MQuerySequence;
+  explicit QueryState(moriarty_internal::RandomEngine& random_engine)
+      : random_engine_(random_engine) {}
+
+  moriarty_internal::RandomEngine& random_engine_;
+  // The first error from the random engine.
+  absl::Status status_;
+  int64_t query_index_ = 0;
+  moriarty_internal::OrderStatisticTreap keys_;
+};
+
+// MQuerySequence
+//
+// Describes a sequence of queries for data-structure problems, where the
+// arguments of each query depend on the queries before it (e.g., "delete an
+// existing key" or "1 <= l <= r <= current size").
+//
+// Each operation has a name, a weight and a sampler. For each query, an
+// operation is picked with probability proportional to its weight, and its
+// sampler writes the query's arguments, updating the `QueryState` as needed:
+//
+//   MQuerySequence()
+//       .OfLength("Q")
+//       .AddOperation("+", 2, /* num_arguments = */ 1,
+//                     [](QueryState& state, std::vector<int64_t>& args) {
+//                       int64_t key = state.RandomInteger(1, 1'000'000'000);
+//                       state.InsertKey(key);
+//                       args.push_back(key);
+//                       return true;
+//                     })
+//       .AddOperation("-", 1, /* num_arguments = */ 1,
+//                     [](QueryState& state, std::vector<int64_t>& args) {
+//                       if (state.NumKeys() == 0) return false;
+//                       int64_t key = state.RandomKey();
+//                       state.EraseKey(key);
+//                       args.push_back(key);
+//                       return true;
+//                     });
+//
+// A sampler returns false (without changing the state) if its operation
+// cannot be applied right now, and another operation is picked instead.
+//
+// Each query is printed on its own line: the operation's name, then its
+// arguments, separated by spaces. Validation only checks the number of queries
+// and that each has a known operation with the right number of arguments; the
+// samplers cannot check whether the arguments make sense.
+class MQuerySequence
+    : public librarian::MVariable<MQuerySequence, QuerySequence> {
+ public:
+  // Sampler
+  //
+  // Appends the arguments of one query to `arguments` (which starts empty).
+  // Returns false if the operation cannot be applied in `state`.
+  using Sampler =
+      std::function<bool(QueryState& state, std::vector<int64_t>& arguments)>;
+
+  // Create an MQuerySequence from a set of constraints. Logically equivalent
+  // to calling AddConstraint() for each constraint.
+  //
+  // E.g., MQuerySequence(Length(100000))
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MQuerySequence(Constraints&&... constraints);
+
+  // The sequence must have this many queries.
+  MQuerySequence& AddConstraint(const Length& constraint);
+
+  [[nodiscard]] std::string Typename() const override {
+    return "MQuerySequence";
+  }
+
+  // OfLength()
+  //
+  // Sets the constraints for the number of queries. If two parameters are
+  // provided, the length is in the closed range [`min_length`, `max_length`].
+  //
+  // For example:
+  // `OfLength(5, 10)` is equivalent to `OfLength(MInteger().Between(5, 10))`.
+  // `OfLength("Q")` is equivalent to `OfLength(MInteger().Is("Q"))`.
+  MQuerySequence& OfLength(const MInteger& length);
+  MQuerySequence& OfLength(int64_t length);
+  MQuerySequence& OfLength(absl::string_view length_expression);
+  MQuerySequence& OfLength(int64_t min_length, int64_t max_length);
+
+  // AddOperation()
+  //
+  // Adds an operation called `name` (how it is printed and read), picked with
+  // probability proportional to `weight`. Each query of this operation has
+  // exactly `num_arguments` arguments, which are written by `sampler`.
+  //
+  // Names must be tokens (non-empty, without whitespace), and weights and
+  // `num_arguments` non-negative. An operation with the same name as an
+  // existing one replaces it.
+  MQuerySequence& AddOperation(absl::string_view name, int64_t weight,
+                               int num_arguments, Sampler sampler);
+
+ private:
+  struct Operation {
+    std::string name;
+    int64_t weight;
+    int num_arguments;
+    Sampler sampler;
+  };
+
+  std::optional<MInteger> length_;
+  std::vector<Operation> operations_;
+
+  // Returns the index of the operation called `name`, if any.
+  std::optional<int> FindOperation(absl::string_view name) const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<QuerySequence> GenerateImpl() override;
+  absl::Status IsSatisfiedWithImpl(const QuerySequence& value) const override;
+  absl::Status MergeFromImpl(const MQuerySequence& other) override;
+  absl::StatusOr<QuerySequence> ReadImpl() override;
+  absl::Status PrintImpl(const QuerySequence& value) override;
+  std::vector<std::string> GetDependenciesImpl() const override;
+  std::string ToStringImpl() const override;
+  // ---------------------------------------------------------------------------
+};
+
+// -----------------------------------------------------------------------------
+//  Implementation details
+// -----------------------------------------------------------------------------
+
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MQuerySequence::MQuerySequence(Constraints&&... constraints) {
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MQUERY_SEQUENCE_H_
@@ -0,0 +1,203 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mquery_sequence.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOk;
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::moriarty_testing::Context;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::Property;
+
+// Inserts a key that is not in the set yet.
+bool SampleInsert(QueryState& state, std::vector<int64_t>& arguments) {
+  int64_t key;
+  do {
+    key = state.RandomInteger(1, 1'000'000'000);
+  } while (state.ContainsKey(key));
+  state.InsertKey(key);
+  arguments.push_back(key);
+  return true;
+}
+
+// Erases a key that is in the set.
+bool SampleErase(QueryState& state, std::vector<int64_t>& arguments) {
+  if (state.NumKeys() == 0) return false;
+  int64_t key = state.RandomKey();
+  state.EraseKey(key);
+  arguments.push_back(key);
+  return true;
+}
+
+// Asks for the k-th smallest key (1-based) of the set.
+bool SampleKth(QueryState& state, std::vector<int64_t>& arguments) {
+  if (state.NumKeys() == 0) return false;
+  arguments.push_back(state.RandomInteger(1, state.NumKeys()));
+  return true;
+}
+
+MQuerySequence SetQueries() {
+  return MQuerySequence()
+      .AddOperation("+", 3, 1, SampleInsert)
+      .AddOperation("-", 2, 1, SampleErase)
+      .AddOperation("?", 1, 1, SampleKth);
+}
+
+TEST(MQuerySequenceTest, TypenameIsCorrect) {
+  EXPECT_EQ(MQuerySequence().Typename(), "MQuerySequence");
+}
+
+TEST(MQuerySequenceTest, QuerySequenceStoresTheQueriesInColumns) {
+  QuerySequence queries;
+  queries.Add(1, {5, 6});
+  queries.Add(0, {});
+  queries.Add(2, {7});
+
+  EXPECT_EQ(queries.size(), 3);
+  EXPECT_EQ(queries.Operation(0), 1);
+  EXPECT_THAT(queries.Arguments(0), ElementsAre(5, 6));
+  EXPECT_THAT(queries.Arguments(1), ElementsAre());
+  EXPECT_THAT(queries.Arguments(2), ElementsAre(7));
+}
+
+TEST(MQuerySequenceTest, GeneratedQueriesShouldDependOnTheState) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(QuerySequence queries,
+                                Generate(SetQueries().OfLength(10000)));
+  ASSERT_EQ(queries.size(), 10000);
+
+  // Replay the queries: every erased key exists and every k is in range.
+  std::set<int64_t> keys;
+  for (int64_t i = 0; i < queries.size(); i++) {
+    ASSERT_EQ(queries.Arguments(i).size(), 1) << "query " << i;
+    int64_t argument = queries.Arguments(i)[0];
+    switch (queries.Operation(i)) {
+      case 0:
+        EXPECT_TRUE(keys.insert(argument).second) << "query " << i;
+        break;
+      case 1:
+        EXPECT_EQ(keys.erase(argument), 1) << "query " << i;
+        break;
+      case 2:
+        EXPECT_GE(argument, 1) << "query " << i;
+        EXPECT_LE(argument, keys.size()) << "query " << i;
+        break;
+    }
+  }
+}
+
+TEST(MQuerySequenceTest, GenerateWithLengthFromOtherVariablesWorks) {
+  EXPECT_THAT(Generate(SetQueries().OfLength("Q"),
+                       Context().WithValue<MInteger>("Q", 7)),
+              IsOkAndHolds(Property(&QuerySequence::size, 7)));
+}
+
+TEST(MQuerySequenceTest, GenerateWithoutLengthOrOperationsFails) {
+  EXPECT_THAT(Generate(SetQueries()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(MQuerySequence().OfLength(5)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MQuerySequenceTest, GenerateFailsIfNoOperationCanBeApplied) {
+  // Nothing can be erased from the empty set.
+  EXPECT_THAT(
+      Generate(MQuerySequence().OfLength(5).AddOperation("-", 1, 1,
+                                                         SampleErase)),
+      StatusIs(absl::StatusCode::kFailedPrecondition,
+               HasSubstr("No operation could be applied")));
+}
+
+TEST(MQuerySequenceTest, GenerateFailsIfASamplerWritesTheWrongArguments) {
+  EXPECT_THAT(
+      Generate(MQuerySequence().OfLength(5).AddOperation("+", 1, 2,
+                                                         SampleInsert)),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MQuerySequenceTest, IsSatisfiedWithChecksTheLengthAndArguments) {
+  QuerySequence queries;
+  queries.Add(0, {5});
+  queries.Add(2, {1});
+
+  EXPECT_THAT(SetQueries().OfLength(2), IsSatisfiedWith(queries));
+  EXPECT_THAT(SetQueries().OfLength(3), IsNotSatisfiedWith(queries, "length"));
+
+  queries.Add(1, {});
+  EXPECT_THAT(SetQueries(), IsNotSatisfiedWith(queries, "query 2"));
+}
+
+TEST(MQuerySequenceTest, PrintWritesOneQueryPerLine) {
+  QuerySequence queries;
+  queries.Add(0, {5});
+  queries.Add(1, {5});
+
+  EXPECT_THAT(Print(SetQueries(), queries), IsOkAndHolds("+ 5\n- 5"));
+}
+
+TEST(MQuerySequenceTest, ReadReadsOneQueryPerLine) {
+  QuerySequence queries;
+  queries.Add(0, {5});
+  queries.Add(2, {1});
+
+  EXPECT_THAT(Read(SetQueries().OfLength(2), "+ 5\n? 1"),
+              IsOkAndHolds(queries));
+  EXPECT_THAT(Read(SetQueries().OfLength(2), "+ 5\n* 1"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Read(SetQueries(), "+ 5"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MQuerySequenceTest, AddingAnOperationWithTheSameNameReplacesIt) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      QuerySequence queries,
+      Generate(SetQueries().OfLength(100).AddOperation("-", 0, 1,
+                                                       SampleErase)));
+  for (int64_t i = 0; i < queries.size(); i++)
+    EXPECT_NE(queries.Operation(i), 1) << "query " << i;
+}
+
+TEST(MQuerySequenceTest, InvalidOperationsShouldFail) {
+  EXPECT_THAT(Generate(MQuerySequence().OfLength(5).AddOperation(
+                  "a b", 1, 1, SampleInsert)),
+              Not(IsOk()));
+  EXPECT_THAT(Generate(MQuerySequence().OfLength(5).AddOperation(
+                  "+", -1, 1, SampleInsert)),
+              Not(IsOk()));
+}
+
+}  // namespace
+}  // namespace moriarty
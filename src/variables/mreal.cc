@@ -0,0 +1,254 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mreal.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "src/errors.h"
+#include "src/internal/random_engine.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+using moriarty::librarian::IOConfig;
+
+namespace {
+
+// Scaled values must be exactly representable as doubles, so that
+// `scaled / 10^digits` is the double closest to the decimal number.
+constexpr int64_t kMaxExactScaledValue = int64_t{1} << 53;
+
+// Formats `value` as `IOConfig::PrintReal()` does.
+std::string FormatReal(double value, std::optional<int> digits) {
+  char buffer[400];
+  std::to_chars_result result =
+      digits ? std::to_chars(buffer, buffer + sizeof(buffer), value,
+                             std::chars_format::fixed, *digits)
+             : std::to_chars(buffer, buffer + sizeof(buffer), value,
+                             std::chars_format::fixed);
+  if (result.ec != std::errc()) return absl::StrCat(value);
+  return std::string(buffer, result.ptr);
+}
+
+}  // namespace
+
+MReal& MReal::AddConstraint(const Exactly<double>& constraint) {
+  return Between(constraint.GetValue(), constraint.GetValue());
+}
+
+MReal& MReal::Between(double minimum, double maximum) {
+  return AtLeast(minimum).AtMost(maximum);
+}
+
+MReal& MReal::AtLeast(double minimum) {
+  if (std::isnan(minimum)) {
+    DeclareSelfAsInvalid(
+        UnsatisfiedConstraintError("The minimum of an MReal cannot be NaN."));
+    return *this;
+  }
+  minimum_ = std::max(minimum_, minimum);
+  return *this;
+}
+
+MReal& MReal::AtMost(double maximum) {
+  if (std::isnan(maximum)) {
+    DeclareSelfAsInvalid(
+        UnsatisfiedConstraintError("The maximum of an MReal cannot be NaN."));
+    return *this;
+  }
+  maximum_ = std::min(maximum_, maximum);
+  return *this;
+}
+
+MReal& MReal::WithDigits(int digits) {
+  if (digits < 0 || digits > IOConfig::kMaxRealDigits) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(absl::Substitute(
+        "The number of digits of an MReal must be in [0, $0], but got $1.",
+        IOConfig::kMaxRealDigits, digits)));
+  } else if (digits_.has_value() && *digits_ != digits) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        "Attempting to set multiple numbers of digits for the same MReal."));
+  } else {
+    digits_ = digits;
+  }
+  return *this;
+}
+
+absl::StatusOr<MReal::ScaledRange> MReal::GetScaledRange() const {
+  MORIARTY_RETURN_IF_ERROR(CheckBounded());
+  double scale = std::pow(10.0, *digits_);  // Exact for at most 22 digits.
+  double scaled_min = std::ceil(minimum_ * scale);
+  double scaled_max = std::floor(maximum_ * scale);
+  if (std::max(std::abs(scaled_min), std::abs(scaled_max)) >
+      kMaxExactScaledValue) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "The range [$0, $1] is too large to generate real numbers with $2 "
+        "digits after the decimal point.",
+        minimum_, maximum_, *digits_));
+  }
+
+  // `minimum_ * scale` may have been rounded, so make sure the ends of the
+  // range are the closest values to the bounds that are in the bounds.
+  ScaledRange range = {static_cast<int64_t>(scaled_min),
+                       static_cast<int64_t>(scaled_max), scale};
+  while (range.min / scale < minimum_) range.min++;
+  while ((range.min - 1) / scale >= minimum_) range.min--;
+  while (range.max / scale > maximum_) range.max--;
+  while ((range.max + 1) / scale <= maximum_) range.max++;
+  if (range.min > range.max) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "There is no real number in [$0, $1] with $2 digits after the decimal "
+        "point.",
+        minimum_, maximum_, *digits_));
+  }
+  return range;
+}
+
+absl::Status MReal::CheckBounded() const {
+  if (!std::isfinite(minimum_) || !std::isfinite(maximum_)) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a real number without finite bounds.");
+  }
+  if (minimum_ > maximum_) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "Attempting to generate a real number in an empty range [$0, $1].",
+        minimum_, maximum_));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<double> MReal::GenerateImpl() {
+  if (digits_) {
+    MORIARTY_ASSIGN_OR_RETURN(ScaledRange range, GetScaledRange());
+    MORIARTY_ASSIGN_OR_RETURN(
+        int64_t scaled,
+        Random("scaled_value", MInteger().Between(range.min, range.max)));
+    return scaled / range.scale;
+  }
+
+  MORIARTY_RETURN_IF_ERROR(CheckBounded());
+  if (!std::isfinite(maximum_ - minimum_)) {
+    return absl::FailedPreconditionError(
+        "The range of a real number is too large to generate uniformly.");
+  }
+
+  // MReal needs direct access its RandomEngine. Non built-in types should not
+  // access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  return std::min(maximum_,
+                  minimum_ + (maximum_ - minimum_) * rng.RandDouble());
+}
+
+absl::StatusOr<std::optional<std::vector<double>>> MReal::GenerateInBulkImpl(
+    int n) {
+  std::vector<double> values(n);
+  if (digits_) {
+    // Let `Generate()` deal with errors.
+    absl::StatusOr<ScaledRange> range = GetScaledRange();
+    if (!range.ok()) return std::nullopt;
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::optional<std::vector<int64_t>> scaled,
+        RandomInBulk("scaled_value", MInteger().Between(range->min, range->max),
+                     n));
+    if (!scaled) return std::nullopt;
+    for (int i = 0; i < n; i++) values[i] = (*scaled)[i] / range->scale;
+    return values;
+  }
+
+  if (!CheckBounded().ok() || !std::isfinite(maximum_ - minimum_))
+    return std::nullopt;
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  // Identical to calling `GenerateImpl()` `n` times.
+  for (double& value : values) {
+    value = std::min(maximum_,
+                     minimum_ + (maximum_ - minimum_) * rng.RandDouble());
+  }
+  return values;
+}
+
+absl::Status MReal::IsSatisfiedWithImpl(const double& value) const {
+  if (!std::isfinite(value))
+    return UnsatisfiedConstraintError("real number is not finite");
+  if (value < minimum_ || value > maximum_) {
+    return UnsatisfiedConstraintError(
+        absl::Substitute("$0 is not in the range [$1, $2]",
+                         FormatReal(value, std::nullopt),
+                         minimum_, maximum_));
+  }
+
+  // A value has at most `digits_` digits after the decimal point if printing
+  // it with that many digits reads back as the same value.
+  if (digits_) {
+    std::string formatted = FormatReal(value, digits_);
+    double parsed;
+    std::from_chars(formatted.data(), formatted.data() + formatted.size(),
+                    parsed);
+    if (parsed != value) {
+      return UnsatisfiedConstraintError(absl::Substitute(
+          "$0 has more than $1 digits after the decimal point",
+          FormatReal(value, std::nullopt), *digits_));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MReal::MergeFromImpl(const MReal& other) {
+  Between(other.minimum_, other.maximum_);
+  if (other.digits_) WithDigits(*other.digits_);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<double> MReal::ReadImpl() {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  return io_config->ReadReal();
+}
+
+absl::Status MReal::PrintImpl(const double& value) {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  return io_config->PrintReal(value, digits_);
+}
+
+bool MReal::IsKnownUnsatisfiableImpl() const { return minimum_ > maximum_; }
+
+std::string MReal::ToStringImpl() const {
+  std::string result =
+      absl::Substitute("bounds: [$0, $1]; ", minimum_, maximum_);
+  if (digits_) absl::StrAppend(&result, "digits: ", *digits_, "; ");
+  return result;
+}
+
+absl::StatusOr<std::string> MReal::ValueToStringImpl(
+    const double& value) const {
+  return FormatReal(value, digits_);
+}
+
+}  // namespace moriarty
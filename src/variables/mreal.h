@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MREAL_H_
+#define MORIARTY_SRC_VARIABLES_MREAL_H_
+
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "src/librarian/mvariable.h"
+#include "src/variables/constraints/base_constraints.h"
+
+namespace moriarty {
+
+// MReal
+//
+// Describes constraints placed on a real number (a `double`). Real numbers are
+// read and printed in fixed decimal notation, independent of the locale (see
+// `IOConfig::ReadReal()` and `IOConfig::PrintReal()`).
+//
+// In order to generate, the real number must be bounded (via `Between()`, or
+// `AtLeast()` and `AtMost()`). Generation only uses integer arithmetic and
+// correctly rounded operations, so the same seed gives the same values on every
+// platform.
+class MReal : public librarian::MVariable<MReal, double> {
+ public:
+  // Create an MReal from a set of constraints. Logically equivalent to calling
+  // AddConstraint() for each constraint.
+  //
+  // E.g., MReal(Exactly(0.5))
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MReal(Constraints&&... constraints);
+
+  // The real number must be exactly this value.
+  MReal& AddConstraint(const Exactly<double>& constraint);
+
+  [[nodiscard]] std::string Typename() const override { return "MReal"; }
+
+  // Between()
+  //
+  // Restrict this real number to be in the inclusive range [`minimum`,
+  // `maximum`]. If this restriction is called multiple times, the ranges are
+  // intersected together.
+  MReal& Between(double minimum, double maximum);
+
+  // AtLeast()
+  //
+  // Restricts this real number to be larger than or equal to `minimum`.
+  MReal& AtLeast(double minimum);
+
+  // AtMost()
+  //
+  // Restricts this real number to be smaller than or equal to `maximum`.
+  MReal& AtMost(double maximum);
+
+  // WithDigits()
+  //
+  // Restricts this real number to have at most `digits` digits after the
+  // decimal point (e.g., `WithDigits(2)` allows 1.25, but not 1.255). Values
+  // are generated uniformly among those numbers and are printed with exactly
+  // `digits` digits after the decimal point. `digits` must be in
+  // [0, `IOConfig::kMaxRealDigits`].
+  //
+  // Without this, values are generated uniformly in the range and printed with
+  // as many digits as needed to read them back exactly.
+  MReal& WithDigits(int digits);
+
+ private:
+  double minimum_ = -std::numeric_limits<double>::infinity();
+  double maximum_ = std::numeric_limits<double>::infinity();
+  std::optional<int> digits_;
+
+  // ScaledRange
+  //
+  // The values with `digits_` digits in [`minimum_`, `maximum_`] are
+  // `scaled / 10^digits_` for each `scaled` in [`min`, `max`].
+  struct ScaledRange {
+    int64_t min;
+    int64_t max;
+    double scale;
+  };
+
+  // GetScaledRange()
+  //
+  // Returns the range of scaled values. `digits_` must be set.
+  absl::StatusOr<ScaledRange> GetScaledRange() const;
+
+  // CheckBounded()
+  //
+  // Returns an error if values cannot be generated uniformly in [`minimum_`,
+  // `maximum_`].
+  absl::Status CheckBounded() const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<double> GenerateImpl() override;
+  absl::StatusOr<std::optional<std::vector<double>>> GenerateInBulkImpl(
+      int n) override;
+  absl::Status IsSatisfiedWithImpl(const double& value) const override;
+  absl::Status MergeFromImpl(const MReal& other) override;
+  absl::StatusOr<double> ReadImpl() override;
+  absl::Status PrintImpl(const double& value) override;
+  bool IsKnownUnsatisfiableImpl() const override;
+  std::string ToStringImpl() const override;
+  absl::StatusOr<std::string> ValueToStringImpl(
+      const double& value) const override;
+  // ---------------------------------------------------------------------------
+};
+
+// -----------------------------------------------------------------------------
+//  Implementation details
+// -----------------------------------------------------------------------------
+
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MReal::MReal(Constraints&&... constraints) {
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MREAL_H_
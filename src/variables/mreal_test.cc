@@ -0,0 +1,145 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mreal.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/marray.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::GenerateSameValues;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::AllOf;
+using ::testing::AnyOf;
+using ::testing::Ge;
+using ::testing::Le;
+
+TEST(MRealTest, TypenameIsCorrect) { EXPECT_EQ(MReal().Typename(), "MReal"); }
+
+TEST(MRealTest, GenerateShouldBeInTheRange) {
+  for (int i = 0; i < 100; i++) {
+    EXPECT_THAT(Generate(MReal().Between(-1.5, 2.25)),
+                IsOkAndHolds(AllOf(Ge(-1.5), Le(2.25))));
+  }
+}
+
+TEST(MRealTest, GenerateWithDigitsShouldOnlyHaveThatManyDigits) {
+  for (int i = 0; i < 100; i++) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(
+        double value, Generate(MReal().Between(0.05, 0.35).WithDigits(1)));
+    EXPECT_THAT(value, AnyOf(0.1, 0.2, 0.3));
+  }
+}
+
+TEST(MRealTest, GenerateWithASingleValueShouldReturnIt) {
+  EXPECT_THAT(Generate(MReal(Exactly(0.5))), IsOkAndHolds(0.5));
+  EXPECT_THAT(Generate(MReal().Between(0.1, 0.1).WithDigits(3)),
+              IsOkAndHolds(0.1));
+}
+
+TEST(MRealTest, GenerateWithoutFiniteBoundsShouldFail) {
+  EXPECT_THAT(Generate(MReal()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(MReal().AtLeast(0)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(MReal().Between(-std::numeric_limits<double>::max(),
+                                       std::numeric_limits<double>::max())),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MRealTest, GenerateWithNoValueWithTheDigitsShouldFail) {
+  EXPECT_THAT(Generate(MReal().Between(0.11, 0.19).WithDigits(1)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MRealTest, GenerateInBulkShouldGenerateTheSameValues) {
+  // A custom constraint forces each element through `Random()`.
+  auto always = [](double) { return true; };
+  for (MReal real : {MReal().Between(-10, 10),
+                     MReal().Between(-10, 10).WithDigits(3)}) {
+    EXPECT_TRUE(GenerateSameValues(
+        MArray(real).OfLength(100),
+        MArray(MReal(real).AddCustomConstraint("any", always)).OfLength(100)));
+  }
+}
+
+TEST(MRealTest, IsSatisfiedWithShouldCheckTheBounds) {
+  EXPECT_THAT(MReal().Between(0, 1), IsSatisfiedWith(0.0));
+  EXPECT_THAT(MReal().Between(0, 1), IsSatisfiedWith(1.0));
+  EXPECT_THAT(MReal().Between(0, 1), IsNotSatisfiedWith(1.5, "range"));
+  EXPECT_THAT(MReal(), IsNotSatisfiedWith(std::nan(""), "finite"));
+}
+
+TEST(MRealTest, IsSatisfiedWithShouldCheckTheDigits) {
+  EXPECT_THAT(MReal().WithDigits(2), IsSatisfiedWith(1.25));
+  EXPECT_THAT(MReal().WithDigits(2), IsSatisfiedWith(0.1));
+  EXPECT_THAT(MReal().WithDigits(2), IsNotSatisfiedWith(1.255, "digits"));
+}
+
+TEST(MRealTest, InvalidDigitsShouldFail) {
+  EXPECT_THAT(Generate(MReal().Between(0, 1).WithDigits(-1)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Generate(MReal().Between(0, 1).WithDigits(1).WithDigits(2)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MRealTest, MergeFromShouldIntersectTheRanges) {
+  MReal real = MReal().Between(0, 10);
+  real.MergeFrom(MReal().Between(5, 20).WithDigits(0));
+
+  EXPECT_THAT(real, IsSatisfiedWith(5.0));
+  EXPECT_THAT(real, IsSatisfiedWith(10.0));
+  EXPECT_THAT(real, IsNotSatisfiedWith(4.0, "range"));
+  EXPECT_THAT(real, IsNotSatisfiedWith(5.5, "digits"));
+}
+
+TEST(MRealTest, PrintShouldUseFixedNotation) {
+  EXPECT_THAT(Print(MReal(), 0.1), IsOkAndHolds("0.1"));
+  EXPECT_THAT(Print(MReal(), 1e-7), IsOkAndHolds("0.0000001"));
+  EXPECT_THAT(Print(MReal().WithDigits(3), 0.5), IsOkAndHolds("0.500"));
+}
+
+TEST(MRealTest, ReadShouldReadRealNumbers) {
+  EXPECT_THAT(Read(MReal(), "-2.5"), IsOkAndHolds(-2.5));
+  EXPECT_THAT(Read(MReal(), "1e3"), IsOkAndHolds(1000.0));
+  EXPECT_THAT(Read(MReal(), "nan"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MRealTest, PrintThenReadShouldGiveTheSameValue) {
+  for (double value : {0.1, -1.0 / 3.0, 123456.789, 5e-300}) {
+    MORIARTY_ASSERT_OK_AND_ASSIGN(std::string printed, Print(MReal(), value));
+    EXPECT_THAT(Read(MReal(), printed), IsOkAndHolds(value)) << printed;
+  }
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -0,0 +1,531 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MSTREAMED_ARRAY_H_
+#define MORIARTY_SRC_VARIABLES_MSTREAMED_ARRAY_H_
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/errors.h"
+#include "src/internal/generation_config.h"
+#include "src/internal/generation_context.h"
+#include "src/internal/random_engine.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/container_constraints.h"
+#include "src/variables/constraints/io_constraints.h"
+#include "src/variables/minteger.h"
+
+namespace moriarty {
+
+// StreamedArray<>
+//
+// An array whose elements are never all in memory at once. It is represented
+// by its length and the position of its random stream, and its elements are
+// generated again, `kChunkSize` at a time, whenever they are needed (e.g., to
+// print or validate them). Each chunk has its own random stream, so any chunk
+// can be generated without generating the ones before it.
+//
+// The elements are always the same, since they only depend on the element
+// constraints, the length and the stream.
+template <typename MElementType>
+class StreamedArray {
+ public:
+  using element_value_type = typename MElementType::value_type;
+
+  // The number of elements generated together.
+  static constexpr int64_t kChunkSize =
+      moriarty_internal::GenerationConfig::kParallelGenerationChunkSize;
+
+  // `elements` must not depend on other variables.
+  StreamedArray(MElementType elements, int64_t length, int64_t stream)
+      : elements_(std::move(elements)), length_(length), stream_(stream) {}
+
+  // size()
+  //
+  // The number of elements in this array.
+  [[nodiscard]] int64_t size() const { return length_; }
+
+  // NumChunks()
+  //
+  // The number of chunks of (at most) `kChunkSize` elements in this array.
+  [[nodiscard]] int64_t NumChunks() const {
+    return (length_ + kChunkSize - 1) / kChunkSize;
+  }
+
+  // GetChunk()
+  //
+  // Generates the elements with indices in [`chunk` * `kChunkSize`,
+  // (`chunk` + 1) * `kChunkSize`).
+  absl::StatusOr<std::vector<element_value_type>> GetChunk(
+      int64_t chunk) const;
+
+  // ForEachChunk()
+  //
+  // Calls `fn` with each chunk of elements, in order, and stops at the first
+  // error `fn` returns. Only one chunk is in memory at a time.
+  absl::Status ForEachChunk(
+      absl::FunctionRef<absl::Status(absl::Span<const element_value_type>)> fn)
+      const;
+
+  // ToVector()
+  //
+  // Generates all of the elements. Only use this for arrays that fit in
+  // memory.
+  absl::StatusOr<std::vector<element_value_type>> ToVector() const;
+
+  // Streamed arrays are compared by their length and stream, not by their
+  // elements. Arrays from the same MStreamedArray are equal if and only if
+  // their elements are.
+  friend bool operator==(const StreamedArray& lhs, const StreamedArray& rhs) {
+    return lhs.length_ == rhs.length_ && lhs.stream_ == rhs.stream_;
+  }
+  friend bool operator<(const StreamedArray& lhs, const StreamedArray& rhs) {
+    return std::pair(lhs.length_, lhs.stream_) <
+           std::pair(rhs.length_, rhs.stream_);
+  }
+
+ private:
+  MElementType elements_;
+  int64_t length_;
+  int64_t stream_;
+};
+
+// MStreamedArray<>
+//
+// Describes constraints placed on an array that may be too large to hold in
+// memory (e.g., 10^9 integers). Generated values are `StreamedArray`s, whose
+// elements are generated chunk by chunk as they are printed or validated, so
+// generating, printing (e.g., with `SimpleIOExporter`) and validating the
+// array all use O(`StreamedArray::kChunkSize`) memory.
+//
+// The elements must not depend on other variables, and, unlike `MArray`, the
+// elements have no order, distinctness or sum. The length may depend on other
+// variables. Streamed arrays cannot be read.
+template <typename MElementType>
+class MStreamedArray
+    : public librarian::MVariable<MStreamedArray<MElementType>,
+                                  StreamedArray<MElementType>> {
+ public:
+  using element_value_type = typename MElementType::value_type;
+  using streamed_value_type = StreamedArray<MElementType>;
+
+  // Create an MStreamedArray from a set of constraints. Logically equivalent
+  // to calling AddConstraint() for each constraint.
+  //
+  // E.g., MStreamedArray<MInteger>(Elements<MInteger>(Between(1, 10)),
+  //                                Length(1000000000))
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MStreamedArray(Constraints&&... constraints);
+
+  // Create an MStreamedArray with this set of constraints on each element.
+  explicit MStreamedArray(MElementType element_constraints);
+
+  // The array's elements must satisfy these constraints.
+  MStreamedArray& AddConstraint(const Elements<MElementType>& constraint);
+  // The array must have this length.
+  MStreamedArray& AddConstraint(const Length& constraint);
+  // The array's elements must be separated by this whitespace.
+  MStreamedArray& AddConstraint(const IOSeparator& constraint);
+
+  // Typename()
+  //
+  // Returns a string representing the name of this type (for example,
+  // "MStreamedArray<MInteger>"). This is mostly used for debugging/error
+  // messages.
+  [[nodiscard]] std::string Typename() const override;
+
+  // ValueByteSize()
+  //
+  // Returns the number of bytes of the elements of `value` if they were all
+  // in memory, as for `MArray`. The memory actually held by `value` is much
+  // smaller.
+  [[nodiscard]] static int64_t ValueByteSize(const streamed_value_type& value) {
+    if constexpr (std::is_arithmetic_v<element_value_type>) {
+      return value.size() * sizeof(element_value_type);
+    } else {
+      return value.size();
+    }
+  }
+
+  // Of()
+  //
+  // Add extra constraints to the elements of the array.
+  MStreamedArray& Of(MElementType variable);
+
+  // OfLength()
+  //
+  // Sets the constraints for the length of this array. If two parameters are
+  // provided, the length is in the closed range [`min_length`, `max_length`].
+  //
+  // For example:
+  // `OfLength(5, 10)` is equivalent to `OfLength(MInteger().Between(5, 10))`.
+  // `OfLength("3 * N")` is equivalent to `OfLength(MInteger().Is("3 * N"))`.
+  MStreamedArray& OfLength(const MInteger& length);
+  MStreamedArray& OfLength(int64_t length);
+  MStreamedArray& OfLength(absl::string_view length_expression);
+  MStreamedArray& OfLength(int64_t min_length, int64_t max_length);
+
+  // WithSeparator()
+  //
+  // Sets the whitespace separator to be used between different array entries
+  // when writing. Default = kSpace.
+  MStreamedArray& WithSeparator(Whitespace separator);
+
+ private:
+  MElementType element_constraints_;
+  std::optional<MInteger> length_;
+  std::optional<Whitespace> separator_;
+  Whitespace GetSeparator() const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<streamed_value_type> GenerateImpl() override;
+  absl::Status IsSatisfiedWithImpl(
+      const streamed_value_type& value) const override;
+  absl::Status IsSatisfiedWithGeneratedImpl(
+      const streamed_value_type& value) const override;
+  absl::Status MergeFromImpl(const MStreamedArray<MElementType>& other) override;
+  absl::StatusOr<streamed_value_type> ReadImpl() override;
+  absl::Status PrintImpl(const streamed_value_type& value) override;
+  std::vector<std::string> GetDependenciesImpl() const override;
+  std::string ToStringImpl() const override;
+  // ---------------------------------------------------------------------------
+};
+
+// Class template argument deduction (CTAD). Allows for
+// `MStreamedArray(MInteger())` instead of
+// `MStreamedArray<MInteger>(MInteger())`.
+template <typename MoriartyElementType>
+MStreamedArray(MoriartyElementType) -> MStreamedArray<MoriartyElementType>;
+
+// -----------------------------------------------------------------------------
+//  Template Implementation Below
+
+template <typename MElementType>
+auto StreamedArray<MElementType>::GetChunk(int64_t chunk) const
+    -> absl::StatusOr<std::vector<element_value_type>> {
+  if (chunk < 0 || chunk >= NumChunks()) {
+    return absl::OutOfRangeError(absl::Substitute(
+        "chunk $0 of a streamed array with $1 chunks", chunk, NumChunks()));
+  }
+  int64_t begin = chunk * kChunkSize;
+  int n = std::min(kChunkSize, length_ - begin);
+
+  // The counter-based engine is seeded in O(1), so each chunk may have its
+  // own stream.
+  moriarty_internal::RandomEngine engine(
+      {stream_, chunk}, moriarty_internal::kCounterBasedVersion);
+  moriarty_internal::GenerationContext context(
+      moriarty_internal::VariableSet(), moriarty_internal::ValueSet(), engine,
+      moriarty_internal::GenerationConfig());
+  MElementType element = elements_;
+  moriarty_internal::MVariableManager(&element).SetUniverse(
+      &context.GetUniverse(), "element");
+
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::optional<std::vector<element_value_type>> bulk_values,
+      moriarty_internal::MVariableManager(&element).GenerateInBulk(n));
+  if (bulk_values) return *std::move(bulk_values);
+
+  std::vector<element_value_type> values;
+  values.reserve(n);
+  for (int i = 0; i < n; i++) {
+    MORIARTY_ASSIGN_OR_RETURN(
+        element_value_type value,
+        moriarty_internal::MVariableManager(&element).Generate());
+    values.push_back(std::move(value));
+  }
+  return values;
+}
+
+template <typename MElementType>
+absl::Status StreamedArray<MElementType>::ForEachChunk(
+    absl::FunctionRef<absl::Status(absl::Span<const element_value_type>)> fn)
+    const {
+  for (int64_t chunk = 0; chunk < NumChunks(); chunk++) {
+    MORIARTY_ASSIGN_OR_RETURN(std::vector<element_value_type> values,
+                              GetChunk(chunk));
+    MORIARTY_RETURN_IF_ERROR(fn(values));
+  }
+  return absl::OkStatus();
+}
+
+template <typename MElementType>
+auto StreamedArray<MElementType>::ToVector() const
+    -> absl::StatusOr<std::vector<element_value_type>> {
+  std::vector<element_value_type> result;
+  result.reserve(length_);
+  MORIARTY_RETURN_IF_ERROR(
+      ForEachChunk([&](absl::Span<const element_value_type> values) {
+        result.insert(result.end(), values.begin(), values.end());
+        return absl::OkStatus();
+      }));
+  return result;
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>::MStreamedArray(MElementType element_constraints)
+    : MStreamedArray<MElementType>(
+          Elements<MElementType>(std::move(element_constraints))) {}
+
+template <typename MElementType>
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MStreamedArray<MElementType>::MStreamedArray(Constraints&&... constraints) {
+  static_assert(
+      std::derived_from<MElementType,
+                        librarian::MVariable<
+                            MElementType, typename MElementType::value_type>>,
+      "The T used in MStreamedArray<T> must be a Moriarty variable. For "
+      "example, MStreamedArray<MInteger>.");
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::AddConstraint(
+    const Elements<MElementType>& constraint) {
+  return Of(constraint.GetConstraints());
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::AddConstraint(
+    const Length& constraint) {
+  return OfLength(constraint.GetConstraints());
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::AddConstraint(
+    const IOSeparator& constraint) {
+  return WithSeparator(constraint.GetSeparator());
+}
+
+template <typename MElementType>
+std::string MStreamedArray<MElementType>::Typename() const {
+  return absl::StrCat("MStreamedArray<", element_constraints_.Typename(), ">");
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::Of(
+    MElementType variable) {
+  element_constraints_.MergeFrom(std::move(variable));
+  return *this;
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::OfLength(
+    const MInteger& length) {
+  if (length_)
+    length_->MergeFrom(length);
+  else
+    length_ = length;
+  return *this;
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::OfLength(
+    int64_t length) {
+  return OfLength(length, length);
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::OfLength(
+    absl::string_view length_expression) {
+  return OfLength(MInteger().Between(length_expression, length_expression));
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::OfLength(
+    int64_t min_length, int64_t max_length) {
+  return OfLength(MInteger().Between(min_length, max_length));
+}
+
+template <typename MElementType>
+MStreamedArray<MElementType>& MStreamedArray<MElementType>::WithSeparator(
+    Whitespace separator) {
+  if (separator_.has_value() && *separator_ != separator) {
+    this->DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        "Attempting to set multiple I/O separators for the same "
+        "MStreamedArray."));
+  } else {
+    separator_ = separator;
+  }
+  return *this;
+}
+
+template <typename MElementType>
+Whitespace MStreamedArray<MElementType>::GetSeparator() const {
+  return separator_.value_or(Whitespace::kSpace);
+}
+
+template <typename MElementType>
+auto MStreamedArray<MElementType>::GenerateImpl()
+    -> absl::StatusOr<streamed_value_type> {
+  if (!length_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a streamed array with no length parameter "
+        "given.");
+  }
+  if (!this->GetDependencies(element_constraints_).empty()) {
+    return absl::FailedPreconditionError(
+        "The elements of a streamed array cannot depend on other variables.");
+  }
+
+  // Ensure that the size is non-negative.
+  length_->AtLeast(0);
+
+  if (std::optional<int64_t> generation_limit =
+          this->GetApproximateGenerationLimit()) {
+    length_->AtMost(*generation_limit);
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(int64_t length, this->Random("length", *length_));
+  MORIARTY_ASSIGN_OR_RETURN(
+      int64_t stream,
+      this->Random("stream",
+                   MInteger().Between(0, std::numeric_limits<int64_t>::max())));
+  return streamed_value_type(element_constraints_, length, stream);
+}
+
+template <typename MElementType>
+absl::Status MStreamedArray<MElementType>::IsSatisfiedWithImpl(
+    const streamed_value_type& value) const {
+  if (length_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(this->SatisfiesConstraints(*length_, value.size()),
+                        "invalid MStreamedArray length"));
+  }
+
+  int64_t first_index = 0;
+  return value.ForEachChunk(
+      [&](absl::Span<const element_value_type> values) -> absl::Status {
+        // Only check the elements one at a time if the fast path cannot vouch
+        // for all of them (this also finds the first invalid element).
+        if (!this->AllSatisfyConstraints(element_constraints_, values)) {
+          for (int i = 0; i < values.size(); i++) {
+            MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+                this->SatisfiesConstraints(element_constraints_, values[i]),
+                absl::Substitute("invalid element $0 (0-based)",
+                                 first_index + i)));
+          }
+        }
+        first_index += values.size();
+        return absl::OkStatus();
+      });
+}
+
+template <typename MElementType>
+absl::Status MStreamedArray<MElementType>::IsSatisfiedWithGeneratedImpl(
+    const streamed_value_type& value) const {
+  // The elements of a generated array are generated from these element
+  // constraints, so only the length needs to be checked. Otherwise, every
+  // chunk would be generated again.
+  if (!length_) return absl::OkStatus();
+  return CheckConstraint(this->SatisfiesConstraints(*length_, value.size()),
+                         "invalid MStreamedArray length");
+}
+
+template <typename MElementType>
+absl::Status MStreamedArray<MElementType>::MergeFromImpl(
+    const MStreamedArray<MElementType>& other) {
+  Of(other.element_constraints_);
+  if (other.length_) OfLength(*other.length_);
+  if (other.separator_) WithSeparator(*other.separator_);
+  return absl::OkStatus();
+}
+
+template <typename MElementType>
+auto MStreamedArray<MElementType>::ReadImpl()
+    -> absl::StatusOr<streamed_value_type> {
+  return absl::UnimplementedError(
+      "A streamed array cannot be read. Use MArray instead.");
+}
+
+template <typename MElementType>
+absl::Status MStreamedArray<MElementType>::PrintImpl(
+    const streamed_value_type& value) {
+  MORIARTY_ASSIGN_OR_RETURN(librarian::IOConfig * io_config,
+                            this->GetIOConfig());
+  int64_t index = 0;
+  std::string element_name;
+  return value.ForEachChunk(
+      [&](absl::Span<const element_value_type> values) -> absl::Status {
+        for (const element_value_type& element : values) {
+          if (index > 0) {
+            MORIARTY_RETURN_IF_ERROR(
+                io_config->PrintWhitespace(GetSeparator()));
+          }
+          // Integers are written directly, without naming each element.
+          if constexpr (std::same_as<MElementType, MInteger>) {
+            MORIARTY_RETURN_IF_ERROR(io_config->PrintInteger(element));
+          } else {
+            element_name.clear();
+            absl::StrAppend(&element_name, "element[", index, "]");
+            MORIARTY_RETURN_IF_ERROR(
+                this->Print(element_name, element_constraints_, element));
+          }
+          index++;
+        }
+        return absl::OkStatus();
+      });
+}
+
+template <typename MElementType>
+std::vector<std::string> MStreamedArray<MElementType>::GetDependenciesImpl()
+    const {
+  std::vector<std::string> deps = this->GetDependencies(element_constraints_);
+  if (length_)
+    absl::c_move(this->GetDependencies(*length_), std::back_inserter(deps));
+  return deps;
+}
+
+template <typename MElementType>
+std::string MStreamedArray<MElementType>::ToStringImpl() const {
+  std::string result =
+      absl::StrCat("elements: (", element_constraints_.ToString(), "); ");
+  if (length_)
+    absl::StrAppend(&result, "length: (", length_->ToString(), "); ");
+  if (separator_) {
+    absl::StrAppend(&result, "separator: ",
+                    librarian::WhitespaceName(*separator_), "; ");
+  }
+  return result;
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MSTREAMED_ARRAY_H_
@@ -0,0 +1,146 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mstreamed_array.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_join.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::moriarty_testing::Context;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::AllOf;
+using ::testing::Each;
+using ::testing::ElementsAreArray;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Le;
+using ::testing::SizeIs;
+
+TEST(MStreamedArrayTest, TypenameIsCorrect) {
+  EXPECT_EQ(MStreamedArray(MInteger()).Typename(), "MStreamedArray<MInteger>");
+  EXPECT_EQ(MStreamedArray(MString()).Typename(), "MStreamedArray<MString>");
+}
+
+TEST(MStreamedArrayTest, StreamedArrayGivesTheSameElementsEachTime) {
+  StreamedArray<MInteger> array(MInteger().Between(1, 1000000), 10000, 42);
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> first, array.ToVector());
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> second, array.ToVector());
+
+  EXPECT_THAT(first, SizeIs(10000));
+  EXPECT_EQ(first, second);
+}
+
+TEST(MStreamedArrayTest, StreamedArrayChunksMatchTheWholeArray) {
+  StreamedArray<MInteger> array(MInteger().Between(1, 1000000), 10000, 42);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> all, array.ToVector());
+
+  ASSERT_EQ(array.NumChunks(), 3);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> last, array.GetChunk(2));
+  EXPECT_THAT(last, ElementsAreArray(all.begin() + 2 * array.kChunkSize,
+                                     all.end()));
+  EXPECT_THAT(array.GetChunk(3), StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(MStreamedArrayTest, DifferentStreamsGiveDifferentElements) {
+  StreamedArray<MInteger> a(MInteger().Between(1, 1000000), 100, 1);
+  StreamedArray<MInteger> b(MInteger().Between(1, 1000000), 100, 2);
+
+  EXPECT_NE(*a.ToVector(), *b.ToVector());
+}
+
+TEST(MStreamedArrayTest, GenerateRespectsTheLengthAndElementConstraints) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      StreamedArray<MInteger> array,
+      Generate(MStreamedArray(MInteger().Between(1, 10)).OfLength(5000, 9000)));
+
+  EXPECT_THAT(array.size(), AllOf(Ge(5000), Le(9000)));
+  EXPECT_THAT(array.ToVector(),
+              IsOkAndHolds(AllOf(SizeIs(array.size()),
+                                 Each(AllOf(Ge(1), Le(10))))));
+}
+
+TEST(MStreamedArrayTest, GenerateWithLengthFromAnotherVariableWorks) {
+  EXPECT_THAT(Generate(MStreamedArray(MInteger()).OfLength("N"),
+                       Context().WithValue<MInteger>("N", 20)),
+              IsOkAndHolds(SizeIs(20)));
+}
+
+TEST(MStreamedArrayTest, GenerateWithElementsThatDependOnVariablesFails) {
+  EXPECT_THAT(Generate(MStreamedArray(MInteger().Between(1, "N")).OfLength(5),
+                       Context().WithValue<MInteger>("N", 20)),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("depend")));
+}
+
+TEST(MStreamedArrayTest, PrintWritesEveryElementOfEveryChunk) {
+  StreamedArray<MInteger> array(MInteger().Between(1, 1000000), 10000, 42);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> all, array.ToVector());
+
+  EXPECT_THAT(Print(MStreamedArray(MInteger()), array),
+              IsOkAndHolds(absl::StrJoin(all, " ")));
+  EXPECT_THAT(
+      Print(MStreamedArray(MInteger()).WithSeparator(Whitespace::kNewline),
+            array),
+      IsOkAndHolds(absl::StrJoin(all, "\n")));
+}
+
+TEST(MStreamedArrayTest, PrintWorksForNonIntegerElements) {
+  StreamedArray<MString> array(MString().WithAlphabet("ab").OfLength(3), 5,
+                               42);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(std::vector<std::string> all,
+                                array.ToVector());
+
+  EXPECT_THAT(Print(MStreamedArray(MString()), array),
+              IsOkAndHolds(absl::StrJoin(all, " ")));
+}
+
+TEST(MStreamedArrayTest, IsSatisfiedWithChecksTheLengthAndEveryElement) {
+  StreamedArray<MInteger> array(MInteger().Between(1, 20), 10000, 42);
+
+  EXPECT_THAT(MStreamedArray(MInteger().Between(1, 20)).OfLength(10000),
+              IsSatisfiedWith(array));
+  EXPECT_THAT(MStreamedArray(MInteger().Between(1, 20)).OfLength(5),
+              IsNotSatisfiedWith(array, "length"));
+  EXPECT_THAT(MStreamedArray(MInteger().Between(1, 10)).OfLength(10000),
+              IsNotSatisfiedWith(array, "element"));
+}
+
+TEST(MStreamedArrayTest, ReadIsNotSupported) {
+  EXPECT_THAT(Read(MStreamedArray(MInteger()).OfLength(3), "1 2 3"),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+}  // namespace
+}  // namespace moriarty
@@ -15,23 +15,31 @@
 #include "src/variables/mstring.h"
 
 #include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "absl/algorithm/container.h"
-#include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "src/errors.h"
+#include "src/internal/anti_hash.h"
+#include "src/internal/balanced_brackets.h"
+#include "src/internal/character_set.h"
 #include "src/internal/random_engine.h"
+#include "src/internal/shrink.h"
 #include "src/internal/simple_pattern.h"
+#include "src/internal/simple_pattern_automaton.h"
 #include "src/librarian/io_config.h"
 #include "src/librarian/mvariable.h"
 #include "src/property.h"
@@ -76,6 +84,54 @@ MString& MString::AddConstraint(const SizeCategory& constraint) {
   return AddConstraint(Length(constraint));
 }
 
+MString& MString::AddConstraint(const StringStructure& constraint) {
+  if (constraint.GetKind() == StringStructure::Kind::kPeriodic &&
+      constraint.GetPeriod() <= 0) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(absl::Substitute(
+        "The period of a periodic string must be positive, but got $0",
+        constraint.GetPeriod())));
+    return *this;
+  }
+  if (constraint.GetKind() == StringStructure::Kind::kPolynomialHashCollision &&
+      constraint.GetModulus() <= 0) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(absl::Substitute(
+        "The modulus of a hash collision must be positive, but got $0",
+        constraint.GetModulus())));
+    return *this;
+  }
+  structure_ = constraint;
+  return *this;
+}
+
+MString& MString::AddConstraint(const BalancedBrackets& constraint) {
+  std::string error =
+      moriarty_internal::BracketsError(constraint.GetBrackets());
+  if (error.empty() && constraint.GetMaxDepth() < 0) {
+    error = absl::Substitute(
+        "The maximum depth must be non-negative, but got $0",
+        *constraint.GetMaxDepth());
+  }
+  if (error.empty() && balanced_brackets_ &&
+      balanced_brackets_->GetBrackets() != constraint.GetBrackets()) {
+    error = absl::Substitute(
+        "The string cannot be balanced with both '$0' and '$1'",
+        balanced_brackets_->GetBrackets(), constraint.GetBrackets());
+  }
+  if (!error.empty()) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(error));
+    return *this;
+  }
+
+  // With the same brackets, the smaller maximum depth wins.
+  if (!balanced_brackets_ || (constraint.GetMaxDepth() &&
+                              (!balanced_brackets_->GetMaxDepth() ||
+                               *constraint.GetMaxDepth() <
+                                   *balanced_brackets_->GetMaxDepth()))) {
+    balanced_brackets_ = constraint;
+  }
+  return *this;
+}
+
 MString& MString::OfLength(const MInteger& length) {
   return AddConstraint(Length(length));
 }
@@ -109,38 +165,38 @@ MString& MString::OfLength(absl::string_view min_length_expression,
 }
 
 MString& MString::WithAlphabet(absl::string_view valid_characters) {
-  // If `valid_characters` isn't sorted or contains multiple occurrences of
-  // the same letter, we need to create a new string in order to sort the
-  // characters.
-  std::string valid_character_str;
-  if (!absl::c_is_sorted(valid_characters) ||
-      absl::c_adjacent_find(valid_characters) != std::end(valid_characters)) {
-    valid_character_str = valid_characters;
-
-    // Sort
-    absl::c_sort(valid_character_str);
-    // Remove duplicates
-    valid_character_str.erase(
-        std::unique(valid_character_str.begin(), valid_character_str.end()),
-        valid_character_str.end());
-    valid_characters = valid_character_str;
-  }
-
-  if (!alphabet_) {
-    alphabet_ = valid_characters;
-  } else {  // Do set intersection of the two alphabets
-    alphabet_->erase(absl::c_set_intersection(valid_characters, *alphabet_,
-                                              alphabet_->begin()),
-                     alphabet_->end());
-  }
-
+  IntersectAlphabet(moriarty_internal::CharacterSet(valid_characters));
   return *this;
 }
 
+void MString::IntersectAlphabet(
+    const moriarty_internal::CharacterSet& valid_characters) {
+  std::optional<moriarty_internal::CharacterSet>& alphabet =
+      alphabet_.Mutable();
+  if (!alphabet) {
+    alphabet = valid_characters;
+  } else {
+    alphabet->IntersectWith(valid_characters);
+  }
+}
+
 MString& MString::WithDistinctCharacters() {
   return AddConstraint(DistinctCharacters());
 }
 
+MString& MString::WithStructure(StringStructure::Kind kind, int64_t period) {
+  return AddConstraint(StringStructure(kind, period));
+}
+
+MString& MString::WithBalancedBrackets(absl::string_view brackets) {
+  return AddConstraint(BalancedBrackets(brackets));
+}
+
+MString& MString::WithBalancedBrackets(absl::string_view brackets,
+                                       int64_t max_depth) {
+  return AddConstraint(BalancedBrackets(brackets, max_depth));
+}
+
 MString& MString::WithSimplePattern(absl::string_view simple_pattern) {
   absl::StatusOr<moriarty_internal::SimplePattern> pattern =
       moriarty_internal::SimplePattern::Create(simple_pattern);
@@ -150,16 +206,22 @@ MString& MString::WithSimplePattern(absl::string_view simple_pattern) {
     return *this;
   }
 
-  simple_patterns_.push_back(*std::move(pattern));
+  simple_patterns_.Mutable().push_back(*std::move(pattern));
   return *this;
 }
 
 absl::Status MString::MergeFromImpl(const MString& other) {
   if (other.length_) OfLength(*other.length_);
-  if (other.alphabet_) WithAlphabet(*other.alphabet_);
+  if (other.alphabet_.Get()) IntersectAlphabet(*other.alphabet_.Get());
   distinct_characters_ = other.distinct_characters_;
-  for (const auto& pattern : other.simple_patterns_)
-    simple_patterns_.push_back(pattern);
+  if (other.structure_) structure_ = other.structure_;
+  if (other.balanced_brackets_) AddConstraint(*other.balanced_brackets_);
+  if (!other.simple_patterns_.Get().empty()) {
+    std::vector<moriarty_internal::SimplePattern>& patterns =
+        simple_patterns_.Mutable();
+    for (const auto& pattern : other.simple_patterns_.Get())
+      patterns.push_back(pattern);
+  }
 
   return absl::OkStatus();
 }
@@ -171,36 +233,133 @@ absl::Status MString::IsSatisfiedWithImpl(const std::string& value) const {
                         "length of string is invalid"));
   }
 
-  if (alphabet_) {
-    for (char c : value) {
-      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
-          absl::c_binary_search(*alphabet_, c),
-          absl::Substitute("character '$0' not in alphabet, but in '$1'", c,
-                           value)));
+  if (alphabet_.Get()) {
+    size_t invalid = alphabet_.Get()->FindFirstNotInSet(value);
+    if (invalid != absl::string_view::npos) {
+      return UnsatisfiedConstraintError(
+          absl::Substitute("character '$0' not in alphabet, but in '$1'",
+                           value[invalid], value));
     }
   }
 
   if (distinct_characters_) {
-    absl::flat_hash_set<char> seen;
-    for (char c : value) {
-      auto [it, inserted] = seen.insert(c);
-      MORIARTY_RETURN_IF_ERROR(CheckConstraint(
-          inserted,
-          absl::Substitute(
-              "Characters are not distinct. '$0' appears multiple times.", c)));
+    size_t duplicate = moriarty_internal::FindFirstDuplicateCharacter(value);
+    if (duplicate != absl::string_view::npos) {
+      return UnsatisfiedConstraintError(absl::Substitute(
+          "Characters are not distinct. '$0' appears multiple times.",
+          value[duplicate]));
     }
   }
 
-  for (const moriarty_internal::SimplePattern& pattern : simple_patterns_) {
+  for (const moriarty_internal::SimplePattern& pattern :
+       simple_patterns_.Get()) {
     MORIARTY_RETURN_IF_ERROR(CheckConstraint(
         pattern.Matches(value),
         absl::Substitute("string '$0' does not match simple pattern '$1'",
                          value, pattern.Pattern())));
   }
 
+  if (balanced_brackets_) {
+    std::string error = moriarty_internal::BalancedBracketsError(
+        value, balanced_brackets_->GetBrackets(),
+        balanced_brackets_->GetMaxDepth());
+    if (!error.empty()) return UnsatisfiedConstraintError(error);
+  }
+
   return absl::OkStatus();
 }
 
+namespace {
+
+// Splits `characters` into consecutive strings of the given lengths.
+std::vector<std::string> SplitByLengths(absl::string_view characters,
+                                        absl::Span<const int64_t> lengths) {
+  std::vector<std::string> result;
+  result.reserve(lengths.size());
+  for (int64_t length : lengths) {
+    result.emplace_back(characters.substr(0, length));
+    characters.remove_prefix(length);
+  }
+  return result;
+}
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325;
+constexpr uint64_t kFnvPrime = 0x100000001b3;
+
+}  // namespace
+
+absl::StatusOr<MString::StreamedString> MString::ReadStreamed(
+    StreamedStorage storage) {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+
+  // The simple pattern matcher and the bracket checker need the whole token.
+  bool keep_value = storage == StreamedStorage::kFullValue ||
+                    !simple_patterns_.Get().empty() || balanced_brackets_;
+  const std::optional<moriarty_internal::CharacterSet>& alphabet =
+      alphabet_.Get();
+
+  StreamedString result;
+  result.fingerprint = kFnvOffsetBasis;
+  std::string value;
+  std::bitset<256> seen;
+
+  MORIARTY_RETURN_IF_ERROR(io_config->ReadTokenInChunks(
+      [&](absl::string_view chunk) -> absl::Status {
+        if (alphabet) {
+          size_t invalid = alphabet->FindFirstNotInSet(chunk);
+          if (invalid != absl::string_view::npos) {
+            return UnsatisfiedConstraintError(absl::Substitute(
+                "character '$0' not in alphabet, but at index $1",
+                chunk[invalid], result.length + invalid));
+          }
+        }
+        for (char c : chunk) {
+          uint8_t byte = static_cast<uint8_t>(c);
+          if (distinct_characters_) {
+            if (seen[byte]) {
+              return UnsatisfiedConstraintError(absl::Substitute(
+                  "Characters are not distinct. '$0' appears multiple times.",
+                  c));
+            }
+            seen[byte] = true;
+          }
+          result.fingerprint = (result.fingerprint ^ byte) * kFnvPrime;
+        }
+        result.length += chunk.size();
+        if (keep_value) value.append(chunk);
+        return absl::OkStatus();
+      }));
+
+  if (length_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(SatisfiesConstraints(*length_, result.length),
+                        "length of string is invalid"));
+  }
+
+  for (const moriarty_internal::SimplePattern& pattern :
+       simple_patterns_.Get()) {
+    MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+        pattern.Matches(value),
+        absl::Substitute("string '$0' does not match simple pattern '$1'",
+                         value, pattern.Pattern())));
+  }
+
+  if (balanced_brackets_) {
+    std::string error = moriarty_internal::BalancedBracketsError(
+        value, balanced_brackets_->GetBrackets(),
+        balanced_brackets_->GetMaxDepth());
+    if (!error.empty()) return UnsatisfiedConstraintError(error);
+  }
+
+  if (storage == StreamedStorage::kFullValue) result.value = std::move(value);
+  return result;
+}
+
+std::optional<std::string> MString::ShrinkImpl(const std::string& value,
+                                               int level, int64_t index) const {
+  return moriarty_internal::RemoveChunk(value, level, index);
+}
+
 absl::StatusOr<std::vector<MString>> MString::GetDifficultInstancesImpl()
     const {
   if (!length_) {
@@ -222,72 +381,315 @@ absl::StatusOr<std::vector<MString>> MString::GetDifficultInstancesImpl()
   return values;
 }
 
+bool MString::IsKnownUnsatisfiableImpl() const {
+  if (simple_patterns_.Get().empty() && alphabet_.Get() &&
+      alphabet_.Get()->empty())
+    return true;
+  if (!length_) return false;
+  MInteger length = *length_;
+  length.AtLeast(0);
+  return IsKnownUnsatisfiable("length", length);
+}
+
 absl::StatusOr<std::string> MString::GenerateImpl() {
-  if (simple_patterns_.empty() && (!alphabet_ || alphabet_->empty())) {
+  if (balanced_brackets_) return GenerateWithBalancedBrackets();
+
+  if (simple_patterns_.Get().empty() &&
+      (!alphabet_.Get() || alphabet_.Get()->empty())) {
     return absl::FailedPreconditionError(
         "Attempting to generate a string with an empty alphabet and no simple "
         "pattern.");
   }
-  if (simple_patterns_.empty() && !length_) {
+  if (simple_patterns_.Get().empty() && !length_) {
     return absl::FailedPreconditionError(
         "Attempting to generate a string with no length parameter or simple "
         "pattern given.");
   }
 
-  if (!simple_patterns_.empty()) return GenerateSimplePattern();
+  if (structure_ &&
+      (!simple_patterns_.Get().empty() || distinct_characters_)) {
+    return absl::FailedPreconditionError(
+        "A string structure cannot be combined with simple patterns or "
+        "distinct characters.");
+  }
+  if (!simple_patterns_.Get().empty() && !length_)
+    return GenerateSimplePattern(std::nullopt);
 
-  // Negative string length is impossible.
-  length_->AtLeast(0);
+  MORIARTY_RETURN_IF_ERROR(ConstrainLength());
 
-  if (length_size_property_) {
-    MORIARTY_RETURN_IF_ERROR(length_->OfSizeProperty(*length_size_property_));
+  if (simple_patterns_.Get().empty() && distinct_characters_)
+    return GenerateImplWithDistinctCharacters();
+
+  MORIARTY_ASSIGN_OR_RETURN(int length, Random("length", *length_),
+                            _ << "Error determining the length of the string");
+
+  if (length < 0) {
+    return absl::InvalidArgumentError("Length must be non-negative");
   }
 
-  std::optional<int64_t> generation_limit =
-      this->GetApproximateGenerationLimit();
+  if (!simple_patterns_.Get().empty()) return GenerateSimplePattern(length);
+  if (structure_) return GenerateWithStructure(length);
 
-  if (generation_limit) {
-    length_->AtMost(*generation_limit);
+  std::string result;
+  MORIARTY_RETURN_IF_ERROR(AppendRandomCharacters(length, result));
+  return result;
+}
+
+absl::StatusOr<std::optional<std::vector<std::string>>>
+MString::GenerateInBulkImpl(int n) {
+  // Only strings described by just a length and an alphabet are generated in
+  // bulk. Let `Generate()` deal with everything else.
+  if (!simple_patterns_.Get().empty() || structure_ || distinct_characters_ ||
+      balanced_brackets_ || !length_ || !alphabet_.Get() ||
+      alphabet_.Get()->empty()) {
+    return std::nullopt;
   }
+  MORIARTY_RETURN_IF_ERROR(ConstrainLength());
+
+  // Identical to calling `GenerateImpl()` `n` times, but the characters of all
+  // of the strings are drawn into one buffer instead of one temporary each.
+  std::vector<int64_t> lengths(n);
+  std::string characters;
+  for (int64_t& length : lengths) {
+    MORIARTY_ASSIGN_OR_RETURN(length, Random("length", *length_),
+                              _ << "Error determining the length of the string");
+    if (length < 0) {
+      return absl::InvalidArgumentError("Length must be non-negative");
+    }
+    MORIARTY_RETURN_IF_ERROR(AppendRandomCharacters(length, characters));
+  }
+  return SplitByLengths(characters, lengths);
+}
 
-  if (distinct_characters_) return GenerateImplWithDistinctCharacters();
+absl::StatusOr<std::optional<std::vector<std::string>>>
+MString::GenerateInBulkWithSumImpl(int n, int64_t sum) {
+  // Same restrictions as `GenerateInBulkImpl()`.
+  if (!simple_patterns_.Get().empty() || structure_ || distinct_characters_ ||
+      balanced_brackets_ || !length_ || !alphabet_.Get() ||
+      alphabet_.Get()->empty()) {
+    return std::nullopt;
+  }
+  MORIARTY_RETURN_IF_ERROR(ConstrainLength());
+
+  // Split the total length between the strings first (respecting `length_`),
+  // then fill each string with its assigned number of characters.
+  MORIARTY_ASSIGN_OR_RETURN(std::optional<std::vector<int64_t>> lengths,
+                            RandomInBulkWithSum("length", *length_, n, sum));
+  if (!lengths) return std::nullopt;
+
+  std::string characters;
+  characters.reserve(sum);
+  for (int64_t length : *lengths)
+    MORIARTY_RETURN_IF_ERROR(AppendRandomCharacters(length, characters));
+  return SplitByLengths(characters, *lengths);
+}
 
-  MORIARTY_ASSIGN_OR_RETURN(int length, Random("length", *length_),
-                            _ << "Error determining the length of the string");
+absl::StatusOr<std::string> MString::GenerateWithBalancedBrackets() {
+  if (!simple_patterns_.Get().empty() || distinct_characters_ || structure_) {
+    return absl::FailedPreconditionError(
+        "Balanced brackets cannot be combined with simple patterns, distinct "
+        "characters or a string structure.");
+  }
+  if (!length_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate balanced brackets with no length parameter "
+        "given.");
+  }
+
+  // Only the pairs of brackets that are both in the alphabet can be used.
+  const std::string all_brackets = balanced_brackets_->GetBrackets();
+  const std::optional<moriarty_internal::CharacterSet>& alphabet =
+      alphabet_.Get();
+  std::string brackets;
+  for (int i = 0; i + 1 < all_brackets.size(); i += 2) {
+    if (!alphabet || (alphabet->Contains(all_brackets[i]) &&
+                      alphabet->Contains(all_brackets[i + 1]))) {
+      absl::StrAppend(&brackets, all_brackets.substr(i, 2));
+    }
+  }
+  if (brackets.empty()) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate balanced brackets, but no pair of brackets is "
+        "in the alphabet.");
+  }
+
+  MORIARTY_RETURN_IF_ERROR(ConstrainLength());
+  MInteger length_constraints = *length_;
+  length_constraints.AddConstraint(MultipleOf(2));
+  if (balanced_brackets_->GetMaxDepth() == 0) length_constraints.AtMost(0);
+  MORIARTY_ASSIGN_OR_RETURN(
+      int64_t length, Random("length", length_constraints),
+      _ << "Error determining the length of the balanced brackets");
+
+  // MString needs direct access its RandomEngine. Non built-in types should not
+  // access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  return moriarty_internal::GenerateBalancedBrackets(
+      length, brackets, balanced_brackets_->GetMaxDepth(), rng);
+}
+
+absl::Status MString::AppendRandomCharacters(int64_t length,
+                                             std::string& characters) {
+  // Nothing is drawn, so an empty alphabet is fine.
+  if (length == 0) return absl::OkStatus();
 
-  std::vector<char> alphabet(alphabet_->begin(), alphabet_->end());
-  MORIARTY_ASSIGN_OR_RETURN(std::vector<char> ret,
-                            RandomElementsWithReplacement(alphabet, length));
+  // MString needs direct access its RandomEngine. Non built-in types should not
+  // access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  const std::string& alphabet = alphabet_.Get()->Characters();
+
+  // Draw the indices directly into `characters`, then map them to characters.
+  size_t begin = characters.size();
+  characters.resize(begin + length);
+  absl::Span<uint8_t> indices = absl::MakeSpan(
+      reinterpret_cast<uint8_t*>(characters.data() + begin), length);
+  MORIARTY_RETURN_IF_ERROR(rng.RandIndices(alphabet.size(), indices));
+  for (uint8_t& index : indices) index = alphabet[index];
+  return absl::OkStatus();
+}
 
-  return std::string(ret.begin(), ret.end());
+absl::Status MString::ConstrainLength() {
+  // Negative string length is impossible.
+  length_->AtLeast(0);
+
+  if (length_size_property_) {
+    MORIARTY_RETURN_IF_ERROR(length_->OfSizeProperty(*length_size_property_));
+  }
+
+  if (std::optional<int64_t> generation_limit =
+          this->GetApproximateGenerationLimit()) {
+    length_->AtMost(*generation_limit);
+  }
+  return absl::OkStatus();
 }
 
-absl::StatusOr<std::string> MString::GenerateSimplePattern() {
-  ABSL_CHECK(!simple_patterns_.empty());
+absl::StatusOr<std::string> MString::GenerateSimplePattern(
+    std::optional<int64_t> length) {
+  ABSL_CHECK(!simple_patterns_.Get().empty());
 
   // MString needs direct access its RandomEngine. Non built-in types should not
   // access the RandomEngine directly, use Random(MInteger().Between(x, y))
   // instead.
   moriarty_internal::RandomEngine& rng =
       moriarty_internal::MVariableManager(this).GetRandomEngine();
+  std::optional<absl::string_view> alphabet;
+  if (alphabet_.Get()) alphabet = alphabet_.Get()->Characters();
+
+  // With several patterns or a fixed length, generate directly from the
+  // strings that satisfy all of them, instead of hoping that a string from one
+  // pattern satisfies the others.
+  if (length || simple_patterns_.Get().size() > 1) {
+    std::optional<int64_t> generation_limit =
+        this->GetApproximateGenerationLimit();
+    absl::StatusOr<moriarty_internal::SimplePatternAutomaton> automaton =
+        moriarty_internal::SimplePatternAutomaton::Create(
+            simple_patterns_.Get(), alphabet, length.value_or(0),
+            length.value_or(generation_limit.value_or(
+                std::numeric_limits<int64_t>::max())));
+    if (automaton.ok()) return automaton->Generate(rng);
+    if (!absl::IsUnimplemented(automaton.status())) return automaton.status();
+  }
+
   // Use the last pattern, since it's probably the most specific. This choice is
   // arbitrary since all patterns must be satisfied.
-  return simple_patterns_.back().GenerateWithRestrictions(alphabet_, rng);
+  return simple_patterns_.Get().back().GenerateWithRestrictions(alphabet, rng);
+}
+
+absl::StatusOr<std::string> MString::GenerateWithStructure(int64_t length) {
+  // MString needs direct access its RandomEngine. Non built-in types should not
+  // access the RandomEngine directly.
+  moriarty_internal::RandomEngine& rng =
+      moriarty_internal::MVariableManager(this).GetRandomEngine();
+  const std::string& alphabet = alphabet_.Get()->Characters();
+  std::string result(length, '\0');
+
+  // The two characters used by the Fibonacci word and low entropy strings.
+  MORIARTY_ASSIGN_OR_RETURN(int64_t first, rng.RandInt(alphabet.size()));
+  int64_t second = first;
+  if (alphabet.size() > 1) {
+    MORIARTY_ASSIGN_OR_RETURN(second, rng.RandInt(alphabet.size() - 1));
+    if (second >= first) second++;
+  }
+
+  switch (structure_->GetKind()) {
+    case StringStructure::Kind::kPeriodic: {
+      int64_t block_length = std::min(structure_->GetPeriod(), length);
+      MORIARTY_RETURN_IF_ERROR(rng.RandIndices(
+          alphabet.size(),
+          absl::MakeSpan(reinterpret_cast<uint8_t*>(result.data()),
+                         block_length)));
+      for (int64_t i = 0; i < block_length; i++)
+        result[i] = alphabet[static_cast<uint8_t>(result[i])];
+      for (int64_t i = block_length; i < length; i++)
+        result[i] = result[i - block_length];
+      return result;
+    }
+    case StringStructure::Kind::kFibonacciWord: {
+      // Each Fibonacci word is the previous one followed by the one before
+      // that, which is also a prefix of the previous one.
+      result = {alphabet[first], alphabet[second]};
+      int64_t previous_length = 1;
+      while (static_cast<int64_t>(result.size()) < length) {
+        int64_t current_length = result.size();
+        result.append(result, 0, previous_length);
+        previous_length = current_length;
+      }
+      result.resize(length);
+      return result;
+    }
+    case StringStructure::Kind::kLowEntropy: {
+      // Alternate between the two characters, in runs of up to sqrt(length).
+      int64_t max_run = std::max<int64_t>(1, std::sqrt(length));
+      bool use_first = true;
+      for (int64_t i = 0; i < length; use_first = !use_first) {
+        MORIARTY_ASSIGN_OR_RETURN(int64_t run, rng.RandInt(max_run));
+        int64_t end = std::min(length, i + run + 1);
+        for (; i < end; i++) result[i] = alphabet[use_first ? first : second];
+      }
+      return result;
+    }
+    case StringStructure::Kind::kThueMorse:
+      return moriarty_internal::ThueMorseString(length, alphabet[first],
+                                                alphabet[second]);
+    case StringStructure::Kind::kPolynomialHashCollision: {
+      if (alphabet.size() < 2) {
+        return absl::FailedPreconditionError(
+            "A hash collision needs at least two characters in the alphabet.");
+      }
+      MORIARTY_ASSIGN_OR_RETURN(
+          (std::pair<std::string, std::string> halves),
+          moriarty_internal::FindPolynomialHashCollision(
+              structure_->GetBase(), structure_->GetModulus(), length / 2,
+              alphabet[first], alphabet[second], rng));
+      result = halves.first + halves.second;
+      if (length % 2 == 1) result += alphabet[first];
+      return result;
+    }
+  }
+  return absl::InternalError("Unknown string structure.");
 }
 
 absl::StatusOr<std::string> MString::GenerateImplWithDistinctCharacters() {
   // Creating a copy in case the alphabet changes in the future, we don't want
   // to limit the length forever.
   MInteger mlength = *length_;
-  mlength.AtMost(alphabet_->size());  // Each char appears at most once.
+  mlength.AtMost(alphabet_.Get()->size());  // Each char appears at most once.
   MORIARTY_ASSIGN_OR_RETURN(int length, Random("length", mlength),
                             _ << "Error determining the length of the string");
 
-  std::vector<char> alphabet(alphabet_->begin(), alphabet_->end());
-  MORIARTY_ASSIGN_OR_RETURN(std::vector<char> ret,
-                            RandomElementsWithoutReplacement(alphabet, length));
+  // Pick the positions of the characters directly, instead of copying the
+  // alphabet and the chosen characters into temporary vectors.
+  const std::string& characters = alphabet_.Get()->Characters();
+  MORIARTY_ASSIGN_OR_RETURN(
+      std::vector<int64_t> indices,
+      DistinctIntegers(static_cast<int64_t>(characters.size()), length));
 
-  return std::string(ret.begin(), ret.end());
+  std::string result;
+  result.reserve(length);
+  for (int64_t index : indices) result.push_back(characters[index]);
+  return result;
 }
 
 absl::Status MString::OfSizeProperty(Property property) {
@@ -312,14 +714,22 @@ absl::Status MString::PrintImpl(const std::string& value) {
 std::string MString::ToStringImpl() const {
   std::string result;
   if (length_) absl::StrAppend(&result, "length: ", length_->ToString(), "; ");
-  if (alphabet_) absl::StrAppend(&result, "alphabet: ", *alphabet_, "; ");
+  if (alphabet_.Get())
+    absl::StrAppend(&result, "alphabet: ", alphabet_.Get()->Characters(),
+                    "; ");
   if (distinct_characters_)
     absl::StrAppend(&result, "Only distinct characters; ");
-  for (const moriarty_internal::SimplePattern& pattern : simple_patterns_)
+  for (const moriarty_internal::SimplePattern& pattern : simple_patterns_.Get())
     absl::StrAppend(&result, "simple_pattern: ", pattern.Pattern(), "; ");
   if (length_size_property_.has_value())
     absl::StrAppend(&result, "length: ", length_size_property_->ToString(),
                     "; ");
+  if (structure_)
+    absl::StrAppend(&result, "structure: ", structure_->ToString(), "; ");
+  if (balanced_brackets_) {
+    absl::StrAppend(&result, "balanced brackets: ",
+                    balanced_brackets_->ToString(), "; ");
+  }
   return result;
 }
 
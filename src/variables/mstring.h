@@ -27,6 +27,8 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "src/internal/character_set.h"
+#include "src/internal/copy_on_write.h"
 #include "src/internal/simple_pattern.h"
 #include "src/librarian/mvariable.h"
 #include "src/property.h"
@@ -82,6 +84,10 @@ class MString : public librarian::MVariable<MString, std::string> {
   MString& AddConstraint(const SimplePattern& constraint);
   // The string should be approximately this size.
   MString& AddConstraint(const SizeCategory& constraint);
+  // Generated strings should have this structure.
+  MString& AddConstraint(const StringStructure& constraint);
+  // The string must be a balanced sequence of brackets.
+  MString& AddConstraint(const BalancedBrackets& constraint);
 
   [[nodiscard]] std::string Typename() const override { return "MString"; }
 
@@ -132,21 +138,114 @@ class MString : public librarian::MVariable<MString, std::string> {
   // TODO(darcybest): Add more specific documentation for simple pattern.
   MString& WithSimplePattern(absl::string_view simple_pattern);
 
+  // WithStructure()
+  //
+  // Tells generated strings to have a structure that is a worst case for many
+  // string algorithms (e.g., `WithStructure(StringStructure::Kind::kPeriodic,
+  // 3)` repeats a random block of 3 characters). `period` is only used by
+  // `kPeriodic`. See `StringStructure` for the available structures.
+  //
+  // The string is still built from the alphabet with a length from `Length`,
+  // but this cannot be combined with simple patterns or distinct characters.
+  // This only affects generation, not which strings are valid.
+  MString& WithStructure(StringStructure::Kind kind, int64_t period = 0);
+
+  // WithBalancedBrackets()
+  //
+  // States that this string must be a balanced sequence of the pairs of
+  // brackets in `brackets` (e.g., "()[]"), nested at most `max_depth` deep if
+  // given. Generated strings use the pairs whose characters are both in the
+  // alphabet (if set), and cannot be combined with simple patterns, distinct
+  // characters or a structure. A length is required to generate.
+  MString& WithBalancedBrackets(absl::string_view brackets = "()");
+  MString& WithBalancedBrackets(absl::string_view brackets, int64_t max_depth);
+
+  // StreamedStorage
+  //
+  // What `ReadStreamed()` keeps of the token it reads.
+  enum class StreamedStorage { kDigestOnly, kFullValue };
+
+  // StreamedString
+  //
+  // The result of `ReadStreamed()`.
+  struct StreamedString {
+    int64_t length = 0;
+    // 64-bit FNV-1a hash of the token. Stable across runs and platforms.
+    uint64_t fingerprint = 0;
+    // The token itself. Only set for `StreamedStorage::kFullValue`.
+    std::optional<std::string> value;
+  };
+
+  // ReadStreamed() [Internal Extended API]
+  //
+  // Reads the next token from this variable's IOConfig and checks it against
+  // the length, alphabet, distinct characters, simple pattern and balanced
+  // brackets constraints of this MString. The alphabet and distinct characters
+  // are checked as the token is read, so an invalid character is reported
+  // without reading the rest of the token. With `kDigestOnly`, the token is
+  // never held in memory, unless a simple pattern or balanced brackets have to
+  // be checked against it.
+  //
+  // Constraints that need the whole value (`IsOneOf()`, custom constraints) are
+  // not checked. If the token is invalid, the input stream is in an
+  // unspecified state.
+  absl::StatusOr<StreamedString> ReadStreamed(
+      StreamedStorage storage = StreamedStorage::kDigestOnly);
+
  private:
   // A value of length must be set prior to GenerateValue() being called.
   std::optional<MInteger> length_;
 
-  // alphabet_ is a sorted list of characters that are valid to be in the
-  // string.
-  std::optional<std::string> alphabet_;
+  // alphabet_ is the set of characters that are valid to be in the string.
+  // Shared between copies of this MString until modified.
+  moriarty_internal::CopyOnWrite<std::optional<moriarty_internal::CharacterSet>>
+      alphabet_;
 
   bool distinct_characters_ = false;
 
   std::optional<Property> length_size_property_;
 
-  std::vector<moriarty_internal::SimplePattern> simple_patterns_;
+  std::optional<StringStructure> structure_;
 
-  absl::StatusOr<std::string> GenerateSimplePattern();
+  std::optional<BalancedBrackets> balanced_brackets_;
+
+  // Shared between copies of this MString until modified.
+  moriarty_internal::CopyOnWrite<std::vector<moriarty_internal::SimplePattern>>
+      simple_patterns_;
+
+  // Restricts the alphabet to those characters also in `valid_characters`.
+  void IntersectAlphabet(
+      const moriarty_internal::CharacterSet& valid_characters);
+
+  // GenerateSimplePattern()
+  //
+  // Generates a string that matches the simple patterns (with `length`, if
+  // set). Several patterns or a `length` are handled exactly when the patterns
+  // have no or-expressions; otherwise, only the last pattern is used.
+  absl::StatusOr<std::string> GenerateSimplePattern(
+      std::optional<int64_t> length);
+
+  // GenerateWithStructure()
+  //
+  // Generates a string of length `length` with the structure in `structure_`.
+  absl::StatusOr<std::string> GenerateWithStructure(int64_t length);
+
+  // GenerateWithBalancedBrackets()
+  //
+  // Generates a string with the brackets in `balanced_brackets_`.
+  absl::StatusOr<std::string> GenerateWithBalancedBrackets();
+
+  // ConstrainLength()
+  //
+  // Restricts `length_` (which must be set) to the lengths that may be
+  // generated: non-negative, of the requested size and within the generation
+  // limit.
+  absl::Status ConstrainLength();
+
+  // AppendRandomCharacters()
+  //
+  // Appends `length` random characters from the alphabet to `characters`.
+  absl::Status AppendRandomCharacters(int64_t length, std::string& characters);
 
   // GenerateImplWithDistinctCharacters()
   //
@@ -156,6 +255,10 @@ class MString : public librarian::MVariable<MString, std::string> {
   // ---------------------------------------------------------------------------
   //  MVariable overrides
   absl::StatusOr<std::string> GenerateImpl() override;
+  absl::StatusOr<std::optional<std::vector<std::string>>> GenerateInBulkImpl(
+      int n) override;
+  absl::StatusOr<std::optional<std::vector<std::string>>>
+  GenerateInBulkWithSumImpl(int n, int64_t sum) override;
   absl::Status IsSatisfiedWithImpl(const std::string& value) const override;
   absl::Status MergeFromImpl(const MString& other) override;
   absl::StatusOr<std::string> ReadImpl() override;
@@ -163,6 +266,9 @@ class MString : public librarian::MVariable<MString, std::string> {
   std::vector<std::string> GetDependenciesImpl() const override;
   absl::StatusOr<std::vector<MString>> GetDifficultInstancesImpl()
       const override;
+  std::optional<std::string> ShrinkImpl(const std::string& value, int level,
+                                        int64_t index) const override;
+  bool IsKnownUnsatisfiableImpl() const override;
   std::string ToStringImpl() const override;
   absl::StatusOr<std::string> ValueToStringImpl(
       const std::string& value) const override;
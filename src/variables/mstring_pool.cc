@@ -0,0 +1,284 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mstring_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "src/errors.h"
+#include "src/internal/generation_config.h"
+#include "src/librarian/io_config.h"
+#include "src/util/status_macro/status_macros.h"
+#include "src/variables/constraints/container_constraints.h"
+#include "src/variables/constraints/io_constraints.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+
+using moriarty::librarian::IOConfig;
+
+namespace {
+
+// The number of strings generated (or checked) at once. Only this many strings
+// are ever held as `std::string`s at the same time.
+constexpr int kChunkSize =
+    moriarty_internal::GenerationConfig::kParallelGenerationChunkSize;
+
+}  // namespace
+
+StringPool::StringPool(absl::Span<const std::string> strings) {
+  int64_t num_chars = 0;
+  for (const std::string& s : strings) num_chars += s.size();
+  Reserve(strings.size(), num_chars);
+  for (const std::string& s : strings) Add(s);
+}
+
+void StringPool::Reserve(int64_t num_strings, int64_t num_chars) {
+  offsets_.reserve(num_strings + 1);
+  chars_.reserve(num_chars);
+}
+
+void StringPool::Add(absl::string_view value) {
+  chars_.append(value);
+  offsets_.push_back(chars_.size());
+}
+
+std::vector<std::string> StringPool::ToVector() const {
+  std::vector<std::string> result;
+  result.reserve(size());
+  for (int64_t i = 0; i < size(); i++) result.emplace_back((*this)[i]);
+  return result;
+}
+
+bool operator<(const StringPool& lhs, const StringPool& rhs) {
+  int64_t n = std::min(lhs.size(), rhs.size());
+  for (int64_t i = 0; i < n; i++) {
+    if (lhs[i] != rhs[i]) return lhs[i] < rhs[i];
+  }
+  return lhs.size() < rhs.size();
+}
+
+MStringPool::MStringPool(MString element_constraints)
+    : MStringPool(Elements<MString>(std::move(element_constraints))) {}
+
+MStringPool& MStringPool::AddConstraint(const Elements<MString>& constraint) {
+  return Of(constraint.GetConstraints());
+}
+
+MStringPool& MStringPool::AddConstraint(const Length& constraint) {
+  return OfLength(constraint.GetConstraints());
+}
+
+MStringPool& MStringPool::AddConstraint(const IOSeparator& constraint) {
+  return WithSeparator(constraint.GetSeparator());
+}
+
+MStringPool& MStringPool::Of(MString variable) {
+  element_constraints_.MergeFrom(std::move(variable));
+  return *this;
+}
+
+MStringPool& MStringPool::OfLength(const MInteger& length) {
+  if (length_)
+    length_->MergeFrom(length);
+  else
+    length_ = length;
+  return *this;
+}
+
+MStringPool& MStringPool::OfLength(int64_t length) {
+  return OfLength(length, length);
+}
+
+MStringPool& MStringPool::OfLength(absl::string_view length_expression) {
+  return OfLength(MInteger().Between(length_expression, length_expression));
+}
+
+MStringPool& MStringPool::OfLength(int64_t min_length, int64_t max_length) {
+  return OfLength(MInteger().Between(min_length, max_length));
+}
+
+MStringPool& MStringPool::WithSeparator(Whitespace separator) {
+  if (separator_.has_value() && *separator_ != separator) {
+    DeclareSelfAsInvalid(UnsatisfiedConstraintError(
+        "Attempting to set multiple I/O separators for the same "
+        "MStringPool."));
+  } else {
+    separator_ = separator;
+  }
+  return *this;
+}
+
+Whitespace MStringPool::GetSeparator() const {
+  return separator_.value_or(Whitespace::kSpace);
+}
+
+absl::StatusOr<StringPool> MStringPool::GenerateImpl() {
+  if (!length_) {
+    return absl::FailedPreconditionError(
+        "Attempting to generate a string pool with no length parameter "
+        "given.");
+  }
+
+  // Ensure that the size is non-negative.
+  length_->AtLeast(0);
+
+  std::optional<int64_t> generation_limit = GetApproximateGenerationLimit();
+  if (generation_limit) length_->AtMost(*generation_limit);
+
+  MORIARTY_ASSIGN_OR_RETURN(int64_t length, Random("length", *length_));
+
+  // The strings share the pool's generation limit, as for `MArray`.
+  moriarty_internal::ScopedSoftGenerationLimit element_generation_limit =
+      LowerApproximateGenerationLimit(
+          generation_limit ? *generation_limit / std::max<int64_t>(length, 1)
+                           : 0);
+
+  // Strings are generated a chunk at a time (all at once, if the element
+  // constraints allow it) and copied straight into the pool.
+  StringPool result;
+  result.Reserve(length, 0);
+  std::string element_name;
+  for (int64_t begin = 0; begin < length; begin += kChunkSize) {
+    int n = std::min<int64_t>(kChunkSize, length - begin);
+    MORIARTY_ASSIGN_OR_RETURN(
+        std::optional<std::vector<std::string>> bulk_values,
+        RandomInBulk("elements", element_constraints_, n));
+    if (bulk_values) {
+      for (const std::string& value : *bulk_values) result.Add(value);
+      continue;
+    }
+    for (int64_t i = begin; i < begin + n; i++) {
+      element_name.clear();
+      absl::StrAppend(&element_name, "element[", i, "]");
+      MORIARTY_ASSIGN_OR_RETURN(std::string value,
+                                Random(element_name, element_constraints_));
+      result.Add(value);
+    }
+  }
+  return result;
+}
+
+absl::Status MStringPool::IsSatisfiedWithImpl(const StringPool& value) const {
+  if (length_) {
+    MORIARTY_RETURN_IF_ERROR(
+        CheckConstraint(SatisfiesConstraints(*length_, value.size()),
+                        "invalid MStringPool length"));
+  }
+
+  // Only one chunk of the strings is copied out of the pool at a time.
+  std::vector<std::string> chunk;
+  for (int64_t begin = 0; begin < value.size(); begin += kChunkSize) {
+    int64_t end = std::min<int64_t>(begin + kChunkSize, value.size());
+    chunk.clear();
+    for (int64_t i = begin; i < end; i++) chunk.emplace_back(value[i]);
+
+    // Only check the strings one at a time if the fast path cannot vouch for
+    // all of them (this also finds the first invalid string).
+    if (!AllSatisfyConstraints(element_constraints_, chunk)) {
+      for (int64_t i = begin; i < end; i++) {
+        MORIARTY_RETURN_IF_ERROR(CheckConstraint(
+            SatisfiesConstraints(element_constraints_, chunk[i - begin]),
+            absl::Substitute("invalid element $0 (0-based)", i)));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MStringPool::IsSatisfiedWithGeneratedImpl(
+    const StringPool& value) const {
+  // Each string was generated with the element constraints, so only the length
+  // needs to be checked.
+  if (!length_) return absl::OkStatus();
+  return CheckConstraint(SatisfiesConstraints(*length_, value.size()),
+                         "invalid MStringPool length");
+}
+
+absl::Status MStringPool::MergeFromImpl(const MStringPool& other) {
+  Of(other.element_constraints_);
+  if (other.length_) OfLength(*other.length_);
+  if (other.separator_) WithSeparator(*other.separator_);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<StringPool> MStringPool::ReadImpl() {
+  if (!length_) {
+    return absl::FailedPreconditionError(
+        "Unknown length of string pool before read.");
+  }
+  std::optional<int64_t> length = GetUniqueValue("length", *length_);
+  if (!length) {
+    return absl::FailedPreconditionError(
+        "Cannot determine the length of string pool before read.");
+  }
+
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  StringPool result;
+  result.Reserve(*length, 0);
+  for (int64_t i = 0; i < *length; i++) {
+    if (i > 0) {
+      MORIARTY_RETURN_IF_ERROR(io_config->ReadWhitespace(GetSeparator()));
+    }
+    MORIARTY_ASSIGN_OR_RETURN(std::string token, io_config->ReadToken());
+    result.Add(token);
+  }
+  return result;
+}
+
+absl::Status MStringPool::PrintImpl(const StringPool& value) {
+  MORIARTY_ASSIGN_OR_RETURN(IOConfig * io_config, GetIOConfig());
+  for (int64_t i = 0; i < value.size(); i++) {
+    if (i > 0) {
+      MORIARTY_RETURN_IF_ERROR(io_config->PrintWhitespace(GetSeparator()));
+    }
+    MORIARTY_RETURN_IF_ERROR(io_config->PrintToken(value[i]));
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::string> MStringPool::GetDependenciesImpl() const {
+  std::vector<std::string> deps = GetDependencies(element_constraints_);
+  if (length_)
+    absl::c_move(GetDependencies(*length_), std::back_inserter(deps));
+  return deps;
+}
+
+std::string MStringPool::ToStringImpl() const {
+  std::string result =
+      absl::StrCat("elements: (", element_constraints_.ToString(), "); ");
+  if (length_)
+    absl::StrAppend(&result, "length: (", length_->ToString(), "); ");
+  if (separator_) {
+    absl::StrAppend(&result, "separator: ",
+                    librarian::WhitespaceName(*separator_), "; ");
+  }
+  return result;
+}
+
+}  // namespace moriarty
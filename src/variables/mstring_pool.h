@@ -0,0 +1,195 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MORIARTY_SRC_VARIABLES_MSTRING_POOL_H_
+#define MORIARTY_SRC_VARIABLES_MSTRING_POOL_H_
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/mvariable.h"
+#include "src/variables/constraints/base_constraints.h"
+#include "src/variables/constraints/container_constraints.h"
+#include "src/variables/constraints/io_constraints.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+
+// StringPool
+//
+// A list of strings stored in one contiguous buffer of characters, with the
+// offset of each string in the buffer. Unlike `std::vector<std::string>`, this
+// has no per-string header or heap allocation, which matters for many short
+// strings (e.g., a dictionary of 10^6 words).
+class StringPool {
+ public:
+  StringPool() = default;
+  explicit StringPool(absl::Span<const std::string> strings);
+
+  // size()
+  //
+  // The number of strings in this pool.
+  [[nodiscard]] int64_t size() const { return offsets_.size() - 1; }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  // operator[]
+  //
+  // Returns the `index`-th string. The view is invalidated by `Add()`.
+  [[nodiscard]] absl::string_view operator[](int64_t index) const {
+    return absl::string_view(chars_).substr(
+        offsets_[index], offsets_[index + 1] - offsets_[index]);
+  }
+
+  // Chars()
+  //
+  // All of the characters of all of the strings, back to back.
+  [[nodiscard]] absl::string_view Chars() const { return chars_; }
+
+  // Reserve()
+  //
+  // Reserves space for `num_strings` strings with `num_chars` characters in
+  // total.
+  void Reserve(int64_t num_strings, int64_t num_chars);
+
+  // Add()
+  //
+  // Appends `value` to the end of this pool.
+  void Add(absl::string_view value);
+
+  // ToVector()
+  //
+  // Returns a copy of the strings in this pool.
+  [[nodiscard]] std::vector<std::string> ToVector() const;
+
+  friend bool operator==(const StringPool& lhs, const StringPool& rhs) {
+    return lhs.offsets_ == rhs.offsets_ && lhs.chars_ == rhs.chars_;
+  }
+  // Lexicographic order of the lists of strings, as for
+  // `std::vector<std::string>`.
+  friend bool operator<(const StringPool& lhs, const StringPool& rhs);
+
+ private:
+  std::string chars_;
+  // The `i`-th string is `chars_[offsets_[i], offsets_[i + 1])`.
+  std::vector<int64_t> offsets_ = {0};
+};
+
+// MStringPool
+//
+// Describes constraints placed on an array of strings, like
+// `MArray<MString>`, whose values are `StringPool`s instead of
+// `std::vector<std::string>`. Prefer this for large arrays of short strings,
+// where the per-string overhead of `std::vector<std::string>` dominates.
+//
+// Unlike `MArray`, the strings have no order or distinctness.
+class MStringPool : public librarian::MVariable<MStringPool, StringPool> {
+ public:
+  // Create an MStringPool from a set of constraints. Logically equivalent to
+  // calling AddConstraint() for each constraint.
+  //
+  // E.g., MStringPool(Elements<MString>(Length(1, 10), Alphabet("abc")),
+  //                   Length(1000000))
+  template <typename... Constraints>
+    requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+  explicit MStringPool(Constraints&&... constraints);
+
+  // Create an MStringPool with this set of constraints on each string.
+  explicit MStringPool(MString element_constraints);
+
+  // The strings must satisfy these constraints.
+  MStringPool& AddConstraint(const Elements<MString>& constraint);
+  // The pool must have this many strings.
+  MStringPool& AddConstraint(const Length& constraint);
+  // The strings must be separated by this whitespace.
+  MStringPool& AddConstraint(const IOSeparator& constraint);
+
+  [[nodiscard]] std::string Typename() const override { return "MStringPool"; }
+
+  // ValueByteSize()
+  //
+  // Returns the number of characters in `value`.
+  [[nodiscard]] static int64_t ValueByteSize(const StringPool& value) {
+    return value.Chars().size();
+  }
+
+  // Of()
+  //
+  // Add extra constraints to each string.
+  MStringPool& Of(MString variable);
+
+  // OfLength()
+  //
+  // Sets the constraints for the number of strings. If two parameters are
+  // provided, the length is in the closed range [`min_length`, `max_length`].
+  //
+  // For example:
+  // `OfLength(5, 10)` is equivalent to `OfLength(MInteger().Between(5, 10))`.
+  // `OfLength("3 * N")` is equivalent to `OfLength(MInteger().Is("3 * N"))`.
+  MStringPool& OfLength(const MInteger& length);
+  MStringPool& OfLength(int64_t length);
+  MStringPool& OfLength(absl::string_view length_expression);
+  MStringPool& OfLength(int64_t min_length, int64_t max_length);
+
+  // WithSeparator()
+  //
+  // Sets the whitespace separator to be used between the strings when
+  // reading/writing. Default = kSpace.
+  MStringPool& WithSeparator(Whitespace separator);
+
+ private:
+  MString element_constraints_;
+  std::optional<MInteger> length_;
+  std::optional<Whitespace> separator_;
+  Whitespace GetSeparator() const;
+
+  // ---------------------------------------------------------------------------
+  //  MVariable overrides
+  absl::StatusOr<StringPool> GenerateImpl() override;
+  absl::Status IsSatisfiedWithImpl(const StringPool& value) const override;
+  absl::Status IsSatisfiedWithGeneratedImpl(
+      const StringPool& value) const override;
+  absl::Status MergeFromImpl(const MStringPool& other) override;
+  absl::StatusOr<StringPool> ReadImpl() override;
+  absl::Status PrintImpl(const StringPool& value) override;
+  std::vector<std::string> GetDependenciesImpl() const override;
+  std::string ToStringImpl() const override;
+  // ---------------------------------------------------------------------------
+};
+
+// -----------------------------------------------------------------------------
+//  Implementation details
+// -----------------------------------------------------------------------------
+
+template <typename... Constraints>
+  requires(std::derived_from<std::decay_t<Constraints>, MConstraint> && ...)
+MStringPool::MStringPool(Constraints&&... constraints) {
+  (AddConstraint(std::forward<Constraints>(constraints)), ...);
+}
+
+}  // namespace moriarty
+
+#endif  // MORIARTY_SRC_VARIABLES_MSTRING_POOL_H_
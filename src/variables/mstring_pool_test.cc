@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/variables/mstring_pool.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "src/librarian/io_config.h"
+#include "src/librarian/test_utils.h"
+#include "src/util/test_status_macro/status_testutil.h"
+#include "src/variables/marray.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
+
+namespace moriarty {
+namespace {
+
+using ::moriarty::IsOkAndHolds;
+using ::moriarty::StatusIs;
+using ::moriarty_testing::Context;
+using ::moriarty_testing::Generate;
+using ::moriarty_testing::IsNotSatisfiedWith;
+using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::Print;
+using ::moriarty_testing::Read;
+using ::testing::ElementsAre;
+using ::testing::Property;
+
+TEST(MStringPoolTest, TypenameIsCorrect) {
+  EXPECT_EQ(MStringPool(MString()).Typename(), "MStringPool");
+}
+
+TEST(MStringPoolTest, StringPoolStoresTheStringsContiguously) {
+  StringPool pool({"ab", "", "cde"});
+
+  EXPECT_EQ(pool.size(), 3);
+  EXPECT_EQ(pool.Chars(), "abcde");
+  EXPECT_EQ(pool[0], "ab");
+  EXPECT_EQ(pool[1], "");
+  EXPECT_EQ(pool[2], "cde");
+  EXPECT_THAT(pool.ToVector(), ElementsAre("ab", "", "cde"));
+}
+
+TEST(MStringPoolTest, StringPoolsAreOrderedLikeVectorsOfStrings) {
+  EXPECT_EQ(StringPool({"ab", "c"}), StringPool({"ab", "c"}));
+  EXPECT_NE(StringPool({"ab", "c"}), StringPool({"a", "bc"}));
+  EXPECT_LT(StringPool({"a", "bc"}), StringPool({"ab", "c"}));
+  EXPECT_LT(StringPool({"ab"}), StringPool({"ab", "c"}));
+}
+
+TEST(MStringPoolTest, GenerateHasTheSameStringsAsMArray) {
+  // Both generate the strings in bulk, in the same way.
+  MString element = MString().WithAlphabet("abc").OfLength(0, 10);
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::string> expected,
+      Generate(MArray(element).OfLength(1000)));
+
+  EXPECT_THAT(Generate(MStringPool(element).OfLength(1000)),
+              IsOkAndHolds(Property(&StringPool::ToVector, expected)));
+}
+
+TEST(MStringPoolTest, GenerateRespectsTheElementConstraints) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      StringPool pool,
+      Generate(MStringPool(MString().WithSimplePattern("a[bc]{1, 3}"))
+                   .OfLength(10000)));
+
+  EXPECT_EQ(pool.size(), 10000);
+  EXPECT_THAT(MStringPool(MString().WithSimplePattern("a[bc]{1, 3}")),
+              IsSatisfiedWith(pool));
+}
+
+TEST(MStringPoolTest, GenerateWithLengthFromOtherVariablesWorks) {
+  EXPECT_THAT(
+      Generate(MStringPool(MString().WithAlphabet("a").OfLength(1)).OfLength(
+                   "N"),
+               Context().WithValue<MInteger>("N", 7)),
+      IsOkAndHolds(Property(&StringPool::size, 7)));
+}
+
+TEST(MStringPoolTest, GenerateWithoutLengthFails) {
+  EXPECT_THAT(Generate(MStringPool(MString().WithAlphabet("a").OfLength(1))),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MStringPoolTest, IsSatisfiedWithChecksTheLengthAndEveryString) {
+  StringPool pool({"ab", "ba", "abc"});
+
+  EXPECT_THAT(MStringPool(MString().WithAlphabet("abc")).OfLength(3),
+              IsSatisfiedWith(pool));
+  EXPECT_THAT(MStringPool(MString()).OfLength(2),
+              IsNotSatisfiedWith(pool, "length"));
+  EXPECT_THAT(MStringPool(MString().WithAlphabet("ab")),
+              IsNotSatisfiedWith(pool, "element 2"));
+}
+
+TEST(MStringPoolTest, PrintWritesTheStringsWithTheSeparator) {
+  StringPool pool({"ab", "c", "de"});
+
+  EXPECT_THAT(Print(MStringPool(MString()), pool), IsOkAndHolds("ab c de"));
+  EXPECT_THAT(
+      Print(MStringPool(MString()).WithSeparator(Whitespace::kNewline), pool),
+      IsOkAndHolds("ab\nc\nde"));
+}
+
+TEST(MStringPoolTest, ReadReadsTheStringsWithTheSeparator) {
+  EXPECT_THAT(Read(MStringPool(MString()).OfLength(3), "ab c de"),
+              IsOkAndHolds(StringPool({"ab", "c", "de"})));
+  EXPECT_THAT(Read(MStringPool(MString()).OfLength(2), "ab\nc"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Read(MStringPool(MString()), "ab c"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+}  // namespace
+}  // namespace moriarty
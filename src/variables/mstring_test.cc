@@ -15,16 +15,24 @@
 #include "src/variables/mstring.h"
 
 #include <algorithm>
+#include <optional>
+#include <sstream>
 #include <string>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "src/internal/universe.h"
+#include "src/internal/value_set.h"
+#include "src/internal/variable_set.h"
+#include "src/librarian/io_config.h"
 #include "src/librarian/mvariable.h"
 #include "src/librarian/test_utils.h"
+#include "src/testing/status_test_util.h"
 #include "src/util/test_status_macro/status_testutil.h"
 #include "src/variables/constraints/container_constraints.h"
 #include "src/variables/constraints/numeric_constraints.h"
@@ -41,9 +49,11 @@ using ::moriarty_testing::GeneratedValuesAre;
 using ::moriarty_testing::GenerateSameValues;
 using ::moriarty_testing::IsNotSatisfiedWith;
 using ::moriarty_testing::IsSatisfiedWith;
+using ::moriarty_testing::IsUnsatisfiedConstraint;
 using ::moriarty_testing::Print;
 using ::moriarty_testing::Read;
 using ::testing::AllOf;
+using ::testing::AnyOf;
 using ::testing::Eq;
 using ::testing::Ge;
 using ::testing::HasSubstr;
@@ -52,7 +62,9 @@ using ::testing::Le;
 using ::testing::MatchesRegex;
 using ::testing::Not;
 using ::testing::SizeIs;
+using ::testing::Truly;
 using ::testing::UnorderedElementsAreArray;
+using ::moriarty::IsOk;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
 
@@ -88,6 +100,59 @@ TEST(MStringTest, ReadAtEofShouldFail) {
               StatusIs(absl::StatusCode::kFailedPrecondition));
 }
 
+// Calls `m.ReadStreamed(storage)` with `input` as the input stream.
+absl::StatusOr<MString::StreamedString> ReadStreamed(
+    MString m, absl::string_view input,
+    MString::StreamedStorage storage = MString::StreamedStorage::kDigestOnly) {
+  std::istringstream ss((std::string(input)));
+  librarian::IOConfig io_config;
+  io_config.SetInputStream(ss);
+
+  moriarty_internal::VariableSet variables;
+  moriarty_internal::ValueSet values;
+  moriarty_internal::Universe universe = moriarty_internal::Universe()
+                                             .SetConstVariableSet(&variables)
+                                             .SetConstValueSet(&values)
+                                             .SetIOConfig(&io_config);
+  moriarty_internal::MVariableManager(&m).SetUniverse(&universe, "S");
+  return m.ReadStreamed(storage);
+}
+
+TEST(MStringTest, ReadStreamedShouldReturnTheLengthAndFingerprint) {
+  absl::StatusOr<MString::StreamedString> result =
+      ReadStreamed(MString().OfLength(1, 5).WithAlphabet("abc"), "abc def");
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_EQ(result->length, 3);
+  EXPECT_EQ(result->fingerprint, 0xe71fa2190541574b);  // FNV-1a of "abc".
+  EXPECT_EQ(result->value, std::nullopt);
+}
+
+TEST(MStringTest, ReadStreamedWithFullValueShouldKeepTheToken) {
+  std::string long_token(3 * librarian::IOConfig::kTokenChunkSize + 7, 'a');
+  long_token.back() = 'b';
+
+  absl::StatusOr<MString::StreamedString> result =
+      ReadStreamed(MString().WithAlphabet("ab"), long_token,
+                   MString::StreamedStorage::kFullValue);
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_EQ(result->length, long_token.size());
+  EXPECT_EQ(result->value, long_token);
+}
+
+TEST(MStringTest, ReadStreamedShouldRejectInvalidTokens) {
+  EXPECT_THAT(ReadStreamed(MString().WithAlphabet("ab"), "abcab"),
+              IsUnsatisfiedConstraint("not in alphabet, but at index 2"));
+  EXPECT_THAT(ReadStreamed(MString().WithDistinctCharacters(), "abcb"),
+              IsUnsatisfiedConstraint("'b' appears multiple times"));
+  EXPECT_THAT(ReadStreamed(MString().OfLength(1, 3), "abcd"),
+              IsUnsatisfiedConstraint("length"));
+  EXPECT_THAT(ReadStreamed(MString().WithSimplePattern("a*b"), "aaba"),
+              IsUnsatisfiedConstraint("simple pattern"));
+  MORIARTY_EXPECT_OK(ReadStreamed(MString().WithSimplePattern("a*b"), "aab"));
+  EXPECT_THAT(ReadStreamed(MString(), " abc"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 TEST(MStringTest, GenerateShouldSuccessfullyComplete) {
   MString variable;
   MORIARTY_EXPECT_OK(Generate(
@@ -471,6 +536,185 @@ TEST(MStringTest, SimplePatternShouldRespectAlphabets) {
               GeneratedValuesAre("b"));
 }
 
+TEST(MStringTest, SeveralSimplePatternsShouldAllBeSatisfiedByGeneration) {
+  // Only 1 in 2^30 strings of the last pattern also match the first.
+  EXPECT_THAT(MString()
+                  .WithSimplePattern("a[ab]{29}b")
+                  .WithSimplePattern("[ab]{31}"),
+              GeneratedValuesAre(MatchesRegex("a[ab]{29}b")));
+}
+
+TEST(MStringTest, SimplePatternWithLengthShouldGenerateThatLength) {
+  EXPECT_THAT(MString().WithSimplePattern("a*b*").OfLength(1000),
+              GeneratedValuesAre(AllOf(SizeIs(1000), MatchesRegex("a*b*"))));
+  EXPECT_THAT(MString()
+                  .WithSimplePattern("[a-z]{1,50}")
+                  .WithSimplePattern("[a-m]*[n-z]*")
+                  .OfLength(20, 30),
+              GeneratedValuesAre(AllOf(SizeIs(AllOf(Ge(20), Le(30))),
+                                       MatchesRegex("[a-m]*[n-z]*"))));
+}
+
+MATCHER_P(HasPeriod, period, "") {
+  for (int i = period; i < arg.size(); i++) {
+    if (arg[i] != arg[i - period]) {
+      *result_listener << "index " << i << " differs from index " << i - period;
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(MStringTest, PeriodicStructureShouldGenerateAPeriodicString) {
+  EXPECT_THAT(MString()
+                  .OfLength(100, 1000)
+                  .WithAlphabet("abc")
+                  .WithStructure(StringStructure::Kind::kPeriodic, 7),
+              GeneratedValuesAre(AllOf(HasPeriod(7), MatchesRegex("[abc]*"))));
+  // A period longer than the string is just a random string.
+  EXPECT_THAT(MString().OfLength(5).WithAlphabet("abc").WithStructure(
+                  StringStructure::Kind::kPeriodic, 10),
+              GeneratedValuesAre(SizeIs(5)));
+}
+
+TEST(MStringTest, PeriodicStructureWithNonPositivePeriodShouldFail) {
+  EXPECT_THAT(Generate(MString().OfLength(10).WithAlphabet("a").WithStructure(
+                  StringStructure::Kind::kPeriodic, 0)),
+              Not(IsOk()));
+}
+
+TEST(MStringTest, FibonacciWordStructureShouldGenerateAFibonacciWord) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::string value,
+      Generate(MString().OfLength(13).WithAlphabet("ab").WithStructure(
+          StringStructure::Kind::kFibonacciWord)));
+  EXPECT_THAT(value, AnyOf(Eq("abaababaabaab"), Eq("babbababbabba")));
+
+  EXPECT_THAT(
+      MString().OfLength(100000).WithAlphabet("xyz").WithStructure(
+          StringStructure::Kind::kFibonacciWord),
+      GeneratedValuesAre(AllOf(SizeIs(100000), MatchesRegex("[xyz]*"))));
+}
+
+TEST(MStringTest, LowEntropyStructureShouldUseAtMostTwoCharacters) {
+  EXPECT_THAT(
+      MString().OfLength(1000).WithAlphabet(MString::kLowerCase).WithStructure(
+          StringStructure::Kind::kLowEntropy),
+      GeneratedValuesAre(AllOf(
+          SizeIs(1000), Truly([](const std::string& value) {
+            return absl::flat_hash_set<char>(value.begin(), value.end())
+                       .size() <= 2;
+          }))));
+}
+
+TEST(MStringTest, ThueMorseStructureShouldGenerateAThueMorseString) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::string value,
+      Generate(MString().OfLength(8).WithAlphabet("ab").WithStructure(
+          StringStructure::Kind::kThueMorse)));
+  EXPECT_THAT(value, AnyOf(Eq("abbabaab"), Eq("baababba")));
+}
+
+TEST(MStringTest, HashCollisionStructureShouldHaveCollidingHalves) {
+  constexpr int64_t kBase = 131;
+  constexpr int64_t kModulus = 1'000'000'007;
+  auto hash = [](absl::string_view str) {
+    int64_t hash = 0;
+    for (char c : str) hash = (hash * kBase + c) % kModulus;
+    return hash;
+  };
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      std::string value,
+      Generate(MString(Length(2001), Alphabet::LowerCase(),
+                       StringStructure::PolynomialHashCollision(kBase,
+                                                                kModulus))));
+  ASSERT_THAT(value, SizeIs(2001));
+  absl::string_view first = absl::string_view(value).substr(0, 1000);
+  absl::string_view second = absl::string_view(value).substr(1000, 1000);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(hash(first), hash(second));
+}
+
+TEST(MStringTest, StructureWithSimplePatternShouldFailGeneration) {
+  EXPECT_THAT(Generate(MString()
+                           .OfLength(10)
+                           .WithSimplePattern("a*")
+                           .WithStructure(StringStructure::Kind::kLowEntropy)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+// Returns the depth of a balanced string of "()" and "[]", or -1 if `value`
+// is not balanced.
+int BracketDepth(absl::string_view value) {
+  std::string open;
+  int depth = 0;
+  for (char c : value) {
+    if (c == '(' || c == '[') {
+      open.push_back(c);
+      depth = std::max(depth, static_cast<int>(open.size()));
+    } else if (open.empty() || (c == ')') != (open.back() == '(')) {
+      return -1;
+    } else {
+      open.pop_back();
+    }
+  }
+  return open.empty() ? depth : -1;
+}
+
+TEST(MStringTest, BalancedBracketsShouldGenerateBalancedStrings) {
+  EXPECT_THAT(MString().OfLength(0, 1000).WithBalancedBrackets("()[]"),
+              GeneratedValuesAre(Truly([](const std::string& value) {
+                return BracketDepth(value) >= 0;
+              })));
+  // An odd length is never balanced, so only even lengths are generated.
+  EXPECT_THAT(MString().OfLength(5, 6).WithBalancedBrackets(),
+              GeneratedValuesAre(SizeIs(6)));
+}
+
+TEST(MStringTest, BalancedBracketsShouldOnlyUseBracketsInTheAlphabet) {
+  EXPECT_THAT(
+      MString().OfLength(100).WithAlphabet("[]").WithBalancedBrackets("()[]"),
+      GeneratedValuesAre(MatchesRegex("[][]*")));
+  EXPECT_THAT(Generate(MString()
+                           .OfLength(100)
+                           .WithAlphabet("(]")
+                           .WithBalancedBrackets("()[]")),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MStringTest, BalancedBracketsShouldRespectTheMaximumDepth) {
+  EXPECT_THAT(MString().OfLength(1000).WithBalancedBrackets("()[]", 3),
+              GeneratedValuesAre(Truly([](const std::string& value) {
+                int depth = BracketDepth(value);
+                return 0 <= depth && depth <= 3;
+              })));
+}
+
+TEST(MStringTest, BalancedBracketsShouldBeSatisfiedWithBalancedStrings) {
+  EXPECT_THAT(MString().WithBalancedBrackets("()[]"),
+              IsSatisfiedWith("([]())[]"));
+  EXPECT_THAT(MString().WithBalancedBrackets("()[]"), IsSatisfiedWith(""));
+  EXPECT_THAT(MString().WithBalancedBrackets("()[]"),
+              IsNotSatisfiedWith("([)]", "does not close"));
+  EXPECT_THAT(MString().WithBalancedBrackets("()[]"),
+              IsNotSatisfiedWith("(()", "never closed"));
+  EXPECT_THAT(MString().WithBalancedBrackets("()"),
+              IsNotSatisfiedWith("(x)", "not a bracket"));
+  EXPECT_THAT(MString().WithBalancedBrackets("()", 1),
+              IsNotSatisfiedWith("(())", "nested more than 1 deep"));
+}
+
+TEST(MStringTest, InvalidBalancedBracketsShouldFail) {
+  EXPECT_THAT(Generate(MString().OfLength(10).WithBalancedBrackets("(")),
+              Not(IsOk()));
+  EXPECT_THAT(Generate(MString()
+                           .OfLength(10)
+                           .WithBalancedBrackets("()")
+                           .WithBalancedBrackets("[]")),
+              Not(IsOk()));
+}
+
 TEST(MStringTest, GetDifficultInstancesContainsLengthCases) {
   EXPECT_THAT(
       GenerateDifficultInstancesValues(
@@ -19,6 +19,7 @@
 
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <optional>
 #include <string>
@@ -38,6 +39,8 @@
 #include "src/librarian/mvariable.h"
 #include "src/property.h"
 #include "src/util/status_macro/status_macros.h"
+#include "src/variables/minteger.h"
+#include "src/variables/mstring.h"
 
 namespace moriarty {
 
@@ -112,8 +115,21 @@ class MTuple : public librarian::MVariable<
   absl::Status DistributePropertyToValues(Property property,
                                           std::index_sequence<I...>);
 
+  // Generates component `I` into `result`. `MInteger` and `MString`
+  // components are generated directly when possible (see `RandomInPlace()`),
+  // the rest go through `Random()`.
   template <std::size_t I>
   absl::Status GenerateSingleElement(tuple_value_type& result);
+
+  // Column-wise storage used for bulk generation: one vector per component.
+  using columns_type =
+      std::tuple<std::vector<typename MElementTypes::value_type>...>;
+
+  // Generates `n` values of component `I` in bulk into `columns`. Returns
+  // false if the component cannot be generated in bulk, or if there was an
+  // error (which is stored in `status`).
+  template <std::size_t I>
+  bool GenerateColumn(int n, columns_type& columns, absl::Status& status);
   template <std::size_t I>
   absl::Status TryReadAndSet(tuple_value_type& read_values);
   template <std::size_t I>
@@ -122,12 +138,17 @@ class MTuple : public librarian::MVariable<
   // ---------------------------------------------------------------------------
   //  MVariable overrides
   absl::StatusOr<tuple_value_type> GenerateImpl() override;
+  absl::StatusOr<std::optional<std::vector<tuple_value_type>>>
+  GenerateInBulkImpl(int n) override;
   absl::Status IsSatisfiedWithImpl(
       const tuple_value_type& value) const override;
+  absl::Status IsSatisfiedWithGeneratedImpl(
+      const tuple_value_type& value) const override;
   absl::Status MergeFromImpl(const MTuple& other) override;
   absl::StatusOr<tuple_value_type> ReadImpl() override;
   absl::Status PrintImpl(const tuple_value_type& value) override;
   std::vector<std::string> GetDependenciesImpl() const override;
+  std::string ToStringImpl() const override;
   // ---------------------------------------------------------------------------
 
   // ---------------------------------------------------------------------------
@@ -139,6 +160,9 @@ class MTuple : public librarian::MVariable<
   template <std::size_t... I>
   absl::StatusOr<tuple_value_type> GenerateImpl(std::index_sequence<I...>);
   template <std::size_t... I>
+  absl::StatusOr<std::optional<std::vector<tuple_value_type>>>
+  GenerateInBulkImpl(int n, std::index_sequence<I...>);
+  template <std::size_t... I>
   absl::Status IsSatisfiedWithImpl(const tuple_value_type& value,
                                    std::index_sequence<I...>) const;
   template <std::size_t... I>
@@ -262,12 +286,101 @@ template <typename... MElementTypes>
 template <std::size_t I>
 absl::Status MTuple<MElementTypes...>::GenerateSingleElement(
     tuple_value_type& result) {
+  using ElementType = std::tuple_element_t<I, std::tuple<MElementTypes...>>;
+  if constexpr (std::same_as<ElementType, MInteger>) {
+    std::optional<int64_t> value = this->RandomInPlace(std::get<I>(elements_));
+    if (value) {
+      std::get<I>(result) = *value;
+      return absl::OkStatus();
+    }
+  } else if constexpr (std::same_as<ElementType, MString>) {
+    // MString tightens its length constraints while generating, so it must be
+    // generated from a copy.
+    MString element = std::get<I>(elements_);
+    std::optional<std::string> value = this->RandomInPlace(element);
+    if (value) {
+      std::get<I>(result) = *std::move(value);
+      return absl::OkStatus();
+    }
+  }
+
+  // Either not a simple component, or it needs the retries in `Random()`.
   MORIARTY_ASSIGN_OR_RETURN(
       std::get<I>(result),
       this->Random(absl::StrCat("element<", I, ">"), std::get<I>(elements_)));
   return absl::OkStatus();
 }
 
+template <typename... MElementTypes>
+auto MTuple<MElementTypes...>::GenerateInBulkImpl(int n)
+    -> absl::StatusOr<std::optional<std::vector<tuple_value_type>>> {
+  return GenerateInBulkImpl(n, std::index_sequence_for<MElementTypes...>());
+}
+
+template <typename... MElementTypes>
+template <std::size_t... I>
+auto MTuple<MElementTypes...>::GenerateInBulkImpl(int n,
+                                                  std::index_sequence<I...>)
+    -> absl::StatusOr<std::optional<std::vector<tuple_value_type>>> {
+  // Columns draw from the engine in a different order than generating the
+  // tuples one at a time, so only the counter-based engine generates them.
+  // Older seeds keep their values.
+  if (!moriarty_internal::MVariableManager(this)
+           .GetRandomEngine()
+           .IsCounterBased()) {
+    return std::nullopt;
+  }
+
+  // Each component is generated as a contiguous column, then the columns are
+  // zipped together. Empty columns (which draw nothing) check first that
+  // every component can be generated in bulk.
+  columns_type columns;
+  absl::Status status;
+  bool all_generated = (GenerateColumn<I>(0, columns, status) && ...) &&
+                       (GenerateColumn<I>(n, columns, status) && ...);
+  MORIARTY_RETURN_IF_ERROR(status);
+  if (!all_generated) return std::nullopt;
+
+  std::vector<tuple_value_type> result;
+  result.reserve(n);
+  for (int i = 0; i < n; i++)
+    result.emplace_back(std::move(std::get<I>(columns)[i])...);
+  return result;
+}
+
+template <typename... MElementTypes>
+template <std::size_t I>
+bool MTuple<MElementTypes...>::GenerateColumn(int n, columns_type& columns,
+                                              absl::Status& status) {
+  auto column = this->RandomInBulk(absl::StrCat("element<", I, ">"),
+                                   std::get<I>(elements_), n);
+  if (!column.ok()) {
+    status = std::move(column).status();
+    return false;
+  }
+  if (!column->has_value()) return false;
+  std::get<I>(columns) = **std::move(column);
+  return true;
+}
+
+template <typename... MElementTypes>
+std::string MTuple<MElementTypes...>::ToStringImpl() const {
+  std::string result;
+  int index = 0;
+  std::apply(
+      [&](const auto&... elem) {
+        (absl::StrAppend(&result, "element<", index++, ">: (", elem.ToString(),
+                         "); "),
+         ...);
+      },
+      elements_);
+  if (separator_) {
+    absl::StrAppend(&result, "separator: ",
+                    librarian::WhitespaceName(*separator_), "; ");
+  }
+  return result;
+}
+
 template <typename... MElementTypes>
 std::vector<std::string> MTuple<MElementTypes...>::GetDependenciesImpl() const {
   return GetDependenciesImpl(std::index_sequence_for<MElementTypes...>());
@@ -320,14 +433,22 @@ absl::Status MTuple<MElementTypes...>::IsSatisfiedWithImpl(
                              std::index_sequence_for<MElementTypes...>());
 }
 
+template <typename... MElementTypes>
+absl::Status MTuple<MElementTypes...>::IsSatisfiedWithGeneratedImpl(
+    const tuple_value_type& value) const {
+  // Each element was generated (and checked) by its own variable.
+  return absl::OkStatus();
+}
+
 template <typename... MElementTypes>
 template <std::size_t... I>
 absl::Status MTuple<MElementTypes...>::IsSatisfiedWithImpl(
     const tuple_value_type& value, std::index_sequence<I...>) const {
-  // TODO(b/208295758): This should be shortcircuited.
+  // `&&` stops at the first invalid element.
   absl::Status status;
-  (status.Update(
-       this->SatisfiesConstraints(std::get<I>(elements_), std::get<I>(value))),
+  ((status = this->SatisfiesConstraints(std::get<I>(elements_),
+                                        std::get<I>(value)))
+       .ok() &&
    ...);
 
   return status;
@@ -343,10 +464,11 @@ template <typename... MElementTypes>
 template <std::size_t... I>
 absl::StatusOr<typename MTuple<MElementTypes...>::tuple_value_type>
 MTuple<MElementTypes...>::ReadImpl(std::index_sequence<I...>) {
-  // TODO(b/208295758): This should be shortcircuited.
+  // `&&` stops at the first element that cannot be read, so the rest of the
+  // input is not parsed.
   absl::Status status;
   tuple_value_type result;
-  (status.Update(TryReadAndSet<I>(result)), ...);
+  ((status = TryReadAndSet<I>(result)).ok() && ...);
   if (!status.ok()) return status;
   return result;
 }
@@ -15,7 +15,9 @@
 #include "src/variables/mtuple.h"
 
 #include <cstdint>
+#include <string>
 #include <tuple>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -30,17 +32,21 @@
 namespace moriarty {
 namespace {
 
+using ::moriarty_testing::Context;
 using ::moriarty_testing::Generate;
 using ::moriarty_testing::GeneratedValuesAre;
+using ::moriarty_testing::GenerateN;
 using ::moriarty_testing::GenerateSameValues;
 using ::moriarty_testing::IsNotSatisfiedWith;
 using ::moriarty_testing::IsSatisfiedWith;
 using ::moriarty_testing::Print;
 using ::moriarty_testing::Read;
 using ::testing::AllOf;
+using ::testing::Each;
 using ::testing::FieldsAre;
 using ::testing::Ge;
 using ::testing::Le;
+using ::testing::Ne;
 using ::testing::SizeIs;
 using ::moriarty::IsOkAndHolds;
 using ::moriarty::StatusIs;
@@ -146,6 +152,50 @@ TEST(MTupleTest, GenerateShouldSuccessfullyComplete) {
                       MTuple<MInteger>>()));
 }
 
+TEST(MTupleTest, SimpleComponentsGenerateTheSameValuesAsRandom) {
+  // A custom constraint forces each component through `Random()`.
+  auto always = [](const auto&) { return true; };
+  EXPECT_TRUE(GenerateSameValues(
+      MTuple(MInteger().Between(1, 1000),
+             MString().WithAlphabet("abc").OfLength(1, 10)),
+      MTuple(MInteger().Between(1, 1000).AddCustomConstraint("any", always),
+             MString()
+                 .WithAlphabet("abc")
+                 .OfLength(1, 10)
+                 .AddCustomConstraint("any", always))));
+}
+
+TEST(MTupleTest, ComponentsWithDependenciesOrRejectionsAreRespected) {
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      (std::vector<std::tuple<int64_t, int64_t, std::string>> values),
+      GenerateN(
+          MTuple(MInteger().Between(1, "N"),
+                 MInteger().Between(1, 3).AddCustomConstraint(
+                     "not 2", [](int64_t x) { return x != 2; }),
+                 MString().WithAlphabet("a").OfLength("N")),
+          100, Context().WithValue<MInteger>("N", 5)));
+
+  EXPECT_THAT(values, Each(FieldsAre(AllOf(Ge(1), Le(5)), Ne(2), "aaaaa")));
+}
+
+TEST(MTupleTest, RetriesShouldKeepTheComponentConstraints) {
+  // Rejected tuples are regenerated from the same components.
+  MTuple tuple =
+      MTuple(MInteger().Between(1, 10),
+             MString().WithAlphabet("ab").OfLength(2, 3))
+          .AddCustomConstraint(
+              "first is odd",
+              [](const std::tuple<int64_t, std::string>& value) {
+                return std::get<0>(value) % 2 == 1;
+              });
+
+  MORIARTY_ASSERT_OK_AND_ASSIGN(
+      (std::vector<std::tuple<int64_t, std::string>> values),
+      GenerateN(tuple, 100));
+  EXPECT_THAT(values, Each(FieldsAre(AllOf(Ge(1), Le(9)),
+                                     SizeIs(AllOf(Ge(2), Le(3))))));
+}
+
 TEST(MTupleTest, MergeFromCorrectlyMergesEachArgument) {
   {
     MTuple a = MTuple(MInteger().Between(1, 10), MInteger().Between(20, 30));
@@ -223,6 +273,23 @@ TEST(MTupleTest, SatisfiesConstraintsWorksForValid) {
   }
 }
 
+TEST(MTupleTest, SatisfiesConstraintsStopsAtTheFirstInvalidElement) {
+  int checks = 0;
+  MTuple constraints =
+      MTuple(MInteger().Between(1, 10),
+             MInteger().AddCustomConstraint("counted", [&checks](int64_t) {
+               checks++;
+               return true;
+             }));
+  using Type = std::tuple<int64_t, int64_t>;
+
+  EXPECT_THAT(constraints, IsNotSatisfiedWith(Type{0, 5}, "range"));
+  EXPECT_EQ(checks, 0);
+
+  EXPECT_THAT(constraints, IsSatisfiedWith(Type{5, 5}));
+  EXPECT_EQ(checks, 1);
+}
+
 TEST(MTupleTest, SatisfiesConstraintsWorksForInvalid) {
   {  // Simple
     MTuple constraints =